@@ -1,3 +1,6 @@
+// The tail is a static grid in the frame of the tail, where z points away
+// from the sun: in_Position holds the fraction of the tail length and the
+// sine and cosine of the angle around its axis, and in_Normal the normal.
 attribute vec4 in_Position;
 attribute vec3 in_Normal;
 attribute float in_Brightness;
@@ -5,11 +8,16 @@ attribute float in_Brightness;
 uniform vec3 color;
 uniform vec3 viewDir;
 uniform float fadeFactor;
+// x: radius at the end of the tail, y: length, z: distance of the start of
+// the tail from the nucleus, toward the sun
+uniform vec3 tailSize;
 
 varying float shade;
 
 void main(void)
 {
+    float t = in_Position.x;
+    vec3 position = vec3(in_Position.yz * (t * tailSize.x), t * t * tailSize.y - tailSize.z);
     shade = abs(dot(viewDir.xyz, in_Normal.xyz) * in_Brightness * fadeFactor);
-    set_vp(in_Position);
+    set_vp(vec4(position, 1.0));
 }
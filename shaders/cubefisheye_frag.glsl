@@ -0,0 +1,21 @@
+varying vec2 lensCoord;
+varying float intensity;
+
+uniform samplerCube tex;
+
+void main(void)
+{
+    // Same mapping as the fisheye projection: the angle from the view
+    // direction grows linearly up to 90 degrees at the edge of the circle
+    float r = length(lensCoord);
+    if (r > 1.0)
+    {
+        gl_FragColor = vec4(0.0, 0.0, 0.0, 1.0);
+        return;
+    }
+
+    float phi = r * 1.5707963;
+    vec2 d = r > 0.0 ? lensCoord / r : vec2(0.0);
+    vec3 direction = vec3(d * sin(phi), -cos(phi));
+    gl_FragColor = vec4(textureCube(tex, direction).rgb * intensity, 1.0);
+}
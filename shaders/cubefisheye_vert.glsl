@@ -0,0 +1,16 @@
+attribute vec2 in_Position;
+attribute vec2 in_TexCoord0;
+attribute float in_Intensity;
+
+varying vec2 lensCoord;
+varying float intensity;
+
+uniform float screenRatio;
+uniform vec2 lensScale;
+
+void main(void)
+{
+    gl_Position = vec4(in_Position.x * screenRatio, in_Position.y, 0.0, 1.0);
+    lensCoord = (in_TexCoord0 * 2.0 - 1.0) * lensScale;
+    intensity = in_Intensity;
+}
@@ -0,0 +1,28 @@
+in vec4 in_Position;
+in float in_Size;
+in float in_ColorIndex;
+in float in_Brightness;
+
+// Per galaxy: the model matrix, and the size, brightness and minimum
+// feature size of the galaxy
+in mat4 in_ModelMatrix;
+in vec3 in_GalaxyParams;
+
+uniform sampler2D colorTex;
+
+out Vertex
+{
+    vec3  color;
+    float size;
+    float brightness;
+    float minimumFeatureSize;
+} vertex;
+
+void main()
+{
+    gl_Position = in_ModelMatrix * in_Position;
+    vertex.size = in_GalaxyParams.x * in_Size;
+    vertex.brightness = in_GalaxyParams.y * in_Brightness;
+    vertex.minimumFeatureSize = in_GalaxyParams.z;
+    vertex.color = texture(colorTex, vec2(in_ColorIndex, 0.0)).rgb;
+}
@@ -0,0 +1,18 @@
+uniform sampler2D starTex;
+uniform sampler2D colorTex;
+uniform int textured;
+uniform float psfCell;
+varying float colorCoord;
+varying float alpha;
+
+// Cells of the star PSF atlas
+const float PSFCellCount = 2.0;
+
+void main(void)
+{
+    vec4 color = vec4(texture2D(colorTex, vec2(colorCoord, 0.5)).rgb, alpha);
+    if (textured != 0)
+        gl_FragColor = texture2D(starTex, vec2((gl_PointCoord.x + psfCell) / PSFCellCount, gl_PointCoord.y)) * color;
+    else
+        gl_FragColor = color;
+}
@@ -0,0 +1,86 @@
+attribute vec3 in_Position;      // light years
+attribute float in_TexCoord0;    // temperature, indexes the color table
+attribute float in_Intensity;    // absolute magnitude
+attribute float in_ScaleFactor;  // extinction per light year
+
+uniform vec3 obsPosition;
+uniform float limitingMag;
+uniform float faintestMag;
+uniform float brightnessScale;
+uniform float brightnessBias;
+uniform float satPoint;
+uniform float discSize;
+uniform float pointScale;
+uniform float distanceLimit;
+uniform int starStyle;
+uniform int glare;
+uniform float colorTempScale;
+uniform float colorCount;
+
+varying float colorCoord;
+varying float alpha;
+
+const float LY_PER_PARSEC = 3.26156377716743;
+const float LOG10_2 = 0.30103;
+const float MaxScaledDiscStarSize = 8.0;
+const float GlareOpacity = 0.65;
+
+// Same values as PointStarRenderer and Renderer::calculatePointSize
+void main(void)
+{
+    vec3 relPos = in_Position - obsPosition;
+    float distance = length(relPos);
+    float appMag = in_Intensity + 5.0 * LOG10_2 * log2(distance / LY_PER_PARSEC) - 5.0
+                 + in_ScaleFactor * distance;
+
+    alpha = max(0.0, (faintestMag - appMag) * brightnessScale + brightnessBias);
+    float pointSize = discSize;
+    float glareSize = 0.0;
+    float glareAlpha = 0.0;
+    if (alpha > 1.0)
+    {
+        if (starStyle == 2)
+        {
+            float discScale = min(MaxScaledDiscStarSize, pow(2.0, 0.3 * (satPoint - appMag)));
+            pointSize *= max(1.0, discScale);
+            glareAlpha = min(0.5, discScale / 4.0);
+            glareSize = pointSize * 3.0;
+        }
+        else
+        {
+            float discScale = min(100.0, satPoint - appMag + 2.0);
+            glareAlpha = min(GlareOpacity, (discScale - 2.0) / 4.0);
+            glareSize = 2.0 * discScale * discSize;
+        }
+        alpha = 1.0;
+    }
+
+    if (glare != 0)
+    {
+        pointSize = glareSize;
+        alpha = glareAlpha;
+    }
+    else if (starStyle == 1)
+    {
+        pointSize = pointScale;
+    }
+
+    if (appMag > limitingMag || distance > distanceLimit || alpha <= 0.0 || pointSize <= 0.0)
+    {
+        // Move culled stars outside of the clip volume
+        gl_PointSize = 0.0;
+        colorCoord = 0.0;
+        alpha = 0.0;
+        gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+        return;
+    }
+
+    // Center of the texel of the nearest entry, as in
+    // ColorTemperatureTable::lookupColor
+    float colorIndex = min(floor(in_TexCoord0 * colorTempScale + 0.5), colorCount - 1.0);
+    colorCoord = (colorIndex + 0.5) / colorCount;
+
+    gl_PointSize = pointSize;
+    alpha = min(alpha, 1.0);
+    set_vp(vec4(relPos, 1.0));
+}
@@ -0,0 +1,10 @@
+varying vec2 texCoord;
+varying float opacity;
+
+uniform sampler2D tex;
+
+void main(void)
+{
+    // The image has premultiplied alpha
+    gl_FragColor = texture2D(tex, texCoord) * opacity;
+}
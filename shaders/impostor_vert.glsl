@@ -0,0 +1,13 @@
+attribute vec4 in_Position;
+attribute vec2 in_TexCoord0;
+attribute float in_Intensity; // opacity of the image
+
+varying vec2 texCoord;
+varying float opacity;
+
+void main(void)
+{
+    texCoord = in_TexCoord0.st;
+    opacity = in_Intensity;
+    set_vp(in_Position);
+}
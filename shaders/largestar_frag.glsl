@@ -1,9 +1,14 @@
 uniform sampler2D starTex;
+uniform float psfCell;
 uniform vec4 color;
 
 varying vec2 texCoord;
 
+// Cells of the star PSF atlas
+const float PSFCellCount = 2.0;
+
 void main(void)
 {
-    gl_FragColor = texture2D(starTex, texCoord) * color;
+    vec2 cellCoord = vec2((texCoord.x + psfCell) / PSFCellCount, texCoord.y);
+    gl_FragColor = texture2D(starTex, cellCoord) * color;
 }
@@ -0,0 +1,14 @@
+attribute vec2 in_Position;
+// Per marker: the position in pixels and the depth, and the scale of the
+// symbol
+attribute vec4 in_TexCoord0;
+attribute vec4 in_Color;
+
+varying vec4 color;
+
+void main(void)
+{
+    color = in_Color;
+    vec2 p = in_TexCoord0.xy + in_Position * in_TexCoord0.w;
+    gl_Position = MVPMatrix * vec4(p, in_TexCoord0.z, 1.0);
+}
@@ -0,0 +1,20 @@
+uniform vec4 color;
+// Days from the first sample of the buffer
+uniform vec2 window;
+uniform float fadeStart;
+// 0 when the path isn't faded
+uniform float fadeRate;
+
+varying float v_Time;
+
+void main(void)
+{
+    // The segments at the ends of the window are only drawn partly
+    if (v_Time < window.x || v_Time > window.y)
+        discard;
+
+    float opacity = 1.0;
+    if (fadeRate != 0.0)
+        opacity = clamp((v_Time - fadeStart) * fadeRate, 0.0, 1.0);
+    gl_FragColor = vec4(color.rgb, color.a * opacity);
+}
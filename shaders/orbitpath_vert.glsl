@@ -0,0 +1,22 @@
+// The samples of an orbit, in the frame of the orbit, split into the float
+// nearest to each coordinate and the remainder, so that the position
+// relative to the camera keeps the precision of a double.
+attribute vec3 in_Position;      // high part
+attribute vec3 in_TexCoord0;     // low part
+attribute float in_TexCoord1;    // days from the first sample
+
+uniform vec3 eyeHigh;
+uniform vec3 eyeLow;
+// From the frame of the orbit to camera space
+uniform mat3 orientation;
+
+varying float v_Time;
+
+void main(void)
+{
+    // The high parts are close to each other near the camera, where the
+    // difference is exact, and the low parts are small
+    vec3 relPos = (in_Position - eyeHigh) + (in_TexCoord0 - eyeLow);
+    v_Time = in_TexCoord1;
+    set_vp(vec4(orientation * relPos, 1.0));
+}
@@ -1,7 +1,12 @@
 uniform sampler2D starTex;
+uniform float psfCell;
 varying vec4 color;
 
+// Cells of the star PSF atlas
+const float PSFCellCount = 2.0;
+
 void main(void)
 {
-    gl_FragColor = texture2D(starTex, gl_PointCoord) * color;
+    vec2 texCoord = vec2((gl_PointCoord.x + psfCell) / PSFCellCount, gl_PointCoord.y);
+    gl_FragColor = texture2D(starTex, texCoord) * color;
 }
@@ -0,0 +1,21 @@
+varying vec2 texCoord;
+
+uniform sampler2D tex;
+uniform vec2 texelSize;
+uniform float sharpness;
+
+void main(void)
+{
+    vec3 c = texture2D(tex, texCoord).rgb;
+    vec3 n = texture2D(tex, texCoord + vec2(0.0, texelSize.y)).rgb;
+    vec3 s = texture2D(tex, texCoord - vec2(0.0, texelSize.y)).rgb;
+    vec3 e = texture2D(tex, texCoord + vec2(texelSize.x, 0.0)).rgb;
+    vec3 w = texture2D(tex, texCoord - vec2(texelSize.x, 0.0)).rgb;
+
+    // Unsharp mask, limited to the range of the neighbours so that the
+    // edges of stars and labels don't get dark or bright rings
+    vec3 sharpened = c + sharpness * (c - 0.25 * (n + s + e + w));
+    vec3 lo = min(c, min(min(n, s), min(e, w)));
+    vec3 hi = max(c, max(max(n, s), max(e, w)));
+    gl_FragColor = vec4(clamp(sharpened, lo, hi), 1.0);
+}
@@ -490,7 +490,7 @@ bool processTriangleMeshChunk(std::istream& in, M3DChunkType chunkType, std::int
 }
 
 
-bool processModelChunk(std::istream& in, M3DChunkType chunkType, std::int32_t contentSize, M3DModel& model)
+bool processModelChunk(std::istream& in, M3DChunkType chunkType, std::int32_t contentSize, M3DSceneHandler& handler)
 {
     if (chunkType != M3DChunkType::TriangleMesh)
     {
@@ -500,7 +500,7 @@ bool processModelChunk(std::istream& in, M3DChunkType chunkType, std::int32_t co
     GetLogger()->debug("Processing TriangleMesh chunk\n");
     M3DTriangleMesh triMesh;
     if (!readChunks(in, contentSize, triMesh, processTriangleMeshChunk)) { return false; }
-    model.addTriMesh(std::move(triMesh));
+    handler.addTriMesh(std::move(triMesh));
     return true;
 }
 
@@ -711,51 +711,50 @@ bool processMaterialChunk(std::istream& in, M3DChunkType chunkType, std::int32_t
 }
 
 
-bool readNamedObject(std::istream& in, std::int32_t contentSize, M3DScene& scene)
+bool readNamedObject(std::istream& in, std::int32_t contentSize, M3DSceneHandler& handler)
 {
     std::string name;
     if (!readString(in, contentSize, name)) { return false; }
-    M3DModel model;
-    model.setName(std::move(name));
-    if (!readChunks(in, contentSize, model, processModelChunk)) { return false; }
-    scene.addModel(std::move(model));
+    handler.beginModel(std::move(name));
+    if (!readChunks(in, contentSize, handler, processModelChunk)) { return false; }
+    handler.endModel();
     return true;
 }
 
 
-bool readMaterialEntry(std::istream& in, std::int32_t contentSize, M3DScene& scene)
+bool readMaterialEntry(std::istream& in, std::int32_t contentSize, M3DSceneHandler& handler)
 {
     M3DMaterial material;
     if (!readChunks(in, contentSize, material, processMaterialChunk)) { return false; }
-    scene.addMaterial(std::move(material));
+    handler.addMaterial(std::move(material));
     return true;
 }
 
 
-bool readBackgroundColor(std::istream& in, std::int32_t contentSize, M3DScene& scene)
+bool readBackgroundColor(std::istream& in, std::int32_t contentSize, M3DSceneHandler& handler)
 {
     M3DColor color;
     if (!readChunks(in, contentSize, color, processColorChunk)) { return false; }
-    scene.setBackgroundColor(color);
+    handler.setBackgroundColor(color);
     return true;
 }
 
 
-bool processMeshdataChunk(std::istream& in, M3DChunkType chunkType, std::int32_t contentSize, M3DScene& scene)
+bool processMeshdataChunk(std::istream& in, M3DChunkType chunkType, std::int32_t contentSize, M3DSceneHandler& handler)
 {
     switch (chunkType)
     {
     case M3DChunkType::NamedObject:
         GetLogger()->debug("Processing NamedObject chunk\n");
-        return readNamedObject(in, contentSize, scene);
+        return readNamedObject(in, contentSize, handler);
 
     case M3DChunkType::MaterialEntry:
         GetLogger()->debug("Processing MaterialEntry chunk\n");
-        return readMaterialEntry(in, contentSize, scene);
+        return readMaterialEntry(in, contentSize, handler);
 
     case M3DChunkType::BackgroundColor:
         GetLogger()->debug("Processing BackgroundColor chunk\n");
-        return readBackgroundColor(in, contentSize, scene);
+        return readBackgroundColor(in, contentSize, handler);
 
     default:
         return skipChunk(in, chunkType, contentSize);
@@ -763,7 +762,7 @@ bool processMeshdataChunk(std::istream& in, M3DChunkType chunkType, std::int32_t
 }
 
 
-bool processTopLevelChunk(std::istream& in, M3DChunkType chunkType, std::int32_t contentSize, M3DScene& scene)
+bool processTopLevelChunk(std::istream& in, M3DChunkType chunkType, std::int32_t contentSize, M3DSceneHandler& handler)
 {
     if (chunkType != M3DChunkType::Meshdata)
     {
@@ -771,49 +770,82 @@ bool processTopLevelChunk(std::istream& in, M3DChunkType chunkType, std::int32_t
     }
 
     GetLogger()->debug("Processing Meshdata chunk\n");
-    return readChunks(in, contentSize, scene, processMeshdataChunk);
+    return readChunks(in, contentSize, handler, processMeshdataChunk);
 }
 
+
+// Collects the contents of the file into an M3DScene
+class SceneBuilder : public M3DSceneHandler
+{
+ public:
+    void addMaterial(M3DMaterial&& material) override { scene->addMaterial(std::move(material)); }
+    void beginModel(std::string&& name) override
+    {
+        model = M3DModel();
+        model.setName(std::move(name));
+    }
+    void addTriMesh(M3DTriangleMesh&& triMesh) override { model.addTriMesh(std::move(triMesh)); }
+    void endModel() override { scene->addModel(std::move(model)); }
+    void setBackgroundColor(const M3DColor& color) override { scene->setBackgroundColor(color); }
+
+    std::unique_ptr<M3DScene> scene{ std::make_unique<M3DScene>() };
+
+ private:
+    M3DModel model;
+};
+
 } // end unnamed namespace
 
 
-std::unique_ptr<M3DScene> Read3DSFile(std::istream& in)
+bool Read3DSFile(std::istream& in, M3DSceneHandler& handler)
 {
     if (M3DChunkType chunkType; !readChunkType(in, chunkType) || chunkType != M3DChunkType::Magic)
     {
         GetLogger()->error("Read3DSFile: Wrong magic number in header\n");
-        return nullptr;
+        return false;
     }
 
     std::int32_t chunkSize;
     if (!util::readLE<std::int32_t>(in, chunkSize) || chunkSize < chunkHeaderSize)
     {
         GetLogger()->error("Read3DSFile: Error reading 3DS file top level chunk size\n");
-        return nullptr;
+        return false;
     }
 
     GetLogger()->verbose("3DS file, {} bytes\n", chunkSize + chunkHeaderSize);
 
-    auto scene = std::make_unique<M3DScene>();
-    if (!readChunks(in, chunkSize - chunkHeaderSize, *scene, processTopLevelChunk))
-    {
-        return nullptr;
-    }
-
-    return scene;
+    return readChunks(in, chunkSize - chunkHeaderSize, handler, processTopLevelChunk);
 }
 
 
-std::unique_ptr<M3DScene> Read3DSFile(const fs::path& filename)
+bool Read3DSFile(const fs::path& filename, M3DSceneHandler& handler)
 {
     std::ifstream in(filename, std::ios::in | std::ios::binary);
     if (!in.good())
     {
         GetLogger()->error("Read3DSFile: Error opening {}\n", filename);
-        return nullptr;
+        return false;
     }
 
-    std::unique_ptr<M3DScene> scene = Read3DSFile(in);
-    in.close();
-    return scene;
+    return Read3DSFile(in, handler);
+}
+
+
+std::unique_ptr<M3DScene> Read3DSFile(std::istream& in)
+{
+    SceneBuilder builder;
+    if (!Read3DSFile(in, builder))
+        return nullptr;
+
+    return std::move(builder.scene);
+}
+
+
+std::unique_ptr<M3DScene> Read3DSFile(const fs::path& filename)
+{
+    SceneBuilder builder;
+    if (!Read3DSFile(filename, builder))
+        return nullptr;
+
+    return std::move(builder.scene);
 }
@@ -11,9 +11,32 @@
 
 #include <iosfwd>
 #include <memory>
+#include <string>
 #include <celcompat/filesystem.h>
 
+class M3DColor;
+class M3DMaterial;
 class M3DScene;
+class M3DTriangleMesh;
+
+// Receives the contents of a 3DS file while it is read: each material and
+// triangle mesh as soon as its chunk is complete, so that they can be
+// converted without keeping the whole scene in memory. The triangle meshes
+// of a named object are passed between beginModel and endModel.
+class M3DSceneHandler
+{
+ public:
+    virtual ~M3DSceneHandler() = default;
+
+    virtual void addMaterial(M3DMaterial&&) = 0;
+    virtual void beginModel(std::string&& /* name */) {}
+    virtual void addTriMesh(M3DTriangleMesh&&) = 0;
+    virtual void endModel() {}
+    virtual void setBackgroundColor(const M3DColor&) {}
+};
 
 std::unique_ptr<M3DScene> Read3DSFile(std::istream& in);
 std::unique_ptr<M3DScene> Read3DSFile(const fs::path& filename);
+
+bool Read3DSFile(std::istream& in, M3DSceneHandler& handler);
+bool Read3DSFile(const fs::path& filename, M3DSceneHandler& handler);
@@ -41,10 +41,6 @@ namespace celestia::astro
 namespace
 {
 
-// Difference in seconds between Terrestrial Time and International
-// Atomic Time
-constexpr double dTA = 32.184;
-
 // Table of leap second insertions. The leap second always
 // appears as the last second of the day immediately prior
 // to the date in the table.
@@ -82,6 +78,61 @@ constexpr std::array<LeapSecondRecord, 28> LeapSeconds
 
 celestia::util::array_view<LeapSecondRecord> g_leapSeconds = LeapSeconds; //NOSONAR
 
+// Index of the last leap second record whose insertion the time is past,
+// with isPast(i) telling whether it is past the record i > 0, or 0 when it
+// precedes them all. As the records are in order, isPast holds for all the
+// records before the found one. Most times are in the current era, past
+// the last record, so check it first, then the hint, which is the result
+// of the lookup of a neighbouring time, and only search the table for the
+// others.
+template<typename F>
+std::size_t
+findLeapSecond(F isPast, std::size_t hint = 0)
+{
+    const std::size_t last = g_leapSeconds.size() - 1;
+    if (last == 0 || isPast(last))
+        return last;
+
+    if (hint < last && (hint == 0 || isPast(hint)) && !isPast(hint + 1))
+        return hint;
+
+    // Find the first record in [1, last] which the time isn't past
+    std::size_t first = 1;
+    std::size_t count = last - 1;
+    while (count > 0)
+    {
+        std::size_t step = count / 2;
+        if (isPast(first + step))
+        {
+            first += step + 1;
+            count -= step + 1;
+        }
+        else
+        {
+            count = step;
+        }
+    }
+
+    return first - 1;
+}
+
+double
+jdutcToTAI(double utc, std::size_t& hint)
+{
+    hint = findLeapSecond([utc](std::size_t i) { return utc > g_leapSeconds[i].t; }, hint);
+    return utc + secsToDays(g_leapSeconds[hint].seconds);
+}
+
+double
+taiToJDUTC(double tai, std::size_t& hint)
+{
+    hint = findLeapSecond([tai](std::size_t i)
+    {
+        return tai - secsToDays(g_leapSeconds[i - 1].seconds) > g_leapSeconds[i].t;
+    }, hint);
+    return tai - secsToDays(g_leapSeconds[hint].seconds);
+}
+
 #if !(defined(__GNUC__) && !defined(_WIN32))
 class MonthAbbreviations
 {
@@ -340,23 +391,18 @@ parseDate(const std::string& s, Date& date)
 Date
 TAItoUTC(double tai)
 {
-    int dAT = g_leapSeconds[0].seconds;
-    int extraSecs = 0;
-
-    for (std::size_t i = g_leapSeconds.size() - 1; i > 0; i--) //NOSONAR
+    // The time is past the insertion of a leap second as soon as the clock
+    // reaches it with the previous offset, and within the leap second until
+    // it reaches it with the new one.
+    std::size_t i = findLeapSecond([tai](std::size_t j)
     {
-        if (tai - secsToDays(g_leapSeconds[i].seconds) >= g_leapSeconds[i].t)
-        {
-            dAT = g_leapSeconds[i].seconds;
-            break;
-        }
-        if (tai - secsToDays(g_leapSeconds[i - 1].seconds) >= g_leapSeconds[i].t)
-        {
-            dAT = g_leapSeconds[i].seconds;
-            extraSecs = g_leapSeconds[i].seconds - g_leapSeconds[i - 1].seconds;
-            break;
-        }
-    }
+        return tai - secsToDays(g_leapSeconds[j - 1].seconds) >= g_leapSeconds[j].t;
+    });
+
+    int dAT = g_leapSeconds[i].seconds;
+    int extraSecs = 0;
+    if (i > 0 && tai - secsToDays(g_leapSeconds[i].seconds) < g_leapSeconds[i].t)
+        extraSecs = g_leapSeconds[i].seconds - g_leapSeconds[i - 1].seconds;
 
     Date utcDate(tai - secsToDays(dAT));
     utcDate.seconds += extraSecs;
@@ -368,37 +414,15 @@ TAItoUTC(double tai)
 double
 UTCtoTAI(const Date& utc)
 {
-    double dAT = g_leapSeconds[0].seconds;
     auto utcjd = (double) Date(utc.year, utc.month, utc.day);
-
-    for (std::size_t i = g_leapSeconds.size() - 1; i > 0; i--)
-    {
-        if (utcjd >= g_leapSeconds[i].t)
-        {
-            dAT = g_leapSeconds[i].seconds;
-            break;
-        }
-    }
+    std::size_t i = findLeapSecond([utcjd](std::size_t j) { return utcjd >= g_leapSeconds[j].t; });
+    double dAT = g_leapSeconds[i].seconds;
 
     double tai = utcjd + secsToDays(utc.hour * 3600.0 + utc.minute * 60.0 + utc.seconds + dAT);
 
     return tai;
 }
 
-// Convert from Terrestrial Time to Atomic Time
-double
-TTtoTAI(double tt)
-{
-    return tt - secsToDays(dTA);
-}
-
-// Convert from Atomic Time to Terrestrial TIme
-double
-TAItoTT(double tai)
-{
-    return tai + secsToDays(dTA);
-}
-
 // Input is a TDB Julian Date; result is in seconds
 double
 TDBcorrection(double tdb)
@@ -502,36 +526,60 @@ UTCtoTDB(const Date& utc)
 double
 JDUTCtoTAI(double utc)
 {
-    double dAT = g_leapSeconds[0].seconds;
-
-    for (std::size_t i = g_leapSeconds.size() - 1; i > 0; i--)
-    {
-        if (utc > g_leapSeconds[i].t)
-        {
-            dAT = g_leapSeconds[i].seconds;
-            break;
-        }
-    }
-
-    return utc + secsToDays(dAT);
+    std::size_t hint = 0;
+    return jdutcToTAI(utc, hint);
 }
 
 // Convert from Julian Date UTC to TAI
 double
 TAItoJDUTC(double tai)
 {
-    double dAT = g_leapSeconds[0].seconds;
+    std::size_t hint = 0;
+    return taiToJDUTC(tai, hint);
+}
 
-    for (std::size_t i = g_leapSeconds.size() - 1; i > 0; i--)
-    {
-        if (tai - secsToDays(g_leapSeconds[i - 1].seconds) > g_leapSeconds[i].t)
-        {
-            dAT = g_leapSeconds[i].seconds;
-            break;
-        }
-    }
+// Convert from Barycentric Dynamical Time to Julian Date UTC
+double
+TDBtoJDUTC(double tdb)
+{
+    return TAItoJDUTC(TTtoTAI(TDBtoTT(tdb)));
+}
+
+// Convert from Julian Date UTC to Barycentric Dynamical Time
+double
+JDUTCtoTDB(double utc)
+{
+    return TTtoTDB(TAItoTT(JDUTCtoTAI(utc)));
+}
 
-    return tai - secsToDays(dAT);
+void
+TTtoTDB(celestia::util::array_view<double> tt, double* tdb)
+{
+    for (std::size_t i = 0; i < tt.size(); ++i)
+        tdb[i] = TTtoTDB(tt[i]);
+}
+
+void
+TDBtoTT(celestia::util::array_view<double> tdb, double* tt)
+{
+    for (std::size_t i = 0; i < tdb.size(); ++i)
+        tt[i] = TDBtoTT(tdb[i]);
+}
+
+void
+TDBtoJDUTC(celestia::util::array_view<double> tdb, double* utc)
+{
+    std::size_t hint = 0;
+    for (std::size_t i = 0; i < tdb.size(); ++i)
+        utc[i] = taiToJDUTC(TTtoTAI(TDBtoTT(tdb[i])), hint);
+}
+
+void
+JDUTCtoTDB(celestia::util::array_view<double> utc, double* tdb)
+{
+    std::size_t hint = 0;
+    for (std::size_t i = 0; i < utc.size(); ++i)
+        tdb[i] = TTtoTDB(TAItoTT(jdutcToTAI(utc[i], hint)));
 }
 
 } // end namespace celestia::astro
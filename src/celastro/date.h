@@ -28,6 +28,10 @@ constexpr inline double SECONDS_PER_DAY = 86400.0;
 constexpr inline double MINUTES_PER_DAY = 1440.0;
 constexpr inline double HOURS_PER_DAY   = 24.0;
 
+// Difference in seconds between Terrestrial Time and International
+// Atomic Time
+constexpr inline double TT_MINUS_TAI = 32.184;
+
 constexpr double secsToDays(double s)
 {
     return s * (1.0 / SECONDS_PER_DAY);
@@ -99,8 +103,16 @@ bool parseDate(const std::string&, Date&);
 // TDB - Barycentric Dynamical Time
 
 // Convert among uniform time scales
-double TTtoTAI(double tt);
-double TAItoTT(double tai);
+constexpr double TTtoTAI(double tt)
+{
+    return tt - secsToDays(TT_MINUS_TAI);
+}
+
+constexpr double TAItoTT(double tai)
+{
+    return tai + secsToDays(TT_MINUS_TAI);
+}
+
 double TTtoTDB(double tt);
 double TDBtoTT(double tdb);
 
@@ -109,6 +121,17 @@ double TDBtoTT(double tdb);
 // during leapseconds.
 double JDUTCtoTAI(double utc);
 double TAItoJDUTC(double tai);
+double TDBtoJDUTC(double tdb);
+double JDUTCtoTDB(double utc);
+
+// Convert arrays of times, writing the results to the output array, which
+// may be the input one. The conversions to and from UTC reuse the leap
+// second lookup of the previous time, so they are fastest for ordered
+// arrays.
+void TTtoTDB(celestia::util::array_view<double> tt, double* tdb);
+void TDBtoTT(celestia::util::array_view<double> tdb, double* tt);
+void TDBtoJDUTC(celestia::util::array_view<double> tdb, double* utc);
+void JDUTCtoTDB(celestia::util::array_view<double> utc, double* tdb);
 
 // Convert to and from UTC dates
 double UTCtoTAI(const Date& utc);
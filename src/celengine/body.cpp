@@ -59,6 +59,8 @@ constexpr auto CLASSES_SECONDARY_ILLUMINATOR = BodyClassification::Planet      |
 
 }
 
+std::atomic<std::uint64_t> Body::ephemerisEpoch{ 0 };
+
 Body::Body(PlanetarySystem* _system, const std::string& _name) :
     system(_system),
     orbitVisibility(UseClassVisibility)
@@ -107,7 +109,7 @@ Body::setDefaultProperties()
 /*! Return the list of all names (non-localized) by which this
  *  body is known.
  */
-const std::vector<std::string>&
+const std::vector<util::InternedString>&
 Body::getNames() const
 {
     return names;
@@ -127,7 +129,7 @@ Body::getName(bool i18n) const
 std::string
 Body::getPath(const StarDatabase* starDB, char delimiter) const
 {
-    std::string name = names[0];
+    std::string name = names[0].str();
     const PlanetarySystem* planetarySystem = system;
     while (planetarySystem != nullptr)
     {
@@ -170,7 +172,7 @@ Body::hasLocalizedName() const
 void
 Body::setName(const std::string& name)
 {
-    names[0] = name;
+    names[0] = util::InternedString(name);
 
     // Gettext uses the empty string to store various metadata, so don't try
     // to translate it.
@@ -187,7 +189,7 @@ Body::setName(const std::string& name)
     }
     else
     {
-        localizedName = locName;
+        localizedName = util::InternedString(locName);
     }
 }
 
@@ -197,10 +199,10 @@ void
 Body::addAlias(const std::string& alias)
 {
     // Don't add an alias if it matches the primary name
-    if (alias != names[0])
+    if (alias != names[0].str())
     {
-        names.push_back(alias);
-        system->addAlias(this, alias);
+        names.emplace_back(alias);
+        system->addAlias(this, names.back());
     }
 }
 
@@ -234,6 +236,7 @@ void
 Body::setTimeline(std::unique_ptr<Timeline>&& newTimeline)
 {
     timeline = std::move(newTimeline);
+    ephemerisEpoch.fetch_add(1, std::memory_order_relaxed);
     markChanged();
 }
 
@@ -263,6 +266,12 @@ Body::getOrbit(double tdb) const
     return timeline->findPhase(tdb)->orbit().get();
 }
 
+const std::shared_ptr<const celestia::ephem::Orbit>&
+Body::getSharedOrbit(double tdb) const
+{
+    return timeline->findPhase(tdb)->orbit();
+}
+
 const std::shared_ptr<const ReferenceFrame>&
 Body::getBodyFrame(double tdb) const
 {
@@ -645,8 +654,7 @@ Body::getAngularVelocity(double tdb) const
 Eigen::Matrix4d
 Body::getLocalToAstrocentric(double tdb) const
 {
-    const TimelinePhase* phase = timeline->findPhase(tdb).get();
-    Eigen::Vector3d p = phase->orbitFrame()->convertToAstrocentric(phase->orbit()->positionAtTime(tdb), tdb);
+    Eigen::Vector3d p = getAstrocentricPosition(tdb);
     return Eigen::Transform<double, 3, Eigen::Affine>(Eigen::Translation3d(p)).matrix();
 }
 
@@ -660,6 +668,49 @@ Body::getAstrocentricPosition(double tdb) const
     return phase->orbitFrame()->convertToAstrocentric(phase->orbit()->positionAtTime(tdb), tdb);
 }
 
+void
+Body::setEphemerisState(double tdb,
+                        const Star* star,
+                        const Eigen::Vector3d& astrocentricPosition,
+                        const Eigen::Quaterniond& orientation)
+{
+    ephemerisState.tdb = tdb;
+    ephemerisState.epoch = getEphemerisEpoch();
+    ephemerisState.star = star;
+    ephemerisState.astrocentricPosition = astrocentricPosition;
+    ephemerisState.orientation = orientation;
+}
+
+bool
+Body::hasEphemerisState(double tdb) const
+{
+    return ephemerisState.tdb == tdb && ephemerisState.epoch == getEphemerisEpoch();
+}
+
+UniversalCoord
+Body::getRenderPosition(double tdb) const
+{
+    if (hasEphemerisState(tdb))
+        return ephemerisState.star->getPosition(tdb).offsetKm(ephemerisState.astrocentricPosition);
+    return getPosition(tdb);
+}
+
+Eigen::Vector3d
+Body::getRenderAstrocentricPosition(double tdb) const
+{
+    if (hasEphemerisState(tdb))
+        return ephemerisState.astrocentricPosition;
+    return getAstrocentricPosition(tdb);
+}
+
+Eigen::Quaterniond
+Body::getRenderOrientation(double tdb) const
+{
+    if (hasEphemerisState(tdb))
+        return ephemerisState.orientation;
+    return getOrientation(tdb);
+}
+
 /*! Get a rotation that converts from the ecliptic frame to the body frame.
  */
 Eigen::Quaterniond
@@ -1039,7 +1090,7 @@ PlanetarySystem::addAlias(Body* body, const std::string& alias)
 {
     assert(body->getSystem() == this);
 
-    objectIndex.try_emplace(alias, body);
+    objectIndex.try_emplace(util::InternedString(alias).str(), body);
 }
 
 Body*
@@ -1068,20 +1119,18 @@ PlanetarySystem::removeBody(const Body* body)
 void
 PlanetarySystem::addBodyToNameIndex(Body* body)
 {
-    const std::vector<std::string>& names = body->getNames();
-    for (const auto& name : names)
+    for (const auto& name : body->getNames())
     {
-        objectIndex.try_emplace(name, body);
+        objectIndex.try_emplace(name.str(), body);
     }
 }
 
 void
 PlanetarySystem::removeBodyFromNameIndex(const Body* body)
 {
-    const std::vector<std::string>& names = body->getNames();
-    for (const auto& name : names)
+    for (const auto& name : body->getNames())
     {
-        auto iter = objectIndex.find(name);
+        auto iter = objectIndex.find(name.str());
         if (iter == objectIndex.end() || iter->second != body)
             continue;
         objectIndex.erase(iter);
@@ -1139,15 +1188,16 @@ PlanetarySystem::getCompletion(std::vector<celestia::engine::Completion>& comple
     // Search through all names in this planetary system.
     for (const auto& index : objectIndex)
     {
-        const std::string& alias = index.first;
+        std::string_view alias = index.first;
 
         if (UTF8StartsWith(alias, _name))
         {
-            completion.emplace_back(alias, Selection(index.second));
+            completion.emplace_back(std::string(alias), Selection(index.second));
         }
         else
         {
-            std::string lname = D_(alias.c_str());
+            // The keys are views of null-terminated interned strings
+            std::string lname = D_(alias.data());
             if (lname != alias && UTF8StartsWith(lname, _name))
                 completion.emplace_back(lname, Selection(index.second));
         }
@@ -1402,7 +1452,12 @@ BodyFeaturesManager::computeLocations(const Body* body)
 
     const Geometry* g = engine::GetGeometryManager()->find(geometry);
     if (g == nullptr)
+    {
+        // Try again once a model loading in the background is ready
+        if (engine::GetGeometryManager()->getState(geometry) == ResourceState::Pending)
+            bodyLocations.locationsComputed = false;
         return;
+    }
 
     // TODO: Implement separate radius and bounding radius so that this hack is
     // not necessary.
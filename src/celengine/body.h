@@ -9,7 +9,9 @@
 
 #pragma once
 
+#include <atomic>
 #include <cstdint>
+#include <limits>
 #include <map>
 #include <memory>
 #include <optional>
@@ -25,6 +27,7 @@
 #include <celutil/flag.h>
 #include <celutil/ranges.h>
 #include <celutil/reshandle.h>
+#include <celutil/stringinterner.h>
 #include <celutil/utf8.h>
 #include "multitexture.h"
 #include "surface.h"
@@ -83,7 +86,8 @@ private:
     void addBodyToNameIndex(Body* body);
     void removeBodyFromNameIndex(const Body* body);
 
-    using ObjectIndex = std::map<std::string, Body*, UTF8StringOrderingPredicate>;
+    // The keys are the interned names of the bodies
+    using ObjectIndex = std::map<std::string_view, Body*, UTF8StringOrderingPredicate>;
 
     Star* star;
     Body* primary{nullptr};
@@ -212,7 +216,7 @@ public:
     void setDefaultProperties();
 
     PlanetarySystem* getSystem() const;
-    const std::vector<std::string>& getNames() const;
+    const std::vector<celestia::util::InternedString>& getNames() const;
     const std::string& getName(bool i18n = false) const;
     std::string getPath(const StarDatabase*, char delimiter = '/') const;
     const std::string& getLocalizedName() const;
@@ -227,6 +231,9 @@ public:
 
     const std::shared_ptr<const ReferenceFrame>& getOrbitFrame(double tdb) const;
     const celestia::ephem::Orbit* getOrbit(double tdb) const;
+    // The orbit with shared ownership, for users which may outlive the
+    // timeline, e.g. when a catalog is reloaded
+    const std::shared_ptr<const celestia::ephem::Orbit>& getSharedOrbit(double tdb) const;
     const std::shared_ptr<const ReferenceFrame>& getBodyFrame(double tdb) const;
     const celestia::ephem::RotationModel* getRotationModel(double tdb) const;
 
@@ -311,6 +318,24 @@ public:
     inline Eigen::Quaterniond getEclipticToBodyFixed(double tdb) const { return getOrientation(tdb); }
     Eigen::Matrix4d getBodyFixedToAstrocentric(double) const;
 
+    // Store the state computed by FrameTree::updateBodyStates. It is only
+    // valid until the time or the timeline of any body changes.
+    void setEphemerisState(double tdb,
+                           const Star* star,
+                           const Eigen::Vector3d& astrocentricPosition,
+                           const Eigen::Quaterniond& orientation);
+    static std::uint64_t getEphemerisEpoch() { return ephemerisEpoch.load(std::memory_order_relaxed); }
+
+    // The stored state if it is valid for tdb, or the same as getPosition,
+    // getAstrocentricPosition and getOrientation otherwise. The state is
+    // rewritten every frame without synchronization, so these are only for
+    // the renderer, on the thread which calls FrameTree::updateBodyStates
+    // and the jobs it waits for. Other threads must use the getters above,
+    // which always evaluate the orbits and frames.
+    UniversalCoord getRenderPosition(double tdb) const;
+    Eigen::Vector3d getRenderAstrocentricPosition(double tdb) const;
+    Eigen::Quaterniond getRenderOrientation(double tdb) const;
+
     Eigen::Vector3d planetocentricToCartesian(double lon, double lat, double alt) const;
     Eigen::Vector3d planetocentricToCartesian(const Eigen::Vector3d& lonLatAlt) const;
     Eigen::Vector3d cartesianToPlanetocentric(const Eigen::Vector3d& v) const;
@@ -352,9 +377,25 @@ public:
 
 private:
     void setName(const std::string& name);
+    bool hasEphemerisState(double tdb) const;
+
+    struct EphemerisState
+    {
+        double tdb;
+        std::uint64_t epoch;
+        // Star at the root of the frame hierarchy
+        const Star* star;
+        Eigen::Vector3d astrocentricPosition;
+        Eigen::Quaterniond orientation;
+    };
+
+    // Incremented whenever a timeline changes, which invalidates the
+    // stored states of all bodies. Timelines may be set while loading on
+    // other threads.
+    static std::atomic<std::uint64_t> ephemerisEpoch;
 
-    std::vector<std::string> names{ 1 };
-    std::string localizedName;
+    std::vector<celestia::util::InternedString> names{ 1 };
+    celestia::util::InternedString localizedName;
 
     // Parent in the name hierarchy
     PlanetarySystem* system;
@@ -390,6 +431,9 @@ private:
     // Track enabled features to allow fast rejection during lookup
     BodyFeatures features{ BodyFeatures::None };
 
+    EphemerisState ephemerisState{ std::numeric_limits<double>::quiet_NaN(), 0, nullptr,
+                                   Eigen::Vector3d::Zero(), Eigen::Quaterniond::Identity() };
+
     bool visible{ true };
     bool clickable{ true };
     VisibilityPolicy orbitVisibility : 3;
@@ -9,6 +9,17 @@
 
 #include "completion.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <utility>
+
+#include <celutil/greek.h>
+#include <celutil/strnatcmp.h>
+#include <celutil/utf8.h>
+#include "deepskyobj.h"
+#include "star.h"
+
 namespace celestia::engine
 {
 
@@ -34,4 +45,64 @@ Selection Completion::getSelection() const
     }, selection);
 }
 
+void
+rankCompletions(std::vector<Completion>& completion, std::string_view text)
+{
+    auto pos = text.rfind('/');
+    std::string_view typed = pos == std::string_view::npos ? text : text.substr(pos + 1);
+    std::string typedGreek = ReplaceGreekLetter(typed);
+
+    struct RankKey
+    {
+        std::string name;
+        float magnitude;
+        std::uint32_t index;
+        bool exact;
+    };
+
+    std::vector<RankKey> keys;
+    keys.reserve(completion.size());
+    for (std::size_t i = 0; i < completion.size(); ++i)
+    {
+        auto& key = keys.emplace_back();
+        key.name = completion[i].getName();
+        key.index = static_cast<std::uint32_t>(i);
+        key.exact = UTF8StringCompare(key.name, typed) == 0 || UTF8StringCompare(key.name, typedGreek) == 0;
+
+        // The bodies and locations come from the solar systems of the
+        // selection and the observer, rank them above the catalogs
+        Selection sel = completion[i].getSelection();
+        switch (sel.getType())
+        {
+        case SelectionType::Star:
+            key.magnitude = sel.star()->getAbsoluteMagnitude();
+            break;
+        case SelectionType::DeepSky:
+            key.magnitude = sel.deepsky()->getAbsoluteMagnitude();
+            break;
+        default:
+            key.magnitude = -std::numeric_limits<float>::infinity();
+            break;
+        }
+    }
+
+    std::sort(keys.begin(), keys.end(),
+              [](const RankKey& k0, const RankKey& k1)
+              {
+                  if (k0.exact != k1.exact)
+                      return k0.exact;
+                  if (k0.magnitude != k1.magnitude)
+                      return k0.magnitude < k1.magnitude;
+                  if (int order = strnatcmp(k0.name, k1.name); order != 0)
+                      return order < 0;
+                  return k0.index < k1.index;
+              });
+
+    std::vector<Completion> ranked;
+    ranked.reserve(completion.size());
+    for (const auto& key : keys)
+        ranked.push_back(std::move(completion[key.index]));
+    completion = std::move(ranked);
+}
+
 }
@@ -11,7 +11,9 @@
 
 #include <functional>
 #include <string>
+#include <string_view>
 #include <variant>
+#include <vector>
 #include <celengine/selection.h>
 
 namespace celestia::engine
@@ -33,4 +35,14 @@ private:
     std::variant<Selection, std::function<Selection()>> selection;
 };
 
+// Called when a source of completions has been added, as the stars of the
+// catalog are, returning false stops the completion
+using CompletionProgress = std::function<bool()>;
+
+// Order the completions of text by exact matches of the last path component
+// first, then prefix matches. Within each, the objects of the solar systems
+// come first, then the catalog objects from the brightest, then the names in
+// natural order.
+void rankCompletions(std::vector<Completion>& completion, std::string_view text);
+
 }
@@ -0,0 +1,112 @@
+// completionquery.cpp
+//
+// Copyright (C) 2025-present, the Celestia Development Team
+//
+// Background completion of object names.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include "completionquery.h"
+
+#include <algorithm>
+#include <chrono>
+#include <utility>
+
+#include <celutil/threadpool.h>
+#include "universe.h"
+
+namespace celestia::engine
+{
+
+CompletionQuery::~CompletionQuery()
+{
+    // The workers read the universe, which must outlive them
+    cancel();
+    for (auto& pending : m_pending)
+        pending.wait();
+}
+
+void
+CompletionQuery::cancel()
+{
+    if (m_state != nullptr)
+        m_state->cancelled.store(true);
+    m_state = nullptr;
+
+    m_pending.erase(std::remove_if(m_pending.begin(), m_pending.end(),
+                                   [](const auto& pending)
+                                   {
+                                       return pending.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+                                   }),
+                    m_pending.end());
+}
+
+void
+CompletionQuery::start(const Universe* universe,
+                       std::string_view text,
+                       std::vector<Selection> contexts,
+                       bool withLocations)
+{
+    cancel();
+    auto state = std::make_shared<State>();
+    m_state = state;
+
+    m_pending.push_back(util::GetThreadPool()->async(
+        [universe, state, text = std::string(text), contexts = std::move(contexts), withLocations]
+        {
+            std::vector<Completion> completion;
+            auto publish = [&state, &text, &completion](bool finished)
+            {
+                if (state->cancelled.load())
+                    return false;
+
+                // The search goes on with the completions found so far
+                std::vector<Completion> ranked = finished ? std::move(completion) : completion;
+                rankCompletions(ranked, text);
+
+                std::scoped_lock lock(state->mutex);
+                state->completion = std::move(ranked);
+                state->updated = true;
+                state->finished = finished;
+                return !state->cancelled.load();
+            };
+
+            universe->getCompletionPath(completion,
+                                        text,
+                                        { contexts.data(), contexts.size() },
+                                        withLocations,
+                                        [&publish] { return publish(false); });
+            publish(true);
+        }));
+}
+
+bool
+CompletionQuery::poll(std::vector<Completion>& completion)
+{
+    if (m_state == nullptr)
+        return false;
+
+    std::scoped_lock lock(m_state->mutex);
+    if (!m_state->updated)
+        return false;
+
+    completion = std::move(m_state->completion);
+    m_state->completion.clear();
+    m_state->updated = false;
+    return true;
+}
+
+bool
+CompletionQuery::isRunning() const
+{
+    if (m_state == nullptr)
+        return false;
+
+    std::scoped_lock lock(m_state->mutex);
+    return !m_state->finished || m_state->updated;
+}
+
+} // end namespace celestia::engine
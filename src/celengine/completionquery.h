@@ -0,0 +1,74 @@
+// completionquery.h
+//
+// Copyright (C) 2025-present, the Celestia Development Team
+//
+// Background completion of object names.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <atomic>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <celengine/completion.h>
+#include <celengine/selection.h>
+
+class Universe;
+
+namespace celestia::engine
+{
+
+// Completes object names on the thread pool. Starting a query supersedes
+// the previous one, which stops at its next source of completions. The
+// completions found so far are ranked after each source and picked up by
+// poll, so that the bodies of the solar systems show before the catalogs
+// have been searched. The query runs while the main thread renders, so it
+// must only read the catalogs and the values captured when it was started.
+class CompletionQuery
+{
+public:
+    CompletionQuery() = default;
+    ~CompletionQuery();
+
+    CompletionQuery(const CompletionQuery&) = delete;
+    CompletionQuery& operator=(const CompletionQuery&) = delete;
+    CompletionQuery(CompletionQuery&&) = delete;
+    CompletionQuery& operator=(CompletionQuery&&) = delete;
+
+    void start(const Universe* universe,
+               std::string_view text,
+               std::vector<Selection> contexts,
+               bool withLocations);
+    void cancel();
+
+    // Move the completions ranked since the last call into completion and
+    // return true, or return false if there are none
+    bool poll(std::vector<Completion>& completion);
+
+    // Whether the query may still deliver completions
+    bool isRunning() const;
+
+private:
+    struct State
+    {
+        std::atomic<bool> cancelled{ false };
+        std::mutex mutex;
+        std::vector<Completion> completion;
+        bool updated{ false };
+        bool finished{ false };
+    };
+
+    std::shared_ptr<State> m_state;
+    std::vector<std::future<void>> m_pending;
+};
+
+} // end namespace celestia::engine
@@ -0,0 +1,45 @@
+// cubefaceprojectionmode.cpp
+//
+// Copyright (C) 2025, Celestia Development Team
+//
+// Projection of the faces of a cube map.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include "cubefaceprojectionmode.h"
+
+#include <celcompat/numbers.h>
+
+namespace celestia::engine
+{
+
+CubeFaceProjectionMode::CubeFaceProjectionMode(float size, int screenDpi) :
+    // The distance to the screen only matters for the field of view
+    PerspectiveProjectionMode(size, size, 1, screenDpi)
+{
+}
+
+float CubeFaceProjectionMode::getMinimumFOV() const
+{
+    return getFOV(1.0f);
+}
+
+float CubeFaceProjectionMode::getMaximumFOV() const
+{
+    return getFOV(1.0f);
+}
+
+float CubeFaceProjectionMode::getFOV(float /*zoom*/) const
+{
+    return celestia::numbers::pi_v<float> * 0.5f;
+}
+
+float CubeFaceProjectionMode::getZoom(float /*fov*/) const
+{
+    return 1.0f;
+}
+
+} // end namespace celestia::engine
@@ -0,0 +1,33 @@
+// cubefaceprojectionmode.h
+//
+// Copyright (C) 2025, Celestia Development Team
+//
+// Projection of the faces of a cube map.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <celengine/perspectiveprojectionmode.h>
+
+namespace celestia::engine
+{
+
+// Perspective projection with the 90 degree field of view of a cube face,
+// whatever the zoom of the observer
+class CubeFaceProjectionMode : public PerspectiveProjectionMode
+{
+public:
+    CubeFaceProjectionMode(float size, int screenDpi);
+    ~CubeFaceProjectionMode() override = default;
+
+    float getMinimumFOV() const override;
+    float getMaximumFOV() const override;
+    float getFOV(float zoom) const override;
+    float getZoom(float fov) const override;
+};
+
+} // end namespace celestia::engine
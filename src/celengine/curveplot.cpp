@@ -6,7 +6,9 @@
 // plot is a series of cubic curves. The curves are transformed
 // to camera space in software because double precision is absolutely
 // required. The cubics are adaptively subdivided based on distance from
-// the camera position.
+// the camera position. Samples far enough from the camera to be joined by
+// straight lines can instead be drawn from a static buffer, with positions
+// split into two floats.
 //
 // curveplot is free software; you can redistribute it and/or
 // modify it under the terms of the GNU Lesser General Public
@@ -29,12 +31,17 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstddef>
 #include <memory>
+#include <utility>
 #include <vector>
 #include <celrender/linerenderer.h>
+#include <celutil/flag.h>
 
 #include "curveplot.h"
+#include "glsupport.h"
 #include "render.h"
+#include "renderflags.h"
 #include "shadermanager.h"
 
 using celestia::render::LineRenderer;
@@ -46,6 +53,27 @@ constexpr unsigned int SubdivisionFactor = 8;
 constexpr double InvSubdivisionFactor = 1.0 / static_cast<double>(SubdivisionFactor);
 constexpr float OrbitThickness = 1.0f;
 
+// Segments per chunk of the buffered samples, which are either all drawn
+// from the buffer or all drawn by the CPU
+constexpr unsigned int BufferChunkSegments = 16;
+
+// A sample in the buffer, as the nearest float to each coordinate and the
+// remainder
+struct BufferVertex
+{
+    Eigen::Vector3f high;
+    Eigen::Vector3f low;
+    // Days from the first sample
+    float t;
+};
+
+inline void
+splitDouble(const Eigen::Vector3d& v, Eigen::Vector3f& high, Eigen::Vector3f& low)
+{
+    high = v.cast<float>();
+    low = (v - high.cast<double>()).cast<float>();
+}
+
 // Convert a 3-vector to a 4-vector by adding a zero
 inline Eigen::Vector4d
 zeroExtend(const Eigen::Vector3d& v)
@@ -378,6 +406,8 @@ CurvePlot::addSample(const CurvePlotSample& sample)
     else
         m_samples.push_front(sample);
 
+    ++m_revision;
+
     if (m_samples.size() > 1)
     {
         // Calculate a bounding radius for this segment. No point on the curve will
@@ -418,6 +448,7 @@ CurvePlot::removeSamplesBefore(double t)
     while (!m_samples.empty() && m_samples.front().t < t)
     {
         m_samples.pop_front();
+        ++m_revision;
     }
 }
 
@@ -430,6 +461,7 @@ CurvePlot::removeSamplesAfter(double t)
     while (!m_samples.empty() && m_samples.back().t > t)
     {
         m_samples.pop_back();
+        ++m_revision;
     }
 }
 
@@ -893,3 +925,244 @@ CurvePlot::renderFaded(const Eigen::Affine3d& modelview,
     vbuf.flush();
     vbuf.finish();
 }
+
+
+/** Upload the samples to the GPU, and compute the bounds of each chunk of
+  * samples.
+  */
+void
+CurvePlot::updateBuffer()
+{
+    m_bufferRevision = m_revision;
+    m_chunks.clear();
+    if (m_samples.size() < 2)
+        return;
+
+    m_bufferStartTime = m_samples.front().t;
+
+    std::vector<BufferVertex> vertices;
+    vertices.reserve(m_samples.size());
+    for (const CurvePlotSample& sample : m_samples)
+    {
+        BufferVertex& vertex = vertices.emplace_back();
+        splitDouble(sample.position, vertex.high, vertex.low);
+        vertex.t = static_cast<float>(sample.t - m_bufferStartTime);
+    }
+
+    auto lastSample = static_cast<unsigned int>(m_samples.size() - 1);
+    for (unsigned int first = 0; first < lastSample; first += BufferChunkSegments)
+    {
+        unsigned int last = std::min(first + BufferChunkSegments, lastSample);
+
+        Eigen::AlignedBox3d bounds;
+        for (unsigned int i = first; i <= last; i++)
+            bounds.extend(m_samples[i].position);
+
+        // No point on a segment is further from its first sample than the
+        // bounding radius of the segment, which is kept with its last sample
+        BufferChunk& chunk = m_chunks.emplace_back();
+        chunk.center = bounds.center();
+        chunk.radius = (m_samples[last].position - chunk.center).norm();
+        chunk.maxSegmentRadius = 0.0;
+        for (unsigned int i = first + 1; i <= last; i++)
+        {
+            double segmentRadius = m_samples[i].boundingRadius;
+            chunk.radius = std::max(chunk.radius, (m_samples[i - 1].position - chunk.center).norm() + segmentRadius);
+            chunk.maxSegmentRadius = std::max(chunk.maxSegmentRadius, segmentRadius);
+        }
+    }
+
+    m_bo = celestia::gl::Buffer(celestia::gl::Buffer::TargetHint::Array);
+    m_bo.setStorage(vertices);
+    m_vo = celestia::gl::VertexObject(celestia::gl::VertexObject::Primitive::LineStrip);
+    m_vo.addVertexBuffer(m_bo,
+                         CelestiaGLProgram::VertexCoordAttributeIndex,
+                         3,
+                         celestia::gl::VertexObject::DataType::Float,
+                         false,
+                         sizeof(BufferVertex),
+                         offsetof(BufferVertex, high));
+    m_vo.addVertexBuffer(m_bo,
+                         CelestiaGLProgram::TextureCoord0AttributeIndex,
+                         3,
+                         celestia::gl::VertexObject::DataType::Float,
+                         false,
+                         sizeof(BufferVertex),
+                         offsetof(BufferVertex, low));
+    m_vo.addVertexBuffer(m_bo,
+                         CelestiaGLProgram::TextureCoord1AttributeIndex,
+                         1,
+                         celestia::gl::VertexObject::DataType::Float,
+                         false,
+                         sizeof(BufferVertex),
+                         offsetof(BufferVertex, t));
+}
+
+
+std::size_t
+CurvePlot::bufferBytes() const
+{
+    if (m_chunks.empty())
+        return 0;
+    return m_samples.size() * sizeof(BufferVertex) + m_chunks.size() * sizeof(BufferChunk);
+}
+
+
+void
+CurvePlot::renderRange(const Eigen::Affine3d& modelview,
+                       double nearZ,
+                       double farZ,
+                       const Eigen::Vector3d viewFrustumPlaneNormals[],
+                       double subdivisionThreshold,
+                       double startTime,
+                       double endTime,
+                       const Eigen::Vector4f& color,
+                       double fadeStartTime,
+                       double fadeEndTime) const
+{
+    if (fadeStartTime == fadeEndTime)
+    {
+        render(modelview, nearZ, farZ, viewFrustumPlaneNormals, subdivisionThreshold,
+               startTime, endTime, color);
+    }
+    else
+    {
+        renderFaded(modelview, nearZ, farZ, viewFrustumPlaneNormals, subdivisionThreshold,
+                    startTime, endTime, color, fadeStartTime, fadeEndTime);
+    }
+}
+
+
+/** Draw the part of the curve between startTime and endTime as render and
+  * renderFaded do, but draw the samples far enough from the camera to be
+  * joined by straight lines from a buffer which stays on the GPU until the
+  * samples change. The positions in the buffer are split into two floats, and
+  * are made relative to the camera by the vertex shader without losing the
+  * precision of a double. The interval and the fading are applied by the
+  * shader, so that the buffer doesn't depend on them. The runs of samples near
+  * the camera are still subdivided on the CPU.
+  *
+  * The curve is faded as in renderFaded unless fadeStartTime and fadeEndTime
+  * are equal.
+  */
+void
+CurvePlot::renderBuffered(const Eigen::Affine3d& modelview,
+                          double nearZ,
+                          double farZ,
+                          const Eigen::Vector3d viewFrustumPlaneNormals[],
+                          double subdivisionThreshold,
+                          double startTime,
+                          double endTime,
+                          const Eigen::Vector4f& color,
+                          double fadeStartTime,
+                          double fadeEndTime)
+{
+    if (m_samples.empty() || endTime <= m_samples.front().t || startTime >= m_samples.back().t)
+        return;
+
+    // Wide lines are drawn as triangles by the line renderer
+    float lineWidth = OrbitThickness * m_renderer.getScaleFactor();
+    if (celestia::util::is_set(m_renderer.getRenderFlags(), RenderFlags::ShowSmoothLines))
+        lineWidth *= 1.5f;
+
+    CelestiaGLProgram* prog = m_renderer.getShaderManager().getShader("orbitpath");
+    if (prog == nullptr || lineWidth > celestia::gl::maxLineWidth)
+    {
+        renderRange(modelview, nearZ, farZ, viewFrustumPlaneNormals, subdivisionThreshold,
+                    startTime, endTime, color, fadeStartTime, fadeEndTime);
+        return;
+    }
+
+    if (m_bufferRevision != m_revision)
+        updateBuffer();
+
+    // The segments covering the interval; the parts outside of it are
+    // discarded by the shader
+    auto firstSample = static_cast<unsigned int>(std::upper_bound(m_samples.begin(), m_samples.end(), startTime,
+                                                                  [](double t, const CurvePlotSample& sample) { return t < sample.t; })
+                                                 - m_samples.begin());
+    auto lastSample = static_cast<unsigned int>(std::lower_bound(m_samples.begin(), m_samples.end(), endTime,
+                                                                 [](const CurvePlotSample& sample, double t) { return sample.t < t; })
+                                                - m_samples.begin());
+    firstSample = std::max(firstSample, 1u) - 1;
+    lastSample = std::min(lastSample, static_cast<unsigned int>(m_samples.size() - 1));
+
+    // The camera in the frame of the curve
+    Eigen::Matrix3d orientation = modelview.linear();
+    Eigen::Vector3d eyePosition = -(orientation.transpose() * modelview.translation());
+
+    HighPrec_Frustum viewFrustum(nearZ, farZ, viewFrustumPlaneNormals);
+
+    // Runs of samples drawn from the buffer, and time intervals drawn by the CPU
+    std::vector<int> firsts;
+    std::vector<int> counts;
+    std::vector<std::pair<double, double>> cpuRanges;
+
+    for (unsigned int chunkIndex = firstSample / BufferChunkSegments;
+         chunkIndex < m_chunks.size() && chunkIndex * BufferChunkSegments < lastSample;
+         chunkIndex++)
+    {
+        const BufferChunk& chunk = m_chunks[chunkIndex];
+        unsigned int first = std::max(chunkIndex * BufferChunkSegments, firstSample);
+        unsigned int last = std::min((chunkIndex + 1) * BufferChunkSegments, lastSample);
+
+        if (viewFrustum.cullSphere(modelview * chunk.center, chunk.radius))
+            continue;
+
+        // The same test as in render, for the whole chunk
+        double minDistance = (chunk.center - eyePosition).norm() - chunk.radius;
+        if (chunk.maxSegmentRadius >= subdivisionThreshold * minDistance)
+        {
+            double rangeStart = std::max(m_samples[first].t, startTime);
+            double rangeEnd = std::min(m_samples[last].t, endTime);
+            if (!cpuRanges.empty() && cpuRanges.back().second == rangeStart)
+                cpuRanges.back().second = rangeEnd;
+            else
+                cpuRanges.emplace_back(rangeStart, rangeEnd);
+        }
+        else if (!firsts.empty() && static_cast<unsigned int>(firsts.back() + counts.back() - 1) == first)
+        {
+            counts.back() += static_cast<int>(last - first);
+        }
+        else
+        {
+            firsts.push_back(static_cast<int>(first));
+            counts.push_back(static_cast<int>(last - first + 1));
+        }
+    }
+
+    if (!firsts.empty())
+    {
+        Eigen::Vector3f eyeHigh;
+        Eigen::Vector3f eyeLow;
+        splitDouble(eyePosition, eyeHigh, eyeLow);
+
+        prog->use();
+        prog->setMVPMatrices(m_renderer.getCurrentProjectionMatrix(), ModelViewMatrix);
+        prog->vec3Param("eyeHigh") = eyeHigh;
+        prog->vec3Param("eyeLow") = eyeLow;
+        prog->mat3Param("orientation") = orientation.cast<float>();
+        prog->vec4Param("color") = color;
+        prog->vec2Param("window") = Eigen::Vector2f(static_cast<float>(startTime - m_bufferStartTime),
+                                                    static_cast<float>(endTime - m_bufferStartTime));
+        if (fadeStartTime == fadeEndTime)
+        {
+            prog->floatParam("fadeStart") = 0.0f;
+            prog->floatParam("fadeRate") = 0.0f;
+        }
+        else
+        {
+            prog->floatParam("fadeStart") = static_cast<float>(fadeStartTime - m_bufferStartTime);
+            prog->floatParam("fadeRate") = static_cast<float>(1.0 / (fadeEndTime - fadeStartTime));
+        }
+        glLineWidth(lineWidth);
+
+        m_vo.multiDraw(celestia::gl::VertexObject::Primitive::LineStrip, counts, firsts);
+    }
+
+    for (const auto& [rangeStart, rangeEnd] : cpuRanges)
+    {
+        renderRange(modelview, nearZ, farZ, viewFrustumPlaneNormals, subdivisionThreshold,
+                    rangeStart, rangeEnd, color, fadeStartTime, fadeEndTime);
+    }
+}
@@ -6,7 +6,9 @@
 // plot is a series of cubic curves. The curves are transformed
 // to camera space in software because double precision is absolutely
 // required. The cubics are adaptively subdivided based on distance from
-// the camera position.
+// the camera position. Samples far enough from the camera to be joined by
+// straight lines can instead be drawn from a static buffer, with positions
+// split into two floats.
 //
 // curveplot is free software; you can redistribute it and/or
 // modify it under the terms of the GNU Lesser General Public
@@ -29,11 +31,16 @@
 
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <deque>
+#include <vector>
 
 #include <Eigen/Core>
 #include <Eigen/Geometry>
 
+#include <celrender/gl/buffer.h>
+#include <celrender/gl/vertexobject.h>
 #include <celutil/color.h>
 
 class Color;
@@ -92,8 +99,16 @@ class CurvePlot
                      double fadeStartTime,
                      double fadeEndTime) const;
 
-    unsigned int lastUsed() const { return m_lastUsed; }
-    void setLastUsed(unsigned int lastUsed) { m_lastUsed = lastUsed; }
+    void renderBuffered(const Eigen::Affine3d& modelview,
+                        double nearZ,
+                        double farZ,
+                        const Eigen::Vector3d viewFrustumPlaneNormals[],
+                        double subdivisionThreshold,
+                        double startTime,
+                        double endTime,
+                        const Eigen::Vector4f& color,
+                        double fadeStartTime = 0.0,
+                        double fadeEndTime = 0.0);
 
     void addSample(const CurvePlotSample& sample);
     void removeSamplesBefore(double t);
@@ -102,13 +117,42 @@ class CurvePlot
     bool empty() const { return m_samples.empty(); }
 
     unsigned int sampleCount() const { return static_cast<unsigned int>(m_samples.size()); }
+    // Size of the samples uploaded by renderBuffered and of their bounds
+    std::size_t bufferBytes() const;
 
     static void deinit();
 
  private:
+    // Bounds of a run of samples in the buffer
+    struct BufferChunk
+    {
+        Eigen::Vector3d center;
+        double radius;
+        double maxSegmentRadius;
+    };
+
+    void updateBuffer();
+    void renderRange(const Eigen::Affine3d& modelview,
+                     double nearZ,
+                     double farZ,
+                     const Eigen::Vector3d viewFrustumPlaneNormals[],
+                     double subdivisionThreshold,
+                     double startTime,
+                     double endTime,
+                     const Eigen::Vector4f& color,
+                     double fadeStartTime,
+                     double fadeEndTime) const;
+
     std::deque<CurvePlotSample>     m_samples;
     const Renderer                 &m_renderer;
     double                          m_duration      { 0.0 };
-    unsigned int                    m_lastUsed      { 0   };
+
+    // The samples on the GPU, rebuilt when the revision changes
+    celestia::gl::Buffer            m_bo            { celestia::util::NoCreateT{} };
+    celestia::gl::VertexObject      m_vo            { celestia::util::NoCreateT{} };
+    std::vector<BufferChunk>        m_chunks;
+    double                          m_bufferStartTime { 0.0 };
+    std::uint32_t                   m_revision      { 1 };
+    std::uint32_t                   m_bufferRevision { 0 };
 };
 
@@ -0,0 +1,248 @@
+// dsobinary.cpp
+//
+// Copyright (C) 2025, Celestia Development Team
+//
+// Binary deep sky catalogs, which are loaded without parsing.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include "dsobinary.h"
+
+#include <cstddef>
+#include <limits>
+#include <ostream>
+#include <sstream>
+#include <utility>
+
+#include <celutil/binaryread.h>
+#include <celutil/binarywrite.h>
+#include <celutil/hash.h>
+
+using namespace std::string_view_literals;
+
+namespace celestia::engine
+{
+
+namespace
+{
+
+// The catalog is little-endian. It starts with the magic string, the
+// version, a reserved word, the record count and the size of the string
+// table, followed by the fixed size records and the string table. Strings
+// are referenced by offset and length; the categories of an object are
+// held in one string, separated by NUL characters.
+constexpr std::string_view DSOCatalogMagic = "CELDSCAT"sv;
+constexpr std::uint16_t DSOCatalogVersion = 0x0100;
+constexpr std::size_t HeaderSize = 8 + 2 + 2 + 4 + 4;
+
+constexpr std::size_t StringRefCount = 5;
+constexpr std::size_t RecordSize = 1 + 1 + 2   // type, flags, reserved
+                                 + 3 * 8       // position
+                                 + 4 * 4       // orientation
+                                 + 5 * 4       // radius, absMag, detail, coreRadius, kingConcentration
+                                 + StringRefCount * 2 * 4;
+
+constexpr std::uint8_t VisibleFlag = 1;
+constexpr std::uint8_t ClickableFlag = 2;
+
+constexpr char CategorySeparator = '\0';
+
+class RecordReader
+{
+public:
+    RecordReader(const char* data, std::string_view strings) : m_data(data), m_strings(strings) {}
+
+    template<typename T>
+    T read()
+    {
+        T value = util::fromMemoryLE<T>(m_data);
+        m_data += sizeof(T);
+        return value;
+    }
+
+    bool readString(std::string& value)
+    {
+        auto offset = read<std::uint32_t>();
+        auto length = read<std::uint32_t>();
+        if (offset > m_strings.size() || length > m_strings.size() - offset)
+            return false;
+
+        value.assign(m_strings.substr(offset, length));
+        return true;
+    }
+
+private:
+    const char* m_data;
+    std::string_view m_strings;
+};
+
+bool
+writeString(std::ostream& out, std::string& strings, std::string_view value)
+{
+    if (value.size() > std::numeric_limits<std::uint32_t>::max() ||
+        strings.size() > std::numeric_limits<std::uint32_t>::max() - value.size())
+    {
+        return false;
+    }
+
+    util::writeLE<std::uint32_t>(out, static_cast<std::uint32_t>(strings.size()));
+    util::writeLE<std::uint32_t>(out, static_cast<std::uint32_t>(value.size()));
+    strings.append(value);
+    return true;
+}
+
+} // end unnamed namespace
+
+bool
+IsDSOBinaryCatalog(std::string_view contents)
+{
+    return contents.size() >= HeaderSize && contents.substr(0, DSOCatalogMagic.size()) == DSOCatalogMagic;
+}
+
+bool
+ReadDSOBinaryCatalog(std::string_view contents, std::vector<DSOBinaryRecord>& records)
+{
+    if (!IsDSOBinaryCatalog(contents))
+        return false;
+
+    const char* data = contents.data();
+    if (util::fromMemoryLE<std::uint16_t>(data + 8) != DSOCatalogVersion)
+        return false;
+
+    auto recordCount = static_cast<std::size_t>(util::fromMemoryLE<std::uint32_t>(data + 12));
+    auto stringsSize = static_cast<std::size_t>(util::fromMemoryLE<std::uint32_t>(data + 16));
+    if (contents.size() != HeaderSize + recordCount * RecordSize + stringsSize)
+        return false;
+
+    std::string_view strings = contents.substr(HeaderSize + recordCount * RecordSize);
+
+    std::vector<DSOBinaryRecord> result(recordCount);
+    for (std::size_t i = 0; i < recordCount; ++i)
+    {
+        DSOBinaryRecord& record = result[i];
+        RecordReader reader(data + HeaderSize + i * RecordSize, strings);
+
+        auto type = reader.read<std::uint8_t>();
+        if (type > static_cast<std::uint8_t>(DeepSkyObjectType::OpenCluster))
+            return false;
+        record.type = static_cast<DeepSkyObjectType>(type);
+
+        auto flags = reader.read<std::uint8_t>();
+        record.visible = (flags & VisibleFlag) != 0;
+        record.clickable = (flags & ClickableFlag) != 0;
+        reader.read<std::uint16_t>();
+
+        for (int j = 0; j < 3; ++j)
+            record.position[j] = reader.read<double>();
+
+        record.orientation.w() = reader.read<float>();
+        record.orientation.x() = reader.read<float>();
+        record.orientation.y() = reader.read<float>();
+        record.orientation.z() = reader.read<float>();
+
+        record.radius = reader.read<float>();
+        record.absMag = reader.read<float>();
+        record.detail = reader.read<float>();
+        record.coreRadius = reader.read<float>();
+        record.kingConcentration = reader.read<float>();
+
+        std::string categories;
+        if (!reader.readString(record.names) ||
+            !reader.readString(record.infoURL) ||
+            !reader.readString(record.typeName) ||
+            !reader.readString(record.form) ||
+            !reader.readString(categories))
+        {
+            return false;
+        }
+
+        for (std::string_view rest = categories; !rest.empty();)
+        {
+            auto pos = rest.find(CategorySeparator);
+            record.categories.emplace_back(rest.substr(0, pos));
+            if (pos == std::string_view::npos)
+                break;
+            rest = rest.substr(pos + 1);
+        }
+    }
+
+    records = std::move(result);
+    return true;
+}
+
+bool
+WriteDSOBinaryCatalog(std::ostream& out, util::array_view<DSOBinaryRecord> records)
+{
+    if (records.size() > std::numeric_limits<std::uint32_t>::max() / RecordSize)
+        return false;
+
+    out.write(DSOCatalogMagic.data(), DSOCatalogMagic.size());
+    util::writeLE<std::uint16_t>(out, DSOCatalogVersion);
+    util::writeLE<std::uint16_t>(out, 0);
+    util::writeLE<std::uint32_t>(out, static_cast<std::uint32_t>(records.size()));
+
+    // The size of the string table is only known once the records are
+    // written, so the records are written to a buffer first
+    std::string strings;
+    std::ostringstream recordStream;
+    for (const DSOBinaryRecord& record : records)
+    {
+        util::writeLE<std::uint8_t>(recordStream, static_cast<std::uint8_t>(record.type));
+        util::writeLE<std::uint8_t>(recordStream, static_cast<std::uint8_t>((record.visible ? VisibleFlag : 0) |
+                                                                             (record.clickable ? ClickableFlag : 0)));
+        util::writeLE<std::uint16_t>(recordStream, 0);
+
+        for (int j = 0; j < 3; ++j)
+            util::writeLE<double>(recordStream, record.position[j]);
+
+        util::writeLE<float>(recordStream, record.orientation.w());
+        util::writeLE<float>(recordStream, record.orientation.x());
+        util::writeLE<float>(recordStream, record.orientation.y());
+        util::writeLE<float>(recordStream, record.orientation.z());
+
+        util::writeLE<float>(recordStream, record.radius);
+        util::writeLE<float>(recordStream, record.absMag);
+        util::writeLE<float>(recordStream, record.detail);
+        util::writeLE<float>(recordStream, record.coreRadius);
+        util::writeLE<float>(recordStream, record.kingConcentration);
+
+        std::string categories;
+        for (const auto& category : record.categories)
+        {
+            if (!categories.empty())
+                categories.push_back(CategorySeparator);
+            categories.append(category);
+        }
+
+        if (!writeString(recordStream, strings, record.names) ||
+            !writeString(recordStream, strings, record.infoURL) ||
+            !writeString(recordStream, strings, record.typeName) ||
+            !writeString(recordStream, strings, record.form) ||
+            !writeString(recordStream, strings, categories))
+        {
+            return false;
+        }
+    }
+
+    util::writeLE<std::uint32_t>(out, static_cast<std::uint32_t>(strings.size()));
+    std::string recordData = recordStream.str();
+    out.write(recordData.data(), static_cast<std::streamsize>(recordData.size()));
+    out.write(strings.data(), static_cast<std::streamsize>(strings.size()));
+    return out.good();
+}
+
+std::uint64_t
+ComputeDSOCatalogKey(std::string_view contents, const fs::path& resourcePath)
+{
+    util::FNV1aHash hash;
+    hash.addValue(DSOCatalogVersion);
+    hash.addBytes(resourcePath.u8string());
+    hash.addBytes("\n"sv);
+    hash.addBytes(contents);
+    return hash.value();
+}
+
+} // end namespace celestia::engine
@@ -0,0 +1,73 @@
+// dsobinary.h
+//
+// Copyright (C) 2025, Celestia Development Team
+//
+// Binary deep sky catalogs, which are loaded without parsing.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+
+#include <celcompat/filesystem.h>
+#include <celutil/array_view.h>
+#include "deepskyobj.h"
+
+namespace celestia::engine
+{
+
+// The definition of a deep sky object as read from a .dsc file. Values are
+// held as the objects store them, while the references to files, such as
+// custom galaxy templates and nebula meshes, and the info URL are kept as
+// written, to be resolved against the resource path of the catalog when
+// the object is created.
+struct DSOBinaryRecord
+{
+    DeepSkyObjectType type{ DeepSkyObjectType::Galaxy };
+    // Names separated by ':' as in the .dsc file
+    std::string names;
+    Eigen::Vector3d position{ Eigen::Vector3d::Zero() };
+    Eigen::Quaternionf orientation{ Eigen::Quaternionf::Identity() };
+    float radius{ 1.0f };
+    float absMag{ DSO_DEFAULT_ABS_MAGNITUDE };
+    bool visible{ true };
+    bool clickable{ true };
+    std::string infoURL;
+    std::vector<std::string> categories;
+
+    // Galaxies and globulars
+    float detail{ 1.0f };
+    // Hubble type of galaxies
+    std::string typeName;
+    // Custom template of galaxies, or mesh of nebulae
+    std::string form;
+    // Globulars, core radius in arcminutes
+    float coreRadius{ 0.0f };
+    float kingConcentration{ 0.0f };
+};
+
+// Returns true if the contents start like a binary catalog
+bool IsDSOBinaryCatalog(std::string_view contents);
+
+// Decode the records of a binary catalog; returns false and leaves the
+// records untouched if the catalog is malformed
+bool ReadDSOBinaryCatalog(std::string_view contents, std::vector<DSOBinaryRecord>& records);
+
+bool WriteDSOBinaryCatalog(std::ostream& out, util::array_view<DSOBinaryRecord> records);
+
+// Key of the compiled copy of a text catalog, which changes along with its
+// contents, its resource path or the version of the format
+std::uint64_t ComputeDSOCatalogKey(std::string_view contents, const fs::path& resourcePath);
+
+} // end namespace celestia::engine
@@ -12,12 +12,9 @@
 
 #include "dsodb.h"
 
-#include <algorithm>
-#include <array>
 #include <utility>
 
 #include <celutil/gettext.h>
-#include "name.h"
 
 namespace engine = celestia::engine;
 
@@ -25,31 +22,12 @@ DSODatabase::~DSODatabase() = default;
 
 DSODatabase::DSODatabase(std::unique_ptr<engine::DSOOctree>&& octreeRoot,
                          std::unique_ptr<NameDatabase>&& namesDB,
-                         std::vector<std::uint32_t>&& catalogNumberIndex,
                          float avgAbsMag) :
-    m_octreeRoot(std::move(octreeRoot)),
-    m_namesDB(std::move(namesDB)),
-    m_catalogNumberIndex(std::move(catalogNumberIndex)),
     m_avgAbsMag(avgAbsMag)
 {
-}
-
-DeepSkyObject*
-DSODatabase::find(const AstroCatalog::IndexNumber catalogNumber) const
-{
-    auto it = std::lower_bound(m_catalogNumberIndex.begin(),
-                               m_catalogNumberIndex.end(),
-                               catalogNumber,
-                               [this](std::uint32_t idx, AstroCatalog::IndexNumber catNum)
-                               {
-                                   return (*m_octreeRoot)[idx]->getIndex() < catNum;
-                               });
-
-    if (it == m_catalogNumberIndex.end())
-        return nullptr;
-
-    DeepSkyObject* dso = (*m_octreeRoot)[*it].get();
-    return dso->getIndex() == catalogNumber ? dso : nullptr;
+    m_octreeRoot = std::move(octreeRoot);
+    m_namesDB = std::move(namesDB);
+    buildCatalogNumberIndex();
 }
 
 DeepSkyObject*
@@ -64,45 +42,10 @@ DSODatabase::find(std::string_view name, bool i18n) const
         : find(catalogNumber);
 }
 
-void
-DSODatabase::getCompletion(std::vector<celestia::engine::Completion>& completion, std::string_view name) const
-{
-    // only named DSOs are supported by completion.
-    if (!name.empty())
-    {
-        std::vector<std::pair<std::string, AstroCatalog::IndexNumber>> namesWithIndices;
-        m_namesDB->getCompletion(namesWithIndices, name);
-
-        for (const auto& [dsoName, index] : namesWithIndices)
-        {
-            auto capturedIndex = index;
-            completion.emplace_back(dsoName, [this, capturedIndex]
-            {
-                return Selection(find(capturedIndex));
-            });
-        }
-    }
-}
-
 std::string
-DSODatabase::getDSOName(const DeepSkyObject* dso, [[maybe_unused]] bool i18n) const
+DSODatabase::getDSOName(const DeepSkyObject* dso, bool i18n) const
 {
-    AstroCatalog::IndexNumber catalogNumber = dso->getIndex();
-
-    auto iter = m_namesDB->getFirstNameIter(catalogNumber);
-    if (iter == m_namesDB->getFinalNameIter())
-        return {};
-
-#ifdef ENABLE_NLS
-    if (i18n)
-    {
-        const char* local = D_(iter->second.c_str());
-        if (iter->second != local)
-            return local;
-    }
-#endif
-
-    return iter->second;
+    return getFirstName(dso->getIndex(), i18n);
 }
 
 std::string
@@ -135,28 +78,7 @@ DSODatabase::findVisibleDSOs(engine::DSOHandler& dsoHandler,
                              float aspectRatio,
                              float limitingMag) const
 {
-    // Compute the bounding planes of an infinite view frustum
-    std::array<Eigen::Hyperplane<double, 3>, 5> frustumPlanes;
-
-    Eigen::Quaterniond obsOrientd = obsOrient.cast<double>();
-    Eigen::Matrix3d rot = obsOrientd.toRotationMatrix().transpose();
-    double h = std::tan(fovY / 2);
-    double w = h * aspectRatio;
-
-    std::array<Eigen::Vector3d, 5> planeNormals
-    {
-        Eigen::Vector3d( 0,  1, -h),
-        Eigen::Vector3d( 0, -1, -h),
-        Eigen::Vector3d( 1,  0, -w),
-        Eigen::Vector3d(-1,  0, -w),
-        Eigen::Vector3d( 0,  0, -1),
-    };
-
-    for (int i = 0; i < 5; ++i)
-    {
-        planeNormals[i]  = rot * planeNormals[i].normalized();
-        frustumPlanes[i] = Eigen::Hyperplane<double, 3>(planeNormals[i], obsPos);
-    }
+    FrustumPlanes frustumPlanes = computeFrustumPlanes(obsPos, obsOrient, fovY, aspectRatio);
 
     engine::DSOOctreeVisibleObjectsProcessor processor(&dsoHandler,
                                                        obsPos,
@@ -12,6 +12,8 @@
 
 #pragma once
 
+#include <array>
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <string>
@@ -21,37 +23,33 @@
 #include <Eigen/Core>
 #include <Eigen/Geometry>
 
-#include <celengine/completion.h>
 #include <celengine/dsooctree.h>
+#include <celengine/name.h>
+#include <celengine/spatialcatalog.h>
+#include <celutil/threadpool.h>
 
 class DeepSkyObject;
 class DSODatabaseBuilder;
-class NameDatabase;
 
 constexpr inline unsigned int MAX_DSO_NAMES = 10;
 
 // 100 Gly - on the order of the current size of the universe
 constexpr inline float DSO_OCTREE_ROOT_SIZE = 1.0e11f;
 
-//NOTE: this one and starDatabase should be derived from a common base class since they share lots of code and functionality.
-class DSODatabase
+class DSODatabase : public celestia::engine::SpatialCatalog<std::unique_ptr<DeepSkyObject>, double, NameDatabase>
 {
 public:
     DSODatabase(std::unique_ptr<celestia::engine::DSOOctree>&&,
                 std::unique_ptr<NameDatabase>&&,
-                std::vector<std::uint32_t>&&,
                 float);
 
     ~DSODatabase();
 
     DeepSkyObject* getDSO(const std::uint32_t) const;
-    std::uint32_t size() const;
 
     DeepSkyObject* find(const AstroCatalog::IndexNumber catalogNumber) const;
     DeepSkyObject* find(std::string_view, bool i18n) const;
 
-    void getCompletion(std::vector<celestia::engine::Completion>&, std::string_view) const;
-
     void findVisibleDSOs(celestia::engine::DSOHandler& dsoHandler,
                          const Eigen::Vector3d& obsPosition,
                          const Eigen::Quaternionf& obsOrientation,
@@ -59,6 +57,21 @@ public:
                          float aspectRatio,
                          float limitingMag) const;
 
+    // Find the visible DSOs like findVisibleDSOs, with the octree split into
+    // ranges processed concurrently on the thread pool, each one by its own
+    // copy of the prototype handler. The copies are left in handlers in
+    // traversal order, so that passing on their results one after another
+    // visits the objects in the same order as findVisibleDSOs.
+    template<typename HANDLER>
+    void findVisibleDSOs(std::vector<HANDLER>& handlers,
+                         const HANDLER& prototype,
+                         const Eigen::Vector3d& obsPosition,
+                         const Eigen::Quaternionf& obsOrientation,
+                         float fovY,
+                         float aspectRatio,
+                         float limitingMag,
+                         celestia::util::ThreadPool* threadPool) const;
+
     void findCloseDSOs(celestia::engine::DSOHandler& dsoHandler,
                        const Eigen::Vector3d& obsPosition,
                        float radius) const;
@@ -69,10 +82,6 @@ public:
     float getAverageAbsoluteMagnitude() const;
 
 private:
-    std::unique_ptr<celestia::engine::DSOOctree> m_octreeRoot;
-    std::unique_ptr<NameDatabase> m_namesDB;
-    std::vector<std::uint32_t> m_catalogNumberIndex;
-
     float m_avgAbsMag{ 0.0f };
 
     friend class DSODatabaseBuilder;
@@ -81,13 +90,13 @@ private:
 inline DeepSkyObject*
 DSODatabase::getDSO(const std::uint32_t n) const
 {
-    return (*m_octreeRoot)[n].get();
+    return getObject(n);
 }
 
-inline std::uint32_t
-DSODatabase::size() const
+inline DeepSkyObject*
+DSODatabase::find(const AstroCatalog::IndexNumber catalogNumber) const
 {
-    return m_octreeRoot->size();
+    return findByCatalogNumber(catalogNumber);
 }
 
 inline float
@@ -95,3 +104,39 @@ DSODatabase::getAverageAbsoluteMagnitude() const
 {
     return m_avgAbsMag;
 }
+
+template<typename HANDLER>
+void
+DSODatabase::findVisibleDSOs(std::vector<HANDLER>& handlers,
+                             const HANDLER& prototype,
+                             const Eigen::Vector3d& obsPos,
+                             const Eigen::Quaternionf& obsOrient,
+                             float fovY,
+                             float aspectRatio,
+                             float limitingMag,
+                             celestia::util::ThreadPool* threadPool) const
+{
+    namespace engine = celestia::engine;
+
+    FrustumPlanes frustumPlanes = computeFrustumPlanes(obsPos, obsOrient, fovY, aspectRatio);
+    handlers.clear();
+
+    // Splitting only tests the nodes, no object is passed to the handler
+    std::vector<engine::OctreeNodeRange> ranges;
+    HANDLER splitHandler(prototype);
+    engine::DSOOctreeVisibleObjectsProcessor splitProcessor(&splitHandler, obsPos, frustumPlanes, limitingMag);
+    if (!splitTraversal(splitProcessor, threadPool, ranges))
+    {
+        HANDLER& handler = handlers.emplace_back(prototype);
+        engine::DSOOctreeVisibleObjectsProcessor processor(&handler, obsPos, frustumPlanes, limitingMag);
+        m_octreeRoot->processDepthFirst(processor);
+        return;
+    }
+
+    handlers.resize(ranges.size(), prototype);
+    threadPool->parallelFor(ranges.size(), [&](std::size_t i)
+    {
+        engine::DSOOctreeVisibleObjectsProcessor processor(&handlers[i], obsPos, frustumPlanes, limitingMag);
+        m_octreeRoot->processDepthFirst(processor, ranges[i]);
+    });
+}
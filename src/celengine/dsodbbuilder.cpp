@@ -13,19 +13,33 @@
 #include "dsodbbuilder.h"
 
 #include <algorithm>
+#include <cstddef>
 #include <cstdint>
-#include <numeric>
+#include <fstream>
+#include <memory>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
 
 #include <Eigen/Core>
 
+#include <fmt/format.h>
+
 #include <celastro/astro.h>
 #include <celcompat/numbers.h>
 #include <celutil/associativearray.h>
+#include <celutil/atomicfile.h>
+#include <celutil/fsutils.h>
+#include <celutil/infourl.h>
 #include <celutil/logger.h>
 #include <celutil/gettext.h>
+#include <celutil/mappedfile.h>
 #include <celutil/parser.h>
 #include <celutil/stringutils.h>
+#include <celutil/threadpool.h>
 #include <celutil/tokenizer.h>
 #include "category.h"
 #include "deepskyobj.h"
@@ -36,6 +50,7 @@
 #include "nebula.h"
 #include "octree.h"
 #include "octreebuilder.h"
+#include "octreecache.h"
 #include "opencluster.h"
 
 namespace astro = celestia::astro;
@@ -44,11 +59,26 @@ namespace util = celestia::util;
 
 using celestia::util::GetLogger;
 
+struct DSODatabaseBuilder::DscRecord
+{
+    std::string objName;
+    util::Value params;
+    std::unique_ptr<DeepSkyObject> obj;
+    bool loaded{ false };
+};
+
 namespace
 {
 
 constexpr engine::OctreeObjectIndex DSOOctreeSplitThreshold = 10;
 
+// Number of .dsc definitions which are read before their objects are
+// created. Batches of at least DscParallelThreshold definitions are loaded
+// in parallel, in chunks of DscChunkSize definitions.
+constexpr std::size_t DscBatchSize = 4096;
+constexpr std::size_t DscParallelThreshold = 512;
+constexpr std::size_t DscChunkSize = 128;
+
 // The octree node into which a dso is placed is dependent on two properties:
 // its obsPosition and its luminosity--the fainter the dso, the deeper the node
 // in which it will reside.  Each node stores an absolute magnitude; no child
@@ -106,6 +136,148 @@ createDSO(std::string_view objType)
     return nullptr;
 }
 
+// The definition of a loaded object for a binary catalog, from the object
+// and the parameters which refer to other files
+engine::DSOBinaryRecord
+compileRecord(const DSODatabaseBuilder::DscRecord& record)
+{
+    const DeepSkyObject& obj = *record.obj;
+    const auto* params = record.params.getHash();
+
+    engine::DSOBinaryRecord compiled;
+    compiled.type = obj.getObjType();
+    compiled.names = record.objName;
+    compiled.position = obj.getPosition();
+    compiled.orientation = obj.getOrientation();
+    compiled.radius = obj.getRadius();
+    compiled.absMag = obj.getAbsoluteMagnitude();
+    compiled.visible = obj.isVisible();
+    compiled.clickable = obj.isClickable();
+    if (const std::string* infoURL = params->getString("InfoURL"); infoURL != nullptr)
+        compiled.infoURL = *infoURL;
+
+    // As read by UserCategory::loadCategories
+    if (const auto* category = params->getValue("Category"); category != nullptr)
+    {
+        if (const std::string* name = category->getString(); name != nullptr && !name->empty())
+            compiled.categories.push_back(*name);
+        if (const auto* names = category->getArray(); names != nullptr)
+        {
+            for (const auto& value : *names)
+            {
+                if (const std::string* name = value.getString(); name != nullptr && !name->empty())
+                    compiled.categories.push_back(*name);
+            }
+        }
+    }
+
+    switch (compiled.type)
+    {
+    case DeepSkyObjectType::Galaxy:
+        {
+            const auto& galaxy = static_cast<const Galaxy&>(obj);
+            compiled.detail = galaxy.getDetail();
+            compiled.typeName = galaxy.getType();
+            if (const std::string* customTemplate = params->getString("CustomTemplate"); customTemplate != nullptr)
+                compiled.form = *customTemplate;
+        }
+        break;
+    case DeepSkyObjectType::Globular:
+        {
+            const auto& globular = static_cast<const Globular&>(obj);
+            compiled.detail = globular.getDetail();
+            compiled.coreRadius = globular.getCoreRadius();
+            compiled.kingConcentration = globular.getKingConcentration();
+        }
+        break;
+    case DeepSkyObjectType::Nebula:
+        if (const std::string* mesh = params->getString("Mesh"); mesh != nullptr)
+            compiled.form = *mesh;
+        break;
+    default:
+        break;
+    }
+
+    return compiled;
+}
+
+// Create an object from its definition in a binary catalog, as load does
+// from the .dsc parameters
+std::unique_ptr<DeepSkyObject>
+createDSO(const engine::DSOBinaryRecord& record, const fs::path& resourcePath)
+{
+    std::unique_ptr<DeepSkyObject> obj;
+    switch (record.type)
+    {
+    case DeepSkyObjectType::Galaxy:
+        {
+            auto galaxy = std::make_unique<Galaxy>();
+            galaxy->setDetail(record.detail);
+            galaxy->setType(record.typeName);
+            if (record.form.empty())
+                galaxy->setForm({});
+            else
+                galaxy->setForm(util::PathExp(fs::u8path(record.form)), resourcePath);
+            obj = std::move(galaxy);
+        }
+        break;
+    case DeepSkyObjectType::Globular:
+        {
+            auto globular = std::make_unique<Globular>();
+            globular->setDetail(record.detail);
+            obj = std::move(globular);
+        }
+        break;
+    case DeepSkyObjectType::Nebula:
+        {
+            auto nebula = std::make_unique<Nebula>();
+            if (!record.form.empty() && !nebula->setMesh(record.form, resourcePath))
+                return nullptr;
+            obj = std::move(nebula);
+        }
+        break;
+    case DeepSkyObjectType::OpenCluster:
+        obj = std::make_unique<OpenCluster>();
+        break;
+    }
+
+    if (obj == nullptr)
+        return nullptr;
+
+    obj->setPosition(record.position);
+    obj->setOrientation(record.orientation);
+    obj->setRadius(record.radius);
+    obj->setAbsoluteMagnitude(record.absMag);
+    obj->setVisible(record.visible);
+    obj->setClickable(record.clickable);
+
+    if (!record.infoURL.empty())
+    {
+        if (std::string infoURL = util::BuildInfoURL(record.infoURL, resourcePath); !infoURL.empty())
+            obj->setInfoURL(std::move(infoURL));
+        else
+            GetLogger()->error(_("Invalid InfoURL used in {} definition.\n"), record.names);
+    }
+
+    // The tidal radius depends on the position
+    if (record.type == DeepSkyObjectType::Globular)
+        static_cast<Globular*>(obj.get())->setStructure(record.coreRadius, record.kingConcentration);
+
+    return obj;
+}
+
+bool
+writeCatalogCache(const fs::path& path, util::array_view<engine::DSOBinaryRecord> records)
+{
+    std::error_code ec;
+    fs::create_directories(path.parent_path(), ec);
+
+    util::AtomicFile file(path);
+    return file.isOpen() &&
+           engine::WriteDSOBinaryCatalog(file.stream(), records) &&
+           file.commit();
+}
+
 float
 calcAvgAbsMag(const engine::DSOOctree& DSOs)
 {
@@ -126,6 +298,62 @@ calcAvgAbsMag(const engine::DSOOctree& DSOs)
     return avgAbsMag / static_cast<float>(nDSOeff);
 }
 
+// Custom galaxy templates and nebula meshes are loaded through the shared
+// resource managers, so those objects are loaded on the calling thread.
+bool
+isThreadSafeLoad(const DSODatabaseBuilder::DscRecord& record)
+{
+    const auto* params = record.params.getHash();
+    switch (record.obj->getObjType())
+    {
+    case DeepSkyObjectType::Galaxy:
+        return params->getValue("CustomTemplate") == nullptr;
+    case DeepSkyObjectType::Nebula:
+        return params->getValue("Mesh") == nullptr;
+    default:
+        return true;
+    }
+}
+
+void
+loadRecord(DSODatabaseBuilder::DscRecord& record, const fs::path& resourcePath)
+{
+    record.loaded = record.obj->load(record.params.getHash(), resourcePath, record.objName);
+}
+
+void
+loadRecords(std::vector<DSODatabaseBuilder::DscRecord>& records, const fs::path& resourcePath)
+{
+    std::size_t nRecords = records.size();
+    if (nRecords < DscParallelThreshold)
+    {
+        for (auto& record : records)
+        {
+            if (record.obj != nullptr)
+                loadRecord(record, resourcePath);
+        }
+        return;
+    }
+
+    std::size_t nChunks = (nRecords + DscChunkSize - 1) / DscChunkSize;
+    util::GetThreadPool()->parallelFor(nChunks, [&](std::size_t chunkIdx)
+    {
+        std::size_t first = chunkIdx * DscChunkSize;
+        std::size_t last = std::min(first + DscChunkSize, nRecords);
+        for (std::size_t i = first; i < last; ++i)
+        {
+            if (records[i].obj != nullptr && isThreadSafeLoad(records[i]))
+                loadRecord(records[i], resourcePath);
+        }
+    });
+
+    for (auto& record : records)
+    {
+        if (record.obj != nullptr && !isThreadSafeLoad(record))
+            loadRecord(record, resourcePath);
+    }
+}
+
 void
 addName(NameDatabase* namesDB, AstroCatalog::IndexNumber objCatalogNumber, std::string_view objName)
 {
@@ -151,24 +379,48 @@ addName(NameDatabase* namesDB, AstroCatalog::IndexNumber objCatalogNumber, std::
 }
 
 std::unique_ptr<engine::DSOOctree>
-buildOctree(std::vector<std::unique_ptr<DeepSkyObject>>&& DSOs)
+buildOctree(std::vector<std::unique_ptr<DeepSkyObject>>&& DSOs, const fs::path& cachePath)
 {
     GetLogger()->debug("Sorting DSOs into octree . . .\n");
     float absMag = astro::appToAbsMag(DSO_OCTREE_MAGNITUDE, DSO_OCTREE_ROOT_SIZE * celestia::numbers::sqrt3_v<float>);
 
     auto dsoCount = static_cast<engine::OctreeObjectIndex>(DSOs.size());
 
+    std::optional<engine::OctreeCache<DSOOctreeTraits>> cache;
+    std::unique_ptr<util::FileLock> cacheLock;
+    if (!cachePath.empty())
+    {
+        auto key = engine::OctreeCache<DSOOctreeTraits>::computeKey(DSOs,
+                                                                    Eigen::Vector3d::Zero(),
+                                                                    DSO_OCTREE_ROOT_SIZE,
+                                                                    absMag,
+                                                                    DSOOctreeSplitThreshold);
+        cache.emplace(cachePath, key);
+        // Wait for another process building the same octree, then map it
+        cacheLock = cache->lock();
+        if (auto cachedOctree = cache->load(DSOs); cachedOctree != nullptr)
+        {
+            GetLogger()->debug("Loaded DSO octree from cache {}\n", cachePath);
+            return cachedOctree;
+        }
+    }
+
     auto root = engine::makeDynamicOctree<DSOOctreeTraits>(std::move(DSOs),
                                                            Eigen::Vector3d::Zero(),
                                                            DSO_OCTREE_ROOT_SIZE,
                                                            absMag,
-                                                           DSOOctreeSplitThreshold);
+                                                           DSOOctreeSplitThreshold,
+                                                           *util::GetThreadPool());
 
     GetLogger()->debug("Spatially sorting DSOs for improved locality of reference . . .\n");
 
     // The spatial sorting part is useless for DSOs since we
     // are storing pointers to objects and not the objects themselves:
-    auto octreeRoot = root->build();
+    std::vector<engine::OctreeObjectIndex> objectOrder;
+    auto octreeRoot = root->build(cache.has_value() ? &objectOrder : nullptr);
+
+    if (cache.has_value() && !cache->save(*octreeRoot, objectOrder))
+        GetLogger()->warn("Failed to write DSO octree cache {}\n", cachePath);
 
     GetLogger()->debug("{} DSOs total.\nOctree has {} nodes and {} DSOs.\n",
                        dsoCount,
@@ -178,32 +430,113 @@ buildOctree(std::vector<std::unique_ptr<DeepSkyObject>>&& DSOs)
     return octreeRoot;
 }
 
-std::vector<std::uint32_t>
-buildCatalogNumberIndex(const engine::DSOOctree& DSOs)
+} // end unnamed namespace
+
+DSODatabaseBuilder::~DSODatabaseBuilder() = default;
+
+bool
+DSODatabaseBuilder::load(std::istream& in, const fs::path& resourcePath)
 {
-    GetLogger()->debug("Building catalog number indexes . . .\n");
+    util::Tokenizer tokenizer(&in);
+    return parseCatalog(tokenizer, resourcePath);
+}
 
-    std::vector<std::uint32_t> catalogNumberIndex(DSOs.size(), UINT32_C(0));
-    std::iota(catalogNumberIndex.begin(), catalogNumberIndex.end(), UINT32_C(0));
+bool
+DSODatabaseBuilder::load(std::string_view contents, const fs::path& resourcePath)
+{
+    if (engine::IsDSOBinaryCatalog(contents))
+    {
+        std::vector<engine::DSOBinaryRecord> records;
+        if (!engine::ReadDSOBinaryCatalog(contents, records))
+        {
+            GetLogger()->error("Error reading binary deep sky catalog.\n");
+            return false;
+        }
+        return addBinaryRecords(records, resourcePath);
+    }
 
-    std::sort(catalogNumberIndex.begin(),
-              catalogNumberIndex.end(),
-              [&DSOs](std::uint32_t idx0, std::uint32_t idx1)
-              {
-                  return DSOs[idx0]->getIndex() < DSOs[idx1]->getIndex();
-              });
+    if (!catalogCacheDirectory.empty())
+        return loadCached(contents, resourcePath);
 
-    return catalogNumberIndex;
+    util::Tokenizer tokenizer(contents);
+    return parseCatalog(tokenizer, resourcePath);
 }
 
-} // end unnamed namespace
+bool
+DSODatabaseBuilder::loadCached(std::string_view contents, const fs::path& resourcePath)
+{
+    fs::path cachePath = catalogCacheDirectory / fmt::format("{:016x}.dsb", engine::ComputeDSOCatalogKey(contents, resourcePath));
+    if (auto cached = util::MappedFile::open(cachePath); cached != nullptr)
+    {
+        std::vector<engine::DSOBinaryRecord> records;
+        if (engine::ReadDSOBinaryCatalog(std::string_view(cached->data(), cached->size()), records))
+            return addBinaryRecords(records, resourcePath);
+    }
 
-DSODatabaseBuilder::~DSODatabaseBuilder() = default;
+    // Collect the definitions of this catalog for the cache
+    const bool keep = keepDefinitions;
+    const std::size_t first = definitions.size();
+    keepDefinitions = true;
+
+    util::Tokenizer tokenizer(contents);
+    bool result = parseCatalog(tokenizer, resourcePath);
+    keepDefinitions = keep;
+
+    // A catalog with errors is parsed again next time, to report them
+    if (result && !writeCatalogCache(cachePath, util::array_view<engine::DSOBinaryRecord>(definitions.data() + first, definitions.size() - first)))
+        GetLogger()->warn("Failed to write deep sky catalog cache {}\n", cachePath);
+
+    if (!keep)
+        definitions.resize(first);
+
+    return result;
+}
 
 bool
-DSODatabaseBuilder::load(std::istream& in, const fs::path& resourcePath)
+DSODatabaseBuilder::addBinaryRecords(const std::vector<engine::DSOBinaryRecord>& records, const fs::path& resourcePath)
+{
+#ifdef ENABLE_NLS
+    std::string s = resourcePath.string();
+    const char *d = s.c_str();
+    bindtextdomain(d, d); // domain name is the same as resource path
+#endif
+
+    for (const engine::DSOBinaryRecord& record : records)
+    {
+        std::unique_ptr<DeepSkyObject> obj = createDSO(record, resourcePath);
+        if (obj == nullptr)
+        {
+            GetLogger()->warn("Bad Deep Sky Object definition--will continue parsing file.\n");
+            continue;
+        }
+
+        for (const std::string& category : record.categories)
+            UserCategory::addObject(obj.get(), UserCategory::findOrAdd(category, resourcePath.string()));
+
+        if (nextAutoCatalogNumber == AstroCatalog::InvalidIndex)
+        {
+            GetLogger()->error("Exceeded maximum DSO count.\n");
+            return false;
+        }
+
+        AstroCatalog::IndexNumber objCatalogNumber = nextAutoCatalogNumber;
+        ++nextAutoCatalogNumber;
+
+        obj->setIndex(objCatalogNumber);
+        DSOs.emplace_back(std::move(obj));
+
+        addName(namesDB.get(), objCatalogNumber, record.names);
+
+        if (keepDefinitions)
+            definitions.push_back(record);
+    }
+
+    return true;
+}
+
+bool
+DSODatabaseBuilder::parseCatalog(util::Tokenizer& tokenizer, const fs::path& resourcePath)
 {
-    util::Tokenizer tokenizer(&in);
     util::Parser    parser(&tokenizer);
 
 #ifdef ENABLE_NLS
@@ -212,6 +545,12 @@ DSODatabaseBuilder::load(std::istream& in, const fs::path& resourcePath)
     bindtextdomain(d, d); // domain name is the same as resource path
 #endif
 
+    // The definitions are read in batches, and the objects of a batch are
+    // loaded in parallel before they are numbered and named in file order.
+    std::vector<DscRecord> records;
+    records.reserve(DscBatchSize);
+
+    bool result = true;
     while (tokenizer.nextToken() != util::Tokenizer::TokenEnd)
     {
         std::string objType;
@@ -222,68 +561,118 @@ DSODatabaseBuilder::load(std::istream& in, const fs::path& resourcePath)
         else
         {
             GetLogger()->error("Error parsing deep sky catalog file.\n");
-            return false;
+            result = false;
+            break;
         }
 
         tokenizer.nextToken();
-        std::string objName;
+        DscRecord& record = records.emplace_back();
         if (auto tokenValue = tokenizer.getStringValue(); tokenValue.has_value())
         {
-            objName = *tokenValue;
+            record.objName = *tokenValue;
         }
         else
         {
             GetLogger()->error("Error parsing deep sky catalog file: bad name.\n");
-            return false;
+            records.pop_back();
+            result = false;
+            break;
         }
 
-        const util::Value objParamsValue = parser.readValue();
-        const util::AssociativeArray* objParams = objParamsValue.getHash();
-        if (objParams == nullptr)
+        record.params = parser.readValue();
+        if (record.params.getHash() == nullptr)
         {
-            GetLogger()->error("Error parsing deep sky catalog entry {}\n", objName);
-            return false;
+            GetLogger()->error("Error parsing deep sky catalog entry {}\n", record.objName);
+            records.pop_back();
+            result = false;
+            break;
         }
 
-        std::unique_ptr<DeepSkyObject> obj = createDSO(objType);
+        record.obj = createDSO(objType);
+        if (records.size() == DscBatchSize)
+        {
+            if (!addRecords(records, resourcePath))
+                return result;
+            records.clear();
+        }
+    }
 
-        if (obj == nullptr || !obj->load(objParams, resourcePath, objName))
+    // Definitions before a parse error are kept
+    addRecords(records, resourcePath);
+    return result;
+}
+
+bool
+DSODatabaseBuilder::addRecords(std::vector<DscRecord>& records, const fs::path& resourcePath)
+{
+    loadRecords(records, resourcePath);
+
+    for (DscRecord& record : records)
+    {
+        if (!record.loaded)
         {
             GetLogger()->warn("Bad Deep Sky Object definition--will continue parsing file.\n");
             continue;
         }
 
-        UserCategory::loadCategories(obj.get(), *objParams, DataDisposition::Add, resourcePath.string());
+        UserCategory::loadCategories(record.obj.get(), *record.params.getHash(),
+                                     DataDisposition::Add, resourcePath.string());
 
         if (nextAutoCatalogNumber == AstroCatalog::InvalidIndex)
         {
             GetLogger()->error("Exceeded maximum DSO count.\n");
-            break;
+            return false;
         }
 
         AstroCatalog::IndexNumber objCatalogNumber = nextAutoCatalogNumber;
         ++nextAutoCatalogNumber;
 
-        obj->setIndex(objCatalogNumber);
-        DSOs.emplace_back(std::move(obj));
+        if (keepDefinitions)
+            definitions.push_back(compileRecord(record));
+
+        record.obj->setIndex(objCatalogNumber);
+        DSOs.emplace_back(std::move(record.obj));
 
-        addName(namesDB.get(), objCatalogNumber, objName);
+        addName(namesDB.get(), objCatalogNumber, record.objName);
     }
 
     return true;
 }
 
+void
+DSODatabaseBuilder::setOctreeCachePath(const fs::path& path)
+{
+    octreeCachePath = path;
+}
+
+void
+DSODatabaseBuilder::setCatalogCacheDirectory(const fs::path& directory)
+{
+    catalogCacheDirectory = directory;
+}
+
+void
+DSODatabaseBuilder::setKeepDefinitions(bool keep)
+{
+    keepDefinitions = keep;
+}
+
+bool
+DSODatabaseBuilder::writeBinary(std::ostream& out) const
+{
+    return engine::WriteDSOBinaryCatalog(out, definitions);
+}
+
 std::unique_ptr<DSODatabase>
 DSODatabaseBuilder::finish()
 {
-    auto octreeRoot = buildOctree(std::move(DSOs));
-    auto catalogNumberIndex = buildCatalogNumberIndex(*octreeRoot);
+    auto octreeRoot = buildOctree(std::move(DSOs), octreeCachePath);
     float avgAbsMag = calcAvgAbsMag(*octreeRoot);
+    namesDB->freeze();
 
     GetLogger()->info(_("Loaded {} deep space objects\n"), octreeRoot->size());
 
     return std::make_unique<DSODatabase>(std::move(octreeRoot),
                                          std::move(namesDB),
-                                         std::move(catalogNumberIndex),
                                          avgAbsMag);
 }
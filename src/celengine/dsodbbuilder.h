@@ -12,14 +12,22 @@
 
 #pragma once
 
+#include <cstddef>
 #include <iosfwd>
 #include <memory>
+#include <string_view>
 #include <vector>
 
 #include <celcompat/filesystem.h>
 #include "astroobj.h"
+#include "dsobinary.h"
 #include "name.h"
 
+namespace celestia::util
+{
+class Tokenizer;
+}
+
 class DeepSkyObject;
 class DSODatabase;
 class NameDatabase;
@@ -31,10 +39,40 @@ public:
     ~DSODatabaseBuilder();
 
     bool load(std::istream&, const fs::path& resourcePath = fs::path());
+    // Load a catalog held in memory, such as a mapped file, either a text
+    // catalog or a binary one written by writeBinary
+    bool load(std::string_view, const fs::path& resourcePath = fs::path());
+
+    // Enable the on-disk octree cache, stored in the given file
+    void setOctreeCachePath(const fs::path&);
+
+    // Keep a binary copy of each text catalog loaded from memory in the
+    // directory, which is loaded instead while the catalog is unchanged
+    void setCatalogCacheDirectory(const fs::path&);
+
+    // Keep the definitions of the objects loaded from now on for writeBinary
+    void setKeepDefinitions(bool);
+    bool writeBinary(std::ostream&) const;
+
+    // Number of objects loaded so far
+    std::size_t size() const { return DSOs.size(); }
+
     std::unique_ptr<DSODatabase> finish();
 
+    struct DscRecord;
+
 private:
+    bool parseCatalog(celestia::util::Tokenizer&, const fs::path&);
+    bool addRecords(std::vector<DscRecord>&, const fs::path&);
+    bool loadCached(std::string_view, const fs::path&);
+    bool addBinaryRecords(const std::vector<celestia::engine::DSOBinaryRecord>&, const fs::path&);
+
     std::vector<std::unique_ptr<DeepSkyObject>> DSOs;
     std::unique_ptr<NameDatabase> namesDB{ std::make_unique<NameDatabase>() };
     AstroCatalog::IndexNumber nextAutoCatalogNumber{ 0 };
+    fs::path octreeCachePath;
+    fs::path catalogCacheDirectory;
+
+    bool keepDefinitions{ false };
+    std::vector<celestia::engine::DSOBinaryRecord> definitions;
 };
@@ -63,6 +63,31 @@ DSOOctreeVisibleObjectsProcessor::checkNode(const DSOOctree::PointType& center,
     return true;
 }
 
+std::uint32_t
+DSOOctreeVisibleObjectsProcessor::checkNodes(const OctreeNodeBatch<double>& batch)
+{
+    using BatchType = OctreeNodeBatch<double>;
+
+    BatchType::MaskArrayType result = batch.inFrustum(m_frustumPlanes);
+
+    BatchType::ArrayType minDistance = batch.distanceFrom(m_obsPosition) - batch.size * numbers::sqrt3;
+    BatchType::FactorArrayType distanceModulus = minDistance.unaryExpr([](double d)
+    {
+        return static_cast<float>(astro::distanceModulus(d));
+    });
+    result = result && ((minDistance <= 0.0) || ((batch.brightFactor + distanceModulus) <= m_limitingFactor));
+
+    m_batchDimmest = (minDistance > 0.0).select(m_limitingFactor - distanceModulus, 1000.0f);
+
+    return BatchType::toBitMask(result);
+}
+
+void
+DSOOctreeVisibleObjectsProcessor::selectNode(unsigned int lane)
+{
+    m_dimmest = m_batchDimmest[lane];
+}
+
 void
 DSOOctreeVisibleObjectsProcessor::process(const std::unique_ptr<DeepSkyObject>& obj) const //NOSONAR
 {
@@ -98,6 +123,15 @@ DSOOctreeCloseObjectsProcessor::checkNode(const DSOOctree::PointType& center,
     return nodeDistance <= m_boundingRadius;
 }
 
+std::uint32_t
+DSOOctreeCloseObjectsProcessor::checkNodes(const OctreeNodeBatch<double>& batch) const
+{
+    using BatchType = OctreeNodeBatch<double>;
+
+    BatchType::ArrayType nodeDistance = batch.distanceFrom(m_obsPosition) - batch.size * numbers::sqrt3;
+    return BatchType::toBitMask(nodeDistance <= m_boundingRadius);
+}
+
 void
 DSOOctreeCloseObjectsProcessor::process(const std::unique_ptr<DeepSkyObject>& obj) const //NOSONAR
 {
@@ -45,6 +45,8 @@ public:
                                      float);
 
     bool checkNode(const DSOOctree::PointType&, double, float);
+    std::uint32_t checkNodes(const OctreeNodeBatch<double>&);
+    void selectNode(unsigned int);
     void process(const std::unique_ptr<DeepSkyObject>&) const; //NOSONAR
 
 private:
@@ -54,6 +56,7 @@ private:
     float m_limitingFactor;
 
     float m_dimmest{ 1000.0f };
+    OctreeNodeBatch<double>::FactorArrayType m_batchDimmest;
 };
 
 class DSOOctreeCloseObjectsProcessor
@@ -64,6 +67,8 @@ public:
                                    double);
 
     bool checkNode(const DSOOctree::PointType&, double, float) const;
+    std::uint32_t checkNodes(const OctreeNodeBatch<double>&) const;
+    void selectNode(unsigned int) const { /* no per-node state */ }
     void process(const std::unique_ptr<DeepSkyObject>&) const; //NOSONAR
 
 private:
@@ -36,6 +36,8 @@ constexpr double enhance = 4.0;
 constexpr double pc10 = 32.6167; // 10 parsecs
 constexpr float CubeCornerToCenterDistance = 1.7320508075688772f;
 
+static_assert(static_cast<std::size_t>(DeepSkyObjectType::OpenCluster) + 1 == celestia::engine::FrameDSOTypeCount);
+
 float
 brightness(float avgAbsMag, float absMag, float appMag, float brightnessCorr, float faintestMag)
 {
@@ -64,9 +66,16 @@ void DSORenderer::process(const std::unique_ptr<DeepSkyObject>& dso, //NOSONAR
                           double distanceToDSO,
                           float absMag)
 {
-    if (distanceToDSO > distanceLimit || !dso->isVisible())
+    if (!dso->isVisible())
         return;
 
+    auto typeIndex = static_cast<std::size_t>(dso->getObjType());
+    if (distanceToDSO > distanceLimit)
+    {
+        ++dsosCulledByType[typeIndex];
+        return;
+    }
+
     Eigen::Vector3f relPos = (dso->getPosition() - obsPos).cast<float>();
     Eigen::Vector3f center = orientationMatrixT * relPos;
 
@@ -76,7 +85,10 @@ void DSORenderer::process(const std::unique_ptr<DeepSkyObject>& dso, //NOSONAR
     // pipeline.
     double dsoRadius = dso->getBoundingSphereRadius();
     if (frustum.testSphere(center, (float) dsoRadius) == math::FrustumAspect::Outside)
+    {
+        ++dsosCulledByType[typeIndex];
         return;
+    }
 
     float appMag;
     if (distanceToDSO >= pc10)
@@ -87,6 +99,7 @@ void DSORenderer::process(const std::unique_ptr<DeepSkyObject>& dso, //NOSONAR
     if (util::is_set(renderFlags, dso->getRenderMask()))
     {
         dsosProcessed++;
+        ++dsosProcessedByType[typeIndex];
 
         float nearZ = 0.0f, farZ = 0.0f;
         if (dsoRadius < 1000.0)
@@ -111,20 +124,20 @@ void DSORenderer::process(const std::unique_ptr<DeepSkyObject>& dso, //NOSONAR
         case DeepSkyObjectType::Galaxy:
             // -19.04f == average over 10937 galaxies in galaxies.dsc.
             b = brightness(-19.04f, absMag, appMag, b, faintestMag);
-            galaxyRenderer->add(static_cast<const Galaxy*>(dso.get()), relPos, b, nearZ, farZ);
+            m_galaxies.push_back({ dso.get(), relPos, b, nearZ, farZ });
             break;
         case DeepSkyObjectType::Globular:
             // -6.86f == average over 150 globulars in globulars.dsc.
             b = brightness(-6.86f, absMag, appMag, b, faintestMag);
-            globularRenderer->add(static_cast<const Globular*>(dso.get()), relPos, b, nearZ, farZ);
+            m_globulars.push_back({ dso.get(), relPos, b, nearZ, farZ });
             break;
         case DeepSkyObjectType::Nebula:
             b = brightness(avgAbsMag, absMag, appMag, b, faintestMag);
-            nebulaRenderer->add(static_cast<const Nebula*>(dso.get()), relPos, b, nearZ, farZ);
+            m_nebulae.push_back({ dso.get(), relPos, b, nearZ, farZ });
             break;
         case DeepSkyObjectType::OpenCluster:
             b = brightness(avgAbsMag, absMag, appMag, b, faintestMag);
-            openClusterRenderer->add(static_cast<const OpenCluster*>(dso.get()), relPos, b, nearZ, farZ);
+            m_openClusters.push_back({ dso.get(), relPos, b, nearZ, farZ });
             break;
         default:
             // Unsupported DSO
@@ -187,13 +200,69 @@ void DSORenderer::process(const std::unique_ptr<DeepSkyObject>& dso, //NOSONAR
             float distr = std::min(1.0f, step * (labelThresholdMag - appMagEff) / labelThresholdMag);
             labelColor.alpha(distr * labelColor.alpha());
 
-            renderer->addBackgroundAnnotation(rep,
-                                              dsoDB->getDSOName(dso.get(), true),
-                                              labelColor,
-                                              relPos,
-                                              Renderer::LabelHorizontalAlignment::Start,
-                                              Renderer::LabelVerticalAlignment::Center,
-                                              symbolSize);
+            m_labels.push_back({ dso.get(), rep, labelColor, relPos, symbolSize, appMagEff });
         }
     }     // labels enabled
 }
+
+void DSORenderer::addPickTargets(const std::vector<QueuedObject> &objects, bool exact) const
+{
+    for (const auto &obj : objects)
+    {
+        float distance = obj.offset.norm();
+        float radius = obj.dso->getRadius();
+        // Objects drawn as points are left to the geometric pick, which also
+        // skips the object the observer is in
+        if (!obj.dso->isClickable() || distance <= radius || radius < distance * pixelSize)
+            continue;
+
+        renderer->addPickTarget(celestia::engine::PickBuffer::Layer::DeepSky,
+                                Selection(const_cast<DeepSkyObject*>(obj.dso)),
+                                obj.offset,
+                                radius / (distance * pixelSize),
+                                distance - radius,
+                                exact);
+    }
+}
+
+void DSORenderer::flush()
+{
+    // Each renderer draws its objects together, so only the order within
+    // a type matters
+    for (const auto &obj : m_galaxies)
+        galaxyRenderer->add(static_cast<const Galaxy*>(obj.dso), obj.offset, obj.brightness, obj.nearZ, obj.farZ);
+    for (const auto &obj : m_globulars)
+        globularRenderer->add(static_cast<const Globular*>(obj.dso), obj.offset, obj.brightness, obj.nearZ, obj.farZ);
+    for (const auto &obj : m_nebulae)
+        nebulaRenderer->add(static_cast<const Nebula*>(obj.dso), obj.offset, obj.brightness, obj.nearZ, obj.farZ);
+    for (const auto &obj : m_openClusters)
+        openClusterRenderer->add(static_cast<const OpenCluster*>(obj.dso), obj.offset, obj.brightness, obj.nearZ, obj.farZ);
+
+    if (recordPickTargets)
+    {
+        // The galaxies and globulars are picked by shapes larger than their
+        // bounding sphere, leave the pick to the geometric test when in doubt
+        addPickTargets(m_galaxies, false);
+        addPickTargets(m_globulars, false);
+        addPickTargets(m_nebulae, true);
+        addPickTargets(m_openClusters, true);
+    }
+
+    for (const auto &label : m_labels)
+    {
+        renderer->addBackgroundAnnotation(label.rep,
+                                          dsoDB->getDSOName(label.dso, true),
+                                          label.color,
+                                          label.offset,
+                                          Renderer::LabelHorizontalAlignment::Start,
+                                          Renderer::LabelVerticalAlignment::Center,
+                                          label.symbolSize,
+                                          label.appMag);
+    }
+
+    m_galaxies.clear();
+    m_globulars.clear();
+    m_nebulae.clear();
+    m_openClusters.clear();
+    m_labels.clear();
+}
@@ -10,20 +10,32 @@
 
 #pragma once
 
+#include <array>
 #include <cstdint>
 #include <memory>
+#include <vector>
 
 #include <Eigen/Core>
 
+#include <celengine/framestats.h>
 #include <celmath/frustum.h>
 #include <celmath/mathlib.h>
 #include <celrender/rendererfwd.h>
+#include <celutil/color.h>
 #include "objectrenderer.h"
 #include "projectionmode.h"
 
 class DeepSkyObject;
 class DSODatabase;
 
+namespace celestia
+{
+class MarkerRepresentation;
+}
+
+// The DSORenderer only culls the objects and queues the accepted ones by
+// type, so that copies of it can process parts of the octree concurrently.
+// The queues are passed on to the renderers by flush, in traversal order.
 class DSORenderer : public ObjectRenderer<std::unique_ptr<DeepSkyObject>, double>
 {
 public:
@@ -31,6 +43,10 @@ public:
 
     void process(const std::unique_ptr<DeepSkyObject>&, double, float) override; //NOSONAR
 
+    // Add the queued objects to the renderers of their type, and their
+    // labels to the renderer, then clear the queues
+    void flush();
+
     celestia::math::InfiniteFrustum frustum{ celestia::math::degToRad(celestia::engine::standardFOV),
                                              1.0f,
                                              1.0f };
@@ -39,11 +55,44 @@ public:
     Eigen::Matrix3f orientationMatrixT;
     DSODatabase    *dsoDB{ nullptr };
 
+    // Record the objects drawn larger than a pixel in the pick buffer of
+    // the renderer on flush
+    bool          recordPickTargets{ false };
     float         avgAbsMag{ 0.0f };
     std::uint32_t dsosProcessed{ 0 };
+    std::array<std::uint32_t, celestia::engine::FrameDSOTypeCount> dsosCulledByType{ };
+    std::array<std::uint32_t, celestia::engine::FrameDSOTypeCount> dsosProcessedByType{ };
 
     celestia::render::GalaxyRenderer      *galaxyRenderer{ nullptr };
     celestia::render::GlobularRenderer    *globularRenderer{ nullptr };
     celestia::render::NebulaRenderer      *nebulaRenderer{ nullptr };
     celestia::render::OpenClusterRenderer *openClusterRenderer{ nullptr };
+
+private:
+    struct QueuedObject
+    {
+        const DeepSkyObject *dso;
+        Eigen::Vector3f      offset;
+        float                brightness;
+        float                nearZ;
+        float                farZ;
+    };
+
+    struct QueuedLabel
+    {
+        const DeepSkyObject                  *dso;
+        const celestia::MarkerRepresentation *rep;
+        Color                                 color;
+        Eigen::Vector3f                       offset;
+        float                                 symbolSize;
+        float                                 appMag;
+    };
+
+    void addPickTargets(const std::vector<QueuedObject>&, bool exact) const;
+
+    std::vector<QueuedObject> m_galaxies;
+    std::vector<QueuedObject> m_globulars;
+    std::vector<QueuedObject> m_nebulae;
+    std::vector<QueuedObject> m_openClusters;
+    std::vector<QueuedLabel>  m_labels;
 };
@@ -0,0 +1,145 @@
+// formcache.cpp
+//
+// Copyright (C) 2025, Celestia Development Team
+//
+// On-disk cache of the point clouds of procedural galaxy and globular
+// cluster forms.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include "formcache.h"
+
+#include <fstream>
+#include <system_error>
+
+#include <fmt/format.h>
+
+#include <celutil/atomicfile.h>
+#include <celutil/binaryread.h>
+#include <celutil/binarywrite.h>
+#include <celutil/hash.h>
+
+namespace celestia::engine
+{
+
+namespace
+{
+
+// Forms have a few thousand blobs, anything much larger is corruption
+constexpr std::uint32_t MaxRecords = 1U << 20;
+
+fs::path cacheDirectory;
+
+fs::path
+getPath(std::uint64_t key)
+{
+    return cacheDirectory / fmt::format("{:016x}.form", key);
+}
+
+} // end unnamed namespace
+
+std::uint64_t
+FormCache::computeKey(std::string_view parameters)
+{
+    return util::FNV1aHash().addValue(Version).addBytes(parameters).value();
+}
+
+std::optional<std::uint64_t>
+FormCache::computeKey(std::string_view parameters, const fs::path& source)
+{
+    std::error_code ec;
+    fs::path path = source.is_absolute() ? source : fs::current_path(ec) / source;
+    if (ec)
+        return std::nullopt;
+
+    std::uintmax_t size = fs::file_size(path, ec);
+    if (ec)
+        return std::nullopt;
+
+    auto modified = fs::last_write_time(path, ec);
+    if (ec)
+        return std::nullopt;
+
+    return computeKey(fmt::format("{}\n{}\n{}\n{}",
+                                  parameters,
+                                  path.u8string(),
+                                  size,
+                                  static_cast<std::int64_t>(modified.time_since_epoch().count())));
+}
+
+std::optional<std::string>
+FormCache::read(std::uint64_t key, std::size_t recordSize)
+{
+    if (cacheDirectory.empty())
+        return std::nullopt;
+
+    std::ifstream in(getPath(key), std::ios::binary);
+    if (!in.good())
+        return std::nullopt;
+
+    char magic[Magic.size()]; //NOSONAR
+    if (!in.read(magic, Magic.size()).good() || std::string_view(magic, Magic.size()) != Magic) /* Flawfinder: ignore */
+        return std::nullopt;
+
+    std::uint32_t version;
+    std::uint64_t fileKey;
+    std::uint32_t fileRecordSize;
+    std::uint32_t count;
+    std::uint64_t checksum;
+    if (!util::readNative(in, version) || version != Version ||
+        !util::readNative(in, fileKey) || fileKey != key ||
+        !util::readNative(in, fileRecordSize) || fileRecordSize != recordSize ||
+        !util::readNative(in, count) || count > MaxRecords ||
+        !util::readNative(in, checksum))
+    {
+        return std::nullopt;
+    }
+
+    std::string payload(static_cast<std::size_t>(count) * recordSize, '\0');
+    if (!in.read(payload.data(), static_cast<std::streamsize>(payload.size())).good() || /* Flawfinder: ignore */
+        util::FNV1aHash().addBytes(payload).value() != checksum)
+    {
+        return std::nullopt;
+    }
+
+    return payload;
+}
+
+bool
+FormCache::write(std::uint64_t key, std::size_t recordSize, const void* data, std::size_t count)
+{
+    if (cacheDirectory.empty() || count > MaxRecords)
+        return false;
+
+    std::error_code ec;
+    fs::create_directories(cacheDirectory, ec);
+
+    // Forms may be built on several threads and by several processes at
+    // once, each one writes its own temporary file
+    util::AtomicFile file(getPath(key));
+    if (!file.isOpen())
+        return false;
+
+    std::string_view payload(static_cast<const char*>(data), count * recordSize);
+    std::ofstream& out = file.stream();
+    out.write(Magic.data(), Magic.size());
+    bool ok = util::writeNative(out, Version) &&
+              util::writeNative(out, key) &&
+              util::writeNative(out, static_cast<std::uint32_t>(recordSize)) &&
+              util::writeNative(out, static_cast<std::uint32_t>(count)) &&
+              util::writeNative(out, util::FNV1aHash().addBytes(payload).value()) &&
+              out.write(payload.data(), static_cast<std::streamsize>(payload.size())).good();
+
+    return ok && file.commit();
+}
+
+void
+SetFormCacheDirectory(const fs::path& directory)
+{
+    cacheDirectory = directory;
+}
+
+} // end namespace celestia::engine
@@ -0,0 +1,90 @@
+// formcache.h
+//
+// Copyright (C) 2025, Celestia Development Team
+//
+// On-disk cache of the point clouds of procedural galaxy and globular
+// cluster forms.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include <celcompat/filesystem.h>
+
+namespace celestia::engine
+{
+
+// The FormCache keeps the blobs generated for a form in one file per form,
+// named after a hash of the parameters the generation depends on, so that
+// later runs skip the random sampling. Like the other caches, the blobs are
+// written in native byte order as raw records; a file with another record
+// size, key or checksum is ignored and replaced on the next save.
+class FormCache
+{
+public:
+    // Returns a key for the parameters, which should include a version of
+    // the generating code
+    static std::uint64_t computeKey(std::string_view parameters);
+
+    // Returns the key of a form generated from a source file, from its path,
+    // size and modification time, or nullopt if the file doesn't exist
+    static std::optional<std::uint64_t> computeKey(std::string_view parameters,
+                                                   const fs::path& source);
+
+    // Returns false and leaves the records untouched if there is no valid
+    // file for the key, or the cache is disabled
+    template<typename T>
+    static bool load(std::uint64_t key, std::vector<T>& records);
+
+    template<typename T>
+    static bool save(std::uint64_t key, const std::vector<T>& records);
+
+private:
+    static constexpr std::string_view Magic{ "CELFORMC" };
+    static constexpr std::uint32_t Version = 1;
+
+    static std::optional<std::string> read(std::uint64_t key, std::size_t recordSize);
+    static bool write(std::uint64_t key, std::size_t recordSize, const void* data, std::size_t count);
+};
+
+// Keep the generated forms in the directory; an empty path disables the
+// cache. Call before any form is built.
+void
+SetFormCacheDirectory(const fs::path& directory);
+
+template<typename T>
+bool
+FormCache::load(std::uint64_t key, std::vector<T>& records)
+{
+    static_assert(std::is_standard_layout_v<T> && std::is_trivially_destructible_v<T>);
+
+    auto payload = read(key, sizeof(T));
+    if (!payload.has_value())
+        return false;
+
+    records.resize(payload->size() / sizeof(T));
+    std::memcpy(static_cast<void*>(records.data()), payload->data(), payload->size()); //NOSONAR
+    return true;
+}
+
+template<typename T>
+bool
+FormCache::save(std::uint64_t key, const std::vector<T>& records)
+{
+    static_assert(std::is_standard_layout_v<T> && std::is_trivially_destructible_v<T>);
+    return write(key, sizeof(T), records.data(), records.size());
+}
+
+} // end namespace celestia::engine
@@ -213,6 +213,12 @@ J2000EclipticFrame::isInertial() const
     return true;
 }
 
+bool
+J2000EclipticFrame::isThreadSafe() const
+{
+    return true;
+}
+
 unsigned int
 J2000EclipticFrame::nestingDepth(unsigned int depth,
                                  unsigned int maxDepth) const
@@ -239,6 +245,12 @@ J2000EquatorFrame::isInertial() const
     return true;
 }
 
+bool
+J2000EquatorFrame::isThreadSafe() const
+{
+    return true;
+}
+
 unsigned int
 J2000EquatorFrame::nestingDepth(unsigned int depth,
                                 unsigned int maxDepth) const
@@ -48,6 +48,10 @@ public:
 
     virtual bool isInertial() const = 0;
 
+    // Return true if getOrientation may be called concurrently from several
+    // threads: the frame has no caches and doesn't depend on other objects.
+    virtual bool isThreadSafe() const { return false; }
+
     unsigned int nestingDepth(unsigned int maxDepth) const;
 
 protected:
@@ -112,6 +116,7 @@ public:
     }
 
     bool isInertial() const override;
+    bool isThreadSafe() const override;
 
 protected:
     unsigned int nestingDepth(unsigned int depth,
@@ -128,6 +133,7 @@ public:
     ~J2000EquatorFrame() override = default;
     Eigen::Quaterniond getOrientation(double tjd) const override;
     bool isInertial() const override;
+    bool isThreadSafe() const override;
 
 protected:
     unsigned int nestingDepth(unsigned int depth,
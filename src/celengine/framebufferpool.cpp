@@ -0,0 +1,108 @@
+// framebufferpool.cpp
+//
+// Copyright (C) 2025, Celestia Development Team
+//
+// Pool of render targets reused by size and attachments.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include "framebufferpool.h"
+
+#include <algorithm>
+
+#include "framebuffer.h"
+
+FramebufferPool::~FramebufferPool() = default;
+
+std::shared_ptr<FramebufferObject>
+FramebufferPool::acquire(GLuint width, GLuint height, unsigned int attachments)
+{
+    if (Entry* entry = find(width, height, attachments); entry != nullptr)
+    {
+        entry->lastUsed = m_frame;
+        entry->transient = false;
+        return entry->fbo;
+    }
+
+    auto fbo = std::make_shared<FramebufferObject>(width, height, attachments);
+    if (!fbo->isValid())
+        return nullptr;
+
+    m_entries.push_back({ fbo, attachments, m_frame, false });
+    return fbo;
+}
+
+FramebufferObject*
+FramebufferPool::acquireTransient(GLuint width, GLuint height, unsigned int attachments)
+{
+    auto fbo = acquire(width, height, attachments);
+    if (fbo == nullptr)
+        return nullptr;
+
+    // The pool holds the only reference, the target stays in use through
+    // the flag until the next frame
+    auto it = std::find_if(m_entries.begin(), m_entries.end(),
+                           [&fbo](const Entry& entry) { return entry.fbo == fbo; });
+    it->transient = true;
+    return fbo.get();
+}
+
+void
+FramebufferPool::beginFrame()
+{
+    for (Entry& entry : m_entries)
+    {
+        if (isInUse(entry))
+            entry.lastUsed = m_frame;
+        entry.transient = false;
+    }
+
+    ++m_frame;
+    m_entries.erase(std::remove_if(m_entries.begin(), m_entries.end(),
+                                   [this](const Entry& entry)
+                                   {
+                                       return !isInUse(entry) && m_frame - entry.lastUsed > MaxUnusedFrames;
+                                   }),
+                    m_entries.end());
+
+    // Free the oldest unused targets beyond the limit
+    std::size_t unused = std::count_if(m_entries.begin(), m_entries.end(),
+                                       [this](const Entry& entry) { return !isInUse(entry); });
+    while (unused > MaxUnusedTargets)
+    {
+        auto oldest = m_entries.end();
+        for (auto it = m_entries.begin(); it != m_entries.end(); ++it)
+        {
+            if (!isInUse(*it) && (oldest == m_entries.end() || it->lastUsed < oldest->lastUsed))
+                oldest = it;
+        }
+        m_entries.erase(oldest);
+        --unused;
+    }
+}
+
+bool
+FramebufferPool::isInUse(const Entry& entry) const
+{
+    return entry.transient || entry.fbo.use_count() > 1;
+}
+
+FramebufferPool::Entry*
+FramebufferPool::find(GLuint width, GLuint height, unsigned int attachments)
+{
+    for (Entry& entry : m_entries)
+    {
+        if (!isInUse(entry) &&
+            entry.attachments == attachments &&
+            entry.fbo->width() == width &&
+            entry.fbo->height() == height)
+        {
+            return &entry;
+        }
+    }
+
+    return nullptr;
+}
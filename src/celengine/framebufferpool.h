@@ -0,0 +1,69 @@
+// framebufferpool.h
+//
+// Copyright (C) 2025, Celestia Development Team
+//
+// Pool of render targets reused by size and attachments.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "glsupport.h"
+
+class FramebufferObject;
+
+// Render targets shared by the views, the shadow maps and the captures. A
+// target handed out by acquire() is in use while a reference to it is held;
+// one handed out by acquireTransient() is in use until the next frame. The
+// targets no longer in use are kept for MaxUnusedFrames frames, so that
+// resizing a view or toggling an effect back gets the same targets instead
+// of allocating new ones.
+class FramebufferPool
+{
+public:
+    static constexpr std::uint32_t MaxUnusedFrames = 120;
+    // Unused targets kept at most, to bound the memory held while a window
+    // is resized
+    static constexpr std::size_t MaxUnusedTargets = 4;
+
+    FramebufferPool() = default;
+    ~FramebufferPool();
+
+    FramebufferPool(const FramebufferPool&) = delete;
+    FramebufferPool& operator=(const FramebufferPool&) = delete;
+    FramebufferPool(FramebufferPool&&) = delete;
+    FramebufferPool& operator=(FramebufferPool&&) = delete;
+
+    // Get a target of the size and FramebufferObject attachments, nullptr
+    // when it can't be created
+    std::shared_ptr<FramebufferObject> acquire(GLuint width, GLuint height, unsigned int attachments);
+    // Get a target for the current frame only
+    FramebufferObject* acquireTransient(GLuint width, GLuint height, unsigned int attachments);
+
+    // Start a new frame: release the transient targets and free the targets
+    // which have been unused for too long
+    void beginFrame();
+
+private:
+    struct Entry
+    {
+        std::shared_ptr<FramebufferObject> fbo;
+        unsigned int attachments;
+        std::uint32_t lastUsed;
+        bool transient;
+    };
+
+    bool isInUse(const Entry&) const;
+    Entry* find(GLuint width, GLuint height, unsigned int attachments);
+
+    std::vector<Entry> m_entries;
+    std::uint32_t m_frame{ 0 };
+};
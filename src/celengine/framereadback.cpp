@@ -0,0 +1,131 @@
+// framereadback.cpp
+//
+// Copyright (C) 2024, the Celestia Development Team
+//
+// Asynchronous framebuffer reads through pixel buffer objects.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include "framereadback.h"
+
+#include <cstring>
+
+#include "render.h"
+
+namespace gl = celestia::gl;
+using celestia::engine::PixelFormat;
+
+FrameReadback::FrameReadback(const Renderer& renderer,
+                             int width,
+                             int height,
+                             PixelFormat format) :
+    m_renderer(renderer),
+    m_width(width),
+    m_height(height),
+    m_format(format)
+{
+    const std::size_t bytesPerPixel = format == PixelFormat::RGBA || format == PixelFormat::BGRA ? 4 : 3;
+    // The default GL_PACK_ALIGNMENT of 4
+    m_rowStride = (bytesPerPixel * static_cast<std::size_t>(width) + 3) & ~std::size_t(3);
+
+    glGenBuffers(RingSize, m_buffers.data());
+    for (GLuint buffer : m_buffers)
+    {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer);
+        glBufferData(GL_PIXEL_PACK_BUFFER, static_cast<GLsizeiptr>(getFrameSize()), nullptr, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+FrameReadback::~FrameReadback()
+{
+    for (GLsync fence : m_fences)
+    {
+        if (fence != nullptr)
+            glDeleteSync(fence);
+    }
+    glDeleteBuffers(RingSize, m_buffers.data());
+}
+
+bool
+FrameReadback::isSupported()
+{
+#ifdef GL_ES
+    return gl::checkVersion(gl::GLES_3);
+#else
+    return gl::ARB_sync && gl::checkVersion(gl::GL_3_0);
+#endif
+}
+
+bool
+FrameReadback::read(int x, int y)
+{
+    if (isFull())
+        return false;
+
+    const unsigned int slot = (m_first + m_pending) % RingSize;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, m_buffers[slot]);
+    glReadPixels(x, y, m_width, m_height, static_cast<GLenum>(m_format), GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    if (glGetError() != GL_NO_ERROR)
+        return false;
+
+    m_fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    ++m_pending;
+    return true;
+}
+
+bool
+FrameReadback::retrieve(unsigned char* buffer, bool wait)
+{
+    if (m_pending == 0)
+        return false;
+
+    GLsync& fence = m_fences[m_first];
+    if (wait)
+    {
+        constexpr GLuint64 timeout = 1000000000; // 1 second
+        while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout) == GL_TIMEOUT_EXPIRED) {}
+    }
+    else if (glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+    {
+        return false;
+    }
+
+    glDeleteSync(fence);
+    fence = nullptr;
+
+    const std::size_t frameSize = getFrameSize();
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, m_buffers[m_first]);
+    const auto* pixels = static_cast<const unsigned char*>(glMapBufferRange(GL_PIXEL_PACK_BUFFER,
+                                                                            0,
+                                                                            static_cast<GLsizeiptr>(frameSize),
+                                                                            GL_MAP_READ_BIT));
+    bool ok = pixels != nullptr;
+    if (ok)
+    {
+        if (m_renderer.isPackInverted())
+        {
+            std::memcpy(buffer, pixels, frameSize);
+        }
+        else
+        {
+            // GL rows go bottom up
+            for (int row = 0; row < m_height; ++row)
+            {
+                std::memcpy(buffer + static_cast<std::size_t>(row) * m_rowStride,
+                            pixels + static_cast<std::size_t>(m_height - 1 - row) * m_rowStride,
+                            m_rowStride);
+            }
+        }
+        ok = glUnmapBuffer(GL_PIXEL_PACK_BUFFER) == GL_TRUE;
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    m_first = (m_first + 1) % RingSize;
+    --m_pending;
+    return ok;
+}
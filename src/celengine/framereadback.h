@@ -0,0 +1,68 @@
+// framereadback.h
+//
+// Copyright (C) 2024, the Celestia Development Team
+//
+// Asynchronous framebuffer reads through pixel buffer objects.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+#include <celimage/pixelformat.h>
+#include "glsupport.h"
+
+class Renderer;
+
+// FrameReadback reads regions of the framebuffer through a ring of
+// RingSize pixel buffer objects. A read only queues the transfer and places
+// a fence after it; the pixels are copied out once the fence has signaled,
+// so the transfer of a frame overlaps with rendering the next ones. The
+// frames are retrieved in the order they were read.
+//
+// Retrieved frames have their top row first, like the ones returned by
+// Renderer::captureFrame, with rows padded to four bytes.
+class FrameReadback
+{
+ public:
+    static constexpr unsigned int RingSize = 3;
+
+    FrameReadback(const Renderer&, int width, int height, celestia::engine::PixelFormat);
+    ~FrameReadback();
+    FrameReadback(const FrameReadback&) = delete;
+    FrameReadback& operator=(const FrameReadback&) = delete;
+
+    // Pixel buffer objects, fences and buffer mapping are all needed
+    static bool isSupported();
+
+    std::size_t getRowStride() const { return m_rowStride; }
+    std::size_t getFrameSize() const { return m_rowStride * static_cast<std::size_t>(m_height); }
+
+    unsigned int getPending() const { return m_pending; }
+    bool isFull() const { return m_pending == RingSize; }
+
+    // Queue the read of the region with its lower left corner at x, y. Fails
+    // if the ring is full.
+    bool read(int x, int y);
+    // Copy the oldest frame into buffer, which must hold getFrameSize()
+    // bytes. Without wait, fails if the transfer hasn't finished yet.
+    bool retrieve(unsigned char* buffer, bool wait);
+
+ private:
+    const Renderer& m_renderer;
+    int m_width;
+    int m_height;
+    celestia::engine::PixelFormat m_format;
+    std::size_t m_rowStride;
+
+    std::array<GLuint, RingSize> m_buffers{ };
+    std::array<GLsync, RingSize> m_fences{ };
+    // Slot of the oldest pending frame
+    unsigned int m_first{ 0 };
+    unsigned int m_pending{ 0 };
+};
@@ -0,0 +1,141 @@
+// framestats.cpp
+//
+// Copyright (C) 2024, Celestia Development Team
+//
+// Counters and timings of the stages of a frame.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include "framestats.h"
+
+#include <memory>
+#include <utility>
+
+using namespace std::string_view_literals;
+
+namespace celestia::engine
+{
+
+namespace
+{
+
+constexpr std::array<std::string_view, FrameStageCount> FrameStageNames
+{
+    "simulation"sv,
+    "resources"sv,
+    "lists"sv,
+    "deepsky"sv,
+    "stars"sv,
+    "annotations"sv,
+    "solarsystem"sv,
+};
+
+constexpr std::array<std::string_view, GPUStageCount> GPUStageNames
+{
+    "skygrids"sv,
+    "deepsky"sv,
+    "stars"sv,
+    "annotations"sv,
+    "solarsystem"sv,
+    "effects"sv,
+    "overlay"sv,
+};
+
+constexpr std::array<std::string_view, FrameZoneCount> FrameZoneNames
+{
+    "texture"sv,
+    "geometry"sv,
+    "orbit"sv,
+    "shader"sv,
+    "script"sv,
+};
+
+} // end unnamed namespace
+
+std::string_view
+GetFrameStageName(FrameStage stage)
+{
+    auto index = static_cast<std::size_t>(stage);
+    return index < FrameStageCount ? FrameStageNames[index] : std::string_view{};
+}
+
+std::string_view
+GetGPUStageName(GPUStage stage)
+{
+    auto index = static_cast<std::size_t>(stage);
+    return index < GPUStageCount ? GPUStageNames[index] : std::string_view{};
+}
+
+std::string_view
+GetFrameZoneName(FrameZone zone)
+{
+    auto index = static_cast<std::size_t>(zone);
+    return index < FrameZoneCount ? FrameZoneNames[index] : std::string_view{};
+}
+
+void
+FrameStats::beginFrame()
+{
+    std::uint64_t frame = m_current.frame;
+    m_last = std::move(m_current);
+    m_current = FrameCounters{};
+    m_current.frame = frame + 1;
+}
+
+void
+FrameStats::addStageTime(FrameStage stage, std::chrono::steady_clock::duration duration)
+{
+    auto index = static_cast<std::size_t>(stage);
+    if (index < FrameStageCount)
+        m_current.stageTimes[index] += std::chrono::duration<double, std::milli>(duration).count();
+}
+
+void
+FrameStats::addGPUTime(std::chrono::nanoseconds duration)
+{
+    m_current.gpuTime = m_current.gpuTime.value_or(0.0) +
+                        std::chrono::duration<double, std::milli>(duration).count();
+}
+
+void
+FrameStats::addGPUStageTime(GPUStage stage, std::chrono::nanoseconds duration)
+{
+    auto index = static_cast<std::size_t>(stage);
+    if (index >= GPUStageCount)
+        return;
+
+    if (!m_current.gpuStageTimes.has_value())
+        m_current.gpuStageTimes.emplace();
+    (*m_current.gpuStageTimes)[index] += std::chrono::duration<double, std::milli>(duration).count();
+}
+
+void
+FrameStats::addInputLatency(std::chrono::steady_clock::duration duration)
+{
+    double latency = std::chrono::duration<double, std::milli>(duration).count();
+    m_current.inputLatency = latency;
+    if (m_averageInputLatency.has_value())
+        *m_averageInputLatency += (latency - *m_averageInputLatency) * 0.1;
+    else
+        m_averageInputLatency = latency;
+}
+
+void
+FrameStats::addZoneTime(FrameZone zone, std::string_view name, std::chrono::steady_clock::duration duration)
+{
+    double time = std::chrono::duration<double, std::milli>(duration).count();
+    if (time >= MinFrameZoneTime)
+        m_current.zones.push_back({ zone, std::string(name), time });
+}
+
+FrameStats*
+GetFrameStats()
+{
+    static FrameStats* const stats = std::make_unique<FrameStats>().release(); //NOSONAR
+    return stats;
+}
+
+} // namespace celestia::engine
@@ -0,0 +1,209 @@
+// framestats.h
+//
+// Copyright (C) 2024, Celestia Development Team
+//
+// Counters and timings of the stages of a frame.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace celestia::engine
+{
+
+enum class FrameStage : std::uint8_t
+{
+    Simulation,  // Simulation::update, including the scripts
+    Resources,   // Shaders, textures and models ready to be uploaded
+    Lists,       // Render, orbit and light source lists
+    DeepSky,
+    Stars,
+    Annotations, // Grids, asterisms, boundaries, markers and labels
+    SolarSystem,
+    Count,
+};
+
+constexpr inline std::size_t FrameStageCount = static_cast<std::size_t>(FrameStage::Count);
+
+// The passes of a view timed on the GPU
+enum class GPUStage : std::uint8_t
+{
+    SkyGrids,
+    DeepSky,
+    Stars,
+    Annotations,     // Asterisms, boundaries, markers and labels
+    SolarSystem,     // All the depth partitions
+    ViewportEffects,
+    Overlay,         // HUD and console
+    Count,
+};
+
+constexpr inline std::size_t GPUStageCount = static_cast<std::size_t>(GPUStage::Count);
+
+// Work done for one object which can stall a frame
+enum class FrameZone : std::uint8_t
+{
+    TextureLoad,   // Creating a texture, including decoding when synchronous
+    GeometryLoad,
+    OrbitSampling,
+    ShaderCompile,
+    ScriptTick,
+    Count,
+};
+
+constexpr inline std::size_t FrameZoneCount = static_cast<std::size_t>(FrameZone::Count);
+
+// Zones taking less time are not recorded
+constexpr inline double MinFrameZoneTime = 1.0;
+
+struct FrameZoneTime
+{
+    FrameZone zone;
+    // The file, object or script the work was done for
+    std::string name;
+    // Milliseconds
+    double time{ 0.0 };
+};
+
+// The deep sky objects are counted by DeepSkyObjectType
+constexpr inline std::size_t FrameDSOTypeCount = 4;
+
+std::string_view GetFrameStageName(FrameStage);
+std::string_view GetGPUStageName(GPUStage);
+std::string_view GetFrameZoneName(FrameZone);
+
+struct FrameCounters
+{
+    std::uint64_t frame{ 0 };
+    // Stars passed to the point star renderer; with GPU star culling only
+    // the ones which get a label
+    std::uint32_t starsProcessed{ 0 };
+    std::uint32_t dsosProcessed{ 0 };
+    // DSOs of the visible octree nodes which were rejected by their distance
+    // or bounding sphere, and DSOs processed, by type
+    std::array<std::uint32_t, FrameDSOTypeCount> dsosCulledByType{ };
+    std::array<std::uint32_t, FrameDSOTypeCount> dsosProcessedByType{ };
+    // Points of the galaxy point clouds drawn
+    std::uint32_t galaxyPoints{ 0 };
+    std::uint32_t renderListSize{ 0 };
+    std::uint32_t depthPartitions{ 0 };
+    std::uint32_t drawCalls{ 0 };
+    // Vertices, or indices for indexed draws, of the draw calls counted
+    std::uint64_t verticesSubmitted{ 0 };
+    std::uint32_t orbitCacheHits{ 0 };
+    std::uint32_t orbitCacheMisses{ 0 };
+    // Programs compiled from source, rather than read from the shader cache
+    std::uint32_t shaderCompiles{ 0 };
+    std::uint32_t textureUploads{ 0 };
+    std::uint64_t textureUploadBytes{ 0 };
+    // Bodies whose eclipse and ring shadows were computed, or reused from
+    // an earlier view or frame at the same time
+    std::uint32_t lightingComputed{ 0 };
+    std::uint32_t lightingReused{ 0 };
+    // Milliseconds of CPU time spent by each stage
+    std::array<double, FrameStageCount> stageTimes{ };
+    // Milliseconds the GPU spent on the views which completed during the
+    // frame, which are those of one or two frames earlier. Nothing when
+    // timer queries aren't available.
+    std::optional<double> gpuTime;
+    // Milliseconds the GPU spent on each stage of the views which completed
+    // during the frame. Nothing when timer queries aren't available.
+    std::optional<std::array<double, GPUStageCount>> gpuStageTimes;
+    // Milliseconds from the oldest input event shown in the frame to its
+    // presentation. Nothing when the frame shows no input or the front end
+    // doesn't measure it.
+    std::optional<double> inputLatency;
+    // Zones which took at least MinFrameZoneTime, in the order they ended
+    std::vector<FrameZoneTime> zones;
+};
+
+// Collects the counters of the frame being prepared, which starts with the
+// simulation tick and ends with the next tick. Only used from the render
+// thread.
+class FrameStats
+{
+public:
+    void beginFrame();
+
+    FrameCounters& current() { return m_current; }
+    // The counters of the last complete frame
+    const FrameCounters& getLastFrame() const { return m_last; }
+
+    void addStageTime(FrameStage, std::chrono::steady_clock::duration);
+    void addGPUTime(std::chrono::nanoseconds);
+    void addGPUStageTime(GPUStage, std::chrono::nanoseconds);
+    void addDrawCall(std::uint64_t vertexCount)
+    {
+        ++m_current.drawCalls;
+        m_current.verticesSubmitted += vertexCount;
+    }
+    void addInputLatency(std::chrono::steady_clock::duration);
+    void addZoneTime(FrameZone, std::string_view name, std::chrono::steady_clock::duration);
+
+    // The input latency averaged over the last frames showing input
+    std::optional<double> getAverageInputLatency() const { return m_averageInputLatency; }
+
+private:
+    FrameCounters m_current;
+    FrameCounters m_last;
+    std::optional<double> m_averageInputLatency;
+};
+
+FrameStats* GetFrameStats();
+
+// Adds the time elapsed since the previous lap, or construction, to a stage
+class FrameStageTimer
+{
+public:
+    FrameStageTimer() : m_start(std::chrono::steady_clock::now()) {}
+
+    void lap(FrameStage stage)
+    {
+        auto now = std::chrono::steady_clock::now();
+        GetFrameStats()->addStageTime(stage, now - m_start);
+        m_start = now;
+    }
+
+private:
+    std::chrono::steady_clock::time_point m_start;
+};
+
+// Adds the time from construction to destruction to a zone. The name must
+// outlive the timer.
+class FrameZoneTimer
+{
+public:
+    FrameZoneTimer(FrameZone zone, std::string_view name) :
+        m_zone(zone),
+        m_name(name),
+        m_start(std::chrono::steady_clock::now())
+    {
+    }
+
+    ~FrameZoneTimer()
+    {
+        GetFrameStats()->addZoneTime(m_zone, m_name, std::chrono::steady_clock::now() - m_start);
+    }
+
+    FrameZoneTimer(const FrameZoneTimer&) = delete;
+    FrameZoneTimer& operator=(const FrameZoneTimer&) = delete;
+
+private:
+    FrameZone m_zone;
+    std::string_view m_name;
+    std::chrono::steady_clock::time_point m_start;
+};
+
+} // namespace celestia::engine
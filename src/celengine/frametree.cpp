@@ -13,11 +13,19 @@
 #include "frametree.h"
 
 #include <algorithm>
+#include <cstddef>
+#include <limits>
+
+#include <Eigen/Geometry>
 
 #include <celephem/orbit.h>
+#include <celephem/rotation.h>
+#include <celutil/threadpool.h>
 #include "frame.h"
 #include "timelinephase.h"
 
+namespace util = celestia::util;
+
 /* A FrameTree is hierarchy of solar system bodies organized according to
  * the relationship of their reference frames. An object will appear in as
  * a child in the tree of whatever object is the center of its orbit frame.
@@ -36,8 +44,50 @@
  * objects themselves. Change tracking is performed whenever the frame tree
  * is modified: adding a node, removing a node, or changing the radius of an
  * object will all cause the tree to be marked as changed.
+ *
+ * Large levels of the tree, such as the asteroids orbiting the Sun, also
+ * keep the bounding sphere of each child and its subtree in one array, and
+ * after the positions of the bodies are evaluated, the bounds of groups of
+ * consecutive children. The renderer rejects whole groups of small bodies
+ * that lie outside the view with a single test.
  */
 
+namespace
+{
+
+// Tree levels with at least this many children are evaluated in parallel,
+// in chunks of StateChunkSize phases.
+constexpr unsigned int ParallelStateThreshold = 2048;
+constexpr unsigned int StateChunkSize = 512;
+
+// Children of tree levels with at least this many of them are grouped
+// for culling.
+constexpr unsigned int BoundsGroupThreshold = 256;
+
+// The state of a phase which passes this test can be computed on a worker
+// thread; phases with scripted or caching models, or frames which depend
+// on other bodies, are evaluated on the calling thread.
+bool
+isThreadSafePhase(const TimelinePhase* phase)
+{
+    return phase->orbit()->isThreadSafe() &&
+           phase->orbitFrame()->isThreadSafe() &&
+           phase->rotationModel()->isThreadSafe() &&
+           phase->bodyFrame()->isThreadSafe();
+}
+
+void
+updateBodyState(const TimelinePhase* phase, double tdb, const Star* star, const Eigen::Vector3d& center)
+{
+    // The orbit frame of a phase is centered on the parent of its tree
+    Eigen::Vector3d p = center +
+                        phase->orbitFrame()->getOrientation(tdb).conjugate() * phase->orbit()->positionAtTime(tdb);
+    Eigen::Quaterniond q = phase->rotationModel()->orientationAtTime(tdb) * phase->bodyFrame()->getOrientation(tdb);
+    phase->body()->setEphemerisState(tdb, star, p, q);
+}
+
+} // end unnamed namespace
+
 /*! Create a frame tree associated with a star.
  */
 FrameTree::FrameTree(Star* star) :
@@ -74,6 +124,8 @@ FrameTree::getDefaultReferenceFrame() const
 void
 FrameTree::markChanged()
 {
+    m_stateTdb = std::numeric_limits<double>::quiet_NaN();
+    m_boundsTdb = std::numeric_limits<double>::quiet_NaN();
     if (!m_changed)
     {
         m_changed = true;
@@ -114,25 +166,41 @@ FrameTree::recomputeBoundingSphere()
     m_containsSecondaryIlluminators = false;
     m_childClassMask = BodyClassification::EmptyMask;
 
-    for (const auto &phase : children)
+    m_childRadii.resize(children.size());
+    m_boundsGroups.clear();
+    if (children.size() >= BoundsGroupThreshold)
+        m_boundsGroups.resize((children.size() + BoundsGroupSize - 1) / BoundsGroupSize);
+
+    for (std::size_t i = 0; i < children.size(); i++)
     {
+        const TimelinePhase* phase = children[i].get();
         double bodyRadius = phase->body()->getRadius();
-        double r = phase->body()->getCullingRadius() + phase->orbit()->getBoundingRadius();
+        double childRadius = phase->body()->getCullingRadius();
+        bool isSecondaryIlluminator = phase->body()->isSecondaryIlluminator();
         m_maxChildRadius = std::max(m_maxChildRadius, bodyRadius);
-        m_containsSecondaryIlluminators = m_containsSecondaryIlluminators || phase->body()->isSecondaryIlluminator();
         m_childClassMask |= phase->body()->getClassification();
 
         if (FrameTree* tree = phase->body()->getFrameTree(); tree != nullptr)
         {
             tree->recomputeBoundingSphere();
-            r += tree->m_boundingSphereRadius;
+            childRadius += tree->m_boundingSphereRadius;
             m_maxChildRadius = std::max(m_maxChildRadius, tree->m_maxChildRadius);
-            m_containsSecondaryIlluminators = m_containsSecondaryIlluminators || tree->containsSecondaryIlluminators();
+            isSecondaryIlluminator = isSecondaryIlluminator || tree->containsSecondaryIlluminators();
             m_childClassMask |= tree->childClassMask();
         }
 
-        m_boundingSphereRadius = std::max(m_boundingSphereRadius, r);
+        m_childRadii[i] = childRadius;
+        m_containsSecondaryIlluminators = m_containsSecondaryIlluminators || isSecondaryIlluminator;
+        if (isSecondaryIlluminator && !m_boundsGroups.empty())
+            m_boundsGroups[i / BoundsGroupSize].containsSecondaryIlluminators = true;
+
+        m_boundingSphereRadius = std::max(m_boundingSphereRadius, childRadius + phase->orbit()->getBoundingRadius());
     }
+
+    // The group bounds depend on the radii, so the states are evaluated
+    // again
+    m_stateTdb = std::numeric_limits<double>::quiet_NaN();
+    m_boundsTdb = std::numeric_limits<double>::quiet_NaN();
 }
 
 /*! Add a new phase to this tree.
@@ -171,3 +239,130 @@ FrameTree::childCount() const
 {
     return static_cast<unsigned int>(children.size());
 }
+
+/*! Evaluate the position and orientation of every body in the tree at tdb,
+ *  parents before their children, and store them in the bodies. This is
+ *  done once per frame on the render thread, so that the renderer doesn't
+ *  evaluate the orbits and frames of a body and all of its parents again;
+ *  it reads the stored states through Body::getRenderPosition and related
+ *  methods. Other users, such as picking and the HUD, evaluate the
+ *  ephemerides directly. Only trees associated with a star can be
+ *  evaluated. Nothing is done when the states are already stored for tdb,
+ *  such as when several views are rendered at the same time.
+ */
+void
+FrameTree::updateBodyStates(double tdb) const
+{
+    if (starParent == nullptr)
+        return;
+
+    if (tdb == m_stateTdb && Body::getEphemerisEpoch() == m_stateEpoch)
+        return;
+
+    updateBodyStates(tdb, starParent, Eigen::Vector3d::Zero());
+    m_stateTdb = tdb;
+    m_stateEpoch = Body::getEphemerisEpoch();
+}
+
+void
+FrameTree::updateBodyStates(double tdb, const Star* star, const Eigen::Vector3d& center) const
+{
+    auto nChildren = static_cast<unsigned int>(children.size());
+    if (nChildren >= ParallelStateThreshold)
+    {
+        std::size_t nChunks = (nChildren + StateChunkSize - 1) / StateChunkSize;
+        util::GetThreadPool()->parallelFor(nChunks, [&](std::size_t chunkIdx)
+        {
+            auto first = static_cast<unsigned int>(chunkIdx) * StateChunkSize;
+            auto last = std::min(first + StateChunkSize, nChildren);
+            for (unsigned int i = first; i < last; i++)
+            {
+                const TimelinePhase* phase = children[i].get();
+                if (phase->includes(tdb) && isThreadSafePhase(phase))
+                    updateBodyState(phase, tdb, star, center);
+            }
+        });
+
+        for (const auto& phase : children)
+        {
+            if (phase->includes(tdb) && !isThreadSafePhase(phase.get()))
+                updateBodyState(phase.get(), tdb, star, center);
+        }
+    }
+    else
+    {
+        for (const auto& phase : children)
+        {
+            if (phase->includes(tdb))
+                updateBodyState(phase.get(), tdb, star, center);
+        }
+    }
+
+    for (const auto& phase : children)
+    {
+        if (!phase->includes(tdb))
+            continue;
+
+        const Body* body = phase->body();
+        if (const FrameTree* tree = body->getFrameTree(); tree != nullptr)
+            tree->updateBodyStates(tdb, star, body->getRenderAstrocentricPosition(tdb));
+    }
+
+    updateBoundsGroups(tdb);
+}
+
+/*! Compute the bounds of the groups of children from the positions just
+ *  stored in the bodies. The radii are those of the last
+ *  recomputeBoundingSphere; the groups are left out of date when the tree
+ *  has changed since.
+ */
+void
+FrameTree::updateBoundsGroups(double tdb) const
+{
+    if (m_boundsGroups.empty() || m_changed || m_childRadii.size() != children.size())
+        return;
+
+    auto nChildren = static_cast<unsigned int>(children.size());
+    auto updateGroup = [this, tdb, nChildren](std::size_t groupIdx)
+    {
+        auto first = static_cast<unsigned int>(groupIdx) * BoundsGroupSize;
+        auto last = std::min(first + BoundsGroupSize, nChildren);
+
+        Eigen::AlignedBox3d box;
+        for (unsigned int i = first; i < last; i++)
+        {
+            if (children[i]->includes(tdb))
+                box.extend(children[i]->body()->getAstrocentricPosition(tdb));
+        }
+
+        BoundsGroup& group = m_boundsGroups[groupIdx];
+        if (box.isEmpty())
+        {
+            group.radius = -1.0;
+            return;
+        }
+
+        group.center = box.center();
+        group.radius = 0.0;
+        for (unsigned int i = first; i < last; i++)
+        {
+            if (!children[i]->includes(tdb))
+                continue;
+
+            Eigen::Vector3d offset = children[i]->body()->getAstrocentricPosition(tdb) - group.center;
+            group.radius = std::max(group.radius, offset.norm() + m_childRadii[i]);
+        }
+    };
+
+    if (nChildren >= ParallelStateThreshold)
+    {
+        util::GetThreadPool()->parallelFor(m_boundsGroups.size(), updateGroup);
+    }
+    else
+    {
+        for (std::size_t i = 0; i < m_boundsGroups.size(); i++)
+            updateGroup(i);
+    }
+
+    m_boundsTdb = tdb;
+}
@@ -12,9 +12,14 @@
 
 #pragma once
 
+#include <cstdint>
+#include <limits>
 #include <memory>
 #include <vector>
 
+#include <Eigen/Core>
+
+#include <celutil/array_view.h>
 #include "body.h"
 
 class ReferenceFrame;
@@ -24,6 +29,21 @@ class TimelinePhase;
 class FrameTree //NOSONAR
 {
 public:
+    /*! Bounds of a run of BoundsGroupSize consecutive children at the time
+     *  of the last updateBodyStates: a sphere in astrocentric coordinates
+     *  which contains the bodies and their subtrees, so that the renderer
+     *  can reject the whole run with one test. The radius is negative when
+     *  none of the children are active.
+     */
+    struct BoundsGroup
+    {
+        Eigen::Vector3d center{ Eigen::Vector3d::Zero() };
+        double radius{ -1.0 };
+        bool containsSecondaryIlluminators{ false };
+    };
+
+    static constexpr unsigned int BoundsGroupSize = 64;
+
     explicit FrameTree(Star*);
     explicit FrameTree(Body*);
     ~FrameTree();
@@ -47,6 +67,19 @@ public:
     void markUpdated();
     void recomputeBoundingSphere();
 
+    void updateBodyStates(double tdb) const;
+
+    /*! Return the bounds of the groups of children at tdb, or an empty
+     *  view if they haven't been computed for tdb. Only trees with many
+     *  children are grouped.
+     */
+    celestia::util::array_view<BoundsGroup> getBoundsGroups(double tdb) const
+    {
+        if (tdb != m_boundsTdb)
+            return {};
+        return m_boundsGroups;
+    }
+
     bool isRoot() const
     {
         return bodyParent == nullptr;
@@ -89,14 +122,26 @@ public:
     }
 
 private:
+    void updateBodyStates(double tdb, const Star* star, const Eigen::Vector3d& center) const;
+    void updateBoundsGroups(double tdb) const;
+
     Star* starParent{ nullptr };
     Body* bodyParent{ nullptr };
     std::vector<std::shared_ptr<const TimelinePhase>> children;
+    // Radius of a sphere around each child which contains the body and its
+    // subtree, in the order of children
+    std::vector<double> m_childRadii;
+    mutable std::vector<BoundsGroup> m_boundsGroups;
+    mutable double m_boundsTdb{ std::numeric_limits<double>::quiet_NaN() };
 
     double m_boundingSphereRadius{ 0.0 };
     double m_maxChildRadius{ 0.0 };
     bool m_containsSecondaryIlluminators{ false };
     bool m_changed{ true };
+    // Time and ephemeris epoch of the last updateBodyStates, so that the
+    // views of a frame evaluate the tree only once
+    mutable double m_stateTdb{ std::numeric_limits<double>::quiet_NaN() };
+    mutable std::uint64_t m_stateEpoch{ 0 };
     BodyClassification m_childClassMask{ BodyClassification::EmptyMask };
 
     std::shared_ptr<const ReferenceFrame> defaultFrame;
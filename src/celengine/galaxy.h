@@ -84,13 +84,15 @@ public:
 
     float getBrightnessCorrection(const Eigen::Vector3f &) const;
 
+    // Use the custom template, relative to the resource directory, or the
+    // template of the galaxy type if empty; the type should be set first
+    void setForm(const fs::path&, const fs::path& = {});
+
 private:
     // TODO: This value is just a guess.
     // To be optimal, it should actually be computed:
     constexpr static float kRadiusCorrection = 0.025f;
 
-    void setForm(const fs::path&, const fs::path& = {});
-
     float       detail{ 1.0f };
     GalaxyType  type{ GalaxyType::Irr };
     int         form{ 0 };
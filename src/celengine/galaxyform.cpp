@@ -10,10 +10,15 @@
 
 #include <cassert>
 #include <memory>
+#include <random>
+
+#include <fmt/format.h>
 
 #include <celimage/image.h>
 #include <celmath/randutils.h>
 #include <celutil/logger.h>
+#include <celutil/threadpool.h>
+#include "formcache.h"
 #include "render.h"
 #include "texture.h"
 #include "galaxy.h"
@@ -25,8 +30,16 @@ namespace
 {
 constexpr unsigned int kIrrGalaxyPoints = 3500u;
 
-std::optional<celestia::engine::GalacticForm>
-buildGalacticForm(const fs::path& filename)
+// Bump when the generation of the forms changes, so that the forms cached
+// by an earlier version aren't used
+constexpr std::string_view kFormParameters = "galaxy 1";
+
+// Each form has its own generator, so that the forms are the same whatever
+// the order they are built in
+constexpr std::mt19937::result_type kFormSeed = 1312;
+
+std::optional<GalacticForm::BlobVector>
+generateGalacticForm(const fs::path& filename)
 {
     GalacticForm::Blob b;
     GalacticForm::BlobVector galacticPoints;
@@ -44,8 +57,7 @@ buildGalacticForm(const fs::path& filename)
     int height = img->getHeight();
     int rgb    = img->getComponents();
 
-    auto& rng = math::getRNG();
-    rng.seed(1312);
+    std::mt19937 rng(kFormSeed);
     for (int i = 0; i < width * height; i++)
     {
         std::uint8_t value = img->getPixels()[rgb * i];
@@ -106,19 +118,111 @@ buildGalacticForm(const fs::path& filename)
 
     // reshuffle the galaxy points randomly...except the first kmin+1 in the center!
     // the higher that number the stronger the central "glow"
-    std::shuffle(galacticPoints.begin() + kmin, galacticPoints.end(), math::getRNG());
+    std::shuffle(galacticPoints.begin() + kmin, galacticPoints.end(), rng);
 
-    std::optional<celestia::engine::GalacticForm> galacticForm(std::in_place);
-    galacticForm->blobs = std::move(galacticPoints);
+    return galacticPoints;
+}
+
+std::optional<GalacticForm>
+buildGalacticForm(const fs::path& filename)
+{
+    std::optional<GalacticForm> galacticForm(std::in_place);
     galacticForm->scale = Eigen::Vector3f::Ones();
 
+    // The template itself is hashed with the generation parameters, as the
+    // E0 template is sampled differently than the others
+    auto key = FormCache::computeKey(fmt::format("{}\n{}", kFormParameters, filename), filename);
+    if (key.has_value() && FormCache::load(*key, galacticForm->blobs))
+        return galacticForm;
+
+    auto blobs = generateGalacticForm(filename);
+    if (!blobs.has_value())
+        return std::nullopt;
+
+    galacticForm->blobs = std::move(*blobs);
+    if (key.has_value())
+        FormCache::save(*key, galacticForm->blobs);
+
     return galacticForm;
 }
 
+GalacticForm::BlobVector
+generateIrregularForm()
+{
+    unsigned int galaxySize = kIrrGalaxyPoints, ip = 0;
+    GalacticForm::Blob b;
+    Eigen::Vector3f p;
+
+    GalacticForm::BlobVector irregularPoints;
+    irregularPoints.reserve(galaxySize);
+
+    std::mt19937 rng(kFormSeed);
+    while (ip < galaxySize)
+    {
+        p = Eigen::Vector3f(math::RealDists<float>::SignedUnit(rng),
+                            math::RealDists<float>::SignedUnit(rng),
+                            math::RealDists<float>::SignedUnit(rng));
+        float r  = p.norm();
+        if (r < 1)
+        {
+            Eigen::Vector3f p1(p.array() + 5.0f);
+            float prob = (1.0f - r) * (math::fractalsum(p1, 8.0f) + 1.0f) * 0.5f;
+            if (math::RealDists<float>::Unit(rng) < prob)
+            {
+                b.position   = p;
+                b.brightness = std::uint8_t(64);
+                b.colorIndex = static_cast<std::uint8_t>(std::min(r * 511.0f, 255.0f));
+                irregularPoints.push_back(b);
+                ++ip;
+            }
+        }
+    }
+
+    return irregularPoints;
+}
+
+std::optional<GalacticForm>
+buildIrregularForm()
+{
+    std::optional<GalacticForm> irregularForm(std::in_place);
+    irregularForm->scale = Eigen::Vector3f::Constant(0.5f);
+
+    // The noise the form is sampled from is seeded at random for each run,
+    // so the cached form keeps the irregular galaxies the same across runs
+    auto key = FormCache::computeKey(fmt::format("{}\nirregular\n{}", kFormParameters, kIrrGalaxyPoints));
+    if (!FormCache::load(key, irregularForm->blobs))
+    {
+        irregularForm->blobs = generateIrregularForm();
+        FormCache::save(key, irregularForm->blobs);
+    }
+
+    return irregularForm;
+}
+
+// Elliptical Galaxies , 8 classical Hubble types, E0..E7,
+//
+// To save space: generate spherical E0 template from S0 disk
+// via rescaling by (1.0f, 3.8f, 1.0f).
+std::optional<GalacticForm>
+buildEllipticalForm()
+{
+    auto ellipticalForm = buildGalacticForm("models/E0.png");
+    if (ellipticalForm.has_value())
+    {
+        for (auto& blob : ellipticalForm->blobs)
+        {
+            blob.colorIndex = static_cast<std::uint8_t>(std::ceil(0.76f * static_cast<float>(blob.colorIndex)));
+        }
+    }
+
+    return ellipticalForm;
+}
+
 } // anonymous namespace
 
 GalacticFormManager::GalacticFormManager()
 {
+    galacticForms.reserve(GalacticFormsReserve);
     initializeStandardForms();
 }
 
@@ -126,8 +230,10 @@ const GalacticForm*
 GalacticFormManager::getForm(int form) const
 {
     assert(form < static_cast<int>(galacticForms.size()));
-    return galacticForms[form].has_value()
-        ? &*galacticForms[form]
+    Entry& entry = *galacticForms[form];
+    std::call_once(entry.built, [&entry] { entry.form = entry.build(); });
+    return entry.form.has_value()
+        ? &*entry.form
         : nullptr;
 }
 
@@ -141,7 +247,7 @@ GalacticFormManager::getCustomForm(const fs::path& path)
 
     auto result = static_cast<int>(galacticForms.size());
     customForms[path] = result;
-    galacticForms.push_back(buildGalacticForm(path));
+    addForm([path] { return buildGalacticForm(path); });
     return result;
 }
 
@@ -151,76 +257,52 @@ GalacticFormManager::getCount() const
     return static_cast<int>(galacticForms.size());
 }
 
+void
+GalacticFormManager::buildForms() const
+{
+    // The elliptical forms wait for the E0 form they are copied from, which
+    // is built by the first of them to need it
+    util::GetThreadPool()->parallelFor(galacticForms.size(),
+                                       [this](std::size_t i) { getForm(static_cast<int>(i)); });
+}
+
+void
+GalacticFormManager::addForm(std::function<std::optional<GalacticForm>()>&& build)
+{
+    auto& entry = galacticForms.emplace_back(std::make_unique<Entry>());
+    entry->build = std::move(build);
+}
+
 void
 GalacticFormManager::initializeStandardForms()
 {
     // Irregular Galaxies
-    unsigned int galaxySize = kIrrGalaxyPoints, ip = 0;
-    GalacticForm::Blob b;
-    Eigen::Vector3f p;
-
-    GalacticForm::BlobVector irregularPoints;
-    irregularPoints.reserve(galaxySize);
+    addForm(buildIrregularForm);
 
-    auto& rng = math::getRNG();
-    while (ip < galaxySize)
+    // Spiral Galaxies, 7 classical Hubble types
+    for (const char* filename : { "models/S0.png", "models/Sa.png", "models/Sb.png", "models/Sc.png",
+                                  "models/SBa.png", "models/SBb.png", "models/SBc.png" })
     {
-        p = Eigen::Vector3f(math::RealDists<float>::SignedUnit(rng),
-                            math::RealDists<float>::SignedUnit(rng),
-                            math::RealDists<float>::SignedUnit(rng));
-        float r  = p.norm();
-        if (r < 1)
-        {
-            Eigen::Vector3f p1(p.array() + 5.0f);
-            float prob = (1.0f - r) * (math::fractalsum(p1, 8.0f) + 1.0f) * 0.5f;
-            if (math::RealDists<float>::Unit(rng) < prob)
-            {
-                b.position   = p;
-                b.brightness = std::uint8_t(64);
-                b.colorIndex = static_cast<std::uint8_t>(std::min(r * 511.0f, 255.0f));
-                irregularPoints.push_back(b);
-                ++ip;
-            }
-        }
+        addForm([filename] { return buildGalacticForm(filename); });
     }
 
-    auto& irregularForm = galacticForms.emplace_back(std::in_place);
-    irregularForm->blobs = std::move(irregularPoints);
-    irregularForm->scale = Eigen::Vector3f::Constant(0.5f);
-
-    // Spiral Galaxies, 7 classical Hubble types
-
-    galacticForms.push_back(buildGalacticForm("models/S0.png"));
-    galacticForms.push_back(buildGalacticForm("models/Sa.png"));
-    galacticForms.push_back(buildGalacticForm("models/Sb.png"));
-    galacticForms.push_back(buildGalacticForm("models/Sc.png"));
-    galacticForms.push_back(buildGalacticForm("models/SBa.png"));
-    galacticForms.push_back(buildGalacticForm("models/SBb.png"));
-    galacticForms.push_back(buildGalacticForm("models/SBc.png"));
-
-    // Elliptical Galaxies , 8 classical Hubble types, E0..E7,
-    //
-    // To save space: generate spherical E0 template from S0 disk
-    // via rescaling by (1.0f, 3.8f, 1.0f).
-
-    for (unsigned int eform = 0; eform <= 7; ++eform)
+    // Elliptical Galaxies, all 8 are E0 rescaled
+    auto e0 = static_cast<int>(galacticForms.size());
+    addForm(buildEllipticalForm);
+    for (unsigned int eform = 1; eform <= 7; ++eform)
     {
         float ell = 1.0f - static_cast<float>(eform) / 8.0f;
-
-        // note the correct x,y-alignment of 'ell' scaling!!
-        // build all elliptical templates from rescaling E0
-        auto ellipticalForm = buildGalacticForm("models/E0.png");
-        if (ellipticalForm.has_value())
+        addForm([this, e0, ell]
         {
-            ellipticalForm->scale = Eigen::Vector3f(ell, ell, 1.0f);
-
-            for (auto& blob : ellipticalForm->blobs)
-            {
-                blob.colorIndex = static_cast<std::uint8_t>(std::ceil(0.76f * static_cast<float>(blob.colorIndex)));
-            }
-        }
+            const GalacticForm* e0Form = getForm(e0);
+            if (e0Form == nullptr)
+                return std::optional<GalacticForm>();
 
-        galacticForms.push_back(std::move(ellipticalForm));
+            // note the correct x,y-alignment of 'ell' scaling!!
+            std::optional<GalacticForm> ellipticalForm(*e0Form);
+            ellipticalForm->scale = Eigen::Vector3f(ell, ell, 1.0f);
+            return ellipticalForm;
+        });
     }
 }
 
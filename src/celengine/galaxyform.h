@@ -11,7 +11,10 @@
 #pragma once
 
 #include <cstdint>
+#include <functional>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <optional>
 #include <type_traits> // std::is_standard_layout_v<>
 #include <vector>
@@ -40,6 +43,8 @@ public:
     Eigen::Vector3f scale;
 };
 
+// Forms are generated when they are first needed, or loaded from the form
+// cache if an earlier run generated them.
 class GalacticFormManager
 {
 public:
@@ -47,17 +52,30 @@ public:
 
     static GalacticFormManager* get();
 
+    // Returns nullptr if the form couldn't be built
     const GalacticForm* getForm(int) const;
     int getCustomForm(const fs::path& path);
 
     int getCount() const;
 
+    // Build all the forms not built yet in parallel, before a caller which
+    // needs all of them goes through them one by one
+    void buildForms() const;
+
 private:
+    struct Entry
+    {
+        std::function<std::optional<GalacticForm>()> build;
+        std::once_flag built;
+        std::optional<GalacticForm> form;
+    };
+
     void initializeStandardForms();
+    void addForm(std::function<std::optional<GalacticForm>()>&&);
 
     static constexpr std::size_t GalacticFormsReserve = 32;
 
-    std::vector<std::optional<GalacticForm>> galacticForms{ };
+    std::vector<std::unique_ptr<Entry>> galacticForms{ };
     std::map<fs::path, int> customForms{ };
 };
 
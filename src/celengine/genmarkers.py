@@ -125,7 +125,7 @@ result = []
 offset = 0
 for m in filledMarkers:
     offsets.append(offset)
-    count = len(m) / 2
+    count = len(m) // 2
     counts.append(count)
     offset += count
     result += m
@@ -145,7 +145,7 @@ print("constexpr std::array<float, {}> FilledMarkersData = {{".format(len(result
 i = 0
 n = 0
 while i < len(result):
-    if n < len(offsets) and i / 2 == offsets[n]:
+    if n < len(offsets) and i // 2 == offsets[n]:
         print("    // {}".format(list(FilledMarkers)[n].name))
         n += 1
     print("    {: f}f, {: f}f{}".format(result[i], result[i+1], ',' if i < len(result) - 2 else ''))
@@ -188,6 +188,9 @@ print("constexpr int SelPointerOffset = {};".format(offsets[FilledMarkers.SelPoi
 print("constexpr int CrosshairCount   = {};".format(counts[FilledMarkers.Crosshair.value]))
 print("constexpr int CrosshairOffset  = {};".format(offsets[FilledMarkers.Crosshair.value]))
 
+filledOffsets = offsets
+filledCounts = counts
+
 ### Markers drawn with lines
 
 class HollowMarkers(Enum):
@@ -234,7 +237,7 @@ result = []
 offset = 0
 for m in hollowMarkers:
     offsets.append(offset)
-    count = len(m) / 2
+    count = len(m) // 2
     counts.append(count)
     offset += count
     result += m
@@ -257,7 +260,7 @@ print("constexpr std::array<float, {}> HollowMarkersData = {{".format(len(result
 i = 0
 n = 0
 while i < len(result):
-    if n < len(offsets) and i / 2 == offsets[n]:
+    if n < len(offsets) and i // 2 == offsets[n]:
         print("    // {}".format(list(HollowMarkers)[n].name))
         n += 1
     print("    {: f}f, {: f}f{}".format(result[i], result[i+1], ',' if i < len(result) - 2 else ''))
@@ -285,3 +288,39 @@ print("        break;")
 print("    }")
 print("    lr.finish();")
 print("}")
+
+print("\n// Vertex range of the symbol drawn for a marker, for drawing the markers")
+print("// with the same symbol at once\n")
+print("struct MarkerRange")
+print("{")
+print("    bool filled;")
+print("    gl::VertexObject::Primitive primitive;")
+print("    int count;")
+print("    int first;")
+print("};")
+
+print("\nMarkerRange\nGetMarkerRange(MarkerRepresentation::Symbol symbol, float size)")
+print("{")
+print("    switch (symbol)")
+print("    {")
+for i in FilledMarkers:
+    if not i.name in ['Disk', 'LargeDisk', 'SelPointer', 'Crosshair']:
+        prim = 'TriangleFan' if i.name  == 'FilledSquare' else 'Triangles'
+        print("    case MarkerRepresentation::{}:".format(i.name))
+        print("        return {{ true, gl::VertexObject::Primitive::{}, {}, {} }};".format(prim, int(filledCounts[i.value]), int(filledOffsets[i.value])))
+print("    case MarkerRepresentation::Disk:")
+print("        if (size <= 40.0f) // TODO: this should be configurable")
+print("            return {{ true, gl::VertexObject::Primitive::TriangleFan, {}, {} }};".format(int(filledCounts[FilledMarkers.Disk.value]), int(filledOffsets[FilledMarkers.Disk.value])))
+print("        return {{ true, gl::VertexObject::Primitive::TriangleFan, {}, {} }};".format(int(filledCounts[FilledMarkers.LargeDisk.value]), int(filledOffsets[FilledMarkers.LargeDisk.value])))
+for i in HollowMarkers:
+    if i.name != 'Circle' and i.name != 'LargeCircle':
+        print("    case MarkerRepresentation::{}:".format(i.name))
+        print("        return {{ false, gl::VertexObject::Primitive::Lines, {}, {} }};".format(int(counts[i.value]), int(offsets[i.value])))
+print("    case MarkerRepresentation::Circle:")
+print("        if (size <= 40.0f) // TODO: this should be configurable")
+print("            return {{ false, gl::VertexObject::Primitive::Lines, {}, {} }};".format(int(counts[HollowMarkers.Circle.value]), int(offsets[HollowMarkers.Circle.value])))
+print("        return {{ false, gl::VertexObject::Primitive::Lines, {}, {} }};".format(int(counts[HollowMarkers.LargeCircle.value]), int(offsets[HollowMarkers.LargeCircle.value])))
+print("    default:")
+print("        return { false, gl::VertexObject::Primitive::Lines, 0, 0 };")
+print("    }")
+print("}")
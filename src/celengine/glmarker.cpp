@@ -8,9 +8,11 @@
 // as published by the Free Software Foundation; either version 2
 // of the License, or (at your option) any later version.
 
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <cstddef>
+#include <tuple>
 
 #include <celcompat/numbers.h>
 #include <celmath/frustum.h>
@@ -19,6 +21,8 @@
 #include <celrender/gl/buffer.h>
 #include <celrender/gl/vertexobject.h>
 #include <celrender/linerenderer.h>
+#include <celutil/flag.h>
+#include "glsupport.h"
 #include "marker.h"
 #include "observer.h"
 #include "render.h"
@@ -52,6 +56,47 @@ initialize(LineRenderer &lr, gl::VertexObject &vo, gl::Buffer &bo)
         lr.addVertex(HollowMarkersData[i], HollowMarkersData[i+1]);
 }
 
+// Width of the lines of the hollow markers, as drawn by the line renderer
+float
+markerLineWidth(const Renderer &r)
+{
+    float width = util::is_set(r.getRenderFlags(), RenderFlags::ShowSmoothLines) ? 1.5f : 1.0f;
+    return width * r.getScaleFactor();
+}
+
+void
+addMarkerInstanceBuffers(gl::VertexObject &vo, const gl::Buffer &vertices, const gl::Buffer &instances)
+{
+    vo.addVertexBuffer(
+        vertices,
+        CelestiaGLProgram::VertexCoordAttributeIndex,
+        2,
+        gl::VertexObject::DataType::Float);
+    vo.addInstanceBuffer(
+        instances,
+        CelestiaGLProgram::TextureCoord0AttributeIndex,
+        4,
+        gl::VertexObject::DataType::Float,
+        false,
+        sizeof(Renderer::MarkerInstance),
+        offsetof(Renderer::MarkerInstance, position));
+    vo.addInstanceBuffer(
+        instances,
+        CelestiaGLProgram::ColorAttributeIndex,
+        4,
+        gl::VertexObject::DataType::UnsignedByte,
+        true,
+        sizeof(Renderer::MarkerInstance),
+        offsetof(Renderer::MarkerInstance, color));
+}
+
+auto
+markerBatchKey(const Renderer::MarkerInstance &instance)
+{
+    MarkerRange range = GetMarkerRange(instance.symbol, instance.size);
+    return std::make_tuple(range.filled, range.first);
+}
+
 }
 
 void
@@ -94,6 +139,106 @@ Renderer::renderMarker(MarkerRepresentation::Symbol symbol,
     }
 }
 
+/*! Queue a marker to be drawn by renderMarkerInstances with the other
+ *  markers of its symbol, at position in pixels with the identity model
+ *  view matrix. Return false if the marker must be drawn by renderMarker,
+ *  as instanced drawing isn't supported for the symbol.
+ */
+bool
+Renderer::addMarkerInstance(MarkerRepresentation::Symbol symbol,
+                            float size,
+                            const Color &color,
+                            const Eigen::Vector3f &position)
+{
+    if (!m_markerInstancesInitialized)
+    {
+        m_markerInstancesInitialized = true;
+        if (!gl::hasInstancing() || shaderManager->getShader("marker") == nullptr)
+            return false;
+
+        if (!m_markerDataInitialized)
+        {
+            initialize(*m_hollowMarkerRenderer, *m_markerVO, *m_markerBO);
+            m_markerDataInitialized = true;
+        }
+
+        m_markerInstanceBO = std::make_unique<gl::Buffer>(gl::Buffer::TargetHint::Array);
+        m_hollowMarkerBO = std::make_unique<gl::Buffer>(gl::Buffer::TargetHint::Array, HollowMarkersData);
+        m_filledMarkerInstanceVO = std::make_unique<gl::VertexObject>();
+        addMarkerInstanceBuffers(*m_filledMarkerInstanceVO, *m_markerBO, *m_markerInstanceBO);
+        m_hollowMarkerInstanceVO = std::make_unique<gl::VertexObject>(gl::VertexObject::Primitive::Lines);
+        addMarkerInstanceBuffers(*m_hollowMarkerInstanceVO, *m_hollowMarkerBO, *m_markerInstanceBO);
+        m_hollowMarkerBO->unbind();
+    }
+
+    if (m_filledMarkerInstanceVO == nullptr)
+        return false;
+
+    MarkerRange range = GetMarkerRange(symbol, size);
+    if (range.count == 0)
+        return false;
+
+    // Lines wider than the driver supports are drawn as triangles by the
+    // line renderer
+    if (!range.filled && markerLineWidth(*this) > gl::maxLineWidth)
+        return false;
+
+    float s = size / 2.0f * getScaleFactor();
+    m_markerInstances.push_back({ Eigen::Vector4f(position.x(), position.y(), position.z(), s), color, symbol, size });
+    return true;
+}
+
+/*! Draw the markers queued by addMarkerInstance, with one call for each
+ *  symbol.
+ */
+void
+Renderer::renderMarkerInstances()
+{
+    if (m_markerInstances.empty())
+        return;
+
+    auto* prog = shaderManager->getShader("marker");
+    if (prog == nullptr)
+    {
+        m_markerInstances.clear();
+        return;
+    }
+
+    // The markers of a symbol are drawn in the order they were queued
+    std::stable_sort(m_markerInstances.begin(), m_markerInstances.end(),
+                     [](const MarkerInstance &a, const MarkerInstance &b)
+                     {
+                         return markerBatchKey(a) < markerBatchKey(b);
+                     });
+
+    prog->use();
+    prog->setMVPMatrices(m_orthoProjMatrix);
+
+    for (auto first = m_markerInstances.begin(); first != m_markerInstances.end();)
+    {
+        auto key = markerBatchKey(*first);
+        auto last = std::find_if(first, m_markerInstances.end(),
+                                 [&key](const MarkerInstance &instance)
+                                 {
+                                     return markerBatchKey(instance) != key;
+                                 });
+        auto count = static_cast<int>(last - first);
+
+        MarkerRange range = GetMarkerRange(first->symbol, first->size);
+        m_markerInstanceBO->setData(util::array_view<const void>(&*first, sizeof(MarkerInstance) * count),
+                                    gl::Buffer::BufferUsage::StreamDraw);
+        gl::VertexObject &vo = range.filled ? *m_filledMarkerInstanceVO : *m_hollowMarkerInstanceVO;
+        if (!range.filled)
+            glLineWidth(markerLineWidth(*this));
+        vo.setPrimitive(range.primitive);
+        vo.drawInstanced(range.count, count, range.first);
+
+        first = last;
+    }
+
+    m_markerInstances.clear();
+}
+
 /*! Draw an arrow at the view border pointing to an offscreen selection. This method
  *  should only be called when the selection lies outside the view frustum.
  */
@@ -104,19 +104,18 @@ bool Globular::load(const util::AssociativeArray* params, const fs::path& resPat
     if (auto detailVal = params->getNumber<float>("Detail"); detailVal.has_value())
         detail = *detailVal;
 
-    if (auto coreRadius = params->getAngle<float>("CoreRadius", 1.0 / astro::MINUTES_PER_DEG);
-        coreRadius.has_value())
-    {
-        r_c = *coreRadius;
-    }
+    setStructure(params->getAngle<float>("CoreRadius", 1.0 / astro::MINUTES_PER_DEG).value_or(r_c),
+                 params->getNumber<float>("KingConcentration").value_or(c));
 
-    if (auto king = params->getNumber<float>("KingConcentration"); king.has_value())
-        c = *king;
+    return true;
+}
 
+void Globular::setStructure(float coreRadius, float kingConcentration)
+{
+    r_c = coreRadius;
+    c = kingConcentration;
     formIndex = cSlot(c);
     recomputeTidalRadius();
-
-    return true;
 }
 
 RenderFlags Globular::getRenderMask() const
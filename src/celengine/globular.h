@@ -65,6 +65,13 @@ public:
 
     int getFormId() const;
 
+    // Core radius in arcminutes
+    float getCoreRadius() const { return r_c; }
+    float getKingConcentration() const { return c; }
+    // The tidal radius depends on the distance, so the position should be
+    // set first
+    void setStructure(float coreRadius, float kingConcentration);
+
 private:
     // Reference values ( = data base averages) of core radius, King concentration
     static constexpr float R_c_ref = 0.83f;
@@ -8,6 +8,7 @@
 // of the License, or (at your option) any later version.
 
 #include <celutil/logger.h>
+#include "framestats.h"
 #include "glshader.h"
 
 using celestia::util::GetLogger;
@@ -80,6 +81,20 @@ GLShader::compile(const std::vector<std::string>& source)
     if (source.empty())
         return GLShaderStatus::EmptyProgram;
 
+    startCompile(source);
+
+    GLint compileSuccess;
+    glGetShaderiv(id, GL_COMPILE_STATUS, &compileSuccess);
+    if (compileSuccess != GL_TRUE)
+        return GLShaderStatus::CompileError;
+
+    return GLShaderStatus::OK;
+}
+
+
+void
+GLShader::startCompile(const std::vector<std::string>& source)
+{
     // Convert vector of shader source strings to an array for OpenGL
     const auto** sourceStrings = new const char*[source.size()];
     for (unsigned int i = 0; i < source.size(); i++)
@@ -91,13 +106,6 @@ GLShader::compile(const std::vector<std::string>& source)
 
     // Actually compile the shader
     glCompileShader(id);
-
-    GLint compileSuccess;
-    glGetShaderiv(id, GL_COMPILE_STATUS, &compileSuccess);
-    if (compileSuccess != GL_TRUE)
-        return GLShaderStatus::CompileError;
-
-    return GLShaderStatus::OK;
 }
 
 
@@ -238,9 +246,35 @@ GLProgram::attach(const GLShader& shader)
 
 GLShaderStatus
 GLProgram::link()
+{
+    startLink();
+    return finishLink();
+}
+
+
+void
+GLProgram::startLink()
 {
     glLinkProgram(id);
+    ++celestia::engine::GetFrameStats()->current().shaderCompiles;
+}
+
+
+bool
+GLProgram::isLinkComplete() const
+{
+    if (!celestia::gl::KHR_parallel_shader_compile)
+        return true;
+
+    GLint complete = GL_FALSE;
+    glGetProgramiv(id, GL_COMPLETION_STATUS_KHR, &complete);
+    return complete == GL_TRUE;
+}
 
+
+GLShaderStatus
+GLProgram::finishLink()
+{
     GLint linkSuccess;
     glGetProgramiv(id, GL_LINK_STATUS, &linkSuccess);
     if (linkSuccess != GL_TRUE)
@@ -257,6 +291,25 @@ GLProgram::link()
 }
 
 
+bool
+GLProgram::getBinary(GLenum& format, std::vector<char>& binary) const
+{
+    GLint length = 0;
+    glGetProgramiv(id, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return false;
+
+    binary.resize(static_cast<std::size_t>(length));
+    GLsizei written = 0;
+    glGetProgramBinary(id, length, &written, &format, binary.data());
+    if (written <= 0)
+        return false;
+
+    binary.resize(static_cast<std::size_t>(written));
+    return true;
+}
+
+
 //************* GLShaderLoader ************
 
 GLShaderStatus
@@ -505,3 +558,65 @@ GLShaderLoader::CreateProgram(const std::string& vsSource,
 
     return CreateProgram(vsSourceVec, gsSourceVec, fsSourceVec, progOut);
 }
+
+
+GLShaderStatus
+GLShaderLoader::StartProgram(const std::string& vsSource,
+                             const std::string& gsSource,
+                             const std::string& fsSource,
+                             GLProgram** progOut)
+{
+    if (vsSource.empty() || fsSource.empty())
+        return GLShaderStatus::EmptyProgram;
+
+    auto* prog = new GLProgram(glCreateProgram());
+
+    // The shaders are only flagged for deletion while they are attached
+    GLVertexShader vs(glCreateShader(GL_VERTEX_SHADER));
+    vs.startCompile({ vsSource });
+    prog->attach(vs);
+
+    if (!gsSource.empty())
+    {
+        GLGeometryShader gs(glCreateShader(GL_GEOMETRY_SHADER));
+        gs.startCompile({ gsSource });
+        prog->attach(gs);
+    }
+
+    GLFragmentShader fs(glCreateShader(GL_FRAGMENT_SHADER));
+    fs.startCompile({ fsSource });
+    prog->attach(fs);
+
+    *progOut = prog;
+
+    return GLShaderStatus::OK;
+}
+
+
+GLShaderStatus
+GLShaderLoader::CreateProgram(GLenum binaryFormat,
+                              const std::vector<char>& binary,
+                              GLProgram** progOut)
+{
+    if (binary.empty())
+        return GLShaderStatus::EmptyProgram;
+
+    GLuint progid = glCreateProgram();
+
+    auto* prog = new GLProgram(progid);
+
+    glProgramBinary(progid, binaryFormat, binary.data(), static_cast<GLsizei>(binary.size()));
+
+    // Binaries are rejected after a driver update, which is not an error
+    GLint linkSuccess;
+    glGetProgramiv(progid, GL_LINK_STATUS, &linkSuccess);
+    if (linkSuccess != GL_TRUE)
+    {
+        delete prog;
+        return GLShaderStatus::LinkError;
+    }
+
+    *progOut = prog;
+
+    return GLShaderStatus::OK;
+}
@@ -41,6 +41,8 @@ class GLShader
     GLuint id;
 
     GLShaderStatus compile(const std::vector<std::string>& source);
+    // Submit the source without waiting for the result
+    void startCompile(const std::vector<std::string>& source);
 
     friend class GLShaderLoader;
 };
@@ -85,9 +87,20 @@ class GLProgram
 
     GLShaderStatus link();
 
+    // link() in two steps: startLink returns without waiting for the
+    // driver, and finishLink blocks until the program is linked.
+    // isLinkComplete can be polled in between with parallel shader compile.
+    void startLink();
+    bool isLinkComplete() const;
+    GLShaderStatus finishLink();
+
     void use() const;
     GLuint getID() const { return id; }
 
+    // Retrieve the binary of a linked program. Returns false if the driver
+    // doesn't provide one.
+    bool getBinary(GLenum& format, std::vector<char>& binary) const;
+
  private:
     GLuint id;
 
@@ -222,6 +235,18 @@ class GLShaderLoader
                                         const std::string& fsSource,
                                         const std::string& gsSource,
                                         GLProgram**);
+    // Create an unlinked program whose shaders are still being compiled.
+    // Compile errors are reported when the program is linked. An empty
+    // geometry shader source creates a program without one.
+    static GLShaderStatus StartProgram(const std::string& vsSource,
+                                       const std::string& gsSource,
+                                       const std::string& fsSource,
+                                       GLProgram**);
+    // Create a linked program from a binary retrieved with getBinary,
+    // which may be rejected by the driver
+    static GLShaderStatus CreateProgram(GLenum binaryFormat,
+                                        const std::vector<char>& binary,
+                                        GLProgram**);
 };
 
 
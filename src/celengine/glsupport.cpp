@@ -14,11 +14,19 @@ CELAPI bool OES_geometry_shader            = false;
 #else
 CELAPI bool ARB_vertex_array_object        = false;
 CELAPI bool ARB_framebuffer_object         = false;
+CELAPI bool ARB_buffer_storage             = false;
+CELAPI bool ARB_sync                       = false;
+CELAPI bool ARB_clip_control               = false;
+CELAPI bool ARB_get_program_binary         = false;
+CELAPI bool ARB_timer_query                = false;
+CELAPI bool ARB_direct_state_access        = false;
+CELAPI bool ARB_base_instance              = false;
 #endif
 CELAPI bool ARB_shader_texture_lod         = false;
 CELAPI bool EXT_texture_compression_s3tc   = false;
 CELAPI bool EXT_texture_filter_anisotropic = false;
 CELAPI bool MESA_pack_invert               = false;
+CELAPI bool KHR_parallel_shader_compile    = false;
 CELAPI GLint maxPointSize                  = 0;
 CELAPI GLint maxTextureSize                = 0;
 CELAPI GLfloat maxLineWidth                = 0.0f;
@@ -83,6 +91,13 @@ bool init(util::array_view<std::string> ignore) noexcept
     OES_geometry_shader            = check_extension(ignore, "GL_OES_geometry_shader") || check_extension(ignore, "GL_EXT_geometry_shader");
 #else
     ARB_vertex_array_object        = check_extension(ignore, "GL_ARB_vertex_array_object");
+    ARB_buffer_storage             = check_extension(ignore, "GL_ARB_buffer_storage");
+    ARB_sync                       = check_extension(ignore, "GL_ARB_sync");
+    ARB_clip_control               = check_extension(ignore, "GL_ARB_clip_control");
+    ARB_get_program_binary         = check_extension(ignore, "GL_ARB_get_program_binary");
+    ARB_timer_query                = check_extension(ignore, "GL_ARB_timer_query");
+    ARB_direct_state_access        = check_extension(ignore, "GL_ARB_direct_state_access");
+    ARB_base_instance              = check_extension(ignore, "GL_ARB_base_instance");
     if (!has_extension("GL_ARB_framebuffer_object"))
     {
         fmt::print("{}", _("Mandatory extension GL_ARB_framebuffer_object is missing!\n"));
@@ -93,6 +108,7 @@ bool init(util::array_view<std::string> ignore) noexcept
     EXT_texture_compression_s3tc   = check_extension(ignore, "GL_EXT_texture_compression_s3tc");
     EXT_texture_filter_anisotropic = check_extension(ignore, "GL_EXT_texture_filter_anisotropic") || check_extension(ignore, "GL_ARB_texture_filter_anisotropic");
     MESA_pack_invert               = check_extension(ignore, "GL_MESA_pack_invert");
+    KHR_parallel_shader_compile    = check_extension(ignore, "GL_KHR_parallel_shader_compile");
 
     GLint pointSizeRange[2];
     GLfloat lineWidthRange[2];
@@ -133,6 +149,24 @@ bool hasGeomShader() noexcept
 #endif
 }
 
+bool hasInstancing() noexcept
+{
+#ifdef GL_ES
+    return checkVersion(celestia::gl::GLES_3_0);
+#else
+    return checkVersion(celestia::gl::GL_3_3);
+#endif
+}
+
+bool hasDirectStateAccess() noexcept
+{
+#ifdef GL_ES
+    return false;
+#else
+    return ARB_direct_state_access && ARB_buffer_storage && ARB_vertex_array_object;
+#endif
+}
+
 void enableGeomShaders() noexcept
 {
     EnableGeomShaders = true;
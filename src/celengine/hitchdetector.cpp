@@ -0,0 +1,123 @@
+// hitchdetector.cpp
+//
+// Copyright (C) 2026, Celestia Development Team
+//
+// Frames which took too long, and the work which made them slow.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include "hitchdetector.h"
+
+#include <algorithm>
+#include <numeric>
+
+#include <celutil/logger.h>
+
+using celestia::util::GetLogger;
+
+namespace celestia::engine
+{
+
+namespace
+{
+
+// Zones logged for each hitch
+constexpr std::size_t LoggedZones = 3;
+
+} // end unnamed namespace
+
+HitchDetector::HitchDetector(double threshold) :
+    m_threshold(threshold)
+{
+}
+
+const Hitch*
+HitchDetector::check(const FrameCounters& counters)
+{
+    double time = std::accumulate(counters.stageTimes.begin(), counters.stageTimes.end(), 0.0);
+    if (m_threshold <= 0.0 || time < m_threshold)
+        return nullptr;
+
+    ++m_hitchCount;
+    if (m_recent.size() == MaxRecentHitches)
+        m_recent.pop_front();
+
+    Hitch& hitch = m_recent.emplace_back();
+    hitch.frame = counters.frame;
+    hitch.time = time;
+    auto slowest = std::max_element(counters.stageTimes.begin(), counters.stageTimes.end());
+    hitch.stage = static_cast<FrameStage>(slowest - counters.stageTimes.begin());
+    hitch.zones = counters.zones;
+    std::stable_sort(hitch.zones.begin(), hitch.zones.end(),
+                     [](const FrameZoneTime& a, const FrameZoneTime& b) { return a.time > b.time; });
+
+    // Zones may be nested, as a script can load a texture, so the time
+    // they explain is only an estimate
+    double explained = 0.0;
+    for (const FrameZoneTime& zone : hitch.zones)
+    {
+        addCause(GetFrameZoneName(zone.zone), zone.name, zone.time);
+        explained += zone.time;
+    }
+
+    if (explained < time * 0.5)
+        addCause("stage", GetFrameStageName(hitch.stage), time - explained);
+
+    return &hitch;
+}
+
+std::vector<HitchCause>
+HitchDetector::getTopCauses(std::size_t count) const
+{
+    std::vector<HitchCause> causes;
+    causes.reserve(m_causes.size());
+    for (const auto& [key, cause] : m_causes)
+        causes.push_back(cause);
+
+    std::stable_sort(causes.begin(), causes.end(),
+                     [](const HitchCause& a, const HitchCause& b) { return a.totalTime > b.totalTime; });
+    if (causes.size() > count)
+        causes.resize(count);
+    return causes;
+}
+
+void
+HitchDetector::reset()
+{
+    m_hitchCount = 0;
+    m_recent.clear();
+    m_causes.clear();
+}
+
+void
+HitchDetector::log(const Hitch& hitch)
+{
+    GetLogger()->warn("Frame {} took {:.1f} ms, mostly in {}\n",
+                      hitch.frame, hitch.time, GetFrameStageName(hitch.stage));
+    for (std::size_t i = 0; i < std::min(hitch.zones.size(), LoggedZones); ++i)
+    {
+        const FrameZoneTime& zone = hitch.zones[i];
+        GetLogger()->warn("  {:<8} {:>8.1f} ms  {}\n", GetFrameZoneName(zone.zone), zone.time, zone.name);
+    }
+}
+
+void
+HitchDetector::addCause(std::string_view category, std::string_view name, double time)
+{
+    auto [it, inserted] = m_causes.try_emplace({ std::string(category), std::string(name) });
+    HitchCause& cause = it->second;
+    if (inserted)
+    {
+        cause.category = category;
+        cause.name = name;
+    }
+
+    ++cause.count;
+    cause.totalTime += time;
+    cause.maxTime = std::max(cause.maxTime, time);
+}
+
+} // end namespace celestia::engine
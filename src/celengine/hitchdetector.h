@@ -0,0 +1,87 @@
+// hitchdetector.h
+//
+// Copyright (C) 2026, Celestia Development Team
+//
+// Frames which took too long, and the work which made them slow.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "framestats.h"
+
+namespace celestia::engine
+{
+
+struct Hitch
+{
+    std::uint64_t frame{ 0 };
+    // Milliseconds of CPU time spent by the stages of the frame
+    double time{ 0.0 };
+    // The stage which took the most time
+    FrameStage stage{ FrameStage::Simulation };
+    // The zones recorded in the frame, slowest first
+    std::vector<FrameZoneTime> zones;
+};
+
+// Work which made frames slow over the session. The time of a hitch which
+// isn't explained by its zones is attributed to its slowest stage, with
+// the category "stage".
+struct HitchCause
+{
+    std::string category;
+    std::string name;
+    std::uint32_t count{ 0 };
+    // Milliseconds
+    double totalTime{ 0.0 };
+    double maxTime{ 0.0 };
+};
+
+// Flags the frames whose stages took longer than a threshold
+class HitchDetector
+{
+public:
+    static constexpr std::size_t MaxRecentHitches = 32;
+
+    // Threshold in milliseconds
+    explicit HitchDetector(double threshold);
+
+    double getThreshold() const { return m_threshold; }
+    void setThreshold(double threshold) { m_threshold = threshold; }
+
+    // Check a complete frame; returns the hitch if the frame was one
+    const Hitch* check(const FrameCounters&);
+
+    std::uint32_t getHitchCount() const { return m_hitchCount; }
+    // The last hitches, oldest first
+    const std::deque<Hitch>& getRecentHitches() const { return m_recent; }
+    // The causes which took the most time in total, at most count of them
+    std::vector<HitchCause> getTopCauses(std::size_t count) const;
+
+    void reset();
+
+    // Write a hitch and its slowest zones to the log
+    static void log(const Hitch&);
+
+private:
+    void addCause(std::string_view category, std::string_view name, double time);
+
+    double m_threshold;
+    std::uint32_t m_hitchCount{ 0 };
+    std::deque<Hitch> m_recent;
+    std::map<std::pair<std::string, std::string>, HitchCause> m_causes;
+};
+
+} // end namespace celestia::engine
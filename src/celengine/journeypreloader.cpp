@@ -0,0 +1,193 @@
+// journeypreloader.cpp
+//
+// Copyright (C) 2025-present, the Celestia Development Team
+//
+// Background loading of the destination of a journey.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include "journeypreloader.h"
+
+#include <algorithm>
+
+#include "atmosphere.h"
+#include "body.h"
+#include "location.h"
+#include "meshmanager.h"
+#include "observer.h"
+#include "solarsys.h"
+#include "surface.h"
+#include "texmanager.h"
+#include "universe.h"
+#include "virtualtex.h"
+
+namespace celestia::engine
+{
+
+void
+JourneyPreloader::update(const Observer& observer, const Universe& universe, TextureResolution resolution)
+{
+    const Observer::JourneyParams& journey = observer.getJourney();
+    if (observer.getMode() != Observer::ObserverMode::Travelling || journey.destination.empty())
+    {
+        // The remaining resources are loaded when they come into view
+        destination = Selection();
+        requests.clear();
+        next = 0;
+        return;
+    }
+
+    if (journey.destination != destination || journey.startTime != startTime)
+    {
+        startTime = journey.startTime;
+        start(journey.destination, universe);
+    }
+
+    std::size_t issued = 0;
+    while (next < requests.size() && issued < MaxRequestsPerFrame)
+    {
+        if (issue(requests[next], resolution))
+            ++issued;
+        ++next;
+    }
+}
+
+void
+JourneyPreloader::start(const Selection& _destination, const Universe& universe)
+{
+    destination = _destination;
+    requests.clear();
+    next = 0;
+
+    std::vector<const Body*> bodies;
+    const Body* body = nullptr;
+    switch (destination.getType())
+    {
+    case SelectionType::Body:
+        body = destination.body();
+        break;
+    case SelectionType::Location:
+        body = destination.location()->getParentBody();
+        break;
+    case SelectionType::Star:
+        // Looking up the solar system creates it when it is loaded lazily
+        if (const SolarSystem* solarSystem = universe.getSolarSystem(destination.star());
+            solarSystem != nullptr)
+        {
+            const PlanetarySystem* planets = solarSystem->getPlanets();
+            for (int i = 0; i < planets->getSystemSize(); ++i)
+                addBody(planets->getBody(i), bodies);
+        }
+        break;
+    default:
+        break;
+    }
+
+    if (body != nullptr)
+    {
+        addBody(body, bodies);
+        if (const PlanetarySystem* satellites = body->getSatellites(); satellites != nullptr)
+        {
+            for (int i = 0; i < satellites->getSystemSize(); ++i)
+                addBody(satellites->getBody(i), bodies);
+        }
+
+        if (const PlanetarySystem* system = body->getSystem(); system != nullptr)
+        {
+            // The body it orbits is in view on the approach
+            addBody(system->getPrimaryBody(), bodies);
+            for (int i = 0; i < system->getSystemSize(); ++i)
+                addBody(system->getBody(i), bodies);
+        }
+    }
+
+    for (const Body* b : bodies)
+        addRequests(b);
+}
+
+void
+JourneyPreloader::addBody(const Body* body, std::vector<const Body*>& bodies) const
+{
+    if (body == nullptr || !body->isVisible() || bodies.size() >= MaxBodies)
+        return;
+
+    if (std::find(bodies.begin(), bodies.end(), body) == bodies.end())
+        bodies.push_back(body);
+}
+
+void
+JourneyPreloader::addRequests(const Body* body)
+{
+    if (body->getGeometry() != InvalidResource)
+        requests.push_back({ MultiResTexture(), body->getGeometry() });
+
+    auto addTexture = [this](const MultiResTexture& texture)
+    {
+        if (texture.isValid())
+            requests.push_back({ texture, InvalidResource });
+    };
+
+    const Surface& surface = body->getSurface();
+    addTexture(surface.baseTexture);
+    addTexture(surface.nightTexture);
+    addTexture(surface.bumpTexture);
+    addTexture(surface.specularTexture);
+    addTexture(surface.overlayTexture);
+
+    const BodyFeaturesManager* features = GetBodyFeaturesManager();
+    if (const Atmosphere* atmosphere = features->getAtmosphere(body); atmosphere != nullptr)
+    {
+        addTexture(atmosphere->cloudTexture);
+        addTexture(atmosphere->cloudNormalMap);
+    }
+
+    if (const RingSystem* rings = features->getRings(body); rings != nullptr)
+        addTexture(rings->texture);
+}
+
+// Start loading the resource of the request and return whether a load was
+// started; resources which would be loaded on this thread are skipped.
+bool
+JourneyPreloader::issue(Request& request, TextureResolution resolution) const
+{
+    if (request.geometry != InvalidResource)
+    {
+        GeometryManager* geometryManager = GetGeometryManager();
+        if (!geometryManager->getAsyncLoading() ||
+            geometryManager->getState(request.geometry) != ResourceState::NotLoaded)
+        {
+            return false;
+        }
+
+        geometryManager->find(request.geometry);
+        return true;
+    }
+
+    TextureManager* textureManager = GetTextureManager();
+    if (!textureManager->getAsyncLoading())
+        return false;
+
+    if (textureManager->getState(request.texture.texture(resolution)) != ResourceState::NotLoaded)
+        return false;
+
+    // Virtual textures are created right away; request the tiles of their
+    // first level, which are then streamed in the background
+    if (Texture* texture = request.texture.find(resolution);
+        texture != nullptr && VirtualTexture::getStreaming())
+    {
+        texture->beginUsage();
+        for (int v = 0; v < texture->getVTileCount(0); ++v)
+        {
+            for (int u = 0; u < texture->getUTileCount(0); ++u)
+                texture->getTile(0, u, v);
+        }
+        texture->endUsage();
+    }
+
+    return true;
+}
+
+} // end namespace celestia::engine
@@ -0,0 +1,65 @@
+// journeypreloader.h
+//
+// Copyright (C) 2025-present, the Celestia Development Team
+//
+// Background loading of the destination of a journey.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <celengine/multitexture.h>
+#include <celengine/selection.h>
+#include <celutil/reshandle.h>
+
+class Body;
+class Observer;
+class Universe;
+
+namespace celestia::engine
+{
+
+// Starts loading the textures and models of the destination of a journey
+// while the observer travels, so that they are ready on arrival rather than
+// loaded once they come into view. The destination is loaded first, then
+// its satellites, the body it orbits and the other bodies orbiting it. The
+// loads are only requested from the resource managers which load in the
+// background, a few per frame, and are dropped when the journey ends.
+class JourneyPreloader
+{
+public:
+    // Bodies whose resources are loaded for a journey at most
+    static constexpr std::size_t MaxBodies = 24;
+    // Loads requested per frame at most
+    static constexpr std::size_t MaxRequestsPerFrame = 4;
+
+    // Called each frame on the render thread with the observer drawn
+    void update(const Observer& observer, const Universe& universe, TextureResolution resolution);
+
+    bool isPreloading() const { return next < requests.size(); }
+
+private:
+    struct Request
+    {
+        MultiResTexture texture;
+        ResourceHandle geometry{ InvalidResource };
+    };
+
+    void start(const Selection& destination, const Universe& universe);
+    void addBody(const Body* body, std::vector<const Body*>& bodies) const;
+    void addRequests(const Body* body);
+    bool issue(Request& request, TextureResolution resolution) const;
+
+    Selection destination;
+    double startTime{ 0.0 };
+    std::vector<Request> requests;
+    std::size_t next{ 0 };
+};
+
+} // end namespace celestia::engine
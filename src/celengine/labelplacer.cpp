@@ -0,0 +1,124 @@
+// labelplacer.cpp
+//
+// Copyright (C) 2024, Celestia Development Team
+//
+// Screen space placement of non-overlapping labels.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include "labelplacer.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace celestia::engine
+{
+
+namespace
+{
+
+bool
+intersects(const LabelPlacer::Rect& a, const LabelPlacer::Rect& b)
+{
+    return a.x0 < b.x1 && b.x0 < a.x1 && a.y0 < b.y1 && b.y0 < a.y1;
+}
+
+} // end unnamed namespace
+
+LabelPlacer::LabelPlacer(float cellSize) :
+    m_cellSize(cellSize)
+{
+}
+
+void
+LabelPlacer::reset(int width, int height)
+{
+    m_rects.clear();
+
+    int columns = std::max(1, static_cast<int>(std::ceil(static_cast<float>(width) / m_cellSize)));
+    int rows = std::max(1, static_cast<int>(std::ceil(static_cast<float>(height) / m_cellSize)));
+    if (columns != m_columns || rows != m_rows)
+    {
+        m_columns = columns;
+        m_rows = rows;
+        m_cells.assign(static_cast<std::size_t>(columns * rows), {});
+    }
+    else
+    {
+        // Keep the capacity of the cells from the previous frame
+        for (auto& cell : m_cells)
+            cell.clear();
+    }
+}
+
+LabelPlacer::CellRange
+LabelPlacer::cellRange(const Rect& rect) const
+{
+    auto toCell = [this](float v, int count)
+    {
+        return std::clamp(static_cast<int>(std::floor(v / m_cellSize)), 0, count - 1);
+    };
+
+    return CellRange
+    {
+        toCell(rect.x0, m_columns),
+        toCell(rect.y0, m_rows),
+        toCell(rect.x1, m_columns),
+        toCell(rect.y1, m_rows),
+    };
+}
+
+bool
+LabelPlacer::overlaps(const Rect& rect) const
+{
+    if (m_cells.empty())
+        return false;
+
+    CellRange range = cellRange(rect);
+    for (int y = range.y0; y <= range.y1; ++y)
+    {
+        for (int x = range.x0; x <= range.x1; ++x)
+        {
+            const auto& cell = m_cells[static_cast<std::size_t>(y * m_columns + x)];
+            if (std::any_of(cell.begin(), cell.end(),
+                            [&](std::uint32_t index) { return intersects(rect, m_rects[index]); }))
+            {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+bool
+LabelPlacer::place(const Rect& rect)
+{
+    if (overlaps(rect))
+        return false;
+
+    insert(rect);
+    return true;
+}
+
+void
+LabelPlacer::insert(const Rect& rect)
+{
+    if (m_cells.empty())
+        return;
+
+    auto index = static_cast<std::uint32_t>(m_rects.size());
+    m_rects.push_back(rect);
+
+    CellRange range = cellRange(rect);
+    for (int y = range.y0; y <= range.y1; ++y)
+    {
+        for (int x = range.x0; x <= range.x1; ++x)
+            m_cells[static_cast<std::size_t>(y * m_columns + x)].push_back(index);
+    }
+}
+
+} // end namespace celestia::engine
@@ -0,0 +1,73 @@
+// labelplacer.h
+//
+// Copyright (C) 2024, Celestia Development Team
+//
+// Screen space placement of non-overlapping labels.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace celestia::engine
+{
+
+// Place label rectangles on the screen in the order of their priority,
+// rejecting the ones which overlap a label placed before. The rectangles are
+// binned in a uniform grid of cells, so that each test only looks at the
+// labels in the cells it covers and placing n labels takes O(n) time.
+class LabelPlacer
+{
+public:
+    struct Rect
+    {
+        float x0;
+        float y0;
+        float x1;
+        float y1;
+    };
+
+    static constexpr float DefaultCellSize = 64.0f;
+
+    explicit LabelPlacer(float cellSize = DefaultCellSize);
+
+    // Remove all the labels and set the size of the screen. Labels outside
+    // the screen are binned in the border cells.
+    void reset(int width, int height);
+
+    bool overlaps(const Rect&) const;
+
+    // Place the rectangle if it doesn't overlap a placed one and return
+    // whether it was placed
+    bool place(const Rect&);
+
+    // Place the rectangle whether it overlaps or not
+    void insert(const Rect&);
+
+    std::size_t size() const { return m_rects.size(); }
+
+private:
+    struct CellRange
+    {
+        int x0;
+        int y0;
+        int x1;
+        int y1;
+    };
+
+    CellRange cellRange(const Rect&) const;
+
+    float m_cellSize;
+    int m_columns{ 0 };
+    int m_rows{ 0 };
+    std::vector<Rect> m_rects;
+    std::vector<std::vector<std::uint32_t>> m_cells;
+};
+
+} // end namespace celestia::engine
@@ -35,6 +35,8 @@ public:
     Eigen::Vector3d position;  // position relative to the lit object
     float apparentSize;
     bool castsShadows;
+    // Index of the light source, for the lights which cast shadows
+    unsigned int sourceIndex;
 };
 
 class EclipseShadow
@@ -38,9 +38,11 @@ Location::getName(bool i18n) const
 void
 Location::setName(const std::string& _name)
 {
-    name = _name;
-    i18nName = D_(_name.c_str());
-    if (name == i18nName)
+    name = celestia::util::InternedString(_name);
+    // Gettext returns the same string when there is no translation
+    if (const char* translated = D_(_name.c_str()); _name != translated)
+        i18nName = celestia::util::InternedString(translated);
+    else
         i18nName = {};
 }
 
@@ -48,9 +50,9 @@ std::string
 Location::getPath(const StarDatabase* starDB, char delimiter) const
 {
     if (parent)
-        return parent->getPath(starDB, delimiter) + delimiter + name;
+        return parent->getPath(starDB, delimiter) + delimiter + name.str();
     else
-        return name;
+        return name.str();
 }
 
 Eigen::Vector3f
@@ -16,6 +16,7 @@
 #include <Eigen/Core>
 
 #include <celutil/color.h>
+#include <celutil/stringinterner.h>
 
 class Body;
 class StarDatabase;
@@ -129,8 +130,8 @@ public:
 
  private:
     Body* parent{ nullptr };
-    std::string name{};
-    std::string i18nName{};
+    celestia::util::InternedString name{};
+    celestia::util::InternedString i18nName{};
     Eigen::Vector3f position{ Eigen::Vector3f::Zero() };
     float size{ 0.0f };
     float importance{ -1.0f };
@@ -19,6 +19,7 @@
 #include <boost/container/static_vector.hpp>
 
 #include <celcompat/numbers.h>
+#include <celengine/framestats.h>
 #include <celengine/shadermanager.h>
 #include <celengine/texture.h>
 #include <celmath/frustum.h>
@@ -49,6 +50,13 @@ static_assert(nIndices < std::numeric_limits<unsigned short>::max());
 constexpr const int MaxVertexSize = 3 + 3 + LODSphereMesh::MAX_SPHERE_MESH_TEXTURES * 2;
 
 
+// Size in bytes of the patch vertex buffers kept between draws, 0 to stream
+// the vertices
+std::size_t patchCacheSize = 0;
+
+float detailScale = 1.0f;
+
+
 using ThetaArray = std::array<float, thetaDivisions + 1>;
 using PhiArray   = std::array<float, phiDivisions + 1>;
 
@@ -281,6 +289,46 @@ createVertices(std::vector<float>& vertices,
 }
 
 
+void
+createIndices(std::vector<unsigned short>& indices, int nRings, int nSlices)
+{
+    indices.clear();
+    int expectedIndices = 2 * (nRings * (nSlices + 1) + std::max(nRings - 1, 0));
+    indices.reserve(expectedIndices);
+    for (int i = 0; i < nRings; i++)
+    {
+        if (i > 0)
+        {
+            indices.push_back(static_cast<unsigned short>(i * (nSlices + 1) + 0));
+        }
+        for (int j = 0; j <= nSlices; j++)
+        {
+            indices.push_back(static_cast<unsigned short>(i * (nSlices + 1) + j));
+            indices.push_back(static_cast<unsigned short>((i + 1) * (nSlices + 1) + j));
+        }
+        if (i < nRings - 1)
+        {
+            indices.push_back(static_cast<unsigned short>((i + 1) * (nSlices + 1) + nSlices));
+        }
+    }
+
+    assert(expectedIndices == indices.size());
+}
+
+
+// The patch origin fits in 14 bits per coordinate, the extent and step in
+// 16 bits and the vertex size in 4 bits
+std::uint64_t
+patchKey(int phi0, int theta0, int extent, int step, int vertexSize)
+{
+    return static_cast<std::uint64_t>(phi0) |
+           (static_cast<std::uint64_t>(theta0) << 14) |
+           (static_cast<std::uint64_t>(extent) << 28) |
+           (static_cast<std::uint64_t>(step) << 44) |
+           (static_cast<std::uint64_t>(vertexSize) << 60);
+}
+
+
 } // end unnamed namespace
 
 
@@ -288,6 +336,24 @@ LODSphereMesh::~LODSphereMesh()
 {
     glDeleteBuffers(vertexBuffers.size(), vertexBuffers.data());
     glDeleteBuffers(1, &indexBuffer);
+    for (const auto& [key, patch] : patchCache)
+        glDeleteBuffers(1, &patch.buffer);
+    for (const auto& [key, buffer] : indexCache)
+        glDeleteBuffers(1, &buffer);
+}
+
+
+void
+LODSphereMesh::setPatchCacheSize(std::size_t size)
+{
+    patchCacheSize = size;
+}
+
+
+void
+LODSphereMesh::setDetailScale(float scale)
+{
+    detailScale = scale;
 }
 
 
@@ -334,7 +400,7 @@ void LODSphereMesh::render(unsigned int attributes,
                            CelestiaGLProgram *program)
 {
     int lod = 64;
-    int lodBias = getSphereLOD(pixWidth);
+    int lodBias = getSphereLOD(pixWidth * detailScale);
 
     if (lodBias < 0)
         lod /= (1 << (-lodBias));
@@ -428,40 +494,27 @@ void LODSphereMesh::render(unsigned int attributes,
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
     }
 
-    currentVB = 0;
-    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffers[currentVB]);
-
     // Set up the mesh vertices
     int nRings = phiExtent / ri.step;
     int nSlices = thetaExtent / ri.step;
 
-    indices.clear();
-    int expectedIndices = 2 * (nRings * (nSlices + 1) + std::max(nRings - 1, 0));
-    indices.reserve(expectedIndices);
-    for (int i = 0; i < nRings; i++)
+    if (patchCacheSize > 0)
     {
-        if (i > 0)
-        {
-            indices.push_back(static_cast<unsigned short>(i * (nSlices + 1) + 0));
-        }
-        for (int j = 0; j <= nSlices; j++)
-        {
-            indices.push_back(static_cast<unsigned short>(i * (nSlices + 1) + j));
-            indices.push_back(static_cast<unsigned short>((i + 1) * (nSlices + 1) + j));
-        }
-        if (i < nRings - 1)
-        {
-            indices.push_back(static_cast<unsigned short>((i + 1) * (nSlices + 1) + nSlices));
-        }
+        ++renderCount;
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, getCachedIndices(nRings, nSlices));
     }
+    else
+    {
+        currentVB = 0;
+        glBindBuffer(GL_ARRAY_BUFFER, vertexBuffers[currentVB]);
 
-    assert(expectedIndices == indices.size());
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER,
-                 indices.size() * sizeof(unsigned short),
-                 indices.data(),
-                 GL_DYNAMIC_DRAW);
+        createIndices(indices, nRings, nSlices);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+                     indices.size() * sizeof(unsigned short),
+                     indices.data(),
+                     GL_DYNAMIC_DRAW);
+    }
 
     // Compute the size of a vertex
     vertexSize = 3;
@@ -548,6 +601,9 @@ void LODSphereMesh::render(unsigned int attributes,
 
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    if (patchCacheSize > 0)
+        evictPatches();
 }
 
 
@@ -637,41 +693,12 @@ LODSphereMesh::renderSection(int phi0, int theta0, int extent,
                              const RenderInfo& ri, CelestiaGLProgram *program)
 
 {
-    auto stride = static_cast<GLsizei>(vertexSize * sizeof(float));
-    int texCoordOffset = ((ri.attributes & Tangents) != 0) ? 6 : 3;
-
-    glVertexAttribPointer(CelestiaGLProgram::VertexCoordAttributeIndex,
-                          3, GL_FLOAT, GL_FALSE,
-                          stride, PTR(0));
-    if ((ri.attributes & Normals) != 0)
-    {
-        glVertexAttribPointer(CelestiaGLProgram::NormalAttributeIndex,
-                              3, GL_FLOAT, GL_FALSE,
-                              stride, PTR(0));
-    }
-
-    for (int tc = 0; tc < nTexturesUsed; tc++)
-    {
-        glVertexAttribPointer(CelestiaGLProgram::TextureCoord0AttributeIndex + tc,
-                              2, GL_FLOAT, GL_FALSE,
-                              stride, PTR(texCoordOffset * sizeof(float)));
-    }
-
-    if ((ri.attributes & Tangents) != 0)
-    {
-        glVertexAttribPointer(CelestiaGLProgram::TangentAttributeIndex,
-                              3, GL_FLOAT, GL_FALSE,
-                              stride, PTR(3 * sizeof(float))); // 3 == tangentOffset
-    }
-
     // assert(ri.step >= minStep);
     // assert(phi0 + extent <= maxDivisions);
     // assert(theta0 + extent / 2 < maxDivisions);
     // assert(isPow2(extent));
     int thetaExtent = extent;
     int phiExtent = extent / 2;
-    int theta1 = theta0 + thetaExtent;
-    int phi1 = phi0 + phiExtent;
 
     TextureCoords tc{ nTexturesUsed };
 
@@ -731,32 +758,149 @@ LODSphereMesh::renderSection(int phi0, int theta0, int extent,
         }
     }
 
+    if (patchCacheSize > 0)
+    {
+        bindCachedVertices(phi0, theta0, extent, ri);
+    }
+    else
+    {
+        buildVertices(phi0, theta0, extent, ri);
+        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), nullptr, GL_STREAM_DRAW);
+        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STREAM_DRAW);
+    }
+
+    auto stride = static_cast<GLsizei>(vertexSize * sizeof(float));
+    int texCoordOffset = ((ri.attributes & Tangents) != 0) ? 6 : 3;
+
+    glVertexAttribPointer(CelestiaGLProgram::VertexCoordAttributeIndex,
+                          3, GL_FLOAT, GL_FALSE,
+                          stride, PTR(0));
+    if ((ri.attributes & Normals) != 0)
+    {
+        glVertexAttribPointer(CelestiaGLProgram::NormalAttributeIndex,
+                              3, GL_FLOAT, GL_FALSE,
+                              stride, PTR(0));
+    }
+
+    for (int i = 0; i < nTexturesUsed; i++)
+    {
+        glVertexAttribPointer(CelestiaGLProgram::TextureCoord0AttributeIndex + i,
+                              2, GL_FLOAT, GL_FALSE,
+                              stride, PTR(texCoordOffset * sizeof(float)));
+    }
+
+    if ((ri.attributes & Tangents) != 0)
+    {
+        glVertexAttribPointer(CelestiaGLProgram::TangentAttributeIndex,
+                              3, GL_FLOAT, GL_FALSE,
+                              stride, PTR(3 * sizeof(float))); // 3 == tangentOffset
+    }
+
+    int nRings = phiExtent / ri.step;
+    int nSlices = thetaExtent / ri.step;
+    int nIndices = nRings * (nSlices + 2) * 2 - 2;
+    glDrawElements(GL_TRIANGLE_STRIP,
+                   nIndices,
+                   GL_UNSIGNED_SHORT,
+                   nullptr);
+    celestia::engine::GetFrameStats()->addDrawCall(static_cast<std::uint64_t>(nIndices));
+
+    if (patchCacheSize == 0)
+    {
+        // Cycle through the vertex buffers
+        currentVB++;
+        if (currentVB == NUM_SPHERE_VERTEX_BUFFERS)
+            currentVB = 0;
+        glBindBuffer(GL_ARRAY_BUFFER, vertexBuffers[currentVB]);
+    }
+}
+
+
+void
+LODSphereMesh::buildVertices(int phi0, int theta0, int extent, const RenderInfo& ri)
+{
+    int theta1 = theta0 + extent;
+    int phi1 = phi0 + extent / 2;
+
     vertices.clear();
     int perVertexFloats = (ri.attributes & Tangents) == 0 ? 3 : 6;
     int expectedVertices = ((phi1 - phi0) / ri.step + 1) *
                            ((theta1 - theta0) / ri.step + 1) * (perVertexFloats + (nTexturesUsed > 0 ? 2 : 0));
     assert(expectedVertices <= maxVertices * MaxVertexSize);
     vertices.reserve(expectedVertices);
+
+    // The texture coordinates are the grid coordinates, which the programs
+    // map to the subtexture of the patch
+    TextureCoords tc{ nTexturesUsed };
     if ((ri.attributes & Tangents) == 0)
         createVertices<false>(vertices, phi0, phi1, theta0, theta1, ri.step, tc);
     else
         createVertices<true>(vertices, phi0, phi1, theta0, theta1, ri.step, tc);
 
     assert(expectedVertices == vertices.size());
+}
 
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), nullptr, GL_STREAM_DRAW);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STREAM_DRAW);
 
-    int nRings = phiExtent / ri.step;
-    int nSlices = thetaExtent / ri.step;
-    glDrawElements(GL_TRIANGLE_STRIP,
-                   nRings * (nSlices + 2) * 2 - 2,
-                   GL_UNSIGNED_SHORT,
-                   nullptr);
+// The vertices of a patch don't depend on the sphere or its textures, so
+// they are made once and drawn from the same buffer until evicted.
+void
+LODSphereMesh::bindCachedVertices(int phi0, int theta0, int extent, const RenderInfo& ri)
+{
+    auto [it, inserted] = patchCache.try_emplace(patchKey(phi0, theta0, extent, ri.step, vertexSize));
+    CachedPatch& patch = it->second;
+    patch.lastUse = renderCount;
+    if (!inserted)
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, patch.buffer);
+        return;
+    }
 
-    // Cycle through the vertex buffers
-    currentVB++;
-    if (currentVB == NUM_SPHERE_VERTEX_BUFFERS)
-        currentVB = 0;
-    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffers[currentVB]);
+    buildVertices(phi0, theta0, extent, ri);
+    patch.size = vertices.size() * sizeof(float);
+    glGenBuffers(1, &patch.buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, patch.buffer);
+    glBufferData(GL_ARRAY_BUFFER, patch.size, vertices.data(), GL_STATIC_DRAW);
+    patchCacheUsage += patch.size;
+}
+
+
+GLuint
+LODSphereMesh::getCachedIndices(int nRings, int nSlices)
+{
+    auto key = static_cast<std::uint32_t>(nRings) << 16 | static_cast<std::uint32_t>(nSlices);
+    auto [it, inserted] = indexCache.try_emplace(key, 0);
+    if (inserted)
+    {
+        createIndices(indices, nRings, nSlices);
+        glGenBuffers(1, &it->second);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, it->second);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+                     indices.size() * sizeof(unsigned short),
+                     indices.data(),
+                     GL_STATIC_DRAW);
+    }
+
+    return it->second;
+}
+
+
+// Release the least recently drawn patches above the cache size. The
+// patches of the last sphere drawn are kept, even when they exceed it.
+void
+LODSphereMesh::evictPatches()
+{
+    while (patchCacheUsage > patchCacheSize)
+    {
+        auto oldest = std::min_element(patchCache.begin(), patchCache.end(),
+                                       [](const auto& a, const auto& b)
+                                       {
+                                           return a.second.lastUse < b.second.lastUse;
+                                       });
+        if (oldest == patchCache.end() || oldest->second.lastUse == renderCount)
+            break;
+
+        glDeleteBuffers(1, &oldest->second.buffer);
+        patchCacheUsage -= oldest->second.size;
+        patchCache.erase(oldest);
+    }
 }
@@ -12,6 +12,8 @@
 
 #include <array>
 #include <cstddef>
+#include <cstdint>
+#include <unordered_map>
 #include <vector>
 
 #include <Eigen/Core>
@@ -55,6 +57,17 @@ public:
         Tangents   = 0x02,
     };
 
+    // With a cache size, the vertices of each patch are made once and kept
+    // in a buffer, shared by all the spheres, so that drawing a sphere only
+    // selects the patches; the least recently drawn patches are released
+    // above the size in bytes. With the default of 0, the vertices of the
+    // patches are made and uploaded for each draw.
+    static void setPatchCacheSize(std::size_t);
+
+    // Factor applied to the size on screen of the spheres when choosing the
+    // number of their divisions; below 1 draws coarser spheres
+    static void setDetailScale(float);
+
  private:
     struct RenderInfo
     {
@@ -81,6 +94,18 @@ public:
 
     void renderSection(int phi0, int theta0, int extent, const RenderInfo&, CelestiaGLProgram *);
 
+    void buildVertices(int phi0, int theta0, int extent, const RenderInfo&);
+    void bindCachedVertices(int phi0, int theta0, int extent, const RenderInfo&);
+    GLuint getCachedIndices(int nRings, int nSlices);
+    void evictPatches();
+
+    struct CachedPatch
+    {
+        GLuint buffer{ 0 };
+        std::size_t size{ 0 };
+        std::uint64_t lastUse{ 0 };
+    };
+
     int vertexSize{ 0 };
 
     std::vector<float> vertices{};
@@ -94,4 +119,11 @@ public:
     GLuint currentVB{ 0 };
     std::array<GLuint, NUM_SPHERE_VERTEX_BUFFERS> vertexBuffers{};
     GLuint indexBuffer{ 0 };
+
+    // Patch vertex buffers by position, extent, step and vertex size, and
+    // index buffers by the number of rings and slices
+    std::unordered_map<std::uint64_t, CachedPatch> patchCache;
+    std::unordered_map<std::uint32_t, GLuint> indexCache;
+    std::size_t patchCacheUsage{ 0 };
+    std::uint64_t renderCount{ 0 };
 };
@@ -0,0 +1,57 @@
+// memoryreport.cpp
+//
+// Copyright (C) 2026, Celestia Development Team
+//
+// Memory held by the catalogs, resources and caches.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include "memoryreport.h"
+
+#include <celutil/logger.h>
+
+using celestia::util::GetLogger;
+
+namespace celestia::engine
+{
+
+namespace
+{
+
+constexpr double BytesPerMiB = 1024.0 * 1024.0;
+
+} // end unnamed namespace
+
+void
+MemoryReport::add(std::string_view name, std::size_t bytes, std::size_t count)
+{
+    m_entries.push_back({ std::string(name), bytes, count });
+}
+
+std::size_t
+MemoryReport::getTotalBytes() const
+{
+    std::size_t total = 0;
+    for (const MemoryReportEntry& entry : m_entries)
+        total += entry.bytes;
+    return total;
+}
+
+void
+MemoryReport::log() const
+{
+    GetLogger()->info("Memory usage:\n");
+    for (const MemoryReportEntry& entry : m_entries)
+    {
+        if (entry.count > 0)
+            GetLogger()->info("  {:<24} {:>10.2f} MiB ({} objects)\n", entry.name, static_cast<double>(entry.bytes) / BytesPerMiB, entry.count);
+        else
+            GetLogger()->info("  {:<24} {:>10.2f} MiB\n", entry.name, static_cast<double>(entry.bytes) / BytesPerMiB);
+    }
+    GetLogger()->info("  {:<24} {:>10.2f} MiB\n", "total", static_cast<double>(getTotalBytes()) / BytesPerMiB);
+}
+
+} // end namespace celestia::engine
@@ -0,0 +1,74 @@
+// memoryreport.h
+//
+// Copyright (C) 2026, Celestia Development Team
+//
+// Memory held by the catalogs, resources and caches.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace celestia::engine
+{
+
+// Approximate heap memory of the standard containers, for the sizes
+// reported by the subsystems. The nodes of a map are assumed to carry three
+// pointers and a color besides their value.
+inline std::size_t
+StringMemoryUsage(const std::string& str)
+{
+    const char* data = str.data();
+    const auto* self = reinterpret_cast<const char*>(&str);
+    // Short strings are held in the object itself
+    return data >= self && data < self + sizeof(str) ? 0 : str.capacity() + 1;
+}
+
+template<typename T>
+std::size_t
+VectorMemoryUsage(const std::vector<T>& vec)
+{
+    return vec.capacity() * sizeof(T);
+}
+
+template<typename MAP>
+std::size_t
+MapNodeMemoryUsage(const MAP& map)
+{
+    return map.size() * (sizeof(typename MAP::value_type) + 4 * sizeof(void*));
+}
+
+struct MemoryReportEntry
+{
+    std::string name;
+    std::size_t bytes{ 0 };
+    // Number of objects, if they are counted
+    std::size_t count{ 0 };
+};
+
+// A list of the memory held by each subsystem, named like
+// "stars.octree". The sizes are estimates: they cover the main objects
+// and containers of each subsystem, not the allocator overhead.
+class MemoryReport
+{
+public:
+    void add(std::string_view name, std::size_t bytes, std::size_t count = 0);
+
+    const std::vector<MemoryReportEntry>& getEntries() const { return m_entries; }
+    std::size_t getTotalBytes() const;
+
+    // Write the entries and the total to the log
+    void log() const;
+
+private:
+    std::vector<MemoryReportEntry> m_entries;
+};
+
+} // end namespace celestia::engine
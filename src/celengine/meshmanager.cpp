@@ -10,10 +10,13 @@
 
 #include "meshmanager.h"
 
+#include <algorithm>
+#include <cmath>
 #include <cstdint>
 #include <cstring>
 #include <fstream>
 #include <ios>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -22,11 +25,14 @@
 #include <celmodel/model.h>
 #include <celmodel/modelfile.h>
 #include <celutil/associativearray.h>
+#include <celutil/fileaccesslog.h>
 #include <celutil/filetype.h>
 #include <celutil/gettext.h>
 #include <celutil/logger.h>
 #include <celutil/parser.h>
+#include <celutil/profiler.h>
 #include <celutil/tokenizer.h>
+#include "framestats.h"
 #include "modelgeometry.h"
 #include "spheremesh.h"
 #include "texmanager.h"
@@ -39,6 +45,21 @@ namespace celestia::engine
 namespace
 {
 
+// Returns the index of the texture in the list, which stands for its handle
+// until the geometry is created
+ResourceHandle
+AddTexture(std::vector<TextureInfo>& textures, const fs::path& source, const fs::path& path)
+{
+    TextureInfo info(source, path, TextureInfo::WrapTexture);
+    auto it = std::find_if(textures.begin(), textures.end(),
+                           [&info](const TextureInfo& other) { return !(info < other) && !(other < info); });
+    if (it != textures.end())
+        return static_cast<ResourceHandle>(it - textures.begin());
+
+    textures.push_back(std::move(info));
+    return static_cast<ResourceHandle>(textures.size() - 1);
+}
+
 std::unique_ptr<cmod::Model>
 LoadCelestiaMesh(const fs::path& filename)
 {
@@ -92,9 +113,18 @@ LoadCelestiaMesh(const fs::path& filename)
     return model;
 }
 
+// Returns the index of the first material with the name, or 0 if there is
+// none
+std::uint32_t
+FindMaterialIndex(const std::vector<std::string>& materialNames, const std::string& name)
+{
+    auto it = std::find(materialNames.begin(), materialNames.end(), name);
+    return it == materialNames.end() ? 0 : static_cast<std::uint32_t>(it - materialNames.begin());
+}
+
 cmod::Mesh
 ConvertTriangleMesh(const M3DTriangleMesh& mesh,
-                    const M3DScene& scene)
+                    const std::vector<std::string>& materialNames)
 {
     int nFaces     = mesh.getFaceCount();
     int nVertices  = mesh.getVertexCount();
@@ -275,93 +305,119 @@ ConvertTriangleMesh(const M3DTriangleMesh& mesh,
             indices.push_back(faceIndex * 3 + 2);
         }
 
-        // Lookup the material index
-        std::uint32_t materialIndex = 0;
-        for (std::uint32_t j = 0; j < scene.getMaterialCount(); ++j)
-        {
-            if (matGroup->materialName == scene.getMaterial(j)->getName())
-            {
-                materialIndex = j;
-                break;
-            }
-        }
-
+        std::uint32_t materialIndex = FindMaterialIndex(materialNames, matGroup->materialName);
         newMesh.addGroup(cmod::PrimitiveGroupType::TriList, materialIndex, std::move(indices));
     }
 
     return newMesh;
 }
 
-std::unique_ptr<cmod::Model>
-Convert3DSModel(const M3DScene& scene, const fs::path& texPath)
+cmod::Material
+ConvertMaterial(const M3DMaterial& material, const fs::path& texPath, std::vector<TextureInfo>& textures)
 {
-    auto model = std::make_unique<cmod::Model>();
+    cmod::Material newMaterial;
+
+    M3DColor diffuse = material.getDiffuseColor();
+    newMaterial.diffuse = cmod::Color(diffuse.red, diffuse.green, diffuse.blue);
+    newMaterial.opacity = material.getOpacity();
+
+    M3DColor specular = material.getSpecularColor();
+    newMaterial.specular = cmod::Color(specular.red, specular.green, specular.blue);
+
+    float shininess = material.getShininess();
+
+    // Map the 3DS file's shininess from percentage (0-100) to
+    // range that OpenGL uses for the specular exponent. The
+    // current equation is just a guess at the mapping that
+    // 3DS actually uses.
+    newMaterial.specularPower = std::pow(2.0f, 1.0f + 0.1f * shininess);
+    if (newMaterial.specularPower > 128.0f)
+        newMaterial.specularPower = 128.0f;
 
-    // Convert the materials
-    for (std::uint32_t i = 0; i < scene.getMaterialCount(); i++)
+    if (!material.getTextureMap().empty())
     {
-        const M3DMaterial* material = scene.getMaterial(i);
-        cmod::Material newMaterial;
+        ResourceHandle tex = AddTexture(textures, material.getTextureMap(), texPath);
+        newMaterial.setMap(cmod::TextureSemantic::DiffuseMap, tex);
+    }
+
+    return newMaterial;
+}
 
-        M3DColor diffuse = material->getDiffuseColor();
-        newMaterial.diffuse = cmod::Color(diffuse.red, diffuse.green, diffuse.blue);
-        newMaterial.opacity = material->getOpacity();
+// Converts the materials and meshes of a 3DS file while it is read, so that
+// only one 3DS mesh is kept in memory at a time. Some confusing terminology:
+// a 3ds 'scene' is the same as a Celestia model, and a 3ds 'model' is the
+// same as a Celestia mesh.
+class ModelConverter : public M3DSceneHandler
+{
+ public:
+    ModelConverter(const fs::path& texPath, std::vector<TextureInfo>& textures) :
+        texPath(texPath), textures(textures)
+    {
+    }
 
-        M3DColor specular = material->getSpecularColor();
-        newMaterial.specular = cmod::Color(specular.red, specular.green, specular.blue);
+    void addMaterial(M3DMaterial&& material) override
+    {
+        model->addMaterial(ConvertMaterial(material, texPath, textures));
+        materialNames.push_back(material.getName());
+    }
 
-        float shininess = material->getShininess();
+    void addTriMesh(M3DTriangleMesh&& mesh) override
+    {
+        // Meshes referring to materials which follow them are converted
+        // once the whole file is read, and so are those after them to keep
+        // the order of the meshes
+        if (pendingMeshes.empty() && hasMaterials(mesh))
+            addMesh(mesh);
+        else
+            pendingMeshes.push_back(std::move(mesh));
+    }
 
-        // Map the 3DS file's shininess from percentage (0-100) to
-        // range that OpenGL uses for the specular exponent. The
-        // current equation is just a guess at the mapping that
-        // 3DS actually uses.
-        newMaterial.specularPower = std::pow(2.0f, 1.0f + 0.1f * shininess);
-        if (newMaterial.specularPower > 128.0f)
-            newMaterial.specularPower = 128.0f;
+    std::unique_ptr<cmod::Model> finish()
+    {
+        for (const M3DTriangleMesh& mesh : pendingMeshes)
+            addMesh(mesh);
+        pendingMeshes.clear();
+        return std::move(model);
+    }
 
-        if (!material->getTextureMap().empty())
+ private:
+    bool hasMaterials(const M3DTriangleMesh& mesh) const
+    {
+        for (std::uint32_t i = 0; i < mesh.getMeshMaterialGroupCount(); ++i)
         {
-            ResourceHandle tex = GetTextureManager()->getHandle(TextureInfo(material->getTextureMap(), texPath, TextureInfo::WrapTexture));
-            newMaterial.setMap(cmod::TextureSemantic::DiffuseMap, tex);
+            const std::string& name = mesh.getMeshMaterialGroup(i)->materialName;
+            if (std::find(materialNames.begin(), materialNames.end(), name) == materialNames.end())
+                return false;
         }
 
-        model->addMaterial(std::move(newMaterial));
+        return true;
     }
 
-    // Convert all models in the scene. Some confusing terminology: a 3ds 'scene' is the same
-    // as a Celestia model, and a 3ds 'model' is the same as a Celestia mesh.
-    for (std::uint32_t i = 0; i < scene.getModelCount(); i++)
+    void addMesh(const M3DTriangleMesh& mesh)
     {
-        const M3DModel* model3ds = scene.getModel(i);
-        if (model3ds)
-        {
-            for (unsigned int j = 0; j < model3ds->getTriMeshCount(); j++)
-            {
-                const M3DTriangleMesh* mesh = model3ds->getTriMesh(j);
-                if (mesh)
-                {
-                    cmod::Mesh cmodmesh = ConvertTriangleMesh(*mesh, scene);
-                    if (cmodmesh.getGroupCount() > 0)
-                        model->addMesh(std::move(cmodmesh));
-                    else
-                        GetLogger()->warn("Skipping mesh with 0 primitive groups!\n");
-                }
-            }
-        }
+        cmod::Mesh cmodmesh = ConvertTriangleMesh(mesh, materialNames);
+        if (cmodmesh.getGroupCount() > 0)
+            model->addMesh(std::move(cmodmesh));
+        else
+            GetLogger()->warn("Skipping mesh with 0 primitive groups!\n");
     }
 
-    return model;
-}
+    const fs::path& texPath;
+    std::vector<TextureInfo>& textures;
+    std::unique_ptr<cmod::Model> model{ std::make_unique<cmod::Model>() };
+    std::vector<std::string> materialNames;
+    std::vector<M3DTriangleMesh> pendingMeshes;
+};
 
 std::unique_ptr<cmod::Model>
-Load3DSModel(const GeometryInfo::ResourceKey& key, const fs::path& path)
+Load3DSModel(const GeometryInfo::ResourceKey& key, const fs::path& path, std::vector<TextureInfo>& textures)
 {
-    std::unique_ptr<M3DScene> scene = Read3DSFile(key.resolvedPath);
-    if (scene == nullptr)
+    fs::path texPath = key.resolvedToPath ? path : fs::path();
+    ModelConverter converter(texPath, textures);
+    if (!Read3DSFile(key.resolvedPath, converter))
         return nullptr;
 
-    std::unique_ptr<cmod::Model> model = Convert3DSModel(*scene, key.resolvedToPath ? path : fs::path());
+    std::unique_ptr<cmod::Model> model = converter.finish();
 
     if (key.isNormalized)
         model->normalize(key.center);
@@ -372,17 +428,13 @@ Load3DSModel(const GeometryInfo::ResourceKey& key, const fs::path& path)
 }
 
 std::unique_ptr<cmod::Model>
-LoadCMODModel(const GeometryInfo::ResourceKey& key, const fs::path& path)
+LoadCMODModel(const GeometryInfo::ResourceKey& key, const fs::path& path, std::vector<TextureInfo>& textures)
 {
-    std::ifstream in(key.resolvedPath, std::ios::binary);
-    if (!in.good())
-        return nullptr;
-
     std::unique_ptr<cmod::Model> model = cmod::LoadModel(
-        in,
-        [&path](const fs::path& name)
+        key.resolvedPath,
+        [&path, &textures](const fs::path& name)
         {
-            return GetTextureManager()->getHandle(TextureInfo(name, path, TextureInfo::WrapTexture));
+            return AddTexture(textures, name, path);
         });
 
     if (model == nullptr)
@@ -413,6 +465,9 @@ LoadCMSModel(const GeometryInfo::ResourceKey& key)
 
 } // end unnamed namespace
 
+DecodedGeometry::DecodedGeometry() = default;
+DecodedGeometry::~DecodedGeometry() = default;
+
 GeometryInfo::ResourceKey
 GeometryInfo::resolve(const fs::path& baseDir) const
 {
@@ -436,32 +491,43 @@ GeometryInfo::resolve(const fs::path& baseDir) const
 std::unique_ptr<Geometry>
 GeometryInfo::load(const ResourceKey& key) const
 {
+    return create(key, decode(key));
+}
+
+std::unique_ptr<DecodedGeometry>
+GeometryInfo::decode(const ResourceKey& key) const
+{
+    auto decoded = std::make_unique<DecodedGeometry>();
+
     // empty mesh
     if (key.resolvedPath.empty())
-        return std::make_unique<EmptyGeometry>();
+        return decoded;
 
     GetLogger()->info(_("Loading model: {}\n"), key.resolvedPath);
+    celestia::util::FileAccessScope access("model", key.resolvedPath);
     std::unique_ptr<cmod::Model> model = nullptr;
 
     switch (ContentType fileType = DetermineFileType(key.resolvedPath); fileType)
     {
     case ContentType::_3DStudio:
-        model = Load3DSModel(key, path);
+        model = Load3DSModel(key, path, decoded->textures);
         break;
     case ContentType::CelestiaModel:
-        model = LoadCMODModel(key, path);
+        model = LoadCMODModel(key, path, decoded->textures);
         break;
     case ContentType::CelestiaMesh:
         model = LoadCMSModel(key);
         break;
     default:
         GetLogger()->error(_("Unknown model format '{}'\n"), key.resolvedPath);
+        access.setFailed();
         return nullptr;
     }
 
     if (model == nullptr)
     {
         GetLogger()->error(_("Error loading model '{}'\n"), key.resolvedPath);
+        access.setFailed();
         return nullptr;
     }
 
@@ -479,6 +545,10 @@ GeometryInfo::load(const ResourceKey& key) const
     // rendered before geometry that they cover.
     model->sortMeshes(cmod::Model::OpacityComparator());
 
+    // Simplified versions of detailed models are drawn when they're small
+    // on screen
+    model->generateLODs();
+
     model->determineOpacity();
 
     // Display some statics for the model
@@ -488,13 +558,55 @@ GeometryInfo::load(const ResourceKey& key) const
                          originalMaterialCount,
                          model->getMaterialCount());
 
-    return std::make_unique<ModelGeometry>(std::move(model));
+    decoded->model = std::move(model);
+    return decoded;
+}
+
+std::unique_ptr<Geometry>
+GeometryInfo::create(const ResourceKey& key, std::unique_ptr<DecodedGeometry> decoded) const
+{
+    if (key.resolvedPath.empty())
+        return std::make_unique<EmptyGeometry>();
+
+    if (decoded == nullptr || decoded->model == nullptr)
+        return nullptr;
+
+    cmod::Model& model = *decoded->model;
+    for (unsigned int i = 0; i < model.getMaterialCount(); ++i)
+    {
+        cmod::Material material = model.getMaterial(i)->clone();
+        bool textured = false;
+        for (std::size_t j = 0; j < static_cast<std::size_t>(cmod::TextureSemantic::TextureSemanticMax); ++j)
+        {
+            auto semantic = static_cast<cmod::TextureSemantic>(j);
+            if (ResourceHandle tex = material.getMap(semantic); tex != InvalidResource)
+            {
+                material.setMap(semantic, GetTextureManager()->getHandle(decoded->textures[tex]));
+                textured = true;
+            }
+        }
+
+        if (textured)
+            model.setMaterial(i, std::move(material));
+    }
+
+    return std::make_unique<ModelGeometry>(std::move(decoded->model));
 }
 
 GeometryManager*
 GetGeometryManager()
 {
-    static GeometryManager* const geometryManager = std::make_unique<GeometryManager>("models").release(); //NOSONAR
+    static GeometryManager* const geometryManager = []
+    {
+        auto manager = std::make_unique<GeometryManager>("models");
+        manager->setLoadObserver([](const GeometryInfo::ResourceKey& key, const util::ResourceLoadRecord& record)
+        {
+            std::string path = key.resolvedPath.u8string();
+            GetFrameStats()->addZoneTime(FrameZone::GeometryLoad, path, record.createTime);
+            util::Profiler::recordInstant(record.failed ? "model load failed" : "model load", path);
+        });
+        return manager.release();
+    }(); //NOSONAR
     return geometryManager;
 }
 
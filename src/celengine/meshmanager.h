@@ -12,6 +12,7 @@
 #include <memory>
 #include <tuple>
 #include <utility>
+#include <vector>
 
 #include <Eigen/Core>
 
@@ -19,13 +20,34 @@
 #include <celutil/resmanager.h>
 #include "geometry.h"
 
+class TextureInfo;
+
+namespace cmod
+{
+class Model;
+}
+
 namespace celestia::engine
 {
 
+// A model parsed and prepared for rendering by GeometryInfo::decode, which
+// may run on a worker thread. The texture manager is only used on the render
+// thread, so until GeometryInfo::create, the texture handles of the
+// materials are indices in textures.
+struct DecodedGeometry
+{
+    DecodedGeometry();
+    ~DecodedGeometry();
+
+    std::unique_ptr<cmod::Model> model;
+    std::vector<TextureInfo> textures;
+};
+
 class GeometryInfo
 {
 public:
     using ResourceType = Geometry;
+    using DecodedType = DecodedGeometry;
 
     // Ensure that models with different centers get resolved to different objects by
     // encoding the center, scale and normalization state in the key.
@@ -73,6 +95,11 @@ public:
     ResourceKey resolve(const fs::path&) const;
     std::unique_ptr<Geometry> load(const ResourceKey&) const;
 
+    // load() split for background loading; decode doesn't use the texture
+    // manager or the GL state
+    std::unique_ptr<DecodedGeometry> decode(const ResourceKey&) const;
+    std::unique_ptr<Geometry> create(const ResourceKey&, std::unique_ptr<DecodedGeometry>) const;
+
 private:
     fs::path source;
     fs::path path;
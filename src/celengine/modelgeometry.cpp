@@ -9,23 +9,32 @@
 // of the License, or (at your option) any later version.
 
 #include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <tuple>
 #include <vector>
 #include <utility>
+#include <celmath/frustum.h>
 #include <celrender/gl/buffer.h>
 #include <celrender/gl/vertexobject.h>
-#include <celutil/gettext.h>
-#include <celutil/logger.h>
 #include "glsupport.h"
 #include "modelgeometry.h"
 #include "rendcontext.h"
 
-using celestia::util::GetLogger;
 namespace gl = celestia::gl;
+namespace math = celestia::math;
 namespace util = celestia::util;
 
 namespace
 {
 
+// Levels of detail move the vertices by at most this many pixels
+constexpr float MaxLODErrorPixels = 1.0f;
+
 constexpr gl::VertexObject::DataType GLComponentTypes[static_cast<std::size_t>(cmod::VertexAttributeFormat::FormatMax)] =
 {
      gl::VertexObject::DataType::Float,         // Float1
@@ -76,37 +85,514 @@ convert(cmod::VertexAttributeSemantic semantic)
     }
 }
 
-void
-setVertexArrays(gl::VertexObject &vao, const gl::Buffer &vbo, const cmod::VertexDescription& desc)
+bool compactVertices = false;
+
+// Graphics memory of the buffers of the models which exist
+std::size_t totalBufferMemory = 0;
+
+// How an attribute is converted for the vertex buffer
+enum class PackedFormat
+{
+    Copy,
+    Normal1010102, // signed normalized 10 bit components
+    NormalShort4,  // signed normalized 16 bit components
+    Half2,
+};
+
+struct PackedAttribute
+{
+    const cmod::VertexAttribute* source;
+    PackedFormat format;
+    gl::VertexObject::DataType type;
+    int components;
+    bool normalized;
+    int size;
+    int offset;
+};
+
+struct PackedLayout
 {
+    std::vector<PackedAttribute> attributes;
+    int strideBytes{ 0 };
+    bool isCopy{ true };
+};
+
+// The attributes in the vertex buffer; with compact vertices, normals and
+// tangents are normalized integers and texture coordinates half floats, which
+// the vertex fetch converts, so the shaders are the same
+PackedLayout
+getPackedLayout(const cmod::VertexDescription& desc)
+{
+#ifdef GL_ES
+    bool hasPackedTypes = celestia::gl::checkVersion(celestia::gl::GLES_3);
+#else
+    bool hasPackedTypes = celestia::gl::checkVersion(celestia::gl::GL_3_3);
+#endif
+
+    PackedLayout layout;
     for (const auto &attribute : desc.attributes)
     {
         if (attribute.semantic == cmod::VertexAttributeSemantic::InvalidSemantic)
             continue;
 
+        auto format = static_cast<std::size_t>(attribute.format);
+        PackedAttribute& packed = layout.attributes.emplace_back(PackedAttribute{
+            &attribute,
+            PackedFormat::Copy,
+            GLComponentTypes[format],
+            GLComponentCounts[format],
+            GLComponentNormalized[format],
+            static_cast<int>(cmod::VertexAttribute::getFormatSizeWords(attribute.format) * sizeof(cmod::VWord)),
+            layout.strideBytes,
+        });
+
+        if (!compactVertices)
+        {
+            layout.strideBytes += packed.size;
+            continue;
+        }
+
+        if ((attribute.semantic == cmod::VertexAttributeSemantic::Normal ||
+             attribute.semantic == cmod::VertexAttributeSemantic::Tangent) &&
+            attribute.format == cmod::VertexAttributeFormat::Float3)
+        {
+            if (hasPackedTypes)
+            {
+                packed.format = PackedFormat::Normal1010102;
+                packed.type = gl::VertexObject::DataType::Int2101010Rev;
+                packed.size = 4;
+            }
+            else
+            {
+                packed.format = PackedFormat::NormalShort4;
+                packed.type = gl::VertexObject::DataType::Short;
+                packed.size = 8;
+            }
+            packed.components = 4;
+            packed.normalized = true;
+        }
+        else if (attribute.semantic == cmod::VertexAttributeSemantic::Texture0 &&
+                 attribute.format == cmod::VertexAttributeFormat::Float2 &&
+                 hasPackedTypes)
+        {
+            packed.format = PackedFormat::Half2;
+            packed.type = gl::VertexObject::DataType::Half;
+            packed.size = 4;
+        }
+
+        layout.strideBytes += packed.size;
+    }
+
+    layout.isCopy = layout.strideBytes == static_cast<int>(desc.strideBytes) &&
+                    std::all_of(layout.attributes.cbegin(), layout.attributes.cend(),
+                                [](const PackedAttribute& packed) { return packed.format == PackedFormat::Copy; });
+    return layout;
+}
+
+Eigen::Vector3f
+readDirection(const cmod::VWord* data)
+{
+    float fv[3];
+    std::memcpy(fv, data, sizeof(fv));
+    Eigen::Vector3f v(fv[0], fv[1], fv[2]);
+    float length = v.norm();
+    return length > 0.0f ? Eigen::Vector3f(v / length) : v;
+}
+
+std::uint32_t
+packSnorm10(float x)
+{
+    auto value = static_cast<std::int32_t>(std::lround(std::clamp(x, -1.0f, 1.0f) * 511.0f));
+    return static_cast<std::uint32_t>(value) & 0x3ffU;
+}
+
+std::int16_t
+packSnorm16(float x)
+{
+    return static_cast<std::int16_t>(std::lround(std::clamp(x, -1.0f, 1.0f) * 32767.0f));
+}
+
+void
+packVertices(const cmod::Mesh& mesh, const PackedLayout& layout, std::vector<std::uint8_t>& data)
+{
+    data.resize(static_cast<std::size_t>(mesh.getVertexCount()) * layout.strideBytes);
+    unsigned int sourceStride = mesh.getVertexStrideWords();
+    for (unsigned int i = 0; i < mesh.getVertexCount(); ++i)
+    {
+        const cmod::VWord* vertex = mesh.getVertexData() + i * sourceStride;
+        std::uint8_t* packedVertex = data.data() + static_cast<std::size_t>(i) * layout.strideBytes;
+        for (const PackedAttribute& packed : layout.attributes)
+        {
+            const cmod::VWord* source = vertex + packed.source->offsetWords;
+            std::uint8_t* destination = packedVertex + packed.offset;
+            switch (packed.format)
+            {
+            case PackedFormat::Copy:
+                std::memcpy(destination, source, packed.size);
+                break;
+            case PackedFormat::Normal1010102:
+                {
+                    Eigen::Vector3f v = readDirection(source);
+                    std::uint32_t value = packSnorm10(v.x()) | (packSnorm10(v.y()) << 10) | (packSnorm10(v.z()) << 20);
+                    std::memcpy(destination, &value, sizeof(value));
+                }
+                break;
+            case PackedFormat::NormalShort4:
+                {
+                    Eigen::Vector3f v = readDirection(source);
+                    std::array<std::int16_t, 4> value{ packSnorm16(v.x()), packSnorm16(v.y()), packSnorm16(v.z()), 0 };
+                    std::memcpy(destination, value.data(), sizeof(value));
+                }
+                break;
+            case PackedFormat::Half2:
+                {
+                    float fv[2];
+                    std::memcpy(fv, source, sizeof(fv));
+                    std::array<std::uint16_t, 2> value{ Eigen::half(fv[0]).x, Eigen::half(fv[1]).x };
+                    std::memcpy(destination, value.data(), sizeof(value));
+                }
+                break;
+            }
+        }
+    }
+}
+
+void
+setVertexArrays(gl::VertexObject &vao, const gl::Buffer &vbo, const PackedLayout& layout)
+{
+    for (const auto &packed : layout.attributes)
+    {
         vao.addVertexBuffer(
             vbo,
-            convert(attribute.semantic),
-            GLComponentCounts[static_cast<std::size_t>(attribute.format)],
-            GLComponentTypes[static_cast<std::size_t>(attribute.format)],
-            GLComponentNormalized[static_cast<std::size_t>(attribute.format)],
-            desc.strideBytes,
-            attribute.offsetWords * sizeof(cmod::VWord));
+            convert(packed.source->semantic),
+            packed.components,
+            packed.type,
+            packed.normalized,
+            layout.strideBytes,
+            packed.offset);
     }
 }
 
+bool
+isListPrimitive(cmod::PrimitiveGroupType prim)
+{
+    return prim == cmod::PrimitiveGroupType::TriList ||
+           prim == cmod::PrimitiveGroupType::LineList ||
+           prim == cmod::PrimitiveGroupType::PointList ||
+           prim == cmod::PrimitiveGroupType::SpriteList;
+}
+
+// Merge adjacent ranges of lists; strips and fans can't be joined
+void
+appendRange(std::vector<int>& counts, std::vector<int>& firsts, bool isList, int count, int first)
+{
+    if (count == 0)
+        return;
+
+    if (isList && !counts.empty() && firsts.back() + counts.back() == first)
+    {
+        counts.back() += count;
+    }
+    else
+    {
+        counts.push_back(count);
+        firsts.push_back(first);
+    }
+}
+
+// The box around the vertices used by the group, including the size of
+// point sprites; empty if the positions aren't three floats
+Eigen::AlignedBox<float, 3>
+getGroupBounds(const cmod::Mesh& mesh, const cmod::PrimitiveGroup& group)
+{
+    Eigen::AlignedBox<float, 3> bounds;
+    const cmod::VertexDescription& desc = mesh.getVertexDescription();
+    const cmod::VertexAttribute& position = desc.getAttribute(cmod::VertexAttributeSemantic::Position);
+    if (position.format != cmod::VertexAttributeFormat::Float3)
+        return bounds;
+
+    const cmod::VertexAttribute& pointSize = desc.getAttribute(cmod::VertexAttributeSemantic::PointSize);
+    bool hasPointSize = pointSize.format == cmod::VertexAttributeFormat::Float1;
+    unsigned int stride = mesh.getVertexStrideWords();
+    for (cmod::Index32 index : group.indices)
+    {
+        if (index >= mesh.getVertexCount())
+            continue;
+
+        const cmod::VWord* vertex = mesh.getVertexData() + static_cast<std::size_t>(index) * stride;
+        float fv[3];
+        std::memcpy(fv, vertex + position.offsetWords, sizeof(fv));
+        Eigen::Vector3f center(fv[0], fv[1], fv[2]);
+        if (hasPointSize)
+        {
+            float size;
+            std::memcpy(&size, vertex + pointSize.offsetWords, sizeof(size));
+            bounds.extend(center - Eigen::Vector3f::Constant(size));
+            bounds.extend(center + Eigen::Vector3f::Constant(size));
+        }
+        else
+        {
+            bounds.extend(center);
+        }
+    }
+
+    return bounds;
+}
+
 } // anonymous namespace
 
 
 class ModelOpenGLData
 {
 public:
+    // Consecutive groups of one batch with the same material and primitive
+    // type, drawn together
+    struct DrawRun
+    {
+        std::size_t batch;
+        unsigned int materialIndex;
+        cmod::PrimitiveGroupType prim;
+        // The index ranges at each level of detail
+        std::vector<std::vector<int>> counts;
+        std::vector<std::vector<int>> firsts;
+        // The bounding spheres of the groups in the run, and the count and
+        // first index of each group at each level of detail, for drawing
+        // only the groups in view
+        std::vector<Eigen::Vector3f> centers;
+        std::vector<float> radii;
+        std::vector<std::vector<std::pair<int, int>>> groupRanges;
+    };
+
+    void build(const cmod::Model&);
+    unsigned int selectLOD(float maxError) const;
+    // Collects the ranges of the groups of the run in the frustum into
+    // visibleCounts and visibleFirsts
+    void cullRun(const DrawRun&, unsigned int level, const math::Frustum&);
+
+    // Meshes with the same vertex description share the buffers of a batch
+    std::vector<const cmod::VertexDescription*> batchDescs;
     std::vector<gl::Buffer> vbos; // vertex buffer objects
     std::vector<gl::Buffer> vios; // vertex index objects
     std::vector<gl::VertexObject> vaos; // vertex attributes
+    std::vector<DrawRun> runs;
+    // The largest error of the meshes at each level of detail after the full
+    // one; a mesh with fewer levels uses its coarsest at the higher ones
+    std::vector<float> lodErrors;
+
+    // Sphere around all the groups; groups without bounds have a negative
+    // radius and disable culling
+    Eigen::Vector3f center{ Eigen::Vector3f::Zero() };
+    float radius{ -1.0f };
+
+    // Size of the vertex and index buffers
+    std::size_t bufferMemory{ 0 };
+
+    std::vector<int> visibleCounts;
+    std::vector<int> visibleFirsts;
 };
 
 
+void
+ModelOpenGLData::build(const cmod::Model& model)
+{
+    struct GroupEntry
+    {
+        std::size_t batch;
+        const cmod::PrimitiveGroup* group;
+        std::vector<std::pair<int, int>> ranges; // count and first per level
+        Eigen::AlignedBox<float, 3> bounds;
+    };
+
+    unsigned int lodCount = 1;
+    std::vector<std::size_t> meshBatches;
+    std::vector<unsigned int> baseVertices;
+    std::vector<unsigned int> batchVertexCounts;
+    for (unsigned int i = 0; i < model.getMeshCount(); ++i)
+    {
+        const cmod::Mesh* mesh = model.getMesh(i);
+        lodCount = std::max(lodCount, mesh->getLODCount());
+
+        const cmod::VertexDescription& vertexDesc = mesh->getVertexDescription();
+        auto it = std::find_if(batchDescs.cbegin(), batchDescs.cend(),
+                               [&vertexDesc](const cmod::VertexDescription* desc) { return *desc == vertexDesc; });
+        auto batch = static_cast<std::size_t>(it - batchDescs.cbegin());
+        if (it == batchDescs.cend())
+        {
+            batchDescs.push_back(&vertexDesc);
+            batchVertexCounts.push_back(0);
+        }
+
+        meshBatches.push_back(batch);
+        baseVertices.push_back(batchVertexCounts[batch]);
+        batchVertexCounts[batch] += mesh->getVertexCount();
+    }
+
+    for (unsigned int level = 1; level < lodCount; ++level)
+    {
+        float error = 0.0f;
+        for (unsigned int i = 0; i < model.getMeshCount(); ++i)
+        {
+            const cmod::Mesh* mesh = model.getMesh(i);
+            error = std::max(error, mesh->getLODError(std::min(level, mesh->getLODCount() - 1)));
+        }
+        lodErrors.push_back(error);
+    }
+
+    // The indices of the meshes are offset by their first vertex in the
+    // batch, so that they can be drawn without base vertices
+    std::vector<std::vector<cmod::Index32>> batchIndices(batchDescs.size());
+    std::vector<GroupEntry> entries;
+    for (unsigned int i = 0; i < model.getMeshCount(); ++i)
+    {
+        const cmod::Mesh* mesh = model.getMesh(i);
+        std::size_t batch = meshBatches[i];
+        cmod::Index32 baseVertex = baseVertices[i];
+        auto& indices = batchIndices[batch];
+        auto appendIndices = [&indices, baseVertex](const std::vector<cmod::Index32>& groupIndices)
+        {
+            auto first = static_cast<int>(indices.size());
+            std::transform(groupIndices.begin(), groupIndices.end(), std::back_inserter(indices),
+                           [baseVertex](cmod::Index32 index) { return index + baseVertex; });
+            return std::make_pair(static_cast<int>(groupIndices.size()), first);
+        };
+
+        for (unsigned int groupIndex = 0; groupIndex < mesh->getGroupCount(); ++groupIndex)
+        {
+            const cmod::PrimitiveGroup* group = mesh->getGroup(groupIndex);
+            GroupEntry& entry = entries.emplace_back(GroupEntry{ batch, group, {}, getGroupBounds(*mesh, *group) });
+            entry.ranges.push_back(appendIndices(group->indices));
+
+            // Groups which aren't simplified draw their full indices
+            for (unsigned int level = 1; level < lodCount; ++level)
+            {
+                unsigned int meshLevel = std::min(level, mesh->getLODCount() - 1);
+                if (meshLevel == 0 || meshLevel > group->lodIndices.size())
+                    entry.ranges.push_back(entry.ranges.front());
+                else if (level > meshLevel)
+                    entry.ranges.push_back(entry.ranges.back());
+                else
+                    entry.ranges.push_back(appendIndices(group->lodIndices[meshLevel - 1]));
+            }
+        }
+    }
+
+    // Keep the order of the meshes, which are sorted so that opaque
+    // materials come first
+    std::stable_sort(entries.begin(), entries.end(),
+                     [](const GroupEntry& a, const GroupEntry& b)
+                     {
+                         return std::make_tuple(b.group->materialIndex, a.batch, a.group->prim) <
+                                std::make_tuple(a.group->materialIndex, b.batch, b.group->prim);
+                     });
+
+    Eigen::AlignedBox<float, 3> modelBounds;
+    bool bounded = true;
+    for (const GroupEntry& entry : entries)
+    {
+        if (entry.bounds.isEmpty())
+            bounded = bounded && entry.group->indices.empty();
+        else
+            modelBounds.extend(entry.bounds);
+    }
+
+    if (bounded && !modelBounds.isEmpty())
+    {
+        center = modelBounds.center();
+        radius = modelBounds.diagonal().norm() * 0.5f;
+    }
+
+    for (const GroupEntry& entry : entries)
+    {
+        if (runs.empty() ||
+            std::tie(runs.back().batch, runs.back().materialIndex, runs.back().prim) !=
+            std::tie(entry.batch, entry.group->materialIndex, entry.group->prim))
+        {
+            runs.push_back(DrawRun{ entry.batch, entry.group->materialIndex, entry.group->prim,
+                                    std::vector<std::vector<int>>(lodCount),
+                                    std::vector<std::vector<int>>(lodCount),
+                                    {}, {}, {} });
+        }
+
+        DrawRun& run = runs.back();
+        bool isList = isListPrimitive(entry.group->prim);
+        for (unsigned int level = 0; level < lodCount; ++level)
+        {
+            auto [count, first] = entry.ranges[level];
+            appendRange(run.counts[level], run.firsts[level], isList, count, first);
+        }
+
+        if (radius >= 0.0f && !entry.group->indices.empty())
+        {
+            run.centers.push_back(entry.bounds.center());
+            run.radii.push_back(entry.bounds.diagonal().norm() * 0.5f);
+            run.groupRanges.push_back(entry.ranges);
+        }
+    }
+
+    std::vector<std::uint8_t> packedVertices;
+    for (std::size_t batch = 0; batch < batchDescs.size(); ++batch)
+    {
+        PackedLayout layout = getPackedLayout(*batchDescs[batch]);
+        std::size_t stride = layout.strideBytes;
+        gl::Buffer& vbo = vbos.emplace_back(gl::Buffer::TargetHint::Array);
+        vbo.setData(util::array_view<const void>(nullptr, batchVertexCounts[batch] * stride));
+        bufferMemory += batchVertexCounts[batch] * stride + batchIndices[batch].size() * sizeof(cmod::Index32);
+        for (unsigned int i = 0; i < model.getMeshCount(); ++i)
+        {
+            if (meshBatches[i] != batch)
+                continue;
+
+            const cmod::Mesh* mesh = model.getMesh(i);
+            if (layout.isCopy)
+            {
+                vbo.setSubData(static_cast<GLintptr>(baseVertices[i] * stride),
+                               util::array_view<const void>(mesh->getVertexData(),
+                                                            mesh->getVertexCount() * stride));
+            }
+            else
+            {
+                packVertices(*mesh, layout, packedVertices);
+                vbo.setSubData(static_cast<GLintptr>(baseVertices[i] * stride),
+                               util::array_view<const void>(packedVertices.data(), packedVertices.size()));
+            }
+        }
+
+        vios.emplace_back(gl::Buffer::TargetHint::ElementArray, batchIndices[batch]);
+
+        gl::VertexObject vao;
+        setVertexArrays(vao, vbos.back(), layout);
+        vao.setIndexBuffer(vios.back(), 0, gl::VertexObject::IndexType::UnsignedInt);
+        vaos.emplace_back(std::move(vao));
+    }
+}
+
+
+void
+ModelOpenGLData::cullRun(const DrawRun& run, unsigned int level, const math::Frustum& frustum)
+{
+    visibleCounts.clear();
+    visibleFirsts.clear();
+    bool isList = isListPrimitive(run.prim);
+    for (std::size_t i = 0; i < run.centers.size(); ++i)
+    {
+        if (frustum.testSphere(run.centers[i], run.radii[i]) == math::FrustumAspect::Outside)
+            continue;
+
+        auto [count, first] = run.groupRanges[i][level];
+        appendRange(visibleCounts, visibleFirsts, isList, count, first);
+    }
+}
+
+
+unsigned int
+ModelOpenGLData::selectLOD(float maxError) const
+{
+    // Errors grow with the level
+    auto it = std::upper_bound(lodErrors.cbegin(), lodErrors.cend(), maxError);
+    return static_cast<unsigned int>(it - lodErrors.cbegin());
+}
+
+
 /** Create a new ModelGeometry wrapping the specified model.
   * The ModelGeoemtry takes ownership of the model.
   */
@@ -118,7 +604,10 @@ ModelGeometry::ModelGeometry(std::unique_ptr<cmod::Model>&& model) :
 
 
 // Needs to be defined at a point where ModelOpenGLData is complete
-ModelGeometry::~ModelGeometry() = default;
+ModelGeometry::~ModelGeometry()
+{
+    totalBufferMemory -= m_glData->bufferMemory;
+}
 
 
 bool
@@ -144,66 +633,49 @@ ModelGeometry::render(RenderContext& rc, double /* t */)
     if (!m_vbInitialized)
     {
         m_vbInitialized = true;
+        m_glData->build(*m_model);
+        totalBufferMemory += m_glData->bufferMemory;
+    }
 
-        std::vector<cmod::Index32> indices;
-        for (unsigned int i = 0; i < m_model->getMeshCount(); ++i)
-        {
-            const cmod::Mesh* mesh = m_model->getMesh(i);
-            const cmod::VertexDescription& vertexDesc = mesh->getVertexDescription();
-
-            m_glData->vbos.emplace_back(
-                gl::Buffer::TargetHint::Array,
-                util::array_view<const void>(
-                    mesh->getVertexData(),
-                    mesh->getVertexCount() * vertexDesc.strideBytes));
+    unsigned int level = 0;
+    if (float pixelScale = rc.getPixelScale(); pixelScale > 0.0f)
+        level = m_glData->selectLOD(MaxLODErrorPixels / pixelScale);
 
-            indices.reserve(std::max(indices.capacity(), static_cast<std::size_t>(mesh->getIndexCount())));
-            for (unsigned int groupIndex = 0; groupIndex < mesh->getGroupCount(); ++groupIndex)
-            {
-                const auto* group = mesh->getGroup(groupIndex);
-                std::copy(group->indices.begin(), group->indices.end(), std::back_inserter(indices));
-            }
-            m_glData->vios.emplace_back(gl::Buffer::TargetHint::ElementArray, indices);
-            indices.clear();
-
-            gl::VertexObject vao;
-            setVertexArrays(vao, m_glData->vbos.back(), mesh->getVertexDescription());
-            vao.setIndexBuffer(m_glData->vios.back(), 0, gl::VertexObject::IndexType::UnsignedInt);
-            m_glData->vaos.emplace_back(std::move(vao));
-        }
+    // Only the groups of models partly in view are tested against the
+    // frustum
+    const math::Frustum* frustum = rc.getFrustum();
+    bool cull = false;
+    if (frustum != nullptr && m_glData->radius >= 0.0f)
+    {
+        auto aspect = frustum->testSphere(m_glData->center, m_glData->radius);
+        if (aspect == math::FrustumAspect::Outside)
+            return;
+        cull = aspect == math::FrustumAspect::Intersect;
     }
 
-    unsigned int lastMaterial = ~0u;
     unsigned int materialCount = m_model->getMaterialCount();
-
-    // Iterate over all meshes in the model
-    for (unsigned int meshIndex = 0; meshIndex < m_model->getMeshCount(); ++meshIndex)
+    for (const auto& run : m_glData->runs)
     {
-        const cmod::Mesh* mesh = m_model->getMesh(meshIndex);
-
-        if (meshIndex >= m_glData->vbos.size())
+        util::array_view<int> counts = run.counts[level];
+        util::array_view<int> firsts = run.firsts[level];
+        if (cull)
         {
-            GetLogger()->error(_("Mesh index {} is higher than VBO count {}!"), meshIndex, m_glData->vbos.size());
-            return;
+            m_glData->cullRun(run, level, *frustum);
+            if (m_glData->visibleCounts.empty())
+                continue;
+            counts = m_glData->visibleCounts;
+            firsts = m_glData->visibleFirsts;
         }
 
-        // Iterate over all primitive groups in the mesh
-        for (unsigned int groupIndex = 0; groupIndex < mesh->getGroupCount(); ++groupIndex)
-        {
-            const cmod::PrimitiveGroup* group = mesh->getGroup(groupIndex);
-            rc.updateShader(mesh->getVertexDescription(), group->prim);
+        rc.updateShader(*m_glData->batchDescs[run.batch], run.prim);
 
-            // Set up the material
-            const cmod::Material* material = nullptr;
-            unsigned int materialIndex = group->materialIndex;
-            if (materialIndex != lastMaterial && materialIndex < materialCount)
-            {
-                material = m_model->getMaterial(materialIndex);
-            }
+        // Set up the material
+        const cmod::Material* material = nullptr;
+        if (run.materialIndex < materialCount)
+            material = m_model->getMaterial(run.materialIndex);
 
-            rc.setMaterial(material);
-            rc.drawGroup(m_glData->vaos[meshIndex], *group);
-        }
+        rc.setMaterial(material);
+        rc.drawGroups(m_glData->vaos[run.batch], run.prim, counts, firsts);
     }
 }
 
@@ -246,3 +718,17 @@ ModelGeometry::loadTextures()
     }
 #endif
 }
+
+
+void
+ModelGeometry::setCompactVertices(bool enable)
+{
+    compactVertices = enable;
+}
+
+
+std::size_t
+ModelGeometry::getTotalBufferMemory()
+{
+    return totalBufferMemory;
+}
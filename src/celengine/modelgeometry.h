@@ -10,6 +10,7 @@
 
 #pragma once
 
+#include <cstddef>
 #include <memory>
 
 #include <Eigen/Geometry>
@@ -43,6 +44,15 @@ public:
 
     void loadTextures() override;
 
+    // Store normals and tangents as normalized integers and texture
+    // coordinates as half floats in the vertex buffers of models created
+    // later, which takes less graphics memory at a small loss of precision
+    static void setCompactVertices(bool enable);
+
+    // Graphics memory of the vertex and index buffers of the models which
+    // have been drawn, summed over all the models which still exist
+    static std::size_t getTotalBufferMemory();
+
 private:
     std::unique_ptr<cmod::Model> m_model;
     std::unique_ptr<ModelOpenGLData> m_glData;
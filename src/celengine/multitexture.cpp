@@ -99,6 +99,15 @@ Texture* MultiResTexture::find(TextureResolution resolution)
         break;
     }
 
+    if (texMan->getState(tex[resolutionIndex]) == ResourceState::Pending)
+    {
+        // Still loading in the background: draw with another resolution if
+        // one is loaded already, without loading it, or else untextured
+        if (Texture* loaded = texMan->findLoaded(tex[secondChoice]); loaded != nullptr)
+            return loaded;
+        return texMan->findLoaded(tex[lastResort]);
+    }
+
     tex[resolutionIndex] = tex[secondChoice];
     res = texMan->find(tex[resolutionIndex]);
     if (res != nullptr)
@@ -1,14 +1,46 @@
 #include "name.h"
 
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <ostream>
+#include <unordered_map>
 #include <utility>
 
 #ifdef DEBUG
 #include <celutil/logger.h>
 #endif
+#include <celengine/memoryreport.h>
+#include <celutil/binaryread.h>
+#include <celutil/binarywrite.h>
 #include <celutil/gettext.h>
 #include <celutil/greek.h>
 #include <celutil/utf8.h>
 
+using namespace std::string_view_literals;
+
+namespace util = celestia::util;
+
+namespace
+{
+
+// Binary name index layout, all values little-endian:
+//   header:  magic[8], version (u16), reserved (u16), index entry count,
+//            number entry count, string size (u32)
+//   index:   name offset, folded name offset (u32), name length, folded
+//            name length (u16), catalog number (u32), sorted by folded name
+//   numbers: catalog number, name offset (u32), name length (u16),
+//            reserved (u16), sorted by catalog number
+//   strings
+constexpr std::string_view NameIndexMagic = "CELNAMES"sv;
+constexpr std::uint16_t NameIndexVersion = 1;
+
+constexpr std::size_t HeaderSize = 8 + 2 + 2 + 4 + 4 + 4;
+constexpr std::size_t IndexRecordSize = 4 + 4 + 2 + 2 + 4;
+constexpr std::size_t NumberRecordSize = 4 + 4 + 2 + 2;
+
+} // end unnamed namespace
+
 void
 NameDatabase::add(const AstroCatalog::IndexNumber catalogNumber, std::string_view name)
 {
@@ -42,12 +74,16 @@ NameDatabase::getCatalogNumberByName(std::string_view name, [[maybe_unused]] boo
 {
     if (auto iter = nameIndex.find(name); iter != nameIndex.end())
         return iter->second;
+    if (auto catalogNumber = findInIndex(name, false); catalogNumber != AstroCatalog::InvalidIndex)
+        return catalogNumber;
 
-#if ENABLE_NLS
+#ifdef ENABLE_NLS
     if (i18n)
     {
         if (auto iter = localizedNameIndex.find(name); iter != localizedNameIndex.end())
             return iter->second;
+        if (auto catalogNumber = findInIndex(name, true); catalogNumber != AstroCatalog::InvalidIndex)
+            return catalogNumber;
     }
 #endif
 
@@ -84,6 +120,8 @@ NameDatabase::getFinalNameIter() const
 void
 NameDatabase::getCompletion(std::vector<std::pair<std::string, AstroCatalog::IndexNumber>>& completion, std::string_view name) const
 {
+    auto first = static_cast<std::ptrdiff_t>(completion.size());
+
     std::string name2 = ReplaceGreekLetter(name);
     for (const auto &[n, index] : nameIndex)
     {
@@ -98,4 +136,321 @@ NameDatabase::getCompletion(std::vector<std::pair<std::string, AstroCatalog::Ind
             completion.emplace_back(n, index);
     }
 #endif
+
+    std::string prefix = UTF8FoldCase(name2);
+    auto it = std::lower_bound(index.begin(), index.end(), prefix,
+                               [this](const IndexEntry& entry, std::string_view key)
+                               { return getFoldedName(entry) < key; });
+    for (; it != index.end() && getFoldedName(*it).substr(0, prefix.size()) == prefix; ++it)
+        completion.emplace_back(getName(*it), it->catalogNumber);
+
+    std::stable_sort(completion.begin() + first, completion.end(),
+                     [](const auto& a, const auto& b) { return a.first.size() < b.first.size(); });
+}
+
+void
+NameDatabase::freeze()
+{
+    // Nothing to merge, e.g. after loading a binary index
+#ifdef ENABLE_NLS
+    if (nameIndex.empty() && localizedNameIndex.empty())
+#else
+    if (nameIndex.empty())
+#endif
+        return;
+
+    std::vector<std::pair<std::string, const NameIndex::value_type*>> names;
+    names.reserve(nameIndex.size());
+    for (const auto& entry : nameIndex)
+        names.emplace_back(UTF8FoldCase(entry.first), &entry);
+
+    std::size_t nonLocalized = names.size();
+#ifdef ENABLE_NLS
+    for (const auto& entry : localizedNameIndex)
+        names.emplace_back(UTF8FoldCase(entry.first), &entry);
+#endif
+
+    std::vector<IndexEntry> newIndex;
+    newIndex.reserve(index.size() + names.size());
+    std::string newStrings;
+
+    auto addEntry = [&newIndex, &newStrings](std::string_view name,
+                                             std::string_view folded,
+                                             AstroCatalog::IndexNumber catalogNumber,
+                                             bool localized)
+    {
+        constexpr auto maxLength = static_cast<std::size_t>(std::numeric_limits<std::uint16_t>::max());
+        if (name.size() > maxLength || folded.size() > maxLength)
+            return;
+
+        auto& entry = newIndex.emplace_back();
+        entry.nameOffset = static_cast<std::uint32_t>(newStrings.size());
+        entry.nameLength = static_cast<std::uint16_t>(name.size());
+        newStrings.append(name);
+        if (folded == name)
+        {
+            entry.foldedOffset = entry.nameOffset;
+        }
+        else
+        {
+            entry.foldedOffset = static_cast<std::uint32_t>(newStrings.size());
+            newStrings.append(folded);
+        }
+        entry.foldedLength = static_cast<std::uint16_t>(folded.size());
+        entry.catalogNumber = catalogNumber;
+        entry.localized = localized;
+    };
+
+    // Names added since the last call replace the ones already in the index
+    for (const auto& entry : index)
+    {
+        std::string_view name = getName(entry);
+#ifdef ENABLE_NLS
+        const NameIndex& added = entry.localized ? localizedNameIndex : nameIndex;
+#else
+        const NameIndex& added = nameIndex;
+#endif
+        if (added.find(name) == added.end())
+            addEntry(name, getFoldedName(entry), entry.catalogNumber, entry.localized);
+    }
+
+    for (std::size_t i = 0; i < names.size(); ++i)
+        addEntry(names[i].second->first, names[i].first, names[i].second->second, i >= nonLocalized);
+
+    std::stable_sort(newIndex.begin(), newIndex.end(),
+                     [&newStrings](const IndexEntry& a, const IndexEntry& b)
+                     {
+                         return std::string_view(newStrings).substr(a.foldedOffset, a.foldedLength)
+                              < std::string_view(newStrings).substr(b.foldedOffset, b.foldedLength);
+                     });
+
+    newStrings.shrink_to_fit();
+    indexStrings = std::move(newStrings);
+    index = std::move(newIndex);
+
+    nameIndex.clear();
+#ifdef ENABLE_NLS
+    localizedNameIndex.clear();
+#endif
+}
+
+std::string_view
+NameDatabase::getName(const IndexEntry& entry) const
+{
+    return std::string_view(indexStrings).substr(entry.nameOffset, entry.nameLength);
+}
+
+std::string_view
+NameDatabase::getFoldedName(const IndexEntry& entry) const
+{
+    return std::string_view(indexStrings).substr(entry.foldedOffset, entry.foldedLength);
+}
+
+AstroCatalog::IndexNumber
+NameDatabase::findInIndex(std::string_view name, bool localized) const
+{
+    if (index.empty())
+        return AstroCatalog::InvalidIndex;
+
+    // Names which only differ in case fold to the same key, so look for the
+    // one matching the way the name index compares them
+    std::string folded = UTF8FoldCase(name);
+    auto it = std::lower_bound(index.begin(), index.end(), folded,
+                               [this](const IndexEntry& entry, std::string_view key)
+                               { return getFoldedName(entry) < key; });
+    for (; it != index.end() && getFoldedName(*it) == folded; ++it)
+    {
+        if (it->localized == localized && compareIgnoringCase(getName(*it), name) == 0)
+            return it->catalogNumber;
+    }
+
+    return AstroCatalog::InvalidIndex;
+}
+
+bool
+NameDatabase::writeIndex(std::ostream& out) const
+{
+    // Only the frozen index is written
+#ifdef ENABLE_NLS
+    if (!nameIndex.empty() || !localizedNameIndex.empty())
+#else
+    if (!nameIndex.empty())
+#endif
+        return false;
+
+    constexpr auto maxLength = static_cast<std::size_t>(std::numeric_limits<std::uint16_t>::max());
+
+    // The names of the number index are mostly in the frozen index already
+    std::string strings = indexStrings;
+    std::unordered_map<std::string_view, std::uint32_t> offsets;
+    for (const auto& entry : index)
+    {
+        if (!entry.localized)
+            offsets.try_emplace(getName(entry), entry.nameOffset);
+    }
+
+    struct NumberRecord
+    {
+        AstroCatalog::IndexNumber catalogNumber;
+        std::uint32_t nameOffset;
+        std::uint16_t nameLength;
+    };
+
+    std::vector<NumberRecord> numberRecords;
+    numberRecords.reserve(numberIndex.size());
+    for (const auto& [catalogNumber, name] : numberIndex)
+    {
+        if (name.size() > maxLength)
+            continue;
+
+        auto& record = numberRecords.emplace_back();
+        record.catalogNumber = catalogNumber;
+        record.nameLength = static_cast<std::uint16_t>(name.size());
+        if (auto it = offsets.find(name); it != offsets.end())
+        {
+            record.nameOffset = it->second;
+        }
+        else
+        {
+            record.nameOffset = static_cast<std::uint32_t>(strings.size());
+            strings.append(name);
+        }
+    }
+
+    auto nIndex = static_cast<std::uint32_t>(std::count_if(index.begin(), index.end(),
+                                                           [](const IndexEntry& entry) { return !entry.localized; }));
+    if (strings.size() > std::numeric_limits<std::uint32_t>::max())
+        return false;
+
+    out.write(NameIndexMagic.data(), NameIndexMagic.size());
+    if (!util::writeLE<std::uint16_t>(out, NameIndexVersion) ||
+        !util::writeLE<std::uint16_t>(out, 0) ||
+        !util::writeLE<std::uint32_t>(out, nIndex) ||
+        !util::writeLE<std::uint32_t>(out, static_cast<std::uint32_t>(numberRecords.size())) ||
+        !util::writeLE<std::uint32_t>(out, static_cast<std::uint32_t>(strings.size())))
+    {
+        return false;
+    }
+
+    for (const auto& entry : index)
+    {
+        if (entry.localized)
+            continue;
+
+        util::writeLE<std::uint32_t>(out, entry.nameOffset);
+        util::writeLE<std::uint32_t>(out, entry.foldedOffset);
+        util::writeLE<std::uint16_t>(out, entry.nameLength);
+        util::writeLE<std::uint16_t>(out, entry.foldedLength);
+        util::writeLE<std::uint32_t>(out, entry.catalogNumber);
+    }
+
+    for (const auto& record : numberRecords)
+    {
+        util::writeLE<std::uint32_t>(out, record.catalogNumber);
+        util::writeLE<std::uint32_t>(out, record.nameOffset);
+        util::writeLE<std::uint16_t>(out, record.nameLength);
+        util::writeLE<std::uint16_t>(out, 0);
+    }
+
+    out.write(strings.data(), static_cast<std::streamsize>(strings.size()));
+    return out.good();
+}
+
+bool
+NameDatabase::isIndex(const char* data, std::size_t size)
+{
+    return size >= NameIndexMagic.size() && std::string_view(data, NameIndexMagic.size()) == NameIndexMagic;
+}
+
+bool
+NameDatabase::readIndex(const char* data, std::size_t size)
+{
+    if (size < HeaderSize || !isIndex(data, size) ||
+        util::fromMemoryLE<std::uint16_t>(data + 8) != NameIndexVersion)
+    {
+        return false;
+    }
+
+    auto nIndex = static_cast<std::size_t>(util::fromMemoryLE<std::uint32_t>(data + 12));
+    auto nNumbers = static_cast<std::size_t>(util::fromMemoryLE<std::uint32_t>(data + 16));
+    auto stringSize = static_cast<std::size_t>(util::fromMemoryLE<std::uint32_t>(data + 20));
+    if (size != HeaderSize + nIndex * IndexRecordSize + nNumbers * NumberRecordSize + stringSize)
+        return false;
+
+    const char* indexData = data + HeaderSize;
+    const char* numberData = indexData + nIndex * IndexRecordSize;
+    std::string_view strings(numberData + nNumbers * NumberRecordSize, stringSize);
+
+    std::vector<IndexEntry> newIndex;
+    newIndex.reserve(nIndex);
+    for (std::size_t i = 0; i < nIndex; ++i)
+    {
+        const char* ptr = indexData + i * IndexRecordSize;
+        auto& entry = newIndex.emplace_back();
+        entry.nameOffset = util::fromMemoryLE<std::uint32_t>(ptr);
+        entry.foldedOffset = util::fromMemoryLE<std::uint32_t>(ptr + 4);
+        entry.nameLength = util::fromMemoryLE<std::uint16_t>(ptr + 8);
+        entry.foldedLength = util::fromMemoryLE<std::uint16_t>(ptr + 10);
+        entry.catalogNumber = util::fromMemoryLE<AstroCatalog::IndexNumber>(ptr + 12);
+        entry.localized = false;
+        if (static_cast<std::size_t>(entry.nameOffset) + entry.nameLength > stringSize ||
+            static_cast<std::size_t>(entry.foldedOffset) + entry.foldedLength > stringSize)
+        {
+            return false;
+        }
+    }
+
+    NumberIndex newNumberIndex;
+    for (std::size_t i = 0; i < nNumbers; ++i)
+    {
+        const char* ptr = numberData + i * NumberRecordSize;
+        auto catalogNumber = util::fromMemoryLE<AstroCatalog::IndexNumber>(ptr);
+        auto offset = static_cast<std::size_t>(util::fromMemoryLE<std::uint32_t>(ptr + 4));
+        auto length = static_cast<std::size_t>(util::fromMemoryLE<std::uint16_t>(ptr + 8));
+        if (offset + length > stringSize)
+            return false;
+
+        // The records are sorted, so each one goes at the end
+        newNumberIndex.emplace_hint(newNumberIndex.end(), catalogNumber, strings.substr(offset, length));
+    }
+
+    indexStrings = strings;
+    index = std::move(newIndex);
+    numberIndex = std::move(newNumberIndex);
+    nameIndex.clear();
+
+#ifdef ENABLE_NLS
+    // Localized names are found through the translations of the current
+    // locale, as they are by add()
+    localizedNameIndex.clear();
+    for (const auto& entry : index)
+    {
+        std::string name(getName(entry));
+        if (std::string_view lname = D_(name.c_str()); lname != name)
+            localizedNameIndex[std::string(lname)] = entry.catalogNumber;
+    }
+#endif
+
+    return true;
+}
+
+std::size_t
+NameDatabase::getMemoryUsage() const
+{
+    using celestia::engine::MapNodeMemoryUsage;
+    using celestia::engine::StringMemoryUsage;
+
+    std::size_t bytes = MapNodeMemoryUsage(nameIndex) + MapNodeMemoryUsage(numberIndex);
+    for (const auto& [name, catalogNumber] : nameIndex)
+        bytes += StringMemoryUsage(name);
+    for (const auto& [catalogNumber, name] : numberIndex)
+        bytes += StringMemoryUsage(name);
+
+#ifdef ENABLE_NLS
+    bytes += MapNodeMemoryUsage(localizedNameIndex);
+    for (const auto& [name, catalogNumber] : localizedNameIndex)
+        bytes += StringMemoryUsage(name);
+#endif
+
+    return bytes + StringMemoryUsage(indexStrings) + celestia::engine::VectorMemoryUsage(index);
 }
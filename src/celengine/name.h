@@ -12,7 +12,9 @@
 
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
+#include <iosfwd>
 #include <map>
 #include <string>
 #include <string_view>
@@ -39,12 +41,49 @@ public:
     NumberIndex::const_iterator getFirstNameIter(AstroCatalog::IndexNumber catalogNumber) const;
     NumberIndex::const_iterator getFinalNameIter() const;
 
+    // Matches are appended with the shortest names first
     void getCompletion(std::vector<std::pair<std::string, AstroCatalog::IndexNumber>>& completion, std::string_view name) const;
 
+    // Move the names into a compact index sorted by case-folded name, once
+    // the catalogs are loaded. Names added afterwards are still found, and
+    // take precedence over the ones in the index.
+    void freeze();
+
+    // Write the frozen index and the names of each catalog number in a
+    // binary form which readIndex loads without parsing or sorting. The
+    // localized names are left out, as they depend on the locale at run
+    // time.
+    bool writeIndex(std::ostream&) const;
+    // Replace the names with the contents of a buffer written by writeIndex,
+    // e.g. a mapped file. Returns false if the buffer isn't a valid index.
+    bool readIndex(const char* data, std::size_t size);
+    static bool isIndex(const char* data, std::size_t size);
+
+    // Approximate memory of the names and their indexes
+    std::size_t getMemoryUsage() const;
+
 private:
+    struct IndexEntry
+    {
+        std::uint32_t nameOffset;
+        std::uint32_t foldedOffset;
+        std::uint16_t nameLength;
+        std::uint16_t foldedLength;
+        AstroCatalog::IndexNumber catalogNumber;
+        bool localized;
+    };
+
+    std::string_view getName(const IndexEntry&) const;
+    std::string_view getFoldedName(const IndexEntry&) const;
+    AstroCatalog::IndexNumber findInIndex(std::string_view, bool localized) const;
+
     NameIndex   nameIndex;
 #ifdef ENABLE_NLS
     NameIndex   localizedNameIndex;
 #endif
     NumberIndex numberIndex;
+
+    // The names and case-folded names of the frozen index
+    std::string             indexStrings;
+    std::vector<IndexEntry> index;
 };
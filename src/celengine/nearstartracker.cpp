@@ -0,0 +1,60 @@
+// nearstartracker.cpp
+//
+// Copyright (C) 2025-present, the Celestia Development Team
+//
+// Tracking of the stars near a moving observer.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include "nearstartracker.h"
+
+#include "star.h"
+#include "univcoord.h"
+#include "universe.h"
+
+namespace celestia::engine
+{
+
+void
+NearStarTracker::find(const Universe& _universe,
+                      const UniversalCoord& position,
+                      float maxDistance,
+                      std::vector<const Star*>& nearStars)
+{
+    Eigen::Vector3f pos = position.toLy().cast<float>();
+
+    // Every star within maxDistance of pos is within the search radius of
+    // the center as long as the offset fits in the margin
+    if (&_universe != universe ||
+        _universe.getCatalogGeneration() != catalogGeneration ||
+        (pos - center).norm() + maxDistance > searchRadius)
+    {
+        universe = &_universe;
+        catalogGeneration = _universe.getCatalogGeneration();
+        center = pos;
+        searchRadius = maxDistance * (1.0f + MarginFraction);
+        candidates.clear();
+        _universe.getNearStars(position, searchRadius, candidates);
+        ++searchCount;
+    }
+
+    // Same test as Universe::getNearStars
+    for (const Star* star : candidates)
+    {
+        if ((star->getPosition() - pos).norm() < maxDistance)
+            nearStars.push_back(star);
+    }
+}
+
+void
+NearStarTracker::reset()
+{
+    universe = nullptr;
+    searchRadius = -1.0f;
+    candidates.clear();
+}
+
+} // end namespace celestia::engine
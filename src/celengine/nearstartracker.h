@@ -0,0 +1,62 @@
+// nearstartracker.h
+//
+// Copyright (C) 2025-present, the Celestia Development Team
+//
+// Tracking of the stars near a moving observer.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <Eigen/Core>
+
+class Star;
+class UniversalCoord;
+class Universe;
+
+namespace celestia::engine
+{
+
+// Finds the stars near a position which moves a little between calls, such
+// as the observer's, without searching the star octree each time. The
+// octree is searched with a margin around the radius, and the stars found
+// are kept; while the position stays within the margin of where it was
+// searched, the stars near it are all among them and only their distances
+// are checked. The search is repeated after a jump, a larger radius or a
+// change of the catalogs.
+class NearStarTracker
+{
+public:
+    // Margin searched beyond the radius, as a fraction of it
+    static constexpr float MarginFraction = 0.25f;
+
+    // Append the stars closer than maxDistance light years to position to
+    // nearStars, like Universe::getNearStars
+    void find(const Universe& universe,
+              const UniversalCoord& position,
+              float maxDistance,
+              std::vector<const Star*>& nearStars);
+
+    // Forget the stars found, so that the next call searches the octree
+    void reset();
+
+    // Number of octree searches done so far
+    std::uint64_t getSearchCount() const { return searchCount; }
+
+private:
+    const Universe* universe{ nullptr };
+    std::uint32_t catalogGeneration{ 0 };
+    Eigen::Vector3f center{ Eigen::Vector3f::Zero() };
+    // Radius of the last search, negative before the first one
+    float searchRadius{ -1.0f };
+    std::vector<const Star*> candidates;
+    std::uint64_t searchCount{ 0 };
+};
+
+} // end namespace celestia::engine
@@ -62,21 +62,26 @@ Nebula::getObjType() const
 bool
 Nebula::load(const util::AssociativeArray* params, const fs::path& resPath, std::string_view name)
 {
-    if (const std::string* t = params->getString("Mesh"); t != nullptr)
-    {
-        auto geometryFileName = util::U8FileName(*t);
-        if (!geometryFileName.has_value())
-        {
-            GetLogger()->error("Invalid filename in Mesh\n");
-            return false;
-        }
+    if (const std::string* t = params->getString("Mesh"); t != nullptr && !setMesh(*t, resPath))
+        return false;
+
+    return DeepSkyObject::load(params, resPath, name);
+}
 
-        ResourceHandle geometryHandle =
-            engine::GetGeometryManager()->getHandle(engine::GeometryInfo(*geometryFileName, resPath));
-        setGeometry(geometryHandle);
+bool
+Nebula::setMesh(std::string_view meshName, const fs::path& resPath)
+{
+    auto geometryFileName = util::U8FileName(meshName);
+    if (!geometryFileName.has_value())
+    {
+        GetLogger()->error("Invalid filename in Mesh\n");
+        return false;
     }
 
-    return DeepSkyObject::load(params, resPath, name);
+    ResourceHandle geometryHandle =
+        engine::GetGeometryManager()->getHandle(engine::GeometryInfo(*geometryFileName, resPath));
+    setGeometry(geometryHandle);
+    return true;
 }
 
 RenderFlags
@@ -41,6 +41,8 @@ public:
 
     void setGeometry(ResourceHandle);
     ResourceHandle getGeometry() const;
+    // Set the geometry from a mesh file name, relative to the resource path
+    bool setMesh(std::string_view, const fs::path&);
 
     DeepSkyObjectType getObjType() const override;
 
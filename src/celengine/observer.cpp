@@ -500,6 +500,18 @@ Observer::setTime(double jd)
     updateUniversal();
 }
 
+void
+Observer::interpolate(const Observer& from, const Observer& to, double t)
+{
+    double s = 1.0 - t;
+    simTime -= s * (to.simTime - from.simTime);
+    realTime -= s * (to.realTime - from.realTime);
+    position = position.offsetKm(to.position.offsetFromKm(from.position) * -s);
+    originalOrientation = originalOrientation * to.originalOrientation.conjugate() *
+                          from.originalOrientation.slerp(t, to.originalOrientation);
+    updateUniversal();
+}
+
 /*! Return the position of the observer in universal coordinates. The origin
  *  The origin of this coordinate system is the Solar System Barycenter, and
  *  axes are defined by the J2000 ecliptic and equinox.
@@ -780,6 +792,7 @@ Observer::computeGotoParameters(const Selection& destination,
 
     jparams.traj = TrajectoryType::Linear;
     jparams.startTime = realTime;
+    jparams.destination = destination;
 
     // Right where we are now . . .
     jparams.from = getPosition();
@@ -833,6 +846,7 @@ Observer::computeGotoParametersGC(const Selection& destination,
 
     jparams.traj = TrajectoryType::GreatCircle;
     jparams.startTime = realTime;
+    jparams.destination = destination;
 
     jparams.centerObject = centerObj;
 
@@ -877,6 +891,7 @@ Observer::computeCenterParameters(const Selection& destination,
     jparams.duration = centerTime;
     jparams.startTime = realTime;
     jparams.traj = TrajectoryType::Linear;
+    jparams.destination = Selection();
 
     // Don't move through space, just rotate the camera
     jparams.from = getPosition();
@@ -904,6 +919,7 @@ Observer::computeCenterCOParameters(const Selection& destination,
     jparams.duration = centerTime;
     jparams.startTime = realTime;
     jparams.traj = TrajectoryType::CircularOrbit;
+    jparams.destination = Selection();
 
     jparams.centerObject = frame->getRefObject();
     jparams.expFactor = 0.5;
@@ -1403,6 +1419,7 @@ Observer::gotoLocation(const UniversalCoord& toPosition,
 {
     journey.startTime = realTime;
     journey.duration = duration;
+    journey.destination = Selection();
 
     journey.from = position;
     journey.initialOrientation = transformedOrientation;
@@ -1468,6 +1485,7 @@ Observer::gotoSurface(const Selection& sel, double duration)
     UniversalCoord nearSurfacePoint = UniversalCoord::Zero().offsetKm(dir);
 
     gotoLocation(nearSurfacePoint, q, duration);
+    journey.destination = sel;
 }
 
 void
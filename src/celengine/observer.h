@@ -228,6 +228,11 @@ public:
     double getRealTime() const;
     void setTime(double);
 
+    // Move the observer back along the change between two of its earlier
+    // states in the same reference frame, by the fraction 1 - t of it. When
+    // the observer is in the state to, this interpolates between the two.
+    void interpolate(const Observer& from, const Observer& to, double t);
+
     enum class ObserverMode
     {
         Free                    = 0,
@@ -259,11 +264,14 @@ public:
         Eigen::Quaterniond rotation1; // rotation on the CircularOrbit around centerObject
 
         Selection centerObject;
+        // Object the journey ends at, empty when going to a position
+        Selection destination;
 
         TrajectoryType traj{ TrajectoryType::Linear };
     };
 
     void gotoJourney(const JourneyParams&);
+    const JourneyParams& getJourney() const { return journey; }
     // void setSimulation(Simulation* _sim) { sim = _sim; };
 
 private:
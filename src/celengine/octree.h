@@ -12,13 +12,20 @@
 
 #pragma once
 
+#include <algorithm>
 #include <array>
+#include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
 #include <Eigen/Core>
+#include <Eigen/Geometry>
+
+#include <celcompat/numbers.h>
+#include <celutil/array_view.h>
 
 namespace celestia::engine
 {
@@ -29,6 +36,135 @@ using OctreeDepthType = std::uint32_t;
 
 constexpr inline OctreeNodeIndex InvalidOctreeNode = UINT32_MAX;
 
+// Number of consecutive nodes tested together by the batched culling path.
+constexpr inline OctreeNodeIndex OctreeNodeBatchSize = 8;
+
+// A view of OctreeNodeBatchSize consecutive nodes in the structure-of-arrays
+// node layout of a StaticOctree. Processors which implement
+//     std::uint32_t checkNodes(const OctreeNodeBatch<PREC>&);
+//     void selectNode(unsigned int lane);
+// are traversed with the batched path: checkNodes returns a bit mask of the
+// nodes in the batch which pass the culling tests (bit i for node i), and
+// selectNode is called for a passing node before its objects are processed,
+// so that per-node state computed by checkNodes can be made current.
+template<class PREC>
+struct OctreeNodeBatch
+{
+    using ArrayType = Eigen::Array<PREC, OctreeNodeBatchSize, 1>;
+    using FactorArrayType = Eigen::Array<float, OctreeNodeBatchSize, 1>;
+    using MaskArrayType = Eigen::Array<bool, OctreeNodeBatchSize, 1>;
+    using PointType = Eigen::Matrix<PREC, 3, 1>;
+    using PlaneType = Eigen::Hyperplane<PREC, 3>;
+
+    OctreeNodeBatch(const PREC*, const PREC*, const PREC*, const PREC*, const float*);
+
+    MaskArrayType inFrustum(util::array_view<PlaneType>) const;
+    MaskArrayType inCone(const PointType&, const PointType&, PREC, PREC) const;
+    ArrayType distanceFrom(const PointType&) const;
+
+    static std::uint32_t toBitMask(const MaskArrayType&);
+
+    Eigen::Map<const ArrayType> centerX;
+    Eigen::Map<const ArrayType> centerY;
+    Eigen::Map<const ArrayType> centerZ;
+    Eigen::Map<const ArrayType> size;
+    Eigen::Map<const FactorArrayType> brightFactor;
+};
+
+template<class PREC>
+OctreeNodeBatch<PREC>::OctreeNodeBatch(const PREC* _centerX,
+                                       const PREC* _centerY,
+                                       const PREC* _centerZ,
+                                       const PREC* _size,
+                                       const float* _brightFactor) :
+    centerX(_centerX),
+    centerY(_centerY),
+    centerZ(_centerZ),
+    size(_size),
+    brightFactor(_brightFactor)
+{
+}
+
+// Test the cubic octree nodes against each one of the planes of the view
+// frustum, this is the batched equivalent of the per-node plane test.
+template<class PREC>
+typename OctreeNodeBatch<PREC>::MaskArrayType
+OctreeNodeBatch<PREC>::inFrustum(util::array_view<PlaneType> planes) const
+{
+    MaskArrayType result = MaskArrayType::Constant(true);
+    for (const PlaneType& plane : planes)
+    {
+        const auto& normal = plane.normal();
+        PREC radiusScale = normal.cwiseAbs().sum();
+        ArrayType signedDistance = centerX * normal.x()
+                                 + centerY * normal.y()
+                                 + centerZ * normal.z()
+                                 + plane.offset();
+        result = result && (signedDistance >= -(size * radiusScale));
+    }
+
+    return result;
+}
+
+// Test the bounding spheres of the nodes against the infinite cone with the
+// given apex, unit axis and half angle. A sphere intersects the cone when
+// its center is within the radius of the lateral surface, or of the apex
+// when the center projects behind it.
+template<class PREC>
+typename OctreeNodeBatch<PREC>::MaskArrayType
+OctreeNodeBatch<PREC>::inCone(const PointType& apex,
+                              const PointType& axis,
+                              PREC sinAngle,
+                              PREC cosAngle) const
+{
+    ArrayType vx = centerX - apex.x();
+    ArrayType vy = centerY - apex.y();
+    ArrayType vz = centerZ - apex.z();
+    ArrayType along = vx * axis.x() + vy * axis.y() + vz * axis.z();
+    ArrayType distance2 = vx.square() + vy.square() + vz.square();
+    ArrayType across = (distance2 - along.square()).max(PREC(0)).sqrt();
+    ArrayType radius = size * numbers::sqrt3_v<PREC>;
+
+    return (distance2 <= radius.square())
+        || ((across * cosAngle - along * sinAngle <= radius) && (along * cosAngle + across * sinAngle >= PREC(0)));
+}
+
+template<class PREC>
+typename OctreeNodeBatch<PREC>::ArrayType
+OctreeNodeBatch<PREC>::distanceFrom(const PointType& position) const
+{
+    return ((centerX - position.x()).square()
+          + (centerY - position.y()).square()
+          + (centerZ - position.z()).square()).sqrt();
+}
+
+template<class PREC>
+std::uint32_t
+OctreeNodeBatch<PREC>::toBitMask(const MaskArrayType& mask)
+{
+    std::uint32_t result = 0;
+    for (OctreeNodeIndex i = 0; i < OctreeNodeBatchSize; ++i)
+        result |= static_cast<std::uint32_t>(mask[i]) << i;
+    return result;
+}
+
+// A range of nodes [begin, end) in depth-first order which can be traversed
+// independently of the rest of the octree.
+struct OctreeNodeRange
+{
+    OctreeNodeIndex begin;
+    OctreeNodeIndex end;
+};
+
+// A subset of the nodes in depth-first order, such as the nodes which passed
+// a culling test. For each node, right holds the position in the subset
+// following the subset nodes in its subtree.
+struct OctreeNodeSubset
+{
+    std::vector<OctreeNodeIndex> nodes;
+    std::vector<std::uint32_t> right;
+};
+
 namespace detail
 {
 
@@ -55,6 +191,56 @@ StaticOctreeNode<PREC>::StaticOctreeNode(const PointType& _center,
 {
 }
 
+// Structure-of-arrays copy of the node data used for culling, padded to a
+// multiple of OctreeNodeBatchSize so that full batches can always be read.
+template<class PREC>
+struct StaticOctreeNodeArrays
+{
+    std::vector<PREC> centerX;
+    std::vector<PREC> centerY;
+    std::vector<PREC> centerZ;
+    std::vector<PREC> size;
+    std::vector<float> brightFactor;
+};
+
+// The node tables read by the traversals. Nodes link each other by index, so
+// the tables can point into the arrays of the octree or into a read-only
+// mapping shared with other processes.
+template<class PREC>
+struct StaticOctreeNodeTables
+{
+    const StaticOctreeNode<PREC>* nodes{ nullptr };
+    OctreeNodeIndex nodeCount{ 0 };
+    // Padded to a multiple of OctreeNodeBatchSize
+    const PREC* centerX{ nullptr };
+    const PREC* centerY{ nullptr };
+    const PREC* centerZ{ nullptr };
+    const PREC* size{ nullptr };
+    const float* brightFactor{ nullptr };
+};
+
+template<typename PROCESSOR, typename PREC, typename = void>
+struct HasBatchedCheck : std::false_type {};
+
+template<typename PROCESSOR, typename PREC>
+struct HasBatchedCheck<PROCESSOR,
+                       PREC,
+                       std::void_t<decltype(std::declval<PROCESSOR&>().checkNodes(std::declval<const OctreeNodeBatch<PREC>&>())),
+                                   decltype(std::declval<PROCESSOR&>().selectNode(0U))>> : std::true_type {};
+
+template<typename PROCESSOR, typename OBJ, typename PREC, typename = void>
+struct HasRangeProcess : std::false_type {};
+
+template<typename PROCESSOR, typename OBJ, typename PREC>
+struct HasRangeProcess<PROCESSOR,
+                       OBJ,
+                       PREC,
+                       std::void_t<decltype(std::declval<PROCESSOR&>().processObjects(std::declval<const Eigen::Matrix<PREC, 3, 1>&>(),
+                                                                                      std::declval<PREC>(),
+                                                                                      std::declval<const OBJ*>(),
+                                                                                      OctreeObjectIndex{},
+                                                                                      OctreeObjectIndex{}))>> : std::true_type {};
+
 } // end namespace celestia::engine::detail
 
 template <class OBJ, class PREC>
@@ -71,6 +257,17 @@ protected:
 template<class TRAITS, class STORAGE>
 class DynamicOctree;
 
+template<class TRAITS>
+class OctreeCache;
+
+// Processors may implement
+//     void processObjects(const PointType& center, PREC size,
+//                         const OBJ* objects,
+//                         OctreeObjectIndex first, OctreeObjectIndex last);
+// to receive all the objects of a node which passed checkNode at once,
+// instead of calling process for each one. This allows the processor to use
+// auxiliary per-object data indexed in the same order as the octree.
+//
 // The StaticOctree template arguments are:
 // OBJ:  object hanging from the node,
 // PREC: floating point precision of the culling operations at node level.
@@ -95,22 +292,53 @@ public:
     template<typename PROCESSOR>
     void processDepthFirst(PROCESSOR&) const;
 
+    template<typename PROCESSOR>
+    void processDepthFirst(PROCESSOR&, OctreeNodeRange) const;
+
+    template<typename PROCESSOR>
+    void processDepthFirst(PROCESSOR&, const OctreeNodeSubset&) const;
+
+    template<typename PROCESSOR>
+    void splitDepthFirst(PROCESSOR&, OctreeDepthType, std::vector<OctreeNodeRange>&) const;
+
+    template<typename PROCESSOR>
+    void selectDepthFirst(PROCESSOR&, OctreeNodeSubset&) const;
+
     template<typename PROCESSOR>
     void processBreadthFirst(PROCESSOR&) const;
 
     OctreeObjectIndex size() const;
     OctreeNodeIndex nodeCount() const;
 
+    // Memory of the nodes and of the object array; shared node tables
+    // aren't counted
+    std::size_t getNodeMemoryUsage() const;
+    std::size_t getObjectMemoryUsage() const;
+
     OBJ& operator[](OctreeObjectIndex);
     const OBJ& operator[](OctreeObjectIndex) const;
 
 private:
     using NodeType = detail::StaticOctreeNode<PREC>;
 
+    template<typename PROCESSOR>
+    void processDepthFirstBatched(PROCESSOR&, OctreeNodeRange) const;
+
     template<typename PROCESSOR>
     bool processToDepth(PROCESSOR&, OctreeDepthType) const;
 
+    template<typename PROCESSOR>
+    void processNodeObjects(PROCESSOR&, const NodeType&) const;
+
+    OctreeNodeBatch<PREC> getBatch(OctreeNodeIndex) const;
+    void buildNodeArrays();
+
+    // Owned nodes, empty if the tables point into shared storage
     std::vector<NodeType> m_nodes;
+    detail::StaticOctreeNodeArrays<PREC> m_nodeArrays;
+    detail::StaticOctreeNodeTables<PREC> m_tables;
+    // Keeps the storage of shared tables alive
+    std::shared_ptr<const void> m_sharedTables;
     std::vector<OBJ> m_objects;
     std::vector<PREC> m_sizes;
     OctreeDepthType m_minPopulated{ UINT32_MAX };
@@ -118,6 +346,9 @@ private:
 
     template<class TRAITS, class STORAGE>
     friend class DynamicOctree;
+
+    template<class TRAITS>
+    friend class OctreeCache;
 };
 
 template<class OBJ, class PREC>
@@ -125,19 +356,174 @@ template<typename PROCESSOR>
 void
 StaticOctree<OBJ, PREC>::processDepthFirst(PROCESSOR& processor) const
 {
+    processDepthFirst(processor, OctreeNodeRange{ 0, nodeCount() });
+}
+
+// Process the nodes in a range produced by splitDepthFirst, or the whole
+// octree. Ranges produced by splitDepthFirst can be processed concurrently
+// with separate processors.
+template<class OBJ, class PREC>
+template<typename PROCESSOR>
+void
+StaticOctree<OBJ, PREC>::processDepthFirst(PROCESSOR& processor, OctreeNodeRange range) const
+{
+    if constexpr (detail::HasBatchedCheck<PROCESSOR, PREC>::value)
+    {
+        processDepthFirstBatched(processor, range);
+        return;
+    }
+
+    OctreeNodeIndex nodeIdx = range.begin;
+    const OctreeNodeIndex endIdx = range.end;
+    while (nodeIdx < endIdx)
+    {
+        const NodeType& node = m_tables.nodes[nodeIdx];
+        if (!processor.checkNode(node.center, m_sizes[node.depth], node.brightFactor))
+        {
+            nodeIdx = node.right;
+            continue;
+        }
+
+        processNodeObjects(processor, node);
+
+        ++nodeIdx;
+    }
+}
+
+// Process only the nodes of a subset produced by selectDepthFirst. If the
+// subset contains every node which passes the processor's checkNode, this
+// visits the same objects as processDepthFirst.
+template<class OBJ, class PREC>
+template<typename PROCESSOR>
+void
+StaticOctree<OBJ, PREC>::processDepthFirst(PROCESSOR& processor, const OctreeNodeSubset& subset) const
+{
+    std::uint32_t subsetIdx = 0;
+    const auto subsetSize = static_cast<std::uint32_t>(subset.nodes.size());
+    while (subsetIdx < subsetSize)
+    {
+        const NodeType& node = m_tables.nodes[subset.nodes[subsetIdx]];
+        if (!processor.checkNode(node.center, m_sizes[node.depth], node.brightFactor))
+        {
+            subsetIdx = subset.right[subsetIdx];
+            continue;
+        }
+
+        processNodeObjects(processor, node);
+
+        ++subsetIdx;
+    }
+}
+
+// Collect the nodes reached by a depth-first traversal with the processor,
+// that is the nodes which pass checkNode along with all their ancestors.
+template<class OBJ, class PREC>
+template<typename PROCESSOR>
+void
+StaticOctree<OBJ, PREC>::selectDepthFirst(PROCESSOR& processor, OctreeNodeSubset& subset) const
+{
+    subset.nodes.clear();
+    subset.right.clear();
+
+    // Subset nodes whose subtree has not been left yet, with the index of
+    // the node following their subtree in the octree
+    std::vector<std::pair<std::uint32_t, OctreeNodeIndex>> open;
+
     OctreeNodeIndex nodeIdx = 0;
     const OctreeNodeIndex endIdx = nodeCount();
     while (nodeIdx < endIdx)
     {
-        const NodeType& node = m_nodes[nodeIdx];
+        while (!open.empty() && open.back().second <= nodeIdx)
+        {
+            subset.right[open.back().first] = static_cast<std::uint32_t>(subset.nodes.size());
+            open.pop_back();
+        }
+
+        const NodeType& node = m_tables.nodes[nodeIdx];
         if (!processor.checkNode(node.center, m_sizes[node.depth], node.brightFactor))
         {
             nodeIdx = node.right;
             continue;
         }
 
-        for (OctreeObjectIndex idx = node.first; idx < node.last; ++idx)
-            processor.process(m_objects[idx]);
+        open.emplace_back(static_cast<std::uint32_t>(subset.nodes.size()), node.right);
+        subset.nodes.push_back(nodeIdx);
+        subset.right.push_back(0);
+
+        ++nodeIdx;
+    }
+
+    for (const auto& [subsetIdx, rightIdx] : open)
+        subset.right[subsetIdx] = static_cast<std::uint32_t>(subset.nodes.size());
+}
+
+// Split a depth-first traversal into ranges: the nodes above splitDepth are
+// tested with the processor here, and each one which passes and holds
+// objects becomes a single-node range. Each node at splitDepth reached this
+// way becomes a range covering its whole subtree. Processing the ranges in
+// order visits the objects in the same order as processDepthFirst.
+template<class OBJ, class PREC>
+template<typename PROCESSOR>
+void
+StaticOctree<OBJ, PREC>::splitDepthFirst(PROCESSOR& processor,
+                                         OctreeDepthType splitDepth,
+                                         std::vector<OctreeNodeRange>& ranges) const
+{
+    OctreeNodeIndex nodeIdx = 0;
+    const OctreeNodeIndex endIdx = nodeCount();
+    while (nodeIdx < endIdx)
+    {
+        const NodeType& node = m_tables.nodes[nodeIdx];
+        const OctreeNodeIndex rightIdx = std::min(node.right, endIdx);
+        if (node.depth >= splitDepth)
+        {
+            ranges.push_back(OctreeNodeRange{ nodeIdx, rightIdx });
+            nodeIdx = rightIdx;
+        }
+        else if (!processor.checkNode(node.center, m_sizes[node.depth], node.brightFactor))
+        {
+            nodeIdx = rightIdx;
+        }
+        else
+        {
+            if (node.first != node.last)
+                ranges.push_back(OctreeNodeRange{ nodeIdx, nodeIdx + 1 });
+            ++nodeIdx;
+        }
+    }
+}
+
+// The nodes are tested a batch at a time, but the traversal order is the
+// same as the scalar path: a failing node still skips to node.right, so
+// batches lying entirely within a culled subtree are never tested.
+template<class OBJ, class PREC>
+template<typename PROCESSOR>
+void
+StaticOctree<OBJ, PREC>::processDepthFirstBatched(PROCESSOR& processor, OctreeNodeRange range) const
+{
+    OctreeNodeIndex nodeIdx = range.begin;
+    const OctreeNodeIndex endIdx = range.end;
+    OctreeNodeIndex batchStart = InvalidOctreeNode;
+    std::uint32_t batchMask = 0;
+    while (nodeIdx < endIdx)
+    {
+        const OctreeNodeIndex currentBatch = nodeIdx - nodeIdx % OctreeNodeBatchSize;
+        if (currentBatch != batchStart)
+        {
+            batchStart = currentBatch;
+            batchMask = processor.checkNodes(getBatch(batchStart));
+        }
+
+        const NodeType& node = m_tables.nodes[nodeIdx];
+        const auto lane = static_cast<unsigned int>(nodeIdx - batchStart);
+        if ((batchMask & (UINT32_C(1) << lane)) == 0)
+        {
+            nodeIdx = node.right;
+            continue;
+        }
+
+        processor.selectNode(lane);
+        processNodeObjects(processor, node);
 
         ++nodeIdx;
     }
@@ -168,7 +554,7 @@ StaticOctree<OBJ, PREC>::processToDepth(PROCESSOR& processor, OctreeDepthType de
     bool result = false;
     while (nodeIdx < endIdx)
     {
-        const NodeType& node = m_nodes[nodeIdx];
+        const NodeType& node = m_tables.nodes[nodeIdx];
         if (!processor.checkNode(node.center, m_sizes[node.depth], node.brightFactor))
         {
             nodeIdx = node.right;
@@ -176,8 +562,7 @@ StaticOctree<OBJ, PREC>::processToDepth(PROCESSOR& processor, OctreeDepthType de
         else if (node.depth == depth)
         {
             result = true;
-            for (OctreeObjectIndex idx = node.first; idx < node.last; ++idx)
-                processor.process(m_objects[idx]);
+            processNodeObjects(processor, node);
             nodeIdx = node.right;
         }
         else
@@ -189,6 +574,68 @@ StaticOctree<OBJ, PREC>::processToDepth(PROCESSOR& processor, OctreeDepthType de
     return result;
 }
 
+template<class OBJ, class PREC>
+template<typename PROCESSOR>
+void
+StaticOctree<OBJ, PREC>::processNodeObjects(PROCESSOR& processor, const NodeType& node) const
+{
+    if constexpr (detail::HasRangeProcess<PROCESSOR, OBJ, PREC>::value)
+    {
+        if (node.first != node.last)
+            processor.processObjects(node.center, m_sizes[node.depth], m_objects.data(), node.first, node.last);
+    }
+    else
+    {
+        for (OctreeObjectIndex idx = node.first; idx < node.last; ++idx)
+            processor.process(m_objects[idx]);
+    }
+}
+
+template<class OBJ, class PREC>
+OctreeNodeBatch<PREC>
+StaticOctree<OBJ, PREC>::getBatch(OctreeNodeIndex start) const
+{
+    return OctreeNodeBatch<PREC>(m_tables.centerX + start,
+                                 m_tables.centerY + start,
+                                 m_tables.centerZ + start,
+                                 m_tables.size + start,
+                                 m_tables.brightFactor + start);
+}
+
+template<class OBJ, class PREC>
+void
+StaticOctree<OBJ, PREC>::buildNodeArrays()
+{
+    const std::size_t nodeCount = m_nodes.size();
+    const std::size_t paddedCount = ((nodeCount + OctreeNodeBatchSize - 1) / OctreeNodeBatchSize) * OctreeNodeBatchSize;
+
+    // Padding nodes are never visited, their contents are irrelevant
+    m_nodeArrays.centerX.assign(paddedCount, PREC(0));
+    m_nodeArrays.centerY.assign(paddedCount, PREC(0));
+    m_nodeArrays.centerZ.assign(paddedCount, PREC(0));
+    m_nodeArrays.size.assign(paddedCount, PREC(0));
+    m_nodeArrays.brightFactor.assign(paddedCount, 1000.0f);
+
+    for (std::size_t i = 0; i < nodeCount; ++i)
+    {
+        const NodeType& node = m_nodes[i];
+        m_nodeArrays.centerX[i] = node.center.x();
+        m_nodeArrays.centerY[i] = node.center.y();
+        m_nodeArrays.centerZ[i] = node.center.z();
+        m_nodeArrays.size[i] = m_sizes[node.depth];
+        m_nodeArrays.brightFactor[i] = node.brightFactor;
+    }
+
+    m_tables.nodes = m_nodes.data();
+    m_tables.nodeCount = static_cast<OctreeNodeIndex>(nodeCount);
+    m_tables.centerX = m_nodeArrays.centerX.data();
+    m_tables.centerY = m_nodeArrays.centerY.data();
+    m_tables.centerZ = m_nodeArrays.centerZ.data();
+    m_tables.size = m_nodeArrays.size.data();
+    m_tables.brightFactor = m_nodeArrays.brightFactor.data();
+    m_sharedTables.reset();
+}
+
 template<class OBJ, class PREC>
 OctreeObjectIndex
 StaticOctree<OBJ, PREC>::size() const
@@ -200,7 +647,25 @@ template<class OBJ, class PREC>
 OctreeNodeIndex
 StaticOctree<OBJ, PREC>::nodeCount() const
 {
-    return static_cast<OctreeNodeIndex>(m_nodes.size());
+    return m_tables.nodeCount;
+}
+
+template<class OBJ, class PREC>
+std::size_t
+StaticOctree<OBJ, PREC>::getNodeMemoryUsage() const
+{
+    return m_nodes.capacity() * sizeof(NodeType) +
+           (m_nodeArrays.centerX.capacity() + m_nodeArrays.centerY.capacity() +
+            m_nodeArrays.centerZ.capacity() + m_nodeArrays.size.capacity() +
+            m_sizes.capacity()) * sizeof(PREC) +
+           m_nodeArrays.brightFactor.capacity() * sizeof(float);
+}
+
+template<class OBJ, class PREC>
+std::size_t
+StaticOctree<OBJ, PREC>::getObjectMemoryUsage() const
+{
+    return m_objects.capacity() * sizeof(OBJ);
 }
 
 template<class OBJ, class PREC>
@@ -17,6 +17,8 @@
 #include <algorithm>
 #include <array>
 #include <cassert>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <type_traits>
 #include <utility>
@@ -25,6 +27,7 @@
 #include <Eigen/Core>
 
 #include <celutil/blockarray.h>
+#include <celutil/threadpool.h>
 #include "octree.h"
 
 namespace celestia::engine
@@ -61,6 +64,20 @@ DynamicOctreeNode<PREC>::isStraddling(const PointType& pos, PREC radius)
     return radius > PREC(0) && (pos - center).cwiseAbs().minCoeff() < radius;
 }
 
+// Temporary node used by the parallel builder, the subtrees are built
+// independently and then copied into the DynamicOctree node array.
+template<class PREC>
+struct ParallelOctreeNode
+{
+    using PointType = Eigen::Matrix<PREC, 3, 1>;
+
+    explicit ParallelOctreeNode(const PointType& _center) : center(_center) {}
+
+    PointType center;
+    std::vector<OctreeObjectIndex> objIndices;
+    std::array<std::unique_ptr<ParallelOctreeNode>, 8> children;
+};
+
 } // end namespace celestia::engine::detail
 
 // The DynamicOctree is built first by inserting objects from a database or
@@ -90,23 +107,56 @@ public:
                   float rootExclusionFactor,
                   OctreeObjectIndex splitThreshold);
 
+    // Build the same octree as the sequential constructor, but by
+    // partitioning the objects level by level, with the partitioning of
+    // large nodes and the construction of the child subtrees distributed
+    // over the thread pool.
+    DynamicOctree(STORAGE&& objects,
+                  const PointType& rootCenter,
+                  PrecisionType rootSize,
+                  float rootExclusionFactor,
+                  OctreeObjectIndex splitThreshold,
+                  util::ThreadPool& threadPool);
+
     DynamicOctree(const DynamicOctree&) = delete;
     DynamicOctree& operator=(const DynamicOctree&) = delete;
     DynamicOctree(DynamicOctree&&) noexcept = default;
     DynamicOctree& operator=(DynamicOctree&&) noexcept = default;
 
-    std::unique_ptr<StaticOctreeType> build();
+    // If objectOrder is not null, it receives the index in the source storage
+    // of each object in the resulting octree.
+    std::unique_ptr<StaticOctreeType> build(std::vector<OctreeObjectIndex>* objectOrder = nullptr);
 
 private:
     using NodeType = detail::DynamicOctreeNode<PrecisionType>;
 
+    using ParallelNodeType = detail::ParallelOctreeNode<PrecisionType>;
+
     void insertObject(OctreeObjectIndex);
+    bool isRetained(OctreeObjectIndex, const PointType&, float) const;
+    unsigned int getObjectClass(OctreeObjectIndex, const PointType&, float) const;
+    void buildParallelNode(ParallelNodeType&,
+                           std::vector<OctreeObjectIndex>&&,
+                           OctreeDepthType,
+                           PrecisionType,
+                           float,
+                           util::ThreadPool&,
+                           OctreeDepthType&) const;
+    OctreeNodeIndex copyParallelNode(ParallelNodeType&);
     void splitNode(NodeType&, OctreeDepthType);
     OctreeNodeIndex getChild(NodeType&, OctreeDepthType, const PointType&);
     void buildNode(StaticOctreeType&,
                    const NodeType&,
                    OctreeDepthType,
-                   std::vector<OctreeNodeIndex>&);
+                   std::vector<OctreeNodeIndex>&,
+                   std::vector<OctreeObjectIndex>*);
+
+    // Nodes with fewer objects than this are partitioned on a single thread
+    static constexpr std::size_t ParallelPartitionGrain = 16384;
+    // Subtrees with fewer objects than this are built on the current task
+    static constexpr std::size_t ParallelSubtreeGrain = 4096;
+    // OctreeObjectClass value for objects which stay in the node
+    static constexpr unsigned int RetainedClass = 8;
 
     BlockArray<NodeType> m_nodes;
     STORAGE m_objects;
@@ -135,6 +185,224 @@ DynamicOctree<TRAITS, STORAGE>::DynamicOctree(STORAGE&& objects,
     }
 }
 
+template<class TRAITS, class STORAGE>
+DynamicOctree<TRAITS, STORAGE>::DynamicOctree(STORAGE&& objects,
+                                              const PointType& rootCenter,
+                                              PrecisionType rootSize,
+                                              float rootExclusionFactor,
+                                              OctreeObjectIndex splitThreshold,
+                                              util::ThreadPool& threadPool) :
+    m_objects(std::move(objects)),
+    m_splitThreshold(splitThreshold)
+{
+    std::vector<OctreeObjectIndex> rootObjects;
+    rootObjects.reserve(m_objects.size());
+    for (OctreeObjectIndex i = 0, end = static_cast<OctreeObjectIndex>(m_objects.size()); i < end; ++i)
+    {
+        if ((TRAITS::getPosition(m_objects[i]) - rootCenter).cwiseAbs().maxCoeff() > rootSize)
+            m_excluded.push_back(i);
+        else
+            rootObjects.push_back(i);
+    }
+
+    ParallelNodeType root(rootCenter);
+    OctreeDepthType maxDepth = 0;
+    buildParallelNode(root, std::move(rootObjects), 0, rootSize, rootExclusionFactor, threadPool, maxDepth);
+
+    // Same sequence of operations as the sequential builder, so that the
+    // level sizes are bit-identical
+    m_sizes.emplace_back(rootSize);
+    while (m_sizes.size() <= maxDepth)
+        m_sizes.push_back(m_sizes.back() * PrecisionType(0.5));
+    m_factors.emplace_back(rootExclusionFactor);
+
+    copyParallelNode(root);
+}
+
+// Whether an object at this node must be placed in the node rather than in
+// one of its children.
+template<class TRAITS, class STORAGE>
+bool
+DynamicOctree<TRAITS, STORAGE>::isRetained(OctreeObjectIndex idx, const PointType& center, float factor) const
+{
+    const ObjectType& obj = m_objects[idx];
+    PrecisionType radius = TRAITS::getRadius(obj);
+    return TRAITS::getMagnitude(obj) <= factor
+        || (radius > PrecisionType(0) && (TRAITS::getPosition(obj) - center).cwiseAbs().minCoeff() < radius);
+}
+
+// Returns the child index for the object, or RetainedClass if it stays in
+// the node.
+template<class TRAITS, class STORAGE>
+unsigned int
+DynamicOctree<TRAITS, STORAGE>::getObjectClass(OctreeObjectIndex idx, const PointType& center, float factor) const
+{
+    if (isRetained(idx, center, factor))
+        return RetainedClass;
+
+    PointType pos = TRAITS::getPosition(m_objects[idx]);
+    return static_cast<unsigned int>(pos.x() >= center.x()) |
+           (static_cast<unsigned int>(pos.y() >= center.y()) << 1U) |
+           (static_cast<unsigned int>(pos.z() >= center.z()) << 2U);
+}
+
+// The sequential builder keeps every object which reaches a node until an
+// object that could go to a child arrives when the node already holds
+// splitThreshold objects. So a node is split exactly when one of the
+// objects after the first splitThreshold is not retained. On a split, the
+// objects are distributed among the children preserving their order, which
+// is the order in which the sequential builder would have inserted them.
+template<class TRAITS, class STORAGE>
+void
+DynamicOctree<TRAITS, STORAGE>::buildParallelNode(ParallelNodeType& node,
+                                                  std::vector<OctreeObjectIndex>&& objIndices,
+                                                  OctreeDepthType depth,
+                                                  PrecisionType size,
+                                                  float factor,
+                                                  util::ThreadPool& threadPool,
+                                                  OctreeDepthType& maxDepth) const
+{
+    maxDepth = std::max(maxDepth, depth);
+
+    const std::size_t count = objIndices.size();
+    bool split = false;
+    for (std::size_t i = m_splitThreshold; i < count; ++i)
+    {
+        if (!isRetained(objIndices[i], node.center, factor))
+        {
+            split = true;
+            break;
+        }
+    }
+
+    if (!split)
+    {
+        node.objIndices = std::move(objIndices);
+        return;
+    }
+
+    // Stable partition into retained objects and the eight octants, using
+    // per-chunk counts and prefix sums so that chunks can be scattered
+    // concurrently.
+    constexpr unsigned int ClassCount = RetainedClass + 1;
+    const std::size_t chunkCount = count < ParallelPartitionGrain
+        ? 1
+        : std::min(count / ParallelPartitionGrain, (static_cast<std::size_t>(threadPool.threadCount()) + 1) * 4);
+
+    std::vector<std::uint8_t> classes(count);
+    std::vector<std::array<std::size_t, ClassCount>> chunkOffsets(chunkCount);
+    threadPool.parallelFor(chunkCount, [&](std::size_t chunk)
+    {
+        auto& counts = chunkOffsets[chunk];
+        counts.fill(0);
+        for (std::size_t i = count * chunk / chunkCount, end = count * (chunk + 1) / chunkCount; i < end; ++i)
+        {
+            auto objectClass = getObjectClass(objIndices[i], node.center, factor);
+            classes[i] = static_cast<std::uint8_t>(objectClass);
+            ++counts[objectClass];
+        }
+    });
+
+    std::array<std::vector<OctreeObjectIndex>, ClassCount> partitions;
+    for (unsigned int objectClass = 0; objectClass < ClassCount; ++objectClass)
+    {
+        std::size_t total = 0;
+        for (auto& counts : chunkOffsets)
+        {
+            std::size_t chunkTotal = counts[objectClass];
+            counts[objectClass] = total;
+            total += chunkTotal;
+        }
+
+        partitions[objectClass].resize(total);
+    }
+
+    threadPool.parallelFor(chunkCount, [&](std::size_t chunk)
+    {
+        auto offsets = chunkOffsets[chunk];
+        for (std::size_t i = count * chunk / chunkCount, end = count * (chunk + 1) / chunkCount; i < end; ++i)
+            partitions[classes[i]][offsets[classes[i]]++] = objIndices[i];
+    });
+
+    objIndices = std::vector<OctreeObjectIndex>();
+    classes = std::vector<std::uint8_t>();
+
+    node.objIndices = std::move(partitions[RetainedClass]);
+
+    const PrecisionType childSize = size * PrecisionType(0.5);
+    const float childFactor = TRAITS::applyDecay(factor);
+    std::array<OctreeDepthType, 8> childMaxDepths;
+    childMaxDepths.fill(0);
+    for (unsigned int childIndex = 0; childIndex < 8; ++childIndex)
+    {
+        if (partitions[childIndex].empty())
+            continue;
+
+        PointType centerPos = node.center
+                            + childSize * PointType(static_cast<PrecisionType>(static_cast<int>((childIndex & 1U) << 1U) - 1),
+                                                    static_cast<PrecisionType>(static_cast<int>(childIndex & 2U) - 1),
+                                                    static_cast<PrecisionType>(static_cast<int>((childIndex & 4U) >> 1U) - 1));
+        node.children[childIndex] = std::make_unique<ParallelNodeType>(centerPos);
+    }
+
+    auto buildChild = [&](std::size_t childIndex)
+    {
+        if (node.children[childIndex] == nullptr)
+            return;
+        buildParallelNode(*node.children[childIndex],
+                          std::move(partitions[childIndex]),
+                          depth + 1,
+                          childSize,
+                          childFactor,
+                          threadPool,
+                          childMaxDepths[childIndex]);
+    };
+
+    if (count - node.objIndices.size() < ParallelSubtreeGrain)
+    {
+        for (std::size_t childIndex = 0; childIndex < 8; ++childIndex)
+            buildChild(childIndex);
+    }
+    else
+    {
+        threadPool.parallelFor(8, buildChild);
+    }
+
+    for (OctreeDepthType childMaxDepth : childMaxDepths)
+        maxDepth = std::max(maxDepth, childMaxDepth);
+}
+
+template<class TRAITS, class STORAGE>
+OctreeNodeIndex
+DynamicOctree<TRAITS, STORAGE>::copyParallelNode(ParallelNodeType& parallelNode)
+{
+    auto nodeIdx = static_cast<OctreeNodeIndex>(m_nodes.size());
+    NodeType& node = m_nodes.emplace_back(parallelNode.center);
+    node.objIndices = std::move(parallelNode.objIndices);
+
+    for (unsigned int childIndex = 0; childIndex < 8; ++childIndex)
+    {
+        auto& child = parallelNode.children[childIndex];
+        if (child == nullptr)
+            continue;
+
+        OctreeNodeIndex childIdx = copyParallelNode(*child);
+        child.reset();
+
+        // BlockArray elements don't move, but look the node up again for clarity
+        NodeType& updatedNode = m_nodes[nodeIdx];
+        if (updatedNode.children == nullptr)
+        {
+            updatedNode.children = std::make_unique<typename NodeType::ChildrenType>();
+            updatedNode.children->fill(InvalidOctreeNode);
+        }
+
+        (*updatedNode.children)[childIndex] = childIdx;
+    }
+
+    return nodeIdx;
+}
+
 template<class TRAITS, class STORAGE>
 void
 DynamicOctree<TRAITS, STORAGE>::insertObject(OctreeObjectIndex idx)
@@ -252,7 +520,7 @@ DynamicOctree<TRAITS, STORAGE>::getChild(NodeType& node, OctreeDepthType depth,
 
 template<class TRAITS, class STORAGE>
 std::unique_ptr<typename DynamicOctree<TRAITS, STORAGE>::StaticOctreeType>
-DynamicOctree<TRAITS, STORAGE>::build()
+DynamicOctree<TRAITS, STORAGE>::build(std::vector<OctreeObjectIndex>* objectOrder)
 {
     auto staticOctree = std::make_unique<StaticOctreeType>();
     staticOctree->m_nodes.reserve(m_nodes.size());
@@ -267,7 +535,7 @@ DynamicOctree<TRAITS, STORAGE>::build()
         nodeStack.pop_back();
 
         const NodeType& node = m_nodes[nodeIdx];
-        buildNode(*staticOctree, node, depth, prevByDepth);
+        buildNode(*staticOctree, node, depth, prevByDepth, objectOrder);
         if (depth < staticOctree->m_minPopulated && !node.objIndices.empty())
             staticOctree->m_minPopulated = depth;
         if (depth > staticOctree->m_maxDepth)
@@ -286,7 +554,11 @@ DynamicOctree<TRAITS, STORAGE>::build()
     for (OctreeObjectIndex objIndex : m_excluded)
         staticOctree->m_objects.emplace_back(std::move(m_objects[objIndex]));
 
+    if (objectOrder != nullptr)
+        objectOrder->insert(objectOrder->end(), m_excluded.begin(), m_excluded.end());
+
     staticOctree->m_sizes = std::move(m_sizes);
+    staticOctree->buildNodeArrays();
 
     return staticOctree;
 }
@@ -296,7 +568,8 @@ void
 DynamicOctree<TRAITS, STORAGE>::buildNode(StaticOctreeType& staticOctree,
                                           const NodeType& node,
                                           OctreeDepthType depth,
-                                          std::vector<OctreeNodeIndex>& prevByDepth)
+                                          std::vector<OctreeNodeIndex>& prevByDepth,
+                                          std::vector<OctreeObjectIndex>* objectOrder)
 {
     // any nodes in the node stack with a depth greater or equal to this one
     // will have this node as the node to jump to when skipping the subtree
@@ -325,6 +598,9 @@ DynamicOctree<TRAITS, STORAGE>::buildNode(StaticOctreeType& staticOctree,
         staticOctree.m_objects.emplace_back(std::move(obj));
     }
 
+    if (objectOrder != nullptr)
+        objectOrder->insert(objectOrder->end(), node.objIndices.begin(), node.objIndices.end());
+
     // update parent node brightness factors, in case node was empty or
     // (less likely) filled with objects straddling the center
     for (OctreeNodeIndex parentDepth = depth; parentDepth-- > 0;)
@@ -353,4 +629,22 @@ makeDynamicOctree(STORAGE&& objects,
                                                             splitThreshold);
 }
 
+template<typename TRAITS, typename STORAGE>
+inline std::unique_ptr<DynamicOctree<TRAITS, STORAGE>>
+makeDynamicOctree(STORAGE&& objects,
+                  const Eigen::Matrix<typename TRAITS::PrecisionType, 3, 1>& rootCenter,
+                  typename TRAITS::PrecisionType rootSize,
+                  float rootExclusionFactor,
+                  OctreeObjectIndex splitThreshold,
+                  util::ThreadPool& threadPool)
+{
+    static_assert(!std::is_reference_v<STORAGE>, "makeDynamicOctree must be called with rvalue for objects parameter");
+    return std::make_unique<DynamicOctree<TRAITS, STORAGE>>(std::forward<STORAGE>(objects),
+                                                            rootCenter,
+                                                            rootSize,
+                                                            rootExclusionFactor,
+                                                            splitThreshold,
+                                                            threadPool);
+}
+
 } // end namespace celestia::engine
@@ -0,0 +1,345 @@
+// octreecache.h
+//
+// On-disk cache of built octrees.
+//
+// Copyright (C) 2024, Celestia Development Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <Eigen/Core>
+
+#include <celcompat/filesystem.h>
+#include <celutil/atomicfile.h>
+#include <celutil/filelock.h>
+#include <celutil/hash.h>
+#include <celutil/mappedfile.h>
+#include "octree.h"
+
+namespace celestia::engine
+{
+
+// The OctreeCache stores the flattened nodes of a StaticOctree together
+// with the order in which the source objects were placed into it, so that
+// a later run loading the same objects can skip the DynamicOctree build.
+//
+// The cache is keyed on a hash of everything the octree layout depends on:
+// the build parameters and the position, magnitude and radius of every
+// object in load order. The file is written in native byte order as it is
+// only ever read back on the machine which wrote it.
+//
+// The node tables are stored as aligned arrays which link the nodes by
+// index, and a loaded octree traverses them in place from a read-only
+// mapping of the file. Processes loading the same catalogs, such as the
+// channels of a planetarium dome, thus share one copy of the tables, and
+// holding lock() while loading or building and saving the octree lets the
+// first of several processes started together build it for the others.
+template<class TRAITS>
+class OctreeCache
+{
+public:
+    using ObjectType = typename TRAITS::ObjectType;
+    using PrecisionType = typename TRAITS::PrecisionType;
+    using PointType = Eigen::Matrix<PrecisionType, 3, 1>;
+    using StaticOctreeType = StaticOctree<ObjectType, PrecisionType>;
+
+    OctreeCache(const fs::path&, std::uint64_t key);
+
+    template<class STORAGE>
+    static std::uint64_t computeKey(const STORAGE& objects,
+                                    const PointType& rootCenter,
+                                    PrecisionType rootSize,
+                                    float rootExclusionFactor,
+                                    OctreeObjectIndex splitThreshold);
+
+    // Returns nullptr if there is no valid cache for the key, in which case
+    // the objects are left untouched.
+    template<class STORAGE>
+    std::unique_ptr<StaticOctreeType> load(STORAGE& objects) const;
+
+    bool save(const StaticOctreeType&, const std::vector<OctreeObjectIndex>& objectOrder) const;
+
+    // Returns nullptr if the lock file can't be created, in which case the
+    // cache still works but processes may build the octree concurrently
+    std::unique_ptr<util::FileLock> lock() const;
+
+private:
+    using NodeType = typename StaticOctreeType::NodeType;
+
+    // The nodes are stored as they are in memory. Eigen vectors have no
+    // trivial copy constructor, but are plain arrays of their scalars.
+    static_assert(std::is_standard_layout_v<NodeType> && std::is_trivially_destructible_v<NodeType>);
+
+    struct Header
+    {
+        std::uint32_t version;
+        std::uint32_t nodeSize;
+        std::uint64_t key;
+        std::uint32_t objectCount;
+        std::uint32_t nodeCount;
+        std::uint32_t depthCount;
+        std::uint32_t minPopulated;
+        std::uint32_t maxDepth;
+    };
+
+    // Offsets of the arrays in the file
+    struct Layout
+    {
+        std::size_t sizes;
+        std::size_t nodes;
+        std::size_t centerX;
+        std::size_t centerY;
+        std::size_t centerZ;
+        std::size_t size;
+        std::size_t brightFactor;
+        std::size_t objectOrder;
+        std::size_t end;
+    };
+
+    static constexpr std::string_view Magic{ "CELOCTRE" };
+    static constexpr std::uint32_t Version = 2;
+    // Alignment of the arrays, enough for the batched traversal loads
+    static constexpr std::size_t SectionAlignment = 64;
+
+    static Layout getLayout(const Header&);
+    static std::size_t paddedNodeCount(std::size_t nodeCount);
+
+    fs::path m_path;
+    std::uint64_t m_key;
+};
+
+template<class TRAITS>
+OctreeCache<TRAITS>::OctreeCache(const fs::path& path, std::uint64_t key) :
+    m_path(path),
+    m_key(key)
+{
+}
+
+template<class TRAITS>
+template<class STORAGE>
+std::uint64_t
+OctreeCache<TRAITS>::computeKey(const STORAGE& objects,
+                                const PointType& rootCenter,
+                                PrecisionType rootSize,
+                                float rootExclusionFactor,
+                                OctreeObjectIndex splitThreshold)
+{
+    util::FNV1aHash hash;
+    hash.addValue(Version);
+    hash.addValue(static_cast<std::uint32_t>(sizeof(PrecisionType)));
+    hash.addValue(rootCenter.x());
+    hash.addValue(rootCenter.y());
+    hash.addValue(rootCenter.z());
+    hash.addValue(rootSize);
+    hash.addValue(rootExclusionFactor);
+    hash.addValue(splitThreshold);
+    hash.addValue(TRAITS::applyDecay(rootExclusionFactor));
+
+    const auto count = static_cast<OctreeObjectIndex>(objects.size());
+    hash.addValue(count);
+    for (OctreeObjectIndex i = 0; i < count; ++i)
+    {
+        const ObjectType& obj = objects[i];
+        PointType position = TRAITS::getPosition(obj);
+        hash.addValue(position.x());
+        hash.addValue(position.y());
+        hash.addValue(position.z());
+        hash.addValue(TRAITS::getMagnitude(obj));
+        hash.addValue(TRAITS::getRadius(obj));
+    }
+
+    return hash.value();
+}
+
+template<class TRAITS>
+std::size_t
+OctreeCache<TRAITS>::paddedNodeCount(std::size_t nodeCount)
+{
+    return ((nodeCount + OctreeNodeBatchSize - 1) / OctreeNodeBatchSize) * OctreeNodeBatchSize;
+}
+
+template<class TRAITS>
+typename OctreeCache<TRAITS>::Layout
+OctreeCache<TRAITS>::getLayout(const Header& header)
+{
+    auto align = [](std::size_t offset)
+    {
+        return (offset + SectionAlignment - 1) & ~(SectionAlignment - 1);
+    };
+
+    const std::size_t padded = paddedNodeCount(header.nodeCount);
+
+    Layout layout;
+    layout.sizes = align(Magic.size() + sizeof(Header));
+    layout.nodes = align(layout.sizes + sizeof(PrecisionType) * header.depthCount);
+    layout.centerX = align(layout.nodes + sizeof(NodeType) * header.nodeCount);
+    layout.centerY = align(layout.centerX + sizeof(PrecisionType) * padded);
+    layout.centerZ = align(layout.centerY + sizeof(PrecisionType) * padded);
+    layout.size = align(layout.centerZ + sizeof(PrecisionType) * padded);
+    layout.brightFactor = align(layout.size + sizeof(PrecisionType) * padded);
+    layout.objectOrder = align(layout.brightFactor + sizeof(float) * padded);
+    layout.end = layout.objectOrder + sizeof(OctreeObjectIndex) * header.objectCount;
+    return layout;
+}
+
+template<class TRAITS>
+template<class STORAGE>
+std::unique_ptr<typename OctreeCache<TRAITS>::StaticOctreeType>
+OctreeCache<TRAITS>::load(STORAGE& objects) const
+{
+    std::shared_ptr<const util::MappedFile> file = util::MappedFile::open(m_path);
+    if (file == nullptr || file->size() < Magic.size() + sizeof(Header) ||
+        std::string_view(file->data(), Magic.size()) != Magic)
+    {
+        return nullptr;
+    }
+
+    Header header;
+    std::memcpy(&header, file->data() + Magic.size(), sizeof(Header));
+    if (header.version != Version ||
+        header.nodeSize != sizeof(NodeType) ||
+        header.key != m_key ||
+        header.objectCount != objects.size() ||
+        header.nodeCount == 0 ||
+        header.depthCount == 0)
+    {
+        return nullptr;
+    }
+
+    const Layout layout = getLayout(header);
+    if (file->size() < layout.end)
+        return nullptr;
+
+    // The mapping is page aligned, so are the arrays at their alignment
+    const char* data = file->data();
+    const auto* nodes = reinterpret_cast<const NodeType*>(data + layout.nodes); //NOSONAR
+    const auto* sizes = reinterpret_cast<const PrecisionType*>(data + layout.sizes); //NOSONAR
+    const auto* order = reinterpret_cast<const OctreeObjectIndex*>(data + layout.objectOrder); //NOSONAR
+
+    for (std::uint32_t i = 0; i < header.nodeCount; ++i)
+    {
+        const NodeType& node = nodes[i];
+        if (node.depth >= header.depthCount ||
+            node.first > node.last ||
+            node.last > header.objectCount ||
+            (node.right <= i && node.right != InvalidOctreeNode))
+        {
+            return nullptr;
+        }
+    }
+
+    // Validate the order fully before moving any object out of the storage
+    std::vector<bool> seen(header.objectCount, false);
+    for (std::uint32_t i = 0; i < header.objectCount; ++i)
+    {
+        if (order[i] >= header.objectCount || seen[order[i]])
+            return nullptr;
+        seen[order[i]] = true;
+    }
+
+    auto octree = std::make_unique<StaticOctreeType>();
+    octree->m_sizes.assign(sizes, sizes + header.depthCount);
+
+    octree->m_objects.reserve(header.objectCount);
+    for (std::uint32_t i = 0; i < header.objectCount; ++i)
+        octree->m_objects.emplace_back(std::move(objects[order[i]]));
+
+    octree->m_minPopulated = header.minPopulated;
+    octree->m_maxDepth = header.maxDepth;
+
+    auto& tables = octree->m_tables;
+    tables.nodes = nodes;
+    tables.nodeCount = header.nodeCount;
+    tables.centerX = reinterpret_cast<const PrecisionType*>(data + layout.centerX); //NOSONAR
+    tables.centerY = reinterpret_cast<const PrecisionType*>(data + layout.centerY); //NOSONAR
+    tables.centerZ = reinterpret_cast<const PrecisionType*>(data + layout.centerZ); //NOSONAR
+    tables.size = reinterpret_cast<const PrecisionType*>(data + layout.size); //NOSONAR
+    tables.brightFactor = reinterpret_cast<const float*>(data + layout.brightFactor); //NOSONAR
+    octree->m_sharedTables = std::move(file);
+
+    return octree;
+}
+
+template<class TRAITS>
+bool
+OctreeCache<TRAITS>::save(const StaticOctreeType& octree,
+                          const std::vector<OctreeObjectIndex>& objectOrder) const
+{
+    if (objectOrder.size() != octree.m_objects.size())
+        return false;
+
+    std::error_code ec;
+    fs::create_directories(m_path.parent_path(), ec);
+
+    const auto& tables = octree.m_tables;
+    Header header{};
+    header.version = Version;
+    header.nodeSize = static_cast<std::uint32_t>(sizeof(NodeType));
+    header.key = m_key;
+    header.objectCount = static_cast<std::uint32_t>(octree.m_objects.size());
+    header.nodeCount = tables.nodeCount;
+    header.depthCount = static_cast<std::uint32_t>(octree.m_sizes.size());
+    header.minPopulated = octree.m_minPopulated;
+    header.maxDepth = octree.m_maxDepth;
+
+    const Layout layout = getLayout(header);
+    const std::size_t padded = paddedNodeCount(tables.nodeCount);
+
+    // A process mapping the previous file keeps its contents
+    util::AtomicFile file(m_path);
+    if (!file.isOpen())
+        return false;
+
+    std::ofstream& out = file.stream();
+    std::size_t offset = 0;
+    auto writeAt = [&out, &offset](std::size_t position, const void* values, std::size_t bytes)
+    {
+        static constexpr char zeros[SectionAlignment]{}; //NOSONAR
+        if (position > offset)
+            out.write(zeros, static_cast<std::streamsize>(position - offset));
+        out.write(static_cast<const char*>(values), static_cast<std::streamsize>(bytes));
+        offset = position + bytes;
+    };
+
+    writeAt(0, Magic.data(), Magic.size());
+    writeAt(offset, &header, sizeof(Header));
+    writeAt(layout.sizes, octree.m_sizes.data(), sizeof(PrecisionType) * octree.m_sizes.size());
+    writeAt(layout.nodes, tables.nodes, sizeof(NodeType) * tables.nodeCount);
+    writeAt(layout.centerX, tables.centerX, sizeof(PrecisionType) * padded);
+    writeAt(layout.centerY, tables.centerY, sizeof(PrecisionType) * padded);
+    writeAt(layout.centerZ, tables.centerZ, sizeof(PrecisionType) * padded);
+    writeAt(layout.size, tables.size, sizeof(PrecisionType) * padded);
+    writeAt(layout.brightFactor, tables.brightFactor, sizeof(float) * padded);
+    writeAt(layout.objectOrder, objectOrder.data(), sizeof(OctreeObjectIndex) * objectOrder.size());
+
+    return file.commit();
+}
+
+template<class TRAITS>
+std::unique_ptr<util::FileLock>
+OctreeCache<TRAITS>::lock() const
+{
+    std::error_code ec;
+    fs::create_directories(m_path.parent_path(), ec);
+
+    fs::path lockPath = m_path;
+    lockPath += ".lock";
+    return util::FileLock::acquire(lockPath);
+}
+
+} // end namespace celestia::engine
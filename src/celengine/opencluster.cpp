@@ -11,6 +11,8 @@
 #include "render.h"
 #include "opencluster.h"
 #include "meshmanager.h"
+#include "stardb.h"
+#include "staroctree.h"
 #include <celmath/mathlib.h>
 #include <celutil/gettext.h>
 #include <algorithm>
@@ -19,6 +21,31 @@ using namespace Eigen;
 using namespace std;
 
 
+namespace
+{
+
+class MemberCollector : public celestia::engine::StarHandler
+{
+public:
+    MemberCollector(const StarDatabase& starDB, std::vector<std::uint32_t>& members) :
+        firstStar(starDB.size() > 0 ? starDB.getStar(0) : nullptr),
+        members(members)
+    {
+    }
+
+    void process(const Star& star, float /*distance*/, float /*appMag*/) override
+    {
+        members.push_back(static_cast<std::uint32_t>(&star - firstStar));
+    }
+
+private:
+    const Star* firstStar;
+    std::vector<std::uint32_t>& members;
+};
+
+} // end unnamed namespace
+
+
 const char* OpenCluster::getType() const
 {
     return "Open cluster";
@@ -52,6 +79,19 @@ bool OpenCluster::pick(const Eigen::ParametrizedLine<double, 3>& ray,
 }
 
 
+void OpenCluster::findMembers(const StarDatabase& starDB)
+{
+    members.clear();
+    if (starDB.size() == 0)
+        return;
+
+    MemberCollector collector(starDB, members);
+    starDB.findCloseStars(collector, getPosition().cast<float>(), getRadius());
+    std::sort(members.begin(), members.end());
+    members.shrink_to_fit();
+}
+
+
 RenderFlags OpenCluster::getRenderMask() const
 {
     return RenderFlags::ShowOpenClusters;
@@ -12,6 +12,7 @@
 #include <cstdint>
 #include <string>
 #include <string_view>
+#include <vector>
 
 #include <Eigen/Geometry>
 
@@ -19,6 +20,8 @@
 #include "deepskyobj.h"
 #include "renderflags.h"
 
+class StarDatabase;
+
 class OpenCluster : public DeepSkyObject
 {
 public:
@@ -37,10 +40,19 @@ public:
 
     DeepSkyObjectType getObjType() const override;
 
+    // Indices in the star database of the stars within the radius of the
+    // cluster, in increasing order. They are found when the catalogs are
+    // loaded, so that renderers need not search the star octree for them.
+    const std::vector<std::uint32_t>& getMembers() const { return members; }
+    void findMembers(const StarDatabase&);
+
     enum ClusterType
     {
         Open          = 0,
         Globular      = 1,
         NotDefined    = 2
     };
+
+private:
+    std::vector<std::uint32_t> members;
 };
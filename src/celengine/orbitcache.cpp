@@ -0,0 +1,166 @@
+// orbitcache.cpp
+//
+// Copyright (C) 2024, Celestia Development Team
+//
+// Cache of sampled orbit paths.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include "orbitcache.h"
+
+#include <chrono>
+#include <string>
+#include <utility>
+
+#include <celephem/orbit.h>
+#include <celutil/profiler.h>
+#include <celutil/threadpool.h>
+#include "framestats.h"
+#include "orbitsampler.h"
+
+namespace engine = celestia::engine;
+namespace ephem = celestia::ephem;
+namespace util = celestia::util;
+
+namespace
+{
+
+// Number of intervals of the path drawn while an orbit is being sampled
+constexpr unsigned int PlaceholderIntervals = 16;
+
+bool
+isReady(const std::future<std::vector<CurvePlotSample>>& future)
+{
+    return future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+} // end unnamed namespace
+
+OrbitCache::OrbitCache(const Renderer& renderer, std::size_t budget, util::ThreadPool* threadPool) :
+    m_renderer(renderer),
+    m_budget(budget),
+    m_threadPool(threadPool)
+{
+}
+
+OrbitCache::~OrbitCache()
+{
+    clear();
+}
+
+CurvePlot*
+OrbitCache::get(const std::shared_ptr<const ephem::Orbit>& orbit, double startTime, std::uint32_t frame)
+{
+    engine::FrameCounters& counters = engine::GetFrameStats()->current();
+    if (auto it = m_entries.find(orbit.get()); it != m_entries.end())
+    {
+        ++counters.orbitCacheHits;
+        Entry& entry = *it->second;
+        m_lru.splice(m_lru.begin(), m_lru, it->second);
+        entry.lastUsed = frame;
+        integrate(entry);
+        updateBytes(entry);
+        return entry.plot.get();
+    }
+
+    ++counters.orbitCacheMisses;
+    Entry& entry = m_lru.emplace_front();
+    entry.orbit = orbit;
+    entry.lastUsed = frame;
+    m_entries.try_emplace(orbit.get(), m_lru.begin());
+
+    double tolerance = ephem::OrbitSampleProc::DefaultAngularTolerance * m_toleranceScale;
+    if (m_threadPool != nullptr && orbit->isThreadSafe())
+    {
+        entry.plot = samplePlaceholder(orbit.get(), startTime);
+        // The task owns the orbit too, as the entry may be evicted first
+        entry.pending = m_threadPool->async([orbit, startTime, tolerance]
+        {
+            OrbitSampler sampler(tolerance);
+            orbit->sample(startTime, startTime + orbit->getPeriod(), sampler);
+            return std::move(sampler.samples);
+        });
+    }
+    else
+    {
+        entry.plot = std::make_unique<CurvePlot>(m_renderer);
+        OrbitSampler sampler(tolerance);
+        orbit->sample(startTime, startTime + orbit->getPeriod(), sampler);
+        sampler.insertForward(entry.plot.get());
+    }
+
+    updateBytes(entry);
+    evict(frame);
+    return entry.plot.get();
+}
+
+void
+OrbitCache::clear()
+{
+    m_entries.clear();
+    m_lru.clear();
+    m_bytes = 0;
+}
+
+std::unique_ptr<CurvePlot>
+OrbitCache::samplePlaceholder(const ephem::Orbit* orbit, double startTime) const
+{
+    auto plot = std::make_unique<CurvePlot>(m_renderer);
+    double period = orbit->getPeriod();
+    for (unsigned int i = 0; i <= PlaceholderIntervals; ++i)
+    {
+        CurvePlotSample sample;
+        sample.t = startTime + period * static_cast<double>(i) / static_cast<double>(PlaceholderIntervals);
+        sample.position = orbit->positionAtTime(sample.t);
+        sample.velocity = orbit->velocityAtTime(sample.t);
+        plot->addSample(sample);
+    }
+
+    return plot;
+}
+
+// Replace the placeholder with the full path once it has been sampled
+void
+OrbitCache::integrate(Entry& entry)
+{
+    if (!entry.pending.valid() || !isReady(entry.pending))
+        return;
+
+    Samples samples = entry.pending.get();
+    if (samples.empty())
+        return;
+
+    auto plot = std::make_unique<CurvePlot>(m_renderer);
+    for (const CurvePlotSample& sample : samples)
+        plot->addSample(sample);
+    entry.plot = std::move(plot);
+}
+
+void
+OrbitCache::updateBytes(Entry& entry)
+{
+    m_bytes -= entry.bytes;
+    entry.bytes = sizeof(Entry) + sizeof(CurvePlot) + entry.plot->sampleCount() * sizeof(CurvePlotSample)
+                + entry.plot->bufferBytes();
+    m_bytes += entry.bytes;
+}
+
+void
+OrbitCache::evict(std::uint32_t frame)
+{
+    std::size_t evicted = 0;
+    while (m_bytes > m_budget && !m_lru.empty() && m_lru.back().lastUsed != frame)
+    {
+        ++evicted;
+        Entry& entry = m_lru.back();
+        m_bytes -= entry.bytes;
+        m_entries.erase(entry.orbit.get());
+        m_lru.pop_back();
+    }
+
+    if (evicted > 0 && util::Profiler::isEnabled())
+        util::Profiler::recordInstant("eviction", "orbits: " + std::to_string(evicted));
+}
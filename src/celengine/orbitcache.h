@@ -0,0 +1,105 @@
+// orbitcache.h
+//
+// Copyright (C) 2024, Celestia Development Team
+//
+// Cache of sampled orbit paths.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "curveplot.h"
+
+class Renderer;
+
+namespace celestia::ephem
+{
+class Orbit;
+}
+
+namespace celestia::util
+{
+class ThreadPool;
+}
+
+// Least recently used cache of orbit paths, limited by the memory used by
+// the samples and their copies on the GPU. Entries used in the current frame are never evicted, so the
+// budget may be exceeded while more orbits are visible than fit in it.
+//
+// Orbits which can be sampled concurrently are sampled on the thread pool
+// when they are first requested; until the samples arrive the orbit is drawn
+// from a coarse placeholder. Other orbits are sampled immediately.
+//
+// The entries and the sampling tasks share the ownership of their orbits, so
+// an orbit replaced while its path is cached or being sampled, e.g. by a
+// catalog reload, stays alive until its entry is evicted and its samples
+// have arrived.
+class OrbitCache
+{
+public:
+    static constexpr std::size_t DefaultBudget = 32 * 1024 * 1024;
+
+    OrbitCache(const Renderer&, std::size_t budget, celestia::util::ThreadPool*);
+    ~OrbitCache();
+
+    OrbitCache(const OrbitCache&) = delete;
+    OrbitCache& operator=(const OrbitCache&) = delete;
+    OrbitCache(OrbitCache&&) = delete;
+    OrbitCache& operator=(OrbitCache&&) = delete;
+
+    // Get the path of the orbit, sampled starting from startTime if it is
+    // not in the cache yet. The path may be modified by the caller; its size
+    // is accounted for on the next lookup.
+    CurvePlot* get(const std::shared_ptr<const celestia::ephem::Orbit>&, double startTime, std::uint32_t frame);
+
+    // Remove all the paths; pending samples are discarded
+    void clear();
+
+    // Factor applied to the angular tolerance of the paths sampled from now
+    // on; above 1 samples them more sparsely
+    void setToleranceScale(double scale) { m_toleranceScale = scale; }
+
+    std::size_t size() const { return m_entries.size(); }
+    std::size_t bytes() const { return m_bytes; }
+
+private:
+    using Samples = std::vector<CurvePlotSample>;
+
+    struct Entry
+    {
+        std::shared_ptr<const celestia::ephem::Orbit> orbit;
+        std::unique_ptr<CurvePlot> plot;
+        std::future<Samples> pending;
+        std::size_t bytes{ 0 };
+        std::uint32_t lastUsed{ 0 };
+    };
+
+    using EntryList = std::list<Entry>;
+
+    std::unique_ptr<CurvePlot> samplePlaceholder(const celestia::ephem::Orbit*, double startTime) const;
+    void integrate(Entry&);
+    void updateBytes(Entry&);
+    void evict(std::uint32_t frame);
+
+    const Renderer& m_renderer;
+    std::size_t m_budget;
+    celestia::util::ThreadPool* m_threadPool;
+    double m_toleranceScale{ 1.0 };
+
+    // Most recently used first. The entries are keyed by the address of
+    // their orbit, which they keep alive.
+    EntryList m_lru;
+    std::unordered_map<const celestia::ephem::Orbit*, EntryList::iterator> m_entries;
+    std::size_t m_bytes{ 0 };
+};
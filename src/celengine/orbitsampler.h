@@ -20,6 +20,9 @@ public:
     std::vector<CurvePlotSample> samples;
 
     OrbitSampler() = default;
+    explicit OrbitSampler(double tolerance) : m_tolerance(tolerance) {}
+
+    double angularTolerance() const override { return m_tolerance; }
 
     void sample(double t, const Eigen::Vector3d& position, const Eigen::Vector3d& velocity)
     {
@@ -45,4 +48,7 @@ public:
             plot->addSample(*iter);
         }
     }
+
+private:
+    double m_tolerance{ DefaultAngularTolerance };
 };
@@ -8,6 +8,7 @@
 // as published by the Free Software Foundation; either version 2
 // of the License, or (at your option) any later version.
 
+#include <algorithm>
 #include <cstring>
 #include <Eigen/Core>
 #include <celmath/geomutil.h>
@@ -26,12 +27,14 @@ Overlay::Overlay(Renderer& r) :
     layout(make_unique<TextLayout>(r.getScreenDpi())),
     renderer(r)
 {
+    layout->setLineCache(&lineCache);
 }
 
 void Overlay::begin()
 {
     layout->setLayoutDirectionFollowTextAlignment(true);
     layout->setScreenDpi(renderer.getScreenDpi());
+    lineCache.nextFrame();
 
     projection = math::Ortho2D(0.0f, (float)windowWidth, 0.0f, (float)windowHeight);
     // ModelView is Identity
@@ -45,6 +48,7 @@ void Overlay::begin()
 
 void Overlay::end()
 {
+    drawText();
 }
 
 
@@ -57,6 +61,9 @@ void Overlay::setWindowSize(int w, int h)
 void Overlay::setFont(const std::shared_ptr<TextureFont>& f)
 {
     layout->setFont(f);
+    font = f;
+    if (inText)
+        batchFont();
 }
 
 void Overlay::setTextAlignment(TextLayout::HorizontalAlignment halign)
@@ -68,11 +75,15 @@ void Overlay::beginText()
 {
     savePos();
     layout->begin(projection);
+    inText = true;
+    batchFont();
 }
 
 void Overlay::endText()
 {
+    // The text stays queued until the next rectangle or the end of the frame
     layout->end();
+    inText = false;
     restorePos();
 }
 
@@ -81,29 +92,34 @@ void Overlay::print(std::string_view s)
     layout->render(s);
 }
 
-void Overlay::drawRectangle(const celestia::Rect& r) const
+void Overlay::drawRectangle(const celestia::Rect& r)
 {
+    layout->flush();
+    drawText();
     renderer.drawRectangle(r, FisheyeOverrideMode::Disabled, projection);
+    if (inText)
+        batchFont();
 }
 
 void Overlay::setColor(float r, float g, float b, float a)
 {
-    layout->flush();
-    glVertexAttrib4f(CelestiaGLProgram::ColorAttributeIndex, r, g, b, a);
+    setColor(Color(r, g, b, a));
 }
 
 void Overlay::setColor(const Color& c)
 {
+    // The pending line is queued with the previous color
     layout->flush();
+    textColor = c;
     glVertexAttrib4f(CelestiaGLProgram::ColorAttributeIndex,
                      c.red(), c.green(), c.blue(), c.alpha());
+    if (font != nullptr)
+        font->setBatchColor(textColor);
 }
 
 void Overlay::setColor(const Color& c, float a)
 {
-    layout->flush();
-    glVertexAttrib4f(CelestiaGLProgram::ColorAttributeIndex,
-                     c.red(), c.green(), c.blue(), a);
+    setColor(Color(c, a));
 }
 
 void Overlay::moveBy(float dx, float dy)
@@ -116,6 +132,26 @@ void Overlay::moveBy(int dx, int dy)
     layout->moveRelative(static_cast<float>(dx), static_cast<float>(dy));
 }
 
+void Overlay::batchFont()
+{
+    if (font == nullptr)
+        return;
+
+    if (std::find(batchedFonts.begin(), batchedFonts.end(), font) == batchedFonts.end())
+    {
+        font->beginBatch();
+        batchedFonts.push_back(font);
+    }
+    font->setBatchColor(textColor);
+}
+
+void Overlay::drawText()
+{
+    for (const auto& f : batchedFonts)
+        f->endBatch();
+    batchedFonts.clear();
+}
+
 void Overlay::savePos()
 {
     posStack.push_back(layout->getCurrentPosition());
@@ -10,15 +10,18 @@
 
 #pragma once
 
+#include <cstddef>
+#include <iterator>
 #include <locale>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 #include <fmt/printf.h>
 #include <Eigen/Core>
 #include <celengine/textlayout.h>
+#include <celutil/color.h>
 
-class Color;
 class Overlay;
 class Renderer;
 
@@ -55,7 +58,8 @@ class Overlay
         return renderer;
     };
 
-    void drawRectangle(const celestia::Rect&) const;
+    // Queued text is drawn first, so that rectangles cover the text before them
+    void drawRectangle(const celestia::Rect&);
 
     void beginText();
     void endText();
@@ -66,14 +70,18 @@ class Overlay
     void print(const std::locale& loc, fmt::format_string<T...> format, T&&... args)
     {
         static_assert(sizeof...(args) > 0);
-        print(fmt::format(loc, format, std::forward<T>(args)...));
+        fmt::basic_memory_buffer<char, PrintBufferSize> buffer;
+        fmt::format_to(std::back_inserter(buffer), loc, format, std::forward<T>(args)...);
+        print(std::string_view(buffer.data(), buffer.size()));
     }
 
     template <typename... T>
     void print(fmt::format_string<T...> format, T&&... args)
     {
         static_assert(sizeof...(args) > 0);
-        print(fmt::format(format, std::forward<T>(args)...));
+        fmt::basic_memory_buffer<char, PrintBufferSize> buffer;
+        fmt::format_to(std::back_inserter(buffer), format, std::forward<T>(args)...);
+        print(std::string_view(buffer.data(), buffer.size()));
     }
 
     template <typename... T>
@@ -84,13 +92,27 @@ class Overlay
     }
 
  private:
+    // Formatted lines up to this size don't allocate
+    static constexpr std::size_t PrintBufferSize = 256;
+
     int windowWidth{ 1 };
     int windowHeight{ 1 };
 
     std::unique_ptr<celestia::engine::TextLayout> layout{ nullptr };
+    // The lines printed in every frame are laid out once
+    celestia::engine::TextLineCache lineCache;
+
+    // The text of a frame is queued and drawn with one call per font
+    std::shared_ptr<TextureFont> font;
+    std::vector<std::shared_ptr<TextureFont>> batchedFonts;
+    Color textColor{ 1.0f, 1.0f, 1.0f, 1.0f };
+    bool inText{ false };
 
     Renderer& renderer;
 
     std::vector<std::pair<float, float>> posStack;
     Eigen::Matrix4f projection;
+
+    void batchFont();
+    void drawText();
 };
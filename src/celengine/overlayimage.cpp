@@ -1,16 +1,38 @@
 #include <algorithm>
 #include <celmath/mathlib.h>
 #include "overlayimage.h"
+#include "overlayimagecache.h"
 #include "rectangle.h"
 #include "render.h"
 
+namespace
+{
+
+fs::path
+imagePath(const fs::path& filename)
+{
+    return fs::path("images") / filename;
+}
+
+} // end unnamed namespace
+
 OverlayImage::OverlayImage(fs::path f, Renderer *r) :
     filename(std::move(f)),
     renderer(r)
 {
-    texture = LoadTextureFromFile(fs::path("images") / filename,
-                                  Texture::EdgeClamp,
-                                  Texture::NoMipMaps);
+    if (renderer != nullptr)
+        texture = renderer->getOverlayImageCache().get(imagePath(filename));
+}
+
+void OverlayImage::preload(const fs::path& f, Renderer *r)
+{
+    r->getOverlayImageCache().preload(imagePath(f));
+}
+
+bool OverlayImage::isLoading() const
+{
+    return texture == nullptr && renderer != nullptr &&
+           renderer->getOverlayImageCache().isLoading(imagePath(filename));
 }
 
 void OverlayImage::setColor(const Color& c)
@@ -25,9 +47,17 @@ void OverlayImage::setColor(std::array<Color, 4>& c)
 
 void OverlayImage::render(float curr_time, int width, int height)
 {
-    if (renderer == nullptr || texture == nullptr || (curr_time >= start + duration))
+    if (renderer == nullptr || (curr_time >= start + duration))
         return;
 
+    // The image is shown once it is decoded
+    if (texture == nullptr)
+    {
+        texture = renderer->getOverlayImageCache().get(imagePath(filename));
+        if (texture == nullptr)
+            return;
+    }
+
     float xSize = texture->getWidth();
     float ySize = texture->getHeight();
 
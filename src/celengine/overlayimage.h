@@ -17,6 +17,10 @@ class OverlayImage
     OverlayImage(OverlayImage&&) = delete;
 
     void render(float, int, int);
+    // Whether the image is still being decoded, and isn't shown yet
+    bool isLoading() const;
+    // Start decoding an image a script will show
+    static void preload(const fs::path&, Renderer*);
     bool isNewImage(const fs::path& f) const
     {
         return filename != f;
@@ -55,6 +59,6 @@ class OverlayImage
     std::array<Color, 4> colors;
 
     fs::path filename;
-    std::unique_ptr<Texture> texture;
+    std::shared_ptr<Texture> texture;
     Renderer *renderer { nullptr };
 };
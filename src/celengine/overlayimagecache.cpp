@@ -0,0 +1,161 @@
+// overlayimagecache.cpp
+//
+// Copyright (C) 2026, Celestia Development Team
+//
+// Cache of the textures of the images shown by scripts over the view.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include "overlayimagecache.h"
+
+#include <chrono>
+#include <utility>
+
+#include <celimage/image.h>
+#include <celutil/threadpool.h>
+#include "texture.h"
+
+namespace engine = celestia::engine;
+namespace util = celestia::util;
+
+namespace
+{
+
+// Time spent uploading the parts of a large image per frame
+constexpr std::chrono::milliseconds UploadBudget{ 4 };
+
+bool
+isReady(const std::future<std::unique_ptr<engine::Image>>& future)
+{
+    return future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+} // end unnamed namespace
+
+OverlayImageCache::OverlayImageCache(std::size_t budget, util::ThreadPool* threadPool) :
+    m_budget(budget),
+    m_threadPool(threadPool)
+{
+}
+
+OverlayImageCache::~OverlayImageCache()
+{
+    clear();
+}
+
+void
+OverlayImageCache::preload(const fs::path& path)
+{
+    find(path);
+}
+
+std::shared_ptr<Texture>
+OverlayImageCache::get(const fs::path& path)
+{
+    Entry& entry = find(path);
+    finishLoading(entry);
+    return entry.complete ? entry.texture : nullptr;
+}
+
+bool
+OverlayImageCache::isLoading(const fs::path& path) const
+{
+    auto it = m_entries.find(path);
+    return it != m_entries.end() && !it->second->complete && !it->second->failed;
+}
+
+void
+OverlayImageCache::clear()
+{
+    for (Entry& entry : m_lru)
+    {
+        if (entry.pending.valid())
+            entry.pending.wait();
+    }
+
+    m_entries.clear();
+    m_lru.clear();
+    m_bytes = 0;
+}
+
+OverlayImageCache::Entry&
+OverlayImageCache::find(const fs::path& path)
+{
+    if (auto it = m_entries.find(path); it != m_entries.end())
+    {
+        m_lru.splice(m_lru.begin(), m_lru, it->second);
+        return *it->second;
+    }
+
+    Entry& entry = m_lru.emplace_front();
+    entry.path = path;
+    m_entries.try_emplace(path, m_lru.begin());
+
+    if (m_threadPool != nullptr)
+    {
+        entry.pending = m_threadPool->async([path]
+        {
+            return LoadTextureImage(path);
+        });
+    }
+    else
+    {
+        std::promise<std::unique_ptr<engine::Image>> promise;
+        promise.set_value(LoadTextureImage(path));
+        entry.pending = promise.get_future();
+    }
+
+    return entry;
+}
+
+// Create the texture once the image is decoded, and continue its upload
+void
+OverlayImageCache::finishLoading(Entry& entry)
+{
+    if (entry.complete || entry.failed)
+        return;
+
+    if (entry.pending.valid())
+    {
+        if (!isReady(entry.pending))
+            return;
+
+        std::unique_ptr<engine::Image> image = entry.pending.get();
+        if (image != nullptr)
+            entry.texture = CreateTextureFromFileImage(entry.path, std::move(image), Texture::EdgeClamp, Texture::NoMipMaps);
+
+        if (entry.texture == nullptr)
+        {
+            entry.failed = true;
+            return;
+        }
+    }
+
+    if (!entry.texture->upload(std::chrono::steady_clock::now() + UploadBudget))
+        return;
+
+    entry.complete = true;
+    entry.bytes = entry.texture->getMemoryUsage();
+    m_bytes += entry.bytes;
+    evict();
+}
+
+// Images still shown or loading are never evicted; images which failed to
+// load are kept until then so that they aren't read again
+void
+OverlayImageCache::evict()
+{
+    for (auto it = m_lru.end(); m_bytes > m_budget && it != m_lru.begin();)
+    {
+        --it;
+        if ((!it->complete && !it->failed) || it->texture.use_count() > 1)
+            continue;
+
+        m_bytes -= it->bytes;
+        m_entries.erase(it->path);
+        it = m_lru.erase(it);
+    }
+}
@@ -0,0 +1,92 @@
+// overlayimagecache.h
+//
+// Copyright (C) 2026, Celestia Development Team
+//
+// Cache of the textures of the images shown by scripts over the view.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <cstddef>
+#include <future>
+#include <list>
+#include <map>
+#include <memory>
+
+#include <celcompat/filesystem.h>
+
+class Texture;
+
+namespace celestia::engine
+{
+class Image;
+}
+
+namespace celestia::util
+{
+class ThreadPool;
+}
+
+// The images are decoded on the thread pool, so that a script switching
+// slides doesn't stall the frame, and uploaded by the render thread within a
+// time budget per frame. Images no longer shown are kept, least recently used
+// first out, within a memory budget, as shows often come back to them.
+class OverlayImageCache
+{
+public:
+    static constexpr std::size_t DefaultBudget = 64 * 1024 * 1024;
+
+    OverlayImageCache(std::size_t budget, celestia::util::ThreadPool*);
+    ~OverlayImageCache();
+
+    OverlayImageCache(const OverlayImageCache&) = delete;
+    OverlayImageCache& operator=(const OverlayImageCache&) = delete;
+    OverlayImageCache(OverlayImageCache&&) = delete;
+    OverlayImageCache& operator=(OverlayImageCache&&) = delete;
+
+    // Start decoding the image unless it is cached
+    void preload(const fs::path&);
+
+    // The texture of the image, or nullptr until it is decoded and uploaded,
+    // or if it couldn't be loaded. Starts decoding the image unless it is
+    // cached.
+    std::shared_ptr<Texture> get(const fs::path&);
+
+    // Whether the image is still being decoded or uploaded
+    bool isLoading(const fs::path&) const;
+
+    // Remove all the images, waiting for those being decoded
+    void clear();
+
+    std::size_t size() const { return m_entries.size(); }
+    std::size_t bytes() const { return m_bytes; }
+
+private:
+    struct Entry
+    {
+        fs::path path;
+        std::future<std::unique_ptr<celestia::engine::Image>> pending;
+        std::shared_ptr<Texture> texture;
+        std::size_t bytes{ 0 };
+        bool complete{ false };
+        bool failed{ false };
+    };
+
+    using EntryList = std::list<Entry>;
+
+    Entry& find(const fs::path&);
+    void finishLoading(Entry&);
+    void evict();
+
+    std::size_t m_budget;
+    celestia::util::ThreadPool* m_threadPool;
+
+    // Most recently used first
+    EntryList m_lru;
+    std::map<fs::path, EntryList::iterator> m_entries;
+    std::size_t m_bytes{ 0 };
+};
@@ -0,0 +1,741 @@
+// pagedstarcatalog.cpp
+//
+// Copyright (C) 2024, Celestia Development Team
+//
+// Star catalog with the octree node contents paged in from disk on demand.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include "pagedstarcatalog.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+#include <celastro/astro.h>
+#include <celcompat/bit.h>
+#include <celcompat/numbers.h>
+#include <celutil/binaryread.h>
+#include <celutil/binarywrite.h>
+#include <celutil/logger.h>
+#include <celutil/mappedfile.h>
+#include <celutil/threadpool.h>
+#include "octreebuilder.h"
+#include "stardb.h"
+#include "stellarclass.h"
+
+using namespace std::string_view_literals;
+
+using celestia::util::GetLogger;
+
+namespace celestia::engine
+{
+
+namespace
+{
+
+// File layout, all values little-endian:
+//   header:  magic[8], version (u16), node count (u32), star count (u32),
+//            palette size (u16)
+//   palette: packed spectral types (u16), as in stars.dat
+//   nodes:   center x, y, z, size, bright factor (f32), right, first,
+//            count (u32), origin x, y, z, position step (f32), offset of
+//            the records from the end of the node table (u64), size of the
+//            records (u32)
+//   records: the stars of each node in octree order, as three arrays:
+//            - the positions, with a nonzero step as the offsets from the
+//              origin in steps, 21 bits for each axis from the lowest bits
+//              of a u64, otherwise as x, y, z (f32)
+//            - the magnitudes and spectral types, 3 bytes each, with the
+//              magnitude in fixed point in the lower 12 bits and the
+//              palette index in the upper 12 bits
+//            - the catalog numbers, the first one as a u32 and the others
+//              as LEB128 differences from the previous one; the stars of a
+//              node are sorted by catalog number
+constexpr std::string_view PagedCatalogMagic = "CELPSTAR"sv;
+constexpr std::uint16_t PagedCatalogVersion = 2;
+
+constexpr std::size_t HeaderSize = 8 + 2 + 4 + 4 + 2;
+constexpr std::size_t NodeSize = 5 * 4 + 3 * 4 + 4 * 4 + 8 + 4;
+
+constexpr unsigned int PositionBits = 21;
+constexpr std::uint32_t MaxPositionSteps = (UINT32_C(1) << PositionBits) - 1;
+constexpr std::size_t QuantizedPositionSize = 8;
+constexpr std::size_t FullPositionSize = 3 * 4;
+constexpr std::size_t MagnitudeTypeSize = 3;
+
+// Absolute magnitudes from -16 to 24.95, in steps of 0.01
+constexpr std::uint32_t MaxMagnitudeSteps = 4095;
+constexpr float MagnitudeOrigin = -16.0f;
+constexpr float MagnitudeScale = 100.0f;
+
+constexpr std::size_t MaxPaletteSize = 4096;
+
+// Positions of a node are quantized when the error is below this angle as
+// seen from the origin of the catalog, about 0.2 arcseconds
+constexpr float MaxPositionAngle = 1.0e-6f;
+
+// Larger than the split threshold of the resident star octree, so that each
+// page is worth a read
+constexpr OctreeObjectIndex PagedOctreeSplitThreshold = 4096;
+
+// Same parameters as the resident star octree
+constexpr float PagedOctreeMagnitude = 6.0f;
+const Eigen::Vector3f PagedOctreeRootCenter(1000.0f, 1000.0f, 1000.0f);
+
+// Maximum number of pages being loaded per worker thread
+constexpr unsigned int PendingPagesPerThread = 2;
+
+struct PagedStarRecordTraits
+{
+    using ObjectType = PagedStarRecord;
+    using PrecisionType = float;
+
+    static Eigen::Vector3f getPosition(const ObjectType& obj) { return obj.position; }
+    static float getRadius(const ObjectType&) { return 0.0f; }
+    static float getMagnitude(const ObjectType& obj) { return obj.absMag; }
+
+    static float applyDecay(float factor)
+    {
+        // Decrease in luminosity by factor of 4
+        return factor + 1.50515f;
+    }
+};
+
+using PagedRecordOctree = StaticOctree<PagedStarRecord, float>;
+
+template<typename T>
+void
+appendLE(std::string& out, T value)
+{
+    std::array<char, sizeof(T)> bytes;
+    std::memcpy(bytes.data(), &value, sizeof(T));
+    if constexpr (compat::endian::native != compat::endian::little)
+        std::reverse(bytes.begin(), bytes.end());
+    out.append(bytes.data(), bytes.size());
+}
+
+void
+appendVarint(std::string& out, std::uint32_t value)
+{
+    while (value >= 0x80)
+    {
+        out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+bool
+readVarint(const char*& ptr, const char* end, std::uint32_t& value)
+{
+    value = 0;
+    for (unsigned int shift = 0; shift < 32; shift += 7)
+    {
+        if (ptr == end)
+            return false;
+        auto byte = static_cast<std::uint8_t>(*ptr++);
+        value |= static_cast<std::uint32_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0)
+            return true;
+    }
+
+    return false;
+}
+
+std::uint32_t
+quantizeMagnitude(float absMag)
+{
+    float steps = std::round((absMag - MagnitudeOrigin) * MagnitudeScale);
+    return static_cast<std::uint32_t>(std::clamp(steps, 0.0f, static_cast<float>(MaxMagnitudeSteps)));
+}
+
+float
+decodeMagnitude(std::uint32_t steps)
+{
+    return static_cast<float>(steps) / MagnitudeScale + MagnitudeOrigin;
+}
+
+// The stars of a node, encoded as described for the file layout
+struct NodeEncoding
+{
+    Eigen::Vector3f origin{ Eigen::Vector3f::Zero() };
+    float step{ 0.0f };
+    std::string bytes;
+};
+
+NodeEncoding
+encodeNode(std::vector<PagedStarRecord>& stars, const std::map<std::uint16_t, std::uint32_t>& palette)
+{
+    NodeEncoding encoding;
+    if (stars.empty())
+        return encoding;
+
+    std::sort(stars.begin(), stars.end(),
+              [](const PagedStarRecord& a, const PagedStarRecord& b) { return a.catalogNumber < b.catalogNumber; });
+
+    Eigen::Vector3f lower = stars.front().position;
+    Eigen::Vector3f upper = lower;
+    float nearest = stars.front().position.norm();
+    for (const PagedStarRecord& star : stars)
+    {
+        lower = lower.cwiseMin(star.position);
+        upper = upper.cwiseMax(star.position);
+        nearest = std::min(nearest, star.position.norm());
+    }
+
+    float extent = (upper - lower).maxCoeff();
+    float step = extent > 0.0f
+        ? extent / static_cast<float>(MaxPositionSteps)
+        : std::numeric_limits<float>::min();
+    if (step * 0.5f <= MaxPositionAngle * nearest)
+    {
+        encoding.origin = lower;
+        encoding.step = step;
+    }
+
+    std::string& out = encoding.bytes;
+    for (const PagedStarRecord& star : stars)
+    {
+        if (encoding.step == 0.0f)
+        {
+            appendLE(out, star.position.x());
+            appendLE(out, star.position.y());
+            appendLE(out, star.position.z());
+            continue;
+        }
+
+        std::uint64_t packed = 0;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            float steps = std::round((star.position[axis] - encoding.origin[axis]) / encoding.step);
+            auto q = static_cast<std::uint64_t>(std::clamp(steps, 0.0f, static_cast<float>(MaxPositionSteps)));
+            packed |= q << (axis * PositionBits);
+        }
+        appendLE(out, packed);
+    }
+
+    for (const PagedStarRecord& star : stars)
+    {
+        std::uint32_t packed = quantizeMagnitude(star.absMag) | (palette.at(star.spectralType) << 12);
+        out.push_back(static_cast<char>(packed & 0xff));
+        out.push_back(static_cast<char>((packed >> 8) & 0xff));
+        out.push_back(static_cast<char>(packed >> 16));
+    }
+
+    appendLE(out, stars.front().catalogNumber);
+    for (std::size_t i = 1; i < stars.size(); ++i)
+        appendVarint(out, stars[i].catalogNumber - stars[i - 1].catalogNumber);
+
+    return encoding;
+}
+
+// Collects the node table of an octree: every node passes, and nodes are
+// reached in depth-first order.
+class NodeTableBuilder
+{
+public:
+    bool checkNode(const Eigen::Vector3f& center, float size, float factor)
+    {
+        nodes.push_back({ center, size, factor, 0, 0, 0 });
+        return true;
+    }
+
+    void process(const PagedStarRecord&) const { /* handled by processObjects */ }
+
+    void processObjects(const Eigen::Vector3f&,
+                        float,
+                        const PagedStarRecord*,
+                        OctreeObjectIndex first,
+                        OctreeObjectIndex last)
+    {
+        nodes.back().first = first;
+        nodes.back().count = last - first;
+    }
+
+    struct NodeEntry
+    {
+        Eigen::Vector3f center;
+        float size;
+        float brightFactor;
+        std::uint32_t right;
+        std::uint32_t first;
+        std::uint32_t count;
+    };
+
+    std::vector<NodeEntry> nodes;
+};
+
+} // end unnamed namespace
+
+PagedStarCatalog::PagedStarCatalog(std::unique_ptr<util::MappedFile>&& file,
+                                   std::size_t memoryBudget,
+                                   util::ThreadPool* threadPool) :
+    m_file(std::move(file)),
+    m_memoryBudget(memoryBudget),
+    m_threadPool(threadPool)
+{
+}
+
+PagedStarCatalog::~PagedStarCatalog()
+{
+    // The loading tasks read from the mapping and report back to this
+    std::unique_lock lock(m_mutex);
+    m_condition.wait(lock, [this] { return m_pending == 0; });
+}
+
+std::unique_ptr<PagedStarCatalog>
+PagedStarCatalog::open(const fs::path& path, std::size_t memoryBudget, util::ThreadPool* threadPool)
+{
+    auto file = util::MappedFile::open(path);
+    if (file == nullptr)
+    {
+        GetLogger()->error("Could not map paged star catalog {}\n", path);
+        return nullptr;
+    }
+
+    auto catalog = std::make_unique<PagedStarCatalog>(std::move(file), memoryBudget, threadPool);
+    if (!catalog->readNodes())
+    {
+        GetLogger()->error("Invalid paged star catalog {}\n", path);
+        return nullptr;
+    }
+
+    GetLogger()->info("Paged star catalog {}: {} stars in {} nodes\n",
+                      path, catalog->m_starCount, catalog->m_nodes.size());
+    return catalog;
+}
+
+bool
+PagedStarCatalog::readNodes()
+{
+    const char* data = m_file->data();
+    const std::size_t fileSize = m_file->size();
+    if (fileSize < HeaderSize || std::string_view(data, PagedCatalogMagic.size()) != PagedCatalogMagic)
+        return false;
+
+    if (auto version = util::fromMemoryLE<std::uint16_t>(data + 8); version != PagedCatalogVersion)
+    {
+        GetLogger()->error("Unsupported paged star catalog version {}, rebuild it with makepagedstars\n", version);
+        return false;
+    }
+
+    auto nodeCount = util::fromMemoryLE<std::uint32_t>(data + 10);
+    m_starCount = util::fromMemoryLE<std::uint32_t>(data + 14);
+    auto paletteSize = util::fromMemoryLE<std::uint16_t>(data + 18);
+    const std::size_t paletteBytes = static_cast<std::size_t>(paletteSize) * 2;
+    if (fileSize - HeaderSize < paletteBytes ||
+        (fileSize - HeaderSize - paletteBytes) / NodeSize < nodeCount)
+    {
+        return false;
+    }
+
+    // StarDetailsManager is not thread-safe, so the details of the palette
+    // are all looked up here
+    const char* ptr = data + HeaderSize;
+    m_palette.reserve(paletteSize);
+    for (std::uint16_t i = 0; i < paletteSize; ++i, ptr += 2)
+    {
+        auto& details = m_palette.emplace_back();
+        if (StellarClass sc; sc.unpackV1(util::fromMemoryLE<std::uint16_t>(ptr)))
+            details = StarDetails::GetStarDetails(sc);
+    }
+
+    m_records = ptr + static_cast<std::size_t>(nodeCount) * NodeSize;
+    m_recordBytes = static_cast<std::size_t>(data + fileSize - m_records);
+
+    m_nodes.reserve(nodeCount);
+    m_pages.resize(nodeCount);
+
+    // Ancestors of the current node, to find its depth
+    std::vector<OctreeNodeIndex> ancestorRights;
+    for (OctreeNodeIndex i = 0; i < nodeCount; ++i, ptr += NodeSize)
+    {
+        Node& node = m_nodes.emplace_back();
+        node.center = Eigen::Vector3f(util::fromMemoryLE<float>(ptr),
+                                      util::fromMemoryLE<float>(ptr + 4),
+                                      util::fromMemoryLE<float>(ptr + 8));
+        node.size = util::fromMemoryLE<float>(ptr + 12);
+        node.brightFactor = util::fromMemoryLE<float>(ptr + 16);
+        node.right = util::fromMemoryLE<std::uint32_t>(ptr + 20);
+        node.first = util::fromMemoryLE<std::uint32_t>(ptr + 24);
+        node.count = util::fromMemoryLE<std::uint32_t>(ptr + 28);
+        node.origin = Eigen::Vector3f(util::fromMemoryLE<float>(ptr + 32),
+                                      util::fromMemoryLE<float>(ptr + 36),
+                                      util::fromMemoryLE<float>(ptr + 40));
+        node.step = util::fromMemoryLE<float>(ptr + 44);
+        node.offset = util::fromMemoryLE<std::uint64_t>(ptr + 48);
+        node.bytes = util::fromMemoryLE<std::uint32_t>(ptr + 56);
+
+        if (node.right <= i || node.right > nodeCount ||
+            node.first > m_starCount || node.count > m_starCount - node.first ||
+            node.offset > m_recordBytes || node.bytes > m_recordBytes - node.offset)
+        {
+            return false;
+        }
+
+        while (!ancestorRights.empty() && ancestorRights.back() <= i)
+            ancestorRights.pop_back();
+
+        if (ancestorRights.size() < ResidentDepth)
+        {
+            m_pages[i].resident = true;
+            decodePage(i, m_records + node.offset);
+        }
+
+        ancestorRights.push_back(node.right);
+    }
+
+    return true;
+}
+
+std::size_t
+PagedStarCatalog::pageBytes(const Page& page)
+{
+    return page.encoded.capacity() + page.stars.capacity() * sizeof(Star);
+}
+
+// Each array is decoded in its own loop, so that the loops over the
+// positions and magnitudes have no dependencies between the stars
+void
+PagedStarCatalog::decodePage(OctreeNodeIndex nodeIdx, const char* records)
+{
+    const Node& node = m_nodes[nodeIdx];
+    Page& page = m_pages[nodeIdx];
+    const OctreeObjectIndex count = node.count;
+
+    page.stars.clear();
+    page.status = PageStatus::Loaded;
+
+    const std::size_t positionSize = node.step == 0.0f ? FullPositionSize : QuantizedPositionSize;
+    const std::size_t fixedBytes = count * (positionSize + MagnitudeTypeSize) + 4;
+    if (count == 0 || node.bytes < fixedBytes)
+        return;
+
+    m_positions.resize(count);
+    if (node.step == 0.0f)
+    {
+        for (OctreeObjectIndex i = 0; i < count; ++i)
+        {
+            const char* ptr = records + i * FullPositionSize;
+            m_positions[i] = Eigen::Vector3f(util::fromMemoryLE<float>(ptr),
+                                             util::fromMemoryLE<float>(ptr + 4),
+                                             util::fromMemoryLE<float>(ptr + 8));
+        }
+    }
+    else
+    {
+        constexpr std::uint64_t mask = MaxPositionSteps;
+        for (OctreeObjectIndex i = 0; i < count; ++i)
+        {
+            auto packed = util::fromMemoryLE<std::uint64_t>(records + i * QuantizedPositionSize);
+            Eigen::Vector3f steps(static_cast<float>(packed & mask),
+                                  static_cast<float>((packed >> PositionBits) & mask),
+                                  static_cast<float>((packed >> (2 * PositionBits)) & mask));
+            m_positions[i] = node.origin + steps * node.step;
+        }
+    }
+
+    // The differences are summed in order, so the catalog numbers are
+    // decoded up to the first malformed one
+    const char* ptr = records + count * (positionSize + MagnitudeTypeSize);
+    const char* end = records + node.bytes;
+    m_catalogNumbers.resize(count);
+    m_catalogNumbers[0] = util::fromMemoryLE<std::uint32_t>(ptr);
+    ptr += 4;
+    OctreeObjectIndex decoded = 1;
+    for (std::uint32_t delta; decoded < count && readVarint(ptr, end, delta); ++decoded)
+        m_catalogNumbers[decoded] = m_catalogNumbers[decoded - 1] + delta;
+
+    const auto* magnitudeTypes = reinterpret_cast<const std::uint8_t*>(records + count * positionSize);
+    page.stars.reserve(decoded);
+    for (OctreeObjectIndex i = 0; i < decoded; ++i, magnitudeTypes += MagnitudeTypeSize)
+    {
+        std::uint32_t packed = static_cast<std::uint32_t>(magnitudeTypes[0]) |
+                               (static_cast<std::uint32_t>(magnitudeTypes[1]) << 8) |
+                               (static_cast<std::uint32_t>(magnitudeTypes[2]) << 16);
+        std::uint32_t paletteIndex = packed >> 12;
+        if (paletteIndex >= m_palette.size() || m_palette[paletteIndex] == nullptr)
+            continue;
+
+        Star& star = page.stars.emplace_back(m_catalogNumbers[i], m_palette[paletteIndex]);
+        star.setPosition(m_positions[i]);
+        star.setAbsoluteMagnitude(decodeMagnitude(packed & MaxMagnitudeSteps));
+    }
+}
+
+void
+PagedStarCatalog::requestPage(OctreeNodeIndex nodeIdx)
+{
+    const unsigned int maxPending = (m_threadPool == nullptr ? 1 : m_threadPool->threadCount() + 1)
+                                  * PendingPagesPerThread;
+    {
+        std::scoped_lock lock(m_mutex);
+        if (m_pending >= maxPending)
+            return;
+        ++m_pending;
+    }
+
+    m_pages[nodeIdx].status = PageStatus::Loading;
+
+    // Copying the records out of the mapping on a worker thread moves the
+    // disk reads off the traversal thread
+    auto task = [this, nodeIdx]
+    {
+        const Node& node = m_nodes[nodeIdx];
+        const char* records = m_records + node.offset;
+        std::vector<char> buffer(records, records + node.bytes);
+
+        std::scoped_lock lock(m_mutex);
+        m_loaded.emplace_back(nodeIdx, std::move(buffer));
+        --m_pending;
+        m_condition.notify_all();
+    };
+
+    if (m_threadPool == nullptr)
+        task();
+    else
+        m_threadPool->submit(std::move(task));
+}
+
+void
+PagedStarCatalog::integrateLoadedPages()
+{
+    std::vector<std::pair<OctreeNodeIndex, std::vector<char>>> loaded;
+    {
+        std::scoped_lock lock(m_mutex);
+        loaded.swap(m_loaded);
+    }
+
+    // The pages are kept encoded until a traversal reaches them
+    for (auto& [nodeIdx, buffer] : loaded)
+    {
+        Page& page = m_pages[nodeIdx];
+        page.encoded = std::move(buffer);
+        page.status = PageStatus::Loaded;
+        m_pagedBytes += pageBytes(page);
+        m_lru.push_front(nodeIdx);
+        page.lruPosition = m_lru.begin();
+    }
+
+    releaseDecodedPages();
+
+    // Stars handed out during the previous traversal may be released now
+    bool evictedDecoded = false;
+    while (m_pagedBytes > m_memoryBudget && !m_lru.empty())
+    {
+        Page& page = m_pages[m_lru.back()];
+        m_pagedBytes -= pageBytes(page);
+        evictedDecoded = evictedDecoded || !page.stars.empty();
+        page.encoded = std::vector<char>();
+        page.stars = std::vector<Star>();
+        page.status = PageStatus::Absent;
+        m_lru.pop_back();
+    }
+
+    if (evictedDecoded)
+    {
+        m_decodedPages.erase(std::remove_if(m_decodedPages.begin(), m_decodedPages.end(),
+                                            [this](OctreeNodeIndex idx) { return m_pages[idx].stars.empty(); }),
+                             m_decodedPages.end());
+    }
+}
+
+// Release the stars of the pages which the last traversal didn't reach
+void
+PagedStarCatalog::releaseDecodedPages()
+{
+    auto it = std::remove_if(m_decodedPages.begin(), m_decodedPages.end(),
+                             [this](OctreeNodeIndex idx)
+                             {
+                                 Page& page = m_pages[idx];
+                                 if (page.traversal == m_traversal)
+                                     return false;
+
+                                 m_pagedBytes -= page.stars.capacity() * sizeof(Star);
+                                 page.stars = std::vector<Star>();
+                                 return true;
+                             });
+    m_decodedPages.erase(it, m_decodedPages.end());
+}
+
+template<typename PROCESSOR>
+void
+PagedStarCatalog::processDepthFirst(PROCESSOR& processor)
+{
+    integrateLoadedPages();
+    ++m_traversal;
+
+    OctreeNodeIndex nodeIdx = 0;
+    const auto endIdx = static_cast<OctreeNodeIndex>(m_nodes.size());
+    while (nodeIdx < endIdx)
+    {
+        const Node& node = m_nodes[nodeIdx];
+        if (!processor.checkNode(node.center, node.size, node.brightFactor))
+        {
+            nodeIdx = node.right;
+            continue;
+        }
+
+        Page& page = m_pages[nodeIdx];
+        switch (page.status)
+        {
+        case PageStatus::Loaded:
+            if (!page.resident)
+            {
+                m_lru.splice(m_lru.begin(), m_lru, page.lruPosition);
+                if (page.stars.empty() && !page.encoded.empty())
+                {
+                    decodePage(nodeIdx, page.encoded.data());
+                    m_pagedBytes += page.stars.capacity() * sizeof(Star);
+                    if (!page.stars.empty())
+                        m_decodedPages.push_back(nodeIdx);
+                }
+                page.traversal = m_traversal;
+            }
+            for (const Star& star : page.stars)
+                processor.process(star);
+            break;
+
+        case PageStatus::Absent:
+            if (node.count > 0)
+                requestPage(nodeIdx);
+            break;
+
+        case PageStatus::Loading:
+            break;
+        }
+
+        ++nodeIdx;
+    }
+}
+
+void
+PagedStarCatalog::findVisibleStars(StarHandler& starHandler,
+                                   const Eigen::Vector3f& obsPosition,
+                                   util::array_view<PlaneType> frustumPlanes,
+                                   float limitingMag)
+{
+    StarOctreeVisibleObjectsProcessor processor(&starHandler, obsPosition, frustumPlanes, limitingMag);
+    processDepthFirst(processor);
+}
+
+bool
+PagedStarCatalog::write(const fs::path& path, std::vector<PagedStarRecord>&& records)
+{
+    // Quantize the magnitudes first, the node bright factors must be
+    // consistent with the magnitudes which will be read back
+    std::map<std::uint16_t, std::uint32_t> palette;
+    for (PagedStarRecord& record : records)
+    {
+        record.absMag = decodeMagnitude(quantizeMagnitude(record.absMag));
+        palette.try_emplace(record.spectralType, 0);
+    }
+
+    if (palette.size() > MaxPaletteSize)
+    {
+        GetLogger()->error("Too many spectral types for a paged star catalog: {}, the maximum is {}\n",
+                           palette.size(), MaxPaletteSize);
+        return false;
+    }
+
+    std::uint32_t paletteIndex = 0;
+    for (auto& entry : palette)
+        entry.second = paletteIndex++;
+
+    const auto inputCount = records.size();
+    float absMag = astro::appToAbsMag(PagedOctreeMagnitude,
+                                      StarDatabase::STAR_OCTREE_ROOT_SIZE * celestia::numbers::sqrt3_v<float>);
+    std::unique_ptr<PagedRecordOctree> octree = makeDynamicOctree<PagedStarRecordTraits>(std::move(records),
+                                                                                        PagedOctreeRootCenter,
+                                                                                        StarDatabase::STAR_OCTREE_ROOT_SIZE,
+                                                                                        absMag,
+                                                                                        PagedOctreeSplitThreshold,
+                                                                                        *util::GetThreadPool())->build();
+
+    NodeTableBuilder tableBuilder;
+    OctreeNodeSubset allNodes;
+    octree->selectDepthFirst(tableBuilder, allNodes);
+    tableBuilder.nodes.clear();
+    octree->processDepthFirst(tableBuilder);
+    for (std::size_t i = 0; i < tableBuilder.nodes.size(); ++i)
+        tableBuilder.nodes[i].right = allNodes.right[i];
+
+    // The octree keeps the stars outside the root after those of the nodes,
+    // and they aren't written
+    OctreeObjectIndex starCount = 0;
+    for (const auto& node : tableBuilder.nodes)
+        starCount += node.count;
+    if (starCount != inputCount)
+        GetLogger()->warn("{} stars outside the octree were dropped\n", inputCount - starCount);
+
+    std::vector<NodeEncoding> encodings;
+    encodings.reserve(tableBuilder.nodes.size());
+    std::vector<PagedStarRecord> nodeStars;
+    for (const auto& node : tableBuilder.nodes)
+    {
+        nodeStars.clear();
+        for (OctreeObjectIndex i = node.first; i < node.first + node.count; ++i)
+            nodeStars.push_back((*octree)[i]);
+        encodings.push_back(encodeNode(nodeStars, palette));
+    }
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out.good())
+        return false;
+
+    out.write(PagedCatalogMagic.data(), PagedCatalogMagic.size());
+    bool ok = util::writeLE(out, PagedCatalogVersion) &&
+              util::writeLE(out, static_cast<std::uint32_t>(tableBuilder.nodes.size())) &&
+              util::writeLE(out, starCount) &&
+              util::writeLE(out, static_cast<std::uint16_t>(palette.size()));
+
+    for (auto it = palette.begin(); ok && it != palette.end(); ++it)
+        ok = util::writeLE(out, it->first);
+
+    std::uint64_t offset = 0;
+    for (std::size_t i = 0; ok && i < tableBuilder.nodes.size(); ++i)
+    {
+        const auto& node = tableBuilder.nodes[i];
+        const NodeEncoding& encoding = encodings[i];
+        ok = util::writeLE(out, node.center.x()) &&
+             util::writeLE(out, node.center.y()) &&
+             util::writeLE(out, node.center.z()) &&
+             util::writeLE(out, node.size) &&
+             util::writeLE(out, node.brightFactor) &&
+             util::writeLE(out, node.right) &&
+             util::writeLE(out, node.first) &&
+             util::writeLE(out, node.count) &&
+             util::writeLE(out, encoding.origin.x()) &&
+             util::writeLE(out, encoding.origin.y()) &&
+             util::writeLE(out, encoding.origin.z()) &&
+             util::writeLE(out, encoding.step) &&
+             util::writeLE(out, offset) &&
+             util::writeLE(out, static_cast<std::uint32_t>(encoding.bytes.size()));
+        offset += encoding.bytes.size();
+    }
+
+    for (auto it = encodings.begin(); ok && it != encodings.end(); ++it)
+        ok = out.write(it->bytes.data(), static_cast<std::streamsize>(it->bytes.size())).good();
+
+    if (ok)
+    {
+        GetLogger()->info("{} stars in {} bytes, {:.1f} bytes per star\n",
+                          starCount, offset,
+                          starCount == 0 ? 0.0 : static_cast<double>(offset) / starCount);
+    }
+
+    return ok && out.flush().good();
+}
+
+} // end namespace celestia::engine
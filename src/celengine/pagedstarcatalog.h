@@ -0,0 +1,180 @@
+// pagedstarcatalog.h
+//
+// Copyright (C) 2024, Celestia Development Team
+//
+// Star catalog with the octree node contents paged in from disk on demand.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <array>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+
+#include <boost/smart_ptr/intrusive_ptr.hpp>
+
+#include <celcompat/filesystem.h>
+#include <celengine/astroobj.h>
+#include <celengine/star.h>
+#include <celengine/staroctree.h>
+
+namespace celestia::util
+{
+class MappedFile;
+class ThreadPool;
+}
+
+namespace celestia::engine
+{
+
+// Input star for PagedStarCatalog::write, the spectral type is packed as in
+// stars.dat.
+struct PagedStarRecord
+{
+    AstroCatalog::IndexNumber catalogNumber;
+    Eigen::Vector3f position;
+    float absMag;
+    std::uint16_t spectralType;
+};
+
+// A star catalog too large to be held in memory. The octree node table and
+// the stars of the top levels of the octree are resident, the stars of the
+// deeper nodes are loaded in the background when a traversal first reaches
+// them, and kept in a least recently used cache limited to a memory budget.
+// Nodes which are not loaded yet are skipped, so the faint stars appear over
+// the following frames rather than blocking the traversal.
+//
+// The stars of a node are stored compactly, with positions quantized within
+// the bounds of the node, magnitudes in fixed point, spectral types as
+// indices into a palette and delta-encoded catalog numbers. Loaded pages are
+// cached in that form, and only the pages reached by the last traversal are
+// decoded into Star objects.
+//
+// Stars passed to a handler remain valid until the next traversal starts, as
+// pages are only evicted then. They must not be retained beyond that, so the
+// paged stars can't be selected.
+class PagedStarCatalog
+{
+public:
+    using PlaneType = Eigen::Hyperplane<float, 3>;
+
+    // Nodes at depths below this are always resident
+    static constexpr unsigned int ResidentDepth = 4;
+
+    PagedStarCatalog(std::unique_ptr<util::MappedFile>&&, std::size_t memoryBudget, util::ThreadPool*);
+    ~PagedStarCatalog();
+
+    PagedStarCatalog(const PagedStarCatalog&) = delete;
+    PagedStarCatalog& operator=(const PagedStarCatalog&) = delete;
+    PagedStarCatalog(PagedStarCatalog&&) = delete;
+    PagedStarCatalog& operator=(PagedStarCatalog&&) = delete;
+
+    // Returns nullptr if the file is not a valid paged star catalog
+    static std::unique_ptr<PagedStarCatalog> open(const fs::path&,
+                                                  std::size_t memoryBudget,
+                                                  util::ThreadPool*);
+
+    // Sort the stars into an octree and write them as a paged catalog
+    static bool write(const fs::path&, std::vector<PagedStarRecord>&&);
+
+    void findVisibleStars(StarHandler& starHandler,
+                          const Eigen::Vector3f& obsPosition,
+                          util::array_view<PlaneType> frustumPlanes,
+                          float limitingMag);
+
+    std::uint32_t size() const { return m_starCount; }
+    // Memory held by the pages which aren't resident, both encoded and
+    // decoded
+    std::size_t pagedBytes() const { return m_pagedBytes; }
+
+private:
+    enum class PageStatus : std::uint8_t
+    {
+        Absent,
+        Loading,
+        Loaded,
+    };
+
+    struct Node
+    {
+        Eigen::Vector3f center;
+        float size;
+        float brightFactor;
+        OctreeNodeIndex right;
+        OctreeObjectIndex first;
+        OctreeObjectIndex count;
+        // Positions are origin + step * quantized offset, or stored in full
+        // when the step is 0
+        Eigen::Vector3f origin;
+        float step;
+        // Location of the encoded stars, from the start of the records
+        std::uint64_t offset;
+        std::uint32_t bytes;
+    };
+
+    struct Page
+    {
+        std::vector<char> encoded;
+        std::vector<Star> stars;
+        PageStatus status{ PageStatus::Absent };
+        bool resident{ false };
+        // The traversal which last reached the page
+        std::uint32_t traversal{ 0 };
+        std::list<OctreeNodeIndex>::iterator lruPosition;
+    };
+
+    template<typename PROCESSOR>
+    void processDepthFirst(PROCESSOR&);
+
+    bool readNodes();
+    void requestPage(OctreeNodeIndex);
+    void integrateLoadedPages();
+    void releaseDecodedPages();
+    void decodePage(OctreeNodeIndex, const char*);
+    static std::size_t pageBytes(const Page&);
+
+    std::unique_ptr<util::MappedFile> m_file;
+    std::size_t m_memoryBudget;
+    util::ThreadPool* m_threadPool;
+
+    std::vector<Node> m_nodes;
+    std::vector<Page> m_pages;
+    std::list<OctreeNodeIndex> m_lru;
+    std::size_t m_pagedBytes{ 0 };
+    const char* m_records{ nullptr };
+    std::size_t m_recordBytes{ 0 };
+    std::uint32_t m_starCount{ 0 };
+
+    // Details of the spectral types of the palette, null for the types which
+    // couldn't be unpacked
+    std::vector<boost::intrusive_ptr<StarDetails>> m_palette;
+
+    // Pages which aren't resident and have decoded stars
+    std::vector<OctreeNodeIndex> m_decodedPages;
+    std::uint32_t m_traversal{ 0 };
+
+    // Scratch arrays of decodePage
+    std::vector<Eigen::Vector3f> m_positions;
+    std::vector<std::uint32_t> m_catalogNumbers;
+
+    // Shared with the loading tasks
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::vector<std::pair<OctreeNodeIndex, std::vector<char>>> m_loaded;
+    unsigned int m_pending{ 0 };
+};
+
+} // end namespace celestia::engine
@@ -23,6 +23,7 @@
 #include <celastro/astro.h>
 #include <celastro/date.h>
 #include <celcompat/numbers.h>
+#include <celephem/chebyshevorbit.h>
 #include <celephem/customorbit.h>
 #include <celephem/customrotation.h>
 #include <celephem/orbit.h>
@@ -1486,7 +1487,7 @@ CreateOrbit(const Selection& centralObject,
         {
             auto orbit = CreateSpiceOrbit(spiceOrbitData, path, usePlanetUnits);
             if (orbit != nullptr)
-                return orbit;
+                return ephem::CreateCachedOrbit(orbit);
 
             GetLogger()->error("Bad spice orbit\n");
             GetLogger()->error("Could not load SPICE orbit\n");
@@ -0,0 +1,118 @@
+// pathcache.cpp
+//
+// Copyright (C) 2024, Celestia Development Team
+//
+// Cache of object paths resolved by the universe.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include "pathcache.h"
+
+#include <algorithm>
+#include <functional>
+
+namespace util = celestia::util;
+
+PathCache::PathCache(std::size_t capacity) :
+    m_capacity(std::max(capacity, std::size_t(1)))
+{
+}
+
+bool
+PathCache::Key::operator==(const Key& other) const
+{
+    return i18n == other.i18n &&
+           nContexts == other.nContexts &&
+           std::equal(contexts.begin(), contexts.begin() + nContexts, other.contexts.begin()) &&
+           path == other.path;
+}
+
+std::size_t
+PathCache::KeyHash::operator()(const Key& key) const
+{
+    std::size_t h = std::hash<std::string>()(key.path);
+    for (std::uint8_t i = 0; i < key.nContexts; ++i)
+        h = h * 31 + std::hash<Selection>()(key.contexts[i]);
+    return h * 2 + (key.i18n ? 1 : 0);
+}
+
+bool
+PathCache::makeKey(Key& key,
+                   std::string_view path,
+                   util::array_view<const Selection> contexts,
+                   bool i18n)
+{
+    if (contexts.size() > MaxContexts)
+        return false;
+
+    key.path.assign(path);
+    key.nContexts = static_cast<std::uint8_t>(contexts.size());
+    std::copy(contexts.begin(), contexts.end(), key.contexts.begin());
+    std::fill(key.contexts.begin() + key.nContexts, key.contexts.end(), Selection());
+    key.i18n = i18n;
+    return true;
+}
+
+std::optional<Selection>
+PathCache::find(std::string_view path,
+                util::array_view<const Selection> contexts,
+                bool i18n,
+                std::uint32_t generation)
+{
+    if (generation != m_generation)
+    {
+        clear();
+        m_generation = generation;
+    }
+
+    if (!makeKey(m_lookupKey, path, contexts, i18n))
+        return std::nullopt;
+
+    auto it = m_entries.find(m_lookupKey);
+    if (it == m_entries.end())
+    {
+        ++m_stats.misses;
+        return std::nullopt;
+    }
+
+    ++m_stats.hits;
+    m_lru.splice(m_lru.begin(), m_lru, it->second);
+    return it->second->second;
+}
+
+void
+PathCache::insert(std::string_view path,
+                  util::array_view<const Selection> contexts,
+                  bool i18n,
+                  const Selection& sel)
+{
+    Key key;
+    if (!makeKey(key, path, contexts, i18n))
+        return;
+
+    if (auto it = m_entries.find(key); it != m_entries.end())
+    {
+        it->second->second = sel;
+        m_lru.splice(m_lru.begin(), m_lru, it->second);
+        return;
+    }
+
+    if (m_entries.size() >= m_capacity)
+    {
+        m_entries.erase(m_lru.back().first);
+        m_lru.pop_back();
+    }
+
+    m_lru.emplace_front(key, sel);
+    m_entries.try_emplace(std::move(key), m_lru.begin());
+}
+
+void
+PathCache::clear()
+{
+    m_entries.clear();
+    m_lru.clear();
+}
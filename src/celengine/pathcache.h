@@ -0,0 +1,93 @@
+// pathcache.h
+//
+// Copyright (C) 2024, Celestia Development Team
+//
+// Cache of object paths resolved by the universe.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+
+#include <celutil/array_view.h>
+#include "selection.h"
+
+// Least recently used cache of the objects found for paths such as
+// Sol/Earth/Moon. A path resolves differently depending on the contexts it
+// is looked up in and on whether localized names are accepted, so those are
+// part of the key. The objects are referenced by address, so the cache is
+// emptied when the generation of the catalogs changes.
+class PathCache
+{
+public:
+    // Lookups with more contexts than this bypass the cache
+    static constexpr std::size_t MaxContexts = 3;
+
+    struct Stats
+    {
+        std::uint64_t hits{ 0 };
+        std::uint64_t misses{ 0 };
+    };
+
+    explicit PathCache(std::size_t capacity = 256);
+
+    // Returns the cached object, which may be an empty selection for a path
+    // which wasn't found, or nothing if the path has to be resolved
+    std::optional<Selection> find(std::string_view path,
+                                  celestia::util::array_view<const Selection> contexts,
+                                  bool i18n,
+                                  std::uint32_t generation);
+    void insert(std::string_view path,
+                celestia::util::array_view<const Selection> contexts,
+                bool i18n,
+                const Selection& sel);
+
+    void clear();
+    const Stats& getStats() const { return m_stats; }
+    std::size_t size() const { return m_entries.size(); }
+
+private:
+    struct Key
+    {
+        std::string path;
+        std::array<Selection, MaxContexts> contexts;
+        std::uint8_t nContexts{ 0 };
+        bool i18n{ false };
+
+        bool operator==(const Key&) const;
+    };
+
+    struct KeyHash
+    {
+        std::size_t operator()(const Key&) const;
+    };
+
+    using EntryList = std::list<std::pair<Key, Selection>>;
+
+    static bool makeKey(Key&,
+                        std::string_view path,
+                        celestia::util::array_view<const Selection> contexts,
+                        bool i18n);
+
+    std::size_t m_capacity;
+    std::uint32_t m_generation{ 0 };
+    Stats m_stats;
+
+    // Most recently used first
+    EntryList m_lru;
+    std::unordered_map<Key, EntryList::iterator, KeyHash> m_entries;
+    // Reused to build the keys of lookups
+    Key m_lookupKey;
+};
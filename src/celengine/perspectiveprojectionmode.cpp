@@ -22,7 +22,13 @@ PerspectiveProjectionMode::PerspectiveProjectionMode(float width, float height,
 
 Eigen::Matrix4f PerspectiveProjectionMode::getProjectionMatrix(float nearZ, float farZ, float zoom) const
 {
-    return math::Perspective(math::radToDeg(getFOV(zoom)), width / height, nearZ, farZ);
+    return getTileMatrix() * math::Perspective(math::radToDeg(getFOV(zoom)), getImageAspectRatio(), nearZ, farZ);
+}
+
+bool PerspectiveProjectionMode::getReverseDepthProjectionMatrix(float nearZ, float zoom, Eigen::Matrix4f& result) const
+{
+    result = getTileMatrix() * math::InfiniteReversePerspective(math::radToDeg(getFOV(zoom)), getImageAspectRatio(), nearZ);
+    return true;
 }
 
 float PerspectiveProjectionMode::getMinimumFOV() const
@@ -47,7 +53,7 @@ float PerspectiveProjectionMode::getZoom(float fov) const
 
 float PerspectiveProjectionMode::getPixelSize(float zoom) const
 {
-    return 2.0f * std::tan(getFOV(zoom) * 0.5f) /  height;
+    return 2.0f * std::tan(getFOV(zoom) * 0.5f) / (height * static_cast<float>(tileRows));
 }
 
 float PerspectiveProjectionMode::getFieldCorrection(float zoom) const
@@ -55,16 +61,19 @@ float PerspectiveProjectionMode::getFieldCorrection(float zoom) const
     return 2.0f * standardFOV / (math::radToDeg(getFOV(zoom)) + standardFOV);
 }
 
+// The frustums cover the whole image rather than the tile, so that the same
+// objects and labels are found for all the tiles and labels are placed the
+// same way in each of them
 math::Frustum
 PerspectiveProjectionMode::getFrustum(float nearZ, float farZ, float zoom) const
 {
-    return math::Frustum(getFOV(zoom), width / height, nearZ, farZ);
+    return math::Frustum(getFOV(zoom), getImageAspectRatio(), nearZ, farZ);
 }
 
 math::InfiniteFrustum
 PerspectiveProjectionMode::getInfiniteFrustum(float nearZ, float zoom) const
 {
-    return math::InfiniteFrustum(getFOV(zoom), width / height, nearZ);
+    return math::InfiniteFrustum(getFOV(zoom), getImageAspectRatio(), nearZ);
 }
 
 double PerspectiveProjectionMode::getViewConeAngleMax(float zoom) const
@@ -72,7 +81,7 @@ double PerspectiveProjectionMode::getViewConeAngleMax(float zoom) const
     // When computing the view cone, we want the field of
     // view as measured on the diagonal between viewport corners.
     double h = std::tan(static_cast<double>(getFOV(zoom)) / 2.0);
-    double w = h * static_cast<double>(width) / static_cast<double>(height);
+    double w = h * static_cast<double>(getImageAspectRatio());
     double diag = std::sqrt(1.0 + h * h + w * w);
     return 1.0 / diag;
 }
@@ -108,4 +117,36 @@ bool PerspectiveProjectionMode::project(const Eigen::Vector3f& pos,
     return math::ProjectPerspective(pos, existingMVPMatrix, viewport, result);
 }
 
+bool PerspectiveProjectionMode::setTile(int columns, int rows, int column, int row)
+{
+    if (columns < 1 || rows < 1 || column < 0 || column >= columns || row < 0 || row >= rows)
+        return false;
+
+    tileColumns = columns;
+    tileRows = rows;
+    tileColumn = column;
+    tileRow = row;
+    return true;
+}
+
+float PerspectiveProjectionMode::getImageAspectRatio() const
+{
+    return width * static_cast<float>(tileColumns) / (height * static_cast<float>(tileRows));
+}
+
+// Map the tile in the normalized device coordinates of the image to the
+// whole viewport
+Eigen::Matrix4f PerspectiveProjectionMode::getTileMatrix() const
+{
+    auto columns = static_cast<float>(tileColumns);
+    auto rows = static_cast<float>(tileRows);
+
+    Eigen::Matrix4f m = Eigen::Matrix4f::Identity();
+    m(0, 0) = columns;
+    m(0, 3) = columns - 1.0f - 2.0f * static_cast<float>(tileColumn);
+    m(1, 1) = rows;
+    m(1, 3) = rows - 1.0f - 2.0f * static_cast<float>(tileRow);
+    return m;
+}
+
 }
@@ -28,6 +28,7 @@ public:
     ~PerspectiveProjectionMode() override = default;
 
     Eigen::Matrix4f getProjectionMatrix(float nearZ, float farZ, float zoom) const override;
+    bool getReverseDepthProjectionMatrix(float nearZ, float zoom, Eigen::Matrix4f& result) const override;
     float getMinimumFOV() const override;
     float getMaximumFOV() const override;
     float getFOV(float zoom) const override;
@@ -49,6 +50,17 @@ public:
                  const Eigen::Matrix4f& existingMVPMatrix,
                  const std::array<int, 4>& viewport,
                  Eigen::Vector3f& result) const override;
+
+    bool setTile(int columns, int rows, int column, int row) override;
+
+private:
+    float getImageAspectRatio() const;
+    Eigen::Matrix4f getTileMatrix() const;
+
+    int tileColumns{ 1 };
+    int tileRows{ 1 };
+    int tileColumn{ 0 };
+    int tileRow{ 0 };
 };
 
 } // end namespace celestia::engine
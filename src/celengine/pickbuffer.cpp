@@ -0,0 +1,157 @@
+// pickbuffer.cpp
+//
+// Copyright (C) 2024, Celestia Development Team
+//
+// Screen space record of the objects drawn in a frame, used for picking.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include "pickbuffer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace celestia::engine
+{
+
+PickBuffer::PickBuffer(float cellSize) :
+    m_cellSize(cellSize)
+{
+}
+
+void
+PickBuffer::reset(int width, int height)
+{
+    m_entries.clear();
+    m_width = width;
+    m_height = height;
+
+    int columns = std::max(1, static_cast<int>(std::ceil(static_cast<float>(width) / m_cellSize)));
+    int rows = std::max(1, static_cast<int>(std::ceil(static_cast<float>(height) / m_cellSize)));
+    if (columns != m_columns || rows != m_rows)
+    {
+        m_columns = columns;
+        m_rows = rows;
+        m_cells.assign(static_cast<std::size_t>(columns * rows), {});
+    }
+    else
+    {
+        // Keep the capacity of the cells from the previous frame
+        for (auto& cell : m_cells)
+            cell.clear();
+    }
+}
+
+PickBuffer::CellRange
+PickBuffer::cellRange(const Eigen::Vector2f& center, float radius) const
+{
+    auto toCell = [this](float v, int count)
+    {
+        // Clamp before the conversion, discs of nearby bodies may extend
+        // far beyond the window
+        float cell = std::clamp(std::floor(v / m_cellSize), 0.0f, static_cast<float>(count - 1));
+        return static_cast<int>(cell);
+    };
+
+    return CellRange
+    {
+        toCell(center.x() - radius, m_columns),
+        toCell(center.y() - radius, m_rows),
+        toCell(center.x() + radius, m_columns),
+        toCell(center.y() + radius, m_rows),
+    };
+}
+
+void
+PickBuffer::add(Layer layer,
+                const Selection& sel,
+                const Eigen::Vector2f& center,
+                float radius,
+                float depth,
+                bool exact)
+{
+    if (m_cells.empty() || sel.empty())
+        return;
+
+    auto index = static_cast<std::uint32_t>(m_entries.size());
+    m_entries.push_back({ sel, center, radius, depth, layer, exact });
+
+    CellRange range = cellRange(center, radius);
+    for (int y = range.y0; y <= range.y1; ++y)
+    {
+        for (int x = range.x0; x <= range.x1; ++x)
+            m_cells[static_cast<std::size_t>(y * m_columns + x)].push_back(index);
+    }
+}
+
+PickHits
+PickBuffer::pick(const Eigen::Vector2f& point, float tolerance) const
+{
+    PickHits hits;
+    if (m_cells.empty() || m_entries.empty())
+        return hits;
+
+    // A body within the tolerance has its center within the tolerance, so
+    // it is binned in one of the cells around the point. The same entry may
+    // be found in several cells, which doesn't change the result.
+    const Entry* nearestDisc = nullptr;
+    const Entry* closestCenter = nullptr;
+    float closestCenterDistance = tolerance;
+    const Entry* closestDeepSky = nullptr;
+    float closestDeepSkyDistance = std::numeric_limits<float>::max();
+    bool deepSkyResolved = true;
+
+    CellRange range = cellRange(point, tolerance);
+    for (int y = range.y0; y <= range.y1; ++y)
+    {
+        for (int x = range.x0; x <= range.x1; ++x)
+        {
+            for (std::uint32_t index : m_cells[static_cast<std::size_t>(y * m_columns + x)])
+            {
+                const Entry& entry = m_entries[index];
+                float distance = (entry.center - point).norm();
+                bool inside = distance <= entry.radius;
+
+                if (entry.layer == Layer::DeepSky)
+                {
+                    if (!inside)
+                        continue;
+                    deepSkyResolved = deepSkyResolved && entry.exact;
+                    if (distance < closestDeepSkyDistance)
+                    {
+                        closestDeepSky = &entry;
+                        closestDeepSkyDistance = distance;
+                    }
+                    continue;
+                }
+
+                if (inside && (nearestDisc == nullptr || entry.depth < nearestDisc->depth))
+                    nearestDisc = &entry;
+                if (distance <= closestCenterDistance)
+                {
+                    closestCenter = &entry;
+                    closestCenterDistance = distance;
+                }
+            }
+        }
+    }
+
+    if (nearestDisc != nullptr && nearestDisc->exact)
+    {
+        if (closestCenter != nullptr && closestCenter->depth < nearestDisc->depth)
+            hits.body = closestCenter->sel;
+        else
+            hits.body = nearestDisc->sel;
+    }
+
+    if (closestDeepSky != nullptr && deepSkyResolved)
+        hits.deepSky = closestDeepSky->sel;
+
+    return hits;
+}
+
+} // end namespace celestia::engine
@@ -0,0 +1,107 @@
+// pickbuffer.h
+//
+// Copyright (C) 2024, Celestia Development Team
+//
+// Screen space record of the objects drawn in a frame, used for picking.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <Eigen/Core>
+
+#include <celengine/selection.h>
+
+namespace celestia::engine
+{
+
+// The objects found under the cursor in the last rendered frame. An empty
+// selection means that the layer can't be resolved from the frame, and
+// the pick has to fall back to intersecting the pick ray with the objects.
+struct PickHits
+{
+    Selection body;
+    Selection deepSky;
+};
+
+// The discs of the objects drawn in a frame, in window coordinates, binned
+// in a uniform grid of cells so that a pick only looks at the discs in the
+// cells around the cursor. Solar system bodies and stars drawn as discs go
+// in the body layer, deep sky objects in the deep sky layer. Objects drawn
+// as points are left to the geometric pick.
+class PickBuffer
+{
+public:
+    enum class Layer : std::uint8_t
+    {
+        Body,
+        DeepSky,
+    };
+
+    static constexpr float DefaultCellSize = 32.0f;
+
+    explicit PickBuffer(float cellSize = DefaultCellSize);
+
+    // Remove all the objects and set the size of the window. Objects outside
+    // the window are binned in the border cells.
+    void reset(int width, int height);
+
+    // Record an object drawn as a disc around center with the depth of its
+    // nearest point. Exact discs are the silhouette of the object; other
+    // ones only bound it and can't resolve a pick on their own.
+    void add(Layer layer,
+             const Selection& sel,
+             const Eigen::Vector2f& center,
+             float radius,
+             float depth,
+             bool exact);
+
+    // Find the objects under the point. In the body layer, the nearest disc
+    // under the point is picked unless a body in front of it has its center
+    // closer to the point, within the tolerance, as the geometric pick does
+    // for small satellites. In the deep sky layer, the disc with the center
+    // closest to the point is picked.
+    PickHits pick(const Eigen::Vector2f& point, float tolerance) const;
+
+    int width() const { return m_width; }
+    int height() const { return m_height; }
+    std::size_t size() const { return m_entries.size(); }
+
+private:
+    struct Entry
+    {
+        Selection sel;
+        Eigen::Vector2f center;
+        float radius;
+        float depth;
+        Layer layer;
+        bool exact;
+    };
+
+    struct CellRange
+    {
+        int x0;
+        int y0;
+        int x1;
+        int y1;
+    };
+
+    CellRange cellRange(const Eigen::Vector2f& center, float radius) const;
+
+    float m_cellSize;
+    int m_width{ 0 };
+    int m_height{ 0 };
+    int m_columns{ 0 };
+    int m_rows{ 0 };
+    std::vector<Entry> m_entries;
+    std::vector<std::vector<std::uint32_t>> m_cells;
+};
+
+} // end namespace celestia::engine
@@ -42,6 +42,8 @@ void PointStarRenderer::process(const Star& star, float distance, float appMag)
     if (distance > distanceLimit)
         return;
 
+    ++starsProcessed;
+
     Vector3f starPos = star.getPosition();
 
     // Calculate the difference at double precision *before* converting to float.
@@ -123,7 +125,11 @@ void PointStarRenderer::process(const Star& star, float distance, float appMag)
                     renderer->addBackgroundAnnotation(nullptr,
                                                       starDB->getStarName(star, true),
                                                       color,
-                                                      relPos);
+                                                      relPos,
+                                                      Renderer::LabelHorizontalAlignment::Start,
+                                                      Renderer::LabelVerticalAlignment::Bottom,
+                                                      0.0f,
+                                                      appMag);
                 }
             }
         }
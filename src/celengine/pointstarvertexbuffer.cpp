@@ -8,6 +8,7 @@
 // as published by the Free Software Foundation; either version 2
 // of the License, or (at your option) any later version.
 
+#include <algorithm>
 #include <celrender/gl/buffer.h>
 #include <celrender/gl/vertexobject.h>
 #include <celutil/color.h>
@@ -23,14 +24,37 @@ namespace util = celestia::util;
 
 PointStarVertexBuffer* PointStarVertexBuffer::current = nullptr;
 
+namespace
+{
+
+#ifndef GL_ES
+void
+waitForFence(GLsync fence)
+{
+    constexpr GLuint64 timeout = 1000000000; // 1 second
+    for (;;)
+    {
+        GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+        if (result != GL_TIMEOUT_EXPIRED)
+            break;
+    }
+}
+#endif
+
+} // end unnamed namespace
+
 PointStarVertexBuffer::PointStarVertexBuffer(const Renderer &renderer,
                                              capacity_t capacity) :
     m_renderer(renderer),
-    m_capacity(capacity),
-    m_vertices(std::make_unique<StarVertex[]>(capacity))
+    m_capacity(std::min(capacity, MaxCapacity))
 {
 }
 
+PointStarVertexBuffer::~PointStarVertexBuffer()
+{
+    releaseBuffers();
+}
+
 void PointStarVertexBuffer::startSprites()
 {
     m_prog = m_renderer.getShaderManager().getShader("star");
@@ -48,23 +72,167 @@ void PointStarVertexBuffer::startBasicPoints()
 
 void PointStarVertexBuffer::render()
 {
-    if (m_nStars != 0)
-    {
-        makeCurrent();
+    if (m_nStars == 0)
+        return;
 
-        if (m_texture != nullptr)
-            m_texture->bind();
+    makeCurrent();
+    setupVertexArrayObject();
+
+    if (m_texture != nullptr)
+        m_texture->bind();
 
+    int first = 0;
+    if (m_mapped == nullptr)
+    {
         m_bo->invalidateData().setData(
-            util::array_view(m_vertices.get(), m_nStars),
+            util::array_view(m_vertices, m_nStars),
             gl::Buffer::BufferUsage::StreamDraw);
+    }
+    else
+    {
+        first = static_cast<int>(m_vertices - m_mapped);
+    }
+
+    if (m_pointSizeFromVertex)
+        m_vo1->draw(static_cast<int>(m_nStars), first);
+    else
+        m_vo2->draw(static_cast<int>(m_nStars), first);
+
+#ifndef GL_ES
+    if (m_mapped != nullptr)
+    {
+        // The fence covers all batches drawn from the region so far
+        if (m_fences[m_region] != nullptr)
+            glDeleteSync(m_fences[m_region]);
+        m_fences[m_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+        m_regionUsed += m_nStars;
+        m_vertices += m_nStars;
+        m_available -= m_nStars;
+    }
+#endif
+
+    m_nStars = 0;
+}
+
+// Make room for at least one more star in the current batch
+void PointStarVertexBuffer::reserve()
+{
+#ifndef GL_ES
+    if (m_mapped == nullptr && !m_useStaging)
+    {
+        if (gl::ARB_buffer_storage && gl::ARB_sync && createRing(m_capacity))
+            return;
+        m_useStaging = true;
+    }
+
+    if (m_mapped != nullptr)
+    {
+        // The region is full. If a single batch filled it the ring is too
+        // small for a frame's stars, so it is replaced by a larger one.
+        bool batchFilledRegion = m_regionUsed == 0;
+        render();
+        if (!batchFilledRegion || m_capacity == MaxCapacity)
+        {
+            nextRegion();
+            return;
+        }
 
-        if (m_pointSizeFromVertex)
-            m_vo1->draw(m_nStars);
-        else
-            m_vo2->draw(m_nStars);
-        m_nStars = 0;
+        if (createRing(std::min(m_capacity * 2, MaxCapacity)))
+            return;
     }
+#endif
+
+    reserveStaging();
+}
+
+void PointStarVertexBuffer::reserveStaging()
+{
+    if (m_staging == nullptr)
+    {
+        m_staging = std::make_unique<StarVertex[]>(m_capacity);
+    }
+    else if (m_capacity < MaxCapacity)
+    {
+        capacity_t capacity = std::min(m_capacity * 2, MaxCapacity);
+        auto staging = std::make_unique<StarVertex[]>(capacity);
+        std::copy_n(m_staging.get(), m_nStars, staging.get());
+        m_staging = std::move(staging);
+        m_capacity = capacity;
+    }
+    else
+    {
+        render();
+    }
+
+    m_vertices = m_staging.get();
+    m_available = m_capacity;
+}
+
+#ifndef GL_ES
+bool PointStarVertexBuffer::createRing(capacity_t capacity)
+{
+    releaseBuffers();
+
+    auto bo = std::make_unique<gl::Buffer>();
+    auto mapped = static_cast<StarVertex*>(bo->setPersistentStorage(
+        static_cast<GLsizeiptr>(RingRegions) * capacity * sizeof(StarVertex)));
+    if (mapped == nullptr)
+    {
+        m_useStaging = true;
+        return false;
+    }
+
+    m_capacity = capacity;
+    m_bo = std::move(bo);
+    m_mapped = mapped;
+    m_region = 0;
+    m_regionUsed = 0;
+    m_vertices = m_mapped;
+    m_available = m_capacity;
+    return true;
+}
+
+// Move on to the next region of the ring, waiting until the GPU has
+// finished drawing from it
+void PointStarVertexBuffer::nextRegion()
+{
+    m_region = (m_region + 1) % RingRegions;
+    if (GLsync& fence = m_fences[m_region]; fence != nullptr)
+    {
+        waitForFence(fence);
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+
+    m_regionUsed = 0;
+    m_vertices = m_mapped + static_cast<std::size_t>(m_region) * m_capacity;
+    m_available = m_capacity;
+}
+#endif
+
+void PointStarVertexBuffer::releaseBuffers()
+{
+#ifndef GL_ES
+    for (GLsync& fence : m_fences)
+    {
+        if (fence != nullptr)
+            glDeleteSync(fence);
+        fence = nullptr;
+    }
+#endif
+
+    if (current == this)
+        current = nullptr;
+
+    // The GL keeps the storage alive until pending draws have completed
+    m_vo1.reset();
+    m_vo2.reset();
+    m_bo.reset();
+    m_mapped = nullptr;
+    m_vertices = m_staging.get();
+    m_available = m_staging == nullptr ? 0 : m_capacity;
+    m_initialized = false;
 }
 
 void PointStarVertexBuffer::makeCurrent()
@@ -82,6 +250,7 @@ void PointStarVertexBuffer::makeCurrent()
     if (m_pointSizeFromVertex)
     {
         m_prog->samplerParam("starTex") = 0;
+        m_prog->floatParam("psfCell") = m_psfCell;
     }
     else
     {
@@ -97,7 +266,8 @@ void PointStarVertexBuffer::setupVertexArrayObject()
     {
         m_initialized = true;
 
-        m_bo = std::make_unique<gl::Buffer>();
+        if (m_bo == nullptr)
+            m_bo = std::make_unique<gl::Buffer>();
         m_vo1 = std::make_unique<gl::VertexObject>(gl::VertexObject::Primitive::Points);
         m_vo2 = std::make_unique<gl::VertexObject>(gl::VertexObject::Primitive::Points);
 
@@ -175,6 +345,11 @@ void PointStarVertexBuffer::setTexture(Texture *texture)
     m_texture = texture;
 }
 
+void PointStarVertexBuffer::setPSF(celestia::render::StarPSF psf)
+{
+    m_psfCell = celestia::render::starPSFCell(psf);
+}
+
 void PointStarVertexBuffer::setPointScale(float pointSize)
 {
     m_pointScale = pointSize;
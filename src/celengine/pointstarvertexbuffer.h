@@ -10,8 +10,11 @@
 
 #pragma once
 
+#include <array>
 #include <memory>
 #include <Eigen/Core>
+#include <celengine/glsupport.h>
+#include <celrender/starpsf.h>
 
 class Color;
 class Renderer;
@@ -25,13 +28,23 @@ class VertexObject;
 }
 
 // PointStarVertexBuffer is used when hardware supports point sprites.
+//
+// When persistent buffer mapping is available, stars are written directly
+// into a mapped ring buffer with RingRegions regions of capacity stars each,
+// which are reused once the GPU has finished with them. Otherwise they are
+// staged in memory and uploaded by orphaning the buffer. In both cases the
+// capacity grows up to MaxCapacity, so the stars of a frame are normally
+// drawn with a single call per buffer.
 class PointStarVertexBuffer
 {
 public:
     using capacity_t = unsigned int;
 
+    static constexpr unsigned int RingRegions = 3;
+    static constexpr capacity_t MaxCapacity = 1U << 20;
+
     PointStarVertexBuffer(const Renderer &renderer, capacity_t capacity);
-    ~PointStarVertexBuffer() = default;
+    ~PointStarVertexBuffer();
     PointStarVertexBuffer() = delete;
     PointStarVertexBuffer(const PointStarVertexBuffer&) = delete;
     PointStarVertexBuffer(PointStarVertexBuffer&&) = delete;
@@ -43,7 +56,10 @@ public:
     void render();
     void finish();
     void addStar(const Eigen::Vector3f &pos, const Color &color, float size);
+    // The texture is the atlas of the star PSFs, of which the sprites use
+    // one cell
     void setTexture(Texture* texture);
+    void setPSF(celestia::render::StarPSF);
     void setPointScale(float);
 
     static void enable();
@@ -60,10 +76,15 @@ private:
     const Renderer                 &m_renderer;
     capacity_t                      m_capacity;
     capacity_t                      m_nStars                { 0 };
-    std::unique_ptr<StarVertex[]>   m_vertices;
+    // Space for the current batch of stars, in the staging array or in the
+    // mapped ring buffer
+    StarVertex                     *m_vertices              { nullptr };
+    capacity_t                      m_available             { 0 };
+    std::unique_ptr<StarVertex[]>   m_staging;
     Texture                        *m_texture               { nullptr };
     bool                            m_pointSizeFromVertex   { false };
     float                           m_pointScale            { 1.0f };
+    float                           m_psfCell               { 0.0f };
     CelestiaGLProgram              *m_prog                  { nullptr };
 
     std::unique_ptr<celestia::gl::Buffer>        m_bo;
@@ -71,10 +92,24 @@ private:
     std::unique_ptr<celestia::gl::VertexObject>  m_vo2;
     bool m_initialized{ false };
 
+    // Persistently mapped ring buffer state
+    StarVertex                     *m_mapped                { nullptr };
+    unsigned int                    m_region                { 0 };
+    capacity_t                      m_regionUsed            { 0 };
+    std::array<GLsync, RingRegions> m_fences                { };
+    bool                            m_useStaging            { false };
+
     static PointStarVertexBuffer    *current;
 
     void makeCurrent();
     void setupVertexArrayObject();
+    void reserve();
+    void reserveStaging();
+#ifndef GL_ES
+    bool createRing(capacity_t);
+    void nextRegion();
+#endif
+    void releaseBuffers();
 };
 
 inline void
@@ -82,17 +117,12 @@ PointStarVertexBuffer::addStar(const Eigen::Vector3f &pos,
                                const Color &color,
                                float size)
 {
-    if (m_nStars < m_capacity)
-    {
-        m_vertices[m_nStars].position = pos;
-        m_vertices[m_nStars].size = size;
-        color.get(m_vertices[m_nStars].color);
-        m_nStars++;
-    }
+    if (m_nStars == m_available)
+        reserve();
 
-    if (m_nStars == m_capacity)
-    {
-        render();
-        m_nStars = 0;
-    }
+    StarVertex &vertex = m_vertices[m_nStars];
+    vertex.position = pos;
+    vertex.size = size;
+    color.get(vertex.color);
+    m_nStars++;
 }
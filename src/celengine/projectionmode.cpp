@@ -25,6 +25,16 @@ std::tuple<float, float> ProjectionMode::getDefaultDepthRange() const
     return std::make_tuple(0.5f, 1.0e9f);
 }
 
+bool ProjectionMode::getReverseDepthProjectionMatrix(float /*nearZ*/, float /*zoom*/, Eigen::Matrix4f& /*result*/) const
+{
+    return false;
+}
+
+bool ProjectionMode::setTile(int columns, int rows, int /*column*/, int /*row*/)
+{
+    return columns == 1 && rows == 1;
+}
+
 void ProjectionMode::setScreenDpi(int dpi)
 {
     screenDpi = dpi;
@@ -37,6 +37,10 @@ public:
     // Some rendering systems provide nearZ, farZ. We'll use this value to set up
     // the basic projection matrix for rendering.
     virtual std::tuple<float, float> getDefaultDepthRange() const;
+    // Get a projection matrix with the far plane at infinity, which maps the
+    // near plane to a depth of 1 and infinity to 0 in a [0, 1] clip space
+    // depth range. Returns false if the projection has no such form.
+    virtual bool getReverseDepthProjectionMatrix(float nearZ, float zoom, Eigen::Matrix4f& result) const;
     virtual float getMinimumFOV() const = 0;
     virtual float getMaximumFOV() const = 0;
     virtual float getFOV(float zoom) const = 0;
@@ -61,6 +65,13 @@ public:
                          const std::array<int, 4>& viewport,
                          Eigen::Vector3f& result) const = 0;
 
+    // Render one tile of a grid of columns x rows tiles, each the size of
+    // the viewport, counting from the bottom left. The whole image keeps the
+    // vertical field of view and has square pixels, so it has the framing of
+    // the viewport when the grid is square. Returns false if the projection
+    // can't be split into tiles.
+    virtual bool setTile(int columns, int rows, int column, int row);
+
     void setScreenDpi(int screenDpi);
     void setDistanceToScreen(int distanceToScreen);
     void setSize(float width, float height);
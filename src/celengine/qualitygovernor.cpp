@@ -0,0 +1,140 @@
+// qualitygovernor.cpp
+//
+// Copyright (C) 2026, Celestia Development Team
+//
+// Lowers the render detail when frames take longer than a target time, and
+// raises it again when they are fast enough.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include "qualitygovernor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace celestia::engine
+{
+
+namespace
+{
+
+// Weight of the last frame in the smoothed frame time
+constexpr double FrameTimeWeight = 0.1;
+
+// Consecutive frames missing the target before the level is lowered or
+// raised
+constexpr std::uint32_t LowerAfterFrames = 15;
+constexpr std::uint32_t RaiseAfterFrames = 120;
+
+// Budgets which aren't limited at the best quality start from this
+// multiple of their lowest value
+constexpr double UnlimitedBudgetFactor = 4.0;
+
+double
+interpolate(const QualityRange& range, double t)
+{
+    return range.best + (range.worst - range.best) * t;
+}
+
+// Budgets and sizes are scaled by the same factor at each level
+unsigned int
+interpolateBudget(const QualityRange& range, double t)
+{
+    if (range.worst <= 0.0 || t <= 0.0)
+        return static_cast<unsigned int>(range.best);
+
+    double best = range.best > 0.0 ? range.best : range.worst * UnlimitedBudgetFactor;
+    return static_cast<unsigned int>(best * std::pow(range.worst / best, t));
+}
+
+} // end unnamed namespace
+
+void
+QualityGovernor::setLimits(const QualityLimits& limits)
+{
+    m_limits = limits;
+    reset();
+}
+
+bool
+QualityGovernor::update(const FrameCounters& counters)
+{
+    if (!isEnabled())
+        return false;
+
+    double time = std::accumulate(counters.stageTimes.begin(), counters.stageTimes.end(), 0.0);
+    if (counters.gpuTime.has_value())
+        time = std::max(time, *counters.gpuTime);
+    if (time <= 0.0)
+        return false;
+
+    m_frameTime = m_frameTime > 0.0
+        ? m_frameTime + (time - m_frameTime) * FrameTimeWeight
+        : time;
+
+    int level = m_level;
+    if (m_frameTime > m_limits.targetFrameTime * (1.0 + m_limits.tolerance))
+    {
+        m_fastFrames = 0;
+        if (++m_slowFrames >= LowerAfterFrames)
+            level = std::min(m_level + 1, MaxLevel);
+    }
+    else if (m_frameTime < m_limits.targetFrameTime * (1.0 - m_limits.tolerance))
+    {
+        m_slowFrames = 0;
+        if (++m_fastFrames >= RaiseAfterFrames)
+            level = std::max(m_level - 1, 0);
+    }
+    else
+    {
+        m_slowFrames = 0;
+        m_fastFrames = 0;
+    }
+
+    if (level == m_level)
+        return false;
+
+    m_level = level;
+    m_slowFrames = 0;
+    m_fastFrames = 0;
+    ++m_adjustments;
+    return true;
+}
+
+QualitySettings
+QualityGovernor::getSettings() const
+{
+    double t = static_cast<double>(m_level) / static_cast<double>(MaxLevel);
+
+    QualitySettings settings;
+    settings.magnitudeOffset = static_cast<float>(interpolate(m_limits.magnitudeOffset, t));
+    settings.galaxyPointBudget = interpolateBudget(m_limits.galaxyPointBudget, t);
+    settings.maxLabels = interpolateBudget(m_limits.maxLabels, t);
+    settings.orbitTolerance = interpolate(m_limits.orbitTolerance, t);
+    settings.sphereDetail = static_cast<float>(interpolate(m_limits.sphereDetail, t));
+
+    // Shadow maps keep a power of two size, and aren't enabled by the governor
+    if (m_limits.shadowMapSize.best > 0.0)
+    {
+        auto size = static_cast<double>(interpolateBudget(m_limits.shadowMapSize, t));
+        settings.shadowMapSize = static_cast<unsigned int>(std::exp2(std::round(std::log2(std::max(size, 1.0)))));
+    }
+
+    return settings;
+}
+
+void
+QualityGovernor::reset()
+{
+    m_level = 0;
+    m_frameTime = 0.0;
+    m_slowFrames = 0;
+    m_fastFrames = 0;
+    m_adjustments = 0;
+}
+
+} // end namespace celestia::engine
@@ -0,0 +1,101 @@
+// qualitygovernor.h
+//
+// Copyright (C) 2026, Celestia Development Team
+//
+// Lowers the render detail when frames take longer than a target time, and
+// raises it again when they are fast enough.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <cstdint>
+
+#include "framestats.h"
+
+namespace celestia::engine
+{
+
+// The values of a setting at the highest and the lowest quality
+struct QualityRange
+{
+    double best;
+    double worst;
+};
+
+struct QualityLimits
+{
+    // Milliseconds; 0 disables the governor
+    double targetFrameTime{ 0.0 };
+    // Fraction of the target by which the frame time must miss it before the
+    // quality changes
+    double tolerance{ 0.15 };
+    // Magnitudes subtracted from the faintest magnitude
+    QualityRange magnitudeOffset{ 0.0, -2.0 };
+    // Budgets of 0 are not limited
+    QualityRange galaxyPointBudget{ 0.0, 0.0 };
+    QualityRange maxLabels{ 0.0, 0.0 };
+    // Factor applied to the tolerance of the orbit paths sampled
+    QualityRange orbitTolerance{ 1.0, 8.0 };
+    // Factor applied to the size on screen of the spheres when choosing
+    // their level of detail
+    QualityRange sphereDetail{ 1.0, 0.25 };
+    // 0 when shadow maps are disabled
+    QualityRange shadowMapSize{ 0.0, 0.0 };
+};
+
+// The settings of a quality level
+struct QualitySettings
+{
+    float magnitudeOffset{ 0.0f };
+    unsigned int galaxyPointBudget{ 0 };
+    unsigned int maxLabels{ 0 };
+    double orbitTolerance{ 1.0 };
+    float sphereDetail{ 1.0f };
+    unsigned int shadowMapSize{ 0 };
+};
+
+// Picks a quality level from the time of the last frames. The level drops
+// once the smoothed frame time stays above the target for a few frames,
+// and rises only after it stays below the target for longer, so that the
+// detail doesn't flicker between two levels.
+class QualityGovernor
+{
+public:
+    // Level 0 is the best quality
+    static constexpr int MaxLevel = 8;
+
+    QualityGovernor() = default;
+
+    const QualityLimits& getLimits() const { return m_limits; }
+    void setLimits(const QualityLimits&);
+    bool isEnabled() const { return m_limits.targetFrameTime > 0.0; }
+
+    // Check a complete frame; returns true when the level changed
+    bool update(const FrameCounters&);
+
+    int getLevel() const { return m_level; }
+    // Milliseconds, the larger of the CPU and GPU time, smoothed over the
+    // last frames
+    double getFrameTime() const { return m_frameTime; }
+    // Number of level changes since the last reset
+    std::uint32_t getAdjustments() const { return m_adjustments; }
+
+    QualitySettings getSettings() const;
+
+    void reset();
+
+private:
+    QualityLimits m_limits;
+    int m_level{ 0 };
+    double m_frameTime{ 0.0 };
+    // Consecutive frames above and below the tolerance of the target
+    std::uint32_t m_slowFrames{ 0 };
+    std::uint32_t m_fastFrames{ 0 };
+    std::uint32_t m_adjustments{ 0 };
+};
+
+} // end namespace celestia::engine
@@ -134,6 +134,16 @@ RenderContext::getCameraOrientation() const
 
 void
 RenderContext::drawGroup(gl::VertexObject &vao, const cmod::PrimitiveGroup& group)
+{
+    drawGroups(vao, group.prim, util::array_view<int>(&group.indicesCount, 1), util::array_view<int>(&group.indicesOffset, 1));
+}
+
+
+void
+RenderContext::drawGroups(gl::VertexObject &vao,
+                          cmod::PrimitiveGroupType prim,
+                          util::array_view<int> counts,
+                          util::array_view<int> firsts)
 {
     // Skip rendering if this is the emissive pass but there's no
     // emissive texture.
@@ -147,9 +157,9 @@ RenderContext::drawGroup(gl::VertexObject &vao, const cmod::PrimitiveGroup& grou
 #ifndef GL_ES
     bool drawPoints = false;
 #endif
-    if (group.prim == cmod::PrimitiveGroupType::SpriteList || group.prim == cmod::PrimitiveGroupType::PointList)
+    if (prim == cmod::PrimitiveGroupType::SpriteList || prim == cmod::PrimitiveGroupType::PointList)
     {
-        if (group.prim == cmod::PrimitiveGroupType::PointList)
+        if (prim == cmod::PrimitiveGroupType::PointList)
             glVertexAttrib1f(CelestiaGLProgram::PointSizeAttributeIndex, 1.0f);
 #ifndef GL_ES
         drawPoints = true;
@@ -159,7 +169,7 @@ RenderContext::drawGroup(gl::VertexObject &vao, const cmod::PrimitiveGroup& grou
         glActiveTexture(GL_TEXTURE0);
     }
 
-    vao.draw(convert(group.prim), group.indicesCount, group.indicesOffset);
+    vao.multiDraw(convert(prim), counts, firsts);
 
 #ifndef GL_ES
     if (drawPoints)
@@ -15,6 +15,7 @@
 
 #include <celmodel/material.h>
 #include <celmodel/mesh.h>
+#include <celutil/array_view.h>
 
 #include "glsupport.h"
 #include "shadermanager.h"
@@ -30,6 +31,11 @@ namespace celestia::gl
 class VertexObject;
 }
 
+namespace celestia::math
+{
+class Frustum;
+}
+
 class RenderContext
 {
  public:
@@ -40,6 +46,12 @@ class RenderContext
     virtual void makeCurrent(const cmod::Material&) = 0;
     virtual void updateShader(const cmod::VertexDescription& desc, cmod::PrimitiveGroupType primType);
     virtual void drawGroup(celestia::gl::VertexObject &vao, const cmod::PrimitiveGroup& group);
+    // Draws the ranges of indices, given by their counts and first indices,
+    // with one call where supported
+    virtual void drawGroups(celestia::gl::VertexObject &vao,
+                            cmod::PrimitiveGroupType prim,
+                            celestia::util::array_view<int> counts,
+                            celestia::util::array_view<int> firsts);
 
     const cmod::Material* getMaterial() const;
     void setMaterial(const cmod::Material*);
@@ -62,6 +74,17 @@ class RenderContext
     void setCameraOrientation(const Eigen::Quaternionf& q);
     Eigen::Quaternionf getCameraOrientation() const;
 
+    // Size in pixels of one unit of the geometry, used to select the level
+    // of detail. Zero, the default, draws the full detail.
+    void setPixelScale(float scale) { pixelScale = scale; }
+    float getPixelScale() const { return pixelScale; }
+
+    // View frustum in the coordinates of the geometry, used to skip the
+    // parts of models which are out of view. Null, the default, draws
+    // everything.
+    void setFrustum(const celestia::math::Frustum* f) { frustum = f; }
+    const celestia::math::Frustum* getFrustum() const { return frustum; }
+
  protected:
     Renderer* renderer { nullptr };
     bool usePointSize{ false };
@@ -75,6 +98,8 @@ class RenderContext
     bool locked{ false };
     RenderPass renderPass{ PrimaryPass };
     float pointScale{ 1.0f };
+    float pixelScale{ 0.0f };
+    const celestia::math::Frustum* frustum{ nullptr };
     Eigen::Quaternionf cameraOrientation;  // required for drawing billboards
 };
 
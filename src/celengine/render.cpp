@@ -28,6 +28,7 @@
 #include "lodspheremesh.h"
 #include "geometry.h"
 #include "texmanager.h"
+#include "texturestats.h"
 #include "meshmanager.h"
 #include "renderinfo.h"
 #include "renderglsl.h"
@@ -38,9 +39,14 @@
 #include "skygrid.h"
 #include "modelgeometry.h"
 #include "curveplot.h"
+#include "orbitcache.h"
+#include "overlayimagecache.h"
 #include "shadermanager.h"
+#include "shadowmapcache.h"
 #include "rectangle.h"
 #include "framebuffer.h"
+#include "framebufferpool.h"
+#include "framestats.h"
 #include "planetgrid.h"
 #include "pointstarvertexbuffer.h"
 #include "pointstarrenderer.h"
@@ -66,22 +72,33 @@
 #include <celrender/linerenderer.h>
 #include <celrender/galaxyrenderer.h>
 #include <celrender/globularrenderer.h>
+#include <celrender/gpuprofiler.h>
+#include <celrender/gpustagetimer.h>
+#include <celrender/gpustarrenderer.h>
+#include <celrender/gputimer.h>
 #include <celrender/nebularenderer.h>
 #include <celrender/openclusterrenderer.h>
+#include <celrender/reversedepthtarget.h>
 #include <celrender/ringrenderer.h>
 #include <celrender/skygridrenderer.h>
+#include <celrender/starpsf.h>
 #include <celrender/gl/buffer.h>
 #include <celrender/gl/vertexobject.h>
 #include <celutil/logger.h>
+#include <celutil/profiler.h>
+#include <celutil/threadpool.h>
 #include <celutil/utf8.h>
 #include <celutil/timer.h>
 #include <celttf/truetypefont.h>
 #include "glsupport.h"
 #include <algorithm>
+#include <chrono>
 #include <cstring>
 #include <cassert>
 #include <sstream>
 #include <iomanip>
+#include <limits>
+#include <map>
 #include <numeric>
 #ifdef _MSC_VER
 #include <malloc.h>
@@ -122,6 +139,14 @@ static const float MaxFarNearRatio      = 2000000.0f;
 
 static const float MinRelativeOccluderRadius = 0.005f;
 
+// Time spent per frame creating the textures which were decoded in the
+// background
+static constexpr auto TextureUploadBudget = std::chrono::milliseconds(4);
+
+// Time spent per frame creating the models which were loaded in the
+// background
+static constexpr auto GeometryCreateBudget = std::chrono::milliseconds(2);
+
 // The minimum apparent size of an objects orbit in pixels before we display
 // a label for it.  This minimizes label clutter.
 static const float MinOrbitSizeForLabel = 20.0f;
@@ -147,16 +172,11 @@ static bool commonDataInitialized = false;
 
 LODSphereMesh* g_lodSphere = nullptr;
 
-static Texture* gaussianDiscTex = nullptr;
-static Texture* gaussianGlareTex = nullptr;
+// Disc and glare point spread functions of the star sprites
+static Texture* starPSFTex = nullptr;
 
 static const float CoronaHeight = 0.2f;
 
-// Size at which the orbit cache will be flushed of old orbit paths
-static const unsigned int OrbitCacheCullThreshold = 200;
-// Age in frames at which unused orbit paths may be eliminated from the cache
-static const uint32_t OrbitCacheRetireAge = 16;
-
 Color Renderer::StarLabelColor          (0.471f, 0.356f, 0.682f);
 Color Renderer::PlanetLabelColor        (0.407f, 0.333f, 0.964f);
 Color Renderer::DwarfPlanetLabelColor   (0.557f, 0.235f, 0.576f);
@@ -244,7 +264,6 @@ Renderer::Renderer() :
     pointStarVertexBuffer(nullptr),
     glareVertexBuffer(nullptr),
     frameCount(0),
-    lastOrbitCacheFlush(0),
     minOrbitSize(MinOrbitSizeForLabel),
     distanceLimit(1.0e6f),
     minFeatureSize(MinFeatureSizeForLabel),
@@ -256,6 +275,7 @@ Renderer::Renderer() :
     m_eclipticLineRenderer(std::make_unique<EclipticLineRenderer>(*this)),
     m_galaxyRenderer(std::make_unique<GalaxyRenderer>(*this)),
     m_globularRenderer(std::make_unique<GlobularRenderer>(*this)),
+    m_gpuStarRenderer(std::make_unique<GPUStarRenderer>(*this)),
     m_largeStarRenderer(std::make_unique<LargeStarRenderer>(*this)),
     m_hollowMarkerRenderer(std::make_unique<LineRenderer>(*this, 1.0f, LineRenderer::PrimType::Lines, LineRenderer::StorageType::Static)),
     m_nebulaRenderer(std::make_unique<NebulaRenderer>(*this)),
@@ -263,8 +283,12 @@ Renderer::Renderer() :
     m_ringRenderer(std::make_unique<RingRenderer>(*this)),
     m_skyGridRenderer(std::make_unique<SkyGridRenderer>(*this))
 {
-    pointStarVertexBuffer = new PointStarVertexBuffer(*this, 2048);
-    glareVertexBuffer = new PointStarVertexBuffer(*this, 2048);
+    orbitCache = std::make_unique<OrbitCache>(*this, OrbitCache::DefaultBudget, util::GetThreadPool());
+    overlayImageCache = std::make_unique<OverlayImageCache>(OverlayImageCache::DefaultBudget, util::GetThreadPool());
+    m_framebufferPool = std::make_unique<FramebufferPool>();
+    pointStarVertexBuffer = new PointStarVertexBuffer(*this, 16384);
+    glareVertexBuffer = new PointStarVertexBuffer(*this, 16384);
+    glareVertexBuffer->setPSF(StarPSF::Glare);
 
     for (int i = 0; i < (int) FontCount; i++)
     {
@@ -334,143 +358,6 @@ static void RectToSphericalMapEval(float x, float y, float z,
 #endif
 
 
-static void BuildGaussianDiscMipLevel(unsigned char* mipPixels,
-                                      unsigned int log2size,
-                                      float fwhm,
-                                      float power)
-{
-    unsigned int size = 1 << log2size;
-    float sigma = fwhm / 2.3548f;
-    float isig2 = 1.0f / (2.0f * sigma * sigma);
-    // Store 1/sqrt(2*pi) in constexpr sfactor
-    constexpr auto sfactor = static_cast<float>(0.5 * celestia::numbers::sqrt2 * celestia::numbers::inv_sqrtpi);
-    float s = sfactor / sigma;
-
-    for (unsigned int i = 0; i < size; i++)
-    {
-        float y = (float) i - size / 2;
-        for (unsigned int j = 0; j < size; j++)
-        {
-            float x = (float) j - size / 2;
-            float r2 = x * x + y * y;
-            float f = s * std::exp(-r2 * isig2) * power;
-
-            mipPixels[i * size + j] = (unsigned char) (255.99f * std::min(f, 1.0f));
-        }
-    }
-}
-
-
-static void BuildGlareMipLevel(unsigned char* mipPixels,
-                               unsigned int log2size,
-                               float scale,
-                               float base)
-{
-    unsigned int size = 1 << log2size;
-
-    for (unsigned int i = 0; i < size; i++)
-    {
-        float y = (float) i - size / 2;
-        for (unsigned int j = 0; j < size; j++)
-        {
-            float x = (float) j - size / 2;
-            float r = std::sqrt(x * x + y * y);
-            float f = std::pow(base, r * scale);
-            mipPixels[i * size + j] = (unsigned char) (255.99f * std::min(f, 1.0f));
-        }
-    }
-}
-
-
-#if 0
-// An alternate glare function, based roughly on results in Spencer, G. et al,
-// 1995, "Physically-Based Glare Effects for Digital Images"
-static void BuildGlareMipLevel2(unsigned char* mipPixels,
-                                unsigned int log2size,
-                                float scale)
-{
-    unsigned int size = 1 << log2size;
-
-    for (unsigned int i = 0; i < size; i++)
-    {
-        float y = (float) i - size / 2;
-        for (unsigned int j = 0; j < size; j++)
-        {
-            float x = (float) j - size / 2;
-            float r = (float) sqrt(x * x + y * y);
-            float f = 0.3f / (0.3f + r * r * scale * scale * 100);
-            /*
-            if (i == 0 || j == 0 || i == size - 1 || j == size - 1)
-                f = 1.0f;
-            */
-            mipPixels[i * size + j] = (unsigned char) (255.99f * min(f, 1.0f));
-        }
-    }
-}
-#endif
-
-
-static Texture* BuildGaussianDiscTexture(unsigned int log2size)
-{
-    unsigned int size = 1 << log2size;
-    Image* img = new Image(PixelFormat::Luminance, size, size, log2size + 1);
-
-    for (unsigned int mipLevel = 0; mipLevel <= log2size; mipLevel++)
-    {
-        float fwhm = std::pow(2.0f, (float) (log2size - mipLevel)) * 0.3f;
-        BuildGaussianDiscMipLevel(img->getMipLevel(mipLevel),
-                                  log2size - mipLevel,
-                                  fwhm,
-                                  std::pow(2.0f, (float) (log2size - mipLevel)));
-    }
-
-    ImageTexture* texture = new ImageTexture(*img,
-                                             Texture::EdgeClamp,
-                                             Texture::DefaultMipMaps);
-
-    delete img;
-
-    return texture;
-}
-
-
-static Texture* BuildGaussianGlareTexture(unsigned int log2size)
-{
-    unsigned int size = 1 << log2size;
-    Image* img = new Image(PixelFormat::Luminance, size, size, log2size + 1);
-
-    for (unsigned int mipLevel = 0; mipLevel <= log2size; mipLevel++)
-    {
-        /*
-        // Optional gaussian glare
-        float fwhm = (float) pow(2.0f, (float) (log2size - mipLevel)) * 0.15f;
-        float power = (float) pow(2.0f, (float) (log2size - mipLevel)) * 0.15f;
-        BuildGaussianDiscMipLevel(img->getMipLevel(mipLevel),
-                                  log2size - mipLevel,
-                                  fwhm,
-                                  power);
-        */
-        BuildGlareMipLevel(img->getMipLevel(mipLevel),
-                           log2size - mipLevel,
-                           25.0f / (float) pow(2.0f, (float) (log2size - mipLevel)),
-                           0.66f);
-        /*
-        BuildGlareMipLevel2(img->getMipLevel(mipLevel),
-                            log2size - mipLevel,
-                            1.0f / (float) pow(2.0f, (float) (log2size - mipLevel)));
-        */
-    }
-
-    ImageTexture* texture = new ImageTexture(*img,
-                                             Texture::EdgeClamp,
-                                             Texture::DefaultMipMaps);
-
-    delete img;
-
-    return texture;
-}
-
-
 static BodyClassification
 translateLabelModeToClassMask(RenderLabels labelMode)
 {
@@ -538,8 +425,7 @@ bool Renderer::init(int winWidth, int winHeight, const DetailOptions& _detailOpt
     {
         g_lodSphere = new LODSphereMesh();
 
-        gaussianDiscTex = BuildGaussianDiscTexture(8);
-        gaussianGlareTex = BuildGaussianGlareTexture(9);
+        starPSFTex = CreateStarPSFTexture().release();
 
         commonDataInitialized = true;
     }
@@ -721,6 +607,25 @@ void Renderer::setProjectionMode(shared_ptr<celestia::engine::ProjectionMode> _p
     markSettingsChanged();
 }
 
+void Renderer::overrideProjectionMode(shared_ptr<celestia::engine::ProjectionMode> _projectionMode)
+{
+    if (_projectionMode == nullptr)
+    {
+        if (overriddenProjectionMode == nullptr)
+            return;
+        projectionMode = std::move(overriddenProjectionMode);
+    }
+    else if (overriddenProjectionMode == nullptr)
+    {
+        overriddenProjectionMode = std::exchange(projectionMode, std::move(_projectionMode));
+    }
+    else
+    {
+        projectionMode = std::move(_projectionMode);
+    }
+    projectionMode->configureShaderManager(shaderManager);
+}
+
 BodyClassification
 Renderer::getOrbitMask() const
 {
@@ -869,7 +774,8 @@ void Renderer::addAnnotation(vector<Annotation>& annotations,
                              LabelHorizontalAlignment halign,
                              LabelVerticalAlignment valign,
                              float size,
-                             bool special)
+                             bool special,
+                             float priority)
 {
     std::array<int, 4> view{ 0, 0, windowWidth, windowHeight };
     Vector3f win;
@@ -889,18 +795,130 @@ void Renderer::addAnnotation(vector<Annotation>& annotations,
 
         Annotation a;
         if (!special || markerRep == nullptr)
-             a.labelText = labelText;
+             a.labelText = labelArena.copy(labelText);
         a.markerRep = markerRep;
         a.color = color;
         a.position = win;
         a.halign = halign;
         a.valign = valign;
         a.size = size;
+        a.priority = priority;
         annotations.push_back(a);
     }
 }
 
 
+// Remove the labels which overlap a label of higher priority, after trying
+// to move them to the other side of their position. Annotations with a marker
+// keep the marker. The order of the remaining annotations is unchanged.
+void Renderer::declutterAnnotations(vector<Annotation>& annotations, const TextureFont* font)
+{
+    if (!labelDeclutter || font == nullptr || annotations.size() < 2)
+        return;
+
+    std::vector<std::uint32_t> order;
+    order.reserve(annotations.size());
+    for (std::uint32_t i = 0; i < annotations.size(); ++i)
+    {
+        if (!annotations[i].labelText.empty())
+            order.push_back(i);
+    }
+
+    std::stable_sort(order.begin(), order.end(),
+                     [&annotations](std::uint32_t a, std::uint32_t b)
+                     { return annotations[a].priority < annotations[b].priority; });
+
+    auto labelRect = [this, font](const Annotation& a)
+    {
+        TextLayout::HorizontalAlignment alignment = TextLayout::HorizontalAlignment::Left;
+        float hOffset = 0.0f;
+        float vOffset = 0.0f;
+        getLabelAlignmentInfo(a, font, alignment, hOffset, vOffset);
+
+        auto width = static_cast<float>(TextLayout::getTextWidth(a.labelText, font, &labelLineCache));
+        float x = std::trunc(a.position.x()) + hOffset;
+        float y = std::trunc(a.position.y()) + vOffset;
+        switch (alignment)
+        {
+        case TextLayout::HorizontalAlignment::Center:
+            x -= width / 2.0f;
+            break;
+        case TextLayout::HorizontalAlignment::Right:
+            x -= width;
+            break;
+        default:
+            break;
+        }
+
+        return engine::LabelPlacer::Rect
+        {
+            x,
+            y - static_cast<float>(font->getMaxDescent()),
+            x + width,
+            y + static_cast<float>(font->getMaxAscent()),
+        };
+    };
+
+    labelPlacer.reset(windowWidth, windowHeight);
+
+    std::vector<bool> removed(annotations.size(), false);
+    unsigned int placed = 0;
+    for (std::uint32_t i : order)
+    {
+        Annotation& a = annotations[i];
+        if (a.priority == AlwaysShowLabel)
+        {
+            labelPlacer.insert(labelRect(a));
+            continue;
+        }
+
+        if ((maxLabels == 0 || placed < maxLabels) && labelPlacer.place(labelRect(a)))
+        {
+            ++placed;
+            continue;
+        }
+
+        if (maxLabels == 0 || placed < maxLabels)
+        {
+            // Try the label on the opposite side of the position
+            Annotation moved = a;
+            if (a.valign == LabelVerticalAlignment::Bottom)
+                moved.valign = LabelVerticalAlignment::Top;
+            else if (a.valign == LabelVerticalAlignment::Top)
+                moved.valign = LabelVerticalAlignment::Bottom;
+            else if (a.halign == LabelHorizontalAlignment::Start)
+                moved.halign = LabelHorizontalAlignment::End;
+            else if (a.halign == LabelHorizontalAlignment::End)
+                moved.halign = LabelHorizontalAlignment::Start;
+
+            if ((moved.valign != a.valign || moved.halign != a.halign) && labelPlacer.place(labelRect(moved)))
+            {
+                a.halign = moved.halign;
+                a.valign = moved.valign;
+                ++placed;
+                continue;
+            }
+        }
+
+        if (a.markerRep != nullptr)
+            a.labelText = {};
+        else
+            removed[i] = true;
+    }
+
+    auto last = annotations.begin();
+    for (std::size_t i = 0; i < annotations.size(); ++i)
+    {
+        if (removed[i])
+            continue;
+        if (last != annotations.begin() + i)
+            *last = std::move(annotations[i]);
+        ++last;
+    }
+    annotations.erase(last, annotations.end());
+}
+
+
 void Renderer::addForegroundAnnotation(const celestia::MarkerRepresentation* markerRep,
                                        std::string_view labelText,
                                        Color color,
@@ -919,9 +937,10 @@ void Renderer::addBackgroundAnnotation(const celestia::MarkerRepresentation* mar
                                        const Vector3f& pos,
                                        LabelHorizontalAlignment halign,
                                        LabelVerticalAlignment valign,
-                                       float size)
+                                       float size,
+                                       float priority)
 {
-    addAnnotation(backgroundAnnotations, markerRep, labelText, color, pos, halign, valign, size);
+    addAnnotation(backgroundAnnotations, markerRep, labelText, color, pos, halign, valign, size, false, priority);
 }
 
 
@@ -991,6 +1010,7 @@ void Renderer::endObjectAnnotations()
         ps.smoothLines = true;
         setPipelineState(ps);
 
+        declutterAnnotations(objectAnnotations, getFont(FontNormal).get());
         renderAnnotations(objectAnnotations.begin(),
                           objectAnnotations.end(),
                           -depthPartitions[currentIntervalIndex].nearZ,
@@ -1007,12 +1027,13 @@ void Renderer::addObjectAnnotation(const celestia::MarkerRepresentation* markerR
                                    Color color,
                                    const Vector3f& pos,
                                    LabelHorizontalAlignment halign,
-                                   LabelVerticalAlignment valign)
+                                   LabelVerticalAlignment valign,
+                                   float priority)
 {
     assert(objectAnnotationSetOpen);
     if (objectAnnotationSetOpen)
     {
-        addAnnotation(objectAnnotations, markerRep, labelText, color, pos, halign, valign);
+        addAnnotation(objectAnnotations, markerRep, labelText, color, pos, halign, valign, 0.0f, false, priority);
     }
 }
 
@@ -1076,68 +1097,36 @@ void Renderer::renderOrbit(const OrbitPathListEntry& orbitPath,
     double nearZ = -nearDist;  // negate, becase z is into the screen in camera space
     double farZ = -farDist;
 
-    const auto* orbit = body != nullptr ? body->getOrbit(t) : orbitPath.star->getOrbit();
+    const std::shared_ptr<const celestia::ephem::Orbit>& orbit = body != nullptr
+        ? body->getSharedOrbit(t)
+        : orbitPath.star->getSharedOrbit();
+
+    double startTime = t;
 
-    CurvePlot* cachedOrbit = nullptr;
-    if (auto cached = orbitCache.find(orbit); cached != orbitCache.end())
+    // Adjust the number of samples used for aperiodic orbits--these aren't
+    // true orbits, but are sampled trajectories, generally of spacecraft.
+    // Better control is really needed--some sort of adaptive sampling would
+    // be ideal.
+    if (orbit->isPeriodic())
     {
-        cachedOrbit = cached->second;
-        cachedOrbit->setLastUsed(frameCount);
+        startTime = t - orbit->getPeriod();
     }
-
-    // If it's not in the cache already
-    if (cachedOrbit == nullptr)
+    else
     {
-        double startTime = t;
-
-        // Adjust the number of samples used for aperiodic orbits--these aren't
-        // true orbits, but are sampled trajectories, generally of spacecraft.
-        // Better control is really needed--some sort of adaptive sampling would
-        // be ideal.
-        if (orbit->isPeriodic())
-        {
-            startTime = t - orbit->getPeriod();
-        }
-        else
-        {
-            double begin = 0.0, end = 0.0;
-            orbit->getValidRange(begin, end);
-
-            if (begin != end)
-            {
-                startTime = begin;
-            }
-        }
-
-        cachedOrbit = new CurvePlot(*this);
-        cachedOrbit->setLastUsed(frameCount);
-
-        OrbitSampler sampler;
-        orbit->sample(startTime,
-                      startTime + orbit->getPeriod(),
-                      sampler);
-        sampler.insertForward(cachedOrbit);
+        double begin = 0.0, end = 0.0;
+        orbit->getValidRange(begin, end);
 
-        // If the orbit cache is full, first try and eliminate some old orbits
-        if (orbitCache.size() > OrbitCacheCullThreshold)
+        if (begin != end)
         {
-            // Check for old orbits at most once per frame
-            if (lastOrbitCacheFlush != frameCount)
-            {
-                for (auto iter = orbitCache.begin(); iter != orbitCache.end();)
-                {
-                    // Tricky code to eliminate a node in the orbit cache without screwing
-                    // up the iterator. Should work in all STL implementations.
-                    if (frameCount - iter->second->lastUsed() > OrbitCacheRetireAge)
-                        orbitCache.erase(iter++);
-                    else
-                        ++iter;
-                }
-                lastOrbitCacheFlush = frameCount;
-            }
+            startTime = begin;
         }
+    }
 
-        orbitCache[orbit] = cachedOrbit;
+    CurvePlot* cachedOrbit;
+    {
+        std::string_view name = body != nullptr ? std::string_view(body->getName()) : std::string_view("star");
+        engine::FrameZoneTimer zoneTimer(engine::FrameZone::OrbitSampling, name);
+        cachedOrbit = orbitCache->get(orbit, startTime, frameCount);
     }
 
     if (cachedOrbit->empty())
@@ -1215,9 +1204,10 @@ void Renderer::renderOrbit(const OrbitPathListEntry& orbitPath,
         }
     }
 
-    // We perform vertex tranformations on the CPU because double precision is necessary to
-    // render orbits properly. Start by computing the modelview matrix, to transform orbit
-    // vertices into camera space.
+    // Double precision is necessary to render orbits properly: the vertices near the
+    // camera are transformed on the CPU, and the others by a shader from positions
+    // split into two floats. Start by computing the modelview matrix, to transform
+    // orbit vertices into camera space.
     Affine3d modelview;
     {
         auto orientation = body == nullptr ? Quaterniond::Identity() : body->getOrbitFrame(t)->getOrientation(t);
@@ -1257,21 +1247,21 @@ void Renderer::renderOrbit(const OrbitPathListEntry& orbitPath,
 
         if (LinearFadeFraction == 0.0f || !util::is_set(renderFlags, RenderFlags::ShowFadingOrbits))
         {
-            cachedOrbit->render(modelview,
-                                nearZ, farZ, viewFrustumPlaneNormals,
-                                subdivisionThreshold,
-                                windowStart, windowEnd,
-                                orbitColor);
+            cachedOrbit->renderBuffered(modelview,
+                                        nearZ, farZ, viewFrustumPlaneNormals,
+                                        subdivisionThreshold,
+                                        windowStart, windowEnd,
+                                        orbitColor);
         }
         else
         {
-            cachedOrbit->renderFaded(modelview,
-                                     nearZ, farZ, viewFrustumPlaneNormals,
-                                     subdivisionThreshold,
-                                     windowStart, windowEnd,
-                                     orbitColor,
-                                     windowStart,
-                                     windowEnd - windowDuration * (1.0 - LinearFadeFraction));
+            cachedOrbit->renderBuffered(modelview,
+                                        nearZ, farZ, viewFrustumPlaneNormals,
+                                        subdivisionThreshold,
+                                        windowStart, windowEnd,
+                                        orbitColor,
+                                        windowStart,
+                                        windowEnd - windowDuration * (1.0 - LinearFadeFraction));
         }
     }
     else
@@ -1279,19 +1269,20 @@ void Renderer::renderOrbit(const OrbitPathListEntry& orbitPath,
         if (util::is_set(renderFlags, RenderFlags::ShowPartialTrajectories))
         {
             // Show the trajectory from the start time until the current simulation time
-            cachedOrbit->render(modelview,
-                                nearZ, farZ, viewFrustumPlaneNormals,
-                                subdivisionThreshold,
-                                cachedOrbit->startTime(), t,
-                                orbitColor);
+            cachedOrbit->renderBuffered(modelview,
+                                        nearZ, farZ, viewFrustumPlaneNormals,
+                                        subdivisionThreshold,
+                                        cachedOrbit->startTime(), t,
+                                        orbitColor);
         }
         else
         {
             // Show the entire trajectory
-            cachedOrbit->render(modelview,
-                                nearZ, farZ, viewFrustumPlaneNormals,
-                                subdivisionThreshold,
-                                orbitColor);
+            cachedOrbit->renderBuffered(modelview,
+                                        nearZ, farZ, viewFrustumPlaneNormals,
+                                        subdivisionThreshold,
+                                        cachedOrbit->startTime(), cachedOrbit->endTime(),
+                                        orbitColor);
         }
     }
 
@@ -1422,6 +1413,52 @@ setupSecondaryLightSources(vector<SecondaryIlluminator>& secondaryIlluminators,
 }
 
 
+// Opaque items don't depend on the order they are drawn in, so bodies
+// sharing a model are moved next to the first of them in the partition. The
+// model's shaders, textures and buffers stay bound from one body to the next,
+// and the nearest items are still mostly drawn first.
+void
+Renderer::sortOpaqueItems()
+{
+    if (opaqueDrawOrder.size() < 2)
+        return;
+
+    auto geometryOf = [this](int item)
+    {
+        const RenderListEntry& rle = renderList[item];
+        return rle.renderableType == RenderListEntry::RenderableBody
+            ? rle.body->getGeometry()
+            : InvalidResource;
+    };
+
+    // Rank each item by the first position of its model; items without a
+    // model keep their own position
+    std::vector<std::pair<int, int>> ranked;
+    ranked.reserve(opaqueDrawOrder.size());
+    std::map<ResourceHandle, int> firstPositions;
+    bool shared = false;
+    for (int pos = 0; pos < static_cast<int>(opaqueDrawOrder.size()); pos++)
+    {
+        int rank = pos;
+        if (ResourceHandle geometry = geometryOf(opaqueDrawOrder[pos]); geometry != InvalidResource)
+        {
+            auto [it, inserted] = firstPositions.try_emplace(geometry, pos);
+            rank = it->second;
+            shared = shared || !inserted;
+        }
+        ranked.emplace_back(rank, opaqueDrawOrder[pos]);
+    }
+
+    if (!shared)
+        return;
+
+    std::stable_sort(ranked.begin(), ranked.end(),
+                     [](const auto& a, const auto& b) { return a.first < b.first; });
+    for (std::size_t pos = 0; pos < ranked.size(); pos++)
+        opaqueDrawOrder[pos] = ranked[pos].second;
+}
+
+
 // Render an item from the render list
 void Renderer::renderItem(const RenderListEntry& rle,
                           const Observer& observer,
@@ -1480,12 +1517,46 @@ void Renderer::render(const Observer& observer,
                       float faintestMagNight,
                       const Selection& sel)
 {
+    CELESTIA_PROFILE_ZONE("Renderer::render");
+
     // Get the observer's time
     double now = observer.getTime();
     realTime = observer.getRealTime();
 
     frameCount++;
     settingsChanged = false;
+    m_shadowCones.clear();
+    updateLightingCache(now);
+
+    engine::FrameStats* frameStats = engine::GetFrameStats();
+    engine::FrameStageTimer stageTimer;
+    beginGPUTimer();
+    GPUStageTimer* gpuStageTimer = getGPUStageTimer();
+#ifdef CELESTIA_PROFILING
+    if (util::Profiler::isEnabled() && GPUProfiler::isSupported())
+    {
+        if (m_gpuProfiler == nullptr)
+            m_gpuProfiler = std::make_unique<GPUProfiler>();
+        m_gpuProfiler->beginFrame();
+    }
+#endif
+    CELESTIA_PROFILE_GPU_ZONE(m_gpuProfiler.get(), "Frame");
+
+    // Pick up the shaders compiled and the textures and models decoded since
+    // the last frame, once for all the views of a frame
+    if (!multiViewFrame.resourcesUpdated)
+    {
+        const auto* textureLoadStats = engine::GetTextureLoadStats();
+        auto textureLoads = textureLoadStats->getLoadCount();
+        auto textureBytes = textureLoadStats->getLoadedBytes();
+        shaderManager->update();
+        GetTextureManager()->update(TextureUploadBudget);
+        engine::GetGeometryManager()->update(GeometryCreateBudget);
+        frameStats->current().textureUploads += static_cast<std::uint32_t>(textureLoadStats->getLoadCount() - textureLoads);
+        frameStats->current().textureUploadBytes += textureLoadStats->getLoadedBytes() - textureBytes;
+        multiViewFrame.resourcesUpdated = multiViewFrame.active;
+    }
+    stageTimer.lap(engine::FrameStage::Resources);
 
     // Compute the size of a pixel
     float zoom = observer.getZoom();
@@ -1518,10 +1589,14 @@ void Renderer::render(const Observer& observer,
     m_modelMatrix = Affine3f(getCameraOrientationf()).matrix();
     m_MVPMatrix = m_projMatrix * m_modelMatrix;
 
+    m_pickBuffer = selectPickBuffer(observer);
+
     depthSortedAnnotations.clear();
     foregroundAnnotations.clear();
     backgroundAnnotations.clear();
     objectAnnotations.clear();
+    labelArena.reset();
+    labelLineCache.nextFrame();
 
     // Put all solar system bodies into the render list.  Stars close and
     // large enough to have discernible surface detail are also placed in
@@ -1532,10 +1607,13 @@ void Renderer::render(const Observer& observer,
     secondaryIlluminators.clear();
     nearStars.clear();
 
+    faintestMagNight += m_magnitudeOffset;
+
     // See if we want to use AutoMag.
     if (util::is_set(renderFlags, RenderFlags::ShowAutoMag))
     {
         autoMag(faintestMag, zoom);
+        faintestMag += m_magnitudeOffset;
     }
     else
     {
@@ -1550,6 +1628,7 @@ void Renderer::render(const Observer& observer,
     }
 
     setupSecondaryLightSources(secondaryIlluminators, lightSourceList);
+    setupPlanetshine();
 
     // Scan through the render list to see if we're inside a planetary
     // atmosphere.  If so, we need to adjust the sky color as well as the
@@ -1580,24 +1659,37 @@ void Renderer::render(const Observer& observer,
     satPoint = faintestMag - (1.0f - brightnessBias) / brightnessScale;
 
     ambientColor = Color(ambientLightLevel, ambientLightLevel, ambientLightLevel);
+    stageTimer.lap(engine::FrameStage::Lists);
+
+    reverseDepthFrame = beginReverseDepthFrame();
 
     glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
     // Render sky grids first--these will always be in the background
-    renderSkyGrids(observer);
+    {
+        GPUStageScope gpuStage(gpuStageTimer, engine::GPUStage::SkyGrids);
+        renderSkyGrids(observer);
+    }
+    stageTimer.lap(engine::FrameStage::Annotations);
 
     // Render deep sky objects
     if (util::is_set(renderFlags, RenderFlags::ShowDeepSpaceObjects) && universe.getDSOCatalog() != nullptr)
     {
+        CELESTIA_PROFILE_GPU_ZONE(m_gpuProfiler.get(), "Deep sky objects");
+        GPUStageScope gpuStage(gpuStageTimer, engine::GPUStage::DeepSky);
         renderDeepSkyObjects(universe, observer, faintestMag);
     }
+    stageTimer.lap(engine::FrameStage::DeepSky);
 
     // Render stars
     if (util::is_set(renderFlags, RenderFlags::ShowStars) && universe.getStarCatalog() != nullptr)
     {
-        renderPointStars(*universe.getStarCatalog(), faintestMag, observer);
+        CELESTIA_PROFILE_GPU_ZONE(m_gpuProfiler.get(), "Stars");
+        GPUStageScope gpuStage(gpuStageTimer, engine::GPUStage::Stars);
+        renderPointStars(*universe.getStarCatalog(), universe.getDSOCatalog(), faintestMag, observer);
     }
+    stageTimer.lap(engine::FrameStage::Stars);
 
     // Translate the camera before rendering the asterisms and boundaries
     // Set up the camera for star rendering; the units of this phase
@@ -1610,6 +1702,9 @@ void Renderer::render(const Observer& observer,
     Matrices asterismMVP = { &projection, &modelView };
 
     float dist = observerPosLY.norm() * 1.6e4f;
+    std::size_t gpuAnnotations = gpuStageTimer == nullptr
+        ? GPUStageTimer::InvalidInterval
+        : gpuStageTimer->begin(engine::GPUStage::Annotations);
     renderAsterisms(universe, dist, asterismMVP);
     renderBoundaries(universe, dist, asterismMVP);
 
@@ -1638,32 +1733,79 @@ void Renderer::render(const Observer& observer,
     // Render background markers; rendering of other markers is deferred until
     // solar system objects are rendered.
     renderBackgroundAnnotations(FontNormal);
+    if (gpuAnnotations != GPUStageTimer::InvalidInterval)
+        gpuStageTimer->end(gpuAnnotations);
 
     removeInvisibleItems(frustum);
+    if (m_pickBuffer != nullptr)
+        addRenderListPickTargets();
 
     // Sort the annotations
     sort(depthSortedAnnotations.begin(), depthSortedAnnotations.end());
 
     // Sort the orbit paths
     sort(orbitPathList.begin(), orbitPathList.end());
+    stageTimer.lap(engine::FrameStage::Annotations);
 
 #ifndef GL_ES
     glPolygonMode(GL_FRONT_AND_BACK, (GLenum) renderMode);
 #endif
 
+    frameStats->current().renderListSize += static_cast<std::uint32_t>(renderList.size());
     int nIntervals = buildDepthPartitions();
-    renderSolarSystemObjects(observer, nIntervals, now);
-
-    renderForegroundAnnotations(FontNormal);
+    frameStats->current().depthPartitions += static_cast<std::uint32_t>(nIntervals);
+    {
+        CELESTIA_PROFILE_GPU_ZONE(m_gpuProfiler.get(), "Solar system objects");
+        GPUStageScope gpuStage(gpuStageTimer, engine::GPUStage::SolarSystem);
+        renderSolarSystemObjects(observer, nIntervals, now);
+    }
+    stageTimer.lap(engine::FrameStage::SolarSystem);
 
-    if (showSelectionPointer && !selectionVisible && util::is_set(renderFlags, RenderFlags::ShowMarkers))
     {
-        renderSelectionPointer(observer, now, xfrustum, sel);
+        GPUStageScope gpuStage(gpuStageTimer, engine::GPUStage::Annotations);
+        renderForegroundAnnotations(FontNormal);
+
+        if (showSelectionPointer && !selectionVisible && util::is_set(renderFlags, RenderFlags::ShowMarkers))
+        {
+            renderSelectionPointer(observer, now, xfrustum, sel);
+        }
     }
 
 #ifndef GL_ES
     glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 #endif
+
+    if (reverseDepthFrame)
+    {
+        endReverseDepthFrame();
+        reverseDepthFrame = false;
+    }
+
+    if (m_gpuTimer != nullptr)
+        m_gpuTimer->end();
+    stageTimer.lap(engine::FrameStage::Annotations);
+}
+
+GPUStageTimer*
+Renderer::getGPUStageTimer()
+{
+    if (m_gpuStageTimer == nullptr && GPUStageTimer::isSupported())
+        m_gpuStageTimer = std::make_unique<GPUStageTimer>();
+    return m_gpuStageTimer.get();
+}
+
+void
+Renderer::beginGPUTimer()
+{
+    if (!GPUTimer::isSupported())
+        return;
+
+    if (m_gpuTimer == nullptr)
+        m_gpuTimer = std::make_unique<GPUTimer>();
+
+    if (auto elapsed = m_gpuTimer->collect(); elapsed.has_value())
+        engine::GetFrameStats()->addGPUTime(*elapsed);
+    m_gpuTimer->begin();
 }
 
 static Eigen::Vector3f
@@ -1773,11 +1915,10 @@ void Renderer::renderObjectAsPoint(const Vector3f& position,
         ps.depthTest = true;
         setPipelineState(ps);
 
-        if (starStyle != StarStyle::PointStars)
-            gaussianDiscTex->bind();
+        starPSFTex->bind();
 
         if (pointSize > gl::maxPointSize)
-            m_largeStarRenderer->render(position, {color, alpha}, pointSize, mvp);
+            m_largeStarRenderer->render(position, {color, alpha}, pointSize, StarPSF::Disc, mvp);
         else
             pointStarVertexBuffer->addStar(position, {color, alpha}, pointSize);
 
@@ -1790,9 +1931,8 @@ void Renderer::renderObjectAsPoint(const Vector3f& position,
         if (useHalos && glareAlpha > 0.0f)
         {
             Eigen::Vector3f center = calculateQuadCenter(getCameraOrientationf(), position, radius);
-            gaussianGlareTex->bind();
             if (glareSize > gl::maxPointSize)
-                m_largeStarRenderer->render(center, {color, glareAlpha}, glareSize, mvp);
+                m_largeStarRenderer->render(center, {color, glareAlpha}, glareSize, StarPSF::Glare, mvp);
             else
                 glareVertexBuffer->addStar(center, {color, glareAlpha}, glareSize);
         }
@@ -1983,7 +2123,8 @@ Renderer::locationsToAnnotations(const Body& body,
                             labelColor,
                             labelPos.cast<float>(),
                             LabelHorizontalAlignment::Start,
-                            LabelVerticalAlignment::Bottom);
+                            LabelVerticalAlignment::Bottom,
+                            -effSize);
     }
 }
 
@@ -2034,9 +2175,134 @@ estimateReflectedLightFraction(const Vector3d& toSun,
 }
 
 
+// Find the brightest source of planetshine for an object, among the
+// secondary illuminators of its star system.
+static Planetshine
+findPlanetshine(const Body& body,
+                const Vector3f& objPosition_eye,
+                const SecondaryIlluminator* first,
+                const SecondaryIlluminator* last,
+                const vector<LightSource>& suns)
+{
+    Planetshine planetshine;
+    if (suns.empty())
+        return planetshine;
+
+    Vector3d objpos = objPosition_eye.cast<double>();
+    for (const SecondaryIlluminator* illuminator = first; illuminator != last; ++illuminator)
+    {
+        if (illuminator->body == &body)
+            continue;
+
+        Vector3d toIllum = illuminator->position_v - objpos;  // reflector-to-object vector
+        float distSquared = (float) toIllum.squaredNorm() / math::square(illuminator->radius);
+
+        if (distSquared > 0.01f)
+        {
+            // Irradiance falls off with distance^2
+            float irr = illuminator->reflectedIrradiance / distSquared;
+
+            // Phase effects will always leave the irradiance unaffected or reduce it;
+            // don't bother calculating them if we've already found a brighter secondary
+            // source.
+            if (irr > planetshine.irradiance)
+            {
+                // Account for the phase
+                Vector3d toSun = objpos - suns[0].position;
+                irr *= estimateReflectedLightFraction(toSun, toIllum, illuminator->radius);
+                if (irr > planetshine.irradiance)
+                {
+                    planetshine.irradiance = irr;
+                    planetshine.source = illuminator;
+                }
+            }
+        }
+    }
+
+#if DEBUG_SECONDARY_ILLUMINATION
+    if (planetshine.source != nullptr)
+    {
+        clog << "maxIrr = " << planetshine.irradiance << ", "
+             << planetshine.source->body->getName() << ", "
+             << planetshine.source->reflectedIrradiance << endl;
+    }
+#endif
+
+    return planetshine;
+}
+
+
+static const Star*
+getSystemStar(const Body* body)
+{
+    const PlanetarySystem* system = body->getSystem();
+    return system == nullptr ? nullptr : system->getStar();
+}
+
+
+// Planetshine pass: sort the secondary illuminators by star system, then
+// find the source of planetshine of the bodies of the render list which are
+// large enough to be drawn as meshes. Only the illuminators of the same
+// system are considered for a body.
+void
+Renderer::setupPlanetshine()
+{
+    planetshine.clear();
+
+    std::sort(secondaryIlluminators.begin(), secondaryIlluminators.end(),
+              [](const SecondaryIlluminator& a, const SecondaryIlluminator& b)
+              {
+                  return std::less<const Star*>()(getSystemStar(a.body), getSystemStar(b.body));
+              });
+
+    for (const RenderListEntry& rle : renderList)
+    {
+        if (rle.renderableType != RenderListEntry::RenderableBody || rle.discSizeInPixels <= 1.0f)
+            continue;
+
+        planetshine.emplace_back(rle.body, computePlanetshine(*rle.body, rle.position));
+    }
+
+    std::sort(planetshine.begin(), planetshine.end(),
+              [](const auto& a, const auto& b) { return std::less<const Body*>()(a.first, b.first); });
+}
+
+
+Planetshine
+Renderer::computePlanetshine(const Body& body, const Vector3f& pos) const
+{
+    const Star* star = getSystemStar(&body);
+    auto first = std::lower_bound(secondaryIlluminators.begin(), secondaryIlluminators.end(), star,
+                                  [](const SecondaryIlluminator& illuminator, const Star* s)
+                                  { return std::less<const Star*>()(getSystemStar(illuminator.body), s); });
+    auto last = std::upper_bound(first, secondaryIlluminators.end(), star,
+                                 [](const Star* s, const SecondaryIlluminator& illuminator)
+                                 { return std::less<const Star*>()(s, getSystemStar(illuminator.body)); });
+    const SecondaryIlluminator* base = secondaryIlluminators.data();
+    return findPlanetshine(body, pos,
+                           base + (first - secondaryIlluminators.begin()),
+                           base + (last - secondaryIlluminators.begin()),
+                           lightSourceList);
+}
+
+
+Planetshine
+Renderer::getPlanetshine(const Body& body, const Vector3f& pos) const
+{
+    auto it = std::lower_bound(planetshine.begin(), planetshine.end(), &body,
+                               [](const auto& entry, const Body* b) { return std::less<const Body*>()(entry.first, b); });
+    if (it != planetshine.end() && it->first == &body)
+        return it->second;
+
+    // Bodies which weren't large enough to be drawn when the render list
+    // was built
+    return computePlanetshine(body, pos);
+}
+
+
 static void
 setupObjectLighting(const vector<LightSource>& suns,
-                    const vector<SecondaryIlluminator>& secondaryIlluminators,
+                    const Planetshine& planetshine,
                     const Quaternionf& objOrientation,
                     const Vector3f& objScale,
                     const Vector3f& objPosition_eye,
@@ -2064,62 +2330,22 @@ setupObjectLighting(const vector<LightSource>& suns,
         ls.lights[i].position = dir;
         ls.lights[i].apparentSize = (float) (suns[i].radius / dir.norm());
         ls.lights[i].castsShadows = true;
+        ls.lights[i].sourceIndex = i;
     }
 
     // Include effects of secondary illumination (i.e. planetshine)
-    if (!secondaryIlluminators.empty() && i < MaxLights - 1)
+    if (planetshine.source != nullptr && i < MaxLights - 1)
     {
-        float maxIrr = 0.0f;
-        unsigned int maxIrrSource = 0, counter = 0;
-        Vector3d objpos = objPosition_eye.cast<double>();
-
-        // Only account for light from the brightest secondary source
-        for (auto& illuminator : secondaryIlluminators)
-        {
-            Vector3d toIllum = illuminator.position_v - objpos;  // reflector-to-object vector
-            float distSquared = (float) toIllum.squaredNorm() / math::square(illuminator.radius);
-
-            if (distSquared > 0.01f)
-            {
-                // Irradiance falls off with distance^2
-                float irr = illuminator.reflectedIrradiance / distSquared;
-
-                // Phase effects will always leave the irradiance unaffected or reduce it;
-                // don't bother calculating them if we've already found a brighter secondary
-                // source.
-                if (irr > maxIrr)
-                {
-                    // Account for the phase
-                    Vector3d toSun = objpos - suns[0].position;
-                    irr *= estimateReflectedLightFraction(toSun, toIllum, illuminator.radius);
-                    if (irr > maxIrr)
-                    {
-                        maxIrr = irr;
-                        maxIrrSource = counter;
-                    }
-                }
-            }
-            counter++;
-        }
-#if DEBUG_SECONDARY_ILLUMINATION
-        clog << "maxIrr = " << maxIrr << ", "
-             << secondaryIlluminators[maxIrrSource].body->getName() << ", "
-             << secondaryIlluminators[maxIrrSource].reflectedIrradiance << endl;
-#endif
-
-        if (maxIrr > 0.0f)
-        {
-            Vector3d toIllum = secondaryIlluminators[maxIrrSource].position_v - objpos;
-
-            ls.lights[i].direction_eye = toIllum.cast<float>();
-            ls.lights[i].direction_eye.normalize();
-            ls.lights[i].irradiance = maxIrr;
-            ls.lights[i].color = secondaryIlluminators[maxIrrSource].body->getSurface().color;
-            ls.lights[i].apparentSize = 0.0f;
-            ls.lights[i].castsShadows = false;
-            i++;
-            nLights++;
-        }
+        Vector3d toIllum = planetshine.source->position_v - objPosition_eye.cast<double>();
+
+        ls.lights[i].direction_eye = toIllum.cast<float>();
+        ls.lights[i].direction_eye.normalize();
+        ls.lights[i].irradiance = planetshine.irradiance;
+        ls.lights[i].color = planetshine.source->body->getSurface().color;
+        ls.lights[i].apparentSize = 0.0f;
+        ls.lights[i].castsShadows = false;
+        i++;
+        nLights++;
     }
 
     // Sort light sources by brightness.  Light zero should always be the
@@ -2283,6 +2509,7 @@ void Renderer::renderObject(const Vector3f& pos,
     ri.orientation = getCameraOrientationf() * obj.orientation.conjugate();
 
     ri.pixWidth = discSizeInPixels;
+    ri.geometryPixelScale = geometryScale / (max(nearPlaneDistance, altitude) * pixelSize);
 
     // Set up the colors
     if (ri.baseTex == nullptr ||
@@ -2396,6 +2623,11 @@ void Renderer::renderObject(const Vector3f& pos,
         {
             ResourceHandle texOverride = obj.surface->baseTexture.texture(textureResolution);
 
+            // Models skip their parts outside the frustum in the coordinates
+            // of the geometry
+            auto modelFrustum = projectionMode->getFrustum(nearPlaneDistance, farPlaneDistance, observer.getZoom());
+            modelFrustum.transform(Matrix4f(planetMV.inverse()));
+
             if (lit)
             {
                 renderGeometry_GLSL(geometry,
@@ -2406,6 +2638,7 @@ void Renderer::renderObject(const Vector3f& pos,
                                     geometryScale,
                                     renderFlags,
                                     obj.orientation,
+                                    modelFrustum,
                                     astro::daysToSecs(now - astro::J2000),
                                     planetMVP, this);
             }
@@ -2417,6 +2650,7 @@ void Renderer::renderObject(const Vector3f& pos,
                                           geometryScale,
                                           renderFlags,
                                           obj.orientation,
+                                          modelFrustum,
                                           astro::daysToSecs(now - astro::J2000),
                                           planetMVP, this);
             }
@@ -2561,28 +2795,132 @@ void Renderer::renderObject(const Vector3f& pos,
 }
 
 
-bool Renderer::testEclipse(const Body& receiver,
-                           const Body& caster,
-                           LightingState& lightingState,
-                           unsigned int lightIndex,
-                           double now)
+bool
+Renderer::isShadowCaster(const Body& body, double now) const
 {
-    bool isReceiverShadowed = false;
-
-    // Ignore situations where the shadow casting body is much smaller than
-    // the receiver, as these shadows aren't likely to be relevant.  Also,
-    // ignore eclipses where the caster is not an ellipsoid, since we can't
+    // Ignore eclipses where the caster is not an ellipsoid, since we can't
     // generate correct shadows in this case.
-    if (caster.getRadius() >= receiver.getRadius() * MinRelativeOccluderRadius &&
-        caster.hasVisibleGeometry() &&
-        util::is_set(caster.getClassification(), bodyVisibilityMask) &&
-        caster.extant(now) &&
-        caster.isEllipsoid())
-    {
-        const DirectionalLight& light = lightingState.lights[lightIndex];
-        LightingState::EclipseShadowVector& shadows = *lightingState.shadows[lightIndex];
+    return body.hasVisibleGeometry() &&
+           util::is_set(body.getClassification(), bodyVisibilityMask) &&
+           body.extant(now) &&
+           body.isEllipsoid();
+}
 
-        // All of the eclipse related code assumes that both the caster
+
+const engine::ShadowConeSet&
+Renderer::getShadowCones(const PlanetarySystem& system,
+                         unsigned int sourceIndex,
+                         const Vector3d& lightPosition,
+                         double now)
+{
+    auto key = std::make_pair(&system, sourceIndex);
+    if (auto it = m_shadowCones.find(key); it != m_shadowCones.end())
+        return it->second;
+
+    // The positions of the casters are computed once per frame, for all the
+    // receivers of the system
+    std::vector<engine::ShadowCone> cones;
+    int nBodies = system.getSystemSize();
+    for (int i = 0; i < nBodies; i++)
+    {
+        const Body* body = system.getBody(i);
+        if (isShadowCaster(*body, now))
+            cones.emplace_back(*body, lightPosition, now);
+    }
+
+    return m_shadowCones.try_emplace(key, std::move(cones), lightPosition).first->second;
+}
+
+
+void
+Renderer::updateLightingCache(double now)
+{
+    // Shadows of the bodies drawn at the time of the cache are only valid at
+    // that time: drop all of them on any change of the time, including the
+    // jumps, or of the settings deciding which shadows are drawn.
+    if (m_lightingCacheTime != now ||
+        m_lightingCacheFlags != renderFlags ||
+        m_lightingCacheMask != bodyVisibilityMask)
+    {
+        m_lightingCache.clear();
+        m_lightingCacheTime = now;
+        m_lightingCacheFlags = renderFlags;
+        m_lightingCacheMask = bodyVisibilityMask;
+        return;
+    }
+
+    // Forget the bodies which are no longer drawn
+    constexpr std::uint32_t MaxUnusedFrames = 16;
+    for (auto it = m_lightingCache.begin(); it != m_lightingCache.end();)
+    {
+        if (frameCount - it->second.lastUsed > MaxUnusedFrames)
+            it = m_lightingCache.erase(it);
+        else
+            ++it;
+    }
+}
+
+
+bool
+Renderer::restoreShadows(const Body& body, LightingState& lightingState)
+{
+    auto it = m_lightingCache.find(&body);
+    if (it == m_lightingCache.end())
+        return false;
+
+    LightingCacheEntry& entry = it->second;
+    if (entry.nLights != lightingState.nLights)
+        return false;
+    for (unsigned int li = 0; li < lightingState.nLights; li++)
+    {
+        const DirectionalLight& light = lightingState.lights[li];
+        if (entry.castsShadows[li] != light.castsShadows ||
+            (light.castsShadows && entry.sourceIndices[li] != light.sourceIndex))
+            return false;
+    }
+
+    entry.lastUsed = frameCount;
+    for (unsigned int li = 0; li < lightingState.nLights; li++)
+    {
+        eclipseShadows[li] = entry.shadows[li];
+        lightingState.ringShadows[li] = entry.ringShadows[li];
+    }
+    return true;
+}
+
+
+void
+Renderer::storeShadows(const Body& body, const LightingState& lightingState)
+{
+    LightingCacheEntry& entry = m_lightingCache[&body];
+    entry.lastUsed = frameCount;
+    entry.nLights = lightingState.nLights;
+    for (unsigned int li = 0; li < lightingState.nLights; li++)
+    {
+        entry.sourceIndices[li] = lightingState.lights[li].sourceIndex;
+        entry.castsShadows[li] = lightingState.lights[li].castsShadows;
+        entry.shadows[li] = *lightingState.shadows[li];
+        entry.ringShadows[li] = lightingState.ringShadows[li];
+    }
+}
+
+
+bool Renderer::testEclipse(const Body& receiver,
+                           const Vector3d& posReceiver,
+                           const engine::ShadowCone& caster,
+                           LightingState& lightingState,
+                           unsigned int lightIndex) const
+{
+    bool isReceiverShadowed = false;
+
+    // Ignore situations where the shadow casting body is much smaller than
+    // the receiver, as these shadows aren't likely to be relevant.
+    if (caster.radius >= receiver.getRadius() * MinRelativeOccluderRadius)
+    {
+        const DirectionalLight& light = lightingState.lights[lightIndex];
+        LightingState::EclipseShadowVector& shadows = *lightingState.shadows[lightIndex];
+
+        // All of the eclipse related code assumes that both the caster
         // and receiver are spherical.  Irregular receivers will work more
         // or less correctly, but casters that are sufficiently non-spherical
         // will produce obviously incorrect shadows.  Another assumption we
@@ -2590,25 +2928,20 @@ bool Renderer::testEclipse(const Body& receiver,
         // less than the distance between the sun and the receiver.  This
         // approximation works everywhere in the solar system, and is likely
         // valid for any orbitally stable pair of objects orbiting a star.
-        Vector3d posReceiver = receiver.getAstrocentricPosition(now);
-        Vector3d posCaster = caster.getAstrocentricPosition(now);
+        const Vector3d& posCaster = caster.position;
+        float casterRadius = static_cast<float>(caster.radius);
 
-        //const Star* sun = receiver.getSystem()->getStar();
-        //assert(sun != nullptr);
-        //double distToSun = posReceiver.distanceFromOrigin();
-        //float appSunRadius = (float) (sun->getRadius() / distToSun);
         float appSunRadius = light.apparentSize;
 
         Vector3d dir = posCaster - posReceiver;
         double distToCaster = dir.norm() - receiver.getRadius();
-        float appOccluderRadius = (float) (caster.getRadius() / distToCaster);
+        float appOccluderRadius = (float) (casterRadius / distToCaster);
 
         // The shadow radius is the radius of the occluder plus some additional
         // amount that depends upon the apparent radius of the sun.  For
         // a sun that's distant/small and effectively a point, the shadow
         // radius will be the same as the radius of the occluder.
-        float shadowRadius = (1 + appSunRadius / appOccluderRadius) *
-            caster.getRadius();
+        float shadowRadius = (1 + appSunRadius / appOccluderRadius) * casterRadius;
 
         // Test whether a shadow is cast on the receiver.  We want to know
         // if the receiver lies within the shadow volume of the caster.  Since
@@ -2645,10 +2978,10 @@ bool Renderer::testEclipse(const Body& receiver,
             // umbra radius is the radius of the shadow region with constant depth:
             // for total eclipses, this area is actually the umbra, with a depth of
             // 1. For annular eclipses and transits, it is less than 1.
-            shadow.umbraRadius = caster.getRadius() *
+            shadow.umbraRadius = casterRadius *
                 (appOccluderRadius - appSunRadius) / appOccluderRadius;
             shadow.maxDepth = std::min(1.0f, math::square(appOccluderRadius / appSunRadius));
-            shadow.caster = &caster;
+            shadow.caster = caster.caster;
 
             // Ignore transits that don't produce a visible shadow.
             if (shadow.maxDepth > 1.0f / 256.0f)
@@ -2659,8 +2992,7 @@ bool Renderer::testEclipse(const Body& receiver,
 
         // If the caster has a ring system, see if it casts a shadow on the receiver.
         // Ring shadows are only supported in the OpenGL 2.0 path.
-        const BodyFeaturesManager* bodyFeaturesManager = GetBodyFeaturesManager();
-        if (auto rings = bodyFeaturesManager->getRings(&caster); rings != nullptr)
+        if (auto rings = caster.rings; rings != nullptr)
         {
             bool shadowed = false;
 
@@ -2669,7 +3001,7 @@ bool Renderer::testEclipse(const Body& receiver,
             {
                 // Possible intersection, but it depends on the orientation of the
                 // rings.
-                Quaterniond casterOrientation = caster.getOrientation(now);
+                const Quaterniond& casterOrientation = caster.getOrientation();
                 Vector3d ringPlaneNormal = casterOrientation * Vector3d::UnitY();
                 Vector3d shadowDirection = lightToCasterDir.normalized();
                 Vector3d v = ringPlaneNormal.cross(shadowDirection);
@@ -2773,7 +3105,7 @@ void Renderer::renderPlanet(Body& body,
 
         LightingState lights;
         setupObjectLighting(lightSourceList,
-                            secondaryIlluminators,
+                            getPlanetshine(body, pos),
                             rp.orientation,
                             scaleFactors,
                             pos,
@@ -2791,74 +3123,78 @@ void Renderer::renderPlanet(Body& body,
         }
 
 
-        // Add ring shadow records for each light
-        if (rp.rings != nullptr &&
-            util::is_set(renderFlags, RenderFlags::ShowPlanetRings) &&
-            util::is_set(renderFlags, RenderFlags::ShowRingShadows))
+        // The shadows only depend on the time, so they are computed once for
+        // all the views and all the frames drawn at that time
+        if (restoreShadows(body, lights))
         {
-            for (unsigned int li = 0; li < lights.nLights; li++)
-            {
-                lights.ringShadows[li].ringSystem = rp.rings;
-                lights.ringShadows[li].casterOrientation = q.cast<float>();
-                lights.ringShadows[li].origin = Vector3f::Zero();
-                lights.ringShadows[li].direction = -lights.lights[li].position.normalized().cast<float>();
-            }
+            ++engine::GetFrameStats()->current().lightingReused;
         }
-
-        // Calculate eclipse circumstances
-        if (util::is_set(renderFlags, RenderFlags::ShowEclipseShadows) && body.getSystem() != nullptr)
+        else
         {
-            if (const auto *system = body.getSystem(); system->getPrimaryBody() == nullptr)
+            // Add ring shadow records for each light
+            if (rp.rings != nullptr &&
+                util::is_set(renderFlags, RenderFlags::ShowPlanetRings) &&
+                util::is_set(renderFlags, RenderFlags::ShowRingShadows))
             {
-                // The body is a planet.  Check for eclipse shadows
-                // from all of its satellites.
-                if (const auto *satellites = body.getSatellites(); satellites != nullptr)
+                for (unsigned int li = 0; li < lights.nLights; li++)
                 {
-                    int nSatellites = satellites->getSystemSize();
-                    for (unsigned int li = 0; li < lights.nLights; li++)
-                    {
-                        if (lights.lights[li].castsShadows)
-                        {
-                            for (int i = 0; i < nSatellites; i++)
-                            {
-                                testEclipse(body, *satellites->getBody(i), lights, li, now);
-                            }
-                        }
-                    }
+                    lights.ringShadows[li].ringSystem = rp.rings;
+                    lights.ringShadows[li].casterOrientation = q.cast<float>();
+                    lights.ringShadows[li].origin = Vector3f::Zero();
+                    lights.ringShadows[li].direction = -lights.lights[li].position.normalized().cast<float>();
                 }
             }
-            else
+
+            // Calculate eclipse circumstances
+            if (util::is_set(renderFlags, RenderFlags::ShowEclipseShadows) && body.getSystem() != nullptr)
             {
+                // A planet is shadowed by its satellites. A moon is shadowed by
+                // the parent planet and the other satellites in its system;
+                // traverse up the hierarchy so that any parent objects of the
+                // parent are also considered (TODO: their child objects will not
+                // be checked for shadows.)
+                const auto *system = body.getSystem();
+                const PlanetarySystem *casters = system->getPrimaryBody() == nullptr
+                                               ? body.getSatellites()
+                                               : system;
+                Vector3d posReceiver = body.getRenderAstrocentricPosition(now);
+
                 for (unsigned int li = 0; li < lights.nLights; li++)
                 {
-                    if (lights.lights[li].castsShadows)
+                    if (!lights.lights[li].castsShadows)
+                        continue;
+
+                    Vector3d lightPosition = posReceiver + lights.lights[li].position;
+                    if (system->getPrimaryBody() != nullptr)
                     {
-                        // The body is a moon.  Check for eclipse shadows from
-                        // the parent planet and all satellites in the system.
-                        // Traverse up the hierarchy so that any parent objects
-                        // of the parent are also considered (TODO: their child
-                        // objects will not be checked for shadows.)
-                        const Body* planet = system->getPrimaryBody();
-                        while (planet != nullptr)
+                        for (const Body* planet = system->getPrimaryBody(); planet != nullptr;)
                         {
-                            testEclipse(body, *planet, lights, li, now);
+                            if (isShadowCaster(*planet, now))
+                                testEclipse(body, posReceiver, engine::ShadowCone(*planet, lightPosition, now), lights, li);
+
                             if (planet->getSystem() != nullptr)
                                 planet = planet->getSystem()->getPrimaryBody();
                             else
                                 planet = nullptr;
                         }
+                    }
 
-                        int nSatellites = system->getSystemSize();
-                        for (int i = 0; i < nSatellites; i++)
+                    // Only the casters whose shadows may reach the body get the
+                    // exact test
+                    if (casters != nullptr)
+                    {
+                        const auto &cones = getShadowCones(*casters, lights.lights[li].sourceIndex, lightPosition, now);
+                        for (const auto &cone : cones.candidates(posReceiver, body.getRadius(), lights.lights[li].apparentSize))
                         {
-                            if (system->getBody(i) != &body)
-                            {
-                                testEclipse(body, *system->getBody(i), lights, li, now);
-                            }
+                            if (cone.caster != &body)
+                                testEclipse(body, posReceiver, cone, lights, li);
                         }
                     }
                 }
             }
+
+            storeShadows(body, lights);
+            ++engine::GetFrameStats()->current().lightingComputed;
         }
 
         // Sort out the ring shadows; only one ring shadow source is supported right now. This means
@@ -2958,7 +3294,7 @@ void Renderer::renderPlanet(Body& body,
 
             // We need a double precision body-relative position of the
             // observer, otherwise location labels will tend to jitter.
-            Vector3d posd = body.getPosition(observer.getTime()).offsetFromKm(observer.getPosition());
+            Vector3d posd = body.getRenderPosition(observer.getTime()).offsetFromKm(observer.getPosition());
             locationsToAnnotations(body, posd, q);
         }
     }
@@ -3269,83 +3605,239 @@ void Renderer::addRenderListEntries(RenderListEntry& rle,
 }
 
 
+// Render list culling state which is the same for all bodies of a frame
+// tree traversal
+struct Renderer::RenderListParameters
+{
+    Vector3d astrocentricObserverPos;
+    const math::InfiniteFrustum& viewFrustum;
+    Vector3d viewPlaneNormal;
+    Vector3f viewMatZ;
+    double invCosViewAngle;
+    double sinViewAngle;
+    BodyClassification labelClassMask;
+    double now;
+};
+
+namespace
+{
+
+// Frame tree levels with at least this many children are culled in
+// parallel, in chunks of RenderListChunkSize phases.
+constexpr unsigned int ParallelRenderListThreshold = 2048;
+constexpr unsigned int RenderListChunkSize = 512;
+static_assert(RenderListChunkSize % FrameTree::BoundsGroupSize == 0,
+              "chunks must hold whole bounds groups");
+
+// Positions of phases which pass this test can be computed on a worker
+// thread; this covers the large asteroid and comet catalogs. Others, such as
+// scripted or SPICE orbits, and frames which depend on other bodies, are
+// evaluated on the render thread.
+bool
+isThreadSafePhase(const TimelinePhase* phase)
+{
+    return phase->orbit()->isThreadSafe() && phase->orbitFrame()->isThreadSafe();
+}
+
+} // end unnamed namespace
+
 void Renderer::buildRenderLists(const Vector3d& astrocentricObserverPos,
                                 const math::InfiniteFrustum& viewFrustum,
                                 const Vector3d& viewPlaneNormal,
-                                const Vector3d& frameCenter,
                                 const FrameTree* tree,
-                                const Observer& observer,
                                 double now)
 {
-    BodyClassification labelClassMask = translateLabelModeToClassMask(labelMode);
-
     Matrix3f viewMat = getCameraOrientationf().toRotationMatrix();
-    Vector3f viewMatZ = viewMat.row(2);
-    double invCosViewAngle = 1.0 / cosViewConeAngle;
-    double sinViewAngle = sqrt(1.0 - math::square(cosViewConeAngle));
 
+    RenderListParameters params
+    {
+        astrocentricObserverPos,
+        viewFrustum,
+        viewPlaneNormal,
+        viewMat.row(2),
+        1.0 / cosViewConeAngle,
+        sqrt(1.0 - math::square(cosViewConeAngle)),
+        translateLabelModeToClassMask(labelMode),
+        now,
+    };
+
+    buildRenderLists(params, tree);
+}
+
+
+void Renderer::buildRenderLists(const RenderListParameters& params,
+                                const FrameTree* tree)
+{
     unsigned int nChildren = tree != nullptr ? tree->childCount() : 0;
-    for (unsigned int i = 0; i < nChildren; i++)
+    RenderListCandidates candidates;
+
+    // Groups of children whose bounds are outside the view cone are skipped
+    // whole; the test is the one applied to each body in cullRenderListPhase
+    util::array_view<FrameTree::BoundsGroup> groups;
+    if (tree != nullptr)
+        groups = tree->getBoundsGroups(params.now);
+    auto isGroupCulled = [&params, &groups](unsigned int i)
     {
-        const TimelinePhase* phase = tree->getChild(i);
+        if (groups.empty())
+            return false;
+
+        const FrameTree::BoundsGroup& group = groups[i / FrameTree::BoundsGroupSize];
+        if (group.radius < 0.0)
+            return true;
+        // Secondary illuminators may light bodies in view from outside it
+        if (group.containsSecondaryIlluminators)
+            return false;
+
+        Vector3d pos_v = group.center - params.astrocentricObserverPos;
+        double dist_vn = params.viewPlaneNormal.dot(pos_v);
+        if (dist_vn <= -group.radius)
+            return true;
+
+        double maxPerpDist = (group.radius + dist_vn * params.sinViewAngle) * params.invCosViewAngle;
+        return (pos_v - dist_vn * params.viewPlaneNormal).squaredNorm() >= maxPerpDist * maxPerpDist;
+    };
 
-        // No need to do anything if the phase isn't active now
-        if (!phase->includes(now))
-            continue;
+    if (nChildren >= ParallelRenderListThreshold)
+    {
+        // Each chunk collects its candidates separately; they are merged in
+        // chunk order so the result doesn't depend on scheduling.
+        struct ChunkResult
+        {
+            RenderListCandidates candidates;
+            std::vector<const TimelinePhase*> serialPhases;
+        };
 
-        Body* body = phase->body();
+        std::vector<ChunkResult> chunks((nChildren + RenderListChunkSize - 1) / RenderListChunkSize);
+        util::GetThreadPool()->parallelFor(chunks.size(), [&](std::size_t chunkIdx)
+        {
+            ChunkResult& chunk = chunks[chunkIdx];
+            auto first = static_cast<unsigned int>(chunkIdx) * RenderListChunkSize;
+            auto last = std::min(first + RenderListChunkSize, nChildren);
+            for (unsigned int i = first; i < last; i++)
+            {
+                if (i % FrameTree::BoundsGroupSize == 0 && isGroupCulled(i))
+                {
+                    i += FrameTree::BoundsGroupSize - 1;
+                    continue;
+                }
 
-        // pos_s: sun-relative position of object
-        // pos_v: viewer-relative position of object
+                const TimelinePhase* phase = tree->getChild(i);
+                if (!phase->includes(params.now))
+                    continue;
 
-        // Get the position of the body relative to the sun.
-        Vector3d p = phase->orbit()->positionAtTime(now);
-        Vector3d pos_s = frameCenter + phase->orbitFrame()->getOrientation(now).conjugate() * p;
+                if (isThreadSafePhase(phase))
+                    cullRenderListPhase(params, phase, chunk.candidates);
+                else
+                    chunk.serialPhases.push_back(phase);
+            }
+        });
 
-        // We now have the positions of the observer and the planet relative
-        // to the sun.  From these, compute the position of the body
-        // relative to the observer.
-        Vector3d pos_v = pos_s - astrocentricObserverPos;
+        for (ChunkResult& chunk : chunks)
+        {
+            for (const TimelinePhase* phase : chunk.serialPhases)
+                cullRenderListPhase(params, phase, chunk.candidates);
+
+            candidates.append(chunk.candidates);
+        }
+    }
+    else
+    {
+        for (unsigned int i = 0; i < nChildren; i++)
+        {
+            if (i % FrameTree::BoundsGroupSize == 0 && isGroupCulled(i))
+            {
+                i += FrameTree::BoundsGroupSize - 1;
+                continue;
+            }
+
+            const TimelinePhase* phase = tree->getChild(i);
+
+            // No need to do anything if the phase isn't active now
+            if (phase->includes(params.now))
+                cullRenderListPhase(params, phase, candidates);
+        }
+    }
+
+    // Geometry lookups may load resources, so the entries are completed
+    // here rather than in cullRenderListPhase.
+    for (RenderListCandidates::Entry& entry : candidates.entries)
+        addRenderListEntries(entry.rle, *entry.rle.body, entry.isLabeled);
+
+    secondaryIlluminators.insert(secondaryIlluminators.end(),
+                                 candidates.secondaryIlluminators.begin(),
+                                 candidates.secondaryIlluminators.end());
+
+    for (const RenderListCandidates::Subtree& subtree : candidates.subtrees)
+        buildRenderLists(params, subtree.tree);
+}
+
+
+void
+Renderer::RenderListCandidates::append(const RenderListCandidates& other)
+{
+    entries.insert(entries.end(), other.entries.begin(), other.entries.end());
+    secondaryIlluminators.insert(secondaryIlluminators.end(),
+                                 other.secondaryIlluminators.begin(),
+                                 other.secondaryIlluminators.end());
+    subtrees.insert(subtrees.end(), other.subtrees.begin(), other.subtrees.end());
+}
+
+
+// Apply the visibility tests to a body and its subtree. This only reads
+// renderer state, so it may be called from several threads at once for
+// phases which pass isThreadSafePhase.
+void Renderer::cullRenderListPhase(const RenderListParameters& params,
+                                   const TimelinePhase* phase,
+                                   RenderListCandidates& candidates) const
+{
+    Body* body = phase->body();
+
+    // pos_s: sun-relative position of object
+    // pos_v: viewer-relative position of object
 
-        // dist_vn: distance along view normal from the viewer to the
-        // projection of the object's center.
-        double dist_vn = viewPlaneNormal.dot(pos_v);
+    // Get the position of the body relative to the sun, as stored by
+    // FrameTree::updateBodyStates at the start of the frame.
+    Vector3d pos_s = body->getRenderAstrocentricPosition(params.now);
 
-        // Vector from object center to its projection on the view normal.
-        Vector3d toViewNormal = pos_v - dist_vn * viewPlaneNormal;
+    // We now have the positions of the observer and the planet relative
+    // to the sun.  From these, compute the position of the body
+    // relative to the observer.
+    Vector3d pos_v = pos_s - params.astrocentricObserverPos;
 
-        float cullingRadius = body->getCullingRadius();
+    // dist_vn: distance along view normal from the viewer to the
+    // projection of the object's center.
+    double dist_vn = params.viewPlaneNormal.dot(pos_v);
 
-        // The result of the planetshine test can be reused for the view cone
-        // test, but only when the object's light influence sphere is larger
-        // than the geometry. This is not
-        bool viewConeTestFailed = false;
-        if (body->isSecondaryIlluminator())
+    // Vector from object center to its projection on the view normal.
+    Vector3d toViewNormal = pos_v - dist_vn * params.viewPlaneNormal;
+
+    float cullingRadius = body->getCullingRadius();
+
+    // The result of the planetshine test can be reused for the view cone
+    // test, but only when the object's light influence sphere is larger
+    // than the geometry. This is not
+    bool viewConeTestFailed = false;
+    if (body->isSecondaryIlluminator())
+    {
+        float influenceRadius = body->getBoundingRadius() + (body->getRadius() * PLANETSHINE_DISTANCE_LIMIT_FACTOR);
+        if (dist_vn > -influenceRadius)
         {
-            float influenceRadius = body->getBoundingRadius() + (body->getRadius() * PLANETSHINE_DISTANCE_LIMIT_FACTOR);
-            if (dist_vn > -influenceRadius)
+            double maxPerpDist = (influenceRadius + dist_vn * params.sinViewAngle) * params.invCosViewAngle;
+            double perpDistSq = toViewNormal.squaredNorm();
+            if (perpDistSq < maxPerpDist * maxPerpDist)
             {
-                double maxPerpDist = (influenceRadius + dist_vn * sinViewAngle) * invCosViewAngle;
-                double perpDistSq = toViewNormal.squaredNorm();
-                if (perpDistSq < maxPerpDist * maxPerpDist)
+                if ((body->getRadius() / (float) pos_v.norm()) / pixelSize > PLANETSHINE_PIXEL_SIZE_LIMIT)
                 {
-                    if ((body->getRadius() / (float) pos_v.norm()) / pixelSize > PLANETSHINE_PIXEL_SIZE_LIMIT)
-                    {
-                        // add to planetshine list if larger than 1/10 pixel
+                    // add to planetshine list if larger than 1/10 pixel
 #if DEBUG_SECONDARY_ILLUMINATION
-                        clog << "Planetshine: " << body->getName()
-                             << ", " << body->getRadius() / (float) pos_v.length() / pixelSize << endl;
+                    clog << "Planetshine: " << body->getName()
+                         << ", " << body->getRadius() / (float) pos_v.length() / pixelSize << endl;
 #endif
-                        SecondaryIlluminator illum;
-                        illum.body = body;
-                        illum.position_v = pos_v;
-                        illum.radius = body->getRadius();
-                        secondaryIlluminators.push_back(illum);
-                    }
-                }
-                else
-                {
-                    viewConeTestFailed = influenceRadius > cullingRadius;
+                    SecondaryIlluminator illum;
+                    illum.body = body;
+                    illum.position_v = pos_v;
+                    illum.radius = body->getRadius();
+                    candidates.secondaryIlluminators.push_back(illum);
                 }
             }
             else
@@ -3353,144 +3845,141 @@ void Renderer::buildRenderLists(const Vector3d& astrocentricObserverPos,
                 viewConeTestFailed = influenceRadius > cullingRadius;
             }
         }
-
-        bool insideViewCone = false;
-        if (!viewConeTestFailed)
+        else
         {
-            float radius = body->getCullingRadius();
-            if (dist_vn > -radius)
-            {
-                double maxPerpDist = (radius + dist_vn * sinViewAngle) * invCosViewAngle;
-                double perpDistSq = toViewNormal.squaredNorm();
-                insideViewCone = perpDistSq < maxPerpDist * maxPerpDist;
-            }
+            viewConeTestFailed = influenceRadius > cullingRadius;
         }
+    }
 
-        if (insideViewCone)
+    bool insideViewCone = false;
+    if (!viewConeTestFailed)
+    {
+        float radius = body->getCullingRadius();
+        if (dist_vn > -radius)
         {
-            // Calculate the distance to the viewer
-            double dist_v = pos_v.norm();
-
-            // Calculate the size of the planet/moon disc in pixels
-            float discSize = (body->getCullingRadius() / (float) dist_v) / pixelSize;
-
-            // Compute the apparent magnitude; instead of summing the reflected
-            // light from all nearby stars, we just consider the one with the
-            // highest apparent brightness.
-            float appMag = 100.0f;
-            for (const auto &lightSource : lightSourceList)
-            {
-                Eigen::Vector3d sunPos = pos_v - lightSource.position;
-                appMag = std::min(appMag, body->getApparentMagnitude(lightSource.luminosity, sunPos, pos_v));
-            }
+            double maxPerpDist = (radius + dist_vn * params.sinViewAngle) * params.invCosViewAngle;
+            double perpDistSq = toViewNormal.squaredNorm();
+            insideViewCone = perpDistSq < maxPerpDist * maxPerpDist;
+        }
+    }
 
-            bool visibleAsPoint = appMag < faintestPlanetMag && body->isVisibleAsPoint();
-            bool isLabeled = util::is_set(body->getOrbitClassification(), labelClassMask);
+    if (insideViewCone)
+    {
+        // Calculate the distance to the viewer
+        double dist_v = pos_v.norm();
 
-            if ((discSize > 1 || visibleAsPoint || isLabeled) && isBodyVisible(body, bodyVisibilityMask))
-            {
-                RenderListEntry rle;
+        // Calculate the size of the planet/moon disc in pixels
+        float discSize = (body->getCullingRadius() / (float) dist_v) / pixelSize;
 
-                rle.position = pos_v.cast<float>();
-                rle.distance = (float) dist_v;
-                rle.centerZ = pos_v.cast<float>().dot(viewMatZ);
-                rle.appMag   = appMag;
-                rle.discSizeInPixels = body->getRadius() / ((float) dist_v * pixelSize);
+        // Compute the apparent magnitude; instead of summing the reflected
+        // light from all nearby stars, we just consider the one with the
+        // highest apparent brightness.
+        float appMag = 100.0f;
+        for (const auto &lightSource : lightSourceList)
+        {
+            Eigen::Vector3d sunPos = pos_v - lightSource.position;
+            appMag = std::min(appMag, body->getApparentMagnitude(lightSource.luminosity, sunPos, pos_v));
+        }
 
-                // TODO: Remove this. It's only used in two places: for calculating comet tail
-                // length, and for calculating sky brightness to adjust the limiting magnitude.
-                // In both cases, it's the wrong quantity to use (e.g. for objects with orbits
-                // defined relative to the SSB.)
-                rle.sun = -pos_s.cast<float>();
+        bool visibleAsPoint = appMag < faintestPlanetMag && body->isVisibleAsPoint();
+        bool isLabeled = util::is_set(body->getOrbitClassification(), params.labelClassMask);
 
-                addRenderListEntries(rle, *body, isLabeled);
-            }
+        if ((discSize > 1 || visibleAsPoint || isLabeled) && isBodyVisible(body, bodyVisibilityMask))
+        {
+            RenderListEntry rle;
+
+            rle.position = pos_v.cast<float>();
+            rle.distance = (float) dist_v;
+            rle.centerZ = pos_v.cast<float>().dot(params.viewMatZ);
+            rle.appMag   = appMag;
+            rle.discSizeInPixels = body->getRadius() / ((float) dist_v * pixelSize);
+
+            // TODO: Remove this. It's only used in two places: for calculating comet tail
+            // length, and for calculating sky brightness to adjust the limiting magnitude.
+            // In both cases, it's the wrong quantity to use (e.g. for objects with orbits
+            // defined relative to the SSB.)
+            rle.sun = -pos_s.cast<float>();
+            rle.body = body;
+
+            candidates.entries.push_back({ rle, isLabeled });
         }
+    }
 
-        const FrameTree* subtree = body->getFrameTree();
-        if (subtree != nullptr)
+    const FrameTree* subtree = body->getFrameTree();
+    if (subtree != nullptr)
+    {
+        double dist_v = pos_v.norm();
+        bool traverseSubtree = false;
+
+        // There are two different tests available to determine whether we can reject
+        // the object's subtree. If the subtree contains no light reflecting objects,
+        // then render the subtree only when:
+        //    - the subtree bounding sphere intersects the view frustum, and
+        //    - the subtree contains an object bright or large enough to be visible.
+        // Otherwise, render the subtree when any of the above conditions are
+        // true or when a subtree object could potentially illuminate something
+        // in the view cone.
+        auto minPossibleDistance = (float) (dist_v - subtree->boundingSphereRadius());
+        float brightestPossible = 0.0f;
+        float largestPossible = 0.0f;
+
+        // If the viewer is not within the subtree bounding sphere, see if we can cull it because
+        // it contains no objects brighter than the limiting magnitude and no objects that will
+        // be larger than one pixel in size.
+        if (minPossibleDistance > 1.0f)
         {
-            double dist_v = pos_v.norm();
-            bool traverseSubtree = false;
-
-            // There are two different tests available to determine whether we can reject
-            // the object's subtree. If the subtree contains no light reflecting objects,
-            // then render the subtree only when:
-            //    - the subtree bounding sphere intersects the view frustum, and
-            //    - the subtree contains an object bright or large enough to be visible.
-            // Otherwise, render the subtree when any of the above conditions are
-            // true or when a subtree object could potentially illuminate something
-            // in the view cone.
-            auto minPossibleDistance = (float) (dist_v - subtree->boundingSphereRadius());
-            float brightestPossible = 0.0f;
-            float largestPossible = 0.0f;
-
-            // If the viewer is not within the subtree bounding sphere, see if we can cull it because
-            // it contains no objects brighter than the limiting magnitude and no objects that will
-            // be larger than one pixel in size.
-            if (minPossibleDistance > 1.0f)
-            {
-                // Figure out the magnitude of the brightest possible object in the subtree.
+            // Figure out the magnitude of the brightest possible object in the subtree.
 
-                // Compute the luminosity from reflected light of the largest object in the subtree
-                float lum = 0.0f;
-                for (const auto &lightSource : lightSourceList)
-                {
-                    Eigen::Vector3d sunPos = pos_v - lightSource.position;
-                    lum += luminosityAtOpposition(lightSource.luminosity, (float) sunPos.norm(), (float) subtree->maxChildRadius());
-                }
-                brightestPossible = astro::lumToAppMag(lum, astro::kilometersToLightYears(minPossibleDistance));
-                largestPossible = (float) subtree->maxChildRadius() / minPossibleDistance / pixelSize;
-            }
-            else
+            // Compute the luminosity from reflected light of the largest object in the subtree
+            float lum = 0.0f;
+            for (const auto &lightSource : lightSourceList)
             {
-                // Viewer is within the bounding sphere, so the object could be very close.
-                // Assume that an object in the subree could be very bright or large,
-                // so no culling will occur.
-                brightestPossible = -100.0f;
-                largestPossible = 100.0f;
+                Eigen::Vector3d sunPos = pos_v - lightSource.position;
+                lum += luminosityAtOpposition(lightSource.luminosity, (float) sunPos.norm(), (float) subtree->maxChildRadius());
             }
+            brightestPossible = astro::lumToAppMag(lum, astro::kilometersToLightYears(minPossibleDistance));
+            largestPossible = (float) subtree->maxChildRadius() / minPossibleDistance / pixelSize;
+        }
+        else
+        {
+            // Viewer is within the bounding sphere, so the object could be very close.
+            // Assume that an object in the subree could be very bright or large,
+            // so no culling will occur.
+            brightestPossible = -100.0f;
+            largestPossible = 100.0f;
+        }
 
-            if (brightestPossible < faintestPlanetMag || largestPossible > 1.0f)
+        if (brightestPossible < faintestPlanetMag || largestPossible > 1.0f)
+        {
+            // See if the object or any of its children are within the view frustum
+            if (params.viewFrustum.testSphere(pos_v.cast<float>(), (float) subtree->boundingSphereRadius()) != math::FrustumAspect::Outside)
             {
-                // See if the object or any of its children are within the view frustum
-                if (viewFrustum.testSphere(pos_v.cast<float>(), (float) subtree->boundingSphereRadius()) != math::FrustumAspect::Outside)
-                {
-                    traverseSubtree = true;
-                }
+                traverseSubtree = true;
             }
+        }
 
-            // If the subtree contains secondary illuminators, do one last check if it hasn't
-            // already been determined if we need to traverse the subtree: see if something
-            // in the subtree could possibly contribute significant illumination to an
-            // object in the view cone.
-            if (subtree->containsSecondaryIlluminators() &&
-                !traverseSubtree                         &&
-                largestPossible > PLANETSHINE_PIXEL_SIZE_LIMIT)
+        // If the subtree contains secondary illuminators, do one last check if it hasn't
+        // already been determined if we need to traverse the subtree: see if something
+        // in the subtree could possibly contribute significant illumination to an
+        // object in the view cone.
+        if (subtree->containsSecondaryIlluminators() &&
+            !traverseSubtree                         &&
+            largestPossible > PLANETSHINE_PIXEL_SIZE_LIMIT)
+        {
+            auto influenceRadius = (float) (subtree->boundingSphereRadius() +
+                (subtree->maxChildRadius() * PLANETSHINE_DISTANCE_LIMIT_FACTOR));
+            if (dist_vn > -influenceRadius)
             {
-                auto influenceRadius = (float) (subtree->boundingSphereRadius() +
-                    (subtree->maxChildRadius() * PLANETSHINE_DISTANCE_LIMIT_FACTOR));
-                if (dist_vn > -influenceRadius)
-                {
-                    double maxPerpDist = (influenceRadius + dist_vn * sinViewAngle) * invCosViewAngle;
-                    double perpDistSq = toViewNormal.squaredNorm();
-                    if (perpDistSq < maxPerpDist * maxPerpDist)
-                        traverseSubtree = true;
-                }
+                double maxPerpDist = (influenceRadius + dist_vn * params.sinViewAngle) * params.invCosViewAngle;
+                double perpDistSq = toViewNormal.squaredNorm();
+                if (perpDistSq < maxPerpDist * maxPerpDist)
+                    traverseSubtree = true;
             }
+        }
 
-            if (traverseSubtree)
-            {
-                buildRenderLists(astrocentricObserverPos,
-                                 viewFrustum,
-                                 viewPlaneNormal,
-                                 pos_s,
-                                 subtree,
-                                 observer,
-                                 now);
-            }
-        } // end subtree traverse
-    }
+        if (traverseSubtree)
+            candidates.subtrees.push_back({ subtree });
+    } // end subtree traverse
 }
 
 
@@ -3518,7 +4007,7 @@ void Renderer::buildOrbitLists(const Vector3d& astrocentricObserverPos,
         // pos_v: viewer-relative position of object
 
         // Get the position of the body relative to the sun.
-        Vector3d pos_s = body->getAstrocentricPosition(now);
+        Vector3d pos_s = body->getRenderAstrocentricPosition(now);
 
         // We now have the positions of the observer and the planet relative
         // to the sun.  From these, compute the position of the body
@@ -3537,7 +4026,7 @@ void Renderer::buildOrbitLists(const Vector3d& astrocentricObserverPos,
             Selection centerObject = phase->orbitFrame()->getCenter();
             if (centerObject.body() != nullptr)
             {
-                orbitOrigin = centerObject.body()->getAstrocentricPosition(now);
+                orbitOrigin = centerObject.body()->getRenderAstrocentricPosition(now);
             }
 
             // Calculate the origin of the orbit relative to the observer
@@ -3789,9 +4278,12 @@ static float calcMaxFOV(float fovY_degrees, float aspectRatio)
 
 
 void Renderer::renderPointStars(const StarDatabase& starDB,
+                                const DSODatabase* dsoDB,
                                 float faintestMagNight,
                                 const Observer& observer)
 {
+    CELESTIA_PROFILE_ZONE("Renderer::renderPointStars");
+
 #ifndef GL_ES
     // Disable multisample rendering when drawing point stars
     bool toggleAA = (starStyle == StarStyle::PointStars && isMSAAEnabled());
@@ -3825,10 +4317,10 @@ void Renderer::renderPointStars(const StarDatabase& starDB,
 
     starRenderer.colorTemp = &starColors;
 
-    gaussianDiscTex->bind();
-    starRenderer.starVertexBuffer->setTexture(gaussianDiscTex);
+    starPSFTex->bind();
+    starRenderer.starVertexBuffer->setTexture(starPSFTex);
     starRenderer.starVertexBuffer->setPointScale(screenDpi / 96.0f);
-    starRenderer.glareVertexBuffer->setTexture(gaussianGlareTex);
+    starRenderer.glareVertexBuffer->setTexture(starPSFTex);
     starRenderer.glareVertexBuffer->setPointScale(screenDpi / 96.0f);
 
     PointStarVertexBuffer::enable();
@@ -3843,15 +4335,60 @@ void Renderer::renderPointStars(const StarDatabase& starDB,
     ps.blendFunc = {GL_SRC_ALPHA, GL_ONE};
     setPipelineState(ps);
 
-    starDB.findVisibleStars(starRenderer,
-                            obsPos.cast<float>(),
-                            getCameraOrientationf(),
-                            math::degToRad(fov),
-                            getAspectRatio(),
-                            faintestMagNight);
+    bool useGPUStars = gpuStarCulling && m_gpuStarRenderer->prepare(starDB, dsoDB, starColors);
+    if (useGPUStars)
+    {
+        float labelMag = util::is_set(labelMode, RenderLabels::StarLabels)
+            ? starRenderer.labelThresholdMag
+            : -std::numeric_limits<float>::infinity();
+        m_gpuStarRenderer->findVisibleStars(starRenderer,
+                                            obsPos.cast<float>(),
+                                            getCameraOrientationf(),
+                                            math::degToRad(fov),
+                                            getAspectRatio(),
+                                            faintestMagNight,
+                                            labelMag);
+    }
+    else
+    {
+        starDB.findVisibleStars(starRenderer,
+                                obsPos.cast<float>(),
+                                getCameraOrientationf(),
+                                math::degToRad(fov),
+                                getAspectRatio(),
+                                faintestMagNight,
+                                util::GetThreadPool(),
+                                &starVisibilityCache);
+    }
+
+    starDB.findVisiblePagedStars(starRenderer,
+                                 obsPos.cast<float>(),
+                                 getCameraOrientationf(),
+                                 math::degToRad(fov),
+                                 getAspectRatio(),
+                                 faintestMagNight);
+    engine::GetFrameStats()->current().starsProcessed += starRenderer.starsProcessed;
 
     starRenderer.starVertexBuffer->finish();
     starRenderer.glareVertexBuffer->finish();
+
+    if (useGPUStars)
+    {
+        GPUStarRenderer::Parameters params;
+        params.obsPosition     = obsPos.cast<float>();
+        params.limitingMag     = faintestMagNight;
+        params.faintestMag     = faintestMag;
+        params.brightnessScale = brightnessScale;
+        params.brightnessBias  = brightnessBias;
+        params.satPoint        = satPoint;
+        params.discSize        = BaseStarDiscSize * static_cast<float>(screenDpi) / 96.0f;
+        params.pointScale      = static_cast<float>(screenDpi) / 96.0f;
+        params.distanceLimit   = distanceLimit;
+        params.starStyle       = starStyle;
+        params.psfTexture      = starPSFTex;
+        m_gpuStarRenderer->render(params);
+    }
+
     PointStarVertexBuffer::disable();
 
 #ifndef GL_ES
@@ -3864,6 +4401,8 @@ void Renderer::renderDeepSkyObjects(const Universe& universe,
                                     const Observer& observer,
                                     const float     faintestMagNight)
 {
+    CELESTIA_PROFILE_ZONE("Renderer::renderDeepSkyObjects");
+
     DSORenderer dsoRenderer;
 
     auto cameraOrientation = getCameraOrientationf();
@@ -3895,6 +4434,7 @@ void Renderer::renderDeepSkyObjects(const Universe& universe,
     dsoRenderer.faintestMag      = faintestMag;
     dsoRenderer.renderFlags      = renderFlags;
     dsoRenderer.labelMode        = labelMode;
+    dsoRenderer.recordPickTargets = m_pickBuffer != nullptr;
 
     dsoRenderer.frustum = projectionMode->getInfiniteFrustum(MinNearPlaneDistance, observer.getZoom());
     // Use pixelSize * screenDpi instead of FoV, to eliminate windowHeight dependence.
@@ -3909,19 +4449,34 @@ void Renderer::renderDeepSkyObjects(const Universe& universe,
     openClusterRep = MarkerRepresentation(MarkerRepresentation::Circle,   8.0f, OpenClusterLabelColor);
     globularRep    = MarkerRepresentation(MarkerRepresentation::Circle,   8.0f, GlobularLabelColor);
 
-    dsoDB->findVisibleDSOs(dsoRenderer,
+    // Cull on the worker threads, then hand the accepted objects to the
+    // renderers of their type in traversal order
+    std::vector<DSORenderer> rangeRenderers;
+    dsoDB->findVisibleDSOs(rangeRenderers,
+                           dsoRenderer,
                            obsPos,
                            cameraOrientation,
                            math::degToRad(fov),
                            getAspectRatio(),
-                           2 * faintestMagNight);
+                           2 * faintestMagNight,
+                           util::GetThreadPool());
+
+    engine::FrameCounters& counters = engine::GetFrameStats()->current();
+    for (auto &rangeRenderer : rangeRenderers)
+    {
+        rangeRenderer.flush();
+        counters.dsosProcessed += rangeRenderer.dsosProcessed;
+        for (std::size_t i = 0; i < engine::FrameDSOTypeCount; ++i)
+        {
+            counters.dsosCulledByType[i] += rangeRenderer.dsosCulledByType[i];
+            counters.dsosProcessedByType[i] += rangeRenderer.dsosProcessedByType[i];
+        }
+    }
 
     m_galaxyRenderer->render();
     m_globularRenderer->render();
     m_nebulaRenderer->render();
     m_openClusterRenderer->render();
-
-    // clog << "DSOs processed: " << dsoRenderer.dsosProcessed << endl;
 }
 
 
@@ -3977,7 +4532,7 @@ void Renderer::renderSkyGrids(const Observer& observer)
             grid.longitudeUnits = SkyGrid::LongitudeDegrees;
             grid.longitudeDirection = SkyGrid::IncreasingClockwise;
 
-            Vector3d zenithDirection = observer.getPosition().offsetFromKm(body->getPosition(tdb)).normalized();
+            Vector3d zenithDirection = observer.getPosition().offsetFromKm(body->getRenderPosition(tdb)).normalized();
 
             Vector3d northPole = body->getEclipticToEquatorial(tdb).conjugate() * Vector3d::UnitY();
             zenithDirection = toStandardCoords(zenithDirection);
@@ -4066,12 +4621,15 @@ Renderer::renderAnnotationMarker(const Annotation &a,
 
     glVertexAttrib(CelestiaGLProgram::ColorAttributeIndex, a.color);
 
-    Matrix4f mv = math::translate(*m.modelview, (float)(int)a.position.x(), (float)(int)a.position.y(), depth);
+    Vector3f position((float)(int)a.position.x(), (float)(int)a.position.y(), depth);
+    Matrix4f mv = math::translate(*m.modelview, position);
     Matrices mm = { m.projection, &mv };
 
+    // The annotations are drawn with the identity model view matrix, so the
+    // markers which share a symbol can be drawn together
     if (markerRep.symbol() == celestia::MarkerRepresentation::Crosshair)
         renderCrosshair(size, realTime, a.color, mm);
-    else
+    else if (!addMarkerInstance(markerRep.symbol(), size, markerRep.color(), position))
         markerRep.render(*this, size, mm);
 
     if (!markerRep.label().empty())
@@ -4120,12 +4678,15 @@ void Renderer::renderAnnotations(const vector<Annotation>& annotations,
 
     TextLayout layout{ screenDpi };
     layout.setFont(font);
+    layout.setLineCache(&labelLineCache);
 
     Matrix4f mv = Matrix4f::Identity();
     Matrices m = { &m_orthoProjMatrix, &mv };
 
+    font->beginBatch();
     for (const auto &annotation : annotations)
     {
+        font->setBatchColor(annotation.color);
         if (annotation.markerRep != nullptr)
         {
             renderAnnotationMarker(annotation, layout, 0.0f, m);
@@ -4143,6 +4704,8 @@ void Renderer::renderAnnotations(const vector<Annotation>& annotations,
             renderAnnotationLabel(annotation, layout, hOffset, vOffset, 0.0f, m);
         }
     }
+    renderMarkerInstances();
+    font->endBatch();
 }
 
 
@@ -4156,6 +4719,7 @@ Renderer::renderBackgroundAnnotations(FontStyle fs)
     ps.smoothLines = true;
     setPipelineState(ps);
 
+    declutterAnnotations(backgroundAnnotations, getFont(fs).get());
     renderAnnotations(backgroundAnnotations, fs);
     backgroundAnnotations.clear();
 }
@@ -4209,6 +4773,7 @@ Renderer::renderAnnotations(vector<Annotation>::iterator startIter,
 
     TextLayout layout{ screenDpi };
     layout.setFont(font);
+    layout.setLineCache(&labelLineCache);
 
     Matrix4f mv = Matrix4f::Identity();
     Matrices m = { &m_orthoProjMatrix, &mv };
@@ -4218,12 +4783,24 @@ Renderer::renderAnnotations(vector<Annotation>::iterator startIter,
     // projection matrix in order to get the label text position exactly right but need to mimic
     // the depth coordinate generation of a projection.
 
+    font->beginBatch();
     vector<Annotation>::iterator iter = startIter;
     for (; iter != endIter && iter->position.z() > nearDist; ++iter)
     {
-        // Compute normalized device z
-        float z = getProjectionMode()->getNormalizedDeviceZ(nearDist, farDist, iter->position.z());
-        float ndc_z = std::clamp(z, -1.0f, 1.0f);
+        font->setBatchColor(iter->color);
+
+        // Compute normalized device z; the reversed depth projection has
+        // its far plane at infinity
+        float ndc_z;
+        if (reverseDepthFrame)
+        {
+            ndc_z = -nearDist / iter->position.z();
+        }
+        else
+        {
+            float z = getProjectionMode()->getNormalizedDeviceZ(nearDist, farDist, iter->position.z());
+            ndc_z = std::clamp(z, -1.0f, 1.0f);
+        }
 
         if (iter->markerRep != nullptr)
         {
@@ -4242,6 +4819,8 @@ Renderer::renderAnnotations(vector<Annotation>::iterator startIter,
             renderAnnotationLabel(*iter, layout, labelHOffset, labelVOffset, ndc_z, m);
         }
     }
+    renderMarkerInstances();
+    font->endBatch();
 
     return iter;
 }
@@ -4357,7 +4936,7 @@ void Renderer::loadTextures(Body* body)
 
 void Renderer::invalidateOrbitCache()
 {
-    orbitCache.clear();
+    orbitCache->clear();
 }
 
 
@@ -4374,6 +4953,14 @@ void Renderer::markSettingsChanged()
 }
 
 
+bool Renderer::hasPendingResources() const
+{
+    return shaderManager->hasPendingShaders() ||
+           GetTextureManager()->hasPendingLoads() ||
+           engine::GetGeometryManager()->hasPendingLoads();
+}
+
+
 void Renderer::addWatcher(RendererWatcher* watcher)
 {
     assert(watcher != nullptr);
@@ -4427,6 +5014,47 @@ void Renderer::setSolarSystemMaxDistance(float t)
     SolarSystemMaxDistance = std::clamp(t, 1.0f, 10.0f);
 }
 
+bool Renderer::getGPUStarCulling() const
+{
+    return gpuStarCulling;
+}
+
+void Renderer::setGPUStarCulling(bool enable)
+{
+    gpuStarCulling = enable;
+}
+
+bool Renderer::getReverseDepth() const
+{
+    return reverseDepth;
+}
+
+void Renderer::setReverseDepth(bool enable)
+{
+    reverseDepth = enable;
+}
+
+bool Renderer::getLabelDeclutter() const
+{
+    return labelDeclutter;
+}
+
+void Renderer::setLabelDeclutter(bool enable)
+{
+    labelDeclutter = enable;
+}
+
+void Renderer::setMaxLabels(unsigned count)
+{
+    maxLabels = count;
+}
+
+
+void Renderer::setGalaxyPointBudget(unsigned count)
+{
+    m_galaxyRenderer->setPointBudget(count);
+}
+
 
 void Renderer::getViewport(int* x, int* y, int* w, int* h) const
 {
@@ -4527,6 +5155,16 @@ Renderer::getPreferredCaptureFormat() const noexcept
 #endif
 }
 
+bool
+Renderer::isPackInverted() const noexcept
+{
+#ifdef GL_ES
+    return false;
+#else
+    return detailOptions.useMesaPackInvert;
+#endif
+}
+
 bool Renderer::captureFrame(int x, int y, int w, int h, PixelFormat format, unsigned char* buffer) const
 {
     glReadPixels(x, y, w, h, toGLFormat(format), GL_UNSIGNED_BYTE, (void*) buffer);
@@ -4642,6 +5280,7 @@ static void draw_rectangle_solid(const Renderer &renderer,
     prog->setMVPMatrices(p, m);
 
     glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+    engine::GetFrameStats()->addDrawCall(4);
 
     glDisableVertexAttribArray(CelestiaGLProgram::ColorAttributeIndex);
     if (r.tex != nullptr)
@@ -4759,6 +5398,17 @@ bool Renderer::getInfo(map<string, string>& info) const
         info["MaxAnisotropy"] = fmt::format("{:.2f}", maxAnisotropy);
     }
 
+    // Graphics memory of the textures loaded through the texture manager,
+    // in megabytes
+    const auto* textureManager = GetTextureManager();
+    info["TextureMemoryUsage"] = fmt::format("{:.1f}", static_cast<double>(textureManager->getMemoryUsage()) / (1024.0 * 1024.0));
+    if (textureManager->getMemoryBudget() != 0)
+        info["TextureMemoryBudget"] = to_string(textureManager->getMemoryBudget() / (1024U * 1024U));
+
+    const auto* loadStats = celestia::engine::GetTextureLoadStats();
+    info["TextureLoads"] = to_string(loadStats->getLoadCount());
+    info["TextureMaxUploadTime"] = fmt::format("{:.1f}", std::chrono::duration<double, std::milli>(loadStats->getMaxUploadTime()).count());
+
 #if 0 // we don't use cubemaps yet
     GLint maxCubeMapSize = 0;
     glGetIntegerv(GL_MAX_CUBE_MAP_TEXTURE_SIZE, &maxCubeMapSize);
@@ -4772,23 +5422,79 @@ bool Renderer::getInfo(map<string, string>& info) const
     return true;
 }
 
+void Renderer::getFrameStats(map<string, double>& stats) const
+{
+    const engine::FrameCounters& counters = engine::GetFrameStats()->getLastFrame();
+    stats["Frame"] = static_cast<double>(counters.frame);
+    stats["DrawCalls"] = counters.drawCalls;
+    stats["VerticesSubmitted"] = static_cast<double>(counters.verticesSubmitted);
+    stats["StarsProcessed"] = counters.starsProcessed;
+    stats["DSOsProcessed"] = counters.dsosProcessed;
+
+    std::uint32_t dsosCulled = 0;
+    for (std::uint32_t culled : counters.dsosCulledByType)
+        dsosCulled += culled;
+    stats["DSOsCulled"] = dsosCulled;
+
+    stats["RenderListSize"] = counters.renderListSize;
+    stats["DepthPartitions"] = counters.depthPartitions;
+    stats["OrbitCacheHits"] = counters.orbitCacheHits;
+    stats["OrbitCacheMisses"] = counters.orbitCacheMisses;
+    stats["ShaderCompiles"] = counters.shaderCompiles;
+    stats["TextureUploads"] = counters.textureUploads;
+    stats["TextureUploadBytes"] = static_cast<double>(counters.textureUploadBytes);
+
+    if (m_qualityGovernor.isEnabled())
+    {
+        stats["QualityLevel"] = m_qualityGovernor.getLevel();
+        stats["QualityFrameTime"] = m_qualityGovernor.getFrameTime();
+        stats["QualityAdjustments"] = m_qualityGovernor.getAdjustments();
+    }
+
+    if (m_resolutionScaler.isEnabled())
+    {
+        stats["RenderScale"] = m_resolutionScaler.getScale();
+        stats["RenderScaleGPUTime"] = m_resolutionScaler.getGPUTime();
+    }
+
+    stats["OrbitCacheMemory"] = static_cast<double>(orbitCache->bytes());
+    stats["TextureMemory"] = static_cast<double>(GetTextureManager()->getMemoryUsage());
+    stats["GeometryMemory"] = static_cast<double>(ModelGeometry::getTotalBufferMemory());
+}
+
+void Renderer::reportMemoryUsage(engine::MemoryReport& report) const
+{
+    report.add("textures", GetTextureManager()->getMemoryUsage());
+    report.add("geometry.buffers", ModelGeometry::getTotalBufferMemory());
+    report.add("fonts", TextureFont::getTotalAtlasMemory());
+    report.add("orbitcache", orbitCache->bytes(), orbitCache->size());
+}
+
 FramebufferObject*
 Renderer::getShadowFBO(int index) const
 {
     return index == 0 ? m_shadowFBO.get() : nullptr;
 }
 
+ShadowMapCache*
+Renderer::getShadowMapCache() const
+{
+    return m_shadowMapCache.get();
+}
+
 void
 Renderer::createShadowFBO()
 {
-    m_shadowFBO = std::make_unique<FramebufferObject>(m_shadowMapSize,
-                                                      m_shadowMapSize,
-                                                      FramebufferObject::DepthAttachment);
-    if (!m_shadowFBO->isValid())
-    {
+    m_shadowFBO = m_framebufferPool->acquire(m_shadowMapSize,
+                                             m_shadowMapSize,
+                                             FramebufferObject::DepthAttachment);
+    if (m_shadowFBO == nullptr)
         GetLogger()->warn("Error creating shadow FBO.\n");
-        m_shadowFBO = nullptr;
-    }
+
+    if (m_shadowFBO != nullptr && m_shadowMapCacheSize > 0)
+        m_shadowMapCache = std::make_unique<ShadowMapCache>(m_shadowMapSize, m_shadowMapCacheSize);
+    else
+        m_shadowMapCache = nullptr;
 }
 
 void
@@ -4798,14 +5504,72 @@ Renderer::setShadowMapSize(unsigned size)
     if (m_shadowFBO != nullptr && m_shadowMapSize == m_shadowFBO->width())
         return;
     if (m_shadowMapSize == 0)
+    {
         m_shadowFBO = nullptr;
+        m_shadowMapCache = nullptr;
+    }
     else
+    {
         createShadowFBO();
+    }
+}
+
+void
+Renderer::setShadowMapCacheSize(unsigned count)
+{
+    if (count == m_shadowMapCacheSize)
+        return;
+
+    m_shadowMapCacheSize = count;
+    if (m_shadowFBO != nullptr && count > 0)
+        m_shadowMapCache = std::make_unique<ShadowMapCache>(m_shadowMapSize, count);
+    else
+        m_shadowMapCache = nullptr;
+}
+
+void
+Renderer::setQualityLimits(const engine::QualityLimits& limits)
+{
+    m_qualityGovernor.setLimits(limits);
+}
+
+void
+Renderer::setDynamicResolution(double gpuTime, float minScale)
+{
+    m_resolutionScaler.setTarget(gpuTime, minScale);
+}
+
+void
+Renderer::updateQuality()
+{
+    const engine::FrameCounters& lastFrame = engine::GetFrameStats()->getLastFrame();
+    if (m_resolutionScaler.update(lastFrame))
+    {
+        GetLogger()->debug("Render scale {:.2f} at {:.1f} ms of GPU time per frame\n",
+                           m_resolutionScaler.getScale(), m_resolutionScaler.getGPUTime());
+    }
+
+    if (!m_qualityGovernor.update(lastFrame))
+        return;
+
+    engine::QualitySettings settings = m_qualityGovernor.getSettings();
+    m_magnitudeOffset = settings.magnitudeOffset;
+    setGalaxyPointBudget(settings.galaxyPointBudget);
+    setMaxLabels(settings.maxLabels);
+    orbitCache->setToleranceScale(settings.orbitTolerance);
+    LODSphereMesh::setDetailScale(settings.sphereDetail);
+    if (settings.shadowMapSize > 0)
+        setShadowMapSize(settings.shadowMapSize);
+
+    GetLogger()->debug("Quality level {} at {:.1f} ms per frame\n",
+                       m_qualityGovernor.getLevel(), m_qualityGovernor.getFrameTime());
 }
 
 void
 Renderer::removeInvisibleItems(const math::InfiniteFrustum &frustum)
 {
+    CELESTIA_PROFILE_ZONE("Renderer::removeInvisibleItems");
+
     // Remove objects from the render list that lie completely outside the
     // view frustum.
     auto notCulled = renderList.begin();
@@ -4924,6 +5688,99 @@ Renderer::removeInvisibleItems(const math::InfiniteFrustum &frustum)
     sort(renderList.begin(), renderList.end());
 }
 
+PickBuffer*
+Renderer::selectPickBuffer(const Observer& observer)
+{
+    auto it = std::find_if(m_pickBuffers.begin(), m_pickBuffers.end(),
+                           [&observer](const ObserverPickBuffer& b) { return b.observer == &observer; });
+    if (it == m_pickBuffers.end())
+    {
+        if (m_pickBuffers.size() < MaxPickBuffers)
+        {
+            it = m_pickBuffers.insert(m_pickBuffers.end(), ObserverPickBuffer{ &observer, false, PickBuffer() });
+        }
+        else
+        {
+            // Reuse the buffer of the observer rendered least recently
+            it = m_pickBuffers.begin() + static_cast<std::ptrdiff_t>(m_nextPickBuffer);
+            m_nextPickBuffer = (m_nextPickBuffer + 1) % MaxPickBuffers;
+            it->observer = &observer;
+        }
+    }
+
+    // The faces of a cube map don't match the window coordinates of a pick
+    it->valid = m_cameraTransform.isIdentity();
+    if (!it->valid)
+        return nullptr;
+
+    it->buffer.reset(windowWidth, windowHeight);
+    return &it->buffer;
+}
+
+void
+Renderer::addRenderListPickTargets()
+{
+    for (const auto& ri : renderList)
+    {
+        Selection sel;
+        float radius;
+        bool exact;
+        switch (ri.renderableType)
+        {
+        case RenderListEntry::RenderableStar:
+            sel = Selection(const_cast<Star*>(ri.star));
+            radius = ri.star->getRadius();
+            exact = true;
+            break;
+
+        case RenderListEntry::RenderableBody:
+            if (!ri.body->isClickable())
+                continue;
+            sel = Selection(ri.body);
+            radius = ri.body->getRadius();
+            // Only spheres are picked by their disc, the geometric pick
+            // resolves the ellipsoids and meshes
+            exact = ri.body->getGeometry() == InvalidResource && ri.body->isSphere();
+            break;
+
+        default:
+            continue;
+        }
+
+        addPickTarget(PickBuffer::Layer::Body,
+                      sel,
+                      ri.position,
+                      radius / (ri.distance * pixelSize),
+                      ri.distance - radius,
+                      exact);
+    }
+}
+
+void
+Renderer::addPickTarget(PickBuffer::Layer layer,
+                        const Selection& sel,
+                        const Vector3f& position,
+                        float radiusInPixels,
+                        float depth,
+                        bool exact)
+{
+    if (m_pickBuffer == nullptr)
+        return;
+
+    std::array<int, 4> view{ 0, 0, windowWidth, windowHeight };
+    Vector3f win;
+    if (projectionMode->project(position, m_modelMatrix, m_projMatrix, m_MVPMatrix, view, win))
+        m_pickBuffer->add(layer, sel, win.head<2>(), radiusInPixels, depth, exact);
+}
+
+const PickBuffer*
+Renderer::getPickBuffer(const Observer& observer) const
+{
+    auto it = std::find_if(m_pickBuffers.begin(), m_pickBuffers.end(),
+                           [&observer](const ObserverPickBuffer& b) { return b.observer == &observer; });
+    return it != m_pickBuffers.end() && it->valid ? &it->buffer : nullptr;
+}
+
 bool
 Renderer::selectionToAnnotation(const Selection &sel,
                                 const Observer &observer,
@@ -5019,16 +5876,78 @@ Renderer::adjustMagnitudeInsideAtmosphere(float &faintestMag,
     }
 }
 
+void
+Renderer::beginMultiViewFrame(const Universe& universe,
+                              util::array_view<const Observer*> observers)
+{
+    multiViewFrame.active = true;
+    multiViewFrame.resourcesUpdated = false;
+    multiViewFrame.shareNearStars = false;
+    multiViewFrame.nearStars.clear();
+    if (observers.empty())
+        return;
+
+    // Search once around the centroid of the observers, in a sphere
+    // containing the spheres around each of them. This only pays off when
+    // they are at the same time and closer to each other than the size of
+    // a solar system.
+    multiViewFrame.time = observers[0]->getTime();
+    Eigen::Vector3d center = Eigen::Vector3d::Zero();
+    for (const Observer* observer : observers)
+    {
+        if (observer->getTime() != multiViewFrame.time)
+            return;
+        center += observer->getPosition().toLy();
+    }
+    center /= static_cast<double>(observers.size());
+
+    double maxOffset = 0.0;
+    for (const Observer* observer : observers)
+        maxOffset = std::max(maxOffset, (observer->getPosition().toLy() - center).norm());
+    if (maxOffset > SolarSystemMaxDistance)
+        return;
+
+    universe.getNearStars(UniversalCoord::CreateLy(center),
+                          SolarSystemMaxDistance + static_cast<float>(maxOffset),
+                          multiViewFrame.nearStars);
+    multiViewFrame.shareNearStars = true;
+}
+
+void
+Renderer::endMultiViewFrame()
+{
+    multiViewFrame.active = false;
+    multiViewFrame.resourcesUpdated = false;
+    multiViewFrame.shareNearStars = false;
+    multiViewFrame.nearStars.clear();
+}
+
 void
 Renderer::buildNearSystemsLists(const Universe &universe,
                                 const Observer &observer,
                                 const math::InfiniteFrustum &xfrustum,
                                 double now)
 {
+    CELESTIA_PROFILE_ZONE("Renderer::buildNearSystemsLists");
+
     UniversalCoord observerPos = observer.getPosition();
     Eigen::Quaterniond observerOrient = getCameraOrientation();
 
-    universe.getNearStars(observerPos, SolarSystemMaxDistance, nearStars);
+    if (multiViewFrame.shareNearStars && now == multiViewFrame.time)
+    {
+        // Same test as Universe::getNearStars, on the stars found around
+        // all the observers
+        Eigen::Vector3f pos = observerPos.toLy().cast<float>();
+        for (const auto star : multiViewFrame.nearStars)
+        {
+            if ((star->getPosition() - pos).norm() < SolarSystemMaxDistance)
+                nearStars.push_back(star);
+        }
+    }
+    else
+    {
+        nearStarTracker.find(universe, observerPos, SolarSystemMaxDistance, nearStars);
+    }
 
     // Set up direct light sources (i.e. just stars at the moment)
     // Skip if only star orbits to be shown
@@ -5064,13 +5983,18 @@ Renderer::buildNearSystemsLists(const Universe &universe,
             solarSysTree->markUpdated();
         }
 
+        // Evaluate the positions and orientations of all bodies in the
+        // system once, for the render lists and the rest of this frame,
+        // which read them through Body::getRender*.
+        solarSysTree->updateBodyStates(now);
+
         // Compute the position of the observer in astrocentric coordinates
         Vector3d astrocentricObserverPos = astrocentricPosition(observerPos, *sun, now);
 
         // Build render lists for bodies and orbits paths
         buildRenderLists(astrocentricObserverPos, xfrustum,
                          observerOrient.conjugate() * -Vector3d::UnitZ(),
-                         Vector3d::Zero(), solarSysTree, observer, now);
+                         solarSysTree, now);
         if (util::is_set(renderFlags, RenderFlags::ShowOrbits))
         {
             buildOrbitLists(astrocentricObserverPos, observerOrient,
@@ -5219,21 +6143,94 @@ Renderer::buildDepthPartitions()
                                       orbitPathList.back().centerZ - orbitPathList.back().radius);
     }
 
+    // With a reversed floating point depth buffer the relative precision is
+    // the same at all distances, so the whole span fits in one interval.
+    if (reverseDepthFrame && nIntervals > 1)
+    {
+        partition = depthPartitions.back();
+        partition.index = 0;
+        partition.farZ = depthPartitions.front().farZ;
+        depthPartitions.assign(1, partition);
+        nIntervals = 1;
+    }
+
     // We want to avoid overpartitioning the depth buffer. In this stage, we
     // coalesce partitions that have small spans in the depth buffer.
     // TODO: Implement this step!
     return nIntervals;
 }
 
+bool
+Renderer::beginReverseDepthFrame()
+{
+    if (!reverseDepth || !ReverseDepthTarget::isSupported())
+        return false;
+
+    // Only projections with a reversed depth form can use the target
+    Matrix4f proj;
+    if (!projectionMode->getReverseDepthProjectionMatrix(MinNearPlaneDistance, 1.0f, proj))
+        return false;
+
+    if (m_reverseDepthTarget == nullptr)
+        m_reverseDepthTarget = std::make_unique<ReverseDepthTarget>(*this);
+
+    if (!m_reverseDepthTarget->begin(m_viewport[2], m_viewport[3]))
+        return false;
+
+    // The target only covers the viewport
+    reverseDepthViewport = m_viewport;
+    setViewport(0, 0, reverseDepthViewport[2], reverseDepthViewport[3]);
+    if (m_pipelineState.scissor)
+        glScissor(0, 0, reverseDepthViewport[2], reverseDepthViewport[3]);
+
+    return true;
+}
+
+void
+Renderer::endReverseDepthFrame()
+{
+    setViewport(reverseDepthViewport);
+    if (m_pipelineState.scissor)
+    {
+        glScissor(reverseDepthViewport[0], reverseDepthViewport[1],
+                  reverseDepthViewport[2], reverseDepthViewport[3]);
+    }
+
+    m_reverseDepthTarget->end();
+}
+
+void
+Renderer::setReverseDepthState([[maybe_unused]] bool reversed)
+{
+#ifndef GL_ES
+    glClipControl(GL_LOWER_LEFT, reversed ? GL_ZERO_TO_ONE : GL_NEGATIVE_ONE_TO_ONE);
+    glDepthFunc(reversed ? GL_GEQUAL : GL_LEQUAL);
+    glClearDepth(reversed ? 0.0 : 1.0);
+#endif
+}
+
 void
 Renderer::renderSolarSystemObjects(const Observer &observer,
                                    int nIntervals,
                                    double now)
 {
+    CELESTIA_PROFILE_ZONE("Renderer::renderSolarSystemObjects");
+
     // Render everything that wasn't culled.
     auto annotation = depthSortedAnnotations.begin();
     float intervalSize = 1.0f / static_cast<float>(max(1, nIntervals));
     int i = static_cast<int>(renderList.size()) - 1;
+
+    if (reverseDepthFrame)
+    {
+        // Nothing drawn before has a depth in the reversed range
+        setReverseDepthState(true);
+        Renderer::PipelineState ps;
+        ps.depthMask = true;
+        setPipelineState(ps);
+        glClear(GL_DEPTH_BUFFER_BIT);
+    }
+
     for (int interval = 0; interval < nIntervals; interval++)
     {
         currentIntervalIndex = interval;
@@ -5250,7 +6247,11 @@ Renderer::renderSolarSystemObjects(const Observer &observer,
         // Set up a perspective projection using the current interval's near and
         // far clip planes.
         Matrix4f proj;
-        buildProjectionMatrix(proj, nearPlaneDistance, farPlaneDistance, observer.getZoom());
+        if (!reverseDepthFrame ||
+            !projectionMode->getReverseDepthProjectionMatrix(nearPlaneDistance, observer.getZoom(), proj))
+        {
+            buildProjectionMatrix(proj, nearPlaneDistance, farPlaneDistance, observer.getZoom());
+        }
         Matrices m = { &proj, &m_modelMatrix };
 
         setCurrentProjectionMatrix(proj);
@@ -5258,6 +6259,7 @@ Renderer::renderSolarSystemObjects(const Observer &observer,
         int firstInInterval = i;
 
         // Render just the opaque objects in the first pass
+        opaqueDrawOrder.clear();
         while (i >= 0 && renderList[i].farZ < depthPartitions[interval].nearZ)
         {
             // This interval should completely contain the item
@@ -5267,11 +6269,15 @@ Renderer::renderSolarSystemObjects(const Observer &observer,
             // Treat objects that are smaller than one pixel as transparent and
             // render them in the second pass.
             if (renderList[i].isOpaque && renderList[i].discSizeInPixels > 1.0f)
-                renderItem(renderList[i], observer, nearPlaneDistance, farPlaneDistance, m);
+                opaqueDrawOrder.push_back(i);
 
             i--;
         }
 
+        sortOpaqueItems();
+        for (int item : opaqueDrawOrder)
+            renderItem(renderList[item], observer, nearPlaneDistance, farPlaneDistance, m);
+
         // Render orbit paths
         if (!orbitPathList.empty())
         {
@@ -5335,6 +6341,8 @@ Renderer::renderSolarSystemObjects(const Observer &observer,
 
     // reset the depth range
     glDepthRange(0, 1);
+    if (reverseDepthFrame)
+        setReverseDepthState(false);
     setDefaultProjectionMatrix();
 }
 
@@ -10,38 +10,56 @@
 
 #pragma once
 
+#include <array>
+#include <cstdint>
+#include <limits>
 #include <list>
+#include <map>
 #include <memory>
+#include <optional>
 #include <string>
 #include <string_view>
+#include <utility>
 #include <vector>
 
 #include <Eigen/Core>
 
 #include <celengine/body.h>
+#include <celengine/labelplacer.h>
 #include <celengine/lightenv.h>
 #include <celengine/multitexture.h>
+#include <celengine/nearstartracker.h>
+#include <celengine/pickbuffer.h>
 #include <celengine/universe.h>
 #include <celengine/selection.h>
 #include <celengine/shadermanager.h>
+#include <celengine/shadowcones.h>
 #include <celengine/starcolors.h>
 #include <celengine/projectionmode.h>
+#include <celengine/qualitygovernor.h>
+#include <celengine/resolutionscaler.h>
 #include <celengine/rendcontext.h>
 #include <celengine/renderlistentry.h>
 #include <celengine/textlayout.h>
 #include <celimage/pixelformat.h>
 #include <celrender/rendererfwd.h>
+#include <celutil/framearena.h>
 #include "renderflags.h"
 
 class RendererWatcher;
 class FrameTree;
 class ReferenceMark;
 class CurvePlot;
+class OrbitCache;
+class OverlayImageCache;
 class PointStarVertexBuffer;
 class Observer;
 class Surface;
 class TextureFont;
+class TimelinePhase;
 class FramebufferObject;
+class FramebufferPool;
+class ShadowMapCache;
 
 namespace celestia
 {
@@ -85,6 +103,14 @@ struct SecondaryIlluminator
 };
 
 
+// Brightest secondary illuminator of a body
+struct Planetshine
+{
+    const SecondaryIlluminator* source{ nullptr };
+    float irradiance{ 0.0f };
+};
+
+
 enum class RenderMode
 {
     Fill = 0,
@@ -144,7 +170,21 @@ class Renderer
                 float faintestVisible,
                 const Selection& sel);
 
+    // The views rendered between beginMultiViewFrame and endMultiViewFrame
+    // share the work which doesn't depend on the camera: resource uploads
+    // and, when the observers are at the same time and close together, the
+    // search for nearby solar systems.
+    void beginMultiViewFrame(const Universe&, celestia::util::array_view<const Observer*>);
+    void endMultiViewFrame();
+    bool isMultiViewFrame() const { return multiViewFrame.active; }
+
     bool getInfo(std::map<std::string, std::string>& info) const;
+    // Counters of the last complete frame and the memory held by the
+    // renderer, for monitoring; memory sizes are in bytes
+    void getFrameStats(std::map<std::string, double>& stats) const;
+    // Add the memory of the textures, model buffers, font atlases and
+    // orbit cache to the report
+    void reportMemoryUsage(celestia::engine::MemoryReport&) const;
 
     RenderFlags getRenderFlags() const;
     void setRenderFlags(RenderFlags);
@@ -152,6 +192,9 @@ class Renderer
     void setLabelMode(RenderLabels);
     std::shared_ptr<celestia::engine::ProjectionMode> getProjectionMode() const;
     void setProjectionMode(std::shared_ptr<celestia::engine::ProjectionMode>);
+    // Render with another projection until called again with nullptr, as for
+    // the faces of a cube map, without counting it as a change of settings
+    void overrideProjectionMode(std::shared_ptr<celestia::engine::ProjectionMode>);
     float getAmbientLightLevel() const;
     void setAmbientLightLevel(float);
     float getTintSaturation() const;
@@ -188,6 +231,8 @@ class Renderer
     void setPipelineState(const PipelineState &ps) noexcept;
 
     celestia::engine::PixelFormat getPreferredCaptureFormat() const noexcept;
+    // True if the framebuffer is read top row first, see useMesaPackInvert
+    bool isPackInverted() const noexcept;
 
     void drawRectangle(const celestia::Rect& r,
                        FisheyeOverrideMode fishEyeOverrideMode,
@@ -200,7 +245,32 @@ class Renderer
     [[deprecated]] bool getVideoSync() const;
     [[deprecated]] void setVideoSync(bool);
     void setSolarSystemMaxDistance(float);
+    bool getGPUStarCulling() const;
+    void setGPUStarCulling(bool);
+    bool getReverseDepth() const;
+    void setReverseDepth(bool);
+    bool getLabelDeclutter() const;
+    void setLabelDeclutter(bool);
+    void setMaxLabels(unsigned);
+    void setGalaxyPointBudget(unsigned);
     void setShadowMapSize(unsigned);
+    // Number of shadow maps kept from frame to frame, 0 to draw them for
+    // each model in every frame
+    void setShadowMapCacheSize(unsigned);
+
+    // Lower the detail when frames take longer than the target time of the
+    // limits, and raise it back to the best values of the limits when they
+    // are fast again
+    void setQualityLimits(const celestia::engine::QualityLimits&);
+    const celestia::engine::QualityGovernor& getQualityGovernor() const { return m_qualityGovernor; }
+    // Draw the scene at a fraction of the view size, down to minScale, when
+    // the GPU takes longer than gpuTime milliseconds; 0 disables it
+    void setDynamicResolution(double gpuTime, float minScale);
+    const celestia::engine::ResolutionScaler& getResolutionScaler() const { return m_resolutionScaler; }
+    // Fraction of the view size the scene should be drawn at
+    float getRenderScale() const { return m_resolutionScaler.getScale(); }
+    // Adjust the detail and the render scale for the last complete frame
+    void updateQuality();
 
     bool captureFrame(int, int, int, int, celestia::engine::PixelFormat format, unsigned char*) const;
 
@@ -209,6 +279,17 @@ class Renderer
                       const Color &color,
                       const Matrices &m);
 
+    // A marker queued by addMarkerInstance
+    struct MarkerInstance
+    {
+        // Position in pixels and depth, and the scale of the symbol
+        Eigen::Vector4f position;
+        Color color;
+        // Not read by the shader
+        celestia::MarkerRepresentation::Symbol symbol;
+        float size;
+    };
+
     celestia::util::array_view<const Star*> getNearStars() const
     {
         return nearStars;
@@ -287,17 +368,23 @@ class Renderer
 
     struct Annotation
     {
-        std::string labelText;
+        // Stored in the label arena until the end of the frame
+        std::string_view labelText;
         const celestia::MarkerRepresentation* markerRep;
         Color color;
         Eigen::Vector3f position;
         LabelHorizontalAlignment halign : 3;
         LabelVerticalAlignment valign : 3;
         float size;
+        // Labels with a lower value are placed first when decluttering
+        float priority;
 
         bool operator<(const Annotation&) const;
     };
 
+    // Priority of the labels which are shown even if they overlap others
+    static constexpr float AlwaysShowLabel = -std::numeric_limits<float>::infinity();
+
     void addForegroundAnnotation(const celestia::MarkerRepresentation* markerRep,
                                  std::string_view labelText,
                                  Color color,
@@ -311,7 +398,8 @@ class Renderer
                                  const Eigen::Vector3f& position,
                                  LabelHorizontalAlignment halign = LabelHorizontalAlignment::Start,
                                  LabelVerticalAlignment valign = LabelVerticalAlignment::Bottom,
-                                 float size = 0.0f);
+                                 float size = 0.0f,
+                                 float priority = AlwaysShowLabel);
     void addSortedAnnotation(const celestia::MarkerRepresentation* markerRep,
                              std::string_view labelText,
                              Color color,
@@ -320,8 +408,26 @@ class Renderer
                              LabelVerticalAlignment valign = LabelVerticalAlignment::Bottom,
                              float size = 0.0f);
 
+    // Record an object drawn as a disc at the camera relative position for
+    // picking, if the frame is recorded
+    void addPickTarget(celestia::engine::PickBuffer::Layer layer,
+                       const Selection& sel,
+                       const Eigen::Vector3f& position,
+                       float radiusInPixels,
+                       float depth,
+                       bool exact);
+    // The objects drawn in the last frame rendered for the observer, or
+    // nullptr if it wasn't recorded
+    const celestia::engine::PickBuffer* getPickBuffer(const Observer& observer) const;
+
     ShaderManager& getShaderManager() const { return *shaderManager; }
 
+    // True while the current frame is drawn with a reversed depth range
+    bool usesReverseDepth() const { return reverseDepthFrame; }
+    // Switch the clip control, depth test and depth clear value between the
+    // reversed and the conventional depth range
+    void setReverseDepthState(bool reversed);
+
     // Callbacks for renderables; these belong in a special renderer interface
     // only visible in object's render methods.
     void beginObjectAnnotations();
@@ -330,7 +436,8 @@ class Renderer
                              Color,
                              const Eigen::Vector3f&,
                              LabelHorizontalAlignment halign,
-                             LabelVerticalAlignment valign);
+                             LabelVerticalAlignment valign,
+                             float priority = AlwaysShowLabel);
     void endObjectAnnotations();
     Eigen::Quaternionf getCameraOrientationf() const;
     Eigen::Quaterniond getCameraOrientation() const;
@@ -340,6 +447,7 @@ class Renderer
     float getNearPlaneDistance() const;
 
     void invalidateOrbitCache();
+    OverlayImageCache& getOverlayImageCache() { return *overlayImageCache; }
 
     struct OrbitPathListEntry
     {
@@ -365,12 +473,20 @@ class Renderer
 
     bool settingsHaveChanged() const;
     void markSettingsChanged();
+    // Whether shaders, textures or models are being prepared in the
+    // background, to be picked up by the next frames
+    bool hasPendingResources() const;
 
     void addWatcher(RendererWatcher*);
     void removeWatcher(RendererWatcher*);
     void notifyWatchers() const;
 
     FramebufferObject* getShadowFBO(int) const;
+    ShadowMapCache* getShadowMapCache() const;
+    FramebufferPool& getFramebufferPool() const { return *m_framebufferPool; }
+    std::uint32_t getFrameCount() const { return frameCount; }
+    // Nothing when timer queries aren't available
+    celestia::render::GPUStageTimer* getGPUStageTimer();
 
  public:
     struct RenderProperties
@@ -396,6 +512,7 @@ class Renderer
  private:
     void setFieldOfView(float);
     void renderPointStars(const StarDatabase& starDB,
+                          const DSODatabase* dsoDB,
                           float faintestVisible,
                           const Observer& observer);
     void renderDeepSkyObjects(const Universe&,
@@ -411,18 +528,50 @@ class Renderer
     void renderBoundaries(const Universe&, float, const Matrices&);
     void renderCrosshair(float size, double tsec, const Color &color, const Matrices &m);
 
+    bool addMarkerInstance(celestia::MarkerRepresentation::Symbol symbol,
+                           float size,
+                           const Color &color,
+                           const Eigen::Vector3f &position);
+    void renderMarkerInstances();
+
     void buildNearSystemsLists(const Universe &universe,
                                const Observer &observer,
                                const celestia::math::InfiniteFrustum &xfrustum,
                                double jd);
 
+    struct RenderListParameters;
+
+    // Results of the culling tests for the bodies of a frame tree level
+    struct RenderListCandidates
+    {
+        struct Entry
+        {
+            RenderListEntry rle;
+            bool isLabeled;
+        };
+
+        struct Subtree
+        {
+            const FrameTree* tree;
+        };
+
+        void append(const RenderListCandidates&);
+
+        std::vector<Entry> entries;
+        std::vector<SecondaryIlluminator> secondaryIlluminators;
+        std::vector<Subtree> subtrees;
+    };
+
     void buildRenderLists(const Eigen::Vector3d& astrocentricObserverPos,
                           const celestia::math::InfiniteFrustum& viewFrustum,
                           const Eigen::Vector3d& viewPlaneNormal,
-                          const Eigen::Vector3d& frameCenter,
                           const FrameTree* tree,
-                          const Observer& observer,
                           double now);
+    void buildRenderLists(const RenderListParameters& params,
+                          const FrameTree* tree);
+    void cullRenderListPhase(const RenderListParameters& params,
+                             const TimelinePhase* phase,
+                             RenderListCandidates& candidates) const;
     void buildOrbitLists(const Eigen::Vector3d& astrocentricObserverPos,
                          const Eigen::Quaterniond& observerOrientation,
                          const celestia::math::InfiniteFrustum& viewFrustum,
@@ -431,6 +580,10 @@ class Renderer
     void buildLabelLists(const celestia::math::InfiniteFrustum& viewFrustum,
                          double now);
     int buildDepthPartitions();
+    bool beginReverseDepthFrame();
+    void endReverseDepthFrame();
+    // Collect the GPU times which are available and time the current view
+    void beginGPUTimer();
 
 
     void addRenderListEntries(RenderListEntry& rle,
@@ -442,6 +595,8 @@ class Renderer
                                   double now);
 
     void removeInvisibleItems(const celestia::math::InfiniteFrustum &frustum);
+    celestia::engine::PickBuffer* selectPickBuffer(const Observer& observer);
+    void addRenderListPickTargets();
 
     void renderObject(const Eigen::Vector3f& pos,
                       float distance,
@@ -502,6 +657,9 @@ class Renderer
                                 const Eigen::Vector3d& bodyPosition,
                                 const Eigen::Quaterniond& bodyOrientation);
 
+    // Group the opaque items sharing a model for drawing
+    void sortOpaqueItems();
+
     // Render an item from the render list
     void renderItem(const RenderListEntry& rle,
                     const Observer& observer,
@@ -509,11 +667,22 @@ class Renderer
                     float farPlaneDistance,
                     const Matrices&);
 
+    bool isShadowCaster(const Body& body, double now) const;
+    const celestia::engine::ShadowConeSet& getShadowCones(const PlanetarySystem& system,
+                                                          unsigned int sourceIndex,
+                                                          const Eigen::Vector3d& lightPosition,
+                                                          double now);
     bool testEclipse(const Body& receiver,
-                     const Body& caster,
+                     const Eigen::Vector3d& receiverPosition,
+                     const celestia::engine::ShadowCone& caster,
                      LightingState& lightingState,
-                     unsigned int lightIndex,
-                     double now);
+                     unsigned int lightIndex) const;
+    void setupPlanetshine();
+    Planetshine computePlanetshine(const Body& body, const Eigen::Vector3f& pos) const;
+    Planetshine getPlanetshine(const Body& body, const Eigen::Vector3f& pos) const;
+    void updateLightingCache(double now);
+    bool restoreShadows(const Body& body, LightingState& lightingState);
+    void storeShadows(const Body& body, const LightingState& lightingState);
 
     void labelConstellations(const AsterismList& asterisms,
                              const Observer& observer);
@@ -528,7 +697,9 @@ class Renderer
                        LabelHorizontalAlignment halign = LabelHorizontalAlignment::Start,
                        LabelVerticalAlignment = LabelVerticalAlignment::Bottom,
                        float size = 0.0f,
-                       bool special = false);
+                       bool special = false,
+                       float priority = AlwaysShowLabel);
+    void declutterAnnotations(std::vector<Annotation>&, const TextureFont*);
     void renderAnnotationMarker(const Annotation &a,
                                 celestia::engine::TextLayout &layout,
                                 float depth,
@@ -595,6 +766,7 @@ class Renderer
     std::vector<std::shared_ptr<TextureFont>> fonts{FontCount, nullptr};
 
     std::shared_ptr<celestia::engine::ProjectionMode> projectionMode{ nullptr };
+    std::shared_ptr<celestia::engine::ProjectionMode> overriddenProjectionMode{ nullptr };
     int renderMode;
     RenderLabels labelMode{ RenderLabels::NoLabels };
     bool rtl{ false };
@@ -620,16 +792,58 @@ class Renderer
     Eigen::Matrix3d m_cameraTransform{ Eigen::Matrix3d::Identity() };
     PointStarVertexBuffer* pointStarVertexBuffer;
     PointStarVertexBuffer* glareVertexBuffer;
+    StarVisibilityCache starVisibilityCache;
     std::vector<RenderListEntry> renderList;
+    // Render list indices of the opaque items of a depth partition, in the
+    // order they are drawn
+    std::vector<int> opaqueDrawOrder;
     std::vector<SecondaryIlluminator> secondaryIlluminators;
+    // Planetshine of the bodies of the render list, sorted by body
+    std::vector<std::pair<const Body*, Planetshine>> planetshine;
     std::vector<DepthBufferPartition> depthPartitions;
     std::vector<Annotation> backgroundAnnotations;
     std::vector<Annotation> foregroundAnnotations;
     std::vector<Annotation> depthSortedAnnotations;
     std::vector<Annotation> objectAnnotations;
+    // Text of the annotations, reset at the start of each view
+    celestia::util::FrameArena labelArena;
+    // Label texts converted for the fonts
+    celestia::engine::TextLineCache labelLineCache;
     std::vector<OrbitPathListEntry> orbitPathList;
     LightingState::EclipseShadowVector eclipseShadows[MaxLights];
+    // Shadow cones of the planetary systems for each light source, built
+    // for the current frame when a body of the system is drawn
+    std::map<std::pair<const PlanetarySystem*, unsigned int>, celestia::engine::ShadowConeSet> m_shadowCones;
+
+    // Eclipse and ring shadows of the bodies drawn at the simulation time of
+    // the cache. They don't depend on the observer, so they are kept while
+    // the time is paused, or across the views of a frame.
+    struct LightingCacheEntry
+    {
+        std::uint32_t lastUsed{ 0 };
+        unsigned int nLights{ 0 };
+        std::array<unsigned int, MaxLights> sourceIndices;
+        std::array<bool, MaxLights> castsShadows;
+        std::array<LightingState::EclipseShadowVector, MaxLights> shadows;
+        std::array<RingShadow, MaxLights> ringShadows;
+    };
+    std::map<const Body*, LightingCacheEntry> m_lightingCache;
+    std::optional<double> m_lightingCacheTime;
+    RenderFlags m_lightingCacheFlags{ RenderFlags::ShowNothing };
+    BodyClassification m_lightingCacheMask{ BodyClassification::EmptyMask };
     std::vector<const Star*> nearStars;
+    celestia::engine::NearStarTracker nearStarTracker;
+
+    struct MultiViewFrame
+    {
+        bool active{ false };
+        bool resourcesUpdated{ false };
+        bool shareNearStars{ false };
+        double time{ 0.0 };
+        // Stars within SolarSystemMaxDistance of any of the observers
+        std::vector<const Star*> nearStars;
+    };
+    MultiViewFrame multiViewFrame;
 
     std::vector<LightSource> lightSourceList;
 
@@ -652,9 +866,8 @@ class Renderer
 
     std::array<int, 4> m_viewport { 0, 0, 0, 0 };
 
-    typedef std::map<const celestia::ephem::Orbit*, CurvePlot*> OrbitCache;
-    OrbitCache orbitCache;
-    uint32_t lastOrbitCacheFlush;
+    std::unique_ptr<OrbitCache> orbitCache;
+    std::unique_ptr<OverlayImageCache> overlayImageCache;
 
     float minOrbitSize;
     float distanceLimit;
@@ -678,14 +891,63 @@ class Renderer
     // visibility culling of solar systems.
     float SolarSystemMaxDistance{ 1.0f };
 
+    // Draw the faint distant stars from the GPU resident star catalog
+    bool gpuStarCulling{ false };
+
+    // Draw the solar system objects into a floating point depth buffer with
+    // a reversed depth range, in a single depth buffer partition
+    bool reverseDepth{ false };
+    bool reverseDepthFrame{ false };
+    std::array<int, 4> reverseDepthViewport{ 0, 0, 0, 0 };
+    std::unique_ptr<celestia::render::ReverseDepthTarget> m_reverseDepthTarget;
+
+    // Drop the labels which overlap more important ones, and keep at most
+    // maxLabels labels in each set of annotations (0 means no limit)
+    bool labelDeclutter{ false };
+    unsigned maxLabels{ 0 };
+    celestia::engine::LabelPlacer labelPlacer;
+
+    struct ObserverPickBuffer
+    {
+        // Only compared, the observer may be gone
+        const Observer* observer;
+        bool valid;
+        celestia::engine::PickBuffer buffer;
+    };
+
+    // One buffer for each of the recently rendered observers
+    static constexpr std::size_t MaxPickBuffers = 8;
+    std::vector<ObserverPickBuffer> m_pickBuffers;
+    std::size_t m_nextPickBuffer{ 0 };
+    celestia::engine::PickBuffer* m_pickBuffer{ nullptr };
+
+    // Render targets of the views, the shadows and the captures
+    std::unique_ptr<FramebufferPool> m_framebufferPool;
+
     // Size of a texture used in shadow mapping
     unsigned m_shadowMapSize { 0 };
-    std::unique_ptr<FramebufferObject> m_shadowFBO;
+    std::shared_ptr<FramebufferObject> m_shadowFBO;
+    unsigned m_shadowMapCacheSize { 4 };
+    std::unique_ptr<ShadowMapCache> m_shadowMapCache;
+
+    celestia::engine::QualityGovernor m_qualityGovernor;
+    celestia::engine::ResolutionScaler m_resolutionScaler;
+    // Added to the faintest magnitude by the quality governor
+    float m_magnitudeOffset{ 0.0f };
 
     std::unique_ptr<celestia::gl::VertexObject> m_markerVO;
     std::unique_ptr<celestia::gl::Buffer> m_markerBO;
     bool m_markerDataInitialized{ false };
 
+    // Markers of the annotations being rendered, drawn with one instanced
+    // call per symbol
+    std::vector<MarkerInstance> m_markerInstances;
+    std::unique_ptr<celestia::gl::Buffer> m_markerInstanceBO;
+    std::unique_ptr<celestia::gl::Buffer> m_hollowMarkerBO;
+    std::unique_ptr<celestia::gl::VertexObject> m_filledMarkerInstanceVO;
+    std::unique_ptr<celestia::gl::VertexObject> m_hollowMarkerInstanceVO;
+    bool m_markerInstancesInitialized{ false };
+
     // Saturation magnitude used to calculate a point star size
     float satPoint;
 
@@ -696,6 +958,10 @@ class Renderer
     std::unique_ptr<celestia::render::EclipticLineRenderer> m_eclipticLineRenderer;
     std::unique_ptr<celestia::render::GalaxyRenderer> m_galaxyRenderer;
     std::unique_ptr<celestia::render::GlobularRenderer> m_globularRenderer;
+    std::unique_ptr<celestia::render::GPUProfiler> m_gpuProfiler;
+    std::unique_ptr<celestia::render::GPUStageTimer> m_gpuStageTimer;
+    std::unique_ptr<celestia::render::GPUStarRenderer> m_gpuStarRenderer;
+    std::unique_ptr<celestia::render::GPUTimer> m_gpuTimer;
     std::unique_ptr<celestia::render::LargeStarRenderer> m_largeStarRenderer;
     std::unique_ptr<celestia::render::LineRenderer> m_hollowMarkerRenderer;
     std::unique_ptr<celestia::render::NebulaRenderer> m_nebulaRenderer;
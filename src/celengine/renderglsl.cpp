@@ -38,6 +38,7 @@
 #include "renderglsl.h"
 #include "renderinfo.h"
 #include "shadermanager.h"
+#include "shadowmapcache.h"
 #include "shadowmap.h" // GL_ONLY_SHADOWS definition
 #include "texture.h"
 
@@ -81,6 +82,11 @@ void renderGeometryShadow_GLSL(Geometry* geometry,
     if (prog == nullptr)
         return;
 
+    // The shadow map is drawn and sampled with the conventional depth range
+    bool reverseDepth = renderer->usesReverseDepth();
+    if (reverseDepth)
+        renderer->setReverseDepthState(false);
+
     GLint oldFboId;
     glGetIntegerv(GL_FRAMEBUFFER_BINDING, &oldFboId);
     shadowFbo->bind();
@@ -116,6 +122,9 @@ void renderGeometryShadow_GLSL(Geometry* geometry,
     glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
     glCullFace(GL_BACK);
     shadowFbo->unbind(oldFboId);
+
+    if (reverseDepth)
+        renderer->setReverseDepthState(true);
 }
 
 } // end unnamed namespace
@@ -370,14 +379,30 @@ void renderGeometry_GLSL(Geometry* geometry,
                          float geometryScale,
                          RenderFlags renderFlags,
                          const Eigen::Quaternionf& planetOrientation,
+                         const math::Frustum& frustum,
                          double tsec,
                          const Matrices &m,
                          Renderer* renderer)
 {
     auto *shadowBuffer = renderer->getShadowFBO(0);
-    Eigen::Matrix4f lightMatrix(Eigen::Matrix4f::Identity());
+    Eigen::Matrix4f shadowLightMatrix(Eigen::Matrix4f::Identity());
+    Eigen::Matrix4f *lightMatrix = &shadowLightMatrix;
+    bool drawShadowMap = true;
 
-    if (shadowBuffer != nullptr && shadowBuffer->isValid())
+    // Use the kept shadow map of the model when there is one, the shared
+    // one is drawn for each model
+    if (auto *shadowMapCache = renderer->getShadowMapCache(); shadowMapCache != nullptr)
+    {
+        auto shadowMap = shadowMapCache->get(geometry, ls.lights[0].direction_obj, renderer->getFrameCount());
+        if (shadowMap.fbo != nullptr)
+        {
+            shadowBuffer = shadowMap.fbo;
+            lightMatrix = shadowMap.lightMatrix;
+            drawShadowMap = shadowMap.needsUpdate;
+        }
+    }
+
+    if (drawShadowMap && shadowBuffer != nullptr && shadowBuffer->isValid())
     {
         std::array<int, 4> viewport;
         renderer->getViewport(viewport);
@@ -397,7 +422,7 @@ void renderGeometry_GLSL(Geometry* geometry,
 #endif
 
         renderGeometryShadow_GLSL(geometry, shadowBuffer, ls, 0,
-                                  tsec, renderer, &lightMatrix);
+                                  tsec, renderer, lightMatrix);
         renderer->setViewport(viewport);
 #ifdef DEPTH_BUFFER_DEBUG
         glDisable(GL_DEPTH_TEST);
@@ -449,11 +474,13 @@ void renderGeometry_GLSL(Geometry* geometry,
 
     if (shadowBuffer != nullptr && shadowBuffer->isValid())
     {
-        rc.setShadowMap(shadowBuffer->depthTexture(), shadowBuffer->width(), &lightMatrix);
+        rc.setShadowMap(shadowBuffer->depthTexture(), shadowBuffer->width(), lightMatrix);
     }
 
     rc.setCameraOrientation(ri.orientation);
     rc.setPointScale(ri.pointScale);
+    rc.setPixelScale(ri.geometryPixelScale);
+    rc.setFrustum(&frustum);
 
     // Handle extended material attributes (per model only, not per submesh)
     rc.setLunarLambert(ri.lunarLambert);
@@ -494,12 +521,15 @@ void renderGeometry_GLSL_Unlit(Geometry* geometry,
                                float geometryScale,
                                RenderFlags /* renderFlags */,
                                const Eigen::Quaternionf& /* planetOrientation */,
+                               const math::Frustum& frustum,
                                double tsec,
                                const Matrices &m,
                                Renderer* renderer)
 {
     GLSLUnlit_RenderContext rc(renderer, geometryScale, m.modelview, m.projection);
     rc.setPointScale(ri.pointScale);
+    rc.setPixelScale(ri.geometryPixelScale);
+    rc.setFrustum(&frustum);
 
     Renderer::PipelineState ps;
     ps.depthMask = true;
@@ -54,6 +54,7 @@ void renderGeometry_GLSL(Geometry* geometry,
                          float geometryScale,
                          RenderFlags renderFlags,
                          const Eigen::Quaternionf& planetOrientation,
+                         const celestia::math::Frustum& frustum,
                          double tsec,
                          const Matrices &m,
                          Renderer* renderer);
@@ -78,6 +79,7 @@ void renderGeometry_GLSL_Unlit(Geometry* geometry,
                                float geometryScale,
                                RenderFlags renderFlags,
                                const Eigen::Quaternionf& planetOrientation,
+                               const celestia::math::Frustum& frustum,
                                double tsec,
                                const Matrices &m,
                                Renderer* renderer);
@@ -39,6 +39,8 @@ struct RenderInfo
     Eigen::Quaternionf orientation{ Eigen::Quaternionf::Identity() };
     float pixWidth{ 1.0f };
     float pointScale{ 1.0f };
+    // Size in pixels of one unit of the geometry at the nearest point
+    float geometryPixelScale{ 0.0f };
 };
 
 extern LODSphereMesh* g_lodSphere;
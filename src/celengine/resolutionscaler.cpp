@@ -0,0 +1,88 @@
+// resolutionscaler.cpp
+//
+// Copyright (C) 2026, Celestia Development Team
+//
+// Scale of the resolution the scene is drawn at, to hold a GPU frame time.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include "resolutionscaler.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace celestia::engine
+{
+
+namespace
+{
+
+// Weight of the last frame in the smoothed GPU time
+constexpr double GPUTimeWeight = 0.2;
+
+// The GPU time is measured one or two frames late, so the scale is kept
+// for a few frames before the next change
+constexpr std::uint32_t AdjustAfterFrames = 10;
+
+// Fraction of the target by which the GPU time must miss it
+constexpr double Tolerance = 0.1;
+
+} // end unnamed namespace
+
+void
+ResolutionScaler::setTarget(double target, float minScale)
+{
+    m_target = target;
+    m_minScale = std::clamp(minScale, ScaleStep, 1.0f);
+    reset();
+}
+
+bool
+ResolutionScaler::update(const FrameCounters& counters)
+{
+    if (!isEnabled() || !counters.gpuTime.has_value() || *counters.gpuTime <= 0.0)
+        return false;
+
+    m_gpuTime = m_gpuTime > 0.0
+        ? m_gpuTime + (*counters.gpuTime - m_gpuTime) * GPUTimeWeight
+        : *counters.gpuTime;
+    if (++m_framesAtScale < AdjustAfterFrames)
+        return false;
+
+    float scale = m_scale;
+    if (m_gpuTime > m_target * (1.0 + Tolerance))
+    {
+        // Go straight to the scale which would meet the target
+        auto wanted = m_scale * static_cast<float>(std::sqrt(m_target / m_gpuTime));
+        scale = std::max(std::floor(wanted / ScaleStep) * ScaleStep, m_minScale);
+    }
+    else if (m_scale < 1.0f)
+    {
+        // Raise the scale only when the time at the next step would still
+        // be under the target, so that it doesn't go back and forth
+        float next = std::min(m_scale + ScaleStep, 1.0f);
+        double ratio = static_cast<double>(next) / static_cast<double>(m_scale);
+        if (m_gpuTime * ratio * ratio < m_target)
+            scale = next;
+    }
+
+    if (std::abs(scale - m_scale) < ScaleStep * 0.5f)
+        return false;
+
+    m_scale = scale;
+    m_framesAtScale = 0;
+    return true;
+}
+
+void
+ResolutionScaler::reset()
+{
+    m_scale = 1.0f;
+    m_gpuTime = 0.0;
+    m_framesAtScale = 0;
+}
+
+} // end namespace celestia::engine
@@ -0,0 +1,57 @@
+// resolutionscaler.h
+//
+// Copyright (C) 2026, Celestia Development Team
+//
+// Scale of the resolution the scene is drawn at, to hold a GPU frame time.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <cstdint>
+
+#include "framestats.h"
+
+namespace celestia::engine
+{
+
+// Picks the fraction of the view size the scene is drawn at from the GPU
+// time of the last frames, assuming that the time is proportional to the
+// number of pixels drawn. The scale moves in steps, so that the render
+// targets of the views are reused from the pool rather than resized in
+// every frame. It is lowered as soon as the GPU time misses the target,
+// and raised one step at a time while the time at the next step would
+// still meet it.
+class ResolutionScaler
+{
+public:
+    static constexpr float ScaleStep = 0.05f;
+
+    ResolutionScaler() = default;
+
+    // Milliseconds of GPU time; 0 disables the scaling
+    double getTarget() const { return m_target; }
+    void setTarget(double target, float minScale);
+    bool isEnabled() const { return m_target > 0.0; }
+
+    // Check a complete frame; returns true when the scale changed
+    bool update(const FrameCounters&);
+
+    float getScale() const { return m_scale; }
+    // Milliseconds of GPU time smoothed over the last frames
+    double getGPUTime() const { return m_gpuTime; }
+
+    void reset();
+
+private:
+    double m_target{ 0.0 };
+    float m_minScale{ 0.5f };
+    float m_scale{ 1.0f };
+    double m_gpuTime{ 0.0 };
+    std::uint32_t m_framesAtScale{ 0 };
+};
+
+} // end namespace celestia::engine
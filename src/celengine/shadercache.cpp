@@ -0,0 +1,175 @@
+// shadercache.cpp
+//
+// Copyright (C) 2024, Celestia Development Team
+//
+// On-disk cache of linked shader program binaries.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include "shadercache.h"
+
+#include <fstream>
+#include <system_error>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include <celutil/atomicfile.h>
+#include <celutil/binaryread.h>
+#include <celutil/binarywrite.h>
+#include <celutil/hash.h>
+#include "glshader.h"
+#include "glsupport.h"
+
+namespace celestia::engine
+{
+
+namespace
+{
+
+// Larger binaries are taken for a corrupted file
+constexpr std::uint32_t MaxBinarySize = 64U * 1024U * 1024U;
+
+std::string_view
+GetGLString(GLenum name)
+{
+    const auto* s = reinterpret_cast<const char*>(glGetString(name));
+    return s == nullptr ? std::string_view() : std::string_view(s);
+}
+
+} // end unnamed namespace
+
+ShaderCache::ShaderCache(const fs::path& directory) :
+    m_directory(directory),
+    m_driverId(fmt::format("{}\n{}\n{}",
+                           GetGLString(GL_VENDOR),
+                           GetGLString(GL_RENDERER),
+                           GetGLString(GL_VERSION)))
+{
+}
+
+bool
+ShaderCache::isSupported()
+{
+#ifdef GL_ES
+    if (!gl::checkVersion(gl::GLES_3))
+        return false;
+#else
+    if (!gl::ARB_get_program_binary)
+        return false;
+#endif
+
+    // Drivers may expose the entry points without any binary format
+    GLint formatCount = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+    return formatCount > 0;
+}
+
+std::uint64_t
+ShaderCache::computeKey(std::string_view vs,
+                        std::string_view gs,
+                        std::string_view fs)
+{
+    util::FNV1aHash hash;
+    hash.addValue(Version);
+
+    // Hash the lengths too, so that moving text between the stages changes
+    // the key
+    for (std::string_view source : { vs, gs, fs })
+    {
+        hash.addValue(static_cast<std::uint64_t>(source.size()));
+        hash.addBytes(source);
+    }
+
+    return hash.value();
+}
+
+void
+ShaderCache::setRetrievable(const GLProgram& prog)
+{
+    glProgramParameteri(prog.getID(), GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+}
+
+fs::path
+ShaderCache::getPath(std::uint64_t key) const
+{
+    return m_directory / fmt::format("{:016x}.bin", key);
+}
+
+GLProgram*
+ShaderCache::load(std::uint64_t key) const
+{
+    std::ifstream in(getPath(key), std::ios::binary);
+    if (!in.good())
+        return nullptr;
+
+    char magic[Magic.size()]; //NOSONAR
+    if (!in.read(magic, Magic.size()).good() || std::string_view(magic, Magic.size()) != Magic) /* Flawfinder: ignore */
+        return nullptr;
+
+    std::uint32_t version;
+    std::uint64_t fileKey;
+    std::uint32_t driverIdSize;
+    if (!util::readNative(in, version) || version != Version ||
+        !util::readNative(in, fileKey) || fileKey != key ||
+        !util::readNative(in, driverIdSize) || driverIdSize != m_driverId.size())
+    {
+        return nullptr;
+    }
+
+    std::string driverId(driverIdSize, '\0');
+    if (!in.read(driverId.data(), driverIdSize).good() || driverId != m_driverId) /* Flawfinder: ignore */
+        return nullptr;
+
+    std::uint32_t format;
+    std::uint32_t binarySize;
+    if (!util::readNative(in, format) ||
+        !util::readNative(in, binarySize) ||
+        binarySize == 0 || binarySize > MaxBinarySize)
+    {
+        return nullptr;
+    }
+
+    std::vector<char> binary(binarySize);
+    if (!in.read(binary.data(), binarySize).good()) /* Flawfinder: ignore */
+        return nullptr;
+
+    GLProgram* prog = nullptr;
+    if (GLShaderLoader::CreateProgram(static_cast<GLenum>(format), binary, &prog) != GLShaderStatus::OK)
+        return nullptr;
+
+    return prog;
+}
+
+bool
+ShaderCache::save(std::uint64_t key, const GLProgram& prog) const
+{
+    GLenum format = 0;
+    std::vector<char> binary;
+    if (!prog.getBinary(format, binary) || binary.size() > MaxBinarySize)
+        return false;
+
+    std::error_code ec;
+    fs::create_directories(m_directory, ec);
+
+    util::AtomicFile file(getPath(key));
+    if (!file.isOpen())
+        return false;
+
+    std::ofstream& out = file.stream();
+    out.write(Magic.data(), Magic.size());
+    bool ok = util::writeNative(out, Version) &&
+              util::writeNative(out, key) &&
+              util::writeNative(out, static_cast<std::uint32_t>(m_driverId.size())) &&
+              out.write(m_driverId.data(), m_driverId.size()).good() &&
+              util::writeNative(out, static_cast<std::uint32_t>(format)) &&
+              util::writeNative(out, static_cast<std::uint32_t>(binary.size())) &&
+              out.write(binary.data(), binary.size()).good();
+
+    return ok && file.commit();
+}
+
+} // end namespace celestia::engine
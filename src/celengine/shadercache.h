@@ -0,0 +1,59 @@
+// shadercache.h
+//
+// Copyright (C) 2024, Celestia Development Team
+//
+// On-disk cache of linked shader program binaries.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include <celcompat/filesystem.h>
+
+class GLProgram;
+
+namespace celestia::engine
+{
+
+// The ShaderCache keeps one file per program in its directory, named after
+// a hash of the program sources. Each file also records the vendor, renderer
+// and version strings of the driver which produced the binary; a file written
+// by another driver is ignored and replaced on the next save.
+class ShaderCache
+{
+public:
+    // The GL context must be current
+    explicit ShaderCache(const fs::path& directory);
+
+    static bool isSupported();
+
+    static std::uint64_t computeKey(std::string_view vs,
+                                    std::string_view gs,
+                                    std::string_view fs);
+
+    // Call before linking a program which is going to be saved
+    static void setRetrievable(const GLProgram&);
+
+    // Returns nullptr if there is no usable binary for the key
+    GLProgram* load(std::uint64_t key) const;
+
+    bool save(std::uint64_t key, const GLProgram&) const;
+
+private:
+    static constexpr std::string_view Magic{ "CELSHBIN" };
+    static constexpr std::uint32_t Version = 1;
+
+    fs::path getPath(std::uint64_t key) const;
+
+    fs::path m_directory;
+    std::string m_driverId;
+};
+
+} // end namespace celestia::engine
@@ -14,8 +14,10 @@
 #include <cassert>
 #include <cstddef>
 #include <cmath>
+#include <cstdint>
 #include <fstream>
 #include <iomanip>
+#include <iterator>
 #include <optional>
 #include <ostream>
 #include <sstream>
@@ -27,15 +29,21 @@
 #include <fmt/format.h>
 
 #include <celcompat/filesystem.h>
+#include <celutil/atomicfile.h>
+#include <celutil/binaryread.h>
+#include <celutil/binarywrite.h>
 #include <celutil/flag.h>
 #include <celutil/logger.h>
 #include "atmosphere.h"
+#include "framestats.h"
 #include "glsupport.h"
 #include "lightenv.h"
+#include "shadercache.h"
 
 
 using celestia::util::GetLogger;
 using namespace std::string_view_literals;
+namespace engine = celestia::engine;
 namespace gl = celestia::gl;
 namespace util = celestia::util;
 
@@ -153,10 +161,24 @@ constexpr std::string_view LineVertexPosition = R"glsl(
     gl_Position = vec4((thisPos.xy + transform) * thisPos.w, thisPos.zw);
 )glsl"sv;
 
+// The end of the segment and the side of the line are given by the corner
+// of the quad, the end points by the instance
+constexpr std::string_view LineInstanceVertexPosition = R"glsl(
+    vec4 thisPos = calc_vp(mix(in_Position, in_PositionNext, in_LineCorner.x));
+    vec4 nextPos = calc_vp(mix(in_PositionNext, in_Position, in_LineCorner.x));
+    thisPos.xy /= thisPos.w;
+    nextPos.xy /= nextPos.w;
+    vec2 transform = normalize(nextPos.xy - thisPos.xy);
+    transform = vec2(transform.y * lineWidthX, -transform.x * lineWidthY) * in_LineCorner.y;
+    gl_Position = vec4((thisPos.xy + transform) * thisPos.w, thisPos.zw);
+)glsl"sv;
+
 std::string_view
 VertexPosition(const ShaderProperties& props)
 {
-    return util::is_set(props.texUsage, TexUsage::LineAsTriangles) ? LineVertexPosition : NormalVertexPosition;
+    if (!util::is_set(props.texUsage, TexUsage::LineAsTriangles))
+        return NormalVertexPosition;
+    return util::is_set(props.texUsage, TexUsage::LineInstances) ? LineInstanceVertexPosition : LineVertexPosition;
 }
 
 constexpr std::string_view FragmentHeader = ""sv;
@@ -785,6 +807,57 @@ AtmosphericEffects(const ShaderProperties& props)
 }
 
 
+// Look up the single scattering along the view ray in the precomputed tables
+// of the atmosphere; AtmosphereTables describes their parameterization.
+std::string
+ScatteringTableEffects(const ShaderProperties& /*props*/)
+{
+    std::string source;
+
+    source += "{\n";
+    // The view ray starts where it enters the atmosphere, or at the eye when
+    // it is inside; the tables are in units of the atmosphere radius.
+    source += "    vec3 viewDir = -eyeDir;\n";
+    source += "    float rq = dot(eyePosition, viewDir);\n";
+    source += "    float qq = dot(eyePosition, eyePosition) - atmosphereRadius.y;\n";
+    source += "    float d = sqrt(max(rq * rq - qq, 0.0));\n";
+    source += "    vec3 atmEnter = (eyePosition + max(0.0, -rq - d) * viewDir) / atmosphereRadius.x;\n";
+    source += "    float rg = atmosphereRadius.z / atmosphereRadius.x;\n";
+    source += "    float r = clamp(length(atmEnter), rg, 1.0);\n";
+    source += "    float mu = dot(atmEnter, viewDir) / r;\n";
+    source += "    float muS = dot(atmEnter, " + LightProperty(0, "direction") + ") / r;\n";
+
+    source += "    float uR = sqrt((r - rg) / (1.0 - rg));\n";
+    source += "    float muHorizon = -sqrt(max(1.0 - rg * rg / (r * r), 0.0));\n";
+    source += "    float uMu = mu > muHorizon ? 0.5 + 0.5 * sqrt((mu - muHorizon) / (1.0 - muHorizon))\n";
+    source += "                               : 0.5 - 0.5 * sqrt((muHorizon - mu) / (1.0 + muHorizon));\n";
+    source += "    float muSMin = -sqrt(1.0 - rg * rg);\n";
+    source += "    float uMuS = clamp((muS - muSMin) / (1.0 - muSMin), 0.0, 1.0);\n";
+
+    // The samples are at the texel centers
+    source += "    vec3 n = scatteringTableSize;\n";
+    source += "    float x = (uMu * (n.y - 1.0) + 0.5) / n.y;\n";
+    source += "    scatterEx = texture2D(transmittanceTex, vec2(x, (uR * (n.x - 1.0) + 0.5) / n.x)).rgb;\n";
+
+    // The inscatter table stacks one slice per height, interpolate between
+    // the two nearest ones. The table holds the square roots of the values.
+    source += "    float layer = uR * (n.x - 1.0);\n";
+    source += "    float layer0 = floor(layer);\n";
+    source += "    float layer1 = min(layer0 + 1.0, n.x - 1.0);\n";
+    source += "    float y = uMuS * (n.z - 1.0) + 0.5;\n";
+    source += "    vec3 s0 = texture2D(inscatterTex, vec2(x, (layer0 * n.z + y) / (n.x * n.z))).rgb;\n";
+    source += "    vec3 s1 = texture2D(inscatterTex, vec2(x, (layer1 * n.z + y) / (n.x * n.z))).rgb;\n";
+    source += "    vec3 inscatter = mix(s0 * s0, s1 * s1, layer - layer0) * inscatterScale;\n";
+
+    // The tables don't include the scattering coefficients, which are
+    // applied with the phase functions.
+    source += "    " + ScatteredColor(0) + " = " + LightProperty(0, "color") + " * scatterCoeffSum * inscatter;\n";
+    source += "}\n";
+
+    return source;
+}
+
+
 #if 0
 // Integrate the atmosphere by summation--slow, but higher quality
 std::string
@@ -996,11 +1069,14 @@ StaticPointSize()
 }
 
 static std::string
-LineDeclaration()
+LineDeclaration(const ShaderProperties& props)
 {
     std::string source;
     source += DeclareAttribute("in_PositionNext", Shader_Vector4);
-    source += DeclareAttribute("in_ScaleFactor", Shader_Float);
+    if (util::is_set(props.texUsage, TexUsage::LineInstances))
+        source += DeclareAttribute("in_LineCorner", Shader_Vector2);
+    else
+        source += DeclareAttribute("in_ScaleFactor", Shader_Float);
     source += DeclareUniform("lineWidthX", Shader_Float);
     source += DeclareUniform("lineWidthY", Shader_Float);
     return source;
@@ -1062,6 +1138,7 @@ BindAttribLocations(const GLProgram *prog)
     glBindAttribLocation(prog->getID(), CelestiaGLProgram::IntensityAttributeIndex,     "in_Intensity");
     glBindAttribLocation(prog->getID(), CelestiaGLProgram::NextVCoordAttributeIndex,    "in_PositionNext");
     glBindAttribLocation(prog->getID(), CelestiaGLProgram::ScaleFactorAttributeIndex,   "in_ScaleFactor");
+    glBindAttribLocation(prog->getID(), CelestiaGLProgram::LineCornerAttributeIndex,    "in_LineCorner");
     glBindAttribLocation(prog->getID(), CelestiaGLProgram::TangentAttributeIndex,       "in_Tangent");
     glBindAttribLocation(prog->getID(), CelestiaGLProgram::PointSizeAttributeIndex,     "in_PointSize");
 }
@@ -1153,6 +1230,69 @@ OutPrimitive(GLint prim)
     }
 }
 
+// Cap on the number of variants kept for prewarming the next run
+constexpr std::size_t MaxVariants = 1024;
+
+constexpr std::string_view VariantsMagic{ "CELSHVAR" };
+constexpr std::uint32_t VariantsVersion = 1;
+
+int
+CountBits(std::uint32_t bits)
+{
+    int count = 0;
+    for (; bits != 0; bits &= bits - 1)
+        ++count;
+    return count;
+}
+
+bool
+ReadShaderProperties(std::istream& in, ShaderProperties& props)
+{
+    std::uint16_t lightModel;
+    std::uint32_t texUsage;
+    std::uint16_t effects;
+    std::int32_t fishEyeOverride;
+    if (!util::readNative(in, props.nLights) ||
+        !util::readNative(in, lightModel) ||
+        !util::readNative(in, texUsage) ||
+        !util::readNative(in, effects) ||
+        !util::readNative(in, props.shadowCounts) ||
+        !util::readNative(in, fishEyeOverride) ||
+        props.nLights > MaxShaderLights)
+    {
+        return false;
+    }
+
+    props.lightModel = static_cast<LightingModel>(lightModel);
+    props.texUsage = static_cast<TexUsage>(texUsage);
+    props.effects = static_cast<LightingEffects>(effects);
+    props.fishEyeOverride = static_cast<FisheyeOverrideMode>(fishEyeOverride);
+    return true;
+}
+
+bool
+WriteShaderProperties(std::ostream& out, const ShaderProperties& props)
+{
+    return util::writeNative(out, props.nLights) &&
+           util::writeNative(out, static_cast<std::uint16_t>(props.lightModel)) &&
+           util::writeNative(out, static_cast<std::uint32_t>(props.texUsage)) &&
+           util::writeNative(out, static_cast<std::uint16_t>(props.effects)) &&
+           util::writeNative(out, props.shadowCounts) &&
+           util::writeNative(out, static_cast<std::int32_t>(props.fishEyeOverride));
+}
+
+// Names a shader variant in the hitch reports
+std::string
+GetVariantName(const ShaderProperties& props)
+{
+    return fmt::format("model {} lights {} textures {:#x} effects {:#x} shadows {:#x}",
+                       static_cast<unsigned int>(props.lightModel),
+                       props.nLights,
+                       static_cast<std::uint32_t>(props.texUsage),
+                       static_cast<std::uint32_t>(props.effects),
+                       props.shadowCounts);
+}
+
 } // end unnamed namespace
 
 bool
@@ -1366,6 +1506,14 @@ ShaderManager::ShaderManager()
 
 ShaderManager::~ShaderManager()
 {
+    if (variantsChanged)
+        saveVariants();
+
+    for (const auto& pending : pendingShaders)
+        delete pending.second.program;
+
+    pendingShaders.clear();
+
     for(const auto& shader : dynamicShaders)
         delete shader.second;
 
@@ -1386,14 +1534,32 @@ ShaderManager::getShader(const ShaderProperties& props)
         // Shader already exists
         return iter->second;
     }
-    else
+
+    auto pending = pendingShaders.find(props);
+    if (pending == pendingShaders.end())
     {
-        // Create a new shader and add it to the table of created shaders
-        CelestiaGLProgram* prog = buildProgram(props);
-        dynamicShaders[props] = prog;
+        if (!asyncCompilation)
+        {
+            // Create a new shader and add it to the table of created shaders
+            CelestiaGLProgram* prog = buildProgram(props);
+            dynamicShaders[props] = prog;
+            addVariant(props);
 
-        return prog;
+            return prog;
+        }
+
+        pending = startVariant(props);
+    }
+
+    if (asyncCompilation && !isReady(pending->second))
+    {
+        // Draw with a simpler variant until this one is linked. If there is
+        // none, wait for the compilation to complete.
+        if (auto* fallback = findFallback(props); fallback != nullptr)
+            return fallback;
     }
+
+    return finishVariant(pending);
 }
 
 CelestiaGLProgram*
@@ -1406,6 +1572,7 @@ ShaderManager::getShader(std::string_view name, std::string_view vs, std::string
     }
 
     // Create a new shader and add it to the table of created shaders
+    engine::FrameZoneTimer zoneTimer(engine::FrameZone::ShaderCompile, name);
     auto *prog = buildProgram(vs, fs);
     staticShaders[name] = prog;
 
@@ -1433,6 +1600,7 @@ ShaderManager::getShader(std::string_view name)
         return getShader(name, errorVertexShaderSource, errorFragmentShaderSource);
 
     // Create a new shader and add it to the table of created shaders
+    engine::FrameZoneTimer zoneTimer(engine::FrameZone::ShaderCompile, name);
     auto *prog = buildProgram(*vs, *fs);
     staticShaders[name] = prog;
 
@@ -1459,6 +1627,7 @@ ShaderManager::getShaderGL3(std::string_view name, const GeomShaderParams* param
     if (!fs.has_value())
         return getShader(name, errorVertexShaderSource, errorFragmentShaderSource);
 
+    engine::FrameZoneTimer zoneTimer(engine::FrameZone::ShaderCompile, name);
     CelestiaGLProgram *prog = nullptr;
 
     // Geometric shader is optional
@@ -1491,6 +1660,7 @@ ShaderManager::getShaderGL3(std::string_view name, std::string_view vs, std::str
     }
 
     // Create a new shader and add it to the table of created shaders
+    engine::FrameZoneTimer zoneTimer(engine::FrameZone::ShaderCompile, name);
     auto *prog = buildProgramGL3(vs, gs, fs);
     staticShaders[name] = prog;
 
@@ -1498,7 +1668,7 @@ ShaderManager::getShaderGL3(std::string_view name, std::string_view vs, std::str
 }
 
 
-GLVertexShader*
+std::string
 ShaderManager::buildVertexShader(const ShaderProperties& props)
 {
     std::string source(VersionHeader);
@@ -1581,7 +1751,7 @@ R"glsl(
         source += DeclareUniform("ShadowMatrix0", Shader_Matrix4);
 
     if (util::is_set(props.texUsage, TexUsage::LineAsTriangles))
-        source += LineDeclaration();
+        source += LineDeclaration(props);
 
     source += VPFunction(props.fishEyeOverride != FisheyeOverrideMode::Disabled && fisheyeEnabled);
 
@@ -1737,13 +1907,11 @@ R"glsl(
 
     DumpVSSource(source);
 
-    GLVertexShader* vs = nullptr;
-    GLShaderStatus status = GLShaderLoader::CreateVertexShader(source, &vs);
-    return status == GLShaderStatus::OK ? vs : nullptr;
+    return source;
 }
 
 
-GLFragmentShader*
+std::string
 ShaderManager::buildFragmentShader(const ShaderProperties& props)
 {
     std::string source(VersionHeader);
@@ -2097,12 +2265,10 @@ ShaderManager::buildFragmentShader(const ShaderProperties& props)
 
     DumpFSSource(source);
 
-    GLFragmentShader* fs = nullptr;
-    GLShaderStatus status = GLShaderLoader::CreateFragmentShader(source, &fs);
-    return status == GLShaderStatus::OK ? fs : nullptr;
+    return source;
 }
 
-GLVertexShader*
+std::string
 ShaderManager::buildRingsVertexShader(const ShaderProperties& props)
 {
     std::string source(VersionHeader);
@@ -2146,13 +2312,11 @@ ShaderManager::buildRingsVertexShader(const ShaderProperties& props)
 
     DumpVSSource(source);
 
-    GLVertexShader* vs = nullptr;
-    GLShaderStatus status = GLShaderLoader::CreateVertexShader(source, &vs);
-    return status == GLShaderStatus::OK ? vs : nullptr;
+    return source;
 }
 
 
-GLFragmentShader*
+std::string
 ShaderManager::buildRingsFragmentShader(const ShaderProperties& props)
 {
     std::string source(VersionHeader);
@@ -2251,13 +2415,11 @@ ShaderManager::buildRingsFragmentShader(const ShaderProperties& props)
 
     DumpFSSource(source);
 
-    GLFragmentShader* fs = nullptr;
-    GLShaderStatus status = GLShaderLoader::CreateFragmentShader(source, &fs);
-    return status == GLShaderStatus::OK ? fs : nullptr;
+    return source;
 }
 
 
-GLVertexShader*
+std::string
 ShaderManager::buildAtmosphereVertexShader(const ShaderProperties& props)
 {
     std::string source(VersionHeader);
@@ -2284,13 +2446,11 @@ ShaderManager::buildAtmosphereVertexShader(const ShaderProperties& props)
 
     DumpVSSource(source);
 
-    GLVertexShader* vs = nullptr;
-    GLShaderStatus status = GLShaderLoader::CreateVertexShader(source, &vs);
-    return status == GLShaderStatus::OK ? vs : nullptr;
+    return source;
 }
 
 
-GLFragmentShader*
+std::string
 ShaderManager::buildAtmosphereFragmentShader(const ShaderProperties& props)
 {
     std::string source(VersionHeader);
@@ -2299,6 +2459,13 @@ ShaderManager::buildAtmosphereFragmentShader(const ShaderProperties& props)
     source += DeclareLights(props);
     source += DeclareUniform("eyePosition", Shader_Vector3);
     source += ScatteringConstantDeclarations(props);
+    if (util::is_set(props.texUsage, TexUsage::ScatteringTables))
+    {
+        source += DeclareUniform("transmittanceTex", Shader_Sampler2D);
+        source += DeclareUniform("inscatterTex", Shader_Sampler2D);
+        source += DeclareUniform("inscatterScale", Shader_Float);
+        source += DeclareUniform("scatteringTableSize", Shader_Vector3);
+    }
 
     source += DeclareInput("position", Shader_Vector3);
     source += DeclareInput("normal", Shader_Vector3);
@@ -2315,7 +2482,10 @@ ShaderManager::buildAtmosphereFragmentShader(const ShaderProperties& props)
 
     source += DeclareLocal("NL", Shader_Float);
     source += DeclareLocal("scatterEx", Shader_Vector3);
-    source += AtmosphericEffects(props);
+    if (util::is_set(props.texUsage, TexUsage::ScatteringTables))
+        source += ScatteringTableEffects(props);
+    else
+        source += AtmosphericEffects(props);
 
     // Sum the contributions from each light source
     source += "vec3 color = vec3(0.0);\n";
@@ -2337,15 +2507,13 @@ ShaderManager::buildAtmosphereFragmentShader(const ShaderProperties& props)
 
     DumpFSSource(source);
 
-    GLFragmentShader* fs = nullptr;
-    GLShaderStatus status = GLShaderLoader::CreateFragmentShader(source, &fs);
-    return status == GLShaderStatus::OK ? fs : nullptr;
+    return source;
 }
 
 
 // The emissive shader ignores all lighting and uses the diffuse color
 // as the final fragment color.
-GLVertexShader*
+std::string
 ShaderManager::buildEmissiveVertexShader(const ShaderProperties& props)
 {
     std::string source(VersionHeader);
@@ -2403,13 +2571,11 @@ ShaderManager::buildEmissiveVertexShader(const ShaderProperties& props)
 
     DumpVSSource(source);
 
-    GLVertexShader* vs = nullptr;
-    GLShaderStatus status = GLShaderLoader::CreateVertexShader(source, &vs);
-    return status == GLShaderStatus::OK ? vs : nullptr;
+    return source;
 }
 
 
-GLFragmentShader*
+std::string
 ShaderManager::buildEmissiveFragmentShader(const ShaderProperties& props)
 {
     std::string source(VersionHeader);
@@ -2454,14 +2620,12 @@ ShaderManager::buildEmissiveFragmentShader(const ShaderProperties& props)
 
     DumpFSSource(source);
 
-    GLFragmentShader* fs = nullptr;
-    GLShaderStatus status = GLShaderLoader::CreateFragmentShader(source, &fs);
-    return status == GLShaderStatus::OK ? fs : nullptr;
+    return source;
 }
 
 
 // Build the vertex shader used for rendering particle systems.
-GLVertexShader*
+std::string
 ShaderManager::buildParticleVertexShader(const ShaderProperties& props)
 {
     std::ostringstream source;
@@ -2530,13 +2694,11 @@ ShaderManager::buildParticleVertexShader(const ShaderProperties& props)
 
     DumpVSSource(source);
 
-    GLVertexShader* vs = nullptr;
-    GLShaderStatus status = GLShaderLoader::CreateVertexShader(source.str(), &vs);
-    return status == GLShaderStatus::OK ? vs : nullptr;
+    return source.str();
 }
 
 
-GLFragmentShader*
+std::string
 ShaderManager::buildParticleFragmentShader(const ShaderProperties& props)
 {
     std::ostringstream source;
@@ -2585,20 +2747,12 @@ ShaderManager::buildParticleFragmentShader(const ShaderProperties& props)
 
     DumpFSSource(source);
 
-    GLFragmentShader* fs = nullptr;
-    GLShaderStatus status = GLShaderLoader::CreateFragmentShader(source.str(), &fs);
-    return status == GLShaderStatus::OK ? fs : nullptr;
+    return source.str();
 }
 
-CelestiaGLProgram*
-ShaderManager::buildProgram(const ShaderProperties& props)
+void
+ShaderManager::buildSources(const ShaderProperties& props, std::string& vs, std::string& fs)
 {
-    GLProgram* prog = nullptr;
-    GLShaderStatus status;
-
-    GLVertexShader* vs = nullptr;
-    GLFragmentShader* fs = nullptr;
-
     if (props.lightModel == LightingModel::RingIllumModel)
     {
         vs = buildRingsVertexShader(props);
@@ -2624,25 +2778,20 @@ ShaderManager::buildProgram(const ShaderProperties& props)
         vs = buildVertexShader(props);
         fs = buildFragmentShader(props);
     }
+}
 
-    if (vs != nullptr && fs != nullptr)
-    {
-        status = GLShaderLoader::CreateProgram(*vs, *fs, &prog);
-        if (status == GLShaderStatus::OK)
-        {
-            BindAttribLocations(prog);
-            status = prog->link();
-        }
-    }
-    else
-    {
-        status = GLShaderStatus::CompileError;
-    }
+CelestiaGLProgram*
+ShaderManager::buildProgram(const ShaderProperties& props)
+{
+    std::string name = GetVariantName(props);
+    engine::FrameZoneTimer zoneTimer(engine::FrameZone::ShaderCompile, name);
 
-    delete vs;
-    delete fs;
+    std::string vs;
+    std::string fs;
+    buildSources(props, vs, fs);
 
-    if (status != GLShaderStatus::OK)
+    GLProgram* prog = nullptr;
+    if (createProgram(vs, {}, fs, &prog) != GLShaderStatus::OK)
     {
         // If the shader creation failed for some reason, substitute the
         // error shader.
@@ -2657,21 +2806,13 @@ CelestiaGLProgram*
 ShaderManager::buildProgram(std::string_view vs, std::string_view fs)
 {
     GLProgram* prog = nullptr;
-    GLShaderStatus status;
     std::string _vs = fmt::format("{}{}{}{}{}\n", VersionHeader, CommonHeader, VertexHeader, VPFunction(fisheyeEnabled), vs);
     std::string _fs = fmt::format("{}{}{}{}\n", VersionHeader, CommonHeader, FragmentHeader, fs);
 
     DumpVSSource(_vs);
     DumpFSSource(_fs);
 
-    status = GLShaderLoader::CreateProgram(_vs, _fs, &prog);
-    if (status == GLShaderStatus::OK)
-    {
-        BindAttribLocations(prog);
-        status = prog->link();
-    }
-
-    if (status != GLShaderStatus::OK)
+    if (createProgram(_vs, {}, _fs, &prog) != GLShaderStatus::OK)
     {
         // If the shader creation failed for some reason, substitute the
         // error shader.
@@ -2686,21 +2827,13 @@ CelestiaGLProgram*
 ShaderManager::buildProgramGL3(std::string_view vs, std::string_view fs)
 {
     GLProgram* prog = nullptr;
-    GLShaderStatus status;
     std::string _vs = fmt::format("{}{}{}{}{}\n", VersionHeaderGL3, CommonHeader, VertexHeader, VPFunction(fisheyeEnabled), vs);
     std::string _fs = fmt::format("{}{}{}{}\n", VersionHeaderGL3, CommonHeader, FragmentHeader, fs);
 
     DumpVSSource(_vs);
     DumpFSSource(_fs);
 
-    status = GLShaderLoader::CreateProgram(_vs, _fs, &prog);
-    if (status == GLShaderStatus::OK)
-    {
-        BindAttribLocations(prog);
-        status = prog->link();
-    }
-
-    if (status != GLShaderStatus::OK)
+    if (createProgram(_vs, {}, _fs, &prog) != GLShaderStatus::OK)
     {
         // If the shader creation failed for some reason, substitute the
         // error shader.
@@ -2724,7 +2857,6 @@ ShaderManager::buildProgramGL3(std::string_view vs, std::string_view gs, std::st
     }
 
     GLProgram* prog = nullptr;
-    GLShaderStatus status;
     auto _vs = fmt::format("{}{}{}{}\n", VersionHeaderGL3, CommonHeader, VertexHeader, vs);
     auto _gs = fmt::format("{}{}{}{}{}{}\n", VersionHeaderGL3, CommonHeader, layout, GeomHeaderGL3, VPFunction(fisheyeEnabled), gs);
     auto _fs = fmt::format("{}{}{}{}\n", VersionHeaderGL3, CommonHeader, FragmentHeader, fs);
@@ -2733,22 +2865,308 @@ ShaderManager::buildProgramGL3(std::string_view vs, std::string_view gs, std::st
     DumpGSSource(_gs);
     DumpFSSource(_fs);
 
-    status = GLShaderLoader::CreateProgram(_vs, _gs, _fs, &prog);
+    if (createProgram(_vs, _gs, _fs, &prog) != GLShaderStatus::OK)
+    {
+        // If the shader creation failed for some reason, substitute the
+        // error shader.
+        if (CreateErrorShader(&prog, fisheyeEnabled) != GLShaderStatus::OK)
+            return nullptr;
+    }
+
+    return new CelestiaGLProgram(*prog);
+}
+
+GLShaderStatus
+ShaderManager::createProgram(const std::string& vs,
+                             const std::string& gs,
+                             const std::string& fs,
+                             GLProgram** progOut)
+{
+    PendingProgram pending;
+    GLShaderStatus status = startProgram(vs, gs, fs, true, pending);
     if (status == GLShaderStatus::OK)
+        status = finishProgram(pending);
+    if (status == GLShaderStatus::OK)
+        *progOut = pending.program;
+
+    return status;
+}
+
+GLShaderStatus
+ShaderManager::startProgram(const std::string& vs,
+                            const std::string& gs,
+                            const std::string& fs,
+                            bool wait,
+                            PendingProgram& pending)
+{
+    if (shaderCache != nullptr)
     {
-        BindAttribLocations(prog);
-        status = prog->link();
+        pending.cacheKey = engine::ShaderCache::computeKey(vs, gs, fs);
+        pending.program = shaderCache->load(pending.cacheKey);
+        if (pending.program != nullptr)
+        {
+            pending.linked = true;
+            return GLShaderStatus::OK;
+        }
     }
 
+    GLShaderStatus status;
+    if (!wait)
+        status = GLShaderLoader::StartProgram(vs, gs, fs, &pending.program);
+    else if (gs.empty())
+        status = GLShaderLoader::CreateProgram(vs, fs, &pending.program);
+    else
+        status = GLShaderLoader::CreateProgram(vs, gs, fs, &pending.program);
+    if (status != GLShaderStatus::OK)
+        return status;
+
+    // The attribute locations are part of the binary
+    BindAttribLocations(pending.program);
+    if (shaderCache != nullptr)
+        engine::ShaderCache::setRetrievable(*pending.program);
+
+    pending.program->startLink();
+    return GLShaderStatus::OK;
+}
+
+GLShaderStatus
+ShaderManager::finishProgram(PendingProgram& pending)
+{
+    if (pending.linked)
+        return GLShaderStatus::OK;
+
+    GLShaderStatus status = pending.program->finishLink();
+    if (status != GLShaderStatus::OK)
+    {
+        delete pending.program;
+        pending.program = nullptr;
+        return status;
+    }
+
+    pending.linked = true;
+    if (shaderCache != nullptr && !shaderCache->save(pending.cacheKey, *pending.program))
+        GetLogger()->debug("Failed to save shader program {:016x} to the cache\n", pending.cacheKey);
+
+    return GLShaderStatus::OK;
+}
+
+bool
+ShaderManager::isReady(const PendingProgram& pending)
+{
+    if (pending.program == nullptr || pending.linked)
+        return true;
+
+    // Without parallel shader compile there is no way to tell, and querying
+    // the link status waits for it
+    return gl::KHR_parallel_shader_compile && pending.program->isLinkComplete();
+}
+
+ShaderManager::PendingShaders::iterator
+ShaderManager::startVariant(const ShaderProperties& props)
+{
+    std::string name = GetVariantName(props);
+    engine::FrameZoneTimer zoneTimer(engine::FrameZone::ShaderCompile, name);
+
+    std::string vs;
+    std::string fs;
+    buildSources(props, vs, fs);
+
+    PendingProgram pending;
+    if (startProgram(vs, {}, fs, false, pending) != GLShaderStatus::OK)
+        pending.program = nullptr;
+
+    return pendingShaders.try_emplace(props, pending).first;
+}
+
+CelestiaGLProgram*
+ShaderManager::finishVariant(PendingShaders::iterator iter)
+{
+    // Waits for the link to complete if it hasn't
+    std::string name = GetVariantName(iter->first);
+    engine::FrameZoneTimer zoneTimer(engine::FrameZone::ShaderCompile, name);
+
+    GLShaderStatus status = GLShaderStatus::CompileError;
+    if (iter->second.program != nullptr)
+        status = finishProgram(iter->second);
+
+    GLProgram* prog = iter->second.program;
     if (status != GLShaderStatus::OK)
     {
         // If the shader creation failed for some reason, substitute the
         // error shader.
         if (CreateErrorShader(&prog, fisheyeEnabled) != GLShaderStatus::OK)
-            return nullptr;
+            prog = nullptr;
     }
 
-    return new CelestiaGLProgram(*prog);
+    const ShaderProperties& props = iter->first;
+    CelestiaGLProgram* result = prog == nullptr ? nullptr : new CelestiaGLProgram(*prog, props);
+    dynamicShaders[props] = result;
+    addVariant(props);
+
+    pendingShaders.erase(iter);
+    return result;
+}
+
+CelestiaGLProgram*
+ShaderManager::findFallback(const ShaderProperties& props) const
+{
+    // A variant can stand in for another if it uses no feature which the
+    // other doesn't; the one using most of its features is the closest.
+    // Lights weigh more than textures as a missing light is more obvious.
+    auto texUsage = static_cast<std::uint32_t>(props.texUsage);
+    auto effects = static_cast<std::uint32_t>(props.effects);
+
+    CelestiaGLProgram* best = nullptr;
+    int bestScore = -1;
+    for (const auto& [candidate, prog] : dynamicShaders)
+    {
+        if (prog == nullptr ||
+            candidate.lightModel != props.lightModel ||
+            candidate.fishEyeOverride != props.fishEyeOverride ||
+            candidate.nLights > props.nLights)
+        {
+            continue;
+        }
+
+        auto candidateTexUsage = static_cast<std::uint32_t>(candidate.texUsage);
+        auto candidateEffects = static_cast<std::uint32_t>(candidate.effects);
+        if ((candidateTexUsage & ~texUsage) != 0 ||
+            (candidateEffects & ~effects) != 0 ||
+            (candidate.shadowCounts & ~props.shadowCounts) != 0)
+        {
+            continue;
+        }
+
+        int score = static_cast<int>(candidate.nLights) * 32
+                  + CountBits(candidateTexUsage)
+                  + CountBits(candidateEffects)
+                  + CountBits(candidate.shadowCounts);
+        if (score > bestScore)
+        {
+            best = prog;
+            bestScore = score;
+        }
+    }
+
+    return best;
+}
+
+void
+ShaderManager::addVariant(const ShaderProperties& props)
+{
+    if (cacheDirectory.empty() || variants.size() >= MaxVariants)
+        return;
+
+    if (variants.insert(props).second)
+        variantsChanged = true;
+}
+
+void
+ShaderManager::setCacheDirectory(const fs::path& directory)
+{
+    cacheDirectory = directory;
+    loadVariants();
+
+    if (engine::ShaderCache::isSupported())
+        shaderCache = std::make_unique<engine::ShaderCache>(directory);
+    else
+        shaderCache = nullptr;
+}
+
+void
+ShaderManager::setAsyncCompilation(bool enabled)
+{
+    if (enabled && !asyncCompilation && gl::KHR_parallel_shader_compile)
+    {
+        // Let the driver pick the number of threads
+        glMaxShaderCompilerThreadsKHR(0xffffffffU);
+    }
+
+    asyncCompilation = enabled;
+}
+
+void
+ShaderManager::prewarm()
+{
+    for (const ShaderProperties& props : variants)
+    {
+        if (dynamicShaders.find(props) == dynamicShaders.end() &&
+            pendingShaders.find(props) == pendingShaders.end())
+        {
+            startVariant(props);
+        }
+    }
+}
+
+void
+ShaderManager::update()
+{
+    // Without parallel shader compile each program finished here stalls the
+    // frame, so only take one per frame
+    bool finishedOne = false;
+    for (auto iter = pendingShaders.begin(); iter != pendingShaders.end();)
+    {
+        auto next = std::next(iter);
+        if (isReady(iter->second))
+        {
+            finishVariant(iter);
+        }
+        else if (!gl::KHR_parallel_shader_compile && !finishedOne)
+        {
+            finishVariant(iter);
+            finishedOne = true;
+        }
+        iter = next;
+    }
+}
+
+void
+ShaderManager::loadVariants()
+{
+    std::ifstream in(cacheDirectory / "variants.dat", std::ios::binary);
+    if (!in.good())
+        return;
+
+    char magic[VariantsMagic.size()]; //NOSONAR
+    if (!in.read(magic, VariantsMagic.size()).good() || std::string_view(magic, VariantsMagic.size()) != VariantsMagic) /* Flawfinder: ignore */
+        return;
+
+    std::uint32_t version;
+    std::uint32_t count;
+    if (!util::readNative(in, version) || version != VariantsVersion ||
+        !util::readNative(in, count) || count > MaxVariants)
+    {
+        return;
+    }
+
+    for (std::uint32_t i = 0; i < count; ++i)
+    {
+        ShaderProperties props;
+        if (!ReadShaderProperties(in, props))
+            return;
+        variants.insert(props);
+    }
+}
+
+void
+ShaderManager::saveVariants() const
+{
+    std::error_code ec;
+    fs::create_directories(cacheDirectory, ec);
+
+    util::AtomicFile file(cacheDirectory / "variants.dat");
+    if (!file.isOpen())
+        return;
+
+    std::ofstream& out = file.stream();
+    out.write(VariantsMagic.data(), VariantsMagic.size());
+    bool ok = util::writeNative(out, VariantsVersion) &&
+              util::writeNative(out, static_cast<std::uint32_t>(variants.size()));
+    for (auto it = variants.begin(); ok && it != variants.end(); ++it)
+        ok = WriteShaderProperties(out, *it);
+
+    if (ok)
+        file.commit();
 }
 
 void ShaderManager::setFisheyeEnabled(bool enabled)
@@ -2940,6 +3358,12 @@ CelestiaGLProgram::initParameters()
         extinctionCoeff      = vec3Param("extinctionCoeff");
     }
 
+    if (util::is_set(props.texUsage, TexUsage::ScatteringTables))
+    {
+        inscatterScale       = floatParam("inscatterScale");
+        scatteringTableSize  = vec3Param("scatteringTableSize");
+    }
+
     if (util::is_set(props.lightModel, LightingModel::LunarLambertModel))
     {
         lunarLambert         = floatParam("lunarLambert");
@@ -3027,6 +3451,17 @@ CelestiaGLProgram::initSamplers()
         if (slot != -1)
             glUniform1i(slot, nSamplers++);
     }
+
+    if (util::is_set(props.texUsage, TexUsage::ScatteringTables))
+    {
+        int slot = glGetUniformLocation(program->getID(), "transmittanceTex");
+        if (slot != -1)
+            glUniform1i(slot, nSamplers++);
+
+        slot = glGetUniformLocation(program->getID(), "inscatterTex");
+        if (slot != -1)
+            glUniform1i(slot, nSamplers++);
+    }
 }
 
 
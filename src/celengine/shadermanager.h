@@ -12,11 +12,14 @@
 #include <array>
 #include <cstdint>
 #include <map>
+#include <memory>
+#include <set>
 #include <string>
 
 #include <Eigen/Core>
 #include <Eigen/Geometry>
 
+#include <celcompat/filesystem.h>
 #include <celutil/color.h>
 #include <celutil/flag.h>
 #include <celengine/glshader.h>
@@ -24,6 +27,11 @@
 class Atmosphere;
 class LightingState;
 
+namespace celestia::engine
+{
+class ShaderCache;
+}
+
 enum class TexUsage : std::uint32_t
 {
     None                    =       0,
@@ -46,6 +54,9 @@ enum class TexUsage : std::uint32_t
     StaticPointSize         = 0x10000,
     LineAsTriangles         = 0x20000,
     TextureCoordTransform   = 0x40000,
+    ScatteringTables        = 0x80000,
+    // With LineAsTriangles: one instance per segment, expanded from its end points
+    LineInstances           = 0x100000,
 };
 
 ENUM_CLASS_BITWISE_OPS(TexUsage);
@@ -209,6 +220,7 @@ public:
         IntensityAttributeIndex     = 9,
         NextVCoordAttributeIndex    = 10,
         ScaleFactorAttributeIndex   = 11,
+        LineCornerAttributeIndex    = 12,
     };
 
     CelestiaGLProgramLight lights[MaxShaderLights];
@@ -267,6 +279,11 @@ public:
     //    z = 1/radius
     Vec3ShaderParameter atmosphereRadius;
 
+    // Precomputed scattering tables: the scale of the inscatter table, and
+    // the number of height, view angle and sun angle samples
+    FloatShaderParameter inscatterScale;
+    Vec3ShaderParameter scatteringTableSize;
+
     // Scale factor for point sprites
     FloatShaderParameter pointScale;
 
@@ -326,30 +343,93 @@ public:
     CelestiaGLProgram* getShaderGL3(std::string_view, std::string_view, std::string_view, std::string_view);
 
     void setFisheyeEnabled(bool enabled);
+    bool isFisheyeEnabled() const { return fisheyeEnabled; }
+
+    // Keep the binaries of linked programs in the directory, so that a later
+    // run can skip compiling them, along with the list of the variants used.
+    // Binaries are only kept if the driver supports them.
+    void setCacheDirectory(const fs::path&);
+
+    // In asynchronous mode getShader doesn't wait for a new variant to be
+    // compiled; it starts the compilation and returns the closest variant
+    // which is already available, if there is one.
+    void setAsyncCompilation(bool enabled);
+    bool getAsyncCompilation() const { return asyncCompilation; }
+
+    // Start compiling the variants used in previous runs
+    void prewarm();
+
+    // Pick up the variants whose compilation has completed; called once per
+    // frame
+    void update();
+    bool hasPendingShaders() const { return !pendingShaders.empty(); }
 
 private:
+    struct PendingProgram
+    {
+        GLProgram* program{ nullptr };
+        std::uint64_t cacheKey{ 0 };
+        bool linked{ false };
+    };
+
+    // An empty geometry shader source creates a program without one
+    GLShaderStatus createProgram(const std::string& vs,
+                                 const std::string& gs,
+                                 const std::string& fs,
+                                 GLProgram**);
+    GLShaderStatus startProgram(const std::string& vs,
+                                const std::string& gs,
+                                const std::string& fs,
+                                bool wait,
+                                PendingProgram&);
+    GLShaderStatus finishProgram(PendingProgram&);
+
+    using PendingShaders = std::map<ShaderProperties, PendingProgram>;
+
+    // Whether finishing the program won't wait for the driver
+    static bool isReady(const PendingProgram&);
+
+    void buildSources(const ShaderProperties&, std::string& vs, std::string& fs);
+    PendingShaders::iterator startVariant(const ShaderProperties&);
+    CelestiaGLProgram* finishVariant(PendingShaders::iterator);
+    CelestiaGLProgram* findFallback(const ShaderProperties&) const;
+    void addVariant(const ShaderProperties&);
+
+    void loadVariants();
+    void saveVariants() const;
+
     CelestiaGLProgram* buildProgram(const ShaderProperties&);
     CelestiaGLProgram* buildProgram(std::string_view, std::string_view);
     CelestiaGLProgram* buildProgramGL3(std::string_view, std::string_view);
     CelestiaGLProgram* buildProgramGL3(std::string_view, std::string_view, std::string_view, const GeomShaderParams* = nullptr);
 
-    GLVertexShader* buildVertexShader(const ShaderProperties&);
-    GLFragmentShader* buildFragmentShader(const ShaderProperties&);
+    std::string buildVertexShader(const ShaderProperties&);
+    std::string buildFragmentShader(const ShaderProperties&);
 
-    GLVertexShader* buildRingsVertexShader(const ShaderProperties&);
-    GLFragmentShader* buildRingsFragmentShader(const ShaderProperties&);
+    std::string buildRingsVertexShader(const ShaderProperties&);
+    std::string buildRingsFragmentShader(const ShaderProperties&);
 
-    GLVertexShader* buildAtmosphereVertexShader(const ShaderProperties&);
-    GLFragmentShader* buildAtmosphereFragmentShader(const ShaderProperties&);
+    std::string buildAtmosphereVertexShader(const ShaderProperties&);
+    std::string buildAtmosphereFragmentShader(const ShaderProperties&);
 
-    GLVertexShader* buildEmissiveVertexShader(const ShaderProperties&);
-    GLFragmentShader* buildEmissiveFragmentShader(const ShaderProperties&);
+    std::string buildEmissiveVertexShader(const ShaderProperties&);
+    std::string buildEmissiveFragmentShader(const ShaderProperties&);
 
-    GLVertexShader* buildParticleVertexShader(const ShaderProperties&);
-    GLFragmentShader* buildParticleFragmentShader(const ShaderProperties&);
+    std::string buildParticleVertexShader(const ShaderProperties&);
+    std::string buildParticleFragmentShader(const ShaderProperties&);
 
     std::map<ShaderProperties, CelestiaGLProgram*> dynamicShaders;
     std::map<std::string_view, CelestiaGLProgram*> staticShaders;
 
+    PendingShaders pendingShaders;
+
+    std::unique_ptr<celestia::engine::ShaderCache> shaderCache;
+    fs::path cacheDirectory;
+
+    // Variants used in previous runs and in this one
+    std::set<ShaderProperties> variants;
+    bool variantsChanged { false };
+
     bool fisheyeEnabled { false };
+    bool asyncCompilation { false };
 };
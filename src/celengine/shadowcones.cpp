@@ -0,0 +1,102 @@
+// shadowcones.cpp
+//
+// Copyright (C) 2025, Celestia Development Team
+//
+// Broad phase of the eclipse shadow tests.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include "shadowcones.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <numeric>
+
+#include "body.h"
+
+namespace celestia::engine
+{
+
+ShadowCone::ShadowCone(const Body& _caster, const Eigen::Vector3d& lightPosition, double now) :
+    caster(&_caster),
+    rings(GetBodyFeaturesManager()->getRings(&_caster)),
+    position(_caster.getAstrocentricPosition(now)),
+    direction((position - lightPosition).normalized()),
+    radius(_caster.getRadius()),
+    m_time(now)
+{
+}
+
+const Eigen::Quaterniond&
+ShadowCone::getOrientation() const
+{
+    if (!m_orientation.has_value())
+        m_orientation = caster->getOrientation(m_time);
+    return *m_orientation;
+}
+
+ShadowConeSet::ShadowConeSet(std::vector<ShadowCone>&& cones, const Eigen::Vector3d& lightPosition)
+{
+    if (cones.empty())
+        return;
+
+    for (const ShadowCone& cone : cones)
+        m_center += cone.position;
+    m_center /= static_cast<double>(cones.size());
+
+    Eigen::Vector3d lightDirection = (m_center - lightPosition).normalized();
+    m_across = lightDirection.unitOrthogonal();
+
+    for (const ShadowCone& cone : cones)
+    {
+        m_extent = std::max(m_extent, (cone.position - m_center).norm());
+        m_maxRadius = std::max(m_maxRadius, cone.radius);
+        if (cone.rings != nullptr)
+            m_maxRadius = std::max(m_maxRadius, static_cast<double>(cone.rings->outerRadius));
+        m_maxDeviation = std::max(m_maxDeviation, (cone.direction - lightDirection).norm());
+    }
+
+    std::vector<std::size_t> order(cones.size());
+    std::iota(order.begin(), order.end(), std::size_t(0));
+    std::vector<double> offsets(cones.size());
+    for (std::size_t i = 0; i < cones.size(); ++i)
+        offsets[i] = m_across.dot(cones[i].position - m_center);
+    std::sort(order.begin(), order.end(),
+              [&offsets](std::size_t a, std::size_t b) { return offsets[a] < offsets[b]; });
+
+    m_cones.reserve(cones.size());
+    m_offsets.reserve(cones.size());
+    for (std::size_t i : order)
+    {
+        m_cones.push_back(std::move(cones[i]));
+        m_offsets.push_back(offsets[i]);
+    }
+}
+
+util::array_view<ShadowCone>
+ShadowConeSet::candidates(const Eigen::Vector3d& receiverPosition,
+                          double receiverRadius,
+                          float lightApparentSize) const
+{
+    if (m_cones.empty())
+        return {};
+
+    // A shadow widens with the apparent size of the light source, and drifts
+    // from the mean light direction, over at most the distance between the
+    // receiver and the farthest caster.
+    double distance = (receiverPosition - m_center).norm() + m_extent;
+    double halfWidth = receiverRadius + m_maxRadius
+                     + (static_cast<double>(lightApparentSize) + m_maxDeviation) * distance;
+    double offset = m_across.dot(receiverPosition - m_center);
+
+    auto first = std::lower_bound(m_offsets.begin(), m_offsets.end(), offset - halfWidth);
+    auto last = std::upper_bound(first, m_offsets.end(), offset + halfWidth);
+    return util::array_view<ShadowCone>(m_cones.data() + std::distance(m_offsets.begin(), first),
+                                        static_cast<std::size_t>(std::distance(first, last)));
+}
+
+} // end namespace celestia::engine
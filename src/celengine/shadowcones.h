@@ -0,0 +1,79 @@
+// shadowcones.h
+//
+// Copyright (C) 2025, Celestia Development Team
+//
+// Broad phase of the eclipse shadow tests.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <optional>
+#include <vector>
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+
+#include <celutil/array_view.h>
+
+class Body;
+struct RingSystem;
+
+namespace celestia::engine
+{
+
+// Shadow volume of a body lit by a light source, with the positions in
+// astrocentric coordinates. It holds what the eclipse and ring shadow tests
+// of all the receivers need from the caster.
+class ShadowCone
+{
+public:
+    ShadowCone(const Body& caster, const Eigen::Vector3d& lightPosition, double now);
+
+    const Body* caster;
+    RingSystem* rings;
+    Eigen::Vector3d position;
+    // Direction from the light source to the caster, normalized
+    Eigen::Vector3d direction;
+    double radius;
+
+    // Orientation of the caster, only needed for the shadows of rings
+    const Eigen::Quaterniond& getOrientation() const;
+
+private:
+    double m_time;
+    mutable std::optional<Eigen::Quaterniond> m_orientation;
+};
+
+// The shadow cones of the casters of a planetary system for one light
+// source, sorted by their coordinate across the light direction. Since the
+// shadows of a system are nearly parallel, a receiver only needs the exact
+// test with the cones within the widest of them at its distance.
+class ShadowConeSet
+{
+public:
+    ShadowConeSet(std::vector<ShadowCone>&& cones, const Eigen::Vector3d& lightPosition);
+
+    // The cones which may shadow a receiver at the position, lit by a light
+    // source of the apparent size
+    util::array_view<ShadowCone> candidates(const Eigen::Vector3d& receiverPosition,
+                                            double receiverRadius,
+                                            float lightApparentSize) const;
+
+private:
+    std::vector<ShadowCone> m_cones;
+    std::vector<double> m_offsets;
+    Eigen::Vector3d m_across;
+    Eigen::Vector3d m_center{ Eigen::Vector3d::Zero() };
+    // Distance of the farthest caster from the center
+    double m_extent{ 0.0 };
+    // Largest radius of a caster or of its rings
+    double m_maxRadius{ 0.0 };
+    // Largest angle between a shadow and the mean light direction
+    double m_maxDeviation{ 0.0 };
+};
+
+} // end namespace celestia::engine
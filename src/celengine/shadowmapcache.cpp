@@ -0,0 +1,141 @@
+// shadowmapcache.cpp
+//
+// Copyright (C) 2025, Celestia Development Team
+//
+// Cache of the shadow maps of models.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include "shadowmapcache.h"
+
+#include <cmath>
+
+#include "framebuffer.h"
+
+namespace
+{
+
+// Whether the map of the entry was used in this frame or in the previous one
+bool
+isCurrent(std::uint32_t lastUsed, std::uint32_t frame)
+{
+    return frame - lastUsed <= 1;
+}
+
+} // end unnamed namespace
+
+ShadowMapCache::ShadowMapCache(unsigned int mapSize, unsigned int capacity) :
+    m_mapSize(mapSize),
+    // The maps span the unit sphere around the model, so a point at its
+    // edge moves by half a texel when the light turns by 1 / mapSize
+    m_cosThreshold(std::cos(1.0f / static_cast<float>(mapSize))),
+    m_entries(capacity)
+{
+}
+
+ShadowMapCache::~ShadowMapCache() = default;
+
+ShadowMapCache::ShadowMap
+ShadowMapCache::get(const Geometry* geometry, const Eigen::Vector3f& lightDirection, std::uint32_t frame)
+{
+    if (frame != m_frame)
+    {
+        m_frame = frame;
+        m_updates = 0;
+    }
+
+    if (Entry* entry = find(geometry, lightDirection, frame); entry != nullptr)
+    {
+        entry->lastUsed = frame;
+        if (entry->lightDirection.dot(lightDirection) >= m_cosThreshold)
+        {
+            entry->deferred = false;
+            return { entry->fbo.get(), &entry->lightMatrix, false };
+        }
+
+        bool overdue = entry->deferred && frame - entry->deferredSince >= MaxDeferredFrames;
+        if (m_updates < MaxUpdatesPerFrame || overdue)
+        {
+            ++m_updates;
+            entry->lightDirection = lightDirection;
+            entry->deferred = false;
+            return { entry->fbo.get(), &entry->lightMatrix, true };
+        }
+
+        if (!entry->deferred)
+        {
+            entry->deferred = true;
+            entry->deferredSince = frame;
+        }
+        return { entry->fbo.get(), &entry->lightMatrix, false };
+    }
+
+    Entry* entry = allocate(frame);
+    if (entry == nullptr)
+        return {};
+
+    entry->geometry = geometry;
+    entry->lightDirection = lightDirection;
+    entry->lastUsed = frame;
+    entry->deferred = false;
+    return { entry->fbo.get(), &entry->lightMatrix, true };
+}
+
+ShadowMapCache::Entry*
+ShadowMapCache::find(const Geometry* geometry, const Eigen::Vector3f& lightDirection, std::uint32_t frame)
+{
+    Entry* best = nullptr;
+    float bestCos = -2.0f;
+    for (Entry& entry : m_entries)
+    {
+        // A map is used by one model per frame
+        if (entry.geometry != geometry || entry.lastUsed == frame || !isCurrent(entry.lastUsed, frame))
+            continue;
+
+        if (float cosAngle = entry.lightDirection.dot(lightDirection); cosAngle > bestCos)
+        {
+            best = &entry;
+            bestCos = cosAngle;
+        }
+    }
+
+    return best;
+}
+
+ShadowMapCache::Entry*
+ShadowMapCache::allocate(std::uint32_t frame)
+{
+    // Take the map which has been unused for the longest time, but never one
+    // already used in this frame
+    Entry* oldest = nullptr;
+    for (Entry& entry : m_entries)
+    {
+        if (entry.geometry != nullptr && entry.lastUsed == frame)
+            continue;
+        if (oldest == nullptr || entry.geometry == nullptr ||
+            (oldest->geometry != nullptr && frame - entry.lastUsed > frame - oldest->lastUsed))
+        {
+            oldest = &entry;
+            if (entry.geometry == nullptr)
+                break;
+        }
+    }
+
+    if (oldest == nullptr)
+        return nullptr;
+
+    if (oldest->fbo == nullptr)
+    {
+        oldest->fbo = std::make_unique<FramebufferObject>(m_mapSize, m_mapSize, FramebufferObject::DepthAttachment);
+        if (!oldest->fbo->isValid())
+        {
+            oldest->fbo = nullptr;
+            return nullptr;
+        }
+    }
+
+    return oldest;
+}
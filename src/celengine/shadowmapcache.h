@@ -0,0 +1,87 @@
+// shadowmapcache.h
+//
+// Copyright (C) 2025, Celestia Development Team
+//
+// Cache of the shadow maps of models.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <Eigen/Core>
+
+class FramebufferObject;
+class Geometry;
+
+// Shadow maps of models, kept from frame to frame. A shadow map is drawn in
+// the coordinates of its model, so it only depends on the direction of the
+// light in those coordinates: it is drawn again once the direction has
+// turned by more than half a texel at the edge of the map.
+//
+// To spread the cost over several frames when many models turn, only a few
+// maps past their threshold are drawn again in each frame, besides the maps
+// of the models which just came into view. The other ones are still sampled
+// with the light matrix they were drawn with, so that their shadows lag but
+// stay consistent, for at most MaxDeferredFrames frames.
+//
+// The models are referenced by address, so a map is only kept while its
+// model is drawn in consecutive frames. Models sharing a geometry get the
+// map of the geometry closest to their light direction.
+class ShadowMapCache
+{
+public:
+    static constexpr unsigned int MaxUpdatesPerFrame = 2;
+    static constexpr std::uint32_t MaxDeferredFrames = 4;
+
+    ShadowMapCache(unsigned int mapSize, unsigned int capacity);
+    ~ShadowMapCache();
+
+    ShadowMapCache(const ShadowMapCache&) = delete;
+    ShadowMapCache& operator=(const ShadowMapCache&) = delete;
+    ShadowMapCache(ShadowMapCache&&) = delete;
+    ShadowMapCache& operator=(ShadowMapCache&&) = delete;
+
+    struct ShadowMap
+    {
+        FramebufferObject* fbo{ nullptr };
+        // Projection of the model coordinates on the map, which is set when
+        // the map is drawn
+        Eigen::Matrix4f* lightMatrix{ nullptr };
+        // Whether the map has to be drawn before it is sampled
+        bool needsUpdate{ false };
+    };
+
+    // Get the shadow map of the geometry lit from the direction, in model
+    // coordinates. Returns no framebuffer when all the maps are in use in
+    // this frame.
+    ShadowMap get(const Geometry*, const Eigen::Vector3f& lightDirection, std::uint32_t frame);
+
+private:
+    struct Entry
+    {
+        std::unique_ptr<FramebufferObject> fbo;
+        const Geometry* geometry{ nullptr };
+        Eigen::Vector3f lightDirection{ Eigen::Vector3f::Zero() };
+        Eigen::Matrix4f lightMatrix{ Eigen::Matrix4f::Identity() };
+        std::uint32_t lastUsed{ 0 };
+        std::uint32_t deferredSince{ 0 };
+        bool deferred{ false };
+    };
+
+    Entry* find(const Geometry*, const Eigen::Vector3f& lightDirection, std::uint32_t frame);
+    Entry* allocate(std::uint32_t frame);
+
+    unsigned int m_mapSize;
+    float m_cosThreshold;
+    // Sized once, as the light matrices are referenced by the callers
+    std::vector<Entry> m_entries;
+    std::uint32_t m_frame{ 0 };
+    unsigned int m_updates{ 0 };
+};
@@ -15,7 +15,6 @@
 #include <algorithm>
 #include <cstddef>
 
-#include <celutil/strnatcmp.h>
 #include "body.h"
 #include "location.h"
 #include "render.h"
@@ -45,6 +44,7 @@ static const Star* getSun(const Body* body)
 
 void Simulation::render(Renderer& renderer)
 {
+    preloader.update(*activeObserver, *universe, renderer.getResolution());
     renderer.render(*activeObserver,
                     *universe,
                     faintestVisible,
@@ -54,6 +54,8 @@ void Simulation::render(Renderer& renderer)
 
 void Simulation::render(Renderer& renderer, Observer& observer)
 {
+    if (&observer == activeObserver)
+        preloader.update(observer, *universe, renderer.getResolution());
     renderer.render(observer,
                     *universe,
                     faintestVisible,
@@ -144,14 +146,16 @@ void Simulation::setTrackedObject(const Selection& sel)
 
 Selection Simulation::pickObject(const Eigen::Vector3f& pickRay,
                                  RenderFlags renderFlags,
-                                 float tolerance)
+                                 float tolerance,
+                                 const celestia::engine::PickHits& hits)
 {
     return universe->pick(activeObserver->getPosition(),
                           activeObserver->getOrientationf().conjugate() * pickRay,
                           activeObserver->getTime(),
                           renderFlags,
                           faintestVisible,
-                          tolerance);
+                          tolerance,
+                          hits);
 }
 
 void Simulation::reverseObserverOrientation()
@@ -435,35 +439,40 @@ Selection Simulation::findObjectFromPath(std::string_view s, bool i18n) const
 }
 
 
-void Simulation::getObjectCompletion(std::vector<celestia::engine::Completion>& completion,
-                                     std::string_view s,
-                                     bool withLocations) const
+std::vector<Selection> Simulation::getCompletionContexts() const
 {
-    Selection path[2];
-    std::size_t nPathEntries = 0;
+    std::vector<Selection> path;
 
     if (!selection.empty())
     {
         if (selection.getType() == SelectionType::Location)
         {
-            path[nPathEntries++] = Selection(selection.location()->getParentBody());
+            path.emplace_back(selection.location()->getParentBody());
         }
         else
         {
-            path[nPathEntries++] = selection;
+            path.push_back(selection);
         }
     }
 
     if (auto nearestSolarSystem = getNearestSolarSystem();
         nearestSolarSystem != nullptr && nearestSolarSystem != universe->getSolarSystem(selection))
     {
-        path[nPathEntries++] = Selection(nearestSolarSystem->getStar());
+        path.emplace_back(nearestSolarSystem->getStar());
     }
 
-    universe->getCompletionPath(completion, s, {path, nPathEntries}, withLocations);
+    return path;
+}
+
+
+void Simulation::getObjectCompletion(std::vector<celestia::engine::Completion>& completion,
+                                     std::string_view s,
+                                     bool withLocations) const
+{
+    std::vector<Selection> path = getCompletionContexts();
+    universe->getCompletionPath(completion, s, {path.data(), path.size()}, withLocations);
 
-    std::sort(completion.begin(), completion.end(),
-              [](const celestia::engine::Completion &s1, const celestia::engine::Completion &s2) { return strnatcmp(s1.getName(), s2.getName()) < 0; });
+    celestia::engine::rankCompletions(completion, s);
 }
 
 
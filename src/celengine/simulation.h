@@ -26,6 +26,7 @@
 #include <celengine/renderflags.h>
 #include <celengine/texmanager.h>
 #include <celengine/frame.h>
+#include <celengine/journeypreloader.h>
 #include <celengine/observer.h>
 
 class Renderer;
@@ -46,7 +47,10 @@ public:
     void render(Renderer&);
     void render(Renderer&, Observer&);
 
-    Selection pickObject(const Eigen::Vector3f& pickRay, RenderFlags renderFlags, float tolerance = 0.0f);
+    Selection pickObject(const Eigen::Vector3f& pickRay,
+                         RenderFlags renderFlags,
+                         float tolerance = 0.0f,
+                         const celestia::engine::PickHits& hits = {});
 
     Universe* getUniverse() const;
 
@@ -65,9 +69,13 @@ public:
 
     void selectPlanet(int);
     Selection findObjectFromPath(std::string_view s, bool i18n = false) const;
+    // Complete the name synchronously, ranked as by rankCompletions
     void getObjectCompletion(std::vector<celestia::engine::Completion>& completion,
                              std::string_view s,
                              bool withLocations = false) const;
+    // The objects in whose context names are completed, for completing
+    // them with Universe::getCompletionPath
+    std::vector<Selection> getCompletionContexts() const;
     void gotoSelection(double gotoTime,
                        const Eigen::Vector3f& up,
                        ObserverFrame::CoordinateSystem upFrame);
@@ -139,6 +147,9 @@ private:
     Observer* activeObserver;
     std::vector<Observer*> observers;
 
+    // Loads the destination of the active observer's journey
+    celestia::engine::JourneyPreloader preloader;
+
     float faintestVisible{ 5.0f };
     bool pauseState{ false };
 };
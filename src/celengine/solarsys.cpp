@@ -10,6 +10,7 @@
 // as published by the Free Software Foundation; either version 2
 // of the License, or (at your option) any later version.
 
+#include <algorithm>
 #include <cassert>
 #include <cstddef>
 #include <cstring>
@@ -45,6 +46,7 @@
 #include "meshmanager.h"
 #include "parseobject.h"
 #include "solarsys.h"
+#include "ssccache.h"
 #include "surface.h"
 #include "texmanager.h"
 #include "timeline.h"
@@ -111,10 +113,16 @@ enum BodyType
 */
 
 void
-sscError(const Tokenizer& tok, const std::string& msg)
+sscError(int lineNumber, const std::string& msg)
 {
     GetLogger()->error(_("Error in .ssc file (line {}): {}\n"),
-                      tok.getLineNumber(), msg);
+                      lineNumber, msg);
+}
+
+void
+sscError(const Tokenizer& tok, const std::string& msg)
+{
+    sscError(tok.getLineNumber(), msg);
 }
 
 // Object class properties
@@ -1116,202 +1124,573 @@ Body* CreateReferencePoint(const std::string& name,
 
     return body;
 }
-} // end unnamed namespace
-
-bool LoadSolarSystemObjects(std::istream& in,
-                            Universe& universe,
-                            const fs::path& directory)
+// Read the next object definition; returns false at the end of the file or
+// on an error.
+bool ReadSolarSystemDefinition(Tokenizer& tokenizer,
+                               util::Parser& parser,
+                               engine::SolarSystemDefinition& definition,
+                               bool& error)
 {
-    Tokenizer tokenizer(&in);
-    util::Parser parser(&tokenizer);
+    error = false;
+    if (tokenizer.nextToken() == Tokenizer::TokenEnd)
+        return false;
 
-#ifdef ENABLE_NLS
-    std::string s = directory.string();
-    const char* d = s.c_str();
-    bindtextdomain(d, d); // domain name is the same as resource path
-#endif
+    definition.lineNumber = tokenizer.getLineNumber();
 
-    while (tokenizer.nextToken() != Tokenizer::TokenEnd)
+    // Read the disposition; if none is specified, the default is Add.
+    definition.disposition = DataDisposition::Add;
+    if (auto tokenValue = tokenizer.getNameValue(); tokenValue.has_value())
     {
-        // Read the disposition; if none is specified, the default is Add.
-        DataDisposition disposition = DataDisposition::Add;
-        if (auto tokenValue = tokenizer.getNameValue(); tokenValue.has_value())
-        {
-            if (*tokenValue == "Add")
-            {
-                disposition = DataDisposition::Add;
-                tokenizer.nextToken();
-            }
-            else if (*tokenValue == "Replace")
-            {
-                disposition = DataDisposition::Replace;
-                tokenizer.nextToken();
-            }
-            else if (*tokenValue == "Modify")
-            {
-                disposition = DataDisposition::Modify;
-                tokenizer.nextToken();
-            }
-        }
-
-        // Read the item type; if none is specified the default is Body
-        std::string itemType("Body");
-        if (auto tokenValue = tokenizer.getNameValue(); tokenValue.has_value())
+        if (*tokenValue == "Add")
         {
-            itemType = *tokenValue;
+            definition.disposition = DataDisposition::Add;
             tokenizer.nextToken();
         }
-
-        // The name list is a string with zero more names. Multiple names are
-        // delimited by colons.
-        std::string nameList;
-        if (auto tokenValue = tokenizer.getStringValue(); tokenValue.has_value())
+        else if (*tokenValue == "Replace")
         {
-            nameList = *tokenValue;
+            definition.disposition = DataDisposition::Replace;
+            tokenizer.nextToken();
         }
-        else
+        else if (*tokenValue == "Modify")
         {
-            sscError(tokenizer, "object name expected");
-            return false;
+            definition.disposition = DataDisposition::Modify;
+            tokenizer.nextToken();
         }
+    }
 
+    // Read the item type; if none is specified the default is Body
+    definition.itemType = "Body";
+    if (auto tokenValue = tokenizer.getNameValue(); tokenValue.has_value())
+    {
+        definition.itemType = *tokenValue;
         tokenizer.nextToken();
-        std::string parentName;
-        if (auto tokenValue = tokenizer.getStringValue(); tokenValue.has_value())
-        {
-            parentName = *tokenValue;
-        }
-        else
-        {
-            sscError(tokenizer, "bad parent object name");
-            return false;
-        }
+    }
+
+    // The name list is a string with zero more names. Multiple names are
+    // delimited by colons.
+    if (auto tokenValue = tokenizer.getStringValue(); tokenValue.has_value())
+    {
+        definition.nameList = *tokenValue;
+    }
+    else
+    {
+        sscError(tokenizer, "object name expected");
+        error = true;
+        return false;
+    }
 
-        const Value objectDataValue = parser.readValue();
-        const AssociativeArray* objectData = objectDataValue.getHash();
-        if (objectData == nullptr)
+    tokenizer.nextToken();
+    if (auto tokenValue = tokenizer.getStringValue(); tokenValue.has_value())
+    {
+        definition.parentName = *tokenValue;
+    }
+    else
+    {
+        sscError(tokenizer, "bad parent object name");
+        error = true;
+        return false;
+    }
+
+    definition.properties = parser.readValue();
+    if (definition.properties.getHash() == nullptr)
+    {
+        sscError(tokenizer, "{ expected");
+        error = true;
+        return false;
+    }
+
+    return true;
+}
+
+void CreateSolarSystemObject(const engine::SolarSystemDefinition& definition,
+                             Universe& universe,
+                             const fs::path& directory)
+{
+    const std::string& itemType = definition.itemType;
+    const std::string& nameList = definition.nameList;
+    const std::string& parentName = definition.parentName;
+    const DataDisposition disposition = definition.disposition;
+    const AssociativeArray* objectData = definition.properties.getHash();
+    const int lineNumber = definition.lineNumber;
+
+    Selection parent = universe.findPath(parentName, {});
+    PlanetarySystem* parentSystem = nullptr;
+
+    std::vector<std::string> names;
+    // Iterate through the string for names delimited
+    // by ':', and insert them into the name list.
+    if (nameList.empty())
+    {
+        names.push_back("");
+    }
+    else
+    {
+        std::string::size_type startPos   = 0;
+        while (startPos != std::string::npos)
         {
-            sscError(tokenizer, "{ expected");
-            return false;
+            std::string::size_type next   = nameList.find(':', startPos);
+            std::string::size_type length = std::string::npos;
+            if (next != std::string::npos)
+            {
+                length = next - startPos;
+                ++next;
+            }
+            names.push_back(nameList.substr(startPos, length));
+            startPos   = next;
         }
+    }
+    std::string primaryName = names.front();
 
-        Selection parent = universe.findPath(parentName, {});
-        PlanetarySystem* parentSystem = nullptr;
+    BodyType bodyType = UnknownBodyType;
+    if (itemType == "Body")
+        bodyType = NormalBody;
+    else if (itemType == "ReferencePoint")
+        bodyType = ReferencePoint;
+    else if (itemType == "SurfaceObject")
+        bodyType = SurfaceObject;
 
-        std::vector<std::string> names;
-        // Iterate through the string for names delimited
-        // by ':', and insert them into the name list.
-        if (nameList.empty())
+    if (bodyType != UnknownBodyType)
+    {
+        //bool orbitsPlanet = false;
+        if (parent.star() != nullptr)
         {
-            names.push_back("");
+            const SolarSystem* solarSystem = universe.getOrCreateSolarSystem(parent.star());
+            parentSystem = solarSystem->getPlanets();
+        }
+        else if (parent.body() != nullptr)
+        {
+            // Parent is a planet or moon
+            parentSystem = parent.body()->getOrCreateSatellites();
         }
         else
         {
-            std::string::size_type startPos   = 0;
-            while (startPos != std::string::npos)
-            {
-                std::string::size_type next   = nameList.find(':', startPos);
-                std::string::size_type length = std::string::npos;
-                if (next != std::string::npos)
-                {
-                    length = next - startPos;
-                    ++next;
-                }
-                names.push_back(nameList.substr(startPos, length));
-                startPos   = next;
-            }
+            sscError(lineNumber, fmt::sprintf(_("parent body '%s' of '%s' not found.\n"), parentName, primaryName));
         }
-        std::string primaryName = names.front();
-
-        BodyType bodyType = UnknownBodyType;
-        if (itemType == "Body")
-            bodyType = NormalBody;
-        else if (itemType == "ReferencePoint")
-            bodyType = ReferencePoint;
-        else if (itemType == "SurfaceObject")
-            bodyType = SurfaceObject;
 
-        if (bodyType != UnknownBodyType)
+        if (parentSystem != nullptr)
         {
-            //bool orbitsPlanet = false;
-            if (parent.star() != nullptr)
+            Body* existingBody = parentSystem->find(primaryName);
+            if (existingBody)
             {
-                const SolarSystem* solarSystem = universe.getOrCreateSolarSystem(parent.star());
-                parentSystem = solarSystem->getPlanets();
-            }
-            else if (parent.body() != nullptr)
-            {
-                // Parent is a planet or moon
-                parentSystem = parent.body()->getOrCreateSatellites();
+                if (disposition == DataDisposition::Add)
+                    sscError(lineNumber, fmt::sprintf(_("warning duplicate definition of %s %s\n"), parentName, primaryName));
+                else if (disposition == DataDisposition::Replace)
+                    existingBody->setDefaultProperties();
             }
+
+            Body* body;
+            if (bodyType == ReferencePoint)
+                body = CreateReferencePoint(primaryName, parentSystem, universe, existingBody, objectData, directory, disposition);
             else
-            {
-                sscError(tokenizer, fmt::sprintf(_("parent body '%s' of '%s' not found.\n"), parentName, primaryName));
-            }
+                body = CreateBody(primaryName, parentSystem, universe, existingBody, objectData, directory, disposition, bodyType);
 
-            if (parentSystem != nullptr)
+            if (body != nullptr)
             {
-                Body* existingBody = parentSystem->find(primaryName);
-                if (existingBody)
-                {
-                    if (disposition == DataDisposition::Add)
-                        sscError(tokenizer, fmt::sprintf(_("warning duplicate definition of %s %s\n"), parentName, primaryName));
-                    else if (disposition == DataDisposition::Replace)
-                        existingBody->setDefaultProperties();
-                }
-
-                Body* body;
-                if (bodyType == ReferencePoint)
-                    body = CreateReferencePoint(primaryName, parentSystem, universe, existingBody, objectData, directory, disposition);
-                else
-                    body = CreateBody(primaryName, parentSystem, universe, existingBody, objectData, directory, disposition, bodyType);
-
-                if (body != nullptr)
-                {
-                    UserCategory::loadCategories(body, *objectData, disposition, directory.string());
-                    if (disposition == DataDisposition::Add)
-                        for (const auto& name : names)
-                            body->addAlias(name);
-                }
+                UserCategory::loadCategories(body, *objectData, disposition, directory.string());
+                if (disposition == DataDisposition::Add)
+                    for (const auto& name : names)
+                        body->addAlias(name);
             }
         }
-        else if (itemType == "AltSurface")
-        {
-            auto surface = std::make_unique<Surface>();
-            surface->color = Color(1.0f, 1.0f, 1.0f);
-            FillinSurface(objectData, surface.get(), directory);
-            if (parent.body() != nullptr)
-                GetBodyFeaturesManager()->addAlternateSurface(parent.body(), primaryName, std::move(surface));
-            else
-                sscError(tokenizer, _("bad alternate surface"));
-        }
-        else if (itemType == "Location")
+    }
+    else if (itemType == "AltSurface")
+    {
+        auto surface = std::make_unique<Surface>();
+        surface->color = Color(1.0f, 1.0f, 1.0f);
+        FillinSurface(objectData, surface.get(), directory);
+        if (parent.body() != nullptr)
+            GetBodyFeaturesManager()->addAlternateSurface(parent.body(), primaryName, std::move(surface));
+        else
+            sscError(lineNumber, _("bad alternate surface"));
+    }
+    else if (itemType == "Location")
+    {
+        if (parent.body() != nullptr)
         {
-            if (parent.body() != nullptr)
+            std::unique_ptr<Location> location = CreateLocation(objectData, parent.body());
+            if (location != nullptr)
             {
-                std::unique_ptr<Location> location = CreateLocation(objectData, parent.body());
-                if (location != nullptr)
-                {
-                    UserCategory::loadCategories(location.get(), *objectData, disposition, directory.string());
-                    location->setName(primaryName);
-                    GetBodyFeaturesManager()->addLocation(parent.body(), std::move(location));
-                }
-                else
-                {
-                    sscError(tokenizer, _("bad location"));
-                }
+                UserCategory::loadCategories(location.get(), *objectData, disposition, directory.string());
+                location->setName(primaryName);
+                GetBodyFeaturesManager()->addLocation(parent.body(), std::move(location));
             }
             else
             {
-                sscError(tokenizer, fmt::sprintf(_("parent body '%s' of '%s' not found.\n"), parentName, primaryName));
+                sscError(lineNumber, _("bad location"));
             }
         }
+        else
+        {
+            sscError(lineNumber, fmt::sprintf(_("parent body '%s' of '%s' not found.\n"), parentName, primaryName));
+        }
     }
+}
+
+void BindCatalogDomain([[maybe_unused]] const fs::path& directory)
+{
+#ifdef ENABLE_NLS
+    std::string s = directory.string();
+    const char* d = s.c_str();
+    bindtextdomain(d, d); // domain name is the same as resource path
+#endif
+}
+
+// Write the definitions of a catalog to the cache without creating any
+// object
+bool CompileSolarSystemObjects(std::string_view contents,
+                               engine::SolarSystemCatalogCache::Writer& cacheWriter)
+{
+    Tokenizer tokenizer(contents);
+    util::Parser parser(&tokenizer);
+
+    engine::SolarSystemDefinition definition;
+    bool error = false;
+    while (ReadSolarSystemDefinition(tokenizer, parser, definition, error))
+        cacheWriter.write(definition);
+
+    return !error && cacheWriter.commit();
+}
+
+// Objects are created as soon as they are read, so that later definitions
+// can refer to them. The definitions are also passed to the cache writer,
+// if any, which is only committed if the whole file was read.
+bool ParseSolarSystemObjects(Tokenizer& tokenizer,
+                             Universe& universe,
+                             const fs::path& directory,
+                             engine::SolarSystemCatalogCache::Writer* cacheWriter = nullptr,
+                             std::size_t* objectCount = nullptr)
+{
+    util::Parser parser(&tokenizer);
+    BindCatalogDomain(directory);
+
+    engine::SolarSystemDefinition definition;
+    bool error = false;
+    while (ReadSolarSystemDefinition(tokenizer, parser, definition, error))
+    {
+        CreateSolarSystemObject(definition, universe, directory);
+        if (cacheWriter != nullptr)
+            cacheWriter->write(definition);
+        if (objectCount != nullptr)
+            ++*objectCount;
+    }
+
+    if (error)
+        return false;
+
+    if (cacheWriter != nullptr && !cacheWriter->commit())
+        GetLogger()->warn(_("Failed to write the solar system catalog cache\n"));
 
     // TODO: Return some notification if there's an error parsing the file
     return true;
 }
 
+bool IsBodyItem(std::string_view itemType)
+{
+    return itemType == "Body"sv || itemType == "ReferencePoint"sv || itemType == "SurfaceObject"sv;
+}
+
+std::string GetPrimaryName(const std::string& nameList)
+{
+    return nameList.substr(0, nameList.find(':'));
+}
+
+Body* FindCatalogBody(const Universe& universe, const std::string& parentName, const std::string& name)
+{
+    Selection parent = universe.findPath(parentName, {});
+    const PlanetarySystem* system = nullptr;
+    if (parent.star() != nullptr)
+    {
+        if (const SolarSystem* solarSystem = universe.getSolarSystem(parent.star()); solarSystem != nullptr)
+            system = solarSystem->getPlanets();
+    }
+    else if (parent.body() != nullptr)
+    {
+        system = parent.body()->getSatellites();
+    }
+
+    return system == nullptr ? nullptr : system->find(name);
+}
+
+// Locations are kept in a list, so a location which is defined again
+// would be added twice: update the existing one instead.
+void ReloadLocation(const engine::SolarSystemDefinition& definition,
+                    Universe& universe,
+                    const fs::path& directory)
+{
+    Body* body = universe.findPath(definition.parentName, {}).body();
+    std::string name = GetPrimaryName(definition.nameList);
+    Location* existing = body == nullptr
+        ? nullptr
+        : GetBodyFeaturesManager()->findLocation(body, name);
+    if (existing == nullptr)
+    {
+        CreateSolarSystemObject(definition, universe, directory);
+        return;
+    }
+
+    std::unique_ptr<Location> location = CreateLocation(definition.properties.getHash(), body);
+    if (location == nullptr)
+    {
+        sscError(definition.lineNumber, _("bad location"));
+        return;
+    }
+
+    location->setName(name);
+    *existing = std::move(*location);
+    existing->setParentBody(body);
+}
+
+} // end unnamed namespace
+
+struct PendingSolarSystems::Source
+{
+    std::unique_ptr<engine::SolarSystemCatalogCache::Reader> reader;
+    fs::path directory;
+};
+
+bool LoadSolarSystemObjects(std::istream& in,
+                            Universe& universe,
+                            const fs::path& directory)
+{
+    Tokenizer tokenizer(&in);
+    return ParseSolarSystemObjects(tokenizer, universe, directory);
+}
+
+bool LoadSolarSystemObjects(std::string_view contents,
+                            Universe& universe,
+                            const fs::path& directory,
+                            engine::SolarSystemCatalogCache* cache,
+                            std::size_t* objectCount)
+{
+    if (cache == nullptr)
+    {
+        Tokenizer tokenizer(contents);
+        return ParseSolarSystemObjects(tokenizer, universe, directory, nullptr, objectCount);
+    }
+
+    std::uint64_t key = engine::SolarSystemCatalogCache::computeKey(contents);
+    auto reader = cache->open(key);
+
+    PendingSolarSystems* pending = universe.getPendingSolarSystems();
+    if (reader == nullptr && pending != nullptr)
+    {
+        // Compile the catalog first, so that its definitions can be read
+        // back when their solar systems are looked up
+        if (auto writer = cache->create(key);
+            writer != nullptr && CompileSolarSystemObjects(contents, *writer))
+        {
+            reader = cache->open(key);
+        }
+    }
+
+    if (reader != nullptr)
+    {
+        if (pending != nullptr)
+        {
+            pending->add(std::make_shared<PendingSolarSystems::Source>(
+                PendingSolarSystems::Source{ std::move(reader), directory }));
+            return true;
+        }
+
+        BindCatalogDomain(directory);
+
+        engine::SolarSystemDefinition definition;
+        while (reader->read(definition))
+        {
+            CreateSolarSystemObject(definition, universe, directory);
+            if (objectCount != nullptr)
+                ++*objectCount;
+        }
+
+        return true;
+    }
+
+    // When loading lazily, the catalog could not be compiled: load it as a
+    // whole instead
+    Tokenizer tokenizer(contents);
+    auto writer = pending == nullptr ? cache->create(key) : nullptr;
+    return ParseSolarSystemObjects(tokenizer, universe, directory, writer.get(), objectCount);
+}
+
+bool ListSolarSystemObjects(std::string_view contents, SolarSystemCatalogObjects& objects)
+{
+    Tokenizer tokenizer(contents);
+    util::Parser parser(&tokenizer);
+
+    engine::SolarSystemDefinition definition;
+    bool error = false;
+    while (ReadSolarSystemDefinition(tokenizer, parser, definition, error))
+    {
+        if (IsBodyItem(definition.itemType) && definition.disposition == DataDisposition::Add)
+            objects.emplace_back(definition.parentName, GetPrimaryName(definition.nameList));
+    }
+
+    return !error;
+}
+
+bool ReloadSolarSystemObjects(std::string_view contents,
+                              Universe& universe,
+                              const fs::path& directory,
+                              SolarSystemCatalogObjects& objects)
+{
+    Tokenizer tokenizer(contents);
+    util::Parser parser(&tokenizer);
+    BindCatalogDomain(directory);
+
+    // Other threads wait until the reloaded objects are complete
+    Universe::SolarSystemWriteGuard guard(universe);
+
+    SolarSystemCatalogObjects added;
+    engine::SolarSystemDefinition definition;
+    bool error = false;
+    while (ReadSolarSystemDefinition(tokenizer, parser, definition, error))
+    {
+        if (definition.itemType == "Location")
+        {
+            ReloadLocation(definition, universe, directory);
+            continue;
+        }
+
+        if (IsBodyItem(definition.itemType) && definition.disposition == DataDisposition::Add)
+        {
+            auto& [parentName, name] = added.emplace_back(definition.parentName, GetPrimaryName(definition.nameList));
+            // Bodies which are new keep the Add disposition, so that their
+            // aliases are set
+            if (FindCatalogBody(universe, parentName, name) != nullptr)
+                definition.disposition = DataDisposition::Replace;
+        }
+
+        CreateSolarSystemObject(definition, universe, directory);
+    }
+
+    std::sort(added.begin(), added.end());
+    if (error)
+    {
+        // The rest of the file wasn't read, so keep the bodies it had
+        objects.insert(objects.end(), added.begin(), added.end());
+        std::sort(objects.begin(), objects.end());
+        objects.erase(std::unique(objects.begin(), objects.end()), objects.end());
+    }
+    else
+    {
+        for (const auto& [parentName, name] : objects)
+        {
+            if (std::binary_search(added.begin(), added.end(), std::make_pair(parentName, name)))
+                continue;
+
+            if (Body* body = FindCatalogBody(universe, parentName, name); body != nullptr)
+            {
+                body->setVisible(false);
+                body->setClickable(false);
+            }
+        }
+
+        objects = std::move(added);
+    }
+
+    universe.catalogsChanged();
+    return !error;
+}
+
+PendingSolarSystems::PendingSolarSystems(Universe& _universe) :
+    universe(_universe),
+    ownerThread(std::this_thread::get_id())
+{
+}
+
+PendingSolarSystems::~PendingSolarSystems() = default;
+
+bool
+PendingSolarSystems::contains(std::uint32_t starIndex) const
+{
+    return pending.find(starIndex) != pending.end();
+}
+
+void
+PendingSolarSystems::create(const Entry& entry)
+{
+    engine::SolarSystemDefinition definition;
+    if (!entry.source->reader->readAt(entry.offset, definition))
+        return;
+
+    BindCatalogDomain(entry.source->directory);
+    CreateSolarSystemObject(definition, universe, entry.source->directory);
+}
+
+void
+PendingSolarSystems::realize(std::uint32_t starIndex)
+{
+    if (std::this_thread::get_id() != ownerThread)
+        return;
+
+    // Only this thread modifies the pending solar systems, so looking them
+    // up doesn't need the lock
+    auto iter = pending.find(starIndex);
+    if (iter == pending.end())
+        return;
+
+    {
+        // Other threads wait until the solar system is complete
+        Universe::SolarSystemWriteGuard guard(universe);
+
+        // Remove the entries first, as creating the objects looks the solar
+        // system up again
+        std::vector<Entry> entries = std::move(iter->second);
+        pending.erase(iter);
+
+        for (const Entry& entry : entries)
+            create(entry);
+    }
+
+    universe.catalogsChanged();
+}
+
+void
+PendingSolarSystems::realizeAll()
+{
+    if (std::this_thread::get_id() != ownerThread)
+        return;
+
+    while (!pending.empty())
+        realize(pending.begin()->first);
+}
+
+void
+PendingSolarSystems::add(const std::shared_ptr<Source>& source)
+{
+    const StarDatabase* stars = universe.getStarCatalog();
+    const SolarSystemCatalog* solarSystems = universe.getSolarSystemCatalog();
+    Universe::SolarSystemWriteGuard guard(universe);
+
+    engine::SolarSystemDefinition definition;
+    for (;;)
+    {
+        std::size_t offset = source->reader->tell();
+        if (!source->reader->skip(definition))
+            break;
+
+        std::string_view parentName = definition.parentName;
+        const Star* star = stars == nullptr
+            ? nullptr
+            : stars->find(parentName.substr(0, parentName.find('/')), false);
+        if (star == nullptr)
+        {
+            // The parent could be in any solar system
+            realizeAll();
+            create(Entry{ source, offset });
+            continue;
+        }
+
+        std::uint32_t starIndex = star->getIndex();
+        if (auto iter = pending.find(starIndex); iter != pending.end())
+            iter->second.push_back(Entry{ source, offset });
+        else if (solarSystems->find(starIndex) != solarSystems->end())
+            create(Entry{ source, offset });
+        else
+            pending[starIndex].push_back(Entry{ source, offset });
+    }
+}
+
 
 SolarSystem::SolarSystem(Star* _star) :
     star(_star)
@@ -9,15 +9,26 @@
 
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <iosfwd>
 #include <map>
 #include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
 
 #include <Eigen/Core>
 
 #include <celcompat/filesystem.h>
 
+namespace celestia::engine
+{
+class SolarSystemCatalogCache;
+}
+
 class FrameTree;
 class PlanetarySystem;
 class Star;
@@ -42,6 +53,75 @@ class SolarSystem
 
 using SolarSystemCatalog = std::map<std::uint32_t, std::unique_ptr<SolarSystem>>;
 
+// The solar systems which haven't been looked up yet when loading them
+// lazily. Their definitions are only indexed by their offsets into the
+// compiled catalogs of the cache, and the objects are created the first time
+// the universe is asked for the solar system of their star.
+class PendingSolarSystems
+{
+ public:
+    // A compiled catalog and the directory of its source
+    struct Source;
+
+    explicit PendingSolarSystems(Universe&);
+    ~PendingSolarSystems();
+
+    PendingSolarSystems(const PendingSolarSystems&) = delete;
+    PendingSolarSystems& operator=(const PendingSolarSystems&) = delete;
+
+    // Safe on other threads while they hold a read lock of the universe
+    bool contains(std::uint32_t starIndex) const;
+
+    // Create the objects of a pending solar system. This is only done on
+    // the thread which loaded the catalogs, holding the solar system write
+    // guard of the universe; other threads only see the solar systems
+    // already created, once they are complete.
+    void realize(std::uint32_t starIndex);
+    void realizeAll();
+
+    // Index the definitions of a catalog; the ones with a parent path which
+    // doesn't start at a star are created right away.
+    void add(const std::shared_ptr<Source>&);
+
+ private:
+    struct Entry
+    {
+        std::shared_ptr<Source> source;
+        std::size_t offset;
+    };
+
+    void create(const Entry&);
+
+    Universe& universe;
+    std::map<std::uint32_t, std::vector<Entry>> pending;
+    std::thread::id ownerThread;
+};
+
 bool LoadSolarSystemObjects(std::istream& in,
                             Universe& universe,
                             const fs::path& dir = fs::path());
+// Parse a catalog held in memory, such as a mapped file. With a cache, the
+// objects are read from the compiled copy of the catalog when there is one,
+// and the copy is created otherwise. The number of objects created, which
+// excludes the ones left pending, is added to objectCount.
+bool LoadSolarSystemObjects(std::string_view contents,
+                            Universe& universe,
+                            const fs::path& dir = fs::path(),
+                            celestia::engine::SolarSystemCatalogCache* cache = nullptr,
+                            std::size_t* objectCount = nullptr);
+
+// The bodies a catalog adds, as the path of their parent and their name
+using SolarSystemCatalogObjects = std::vector<std::pair<std::string, std::string>>;
+
+// List the bodies a catalog adds without creating them
+bool ListSolarSystemObjects(std::string_view contents, SolarSystemCatalogObjects& objects);
+
+// Apply a catalog again after it was changed. The bodies it adds replace
+// their current definitions, and the locations it adds update the existing
+// ones of the same name. The bodies which it added before, as listed in
+// objects, but doesn't any longer are hidden rather than deleted, as they
+// may still be referred to. The list is updated to the new contents.
+bool ReloadSolarSystemObjects(std::string_view contents,
+                              Universe& universe,
+                              const fs::path& dir,
+                              SolarSystemCatalogObjects& objects);
@@ -0,0 +1,33 @@
+// spatialcatalog.cpp
+//
+// Copyright (C) 2025, Celestia Development Team
+//
+// Common base of the star and deep sky object databases.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include "spatialcatalog.h"
+
+#include <celutil/gettext.h>
+
+namespace celestia::engine::detail
+{
+
+std::string
+localizeCatalogName(const std::string& name, [[maybe_unused]] bool i18n)
+{
+#ifdef ENABLE_NLS
+    if (i18n)
+    {
+        const char* local = D_(name.c_str());
+        if (name != local)
+            return local;
+    }
+#endif
+    return name;
+}
+
+} // end namespace celestia::engine::detail
@@ -0,0 +1,258 @@
+// spatialcatalog.h
+//
+// Copyright (C) 2025, Celestia Development Team
+//
+// Common base of the star and deep sky object databases.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+
+#include <celengine/astroobj.h>
+#include <celengine/completion.h>
+#include <celengine/memoryreport.h>
+#include <celengine/octree.h>
+#include <celutil/threadpool.h>
+
+namespace celestia::engine
+{
+
+namespace detail
+{
+
+// Objects are held in the octree by value or by pointer
+template<typename OBJ>
+struct CatalogObject
+{
+    using type = OBJ;
+    static OBJ* get(OBJ& obj) { return &obj; }
+    // Memory held by an object outside of the octree
+    static constexpr std::size_t heapSize() { return 0; }
+};
+
+template<typename T>
+struct CatalogObject<std::unique_ptr<T>>
+{
+    using type = T;
+    static T* get(const std::unique_ptr<T>& obj) { return obj.get(); }
+    // The size of the base class, less than that of most derived types
+    static constexpr std::size_t heapSize() { return sizeof(T); }
+};
+
+// Translate a name of the catalog when i18n is set and translations are
+// enabled
+std::string localizeCatalogName(const std::string&, bool i18n);
+
+} // end namespace detail
+
+// The SpatialCatalog holds the objects of a catalog in a static octree, with
+// their names and an index sorted by catalog number. It provides what the
+// catalogs have in common: lookups by catalog number, completion of names,
+// the frustum of the visibility traversals and their split across the
+// thread pool, so that the catalogs only add the queries specific to their
+// objects.
+template<typename OBJ, typename PREC, typename NAMEDB>
+class SpatialCatalog
+{
+public:
+    using OctreeType = StaticOctree<OBJ, PREC>;
+    using ObjectType = typename detail::CatalogObject<OBJ>::type;
+    using PointType = typename OctreeType::PointType;
+    using FrustumPlanes = std::array<Eigen::Hyperplane<PREC, 3>, 5>;
+
+    // Catalogs smaller than this are always traversed on the calling
+    // thread, the overhead of distributing the work outweighs the gain
+    static constexpr OctreeObjectIndex ParallelTraversalMinObjects = 4096;
+
+    // Depth at which the octree is split into subtrees for parallel
+    // traversal, giving up to 8^depth independent work items
+    static constexpr OctreeDepthType ParallelTraversalSplitDepth = 3;
+
+    const OctreeType* getOctree() const { return m_octreeRoot.get(); }
+    std::uint32_t size() const { return m_octreeRoot->size(); }
+
+    ObjectType* getObject(std::uint32_t n) const { return detail::CatalogObject<OBJ>::get((*m_octreeRoot)[n]); }
+    ObjectType* findByCatalogNumber(AstroCatalog::IndexNumber) const;
+
+    void getCompletion(std::vector<Completion>&, std::string_view) const;
+
+    // Add the memory of the objects, the octree, the names and the catalog
+    // number index to the report, as entries prefixed by name
+    void reportMemoryUsage(MemoryReport&, std::string_view name) const;
+
+    // Compute the bounding planes of an infinite view frustum
+    static FrustumPlanes computeFrustumPlanes(const PointType& obsPosition,
+                                              const Eigen::Quaternionf& obsOrientation,
+                                              float fovY,
+                                              float aspectRatio);
+
+protected:
+    SpatialCatalog() = default;
+    ~SpatialCatalog() = default;
+
+    SpatialCatalog(const SpatialCatalog&) = delete;
+    SpatialCatalog& operator=(const SpatialCatalog&) = delete;
+
+    // Sort the index of the objects by catalog number, once the octree is
+    // built
+    void buildCatalogNumberIndex();
+
+    // The first name of the catalog number, empty if it has none
+    std::string getFirstName(AstroCatalog::IndexNumber, bool i18n) const;
+
+    // Split the octree into subtrees for traversal on the thread pool, from
+    // the nodes which pass the tests of the processor. Returns false when
+    // the traversal is better done on the calling thread.
+    template<typename PROCESSOR>
+    bool splitTraversal(PROCESSOR&, util::ThreadPool*, std::vector<OctreeNodeRange>&) const;
+
+    std::unique_ptr<OctreeType> m_octreeRoot;
+    std::unique_ptr<NAMEDB>     m_namesDB;
+    std::vector<std::uint32_t>  m_catalogNumberIndex;
+};
+
+template<typename OBJ, typename PREC, typename NAMEDB>
+typename SpatialCatalog<OBJ, PREC, NAMEDB>::ObjectType*
+SpatialCatalog<OBJ, PREC, NAMEDB>::findByCatalogNumber(AstroCatalog::IndexNumber catalogNumber) const
+{
+    auto it = std::lower_bound(m_catalogNumberIndex.begin(), m_catalogNumberIndex.end(),
+                               catalogNumber,
+                               [this](std::uint32_t idx, AstroCatalog::IndexNumber catNum)
+                               {
+                                   return getObject(idx)->getIndex() < catNum;
+                               });
+
+    if (it == m_catalogNumberIndex.end())
+        return nullptr;
+
+    ObjectType* obj = getObject(*it);
+    return obj->getIndex() == catalogNumber ? obj : nullptr;
+}
+
+template<typename OBJ, typename PREC, typename NAMEDB>
+void
+SpatialCatalog<OBJ, PREC, NAMEDB>::getCompletion(std::vector<Completion>& completion, std::string_view name) const
+{
+    // only named objects are supported by completion.
+    if (name.empty() || m_namesDB == nullptr)
+        return;
+
+    std::vector<std::pair<std::string, AstroCatalog::IndexNumber>> namesWithIndices;
+    m_namesDB->getCompletion(namesWithIndices, name);
+
+    for (const auto& [objName, index] : namesWithIndices)
+    {
+        auto capturedIndex = index;
+        completion.emplace_back(objName, [this, capturedIndex]
+        {
+            return Selection(findByCatalogNumber(capturedIndex));
+        });
+    }
+}
+
+template<typename OBJ, typename PREC, typename NAMEDB>
+void
+SpatialCatalog<OBJ, PREC, NAMEDB>::reportMemoryUsage(MemoryReport& report, std::string_view name) const
+{
+    std::string prefix(name);
+    std::size_t count = size();
+    report.add(prefix, m_octreeRoot->getObjectMemoryUsage() + count * detail::CatalogObject<OBJ>::heapSize(), count);
+    report.add(prefix + ".octree", m_octreeRoot->getNodeMemoryUsage(), m_octreeRoot->nodeCount());
+    if (m_namesDB != nullptr)
+        report.add(prefix + ".names", m_namesDB->getMemoryUsage());
+    report.add(prefix + ".index", VectorMemoryUsage(m_catalogNumberIndex));
+}
+
+template<typename OBJ, typename PREC, typename NAMEDB>
+typename SpatialCatalog<OBJ, PREC, NAMEDB>::FrustumPlanes
+SpatialCatalog<OBJ, PREC, NAMEDB>::computeFrustumPlanes(const PointType& obsPosition,
+                                                         const Eigen::Quaternionf& obsOrientation,
+                                                         float fovY,
+                                                         float aspectRatio)
+{
+    using VectorType = Eigen::Matrix<PREC, 3, 1>;
+
+    Eigen::Matrix<PREC, 3, 3> rot = obsOrientation.cast<PREC>().toRotationMatrix().transpose();
+    PREC h = std::tan(static_cast<PREC>(fovY) / PREC(2));
+    PREC w = h * static_cast<PREC>(aspectRatio);
+
+    std::array<VectorType, 5> planeNormals
+    {
+        VectorType(PREC(0), PREC(1), -h),
+        VectorType(PREC(0), PREC(-1), -h),
+        VectorType(PREC(1), PREC(0), -w),
+        VectorType(PREC(-1), PREC(0), -w),
+        VectorType(PREC(0), PREC(0), PREC(-1)),
+    };
+
+    FrustumPlanes frustumPlanes;
+    for (std::size_t i = 0; i < planeNormals.size(); ++i)
+        frustumPlanes[i] = Eigen::Hyperplane<PREC, 3>(rot * planeNormals[i].normalized(), obsPosition);
+
+    return frustumPlanes;
+}
+
+template<typename OBJ, typename PREC, typename NAMEDB>
+void
+SpatialCatalog<OBJ, PREC, NAMEDB>::buildCatalogNumberIndex()
+{
+    m_catalogNumberIndex.resize(m_octreeRoot->size());
+    std::iota(m_catalogNumberIndex.begin(), m_catalogNumberIndex.end(), UINT32_C(0));
+    std::sort(m_catalogNumberIndex.begin(), m_catalogNumberIndex.end(),
+              [this](std::uint32_t idx0, std::uint32_t idx1)
+              {
+                  return getObject(idx0)->getIndex() < getObject(idx1)->getIndex();
+              });
+}
+
+template<typename OBJ, typename PREC, typename NAMEDB>
+std::string
+SpatialCatalog<OBJ, PREC, NAMEDB>::getFirstName(AstroCatalog::IndexNumber catalogNumber, bool i18n) const
+{
+    if (m_namesDB == nullptr)
+        return {};
+
+    auto iter = m_namesDB->getFirstNameIter(catalogNumber);
+    if (iter == m_namesDB->getFinalNameIter())
+        return {};
+
+    return detail::localizeCatalogName(iter->second, i18n);
+}
+
+template<typename OBJ, typename PREC, typename NAMEDB>
+template<typename PROCESSOR>
+bool
+SpatialCatalog<OBJ, PREC, NAMEDB>::splitTraversal(PROCESSOR& processor,
+                                                  util::ThreadPool* threadPool,
+                                                  std::vector<OctreeNodeRange>& ranges) const
+{
+    if (threadPool == nullptr
+        || threadPool->threadCount() == 0
+        || m_octreeRoot->size() < ParallelTraversalMinObjects)
+    {
+        return false;
+    }
+
+    m_octreeRoot->splitDepthFirst(processor, ParallelTraversalSplitDepth, ranges);
+    return true;
+}
+
+} // end namespace celestia::engine
@@ -0,0 +1,504 @@
+// ssccache.cpp
+//
+// On-disk cache of parsed solar system catalogs.
+//
+// Copyright (C) 2024, Celestia Development Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include "ssccache.h"
+
+#include <cstring>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include <celcompat/charconv.h>
+#include <celutil/binaryread.h>
+#include <celutil/mappedfile.h>
+
+namespace celestia::engine
+{
+
+namespace
+{
+
+// Nesting of arrays and hashes deeper than this is treated as corruption
+constexpr int MaxDepth = 64;
+
+// The header stores the magic, the version, the key, the number of
+// definitions and the checksum of the rest of the file
+constexpr std::size_t HeaderSize = 8 + sizeof(std::uint32_t) + sizeof(std::uint64_t) +
+                                   sizeof(std::uint32_t) + sizeof(std::uint64_t);
+
+// Size of the type and units of a value
+constexpr std::size_t ValueHeaderSize = 5;
+
+// Definitions are written out once this much data has been serialized
+constexpr std::size_t WriteBufferSize = 65536;
+
+} // end unnamed namespace
+
+SolarSystemCatalogCache::SolarSystemCatalogCache(const fs::path& directory) :
+    m_directory(directory)
+{
+}
+
+std::uint64_t
+SolarSystemCatalogCache::computeKey(std::string_view contents)
+{
+    return util::FNV1aHash().addValue(Version).addBytes(contents).value();
+}
+
+fs::path
+SolarSystemCatalogCache::getPath(std::uint64_t key) const
+{
+    return m_directory / fmt::format("{:016x}{}", key, Extension);
+}
+
+std::unique_ptr<SolarSystemCatalogCache::Reader>
+SolarSystemCatalogCache::open(std::uint64_t key)
+{
+    m_used.insert(key);
+
+    auto file = util::MappedFile::open(getPath(key));
+    if (file == nullptr || file->size() < HeaderSize)
+        return nullptr;
+
+    const char* data = file->data();
+    if (std::string_view(data, Magic.size()) != Magic)
+        return nullptr;
+
+    std::size_t position = Magic.size();
+    auto version = util::fromMemoryNative<std::uint32_t>(data + position);
+    position += sizeof(std::uint32_t);
+    auto fileKey = util::fromMemoryNative<std::uint64_t>(data + position);
+    position += sizeof(std::uint64_t);
+    auto count = util::fromMemoryNative<std::uint32_t>(data + position);
+    position += sizeof(std::uint32_t);
+    auto checksum = util::fromMemoryNative<std::uint64_t>(data + position);
+    position += sizeof(std::uint64_t);
+
+    if (version != Version || fileKey != key)
+        return nullptr;
+
+    // Verify the whole file up front, so that a damaged cache is never
+    // found halfway through creating the objects
+    if (util::FNV1aHash().addBytes(data + position, file->size() - position).value() != checksum)
+        return nullptr;
+
+    return std::unique_ptr<Reader>(new Reader(std::move(file), position, count));
+}
+
+std::unique_ptr<SolarSystemCatalogCache::Writer>
+SolarSystemCatalogCache::create(std::uint64_t key)
+{
+    m_used.insert(key);
+
+    std::error_code ec;
+    fs::create_directories(m_directory, ec);
+
+    std::unique_ptr<Writer> writer(new Writer(getPath(key), key));
+    if (!writer->m_file.stream().good())
+        return nullptr;
+
+    return writer;
+}
+
+void
+SolarSystemCatalogCache::removeUnused() const
+{
+    std::error_code ec;
+    std::vector<fs::path> unused;
+    for (auto iter = fs::directory_iterator(m_directory, ec); iter != end(iter); iter.increment(ec))
+    {
+        if (ec)
+            break;
+
+        const fs::path& path = iter->path();
+        if (path.extension() != Extension)
+            continue;
+
+        std::string stem = path.stem().string();
+        std::uint64_t key = 0;
+        if (auto [ptr, ec2] = compat::from_chars(stem.data(), stem.data() + stem.size(), key, 16);
+            ec2 != std::errc{} || ptr != stem.data() + stem.size() || m_used.count(key) == 0)
+        {
+            unused.push_back(path);
+        }
+    }
+
+    for (const fs::path& path : unused)
+        fs::remove(path, ec);
+}
+
+SolarSystemCatalogCache::Reader::Reader(std::unique_ptr<util::MappedFile>&& file,
+                                        std::size_t position,
+                                        std::uint32_t count) :
+    m_file(std::move(file)),
+    m_position(position),
+    m_remaining(count)
+{
+}
+
+SolarSystemCatalogCache::Reader::~Reader() = default;
+
+template<typename T>
+bool
+SolarSystemCatalogCache::Reader::readNative(T& value)
+{
+    if (m_file->size() - m_position < sizeof(T))
+        return false;
+
+    value = util::fromMemoryNative<T>(m_file->data() + m_position);
+    m_position += sizeof(T);
+    return true;
+}
+
+bool
+SolarSystemCatalogCache::Reader::readString(std::string_view& str)
+{
+    std::uint32_t length;
+    if (!readNative(length) || m_file->size() - m_position < length)
+        return false;
+
+    str = std::string_view(m_file->data() + m_position, length);
+    m_position += length;
+    return true;
+}
+
+bool
+SolarSystemCatalogCache::Reader::readValue(util::Value& value, int depth)
+{
+    std::uint8_t type;
+    util::Value::Units units;
+    if (depth > MaxDepth ||
+        !readNative(type) ||
+        !readNative(units.length) ||
+        !readNative(units.time) ||
+        !readNative(units.angle) ||
+        !readNative(units.mass))
+    {
+        return false;
+    }
+
+    switch (static_cast<util::ValueType>(type))
+    {
+    case util::ValueType::NullType:
+        value = util::Value();
+        break;
+    case util::ValueType::NumberType:
+        if (double number; readNative(number))
+            value = util::Value(number);
+        else
+            return false;
+        break;
+    case util::ValueType::BooleanType:
+        if (std::uint8_t boolean; readNative(boolean))
+            value = util::Value(boolean != 0);
+        else
+            return false;
+        break;
+    case util::ValueType::StringType:
+        if (std::string_view str; readString(str))
+            value = util::Value(str);
+        else
+            return false;
+        break;
+    case util::ValueType::ArrayType:
+        {
+            std::uint32_t count;
+            if (!readNative(count))
+                return false;
+
+            // Every value takes at least its type and units
+            if (count > (m_file->size() - m_position) / ValueHeaderSize)
+                return false;
+
+            auto array = std::make_unique<util::ValueArray>();
+            array->reserve(count);
+            for (std::uint32_t i = 0; i < count; ++i)
+            {
+                if (!readValue(array->emplace_back(), depth + 1))
+                    return false;
+            }
+
+            value = util::Value(std::move(array));
+        }
+        break;
+    case util::ValueType::HashType:
+        {
+            std::uint32_t count;
+            if (!readNative(count))
+                return false;
+
+            auto hash = std::make_unique<util::AssociativeArray>();
+            for (std::uint32_t i = 0; i < count; ++i)
+            {
+                std::string_view key;
+                util::Value element;
+                if (!readString(key) || !readValue(element, depth + 1))
+                    return false;
+                hash->addValue(key, std::move(element));
+            }
+
+            value = util::Value(std::move(hash));
+        }
+        break;
+    default:
+        return false;
+    }
+
+    value.setUnits(units);
+    return true;
+}
+
+bool
+SolarSystemCatalogCache::Reader::skipValue(int depth)
+{
+    std::uint8_t type;
+    if (depth > MaxDepth ||
+        !readNative(type) ||
+        m_file->size() - m_position < ValueHeaderSize - 1)
+    {
+        return false;
+    }
+
+    m_position += ValueHeaderSize - 1;
+
+    std::size_t size = 0;
+    switch (static_cast<util::ValueType>(type))
+    {
+    case util::ValueType::NullType:
+        return true;
+    case util::ValueType::NumberType:
+        size = sizeof(double);
+        break;
+    case util::ValueType::BooleanType:
+        size = sizeof(std::uint8_t);
+        break;
+    case util::ValueType::StringType:
+        {
+            std::string_view str;
+            return readString(str);
+        }
+    case util::ValueType::ArrayType:
+    case util::ValueType::HashType:
+        {
+            bool isHash = static_cast<util::ValueType>(type) == util::ValueType::HashType;
+            std::uint32_t count;
+            if (!readNative(count))
+                return false;
+
+            for (std::uint32_t i = 0; i < count; ++i)
+            {
+                std::string_view key;
+                if ((isHash && !readString(key)) || !skipValue(depth + 1))
+                    return false;
+            }
+        }
+        return true;
+    default:
+        return false;
+    }
+
+    if (m_file->size() - m_position < size)
+        return false;
+
+    m_position += size;
+    return true;
+}
+
+bool
+SolarSystemCatalogCache::Reader::readDefinition(SolarSystemDefinition& definition, bool withProperties)
+{
+    std::uint8_t disposition;
+    std::int32_t lineNumber;
+    std::string_view itemType;
+    std::string_view nameList;
+    std::string_view parentName;
+    if (!readNative(disposition) ||
+        disposition > static_cast<std::uint8_t>(DataDisposition::Replace) ||
+        !readNative(lineNumber) ||
+        !readString(itemType) ||
+        !readString(nameList) ||
+        !readString(parentName) ||
+        !(withProperties ? readValue(definition.properties, 0) : skipValue(0)))
+    {
+        return false;
+    }
+
+    definition.disposition = static_cast<DataDisposition>(disposition);
+    definition.lineNumber = lineNumber;
+    definition.itemType = itemType;
+    definition.nameList = nameList;
+    definition.parentName = parentName;
+    if (!withProperties)
+        definition.properties = util::Value();
+
+    return true;
+}
+
+bool
+SolarSystemCatalogCache::Reader::read(SolarSystemDefinition& definition)
+{
+    if (m_remaining == 0)
+        return false;
+
+    if (!readDefinition(definition, true))
+    {
+        m_remaining = 0;
+        return false;
+    }
+
+    --m_remaining;
+    return true;
+}
+
+bool
+SolarSystemCatalogCache::Reader::skip(SolarSystemDefinition& definition)
+{
+    if (m_remaining == 0)
+        return false;
+
+    if (!readDefinition(definition, false))
+    {
+        m_remaining = 0;
+        return false;
+    }
+
+    --m_remaining;
+    return true;
+}
+
+bool
+SolarSystemCatalogCache::Reader::readAt(std::size_t offset, SolarSystemDefinition& definition)
+{
+    if (offset >= m_file->size())
+        return false;
+
+    std::size_t position = m_position;
+    m_position = offset;
+    bool result = readDefinition(definition, true);
+    m_position = position;
+    return result;
+}
+
+SolarSystemCatalogCache::Writer::Writer(const fs::path& path, std::uint64_t key) :
+    m_file(path),
+    m_key(key)
+{
+    // The header is filled in when the file is committed
+    m_file.stream().write(std::string(HeaderSize, '\0').data(), HeaderSize);
+    m_buffer.reserve(WriteBufferSize);
+}
+
+template<typename T>
+void
+SolarSystemCatalogCache::Writer::writeNative(T value)
+{
+    char bytes[sizeof(T)]; //NOSONAR
+    std::memcpy(bytes, &value, sizeof(T));
+    m_buffer.append(bytes, sizeof(T));
+}
+
+void
+SolarSystemCatalogCache::Writer::writeString(std::string_view str)
+{
+    writeNative(static_cast<std::uint32_t>(str.size()));
+    m_buffer.append(str);
+}
+
+void
+SolarSystemCatalogCache::Writer::writeValue(const util::Value& value)
+{
+    writeNative(static_cast<std::uint8_t>(value.getType()));
+    writeNative(value.getLengthUnit());
+    writeNative(value.getTimeUnit());
+    writeNative(value.getAngleUnit());
+    writeNative(value.getMassUnit());
+
+    switch (value.getType())
+    {
+    case util::ValueType::NumberType:
+        writeNative(*value.getNumber());
+        break;
+    case util::ValueType::BooleanType:
+        writeNative(static_cast<std::uint8_t>(*value.getBoolean() ? 1 : 0));
+        break;
+    case util::ValueType::StringType:
+        writeString(*value.getString());
+        break;
+    case util::ValueType::ArrayType:
+        {
+            const util::ValueArray* array = value.getArray();
+            writeNative(static_cast<std::uint32_t>(array->size()));
+            for (const util::Value& element : *array)
+                writeValue(element);
+        }
+        break;
+    case util::ValueType::HashType:
+        {
+            const util::AssociativeArray* hash = value.getHash();
+            std::uint32_t count = 0;
+            auto countAction = [&count](std::string_view, const util::Value&) { ++count; };
+            hash->for_all(countAction);
+            writeNative(count);
+
+            auto writeAction = [this](std::string_view key, const util::Value& element)
+            {
+                writeString(key);
+                writeValue(element);
+            };
+            hash->for_all(writeAction);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+void
+SolarSystemCatalogCache::Writer::write(const SolarSystemDefinition& definition)
+{
+    writeNative(static_cast<std::uint8_t>(definition.disposition));
+    writeNative(static_cast<std::int32_t>(definition.lineNumber));
+    writeString(definition.itemType);
+    writeString(definition.nameList);
+    writeString(definition.parentName);
+    writeValue(definition.properties);
+    ++m_count;
+
+    if (m_buffer.size() >= WriteBufferSize)
+    {
+        m_checksum.addBytes(m_buffer);
+        m_file.stream().write(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size()));
+        m_buffer.clear();
+    }
+}
+
+bool
+SolarSystemCatalogCache::Writer::commit()
+{
+    std::ofstream& out = m_file.stream();
+    m_checksum.addBytes(m_buffer);
+    out.write(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size()));
+    m_buffer.clear();
+
+    writeNative(Version);
+    writeNative(m_key);
+    writeNative(m_count);
+    writeNative(m_checksum.value());
+    out.seekp(0);
+    out.write(Magic.data(), Magic.size());
+    out.write(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size()));
+
+    return m_file.commit();
+}
+
+} // end namespace celestia::engine
@@ -0,0 +1,149 @@
+// ssccache.h
+//
+// On-disk cache of parsed solar system catalogs.
+//
+// Copyright (C) 2024, Celestia Development Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <set>
+#include <string>
+#include <string_view>
+
+#include <celcompat/filesystem.h>
+#include <celutil/associativearray.h>
+#include <celutil/atomicfile.h>
+#include <celutil/hash.h>
+#include "parseobject.h"
+
+namespace celestia
+{
+namespace util
+{
+class MappedFile;
+}
+
+namespace engine
+{
+
+// One object definition of a .ssc file as it was parsed, before any object
+// is created from it
+struct SolarSystemDefinition
+{
+    DataDisposition disposition{ DataDisposition::Add };
+    std::string itemType;
+    std::string nameList;
+    std::string parentName;
+    int lineNumber{ 0 };
+    util::Value properties;
+};
+
+// The SolarSystemCatalogCache stores the object definitions of a .ssc file
+// in a binary form, so that later runs skip tokenizing and parsing the file.
+// Creating the objects from the definitions is left to the loader, as the
+// bodies refer to other objects of the universe and to the resources.
+//
+// Each file of the cache is named after a hash of the contents of the source
+// file. Like the octree cache, it is written in native byte order as it is
+// only ever read back on the machine which wrote it.
+class SolarSystemCatalogCache
+{
+public:
+    class Reader;
+    class Writer;
+
+    explicit SolarSystemCatalogCache(const fs::path& directory);
+
+    static std::uint64_t computeKey(std::string_view contents);
+
+    // Returns nullptr if there is no valid cache for the key
+    std::unique_ptr<Reader> open(std::uint64_t key);
+    std::unique_ptr<Writer> create(std::uint64_t key);
+
+    // Delete the files of the cache which weren't opened or created since
+    // the cache was constructed
+    void removeUnused() const;
+
+private:
+    static constexpr std::string_view Magic{ "CELSSCCH" };
+    static constexpr std::uint32_t Version = 1;
+    static constexpr std::string_view Extension{ ".sscc" };
+
+    fs::path getPath(std::uint64_t key) const;
+
+    fs::path m_directory;
+    std::set<std::uint64_t> m_used;
+};
+
+class SolarSystemCatalogCache::Reader
+{
+public:
+    ~Reader();
+
+    Reader(const Reader&) = delete;
+    Reader& operator=(const Reader&) = delete;
+
+    // Returns false at the end of the definitions
+    bool read(SolarSystemDefinition&);
+    // Like read, but leaves out the properties
+    bool skip(SolarSystemDefinition&);
+
+    // Offset of the next definition, which can be read again later with
+    // readAt
+    std::size_t tell() const { return m_position; }
+    bool readAt(std::size_t offset, SolarSystemDefinition&);
+
+private:
+    Reader(std::unique_ptr<util::MappedFile>&&, std::size_t position, std::uint32_t count);
+
+    bool readDefinition(SolarSystemDefinition&, bool withProperties);
+    bool readValue(util::Value&, int depth);
+    bool skipValue(int depth);
+    bool readString(std::string_view&);
+    template<typename T> bool readNative(T&);
+
+    std::unique_ptr<util::MappedFile> m_file;
+    std::size_t m_position;
+    std::uint32_t m_remaining;
+
+    friend class SolarSystemCatalogCache;
+};
+
+class SolarSystemCatalogCache::Writer
+{
+public:
+    ~Writer() = default;
+
+    Writer(const Writer&) = delete;
+    Writer& operator=(const Writer&) = delete;
+
+    void write(const SolarSystemDefinition&);
+    // Finish the file; if this isn't called, nothing is added to the cache
+    bool commit();
+
+private:
+    Writer(const fs::path&, std::uint64_t key);
+
+    void writeValue(const util::Value&);
+    void writeString(std::string_view);
+    template<typename T> void writeNative(T);
+
+    util::AtomicFile m_file;
+    std::string m_buffer;
+    std::uint64_t m_key;
+    util::FNV1aHash m_checksum;
+    std::uint32_t m_count{ 0 };
+
+    friend class SolarSystemCatalogCache;
+};
+
+} // end namespace engine
+} // end namespace celestia
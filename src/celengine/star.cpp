@@ -14,7 +14,10 @@
 #include <cassert>
 #include <cmath>
 #include <cstddef>
+#include <cstdint>
 #include <cstring>
+#include <functional>
+#include <string_view>
 #include <utility>
 
 #include <fmt/format.h>
@@ -1072,6 +1075,62 @@ StarDetails::shared() const
     return isShared;
 }
 
+void
+StarDetailsPool::intern(boost::intrusive_ptr<StarDetails>& d)
+{
+    if (d->shared() || d->orbit != nullptr || d->barycenter != nullptr || d->orbitingStars != nullptr)
+        return;
+
+    if (auto [it, inserted] = details.insert(d); inserted)
+        d->isShared = true;
+    else
+        d = *it;
+}
+
+std::size_t
+StarDetailsPool::Hasher::operator()(const boost::intrusive_ptr<StarDetails>& d) const noexcept
+{
+    // Based on documentation of boost::hash_combine
+    constexpr std::size_t phi = sizeof(std::size_t) == sizeof(std::uint32_t)
+        ? static_cast<std::size_t>(0x9e3779b9) //NOSONAR
+        : static_cast<std::size_t>(0x9e3779b97f4a7c15); //NOSONAR
+
+    std::size_t seed = 0;
+    auto combine = [&seed](std::size_t value) { seed ^= value + phi + (seed << 6) + (seed >> 2); };
+
+    combine(std::hash<float>{}(d->radius));
+    combine(std::hash<float>{}(d->temperature));
+    combine(std::hash<float>{}(d->bolometricCorrection));
+    combine(static_cast<std::size_t>(d->knowledge));
+    combine(std::hash<std::string_view>{}(std::string_view(d->spectralType.data())));
+    for (auto resolution : { TextureResolution::lores, TextureResolution::medres, TextureResolution::hires })
+        combine(std::hash<ResourceHandle>{}(d->texture.texture(resolution)));
+    combine(std::hash<ResourceHandle>{}(d->geometry));
+    combine(std::hash<const ephem::RotationModel*>{}(d->rotationModel.get()));
+    for (int i = 0; i < 3; ++i)
+        combine(std::hash<float>{}(d->semiAxes[i]));
+    return seed;
+}
+
+bool
+StarDetailsPool::Equal::operator()(const boost::intrusive_ptr<StarDetails>& lhs,
+                                   const boost::intrusive_ptr<StarDetails>& rhs) const noexcept
+{
+    return lhs->radius == rhs->radius &&
+           lhs->temperature == rhs->temperature &&
+           lhs->bolometricCorrection == rhs->bolometricCorrection &&
+           lhs->knowledge == rhs->knowledge &&
+           lhs->visible == rhs->visible &&
+           lhs->spectralType == rhs->spectralType &&
+           lhs->texture.texture(TextureResolution::lores) == rhs->texture.texture(TextureResolution::lores) &&
+           lhs->texture.texture(TextureResolution::medres) == rhs->texture.texture(TextureResolution::medres) &&
+           lhs->texture.texture(TextureResolution::hires) == rhs->texture.texture(TextureResolution::hires) &&
+           lhs->geometry == rhs->geometry &&
+           lhs->rotationModel == rhs->rotationModel &&
+           lhs->semiAxes == rhs->semiAxes &&
+           lhs->infoURL == rhs->infoURL;
+}
+
 Star::Star(AstroCatalog::IndexNumber _indexNumber, const boost::intrusive_ptr<StarDetails>& _details) :
     indexNumber(_indexNumber),
     details(_details)
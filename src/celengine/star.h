@@ -17,6 +17,7 @@
 #include <memory>
 #include <string>
 #include <string_view>
+#include <unordered_set>
 #include <vector>
 
 #include <boost/smart_ptr/intrusive_ptr.hpp>
@@ -67,6 +68,7 @@ public:
     ResourceHandle getGeometry() const;
     MultiResTexture getTexture() const;
     const celestia::ephem::Orbit* getOrbit() const;
+    const std::shared_ptr<const celestia::ephem::Orbit>& getSharedOrbit() const;
     float getOrbitalRadius() const;
     const char* getSpectralType() const;
     float getBolometricCorrection() const;
@@ -153,6 +155,7 @@ private:
     bool isShared{ true };
 
     friend class StarDetailsManager;
+    friend class StarDetailsPool;
 };
 
 ENUM_CLASS_BITWISE_OPS(StarDetails::Knowledge);
@@ -187,6 +190,12 @@ StarDetails::getOrbit() const
     return orbit.get();
 }
 
+inline const std::shared_ptr<const celestia::ephem::Orbit>&
+StarDetails::getSharedOrbit() const
+{
+    return orbit;
+}
+
 inline float
 StarDetails::getOrbitalRadius() const
 {
@@ -243,6 +252,36 @@ StarDetails::isBarycenter() const
     return spectralType.data() == "Bary"sv;
 }
 
+/*! Catalogs which give the physical parameters of every star create custom
+ *  details for each of them, most of which are equal. A pool replaces equal
+ *  custom details with one instance, which is then shared like the standard
+ *  details and copied again if one of the stars using it is modified.
+ */
+class StarDetailsPool
+{
+public:
+    // Details which are shared already, or refer to an orbit or to other
+    // stars, are left unchanged.
+    void intern(boost::intrusive_ptr<StarDetails>&);
+
+    // Number of distinct custom details in the pool
+    std::size_t size() const { return details.size(); }
+
+private:
+    struct Hasher
+    {
+        std::size_t operator()(const boost::intrusive_ptr<StarDetails>&) const noexcept;
+    };
+
+    struct Equal
+    {
+        bool operator()(const boost::intrusive_ptr<StarDetails>&,
+                        const boost::intrusive_ptr<StarDetails>&) const noexcept;
+    };
+
+    std::unordered_set<boost::intrusive_ptr<StarDetails>, Hasher, Equal> details;
+};
+
 class Star
 {
 public:
@@ -292,6 +331,8 @@ public:
     MultiResTexture getTexture() const;
     ResourceHandle getGeometry() const;
     const celestia::ephem::Orbit* getOrbit() const;
+    // The orbit with shared ownership, for users which may outlive the star
+    const std::shared_ptr<const celestia::ephem::Orbit>& getSharedOrbit() const;
     float getOrbitalRadius() const;
     Star* getOrbitBarycenter() const;
     bool getVisibility() const;
@@ -361,6 +402,12 @@ Star::getOrbit() const
     return details->getOrbit();
 }
 
+inline const std::shared_ptr<const celestia::ephem::Orbit>&
+Star::getSharedOrbit() const
+{
+    return details->getSharedOrbit();
+}
+
 inline float
 Star::getOrbitalRadius() const
 {
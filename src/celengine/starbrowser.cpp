@@ -19,6 +19,7 @@
 #include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <functional>
 
 #include "star.h"
 #include "stardb.h"
@@ -31,11 +32,14 @@ namespace celestia::engine
 namespace
 {
 
+using PositionList = std::vector<std::pair<const Star*, UniversalCoord>>;
+
 inline float
 distanceSquared(const Star& star,
                 double jd,
                 const Eigen::Vector3f& pos,
-                const UniversalCoord& ucPos)
+                const UniversalCoord& ucPos,
+                const PositionList* positions)
 {
     // For the purposes of building the list, we can use the squared distance
     // to avoid evaluating unnecessary square roots.
@@ -43,8 +47,16 @@ distanceSquared(const Star& star,
 
     // If the stars are closer than one light year, use
     // a more precise distance estimate.
-    if (distance < 1.0f)
-        distance = static_cast<float>((ucPos - star.getPosition(jd)).toLy().squaredNorm());
+    if (distance >= 1.0f)
+        return distance;
+
+    if (positions == nullptr)
+        return static_cast<float>((ucPos - star.getPosition(jd)).toLy().squaredNorm());
+
+    auto it = std::lower_bound(positions->begin(), positions->end(), &star,
+                               [](const auto& entry, const Star* s) { return std::less<const Star*>()(entry.first, s); });
+    if (it != positions->end() && it->first == &star)
+        distance = static_cast<float>((ucPos - it->second).toLy().squaredNorm());
 
     return distance;
 }
@@ -52,19 +64,19 @@ distanceSquared(const Star& star,
 class StarFilter
 {
 public:
-    StarFilter(StarBrowser::Filter, const SolarSystemCatalog*);
+    StarFilter(StarBrowser::Filter, const Universe*);
     bool operator()(const Star&) const;
 
     void setSpectralTypeFilter(const std::function<bool(const char*)>&);
 
 private:
     StarBrowser::Filter m_filter;
-    const SolarSystemCatalog* m_solarSystems;
+    const Universe* m_universe;
     std::function<bool(const char*)> m_spectralTypeFilter{ nullptr };
 };
 
-StarFilter::StarFilter(StarBrowser::Filter filter, const SolarSystemCatalog* solarSystems) :
-    m_filter(filter), m_solarSystems(solarSystems)
+StarFilter::StarFilter(StarBrowser::Filter filter, const Universe* universe) :
+    m_filter(filter), m_universe(universe)
 {
 }
 
@@ -75,18 +87,17 @@ StarFilter::setSpectralTypeFilter(const std::function<bool(const char*)>& filter
 }
 
 bool
-parentHasPlanets(const SolarSystemCatalog* solarSystems, const Star* star)
+parentHasPlanets(const Universe* universe, const Star* star)
 {
     // When searching for visible stars only, also take planets orbiting the
     // parent barycenters into account
-    const auto end = solarSystems->end();
     for (;;)
     {
         star = star->getOrbitBarycenter();
         if (star == nullptr || star->getVisibility())
             return false;
 
-        if (solarSystems->find(star->getIndex()) != end)
+        if (universe->hasSolarSystem(star))
             return true;
     }
 }
@@ -110,8 +121,8 @@ StarFilter::operator()(const Star& star) const
     }
 
     if (util::is_set(m_filter, StarBrowser::Filter::WithPlanets) &&
-        m_solarSystems->find(star.getIndex()) == m_solarSystems->end() &&
-        !(visibleOnly && parentHasPlanets(m_solarSystems, &star)))
+        !m_universe->hasSolarSystem(&star) &&
+        !(visibleOnly && parentHasPlanets(m_universe, &star)))
     {
         return false;
     }
@@ -128,7 +139,8 @@ public:
                       std::uint32_t,
                       const StarFilter&,
                       const UniversalCoord&,
-                      double);
+                      double,
+                      const PositionList*);
 
     ~DistanceProcessor() = default;
 
@@ -150,6 +162,7 @@ private:
     UniversalCoord m_ucPos;
     Eigen::Vector3f m_pos;
     std::uint32_t m_size;
+    const PositionList* m_positions;
     float m_maxDistance{ std::numeric_limits<float>::max() };
 };
 
@@ -157,13 +170,15 @@ DistanceProcessor::DistanceProcessor(std::vector<StarBrowserRecord>& records,
                                      std::uint32_t size,
                                      const StarFilter& filter,
                                      const UniversalCoord& ucPos,
-                                     double jd) :
+                                     double jd,
+                                     const PositionList* positions) :
     m_filter(&filter),
     m_records(&records),
     m_jd(jd),
     m_ucPos(ucPos),
     m_pos(ucPos.toLy().cast<float>()),
-    m_size(size)
+    m_size(size),
+    m_positions(positions)
 {
     assert(m_size > 0);
 }
@@ -195,7 +210,7 @@ DistanceProcessor::process(const Star& star)
         return;
 
     const Star* oldWorst = m_records->empty() ? nullptr : m_records->front().star;
-    auto distance2 = distanceSquared(star, m_jd, m_pos, m_ucPos);
+    auto distance2 = distanceSquared(star, m_jd, m_pos, m_ucPos, m_positions);
     if (m_records->size() < m_size)
     {
         auto& record = m_records->emplace_back(&star);
@@ -237,7 +252,8 @@ public:
                       std::uint32_t,
                       const StarFilter&,
                       const UniversalCoord&,
-                      double);
+                      double,
+                      const PositionList*);
 
     ~AppMagProcessor() = default;
 
@@ -259,19 +275,22 @@ private:
     UniversalCoord m_ucPos;
     Eigen::Vector3f m_pos;
     std::uint32_t m_size;
+    const PositionList* m_positions;
 };
 
 AppMagProcessor::AppMagProcessor(std::vector<StarBrowserRecord>& records,
                                  std::uint32_t size,
                                  const StarFilter& filter,
                                  const UniversalCoord& ucPos,
-                                 double jd) :
+                                 double jd,
+                                 const PositionList* positions) :
     m_filter(&filter),
     m_records(&records),
     m_jd(jd),
     m_ucPos(ucPos),
     m_pos(ucPos.toLy().cast<float>()),
-    m_size(size)
+    m_size(size),
+    m_positions(positions)
 {
     assert(m_size > 0);
 }
@@ -306,7 +325,7 @@ AppMagProcessor::process(const Star& star)
     if (!(*m_filter)(star))
         return;
 
-    auto distance = std::sqrt(distanceSquared(star, m_jd, m_pos, m_ucPos));
+    auto distance = std::sqrt(distanceSquared(star, m_jd, m_pos, m_ucPos, m_positions));
     auto appMag = star.getApparentMagnitude(distance);
     if (m_records->size() < m_size)
     {
@@ -339,7 +358,8 @@ public:
                     std::uint32_t,
                     const StarFilter&,
                     const UniversalCoord&,
-                    double);
+                    double,
+                    const PositionList*);
 
     ~AbsMagProcessor() = default;
 
@@ -361,19 +381,22 @@ private:
     UniversalCoord m_ucPos;
     Eigen::Vector3f m_pos;
     std::uint32_t m_size;
+    const PositionList* m_positions;
 };
 
 AbsMagProcessor::AbsMagProcessor(std::vector<StarBrowserRecord>& records,
                                  std::uint32_t size,
                                  const StarFilter& filter,
                                  const UniversalCoord& ucPos,
-                                 double jd) :
+                                 double jd,
+                                 const PositionList* positions) :
     m_filter(&filter),
     m_records(&records),
     m_jd(jd),
     m_ucPos(ucPos),
     m_pos(ucPos.toLy().cast<float>()),
-    m_size(size)
+    m_size(size),
+    m_positions(positions)
 {
     assert(m_size > 0);
 }
@@ -420,7 +443,7 @@ AbsMagProcessor::finalize()
     std::sort_heap(m_records->begin(), m_records->end(), &compare);
     for (StarBrowserRecord& record : *m_records)
     {
-        record.distance = std::sqrt(distanceSquared(*record.star, m_jd, m_pos, m_ucPos));
+        record.distance = std::sqrt(distanceSquared(*record.star, m_jd, m_pos, m_ucPos, m_positions));
         record.appMag = record.star->getApparentMagnitude(record.distance);
     }
 }
@@ -431,12 +454,13 @@ void processOctree(const StarOctree& octree,
                    std::uint32_t size,
                    const StarFilter& filter,
                    const UniversalCoord& ucPos,
-                   double jd)
+                   double jd,
+                   const PositionList* positions)
 {
     records.clear();
     records.reserve(size);
 
-    PROCESSOR processor(records, size, filter, ucPos, jd);
+    PROCESSOR processor(records, size, filter, ucPos, jd, positions);
     octree.processBreadthFirst(processor);
     processor.finalize();
 }
@@ -479,12 +503,36 @@ void
 StarBrowser::setPosition(const UniversalCoord& ucPos)
 {
     m_ucPos = ucPos;
+    m_hasPositions = false;
+}
+
+void
+StarBrowser::setTime(double jd)
+{
+    m_jd = jd;
+    m_hasPositions = false;
+}
+
+void
+StarBrowser::snapshotPositions()
+{
+    std::vector<const Star*> nearStars;
+    m_universe->getNearStars(m_ucPos, 1.0f, nearStars);
+
+    m_positions.clear();
+    m_positions.reserve(nearStars.size());
+    for (const Star* star : nearStars)
+        m_positions.emplace_back(star, star->getPosition(m_jd));
+
+    std::sort(m_positions.begin(), m_positions.end(),
+              [](const auto& a, const auto& b) { return std::less<const Star*>()(a.first, b.first); });
+    m_hasPositions = true;
 }
 
 void
 StarBrowser::populate(std::vector<StarBrowserRecord>& records) const
 {
-    StarFilter filter(m_filter, m_universe->getSolarSystemCatalog());
+    StarFilter filter(m_filter, m_universe);
     if (m_spectralTypeFilter)
         filter.setSpectralTypeFilter(m_spectralTypeFilter);
     const StarDatabase* stardb = m_universe->getStarCatalog();
@@ -495,18 +543,20 @@ StarBrowser::populate(std::vector<StarBrowserRecord>& records) const
     if (octree == nullptr)
         return;
 
+    const PositionList* positions = m_hasPositions ? &m_positions : nullptr;
+
     switch (m_comparison)
     {
     case Comparison::Nearest:
-        processOctree<DistanceProcessor>(*octree, records, m_size, filter, m_ucPos, m_jd);
+        processOctree<DistanceProcessor>(*octree, records, m_size, filter, m_ucPos, m_jd, positions);
         return;
 
     case Comparison::ApparentMagnitude:
-        processOctree<AppMagProcessor>(*octree, records, m_size, filter, m_ucPos, m_jd);
+        processOctree<AppMagProcessor>(*octree, records, m_size, filter, m_ucPos, m_jd, positions);
         return;
 
     case Comparison::AbsoluteMagnitude:
-        processOctree<AbsMagProcessor>(*octree, records, m_size, filter, m_ucPos, m_jd);
+        processOctree<AbsMagProcessor>(*octree, records, m_size, filter, m_ucPos, m_jd, positions);
         return;
 
     default:
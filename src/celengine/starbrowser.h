@@ -95,7 +95,13 @@ public:
     const UniversalCoord& position() const { return m_ucPos; }
     void setPosition(const UniversalCoord&);
     double time() const { return m_jd; }
-    inline void setTime(double jd) { m_jd = jd; }
+    void setTime(double jd);
+
+    // Evaluate the positions of the stars within a light year, for which
+    // populate uses the orbit rather than the catalog position. Afterwards
+    // populate reads nothing but the catalogs, so it can run on a worker
+    // thread while the renderer evaluates the orbits.
+    void snapshotPositions();
 
     void populate(std::vector<StarBrowserRecord>&) const;
 
@@ -114,6 +120,10 @@ private:
     Filter m_filter;
 
     std::function<bool(const char*)> m_spectralTypeFilter;
+
+    // Positions from snapshotPositions, sorted by star
+    std::vector<std::pair<const Star*, UniversalCoord>> m_positions;
+    bool m_hasPositions{ false };
 };
 
 ENUM_CLASS_BITWISE_OPS(StarBrowser::Filter);
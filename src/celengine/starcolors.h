@@ -55,6 +55,18 @@ class ColorTemperatureTable
         return tableType;
     }
 
+    // The entries, in steps of 1 / getTemperatureScale() from 0 K, for
+    // lookups on the GPU
+    const std::vector<Color>& getColors() const
+    {
+        return colors;
+    }
+
+    float getTemperatureScale() const
+    {
+        return tempScale;
+    }
+
     bool setType(ColorTableType _type);
 
  private:
@@ -10,22 +10,116 @@
 
 #include "stardb.h"
 
-#include <algorithm>
-#include <cmath>
+#include <atomic>
 #include <set>
+#include <utility>
 
 #include <fmt/format.h>
 
+#include <celastro/astro.h>
+#include <celcompat/numbers.h>
+#include <celengine/pagedstarcatalog.h>
 #include <celutil/gettext.h>
+#include <celutil/threadpool.h>
 
 using namespace std::string_view_literals;
 
 namespace compat = celestia::compat;
 namespace engine = celestia::engine;
+namespace util = celestia::util;
 
 namespace
 {
 
+// Tolerances of the StarVisibilityCache. The observer may move this many
+// light years, rotate about two degrees (as a chord length between plane
+// normals) or raise the limiting magnitude by this much before the cached
+// node selection is rebuilt. Larger values select more nodes, but rebuild
+// less often.
+constexpr float VisibilityCachePositionTolerance = 0.01f;
+constexpr float VisibilityCacheNormalTolerance = 0.035f;
+constexpr float VisibilityCacheMagnitudeTolerance = 0.5f;
+
+// Serial of the last star octree, 0 is left for no octree
+std::atomic<std::uint64_t> lastOctreeSerial{ 0 };
+
+struct VisibleStar
+{
+    const Star* star;
+    float distance;
+    float appMag;
+};
+
+// Records the stars found by a worker, so that they can be passed on to the
+// real handler in traversal order once all of the workers are done.
+class BufferingStarHandler : public engine::StarHandler
+{
+public:
+    explicit BufferingStarHandler(std::vector<VisibleStar>& stars) : m_stars(stars) {}
+
+    void process(const Star& star, float distance, float appMag) override
+    {
+        m_stars.push_back(VisibleStar{ &star, distance, appMag });
+    }
+
+private:
+    std::vector<VisibleStar>& m_stars;
+};
+
+// Passes the nodes which pass the visibility test on to the wrapped
+// processor, except for the distant faint nodes whose objects are collected
+// as ranges.
+class StarRangeProcessor
+{
+public:
+    StarRangeProcessor(engine::StarOctreeVisibleObjectsProcessor& processor,
+                       std::vector<engine::StarOctreeObjectRange>& ranges,
+                       const Eigen::Vector3f& obsPosition,
+                       float minRangeDistance,
+                       float minRangeMag) :
+        m_processor(processor),
+        m_ranges(ranges),
+        m_obsPosition(obsPosition),
+        m_minRangeDistance(minRangeDistance),
+        m_minRangeMag(minRangeMag)
+    {}
+
+    bool checkNode(const Eigen::Vector3f& center, float size, float factor)
+    {
+        if (!m_processor.checkNode(center, size, factor))
+            return false;
+
+        float minDistance = (m_obsPosition - center).norm() - size * celestia::numbers::sqrt3_v<float>;
+        m_isRange = minDistance >= m_minRangeDistance
+                 && factor + celestia::astro::distanceModulus(minDistance) > m_minRangeMag;
+        return true;
+    }
+
+    void process(const Star& star) const { m_processor.process(star); }
+
+    void processObjects(const Eigen::Vector3f& center,
+                        float size,
+                        const Star* objects,
+                        engine::OctreeObjectIndex first,
+                        engine::OctreeObjectIndex last) const
+    {
+        if (!m_isRange)
+            m_processor.processObjects(center, size, objects, first, last);
+        else if (!m_ranges.empty() && m_ranges.back().last == first)
+            m_ranges.back().last = last;
+        else
+            m_ranges.push_back(engine::StarOctreeObjectRange{ first, last });
+    }
+
+private:
+    engine::StarOctreeVisibleObjectsProcessor& m_processor;
+    std::vector<engine::StarOctreeObjectRange>& m_ranges;
+    Eigen::Vector3f m_obsPosition;
+    float m_minRangeDistance;
+    float m_minRangeMag;
+    bool m_isRange{ false };
+};
+
 std::string
 catalogNumberToString(AstroCatalog::IndexNumber catalogNumber)
 {
@@ -46,31 +140,20 @@ catalogNumberToString(AstroCatalog::IndexNumber catalogNumber)
 
 } // end unnamed namespace
 
+StarDatabase::StarDatabase() = default;
 StarDatabase::~StarDatabase() = default;
 
-Star*
-StarDatabase::find(AstroCatalog::IndexNumber catalogNumber) const
+void
+StarDatabase::setOctree(std::unique_ptr<engine::StarOctree>&& octree)
 {
-    auto it = std::lower_bound(catalogNumberIndex.begin(), catalogNumberIndex.end(),
-                               catalogNumber,
-                               [this](std::uint32_t idx, AstroCatalog::IndexNumber catNum)
-                               {
-                                   return (*octreeRoot)[idx].getIndex() < catNum;
-                               });
-
-    if (it == catalogNumberIndex.end())
-        return nullptr;
-
-    Star* star = &(*octreeRoot)[*it];
-    return star->getIndex() == catalogNumber
-        ? star
-        : nullptr;
+    m_octreeRoot = std::move(octree);
+    octreeSerial = lastOctreeSerial.fetch_add(1, std::memory_order_relaxed) + 1;
 }
 
 Star*
 StarDatabase::find(std::string_view name, bool i18n) const
 {
-    AstroCatalog::IndexNumber catalogNumber = namesDB->findCatalogNumberByName(name, i18n);
+    AstroCatalog::IndexNumber catalogNumber = m_namesDB->findCatalogNumberByName(name, i18n);
     if (catalogNumber != AstroCatalog::InvalidIndex)
         return find(catalogNumber);
     else
@@ -80,33 +163,13 @@ StarDatabase::find(std::string_view name, bool i18n) const
 Star*
 StarDatabase::searchCrossIndex(StarCatalog catalog, AstroCatalog::IndexNumber number) const
 {
-    AstroCatalog::IndexNumber celCatalogNumber = namesDB->searchCrossIndexForCatalogNumber(catalog, number);
+    AstroCatalog::IndexNumber celCatalogNumber = m_namesDB->searchCrossIndexForCatalogNumber(catalog, number);
     if (celCatalogNumber != AstroCatalog::InvalidIndex)
         return find(celCatalogNumber);
     else
         return nullptr;
 }
 
-void
-StarDatabase::getCompletion(std::vector<celestia::engine::Completion>& completion, std::string_view name) const
-{
-    // only named stars are supported by completion.
-    if (!name.empty() && namesDB != nullptr)
-    {
-        std::vector<std::pair<std::string, AstroCatalog::IndexNumber>> namesWithIndices;
-        namesDB->getCompletion(namesWithIndices, name);
-
-        for (const auto& [starName, index] : namesWithIndices)
-        {
-            auto capturedIndex = index;
-            completion.emplace_back(starName, [this, capturedIndex]
-            {
-                return Selection(find(capturedIndex));
-            });
-        }
-    }
-}
-
 // Return the name for the star with specified catalog number.  The returned
 // string will be:
 //      the common name if it exists, otherwise
@@ -121,24 +184,11 @@ StarDatabase::getCompletion(std::vector<celestia::engine::Completion>& completio
 // of a memory allocation (though no explcit deallocation is
 // required as it's all wrapped in the string class.)
 std::string
-StarDatabase::getStarName(const Star& star, [[maybe_unused]] bool i18n) const
+StarDatabase::getStarName(const Star& star, bool i18n) const
 {
     AstroCatalog::IndexNumber catalogNumber = star.getIndex();
-    if (namesDB == nullptr)
-        return catalogNumberToString(catalogNumber);
-
-    if (auto iter = namesDB->getFirstNameIter(catalogNumber); iter != namesDB->getFinalNameIter())
-    {
-#ifdef ENABLE_NLS
-        if (i18n)
-        {
-            const char * local = D_(iter->second.c_str());
-            if (iter->second != local)
-                return local;
-        }
-#endif
-        return iter->second;
-    }
+    if (std::string name = getFirstName(catalogNumber, i18n); !name.empty())
+        return name;
 
     /*
       // Get the HD catalog name
@@ -171,9 +221,9 @@ StarDatabase::getStarNameList(const Star& star, unsigned int maxNames) const
 
     unsigned int catalogNumber = star.getIndex();
 
-    if (namesDB != nullptr)
+    if (m_namesDB != nullptr)
     {
-        for (auto iter = namesDB->getFirstNameIter(catalogNumber), end = namesDB->getFinalNameIter();
+        for (auto iter = m_namesDB->getFirstNameIter(catalogNumber), end = m_namesDB->getFinalNameIter();
              iter != end && iter->first == catalogNumber;
              ++iter)
         {
@@ -191,7 +241,7 @@ StarDatabase::getStarNameList(const Star& star, unsigned int maxNames) const
             return starNames;
     }
 
-    if (AstroCatalog::IndexNumber hd = namesDB->crossIndex(StarCatalog::HenryDraper, hip);
+    if (AstroCatalog::IndexNumber hd = m_namesDB->crossIndex(StarCatalog::HenryDraper, hip);
         hd != AstroCatalog::InvalidIndex)
     {
         append(fmt::format("HD {}", hd));
@@ -199,7 +249,7 @@ StarDatabase::getStarNameList(const Star& star, unsigned int maxNames) const
             return starNames;
     }
 
-    if (AstroCatalog::IndexNumber sao = namesDB->crossIndex(StarCatalog::SAO, hip);
+    if (AstroCatalog::IndexNumber sao = m_namesDB->crossIndex(StarCatalog::SAO, hip);
         sao != AstroCatalog::InvalidIndex)
     {
         append(fmt::format("SAO {}", sao));
@@ -214,34 +264,96 @@ StarDatabase::findVisibleStars(engine::StarHandler& starHandler,
                                const Eigen::Quaternionf& orientation,
                                float fovY,
                                float aspectRatio,
-                               float limitingMag) const
+                               float limitingMag,
+                               util::ThreadPool* threadPool,
+                               StarVisibilityCache* cache) const
 {
-    // Compute the bounding planes of an infinite view frustum
-    Eigen::Matrix3f rot = orientation.toRotationMatrix();
-    float h = std::tan(fovY * 0.5f);
-    float w = h * aspectRatio;
-    std::array<Eigen::Vector3f, 5> planeNormals
+    auto frustumPlanes = computeFrustumPlanes(position, orientation, fovY, aspectRatio);
+
+    engine::StarOctreeVisibleObjectsProcessor processor(&starHandler,
+                                                        position,
+                                                        frustumPlanes,
+                                                        limitingMag,
+                                                        octreeRecords.get());
+
+    if (cache != nullptr && updateVisibilityCache(*cache, position, frustumPlanes, limitingMag))
     {
-        Eigen::Vector3f(0.0f, 1.0f, -h),
-        Eigen::Vector3f(0.0f, -1.0f, -h),
-        Eigen::Vector3f(1.0f, 0.0f, -w),
-        Eigen::Vector3f(-1.0f, 0.0f, -w),
-        Eigen::Vector3f(0.0f, 0.0f, -1.0f),
-    };
+        m_octreeRoot->processDepthFirst(processor, cache->m_nodes);
+        return;
+    }
 
-    std::array<Eigen::Hyperplane<float, 3>, 5> frustumPlanes;
-    for (unsigned int i = 0U; i < 5U; ++i)
+    std::vector<engine::OctreeNodeRange> ranges;
+    if (!splitTraversal(processor, threadPool, ranges))
     {
-        planeNormals[i] = rot.transpose() * planeNormals[i].normalized();
-        frustumPlanes[i] = Eigen::Hyperplane<float, 3>(planeNormals[i], position);
+        m_octreeRoot->processDepthFirst(processor);
+        return;
     }
 
-    engine::StarOctreeVisibleObjectsProcessor processor(&starHandler,
-                                                        position,
-                                                        frustumPlanes,
-                                                        limitingMag);
+    std::vector<std::vector<VisibleStar>> results(ranges.size());
+    threadPool->parallelFor(ranges.size(), [&](std::size_t i)
+    {
+        BufferingStarHandler bufferingHandler(results[i]);
+        engine::StarOctreeVisibleObjectsProcessor rangeProcessor(&bufferingHandler,
+                                                                 position,
+                                                                 frustumPlanes,
+                                                                 limitingMag,
+                                                                 octreeRecords.get());
+        m_octreeRoot->processDepthFirst(rangeProcessor, ranges[i]);
+    });
+
+    for (const auto& result : results)
+    {
+        for (const VisibleStar& visibleStar : result)
+            starHandler.process(*visibleStar.star, visibleStar.distance, visibleStar.appMag);
+    }
+}
 
-    octreeRoot->processDepthFirst(processor);
+// Returns true if the cached node selection can be used for this viewpoint.
+bool
+StarDatabase::updateVisibilityCache(StarVisibilityCache& cache,
+                                    const Eigen::Vector3f& position,
+                                    util::array_view<Eigen::Hyperplane<float, 3>> frustumPlanes,
+                                    float limitingMag) const
+{
+    bool valid = cache.m_octreeSerial == octreeSerial
+              && (position - cache.m_obsPosition).norm() <= VisibilityCachePositionTolerance
+              && limitingMag <= cache.m_limitingMag + VisibilityCacheMagnitudeTolerance
+              // Also rebuild when the magnitude drops, the selection would
+              // hold many more nodes than needed.
+              && limitingMag >= cache.m_limitingMag - VisibilityCacheMagnitudeTolerance;
+
+    for (std::size_t i = 0; valid && i < cache.m_planeNormals.size(); ++i)
+        valid = (frustumPlanes[i].normal() - cache.m_planeNormals[i]).norm() <= VisibilityCacheNormalTolerance;
+
+    if (!valid)
+    {
+        cache.m_octreeSerial = octreeSerial;
+        cache.m_obsPosition = position;
+        cache.m_limitingMag = limitingMag;
+        for (std::size_t i = 0; i < cache.m_planeNormals.size(); ++i)
+            cache.m_planeNormals[i] = frustumPlanes[i].normal();
+        cache.m_selected = false;
+        return false;
+    }
+
+    if (!cache.m_selected)
+    {
+        // The selection is relative to the reference viewpoint
+        std::array<Eigen::Hyperplane<float, 3>, 5> referencePlanes;
+        for (std::size_t i = 0; i < referencePlanes.size(); ++i)
+            referencePlanes[i] = Eigen::Hyperplane<float, 3>(cache.m_planeNormals[i], cache.m_obsPosition);
+
+        engine::StarOctreeVisibleNodesProcessor nodesProcessor(cache.m_obsPosition,
+                                                               referencePlanes,
+                                                               cache.m_limitingMag,
+                                                               VisibilityCachePositionTolerance,
+                                                               VisibilityCacheNormalTolerance,
+                                                               VisibilityCacheMagnitudeTolerance);
+        m_octreeRoot->selectDepthFirst(nodesProcessor, cache.m_nodes);
+        cache.m_selected = true;
+    }
+
+    return true;
 }
 
 void
@@ -253,11 +365,70 @@ StarDatabase::findCloseStars(engine::StarHandler& starHandler,
                                                       position,
                                                       radius);
 
-    octreeRoot->processDepthFirst(processor);
+    m_octreeRoot->processDepthFirst(processor);
+}
+
+void
+StarDatabase::findStarsInCone(engine::StarHandler& starHandler,
+                              const Eigen::Vector3f& position,
+                              const Eigen::Vector3f& direction,
+                              float angle,
+                              float limitingMag) const
+{
+    engine::StarOctreeConeObjectsProcessor processor(&starHandler,
+                                                     position,
+                                                     direction,
+                                                     angle,
+                                                     limitingMag);
+
+    m_octreeRoot->processDepthFirst(processor);
+}
+
+void
+StarDatabase::findVisibleStarRanges(engine::StarHandler& starHandler,
+                                    std::vector<engine::StarOctreeObjectRange>& ranges,
+                                    const Eigen::Vector3f& position,
+                                    const Eigen::Quaternionf& orientation,
+                                    float fovY,
+                                    float aspectRatio,
+                                    float limitingMag,
+                                    float minRangeDistance,
+                                    float minRangeMag) const
+{
+    auto frustumPlanes = computeFrustumPlanes(position, orientation, fovY, aspectRatio);
+
+    engine::StarOctreeVisibleObjectsProcessor processor(&starHandler,
+                                                        position,
+                                                        frustumPlanes,
+                                                        limitingMag,
+                                                        octreeRecords.get());
+    StarRangeProcessor rangeProcessor(processor, ranges, position, minRangeDistance, minRangeMag);
+    m_octreeRoot->processDepthFirst(rangeProcessor);
+}
+
+void
+StarDatabase::findVisiblePagedStars(engine::StarHandler& starHandler,
+                                    const Eigen::Vector3f& position,
+                                    const Eigen::Quaternionf& orientation,
+                                    float fovY,
+                                    float aspectRatio,
+                                    float limitingMag) const
+{
+    if (pagedCatalog == nullptr)
+        return;
+
+    auto frustumPlanes = computeFrustumPlanes(position, orientation, fovY, aspectRatio);
+    pagedCatalog->findVisibleStars(starHandler, position, frustumPlanes, limitingMag);
+}
+
+const engine::PagedStarCatalog*
+StarDatabase::getPagedCatalog() const
+{
+    return pagedCatalog.get();
 }
 
 const StarNameDatabase*
 StarDatabase::getNameDatabase() const
 {
-    return namesDB.get();
+    return m_namesDB.get();
 }
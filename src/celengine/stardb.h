@@ -10,6 +10,7 @@
 
 #pragma once
 
+#include <array>
 #include <cstdint>
 #include <memory>
 #include <string>
@@ -20,14 +21,44 @@
 #include <Eigen/Geometry>
 
 #include <celengine/astroobj.h>
-#include <celengine/completion.h>
+#include <celengine/spatialcatalog.h>
 #include <celengine/starname.h>
 #include <celengine/staroctree.h>
 
 class Star;
 class StarDatabaseBuilder;
 
-class StarDatabase
+namespace celestia::engine
+{
+class PagedStarCatalog;
+}
+
+// State kept between calls to StarDatabase::findVisibleStars for an
+// observer which moves slowly: the octree nodes which could be visible from
+// any viewpoint near a reference one are selected once, and subsequent calls
+// only test these nodes. The results are identical to a full traversal.
+// When the observer leaves the neighbourhood of the reference viewpoint, a
+// full traversal is done and the selection is only rebuilt if the next call
+// is close to the new viewpoint, so a fast moving observer does not pay for
+// the selection every frame.
+class StarVisibilityCache
+{
+public:
+    void invalidate() { m_octreeSerial = 0; }
+
+private:
+    // Serial of the octree the selection was made in, 0 when there is none
+    std::uint64_t m_octreeSerial{ 0 };
+    Eigen::Vector3f m_obsPosition{ Eigen::Vector3f::Zero() };
+    std::array<Eigen::Vector3f, 5> m_planeNormals;
+    float m_limitingMag{ 0.0f };
+    bool m_selected{ false };
+    celestia::engine::OctreeNodeSubset m_nodes;
+
+    friend class StarDatabase;
+};
+
+class StarDatabase : public celestia::engine::SpatialCatalog<Star, float, StarNameDatabase>
 {
 public:
     // The size of the root star octree node is also the maximum distance
@@ -44,59 +75,98 @@ public:
 
     static constexpr unsigned int MAX_STAR_NAMES = 10;
 
-    StarDatabase() = default;
+    StarDatabase();
     ~StarDatabase();
 
-    const celestia::engine::StarOctree* getOctree() const;
-
     inline Star* getStar(const std::uint32_t) const;
-    inline std::uint32_t size() const;
 
     Star* find(AstroCatalog::IndexNumber catalogNumber) const;
     Star* find(std::string_view, bool i18n) const;
 
-    void getCompletion(std::vector<celestia::engine::Completion>&, std::string_view) const;
-
     void findVisibleStars(celestia::engine::StarHandler& starHandler,
                           const Eigen::Vector3f& obsPosition,
                           const Eigen::Quaternionf& obsOrientation,
                           float fovY,
                           float aspectRatio,
-                          float limitingMag) const;
+                          float limitingMag,
+                          celestia::util::ThreadPool* threadPool = nullptr,
+                          StarVisibilityCache* cache = nullptr) const;
 
     void findCloseStars(celestia::engine::StarHandler& starHandler,
                         const Eigen::Vector3f& obsPosition,
                         float radius) const;
 
+    // Find the stars within angle of a ray from obsPosition along direction
+    // and no fainter than limitingMag, plus any star with an orbit in the
+    // nodes crossed by the cone.
+    void findStarsInCone(celestia::engine::StarHandler& starHandler,
+                         const Eigen::Vector3f& obsPosition,
+                         const Eigen::Vector3f& direction,
+                         float angle,
+                         float limitingMag) const;
+
+    // Find the visible stars like findVisibleStars, except that the stars of
+    // visible nodes at least minRangeDistance away, and which can't contain
+    // a star brighter than minRangeMag, are not passed to the handler: the
+    // ranges of these nodes, which index getStar, are appended to ranges
+    // instead. Adjacent ranges are merged. The stars in the ranges have not
+    // been tested against the limiting magnitude.
+    void findVisibleStarRanges(celestia::engine::StarHandler& starHandler,
+                               std::vector<celestia::engine::StarOctreeObjectRange>& ranges,
+                               const Eigen::Vector3f& obsPosition,
+                               const Eigen::Quaternionf& obsOrientation,
+                               float fovY,
+                               float aspectRatio,
+                               float limitingMag,
+                               float minRangeDistance,
+                               float minRangeMag) const;
+
+    // Find the visible stars of the paged catalog, if there is one. Only the
+    // stars which are in memory are found, the others are queued for
+    // loading. The stars are only valid until the next call, so they must
+    // not be selected or otherwise retained.
+    void findVisiblePagedStars(celestia::engine::StarHandler& starHandler,
+                               const Eigen::Vector3f& obsPosition,
+                               const Eigen::Quaternionf& obsOrientation,
+                               float fovY,
+                               float aspectRatio,
+                               float limitingMag) const;
+
+    const celestia::engine::PagedStarCatalog* getPagedCatalog() const;
+
     std::string getStarName(const Star&, bool i18n = false) const;
     std::string getStarNameList(const Star&, unsigned int maxNames = MAX_STAR_NAMES) const;
 
     const StarNameDatabase* getNameDatabase() const;
 
 private:
-    Star* searchCrossIndex(StarCatalog, AstroCatalog::IndexNumber number) const;
+    // Replace the octree, giving it a new serial
+    void setOctree(std::unique_ptr<celestia::engine::StarOctree>&&);
 
-    std::unique_ptr<StarNameDatabase>             namesDB;
-    std::vector<std::uint32_t>                    catalogNumberIndex;
-    std::unique_ptr<celestia::engine::StarOctree> octreeRoot;
+    Star* searchCrossIndex(StarCatalog, AstroCatalog::IndexNumber number) const;
+    bool updateVisibilityCache(StarVisibilityCache&,
+                               const Eigen::Vector3f&,
+                               celestia::util::array_view<Eigen::Hyperplane<float, 3>>,
+                               float) const;
+
+    std::unique_ptr<celestia::engine::StarOctreeRecords> octreeRecords;
+    std::unique_ptr<celestia::engine::PagedStarCatalog> pagedCatalog;
+    // Unique across the octrees of all the databases, so that visibility
+    // caches don't reuse a selection from an octree rebuilt at the same
+    // address
+    std::uint64_t octreeSerial{ 0 };
 
     friend class StarDatabaseBuilder;
 };
 
-inline const celestia::engine::StarOctree*
-StarDatabase::getOctree() const
-{
-    return octreeRoot.get();
-}
-
 inline Star*
 StarDatabase::getStar(const std::uint32_t n) const
 {
-    return &(*octreeRoot)[n];
+    return getObject(n);
 }
 
-inline std::uint32_t
-StarDatabase::size() const
+inline Star*
+StarDatabase::find(AstroCatalog::IndexNumber catalogNumber) const
 {
-    return octreeRoot->size();
+    return findByCatalogNumber(catalogNumber);
 }
@@ -14,12 +14,18 @@
 #include <array>
 #include <cassert>
 #include <cmath>
+#include <cstddef>
 #include <cstdint>
+#include <fstream>
 #include <istream>
 #include <iterator>
+#include <memory>
+#include <optional>
+#include <string>
 #include <string_view>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 #include <boost/smart_ptr/intrusive_ptr.hpp>
 
@@ -36,11 +42,15 @@
 #include <celutil/gettext.h>
 #include <celutil/infourl.h>
 #include <celutil/logger.h>
+#include <celutil/mappedfile.h>
 #include <celutil/parser.h>
+#include <celutil/threadpool.h>
 #include <celutil/timer.h>
 #include <celutil/tokenizer.h>
 #include "meshmanager.h"
 #include "octreebuilder.h"
+#include "octreecache.h"
+#include "pagedstarcatalog.h"
 #include "stardb.h"
 #include "stellarclass.h"
 
@@ -75,6 +85,26 @@ StarDatabaseBuilder::StcHeader::StcHeader(const fs::path& _path) :
 {
 }
 
+// A star definition read from an .stc file, along with the values which
+// only depend on its own properties. These are computed for a whole batch
+// of records in parallel before the records are added in file order.
+struct StarDatabaseBuilder::StcRecord
+{
+    StcRecord(const StcHeader&, Value&&);
+
+    StcHeader header;
+    Value data;
+    std::optional<StellarClass> stellarClass;
+    // Set if the record has a complete set of RA/Dec/Distance
+    std::optional<Eigen::Vector3f> polarPosition;
+};
+
+StarDatabaseBuilder::StcRecord::StcRecord(const StcHeader& _header, Value&& _data) :
+    header(_header),
+    data(std::move(_data))
+{
+}
+
 template<>
 struct fmt::formatter<StarDatabaseBuilder::StcHeader> : formatter<std::string_view>
 {
@@ -98,6 +128,13 @@ namespace
 // 0 to 5 percent frame rate improvement.
 constexpr engine::OctreeObjectIndex StarOctreeSplitThreshold = 75;
 
+// Number of .stc records which are read before they are added to the
+// database. Batches of at least StcParallelThreshold records are prepared
+// in parallel, in chunks of StcChunkSize records.
+constexpr std::size_t StcBatchSize = 8192;
+constexpr std::size_t StcParallelThreshold = 1024;
+constexpr std::size_t StcChunkSize = 256;
+
 // The octree node into which a star is placed is dependent on two properties:
 // its obsPosition and its luminosity--the fainter the star, the deeper the node
 // in which it will reside.  Each node stores an absolute magnitude; no child
@@ -179,32 +216,66 @@ struct StarsDatRecord
 static_assert(std::is_standard_layout_v<StarsDatHeader>);
 static_assert(std::is_standard_layout_v<StarsDatRecord>);
 
+// Number of records decoded per batch when loading a memory-mapped stars.dat
+constexpr std::uint32_t MappedDecodeRecords = 65536;
+
+// Number of distinct values of the packed spectral type
+constexpr std::size_t PackedSpectralTypes = 65536;
+
 bool
-parseStarsDatHeader(std::istream& in, std::uint32_t& nStarsInFile)
+parseStarsDatHeader(const char* header, std::uint32_t& nStarsInFile)
 {
-    std::array<char, sizeof(StarsDatHeader)> header;
-    if (!in.read(header.data(), header.size()).good()) /* Flawfinder: ignore */
-        return false;
-
     // Verify the magic string
-    if (auto magic = std::string_view(header.data() + offsetof(StarsDatHeader, magic), STARSDAT_MAGIC.size());
+    if (auto magic = std::string_view(header + offsetof(StarsDatHeader, magic), STARSDAT_MAGIC.size());
         magic != STARSDAT_MAGIC)
     {
         return false;
     }
 
     // Verify the version
-    if (auto version = util::fromMemoryLE<std::uint16_t>(header.data() + offsetof(StarsDatHeader, version));
+    if (auto version = util::fromMemoryLE<std::uint16_t>(header + offsetof(StarsDatHeader, version));
         version != StarDBVersion)
     {
         return false;
     }
 
     // Read the star count
-    nStarsInFile = util::fromMemoryLE<std::uint32_t>(header.data() + offsetof(StarsDatHeader, counter));
+    nStarsInFile = util::fromMemoryLE<std::uint32_t>(header + offsetof(StarsDatHeader, counter));
     return true;
 }
 
+bool
+parseStarsDatHeader(std::istream& in, std::uint32_t& nStarsInFile)
+{
+    std::array<char, sizeof(StarsDatHeader)> header;
+    if (!in.read(header.data(), header.size()).good()) /* Flawfinder: ignore */
+        return false;
+
+    return parseStarsDatHeader(header.data(), nStarsInFile);
+}
+
+inline std::uint16_t
+getRecordSpectralType(const char* ptr)
+{
+    return util::fromMemoryLE<std::uint16_t>(ptr + offsetof(StarsDatRecord, spectralType));
+}
+
+// Decode a stars.dat record, the details are looked up by the caller
+Star
+decodeStarsDatRecord(const char* ptr, const boost::intrusive_ptr<StarDetails>& details)
+{
+    auto catNo = util::fromMemoryLE<AstroCatalog::IndexNumber>(ptr + offsetof(StarsDatRecord, catNo));
+    Eigen::Vector3f position(util::fromMemoryLE<float>(ptr + offsetof(StarsDatRecord, x)),
+                             util::fromMemoryLE<float>(ptr + offsetof(StarsDatRecord, y)),
+                             util::fromMemoryLE<float>(ptr + offsetof(StarsDatRecord, z)));
+    auto absMag = util::fromMemoryLE<std::int16_t>(ptr + offsetof(StarsDatRecord, absMag));
+
+    Star star(catNo, details);
+    star.setPosition(position);
+    star.setAbsoluteMagnitude(static_cast<float>(absMag) / 256.0f);
+    return star;
+}
+
 inline void
 stcError(const StarDatabaseBuilder::StcHeader& header, std::string_view msg)
 {
@@ -304,21 +375,22 @@ parseStcHeader(util::Tokenizer& tokenizer, StarDatabaseBuilder::StcHeader& heade
 }
 
 bool
-checkSpectralType(const StarDatabaseBuilder::StcHeader& header,
-                  const AssociativeArray* starData,
+checkSpectralType(const StarDatabaseBuilder::StcRecord& record,
                   const Star* star,
                   boost::intrusive_ptr<StarDetails>& newDetails)
 {
-    const std::string* spectralType = starData->getString("SpectralType");
+    const StarDatabaseBuilder::StcHeader& header = record.header;
     if (!header.isStar)
     {
-        if (spectralType != nullptr)
+        if (record.data.getHash()->getString("SpectralType") != nullptr)
             stcWarn(header, _("ignoring SpectralType on Barycenter"));
         newDetails = StarDetails::GetBarycenterDetails();
     }
-    else if (spectralType != nullptr)
+    else if (record.stellarClass.has_value())
     {
-        newDetails = StarDetails::GetStarDetails(StellarClass::parse(*spectralType));
+        // The details are shared between stars, so they are looked up here
+        // rather than in the parallel stage
+        newDetails = StarDetails::GetStarDetails(*record.stellarClass);
         if (newDetails == nullptr)
         {
             stcError(header, _("invalid SpectralType"));
@@ -335,11 +407,19 @@ checkSpectralType(const StarDatabaseBuilder::StcHeader& header,
 }
 
 bool
-checkPolarCoordinates(const StarDatabaseBuilder::StcHeader& header,
-                      const AssociativeArray* starData,
+checkPolarCoordinates(const StarDatabaseBuilder::StcRecord& record,
                       const Star* star,
                       std::optional<Eigen::Vector3f>& position)
 {
+    if (record.polarPosition.has_value())
+    {
+        position = record.polarPosition;
+        return true;
+    }
+
+    const StarDatabaseBuilder::StcHeader& header = record.header;
+    const AssociativeArray* starData = record.data.getHash();
+
     constexpr unsigned int has_ra = 1;
     constexpr unsigned int has_dec = 2;
     constexpr unsigned int has_distance = 4;
@@ -357,12 +437,8 @@ checkPolarCoordinates(const StarDatabaseBuilder::StcHeader& header,
     if (status == 0)
         return true;
 
-    if (status == has_all)
-    {
-        position = astro::equatorialToCelestialCart(*raValue, *decValue, *distanceValue).cast<float>();
-        return true;
-    }
-
+    // A complete set of coordinates is converted by prepareStcRecord
+    assert(status != has_all);
     if (header.disposition != DataDisposition::Modify)
     {
         stcError(header, _("incomplete set of coordinates RA/Dec/Distance specified"));
@@ -443,6 +519,47 @@ checkMagnitudes(const StarDatabaseBuilder::StcHeader& header,
     return true;
 }
 
+// Compute the values of a record which don't depend on other stars. This
+// runs on the workers of the thread pool, so it must not touch any shared
+// state or log messages; errors are reported when the record is added.
+void
+prepareStcRecord(StarDatabaseBuilder::StcRecord& record)
+{
+    const AssociativeArray* starData = record.data.getHash();
+    if (record.header.isStar)
+    {
+        if (const std::string* spectralType = starData->getString("SpectralType"); spectralType != nullptr)
+            record.stellarClass = StellarClass::parse(*spectralType);
+    }
+
+    auto raValue = starData->getAngle<double>("RA", astro::DEG_PER_HRA, 1.0);
+    auto decValue = starData->getAngle<double>("Dec");
+    auto distanceValue = starData->getLength<double>("Distance", astro::KM_PER_LY<double>);
+    if (raValue.has_value() && decValue.has_value() && distanceValue.has_value())
+        record.polarPosition = astro::equatorialToCelestialCart(*raValue, *decValue, *distanceValue).cast<float>();
+}
+
+void
+prepareStcRecords(std::vector<StarDatabaseBuilder::StcRecord>& records)
+{
+    std::size_t nRecords = records.size();
+    if (nRecords < StcParallelThreshold)
+    {
+        for (auto& record : records)
+            prepareStcRecord(record);
+        return;
+    }
+
+    std::size_t nChunks = (nRecords + StcChunkSize - 1) / StcChunkSize;
+    util::GetThreadPool()->parallelFor(nChunks, [&](std::size_t chunkIdx)
+    {
+        std::size_t first = chunkIdx * StcChunkSize;
+        std::size_t last = std::min(first + StcChunkSize, nRecords);
+        for (std::size_t i = first; i < last; ++i)
+            prepareStcRecord(records[i]);
+    });
+}
+
 void
 mergeStarDetails(boost::intrusive_ptr<StarDetails>& existingDetails,
                  const boost::intrusive_ptr<StarDetails>& referenceDetails)
@@ -617,30 +734,20 @@ StarDatabaseBuilder::loadBinary(std::istream& in)
             return false;
 
         const char* ptr = buffer.data();
-        for (std::uint32_t i = 0; i < recordsToRead; ++i)
+        for (std::uint32_t i = 0; i < recordsToRead; ++i, ptr += sizeof(StarsDatRecord))
         {
-            auto catNo = util::fromMemoryLE<AstroCatalog::IndexNumber>(ptr + offsetof(StarsDatRecord, catNo));
-            Eigen::Vector3f position(util::fromMemoryLE<float>(ptr + offsetof(StarsDatRecord, x)),
-                                     util::fromMemoryLE<float>(ptr + offsetof(StarsDatRecord, y)),
-                                     util::fromMemoryLE<float>(ptr + offsetof(StarsDatRecord, z)));
-            auto absMag = util::fromMemoryLE<std::int16_t>(ptr + offsetof(StarsDatRecord, absMag));
-            auto spectralType = util::fromMemoryLE<std::uint16_t>(ptr + offsetof(StarsDatRecord, spectralType));
-
             boost::intrusive_ptr<StarDetails> details = nullptr;
-            if (StellarClass sc; sc.unpackV1(spectralType))
+            if (StellarClass sc; sc.unpackV1(getRecordSpectralType(ptr)))
                 details = StarDetails::GetStarDetails(sc);
 
             if (details == nullptr)
             {
-                GetLogger()->error(_("Bad spectral type in star database, star #{}\n"), catNo);
+                GetLogger()->error(_("Bad spectral type in star database, star #{}\n"),
+                                   util::fromMemoryLE<AstroCatalog::IndexNumber>(ptr + offsetof(StarsDatRecord, catNo)));
                 continue;
             }
 
-            Star& star = unsortedStars.emplace_back(catNo, details);
-            star.setPosition(position);
-            star.setAbsoluteMagnitude(static_cast<float>(absMag) / 256.0f);
-
-            ptr += sizeof(StarsDatRecord);
+            unsortedStars.push_back(decodeStarsDatRecord(ptr, details));
         }
 
         nStarsRemaining -= recordsToRead;
@@ -649,8 +756,110 @@ StarDatabaseBuilder::loadBinary(std::istream& in)
     if (in.bad())
         return false;
 
-    auto loadTime = timer.getTime();
+    indexBinaryStars(nStarsInFile, timer.getTime());
+    return true;
+}
+
+/*! Load stars.dat by mapping it into memory. The records are decoded in
+ *  place, in batches which are split across the worker threads. Falls back
+ *  to reading the file as a stream if it can't be mapped.
+ */
+bool
+StarDatabaseBuilder::loadBinary(const fs::path& path)
+{
+    Timer timer;
+    auto file = util::MappedFile::open(path);
+    if (file == nullptr)
+    {
+        std::ifstream in(path, std::ios::binary);
+        return in.good() && loadBinary(in);
+    }
+
+    std::uint32_t nStarsInFile;
+    if (file->size() < sizeof(StarsDatHeader) || !parseStarsDatHeader(file->data(), nStarsInFile))
+        return false;
+
+    if ((file->size() - sizeof(StarsDatHeader)) / sizeof(StarsDatRecord) < nStarsInFile)
+        return false;
+
+    const char* records = file->data() + sizeof(StarsDatHeader);
+
+    // StarDetailsManager is not thread-safe, so the shared details for each
+    // spectral type are looked up on this thread before the batch is decoded.
+    std::vector<boost::intrusive_ptr<StarDetails>> detailsByType(PackedSpectralTypes);
+    std::vector<bool> typeResolved(PackedSpectralTypes, false);
 
+    util::ThreadPool* threadPool = util::GetThreadPool();
+    const std::size_t taskCount = static_cast<std::size_t>(threadPool->threadCount()) + 1;
+
+    std::vector<Star> decoded;
+    for (std::uint32_t batchStart = 0; batchStart < nStarsInFile; batchStart += MappedDecodeRecords)
+    {
+        const std::uint32_t batchSize = std::min(MappedDecodeRecords, nStarsInFile - batchStart);
+        const char* batchRecords = records + static_cast<std::size_t>(batchStart) * sizeof(StarsDatRecord);
+
+        for (std::uint32_t i = 0; i < batchSize; ++i)
+        {
+            std::uint16_t spectralType = getRecordSpectralType(batchRecords + i * sizeof(StarsDatRecord));
+            if (typeResolved[spectralType])
+                continue;
+
+            typeResolved[spectralType] = true;
+            if (StellarClass sc; sc.unpackV1(spectralType))
+                detailsByType[spectralType] = StarDetails::GetStarDetails(sc);
+        }
+
+        decoded.resize(batchSize);
+        threadPool->parallelFor(taskCount, [&](std::size_t task)
+        {
+            const std::uint32_t begin = static_cast<std::uint32_t>(batchSize * task / taskCount);
+            const std::uint32_t end = static_cast<std::uint32_t>(batchSize * (task + 1) / taskCount);
+            for (std::uint32_t i = begin; i < end; ++i)
+            {
+                const char* ptr = batchRecords + i * sizeof(StarsDatRecord);
+                if (const auto& details = detailsByType[getRecordSpectralType(ptr)]; details != nullptr)
+                    decoded[i] = decodeStarsDatRecord(ptr, details);
+            }
+        });
+
+        // Append in file order, so the result is the same as the stream loader,
+        // with the runs of valid records appended at once
+        std::uint32_t runStart = 0;
+        for (std::uint32_t i = 0; i < batchSize; ++i)
+        {
+            const char* ptr = batchRecords + i * sizeof(StarsDatRecord);
+            if (detailsByType[getRecordSpectralType(ptr)] != nullptr)
+                continue;
+
+            GetLogger()->error(_("Bad spectral type in star database, star #{}\n"),
+                               util::fromMemoryLE<AstroCatalog::IndexNumber>(ptr + offsetof(StarsDatRecord, catNo)));
+            unsortedStars.append(std::make_move_iterator(decoded.begin() + runStart),
+                                 std::make_move_iterator(decoded.begin() + i));
+            runStart = i + 1;
+        }
+        unsortedStars.append(std::make_move_iterator(decoded.begin() + runStart),
+                             std::make_move_iterator(decoded.begin() + batchSize));
+    }
+
+    indexBinaryStars(nStarsInFile, timer.getTime());
+    return true;
+}
+
+void
+StarDatabaseBuilder::setOctreeCachePath(const fs::path& path)
+{
+    octreeCachePath = path;
+}
+
+void
+StarDatabaseBuilder::setPagedCatalog(std::unique_ptr<engine::PagedStarCatalog>&& pagedCatalog)
+{
+    starDB->pagedCatalog = std::move(pagedCatalog);
+}
+
+void
+StarDatabaseBuilder::indexBinaryStars(std::uint32_t nStarsInFile, double loadTime)
+{
     GetLogger()->debug("StarDatabase::read: nStars = {}, time = {} ms\n", nStarsInFile, loadTime);
     GetLogger()->info(_("{} stars in binary database\n"), unsortedStars.size());
 
@@ -658,14 +867,16 @@ StarDatabaseBuilder::loadBinary(std::istream& in)
     // will be used to lookup stars during file loading. After loading is
     // complete, the stars are sorted into an octree and this list gets
     // replaced.
-    binFileCatalogNumberIndex.reserve(unsortedStars.size());
-    for (Star& star : unsortedStars)
-        binFileCatalogNumberIndex.push_back(&star);
+    binFileCatalogNumberIndex.resize(unsortedStars.size());
+    unsortedStars.for_each_block(*util::GetThreadPool(), [this](Star* stars, std::size_t count, std::size_t offset)
+    {
+        Star** index = binFileCatalogNumberIndex.data() + offset;
+        for (std::size_t i = 0; i < count; ++i)
+            index[i] = stars + i;
+    });
 
     std::sort(binFileCatalogNumberIndex.begin(), binFileCatalogNumberIndex.end(),
                 [](const Star* star0, const Star* star1) { return star0->getIndex() < star1->getIndex(); });
-
-    return true;
 }
 
 /*! Load an STC file with star definitions. Each definition has the form:
@@ -705,6 +916,19 @@ bool
 StarDatabaseBuilder::load(std::istream& in, const fs::path& resourcePath)
 {
     util::Tokenizer tokenizer(&in);
+    return parseCatalog(tokenizer, resourcePath);
+}
+
+bool
+StarDatabaseBuilder::load(std::string_view contents, const fs::path& resourcePath)
+{
+    util::Tokenizer tokenizer(contents);
+    return parseCatalog(tokenizer, resourcePath);
+}
+
+bool
+StarDatabaseBuilder::parseCatalog(util::Tokenizer& tokenizer, const fs::path& resourcePath)
+{
     util::Parser parser(&tokenizer);
 
 #ifdef ENABLE_NLS
@@ -715,24 +939,59 @@ StarDatabaseBuilder::load(std::istream& in, const fs::path& resourcePath)
     std::string domain;
 #endif
 
+    // The definitions are read in batches, so that the conversions which only
+    // depend on a definition itself can be done in parallel. The records are
+    // then added in file order, as they may refer to earlier stars and names.
+    std::vector<StcRecord> records;
+    records.reserve(StcBatchSize);
+
     StcHeader header(resourcePath);
+    bool result = true;
     while (tokenizer.nextToken() != util::Tokenizer::TokenEnd)
     {
         if (!parseStcHeader(tokenizer, header))
-            return false;
+        {
+            result = false;
+            break;
+        }
 
         // now goes the star definition
         tokenizer.pushBack();
-        const Value starDataValue = parser.readValue();
-        const AssociativeArray* starData = starDataValue.getHash();
-        if (starData == nullptr)
+        Value starDataValue = parser.readValue();
+        if (starDataValue.getHash() == nullptr)
         {
             GetLogger()->error(_("Bad star definition at line {}.\n"), tokenizer.getLineNumber());
-            return false;
+            result = false;
+            break;
         }
 
+        records.emplace_back(header, std::move(starDataValue));
+        if (records.size() == StcBatchSize)
+        {
+            addRecords(records, resourcePath, domain);
+            records.clear();
+        }
+    }
+
+    // Definitions before a parse error are kept
+    addRecords(records, resourcePath, domain);
+    return result;
+}
+
+void
+StarDatabaseBuilder::addRecords(std::vector<StcRecord>& records,
+                                const fs::path& resourcePath,
+                                const std::string& domain)
+{
+    prepareStcRecords(records);
+
+    for (StcRecord& record : records)
+    {
+        StcHeader& header = record.header;
+        const AssociativeArray* starData = record.data.getHash();
+
         if (header.disposition != DataDisposition::Add && header.catalogNumber == AstroCatalog::InvalidIndex)
-            header.catalogNumber = starDB->namesDB->findCatalogNumberByName(header.names.front(), false);
+            header.catalogNumber = starDB->m_namesDB->findCatalogNumberByName(header.names.front(), false);
 
         Star* star = findWhileLoading(header.catalogNumber);
         if (star == nullptr)
@@ -750,26 +1009,24 @@ StarDatabaseBuilder::load(std::istream& in, const fs::path& resourcePath)
             }
         }
 
-        if (createOrUpdateStar(header, starData, star, resourcePath))
+        if (createOrUpdateStar(record, star, resourcePath))
         {
             loadCategories(header, starData, domain);
 
             if (!header.names.empty())
             {
-                starDB->namesDB->erase(header.catalogNumber);
+                starDB->m_namesDB->erase(header.catalogNumber);
                 for (const auto& name : header.names)
-                    starDB->namesDB->add(header.catalogNumber, name);
+                    starDB->m_namesDB->add(header.catalogNumber, name);
             }
         }
     }
-
-    return true;
 }
 
 void
 StarDatabaseBuilder::setNameDatabase(std::unique_ptr<StarNameDatabase>&& nameDB)
 {
-    starDB->namesDB = std::move(nameDB);
+    starDB->m_namesDB = std::move(nameDB);
 }
 
 std::unique_ptr<StarDatabase>
@@ -777,6 +1034,16 @@ StarDatabaseBuilder::finish()
 {
     GetLogger()->info(_("Total star count: {}\n"), unsortedStars.size());
 
+    // Share the custom details which are equal between stars. Stars which are
+    // given barycenters below have orbits, so their details aren't shared.
+    StarDetailsPool detailsPool;
+    unsortedStars.for_each_block([&detailsPool](Star* stars, std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+            detailsPool.intern(stars[i].details);
+    });
+    GetLogger()->debug("{} distinct custom star details\n", detailsPool.size());
+
     buildOctree();
     buildIndexes();
 
@@ -804,25 +1071,33 @@ StarDatabaseBuilder::finish()
         UserCategory::addObject(star, category);
     }
 
+    if (starDB->m_namesDB != nullptr)
+        starDB->m_namesDB->freeze();
+
+    // Built last as it depends on the final star orbits
+    starDB->octreeRecords = std::make_unique<engine::StarOctreeRecords>(*starDB->m_octreeRoot);
+
     return std::move(starDB);
 }
 
 /*! Load star data from a property list into a star instance.
  */
 bool
-StarDatabaseBuilder::createOrUpdateStar(const StcHeader& header,
-                                        const AssociativeArray* starData,
+StarDatabaseBuilder::createOrUpdateStar(const StcRecord& record,
                                         Star* star,
                                         const fs::path& resourcePath)
 {
+    const StcHeader& header = record.header;
+    const AssociativeArray* starData = record.data.getHash();
+
     boost::intrusive_ptr<StarDetails> newDetails = nullptr;
-    if (!checkSpectralType(header, starData, star, newDetails))
+    if (!checkSpectralType(record, star, newDetails))
         return false;
 
     std::optional<Eigen::Vector3f> position = std::nullopt;
     std::optional<AstroCatalog::IndexNumber> barycenterNumber = std::nullopt;
     std::shared_ptr<const ephem::Orbit> orbit = nullptr;
-    if (!checkStcPosition(header, starData, star, position, barycenterNumber, orbit))
+    if (!checkStcPosition(record, star, position, barycenterNumber, orbit))
         return false;
 
     std::optional<float> absMagnitude = std::nullopt;
@@ -879,17 +1154,19 @@ StarDatabaseBuilder::createOrUpdateStar(const StcHeader& header,
 }
 
 bool
-StarDatabaseBuilder::checkStcPosition(const StarDatabaseBuilder::StcHeader& header,
-                                      const AssociativeArray* starData,
+StarDatabaseBuilder::checkStcPosition(const StcRecord& record,
                                       const Star* star,
                                       std::optional<Eigen::Vector3f>& position,
                                       std::optional<AstroCatalog::IndexNumber>& barycenterNumber,
                                       std::shared_ptr<const ephem::Orbit>& orbit) const
 {
+    const StcHeader& header = record.header;
+    const AssociativeArray* starData = record.data.getHash();
+
     position = std::nullopt;
     barycenterNumber = std::nullopt;
 
-    if (!checkPolarCoordinates(header, starData, star, position))
+    if (!checkPolarCoordinates(record, star, position))
         return false;
 
     if (auto positionValue = starData->getLengthVector<float>("Position", astro::KM_PER_LY<double>);
@@ -947,7 +1224,7 @@ StarDatabaseBuilder::checkBarycenter(const StarDatabaseBuilder::StcHeader& heade
     }
     else if (auto bcName = orbitBarycenterValue->getString(); bcName != nullptr)
     {
-        barycenterNumber = starDB->namesDB->findCatalogNumberByName(*bcName, false);
+        barycenterNumber = starDB->m_namesDB->findCatalogNumberByName(*bcName, false);
     }
     else
     {
@@ -1085,20 +1362,47 @@ StarDatabaseBuilder::buildOctree()
 
     float absMag = astro::appToAbsMag(STAR_OCTREE_MAGNITUDE,
                                       StarDatabase::STAR_OCTREE_ROOT_SIZE * celestia::numbers::sqrt3_v<float>);
+    const Eigen::Vector3f rootCenter(1000.0f, 1000.0f, 1000.0f);
+
+    std::optional<engine::OctreeCache<StarOctreeTraits>> cache;
+    std::unique_ptr<util::FileLock> cacheLock;
+    if (!octreeCachePath.empty())
+    {
+        auto key = engine::OctreeCache<StarOctreeTraits>::computeKey(unsortedStars,
+                                                                     rootCenter,
+                                                                     StarDatabase::STAR_OCTREE_ROOT_SIZE,
+                                                                     absMag,
+                                                                     StarOctreeSplitThreshold);
+        cache.emplace(octreeCachePath, key);
+        // Wait for another process building the same octree, then map it
+        cacheLock = cache->lock();
+        if (auto cachedOctree = cache->load(unsortedStars); cachedOctree != nullptr)
+        {
+            GetLogger()->debug("Loaded star octree from cache {}\n", octreeCachePath);
+            starDB->setOctree(std::move(cachedOctree));
+            unsortedStars.clear();
+            return;
+        }
+    }
 
     auto root = engine::makeDynamicOctree<StarOctreeTraits>(std::move(unsortedStars),
-                                                            Eigen::Vector3f(1000.0f, 1000.0f, 1000.0f),
+                                                            rootCenter,
                                                             StarDatabase::STAR_OCTREE_ROOT_SIZE,
                                                             absMag,
-                                                            StarOctreeSplitThreshold);
+                                                            StarOctreeSplitThreshold,
+                                                            *util::GetThreadPool());
 
     GetLogger()->debug("Spatially sorting stars for improved locality of reference . . .\n");
-    starDB->octreeRoot = root->build();
+    std::vector<engine::OctreeObjectIndex> objectOrder;
+    starDB->setOctree(root->build(cache.has_value() ? &objectOrder : nullptr));
+
+    if (cache.has_value() && !cache->save(*starDB->m_octreeRoot, objectOrder))
+        GetLogger()->warn("Failed to write star octree cache {}\n", octreeCachePath);
 
     GetLogger()->debug("{} stars total\nOctree has {} nodes and {} stars.\n",
                        starCount,
-                       starDB->octreeRoot->nodeCount(),
-                       starDB->octreeRoot->size());
+                       starDB->m_octreeRoot->nodeCount(),
+                       starDB->m_octreeRoot->size());
 
     unsortedStars.clear();
 }
@@ -1111,17 +1415,5 @@ StarDatabaseBuilder::buildIndexes()
 
     GetLogger()->info("Building catalog number indexes . . .\n");
 
-    auto nStars = starDB->octreeRoot->size();
-
-    starDB->catalogNumberIndex.clear();
-    starDB->catalogNumberIndex.reserve(nStars);
-    for (std::uint32_t i = 0; i < nStars; ++i)
-        starDB->catalogNumberIndex.push_back(i);
-
-    const auto& octreeRoot = *starDB->octreeRoot;
-    std::sort(starDB->catalogNumberIndex.begin(), starDB->catalogNumberIndex.end(),
-              [&octreeRoot](std::uint32_t idx0, std::uint32_t idx1)
-              {
-                  return octreeRoot[idx0].getIndex() < octreeRoot[idx1].getIndex();
-              });
+    starDB->buildCatalogNumberIndex();
 }
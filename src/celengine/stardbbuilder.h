@@ -10,11 +10,14 @@
 
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <iosfwd>
 #include <map>
 #include <memory>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include <Eigen/Core>
@@ -32,6 +35,11 @@ class StarDatabase;
 
 namespace celestia
 {
+namespace engine
+{
+class PagedStarCatalog;
+}
+
 namespace ephem
 {
 class Orbit;
@@ -40,6 +48,7 @@ class Orbit;
 namespace util
 {
 class AssociativeArray;
+class Tokenizer;
 }
 }
 
@@ -55,21 +64,33 @@ public:
     StarDatabaseBuilder& operator=(StarDatabaseBuilder&&) noexcept = delete;
 
     bool load(std::istream&, const fs::path& resourcePath = fs::path());
+    // Parse a catalog held in memory, such as a mapped file
+    bool load(std::string_view, const fs::path& resourcePath = fs::path());
     bool loadBinary(std::istream&);
+    bool loadBinary(const fs::path&);
 
     void setNameDatabase(std::unique_ptr<StarNameDatabase>&&);
 
+    // Enable the on-disk octree cache, stored in the given file
+    void setOctreeCachePath(const fs::path&);
+
+    void setPagedCatalog(std::unique_ptr<celestia::engine::PagedStarCatalog>&&);
+
+    // Number of stars loaded so far
+    std::size_t size() const { return unsortedStars.size(); }
+
     std::unique_ptr<StarDatabase> finish();
 
     struct StcHeader;
+    struct StcRecord;
 
 private:
-    bool createOrUpdateStar(const StcHeader&,
-                            const celestia::util::AssociativeArray*,
+    bool parseCatalog(celestia::util::Tokenizer&, const fs::path&);
+    void addRecords(std::vector<StcRecord>&, const fs::path&, const std::string&);
+    bool createOrUpdateStar(const StcRecord&,
                             Star*,
                             const fs::path&);
-    bool checkStcPosition(const StcHeader&,
-                          const celestia::util::AssociativeArray*,
+    bool checkStcPosition(const StcRecord&,
                           const Star*,
                           std::optional<Eigen::Vector3f>&,
                           std::optional<AstroCatalog::IndexNumber>&,
@@ -86,6 +107,7 @@ private:
                      const std::string& name,
                      const std::string& domain);
 
+    void indexBinaryStars(std::uint32_t, double);
     void buildOctree();
     void buildIndexes();
     Star* findWhileLoading(AstroCatalog::IndexNumber catalogNumber) const;
@@ -94,6 +116,8 @@ private:
 
     AstroCatalog::IndexNumber nextAutoCatalogNumber{ 0xfffffffe };
 
+    fs::path octreeCachePath;
+
     BlockArray<Star> unsortedStars;
     // List of stars loaded from binary file, sorted by catalog number
     std::vector<Star*> binFileCatalogNumberIndex;
@@ -16,9 +16,11 @@
 #include <cassert>
 #include <cctype>
 #include <cstddef>
+#include <fstream>
 #include <istream>
 #include <iterator>
 #include <optional>
+#include <ostream>
 #include <string>
 #include <system_error>
 #include <type_traits>
@@ -27,9 +29,11 @@
 
 #include <celcompat/charconv.h>
 #include <celutil/binaryread.h>
+#include <celutil/binarywrite.h>
 #include <celutil/gettext.h>
 #include <celutil/greek.h>
 #include <celutil/logger.h>
+#include <celutil/mappedfile.h>
 #include <celutil/timer.h>
 #include "astroobj.h"
 #include "constellation.h"
@@ -46,6 +50,11 @@ namespace
 
 constexpr std::string_view CROSSINDEX_MAGIC = "CELINDEX"sv;
 constexpr std::uint16_t CrossIndexVersion   = 0x0100;
+// Version 2 adds the record count after the header, and holds the records
+// sorted by catalog number followed by the records sorted by Celestia
+// catalog number, so that both lookups are binary searches in the file.
+constexpr std::uint16_t SortedCrossIndexVersion = 0x0200;
+constexpr std::size_t SortedCrossIndexHeaderSize = 8 + 2 + 2 + 4;
 
 constexpr std::string_view HDCatalogPrefix        = "HD "sv;
 constexpr std::string_view HIPPARCOSCatalogPrefix = "HIP "sv;
@@ -271,7 +280,7 @@ parseCelestiaCatalogNumber(std::string_view name,
 
 // Verify that the cross index file has a correct header
 bool
-checkCrossIndexHeader(std::istream& in)
+checkCrossIndexHeader(std::istream& in, std::uint16_t& version)
 {
     std::array<char, sizeof(CrossIndexHeader)> header;
     if (!in.read(header.data(), header.size()).good()) /* Flawfinder: ignore */
@@ -285,8 +294,8 @@ checkCrossIndexHeader(std::istream& in)
     }
 
     // Verify the version
-    if (auto version = util::fromMemoryLE<std::uint16_t>(header.data() + offsetof(CrossIndexHeader, version));
-        version != CrossIndexVersion)
+    version = util::fromMemoryLE<std::uint16_t>(header.data() + offsetof(CrossIndexHeader, version));
+    if (version != CrossIndexVersion && version != SortedCrossIndexVersion)
     {
         GetLogger()->error(_("Bad version for cross index\n"));
         return false;
@@ -295,8 +304,34 @@ checkCrossIndexHeader(std::istream& in)
     return true;
 }
 
+// Binary search of the records of a version 2 cross index, which are sorted
+// by the field at the given offset
+const char*
+findCrossIndexRecord(const char* records, std::size_t count, std::size_t keyOffset, AstroCatalog::IndexNumber key)
+{
+    std::size_t first = 0;
+    std::size_t last = count;
+    while (first < last)
+    {
+        std::size_t mid = first + (last - first) / 2;
+        if (util::fromMemoryLE<AstroCatalog::IndexNumber>(records + mid * sizeof(CrossIndexRecord) + keyOffset) < key)
+            first = mid + 1;
+        else
+            last = mid;
+    }
+
+    if (first == count)
+        return nullptr;
+
+    const char* record = records + first * sizeof(CrossIndexRecord);
+    return util::fromMemoryLE<AstroCatalog::IndexNumber>(record + keyOffset) == key ? record : nullptr;
+}
+
 } // end unnamed namespace
 
+StarNameDatabase::StarNameDatabase() = default;
+StarNameDatabase::~StarNameDatabase() = default;
+
 AstroCatalog::IndexNumber
 StarNameDatabase::findCatalogNumberByName(std::string_view name, bool i18n) const
 {
@@ -331,9 +366,19 @@ StarNameDatabase::searchCrossIndexForCatalogNumber(StarCatalog catalog, AstroCat
         return AstroCatalog::InvalidIndex;
 
     const CrossIndex& xindex = crossIndices[catalogIndex];
-    auto iter = std::lower_bound(xindex.begin(), xindex.end(), number,
+    if (xindex.file != nullptr)
+    {
+        const char* record = findCrossIndexRecord(xindex.byCatalogNumber, xindex.recordCount,
+                                                  offsetof(CrossIndexRecord, catalogNumber), number);
+        return record == nullptr
+            ? AstroCatalog::InvalidIndex
+            : util::fromMemoryLE<AstroCatalog::IndexNumber>(record + offsetof(CrossIndexRecord, celCatalogNumber));
+    }
+
+    const auto& entries = xindex.entries;
+    auto iter = std::lower_bound(entries.begin(), entries.end(), number,
                                  [](const CrossIndexEntry& ent, AstroCatalog::IndexNumber n) { return ent.catalogNumber < n; });
-    return iter == xindex.end() || iter->catalogNumber != number
+    return iter == entries.end() || iter->catalogNumber != number
         ? AstroCatalog::InvalidIndex
         : iter->celCatalogNumber;
 }
@@ -346,16 +391,35 @@ StarNameDatabase::crossIndex(StarCatalog catalog, AstroCatalog::IndexNumber celC
         return AstroCatalog::InvalidIndex;
 
     const CrossIndex& xindex = crossIndices[catalogIndex];
+    if (xindex.file != nullptr)
+    {
+        const char* record = findCrossIndexRecord(xindex.byCelCatalogNumber, xindex.recordCount,
+                                                  offsetof(CrossIndexRecord, celCatalogNumber), celCatalogNumber);
+        return record == nullptr
+            ? AstroCatalog::InvalidIndex
+            : util::fromMemoryLE<AstroCatalog::IndexNumber>(record + offsetof(CrossIndexRecord, catalogNumber));
+    }
 
-    // A simple linear search.  We could store cross indices sorted by
-    // both catalog numbers and trade memory for speed
-    auto iter = std::find_if(xindex.begin(), xindex.end(),
+    // A simple linear search for version 1 files; version 2 files hold the
+    // entries sorted by both catalog numbers
+    const auto& entries = xindex.entries;
+    auto iter = std::find_if(entries.begin(), entries.end(),
                              [celCatalogNumber](const CrossIndexEntry& o) { return celCatalogNumber == o.celCatalogNumber; });
-    return iter == xindex.end()
+    return iter == entries.end()
         ? AstroCatalog::InvalidIndex
         : iter->catalogNumber;
 }
 
+std::size_t
+StarNameDatabase::getMemoryUsage() const
+{
+    // Mapped cross indexes are backed by their files
+    std::size_t bytes = NameDatabase::getMemoryUsage();
+    for (const CrossIndex& xindex : crossIndices)
+        bytes += xindex.entries.capacity() * sizeof(CrossIndexEntry);
+    return bytes;
+}
+
 AstroCatalog::IndexNumber
 StarNameDatabase::findByName(std::string_view name, bool i18n) const
 {
@@ -560,6 +624,24 @@ StarNameDatabase::readNames(std::istream& in)
     return db;
 }
 
+std::unique_ptr<StarNameDatabase>
+StarNameDatabase::loadNames(const fs::path& path)
+{
+    if (auto file = util::MappedFile::open(path);
+        file != nullptr && NameDatabase::isIndex(file->data(), file->size()))
+    {
+        auto db = std::make_unique<StarNameDatabase>();
+        if (!db->readIndex(file->data(), file->size()))
+            return nullptr;
+        return db;
+    }
+
+    std::ifstream in(path);
+    if (!in.good())
+        return nullptr;
+    return readNames(in);
+}
+
 bool
 StarNameDatabase::loadCrossIndex(StarCatalog catalog, std::istream& in)
 {
@@ -569,19 +651,39 @@ StarNameDatabase::loadCrossIndex(StarCatalog catalog, std::istream& in)
     if (catalogIndex >= crossIndices.size())
         return false;
 
-    if (!checkCrossIndexHeader(in))
+    std::uint16_t version;
+    if (!checkCrossIndexHeader(in, version))
         return false;
 
     CrossIndex& xindex = crossIndices[catalogIndex];
     xindex = {};
 
+    // Only the records sorted by catalog number are read from version 2
+    // files, and these don't need sorting
+    std::optional<std::uint32_t> recordCount;
+    if (version == SortedCrossIndexVersion)
+    {
+        std::array<char, SortedCrossIndexHeaderSize - sizeof(CrossIndexHeader)> countData;
+        if (!in.read(countData.data(), countData.size()).good()) /* Flawfinder: ignore */
+            return false;
+        recordCount = util::fromMemoryLE<std::uint32_t>(countData.data() + 2);
+        xindex.entries.reserve(*recordCount);
+    }
+
+    CrossIndex::Entries& entries = xindex.entries;
     constexpr std::uint32_t BUFFER_RECORDS = UINT32_C(4096) / sizeof(CrossIndexRecord);
     std::vector<char> buffer(sizeof(CrossIndexRecord) * BUFFER_RECORDS);
     bool hasMoreRecords = true;
     while (hasMoreRecords)
     {
         std::size_t remainingRecords = BUFFER_RECORDS;
-        in.read(buffer.data(), buffer.size()); /* Flawfinder: ignore */
+        if (recordCount.has_value())
+        {
+            remainingRecords = std::min<std::size_t>(remainingRecords, *recordCount - entries.size());
+            hasMoreRecords = entries.size() + remainingRecords < *recordCount;
+        }
+
+        in.read(buffer.data(), remainingRecords * sizeof(CrossIndexRecord)); /* Flawfinder: ignore */
         if (in.bad())
         {
             GetLogger()->error(_("Loading cross index failed\n"));
@@ -592,8 +694,8 @@ StarNameDatabase::loadCrossIndex(StarCatalog catalog, std::istream& in)
         {
             auto bytesRead = static_cast<std::uint32_t>(in.gcount());
             remainingRecords = bytesRead / sizeof(CrossIndexRecord);
-            // disallow partial records
-            if (bytesRead % sizeof(CrossIndexRecord) != 0)
+            // disallow partial records, and missing records of version 2
+            if (bytesRead % sizeof(CrossIndexRecord) != 0 || recordCount.has_value())
             {
                 GetLogger()->error(_("Loading cross index failed - unexpected EOF\n"));
                 xindex = {};
@@ -603,12 +705,12 @@ StarNameDatabase::loadCrossIndex(StarCatalog catalog, std::istream& in)
             hasMoreRecords = false;
         }
 
-        xindex.reserve(xindex.size() + remainingRecords);
+        entries.reserve(entries.size() + remainingRecords);
 
         const char* ptr = buffer.data();
         while (remainingRecords-- > 0)
         {
-            CrossIndexEntry& ent = xindex.emplace_back();
+            CrossIndexEntry& ent = entries.emplace_back();
             ent.catalogNumber = util::fromMemoryLE<AstroCatalog::IndexNumber>(ptr + offsetof(CrossIndexRecord, catalogNumber));
             ent.celCatalogNumber = util::fromMemoryLE<AstroCatalog::IndexNumber>(ptr + offsetof(CrossIndexRecord, celCatalogNumber));
             ptr += sizeof(CrossIndexRecord);
@@ -617,7 +719,84 @@ StarNameDatabase::loadCrossIndex(StarCatalog catalog, std::istream& in)
 
     GetLogger()->debug("Loaded xindex in {} ms\n", timer.getTime());
 
-    std::sort(xindex.begin(), xindex.end(),
-              [](const auto& lhs, const auto& rhs) { return lhs.catalogNumber < rhs.catalogNumber; });
+    if (!recordCount.has_value())
+    {
+        std::sort(entries.begin(), entries.end(),
+                  [](const auto& lhs, const auto& rhs) { return lhs.catalogNumber < rhs.catalogNumber; });
+    }
     return true;
 }
+
+bool
+StarNameDatabase::loadCrossIndex(StarCatalog catalog, const fs::path& path)
+{
+    auto catalogIndex = static_cast<std::size_t>(catalog);
+    if (catalogIndex >= crossIndices.size())
+        return false;
+
+    auto file = util::MappedFile::open(path);
+    if (file == nullptr)
+        return false;
+
+    const char* data = file->data();
+    if (file->size() < SortedCrossIndexHeaderSize ||
+        std::string_view(data, CROSSINDEX_MAGIC.size()) != CROSSINDEX_MAGIC ||
+        util::fromMemoryLE<std::uint16_t>(data + offsetof(CrossIndexHeader, version)) != SortedCrossIndexVersion)
+    {
+        // Older files are read and sorted
+        std::ifstream in(path, std::ios::binary);
+        return in.good() && loadCrossIndex(catalog, in);
+    }
+
+    auto recordCount = static_cast<std::size_t>(util::fromMemoryLE<std::uint32_t>(data + sizeof(CrossIndexHeader) + 2));
+    if (file->size() != SortedCrossIndexHeaderSize + 2 * recordCount * sizeof(CrossIndexRecord))
+    {
+        GetLogger()->error(_("Bad size for cross index\n"));
+        return false;
+    }
+
+    CrossIndex& xindex = crossIndices[catalogIndex];
+    xindex = {};
+    xindex.byCatalogNumber = data + SortedCrossIndexHeaderSize;
+    xindex.byCelCatalogNumber = xindex.byCatalogNumber + recordCount * sizeof(CrossIndexRecord);
+    xindex.recordCount = recordCount;
+    xindex.file = std::move(file);
+    return true;
+}
+
+bool
+StarNameDatabase::writeCrossIndex(std::ostream& out,
+                                  std::vector<std::pair<AstroCatalog::IndexNumber, AstroCatalog::IndexNumber>>&& entries)
+{
+    std::vector<std::pair<AstroCatalog::IndexNumber, AstroCatalog::IndexNumber>> byCatalogNumber = entries;
+    std::stable_sort(byCatalogNumber.begin(), byCatalogNumber.end(),
+                     [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+    std::stable_sort(entries.begin(), entries.end(),
+                     [](const auto& lhs, const auto& rhs) { return lhs.second < rhs.second; });
+    return writeCrossIndex(out, byCatalogNumber, entries);
+}
+
+bool
+StarNameDatabase::writeCrossIndex(std::ostream& out,
+                                  const std::vector<std::pair<AstroCatalog::IndexNumber, AstroCatalog::IndexNumber>>& byCatalogNumber,
+                                  const std::vector<std::pair<AstroCatalog::IndexNumber, AstroCatalog::IndexNumber>>& byCelCatalogNumber)
+{
+    if (byCatalogNumber.size() > UINT32_MAX || byCatalogNumber.size() != byCelCatalogNumber.size())
+        return false;
+
+    out.write(CROSSINDEX_MAGIC.data(), CROSSINDEX_MAGIC.size());
+    util::writeLE<std::uint16_t>(out, SortedCrossIndexVersion);
+    util::writeLE<std::uint16_t>(out, 0);
+    util::writeLE<std::uint32_t>(out, static_cast<std::uint32_t>(byCatalogNumber.size()));
+
+    for (const auto& sorted : { &byCatalogNumber, &byCelCatalogNumber })
+    {
+        for (const auto& [catalogNumber, celCatalogNumber] : *sorted)
+        {
+            util::writeLE<std::uint32_t>(out, catalogNumber);
+            util::writeLE<std::uint32_t>(out, celCatalogNumber);
+        }
+    }
+
+    return out.good();
+}
@@ -18,9 +18,17 @@
 #include <iosfwd>
 #include <memory>
 #include <string_view>
+#include <utility>
+#include <vector>
 
+#include <celcompat/filesystem.h>
 #include <celengine/name.h>
 
+namespace celestia::util
+{
+class MappedFile;
+}
+
 enum class StarCatalog : unsigned int
 {
     HenryDraper,
@@ -34,7 +42,8 @@ public:
     static constexpr AstroCatalog::IndexNumber TYC3_MULTIPLIER = 1000000000u;
     static constexpr AstroCatalog::IndexNumber TYC2_MULTIPLIER = 10000u;
 
-    StarNameDatabase() = default;
+    StarNameDatabase();
+    ~StarNameDatabase();
 
     using NameDatabase::add;
     using NameDatabase::erase;
@@ -43,6 +52,11 @@ public:
     using NameDatabase::getFinalNameIter;
 
     using NameDatabase::getCompletion;
+    using NameDatabase::freeze;
+    using NameDatabase::writeIndex;
+
+    // Memory of the names and of the cross indexes read from streams
+    std::size_t getMemoryUsage() const;
 
     // We don't want users to access the getCatalogMethodByName method on the
     // NameDatabase base class, so use private inheritance to enforce usage of
@@ -53,7 +67,22 @@ public:
     AstroCatalog::IndexNumber crossIndex(StarCatalog, AstroCatalog::IndexNumber number) const;
 
     bool loadCrossIndex(StarCatalog, std::istream&);
+    // Version 2 cross indexes are mapped and searched in place
+    bool loadCrossIndex(StarCatalog, const fs::path&);
+    // Write a version 2 cross index from entries of catalog number and
+    // Celestia catalog number
+    static bool writeCrossIndex(std::ostream&,
+                                std::vector<std::pair<AstroCatalog::IndexNumber, AstroCatalog::IndexNumber>>&&);
+    // Write a version 2 cross index from the same entries already sorted by
+    // catalog number and by Celestia catalog number
+    static bool writeCrossIndex(std::ostream&,
+                                const std::vector<std::pair<AstroCatalog::IndexNumber, AstroCatalog::IndexNumber>>& byCatalogNumber,
+                                const std::vector<std::pair<AstroCatalog::IndexNumber, AstroCatalog::IndexNumber>>& byCelCatalogNumber);
+
     static std::unique_ptr<StarNameDatabase> readNames(std::istream&);
+    // Load a names file either as text or as a binary index written by
+    // makestarnames
+    static std::unique_ptr<StarNameDatabase> loadNames(const fs::path&);
 
 private:
     static constexpr auto NumCatalogs = static_cast<std::size_t>(StarCatalog::_CatalogCount);
@@ -64,7 +93,20 @@ private:
         AstroCatalog::IndexNumber celCatalogNumber;
     };
 
-    using CrossIndex = std::vector<CrossIndexEntry>;
+    struct CrossIndex
+    {
+        using Entries = std::vector<CrossIndexEntry>;
+
+        // Entries read from a stream, sorted by catalog number
+        Entries entries;
+
+        // Version 2 files hold the records sorted by catalog number followed
+        // by the records sorted by Celestia catalog number
+        std::unique_ptr<celestia::util::MappedFile> file;
+        const char* byCatalogNumber{ nullptr };
+        const char* byCelCatalogNumber{ nullptr };
+        std::size_t recordCount{ 0 };
+    };
 
     AstroCatalog::IndexNumber findByName(std::string_view, bool) const;
     AstroCatalog::IndexNumber findFlamsteedOrVariable(std::string_view, std::string_view, bool) const;
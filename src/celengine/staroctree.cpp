@@ -12,6 +12,9 @@
 
 #include "staroctree.h"
 
+#include <algorithm>
+#include <cmath>
+
 #include <celastro/astro.h>
 #include <celcompat/numbers.h>
 #include <celmath/mathlib.h>
@@ -32,15 +35,88 @@ namespace
 // render stars with orbits that are closer than MAX_STAR_ORBIT_RADIUS.
 constexpr float MAX_STAR_ORBIT_RADIUS = 1.0f;
 
+// Allowance for rounding in the float computations on the quantized
+// values, relative to the distance from the origin and in magnitudes.
+constexpr float RecordPositionTolerance = 1.0e-6f;
+constexpr float RecordMagnitudeTolerance = 1.0e-3f;
+
+class StarOctreeRecordBuilder
+{
+public:
+    explicit StarOctreeRecordBuilder(std::vector<StarOctreeRecord>& records) : m_records(records) {}
+
+    bool checkNode(const StarOctree::PointType&, float, float) const { return true; }
+    void process(const Star&) const { /* objects are handled by processObjects */ }
+    void processObjects(const StarOctree::PointType&,
+                        float,
+                        const Star*,
+                        OctreeObjectIndex,
+                        OctreeObjectIndex) const;
+
+private:
+    std::vector<StarOctreeRecord>& m_records;
+};
+
+void
+StarOctreeRecordBuilder::processObjects(const StarOctree::PointType& center,
+                                        float size,
+                                        const Star* objects,
+                                        OctreeObjectIndex first,
+                                        OctreeObjectIndex last) const
+{
+    const float scale = StarOctreeRecord::PositionScale / size;
+    for (OctreeObjectIndex idx = first; idx < last; ++idx)
+    {
+        const Star& star = objects[idx];
+        StarOctreeRecord& record = m_records[idx];
+        record.flags = 0;
+
+        Eigen::Vector3f offset = (star.getPosition() - center) * scale;
+        for (unsigned int i = 0; i < 3; ++i)
+        {
+            float quantized = std::round(offset[i]);
+            if (!(std::abs(quantized) <= StarOctreeRecord::PositionScale))
+            {
+                record.flags |= StarOctreeRecord::ExactTest;
+                quantized = 0.0f;
+            }
+
+            record.position[i] = static_cast<std::int16_t>(quantized);
+        }
+
+        // Round down so that the record is never fainter than the star
+        float absMag = std::floor(star.getAbsoluteMagnitude() * StarOctreeRecord::MagnitudeScale);
+        if (!(absMag >= -32768.0f))
+        {
+            record.flags |= StarOctreeRecord::ExactTest;
+            absMag = -32768.0f;
+        }
+
+        record.absMag = static_cast<std::int16_t>(std::min(absMag, 32767.0f));
+
+        if (star.getOrbit() != nullptr || !(star.getExtinction() >= 0.0f))
+            record.flags |= StarOctreeRecord::ExactTest;
+    }
+}
+
 } // end unnamed namespace
 
+StarOctreeRecords::StarOctreeRecords(const StarOctree& octree) :
+    m_records(octree.size())
+{
+    StarOctreeRecordBuilder builder(m_records);
+    octree.processDepthFirst(builder);
+}
+
 // The version of cppcheck used by Codacy doesn't seem to detect the field initializer
 
 StarOctreeVisibleObjectsProcessor::StarOctreeVisibleObjectsProcessor(StarHandler* starHandler, // cppcheck-suppress uninitMemberVar
                                                                      const StarOctree::PointType& obsPosition,
                                                                      util::array_view<PlaneType> frustumPlanes,
-                                                                     float limitingFactor) :
+                                                                     float limitingFactor,
+                                                                     const StarOctreeRecords* records) :
     m_starHandler(starHandler),
+    m_records(records == nullptr ? nullptr : records->data()),
     m_obsPosition(obsPosition),
     m_frustumPlanes(frustumPlanes),
     m_limitingFactor(limitingFactor)
@@ -78,6 +154,28 @@ StarOctreeVisibleObjectsProcessor::checkNode(const StarOctree::PointType& center
     return true;
 }
 
+std::uint32_t
+StarOctreeVisibleObjectsProcessor::checkNodes(const OctreeNodeBatch<float>& batch)
+{
+    using BatchType = OctreeNodeBatch<float>;
+
+    BatchType::MaskArrayType result = batch.inFrustum(m_frustumPlanes);
+
+    BatchType::ArrayType minDistance = batch.distanceFrom(m_obsPosition) - batch.size * numbers::sqrt3_v<float>;
+    BatchType::FactorArrayType distanceModulus = minDistance.unaryExpr([](float d) { return astro::distanceModulus(d); });
+    result = result && ((minDistance <= 0.0f) || ((batch.brightFactor + distanceModulus) <= m_limitingFactor));
+
+    m_batchDimmest = (minDistance > 0.0f).select(m_limitingFactor - distanceModulus, 1000.0f);
+
+    return BatchType::toBitMask(result);
+}
+
+void
+StarOctreeVisibleObjectsProcessor::selectNode(unsigned int lane)
+{
+    m_dimmest = m_batchDimmest[lane];
+}
+
 void
 StarOctreeVisibleObjectsProcessor::process(const Star& obj) const
 {
@@ -91,6 +189,178 @@ StarOctreeVisibleObjectsProcessor::process(const Star& obj) const
         m_starHandler->process(obj, distance, appMag);
 }
 
+// Reject the stars of a node which are certainly not visible using the
+// compact records, and run the exact test on the remaining ones.
+void
+StarOctreeVisibleObjectsProcessor::processObjects(const StarOctree::PointType& center,
+                                                  float size,
+                                                  const Star* objects,
+                                                  OctreeObjectIndex first,
+                                                  OctreeObjectIndex last) const
+{
+    if (m_records == nullptr)
+    {
+        for (OctreeObjectIndex idx = first; idx < last; ++idx)
+            process(objects[idx]);
+        return;
+    }
+
+    const float step = size / StarOctreeRecord::PositionScale;
+    // Quantization is at most half a step on each axis, allow a full step
+    // plus the rounding error of the float computations
+    const float positionError = step * numbers::sqrt3_v<float>
+                              + (center.norm() + size + m_obsPosition.norm()) * RecordPositionTolerance;
+    const StarOctree::PointType relativeObs = (m_obsPosition - center) / step;
+
+    for (OctreeObjectIndex idx = first; idx < last; ++idx)
+    {
+        const StarOctreeRecord& record = m_records[idx];
+        if ((record.flags & StarOctreeRecord::ExactTest) == 0)
+        {
+            float absMag = static_cast<float>(record.absMag) / StarOctreeRecord::MagnitudeScale;
+            if (absMag > m_dimmest)
+                continue;
+
+            float minDistance = (relativeObs - StarOctree::PointType(record.position[0],
+                                                                     record.position[1],
+                                                                     record.position[2])).norm() * step
+                              - positionError;
+            if (minDistance > 0.0f
+                && astro::absToAppMag(absMag, minDistance) - RecordMagnitudeTolerance > m_limitingFactor)
+            {
+                continue;
+            }
+        }
+
+        process(objects[idx]);
+    }
+}
+
+StarOctreeVisibleNodesProcessor::StarOctreeVisibleNodesProcessor(const StarOctree::PointType& obsPosition,
+                                                                 util::array_view<PlaneType> frustumPlanes,
+                                                                 float limitingFactor,
+                                                                 float positionTolerance,
+                                                                 float normalTolerance,
+                                                                 float magnitudeTolerance) :
+    m_obsPosition(obsPosition),
+    m_frustumPlanes(frustumPlanes),
+    m_limitingFactor(limitingFactor + magnitudeTolerance),
+    m_positionTolerance(positionTolerance),
+    m_normalTolerance(normalTolerance)
+{
+}
+
+bool
+StarOctreeVisibleNodesProcessor::checkNode(const StarOctree::PointType& center,
+                                           float size,
+                                           float factor) const
+{
+    float centerDistance = (m_obsPosition - center).norm();
+
+    // The signed distance to a plane with a normal differing by at most
+    // normalTolerance, passing through an observer at most positionTolerance
+    // away, differs by at most normalTolerance * centerDistance +
+    // positionTolerance. The node extent along the normal grows by at most
+    // size * normalTolerance * sqrt(3).
+    for (const PlaneType& plane : m_frustumPlanes)
+    {
+        float r = size * (plane.normal().cwiseAbs().sum() + m_normalTolerance * numbers::sqrt3_v<float>)
+                + m_normalTolerance * centerDistance
+                + m_positionTolerance;
+        if (plane.signedDistance(center) < -r)
+            return false;
+    }
+
+    float minDistance = centerDistance - size * numbers::sqrt3_v<float> - m_positionTolerance;
+    return minDistance <= 0.0f || (factor + astro::distanceModulus(minDistance)) <= m_limitingFactor;
+}
+
+StarOctreeConeObjectsProcessor::StarOctreeConeObjectsProcessor(StarHandler* starHandler, // cppcheck-suppress uninitMemberVar
+                                                               const StarOctree::PointType& apex,
+                                                               const StarOctree::PointType& axis,
+                                                               float angle,
+                                                               float limitingFactor) :
+    m_starHandler(starHandler),
+    m_apex(apex),
+    m_axis(axis.normalized()),
+    m_sinAngle(std::sin(std::min(angle, numbers::pi_v<float> * 0.5f))),
+    m_cosAngle(std::cos(std::min(angle, numbers::pi_v<float> * 0.5f))),
+    m_limitingFactor(limitingFactor)
+{
+}
+
+bool
+StarOctreeConeObjectsProcessor::checkNode(const StarOctree::PointType& center,
+                                          float size,
+                                          float factor)
+{
+    StarOctree::PointType offset = center - m_apex;
+    float distance = offset.norm();
+    float radius = size * numbers::sqrt3_v<float>;
+    if (distance > radius)
+    {
+        float along = offset.dot(m_axis);
+        float across = std::sqrt(std::max(math::square(distance) - math::square(along), 0.0f));
+        if (across * m_cosAngle - along * m_sinAngle > radius || along * m_cosAngle + across * m_sinAngle < 0.0f)
+            return false;
+    }
+
+    float minDistance = distance - radius;
+    float distanceModulus = astro::distanceModulus(minDistance);
+    if (minDistance > 0.0f && (factor + distanceModulus) > m_limitingFactor)
+        return false;
+
+    m_dimmest = minDistance > 0.0f ? (m_limitingFactor - distanceModulus) : 1000.0f;
+    return true;
+}
+
+std::uint32_t
+StarOctreeConeObjectsProcessor::checkNodes(const OctreeNodeBatch<float>& batch)
+{
+    using BatchType = OctreeNodeBatch<float>;
+
+    BatchType::MaskArrayType result = batch.inCone(m_apex, m_axis, m_sinAngle, m_cosAngle);
+
+    BatchType::ArrayType minDistance = batch.distanceFrom(m_apex) - batch.size * numbers::sqrt3_v<float>;
+    BatchType::FactorArrayType distanceModulus = minDistance.unaryExpr([](float d) { return astro::distanceModulus(d); });
+    result = result && ((minDistance <= 0.0f) || ((batch.brightFactor + distanceModulus) <= m_limitingFactor));
+
+    m_batchDimmest = (minDistance > 0.0f).select(m_limitingFactor - distanceModulus, 1000.0f);
+
+    return BatchType::toBitMask(result);
+}
+
+void
+StarOctreeConeObjectsProcessor::selectNode(unsigned int lane)
+{
+    m_dimmest = m_batchDimmest[lane];
+}
+
+void
+StarOctreeConeObjectsProcessor::process(const Star& obj) const
+{
+    if (obj.getOrbit() != nullptr)
+    {
+        float distance = (m_apex - obj.getPosition()).norm();
+        m_starHandler->process(obj, distance, obj.getApparentMagnitude(distance));
+        return;
+    }
+
+    if (obj.getAbsoluteMagnitude() > m_dimmest)
+        return;
+
+    // Inside the cone when the angle to the axis is at most the half angle
+    StarOctree::PointType offset = obj.getPosition() - m_apex;
+    float along = offset.dot(m_axis);
+    if (along <= 0.0f || math::square(along) < offset.squaredNorm() * math::square(m_cosAngle))
+        return;
+
+    float distance = offset.norm();
+    float appMag = obj.getApparentMagnitude(distance);
+    if (appMag <= m_limitingFactor)
+        m_starHandler->process(obj, distance, appMag);
+}
+
 StarOctreeCloseObjectsProcessor::StarOctreeCloseObjectsProcessor(StarHandler* starHandler,
                                                                  const StarOctree::PointType& obsPosition,
                                                                  float boundingRadius) :
@@ -112,6 +382,15 @@ StarOctreeCloseObjectsProcessor::checkNode(const StarOctree::PointType& center,
     return nodeDistance <= m_boundingRadius;
 }
 
+std::uint32_t
+StarOctreeCloseObjectsProcessor::checkNodes(const OctreeNodeBatch<float>& batch) const
+{
+    using BatchType = OctreeNodeBatch<float>;
+
+    BatchType::ArrayType nodeDistance = batch.distanceFrom(m_obsPosition) - batch.size * numbers::sqrt3_v<float>;
+    return BatchType::toBitMask(nodeDistance <= m_boundingRadius);
+}
+
 void
 StarOctreeCloseObjectsProcessor::process(const Star& obj) const
 {
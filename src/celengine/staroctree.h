@@ -13,6 +13,7 @@
 #pragma once
 
 #include <cstdint>
+#include <vector>
 
 #include <Eigen/Geometry>
 
@@ -25,6 +26,54 @@ namespace celestia::engine
 using StarOctree = StaticOctree<Star, float>;
 using StarHandler = OctreeProcessor<Star, float>;
 
+// Range of stars [first, last) in the object order of a StarOctree
+struct StarOctreeObjectRange
+{
+    OctreeObjectIndex first;
+    OctreeObjectIndex last;
+};
+
+// Compact copy of the data used to cull the stars of a visible node, stored
+// in the same order as the objects of the StarOctree. Positions are
+// quantized relative to the center of the containing node, and magnitudes
+// are rounded down to a fixed point value, so that a star can be rejected
+// without touching the Star object; stars which are not rejected are tested
+// again exactly.
+//
+// The records are kept in addition to the stars, which are referenced by
+// the handlers, selections and scripts, so they add 10 bytes per star. They
+// don't hold a color index: the color is only needed for the stars which
+// are drawn, and it is read from their details.
+struct StarOctreeRecord
+{
+    enum Flags : std::uint16_t
+    {
+        // The star must always be tested exactly: its position could not
+        // be quantized, or it has an orbit or an unusual extinction.
+        ExactTest = 0x1,
+    };
+
+    static constexpr float PositionScale = 32767.0f;
+    static constexpr float MagnitudeScale = 1024.0f;
+
+    std::int16_t position[3]; //NOSONAR
+    std::int16_t absMag;
+    std::uint16_t flags;
+};
+
+static_assert(sizeof(StarOctreeRecord) == 10);
+
+class StarOctreeRecords
+{
+public:
+    explicit StarOctreeRecords(const StarOctree&);
+
+    const StarOctreeRecord* data() const { return m_records.data(); }
+
+private:
+    std::vector<StarOctreeRecord> m_records;
+};
+
 // This class searches the octree for objects that are likely to be visible
 // to a viewer with the specified obsPosition and limitingFactor.  The
 // octreeProcessor is invoked for each potentially visible object --no object with
@@ -40,18 +89,88 @@ public:
     StarOctreeVisibleObjectsProcessor(StarHandler*,
                                       const StarOctree::PointType&,
                                       util::array_view<PlaneType>,
-                                      float);
+                                      float,
+                                      const StarOctreeRecords* = nullptr);
 
     bool checkNode(const StarOctree::PointType&, float, float);
+    std::uint32_t checkNodes(const OctreeNodeBatch<float>&);
+    void selectNode(unsigned int);
     void process(const Star&) const;
+    void processObjects(const StarOctree::PointType&,
+                        float,
+                        const Star*,
+                        OctreeObjectIndex,
+                        OctreeObjectIndex) const;
 
 private:
     StarHandler* m_starHandler;
+    const StarOctreeRecord* m_records;
+    StarOctree::PointType m_obsPosition;
+    util::array_view<PlaneType> m_frustumPlanes;
+    float m_limitingFactor;
+
+    float m_dimmest{ 1000.0f };
+    OctreeNodeBatch<float>::FactorArrayType m_batchDimmest;
+};
+
+// Selects a superset of the nodes accepted by
+// StarOctreeVisibleObjectsProcessor for any observer within the given
+// tolerances of the specified one: a displacement of up to positionTolerance,
+// frustum plane normals differing by a vector of length up to
+// normalTolerance, and a limiting factor up to magnitudeTolerance larger.
+class StarOctreeVisibleNodesProcessor
+{
+public:
+    using PlaneType = Eigen::Hyperplane<float, 3>;
+
+    StarOctreeVisibleNodesProcessor(const StarOctree::PointType&,
+                                    util::array_view<PlaneType>,
+                                    float,
+                                    float,
+                                    float,
+                                    float);
+
+    bool checkNode(const StarOctree::PointType&, float, float) const;
+    void process(const Star&) const { /* only nodes are selected */ }
+
+private:
     StarOctree::PointType m_obsPosition;
     util::array_view<PlaneType> m_frustumPlanes;
     float m_limitingFactor;
+    float m_positionTolerance;
+    float m_normalTolerance;
+};
+
+// Searches the octree for the stars in a cone around a pick ray which are
+// no fainter than limitingFactor. Nodes are tested with their bounding
+// spheres against the cone, and the stars of the nodes which pass are
+// tested against the cone and the limiting magnitude before the handler is
+// called. Stars with orbits are always passed to the handler, as their
+// current position can differ from the barycenter position used here.
+class StarOctreeConeObjectsProcessor
+{
+public:
+    StarOctreeConeObjectsProcessor(StarHandler*,
+                                   const StarOctree::PointType&,
+                                   const StarOctree::PointType&,
+                                   float,
+                                   float);
+
+    bool checkNode(const StarOctree::PointType&, float, float);
+    std::uint32_t checkNodes(const OctreeNodeBatch<float>&);
+    void selectNode(unsigned int);
+    void process(const Star&) const;
+
+private:
+    StarHandler* m_starHandler;
+    StarOctree::PointType m_apex;
+    StarOctree::PointType m_axis;
+    float m_sinAngle;
+    float m_cosAngle;
+    float m_limitingFactor;
 
     float m_dimmest{ 1000.0f };
+    OctreeNodeBatch<float>::FactorArrayType m_batchDimmest;
 };
 
 class StarOctreeCloseObjectsProcessor
@@ -62,6 +181,8 @@ public:
                                     float);
 
     bool checkNode(const StarOctree::PointType&, float, float) const;
+    std::uint32_t checkNodes(const OctreeNodeBatch<float>&) const;
+    void selectNode(unsigned int) const { /* no per-node state */ }
     void process(const Star&) const;
 
 private:
@@ -13,12 +13,20 @@
 #include <array>
 #include <cstddef>
 #include <fstream>
+#include <string>
 #include <string_view>
+#include <utility>
 
+#include <celutil/fileaccesslog.h>
+#include <celutil/filetype.h>
 #include <celutil/fsutils.h>
 #include <celutil/logger.h>
+#include <celutil/profiler.h>
+#include "framestats.h"
+#include "texturestats.h"
 
 using namespace std::string_view_literals;
+using celestia::engine::Image;
 using celestia::util::GetLogger;
 
 namespace
@@ -49,18 +57,32 @@ constexpr std::array extensions =
 TextureManager*
 GetTextureManager()
 {
-    static TextureManager* const textureManager = std::make_unique<TextureManager>("textures").release(); //NOSONAR
+    static TextureManager* const textureManager = []
+    {
+        auto manager = std::make_unique<TextureManager>("textures");
+        manager->setLoadObserver([](const TextureKey& key, const celestia::util::ResourceLoadRecord& record)
+        {
+            celestia::engine::GetTextureLoadStats()->add({ key.path, record, false });
+            std::string path = key.path.u8string();
+            celestia::engine::GetFrameStats()->addZoneTime(celestia::engine::FrameZone::TextureLoad,
+                                                           path,
+                                                           record.createTime);
+            celestia::util::Profiler::recordInstant(record.failed ? "texture load failed" : "texture load", path);
+        });
+        return manager.release();
+    }(); //NOSONAR
     return textureManager;
 }
 
+// Returns the file in the directory for a resolution, or an empty path
 fs::path
-TextureInfo::resolve(const fs::path& baseDir) const
+TextureInfo::findFile(const fs::path& baseDir, std::size_t directory) const
 {
     bool wildcard = source.extension() == ".*";
 
     if (!path.empty())
     {
-        fs::path filename = path / "textures" / directories[static_cast<std::size_t>(resolution)] / source;
+        fs::path filename = path / "textures" / directories[directory] / source;
         // cout << "Resolve: testing [" << filename << "]\n";
         if (wildcard)
         {
@@ -76,42 +98,118 @@ TextureInfo::resolve(const fs::path& baseDir) const
         }
     }
 
-    fs::path filename = baseDir / directories[static_cast<std::size_t>(resolution)] / source;
+    fs::path filename = baseDir / directories[directory] / source;
     if (wildcard)
+        return celestia::util::ResolveWildcard(filename, extensions);
+
+    std::ifstream in(filename);
+    return in.good() ? filename : fs::path();
+}
+
+TextureKey
+TextureInfo::resolve(const fs::path& baseDir) const
+{
+    const auto resolutionIndex = static_cast<std::size_t>(resolution);
+
+    // The medium resolution is the default, and add-ons often only ship
+    // high resolution textures which are meant to be shown at full size, so
+    // only the low resolution reduces the textures it falls back to
+    std::size_t lastIndex = resolution == TextureResolution::lores
+        ? directories.size() - 1
+        : resolutionIndex;
+    for (std::size_t i = resolutionIndex; i <= lastIndex; ++i)
     {
-        fs::path matched = celestia::util::ResolveWildcard(filename, extensions);
-        if (!matched.empty())
-            return matched;
+        if (fs::path filename = findFile(baseDir, i); !filename.empty())
+            return TextureKey{ std::move(filename), static_cast<std::int32_t>(i - resolutionIndex) };
     }
 
-    return filename;
+    // Not found: MultiResTexture falls back to the other resolutions
+    return TextureKey{ baseDir / directories[resolutionIndex] / source, 0 };
+}
+
+
+Texture::AddressMode
+TextureInfo::getAddressMode() const
+{
+    if (flags & WrapTexture)
+        return Texture::Wrap;
+    if (flags & BorderClamp)
+        return Texture::BorderClamp;
+    return Texture::EdgeClamp;
 }
 
 
 std::unique_ptr<Texture>
-TextureInfo::load(const fs::path& name) const
+TextureInfo::load(const TextureKey& key) const
 {
-    Texture::AddressMode addressMode = Texture::EdgeClamp;
+    Texture::AddressMode addressMode = getAddressMode();
     Texture::MipMapMode  mipMode     = Texture::DefaultMipMaps;
     Texture::Colorspace  colorspace  = Texture::DefaultColorspace;
 
-    if (flags & WrapTexture)
-        addressMode = Texture::Wrap;
-    else if (flags & BorderClamp)
-        addressMode = Texture::BorderClamp;
-
     if (flags & NoMipMaps)
         mipMode = Texture::NoMipMaps;
 
     if (flags & LinearColorspace)
         colorspace = Texture::LinearColorspace;
 
+    celestia::util::FileAccessScope access("texture", key.path);
+    std::unique_ptr<Texture> texture;
     if (bumpHeight == 0.0f)
     {
-        GetLogger()->debug("Loading texture: {}\n", name);
-        return LoadTextureFromFile(name, addressMode, mipMode, colorspace);
+        GetLogger()->debug("Loading texture: {}\n", key.path);
+        texture = LoadTextureFromFile(key.path, addressMode, mipMode, colorspace, key.reduction);
     }
+    else
+    {
+        GetLogger()->debug("Loading bump map: {}\n", key.path);
+        texture = LoadHeightMapFromFile(key.path, bumpHeight, addressMode, key.reduction);
+    }
+
+    if (texture == nullptr)
+        access.setFailed();
+    return texture;
+}
+
+
+std::unique_ptr<Image>
+TextureInfo::decode(const TextureKey& key) const
+{
+    celestia::util::FileAccessScope access("texture", key.path);
+    std::unique_ptr<Image> image;
+    if (bumpHeight == 0.0f)
+    {
+        GetLogger()->debug("Decoding texture: {}\n", key.path);
+        image = LoadTextureImage(key.path,
+                                 (flags & LinearColorspace) ? Texture::LinearColorspace : Texture::DefaultColorspace,
+                                 key.reduction);
+    }
+    else
+    {
+        GetLogger()->debug("Decoding bump map: {}\n", key.path);
+        image = LoadHeightMapImage(key.path, bumpHeight, getAddressMode(), key.reduction);
+    }
+
+    if (image == nullptr)
+        access.setFailed();
+    return image;
+}
+
+
+std::unique_ptr<Texture>
+TextureInfo::create(const TextureKey& key, std::unique_ptr<Image> img) const
+{
+    if (img == nullptr)
+    {
+        // Virtual textures only read a small description file, so they are
+        // loaded here
+        if (bumpHeight == 0.0f && DetermineFileType(key.path) == ContentType::CelestiaTexture)
+            return load(key);
+        return nullptr;
+    }
+
+    Texture::MipMapMode mipMode = Texture::DefaultMipMaps;
+    if (bumpHeight == 0.0f && (flags & NoMipMaps))
+        mipMode = Texture::NoMipMaps;
 
-    GetLogger()->debug("Loading bump map: {}\n", name);
-    return LoadHeightMapFromFile(name, bumpHeight, addressMode);
+    return CreateTextureFromFileImage(key.path, std::move(img), getAddressMode(), mipMode);
 }
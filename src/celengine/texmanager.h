@@ -10,6 +10,8 @@
 
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <tuple>
 
@@ -18,11 +20,25 @@
 #include "multitexture.h"
 #include "texture.h"
 
+// The file a texture is loaded from, and how many times its width and height
+// are halved while it is loaded
+struct TextureKey
+{
+    fs::path path;
+    std::int32_t reduction{ 0 };
+};
+
+inline bool operator<(const TextureKey& k0, const TextureKey& k1)
+{
+    return std::tie(k0.path, k0.reduction) < std::tie(k1.path, k1.reduction);
+}
+
 class TextureInfo
 {
 public:
     using ResourceType = Texture;
-    using ResourceKey = fs::path;
+    using ResourceKey = TextureKey;
+    using DecodedType = celestia::engine::Image;
 
     enum
     {
@@ -65,10 +81,22 @@ public:
         bumpHeight(0.0f),
         resolution(_resolution) {};
 
-    fs::path resolve(const fs::path&) const;
-    std::unique_ptr<Texture> load(const fs::path&) const;
+    // At low resolution, a texture which is only available in the medium or
+    // high resolution directory is loaded from there with a reduction,
+    // instead of at its full size.
+    TextureKey resolve(const fs::path&) const;
+    std::unique_ptr<Texture> load(const TextureKey&) const;
+
+    // load() split for background loading; decode doesn't need a GL context
+    std::unique_ptr<celestia::engine::Image> decode(const TextureKey&) const;
+    std::unique_ptr<Texture> create(const TextureKey&, std::unique_ptr<celestia::engine::Image>) const;
+
+    bool isHeightMap() const { return bumpHeight != 0.0f; }
 
 private:
+    Texture::AddressMode getAddressMode() const;
+    fs::path findFile(const fs::path& baseDir, std::size_t directory) const;
+
     fs::path source;
     fs::path path;
     unsigned int flags;
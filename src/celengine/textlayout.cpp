@@ -75,6 +75,11 @@ void TextLayout::setScreenDpi(int value)
     }
 }
 
+void TextLayout::setLineCache(TextLineCache *cache)
+{
+    lineCache = cache;
+}
+
 void TextLayout::setLayoutDirectionFollowTextAlignment(bool value)
 {
     if (layoutDirectionFollowTextAlignment != value)
@@ -131,45 +136,46 @@ void TextLayout::render(std::string_view text)
     if (!began)
         return;
 
-    std::vector<std::u16string> lines;
-    if (!processString(text, lines) || lines.empty())
+    std::vector<std::u16string> storage;
+    const std::vector<std::u16string>* lines = getLines(text, lineCache, storage);
+    if (lines == nullptr || lines->empty())
         return;
 
-    for (std::size_t i = 0; i < lines.size(); i += 1)
+    // The current line keeps its capacity, so that appending the lines to it
+    // doesn't allocate
+    for (std::size_t i = 0; i < lines->size(); i += 1)
     {
-        auto lineToRender = lines[i];
+        const std::u16string& line = (*lines)[i];
         if (i == 0)
         {
             // Combine the current line with the first line
             if (layoutDirectionFollowTextAlignment && horizontalAlignment == HorizontalAlignment::Right)
-            {
-                lineToRender += currentLine;
-            }
+                currentLine.insert(0, line);
             else
-            {
-                lineToRender = currentLine + lineToRender;
-            }
-            if (lines.size() == 1)
-            {
-                // This line is still continuing, clear line and do not render yet
-                currentLine = lineToRender;
-                lineToRender = {};
-            }
+                currentLine += line;
+
+            // This line is still continuing, do not render yet
+            if (lines->size() == 1)
+                continue;
+
+            if (!currentLine.empty())
+                renderLine(currentLine);
         }
         else
         {
             // Reset to line start, and go to the next line
             positionX = alignmentEdgeX;
             positionY -= static_cast<float>(font->getHeight());
-            if (i == lines.size() - 1)
+            if (i == lines->size() - 1)
+            {
+                // Last line (and size != 1), do not render yet
+                currentLine = line;
+            }
+            else if (!line.empty())
             {
-                // Last line (and size != 1), clear line do not render
-                currentLine = lines[i];
-                lineToRender = {};
+                renderLine(line);
             }
         }
-        if (!lineToRender.empty())
-            renderLine(lineToRender);
     }
 }
 
@@ -199,14 +205,18 @@ int TextLayout::getLineHeight() const
     return (font == nullptr) ? 0 : font->getHeight();
 }
 
-int TextLayout::getTextWidth(std::string_view text, const TextureFont *font)
+int TextLayout::getTextWidth(std::string_view text, const TextureFont *font, TextLineCache *cache)
 {
-    std::vector<std::u16string> lines;
-    if (font == nullptr || !processString(text, lines))
+    if (font == nullptr)
+        return 0;
+
+    std::vector<std::u16string> storage;
+    const std::vector<std::u16string>* lines = getLines(text, cache, storage);
+    if (lines == nullptr)
         return 0;
 
     int maxLineWidth = 0;
-    for (const auto& line : lines)
+    for (const auto& line : *lines)
         maxLineWidth = std::max(maxLineWidth, font->getWidth(line));
     return maxLineWidth;
 }
@@ -220,19 +230,25 @@ float TextLayout::getPixelSize(float size, Unit unit) const
 
 void TextLayout::renderLine(std::u16string_view line)
 {
+    // Lines drawn again are laid out once
+    const TextureFont::GlyphRun* run = lineCache == nullptr ? nullptr : &lineCache->getRun(line, *font);
+    auto getWidth = [this, line, run] { return run == nullptr ? font->getWidth(line) : run->width; };
+
     float x = positionX;
     switch (horizontalAlignment)
     {
     case HorizontalAlignment::Center:
-        x -= static_cast<float>(font->getWidth(line)) / 2.0f;
+        x -= static_cast<float>(getWidth()) / 2.0f;
         break;
     case HorizontalAlignment::Right:
-        x -= static_cast<float>(font->getWidth(line));
+        x -= static_cast<float>(getWidth());
         break;
     default:
         break;
     }
-    auto [newX, newY] = font->render(line, x, positionY);
+    auto [newX, newY] = run == nullptr
+        ? font->render(line, x, positionY)
+        : font->render(*run, x, positionY);
     if (layoutDirectionFollowTextAlignment && horizontalAlignment == HorizontalAlignment::Right)
     {
         positionX = x;
@@ -327,4 +343,85 @@ bool TextLayout::processString(std::string_view input, std::vector<std::u16strin
     return true;
 }
 
+const std::vector<std::u16string>* TextLayout::getLines(std::string_view input,
+                                                        TextLineCache *cache,
+                                                        std::vector<std::u16string> &storage)
+{
+    if (cache != nullptr)
+        return cache->get(input);
+
+    return processString(input, storage) ? &storage : nullptr;
+}
+
+const std::vector<std::u16string>* TextLineCache::get(std::string_view text)
+{
+    auto it = entries.find(text);
+    if (it == entries.end())
+    {
+        auto entry = std::make_unique<Entry>();
+        entry->text = text;
+        entry->valid = TextLayout::processString(entry->text, entry->lines);
+        std::string_view key = entry->text;
+        it = entries.try_emplace(key, std::move(entry)).first;
+    }
+
+    Entry& entry = *it->second;
+    entry.lastUsed = frame;
+    return entry.valid ? &entry.lines : nullptr;
+}
+
+const TextureFont::GlyphRun& TextLineCache::getRun(std::u16string_view line, const TextureFont &font)
+{
+    RunMap& fontRuns = runs[&font];
+    auto it = fontRuns.find(line);
+    if (it == fontRuns.end())
+    {
+        auto entry = std::make_unique<RunEntry>();
+        entry->line = line;
+        std::u16string_view key = entry->line;
+        it = fontRuns.try_emplace(key, std::move(entry)).first;
+    }
+
+    RunEntry& entry = *it->second;
+    entry.lastUsed = frame;
+    // The glyphs move when the atlas of the font is rebuilt
+    if (!font.isLaidOut(entry.run))
+        font.layout(entry.line, entry.run);
+    return entry.run;
+}
+
+void TextLineCache::nextFrame()
+{
+    ++frame;
+    // Only look for the unused entries once in a while
+    if (frame % MaxUnusedFrames != 0)
+        return;
+
+    auto isUnused = [this](const auto &item) { return frame - item.second->lastUsed > MaxUnusedFrames; };
+    for (auto it = entries.begin(); it != entries.end();)
+    {
+        if (isUnused(*it))
+            it = entries.erase(it);
+        else
+            ++it;
+    }
+
+    for (auto fontIt = runs.begin(); fontIt != runs.end();)
+    {
+        RunMap& fontRuns = fontIt->second;
+        for (auto it = fontRuns.begin(); it != fontRuns.end();)
+        {
+            if (isUnused(*it))
+                it = fontRuns.erase(it);
+            else
+                ++it;
+        }
+
+        if (fontRuns.empty())
+            fontIt = runs.erase(fontIt);
+        else
+            ++fontIt;
+    }
+}
+
 }
@@ -9,9 +9,11 @@
 
 #pragma once
 
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <string_view>
+#include <unordered_map>
 #include <vector>
 
 #include <Eigen/Core>
@@ -20,6 +22,9 @@
 
 namespace celestia::engine
 {
+
+class TextLineCache;
+
 /**
  * \class TextLayout textlayout.h celengine/textlayout.h
  *
@@ -62,6 +67,8 @@ class TextLayout
     void setFont(const std::shared_ptr<TextureFont>&);
     void setHorizontalAlignment(HorizontalAlignment);
     void setScreenDpi(int);
+    /// Sets the cache of converted texts used by render, or nullptr to convert them every time
+    void setLineCache(TextLineCache*);
 
     /// Sets whether text layout direction follows the specified text alignment, is useful for
     /// distinguishing between (LTR + Right Aligned) vs (RTL)
@@ -107,11 +114,12 @@ class TextLayout
     /// @param text string to calculate width with
     /// @param font font to calculate width with
     /// @return the max width of all the lines in the text in the desired font
-    static int getTextWidth(std::string_view text, const TextureFont *font);
+    static int getTextWidth(std::string_view text, const TextureFont *font, TextLineCache *cache = nullptr);
 
  private:
     float screenDpi;
     std::shared_ptr<TextureFont> font;
+    TextLineCache* lineCache{ nullptr };
 
     HorizontalAlignment horizontalAlignment;
 
@@ -132,6 +140,66 @@ class TextLayout
     void flushInternal(bool flushFont);
 
     static bool processString(std::string_view input, std::vector<std::u16string> &output);
+    static const std::vector<std::u16string>* getLines(std::string_view input,
+                                                       TextLineCache *cache,
+                                                       std::vector<std::u16string> &storage);
+
+    friend class TextLineCache;
+};
+
+/**
+ * \class TextLineCache textlayout.h celengine/textlayout.h
+ *
+ * @brief Texts converted to the UTF-16 lines drawn by TextureFont
+ *
+ * Texts drawn in every frame, such as labels, are only converted and shaped
+ * once, and their lines only laid out into glyphs once per font. The texts
+ * which have not been used for a while are evicted.
+ */
+class TextLineCache
+{
+ public:
+    /// Number of frames after which unused texts are evicted
+    static constexpr std::uint32_t MaxUnusedFrames = 64;
+
+    /// Get the lines of the text
+    /// @param text the text to convert
+    /// @return the lines, or nullptr if the text isn't valid UTF-8
+    const std::vector<std::u16string>* get(std::string_view text);
+
+    /// Get the glyphs of a line laid out with the font
+    /// @param line the line to lay out
+    /// @param font the font to lay out the line with
+    /// @return the glyphs, valid until the next call
+    const TextureFont::GlyphRun& getRun(std::u16string_view line, const TextureFont &font);
+
+    /// Start a new frame, evicting the texts unused for MaxUnusedFrames
+    void nextFrame();
+
+    std::size_t size() const { return entries.size(); }
+
+ private:
+    struct Entry
+    {
+        std::string text;
+        std::vector<std::u16string> lines;
+        bool valid;
+        std::uint32_t lastUsed;
+    };
+
+    struct RunEntry
+    {
+        std::u16string line;
+        TextureFont::GlyphRun run;
+        std::uint32_t lastUsed;
+    };
+
+    using RunMap = std::unordered_map<std::u16string_view, std::unique_ptr<RunEntry>>;
+
+    // The keys are views of the texts of the entries
+    std::unordered_map<std::string_view, std::unique_ptr<Entry>> entries;
+    std::unordered_map<const TextureFont*, RunMap> runs;
+    std::uint32_t frame{ 0 };
 };
 
 }
@@ -10,8 +10,11 @@
 #include <algorithm>
 #include <array>
 #include <cassert>
+#include <cstdint>
 #include <cstdlib>
 #include <cmath>
+#include <cstring>
+#include <utility>
 
 #include <Eigen/Core>
 #include "glsupport.h"
@@ -21,6 +24,7 @@
 #include <celutil/logger.h>
 #include "framebuffer.h"
 #include "texture.h"
+#include "texturecache.h"
 #include "virtualtex.h"
 
 
@@ -28,10 +32,16 @@ using namespace celestia;
 using celestia::util::GetLogger;
 using celestia::engine::Image;
 using celestia::engine::PixelFormat;
+using celestia::engine::TextureCache;
 
 namespace
 {
 
+// Uncompressed images from this size are uploaded in bands of rows of about
+// UploadBandSize when they are loaded in the background
+constexpr std::size_t StagedUploadThreshold = 16U * 1024U * 1024U;
+constexpr std::size_t UploadBandSize = 4U * 1024U * 1024U;
+
 struct TextureCaps
 {
     GLint preferredAnisotropy;
@@ -226,6 +236,22 @@ SetBorderColor(Color borderColor, GLenum target)
 #endif
 }
 
+void
+SetImageTextureParameters(Texture::AddressMode addressMode, bool mipmap)
+{
+    GLenum texAddress = GetGLTexAddressMode(addressMode);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, texAddress);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, texAddress);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                    mipmap ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+
+    if (gl::EXT_texture_filter_anisotropic && GetTextureCaps().preferredAnisotropy > 1)
+    {
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, GetTextureCaps().preferredAnisotropy);
+    }
+}
+
 // Load a prebuilt set of mipmaps; assumes that the image contains
 // a complete set of mipmap levels.
 void
@@ -295,6 +321,19 @@ LoadMiplessTexture(const Image& img, GLenum target)
 }
 
 
+// Size of the image in graphics memory, including the mip levels which are
+// generated by the driver
+std::size_t
+EstimateMemoryUsage(const Image& img, bool mipmap, bool precomputedMipMaps)
+{
+    if (mipmap && precomputedMipMaps)
+        return static_cast<std::size_t>(img.getSize());
+
+    auto size = static_cast<std::size_t>(img.getMipLevelSize(0));
+    return mipmap ? size + size / 3 : size;
+}
+
+
 int
 ilog2(unsigned int x)
 {
@@ -376,6 +415,153 @@ CreateTextureFromImage(const Image& img,
     return tex;
 }
 
+// Set before loading starts, then only read from the loading threads
+std::unique_ptr<TextureCache> textureCache = nullptr;
+
+bool
+IsTranscodable(ContentType type)
+{
+    if (textureCache == nullptr)
+        return false;
+
+    switch (type)
+    {
+    case ContentType::JPEG:
+    case ContentType::BMP:
+    case ContentType::PNG:
+#ifdef USE_LIBAVIF
+    case ContentType::AVIF:
+#endif
+        return true;
+    default:
+        return false;
+    }
+}
+
+std::unique_ptr<Image>
+LoadTranscodedImage(const TextureCache& cache, const fs::path& filename, std::int32_t reduction)
+{
+    if (auto img = cache.load(filename, reduction); img != nullptr)
+        return img;
+
+    auto img = Image::load(filename, reduction);
+    if (img == nullptr)
+        return nullptr;
+
+    // Formats other than RGB and RGBA are used as they are
+    auto compressed = img->compressDXT();
+    if (compressed == nullptr)
+        return img;
+
+    if (!cache.save(filename, *compressed, reduction))
+        GetLogger()->warn("Unable to cache the compressed image of {}\n", filename);
+
+    return compressed;
+}
+
+// Replaces the indices of a compressed block by those of one of its columns
+// or rows, -1 keeping them, so that the block repeats the edge of a tile
+template<int Bits, int Bytes>
+void
+ClampBlockIndices(std::uint8_t* indices, int column, int row)
+{
+    std::uint64_t in = 0;
+    for (int i = 0; i < Bytes; ++i)
+        in |= static_cast<std::uint64_t>(indices[i]) << (8 * i);
+
+    constexpr std::uint64_t mask = (UINT64_C(1) << Bits) - 1;
+    std::uint64_t out = 0;
+    for (int y = 0; y < 4; ++y)
+    {
+        for (int x = 0; x < 4; ++x)
+        {
+            int src = (row < 0 ? y : row) * 4 + (column < 0 ? x : column);
+            out |= ((in >> (Bits * src)) & mask) << (Bits * (y * 4 + x));
+        }
+    }
+
+    for (int i = 0; i < Bytes; ++i)
+        indices[i] = static_cast<std::uint8_t>(out >> (8 * i));
+}
+
+void
+ClampBlock(PixelFormat format, std::uint8_t* block, int column, int row)
+{
+    switch (format)
+    {
+    case PixelFormat::DXT1:
+    case PixelFormat::DXT1_sRGBA:
+        ClampBlockIndices<2, 4>(block + 4, column, row);
+        break;
+    case PixelFormat::DXT3:
+    case PixelFormat::DXT3_sRGBA:
+        ClampBlockIndices<4, 8>(block, column, row);
+        ClampBlockIndices<2, 4>(block + 12, column, row);
+        break;
+    case PixelFormat::DXT5:
+    case PixelFormat::DXT5_sRGBA:
+        ClampBlockIndices<3, 6>(block + 2, column, row);
+        ClampBlockIndices<2, 4>(block + 12, column, row);
+        break;
+    default:
+        break;
+    }
+}
+
+// Copies the tile to the slot image, which is larger by the border on each
+// side, and fills the border with the edges of the tile
+void
+CopyTileToSlot(const Image& tile, Image& slot, int border)
+{
+    int tileSize = tile.getWidth();
+    if (tile.isCompressed())
+    {
+        int blockSize = getCompressedBlockSize(tile.getFormat());
+        int tileBlocks = tileSize / 4;
+        int borderBlocks = border / 4;
+        int slotBlocks = tileBlocks + 2 * borderBlocks;
+        for (int by = 0; by < slotBlocks; ++by)
+        {
+            int sy = std::clamp(by - borderBlocks, 0, tileBlocks - 1);
+            int row = by < borderBlocks ? 0 : (by >= borderBlocks + tileBlocks ? 3 : -1);
+            for (int bx = 0; bx < slotBlocks; ++bx)
+            {
+                int sx = std::clamp(bx - borderBlocks, 0, tileBlocks - 1);
+                int column = bx < borderBlocks ? 0 : (bx >= borderBlocks + tileBlocks ? 3 : -1);
+                std::uint8_t* block = slot.getPixels() + (by * slotBlocks + bx) * blockSize;
+                std::memcpy(block, tile.getPixels() + (sy * tileBlocks + sx) * blockSize, blockSize);
+                if (row >= 0 || column >= 0)
+                    ClampBlock(tile.getFormat(), block, column, row);
+            }
+        }
+        return;
+    }
+
+    int components = tile.getComponents();
+    int slotSize = slot.getWidth();
+    for (int y = 0; y < slotSize; ++y)
+    {
+        int sy = std::clamp(y - border, 0, tileSize - 1);
+        const std::uint8_t* src = tile.getPixels() + sy * tile.getPitch();
+        std::uint8_t* dst = slot.getPixelRow(y);
+        for (int x = 0; x < border; ++x)
+        {
+            std::memcpy(dst + x * components, src, components);
+            std::memcpy(dst + (border + tileSize + x) * components,
+                        src + (tileSize - 1) * components,
+                        components);
+        }
+        std::memcpy(dst + border * components, src, tileSize * components);
+    }
+}
+
+// Side of the atlas textures
+int
+GetAtlasSize()
+{
+    return std::min(4096, static_cast<int>(gl::maxTextureSize));
+}
+
 }
 
 Texture::Texture(int w, int h, int d) :
@@ -472,17 +658,7 @@ ImageTexture::ImageTexture(const Image& img,
         mipmap = false;
     }
 
-    GLenum texAddress = GetGLTexAddressMode(addressMode);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, texAddress);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, texAddress);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
-                    mipmap ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
-
-    if (gl::EXT_texture_filter_anisotropic && GetTextureCaps().preferredAnisotropy > 1)
-    {
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, GetTextureCaps().preferredAnisotropy);
-    }
+    SetImageTextureParameters(addressMode, mipmap);
 
     bool genMipmaps = mipmap && !precomputedMipMaps;
 
@@ -512,6 +688,69 @@ ImageTexture::ImageTexture(const Image& img,
 
     alpha = img.hasAlpha();
     compressed = img.isCompressed();
+    memoryUsage = EstimateMemoryUsage(img, mipmap, precomputedMipMaps);
+}
+
+
+struct ImageTexture::StagedUpload
+{
+    explicit StagedUpload(std::unique_ptr<Image>&& _image) : image(std::move(_image)) {}
+    ~StagedUpload()
+    {
+#ifndef GL_ES
+        if (pbo != 0)
+            glDeleteBuffers(1, &pbo);
+#endif
+    }
+
+    std::unique_ptr<Image> image;
+    int nextRow{ 0 };
+    int bandRows{ 1 };
+    bool genMipmaps{ false };
+    // Pixel buffer the bands are copied to, so that the driver can transfer
+    // them while the frame is drawn
+    GLuint pbo{ 0 };
+};
+
+
+ImageTexture::ImageTexture(std::unique_ptr<Image> img,
+                           AddressMode addressMode,
+                           MipMapMode mipMapMode) :
+    Texture(img->getWidth(), img->getHeight()),
+    glName(0)
+{
+    assert(!img->isCompressed() && img->getMipLevelCount() == 1);
+
+    glGenTextures(1, &glName);
+    glBindTexture(GL_TEXTURE_2D, glName);
+
+    bool mipmap = mipMapMode != NoMipMaps;
+    SetImageTextureParameters(addressMode, mipmap);
+
+    // Only the storage of the base level is allocated here
+    glTexImage2D(GL_TEXTURE_2D,
+                 0,
+                 getInternalFormat(img->getFormat()),
+                 img->getWidth(), img->getHeight(),
+                 0,
+                 getExternalFormat(img->getFormat()),
+                 GL_UNSIGNED_BYTE,
+                 nullptr);
+#ifndef GL_ES
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL,
+                    mipmap ? CalcMipLevelCount(img->getWidth(), img->getHeight()) - 1 : 0);
+#endif
+
+    alpha = img->hasAlpha();
+    compressed = false;
+    memoryUsage = EstimateMemoryUsage(*img, mipmap, false);
+
+    staged = std::make_unique<StagedUpload>(std::move(img));
+    staged->genMipmaps = mipmap;
+    staged->bandRows = std::max(1, static_cast<int>(UploadBandSize / static_cast<std::size_t>(staged->image->getPitch())));
+#ifndef GL_ES
+    glGenBuffers(1, &staged->pbo);
+#endif
 }
 
 
@@ -522,6 +761,71 @@ ImageTexture::~ImageTexture()
 }
 
 
+void ImageTexture::updateRows(const Image& img, int firstRow, int rowCount)
+{
+    assert(!img.isCompressed() && img.getWidth() == getWidth() && img.getHeight() == getHeight());
+
+    glBindTexture(GL_TEXTURE_2D, glName);
+    glTexSubImage2D(GL_TEXTURE_2D,
+                    0,
+                    0, firstRow,
+                    img.getWidth(), rowCount,
+                    getExternalFormat(img.getFormat()),
+                    GL_UNSIGNED_BYTE,
+                    img.getPixels() + static_cast<std::size_t>(firstRow) * static_cast<std::size_t>(img.getPitch()));
+}
+
+
+bool ImageTexture::upload(std::chrono::steady_clock::time_point deadline)
+{
+    if (staged == nullptr)
+        return true;
+
+    Image& img = *staged->image;
+    glBindTexture(GL_TEXTURE_2D, glName);
+    do
+    {
+        int rows = std::min(staged->bandRows, img.getHeight() - staged->nextRow);
+        const std::uint8_t* pixels = img.getPixelRow(staged->nextRow);
+#ifndef GL_ES
+        auto size = static_cast<GLsizeiptr>(rows) * img.getPitch();
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, staged->pbo);
+        // Orphan the previous band, which may still be in transfer
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+        if (void* buffer = glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY); buffer != nullptr)
+        {
+            std::memcpy(buffer, pixels, static_cast<std::size_t>(size));
+            if (glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) == GL_TRUE)
+                pixels = nullptr;
+        }
+        if (pixels != nullptr)
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+#endif
+        glTexSubImage2D(GL_TEXTURE_2D,
+                        0,
+                        0, staged->nextRow,
+                        img.getWidth(), rows,
+                        getExternalFormat(img.getFormat()),
+                        GL_UNSIGNED_BYTE,
+                        pixels);
+#ifndef GL_ES
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+#endif
+        staged->nextRow += rows;
+    }
+    while (staged->nextRow < img.getHeight() && std::chrono::steady_clock::now() < deadline);
+
+    if (staged->nextRow < img.getHeight())
+        return false;
+
+    if (staged->genMipmaps)
+        glGenerateMipmap(GL_TEXTURE_2D);
+
+    staged = nullptr;
+    return true;
+}
+
+
 void ImageTexture::bind()
 {
     glBindTexture(GL_TEXTURE_2D, glName);
@@ -584,6 +888,8 @@ TiledTexture::TiledTexture(const Image& img,
     if (!precomputedMipMaps && img.isCompressed())
         mipmap = false;
 
+    memoryUsage = EstimateMemoryUsage(img, mipmap, precomputedMipMaps);
+
     GLenum texAddress = GetGLTexAddressMode(EdgeClamp);
     int components = img.getComponents();
 
@@ -802,6 +1108,8 @@ CubeMap::CubeMap(celestia::util::array_view<const Image*> faces) :
     }
     if (genMipmaps)
         glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+
+    memoryUsage = EstimateMemoryUsage(*faces[0], mipmap, precomputedMipMaps) * 6;
 }
 
 
@@ -835,6 +1143,118 @@ void CubeMap::setBorderColor(Color borderColor)
 
 
 
+TileAtlas::TileAtlas(PixelFormat _format, int _tileSize) :
+    format(_format),
+    tileSize(_tileSize),
+    slotSize(_tileSize + 2 * Border),
+    size(GetAtlasSize())
+{
+    slotsPerRow = size / slotSize;
+    int slotCount = slotsPerRow * slotsPerRow;
+    freeSlots.reserve(slotCount);
+    for (int slot = slotCount - 1; slot >= 0; --slot)
+        freeSlots.push_back(slot);
+
+    // Compressed textures can't be created without data
+    Image img(format, size, size);
+    slotMemory = static_cast<std::size_t>(img.getMipLevelSize(0)) * slotSize * slotSize
+               / (static_cast<std::size_t>(size) * size);
+
+    glGenTextures(1, &glName);
+    glBindTexture(GL_TEXTURE_2D, glName);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    LoadMiplessTexture(img, GL_TEXTURE_2D);
+#ifndef GL_ES
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+#endif
+}
+
+
+TileAtlas::~TileAtlas()
+{
+    if (glName != 0)
+        glDeleteTextures(1, &glName);
+}
+
+
+bool TileAtlas::isSupported(PixelFormat format, int tileSize)
+{
+    if (getInternalFormat(format) == GL_NONE || tileSize <= 0)
+        return false;
+
+    Image probe(format, 1, 1);
+    if (probe.isCompressed() && tileSize % 4 != 0)
+        return false;
+
+    return GetAtlasSize() / (tileSize + 2 * Border) >= 2;
+}
+
+
+bool TileAtlas::accepts(const Image& img) const
+{
+    return img.getFormat() == format &&
+           img.getWidth() == tileSize &&
+           img.getHeight() == tileSize;
+}
+
+
+int TileAtlas::insert(const Image& img)
+{
+    if (!accepts(img) || freeSlots.empty())
+        return -1;
+
+    Image slotImage(format, slotSize, slotSize);
+    CopyTileToSlot(img, slotImage, Border);
+
+    int slot = freeSlots.back();
+    int x = (slot % slotsPerRow) * slotSize;
+    int y = (slot / slotsPerRow) * slotSize;
+
+    glBindTexture(GL_TEXTURE_2D, glName);
+    if (slotImage.isCompressed())
+    {
+        glCompressedTexSubImage2D(GL_TEXTURE_2D, 0,
+                                  x, y, slotSize, slotSize,
+                                  getInternalFormat(format),
+                                  slotImage.getMipLevelSize(0),
+                                  slotImage.getPixels());
+    }
+    else
+    {
+        glTexSubImage2D(GL_TEXTURE_2D, 0,
+                        x, y, slotSize, slotSize,
+                        getExternalFormat(format),
+                        GL_UNSIGNED_BYTE,
+                        slotImage.getPixels());
+    }
+
+    freeSlots.pop_back();
+    ++usedSlots;
+    return slot;
+}
+
+
+void TileAtlas::remove(int slot)
+{
+    assert(slot >= 0 && slot < slotsPerRow * slotsPerRow);
+    freeSlots.push_back(slot);
+    --usedSlots;
+}
+
+
+TextureTile TileAtlas::getTile(int slot, float u, float v, float du, float dv) const
+{
+    auto scale = static_cast<float>(tileSize) / static_cast<float>(size);
+    auto slotU = static_cast<float>((slot % slotsPerRow) * slotSize + Border) / static_cast<float>(size);
+    auto slotV = static_cast<float>((slot / slotsPerRow) * slotSize + Border) / static_cast<float>(size);
+    return TextureTile(glName, slotU + u * scale, slotV + v * scale, du * scale, dv * scale);
+}
+
+
+
 std::unique_ptr<Texture>
 CreateProceduralTexture(int width, int height,
                         PixelFormat format,
@@ -918,32 +1338,109 @@ std::unique_ptr<Texture>
 LoadTextureFromFile(const fs::path& filename,
                     Texture::AddressMode addressMode,
                     Texture::MipMapMode mipMode,
-                    Texture::Colorspace colorspace)
+                    Texture::Colorspace colorspace,
+                    std::int32_t reduction)
 {
     // Check for a Celestia texture--these need to be handled specially.
-    ContentType contentType = DetermineFileType(filename);
-
-    if (contentType == ContentType::CelestiaTexture)
+    if (DetermineFileType(filename) == ContentType::CelestiaTexture)
         return LoadVirtualTexture(filename);
 
     // All other texture types are handled by first loading an image, then
     // creating a texture from that image.
-    std::unique_ptr<Image> img = Image::load(filename);
+    std::unique_ptr<Image> img = LoadTextureImage(filename, colorspace, reduction);
+    if (img == nullptr)
+        return nullptr;
+
+    return CreateTextureFromFileImage(filename, *img, addressMode, mipMode);
+}
+
+
+// Load a height map texture from a file and convert it to a normal map.
+std::unique_ptr<Texture>
+LoadHeightMapFromFile(const fs::path& filename,
+                      float height,
+                      Texture::AddressMode addressMode,
+                      std::int32_t reduction)
+{
+    auto normalMap = LoadHeightMapImage(filename, height, addressMode, reduction);
+    if (normalMap == nullptr)
+        return nullptr;
+
+    return CreateTextureFromImage(*normalMap, addressMode, Texture::DefaultMipMaps);
+}
+
+
+void
+SetTextureTranscodeDirectory(const fs::path& directory)
+{
+#ifdef GL_ES
+    bool supported = false;
+#else
+    bool supported = gl::EXT_texture_compression_s3tc;
+#endif
+    if (directory.empty() || !supported)
+        textureCache = nullptr;
+    else
+        textureCache = std::make_unique<TextureCache>(directory);
+}
+
+
+std::unique_ptr<Image>
+LoadTextureImage(const fs::path& filename, Texture::Colorspace colorspace, std::int32_t reduction)
+{
+    ContentType type = DetermineFileType(filename);
+    if (type == ContentType::CelestiaTexture)
+        return nullptr;
+
+    std::unique_ptr<Image> img = IsTranscodable(type)
+        ? LoadTranscodedImage(*textureCache, filename, reduction)
+        : Image::load(filename, reduction);
     if (img == nullptr)
         return nullptr;
 
     if (colorspace == Texture::LinearColorspace)
         img->forceLinear();
 
-    std::unique_ptr<Texture> tex = CreateTextureFromImage(*img, addressMode, mipMode);
+    return img;
+}
+
+
+std::unique_ptr<Image>
+LoadHeightMapImage(const fs::path& filename,
+                   float height,
+                   Texture::AddressMode addressMode,
+                   std::int32_t reduction)
+{
+    auto img = Image::load(filename, reduction);
+    if (img == nullptr)
+        return nullptr;
+
+    img->forceLinear();
+
+    // The height differences between neighbouring texels grow with each
+    // reduction, so the bumps are scaled to keep the same slopes
+    if (reduction > 0)
+        height /= static_cast<float>(1 << reduction);
+
+    return img->computeNormalMap(height, addressMode == Texture::Wrap);
+}
+
 
-    if (contentType == ContentType::DXT5NormalMap)
+std::unique_ptr<Texture>
+CreateTextureFromFileImage(const fs::path& filename,
+                           const Image& img,
+                           Texture::AddressMode addressMode,
+                           Texture::MipMapMode mipMode)
+{
+    std::unique_ptr<Texture> tex = CreateTextureFromImage(img, addressMode, mipMode);
+
+    if (tex != nullptr && DetermineFileType(filename) == ContentType::DXT5NormalMap)
     {
         // If the texture came from a .dxt5nm file then mark it as a dxt5
         // compressed normal map. There's no separate OpenGL format for dxt5
         // normal maps, so the file extension is the only thing that
         // distinguishes it from a plain old dxt5 texture.
-        if (img->getFormat() == PixelFormat::DXT5)
+        if (img.getFormat() == PixelFormat::DXT5)
         {
             tex->setFormatOptions(Texture::DXT5NormalMap);
         }
@@ -953,21 +1450,24 @@ LoadTextureFromFile(const fs::path& filename,
 }
 
 
-// Load a height map texture from a file and convert it to a normal map.
 std::unique_ptr<Texture>
-LoadHeightMapFromFile(const fs::path& filename,
-                      float height,
-                      Texture::AddressMode addressMode)
+CreateTextureFromFileImage(const fs::path& filename,
+                           std::unique_ptr<Image> img,
+                           Texture::AddressMode addressMode,
+                           Texture::MipMapMode mipMode)
 {
-    auto img = Image::load(filename);
-    if (img == nullptr)
-        return nullptr;
-
-    img->forceLinear();
-
-    auto normalMap = img->computeNormalMap(height, addressMode == Texture::Wrap);
-    if (normalMap == nullptr)
-        return nullptr;
+    // Images with mip levels of their own are rare enough to be uploaded at
+    // once, as are compressed ones, which are a fraction of the size
+    if (img->isCompressed() ||
+        img->getMipLevelCount() != 1 ||
+        static_cast<std::size_t>(img->getSize()) < StagedUploadThreshold ||
+        img->getWidth() > gl::maxTextureSize ||
+        img->getHeight() > gl::maxTextureSize)
+    {
+        return CreateTextureFromFileImage(filename, *img, addressMode, mipMode);
+    }
 
-    return CreateTextureFromImage(*normalMap, addressMode, Texture::DefaultMipMaps);
+    GetLogger()->info(_("Creating texture uploaded in parts: {}x{}\n"),
+                      img->getWidth(), img->getHeight());
+    return std::make_unique<ImageTexture>(std::move(img), addressMode, mipMode);
 }
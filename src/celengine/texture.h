@@ -10,9 +10,12 @@
 
 #pragma once
 
+#include <chrono>
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include <celcompat/filesystem.h>
 #include <celimage/image.h>
@@ -69,6 +72,14 @@ class Texture
 
     virtual void setBorderColor(Color);
 
+    // Approximate size of the texture in graphics memory, in bytes
+    virtual std::size_t getMemoryUsage() const { return memoryUsage; }
+
+    // Textures which are uploaded in parts continue the upload until the
+    // deadline, with at least one part per call, and return true once they
+    // are complete. They must not be drawn before then.
+    virtual bool upload(std::chrono::steady_clock::time_point /*deadline*/) { return true; }
+
     int getWidth() const;
     int getHeight() const;
     int getDepth() const;
@@ -115,6 +126,7 @@ class Texture
  protected:
     bool alpha{ false };
     bool compressed{ false };
+    std::size_t memoryUsage{ 0 };
 
  private:
     int width;
@@ -129,16 +141,28 @@ class ImageTexture : public Texture
 {
  public:
     ImageTexture(const celestia::engine::Image& img, AddressMode, MipMapMode);
+    // Keeps the image, which must be uncompressed and without mip levels,
+    // and uploads it in bands of rows by upload(). The mip levels are
+    // generated on the GPU once the base level is complete.
+    ImageTexture(std::unique_ptr<celestia::engine::Image> img, AddressMode, MipMapMode);
     ~ImageTexture();
 
     TextureTile getTile(int lod, int u, int v) override;
     void bind() override;
     void setBorderColor(Color) override;
+    bool upload(std::chrono::steady_clock::time_point deadline) override;
+
+    // Replace rows of the base level with those of an uncompressed image of
+    // the size and format of the texture, for textures without mip levels
+    void updateRows(const celestia::engine::Image& img, int firstRow, int rowCount);
 
     unsigned int getName() const;
 
  private:
+    struct StagedUpload;
+
     unsigned int glName;
+    std::unique_ptr<StagedUpload> staged;
 };
 
 
@@ -177,6 +201,55 @@ class CubeMap : public Texture
 };
 
 
+// Tiles of the same size and format kept in one texture, so that drawing
+// neighbouring tiles doesn't change the bound texture. Each slot has a border
+// filled with the edge texels of its tile, which keeps linear filtering from
+// reading the neighbouring slots. Tiles have no mipmaps in the atlas.
+class TileAtlas
+{
+ public:
+    // One block of the compressed formats
+    static constexpr int Border = 4;
+
+    TileAtlas(celestia::engine::PixelFormat format, int tileSize);
+    ~TileAtlas();
+
+    TileAtlas(const TileAtlas&) = delete;
+    TileAtlas& operator=(const TileAtlas&) = delete;
+
+    // Whether tiles of the format and size fit in an atlas with at least
+    // four slots
+    static bool isSupported(celestia::engine::PixelFormat format, int tileSize);
+
+    // Square tiles of the size and format of the atlas, using level 0
+    bool accepts(const celestia::engine::Image&) const;
+
+    // Returns the slot the tile is stored in, or -1 if the atlas is full
+    int insert(const celestia::engine::Image&);
+    void remove(int slot);
+
+    bool empty() const { return usedSlots == 0; }
+    bool full() const { return freeSlots.empty(); }
+
+    // Graphics memory taken by one slot
+    std::size_t getSlotMemoryUsage() const { return slotMemory; }
+
+    // The part u, v, du, dv of the tile in the slot
+    TextureTile getTile(int slot, float u, float v, float du, float dv) const;
+
+ private:
+    unsigned int glName{ 0 };
+    celestia::engine::PixelFormat format;
+    int tileSize;
+    int slotSize;
+    int slotsPerRow;
+    int size;
+    std::size_t slotMemory{ 0 };
+    int usedSlots{ 0 };
+    std::vector<int> freeSlots;
+};
+
+
 std::unique_ptr<Texture>
 CreateProceduralTexture(int width, int height,
                         celestia::engine::PixelFormat format,
@@ -199,9 +272,49 @@ std::unique_ptr<Texture>
 LoadTextureFromFile(const fs::path& filename,
                     Texture::AddressMode addressMode = Texture::EdgeClamp,
                     Texture::MipMapMode mipMode = Texture::DefaultMipMaps,
-                    Texture::Colorspace colorspace = Texture::DefaultColorspace);
+                    Texture::Colorspace colorspace = Texture::DefaultColorspace,
+                    std::int32_t reduction = 0);
 
 std::unique_ptr<Texture>
 LoadHeightMapFromFile(const fs::path& filename,
                       float height,
-                      Texture::AddressMode addressMode = Texture::EdgeClamp);
+                      Texture::AddressMode addressMode = Texture::EdgeClamp,
+                      std::int32_t reduction = 0);
+
+// Compress the uncompressed images loaded by LoadTextureImage to DXT and keep
+// them in the directory, so that the compressed image is loaded directly the
+// next time. Call before any texture is loaded; an empty path disables
+// transcoding, as does a driver without S3TC support.
+void
+SetTextureTranscodeDirectory(const fs::path& directory);
+
+// The loading functions above in two steps, so that the image can be decoded
+// on another thread than the one owning the GL context. LoadTextureImage
+// returns nullptr for virtual textures, which only LoadTextureFromFile loads.
+// A reduction halves the width and height of the image that many times, see
+// Image::load; virtual textures ignore it.
+std::unique_ptr<celestia::engine::Image>
+LoadTextureImage(const fs::path& filename,
+                 Texture::Colorspace colorspace = Texture::DefaultColorspace,
+                 std::int32_t reduction = 0);
+
+// Returns the normal map computed from the height map
+std::unique_ptr<celestia::engine::Image>
+LoadHeightMapImage(const fs::path& filename,
+                   float height,
+                   Texture::AddressMode addressMode = Texture::EdgeClamp,
+                   std::int32_t reduction = 0);
+
+std::unique_ptr<Texture>
+CreateTextureFromFileImage(const fs::path& filename,
+                           const celestia::engine::Image& img,
+                           Texture::AddressMode addressMode = Texture::EdgeClamp,
+                           Texture::MipMapMode mipMode = Texture::DefaultMipMaps);
+
+// Large uncompressed images are uploaded in parts, so the texture returned
+// must be completed by Texture::upload before it is drawn
+std::unique_ptr<Texture>
+CreateTextureFromFileImage(const fs::path& filename,
+                           std::unique_ptr<celestia::engine::Image> img,
+                           Texture::AddressMode addressMode = Texture::EdgeClamp,
+                           Texture::MipMapMode mipMode = Texture::DefaultMipMaps);
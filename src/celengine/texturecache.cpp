@@ -0,0 +1,185 @@
+// texturecache.cpp
+//
+// Copyright (C) 2024, Celestia Development Team
+//
+// On-disk cache of texture images transcoded to a compressed format.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include "texturecache.h"
+
+#include <fstream>
+#include <system_error>
+
+#include <fmt/format.h>
+
+#include <celimage/image.h>
+#include <celutil/atomicfile.h>
+#include <celutil/binaryread.h>
+#include <celutil/binarywrite.h>
+#include <celutil/hash.h>
+
+namespace celestia::engine
+{
+
+namespace
+{
+
+constexpr std::uint32_t MaxMipLevels = 32;
+
+bool
+IsCacheableFormat(PixelFormat format)
+{
+    switch (format)
+    {
+    case PixelFormat::DXT1:
+    case PixelFormat::DXT3:
+    case PixelFormat::DXT5:
+    case PixelFormat::DXT1_sRGBA:
+    case PixelFormat::DXT3_sRGBA:
+    case PixelFormat::DXT5_sRGBA:
+        return true;
+    default:
+        return false;
+    }
+}
+
+} // end unnamed namespace
+
+TextureCache::TextureCache(const fs::path& directory) :
+    m_directory(directory)
+{
+}
+
+std::optional<std::string>
+TextureCache::getSourceId(const fs::path& source, std::int32_t reduction)
+{
+    std::error_code ec;
+    fs::path path = source.is_absolute() ? source : fs::current_path(ec) / source;
+    if (ec)
+        return std::nullopt;
+
+    std::uintmax_t size = fs::file_size(path, ec);
+    if (ec)
+        return std::nullopt;
+
+    auto modified = fs::last_write_time(path, ec);
+    if (ec)
+        return std::nullopt;
+
+    std::string sourceId = fmt::format("{}\n{}\n{}",
+                                       path.u8string(),
+                                       size,
+                                       static_cast<std::int64_t>(modified.time_since_epoch().count()));
+    if (reduction > 0)
+        sourceId += fmt::format("\n{}", reduction);
+    return sourceId;
+}
+
+fs::path
+TextureCache::getPath(std::string_view sourceId) const
+{
+    util::FNV1aHash hash;
+    hash.addValue(Version).addBytes(sourceId);
+    return m_directory / fmt::format("{:016x}.tex", hash.value());
+}
+
+std::unique_ptr<Image>
+TextureCache::load(const fs::path& source, std::int32_t reduction) const
+{
+    auto sourceId = getSourceId(source, reduction);
+    if (!sourceId.has_value())
+        return nullptr;
+
+    std::ifstream in(getPath(*sourceId), std::ios::binary);
+    if (!in.good())
+        return nullptr;
+
+    char magic[Magic.size()]; //NOSONAR
+    if (!in.read(magic, Magic.size()).good() || std::string_view(magic, Magic.size()) != Magic) /* Flawfinder: ignore */
+        return nullptr;
+
+    std::uint32_t version;
+    std::uint32_t sourceIdSize;
+    if (!util::readNative(in, version) || version != Version ||
+        !util::readNative(in, sourceIdSize) || sourceIdSize != sourceId->size())
+    {
+        return nullptr;
+    }
+
+    std::string fileSourceId(sourceIdSize, '\0');
+    if (!in.read(fileSourceId.data(), sourceIdSize).good() || fileSourceId != *sourceId) /* Flawfinder: ignore */
+        return nullptr;
+
+    std::uint32_t format;
+    std::uint32_t width;
+    std::uint32_t height;
+    std::uint32_t mipLevels;
+    std::uint32_t size;
+    if (!util::readNative(in, format) ||
+        !util::readNative(in, width) ||
+        !util::readNative(in, height) ||
+        !util::readNative(in, mipLevels) ||
+        !util::readNative(in, size))
+    {
+        return nullptr;
+    }
+
+    auto pixelFormat = static_cast<PixelFormat>(format);
+    if (!IsCacheableFormat(pixelFormat) ||
+        width == 0 || width > static_cast<std::uint32_t>(Image::MAX_DIMENSION) ||
+        height == 0 || height > static_cast<std::uint32_t>(Image::MAX_DIMENSION) ||
+        mipLevels == 0 || mipLevels > MaxMipLevels)
+    {
+        return nullptr;
+    }
+
+    auto img = std::make_unique<Image>(pixelFormat,
+                                       static_cast<std::int32_t>(width),
+                                       static_cast<std::int32_t>(height),
+                                       static_cast<std::int32_t>(mipLevels));
+    if (static_cast<std::uint32_t>(img->getSize()) != size ||
+        !in.read(reinterpret_cast<char*>(img->getPixels()), size).good()) /* Flawfinder: ignore */
+    {
+        return nullptr;
+    }
+
+    return img;
+}
+
+bool
+TextureCache::save(const fs::path& source, const Image& img, std::int32_t reduction) const
+{
+    if (!IsCacheableFormat(img.getFormat()))
+        return false;
+
+    auto sourceId = getSourceId(source, reduction);
+    if (!sourceId.has_value())
+        return false;
+
+    std::error_code ec;
+    fs::create_directories(m_directory, ec);
+
+    util::AtomicFile file(getPath(*sourceId));
+    if (!file.isOpen())
+        return false;
+
+    std::ofstream& out = file.stream();
+    out.write(Magic.data(), Magic.size());
+    bool ok = util::writeNative(out, Version) &&
+              util::writeNative(out, static_cast<std::uint32_t>(sourceId->size())) &&
+              out.write(sourceId->data(), sourceId->size()).good() &&
+              util::writeNative(out, static_cast<std::uint32_t>(img.getFormat())) &&
+              util::writeNative(out, static_cast<std::uint32_t>(img.getWidth())) &&
+              util::writeNative(out, static_cast<std::uint32_t>(img.getHeight())) &&
+              util::writeNative(out, static_cast<std::uint32_t>(img.getMipLevelCount())) &&
+              util::writeNative(out, static_cast<std::uint32_t>(img.getSize())) &&
+              out.write(reinterpret_cast<const char*>(img.getPixels()), img.getSize()).good();
+
+    return ok && file.commit();
+}
+
+} // end namespace celestia::engine
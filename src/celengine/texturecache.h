@@ -0,0 +1,53 @@
+// texturecache.h
+//
+// Copyright (C) 2024, Celestia Development Team
+//
+// On-disk cache of texture images transcoded to a compressed format.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include <celcompat/filesystem.h>
+
+namespace celestia::engine
+{
+
+class Image;
+
+// The TextureCache keeps one file per source image in its directory, named
+// after a hash of the path, size and modification time of the source. The
+// file records these too, so that a stale or colliding file is ignored and
+// replaced on the next save. Loading and saving don't need a GL context.
+class TextureCache
+{
+public:
+    explicit TextureCache(const fs::path& directory);
+
+    // Returns nullptr if there is no image for the current version of the
+    // source file. Images of a source loaded with a reduction are kept apart
+    // from the full size one.
+    std::unique_ptr<Image> load(const fs::path& source, std::int32_t reduction = 0) const;
+
+    bool save(const fs::path& source, const Image&, std::int32_t reduction = 0) const;
+
+private:
+    static constexpr std::string_view Magic{ "CELTXDXT" };
+    static constexpr std::uint32_t Version = 1;
+
+    static std::optional<std::string> getSourceId(const fs::path& source, std::int32_t reduction);
+    fs::path getPath(std::string_view sourceId) const;
+
+    fs::path m_directory;
+};
+
+} // end namespace celestia::engine
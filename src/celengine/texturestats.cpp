@@ -0,0 +1,112 @@
+// texturestats.cpp
+//
+// Copyright (C) 2024, Celestia Development Team
+//
+// Timings of texture and virtual texture tile loads.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include "texturestats.h"
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+
+#include <celutil/logger.h>
+
+using celestia::util::GetLogger;
+
+namespace celestia::engine
+{
+
+namespace
+{
+
+double
+toMilliseconds(std::chrono::steady_clock::duration duration)
+{
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+} // end unnamed namespace
+
+void
+TextureLoadStats::add(TextureLoadRecord&& record)
+{
+    const util::ResourceLoadRecord& load = record.load;
+    ++loadCount;
+    if (load.failed)
+    {
+        ++failureCount;
+        GetLogger()->debug("Failed to load {} {}, requested in frame {}\n",
+                           record.virtualTile ? "tile" : "texture",
+                           record.path,
+                           load.requestFrame);
+    }
+    else
+    {
+        loadedBytes += load.memory;
+        GetLogger()->debug("Loaded {} {}: {} bytes, decoded in {:.1f} ms, uploaded in {:.1f} ms, "
+                           "requested in frame {}, ready in {}, drawn in {}\n",
+                           record.virtualTile ? "tile" : "texture",
+                           record.path,
+                           load.memory,
+                           toMilliseconds(load.decodeTime),
+                           toMilliseconds(load.createTime),
+                           load.requestFrame,
+                           load.readyFrame,
+                           load.firstUseFrame);
+    }
+
+    ++decodeHistogram[GetHistogramBucket(load.decodeTime)];
+    ++uploadHistogram[GetHistogramBucket(load.createTime)];
+    maxUploadTime = std::max(maxUploadTime, load.createTime);
+
+    if (records.size() >= MaxRecords)
+        records.pop_front();
+    records.push_back(std::move(record));
+}
+
+void
+TextureLoadStats::clear()
+{
+    records.clear();
+    decodeHistogram.fill(0);
+    uploadHistogram.fill(0);
+    loadCount = 0;
+    failureCount = 0;
+    loadedBytes = 0;
+    maxUploadTime = std::chrono::steady_clock::duration::zero();
+}
+
+std::vector<TextureLoadRecord>
+TextureLoadStats::getRecords() const
+{
+    return std::vector<TextureLoadRecord>(records.begin(), records.end());
+}
+
+std::size_t
+TextureLoadStats::GetHistogramBucket(std::chrono::steady_clock::duration duration)
+{
+    auto limit = std::chrono::milliseconds(1);
+    for (std::size_t i = 0; i < HistogramBuckets - 1; ++i)
+    {
+        if (duration < limit)
+            return i;
+        limit *= 2;
+    }
+
+    return HistogramBuckets - 1;
+}
+
+TextureLoadStats*
+GetTextureLoadStats()
+{
+    static TextureLoadStats* const stats = std::make_unique<TextureLoadStats>().release(); //NOSONAR
+    return stats;
+}
+
+} // namespace celestia::engine
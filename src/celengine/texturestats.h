@@ -0,0 +1,75 @@
+// texturestats.h
+//
+// Copyright (C) 2024, Celestia Development Team
+//
+// Timings of texture and virtual texture tile loads.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include <celcompat/filesystem.h>
+#include <celutil/resmanager.h>
+
+namespace celestia::engine
+{
+
+struct TextureLoadRecord
+{
+    fs::path path;
+    // Frames are those of the texture manager for tiles as well
+    util::ResourceLoadRecord load;
+    bool virtualTile{ false };
+};
+
+// Keeps the most recent load records and histograms of the decode and
+// upload times of all loads since the last clear. Each record is also
+// written to the debug log. Only used from the render thread.
+class TextureLoadStats
+{
+public:
+    static constexpr std::size_t MaxRecords = 256;
+    // Bucket i counts the times below 2^i milliseconds, the last one the
+    // rest
+    static constexpr std::size_t HistogramBuckets = 12;
+    using Histogram = std::array<std::uint64_t, HistogramBuckets>;
+
+    void add(TextureLoadRecord&& record);
+    void clear();
+
+    // The records from the oldest to the most recent
+    std::vector<TextureLoadRecord> getRecords() const;
+    const Histogram& getDecodeHistogram() const { return decodeHistogram; }
+    const Histogram& getUploadHistogram() const { return uploadHistogram; }
+
+    std::uint64_t getLoadCount() const { return loadCount; }
+    std::uint64_t getFailureCount() const { return failureCount; }
+    std::uint64_t getLoadedBytes() const { return loadedBytes; }
+    // Longest time spent creating a texture on the render thread
+    std::chrono::steady_clock::duration getMaxUploadTime() const { return maxUploadTime; }
+
+    static std::size_t GetHistogramBucket(std::chrono::steady_clock::duration);
+
+private:
+    std::deque<TextureLoadRecord> records;
+    Histogram decodeHistogram{ };
+    Histogram uploadHistogram{ };
+    std::uint64_t loadCount{ 0 };
+    std::uint64_t failureCount{ 0 };
+    std::uint64_t loadedBytes{ 0 };
+    std::chrono::steady_clock::duration maxUploadTime{ 0 };
+};
+
+TextureLoadStats* GetTextureLoadStats();
+
+} // namespace celestia::engine
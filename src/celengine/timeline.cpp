@@ -12,8 +12,12 @@
 
 #include "celengine/timeline.h"
 #include "celengine/timelinephase.h"
+#include "celengine/body.h"
 #include "celengine/frametree.h"
 #include "celengine/frame.h"
+#include <celephem/orbit.h>
+
+#include <algorithm>
 
 using namespace std;
 
@@ -45,6 +49,7 @@ Timeline::appendPhase(TimelinePhase::SharedConstPtr &phase)
     }
 
     phases.push_back(phase);
+    endTimes.push_back(phase->endTime());
 
     return true;
 }
@@ -54,23 +59,33 @@ const TimelinePhase::SharedConstPtr&
 Timeline::findPhase(double t) const
 {
     // Find the phase containing time t. The overwhelming common case is
-    // nPhases = 1, so we special case that. Otherwise, we do a simple linear search,
-    // as the number of phases in a timeline should always be quite small.
+    // nPhases = 1, so we special case that. Otherwise, the phase found last
+    // is tried before a binary search, as spacecraft timelines may have
+    // hundreds of phases.
     if (phases.size() == 1)
-    {
         return phases[0];
-    }
-    else
-    {
-        for (const auto& phase : phases)
-        {
-            if (t < phase->endTime())
-                return phase;
-        }
 
-        // Time is greater than the end time of the final phase. Just return the final phase.
-        return phases.back();
-    }
+    if (unsigned int n = lastPhase.load(std::memory_order_relaxed); isPhaseAt(n, t))
+        return phases[n];
+
+    // The first phase which ends after t; times before the start of the
+    // timeline are in the first phase, and times past its end in the final
+    // one.
+    auto it = std::upper_bound(endTimes.begin(), endTimes.end() - 1, t);
+    auto n = static_cast<unsigned int>(it - endTimes.begin());
+    lastPhase.store(n, std::memory_order_relaxed);
+    return phases[n];
+}
+
+
+/*! Return whether findPhase(t) is phase n.
+ */
+bool
+Timeline::isPhaseAt(unsigned int n, double t) const
+{
+    if (n >= phases.size())
+        return false;
+    return (n == 0 || endTimes[n - 1] <= t) && (n + 1 == phases.size() || t < endTimes[n]);
 }
 
 
@@ -118,6 +133,25 @@ Timeline::includes(double t) const
 }
 
 
+bool
+Timeline::isThreadSafe() const
+{
+    for (const auto& phase : phases)
+    {
+        if (!phase->orbit()->isThreadSafe() || !phase->orbitFrame()->isThreadSafe())
+            return false;
+
+        if (const Body* center = phase->orbitFrame()->getCenter().body();
+            center != nullptr && !center->getTimeline()->isThreadSafe())
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
 void
 Timeline::markChanged()
 {
@@ -12,6 +12,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <memory>
 #include <vector>
 #include "timelinephase.h"
@@ -22,6 +23,9 @@ public:
     Timeline() = default;
     ~Timeline();
 
+    Timeline(const Timeline&) = delete;
+    Timeline& operator=(const Timeline&) = delete;
+
     const TimelinePhase::SharedConstPtr& findPhase(double t) const;
     bool appendPhase(TimelinePhase::SharedConstPtr&);
     const TimelinePhase::SharedConstPtr& getPhase(unsigned int n) const;
@@ -31,8 +35,21 @@ public:
     double endTime() const;
     bool includes(double t) const;
 
+    // Return true if positions on the timeline may be computed from several
+    // threads: none of the orbits and frames of the phases, or of the
+    // bodies the frames are centered on, have caches
+    bool isThreadSafe() const;
+
     void markChanged();
 
 private:
+    bool isPhaseAt(unsigned int n, double t) const;
+
     std::vector<TimelinePhase::SharedConstPtr> phases;
+    // End times of the phases, searched by findPhase
+    std::vector<double> endTimes;
+    // Index of the phase last found, which is checked first as bodies are
+    // looked up many times at the same time. Several threads may look up
+    // the bodies which frames are centered on.
+    mutable std::atomic<unsigned int> lastPhase{ 0 };
 };
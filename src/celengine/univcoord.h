@@ -14,9 +14,12 @@
 
 #pragma once
 
+#include <cstddef>
+
 #include <Eigen/Core>
 
 #include <celastro/astro.h>
+#include <celutil/array_view.h>
 #include <celutil/r128.h>
 #include <celutil/r128util.h>
 
@@ -71,9 +74,25 @@ class UniversalCoord
       */
     Eigen::Vector3d offsetFromKm(const UniversalCoord& uc) const
     {
-        return Eigen::Vector3d(static_cast<double>(x - uc.x),
-                               static_cast<double>(y - uc.y),
-                               static_cast<double>(z - uc.z)) * celestia::astro::microLightYearsToKilometers(1.0);
+        return offsetFromUly(uc) * celestia::astro::microLightYearsToKilometers(1.0);
+    }
+
+    /** Get the offsets in kilometers of many coordinates from an origin,
+      * writing them to result, which must have room for all of them. This
+      * gives the same results as calling offsetFromKm for each one.
+      */
+    static void OffsetsFromKm(celestia::util::array_view<UniversalCoord> coords,
+                              const UniversalCoord& origin,
+                              Eigen::Vector3d* result)
+    {
+        const double scale = celestia::astro::microLightYearsToKilometers(1.0);
+        for (std::size_t i = 0; i < coords.size(); ++i)
+        {
+            const UniversalCoord& uc = coords[i];
+            result[i] = Eigen::Vector3d(differenceToDouble(uc.x, origin.x),
+                                        differenceToDouble(uc.y, origin.y),
+                                        differenceToDouble(uc.z, origin.z)) * scale;
+        }
     }
 
     /** Get the offset in light years of this coordinate from a point (also with
@@ -83,9 +102,9 @@ class UniversalCoord
     Eigen::Vector3f offsetFromLy(const Eigen::Vector3f& v) const
     {
         Eigen::Vector3f vUly = v * 1.0e6f;
-        Eigen::Vector3f offsetUly(static_cast<float>(static_cast<double>(x - R128(vUly.x()))),
-                                  static_cast<float>(static_cast<double>(y - R128(vUly.y()))),
-                                  static_cast<float>(static_cast<double>(z - R128(vUly.z()))));
+        Eigen::Vector3f offsetUly(static_cast<float>(differenceToDouble(x, R128(vUly.x()))),
+                                  static_cast<float>(differenceToDouble(y, R128(vUly.y()))),
+                                  static_cast<float>(differenceToDouble(z, R128(vUly.z()))));
         return offsetUly * 1.0e-6f;
     }
 
@@ -99,9 +118,9 @@ class UniversalCoord
       */
     Eigen::Vector3d offsetFromUly(const UniversalCoord& uc) const
     {
-        return Eigen::Vector3d(static_cast<double>(x - uc.x),
-                               static_cast<double>(y - uc.y),
-                               static_cast<double>(z - uc.z));
+        return Eigen::Vector3d(differenceToDouble(x, uc.x),
+                               differenceToDouble(y, uc.y),
+                               differenceToDouble(z, uc.z));
     }
 
     /** Get the value of the coordinate in light years. The result is truncated to
@@ -169,6 +188,36 @@ public:
     R128 y { 0 };
     R128 z { 0 };
 
+private:
+    /** Compute a - b converted to double precision, with the same result as
+      * static_cast<double>(a - b) but inline: the differences are a large
+      * part of the cost of positioning stars and bodies, and the generic
+      * R128 subtraction and conversion are out of line calls. Differences
+      * of nearby coordinates, with the same high words, reduce to a 64-bit
+      * subtraction.
+      */
+    static double differenceToDouble(const R128& a, const R128& b)
+    {
+        constexpr double TwoToMinus64 = 1.0 / 18446744073709551616.0;
+
+        R128_U64 lo = a.lo - b.lo;
+        if (a.hi == b.hi)
+        {
+            return a.lo >= b.lo
+                ? static_cast<double>(lo) * TwoToMinus64
+                : -(static_cast<double>(b.lo - a.lo) * TwoToMinus64);
+        }
+
+        R128_U64 hi = a.hi - b.hi - (a.lo < b.lo ? 1 : 0);
+        if (static_cast<R128_S64>(hi) >= 0)
+            return static_cast<double>(hi) + static_cast<double>(lo) * TwoToMinus64;
+
+        // Convert the magnitude so that small negative differences keep
+        // their precision
+        lo = ~lo + 1;
+        hi = ~hi + (lo == 0 ? 1 : 0);
+        return -(static_cast<double>(hi) + static_cast<double>(lo) * TwoToMinus64);
+    }
 };
 
 inline UniversalCoord operator+(const UniversalCoord& uc0, const UniversalCoord& uc1)
@@ -15,14 +15,17 @@
 #include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <unordered_map>
 #include <utility>
 
 #include <celcompat/numbers.h>
 #include <celephem/orbit.h>
+#include <celephem/samporbit.h>
 #include <celmath/mathlib.h>
 #include <celmath/intersect.h>
 #include <celmath/ray.h>
 #include <celutil/greek.h>
+#include <celutil/threadpool.h>
 #include <celutil/utf8.h>
 #include "asterism.h"
 #include "body.h"
@@ -30,16 +33,23 @@
 #include "frametree.h"
 #include "location.h"
 #include "meshmanager.h"
+#include "opencluster.h"
+#include "pagedstarcatalog.h"
 #include "render.h"
+#include "timeline.h"
 #include "timelinephase.h"
 
 namespace engine = celestia::engine;
+namespace ephem = celestia::ephem;
 namespace math = celestia::math;
 namespace util = celestia::util;
 
 namespace
 {
 
+// Number of SolarSystemWriteGuards held by this thread, for each universe
+thread_local std::unordered_map<const Universe*, unsigned int> solarSystemWriteDepths;
+
 constexpr double ANGULAR_RES = 3.5e-6;
 
 class ClosestStarFinder : public engine::StarHandler
@@ -72,7 +82,7 @@ ClosestStarFinder::process(const Star& star, float distance, float /*unused*/)
 {
     if (distance < closestDistance)
     {
-        if (!withPlanets || universe->getSolarSystem(&star))
+        if (!withPlanets || universe->hasSolarSystem(&star))
         {
             closestStar = &star;
             closestDistance = distance;
@@ -106,6 +116,68 @@ NearStarFinder::process(const Star& star, float distance, float /*unused*/)
         nearStars.push_back(&star);
 }
 
+// Collects the stars found in a query, optionally within a cone
+class StarQueryFinder : public engine::StarHandler
+{
+public:
+    explicit StarQueryFinder(std::vector<const Star*>& _stars) : stars(_stars) {}
+    void process(const Star& star, float distance, float appMag) override;
+
+    void setCone(const Eigen::Vector3f& _origin, const Eigen::Vector3f& _direction, float halfAngle)
+    {
+        origin = _origin;
+        direction = _direction.normalized();
+        cosHalfAngle = std::cos(halfAngle);
+    }
+
+private:
+    std::vector<const Star*>& stars;
+    Eigen::Vector3f origin{ Eigen::Vector3f::Zero() };
+    Eigen::Vector3f direction{ Eigen::Vector3f::Zero() };
+    float cosHalfAngle{ -1.0f };
+};
+
+void
+StarQueryFinder::process(const Star& star, float distance, float /*unused*/)
+{
+    if (cosHalfAngle > -1.0f && (star.getPosition() - origin).dot(direction) < cosHalfAngle * distance)
+        return;
+    stars.push_back(&star);
+}
+
+class DSOQueryFinder : public engine::DSOHandler
+{
+public:
+    explicit DSOQueryFinder(std::vector<const DeepSkyObject*>& _dsos) : dsos(_dsos) {}
+    void process(const std::unique_ptr<DeepSkyObject>& dso, double distance, float appMag) override; //NOSONAR
+
+    void setCone(const Eigen::Vector3d& _origin, const Eigen::Vector3f& _direction, float halfAngle)
+    {
+        origin = _origin;
+        direction = _direction.cast<double>().normalized();
+        cosHalfAngle = std::cos(static_cast<double>(halfAngle));
+    }
+
+private:
+    std::vector<const DeepSkyObject*>& dsos;
+    Eigen::Vector3d origin{ Eigen::Vector3d::Zero() };
+    Eigen::Vector3d direction{ Eigen::Vector3d::Zero() };
+    double cosHalfAngle{ -1.0 };
+};
+
+void
+DSOQueryFinder::process(const std::unique_ptr<DeepSkyObject>& dso, double /*unused*/, float /*unused*/) //NOSONAR
+{
+    // The distance passed is to the edge of the object, test its center
+    if (cosHalfAngle > -1.0)
+    {
+        Eigen::Vector3d offset = dso->getPosition() - origin;
+        if (offset.dot(direction) < cosHalfAngle * offset.norm())
+            return;
+    }
+    dsos.push_back(dso.get());
+}
+
 struct PlanetPickInfo
 {
     double sinAngle2Closest;
@@ -254,7 +326,7 @@ traverseFrameTree(const FrameTree* frameTree,
     return true;
 }
 
-// StarPicker is a callback class for StarDatabase::findVisibleStars
+// StarPicker is a callback class for StarDatabase::findStarsInCone
 class StarPicker : public engine::StarHandler
 {
 public:
@@ -549,6 +621,36 @@ getLocationsCompletion(std::vector<celestia::engine::Completion>& completion,
     }
 }
 
+struct BodyMemoryUsage
+{
+    std::size_t bodies{ 0 };
+    std::size_t bodyBytes{ 0 };
+    std::size_t phases{ 0 };
+    std::size_t timelineBytes{ 0 };
+};
+
+void
+addBodyMemoryUsage(const PlanetarySystem* system, BodyMemoryUsage& usage)
+{
+    if (system == nullptr)
+        return;
+
+    usage.bodyBytes += sizeof(PlanetarySystem);
+    for (int i = 0; i < system->getSystemSize(); ++i)
+    {
+        const Body* body = system->getBody(i);
+        ++usage.bodies;
+        usage.bodyBytes += sizeof(Body);
+        if (const Timeline* timeline = body->getTimeline(); timeline != nullptr)
+        {
+            usage.phases += timeline->phaseCount();
+            usage.timelineBytes += sizeof(Timeline) + timeline->phaseCount() * sizeof(TimelinePhase);
+        }
+
+        addBodyMemoryUsage(body->getSatellites(), usage);
+    }
+}
+
 } // end unnamed namespace
 
 // Needs definition of ConstellationBoundaries
@@ -564,6 +666,33 @@ void
 Universe::setStarCatalog(std::unique_ptr<StarDatabase>&& catalog)
 {
     starCatalog = std::move(catalog);
+    findClusterMembers();
+    catalogsChanged();
+}
+
+Universe::SolarSystemWriteGuard::SolarSystemWriteGuard(const Universe& _universe) :
+    universe(_universe)
+{
+    if (solarSystemWriteDepths[&universe]++ == 0)
+        universe.solarSystemMutex.lock();
+}
+
+Universe::SolarSystemWriteGuard::~SolarSystemWriteGuard()
+{
+    auto it = solarSystemWriteDepths.find(&universe);
+    assert(it != solarSystemWriteDepths.end());
+    if (--it->second == 0)
+    {
+        solarSystemWriteDepths.erase(it);
+        universe.solarSystemMutex.unlock();
+    }
+}
+
+Universe::SolarSystemReadGuard::SolarSystemReadGuard(const Universe& universe) :
+    lock(universe.solarSystemMutex, std::defer_lock)
+{
+    if (solarSystemWriteDepths.find(&universe) == solarSystemWriteDepths.end())
+        lock.lock();
 }
 
 SolarSystemCatalog*
@@ -576,6 +705,19 @@ void
 Universe::setSolarSystemCatalog(std::unique_ptr<SolarSystemCatalog>&& catalog)
 {
     solarSystemCatalog = std::move(catalog);
+    catalogsChanged();
+}
+
+PendingSolarSystems*
+Universe::getPendingSolarSystems() const
+{
+    return pendingSolarSystems.get();
+}
+
+void
+Universe::setPendingSolarSystems(std::unique_ptr<PendingSolarSystems>&& pending)
+{
+    pendingSolarSystems = std::move(pending);
 }
 
 DSODatabase*
@@ -588,6 +730,26 @@ void
 Universe::setDSOCatalog(std::unique_ptr<DSODatabase>&& catalog)
 {
     dsoCatalog = std::move(catalog);
+    findClusterMembers();
+    catalogsChanged();
+}
+
+void
+Universe::findClusterMembers()
+{
+    if (starCatalog == nullptr || dsoCatalog == nullptr)
+        return;
+
+    std::vector<OpenCluster*> clusters;
+    for (std::uint32_t i = 0; i < dsoCatalog->size(); ++i)
+    {
+        DeepSkyObject* dso = dsoCatalog->getDSO(i);
+        if (dso->getObjType() == DeepSkyObjectType::OpenCluster)
+            clusters.push_back(static_cast<OpenCluster*>(dso));
+    }
+
+    util::GetThreadPool()->parallelFor(clusters.size(),
+                                       [&](std::size_t i) { clusters[i]->findMembers(*starCatalog); });
 }
 
 AsterismList*
@@ -622,6 +784,10 @@ Universe::getSolarSystem(const Star* star) const
         return nullptr;
 
     auto starNum = star->getIndex();
+    if (pendingSolarSystems != nullptr)
+        pendingSolarSystems->realize(starNum);
+
+    SolarSystemReadGuard guard(*this);
     auto iter = solarSystemCatalog->find(starNum);
     return iter == solarSystemCatalog->end()
         ? nullptr
@@ -666,6 +832,10 @@ SolarSystem*
 Universe::getOrCreateSolarSystem(Star* star) const
 {
     auto starNum = star->getIndex();
+    if (pendingSolarSystems != nullptr)
+        pendingSolarSystems->realize(starNum);
+
+    SolarSystemWriteGuard guard(*this);
     auto iter = solarSystemCatalog->lower_bound(starNum);
     if (iter != solarSystemCatalog->end() && iter->first == starNum)
         return iter->second.get();
@@ -674,6 +844,18 @@ Universe::getOrCreateSolarSystem(Star* star) const
     return iter->second.get();
 }
 
+bool
+Universe::hasSolarSystem(const Star* star) const
+{
+    if (star == nullptr)
+        return false;
+
+    auto starNum = star->getIndex();
+    SolarSystemReadGuard guard(*this);
+    return solarSystemCatalog->find(starNum) != solarSystemCatalog->end() ||
+           (pendingSolarSystems != nullptr && pendingSolarSystems->contains(starNum));
+}
+
 const celestia::MarkerList&
 Universe::getMarkers() const
 {
@@ -815,18 +997,10 @@ Universe::pickStar(const UniversalCoord& origin,
     if (closePicker.closestStar != nullptr)
         return Selection(const_cast<Star*>(closePicker.closestStar));
 
-    // Find visible stars expects an orientation, but we just have a direction
-    // vector.  Convert the direction vector into an orientation by computing
-    // the rotation required to map -Z to the direction.
-    Eigen::Quaternionf rotation;
-    rotation.setFromTwoVectors(-Eigen::Vector3f::UnitZ(), direction);
-
+    // Only the stars within the tolerance of the pick ray can be picked, so
+    // search the cone around it rather than a view frustum.
     StarPicker picker(o, direction, when, tolerance);
-    starCatalog->findVisibleStars(picker,
-                                  o,
-                                  rotation.conjugate(),
-                                  tolerance, 1.0f,
-                                  faintestMag);
+    starCatalog->findStarsInCone(picker, o, direction, tolerance, faintestMag);
     if (picker.pickedStar != nullptr)
         return Selection(const_cast<Star*>(picker.pickedStar));
     else
@@ -873,8 +1047,14 @@ Universe::pick(const UniversalCoord& origin,
                double when,
                RenderFlags renderFlags,
                float  faintestMag,
-               float  tolerance)
+               float  tolerance,
+               const engine::PickHits& hits)
 {
+    // A disc drawn under the cursor is in front of anything the geometric
+    // pick of the bodies and stars could find
+    if (!hits.body.empty())
+        return hits.body;
+
     Selection sel;
 
     if (util::is_set(renderFlags, RenderFlags::ShowPlanets))
@@ -904,7 +1084,9 @@ Universe::pick(const UniversalCoord& origin,
 
     if (sel.empty())
     {
-        sel = pickDeepSkyObject(origin, direction, renderFlags, faintestMag, tolerance);
+        sel = hits.deepSky.empty()
+            ? pickDeepSkyObject(origin, direction, renderFlags, faintestMag, tolerance)
+            : hits.deepSky;
     }
 
     return sel;
@@ -1049,6 +1231,63 @@ Selection
 Universe::findPath(std::string_view s,
                    util::array_view<const Selection> contexts,
                    bool i18n) const
+{
+    {
+        std::scoped_lock lock(pathCacheMutex);
+        if (auto cached = pathCache.find(s, contexts, i18n, catalogGeneration); cached.has_value())
+            return *cached;
+    }
+
+    Selection sel = resolvePath(s, contexts, i18n);
+
+    std::scoped_lock lock(pathCacheMutex);
+    pathCache.insert(s, contexts, i18n, sel);
+    return sel;
+}
+
+PathCache::Stats
+Universe::getPathCacheStats() const
+{
+    std::scoped_lock lock(pathCacheMutex);
+    return pathCache.getStats();
+}
+
+void
+Universe::reportMemoryUsage(engine::MemoryReport& report) const
+{
+    if (starCatalog != nullptr)
+    {
+        starCatalog->reportMemoryUsage(report, "stars");
+        if (const auto* pagedCatalog = starCatalog->getPagedCatalog(); pagedCatalog != nullptr)
+            report.add("stars.paged", pagedCatalog->pagedBytes());
+    }
+
+    if (dsoCatalog != nullptr)
+        dsoCatalog->reportMemoryUsage(report, "dsos");
+
+    if (solarSystemCatalog != nullptr)
+    {
+        SolarSystemReadGuard guard(*this);
+        BodyMemoryUsage usage;
+        for (const auto& [starIndex, solarSystem] : *solarSystemCatalog)
+            addBodyMemoryUsage(solarSystem->getPlanets(), usage);
+
+        report.add("solarsystems", solarSystemCatalog->size() * sizeof(SolarSystem), solarSystemCatalog->size());
+        report.add("solarsystems.bodies", usage.bodyBytes, usage.bodies);
+        report.add("solarsystems.timelines", usage.timelineBytes, usage.phases);
+    }
+
+    // Analytical orbits are small objects held by the timeline phases, the
+    // sampled ones share the samples of their trajectory file
+    std::size_t trajectoryCount = 0;
+    std::size_t trajectoryBytes = ephem::GetSampledTrajectoryMemoryUsage(trajectoryCount);
+    report.add("trajectories", trajectoryBytes, trajectoryCount);
+}
+
+Selection
+Universe::resolvePath(std::string_view s,
+                      util::array_view<const Selection> contexts,
+                      bool i18n) const
 {
     std::string_view::size_type pos = s.find('/', 0);
 
@@ -1081,7 +1320,8 @@ void
 Universe::getCompletion(std::vector<celestia::engine::Completion>& completion,
                         std::string_view s,
                         util::array_view<const Selection> contexts,
-                        bool withLocations) const
+                        bool withLocations,
+                        const engine::CompletionProgress& progress) const
 {
     // Solar bodies first:
     for (const Selection& context : contexts)
@@ -1094,16 +1334,23 @@ Universe::getCompletion(std::vector<celestia::engine::Completion>& completion,
         const SolarSystem* sys = getSolarSystem(context);
         if (sys != nullptr)
         {
+            SolarSystemReadGuard guard(*this);
             const PlanetarySystem* planets = sys->getPlanets();
             if (planets != nullptr)
                 planets->getCompletion(completion, s);
         }
     }
 
+    if (progress && !progress())
+        return;
+
     // Deep sky objects:
     if (dsoCatalog != nullptr)
         dsoCatalog->getCompletion(completion, s);
 
+    if (progress && !progress())
+        return;
+
     // and finally stars;
     if (starCatalog != nullptr)
         starCatalog->getCompletion(completion, s);
@@ -1113,13 +1360,14 @@ void
 Universe::getCompletionPath(std::vector<celestia::engine::Completion>& completion,
                             std::string_view s,
                             util::array_view<const Selection> contexts,
-                            bool withLocations) const
+                            bool withLocations,
+                            const engine::CompletionProgress& progress) const
 {
     std::string_view::size_type pos = s.rfind('/', s.length());
 
     if (pos == std::string_view::npos)
     {
-        getCompletion(completion, s, contexts, withLocations);
+        getCompletion(completion, s, contexts, withLocations, progress);
         return;
     }
 
@@ -1150,7 +1398,10 @@ Universe::getCompletionPath(std::vector<celestia::engine::Completion>& completio
     }
 
     if (worlds != nullptr)
+    {
+        SolarSystemReadGuard guard(*this);
         worlds->getCompletion(completion, s.substr(pos + 1), false);
+    }
 
     if (sel.getType() == SelectionType::Body && withLocations)
     {
@@ -1181,3 +1432,72 @@ Universe::getNearStars(const UniversalCoord& position,
     NearStarFinder finder(maxDistance, nearStars);
     starCatalog->findCloseStars(finder, pos, maxDistance);
 }
+
+void
+Universe::getNearDSOs(const UniversalCoord& position,
+                      float maxDistance,
+                      std::vector<const DeepSkyObject*>& dsos) const
+{
+    DSOQueryFinder finder(dsos);
+    dsoCatalog->findCloseDSOs(finder, position.toLy(), maxDistance);
+}
+
+void
+Universe::getStarsInCone(const UniversalCoord& position,
+                         const Eigen::Vector3f& direction,
+                         float halfAngle,
+                         float maxDistance,
+                         std::vector<const Star*>& stars) const
+{
+    Eigen::Vector3f pos = position.toLy().cast<float>();
+    StarQueryFinder finder(stars);
+    finder.setCone(pos, direction, halfAngle);
+    starCatalog->findCloseStars(finder, pos, maxDistance);
+}
+
+void
+Universe::getDSOsInCone(const UniversalCoord& position,
+                        const Eigen::Vector3f& direction,
+                        float halfAngle,
+                        float maxDistance,
+                        std::vector<const DeepSkyObject*>& dsos) const
+{
+    Eigen::Vector3d pos = position.toLy();
+    DSOQueryFinder finder(dsos);
+    finder.setCone(pos, direction, halfAngle);
+    dsoCatalog->findCloseDSOs(finder, pos, maxDistance);
+}
+
+void
+Universe::getStarsInView(const UniversalCoord& position,
+                         const Eigen::Quaternionf& orientation,
+                         float fovY,
+                         float aspectRatio,
+                         float limitingMag,
+                         std::vector<const Star*>& stars) const
+{
+    StarQueryFinder finder(stars);
+    starCatalog->findVisibleStars(finder,
+                                  position.toLy().cast<float>(),
+                                  orientation,
+                                  fovY,
+                                  aspectRatio,
+                                  limitingMag);
+}
+
+void
+Universe::getDSOsInView(const UniversalCoord& position,
+                        const Eigen::Quaternionf& orientation,
+                        float fovY,
+                        float aspectRatio,
+                        float limitingMag,
+                        std::vector<const DeepSkyObject*>& dsos) const
+{
+    DSOQueryFinder finder(dsos);
+    dsoCatalog->findVisibleDSOs(finder,
+                                position.toLy(),
+                                orientation,
+                                fovY,
+                                aspectRatio,
+                                limitingMag);
+}
@@ -10,7 +10,10 @@
 
 #pragma once
 
+#include <cstdint>
 #include <memory>
+#include <mutex>
+#include <shared_mutex>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -23,6 +26,9 @@
 #include <celengine/solarsys.h>
 #include <celengine/deepskyobj.h>
 #include <celengine/marker.h>
+#include <celengine/memoryreport.h>
+#include <celengine/pathcache.h>
+#include <celengine/pickbuffer.h>
 #include <celengine/renderflags.h>
 #include <celengine/selection.h>
 #include <celengine/asterism.h>
@@ -40,6 +46,11 @@ public:
     SolarSystemCatalog* getSolarSystemCatalog() const;
     void setSolarSystemCatalog(std::unique_ptr<SolarSystemCatalog>&&);
 
+    // When set, the solar systems are loaded lazily: those which haven't
+    // been looked up yet are not in the catalog
+    PendingSolarSystems* getPendingSolarSystems() const;
+    void setPendingSolarSystems(std::unique_ptr<PendingSolarSystems>&&);
+
     DSODatabase* getDSOCatalog() const;
     void setDSOCatalog(std::unique_ptr<DSODatabase>&&);
 
@@ -49,12 +60,27 @@ public:
     ConstellationBoundaries* getBoundaries() const;
     void setBoundaries(std::unique_ptr<ConstellationBoundaries>&&);
 
+    // The generation changes whenever a catalog is replaced or objects are
+    // added to one, so that objects looked up by name can be kept until then
+    std::uint32_t getCatalogGeneration() const { return catalogGeneration; }
+    void catalogsChanged() { ++catalogGeneration; }
+
+    // Lookups of paths by findPath are cached until the catalogs change
+    PathCache::Stats getPathCacheStats() const;
+
+    // Add the memory of the star and deep sky catalogs, the solar system
+    // bodies and the trajectories they use to the report
+    void reportMemoryUsage(celestia::engine::MemoryReport&) const;
+
+    // The hits found in the last rendered frame take the place of the
+    // geometric pick of their layer
     Selection pick(const UniversalCoord& origin,
                    const Eigen::Vector3f& direction,
                    double when,
                    RenderFlags renderFlags,
                    float faintestMag,
-                   float tolerance = 0.0f);
+                   float tolerance = 0.0f,
+                   const celestia::engine::PickHits& hits = {});
 
 
     Selection findPath(std::string_view s,
@@ -64,18 +90,91 @@ public:
     void getCompletionPath(std::vector<celestia::engine::Completion>& completion,
                            std::string_view s,
                            celestia::util::array_view<const Selection> contexts,
-                           bool withLocations = false) const;
+                           bool withLocations = false,
+                           const celestia::engine::CompletionProgress& progress = {}) const;
 
 
+    // Solar systems are never destroyed before the universe, so the returned
+    // pointers stay valid. Their objects are only modified on the thread
+    // which loaded the catalogs, holding a SolarSystemWriteGuard (when
+    // pending solar systems are created or catalogs are reloaded); other
+    // threads walking them hold a SolarSystemReadGuard meanwhile.
     SolarSystem* getNearestSolarSystem(const UniversalCoord& position) const;
     SolarSystem* getSolarSystem(const Star* star) const;
     SolarSystem* getSolarSystem(const Selection&) const;
     SolarSystem* getOrCreateSolarSystem(Star* star) const;
+    // Whether a star has a solar system, without creating it when pending
+    bool hasSolarSystem(const Star* star) const;
+
+    // Exclusive access to the solar system catalog and the pending solar
+    // systems while they are modified. Other threads looking solar systems
+    // up wait until the modification is complete, so that they never see
+    // a solar system whose objects are still being created. Guards of a
+    // universe nest on the same thread, and its lookups don't wait.
+    class SolarSystemWriteGuard
+    {
+    public:
+        explicit SolarSystemWriteGuard(const Universe&);
+        ~SolarSystemWriteGuard();
+
+        SolarSystemWriteGuard(const SolarSystemWriteGuard&) = delete;
+        SolarSystemWriteGuard& operator=(const SolarSystemWriteGuard&) = delete;
+
+    private:
+        const Universe& universe;
+    };
+
+    // Shared access to the solar systems, unless this thread holds a
+    // SolarSystemWriteGuard of the universe. Read guards don't nest, and
+    // nothing which may create a pending solar system (getSolarSystem,
+    // getOrCreateSolarSystem) may be called while one is held.
+    class SolarSystemReadGuard
+    {
+    public:
+        explicit SolarSystemReadGuard(const Universe&);
+
+    private:
+        std::shared_lock<std::shared_mutex> lock;
+    };
 
     void getNearStars(const UniversalCoord& position,
                       float maxDistance,
                       std::vector<const Star*>& stars) const;
 
+    // Spatial queries backed by the octrees; distances are in light years
+    // and angles in radians. The objects are appended in no particular order.
+    void getNearDSOs(const UniversalCoord& position,
+                     float maxDistance,
+                     std::vector<const DeepSkyObject*>& dsos) const;
+
+    void getStarsInCone(const UniversalCoord& position,
+                        const Eigen::Vector3f& direction,
+                        float halfAngle,
+                        float maxDistance,
+                        std::vector<const Star*>& stars) const;
+
+    void getDSOsInCone(const UniversalCoord& position,
+                       const Eigen::Vector3f& direction,
+                       float halfAngle,
+                       float maxDistance,
+                       std::vector<const DeepSkyObject*>& dsos) const;
+
+    // Objects in the view frustum brighter than limitingMag, as they are
+    // found for rendering
+    void getStarsInView(const UniversalCoord& position,
+                        const Eigen::Quaternionf& orientation,
+                        float fovY,
+                        float aspectRatio,
+                        float limitingMag,
+                        std::vector<const Star*>& stars) const;
+
+    void getDSOsInView(const UniversalCoord& position,
+                       const Eigen::Quaternionf& orientation,
+                       float fovY,
+                       float aspectRatio,
+                       float limitingMag,
+                       std::vector<const DeepSkyObject*>& dsos) const;
+
     void markObject(const Selection&,
                     const celestia::MarkerRepresentation& rep,
                     int priority,
@@ -87,10 +186,18 @@ public:
     const celestia::MarkerList& getMarkers() const;
 
 private:
+    // Find the stars of each open cluster, once both catalogs are loaded
+    void findClusterMembers();
+
+    Selection resolvePath(std::string_view s,
+                          celestia::util::array_view<const Selection> contexts,
+                          bool i18n) const;
+
     void getCompletion(std::vector<celestia::engine::Completion>& completion,
                        std::string_view s,
                        celestia::util::array_view<const Selection> contexts,
-                       bool withLocations = false) const;
+                       bool withLocations,
+                       const celestia::engine::CompletionProgress& progress) const;
 
     Selection find(std::string_view s,
                    celestia::util::array_view<const Selection> contexts,
@@ -124,9 +231,17 @@ private:
     std::unique_ptr<StarDatabase> starCatalog{nullptr};
     std::unique_ptr<DSODatabase> dsoCatalog{nullptr};
     std::unique_ptr<SolarSystemCatalog> solarSystemCatalog{nullptr};
+    std::unique_ptr<PendingSolarSystems> pendingSolarSystems{nullptr};
+    // Held exclusively by SolarSystemWriteGuard, and shared by
+    // SolarSystemReadGuard
+    mutable std::shared_mutex solarSystemMutex;
     std::unique_ptr<AsterismList> asterisms{nullptr};
     std::unique_ptr<ConstellationBoundaries> boundaries{nullptr};
 
     celestia::MarkerList markers{ };
     std::vector<const Star*> closeStars{ };
+    std::uint32_t catalogGeneration{ 1 };
+    // Name lookups may be made by celx jobs on worker threads
+    mutable std::mutex pathCacheMutex;
+    mutable PathCache pathCache;
 };
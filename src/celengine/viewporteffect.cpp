@@ -8,8 +8,13 @@
 // as published by the Free Software Foundation; either version 2
 // of the License, or (at your option) any later version.
 
+#include <algorithm>
 #include <array>
+#include <cmath>
+#include <Eigen/Geometry>
+#include <celcompat/numbers.h>
 #include "viewporteffect.h"
+#include "cubefaceprojectionmode.h"
 #include "framebuffer.h"
 #include "render.h"
 #include "shadermanager.h"
@@ -103,6 +108,37 @@ void PassthroughViewportEffect::initialize()
         2 * sizeof(float));
 }
 
+UpscaleViewportEffect::UpscaleViewportEffect(float sharpness) :
+    PassthroughViewportEffect(),
+    sharpness(sharpness)
+{
+}
+
+bool UpscaleViewportEffect::render(Renderer* renderer, FramebufferObject* fbo, int width, int height)
+{
+    // Nothing to sharpen when the scene is drawn at the size of the view
+    if (sharpness <= 0.0f || (fbo->width() == static_cast<GLuint>(width) && fbo->height() == static_cast<GLuint>(height)))
+        return PassthroughViewportEffect::render(renderer, fbo, width, height);
+
+    auto *prog = renderer->getShaderManager().getShader("upscale");
+    if (prog == nullptr)
+        return false;
+
+    initialize();
+
+    prog->use();
+    prog->samplerParam("tex") = 0;
+    prog->vec2Param("texelSize") = Eigen::Vector2f(1.0f / static_cast<float>(fbo->width()),
+                                                   1.0f / static_cast<float>(fbo->height()));
+    prog->floatParam("sharpness") = sharpness;
+    glBindTexture(GL_TEXTURE_2D, fbo->colorTexture());
+    renderer->setPipelineState(ps);
+    vo.draw();
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    return true;
+}
+
 WarpMeshViewportEffect::WarpMeshViewportEffect(WarpMesh *mesh) :
     ViewportEffect(),
     mesh(mesh)
@@ -188,3 +224,298 @@ bool WarpMeshViewportEffect::distortXY(float &x, float &y)
     y = v / 2.0f;
     return true;
 }
+
+namespace
+{
+
+// The faces of the cube map which hold the hemisphere in front of the
+// camera, with the tile of each face rendered. The directions and up
+// vectors follow the orientation of the cube map faces in OpenGL.
+struct CubeFace
+{
+    GLenum target;
+    Eigen::Vector3d direction;
+    Eigen::Vector3d up;
+    int columns;
+    int rows;
+    int column;
+    int row;
+};
+
+const std::array<CubeFace, 5> cubeFaces
+{
+    CubeFace{ GL_TEXTURE_CUBE_MAP_NEGATIVE_Z, -Eigen::Vector3d::UnitZ(), -Eigen::Vector3d::UnitY(), 1, 1, 0, 0 },
+    CubeFace{ GL_TEXTURE_CUBE_MAP_POSITIVE_X,  Eigen::Vector3d::UnitX(), -Eigen::Vector3d::UnitY(), 2, 1, 1, 0 },
+    CubeFace{ GL_TEXTURE_CUBE_MAP_NEGATIVE_X, -Eigen::Vector3d::UnitX(), -Eigen::Vector3d::UnitY(), 2, 1, 0, 0 },
+    CubeFace{ GL_TEXTURE_CUBE_MAP_POSITIVE_Y,  Eigen::Vector3d::UnitY(),  Eigen::Vector3d::UnitZ(), 1, 2, 0, 0 },
+    CubeFace{ GL_TEXTURE_CUBE_MAP_NEGATIVE_Y, -Eigen::Vector3d::UnitY(), -Eigen::Vector3d::UnitZ(), 1, 2, 0, 1 },
+};
+
+// Rotation from the camera to the camera looking at the face
+Eigen::Matrix3d
+faceTransform(const CubeFace& face)
+{
+    Eigen::Vector3d s = face.direction.cross(face.up);
+    Eigen::Vector3d u = s.cross(face.direction);
+
+    Eigen::Matrix3d m;
+    m.row(0) = s;
+    m.row(1) = u;
+    m.row(2) = -face.direction;
+    return m;
+}
+
+} // end unnamed namespace
+
+CubeMapViewportEffect::CubeMapViewportEffect(WarpMesh *mesh) :
+    ViewportEffect(),
+    mesh(mesh)
+{
+}
+
+CubeMapViewportEffect::~CubeMapViewportEffect()
+{
+    cleanupFaces();
+}
+
+bool CubeMapViewportEffect::renderFaces(Renderer* renderer, int viewHeight, const std::function<void()>& renderScene)
+{
+    // The fisheye image spans 180 degrees over the view height, while a face
+    // spans 90 degrees with its pixels at least as dense as at the center
+    auto size = static_cast<int>(std::ceil(static_cast<float>(viewHeight) * 2.0f * celestia::numbers::inv_pi_v<float>));
+    if (!initializeFaces(std::max(size, 1)))
+        return false;
+
+    GLint oldFboId;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &oldFboId);
+    glBindFramebuffer(GL_FRAMEBUFFER, fboId);
+
+    faceProjection->setScreenDpi(renderer->getScreenDpi());
+    renderer->overrideProjectionMode(faceProjection);
+    Eigen::Matrix3d cameraTransform = renderer->getCameraTransform();
+
+    rendered = true;
+    for (const CubeFace& face : cubeFaces)
+    {
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, face.target, colorTexId, 0);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        {
+            rendered = false;
+            break;
+        }
+
+        int width = faceSize / face.columns;
+        int height = faceSize / face.rows;
+        faceProjection->setTile(face.columns, face.rows, face.column, face.row);
+        renderer->setRenderRegion(width * face.column, height * face.row, width, height, false);
+        renderer->setCameraTransform(faceTransform(face) * cameraTransform);
+        renderScene();
+    }
+
+    faceProjection->setTile(1, 1, 0, 0);
+    renderer->setCameraTransform(cameraTransform);
+    renderer->overrideProjectionMode(nullptr);
+    glBindFramebuffer(GL_FRAMEBUFFER, oldFboId);
+
+    return rendered;
+}
+
+bool CubeMapViewportEffect::preprocess(Renderer* /*renderer*/, FramebufferObject* /*fbo*/)
+{
+    // The faces are rendered by renderFaces rather than to the framebuffer
+    // of the view
+    return rendered;
+}
+
+bool CubeMapViewportEffect::prerender(Renderer* /*renderer*/, FramebufferObject* /*fbo*/)
+{
+    if (!rendered)
+        return false;
+
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    return true;
+}
+
+bool CubeMapViewportEffect::render(Renderer* renderer, FramebufferObject* /*fbo*/, int width, int height)
+{
+    if (!rendered)
+        return false;
+
+    auto *prog = renderer->getShaderManager().getShader("cubefisheye");
+    if (prog == nullptr)
+        return false;
+
+    initialize();
+
+    prog->use();
+    prog->samplerParam("tex") = 0;
+    if (mesh == nullptr)
+    {
+        // The quad covers the whole view, as the fisheye projection does
+        prog->floatParam("screenRatio") = 1.0f;
+        prog->vec2Param("lensScale") = Eigen::Vector2f(static_cast<float>(width) / static_cast<float>(height), 1.0f);
+    }
+    else
+    {
+        // As for the warp mesh effect, the mesh maps the square in the
+        // middle of the fisheye image
+        prog->floatParam("screenRatio") = static_cast<float>(height) / static_cast<float>(width);
+        prog->vec2Param("lensScale") = Eigen::Vector2f::Ones();
+    }
+    glBindTexture(GL_TEXTURE_CUBE_MAP, colorTexId);
+    renderer->setPipelineState(ps);
+    vo.draw();
+    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+
+    return true;
+}
+
+bool CubeMapViewportEffect::distortXY(float &x, float &y)
+{
+    if (mesh == nullptr)
+        return true;
+
+    float u;
+    float v;
+    if (!mesh->mapVertex(x * 2.0f, y * 2.0f, &u, &v))
+        return false;
+
+    x = u / 2.0f;
+    y = v / 2.0f;
+    return true;
+}
+
+bool CubeMapViewportEffect::initializeFaces(int size)
+{
+    GLint maxSize = 0;
+    glGetIntegerv(GL_MAX_CUBE_MAP_TEXTURE_SIZE, &maxSize);
+    size = std::min(size, static_cast<int>(maxSize));
+    if (size == faceSize && fboId != 0)
+        return true;
+
+    cleanupFaces();
+    faceSize = size;
+
+    glGenTextures(1, &colorTexId);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, colorTexId);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    for (const CubeFace& face : cubeFaces)
+    {
+#ifdef GL_ES
+        glTexImage2D(face.target, 0, GL_RGBA, size, size, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+#else
+        glTexImage2D(face.target, 0, GL_RGB8, size, size, 0, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+#endif
+    }
+    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+
+    // All the faces share one depth buffer, cleared for each of them
+    glGenTextures(1, &depthTexId);
+    glBindTexture(GL_TEXTURE_2D, depthTexId);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+#ifdef GL_ES
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, size, size, 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, nullptr);
+#else
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, size, size, 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_BYTE, nullptr);
+#endif
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    GLint oldFboId;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &oldFboId);
+    glGenFramebuffers(1, &fboId);
+    glBindFramebuffer(GL_FRAMEBUFFER, fboId);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, cubeFaces[0].target, colorTexId, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTexId, 0);
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, oldFboId);
+
+    if (status != GL_FRAMEBUFFER_COMPLETE)
+    {
+        cleanupFaces();
+        return false;
+    }
+
+    if (faceProjection == nullptr)
+        faceProjection = std::make_shared<celestia::engine::CubeFaceProjectionMode>(static_cast<float>(size), 0);
+    else
+        faceProjection->setSize(static_cast<float>(size), static_cast<float>(size));
+
+    return true;
+}
+
+void CubeMapViewportEffect::cleanupFaces()
+{
+    if (fboId != 0)
+        glDeleteFramebuffers(1, &fboId);
+    if (colorTexId != 0)
+        glDeleteTextures(1, &colorTexId);
+    if (depthTexId != 0)
+        glDeleteTextures(1, &depthTexId);
+
+    fboId = 0;
+    colorTexId = 0;
+    depthTexId = 0;
+    faceSize = 0;
+    rendered = false;
+}
+
+void CubeMapViewportEffect::initialize()
+{
+    if (initialized)
+        return;
+    initialized = true;
+
+    vo = gl::VertexObject();
+    if (mesh == nullptr)
+    {
+        static std::array quadVertices = {
+            // positions   // texCoords  // intensity
+            -1.0f,  1.0f,  0.0f, 1.0f,  1.0f,
+            -1.0f, -1.0f,  0.0f, 0.0f,  1.0f,
+             1.0f, -1.0f,  1.0f, 0.0f,  1.0f,
+
+            -1.0f,  1.0f,  0.0f, 1.0f,  1.0f,
+             1.0f, -1.0f,  1.0f, 0.0f,  1.0f,
+             1.0f,  1.0f,  1.0f, 1.0f,  1.0f
+        };
+
+        bo = gl::Buffer(gl::Buffer::TargetHint::Array, quadVertices, gl::Buffer::BufferUsage::StaticDraw);
+        vo.setCount(6);
+    }
+    else
+    {
+        bo = gl::Buffer();
+        bo.setData(mesh->scopedDataForRendering(), gl::Buffer::BufferUsage::StaticDraw);
+        vo.setCount(mesh->count());
+    }
+
+    vo.addVertexBuffer(
+        bo,
+        CelestiaGLProgram::VertexCoordAttributeIndex,
+        2,
+        gl::VertexObject::DataType::Float,
+        false,
+        5 * sizeof(float),
+        0);
+    vo.addVertexBuffer(
+        bo,
+        CelestiaGLProgram::TextureCoord0AttributeIndex,
+        2,
+        gl::VertexObject::DataType::Float,
+        false,
+        5 * sizeof(float),
+        2 * sizeof(float));
+    vo.addVertexBuffer(
+        bo,
+        CelestiaGLProgram::IntensityAttributeIndex,
+        1,
+        gl::VertexObject::DataType::Float,
+        false,
+        5 * sizeof(float),
+        4 * sizeof(float));
+}
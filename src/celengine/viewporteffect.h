@@ -10,6 +10,9 @@
 
 #pragma once
 
+#include <functional>
+#include <memory>
+
 #include <celrender/gl/buffer.h>
 #include <celrender/gl/vertexobject.h>
 
@@ -18,6 +21,11 @@ class Renderer;
 class CelestiaGLProgram;
 class WarpMesh;
 
+namespace celestia::engine
+{
+class CubeFaceProjectionMode;
+}
+
 class ViewportEffect
 {
 public:
@@ -40,15 +48,31 @@ public:
 
     bool render(Renderer*, FramebufferObject*, int width, int height) override;
 
-private:
+protected:
     celestia::gl::VertexObject vo{ celestia::util::NoCreateT{} };
     celestia::gl::Buffer bo{ celestia::util::NoCreateT{} };
 
     void initialize();
 
+private:
     bool initialized{ false };
 };
 
+// Draws the scene rendered at a lower resolution to the view, sharpening
+// the edges blurred by the scaling without making halos
+class UpscaleViewportEffect : public PassthroughViewportEffect
+{
+public:
+    // Sharpness from 0, plain bilinear filtering, to 1
+    explicit UpscaleViewportEffect(float sharpness);
+    ~UpscaleViewportEffect() override = default;
+
+    bool render(Renderer*, FramebufferObject*, int width, int height) override;
+
+private:
+    float sharpness;
+};
+
 class WarpMeshViewportEffect : public ViewportEffect
 {
 public:
@@ -69,3 +93,43 @@ private:
 
     bool initialized{ false };
 };
+
+// Renders the hemisphere in front of the observer to five faces of a cube
+// map, the front face and the halves of the side faces next to it, then
+// resamples it to the fisheye image, optionally through a warp mesh. Unlike
+// the fisheye projection, this needs no tessellation of the geometry.
+class CubeMapViewportEffect : public ViewportEffect
+{
+public:
+    explicit CubeMapViewportEffect(WarpMesh *mesh = nullptr);
+    ~CubeMapViewportEffect() override;
+
+    // Render the faces for a view of the height, calling renderScene once
+    // for each with the camera and projection of the face set up
+    bool renderFaces(Renderer*, int viewHeight, const std::function<void()>& renderScene);
+
+    bool preprocess(Renderer*, FramebufferObject*) override;
+    bool prerender(Renderer*, FramebufferObject*) override;
+    bool render(Renderer*, FramebufferObject*, int width, int height) override;
+    bool distortXY(float& x, float& y) override;
+
+private:
+    celestia::gl::VertexObject vo{ celestia::util::NoCreateT{} };
+    celestia::gl::Buffer bo{ celestia::util::NoCreateT{} };
+
+    WarpMesh *mesh;
+    std::shared_ptr<celestia::engine::CubeFaceProjectionMode> faceProjection;
+
+    GLuint fboId{ 0 };
+    GLuint colorTexId{ 0 };
+    GLuint depthTexId{ 0 };
+    int faceSize{ 0 };
+    // Whether the cube map holds a complete frame
+    bool rendered{ false };
+
+    bool initializeFaces(int size);
+    void cleanupFaces();
+    void initialize();
+
+    bool initialized{ false };
+};
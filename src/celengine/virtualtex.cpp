@@ -10,7 +10,9 @@
 
 #include "virtualtex.h"
 
+#include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <cstdio>
 #include <fstream>
 #include <optional>
@@ -19,10 +21,13 @@
 
 #include <fmt/format.h>
 
+#include <celutil/fileaccesslog.h>
 #include <celutil/filetype.h>
 #include <celutil/logger.h>
 #include <celutil/parser.h>
+#include <celutil/threadpool.h>
 #include <celutil/tokenizer.h>
+#include "texmanager.h"
 
 namespace util = celestia::util;
 
@@ -34,6 +39,11 @@ namespace
 
 constexpr int MaxResolutionLevels = 13;
 
+// Limits on the tiles of one virtual texture being decoded at a time, and on
+// the time spent uploading decoded tiles in one beginUsage call
+constexpr std::size_t MaxDecodingTiles = 8;
+constexpr auto TileUploadBudget = std::chrono::milliseconds(2);
+
 constexpr bool
 isPow2(int x)
 {
@@ -145,6 +155,7 @@ VirtualTexture::VirtualTexture(const fs::path& _tilePath,
     tilePath(_tilePath),
     tilePrefix(_tilePrefix),
     baseSplit(_baseSplit),
+    tileSize(_tileSize),
     ticks(0),
     nResolutionLevels(0)
 {
@@ -172,9 +183,14 @@ VirtualTexture::getTile(int lod, int u, int v)
     }
 
     const TileQuadtreeNode* node = &tileTree[u >> lod];
+    const TileQuadtreeNode* tileNode = node;
     Tile* tile = node->tile.get();
     unsigned int tileLOD = 0;
 
+    // The deepest tile along the path which can be drawn right away
+    Tile* residentTile = (tile != nullptr && tile->isResident()) ? tile : nullptr;
+    unsigned int residentLOD = 0;
+
     for (int n = 0; n < lod; n++)
     {
         unsigned int mask = 1 << (lod - n - 1);
@@ -187,6 +203,12 @@ VirtualTexture::getTile(int lod, int u, int v)
         {
             tile = node->tile.get();
             tileLOD = n + 1;
+            tileNode = node;
+            if (tile->isResident())
+            {
+                residentTile = tile;
+                residentLOD = tileLOD;
+            }
         }
     }
 
@@ -194,16 +216,45 @@ VirtualTexture::getTile(int lod, int u, int v)
     if (!tile)
         return TextureTile(0);
 
-    // Make the tile resident.
     unsigned int tileU = u >> (lod - tileLOD);
     unsigned int tileV = v >> (lod - tileLOD);
-    makeResident(tile, tileLOD, tileU, tileV);
+
+    if (!streaming || residentTile == nullptr)
+    {
+        // Make the tile resident. When streaming, this only happens for the
+        // coarsest tiles, which are kept so that there is always something
+        // to draw in place of the tiles still loading.
+        makeResident(tile, tileLOD, tileU, tileV);
+        tile->pinned = streaming;
+        residentTile = tile;
+        residentLOD = tileLOD;
+    }
+    else if (residentTile != tile)
+    {
+        requestTile(tile, tileLOD, tileU, tileV, tileLOD - residentLOD);
+    }
+    else if (tileLOD == (unsigned int) lod)
+    {
+        // Load the tiles of the next level before they are needed
+        prefetchChildren(tileNode, tileLOD, tileU, tileV);
+    }
+
+    tile = residentTile;
+    tileLOD = residentLOD;
+    tile->lastUsed = ticks;
+
+    if (tile->loadRecord != nullptr)
+    {
+        tile->loadRecord->load.firstUseFrame = GetTextureManager()->getFrame();
+        celestia::engine::GetTextureLoadStats()->add(std::move(*tile->loadRecord));
+        tile->loadRecord = nullptr;
+    }
 
     // It's possible that we failed to make the tile resident, either
     // because the texture file was bad, or there was an unresolvable
     // out of memory situation.  In that case there is nothing else to
     // do but return a texture tile with a null texture name.
-    if (!tile->tex)
+    if (!tile->isResident())
         return TextureTile(0);
 
     // Set up the texture subrect to be the entire texture
@@ -219,6 +270,9 @@ VirtualTexture::getTile(int lod, int u, int v)
     texU = (u & ((1 << lodDiff) - 1)) * texDU;
     texV = (v & ((1 << lodDiff) - 1)) * texDV;
 
+    if (tile->atlas != nullptr)
+        return tile->atlas->getTile(tile->atlasSlot, texU, texV, texDU, texDV);
+
     return TextureTile(tile->tex->getName(), texU, texV, texDU, texDV);
 }
 
@@ -257,17 +311,40 @@ VirtualTexture::beginUsage()
 {
     ticks++;
     tilesRequested = 0;
+
+    if (streaming)
+    {
+        uploadDecodedTiles();
+        evictTiles();
+    }
 }
 
 
 void
 VirtualTexture::endUsage()
 {
+    if (streaming)
+        startDecodes();
+}
+
+
+void
+VirtualTexture::setStreaming(bool enable, std::size_t budget)
+{
+    streaming = enable;
+    memoryBudget = budget;
+}
+
+
+void
+VirtualTexture::setTileAtlas(bool enable)
+{
+    tileAtlas = enable;
 }
 
 
-std::unique_ptr<ImageTexture>
-VirtualTexture::loadTileTexture(unsigned int lod, unsigned int u, unsigned int v)
+fs::path
+VirtualTexture::getTileFilePath(unsigned int lod, unsigned int u, unsigned int v) const
 {
     lod >>= baseSplit;
     assert(lod < (unsigned)MaxResolutionLevels);
@@ -275,46 +352,309 @@ VirtualTexture::loadTileTexture(unsigned int lod, unsigned int u, unsigned int v
     auto filename = fs::u8path(fmt::format("{}{}_{}", tilePrefix, u, v));
     filename += tileExt;
 
-    auto path = tilePath /
-                fmt::format("level{:d}", lod) /
-                filename;
+    return tilePath /
+           fmt::format("level{:d}", lod) /
+           filename;
+}
 
-    auto img = Image::load(path);
-    if (img == nullptr)
-        return nullptr;
 
-    std::unique_ptr<ImageTexture> tex = nullptr;
+bool
+VirtualTexture::createTileTexture(Tile* tile, const Image& img, unsigned int lod, std::size_t& memory)
+{
+    // TODO: Virtual textures can have tiles in different formats, some
+    // compressed and some not. The compression flag doesn't make much
+    // sense for them.
+    compressed = img.isCompressed();
 
     // Only use mip maps for the LOD 0; for higher LODs, the function of mip
     // mapping is built into the texture.
-    MipMapMode mipMapMode = lod == 0 ? DefaultMipMaps : NoMipMaps;
+    MipMapMode mipMapMode = (lod >> baseSplit) == 0 ? DefaultMipMaps : NoMipMaps;
 
-    if (isPow2(img->getWidth()) && isPow2(img->getHeight()))
-        tex = std::make_unique<ImageTexture>(*img, EdgeClamp, mipMapMode);
+    if (mipMapMode == NoMipMaps)
+    {
+        if (TileAtlas* atlas = getAtlas(img); atlas != nullptr)
+        {
+            tile->atlasSlot = atlas->insert(img);
+            tile->atlas = atlas;
+            memory = atlas->getSlotMemoryUsage();
+            return true;
+        }
+    }
 
-    // TODO: Virtual textures can have tiles in different formats, some
-    // compressed and some not. The compression flag doesn't make much
-    // sense for them.
-    compressed = img->isCompressed();
+    if (!isPow2(img.getWidth()) || !isPow2(img.getHeight()))
+        return false;
+
+    tile->tex = std::make_unique<ImageTexture>(img, EdgeClamp, mipMapMode);
 
-    return tex;
+    // Generated mip maps add a third to the size of the image
+    memory = static_cast<std::size_t>(img.getSize());
+    if (mipMapMode == DefaultMipMaps && img.getMipLevelCount() == 1)
+        memory += memory / 3;
+
+    return true;
+}
+
+
+TileAtlas*
+VirtualTexture::getAtlas(const Image& img)
+{
+    if (!tileAtlas)
+        return nullptr;
+
+    for (const auto& atlas : atlases)
+    {
+        if (atlas->accepts(img) && !atlas->full())
+            return atlas.get();
+    }
+
+    if (img.getWidth() != static_cast<int>(tileSize) ||
+        img.getHeight() != static_cast<int>(tileSize) ||
+        !TileAtlas::isSupported(img.getFormat(), static_cast<int>(tileSize)))
+    {
+        return nullptr;
+    }
+
+    return atlases.emplace_back(std::make_unique<TileAtlas>(img.getFormat(), static_cast<int>(tileSize))).get();
+}
+
+
+void
+VirtualTexture::releaseTile(Tile* tile)
+{
+    if (tile->atlas != nullptr)
+    {
+        tile->atlas->remove(tile->atlasSlot);
+        tile->atlas = nullptr;
+        tile->atlasSlot = -1;
+    }
+
+    tile->tex = nullptr;
 }
 
 
 void VirtualTexture::makeResident(Tile* tile, unsigned int lod, unsigned int u, unsigned int v)
 {
-    if (tile->tex == nullptr && !tile->loadFailed)
+    if (!tile->isResident() && !tile->loadFailed)
     {
-        // Potentially evict other tiles in order to make this one fit
-        tile->tex = loadTileTexture(lod, u, v);
-        if (tile->tex == nullptr)
+        // A streamed load of the tile may still be in flight; it is
+        // discarded when it completes
+        util::ResourceLoadRecord record;
+        record.requestFrame = GetTextureManager()->getFrame();
+        fs::path path = getTileFilePath(lod, u, v);
+
+        auto start = std::chrono::steady_clock::now();
+        std::unique_ptr<Image> img;
+        {
+        util::FileAccessScope access("tile", path);
+        img = Image::load(path);
+        if (img == nullptr)
+            access.setFailed();
+        }
+        auto decoded = std::chrono::steady_clock::now();
+        record.decodeTime = decoded - start;
+
+        std::size_t memory = 0;
+        bool loaded = img != nullptr && createTileTexture(tile, *img, lod, memory);
+        record.createTime = std::chrono::steady_clock::now() - decoded;
+
+        if (!loaded)
         {
             tile->loadFailed = true;
         }
+        else
+        {
+            addResident(tile, memory);
+        }
+
+        record.failed = !loaded;
+        recordLoad(tile, path, record);
+    }
+}
+
+
+void
+VirtualTexture::requestTile(Tile* tile, unsigned int lod, unsigned int u, unsigned int v, unsigned int error)
+{
+    if (tile->isResident() || tile->loadFailed || tile->queued || tile->decoded.valid())
+        return;
+
+    // Requests which couldn't be started are made again, so keep the frame
+    // of the first one
+    if (tile->requestFrame == 0)
+        tile->requestFrame = GetTextureManager()->getFrame();
+    tile->queued = true;
+    requests.push_back(TileRequest{ tile, lod, u, v, error });
+}
+
+
+void
+VirtualTexture::prefetchChildren(const TileQuadtreeNode* node, unsigned int lod, unsigned int u, unsigned int v)
+{
+    if (lod + 1 >= nResolutionLevels)
+        return;
+
+    for (unsigned int child = 0; child < 4; child++)
+    {
+        const TileQuadtreeNode* childNode = node->children[child].get();
+        if (childNode == nullptr || childNode->tile == nullptr)
+            continue;
+
+        // Prefetches have the lowest priority
+        requestTile(childNode->tile.get(),
+                    lod + 1,
+                    u * 2 + (child & 1),
+                    v * 2 + (child >> 1),
+                    0);
+    }
+}
+
+
+void
+VirtualTexture::startDecodes()
+{
+    // The blurriest tiles go first, and at the same error, the coarser ones,
+    // which cover more of the surface
+    std::sort(requests.begin(), requests.end(),
+              [](const TileRequest& a, const TileRequest& b)
+              {
+                  return a.error != b.error ? a.error > b.error : a.lod < b.lod;
+              });
+
+    // Requests which can't be started now are made again by the next frame
+    // if the tile is still visible
+    for (const TileRequest& request : requests)
+    {
+        Tile* tile = request.tile;
+        tile->queued = false;
+        if (decodingTiles.size() >= MaxDecodingTiles)
+            continue;
+
+        tile->lod = request.lod;
+        tile->decoded = util::GetThreadPool()->async([path = getTileFilePath(request.lod, request.u, request.v)]
+        {
+            auto start = std::chrono::steady_clock::now();
+            util::FileAccessScope access("tile", path);
+            auto img = Image::load(path);
+            if (img == nullptr)
+                access.setFailed();
+            return DecodedTile{ std::move(img), path, std::chrono::steady_clock::now() - start };
+        });
+        decodingTiles.push_back(tile);
+    }
+
+    requests.clear();
+}
+
+
+void
+VirtualTexture::uploadDecodedTiles()
+{
+    auto start = std::chrono::steady_clock::now();
+    bool uploaded = false;
+
+    for (auto it = decodingTiles.begin(); it != decodingTiles.end();)
+    {
+        Tile* tile = *it;
+        if (tile->decoded.wait_for(std::chrono::seconds::zero()) != std::future_status::ready)
+        {
+            ++it;
+            continue;
+        }
+
+        // Upload at least one tile per call so that streaming progresses
+        // however slow the uploads are
+        if (uploaded && std::chrono::steady_clock::now() - start > TileUploadBudget)
+            break;
+
+        DecodedTile decoded = tile->decoded.get();
+        it = decodingTiles.erase(it);
+
+        // The tile may have been loaded synchronously in the meantime
+        if (tile->isResident() || tile->loadFailed)
+            continue;
+
+        auto uploadStart = std::chrono::steady_clock::now();
+        std::size_t memory = 0;
+        bool loaded = decoded.image != nullptr && createTileTexture(tile, *decoded.image, tile->lod, memory);
+
+        if (!loaded)
+            tile->loadFailed = true;
+        else
+            addResident(tile, memory);
+
+        util::ResourceLoadRecord record;
+        record.requestFrame = tile->requestFrame;
+        record.decodeTime = decoded.decodeTime;
+        record.createTime = std::chrono::steady_clock::now() - uploadStart;
+        record.failed = !loaded;
+        recordLoad(tile, decoded.path, record);
+
+        uploaded = true;
     }
 }
 
 
+void
+VirtualTexture::addResident(Tile* tile, std::size_t memory)
+{
+    tile->memory = memory;
+    residentMemory += memory;
+    residentTiles.push_back(tile);
+}
+
+
+void
+VirtualTexture::recordLoad(Tile* tile, const fs::path& path, const util::ResourceLoadRecord& load)
+{
+    auto record = std::make_unique<celestia::engine::TextureLoadRecord>();
+    record->path = path;
+    record->load = load;
+    record->load.readyFrame = GetTextureManager()->getFrame();
+    record->load.memory = tile->memory;
+    record->virtualTile = true;
+    tile->requestFrame = 0;
+
+    // Failures are reported right away, loads when the tile is first drawn
+    if (load.failed)
+        celestia::engine::GetTextureLoadStats()->add(std::move(*record));
+    else
+        tile->loadRecord = std::move(record);
+}
+
+
+void
+VirtualTexture::evictTiles()
+{
+    if (memoryBudget == 0 || residentMemory <= memoryBudget)
+        return;
+
+    std::sort(residentTiles.begin(), residentTiles.end(),
+              [](const Tile* a, const Tile* b) { return a->lastUsed < b->lastUsed; });
+
+    // Tiles drawn in the last frame are never evicted, even when they don't
+    // fit in the budget, as they would only be loaded again right away
+    for (Tile* tile : residentTiles)
+    {
+        if (residentMemory <= memoryBudget || tile->lastUsed + 1 >= ticks)
+            break;
+        if (tile->pinned)
+            continue;
+
+        residentMemory -= tile->memory;
+        tile->memory = 0;
+        tile->loadRecord = nullptr;
+        releaseTile(tile);
+    }
+
+    residentTiles.erase(std::remove_if(residentTiles.begin(), residentTiles.end(),
+                                       [](const Tile* tile) { return !tile->isResident(); }),
+                        residentTiles.end());
+    atlases.erase(std::remove_if(atlases.begin(), atlases.end(),
+                                 [](const auto& atlas) { return atlas->empty(); }),
+                  atlases.end());
+}
+
+
 void VirtualTexture::populateTileTree()
 {
     // Count the number of resolution levels present
@@ -375,6 +715,11 @@ VirtualTexture::addTileToTree(std::unique_ptr<Tile> tile, unsigned int lod, unsi
 }
 
 
+bool VirtualTexture::streaming = false;
+std::size_t VirtualTexture::memoryBudget = 0;
+bool VirtualTexture::tileAtlas = false;
+
+
 std::unique_ptr<VirtualTexture>
 LoadVirtualTexture(const fs::path& filename)
 {
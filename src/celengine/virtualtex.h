@@ -10,11 +10,17 @@
 #pragma once
 
 #include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <future>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include <celcompat/filesystem.h>
 #include <celengine/texture.h>
+#include <celengine/texturestats.h>
 
 class VirtualTexture : public Texture
 {
@@ -34,14 +40,64 @@ public:
     int getVTileCount(int lod) const override;
     void beginUsage() override;
     void endUsage() override;
+    std::size_t getMemoryUsage() const override { return residentMemory; }
+
+    // With streaming enabled, tiles are decoded on background threads and
+    // uploaded by beginUsage under a time budget; until then, getTile returns
+    // the part of the nearest coarser tile which is resident. Least recently
+    // used tiles are evicted when the tiles of one virtual texture take more
+    // than memoryBudget bytes of graphics memory.
+    static void setStreaming(bool enable, std::size_t memoryBudget);
+    static bool getStreaming() { return streaming; }
+
+    // With the tile atlas enabled, tiles below LOD 0 which have the tile size
+    // are packed into shared atlas textures, so that drawing the patches of a
+    // planet mostly doesn't change the bound texture. Tiles of other sizes
+    // and the LOD 0 tiles, which have mipmaps, keep textures of their own.
+    static void setTileAtlas(bool enable);
 
 private:
+    struct DecodedTile
+    {
+        std::unique_ptr<celestia::engine::Image> image;
+        fs::path path;
+        std::chrono::steady_clock::duration decodeTime;
+    };
+
     struct Tile
     {
         Tile() = default;
         unsigned int lastUsed{ 0 };
         std::unique_ptr<ImageTexture> tex{ nullptr };
+        TileAtlas* atlas{ nullptr };
+        int atlasSlot{ -1 };
         bool loadFailed{ false };
+
+        bool isResident() const { return tex != nullptr || atlas != nullptr; }
+
+        // Streaming state
+        std::future<DecodedTile> decoded;
+        std::size_t memory{ 0 };
+        unsigned int lod{ 0 };
+        bool queued{ false };
+        bool pinned{ false };
+
+        // Texture manager frame of the pending request, 0 if there is none,
+        // and the load reported to the texture load stats when the tile is
+        // first drawn
+        std::uint64_t requestFrame{ 0 };
+        std::unique_ptr<celestia::engine::TextureLoadRecord> loadRecord{ nullptr };
+    };
+
+    struct TileRequest
+    {
+        Tile* tile;
+        unsigned int lod;
+        unsigned int u;
+        unsigned int v;
+        // Number of levels between the requested tile and the tile drawn in
+        // its place; each level doubles the texel size on screen
+        unsigned int error;
     };
 
     struct TileQuadtreeNode
@@ -54,13 +110,28 @@ private:
     void populateTileTree();
     void addTileToTree(std::unique_ptr<Tile> tile, unsigned int lod, unsigned int u, unsigned int v);
     void makeResident(Tile* tile, unsigned int lod, unsigned int u, unsigned int v);
-    std::unique_ptr<ImageTexture> loadTileTexture(unsigned int lod, unsigned int u, unsigned int v);
+    fs::path getTileFilePath(unsigned int lod, unsigned int u, unsigned int v) const;
+    bool createTileTexture(Tile* tile,
+                           const celestia::engine::Image& img,
+                           unsigned int lod,
+                           std::size_t& memory);
+    TileAtlas* getAtlas(const celestia::engine::Image& img);
+    void releaseTile(Tile* tile);
+
+    void requestTile(Tile* tile, unsigned int lod, unsigned int u, unsigned int v, unsigned int error);
+    void prefetchChildren(const TileQuadtreeNode* node, unsigned int lod, unsigned int u, unsigned int v);
+    void startDecodes();
+    void uploadDecodedTiles();
+    void addResident(Tile* tile, std::size_t memory);
+    void recordLoad(Tile* tile, const fs::path& path, const celestia::util::ResourceLoadRecord& load);
+    void evictTiles();
 
 private:
     fs::path tilePath;
     fs::path tileExt;
     std::string tilePrefix;
     unsigned int baseSplit{ 0 };
+    unsigned int tileSize{ 0 };
     unsigned int ticks{ 0 };
     unsigned int tilesRequested{ 0 };
     unsigned int nResolutionLevels{ 0 };
@@ -72,6 +143,16 @@ private:
     };
 
     std::array<TileQuadtreeNode, 2> tileTree{};
+
+    std::vector<TileRequest> requests;
+    std::vector<Tile*> decodingTiles;
+    std::vector<Tile*> residentTiles;
+    std::size_t residentMemory{ 0 };
+    std::vector<std::unique_ptr<TileAtlas>> atlases;
+
+    static bool streaming;
+    static std::size_t memoryBudget;
+    static bool tileAtlas;
 };
 
 std::unique_ptr<VirtualTexture>
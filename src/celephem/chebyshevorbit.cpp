@@ -0,0 +1,266 @@
+// chebyshevorbit.cpp
+//
+// Copyright (C) 2024, Celestia Development Team
+//
+// Cache of Chebyshev approximations of expensive orbits.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include "chebyshevorbit.h"
+
+#include <array>
+#include <cmath>
+#include <utility>
+
+#include <celastro/date.h>
+#include <celcompat/numbers.h>
+#include "segments.h"
+
+namespace celestia::ephem
+{
+
+namespace
+{
+
+// Halvings of a segment before the orbit is evaluated directly in it
+constexpr unsigned int MaxDepth = 12;
+
+// Fitted segments kept before the cache is cleared
+constexpr std::size_t MaxSegments = 1024;
+
+constexpr double SegmentsPerPeriod = 8.0;
+constexpr double NonPeriodicSegmentLength = 16.0; // days
+
+constexpr std::size_t CoefficientCount = ChebyshevOrbit::Degree + 1;
+
+double orbitCacheTolerance = 0.0;
+
+// Clenshaw's recurrence for the sum of c[j] T_j(x)
+Eigen::Vector3d
+evaluateSeries(const Eigen::Vector3d* c, std::size_t n, double x)
+{
+    Eigen::Vector3d b1 = Eigen::Vector3d::Zero();
+    Eigen::Vector3d b2 = Eigen::Vector3d::Zero();
+    for (std::size_t j = n - 1; j > 0; --j)
+    {
+        Eigen::Vector3d b0 = 2.0 * x * b1 - b2 + c[j];
+        b2 = b1;
+        b1 = b0;
+    }
+
+    return x * b1 - b2 + c[0];
+}
+
+} // end unnamed namespace
+
+
+struct ChebyshevOrbit::Segment
+{
+    enum class Kind
+    {
+        Fitted,
+        Split,
+        Direct,
+    };
+
+    Kind kind{ Kind::Direct };
+    // Coefficients of the position and of its derivative with respect to
+    // time, over the segment mapped to [-1, 1]
+    std::array<Eigen::Vector3d, CoefficientCount> position;
+    std::array<Eigen::Vector3d, CoefficientCount - 1> velocity;
+    // Halves of a split segment, fitted when they are first needed
+    std::array<std::unique_ptr<Segment>, 2> children;
+};
+
+
+ChebyshevOrbit::ChebyshevOrbit(const std::shared_ptr<const Orbit>& orbit, double tolerance) :
+    primary(orbit),
+    tolerance(tolerance)
+{
+    double period = primary->getPeriod();
+    segmentLength = primary->isPeriodic() && period > 0.0
+        ? period / SegmentsPerPeriod
+        : NonPeriodicSegmentLength;
+}
+
+
+ChebyshevOrbit::~ChebyshevOrbit() = default;
+
+
+void
+ChebyshevOrbit::fit(Segment& segment, double begin, double end, unsigned int depth) const
+{
+    double center = (begin + end) * 0.5;
+    double halfLength = (end - begin) * 0.5;
+
+    // Sample at the Chebyshev nodes
+    std::array<Eigen::Vector3d, CoefficientCount> samples;
+    for (std::size_t k = 0; k < CoefficientCount; ++k)
+    {
+        double x = std::cos(celestia::numbers::pi * (static_cast<double>(k) + 0.5) / static_cast<double>(CoefficientCount));
+        samples[k] = primary->positionAtTime(center + halfLength * x);
+    }
+
+    for (std::size_t j = 0; j < CoefficientCount; ++j)
+    {
+        Eigen::Vector3d c = Eigen::Vector3d::Zero();
+        for (std::size_t k = 0; k < CoefficientCount; ++k)
+        {
+            c += samples[k] * std::cos(celestia::numbers::pi * static_cast<double>(j) * (static_cast<double>(k) + 0.5)
+                                       / static_cast<double>(CoefficientCount));
+        }
+        segment.position[j] = c * ((j == 0 ? 1.0 : 2.0) / static_cast<double>(CoefficientCount));
+    }
+
+    // The last coefficients bound the error of a converged series
+    double error = segment.position[Degree].norm() + segment.position[Degree - 1].norm();
+    if (error > tolerance || !std::isfinite(error))
+    {
+        segment.kind = depth < MaxDepth ? Segment::Kind::Split : Segment::Kind::Direct;
+        return;
+    }
+
+    // Coefficients of the derivative, d[j-1] = d[j+1] + 2 j c[j], scaled
+    // from [-1, 1] to days
+    std::array<Eigen::Vector3d, CoefficientCount + 1> d;
+    d[CoefficientCount] = Eigen::Vector3d::Zero();
+    d[CoefficientCount - 1] = Eigen::Vector3d::Zero();
+    for (std::size_t j = CoefficientCount - 1; j > 0; --j)
+        d[j - 1] = d[j + 1] + 2.0 * static_cast<double>(j) * segment.position[j];
+    d[0] *= 0.5;
+
+    for (std::size_t j = 0; j < CoefficientCount - 1; ++j)
+        segment.velocity[j] = d[j] / halfLength;
+
+    segment.kind = Segment::Kind::Fitted;
+    ++segmentCount;
+}
+
+
+const ChebyshevOrbit::Segment&
+ChebyshevOrbit::findSegment(double jd, double& begin, double& end) const
+{
+    static const Segment direct;
+
+    double index = std::floor((jd - astro::J2000) / segmentLength);
+    if (!(std::abs(index) < MaxSegmentIndex))
+        return direct;
+
+    begin = astro::J2000 + index * segmentLength;
+    end = begin + segmentLength;
+
+    auto it = segments.find(static_cast<std::int64_t>(index));
+    if (it == segments.end())
+    {
+        if (segmentCount >= MaxSegments)
+        {
+            segments.clear();
+            segmentCount = 0;
+        }
+
+        it = segments.try_emplace(static_cast<std::int64_t>(index), std::make_unique<Segment>()).first;
+        fit(*it->second, begin, end, 0);
+    }
+
+    Segment* segment = it->second.get();
+    for (unsigned int depth = 1; segment->kind == Segment::Kind::Split; ++depth)
+    {
+        double middle = (begin + end) * 0.5;
+        std::size_t half = jd < middle ? 0 : 1;
+        if (half == 0)
+            end = middle;
+        else
+            begin = middle;
+
+        std::unique_ptr<Segment>& child = segment->children[half];
+        if (child == nullptr)
+        {
+            child = std::make_unique<Segment>();
+            fit(*child, begin, end, depth);
+        }
+
+        segment = child.get();
+    }
+
+    return *segment;
+}
+
+
+Eigen::Vector3d
+ChebyshevOrbit::positionAtTime(double jd) const
+{
+    double begin = 0.0;
+    double end = 0.0;
+    const Segment& segment = findSegment(jd, begin, end);
+    if (segment.kind != Segment::Kind::Fitted)
+        return primary->positionAtTime(jd);
+
+    double halfLength = (end - begin) * 0.5;
+    double x = (jd - (begin + halfLength)) / halfLength;
+    return evaluateSeries(segment.position.data(), segment.position.size(), x);
+}
+
+
+Eigen::Vector3d
+ChebyshevOrbit::velocityAtTime(double jd) const
+{
+    double begin = 0.0;
+    double end = 0.0;
+    const Segment& segment = findSegment(jd, begin, end);
+    if (segment.kind != Segment::Kind::Fitted)
+        return primary->velocityAtTime(jd);
+
+    double halfLength = (end - begin) * 0.5;
+    double x = (jd - (begin + halfLength)) / halfLength;
+    return evaluateSeries(segment.velocity.data(), segment.velocity.size(), x);
+}
+
+
+double
+ChebyshevOrbit::getPeriod() const
+{
+    return primary->getPeriod();
+}
+
+
+double
+ChebyshevOrbit::getBoundingRadius() const
+{
+    return primary->getBoundingRadius();
+}
+
+
+bool
+ChebyshevOrbit::isPeriodic() const
+{
+    return primary->isPeriodic();
+}
+
+
+void
+ChebyshevOrbit::getValidRange(double& begin, double& end) const
+{
+    primary->getValidRange(begin, end);
+}
+
+
+void
+SetOrbitCacheTolerance(double tolerance)
+{
+    orbitCacheTolerance = tolerance;
+}
+
+
+std::shared_ptr<const Orbit>
+CreateCachedOrbit(const std::shared_ptr<const Orbit>& orbit)
+{
+    if (orbit == nullptr || !(orbitCacheTolerance > 0.0))
+        return orbit;
+
+    return std::make_shared<ChebyshevOrbit>(orbit, orbitCacheTolerance);
+}
+
+} // end namespace celestia::ephem
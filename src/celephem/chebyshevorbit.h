@@ -0,0 +1,74 @@
+// chebyshevorbit.h
+//
+// Copyright (C) 2024, Celestia Development Team
+//
+// Cache of Chebyshev approximations of expensive orbits.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+
+#include <Eigen/Core>
+
+#include "orbit.h"
+
+namespace celestia::ephem
+{
+
+/*! Approximates another orbit by Chebyshev polynomials over segments of
+ *  time, so that evaluating it at many different times costs a few
+ *  polynomial terms instead of the full theory. The segments are fitted
+ *  when a time in them is first requested and split in halves until the
+ *  estimated error is within the tolerance. Where no fit is found, e.g.
+ *  across a discontinuity, the other orbit is evaluated directly.
+ */
+class ChebyshevOrbit : public Orbit
+{
+ public:
+    static constexpr std::size_t Degree = 16;
+
+    // Tolerance in kilometers
+    ChebyshevOrbit(const std::shared_ptr<const Orbit>& orbit, double tolerance);
+    ~ChebyshevOrbit() override;
+
+    Eigen::Vector3d positionAtTime(double jd) const override;
+    Eigen::Vector3d velocityAtTime(double jd) const override;
+    double getPeriod() const override;
+    double getBoundingRadius() const override;
+    bool isPeriodic() const override;
+    void getValidRange(double& begin, double& end) const override;
+
+    // Number of fitted segments, for tests
+    std::size_t getSegmentCount() const { return segmentCount; }
+
+ private:
+    struct Segment;
+
+    const Segment& findSegment(double jd, double& begin, double& end) const;
+    void fit(Segment& segment, double begin, double end, unsigned int depth) const;
+
+    std::shared_ptr<const Orbit> primary;
+    double tolerance;
+    double segmentLength;
+
+    mutable std::map<std::int64_t, std::unique_ptr<Segment>> segments;
+    mutable std::size_t segmentCount{ 0 };
+};
+
+// Sets the tolerance of the approximations returned by CreateCachedOrbit,
+// in kilometers; zero disables them
+void SetOrbitCacheTolerance(double tolerance);
+
+// Returns the orbit approximated by a ChebyshevOrbit if a tolerance is set,
+// otherwise the orbit itself
+std::shared_ptr<const Orbit> CreateCachedOrbit(const std::shared_ptr<const Orbit>& orbit);
+
+} // end namespace celestia::ephem
@@ -21,10 +21,12 @@
 
 #include <celastro/astro.h>
 #include <celastro/date.h>
+#include <celcompat/filesystem.h>
 #include <celcompat/numbers.h>
 #include <celmath/mathlib.h>
 #include <celmath/geomutil.h>
 #include <celutil/logger.h>
+#include "chebyshevorbit.h"
 #include "jpleph.h"
 #include "orbit.h"
 #include "vsop87.h"
@@ -3102,9 +3104,16 @@ CreateJPLEphOrbit(JPLEphemItem target,
     if (!jplephInitialized)
     {
         jplephInitialized = true;
-        std::ifstream in("data/jpleph.dat", std::ios::in | std::ios::binary);
-        if (in.good())
-            jpleph = JPLEphemeris::load(in);
+        const fs::path jplephPath("data/jpleph.dat");
+        // Map the file so that only the records in use are decoded, and fall
+        // back to reading it if it can't be mapped into the address space
+        jpleph = JPLEphemeris::load(jplephPath);
+        if (jpleph == nullptr)
+        {
+            std::ifstream in(jplephPath, std::ios::in | std::ios::binary);
+            if (in.good())
+                jpleph = JPLEphemeris::load(in);
+        }
         if (jpleph != nullptr)
         {
             if (unsigned int deNumber = jpleph->getDENumber(); deNumber != 100)
@@ -3672,7 +3681,7 @@ CustomOrbitsManager::getOrbit(CustomOrbitType type)
     if (auto cachedOrbit = weak_ptr.lock(); cachedOrbit != nullptr)
         return cachedOrbit;
 
-    auto orbit = factories[index]();
+    auto orbit = CreateCachedOrbit(factories[index]());
     weak_ptr = orbit;
     return orbit;
 }
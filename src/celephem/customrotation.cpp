@@ -24,6 +24,7 @@
 #include <celastro/date.h>
 #include <celmath/geomutil.h>
 #include <celmath/mathlib.h>
+#include "interpolatedrotation.h"
 #include "precession.h"
 #include "rotation.h"
 
@@ -943,7 +944,7 @@ CustomRotationsManager::getModel(CustomRotationModelType type)
     auto model = models[index].lock();
     if (model == nullptr)
     {
-        model = createModel(type);
+        model = CreateCachedRotationModel(createModel(type));
         models[index] = model;
     }
 
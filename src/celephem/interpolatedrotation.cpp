@@ -0,0 +1,242 @@
+// interpolatedrotation.cpp
+//
+// Copyright (C) 2024, Celestia Development Team
+//
+// Cache of interpolated orientations of expensive rotation models.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include "interpolatedrotation.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+#include <celastro/date.h>
+#include "segments.h"
+
+namespace celestia::ephem
+{
+
+namespace
+{
+
+// Halvings of a segment before the model is evaluated directly in it
+constexpr unsigned int MaxDepth = 10;
+
+// Sampled segments kept before the cache is cleared
+constexpr std::size_t MaxSegments = 1024;
+
+// Keep segments short enough that the spin between their ends is well
+// below half a turn, where slerp would take the other way round
+constexpr double SegmentsPerPeriod = 16.0;
+constexpr double NonPeriodicSegmentLength = 1.0; // days
+
+double rotationCacheTolerance = 0.0;
+
+} // end unnamed namespace
+
+
+struct InterpolatedRotation::Segment
+{
+    enum class Kind
+    {
+        Sampled,
+        Split,
+        Direct,
+    };
+
+    Kind kind{ Kind::Direct };
+    // Spin and equator orientation at the ends of the segment
+    Eigen::Quaterniond spin0;
+    Eigen::Quaterniond spin1;
+    Eigen::Quaterniond equator0;
+    Eigen::Quaterniond equator1;
+    // Halves of a split segment, sampled when they are first needed
+    std::array<std::unique_ptr<Segment>, 2> children;
+};
+
+
+InterpolatedRotation::InterpolatedRotation(const std::shared_ptr<const RotationModel>& model,
+                                           double tolerance) :
+    primary(model),
+    tolerance(tolerance)
+{
+    double period = primary->getPeriod();
+    segmentLength = primary->isPeriodic() && period > 0.0
+        ? period / SegmentsPerPeriod
+        : NonPeriodicSegmentLength;
+}
+
+
+InterpolatedRotation::~InterpolatedRotation() = default;
+
+
+void
+InterpolatedRotation::sample(Segment& segment, double begin, double end, unsigned int depth) const
+{
+    segment.spin0 = primary->spin(begin);
+    segment.spin1 = primary->spin(end);
+    segment.equator0 = primary->equatorOrientationAtTime(begin);
+    segment.equator1 = primary->equatorOrientationAtTime(end);
+
+    // The interpolation is furthest from the model near the middle
+    double middle = (begin + end) * 0.5;
+    double error = std::max(primary->spin(middle).angularDistance(segment.spin0.slerp(0.5, segment.spin1)),
+                            primary->equatorOrientationAtTime(middle)
+                                .angularDistance(segment.equator0.slerp(0.5, segment.equator1)));
+    if (error > tolerance || !std::isfinite(error))
+    {
+        segment.kind = depth < MaxDepth ? Segment::Kind::Split : Segment::Kind::Direct;
+        return;
+    }
+
+    segment.kind = Segment::Kind::Sampled;
+    ++segmentCount;
+}
+
+
+const InterpolatedRotation::Segment&
+InterpolatedRotation::findSegment(double tjd, double& begin, double& end) const
+{
+    static const Segment direct;
+
+    double index = std::floor((tjd - astro::J2000) / segmentLength);
+    if (!(std::abs(index) < MaxSegmentIndex))
+        return direct;
+
+    begin = astro::J2000 + index * segmentLength;
+    end = begin + segmentLength;
+
+    auto it = segments.find(static_cast<std::int64_t>(index));
+    if (it == segments.end())
+    {
+        if (segmentCount >= MaxSegments)
+        {
+            segments.clear();
+            segmentCount = 0;
+        }
+
+        it = segments.try_emplace(static_cast<std::int64_t>(index), std::make_unique<Segment>()).first;
+        sample(*it->second, begin, end, 0);
+    }
+
+    Segment* segment = it->second.get();
+    for (unsigned int depth = 1; segment->kind == Segment::Kind::Split; ++depth)
+    {
+        double middle = (begin + end) * 0.5;
+        std::size_t half = tjd < middle ? 0 : 1;
+        if (half == 0)
+            end = middle;
+        else
+            begin = middle;
+
+        std::unique_ptr<Segment>& child = segment->children[half];
+        if (child == nullptr)
+        {
+            child = std::make_unique<Segment>();
+            sample(*child, begin, end, depth);
+        }
+
+        segment = child.get();
+    }
+
+    return *segment;
+}
+
+
+Eigen::Quaterniond
+InterpolatedRotation::spin(double tjd) const
+{
+    double begin = 0.0;
+    double end = 0.0;
+    const Segment& segment = findSegment(tjd, begin, end);
+    if (segment.kind != Segment::Kind::Sampled)
+        return primary->spin(tjd);
+
+    return segment.spin0.slerp((tjd - begin) / (end - begin), segment.spin1);
+}
+
+
+Eigen::Quaterniond
+InterpolatedRotation::equatorOrientationAtTime(double tjd) const
+{
+    double begin = 0.0;
+    double end = 0.0;
+    const Segment& segment = findSegment(tjd, begin, end);
+    if (segment.kind != Segment::Kind::Sampled)
+        return primary->equatorOrientationAtTime(tjd);
+
+    return segment.equator0.slerp((tjd - begin) / (end - begin), segment.equator1);
+}
+
+
+// Times within the segment of the previous time are interpolated without
+// looking the segment up again
+void
+InterpolatedRotation::computeOrientations(const double* tjd,
+                                          Eigen::Quaterniond* orientations,
+                                          std::size_t count) const
+{
+    const Segment* segment = nullptr;
+    double begin = 0.0;
+    double end = 0.0;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        if (segment == nullptr || !(tjd[i] >= begin && tjd[i] < end))
+            segment = &findSegment(tjd[i], begin, end);
+
+        if (segment->kind != Segment::Kind::Sampled)
+        {
+            orientations[i] = primary->orientationAtTime(tjd[i]);
+            segment = nullptr;
+            continue;
+        }
+
+        double t = (tjd[i] - begin) / (end - begin);
+        orientations[i] = segment->spin0.slerp(t, segment->spin1) * segment->equator0.slerp(t, segment->equator1);
+    }
+}
+
+
+double
+InterpolatedRotation::getPeriod() const
+{
+    return primary->getPeriod();
+}
+
+
+bool
+InterpolatedRotation::isPeriodic() const
+{
+    return primary->isPeriodic();
+}
+
+
+void
+InterpolatedRotation::getValidRange(double& begin, double& end) const
+{
+    primary->getValidRange(begin, end);
+}
+
+
+void
+SetRotationCacheTolerance(double tolerance)
+{
+    rotationCacheTolerance = tolerance;
+}
+
+
+std::shared_ptr<const RotationModel>
+CreateCachedRotationModel(const std::shared_ptr<const RotationModel>& model)
+{
+    if (model == nullptr || !(rotationCacheTolerance > 0.0))
+        return model;
+
+    return std::make_shared<InterpolatedRotation>(model, rotationCacheTolerance);
+}
+
+} // end namespace celestia::ephem
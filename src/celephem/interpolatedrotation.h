@@ -0,0 +1,74 @@
+// interpolatedrotation.h
+//
+// Copyright (C) 2024, Celestia Development Team
+//
+// Cache of interpolated orientations of expensive rotation models.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+
+#include "rotation.h"
+
+namespace celestia::ephem
+{
+
+/*! Approximates another rotation model by interpolating its spin and
+ *  equator orientation between samples over segments of time. The
+ *  segments are sampled when a time in them is first requested and split
+ *  in halves until the interpolation is within the tolerance at their
+ *  middle. Where no segment is accurate enough, the other model is
+ *  evaluated directly.
+ */
+class InterpolatedRotation : public RotationModel
+{
+ public:
+    // Tolerance in radians
+    InterpolatedRotation(const std::shared_ptr<const RotationModel>& model, double tolerance);
+    ~InterpolatedRotation() override;
+
+    Eigen::Quaterniond spin(double tjd) const override;
+    Eigen::Quaterniond equatorOrientationAtTime(double tjd) const override;
+    void computeOrientations(const double* tjd, Eigen::Quaterniond* orientations, std::size_t count) const override;
+
+    double getPeriod() const override;
+    bool isPeriodic() const override;
+    void getValidRange(double& begin, double& end) const override;
+
+    // Number of sampled segments, for tests
+    std::size_t getSegmentCount() const { return segmentCount; }
+
+ private:
+    struct Segment;
+
+    const Segment& findSegment(double tjd, double& begin, double& end) const;
+    void sample(Segment& segment, double begin, double end, unsigned int depth) const;
+
+    std::shared_ptr<const RotationModel> primary;
+    double tolerance;
+    double segmentLength;
+
+    mutable std::map<std::int64_t, std::unique_ptr<Segment>> segments;
+    mutable std::size_t segmentCount{ 0 };
+};
+
+// Sets the tolerance of the approximations returned by
+// CreateCachedRotationModel, in radians; zero disables them
+void SetRotationCacheTolerance(double tolerance);
+
+// Returns the model approximated by an InterpolatedRotation if a tolerance
+// is set, otherwise the model itself
+std::shared_ptr<const RotationModel> CreateCachedRotationModel(const std::shared_ptr<const RotationModel>& model);
+
+} // end namespace celestia::ephem
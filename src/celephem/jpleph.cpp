@@ -15,9 +15,13 @@
 #include <cstddef>
 #include <cstring>
 #include <istream>
+#include <memory>
 #include <type_traits>
+#include <utility>
+#include <vector>
 
 #include <celcompat/bit.h>
+#include <celutil/mappedfile.h>
 #include "jpleph.h"
 
 namespace celestia::ephem
@@ -62,6 +66,9 @@ constexpr unsigned int LabelSize = 84;
 constexpr unsigned int INPOP_DE_COMPATIBLE = 100;
 constexpr unsigned int DE200 = 200;
 
+// Number of decoded records kept for a mapped ephemeris
+constexpr std::size_t RecordCacheSize = 8;
+
 // Read a big-endian or little endian 32-bit unsigned integer
 std::uint32_t readUint(std::istream& in, bool swap)
 {
@@ -70,17 +77,6 @@ std::uint32_t readUint(std::istream& in, bool swap)
     return swap ? compat::byteswap(ret) : ret;
 }
 
-// Read a big-endian or little endian 64-bit IEEE double.
-// If the native double format isn't IEEE 754, there will be troubles.
-double readDouble(std::istream& in, bool swap)
-{
-    char data[sizeof(double)];
-    in.read(data, sizeof(double)); /* Flawfinder: ignore */
-    double d;
-    getMaybeSwapDouble(d, data, swap);
-    return d;
-}
-
 #pragma pack(push, 1)
 
 // These packed structs are only used for offset calculations, they should
@@ -134,6 +130,8 @@ static_assert(std::is_standard_layout_v<JPLEFileHeader>);
 } // end unnamed namespace
 
 
+JPLEphemeris::~JPLEphemeris() = default;
+
 unsigned int JPLEphemeris::getDENumber() const
 {
     return DENum;
@@ -192,9 +190,9 @@ Eigen::Vector3d JPLEphemeris::getPlanetPosition(JPLEphemItem planet, double tjd)
     // recNo is always >= 0:
     auto recNo = (unsigned int) ((tjd - startDate) / daysPerInterval);
     // Make sure we don't go past the end of the array if t == endDate
-    if (recNo >= records.size())
-        recNo = records.size() - 1;
-    const JPLEphRecord* rec = &records[recNo];
+    if (recNo >= nRecords)
+        recNo = nRecords - 1;
+    const JPLEphRecord* rec = &getRecord(recNo);
 
     auto planetIdx = static_cast<std::size_t>(planet);
 
@@ -243,18 +241,14 @@ Eigen::Vector3d JPLEphemeris::getPlanetPosition(JPLEphemItem planet, double tjd)
 }
 
 
-JPLEphemeris* JPLEphemeris::load(std::istream& in)
+// Decode the header from the start of the first record. Except for INPOP
+// ephemerides, this also determines the record size.
+bool JPLEphemeris::parseHeader(const char* header)
 {
-    std::array<char, sizeof(JPLEFileHeader)> fh;
-    in.read(fh.data(), fh.size()); /* Flawfinder: ignore */
-    if (!in.good())
-        return nullptr;
-
     decltype(JPLEFileHeader::deNum) deNum;
-    std::memcpy(&deNum, fh.data() + offsetof(JPLEFileHeader, deNum), sizeof(deNum));
+    std::memcpy(&deNum, header + offsetof(JPLEFileHeader, deNum), sizeof(deNum));
     std::uint32_t deNum2 = compat::byteswap(deNum);
 
-    bool swapBytes;
     if (deNum == INPOP_DE_COMPATIBLE)
     {
         // INPOP ephemeris with same endianess as CPU
@@ -280,51 +274,120 @@ JPLEphemeris* JPLEphemeris::load(std::istream& in)
     else
     {
         // something unknown or broken
-        return nullptr;
+        return false;
     }
 
-    auto *eph = new JPLEphemeris();
-    eph->swapBytes = swapBytes;
-    eph->DENum = deNum;
+    DENum = deNum;
 
     // Read the start time, end time, and time interval
-    getMaybeSwapDouble(eph->startDate,          fh.data() + offsetof(JPLEFileHeader, startDate),          swapBytes);
-    getMaybeSwapDouble(eph->endDate,            fh.data() + offsetof(JPLEFileHeader, endDate),            swapBytes);
-    getMaybeSwapDouble(eph->daysPerInterval,    fh.data() + offsetof(JPLEFileHeader, daysPerInterval),    swapBytes);
+    getMaybeSwapDouble(startDate,          header + offsetof(JPLEFileHeader, startDate),          swapBytes);
+    getMaybeSwapDouble(endDate,            header + offsetof(JPLEFileHeader, endDate),            swapBytes);
+    getMaybeSwapDouble(daysPerInterval,    header + offsetof(JPLEFileHeader, daysPerInterval),    swapBytes);
     // kilometers per astronomical unit
-    getMaybeSwapDouble(eph->au,                 fh.data() + offsetof(JPLEFileHeader, au),                 swapBytes);
-    getMaybeSwapDouble(eph->earthMoonMassRatio, fh.data() + offsetof(JPLEFileHeader, earthMoonMassRatio), swapBytes);
+    getMaybeSwapDouble(au,                 header + offsetof(JPLEFileHeader, au),                 swapBytes);
+    getMaybeSwapDouble(earthMoonMassRatio, header + offsetof(JPLEFileHeader, earthMoonMassRatio), swapBytes);
+
+    double span = (endDate - startDate) / daysPerInterval;
+    if (!(daysPerInterval > 0.0) || !(span >= 1.0 && span < 4.0e9))
+        return false;
+    nRecords = (unsigned int) span;
 
     // Read the coefficient information for each item in the ephemeris
-    eph->recordSize = 0;
+    recordSize = 0;
     for (unsigned int i = 0; i < JPLEph_NItems; i++)
     {
-        const char* coeffInfo = fh.data() + offsetof(JPLEFileHeader, coeffInfo) + i * sizeof(JPLECoeff);
-        getMaybeSwapUint32(eph->coeffInfo[i].offset,    coeffInfo + offsetof(JPLECoeff, offset),    swapBytes);
-        getMaybeSwapUint32(eph->coeffInfo[i].nCoeffs,   coeffInfo + offsetof(JPLECoeff, nCoeffs),   swapBytes);
-        getMaybeSwapUint32(eph->coeffInfo[i].nGranules, coeffInfo + offsetof(JPLECoeff, nGranules), swapBytes);
-        eph->coeffInfo[i].offset -= 3;
+        const char* itemCoeffInfo = header + offsetof(JPLEFileHeader, coeffInfo) + i * sizeof(JPLECoeff);
+        getMaybeSwapUint32(coeffInfo[i].offset,    itemCoeffInfo + offsetof(JPLECoeff, offset),    swapBytes);
+        getMaybeSwapUint32(coeffInfo[i].nCoeffs,   itemCoeffInfo + offsetof(JPLECoeff, nCoeffs),   swapBytes);
+        getMaybeSwapUint32(coeffInfo[i].nGranules, itemCoeffInfo + offsetof(JPLECoeff, nGranules), swapBytes);
+        coeffInfo[i].offset -= 3;
         // last item is the nutation ephemeris (only 2 components)
-        unsigned nRecords = i == JPLEph_NItems - 1 ? 2 : 3;
-        eph->recordSize += eph->coeffInfo[i].nCoeffs * eph->coeffInfo[i].nGranules * nRecords;
+        unsigned nComponents = i == JPLEph_NItems - 1 ? 2 : 3;
+        recordSize += coeffInfo[i].nCoeffs * coeffInfo[i].nGranules * nComponents;
     }
 
-    const char* librationCoeffInfo = fh.data() + offsetof(JPLEFileHeader, librationCoeffInfo);
-    getMaybeSwapUint32(eph->librationCoeffInfo.offset,    librationCoeffInfo + offsetof(JPLECoeff, offset),    swapBytes);
-    getMaybeSwapUint32(eph->librationCoeffInfo.nCoeffs,   librationCoeffInfo + offsetof(JPLECoeff, nCoeffs),   swapBytes);
-    getMaybeSwapUint32(eph->librationCoeffInfo.nGranules, librationCoeffInfo + offsetof(JPLECoeff, nGranules), swapBytes);
-    eph->recordSize += eph->librationCoeffInfo.nCoeffs * eph->librationCoeffInfo.nGranules * 3;
-    eph->recordSize += 2;   // record start and end time
+    const char* libration = header + offsetof(JPLEFileHeader, librationCoeffInfo);
+    getMaybeSwapUint32(librationCoeffInfo.offset,    libration + offsetof(JPLECoeff, offset),    swapBytes);
+    getMaybeSwapUint32(librationCoeffInfo.nCoeffs,   libration + offsetof(JPLECoeff, nCoeffs),   swapBytes);
+    getMaybeSwapUint32(librationCoeffInfo.nGranules, libration + offsetof(JPLECoeff, nGranules), swapBytes);
+    recordSize += librationCoeffInfo.nCoeffs * librationCoeffInfo.nGranules * 3;
+    recordSize += 2;   // record start and end time
+
+    return true;
+}
+
+// Decode a record of recordSize doubles; the first two are the start and
+// end time of the record, and the rest are the coefficients.
+// If the native double format isn't IEEE 754, there will be troubles.
+void JPLEphemeris::decodeRecord(const char* data, JPLEphRecord& record) const
+{
+    getMaybeSwapDouble(record.t0, data, swapBytes);
+    getMaybeSwapDouble(record.t1, data + sizeof(double), swapBytes);
+
+    record.coeffs.resize(recordSize - 2);
+    const char* coeffs = data + 2 * sizeof(double);
+    if (!swapBytes)
+    {
+        std::memcpy(record.coeffs.data(), coeffs, record.coeffs.size() * sizeof(double));
+        return;
+    }
+
+    for (std::size_t i = 0; i < record.coeffs.size(); i++)
+        getMaybeSwapDouble(record.coeffs[i], coeffs + i * sizeof(double), swapBytes);
+}
+
+const JPLEphRecord& JPLEphemeris::getRecord(unsigned int recNo) const
+{
+    if (file == nullptr)
+        return records[recNo];
+
+    ++recordCacheClock;
+    CachedRecord* leastRecent = &recordCache.front();
+    for (CachedRecord& cached : recordCache)
+    {
+        if (cached.recNo == recNo)
+        {
+            cached.lastUse = recordCacheClock;
+            return cached.record;
+        }
+
+        if (cached.lastUse < leastRecent->lastUse)
+            leastRecent = &cached;
+    }
+
+    // The first two records are the header and the constants
+    std::size_t recordBytes = std::size_t(recordSize) * sizeof(double);
+    decodeRecord(file->data() + (std::size_t(recNo) + 2) * recordBytes, leastRecent->record);
+    leastRecent->recNo = recNo;
+    leastRecent->lastUse = recordCacheClock;
+    return leastRecent->record;
+}
+
+
+JPLEphemeris* JPLEphemeris::load(std::istream& in)
+{
+    std::array<char, sizeof(JPLEFileHeader)> fh;
+    in.read(fh.data(), fh.size()); /* Flawfinder: ignore */
+    if (!in.good())
+        return nullptr;
+
+    std::unique_ptr<JPLEphemeris> eph(new JPLEphemeris());
+    if (!eph->parseHeader(fh.data()))
+        return nullptr;
 
     // if INPOP ephemeris, read record size
-    if (deNum == INPOP_DE_COMPATIBLE)
+    if (eph->DENum == INPOP_DE_COMPATIBLE)
     {
        eph->recordSize = readUint(in, eph->swapBytes);
+       if (eph->recordSize * 8 < sizeof(JPLEFileHeader) + sizeof(uint32_t))
+           return nullptr;
        // Skip past the rest of the record
        in.ignore(eph->recordSize * 8 - sizeof(JPLEFileHeader) - sizeof(uint32_t));
     }
     else
     {
+        if (eph->recordSize * 8 < sizeof(JPLEFileHeader))
+            return nullptr;
         // Skip past the rest of the record
         in.ignore(eph->recordSize * 8 - sizeof(JPLEFileHeader));
     }
@@ -332,34 +395,54 @@ JPLEphemeris* JPLEphemeris::load(std::istream& in)
     // The next record contains constant values (which we don't need)
     in.ignore(eph->recordSize * 8);
     if (!in.good())
-    {
-        delete eph;
         return nullptr;
-    }
 
-    auto nRecords = (unsigned int) ((eph->endDate - eph->startDate) /
-                        eph->daysPerInterval);
-    eph->records.resize(nRecords);
-    for (unsigned int i = 0; i < nRecords; i++)
+    std::vector<char> buffer(std::size_t(eph->recordSize) * sizeof(double));
+    eph->records.resize(eph->nRecords);
+    for (JPLEphRecord& record : eph->records)
     {
-        eph->records[i].t0 = readDouble(in, eph->swapBytes);
-        eph->records[i].t1 = readDouble(in, eph->swapBytes);
-
-        // Allocate coefficient array for this record; the first two
-        // 'coefficients' are actually the start and end time (t0 and t1)
-        eph->records[i].coeffs.reserve(eph->recordSize - 2);
-        for (unsigned int j = 0; j < eph->recordSize - 2; j++)
-            eph->records[i].coeffs.push_back(readDouble(in, eph->swapBytes));
-
+        in.read(buffer.data(), buffer.size()); /* Flawfinder: ignore */
         // Make sure that we read this record successfully
         if (!in.good())
-        {
-            delete eph;
             return nullptr;
-        }
+
+        eph->decodeRecord(buffer.data(), record);
+    }
+
+    return eph.release();
+}
+
+
+JPLEphemeris* JPLEphemeris::load(const fs::path& path)
+{
+    auto file = util::MappedFile::open(path);
+    if (file == nullptr || file->size() < sizeof(JPLEFileHeader))
+        return nullptr;
+
+    std::unique_ptr<JPLEphemeris> eph(new JPLEphemeris());
+    if (!eph->parseHeader(file->data()))
+        return nullptr;
+
+    // if INPOP ephemeris, read record size
+    if (eph->DENum == INPOP_DE_COMPATIBLE)
+    {
+        if (file->size() < sizeof(JPLEFileHeader) + sizeof(std::uint32_t))
+            return nullptr;
+        getMaybeSwapUint32(eph->recordSize, file->data() + sizeof(JPLEFileHeader), eph->swapBytes);
+    }
+
+    // The header record, the constants record and the data records must
+    // all be present, but they are only decoded when needed
+    std::size_t recordBytes = std::size_t(eph->recordSize) * sizeof(double);
+    if (recordBytes < sizeof(JPLEFileHeader) + sizeof(std::uint32_t) ||
+        file->size() / recordBytes < std::size_t(eph->nRecords) + 2)
+    {
+        return nullptr;
     }
 
-    return eph;
+    eph->file = std::move(file);
+    eph->recordCache.resize(RecordCacheSize);
+    return eph.release();
 }
 
 } // end namespace celestia::ephem
@@ -16,10 +16,18 @@
 #include <cstddef>
 #include <cstdint>
 #include <iosfwd>
+#include <memory>
 #include <vector>
 
 #include <Eigen/Core>
 
+#include <celcompat/filesystem.h>
+
+namespace celestia::util
+{
+class MappedFile;
+}
+
 namespace celestia::ephem
 {
 
@@ -68,11 +76,14 @@ private:
 public:
     static constexpr std::size_t JPLEph_NItems = 12;
 
-    ~JPLEphemeris() = default;
+    ~JPLEphemeris();
 
     Eigen::Vector3d getPlanetPosition(JPLEphemItem, double t) const;
 
     static JPLEphemeris* load(std::istream&);
+    // Maps the file instead of reading it: only the header is decoded here,
+    // and the records are decoded when they are first needed
+    static JPLEphemeris* load(const fs::path&);
 
     unsigned int getDENumber() const;
     double getStartDate() const;
@@ -81,6 +92,17 @@ public:
     unsigned int getRecordSize() const;
 
 private:
+    struct CachedRecord
+    {
+        unsigned int recNo{ ~0u };
+        std::uint64_t lastUse{ 0 };
+        JPLEphRecord record{ };
+    };
+
+    bool parseHeader(const char* header);
+    void decodeRecord(const char* data, JPLEphRecord& record) const;
+    const JPLEphRecord& getRecord(unsigned int recNo) const;
+
     std::array<JPLEphCoeffInfo, JPLEph_NItems> coeffInfo;
     JPLEphCoeffInfo librationCoeffInfo;
 
@@ -95,7 +117,16 @@ private:
     unsigned int recordSize;  // number of doubles per record
     bool swapBytes;
 
+    unsigned int nRecords;
+
+    // Records of a loaded ephemeris
     std::vector<JPLEphRecord> records;
+
+    // Records of a mapped ephemeris, with the most recently used ones
+    // decoded. Like the caching orbits, this isn't thread safe.
+    std::unique_ptr<util::MappedFile> file;
+    mutable std::vector<CachedRecord> recordCache;
+    mutable std::uint64_t recordCacheClock{ 0 };
 };
 
 } // end namespace celestia::ephem
@@ -21,6 +21,7 @@
 #include <celmath/mathlib.h>
 #include <celmath/solve.h>
 #include <celmath/geomutil.h>
+#include <celutil/profiler.h>
 #include "rotation.h"
 
 namespace celestia::ephem
@@ -139,10 +140,11 @@ CreateKeplerOrbit(const astro::KeplerElements& elements, double epoch)
   *
   * Subclasses of orbit should override this method as necessary. The default
   * implementation uses an adaptive sampling scheme with the following defaults:
-  *    tolerance: 1 km
-  *    start step: T / 1e5
+  *    tolerance: 1 km, or the angular tolerance of the sample proc at the
+  *               distance of the orbit, whichever is larger
+  *    start step: T / 1000
   *    min step: T / 1e7
-  *    max step: T / 100
+  *    max step: T / 20
   *
   * Where T is either the mean orbital period for periodic orbits or the valid
   * time span for aperiodic trajectories.
@@ -171,25 +173,51 @@ void Orbit::sample(double startTime, double endTime, OrbitSampleProc& proc) cons
 
     AdaptiveSamplingParameters samplingParams;
     samplingParams.tolerance = 1.0; // kilometers
-    samplingParams.maxStep = span / 100.0;
+    samplingParams.angularTolerance = proc.angularTolerance();
+    samplingParams.maxStep = span / 20.0;
     samplingParams.minStep = span / 1.0e7;
-    samplingParams.startStep = span / 1.0e5;
+    samplingParams.startStep = span / 1000.0;
 
     adaptiveSample(startTime, endTime, proc, samplingParams);
 }
 
 
 /** Adaptively sample the orbit over the range [ startTime, endTime ].
+  *
+  * Each step is the longest for which the cubic Hermite interpolation of the
+  * end points deviates from the orbit at the midpoint by no more than the
+  * tolerance. The search for a step starts from the previous one, so that
+  * only a few positions are computed per sample where the curvature changes
+  * slowly.
   */
 void Orbit::adaptiveSample(double startTime, double endTime, OrbitSampleProc& proc, const AdaptiveSamplingParameters& samplingParams) const
 {
-    double startStepSize = samplingParams.startStep;
-    double maxStepSize   = samplingParams.maxStep;
-    double minStepSize   = samplingParams.minStep;
-    double tolerance     = samplingParams.tolerance;
-    double t = startTime;
+    const double minStepSize = samplingParams.minStep;
     const double stepFactor = 1.25;
 
+    // Ratio of the interpolation error at the middle of the step to the
+    // allowed error; the step is acceptable when it is at most 1.
+    auto stepError = [&](double t0,
+                         const Eigen::Vector3d& p0,
+                         const Eigen::Vector3d& v0,
+                         double dt,
+                         Eigen::Vector3d& p1,
+                         Eigen::Vector3d& v1)
+    {
+        p1 = positionAtTime(t0 + dt);
+        v1 = velocityAtTime(t0 + dt);
+
+        Eigen::Vector3d pTest = positionAtTime(t0 + dt / 2.0);
+        Eigen::Vector3d pInterp = cubicInterpolate(p0, v0 * dt, p1, v1 * dt, 0.5);
+
+        double tolerance = std::max(samplingParams.tolerance,
+                                    samplingParams.angularTolerance * pTest.norm());
+        return (pInterp - pTest).norm() / tolerance;
+    };
+
+    double t = startTime;
+    double dt = samplingParams.startStep / stepFactor;
+
     Eigen::Vector3d lastP = positionAtTime(t);
     Eigen::Vector3d lastV = velocityAtTime(t);
     proc.sample(t, lastP, lastV);
@@ -197,58 +225,38 @@ void Orbit::adaptiveSample(double startTime, double endTime, OrbitSampleProc& pr
     while (t < endTime)
     {
         // Make sure that we don't go past the end of the sample interval
-        maxStepSize = std::min(maxStepSize, endTime - t);
-        double dt = std::min(maxStepSize, startStepSize * 2.0);
-
-        Eigen::Vector3d p1 = positionAtTime(t + dt);
-        Eigen::Vector3d v1 = velocityAtTime(t + dt);
+        double maxStepSize = std::min(samplingParams.maxStep, endTime - t);
+        dt = std::min(maxStepSize, dt * stepFactor);
 
-        double tmid = t + dt / 2.0;
-        Eigen::Vector3d pTest = positionAtTime(tmid);
-        Eigen::Vector3d pInterp = cubicInterpolate(lastP, lastV * dt,
-                                                   p1, v1 * dt,
-                                                   0.5);
+        Eigen::Vector3d p1;
+        Eigen::Vector3d v1;
+        double error = stepError(t, lastP, lastV, dt, p1, v1);
 
-        double positionError = (pInterp - pTest).norm();
-
-        // Error is greater than tolerance; decrease the step until the
-        // error is within the tolerance.
-        if (positionError > tolerance)
+        if (error > 1.0)
         {
-            while (positionError > tolerance && dt > minStepSize)
+            // Error is greater than tolerance; decrease the step until the
+            // error is within the tolerance.
+            while (error > 1.0 && dt > minStepSize)
             {
                 dt /= stepFactor;
-
-                p1 = positionAtTime(t + dt);
-                v1 = velocityAtTime(t + dt);
-
-                tmid = t + dt / 2.0;
-                pTest = positionAtTime(tmid);
-                pInterp = cubicInterpolate(lastP, lastV * dt,
-                                           p1, v1 * dt,
-                                           0.5);
-
-                positionError = (pInterp - pTest).norm();
+                error = stepError(t, lastP, lastV, dt, p1, v1);
             }
         }
         else
         {
-            // Error is less than the tolerance; increase the step size until the
-            // tolerance is just exceeded.
-            while (positionError < tolerance && dt < maxStepSize)
+            // Error is within the tolerance; increase the step as long as
+            // the error stays within the tolerance.
+            while (dt < maxStepSize)
             {
-                dt *= stepFactor;
-
-                p1 = positionAtTime(t + dt);
-                v1 = velocityAtTime(t + dt);
-
-                tmid = t + dt / 2.0;
-                pTest = positionAtTime(tmid);
-                pInterp = cubicInterpolate(lastP, lastV * dt,
-                                           p1, v1 * dt,
-                                           0.5);
-
-                positionError = (pInterp - pTest).norm();
+                double nextDt = std::min(maxStepSize, dt * stepFactor);
+                Eigen::Vector3d nextP;
+                Eigen::Vector3d nextV;
+                if (stepError(t, lastP, lastV, nextDt, nextP, nextV) > 1.0)
+                    break;
+
+                dt = nextDt;
+                p1 = nextP;
+                v1 = nextV;
             }
         }
 
@@ -383,6 +391,12 @@ double EllipticalOrbit::getBoundingRadius() const
 }
 
 
+bool EllipticalOrbit::isThreadSafe() const
+{
+    return true;
+}
+
+
 HyperbolicOrbit::HyperbolicOrbit(const astro::KeplerElements& _elements, double _epoch) :
     semiMajorAxis(_elements.semimajorAxis),
     eccentricity(_elements.eccentricity),
@@ -491,6 +505,12 @@ bool HyperbolicOrbit::isPeriodic() const
 }
 
 
+bool HyperbolicOrbit::isThreadSafe() const
+{
+    return true;
+}
+
+
 void HyperbolicOrbit::getValidRange(double& begin, double& end) const
 {
     begin = startEpoch;
@@ -501,8 +521,10 @@ void HyperbolicOrbit::getValidRange(double& begin, double& end) const
 
 Eigen::Vector3d CachingOrbit::positionAtTime(double jd) const
 {
+    // Only the computations are profiled, the cache hits are too frequent
     if (jd != lastTime)
     {
+        CELESTIA_PROFILE_ZONE("CachingOrbit::positionAtTime");
         lastTime = jd;
         lastPosition = computePosition(jd);
         positionCacheValid = true;
@@ -510,6 +532,7 @@ Eigen::Vector3d CachingOrbit::positionAtTime(double jd) const
     }
     else if (!positionCacheValid)
     {
+        CELESTIA_PROFILE_ZONE("CachingOrbit::positionAtTime");
         lastPosition = computePosition(jd);
         positionCacheValid = true;
     }
@@ -556,6 +579,14 @@ Eigen::Vector3d CachingOrbit::computeVelocity(double jd) const
 }
 
 
+void CachingOrbit::computePositions(const double* jd, Eigen::Vector3d* positions, std::size_t count) const
+{
+    CELESTIA_PROFILE_ZONE("CachingOrbit::computePositions");
+    for (std::size_t i = 0; i < count; ++i)
+        positions[i] = computePosition(jd[i]);
+}
+
+
 MixedOrbit::MixedOrbit(const std::shared_ptr<const Orbit>& orbit, double t0, double t1, double mass) :
     primary(orbit),
     begin(t0),
@@ -655,6 +686,13 @@ FixedOrbit::isPeriodic() const
 }
 
 
+bool
+FixedOrbit::isThreadSafe() const
+{
+    return true;
+}
+
+
 double
 FixedOrbit::getPeriod() const
 {
@@ -9,6 +9,7 @@
 
 #pragma once
 
+#include <cstddef>
 #include <memory>
 
 #include <Eigen/Core>
@@ -46,6 +47,10 @@ public:
 
     virtual bool isPeriodic() const { return true; };
 
+    // Return true if positionAtTime may be called concurrently from several
+    // threads: the orbit has no caches and doesn't depend on other objects.
+    virtual bool isThreadSafe() const { return false; }
+
     // Return the time range over which the orbit is valid; if the orbit
     // is always valid, begin and end should be equal.
     virtual void getValidRange(double& begin, double& end) const
@@ -57,7 +62,9 @@ public:
 protected:
     struct AdaptiveSamplingParameters
     {
+        // Allowed error in kilometers; the larger of the two applies
         double tolerance;
+        double angularTolerance{ 0.0 };
         double startStep;
         double minStep;
         double maxStep;
@@ -78,6 +85,7 @@ public:
     Eigen::Vector3d velocityAtTime(double) const override;
     double getPeriod() const override;
     double getBoundingRadius() const override;
+    bool isThreadSafe() const override;
 
 private:
     double eccentricAnomaly(double) const;
@@ -107,6 +115,7 @@ public:
     double getPeriod() const override;
     double getBoundingRadius() const override;
     bool isPeriodic() const override;
+    bool isThreadSafe() const override;
     void getValidRange(double& begin, double& end) const override;
 
 private:
@@ -130,9 +139,19 @@ private:
 class OrbitSampleProc
 {
 public:
+    static constexpr double DefaultAngularTolerance = 1.0e-6;
+
     virtual ~OrbitSampleProc() = default;
 
     virtual void sample(double t, const Eigen::Vector3d& position, const Eigen::Vector3d& velocity) = 0;
+
+    /*! Return the error allowed between the orbit and the path interpolated
+     * from the samples, in radians as seen from the origin of the orbit. The
+     * allowed error is relative to the distance, so the samples are closer
+     * together where the orbit passes near the origin and sparser where it
+     * is far away.
+     */
+    virtual double angularTolerance() const { return DefaultAngularTolerance; }
 };
 
 
@@ -152,6 +171,10 @@ class CachingOrbit : public Orbit
 
     virtual Eigen::Vector3d computePosition(double jd) const = 0;
     virtual Eigen::Vector3d computeVelocity(double jd) const;
+    // Computes the positions at count times without using the cache, which
+    // orbits may do faster than one time after another, e.g. when sampling
+    // orbit paths
+    virtual void computePositions(const double* jd, Eigen::Vector3d* positions, std::size_t count) const;
 
     Eigen::Vector3d positionAtTime(double jd) const override;
     Eigen::Vector3d velocityAtTime(double jd) const override;
@@ -229,6 +252,7 @@ class FixedOrbit : public Orbit
     // Eigen::Vector3d velocityAtTime(double) const override;
     double getPeriod() const override;
     bool isPeriodic() const override;
+    bool isThreadSafe() const override;
     double getBoundingRadius() const override;
     void sample(double, double, OrbitSampleProc&) const override;
 
@@ -58,77 +58,84 @@ RotationModel::angularVelocityAtTime(double tdb) const
 }
 
 
+/*! Compute the orientation at each of the times. The default
+ *  implementation evaluates one time after another.
+ */
+void
+RotationModel::computeOrientations(const double* tjd, Eigen::Quaterniond* orientations, std::size_t count) const
+{
+    for (std::size_t i = 0; i < count; ++i)
+        orientations[i] = orientationAtTime(tjd[i]);
+}
+
+
 /***** CachingRotationModel *****/
 
-CachingRotationModel::CachingRotationModel() :
-    lastTime(365.0),
-    spinCacheValid(false),
-    equatorCacheValid(false),
-    angularVelocityCacheValid(false)
+CachingRotationModel::CachingRotationModel() = default;
+
+
+// Return the cache entry for the time, replacing the oldest entry if there
+// is none
+CachingRotationModel::CacheEntry&
+CachingRotationModel::findEntry(double tjd) const
 {
+    for (CacheEntry& entry : cache)
+    {
+        if (entry.time == tjd)
+            return entry;
+    }
+
+    CacheEntry& entry = cache[nextEntry];
+    nextEntry = (nextEntry + 1) % CacheSize;
+    entry.time = tjd;
+    entry.spinValid = false;
+    entry.equatorValid = false;
+    entry.angularVelocityValid = false;
+    return entry;
 }
 
 
 Eigen::Quaterniond
 CachingRotationModel::spin(double tjd) const
 {
-    if (tjd != lastTime)
-    {
-        lastTime = tjd;
-        lastSpin = computeSpin(tjd);
-        spinCacheValid = true;
-        equatorCacheValid = false;
-        angularVelocityCacheValid = false;
-    }
-    else if (!spinCacheValid)
+    CacheEntry& entry = findEntry(tjd);
+    if (!entry.spinValid)
     {
-        lastSpin = computeSpin(tjd);
-        spinCacheValid = true;
+        entry.spin = computeSpin(tjd);
+        entry.spinValid = true;
     }
 
-    return lastSpin;
+    return entry.spin;
 }
 
 
 Eigen::Quaterniond
 CachingRotationModel::equatorOrientationAtTime(double tjd) const
 {
-    if (tjd != lastTime)
+    CacheEntry& entry = findEntry(tjd);
+    if (!entry.equatorValid)
     {
-        lastTime = tjd;
-        lastEquator = computeEquatorOrientation(tjd);
-        spinCacheValid = false;
-        equatorCacheValid = true;
-        angularVelocityCacheValid = false;
-    }
-    else if (!equatorCacheValid)
-    {
-        lastEquator = computeEquatorOrientation(tjd);
-        equatorCacheValid = true;
+        entry.equator = computeEquatorOrientation(tjd);
+        entry.equatorValid = true;
     }
 
-    return lastEquator;
+    return entry.equator;
 }
 
 
 Eigen::Vector3d
 CachingRotationModel::angularVelocityAtTime(double tjd) const
 {
-    if (tjd != lastTime)
-    {
-        lastAngularVelocity = computeAngularVelocity(tjd);
-        lastTime = tjd;
-        spinCacheValid = false;
-        equatorCacheValid = false;
-        angularVelocityCacheValid = true;
-    }
-    else if (!angularVelocityCacheValid)
-    {
-        lastAngularVelocity = computeAngularVelocity(tjd);
-        angularVelocityCacheValid = true;
-    }
-
-    return lastAngularVelocity;
+    // computeAngularVelocity may replace entries, so the entry is looked
+    // up again afterwards
+    if (CacheEntry& entry = findEntry(tjd); entry.angularVelocityValid)
+        return entry.angularVelocity;
+
+    Eigen::Vector3d angularVelocity = computeAngularVelocity(tjd);
+    CacheEntry& entry = findEntry(tjd);
+    entry.angularVelocity = angularVelocity;
+    entry.angularVelocityValid = true;
+    return angularVelocity;
 }
 
 
@@ -208,6 +215,13 @@ UniformRotationModel::getPeriod() const
 }
 
 
+bool
+UniformRotationModel::isThreadSafe() const
+{
+    return true;
+}
+
+
 Eigen::Quaterniond
 UniformRotationModel::spin(double tjd) const
 {
@@ -273,6 +287,13 @@ PrecessingRotationModel::getPeriod() const
 }
 
 
+bool
+PrecessingRotationModel::isThreadSafe() const
+{
+    return true;
+}
+
+
 Eigen::Quaterniond
 PrecessingRotationModel::spin(double tjd) const
 {
@@ -10,6 +10,8 @@
 
 #pragma once
 
+#include <array>
+#include <cstddef>
 #include <memory>
 
 #include <Eigen/Core>
@@ -42,6 +44,10 @@ class RotationModel
 
     virtual Eigen::Vector3d angularVelocityAtTime(double tjd) const;
 
+    // Computes the orientations at count times, which models may do faster
+    // than one time after another when the times are in order
+    virtual void computeOrientations(const double* tjd, Eigen::Quaterniond* orientations, std::size_t count) const;
+
     /*! Return the orientation of the equatorial plane (normal to the primary
      *  axis of rotation.) The overall orientation of the object is
      *  spin * equator. If there is no primary axis of rotation, equator = 1
@@ -62,6 +68,11 @@ class RotationModel
 
     virtual bool isPeriodic() const = 0;
 
+    // Return true if the orientation may be computed concurrently from
+    // several threads: the model has no caches and doesn't depend on other
+    // objects.
+    virtual bool isThreadSafe() const { return false; }
+
     // Return the time range over which the orientation model is valid;
     // if the model is always valid, begin and end should be equal.
     virtual void getValidRange(double& begin, double& end) const
@@ -73,9 +84,10 @@ class RotationModel
 
 
 /*! CachingRotationModel is an abstract base class for complicated rotation
- *  models that are computationally expensive. The last calculated spin,
- *  equator orientation, and angular velocity are all cached and reused in
- *  order to avoid redundant calculation. Subclasses must override computeSpin(),
+ *  models that are computationally expensive. The spin, equator orientation,
+ *  and angular velocity calculated at the last few times are all cached and
+ *  reused in order to avoid redundant calculation, as shadows, rings and
+ *  atmospheres may ask for slightly different times in one frame. Subclasses must override computeSpin(),
  *  computeEquatorOrientation(), and getPeriod(). The default implementation
  *  of computeAngularVelocity uses differentiation to approximate the
  *  the instantaneous angular velocity. It may be overridden if there is some
@@ -99,13 +111,23 @@ class CachingRotationModel : public RotationModel
     bool isPeriodic() const override = 0;
 
 private:
-    mutable Eigen::Quaterniond lastSpin;
-    mutable Eigen::Quaterniond lastEquator;
-    mutable Eigen::Vector3d lastAngularVelocity;
-    mutable double lastTime;
-    mutable bool spinCacheValid;
-    mutable bool equatorCacheValid;
-    mutable bool angularVelocityCacheValid;
+    static constexpr std::size_t CacheSize = 4;
+
+    struct CacheEntry
+    {
+        Eigen::Quaterniond spin;
+        Eigen::Quaterniond equator;
+        Eigen::Vector3d angularVelocity;
+        double time{ 365.0 };
+        bool spinValid{ false };
+        bool equatorValid{ false };
+        bool angularVelocityValid{ false };
+    };
+
+    CacheEntry& findEntry(double tjd) const;
+
+    mutable std::array<CacheEntry, CacheSize> cache;
+    mutable std::size_t nextEntry{ 0 };
 };
 
 
@@ -124,6 +146,7 @@ class ConstantOrientation : public RotationModel
 
     double getPeriod() const override { return 0.0; }
     bool isPeriodic() const override { return false; }
+    bool isThreadSafe() const override { return true; }
 
     static std::shared_ptr<const RotationModel> identity();
 
@@ -147,6 +170,7 @@ class UniformRotationModel : public RotationModel
 
     bool isPeriodic() const override;
     double getPeriod() const override;
+    bool isThreadSafe() const override;
     Eigen::Quaterniond equatorOrientationAtTime(double tjd) const override;
     Eigen::Quaterniond spin(double tjd) const override;
     Eigen::Vector3d angularVelocityAtTime(double tjd) const override;
@@ -176,6 +200,7 @@ class PrecessingRotationModel : public RotationModel
 
     bool isPeriodic() const override;
     double getPeriod() const override;
+    bool isThreadSafe() const override;
     Eigen::Quaterniond equatorOrientationAtTime(double tjd) const override;
     Eigen::Quaterniond spin(double tjd) const override;
 
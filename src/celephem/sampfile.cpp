@@ -116,22 +116,108 @@ bool skipComments(std::istream& in)
 
 } // end namespace celestia::ephem::detail
 
-// Do a binary search to find the samples that define the orientation
-// at the current time. Cache the previous sample used and avoid
-// the search if it covers the requested time.
+namespace
+{
+
+// Check whether the previous sample or one of its neighbors covers the
+// requested time, which is the usual case when time advances smoothly or
+// when a range of times is evaluated in order.
+bool
+findNearSample(double jd, std::uint32_t& n, celestia::util::array_view<double> sampleTimes)
+{
+    auto nSamples = static_cast<std::uint32_t>(sampleTimes.size());
+    if (n < 1 || n >= nSamples)
+        return false;
+
+    if (jd >= sampleTimes[n - 1])
+    {
+        if (jd <= sampleTimes[n])
+            return true;
+        if (n + 1 < nSamples && jd <= sampleTimes[n + 1])
+        {
+            ++n;
+            return true;
+        }
+    }
+    else if (n > 1 && jd >= sampleTimes[n - 2])
+    {
+        --n;
+        return true;
+    }
+
+    return false;
+}
+
+} // end unnamed namespace
+
+
+SampleTimeIndex::SampleTimeIndex(celestia::util::array_view<double> sampleTimes) :
+    SampleTimeIndex(static_cast<std::uint32_t>(sampleTimes.size()),
+                    [sampleTimes](std::uint32_t i) { return sampleTimes[i]; })
+{
+}
+
+
+std::pair<std::uint32_t, std::uint32_t>
+SampleTimeIndex::searchRange(double jd) const
+{
+    if (bucketStarts.empty() || !(jd > startTime))
+        return { 0, std::min(nSamples, std::uint32_t(1)) };
+    if (bucketsPerDay == 0.0)
+        return { 0, nSamples };
+
+    auto nBuckets = static_cast<std::uint32_t>(bucketStarts.size() - 1);
+    double bucket = std::floor((jd - startTime) * bucketsPerDay);
+    if (!(bucket < static_cast<double>(nBuckets)))
+        return { bucketStarts[nBuckets - 1], nSamples };
+
+    // Include the neighboring buckets, in case rounding puts jd in the
+    // wrong one
+    auto b = static_cast<std::uint32_t>(bucket);
+    std::uint32_t first = bucketStarts[b > 0 ? b - 1 : 0];
+    std::uint32_t last = std::min(bucketStarts[std::min(b + 2, nBuckets)] + 1, nSamples);
+    return { first, last };
+}
+
+
+// Find the samples that define the orientation or position at the
+// requested time. Cache the previous sample used and avoid the search if
+// it or a neighboring sample covers the requested time; otherwise do a
+// binary search.
 std::uint32_t
 GetSampleIndex(double jd,
                std::uint32_t& lastSample,
                celestia::util::array_view<double> sampleTimes)
 {
     std::uint32_t n = lastSample;
-    if (n < 1 || n >= sampleTimes.size() || jd < sampleTimes[n - 1] || jd > sampleTimes[n])
+    if (!findNearSample(jd, n, sampleTimes))
     {
         auto iter = std::lower_bound(sampleTimes.begin(), sampleTimes.end(), jd);
         n = static_cast<std::uint32_t>(iter - sampleTimes.begin());
-        lastSample = n;
     }
 
+    lastSample = n;
+    return n;
+}
+
+
+// As above, but search only the samples that the index selects for the
+// requested time.
+std::uint32_t
+GetSampleIndex(double jd,
+               std::uint32_t& lastSample,
+               celestia::util::array_view<double> sampleTimes,
+               const SampleTimeIndex& timeIndex)
+{
+    std::uint32_t n = lastSample;
+    if (!findNearSample(jd, n, sampleTimes))
+    {
+        auto [first, last] = timeIndex.searchRange(jd);
+        auto iter = std::lower_bound(sampleTimes.begin() + first, sampleTimes.begin() + last, jd);
+        n = static_cast<std::uint32_t>(iter - sampleTimes.begin());
+    }
+
+    lastSample = n;
     return n;
 }
 
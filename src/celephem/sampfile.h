@@ -15,6 +15,8 @@
 
 #pragma once
 
+#include <algorithm>
+#include <cmath>
 #include <cstdint>
 #include <fstream>
 #include <istream>
@@ -46,9 +48,71 @@ bool skipComments(std::istream& in);
 }
 
 
+/*! Index of the sample times of a trajectory or orientation file, built
+ *  once at load. The time span is divided into buckets of equal duration,
+ *  each recording its first sample, so a lookup only has to search the few
+ *  samples around one bucket instead of the whole file.
+ */
+class SampleTimeIndex
+{
+public:
+    SampleTimeIndex() = default;
+    explicit SampleTimeIndex(celestia::util::array_view<double> sampleTimes);
+
+    // Build the index from a function returning the time of each of the
+    // nSamples samples, in increasing order
+    template<typename F>
+    SampleTimeIndex(std::uint32_t nSamples, F sampleTime);
+
+    // Return the range [first, last) of samples which contains the first
+    // sample at or after jd, unless all samples are before it, in which
+    // case the range is empty and last is the number of samples
+    std::pair<std::uint32_t, std::uint32_t> searchRange(double jd) const;
+
+    std::size_t getMemoryUsage() const { return bucketStarts.capacity() * sizeof(std::uint32_t); }
+
+private:
+    static constexpr std::uint32_t SamplesPerBucket = 4;
+
+    double startTime{ 0.0 };
+    double bucketsPerDay{ 0.0 };
+    std::uint32_t nSamples{ 0 };
+    // First sample of each bucket, followed by nSamples
+    std::vector<std::uint32_t> bucketStarts;
+};
+
+template<typename F>
+SampleTimeIndex::SampleTimeIndex(std::uint32_t _nSamples, F sampleTime) :
+    nSamples(_nSamples)
+{
+    if (nSamples == 0)
+        return;
+
+    startTime = sampleTime(0);
+    double span = sampleTime(nSamples - 1) - startTime;
+    std::uint32_t nBuckets = std::max(nSamples / SamplesPerBucket, std::uint32_t(1));
+    bucketsPerDay = span > 0.0 ? static_cast<double>(nBuckets) / span : 0.0;
+
+    bucketStarts.reserve(static_cast<std::size_t>(nBuckets) + 1);
+    std::uint32_t i = 0;
+    for (std::uint32_t bucket = 0; bucket < nBuckets; ++bucket)
+    {
+        double bucketStart = span > 0.0 ? startTime + static_cast<double>(bucket) / bucketsPerDay : startTime;
+        while (i < nSamples && sampleTime(i) < bucketStart)
+            ++i;
+        bucketStarts.push_back(i);
+    }
+    bucketStarts.push_back(nSamples);
+}
+
+
 std::uint32_t GetSampleIndex(double jd,
                              std::uint32_t& lastSample,
                              celestia::util::array_view<double> sampleTimes);
+std::uint32_t GetSampleIndex(double jd,
+                             std::uint32_t& lastSample,
+                             celestia::util::array_view<double> sampleTimes,
+                             const SampleTimeIndex& timeIndex);
 
 
 template<typename T, typename F>
@@ -14,11 +14,16 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cassert>
+#include <cmath>
 #include <cstdint>
 #include <cstring>
 #include <fstream>
 #include <istream>
+#include <limits>
+#include <memory>
+#include <mutex>
 #include <string_view>
 #include <type_traits>
 #include <unordered_map>
@@ -30,10 +35,12 @@
 #include <celastro/date.h>
 #include <celcompat/bit.h>
 #include <celmath/mathlib.h>
+#include <celutil/fileaccesslog.h>
 #include <celutil/filetype.h>
 #include <celutil/fsutils.h>
 #include <celutil/gettext.h>
 #include <celutil/logger.h>
+#include <celutil/mappedfile.h>
 #include "orbit.h"
 #include "sampfile.h"
 #include "xyzvbinary.h"
@@ -60,12 +67,19 @@ struct Samples
 {
     Samples(std::vector<double>&& _times, std::vector<T>&& _samples) :
         times(std::move(_times)),
-        samples(std::move(_samples))
+        samples(std::move(_samples)),
+        timeIndex(times)
     {
     }
 
+    std::size_t getMemoryUsage() const
+    {
+        return times.capacity() * sizeof(double) + samples.capacity() * sizeof(T) + timeIndex.getMemoryUsage();
+    }
+
     std::vector<double> times;
     std::vector<T> samples;
+    SampleTimeIndex timeIndex;
 };
 
 struct InterpolationParameters
@@ -115,6 +129,7 @@ public:
     double getBoundingRadius() const override;
     Eigen::Vector3d computePosition(double jd) const override;
     Eigen::Vector3d computeVelocity(double jd) const override;
+    void computePositions(const double* jd, Eigen::Vector3d* positions, std::size_t count) const override;
 
     bool isPeriodic() const override;
     void getValidRange(double& begin, double& end) const override;
@@ -122,6 +137,8 @@ public:
     void sample(double startTime, double endTime, OrbitSampleProc& proc) const override;
 
 private:
+    Eigen::Vector3d computePosition(double jd, std::uint32_t& hint) const;
+
     std::shared_ptr<const Samples<SampleXYZ<T>>> samples;
     util::array_view<double> sampleTimes;
     util::array_view<SampleXYZ<T>> positions;
@@ -185,11 +202,29 @@ SampledOrbit<T>::getBoundingRadius() const
 template<typename T>
 Eigen::Vector3d
 SampledOrbit<T>::computePosition(double jd) const
+{
+    return computePosition(jd, lastSample);
+}
+
+// Evaluate the times with a hint of their own, so that the samples of
+// ordered times are found by stepping from one to the next
+template<typename T>
+void
+SampledOrbit<T>::computePositions(const double* jd, Eigen::Vector3d* _positions, std::size_t count) const
+{
+    std::uint32_t hint = lastSample;
+    for (std::size_t i = 0; i < count; ++i)
+        _positions[i] = computePosition(jd[i], hint);
+}
+
+template<typename T>
+Eigen::Vector3d
+SampledOrbit<T>::computePosition(double jd, std::uint32_t& hint) const
 {
     if (sampleTimes.size() == 1)
         return positions.front().template cast<double>();
 
-    std::uint32_t n = GetSampleIndex(jd, lastSample, sampleTimes);
+    std::uint32_t n = GetSampleIndex(jd, hint, sampleTimes, samples->timeIndex);
     if (n == 0)
         return positions.front().template cast<double>();
     if (n == sampleTimes.size())
@@ -237,7 +272,7 @@ SampledOrbit<T>::computeVelocity(double jd) const
     if (sampleTimes.size() < 2)
         return Eigen::Vector3d::Zero();
 
-    std::uint32_t n = GetSampleIndex(jd, lastSample, sampleTimes);
+    std::uint32_t n = GetSampleIndex(jd, lastSample, sampleTimes, samples->timeIndex);
     if (n == 0 || n == sampleTimes.size())
         return Eigen::Vector3d::Zero();
 
@@ -347,19 +382,377 @@ struct SampleXYZV
     Eigen::Matrix<T, 3, 1> velocity;
 };
 
+// Positions and velocities, either read into memory or accessed in place
+// from a mapped binary xyzv file. Times of mapped samples at a regular
+// cadence are located arithmetically, other times through an index. The
+// chunks of a mapped chunked file are decoded when a sample in them is
+// first accessed, and kept.
+template<typename T>
+class XYZVSamples
+{
+public:
+    XYZVSamples(std::vector<double>&& _times, std::vector<SampleXYZV<T>>&& _samples);
+
+    static std::shared_ptr<const XYZVSamples> map(std::unique_ptr<util::MappedFile>&&);
+    static std::shared_ptr<const XYZVSamples> mapChunked(std::unique_ptr<util::MappedFile>&&,
+                                                         const fs::path&);
+
+    std::uint32_t size() const { return count; }
+    double time(std::uint32_t) const;
+    Eigen::Vector3d position(std::uint32_t) const;
+    Eigen::Vector3d velocity(std::uint32_t) const;
+    double getBoundingRadius() const { return boundingRadius; }
+
+    // Memory of the samples read from a stream and of the decoded chunks;
+    // the mapped records are backed by the file
+    std::size_t getMemoryUsage() const;
+
+    // Index of the first sample at or after jd, as GetSampleIndex
+    std::uint32_t findSample(double jd, std::uint32_t& lastSample) const;
+
+private:
+    XYZVSamples() = default;
+
+    const char* record(std::uint32_t i) const;
+    const XYZVRecord* decodeChunk(std::uint32_t chunk) const;
+
+    std::vector<double> times;
+    std::vector<SampleXYZV<T>> samples;
+
+    std::unique_ptr<util::MappedFile> file;
+    // Interval between mapped samples at a regular cadence, zero otherwise
+    double interval{ 0.0 };
+    SampleTimeIndex timeIndex;
+
+    // Records per chunk of a chunked file, zero otherwise
+    std::uint32_t chunkSize{ 0 };
+    std::vector<double> chunkTimes;
+    std::vector<std::pair<std::size_t, std::size_t>> chunkRanges;
+    // Decoded chunks, published once complete
+    mutable std::unique_ptr<std::atomic<const XYZVRecord*>[]> chunks;
+    mutable std::vector<std::unique_ptr<XYZVRecord[]>> chunkStorage;
+    mutable std::mutex chunkMutex;
+
+    std::uint32_t count{ 0 };
+    double boundingRadius{ 0.0 };
+};
+
+template<typename T>
+XYZVSamples<T>::XYZVSamples(std::vector<double>&& _times, std::vector<SampleXYZV<T>>&& _samples) :
+    times(std::move(_times)),
+    samples(std::move(_samples)),
+    timeIndex(times),
+    count(static_cast<std::uint32_t>(times.size()))
+{
+    assert(!times.empty() && times.size() == samples.size());
+
+    auto it = std::max_element(samples.begin(), samples.end(),
+                               [](const auto& a, const auto& b)
+                               {
+                                   return a.position.squaredNorm() < b.position.squaredNorm();
+                               });
+    boundingRadius = it->position.template cast<double>().norm();
+}
+
+// Use the records of a mapped file with a valid header in place. Files
+// with out-of-order samples or a partial record are left to the stream
+// loader, which skips or reports them.
+template<typename T>
+std::shared_ptr<const XYZVSamples<T>>
+XYZVSamples<T>::map(std::unique_ptr<util::MappedFile>&& file)
+{
+    std::size_t dataSize = file->size() - sizeof(XYZVBinaryHeader);
+    std::size_t nRecords = dataSize / sizeof(XYZVBinaryData);
+    if (dataSize % sizeof(XYZVBinaryData) != 0 || nRecords == 0 ||
+        nRecords > std::numeric_limits<std::uint32_t>::max())
+    {
+        return nullptr;
+    }
+
+    std::shared_ptr<XYZVSamples> result(new XYZVSamples());
+    result->file = std::move(file);
+    result->count = static_cast<std::uint32_t>(nRecords);
+
+    double t0 = result->time(0);
+    double cadence = result->count > 1
+        ? (result->time(result->count - 1) - t0) / static_cast<double>(result->count - 1)
+        : 0.0;
+    double maxDeviation = 0.0;
+    double maxSquaredNorm = 0.0;
+    for (std::uint32_t i = 0; i < result->count; ++i)
+    {
+        double t = result->time(i);
+        if (i > 0 && !(t > result->time(i - 1)))
+            return nullptr;
+
+        maxDeviation = std::max(maxDeviation, std::abs(t - (t0 + cadence * static_cast<double>(i))));
+        maxSquaredNorm = std::max(maxSquaredNorm, result->position(i).squaredNorm());
+    }
+
+    // Estimates within a quarter interval are at most one sample off
+    if (maxDeviation <= cadence * 0.25)
+    {
+        result->interval = cadence;
+    }
+    else
+    {
+        const XYZVSamples* samples = result.get();
+        result->timeIndex = SampleTimeIndex(result->count,
+                                            [samples](std::uint32_t i) { return samples->time(i); });
+    }
+    result->boundingRadius = std::sqrt(maxSquaredNorm);
+
+    return result;
+}
+
+// Use a mapped chunked file after checking its index. The chunks
+// themselves are only checked when they are decoded.
+template<typename T>
+std::shared_ptr<const XYZVSamples<T>>
+XYZVSamples<T>::mapChunked(std::unique_ptr<util::MappedFile>&& file, const fs::path& filename)
+{
+    const char* header = file->data();
+    decltype(XYZVChunkedHeader::chunkSize) chunkSize;
+    decltype(XYZVChunkedHeader::count) count;
+    decltype(XYZVChunkedHeader::indexOffset) indexOffset;
+    double boundingRadius;
+    std::memcpy(&chunkSize, header + offsetof(XYZVChunkedHeader, chunkSize), sizeof(chunkSize));
+    std::memcpy(&count, header + offsetof(XYZVChunkedHeader, count), sizeof(count));
+    std::memcpy(&indexOffset, header + offsetof(XYZVChunkedHeader, indexOffset), sizeof(indexOffset));
+    std::memcpy(&boundingRadius, header + offsetof(XYZVChunkedHeader, boundingRadius), sizeof(boundingRadius));
+
+    std::uint64_t nChunks = chunkSize == 0 ? 0 : (count + chunkSize - 1) / chunkSize;
+    if (nChunks == 0 || count > std::numeric_limits<std::uint32_t>::max() ||
+        indexOffset < sizeof(XYZVChunkedHeader) || indexOffset > file->size() ||
+        (file->size() - indexOffset) / sizeof(XYZVChunkIndexEntry) < nChunks)
+    {
+        GetLogger()->error(_("Bad chunk index in {}.\n"), filename);
+        return nullptr;
+    }
+
+    std::shared_ptr<XYZVSamples> result(new XYZVSamples());
+    result->chunkSize = chunkSize;
+    result->count = static_cast<std::uint32_t>(count);
+    result->chunkTimes.resize(nChunks);
+    result->chunkRanges.resize(nChunks);
+
+    const char* index = header + indexOffset;
+    for (std::size_t i = 0; i < nChunks; ++i)
+    {
+        const char* entry = index + i * sizeof(XYZVChunkIndexEntry);
+        std::uint64_t offset;
+        std::memcpy(&result->chunkTimes[i], entry + offsetof(XYZVChunkIndexEntry, tdb), sizeof(double));
+        std::memcpy(&offset, entry + offsetof(XYZVChunkIndexEntry, offset), sizeof(offset));
+
+        std::uint64_t previous = i == 0 ? sizeof(XYZVChunkedHeader) : result->chunkRanges[i - 1].first;
+        if (offset < previous || offset > indexOffset ||
+            (i > 0 && !(result->chunkTimes[i] > result->chunkTimes[i - 1])))
+        {
+            GetLogger()->error(_("Bad chunk index in {}.\n"), filename);
+            return nullptr;
+        }
+
+        result->chunkRanges[i].first = static_cast<std::size_t>(offset);
+        if (i > 0)
+            result->chunkRanges[i - 1].second = static_cast<std::size_t>(offset);
+    }
+    result->chunkRanges.back().second = static_cast<std::size_t>(indexOffset);
+
+    result->chunks = std::make_unique<std::atomic<const XYZVRecord*>[]>(nChunks);
+    result->chunkStorage.resize(nChunks);
+    result->file = std::move(file);
+    result->boundingRadius = boundingRadius;
+
+    return result;
+}
+
+template<typename T>
+const XYZVRecord*
+XYZVSamples<T>::decodeChunk(std::uint32_t chunk) const
+{
+    std::scoped_lock lock(chunkMutex);
+    if (const XYZVRecord* records = chunks[chunk].load(std::memory_order_relaxed); records != nullptr)
+        return records;
+
+    std::uint32_t nRecords = std::min(chunkSize, count - chunk * chunkSize);
+    auto records = std::make_unique<XYZVRecord[]>(nRecords);
+    auto [start, end] = chunkRanges[chunk];
+    if (!DecodeXYZVChunk(file->data() + start, end - start, nRecords, records.get()))
+    {
+        // Repeat the start of the chunk rather than return garbage
+        GetLogger()->error(_("Bad chunk {} in binary xyzv file.\n"), chunk);
+        for (std::uint32_t i = 0; i < nRecords; ++i)
+            records[i] = XYZVRecord{ chunkTimes[chunk] };
+    }
+
+    chunks[chunk].store(records.get(), std::memory_order_release);
+    chunkStorage[chunk] = std::move(records);
+    return chunkStorage[chunk].get();
+}
+
+template<typename T>
+std::size_t
+XYZVSamples<T>::getMemoryUsage() const
+{
+    std::size_t bytes = times.capacity() * sizeof(double) +
+                        samples.capacity() * sizeof(SampleXYZV<T>) +
+                        timeIndex.getMemoryUsage();
+    if (chunkSize > 0)
+    {
+        std::scoped_lock lock(chunkMutex);
+        for (const auto& records : chunkStorage)
+        {
+            if (records != nullptr)
+                bytes += chunkSize * sizeof(XYZVRecord);
+        }
+    }
+
+    return bytes;
+}
+
+template<typename T>
+const char*
+XYZVSamples<T>::record(std::uint32_t i) const
+{
+    if (chunkSize > 0)
+    {
+        std::uint32_t chunk = i / chunkSize;
+        const XYZVRecord* records = chunks[chunk].load(std::memory_order_acquire);
+        if (records == nullptr)
+            records = decodeChunk(chunk);
+        return reinterpret_cast<const char*>(records + i % chunkSize);
+    }
+
+    return file->data() + sizeof(XYZVBinaryHeader) + static_cast<std::size_t>(i) * sizeof(XYZVBinaryData);
+}
+
+template<typename T>
+double
+XYZVSamples<T>::time(std::uint32_t i) const
+{
+    if (file == nullptr)
+        return times[i];
+
+    double tdb;
+    std::memcpy(&tdb, record(i) + offsetof(XYZVBinaryData, tdb), sizeof(double));
+    return tdb;
+}
+
+template<typename T>
+Eigen::Vector3d
+XYZVSamples<T>::position(std::uint32_t i) const
+{
+    if (file == nullptr)
+        return samples[i].position.template cast<double>();
+
+    Eigen::Vector3d position;
+    std::memcpy(position.data(), record(i) + offsetof(XYZVBinaryData, position), sizeof(double) * 3);
+    convertToCelestiaCoordinates(position);
+    return position;
+}
+
+template<typename T>
+Eigen::Vector3d
+XYZVSamples<T>::velocity(std::uint32_t i) const
+{
+    if (file == nullptr)
+        return samples[i].velocity.template cast<double>();
+
+    Eigen::Vector3d velocity;
+    std::memcpy(velocity.data(), record(i) + offsetof(XYZVBinaryData, velocity), sizeof(double) * 3);
+    velocity *= astro::daysToSecs(1.0);
+    convertToCelestiaCoordinates(velocity);
+    return velocity;
+}
+
+template<typename T>
+std::uint32_t
+XYZVSamples<T>::findSample(double jd, std::uint32_t& lastSample) const
+{
+    if (file == nullptr)
+        return GetSampleIndex(jd, lastSample, times, timeIndex);
+
+    std::uint32_t n = lastSample;
+    if (n >= 1 && n < count && jd >= time(n - 1))
+    {
+        if (jd <= time(n))
+            return n;
+        if (n + 1 < count && jd <= time(n + 1))
+        {
+            lastSample = n + 1;
+            return n + 1;
+        }
+    }
+
+    if (chunkSize > 0)
+    {
+        // The first sample at or after jd is in the last chunk starting
+        // before jd, or starts the next one
+        auto chunk = static_cast<std::uint32_t>(std::lower_bound(chunkTimes.begin(), chunkTimes.end(), jd) -
+                                                chunkTimes.begin());
+        n = std::min(chunk * chunkSize, count);
+        if (chunk > 0)
+        {
+            std::uint32_t first = (chunk - 1) * chunkSize;
+            std::uint32_t last = n;
+            while (first < last)
+            {
+                std::uint32_t middle = first + (last - first) / 2;
+                if (time(middle) < jd)
+                    first = middle + 1;
+                else
+                    last = middle;
+            }
+            n = first;
+        }
+    }
+    else if (interval > 0.0)
+    {
+        double estimate = std::ceil((jd - time(0)) / interval);
+        if (!(estimate > 0.0))
+            n = 0;
+        else if (estimate >= static_cast<double>(count))
+            n = count;
+        else
+            n = static_cast<std::uint32_t>(estimate);
+
+        while (n > 0 && time(n - 1) >= jd)
+            --n;
+        while (n < count && time(n) < jd)
+            ++n;
+    }
+    else
+    {
+        auto [first, last] = timeIndex.searchRange(jd);
+        while (first < last)
+        {
+            std::uint32_t middle = first + (last - first) / 2;
+            if (time(middle) < jd)
+                first = middle + 1;
+            else
+                last = middle;
+        }
+        n = first;
+    }
+
+    lastSample = n;
+    return n;
+}
+
 // Sampled orbit with positions and velocities
 template<typename T>
 class SampledOrbitXYZV : public CachingOrbit
 {
 public:
     SampledOrbitXYZV(TrajectoryInterpolation,
-                     const std::shared_ptr<const Samples<SampleXYZV<T>>>& samples);
+                     const std::shared_ptr<const XYZVSamples<T>>& samples);
     ~SampledOrbitXYZV() override = default;
 
     double getPeriod() const override;
     double getBoundingRadius() const override;
     Eigen::Vector3d computePosition(double jd) const override;
     Eigen::Vector3d computeVelocity(double jd) const override;
+    void computePositions(const double* jd, Eigen::Vector3d* positions, std::size_t count) const override;
 
     bool isPeriodic() const override;
     void getValidRange(double& begin, double& end) const override;
@@ -367,12 +760,11 @@ public:
     void sample(double startTime, double endTime, OrbitSampleProc& proc) const override;
 
 private:
+    Eigen::Vector3d computePosition(double jd, std::uint32_t& hint) const;
     void initializeCubic(double, std::uint32_t, InterpolationParameters&) const;
 
-    std::shared_ptr<const Samples<SampleXYZV<T>>> samples;
-    util::array_view<double> sampleTimes;
-    util::array_view<SampleXYZV<T>> posvels;
-    double boundingRadius;
+    std::shared_ptr<const XYZVSamples<T>> samples;
+    std::uint32_t nSamples;
     mutable std::uint32_t lastSample{ 0 };
 
     TrajectoryInterpolation interpolation;
@@ -380,27 +772,19 @@ private:
 
 template<typename T>
 SampledOrbitXYZV<T>::SampledOrbitXYZV(TrajectoryInterpolation _interpolation,
-                                      const std::shared_ptr<const Samples<SampleXYZV<T>>>& _samples) :
+                                      const std::shared_ptr<const XYZVSamples<T>>& _samples) :
     samples(_samples),
-    sampleTimes(_samples->times),
-    posvels(_samples->samples),
+    nSamples(_samples->size()),
     interpolation(_interpolation)
 {
-    assert(!sampleTimes.empty() && sampleTimes.size() == posvels.size());
-
-    auto it = std::max_element(posvels.begin(), posvels.end(),
-                               [](const auto& a, const auto& b)
-                               {
-                                   return a.position.squaredNorm() < b.position.squaredNorm();
-                               });
-    boundingRadius = it->position.template cast<double>().norm();
+    assert(nSamples > 0);
 }
 
 template<typename T>
 double
 SampledOrbitXYZV<T>::getPeriod() const
 {
-    return sampleTimes.back() - sampleTimes.front();
+    return samples->time(nSamples - 1) - samples->time(0);
 }
 
 template<typename T>
@@ -414,36 +798,53 @@ template<typename T>
 void
 SampledOrbitXYZV<T>::getValidRange(double& begin, double& end) const
 {
-    begin = sampleTimes.front();
-    end = sampleTimes.back();
+    begin = samples->time(0);
+    end = samples->time(nSamples - 1);
 }
 
 template<typename T>
 double
 SampledOrbitXYZV<T>::getBoundingRadius() const
 {
-    return boundingRadius;
+    return samples->getBoundingRadius();
 }
 
 template<typename T>
 Eigen::Vector3d
 SampledOrbitXYZV<T>::computePosition(double jd) const
 {
-    if (sampleTimes.size() == 1)
-        return posvels.front().position.template cast<double>();
+    return computePosition(jd, lastSample);
+}
+
+template<typename T>
+void
+SampledOrbitXYZV<T>::computePositions(const double* jd, Eigen::Vector3d* positions, std::size_t count) const
+{
+    std::uint32_t hint = lastSample;
+    for (std::size_t i = 0; i < count; ++i)
+        positions[i] = computePosition(jd[i], hint);
+}
+
+template<typename T>
+Eigen::Vector3d
+SampledOrbitXYZV<T>::computePosition(double jd, std::uint32_t& hint) const
+{
+    if (nSamples == 1)
+        return samples->position(0);
 
-    std::uint32_t n = GetSampleIndex(jd, lastSample, sampleTimes);
+    std::uint32_t n = samples->findSample(jd, hint);
     if (n == 0)
-        return posvels.front().position.template cast<double>();
-    if (n == sampleTimes.size())
-        return posvels.back().position.template cast<double>();
+        return samples->position(0);
+    if (n == nSamples)
+        return samples->position(nSamples - 1);
 
     if (interpolation == TrajectoryInterpolation::Linear)
     {
-        double t = (jd - sampleTimes[n - 1]) / (sampleTimes[n] - sampleTimes[n - 1]);
+        double t0 = samples->time(n - 1);
+        double t = (jd - t0) / (samples->time(n) - t0);
 
-        Eigen::Vector3d p0 = posvels[n - 1].position.template cast<double>();
-        Eigen::Vector3d p1 = posvels[n].position.template cast<double>();
+        Eigen::Vector3d p0 = samples->position(n - 1);
+        Eigen::Vector3d p1 = samples->position(n);
         return p0 + t * (p1 - p0);
     }
 
@@ -465,17 +866,17 @@ template<typename T>
 Eigen::Vector3d
 SampledOrbitXYZV<T>::computeVelocity(double jd) const
 {
-    if (sampleTimes.size() < 2)
+    if (nSamples < 2)
         return Eigen::Vector3d::Zero();
 
-    std::uint32_t n = GetSampleIndex(jd, lastSample, sampleTimes);
-    if (n == 0 || n == sampleTimes.size())
+    std::uint32_t n = samples->findSample(jd, lastSample);
+    if (n == 0 || n == nSamples)
         return Eigen::Vector3d::Zero();
 
     if (interpolation == TrajectoryInterpolation::Linear)
     {
-        double hRecip = 1.0 / (sampleTimes[n] - sampleTimes[n - 1]);
-        return (posvels[n].position.template cast<double>() - posvels[n - 1].position.template cast<double>()) *
+        double hRecip = 1.0 / (samples->time(n) - samples->time(n - 1));
+        return (samples->position(n) - samples->position(n - 1)) *
                 hRecip *
                 astro::daysToSecs(1.0);
     }
@@ -499,13 +900,14 @@ SampledOrbitXYZV<T>::initializeCubic(double jd,
                                      InterpolationParameters& params) const
 {
     assert(n > 0);
-    double h = sampleTimes[n] - sampleTimes[n - 1];
+    double t0 = samples->time(n - 1);
+    double h = samples->time(n) - t0;
     params.ih = 1.0 / h;
-    params.t = (jd - sampleTimes[n - 1]) * params.ih;
-    params.p0 = posvels[n - 1].position.template cast<double>();
-    params.v0 = posvels[n - 1].velocity.template cast<double>() * h;
-    params.p1 = posvels[n].position.template cast<double>();
-    params.v1 = posvels[n].velocity.template cast<double>() * h;
+    params.t = (jd - t0) * params.ih;
+    params.p0 = samples->position(n - 1);
+    params.v0 = samples->velocity(n - 1) * h;
+    params.p1 = samples->position(n);
+    params.v1 = samples->velocity(n) * h;
 }
 
 template<typename T>
@@ -513,12 +915,8 @@ void
 SampledOrbitXYZV<T>::sample(double /* startTime */, double /* endTime */,
                             OrbitSampleProc& proc) const
 {
-    for (std::uint32_t i = 0; i < sampleTimes.size(); ++i)
-    {
-        proc.sample(sampleTimes[i],
-                    posvels[i].position.template cast<double>(),
-                    posvels[i].velocity.template cast<double>());
-    }
+    for (std::uint32_t i = 0; i < nSamples; ++i)
+        proc.sample(samples->time(i), samples->position(i), samples->velocity(i));
 }
 
 template<typename T>
@@ -560,26 +958,23 @@ LoadSamplesXYZAscii(const fs::path& filename)
     return std::make_shared<Samples<SampleXYZ<T>>>(std::move(sampleTimes), std::move(samples));
 }
 
+// The chunked header starts with the same fields
+static_assert(offsetof(XYZVChunkedHeader, byteOrder) == offsetof(XYZVBinaryHeader, byteOrder));
+static_assert(offsetof(XYZVChunkedHeader, digits) == offsetof(XYZVBinaryHeader, digits));
+static_assert(offsetof(XYZVChunkedHeader, count) == offsetof(XYZVBinaryHeader, count));
+
 bool
-ParseXYZVBinaryHeader(std::istream& in, const fs::path& filename)
+ParseXYZVBinaryHeader(const char* header, const fs::path& filename,
+                      std::string_view magic = XYZV_MAGIC)
 {
-    std::array<char, sizeof(XYZVBinaryHeader)> header;
-
-    // Sonar detects this as being in a critical section for some reason
-    if (!in.read(header.data(), header.size())) /* Flawfinder: ignore */ //NOSONAR
-    {
-        GetLogger()->error(_("Error reading header of {}.\n"), filename);
-        return false;
-    }
-
-    if (std::string_view(header.data() + offsetof(XYZVBinaryHeader, magic), XYZV_MAGIC.size()) != XYZV_MAGIC)
+    if (std::string_view(header + offsetof(XYZVBinaryHeader, magic), magic.size()) != magic)
     {
         GetLogger()->error(_("Bad binary xyzv file {}.\n"), filename);
         return false;
     }
 
     decltype(XYZVBinaryHeader::byteOrder) byteOrder;
-    std::memcpy(&byteOrder, header.data() + offsetof(XYZVBinaryHeader, byteOrder), sizeof(byteOrder));
+    std::memcpy(&byteOrder, header + offsetof(XYZVBinaryHeader, byteOrder), sizeof(byteOrder));
     if (byteOrder != static_cast<decltype(byteOrder)>(celestia::compat::endian::native))
     {
         GetLogger()->error(_("Unsupported byte order {}, expected {} in {}.\n"),
@@ -588,7 +983,7 @@ ParseXYZVBinaryHeader(std::istream& in, const fs::path& filename)
     }
 
     decltype(XYZVBinaryHeader::digits) digits;
-    std::memcpy(&digits, header.data() + offsetof(XYZVBinaryHeader, digits), sizeof(digits));
+    std::memcpy(&digits, header + offsetof(XYZVBinaryHeader, digits), sizeof(digits));
     if (digits != std::numeric_limits<double>::digits)
     {
         GetLogger()->error(_("Unsupported digits number {}, expected {} in {}.\n"),
@@ -597,7 +992,7 @@ ParseXYZVBinaryHeader(std::istream& in, const fs::path& filename)
     }
 
     decltype(XYZVBinaryHeader::count) count;
-    std::memcpy(&count, header.data() + offsetof(XYZVBinaryHeader, count), sizeof(count));
+    std::memcpy(&count, header + offsetof(XYZVBinaryHeader, count), sizeof(count));
     if (count == 0)
     {
         GetLogger()->error(_("Invalid record count {} in {}.\n"), count, filename);
@@ -607,6 +1002,21 @@ ParseXYZVBinaryHeader(std::istream& in, const fs::path& filename)
     return true;
 }
 
+bool
+ParseXYZVBinaryHeader(std::istream& in, const fs::path& filename)
+{
+    std::array<char, sizeof(XYZVBinaryHeader)> header;
+
+    // Sonar detects this as being in a critical section for some reason
+    if (!in.read(header.data(), header.size())) /* Flawfinder: ignore */ //NOSONAR
+    {
+        GetLogger()->error(_("Error reading header of {}.\n"), filename);
+        return false;
+    }
+
+    return ParseXYZVBinaryHeader(header.data(), filename);
+}
+
 template<typename T>
 bool
 ReadXYZVBinarySample(std::istream& in, double& tdb, SampleXYZV<T>& sample)
@@ -642,12 +1052,40 @@ ReadXYZVBinarySample(std::istream& in, double& tdb, SampleXYZV<T>& sample)
     return true;
 }
 
-/* Load a binary xyzv sampled trajectory file.
+/* Load a binary xyzv sampled trajectory file. The file is mapped and the
+ * samples are read from it when needed, unless it can't be mapped or its
+ * samples have to be filtered.
  */
 template <typename T>
-std::shared_ptr<const Samples<SampleXYZV<T>>>
+std::shared_ptr<const XYZVSamples<T>>
 LoadSamplesXYZVBinary(const fs::path& filename)
 {
+    if (auto file = util::MappedFile::open(filename);
+        file != nullptr && file->size() >= sizeof(XYZVBinaryHeader))
+    {
+        // Chunked files are only read mapped
+        if (file->size() >= sizeof(XYZVChunkedHeader) &&
+            std::string_view(file->data(), XYZV_CHUNKED_MAGIC.size()) == XYZV_CHUNKED_MAGIC)
+        {
+            if (!ParseXYZVBinaryHeader(file->data(), filename, XYZV_CHUNKED_MAGIC))
+            {
+                GetLogger()->error(_("Could not read XYZV binary file {}.\n"), filename);
+                return nullptr;
+            }
+
+            return XYZVSamples<T>::mapChunked(std::move(file), filename);
+        }
+
+        if (!ParseXYZVBinaryHeader(file->data(), filename))
+        {
+            GetLogger()->error(_("Could not read XYZV binary file {}.\n"), filename);
+            return nullptr;
+        }
+
+        if (auto samples = XYZVSamples<T>::map(std::move(file)); samples != nullptr)
+            return samples;
+    }
+
     std::vector<double> sampleTimes;
     std::vector<SampleXYZV<T>> samples;
 
@@ -667,8 +1105,8 @@ LoadSamplesXYZVBinary(const fs::path& filename)
     if (!LoadSamples(in, filename, sampleTimes, samples, &ReadXYZVBinarySample<T>))
         return nullptr;
 
-    return std::make_shared<Samples<SampleXYZV<T>>>(std::move(sampleTimes),
-                                                    std::move(samples));
+    return std::make_shared<XYZVSamples<T>>(std::move(sampleTimes),
+                                            std::move(samples));
 }
 
 template<typename T>
@@ -706,7 +1144,7 @@ ReadAsciiSampleXYZV(std::istream& in, double& tdb, SampleXYZV<T>& sample)
 // of a comment.
 
 template<typename T>
-std::shared_ptr<const Samples<SampleXYZV<T>>>
+std::shared_ptr<const XYZVSamples<T>>
 LoadSamplesXYZVAscii(const fs::path& filename)
 {
     auto binname = filename;
@@ -722,23 +1160,25 @@ LoadSamplesXYZVAscii(const fs::path& filename)
     if (!LoadAsciiSamples(filename, sampleTimes, samples, &ReadAsciiSampleXYZV<T>))
         return nullptr;
 
-    return std::make_shared<Samples<SampleXYZV<T>>>(std::move(sampleTimes), std::move(samples));
+    return std::make_shared<XYZVSamples<T>>(std::move(sampleTimes), std::move(samples));
 }
 
 template<typename T>
-using SamplesMap = std::unordered_map<fs::path, std::weak_ptr<const Samples<T>>, util::PathHasher>;
+using SamplesMap = std::unordered_map<fs::path, std::weak_ptr<const T>, util::PathHasher>;
 
 template<typename T, typename F>
-std::shared_ptr<const Samples<T>>
+std::shared_ptr<const T>
 findSamples(SamplesMap<T>& cache, const fs::path& filename, F loader)
 {
     auto it = cache.try_emplace(filename).first;
     if (auto cachedSamples = it->second.lock(); cachedSamples != nullptr)
         return cachedSamples;
 
+    util::FileAccessScope access("trajectory", filename);
     auto samples = loader(filename);
     if (samples == nullptr)
     {
+        access.setFailed();
         cache.erase(it);
         return nullptr;
     }
@@ -758,14 +1198,17 @@ public:
 
     std::shared_ptr<const Samples<SampleXYZ<float>>> findXYZSingle(const fs::path&);
     std::shared_ptr<const Samples<SampleXYZ<double>>> findXYZDouble(const fs::path&);
-    std::shared_ptr<const Samples<SampleXYZV<float>>> findXYZVSingle(const fs::path&);
-    std::shared_ptr<const Samples<SampleXYZV<double>>> findXYZVDouble(const fs::path&);
+    std::shared_ptr<const XYZVSamples<float>> findXYZVSingle(const fs::path&);
+    std::shared_ptr<const XYZVSamples<double>> findXYZVDouble(const fs::path&);
+
+    // Memory of the sample sets in use, and their number
+    std::size_t getMemoryUsage(std::size_t& count) const;
 
 private:
-    SamplesMap<SampleXYZ<float>> samplesXYZSingle;
-    SamplesMap<SampleXYZ<double>> samplesXYZDouble;
-    SamplesMap<SampleXYZV<float>> samplesXYZVSingle;
-    SamplesMap<SampleXYZV<double>> samplesXYZVDouble;
+    SamplesMap<Samples<SampleXYZ<float>>> samplesXYZSingle;
+    SamplesMap<Samples<SampleXYZ<double>>> samplesXYZDouble;
+    SamplesMap<XYZVSamples<float>> samplesXYZVSingle;
+    SamplesMap<XYZVSamples<double>> samplesXYZVDouble;
 };
 
 std::shared_ptr<const Samples<SampleXYZ<float>>>
@@ -780,7 +1223,7 @@ SamplesManager::findXYZDouble(const fs::path& filename)
     return findSamples(samplesXYZDouble, filename, &LoadSamplesXYZAscii<double>);
 }
 
-std::shared_ptr<const Samples<SampleXYZV<float>>>
+std::shared_ptr<const XYZVSamples<float>>
 SamplesManager::findXYZVSingle(const fs::path& filename)
 {
     switch (DetermineFileType(filename))
@@ -795,7 +1238,7 @@ SamplesManager::findXYZVSingle(const fs::path& filename)
     }
 }
 
-std::shared_ptr<const Samples<SampleXYZV<double>>>
+std::shared_ptr<const XYZVSamples<double>>
 SamplesManager::findXYZVDouble(const fs::path& filename)
 {
     switch (DetermineFileType(filename))
@@ -810,6 +1253,39 @@ SamplesManager::findXYZVDouble(const fs::path& filename)
     }
 }
 
+template<typename T>
+std::size_t
+getSamplesMemoryUsage(const SamplesMap<T>& cache, std::size_t& count)
+{
+    std::size_t bytes = 0;
+    for (const auto& [filename, weakSamples] : cache)
+    {
+        if (auto samples = weakSamples.lock(); samples != nullptr)
+        {
+            bytes += samples->getMemoryUsage();
+            ++count;
+        }
+    }
+
+    return bytes;
+}
+
+std::size_t
+SamplesManager::getMemoryUsage(std::size_t& count) const
+{
+    return getSamplesMemoryUsage(samplesXYZSingle, count) +
+           getSamplesMemoryUsage(samplesXYZDouble, count) +
+           getSamplesMemoryUsage(samplesXYZVSingle, count) +
+           getSamplesMemoryUsage(samplesXYZVDouble, count);
+}
+
+SamplesManager&
+getSamplesManager()
+{
+    static SamplesManager samplesManager;
+    return samplesManager;
+}
+
 } // end unnamed namespace
 
 /*! Load a trajectory file containing positions without velocities.
@@ -819,7 +1295,7 @@ LoadSampledTrajectory(const fs::path& filename,
                       TrajectoryInterpolation interpolation,
                       TrajectoryPrecision precision)
 {
-    static SamplesManager samplesManager;
+    SamplesManager& samplesManager = getSamplesManager();
     switch (DetermineFileType(filename))
     {
     case ContentType::CelestiaXYZTrajectory:
@@ -863,4 +1339,11 @@ LoadSampledTrajectory(const fs::path& filename,
     }
 }
 
+std::size_t
+GetSampledTrajectoryMemoryUsage(std::size_t& trajectoryCount)
+{
+    trajectoryCount = 0;
+    return getSamplesManager().getMemoryUsage(trajectoryCount);
+}
+
 } // end namespace celestia::ephem
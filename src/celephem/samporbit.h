@@ -9,6 +9,7 @@
 
 #pragma once
 
+#include <cstddef>
 #include <memory>
 
 #include <celcompat/filesystem.h>
@@ -34,4 +35,8 @@ std::shared_ptr<const Orbit> LoadSampledTrajectory(const fs::path&,
                                                    TrajectoryInterpolation,
                                                    TrajectoryPrecision);
 
+// Memory held by the samples of the trajectory files in use, and the
+// number of files. Must be called from the thread which loads them.
+std::size_t GetSampledTrajectoryMemoryUsage(std::size_t& trajectoryCount);
+
 } // end namespace celestia::ephem
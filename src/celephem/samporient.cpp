@@ -14,6 +14,7 @@
 #include "samporient.h"
 
 #include <cassert>
+#include <cstddef>
 #include <cstdint>
 #include <istream>
 #include <utility>
@@ -68,6 +69,7 @@ public:
      *  to spin (i.e. there's no notion of an equatorial frame.)
      */
     Eigen::Quaterniond spin(double tjd) const override;
+    void computeOrientations(const double* tjd, Eigen::Quaterniond* orientations, std::size_t count) const override;
 
     bool isPeriodic() const override;
     double getPeriod() const override;
@@ -75,12 +77,13 @@ public:
     void getValidRange(double& begin, double& end) const override;
 
 private:
-    Eigen::Quaternionf getOrientation(double tjd) const;
+    Eigen::Quaternionf getOrientation(double tjd, std::uint32_t& hint) const;
 
     // Storing sample times and rotations separately avoids padding due to
     // the 16-byte alignment of Quaternionf
     std::vector<double> sampleTimes;
     std::vector<Eigen::Quaternionf> rotations;
+    SampleTimeIndex timeIndex;
     mutable std::uint32_t lastSample{0};
 };
 
@@ -93,6 +96,7 @@ SampledOrientation::SampledOrientation(std::vector<double>&& _sampleTimes,
     assert(!sampleTimes.empty() && sampleTimes.size() == rotations.size());
     sampleTimes.shrink_to_fit();
     rotations.shrink_to_fit();
+    timeIndex = SampleTimeIndex(sampleTimes);
 
     // Apply a 90-degree rotation around the x-axis to convert the orientation
     // to Celestia's coordinate system
@@ -107,7 +111,20 @@ Eigen::Quaterniond
 SampledOrientation::spin(double tjd) const
 {
     // TODO: cache the last value returned
-    return getOrientation(tjd).cast<double>();
+    return getOrientation(tjd, lastSample).cast<double>();
+}
+
+
+// Evaluate the times with a hint of their own, so that the samples of
+// ordered times are found by stepping from one to the next
+void
+SampledOrientation::computeOrientations(const double* tjd,
+                                        Eigen::Quaterniond* orientations,
+                                        std::size_t count) const
+{
+    std::uint32_t hint = lastSample;
+    for (std::size_t i = 0; i < count; ++i)
+        orientations[i] = getOrientation(tjd[i], hint).cast<double>();
 }
 
 
@@ -134,12 +151,12 @@ SampledOrientation::getValidRange(double& begin, double& end) const
 
 
 Eigen::Quaternionf
-SampledOrientation::getOrientation(double tjd) const
+SampledOrientation::getOrientation(double tjd, std::uint32_t& hint) const
 {
     if (sampleTimes.size() == 1)
         return rotations.front();
 
-    std::uint32_t n = GetSampleIndex(tjd, lastSample, sampleTimes);
+    std::uint32_t n = GetSampleIndex(tjd, hint, sampleTimes, timeIndex);
     if (n == 0)
         return rotations.front();
     else if (n == sampleTimes.size())
@@ -0,0 +1,22 @@
+// segments.h
+//
+// Copyright (C) 2024, Celestia Development Team
+//
+// Limits of the fixed length time segments of the ephemeris caches.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+namespace celestia::ephem
+{
+
+// The cached orbits and rotation models split time into segments counted
+// from J2000. Times further from J2000 than this many segments are evaluated
+// directly, as the segment index and bounds would lose their precision.
+constexpr double MaxSegmentIndex = 1.0e15;
+
+} // end namespace celestia::ephem
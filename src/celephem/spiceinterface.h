@@ -11,7 +11,11 @@
 
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 
 #include <celcompat/filesystem.h>
 
@@ -20,9 +24,48 @@ namespace celestia::ephem
 
 bool InitializeSpice();
 
+// CSPICE keeps the kernel pool and the error state in globals, so calls
+// into it from different threads must hold this lock. It may be taken
+// again by the thread that holds it.
+std::unique_lock<std::recursive_mutex> LockSpice();
+
 // SPICE utility functions
 
 bool GetNaifId(const std::string& name, int* id);
 bool LoadSpiceKernel(const fs::path& filepath);
 
+/*! Segments of time interpolated from SPICE, shared by the threads which
+ *  evaluate an object. Segments are created outside the lock, so a
+ *  segment requested by two threads at once may be sampled twice, and
+ *  the cache is cleared when it grows past MaxSegments.
+ */
+template<typename T>
+class SpiceSegmentCache
+{
+ public:
+    static constexpr std::size_t MaxSegments = 4096;
+
+    template<typename F>
+    T get(std::int64_t index, F create) const
+    {
+        {
+            std::scoped_lock lock(mutex);
+            if (auto it = segments.find(index); it != segments.end())
+                return it->second;
+        }
+
+        T segment = create();
+
+        std::scoped_lock lock(mutex);
+        if (segments.size() >= MaxSegments)
+            segments.clear();
+        segments.try_emplace(index, segment);
+        return segment;
+    }
+
+ private:
+    mutable std::mutex mutex;
+    mutable std::unordered_map<std::int64_t, T> segments;
+};
+
 }
@@ -9,12 +9,15 @@
 // as published by the Free Software Foundation; either version 2
 // of the License, or (at your option) any later version.
 
+#include <algorithm>
+#include <cmath>
 #include <utility>
 
 #include <SpiceUsr.h>
 
 #include <celastro/date.h>
 #include <celutil/logger.h>
+#include "segments.h"
 #include "spiceinterface.h"
 #include "spiceorbit.h"
 
@@ -29,6 +32,30 @@ namespace
 
 constexpr double MILLISEC = astro::secsToDays(0.001);
 
+constexpr double SegmentsPerPeriod = 256.0;
+constexpr double NonPeriodicSegmentLength = 0.125; // days
+
+// Error allowed at the middle of a segment, in kilometers and relative to
+// the distance from the origin
+constexpr double AbsoluteTolerance = 0.001;
+constexpr double RelativeTolerance = 1.0e-8;
+
+// Cubic Hermite interpolation between the states at the ends of a segment
+template<typename S>
+void
+interpolate(const S& segment, double jd, Eigen::Vector3d* position, Eigen::Vector3d* velocity)
+{
+    double h = segment.end - segment.begin;
+    double t = (jd - segment.begin) / h;
+    Eigen::Vector3d hv0 = segment.v0 * h;
+    Eigen::Vector3d a = 2.0 * (segment.p0 - segment.p1) + segment.v1 * h + hv0;
+    Eigen::Vector3d b = 3.0 * (segment.p1 - segment.p0) - 2.0 * hv0 - segment.v1 * h;
+    if (position != nullptr)
+        *position = segment.p0 + t * (hv0 + t * (b + t * a));
+    if (velocity != nullptr)
+        *velocity = (hv0 + t * (2.0 * b + t * 3.0 * a)) / h;
+}
+
 } // end unnamed namespace
 
 /*! Create a new SPICE orbit using with a valid interval specified
@@ -47,7 +74,8 @@ SpiceOrbit::SpiceOrbit(std::string  _targetBodyName,
     spiceErr(false),
     validIntervalBegin(_beginning),
     validIntervalEnd(_ending),
-    useDefaultTimeInterval(false)
+    useDefaultTimeInterval(false),
+    segmentLength(NonPeriodicSegmentLength)
 {
 }
 
@@ -70,7 +98,8 @@ SpiceOrbit::SpiceOrbit(std::string  _targetBodyName,
     spiceErr(false),
     validIntervalBegin(0.0),
     validIntervalEnd(0.0),
-    useDefaultTimeInterval(true)
+    useDefaultTimeInterval(true),
+    segmentLength(NonPeriodicSegmentLength)
 {
 }
 
@@ -123,6 +152,8 @@ SpiceOrbit::init()
         return false;
     }
 
+    auto lock = LockSpice();
+
     SpiceInt spkCount = 0;
     ktotal_c("spk", &spkCount);
 
@@ -234,98 +265,152 @@ SpiceOrbit::init()
         reset_c();
     }
 
+    if (isPeriodic())
+        segmentLength = period / SegmentsPerPeriod;
+
     return !spiceErr;
 }
 
 
+void
+SpiceOrbit::computeState(double jd, Eigen::Vector3d& position, Eigen::Vector3d& velocity) const
+{
+    // Input time for SPICE is seconds after J2000
+    double t = astro::daysToSecs(jd - astro::J2000);
+    double state[6];
+    double lt;          // One way light travel time
+
+    auto lock = LockSpice();
+    spkgeo_c(targetID,
+             t,
+             "eclipj2000",
+             originID,
+             state,
+             &lt);
+
+    // This shouldn't happen, since we've already computed the valid
+    // coverage interval.
+    if (failed_c())
+    {
+        // Print the error message
+        char errMsg[1024];
+        getmsg_c("long", sizeof(errMsg), errMsg);
+        GetLogger()->warn("{}\n", errMsg);
+
+        // Reset the error state
+        reset_c();
+    }
+
+    // Transform into Celestia's coordinate system, and from km/s to km/day
+    double d2s = astro::daysToSecs(1.0);
+    position = Eigen::Vector3d(state[0], state[2], -state[1]);
+    velocity = Eigen::Vector3d(state[3] * d2s, state[5] * d2s, -state[4] * d2s);
+}
+
+
+SpiceOrbit::Segment
+SpiceOrbit::sampleSegment(std::int64_t index) const
+{
+    Segment segment;
+    segment.begin = std::max(astro::J2000 + static_cast<double>(index) * segmentLength, validIntervalBegin);
+    segment.end = std::min(astro::J2000 + static_cast<double>(index + 1) * segmentLength, validIntervalEnd);
+    if (!(segment.end > segment.begin))
+        return segment;
+
+    computeState(segment.begin, segment.p0, segment.v0);
+    computeState(segment.end, segment.p1, segment.v1);
+
+    // The error of the interpolation is largest near the middle
+    double middle = (segment.begin + segment.end) * 0.5;
+    Eigen::Vector3d expected;
+    Eigen::Vector3d velocity;
+    computeState(middle, expected, velocity);
+
+    Eigen::Vector3d position;
+    interpolate(segment, middle, &position, nullptr);
+    double error = (position - expected).norm();
+    segment.direct = !(error <= std::max(AbsoluteTolerance, expected.norm() * RelativeTolerance));
+
+    return segment;
+}
+
+
+SpiceOrbit::Segment
+SpiceOrbit::findSegment(double jd) const
+{
+    double index = std::floor((jd - astro::J2000) / segmentLength);
+    if (!(std::abs(index) < MaxSegmentIndex))
+    {
+        return Segment();
+    }
+
+    auto i = static_cast<std::int64_t>(index);
+    return segments.get(i, [this, i] { return sampleSegment(i); });
+}
+
+
 Eigen::Vector3d
 SpiceOrbit::computePosition(double jd) const
 {
+    if (spiceErr)
+        return Eigen::Vector3d::Zero();
+
     if (jd < validIntervalBegin)
         jd = validIntervalBegin;
     else if (jd > validIntervalEnd)
         jd = validIntervalEnd;
 
-    if (spiceErr)
-    {
-        return Eigen::Vector3d::Zero();
-    }
+    Eigen::Vector3d position;
+    Eigen::Vector3d velocity;
+    if (Segment segment = findSegment(jd); !segment.direct)
+        interpolate(segment, jd, &position, nullptr);
     else
-    {
-        // Input time for SPICE is seconds after J2000
-        double t = astro::daysToSecs(jd - astro::J2000);
-        double position[3];
-        double lt;          // One way light travel time
-
-        spkgps_c(targetID,
-                 t,
-                 "eclipj2000",
-                 originID,
-                 position,
-                 &lt);
-
-        // This shouldn't happen, since we've already computed the valid
-        // coverage interval.
-        if (failed_c())
-        {
-            // Print the error message
-            char errMsg[1024];
-            getmsg_c("long", sizeof(errMsg), errMsg);
-            GetLogger()->warn("{}\n", errMsg);
+        computeState(jd, position, velocity);
 
-            // Reset the error state
-            reset_c();
-        }
-
-        // Transform into Celestia's coordinate system
-        return Eigen::Vector3d(position[0], position[2], -position[1]);
-    }
+    return position;
 }
 
 
 Eigen::Vector3d
 SpiceOrbit::computeVelocity(double jd) const
 {
+    if (spiceErr)
+        return Eigen::Vector3d::Zero();
+
     if (jd < validIntervalBegin)
         jd = validIntervalBegin;
     else if (jd > validIntervalEnd)
         jd = validIntervalEnd;
 
-    if (spiceErr)
-    {
-        return Eigen::Vector3d::Zero();
-    }
+    Eigen::Vector3d position;
+    Eigen::Vector3d velocity;
+    if (Segment segment = findSegment(jd); !segment.direct)
+        interpolate(segment, jd, nullptr, &velocity);
     else
-    {
-        // Input time for SPICE is seconds after J2000
-        double t = astro::daysToSecs(jd - astro::J2000);
-        double state[6];
-        double lt;          // One way light travel time
-
-        spkgeo_c(targetID,
-                 t,
-                 "eclipj2000",
-                 originID,
-                 state,
-                 &lt);
-
-        // This shouldn't happen, since we've already computed the valid
-        // coverage interval.
-        if (failed_c())
-        {
-            // Print the error message
-            char errMsg[1024];
-            getmsg_c("long", sizeof(errMsg), errMsg);
-            GetLogger()->warn("{}\n", errMsg);
+        computeState(jd, position, velocity);
 
-            // Reset the error state
-            reset_c();
-        }
+    return velocity;
+}
 
-        // Transform into Celestia's coordinate system, and from km/s to km/day
-        double d2s = astro::daysToSecs(1.0);
-        return Eigen::Vector3d(state[3] * d2s, state[5] * d2s, -state[4] * d2s);
-    }
+
+Eigen::Vector3d
+SpiceOrbit::positionAtTime(double jd) const
+{
+    return computePosition(jd);
+}
+
+
+Eigen::Vector3d
+SpiceOrbit::velocityAtTime(double jd) const
+{
+    return computeVelocity(jd);
+}
+
+
+bool
+SpiceOrbit::isThreadSafe() const
+{
+    return true;
 }
 
 
@@ -17,10 +17,17 @@
 
 #include <celcompat/filesystem.h>
 #include "orbit.h"
+#include "spiceinterface.h"
 
 namespace celestia::ephem
 {
 
+/*! Trajectory of a SPICE object. Positions are interpolated from states
+ *  sampled from SPICE over short segments of time, which are checked
+ *  against SPICE when they are first sampled; where the interpolation
+ *  is not accurate enough, SPICE is called directly. Calls into SPICE are
+ *  serialized, so the orbit may be evaluated from several threads.
+ */
 class SpiceOrbit : public CachingOrbit
 {
  public:
@@ -59,9 +66,30 @@ class SpiceOrbit : public CachingOrbit
     Eigen::Vector3d computePosition(double jd) const override;
     Eigen::Vector3d computeVelocity(double jd) const override;
 
+    // The segments replace the cache of the last time, which can't be
+    // shared between threads
+    Eigen::Vector3d positionAtTime(double jd) const override;
+    Eigen::Vector3d velocityAtTime(double jd) const override;
+
+    bool isThreadSafe() const override;
     void getValidRange(double& begin, double& end) const override;
 
  private:
+    struct Segment
+    {
+        double begin{ 0.0 };
+        double end{ 0.0 };
+        Eigen::Vector3d p0;
+        Eigen::Vector3d v0;
+        Eigen::Vector3d p1;
+        Eigen::Vector3d v1;
+        bool direct{ true };
+    };
+
+    Segment findSegment(double jd) const;
+    Segment sampleSegment(std::int64_t index) const;
+    void computeState(double jd, Eigen::Vector3d& position, Eigen::Vector3d& velocity) const;
+
     const std::string targetBodyName;
     const std::string originName;
     double period;
@@ -77,6 +105,9 @@ class SpiceOrbit : public CachingOrbit
 
     bool useDefaultTimeInterval;
 
+    double segmentLength;
+    SpiceSegmentCache<Segment> segments;
+
     bool init();
     bool loadRequiredKernel(const fs::path&, const std::string&);
 };
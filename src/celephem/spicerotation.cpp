@@ -12,6 +12,8 @@
 
 #include "spicerotation.h"
 
+#include <algorithm>
+#include <cmath>
 #include <limits>
 
 #include <SpiceUsr.h>
@@ -20,6 +22,7 @@
 #include <celcompat/numbers.h>
 #include <celmath/geomutil.h>
 #include <celutil/logger.h>
+#include "segments.h"
 #include "spiceinterface.h"
 
 using celestia::util::GetLogger;
@@ -33,6 +36,13 @@ namespace
 
 constexpr double MILLISEC = astro::secsToDays(0.001);
 
+constexpr double SegmentsPerPeriod = 256.0;
+constexpr double NonPeriodicSegmentLength = 1.0 / 96.0; // days
+
+// Angle allowed between the interpolated and the SPICE orientation at the
+// middle of a segment, in radians
+constexpr double AngularTolerance = 1.0e-6;
+
 } // end unnamed namespace
 
 /*! Create a new rotation model based on a SPICE frame. The
@@ -53,7 +63,8 @@ SpiceRotation::SpiceRotation(const std::string& frameName,
     m_period(period),
     m_spiceErr(false),
     m_validIntervalBegin(beginning),
-    m_validIntervalEnd(ending)
+    m_validIntervalEnd(ending),
+    m_segmentLength(period > 0.0 ? period / SegmentsPerPeriod : NonPeriodicSegmentLength)
 {
 }
 
@@ -74,7 +85,8 @@ SpiceRotation::SpiceRotation(const std::string& frameName,
     m_period(period),
     m_spiceErr(false),
     m_validIntervalBegin(-std::numeric_limits<double>::infinity()),
-    m_validIntervalEnd(std::numeric_limits<double>::infinity())
+    m_validIntervalEnd(std::numeric_limits<double>::infinity()),
+    m_segmentLength(period > 0.0 ? period / SegmentsPerPeriod : NonPeriodicSegmentLength)
 {
 }
 
@@ -120,6 +132,7 @@ SpiceRotation::init()
     // adequate data in the kernel.
     double beginning = astro::daysToSecs(m_validIntervalBegin - astro::J2000);
     double xform[3][3];
+    auto lock = LockSpice();
     pxform_c(m_frameName.c_str(), m_frameName.c_str(), beginning, xform);
     if (failed_c())
     {
@@ -136,6 +149,67 @@ SpiceRotation::init()
 }
 
 
+Eigen::Quaterniond
+SpiceRotation::computeOrientation(double jd) const
+{
+    // Input time for SPICE is seconds after J2000
+    double t = astro::daysToSecs(jd - astro::J2000);
+    double xform[3][3];
+
+    auto lock = LockSpice();
+    pxform_c(m_frameName.c_str(), m_baseFrameName.c_str(), t, xform);
+
+    if (failed_c())
+    {
+        // Print the error message
+        char errMsg[1024];
+        getmsg_c("long", sizeof(errMsg), errMsg);
+        GetLogger()->error("{}\n", errMsg);
+
+        // Reset the error state
+        reset_c();
+    }
+
+    // Eigen stores matrices in column-major order...
+    double matrixData[9] =
+    {
+        xform[0][0], xform[0][1], xform[0][2],
+        xform[1][0], xform[1][1], xform[1][2],
+        xform[2][0], xform[2][1], xform[2][2]
+    };
+
+    // ...but Celestia's rotations are reversed, thus the extra
+    // call to conjugate()
+    Eigen::Quaterniond q = Eigen::Quaterniond(Eigen::Map<Eigen::Matrix3d>(matrixData)).conjugate();
+
+    // Transform into Celestia's coordinate system
+    return math::YRot180<double> *
+           math::XRot90Conjugate<double> *
+           q.conjugate() *
+           math::XRot90<double>;
+}
+
+
+SpiceRotation::Segment
+SpiceRotation::sampleSegment(std::int64_t index) const
+{
+    Segment segment;
+    segment.begin = std::max(astro::J2000 + static_cast<double>(index) * m_segmentLength, m_validIntervalBegin);
+    segment.end = std::min(astro::J2000 + static_cast<double>(index + 1) * m_segmentLength, m_validIntervalEnd);
+    if (!(segment.end > segment.begin))
+        return segment;
+
+    segment.q0 = computeOrientation(segment.begin);
+    segment.q1 = computeOrientation(segment.end);
+
+    Eigen::Quaterniond expected = computeOrientation((segment.begin + segment.end) * 0.5);
+    double error = expected.angularDistance(segment.q0.slerp(0.5, segment.q1));
+    segment.direct = !(error <= AngularTolerance);
+
+    return segment;
+}
+
+
 Eigen::Quaterniond
 SpiceRotation::computeSpin(double jd) const
 {
@@ -145,46 +219,46 @@ SpiceRotation::computeSpin(double jd) const
         jd = m_validIntervalEnd;
 
     if (m_spiceErr)
-    {
         return Eigen::Quaterniond::Identity();
-    }
-    else
-    {
-        // Input time for SPICE is seconds after J2000
-        double t = astro::daysToSecs(jd - astro::J2000);
-        double xform[3][3];
-
-        pxform_c(m_frameName.c_str(), m_baseFrameName.c_str(), t, xform);
-
-        if (failed_c())
-        {
-            // Print the error message
-            char errMsg[1024];
-            getmsg_c("long", sizeof(errMsg), errMsg);
-            GetLogger()->error("{}\n", errMsg);
-
-            // Reset the error state
-            reset_c();
-        }
-
-        // Eigen stores matrices in column-major order...
-        double matrixData[9] =
-        {
-            xform[0][0], xform[0][1], xform[0][2],
-            xform[1][0], xform[1][1], xform[1][2],
-            xform[2][0], xform[2][1], xform[2][2]
-        };
-
-        // ...but Celestia's rotations are reversed, thus the extra
-        // call to conjugate()
-        Eigen::Quaterniond q = Eigen::Quaterniond(Eigen::Map<Eigen::Matrix3d>(matrixData)).conjugate();
-
-        // Transform into Celestia's coordinate system
-        return math::YRot180<double> *
-               math::XRot90Conjugate<double> *
-               q.conjugate() *
-               math::XRot90<double>;
-    }
+
+    double index = std::floor((jd - astro::J2000) / m_segmentLength);
+    if (!(std::abs(index) < MaxSegmentIndex))
+        return computeOrientation(jd);
+
+    auto i = static_cast<std::int64_t>(index);
+    Segment segment = m_segments.get(i, [this, i] { return sampleSegment(i); });
+    if (segment.direct)
+        return computeOrientation(jd);
+
+    return segment.q0.slerp((jd - segment.begin) / (segment.end - segment.begin), segment.q1);
+}
+
+
+Eigen::Quaterniond
+SpiceRotation::spin(double jd) const
+{
+    return computeSpin(jd);
+}
+
+
+Eigen::Quaterniond
+SpiceRotation::equatorOrientationAtTime(double jd) const
+{
+    return computeEquatorOrientation(jd);
+}
+
+
+Eigen::Vector3d
+SpiceRotation::angularVelocityAtTime(double jd) const
+{
+    return RotationModel::angularVelocityAtTime(jd);
+}
+
+
+bool
+SpiceRotation::isThreadSafe() const
+{
+    return true;
 }
 
 } // end namespace celestia::ephem
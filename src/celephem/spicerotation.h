@@ -12,16 +12,23 @@
 
 #pragma once
 
+#include <cstdint>
 #include <string>
 
 #include <Eigen/Geometry>
 
 #include <celcompat/filesystem.h>
 #include "rotation.h"
+#include "spiceinterface.h"
 
 namespace celestia::ephem
 {
 
+/*! Orientation of a SPICE frame. Like SpiceOrbit, orientations are
+ *  interpolated over short segments of time which are checked against
+ *  SPICE when they are first sampled, and calls into SPICE are
+ *  serialized, so the model may be evaluated from several threads.
+ */
 class SpiceRotation : public CachingRotationModel
 {
  public:
@@ -59,7 +66,27 @@ class SpiceRotation : public CachingRotationModel
 
     Eigen::Quaterniond computeSpin(double jd) const override;
 
+    // The segments replace the cache of the last time, which can't be
+    // shared between threads
+    Eigen::Quaterniond spin(double jd) const override;
+    Eigen::Quaterniond equatorOrientationAtTime(double jd) const override;
+    Eigen::Vector3d angularVelocityAtTime(double jd) const override;
+
+    bool isThreadSafe() const override;
+
  private:
+    struct Segment
+    {
+        double begin{ 0.0 };
+        double end{ 0.0 };
+        Eigen::Quaterniond q0;
+        Eigen::Quaterniond q1;
+        bool direct{ true };
+    };
+
+    Segment sampleSegment(std::int64_t index) const;
+    Eigen::Quaterniond computeOrientation(double jd) const;
+
     const std::string m_frameName;
     const std::string m_baseFrameName;
     double m_period;
@@ -67,6 +94,9 @@ class SpiceRotation : public CachingRotationModel
     double m_validIntervalBegin;
     double m_validIntervalEnd;
 
+    double m_segmentLength;
+    SpiceSegmentCache<Segment> m_segments;
+
     bool loadRequiredKernel(const fs::path&, const std::string&);
     bool init();
 };
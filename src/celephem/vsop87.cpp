@@ -19,6 +19,7 @@
 #include <cstddef>
 #include <memory>
 #include <utility>
+#include <vector>
 
 #include <config.h>
 
@@ -27,6 +28,7 @@
 #include <celcompat/numbers.h>
 #include <celmath/mathlib.h>
 #include "orbit.h"
+#include "vsopseries.h"
 
 namespace celestia::ephem
 {
@@ -34,11 +36,6 @@ namespace celestia::ephem
 namespace
 {
 
-struct VSOPTerm
-{
-    double A, B, C;
-};
-
 struct VSOPSeries
 {
     template<typename std::size_t N>
@@ -11000,32 +10997,46 @@ constexpr std::array sun_Z {
     VSOPSeries(sun_Z0), VSOPSeries(sun_Z1), VSOPSeries(sun_Z2),
 };
 
-double
-SumSeries(const VSOPSeries& series, double t)
+template<std::size_t N>
+VSOPVariable
+MakeVariable(const std::array<VSOPSeries, N>& series)
 {
-    if (series.nTerms < 1)
-        return 0.0;
-
-    double x = 0.0;
-    const VSOPTerm* term = &series.terms[0];
-    for (std::size_t i = 0; i < series.nTerms; i++, term++)
-        x += term->A * std::cos(term->B + term->C * t);
+    VSOPVariable variable;
+    for (const VSOPSeries& s : series)
+        variable.addSeries(s.terms, s.nTerms);
+    return variable;
+}
 
-    return x;
+// t is Julian millenia since J2000.0
+constexpr double
+JulianMillenia(double jd)
+{
+    return (jd - 2451545.0) / 365250.0;
 }
 
 class VSOP87Orbit : public CachingOrbit
 {
  private:
-    const VSOPSeries* vsL;
-    std::size_t nL;
-    const VSOPSeries* vsB;
-    std::size_t nB;
-    const VSOPSeries* vsR;
-    std::size_t nR;
+    VSOPVariable vsL;
+    VSOPVariable vsB;
+    VSOPVariable vsR;
     double period;
     double boundingRadius;
 
+    static Eigen::Vector3d
+    toPosition(double l, double b, double r)
+    {
+        r *= astro::KM_PER_AU<double>;
+
+        // Corrections for internal coordinate system
+        b -= celestia::numbers::pi / 2;
+        l += celestia::numbers::pi;
+
+        return Eigen::Vector3d(std::cos(l) * std::sin(b) * r,
+                               std::cos(b) * r,
+                               -std::sin(l) * std::sin(b) * r);
+    }
+
  public:
     template<std::size_t NL, std::size_t NB, std::size_t NR>
     VSOP87Orbit(const std::array<VSOPSeries, NL>& _vsL,
@@ -11033,9 +11044,9 @@ class VSOP87Orbit : public CachingOrbit
                 const std::array<VSOPSeries, NR>& _vsR,
                 double _period,
                 double _boundingRadius) :
-        vsL(_vsL.data()), nL(_vsL.size()),
-        vsB(_vsB.data()), nB(_vsB.size()),
-        vsR(_vsR.data()), nR(_vsR.size()),
+        vsL(MakeVariable(_vsL)),
+        vsB(MakeVariable(_vsB)),
+        vsR(MakeVariable(_vsR)),
         period(_period),
         boundingRadius(_boundingRadius)
     {
@@ -11058,55 +11069,35 @@ class VSOP87Orbit : public CachingOrbit
     Eigen::Vector3d
     computePosition(double jd) const override
     {
-        // t is Julian millenia since J2000.0
-        double t = (jd - 2451545.0) / 365250.0;
-
-        // Heliocentric coordinates
-        double l = 0.0; // longitude
-        double b = 0.0; // latitude
-        double r = 0.0; // radius
-
-        std::size_t i;
-        double T;
-
-        // Evaluate series for l
-        T = 1;
-        for (i = 0; i < nL; i++)
-        {
-            l += SumSeries(vsL[i], t) * T;
-            T = t * T;
-        }
-
-        // Evaluate series for b
-        T = 1;
-        for (i = 0; i < nB; i++)
-        {
-            b += SumSeries(vsB[i], t) * T;
-            T = t * T;
-        }
-
-        // Evaluate series for r
-        T = 1;
-        for (i = 0; i < nR; i++)
-        {
-            r += SumSeries(vsR[i], t) * T;
-            T = t * T;
-        }
-
-        r *= astro::KM_PER_AU<double>;
+        double t = JulianMillenia(jd);
 
-        // Corrections for internal coordinate system
-        b -= celestia::numbers::pi / 2;
-        l += celestia::numbers::pi;
+        // Heliocentric longitude, latitude and radius
+        return toPosition(vsL.evaluate(t), vsB.evaluate(t), vsR.evaluate(t));
+    }
 
-        return Eigen::Vector3d(std::cos(l) * std::sin(b) * r,
-                               std::cos(b) * r,
-                               -std::sin(l) * std::sin(b) * r);
+    void
+    computePositions(const double* jd, Eigen::Vector3d* positions, std::size_t count) const override
+    {
+        std::vector<double> t(count);
+        for (std::size_t i = 0; i < count; ++i)
+            t[i] = JulianMillenia(jd[i]);
+
+        std::vector<double> l(count);
+        std::vector<double> b(count);
+        std::vector<double> r(count);
+        vsL.evaluate(t.data(), l.data(), count);
+        vsB.evaluate(t.data(), b.data(), count);
+        vsR.evaluate(t.data(), r.data(), count);
+
+        for (std::size_t i = 0; i < count; ++i)
+            positions[i] = toPosition(l[i], b[i], r[i]);
     }
 
 
-    /** Custom implementation of sample() for VSOP87 orbits. The default
-      * implementation runs too slowly and produces too many samples.
+    /** Custom implementation of sample() for VSOP87 orbits. The planetary
+      * orbits are nearly circular, so the step doesn't need to be smaller
+      * than 1/1000 of the period, and the positions are costly enough that
+      * the search for the step starts from a typical one.
       */
     void
     sample(double startTime, double endTime, OrbitSampleProc& proc) const override
@@ -11114,14 +11105,11 @@ class VSOP87Orbit : public CachingOrbit
         double span = getPeriod();
 
         AdaptiveSamplingParameters samplingParams{};
-        samplingParams.tolerance = 1.0; // kilometers
-
-        // startStep, minStep, and maxStep are all set to identical values,
-        // so the adaptive sampling function actuall behaves like uniform
-        // sampling.
-        samplingParams.startStep = span / 150.0;
-        samplingParams.minStep   = samplingParams.startStep;
-        samplingParams.maxStep   = samplingParams.startStep;
+        samplingParams.tolerance        = 1.0; // kilometers
+        samplingParams.angularTolerance = proc.angularTolerance();
+        samplingParams.startStep        = span / 150.0;
+        samplingParams.minStep          = span / 1000.0;
+        samplingParams.maxStep          = span / 20.0;
 
         adaptiveSample(startTime, endTime, proc, samplingParams);
     }
@@ -11131,15 +11119,21 @@ class VSOP87Orbit : public CachingOrbit
 class VSOP87OrbitRect : public CachingOrbit
 {
  private:
-    const VSOPSeries* vsX;
-    std::size_t nX;
-    const VSOPSeries* vsY;
-    std::size_t nY;
-    const VSOPSeries* vsZ;
-    std::size_t nZ;
+    VSOPVariable vsX;
+    VSOPVariable vsY;
+    VSOPVariable vsZ;
     double period;
     double boundingRadius;
 
+    static Eigen::Vector3d
+    toPosition(double x, double y, double z)
+    {
+        Eigen::Vector3d v = Eigen::Vector3d(x, y, z) * astro::KM_PER_AU<double>;
+
+        // Corrections for internal coordinate system
+        return Eigen::Vector3d(v.x(), v.z(), -v.y());
+    }
+
  public:
     template<std::size_t NX, std::size_t NY, std::size_t NZ>
     VSOP87OrbitRect(const std::array<VSOPSeries, NX>& _vsX,
@@ -11147,9 +11141,9 @@ class VSOP87OrbitRect : public CachingOrbit
                     const std::array<VSOPSeries, NZ>& _vsZ,
                     double _period,
                     double _boundingRadius) :
-        vsX(_vsX.data()), nX(_vsX.size()),
-        vsY(_vsY.data()), nY(_vsY.size()),
-        vsZ(_vsZ.data()), nZ(_vsZ.size()),
+        vsX(MakeVariable(_vsX)),
+        vsY(MakeVariable(_vsY)),
+        vsZ(MakeVariable(_vsZ)),
         period(_period),
         boundingRadius(_boundingRadius)
     {
@@ -11178,42 +11172,26 @@ class VSOP87OrbitRect : public CachingOrbit
     Eigen::Vector3d
     computePosition(double jd) const override
     {
-        // t is Julian millenia since J2000.0
-        double t = (jd - 2451545.0) / 365250.0;
-
-        Eigen::Vector3d v(Eigen::Vector3d::Zero());
-
-        std::size_t i;
-        double T;
-
-        // Evaluate series for x
-        T = 1;
-        for (i = 0; i < nX; i++)
-        {
-            v.x() += SumSeries(vsX[i], t) * T;
-            T = t * T;
-        }
-
-        // Evaluate series for y
-        T = 1;
-        for (i = 0; i < nY; i++)
-        {
-            v.y() += SumSeries(vsY[i], t) * T;
-            T = t * T;
-        }
-
-        // Evaluate series for z
-        T = 1;
-        for (i = 0; i < nZ; i++)
-        {
-            v.z() += SumSeries(vsZ[i], t) * T;
-            T = t * T;
-        }
-
-        v *= astro::KM_PER_AU<double>;
+        double t = JulianMillenia(jd);
+        return toPosition(vsX.evaluate(t), vsY.evaluate(t), vsZ.evaluate(t));
+    }
 
-        // Corrections for internal coordinate system
-        return Eigen::Vector3d(v.x(), v.z(), -v.y());
+    void
+    computePositions(const double* jd, Eigen::Vector3d* positions, std::size_t count) const override
+    {
+        std::vector<double> t(count);
+        for (std::size_t i = 0; i < count; ++i)
+            t[i] = JulianMillenia(jd[i]);
+
+        std::vector<double> x(count);
+        std::vector<double> y(count);
+        std::vector<double> z(count);
+        vsX.evaluate(t.data(), x.data(), count);
+        vsY.evaluate(t.data(), y.data(), count);
+        vsZ.evaluate(t.data(), z.data(), count);
+
+        for (std::size_t i = 0; i < count; ++i)
+            positions[i] = toPosition(x[i], y[i], z[i]);
     }
 };
 
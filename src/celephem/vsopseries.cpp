@@ -0,0 +1,335 @@
+// vsopseries.cpp
+//
+// Copyright (C) 2024, Celestia Development Team
+//
+// Evaluation of the series of the VSOP87 theory.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include "vsopseries.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CELESTIA_VSOP_SSE2
+#include <emmintrin.h>
+#elif (defined(__ARM_NEON) && defined(__aarch64__)) || defined(_M_ARM64)
+#define CELESTIA_VSOP_NEON
+#include <arm_neon.h>
+#endif
+
+namespace celestia::ephem
+{
+
+namespace
+{
+
+#if defined(CELESTIA_VSOP_SSE2) || defined(CELESTIA_VSOP_NEON)
+
+#define CELESTIA_VSOP_SIMD
+constexpr std::size_t Lanes = 2;
+
+// pi/2 split in two parts of 26 bits and the rest, so that the products
+// of the first two parts with the quadrant are exact for quadrants up to
+// 2^27
+constexpr double TwoOverPi = 0.6366197723675814;
+constexpr double PiOver2_1 = 1.5707963109016418;
+constexpr double PiOver2_2 = 1.5893254712295857e-08;
+constexpr double PiOver2_3 = 6.123233995736766e-17;
+
+// Arguments below which the quadrant is computed exactly
+constexpr double ReductionLimit = 1.0e8;
+
+// Minimax polynomials for sin and cos on [-pi/4, pi/4] from fdlibm
+constexpr double S1 = -1.66666666666666324348e-01;
+constexpr double S2 = 8.33333333332248946124e-03;
+constexpr double S3 = -1.98412698298579493134e-04;
+constexpr double S4 = 2.75573137070700676789e-06;
+constexpr double S5 = -2.50507602534068634195e-08;
+constexpr double S6 = 1.58969099521155010221e-10;
+
+constexpr double C1 = 4.16666666666666019037e-02;
+constexpr double C2 = -1.38888888888741095749e-03;
+constexpr double C3 = 2.48015872894767294178e-05;
+constexpr double C4 = -2.75573143513906633035e-07;
+constexpr double C5 = 2.08757232129817482790e-09;
+constexpr double C6 = -1.13596475577881948265e-11;
+
+#ifdef CELESTIA_VSOP_SSE2
+
+using Vec = __m128d;
+
+inline Vec load(const double* p) { return _mm_loadu_pd(p); }
+inline void store(double* p, Vec v) { _mm_storeu_pd(p, v); }
+inline Vec set1(double x) { return _mm_set1_pd(x); }
+inline Vec add(Vec a, Vec b) { return _mm_add_pd(a, b); }
+inline Vec sub(Vec a, Vec b) { return _mm_sub_pd(a, b); }
+inline Vec mul(Vec a, Vec b) { return _mm_mul_pd(a, b); }
+
+inline double
+sum(Vec v)
+{
+    return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v)));
+}
+
+#else
+
+using Vec = float64x2_t;
+
+inline Vec load(const double* p) { return vld1q_f64(p); }
+inline void store(double* p, Vec v) { vst1q_f64(p, v); }
+inline Vec set1(double x) { return vdupq_n_f64(x); }
+inline Vec add(Vec a, Vec b) { return vaddq_f64(a, b); }
+inline Vec sub(Vec a, Vec b) { return vsubq_f64(a, b); }
+inline Vec mul(Vec a, Vec b) { return vmulq_f64(a, b); }
+
+inline double
+sum(Vec v)
+{
+    return vaddvq_f64(v);
+}
+
+#endif
+
+inline Vec
+sinPolynomial(Vec r, Vec z)
+{
+    Vec p = add(set1(S5), mul(z, set1(S6)));
+    p = add(set1(S4), mul(z, p));
+    p = add(set1(S3), mul(z, p));
+    p = add(set1(S2), mul(z, p));
+    p = add(set1(S1), mul(z, p));
+    return add(r, mul(mul(r, z), p));
+}
+
+inline Vec
+cosPolynomial(Vec z)
+{
+    Vec p = add(set1(C5), mul(z, set1(C6)));
+    p = add(set1(C4), mul(z, p));
+    p = add(set1(C3), mul(z, p));
+    p = add(set1(C2), mul(z, p));
+    p = add(set1(C1), mul(z, p));
+    return add(sub(set1(1.0), mul(z, set1(0.5))), mul(mul(z, z), p));
+}
+
+// cos(x) = cos(r), -sin(r), -cos(r), sin(r) for x = k pi/2 + r with k mod 4
+// equal to 0, 1, 2, 3
+inline Vec
+cosLanes(Vec x)
+{
+#ifdef CELESTIA_VSOP_SSE2
+    __m128i k = _mm_cvtpd_epi32(mul(x, set1(TwoOverPi)));
+    Vec kf = _mm_cvtepi32_pd(k);
+#else
+    int64x2_t k = vcvtnq_s64_f64(mul(x, set1(TwoOverPi)));
+    Vec kf = vcvtq_f64_s64(k);
+#endif
+
+    Vec r = sub(x, mul(kf, set1(PiOver2_1)));
+    r = sub(r, mul(kf, set1(PiOver2_2)));
+    r = sub(r, mul(kf, set1(PiOver2_3)));
+    Vec z = mul(r, r);
+    Vec s = sinPolynomial(r, z);
+    Vec c = cosPolynomial(z);
+
+#ifdef CELESTIA_VSOP_SSE2
+    // Each lane of k is 32 bits, copy it to both halves of the 64-bit lanes
+    __m128i q = _mm_shuffle_epi32(k, _MM_SHUFFLE(1, 1, 0, 0));
+    __m128i one = _mm_set1_epi32(1);
+    __m128i two = _mm_set1_epi32(2);
+    Vec swap = _mm_castsi128_pd(_mm_cmpeq_epi32(_mm_and_si128(q, one), one));
+    Vec negate = _mm_castsi128_pd(_mm_cmpeq_epi32(_mm_and_si128(_mm_add_epi32(q, one), two), two));
+    Vec result = _mm_or_pd(_mm_and_pd(swap, s), _mm_andnot_pd(swap, c));
+    return _mm_xor_pd(result, _mm_and_pd(negate, set1(-0.0)));
+#else
+    int64x2_t one = vdupq_n_s64(1);
+    int64x2_t two = vdupq_n_s64(2);
+    uint64x2_t swap = vceqq_s64(vandq_s64(k, one), one);
+    uint64x2_t negate = vceqq_s64(vandq_s64(vaddq_s64(k, one), two), two);
+    Vec result = vbslq_f64(swap, s, c);
+    uint64x2_t sign = vandq_u64(negate, vreinterpretq_u64_f64(set1(-0.0)));
+    return vreinterpretq_f64_u64(veorq_u64(vreinterpretq_u64_f64(result), sign));
+#endif
+}
+
+// Sum of the terms at t, with the cosines of several terms at once
+double
+sumTerms(const double* A, const double* B, const double* C, std::size_t nTerms, double t)
+{
+    Vec tv = set1(t);
+    Vec s = set1(0.0);
+    for (std::size_t i = 0; i < nTerms; i += Lanes)
+        s = add(s, mul(load(A + i), cosLanes(add(load(B + i), mul(load(C + i), tv)))));
+
+    return sum(s);
+}
+
+// Sums of the terms at two sets of times, one time in each lane, loading
+// each term once for both
+void
+sumTerms(const double* A, const double* B, const double* C, std::size_t nTerms,
+         Vec tv0, Vec tv1, Vec& s0, Vec& s1)
+{
+    s0 = set1(0.0);
+    s1 = set1(0.0);
+    for (std::size_t i = 0; i < nTerms; ++i)
+    {
+        Vec a = set1(A[i]);
+        Vec b = set1(B[i]);
+        Vec c = set1(C[i]);
+        s0 = add(s0, mul(a, cosLanes(add(b, mul(c, tv0)))));
+        s1 = add(s1, mul(a, cosLanes(add(b, mul(c, tv1)))));
+    }
+}
+
+#else
+
+constexpr std::size_t Lanes = 1;
+
+#endif
+
+double
+sumTermsScalar(const double* A, const double* B, const double* C, std::size_t nTerms, double t)
+{
+    double x = 0.0;
+    for (std::size_t i = 0; i < nTerms; ++i)
+        x += A[i] * std::cos(B[i] + C[i] * t);
+
+    return x;
+}
+
+} // end unnamed namespace
+
+
+void
+VSOPVariable::addSeries(const VSOPTerm* terms, std::size_t nTerms)
+{
+    for (std::size_t i = 0; i < nTerms; ++i)
+    {
+        amplitudes.push_back(terms[i].A);
+        phases.push_back(terms[i].B);
+        frequencies.push_back(terms[i].C);
+        maxPhase = std::max(maxPhase, std::abs(terms[i].B));
+        maxFrequency = std::max(maxFrequency, std::abs(terms[i].C));
+    }
+
+    // Terms with zero amplitude don't add anything
+    std::size_t padding = (Lanes - nTerms % Lanes) % Lanes;
+    amplitudes.resize(amplitudes.size() + padding, 0.0);
+    phases.resize(phases.size() + padding, 0.0);
+    frequencies.resize(frequencies.size() + padding, 0.0);
+
+    seriesStarts.push_back(amplitudes.size());
+}
+
+
+bool
+VSOPVariable::isInKernelRange([[maybe_unused]] double t) const
+{
+#ifdef CELESTIA_VSOP_SIMD
+    return maxPhase + maxFrequency * std::abs(t) < ReductionLimit;
+#else
+    return false;
+#endif
+}
+
+
+double
+VSOPVariable::evaluateScalar(double t) const
+{
+    double value = 0.0;
+    double T = 1.0;
+    for (std::size_t i = 0; i + 1 < seriesStarts.size(); ++i)
+    {
+        std::size_t first = seriesStarts[i];
+        value += sumTermsScalar(amplitudes.data() + first,
+                                phases.data() + first,
+                                frequencies.data() + first,
+                                seriesStarts[i + 1] - first,
+                                t) * T;
+        T = t * T;
+    }
+
+    return value;
+}
+
+
+double
+VSOPVariable::evaluate(double t) const
+{
+#ifdef CELESTIA_VSOP_SIMD
+    if (!isInKernelRange(t))
+        return evaluateScalar(t);
+
+    double value = 0.0;
+    double T = 1.0;
+    for (std::size_t i = 0; i + 1 < seriesStarts.size(); ++i)
+    {
+        std::size_t first = seriesStarts[i];
+        value += sumTerms(amplitudes.data() + first,
+                          phases.data() + first,
+                          frequencies.data() + first,
+                          seriesStarts[i + 1] - first,
+                          t) * T;
+        T = t * T;
+    }
+
+    return value;
+#else
+    return evaluateScalar(t);
+#endif
+}
+
+
+void
+VSOPVariable::evaluate(const double* t, double* values, std::size_t count) const
+{
+    std::size_t j = 0;
+#ifdef CELESTIA_VSOP_SIMD
+    constexpr std::size_t BlockSize = 2 * Lanes;
+    for (; j + BlockSize <= count; j += BlockSize)
+    {
+        if (!std::all_of(t + j, t + j + BlockSize, [this](double tj) { return isInKernelRange(tj); }))
+        {
+            for (std::size_t k = j; k < j + BlockSize; ++k)
+                values[k] = evaluate(t[k]);
+            continue;
+        }
+
+        Vec tv0 = load(t + j);
+        Vec tv1 = load(t + j + Lanes);
+        Vec value0 = set1(0.0);
+        Vec value1 = set1(0.0);
+        Vec T0 = set1(1.0);
+        Vec T1 = set1(1.0);
+        for (std::size_t i = 0; i + 1 < seriesStarts.size(); ++i)
+        {
+            std::size_t first = seriesStarts[i];
+            Vec s0;
+            Vec s1;
+            sumTerms(amplitudes.data() + first,
+                     phases.data() + first,
+                     frequencies.data() + first,
+                     seriesStarts[i + 1] - first,
+                     tv0, tv1, s0, s1);
+            value0 = add(value0, mul(s0, T0));
+            value1 = add(value1, mul(s1, T1));
+            T0 = mul(tv0, T0);
+            T1 = mul(tv1, T1);
+        }
+
+        store(values + j, value0);
+        store(values + j + Lanes, value1);
+    }
+#endif
+
+    for (; j < count; ++j)
+        values[j] = evaluate(t[j]);
+}
+
+} // end namespace celestia::ephem
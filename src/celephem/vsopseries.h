@@ -0,0 +1,55 @@
+// vsopseries.h
+//
+// Copyright (C) 2024, Celestia Development Team
+//
+// Evaluation of the series of the VSOP87 theory.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace celestia::ephem
+{
+
+struct VSOPTerm
+{
+    double A, B, C;
+};
+
+/**
+ * One variable of a VSOP87 theory, the sum of the series S_n(t) t^n where
+ * each series is a sum of terms A cos(B + C t). The amplitudes, phases and
+ * frequencies of the terms are kept in separate arrays with each series
+ * padded to a whole number of SIMD lanes, so that the cosines of several
+ * terms, or of a term at several times, are computed at once.
+ */
+class VSOPVariable
+{
+public:
+    // Appends the series for the next power of t
+    void addSeries(const VSOPTerm* terms, std::size_t nTerms);
+
+    double evaluate(double t) const;
+    // Evaluates the variable at count times
+    void evaluate(const double* t, double* values, std::size_t count) const;
+
+private:
+    bool isInKernelRange(double t) const;
+    double evaluateScalar(double t) const;
+
+    std::vector<double> amplitudes;
+    std::vector<double> phases;
+    std::vector<double> frequencies;
+    // Index of the first term of each series, followed by the term count
+    std::vector<std::size_t> seriesStarts{ 0 };
+    double maxPhase{ 0.0 };
+    double maxFrequency{ 0.0 };
+};
+
+} // end namespace celestia::ephem
@@ -1,6 +1,10 @@
 #pragma once
 
+#include <array>
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
+#include <string>
 #include <string_view>
 #include <type_traits>
 
@@ -28,12 +32,151 @@ struct XYZVBinaryData
     double velocity[3];
 };
 
+// Header of a chunked xyzv file. The records are encoded in chunks of
+// chunkSize records, followed by an index of the chunks at indexOffset.
+struct XYZVChunkedHeader
+{
+    XYZVChunkedHeader() = delete;
+
+    char magic[8];
+    std::uint16_t byteOrder;
+    std::uint16_t digits;
+    std::uint32_t chunkSize;
+    std::uint64_t count;
+    std::uint64_t indexOffset;
+    // Largest distance of a position from the origin in kilometers
+    double boundingRadius;
+};
+
+struct XYZVChunkIndexEntry
+{
+    XYZVChunkIndexEntry() = delete;
+
+    // Time of the first record of the chunk
+    double tdb;
+    // Offset of the chunk from the start of the file
+    std::uint64_t offset;
+};
+
 #pragma pack(pop)
 
 static_assert(std::is_standard_layout_v<XYZVBinaryHeader>);
 static_assert(std::is_standard_layout_v<XYZVBinaryData>);
+static_assert(std::is_standard_layout_v<XYZVChunkedHeader>);
+static_assert(std::is_standard_layout_v<XYZVChunkIndexEntry>);
 
 constexpr inline std::string_view XYZV_MAGIC{ "CELXYZV\0", 8 };
 static_assert(XYZV_MAGIC.size() == sizeof(XYZVBinaryHeader::magic));
 
+constexpr inline std::string_view XYZV_CHUNKED_MAGIC{ "CELXYZC\0", 8 };
+static_assert(XYZV_CHUNKED_MAGIC.size() == sizeof(XYZVChunkedHeader::magic));
+
+// Records per chunk written by xyzv2bin
+constexpr inline std::uint32_t XYZV_CHUNK_SIZE = 256;
+
+// The values of a record in the order of XYZVBinaryData
+using XYZVRecord = std::array<double, 7>;
+static_assert(sizeof(XYZVRecord) == sizeof(XYZVBinaryData));
+
+namespace detail
+{
+
+// Each value of a record is predicted by extrapolating the bit patterns of
+// the values of the two previous records linearly. For smooth trajectories
+// sampled at a steady cadence the residual is small, as the sign, exponent
+// and leading mantissa bits cancel. Integer arithmetic keeps the prediction
+// identical wherever it is computed, so the coding is lossless.
+inline std::uint64_t
+predictXYZV(const std::uint64_t* previous, std::size_t i, std::size_t column)
+{
+    if (i == 0)
+        return 0;
+    if (i == 1)
+        return previous[column];
+    return 2 * previous[column] - previous[column + 7];
+}
+
+inline void
+shiftXYZVHistory(std::uint64_t* previous, const std::uint64_t* bits)
+{
+    for (std::size_t column = 0; column < 7; ++column)
+    {
+        previous[column + 7] = previous[column];
+        previous[column] = bits[column];
+    }
+}
+
+} // end namespace detail
+
+// Append the encoding of a chunk of records to out. Each record is stored
+// as four bytes holding the byte counts of the seven zigzag encoded
+// residuals in nibbles, followed by the significant bytes of the residuals
+// in little-endian order.
+inline void
+EncodeXYZVChunk(const XYZVRecord* records, std::size_t count, std::string& out)
+{
+    std::uint64_t previous[14] = {};
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        std::uint64_t bits[7];
+        std::memcpy(bits, records[i].data(), sizeof(bits));
+
+        std::array<char, 4> lengths = {};
+        std::array<char, 7 * 8> bytes;
+        std::size_t nBytes = 0;
+        for (std::size_t column = 0; column < 7; ++column)
+        {
+            auto residual = static_cast<std::int64_t>(bits[column] - detail::predictXYZV(previous, i, column));
+            auto zigzag = (static_cast<std::uint64_t>(residual) << 1) ^ static_cast<std::uint64_t>(residual >> 63);
+
+            unsigned int length = 0;
+            for (; zigzag != 0; zigzag >>= 8, ++length)
+                bytes[nBytes++] = static_cast<char>(zigzag & 0xff);
+            lengths[column / 2] = static_cast<char>(lengths[column / 2] | (length << (4 * (column % 2))));
+        }
+
+        out.append(lengths.data(), lengths.size());
+        out.append(bytes.data(), nBytes);
+        detail::shiftXYZVHistory(previous, bits);
+    }
+}
+
+// Decode a chunk of count records from size bytes of data. Returns false if
+// the data is short or malformed.
+inline bool
+DecodeXYZVChunk(const char* data, std::size_t size, std::size_t count, XYZVRecord* records)
+{
+    const char* end = data + size;
+    std::uint64_t previous[14] = {};
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        if (end - data < 4)
+            return false;
+
+        const char* lengths = data;
+        data += 4;
+
+        std::uint64_t bits[7];
+        for (std::size_t column = 0; column < 7; ++column)
+        {
+            unsigned int length = (static_cast<unsigned char>(lengths[column / 2]) >> (4 * (column % 2))) & 0xf;
+            if (length > 8 || end - data < static_cast<std::ptrdiff_t>(length))
+                return false;
+
+            std::uint64_t zigzag = 0;
+            for (unsigned int b = 0; b < length; ++b)
+                zigzag |= static_cast<std::uint64_t>(static_cast<unsigned char>(data[b])) << (8 * b);
+            data += length;
+
+            std::uint64_t residual = (zigzag >> 1) ^ (~(zigzag & 1) + 1);
+            bits[column] = detail::predictXYZV(previous, i, column) + residual;
+        }
+
+        std::memcpy(records[i].data(), bits, sizeof(bits));
+        detail::shiftXYZVHistory(previous, bits);
+    }
+
+    return true;
+}
+
 }
@@ -26,6 +26,9 @@ class AudioSession
     AudioSession &operator=(AudioSession&&) = delete;
 
     virtual ~AudioSession() = default;
+    // Open the file and start decoding it in the background, so that play
+    // doesn't have to wait for it
+    virtual bool preload() = 0;
     virtual bool play(double startTime = -1.0) = 0;
     virtual bool isPlaying() const = 0;
     virtual void stop() = 0;
@@ -37,9 +40,12 @@ class AudioSession
     void setNoPause(bool nopause);
 
     bool nopause() const { return m_nopause; }
+    const fs::path& path() const { return m_path; }
+
+    // Relative paths are in the sounds directory
+    static fs::path resolvePath(const fs::path &path);
 
  protected:
-    fs::path path() const { return m_path; }
     float volume() const { return m_volume; }
     float pan() const { return m_pan; }
     bool loop() const { return m_loop; }
@@ -10,15 +10,28 @@
 #pragma once
 
 #include <algorithm>
+#include <cstddef>
+#include <deque>
 #include <fstream>
+#include <future>
+#include <iterator>
+#include <memory>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 #include <celestia/progressnotifier.h>
+#include <celestia/startupprofile.h>
 #include <celutil/array_view.h>
+#include <celutil/fileaccesslog.h>
 #include <celutil/filetype.h>
 #include <celutil/fsutils.h>
 #include <celutil/gettext.h>
 #include <celutil/logger.h>
+#include <celutil/mappedfile.h>
+#include <celutil/threadpool.h>
 
 namespace celestia
 {
@@ -30,50 +43,44 @@ template<class OBJDB> class CatalogLoader
     ContentType                m_contentType;
     ProgressNotifier          *m_notifier;
     util::array_view<fs::path> m_skipPaths;
+    StartupProfile            *m_profile;
 
 public:
+    // With a profile, the time taken by each file is recorded along with its
+    // size and the number of objects it added, as given by OBJDB::size()
     CatalogLoader(OBJDB                     *db,
                   const std::string         &typeDesc,
                   const ContentType         &contentType,
                   ProgressNotifier          *notifier,
-                  util::array_view<fs::path> skipPaths) :
+                  util::array_view<fs::path> skipPaths,
+                  StartupProfile            *profile = nullptr) :
         m_objDB(db),
         m_typeDesc(typeDesc),
         m_contentType(contentType),
         m_notifier(notifier),
-        m_skipPaths(skipPaths)
+        m_skipPaths(skipPaths),
+        m_profile(profile)
     {
     }
 
-    bool load(std::istream &in, const fs::path &dir)
+    bool load(std::string_view contents, const fs::path &dir)
     {
-        return m_objDB->load(in, dir);
+        return m_objDB->load(contents, dir);
     }
 
     void process(const fs::path &filePath, const fs::path &parentPath)
     {
-        if (DetermineFileType(filePath) != m_contentType)
+        if (!shouldLoad(filePath))
             return;
 
-        if (std::find(std::begin(m_skipPaths), std::end(m_skipPaths), filePath)
-            != std::end(m_skipPaths))
-        {
-            util::GetLogger()->info(_("Skipping {} catalog: {}\n"), m_typeDesc, filePath);
-            return;
-        }
-        util::GetLogger()->info(_("Loading {} catalog: {}\n"), m_typeDesc, filePath);
-        if (m_notifier != nullptr)
-            m_notifier->update(filePath.filename().string());
-
-        if (std::ifstream catalogFile(filePath);
-            !catalogFile.good() || !load(catalogFile, parentPath))
-        {
-            util::GetLogger()->error(_("Error reading {} catalog file: {}\n"),
-                                     m_typeDesc,
-                                     filePath);
-        }
+        std::optional<CatalogFile> catalogFile = readFile(filePath, false);
+        loadFile(filePath, parentPath, catalogFile.has_value() ? &*catalogFile : nullptr);
     }
 
+    // The add-on files are read ahead on the thread pool while the files
+    // before them are parsed. Parsing itself stays on the calling thread in
+    // sorted order, as the catalogs may refer to or override objects defined
+    // by earlier ones.
     void loadExtras(util::array_view<fs::path> dirs)
     {
         std::vector<fs::path> entries;
@@ -85,19 +92,145 @@ public:
 
             entries.clear();
 
+            {
+            util::DirectoryScanScope scan(dir);
             for (auto iter = fs::recursive_directory_iterator(dir, ec); iter != end(iter);
                  iter.increment(ec))
             {
                 if (ec)
                     continue;
+                scan.addEntry();
                 if (!fs::is_directory(iter->path(), ec))
                     entries.push_back(iter->path());
             }
+            }
 
             std::sort(std::begin(entries), std::end(entries));
 
-            for (const auto &fn : entries)
-                process(fn, fn.parent_path());
+            entries.erase(std::remove_if(std::begin(entries), std::end(entries),
+                                         [this](const fs::path &fn) { return !shouldLoad(fn); }),
+                          std::end(entries));
+
+            loadFiles(entries);
+        }
+    }
+
+private:
+    // Number of files read ahead per worker thread
+    static constexpr std::size_t ReadAheadPerThread = 4;
+    static constexpr std::size_t PageSize = 4096;
+
+    // The contents of a catalog file. The file is mapped where possible so
+    // that the tokenizer works on it in place, and read into memory
+    // otherwise.
+    struct CatalogFile
+    {
+        std::unique_ptr<util::MappedFile> mapped;
+        std::string                       contents;
+
+        std::string_view view() const
+        {
+            return mapped == nullptr
+                ? std::string_view(contents)
+                : std::string_view(mapped->data(), mapped->size());
+        }
+    };
+
+    bool shouldLoad(const fs::path &filePath) const
+    {
+        if (DetermineFileType(filePath) != m_contentType)
+            return false;
+
+        if (std::find(std::begin(m_skipPaths), std::end(m_skipPaths), filePath)
+            != std::end(m_skipPaths))
+        {
+            util::GetLogger()->info(_("Skipping {} catalog: {}\n"), m_typeDesc, filePath);
+            return false;
+        }
+
+        return true;
+    }
+
+    void loadFile(const fs::path &filePath, const fs::path &parentPath, const CatalogFile *file)
+    {
+        util::GetLogger()->info(_("Loading {} catalog: {}\n"), m_typeDesc, filePath);
+        if (m_notifier != nullptr)
+            m_notifier->update(filePath.filename().string());
+
+        StartupProfile::Scope scope(m_profile, filePath.string(), "catalog");
+        const std::size_t objectCount = m_objDB->size();
+
+        if (file == nullptr || !load(file->view(), parentPath))
+        {
+            util::GetLogger()->error(_("Error reading {} catalog file: {}\n"),
+                                     m_typeDesc,
+                                     filePath);
+        }
+
+        if (file != nullptr)
+            scope.addBytesRead(file->view().size());
+        scope.addObjects(m_objDB->size() - objectCount);
+    }
+
+    // When reading ahead, the pages of a mapped file are touched so that
+    // they are faulted in on the worker thread rather than while parsing.
+    static std::optional<CatalogFile> readFile(const fs::path &filePath, bool prefetch)
+    {
+        util::FileAccessScope access("catalog", filePath);
+        CatalogFile file;
+        file.mapped = util::MappedFile::open(filePath);
+        if (file.mapped != nullptr)
+        {
+            access.opened();
+            if (prefetch)
+            {
+                volatile char sink = 0;
+                for (std::size_t i = 0; i < file.mapped->size(); i += PageSize)
+                    sink = file.mapped->data()[i];
+                static_cast<void>(sink);
+            }
+            return file;
+        }
+
+        // Empty files can't be mapped, nor can be some file systems
+        std::ifstream in(filePath, std::ios::binary);
+        if (!in.good())
+        {
+            access.setFailed();
+            return std::nullopt;
+        }
+
+        access.opened();
+        file.contents.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        if (in.bad())
+        {
+            access.setFailed();
+            return std::nullopt;
+        }
+
+        access.addRead(file.contents.size());
+        return file;
+    }
+
+    void loadFiles(const std::vector<fs::path> &files)
+    {
+        util::ThreadPool *threadPool = util::GetThreadPool();
+        const std::size_t readAhead = (static_cast<std::size_t>(threadPool->threadCount()) + 1) * ReadAheadPerThread;
+
+        std::deque<std::future<std::optional<CatalogFile>>> pending;
+        std::size_t next = 0;
+        for (const auto &fn : files)
+        {
+            while (next < files.size() && pending.size() < readAhead)
+            {
+                pending.push_back(threadPool->async([&path = files[next]] { return readFile(path, true); }));
+                ++next;
+            }
+
+            std::optional<CatalogFile> catalogFile = pending.front().get();
+            pending.pop_front();
+
+            loadFile(fn, fn.parent_path(), catalogFile.has_value() ? &*catalogFile : nullptr);
         }
     }
 };
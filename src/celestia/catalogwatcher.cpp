@@ -0,0 +1,222 @@
+// catalogwatcher.cpp
+//
+// Copyright (C) 2024, the Celestia Development Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include "catalogwatcher.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <system_error>
+
+#include <celengine/universe.h>
+#include <celestia/configfile.h>
+#include <celutil/fsutils.h>
+#include <celutil/gettext.h>
+#include <celutil/logger.h>
+
+namespace celestia
+{
+
+namespace
+{
+
+std::optional<std::string>
+readContents(const fs::path& path)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in.good())
+        return std::nullopt;
+
+    std::string contents(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>{});
+    if (in.bad())
+        return std::nullopt;
+
+    return contents;
+}
+
+} // end unnamed namespace
+
+CatalogWatcher::CatalogWatcher(const CelestiaConfig& config, Universe* universe, double interval) :
+    m_config(config),
+    m_universe(universe),
+    m_interval(std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(interval))),
+    m_lastCheck(std::chrono::steady_clock::now())
+{
+    scan(m_files);
+
+    // The bodies of the solar system catalogs as loaded, so that the ones
+    // removed from a catalog can be found when it changes
+    for (auto& [path, file] : m_files)
+    {
+        if (file.type != ContentType::CelestiaCatalog)
+            continue;
+
+        if (auto contents = readContents(path); contents.has_value())
+            ListSolarSystemObjects(*contents, file.objects);
+    }
+}
+
+bool
+CatalogWatcher::check()
+{
+    if (m_changed)
+        return true;
+
+    auto now = std::chrono::steady_clock::now();
+    if (now - m_lastCheck < m_interval)
+        return false;
+    m_lastCheck = now;
+
+    FileMap current;
+    scan(current);
+
+    m_changed = current.size() != m_files.size() ||
+                std::any_of(current.begin(), current.end(),
+                            [this](const auto& entry)
+                            {
+                                auto it = m_files.find(entry.first);
+                                return it == m_files.end() ||
+                                       it->second.modified != entry.second.modified ||
+                                       it->second.size != entry.second.size;
+                            });
+    if (m_changed)
+        m_changedFiles = std::move(current);
+    return m_changed;
+}
+
+void
+CatalogWatcher::update()
+{
+    if (!m_changed)
+        return;
+    m_changed = false;
+
+    FileMap current = std::move(m_changedFiles);
+    m_changedFiles.clear();
+
+    for (auto& [path, file] : current)
+    {
+        auto it = m_files.find(path);
+        if (it == m_files.end())
+        {
+            reload(path, file, false);
+            continue;
+        }
+
+        if (it->second.modified != file.modified || it->second.size != file.size)
+        {
+            file.objects = std::move(it->second.objects);
+            reload(path, file, false);
+        }
+        else
+        {
+            file.objects = std::move(it->second.objects);
+        }
+    }
+
+    for (auto& [path, file] : m_files)
+    {
+        if (current.find(path) == current.end())
+            reload(path, file, true);
+    }
+
+    m_files = std::move(current);
+}
+
+void
+CatalogWatcher::scan(FileMap& files) const
+{
+    const fs::path empty;
+    for (const auto& path : m_config.paths.solarSystemFiles)
+        addFile(files, path, empty, ContentType::CelestiaCatalog);
+    for (const auto& path : m_config.paths.starCatalogFiles)
+        addFile(files, path, empty, ContentType::CelestiaStarCatalog);
+    for (const auto& path : m_config.paths.dsoCatalogFiles)
+        addFile(files, path, empty, ContentType::CelestiaDeepSkyCatalog);
+
+    const auto& skipPaths = m_config.paths.skipExtras;
+    std::error_code ec;
+    for (const auto& dir : m_config.paths.extrasDirs)
+    {
+        if (!util::IsValidDirectory(dir))
+            continue;
+
+        for (auto iter = fs::recursive_directory_iterator(dir, ec); iter != end(iter); iter.increment(ec))
+        {
+            if (ec || fs::is_directory(iter->path(), ec))
+                continue;
+
+            const fs::path& path = iter->path();
+            ContentType type = DetermineFileType(path);
+            if (type != ContentType::CelestiaCatalog
+                && type != ContentType::CelestiaStarCatalog
+                && type != ContentType::CelestiaDeepSkyCatalog)
+            {
+                continue;
+            }
+
+            if (std::find(skipPaths.begin(), skipPaths.end(), path) == skipPaths.end())
+                addFile(files, path, path.parent_path(), type);
+        }
+    }
+}
+
+void
+CatalogWatcher::addFile(FileMap& files,
+                        const fs::path& path,
+                        const fs::path& directory,
+                        ContentType type) const
+{
+    std::error_code ec;
+    auto modified = fs::last_write_time(path, ec);
+    if (ec)
+        return;
+    auto size = fs::file_size(path, ec);
+    if (ec)
+        return;
+
+    WatchedFile& file = files[path];
+    file.directory = directory;
+    file.type = type;
+    file.modified = modified;
+    file.size = size;
+}
+
+void
+CatalogWatcher::reload(const fs::path& path, WatchedFile& file, bool removed)
+{
+    if (file.type != ContentType::CelestiaCatalog)
+    {
+        util::GetLogger()->warn(_("Catalog {} changed; star and deep sky catalogs are only loaded at startup\n"),
+                                path);
+        return;
+    }
+
+    std::string contents;
+    if (!removed)
+    {
+        auto fileContents = readContents(path);
+        if (!fileContents.has_value())
+        {
+            util::GetLogger()->error(_("Error reading solar system catalog file: {}\n"), path);
+            return;
+        }
+
+        contents = std::move(*fileContents);
+    }
+
+    // A removed catalog is applied as an empty one, which hides its bodies
+    util::GetLogger()->info(_("Reloading solar system catalog: {}\n"), path);
+    if (!ReloadSolarSystemObjects(contents, *m_universe, file.directory, file.objects))
+        util::GetLogger()->error(_("Error reading solar system catalog file: {}\n"), path);
+}
+
+} // end namespace celestia
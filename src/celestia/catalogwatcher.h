@@ -0,0 +1,74 @@
+// catalogwatcher.h
+//
+// Copyright (C) 2024, the Celestia Development Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+
+#include <celcompat/filesystem.h>
+#include <celengine/solarsys.h>
+#include <celutil/filetype.h>
+
+class Universe;
+struct CelestiaConfig;
+
+namespace celestia
+{
+
+// Watches the catalog files of the configuration and of the extras
+// directories, and applies the changes made to them while running. The
+// files are polled, as there is no portable way to be notified of changes.
+//
+// Solar system catalogs are applied again in place. The stars and deep sky
+// objects are kept in octrees built once at startup, so changes to their
+// catalogs are only reported.
+class CatalogWatcher
+{
+public:
+    CatalogWatcher(const CelestiaConfig&, Universe*, double interval);
+
+    // Check the files for changes, if the interval has elapsed since the
+    // last check. Returns true if some were added, modified or removed;
+    // they are then applied by update().
+    bool check();
+    // Apply the changes found by the last check. Must be called from the
+    // thread which owns the universe, once nothing references the orbits
+    // and bodies which the reloaded catalogs may replace.
+    void update();
+
+private:
+    struct WatchedFile
+    {
+        fs::path directory;
+        ContentType type{ ContentType::Unknown };
+        fs::file_time_type modified{ };
+        std::uintmax_t size{ 0 };
+        // The bodies added by a solar system catalog
+        SolarSystemCatalogObjects objects;
+    };
+
+    using FileMap = std::map<fs::path, WatchedFile>;
+
+    void scan(FileMap&) const;
+    void addFile(FileMap&, const fs::path&, const fs::path& directory, ContentType) const;
+    void reload(const fs::path&, WatchedFile&, bool removed);
+
+    const CelestiaConfig& m_config;
+    Universe* m_universe;
+    std::chrono::steady_clock::duration m_interval;
+    std::chrono::steady_clock::time_point m_lastCheck;
+    FileMap m_files;
+    // The files found by the last check, with changes not applied yet
+    FileMap m_changedFiles;
+    bool m_changed{ false };
+};
+
+} // end namespace celestia
@@ -28,8 +28,11 @@
 #include <iomanip>
 #include <iostream>
 #include <iterator>
+#include <limits>
+#include <map>
 #include <memory>
 #include <set>
+#include <vector>
 
 #include <Eigen/Geometry>
 #include <fmt/ostream.h>
@@ -46,36 +49,56 @@
 #include <celengine/body.h>
 #include <celengine/boundaries.h>
 #include <celengine/console.h>
+#include <celengine/formcache.h>
 #include <celengine/framebuffer.h>
+#include <celengine/framebufferpool.h>
+#include <celengine/framestats.h>
 #include <celengine/fisheyeprojectionmode.h>
 #include <celengine/location.h>
+#include <celengine/lodspheremesh.h>
 #include <celengine/mapmanager.h>
+#include <celengine/meshmanager.h>
+#include <celengine/modelgeometry.h>
 #include <celengine/multitexture.h>
 #include <celengine/overlay.h>
 #include <celengine/perspectiveprojectionmode.h>
 #include <celengine/planetgrid.h>
 #include <celengine/starname.h>
+#include <celengine/texmanager.h>
 #include <celengine/textlayout.h>
 #include <celengine/rectangle.h>
+#include <celengine/shadermanager.h>
+#include <celengine/virtualtex.h>
 #include <celengine/visibleregion.h>
+#include <celephem/chebyshevorbit.h>
+#include <celephem/interpolatedrotation.h>
+#include <celestia/catalogwatcher.h>
 #include <celestia/configfile.h>
 #include <celestia/favorites.h>
+#include <celestia/framerecording.h>
 #include <celestia/loaddso.h>
 #include <celestia/loadsso.h>
 #include <celestia/loadstars.h>
 #include <celestia/progressnotifier.h>
+#include <celestia/simulationstepper.h>
+#include <celestia/startupprofile.h>
 #include <celestia/textprintposition.h>
 #include <celestia/viewmanager.h>
 #include <celestia/url.h>
+#include <celimage/imageformats.h>
 #include <celmath/geomutil.h>
+#include <celrender/atmosphererenderer.h>
+#include <celrender/gpustagetimer.h>
 #include <celscript/legacy/execution.h>
 #include <celscript/legacy/cmdparser.h>
 #include <celttf/truetypefont.h>
 #include <celutil/color.h>
+#include <celutil/fileaccesslog.h>
 #include <celutil/filetype.h>
 #include <celutil/fsutils.h>
 #include <celutil/logger.h>
 #include <celutil/gettext.h>
+#include <celutil/profiler.h>
 #include <celutil/utf8.h>
 
 #ifdef USE_MINIAUDIO
@@ -217,6 +240,11 @@ CelestiaCore::~CelestiaCore()
     if (movieCapture != nullptr)
         recordEnd();
 
+    if (Profiler::isEnabled())
+        Profiler::writeTrace(getTracePath());
+    if (FileAccessLog::isEnabled())
+        FileAccessLog::write(config->paths.fileAccessLogFile);
+
     delete timer;
     delete renderer;
 
@@ -381,10 +409,17 @@ void CelestiaCore::cancelScript()
 }
 
 
+bool CelestiaCore::isScriptRunning() const
+{
+    return m_script != nullptr;
+}
+
+
 void CelestiaCore::runScript(const fs::path& filename, bool i18n)
 {
     cancelScript();
     auto maybeLocaleFilename = i18n ? LocaleFilename(filename) : filename;
+    m_scriptName = maybeLocaleFilename.u8string();
 
     if (m_legacyPlugin->isOurFile(maybeLocaleFilename))
     {
@@ -406,6 +441,19 @@ void CelestiaCore::runScript(const fs::path& filename, bool i18n)
     }
 }
 
+void CelestiaCore::runCelxScript([[maybe_unused]] std::istream& in, [[maybe_unused]] const fs::path& name)
+{
+    cancelScript();
+#ifdef CELX
+    m_scriptName = name.u8string();
+    m_script = m_luaPlugin->loadScript(in, name);
+    if (m_script != nullptr)
+        scriptState = sim->getPauseState() ? ScriptPaused : ScriptRunning;
+#else
+    fatalError(_("Invalid filetype"));
+#endif
+}
+
 
 static bool checkMask(int modifiers, int mask)
 {
@@ -414,6 +462,7 @@ static bool checkMask(int modifiers, int mask)
 
 void CelestiaCore::mouseButtonDown(float x, float y, int button)
 {
+    viewChanged = true;
     mouseMotion = 0.0f;
 
     Eigen::Vector2f newLocation(x, y);
@@ -444,6 +493,7 @@ void CelestiaCore::mouseButtonDown(float x, float y, int button)
 
 void CelestiaCore::mouseButtonUp(float x, float y, int button)
 {
+    viewChanged = true;
     dragLocation = std::nullopt;
     dragStartFromSurface = std::nullopt;
     dragStart = std::nullopt;
@@ -474,9 +524,10 @@ void CelestiaCore::mouseButtonUp(float x, float y, int button)
             viewManager->pickView(sim, metrics, x, y);
 
             Vector3f pickRay = getPickRay(x, y, viewManager->activeView());
+            auto pickHits = getPickHits(x, y, viewManager->activeView());
 
             Selection oldSel = sim->getSelection();
-            Selection newSel = sim->pickObject(pickRay, renderer->getRenderFlags(), obsPickTolerance);
+            Selection newSel = sim->pickObject(pickRay, renderer->getRenderFlags(), obsPickTolerance, pickHits);
             addToHistory();
             sim->setSelection(newSel);
             if (!oldSel.empty() && oldSel == newSel)
@@ -485,8 +536,9 @@ void CelestiaCore::mouseButtonUp(float x, float y, int button)
         else if (button == RightButton)
         {
             Eigen::Vector3f pickRay = getPickRay(x, y, viewManager->activeView());
+            auto pickHits = getPickHits(x, y, viewManager->activeView());
 
-            Selection sel = sim->pickObject(pickRay, renderer->getRenderFlags(), obsPickTolerance);
+            Selection sel = sim->pickObject(pickRay, renderer->getRenderFlags(), obsPickTolerance, pickHits);
             if (!sel.empty())
             {
                 if (contextMenuHandler != nullptr)
@@ -517,6 +569,7 @@ void CelestiaCore::mouseButtonUp(float x, float y, int button)
 
 void CelestiaCore::mouseWheel(float motion, int modifiers)
 {
+    viewChanged = true;
     if (is_set(interactionFlags, InteractionFlags::ReverseWheel))
         motion = -motion;
 
@@ -562,6 +615,7 @@ void CelestiaCore::mouseMove(float x, float y)
 
 void CelestiaCore::mouseMove(float dx, float dy, int modifiers)
 {
+    viewChanged = true;
     auto oldLocation = dragLocation;
     auto proposedLocation = oldLocation;
 
@@ -743,6 +797,7 @@ void CelestiaCore::joystickButton(int button, bool down)
 
 void CelestiaCore::pinchUpdate(float focusX, float focusY, float scale, bool zoomFOV)
 {
+    viewChanged = true;
     viewManager->pickView(sim, metrics, focusX, focusY);
     const View *view = viewManager->activeView();
     bool focusZoomingEnabled = is_set(interactionFlags, InteractionFlags::FocusZooming);
@@ -763,6 +818,7 @@ void CelestiaCore::pinchUpdate(float focusX, float focusY, float scale, bool zoo
 
 void CelestiaCore::keyDown(int key, int modifiers)
 {
+    viewChanged = true;
     if (m_scriptHook != nullptr && m_scriptHook->call("keydown", float(key), float(modifiers)))
         return;
 
@@ -853,6 +909,7 @@ void CelestiaCore::keyDown(int key, int modifiers)
 
 void CelestiaCore::keyUp(int key, int)
 {
+    viewChanged = true;
     KeyAccel = 1.0;
     if (std::islower(static_cast<unsigned char>(key)))
         key = std::toupper(static_cast<unsigned char>(key));
@@ -888,6 +945,7 @@ void CelestiaCore::charEntered(char c, int modifiers)
 
 void CelestiaCore::charEntered(const char *c_p, int modifiers)
 {
+    viewChanged = true;
     Observer* observer = sim->getActiveObserver();
 
     char c = *c_p;
@@ -1074,6 +1132,10 @@ void CelestiaCore::charEntered(const char *c_p, int modifiers)
         notifyWatchers(RenderFlagsChanged);
         break;
 
+    case '\016':  // Ctrl+N
+        setTracing(!isTracing());
+        break;
+
     case '\031':  // Ctrl+Y
         renderer->setRenderFlags(renderer->getRenderFlags() ^ RenderFlags::ShowAutoMag);
         if (util::is_set(renderer->getRenderFlags(), RenderFlags::ShowAutoMag))
@@ -1642,7 +1704,7 @@ void CelestiaCore::charEnteredAutoComplete(const char* c_p)
 
 void CelestiaCore::updateSelectionFromInput()
 {
-    auto textInput = hud->textInput();
+    auto& textInput = hud->textInput();
 
     Selection sel;
     // Prefer selected completion, then search with typed text
@@ -1737,11 +1799,31 @@ void CelestiaCore::tick()
 
 void CelestiaCore::tick(double dt)
 {
+    CELESTIA_PROFILE_ZONE("CelestiaCore::tick");
+
+    // The counters of a frame cover its tick and the views drawn after it
+    engine::FrameStats* frameStats = engine::GetFrameStats();
+    frameStats->beginFrame();
+    if (const auto* hitch = hitchDetector.check(frameStats->getLastFrame()); hitch != nullptr)
+        engine::HitchDetector::log(*hitch);
+    renderer->updateQuality();
+    if (Profiler::isEnabled())
+    {
+        std::map<std::string, double> stats;
+        renderer->getFrameStats(stats);
+        for (const auto& [name, value] : stats)
+            Profiler::recordCounter(name, value);
+    }
+    engine::FrameStageTimer stageTimer;
+
     sysTime += dt;
 
     // The time step is normally driven by the system clock; however, when
-    // recording a movie, we fix the time step the frame rate of the movie.
-    if (movieCapture != nullptr && recording)
+    // rendering offline or recording a movie, we fix the time step to the
+    // one requested or to the frame rate of the movie.
+    if (fixedTimeStep > 0.0)
+        dt = fixedTimeStep;
+    else if (movieCapture != nullptr && recording)
         dt = 1.0 / static_cast<double>(movieCapture->getFrameRate());
 
     // Pause script execution
@@ -1907,9 +1989,40 @@ void CelestiaCore::tick(double dt)
         sim->orbit(q);
     }
 
+    if (config != nullptr && config->memoryReportInterval > 0.0 &&
+        sysTime - lastMemoryReport >= config->memoryReportInterval)
+    {
+        lastMemoryReport = sysTime;
+        engine::MemoryReport report;
+        getMemoryReport(report);
+        report.log();
+    }
+
+    if (m_simulationStepper == nullptr)
+    {
+        updateSimulation(dt);
+    }
+    else
+    {
+        for (int steps = m_simulationStepper->advance(dt); steps > 0; --steps)
+        {
+            updateSimulation(m_simulationStepper->getStep());
+            m_simulationStepper->capture(getViewObservers());
+        }
+    }
+    stageTimer.lap(engine::FrameStage::Simulation);
+}
+
+
+// Run the scripts and the simulation for a step
+void CelestiaCore::updateSimulation(double dt)
+{
     // If there's a script running, tick it
     if (m_script != nullptr)
     {
+        // Copied as the script may start another one
+        std::string scriptName = m_scriptName;
+        engine::FrameZoneTimer zoneTimer(engine::FrameZone::ScriptTick, scriptName);
         m_script->handleTickEvent(dt);
         if (scriptState == ScriptRunning)
         {
@@ -1921,36 +2034,101 @@ void CelestiaCore::tick(double dt)
     if (m_scriptHook != nullptr)
         m_scriptHook->call("tick", dt);
 
+    // Apply the catalog files changed since the last check. Reloads replace
+    // the timelines of existing bodies, so drop the orbit paths first.
+    if (catalogWatcher != nullptr && catalogWatcher->check())
+    {
+        renderer->invalidateOrbitCache();
+        catalogWatcher->update();
+    }
+
     sim->update(dt);
 }
 
 
 void CelestiaCore::draw()
 {
-    if (!viewUpdateRequired())
-        return;
+    CELESTIA_PROFILE_ZONE("CelestiaCore::draw");
+
+    renderer->getFramebufferPool().beginFrame();
+
+    // Pick up the GPU times of the frames which have completed
+    render::GPUStageTimer* gpuStageTimer = renderer->getGPUStageTimer();
+    if (gpuStageTimer != nullptr)
+        gpuStageTimer->collect();
+
+    // In render on demand mode the scene is only rendered again when it has
+    // changed; draw may also be called when nothing has, such as when the
+    // window is exposed.
+    const bool drawScene = !renderOnDemand || getRequiredRedraw() == Redraw::Scene;
+
+    // Draw the cameras at the time between the simulation steps
+    const bool interpolate = drawScene && m_simulationStepper != nullptr;
+    if (interpolate)
+        m_simulationStepper->apply(getViewObservers());
+
+    // Record the state the frame is drawn from, so that it can be replayed
+    if (drawScene && frameRecorder != nullptr)
+        frameRecorder->record(sysTime, metrics.width, metrics.height, Url(this).getAsString());
+
+    // Render each view; split views share the work which doesn't depend on
+    // the camera
+    const bool multiView = viewManager->views().size() > 1;
+    if (multiView && drawScene)
+    {
+        std::vector<const Observer*> observers;
+        observers.reserve(viewManager->views().size());
+        for (const auto view : viewManager->views())
+        {
+            if (view->type == View::ViewWindow)
+                observers.push_back(getViewObserver(view));
+        }
+        renderer->beginMultiViewFrame(*sim->getUniverse(), observers);
+    }
 
-    // Render each view
     for (const auto view : viewManager->views())
-        draw(view);
+    {
+        if (drawScene)
+            draw(view);
+        else
+            drawCachedScene(view);
+    }
 
     // Reset to render to the main window
-    if (viewManager->views().size() > 1)
+    if (multiView)
+    {
+        if (drawScene)
+            renderer->endMultiViewFrame();
         renderer->setRenderRegion(0, 0, metrics.width, metrics.height, false);
+    }
+
+    if (interpolate)
+        m_simulationStepper->restore();
+
+    if (renderOnDemand)
+    {
+        if (drawScene)
+            saveDrawnState();
+        overlayChanged = false;
+        overlayAnimating = hud->isAnimating(timeInfo.currentTime);
+    }
 
     bool toggleAA = renderer->isMSAAEnabled();
     if (toggleAA && util::is_set(renderer->getRenderFlags(), RenderFlags::ShowCloudMaps))
         renderer->disableMSAA();
 
-    renderOverlay();
-    if (showConsole)
     {
-        console->setFont(hud->font());
-        console->setColor(1.0f, 1.0f, 1.0f, 1.0f);
-        console->begin();
-        console->moveBy(static_cast<float>(metrics.insetLeft), static_cast<float>(metrics.screenDpi) / 25.4f * 53.0f);
-        console->render(Console::PageRows);
-        console->end();
+        render::GPUStageScope gpuStage(gpuStageTimer, GPUStage::Overlay);
+        renderOverlay();
+        if (showConsole)
+        {
+            console->setFont(hud->font());
+            console->setColor(1.0f, 1.0f, 1.0f, 1.0f);
+            console->begin();
+            console->moveBy(static_cast<float>(metrics.insetLeft), static_cast<float>(metrics.screenDpi) / 25.4f * 53.0f);
+            console->render(Console::PageRows);
+            console->end();
+        }
     }
 
     if (toggleAA)
@@ -1994,13 +2172,22 @@ void CelestiaCore::draw(View* view)
 {
     if (view->type != View::ViewWindow) return;
 
+    if (auto cubeMap = dynamic_cast<CubeMapViewportEffect*>(viewportEffect.get()); cubeMap != nullptr)
+    {
+        drawCubeMap(view, cubeMap);
+        return;
+    }
+
     bool viewportEffectUsed = false;
 
     FramebufferObject *fbo = nullptr;
     if (viewportEffect != nullptr)
     {
-        // create/update FBO for viewport effect
-        view->updateFBO(metrics.width, metrics.height);
+        // create/update FBO for viewport effect, at the render scale
+        float scale = renderer->getRenderScale();
+        view->updateFBO(static_cast<int>(static_cast<float>(metrics.width) * scale),
+                        static_cast<int>(static_cast<float>(metrics.height) * scale),
+                        renderer->getFramebufferPool());
         fbo = view->getFBO();
     }
     bool process = fbo != nullptr && viewportEffect->preprocess(renderer, fbo);
@@ -2010,19 +2197,23 @@ void CelestiaCore::draw(View* view)
     auto viewWidth = static_cast<int>(view->width * static_cast<float>(metrics.width));
     auto viewHeight = static_cast<int>(view->height * static_cast<float>(metrics.height));
     // If we need to process, we draw to the FBO which starts at point zero
-    renderer->setRenderRegion(process ? 0 : x, process ? 0 : y, viewWidth, viewHeight, !view->isRootView());
+    if (process)
+        renderer->setRenderRegion(0, 0, static_cast<int>(fbo->width()), static_cast<int>(fbo->height()), !view->isRootView());
+    else
+        renderer->setRenderRegion(x, y, viewWidth, viewHeight, !view->isRootView());
 
     if (view->isRootView())
         sim->render(*renderer);
     else
         sim->render(*renderer, *view->observer);
 
-    // Viewport need to be reset to start from (x,y) instead of point zero
-    if (process && (x != 0 || y != 0))
+    // Viewport need to be reset to start from (x,y) and cover the view
+    if (process && (x != 0 || y != 0 || fbo->width() != static_cast<GLuint>(viewWidth) || fbo->height() != static_cast<GLuint>(viewHeight)))
         renderer->setRenderRegion(x, y, viewWidth, viewHeight);
 
     if (process && viewportEffect->prerender(renderer, fbo))
     {
+        render::GPUStageScope gpuStage(renderer->getGPUStageTimer(), GPUStage::ViewportEffects);
         if (viewportEffect->render(renderer, fbo, viewWidth, viewHeight))
             viewportEffectUsed = true;
         else
@@ -2031,6 +2222,91 @@ void CelestiaCore::draw(View* view)
     isViewportEffectUsed = viewportEffectUsed;
 }
 
+// Render the view to the faces of the cube map, then resample them to the
+// fisheye image
+void CelestiaCore::drawCubeMap(View* view, CubeMapViewportEffect* cubeMap)
+{
+    auto x = static_cast<int>(view->x * static_cast<float>(metrics.width));
+    auto y = static_cast<int>(view->y * static_cast<float>(metrics.height));
+    auto viewWidth = static_cast<int>(view->width * static_cast<float>(metrics.width));
+    auto viewHeight = static_cast<int>(view->height * static_cast<float>(metrics.height));
+
+    // The faces share the work which doesn't depend on the camera, as split
+    // views do
+    const bool faceFrame = !renderer->isMultiViewFrame();
+    if (faceFrame)
+    {
+        const Observer* observer = getViewObserver(view);
+        renderer->beginMultiViewFrame(*sim->getUniverse(), util::array_view<const Observer*>(&observer, 1));
+    }
+
+    bool rendered = cubeMap->renderFaces(renderer, viewHeight, [this, view]
+    {
+        if (view->isRootView())
+            sim->render(*renderer);
+        else
+            sim->render(*renderer, *view->observer);
+    });
+
+    if (faceFrame)
+        renderer->endMultiViewFrame();
+
+    renderer->setRenderRegion(x, y, viewWidth, viewHeight, !view->isRootView());
+    render::GPUStageScope gpuStage(renderer->getGPUStageTimer(), GPUStage::ViewportEffects);
+    isViewportEffectUsed = rendered &&
+                           cubeMap->prerender(renderer, nullptr) &&
+                           cubeMap->render(renderer, nullptr, viewWidth, viewHeight);
+    if (!isViewportEffectUsed)
+        GetLogger()->error("Unable to render viewport effect.\n");
+}
+
+// Draw the scene kept in the framebuffer of the view by the last draw(View*)
+void CelestiaCore::drawCachedScene(View* view)
+{
+    if (view->type != View::ViewWindow)
+        return;
+
+    if (auto cubeMap = dynamic_cast<CubeMapViewportEffect*>(viewportEffect.get()); cubeMap != nullptr)
+    {
+        // The cube map holds the scene of the last view drawn, so split
+        // views need drawing again
+        if (viewManager->views().size() > 1 || !cubeMap->preprocess(renderer, nullptr))
+        {
+            draw(view);
+            return;
+        }
+
+        auto x = static_cast<int>(view->x * static_cast<float>(metrics.width));
+        auto y = static_cast<int>(view->y * static_cast<float>(metrics.height));
+        auto viewWidth = static_cast<int>(view->width * static_cast<float>(metrics.width));
+        auto viewHeight = static_cast<int>(view->height * static_cast<float>(metrics.height));
+        renderer->setRenderRegion(x, y, viewWidth, viewHeight, !view->isRootView());
+        render::GPUStageScope gpuStage(renderer->getGPUStageTimer(), GPUStage::ViewportEffects);
+        isViewportEffectUsed = cubeMap->prerender(renderer, nullptr) &&
+                               cubeMap->render(renderer, nullptr, viewWidth, viewHeight);
+        return;
+    }
+
+    FramebufferObject* fbo = viewportEffect == nullptr ? nullptr : view->getFBO();
+    if (fbo == nullptr)
+    {
+        draw(view);
+        return;
+    }
+
+    auto x = static_cast<int>(view->x * static_cast<float>(metrics.width));
+    auto y = static_cast<int>(view->y * static_cast<float>(metrics.height));
+    auto viewWidth = static_cast<int>(view->width * static_cast<float>(metrics.width));
+    auto viewHeight = static_cast<int>(view->height * static_cast<float>(metrics.height));
+    renderer->setRenderRegion(x, y, viewWidth, viewHeight, !view->isRootView());
+
+    // Go through the same steps as draw(View*), without the scene
+    render::GPUStageScope gpuStage(renderer->getGPUStageTimer(), GPUStage::ViewportEffects);
+    isViewportEffectUsed = viewportEffect->preprocess(renderer, fbo) &&
+                           viewportEffect->prerender(renderer, fbo) &&
+                           viewportEffect->render(renderer, fbo, viewWidth, viewHeight);
+}
+
 void CelestiaCore::setSafeAreaInsets(int left, int top, int right, int bottom)
 {
     metrics.insetLeft = left;
@@ -2073,39 +2349,122 @@ void CelestiaCore::setInteractionFlags(InteractionFlags flags)
 // can skip rendering, keep the GPU idle, and save power.
 bool CelestiaCore::viewUpdateRequired() const
 {
-#if 1
-    // Enable after 1.5.0
-    return true;
-#else
-    bool isPaused = sim->getPauseState() || sim->getTimeScale() == 0.0;
+    return !renderOnDemand || getRequiredRedraw() != Redraw::None;
+}
 
-    // See if the camera in any of the views is moving
-    bool observersMoving = false;
-    for (const auto v : views)
+CelestiaCore::Redraw CelestiaCore::getRequiredRedraw() const
+{
+    // Scripts, movies and resources loading in the background change the
+    // scene in ways which aren't tracked
+    if (viewChanged ||
+        scriptState == ScriptRunning ||
+        (movieCapture != nullptr && recording) ||
+        renderer->settingsHaveChanged() ||
+        renderer->hasPendingResources() ||
+        sim->getSelection() != drawnSelection ||
+        observersChanged())
     {
-        if (v->observer->getAngularVelocity().length() > 1.0e-10 ||
-            v->observer->getVelocity().length() > 1.0e-12)
-        {
-            observersMoving = true;
-            break;
-        }
+        return Redraw::Scene;
     }
 
-    if (viewChanged ||
-        !isPaused ||
-        observersMoving ||
-        dollyMotion != 0.0 ||
-        zoomMotion != 0.0 ||
-        scriptState == ScriptRunning ||
-        renderer->settingsHaveChanged())
+    // Once a message has faded out, the overlay is drawn once more to
+    // remove it
+    if (overlayChanged ||
+        overlayAnimating ||
+        showConsole ||
+        hud->isAnimating(timeInfo.currentTime))
     {
-        return true;
+        return Redraw::Overlay;
     }
-    else
+
+    return Redraw::None;
+}
+
+void CelestiaCore::setRenderOnDemand(bool enable)
+{
+    renderOnDemand = enable;
+    viewChanged = true;
+
+    // The scene is kept in the framebuffers of the views, which are only
+    // used with a viewport effect
+    if (renderOnDemand && viewportEffect == nullptr)
+        viewportEffect = std::make_unique<PassthroughViewportEffect>();
+}
+
+bool CelestiaCore::getRenderOnDemand() const
+{
+    return renderOnDemand;
+}
+
+void CelestiaCore::setViewChanged()
+{
+    viewChanged = true;
+}
+
+const Observer* CelestiaCore::getViewObserver(const View* view) const
+{
+    return view->isRootView() ? sim->getActiveObserver() : view->observer;
+}
+
+// The observers of the views drawn, each once
+std::vector<Observer*> CelestiaCore::getViewObservers() const
+{
+    std::vector<Observer*> observers;
+    for (const auto view : viewManager->views())
     {
-        return false;
+        if (view->type != View::ViewWindow)
+            continue;
+
+        Observer* observer = view->isRootView() ? sim->getActiveObserver() : view->observer;
+        if (std::find(observers.begin(), observers.end(), observer) == observers.end())
+            observers.push_back(observer);
     }
-#endif
+
+    return observers;
+}
+
+bool CelestiaCore::observersChanged() const
+{
+    auto drawnView = drawnViews.begin();
+    for (const auto view : viewManager->views())
+    {
+        if (view->type != View::ViewWindow)
+            continue;
+
+        const Observer* observer = getViewObserver(view);
+        if (drawnView == drawnViews.end() ||
+            drawnView->observer != observer ||
+            observer->getPosition().offsetFromUly(drawnView->position) != Eigen::Vector3d::Zero() ||
+            drawnView->orientation.coeffs() != observer->getOrientation().coeffs() ||
+            drawnView->fov != observer->getFOV() ||
+            drawnView->time != observer->getTime())
+        {
+            return true;
+        }
+        ++drawnView;
+    }
+
+    return drawnView != drawnViews.end();
+}
+
+void CelestiaCore::saveDrawnState()
+{
+    drawnViews.clear();
+    for (const auto view : viewManager->views())
+    {
+        if (view->type != View::ViewWindow)
+            continue;
+
+        const Observer* observer = getViewObserver(view);
+        drawnViews.push_back({ observer,
+                               observer->getPosition(),
+                               observer->getOrientation(),
+                               observer->getFOV(),
+                               observer->getTime() });
+    }
+
+    drawnSelection = sim->getSelection();
+    viewChanged = false;
 }
 
 
@@ -2128,6 +2487,9 @@ void CelestiaCore::splitView(View::Type type, View* av, float splitPos)
 
 void CelestiaCore::setFOVFromZoom()
 {
+    // Called when the window or the views are resized
+    viewChanged = true;
+
     auto projectionMode = renderer->getProjectionMode();
     for (const auto v : viewManager->views())
     {
@@ -2161,6 +2523,19 @@ void CelestiaCore::singleView(const View* av)
 void CelestiaCore::setActiveView(const View* v)
 {
     viewManager->setActiveView(sim, v);
+    viewChanged = true;
+}
+
+void CelestiaCore::setActiveObserver(Observer* observer)
+{
+    auto& views = viewManager->views();
+    auto it = std::find(views.begin(), views.end(), viewManager->activeView());
+    if (it == views.end())
+        return;
+
+    (*it)->observer = observer;
+    sim->setActiveObserver(observer);
+    viewChanged = true;
 }
 
 void CelestiaCore::deleteView(View* v)
@@ -2195,6 +2570,14 @@ Renderer* CelestiaCore::getRenderer() const
     return renderer;
 }
 
+void CelestiaCore::getMemoryReport(engine::MemoryReport& report) const
+{
+    if (universe != nullptr)
+        universe->reportMemoryUsage(report);
+    if (renderer != nullptr)
+        renderer->reportMemoryUsage(report);
+}
+
 Simulation* CelestiaCore::getSimulation() const
 {
     return sim;
@@ -2208,11 +2591,13 @@ void CelestiaCore::showText(std::string_view s,
     auto [emWidth, height] = hud->titleMetrics();
     hud->showText(TextPrintPosition::relative(horig, vorig, hoff, voff, emWidth, height),
                   s, duration, timeInfo.currentTime);
+    overlayChanged = true;
 }
 
 void CelestiaCore::showTextAtPixel(std::string_view s, int x, int y, double duration)
 {
     hud->showText(TextPrintPosition::absolute(x, y), s, duration, timeInfo.currentTime);
+    overlayChanged = true;
 }
 
 
@@ -2237,7 +2622,9 @@ void CelestiaCore::renderOverlay()
 }
 
 
-Eigen::Vector3f CelestiaCore::getPickRay(float x, float y, const celestia::View *view)
+// The point of the view under the window coordinates, centered and in units
+// of the view height, with y up
+Eigen::Vector2f CelestiaCore::getPickPoint(float x, float y, const celestia::View *view) const
 {
     float pickX;
     float pickY;
@@ -2252,17 +2639,48 @@ Eigen::Vector3f CelestiaCore::getPickRay(float x, float y, const celestia::View
     if (isViewportEffectUsed)
         viewportEffect->distortXY(pickX, pickY);
 
+    return Eigen::Vector2f(pickX, pickY);
+}
+
+Eigen::Vector3f CelestiaCore::getPickRay(float x, float y, const celestia::View *view)
+{
+    Eigen::Vector2f pickPoint = getPickPoint(x, y, view);
+    float windowWidth = static_cast<float>(metrics.width);
+    float windowHeight = static_cast<float>(metrics.height);
+
     // Pick ray depends on view size, setting the size from the view
     // and then restore to the size of the window
     auto projectionMode = renderer->getProjectionMode();
     projectionMode->setSize(view->width * windowWidth, view->height * windowHeight);
 
-    Eigen::Vector3f pickRay = projectionMode->getPickRay(pickX, pickY, view->getObserver()->getZoom());
+    Eigen::Vector3f pickRay = projectionMode->getPickRay(pickPoint.x(), pickPoint.y(), view->getObserver()->getZoom());
 
     projectionMode->setSize(windowWidth, windowHeight);
     return pickRay;
 }
 
+// Look up the objects drawn under the window coordinates in the last frame
+// rendered for the view
+celestia::engine::PickHits CelestiaCore::getPickHits(float x, float y, const celestia::View *view) const
+{
+    const celestia::engine::PickBuffer* pickBuffer = renderer->getPickBuffer(*view->getObserver());
+    auto viewWidth = static_cast<int>(view->width * static_cast<float>(metrics.width));
+    auto viewHeight = static_cast<int>(view->height * static_cast<float>(metrics.height));
+    if (pickBuffer == nullptr || pickBuffer->height() == 0)
+        return {};
+
+    // The scene may have been drawn at a lower resolution than the view
+    float scale = static_cast<float>(pickBuffer->height()) / static_cast<float>(viewHeight);
+    auto bufferWidth = static_cast<float>(pickBuffer->width());
+    auto bufferHeight = static_cast<float>(pickBuffer->height());
+    if (std::abs(bufferWidth - static_cast<float>(viewWidth) * scale) > 1.0f)
+        return {};
+
+    Eigen::Vector2f point = getPickPoint(x, y, view) * bufferHeight;
+    point += Eigen::Vector2f(bufferWidth, bufferHeight) * 0.5f;
+    return pickBuffer->pick(point, pickTolerance * scale);
+}
+
 void CelestiaCore::updateFOV(float newFOV, const std::optional<Eigen::Vector2f> &focus, const celestia::View *view)
 {
     float minFOV = renderer->getProjectionMode()->getMinimumFOV();
@@ -2310,8 +2728,14 @@ bool CelestiaCore::initSimulation(const fs::path& configFileName,
                                   const vector<fs::path>& extrasDirs,
                                   ProgressNotifier* progressNotifier)
 {
+    // Whether the profile is wanted is only known once the configuration
+    // is read, so that is always recorded
+    startupProfile = std::make_unique<StartupProfile>();
+
     config = std::make_unique<CelestiaConfig>();
     bool hasConfig = false;
+    {
+    StartupProfile::Scope scope(startupProfile.get(), "Configuration");
     if (!configFileName.empty())
     {
         hasConfig = ReadCelestiaConfig(configFileName, *config);
@@ -2332,13 +2756,30 @@ bool CelestiaCore::initSimulation(const fs::path& configFileName,
         if (!localConfigFile.empty())
             hasConfig |= ReadCelestiaConfig(localConfigFile, *config);
     }
+    }
 
     if (!hasConfig)
     {
         fatalError(_("Error reading configuration file."), false);
+        startupProfile = nullptr;
         return false;
     }
 
+    if (!keepStartupProfile && config->paths.startupProfileFile.empty() && config->paths.startupTraceFile.empty())
+        startupProfile = nullptr;
+    StartupProfile* profile = startupProfile.get();
+
+    if (!config->paths.fileAccessLogFile.empty())
+        FileAccessLog::setEnabled(true);
+
+    if (!config->paths.profileTraceFile.empty())
+    {
+        Profiler::setEnabled(true);
+#ifndef CELESTIA_PROFILING
+        GetLogger()->info("Profiling zones are not enabled in this build, the trace only has counters and events\n");
+#endif
+    }
+
     // Set the console log size; ignore any request to use less than 100 lines
     if (config->consoleLogRows > 100)
         console->setRowCount(config->consoleLogRows);
@@ -2374,7 +2815,10 @@ bool CelestiaCore::initSimulation(const fs::path& configFileName,
     hud = std::make_unique<Hud>(loc);
 
 #ifdef CELX
+    {
+    StartupProfile::Scope scope(profile, "Lua hook");
     initLuaHook(progressNotifier);
+    }
 #endif
 
     KeyRotationAccel = math::degToRad(config->mouse.rotateAcceleration);
@@ -2389,11 +2833,19 @@ bool CelestiaCore::initSimulation(const fs::path& configFileName,
 
     universe = new Universe();
 
+    // Catalogs of add-ons may produce many warnings, write them from a
+    // background thread while loading
+    util::AsyncLogScope asyncLog(GetLogger());
+
     /***** Load star catalogs *****/
 
     StarDetails::SetStarTextures(config->starTextures);
 
-    std::unique_ptr<StarDatabase> starCatalog = loadStars(*config, progressNotifier);
+    std::unique_ptr<StarDatabase> starCatalog;
+    {
+    StartupProfile::Scope scope(profile, "Star catalogs");
+    starCatalog = loadStars(*config, progressNotifier, profile);
+    }
     if (starCatalog == nullptr)
     {
         fatalError(_("Cannot read star database."), false);
@@ -2403,7 +2855,11 @@ bool CelestiaCore::initSimulation(const fs::path& configFileName,
 
     /***** Load the deep sky catalogs *****/
 
-    std::unique_ptr<DSODatabase> dsoCatalog = loadDSO(*config, progressNotifier);
+    std::unique_ptr<DSODatabase> dsoCatalog;
+    {
+    StartupProfile::Scope scope(profile, "Deep sky catalogs");
+    dsoCatalog = loadDSO(*config, progressNotifier, profile);
+    }
     if (dsoCatalog == nullptr)
     {
         fatalError(_("Cannot read DSO database."), false);
@@ -2413,14 +2869,29 @@ bool CelestiaCore::initSimulation(const fs::path& configFileName,
 
     /***** Load the solar system catalogs *****/
 
-    loadSSO(*config, progressNotifier, universe);
+    celestia::ephem::SetOrbitCacheTolerance(config->orbitCacheTolerance);
+    celestia::ephem::SetRotationCacheTolerance(math::degToRad(config->rotationCacheTolerance / 3600.0));
+    {
+    StartupProfile::Scope scope(profile, "Solar system catalogs");
+    loadSSO(*config, progressNotifier, universe, profile);
+    }
+
+    setSimulationUpdateRate(config->simulationUpdateRate);
+    hitchDetector.setThreshold(config->hitchThreshold);
+
+    if (config->catalogReloadInterval > 0.0)
+        catalogWatcher = std::make_unique<CatalogWatcher>(*config, universe, config->catalogReloadInterval);
 
     // Load asterisms:
     if (!config->paths.asterismsFile.empty())
+    {
+        StartupProfile::Scope scope(profile, "Asterisms");
         loadAsterismsFile(config->paths.asterismsFile);
+    }
 
     if (!config->paths.boundariesFile.empty())
     {
+        StartupProfile::Scope scope(profile, "Boundaries");
         std::ifstream boundariesFile(config->paths.boundariesFile, ios::in);
         if (!boundariesFile.good())
         {
@@ -2436,6 +2907,7 @@ bool CelestiaCore::initSimulation(const fs::path& configFileName,
     // Load destinations list
     if (!config->paths.destinationsFile.empty())
     {
+        StartupProfile::Scope scope(profile, "Destinations");
         fs::path localeDestinationsFile = LocaleFilename(config->paths.destinationsFile);
         ifstream destfile(localeDestinationsFile, ios::in);
         if (destfile.good())
@@ -2444,6 +2916,8 @@ bool CelestiaCore::initSimulation(const fs::path& configFileName,
         }
     }
 
+    asyncLog.end();
+
     std::shared_ptr<ProjectionMode> projectionMode = nullptr;
     if (compareIgnoringCase(config->projectionMode, "fisheye") == 0)
     {
@@ -2484,12 +2958,41 @@ bool CelestiaCore::initSimulation(const fs::path& configFileName,
                     GetLogger()->error("Failed to read warp mesh file {}\n", config->paths.warpMeshFile);
             }
         }
+        else if (config->viewportEffect == "cubemap")
+        {
+            // Optionally through a warp mesh
+            WarpMesh *mesh = nullptr;
+            if (!config->paths.warpMeshFile.empty())
+            {
+                WarpMeshManager *manager = GetWarpMeshManager();
+                mesh = manager->find(manager->getHandle(WarpMeshInfo(config->paths.warpMeshFile)));
+                if (mesh == nullptr)
+                    GetLogger()->error("Failed to read warp mesh file {}\n", config->paths.warpMeshFile);
+            }
+
+            if (compareIgnoringCase(config->projectionMode, "fisheye") != 0)
+                GetLogger()->warn("The cubemap viewport effect needs the fisheye projection mode\n");
+            else if (mesh != nullptr || config->paths.warpMeshFile.empty())
+                viewportEffect = std::make_unique<CubeMapViewportEffect>(mesh);
+        }
         else
         {
             GetLogger()->warn("Unknown viewport effect {}\n", config->viewportEffect);
         }
     }
 
+    // A scene drawn at a lower resolution is scaled to the view by the
+    // viewport effect; the warp mesh does it as it draws the scene, the
+    // upscale effect sharpens it
+    if (config->quality.dynamicResolutionTime > 0.0 &&
+        (viewportEffect == nullptr || config->viewportEffect == "passthrough"))
+    {
+        viewportEffect = std::make_unique<UpscaleViewportEffect>(config->quality.upscaleSharpness);
+    }
+
+    // Needs the viewport effect, so it goes after it has been created
+    setRenderOnDemand(config->renderDetails.RenderOnDemand);
+
     if (!config->measurementSystem.empty())
     {
         if (compareIgnoringCase(config->measurementSystem, "imperial") == 0)
@@ -2565,6 +3068,10 @@ bool CelestiaCore::initSimulation(const fs::path& configFileName,
         cursorHandler->setCursorShape(defaultCursorShape);
     }
 
+    // Written again with the renderer phases by initRenderer, for front ends
+    // which run without one
+    writeStartupProfile();
+
     return true;
 }
 
@@ -2583,6 +3090,8 @@ LoadFontHelper(const Renderer *renderer, const fs::path &p)
 
 bool CelestiaCore::initRenderer([[maybe_unused]] bool useMesaPackInvert)
 {
+    Profiler::setThreadName("Render");
+
     renderer->setRenderFlags(RenderFlags::ShowStars |
                              RenderFlags::ShowPlanets |
                              RenderFlags::ShowAtmospheres |
@@ -2599,12 +3108,40 @@ bool CelestiaCore::initRenderer([[maybe_unused]] bool useMesaPackInvert)
     detailOptions.useMesaPackInvert = useMesaPackInvert;
 #endif
 
+    ShaderManager& shaderManager = renderer->getShaderManager();
+#ifndef PORTABLE_BUILD
+    shaderManager.setCacheDirectory(WriteableDataPath() / "cache" / "shaders");
+#endif
+    shaderManager.setAsyncCompilation(config->renderDetails.AsyncShaderCompilation);
+    if (config->renderDetails.PrewarmShaders)
+        shaderManager.prewarm();
+
+#ifndef PORTABLE_BUILD
+    if (config->renderDetails.TextureTranscoding)
+        SetTextureTranscodeDirectory(WriteableDataPath() / "cache" / "textures");
+    engine::SetFormCacheDirectory(WriteableDataPath() / "cache" / "forms");
+#endif
+    GetTextureManager()->setAsyncLoading(config->renderDetails.AsyncTextureLoading);
+    engine::GetGeometryManager()->setAsyncLoading(config->renderDetails.AsyncGeometryLoading);
+    ModelGeometry::setCompactVertices(config->renderDetails.CompactModelVertices);
+    GetTextureManager()->setMemoryBudget(static_cast<std::size_t>(config->renderDetails.TextureMemoryBudget) * 1024U * 1024U);
+    LODSphereMesh::setPatchCacheSize(static_cast<std::size_t>(config->renderDetails.SphereMeshMemory) * 1024U * 1024U);
+    render::AtmosphereRenderer::setScatteringTables(config->renderDetails.ScatteringTables);
+    VirtualTexture::setStreaming(config->renderDetails.VirtualTextureStreaming,
+                                 static_cast<std::size_t>(config->renderDetails.VirtualTextureMemory) * 1024U * 1024U);
+    VirtualTexture::setTileAtlas(config->renderDetails.VirtualTextureAtlas);
+
+    StartupProfile* profile = startupProfile.get();
+
     // Prepare the scene for rendering.
+    {
+    StartupProfile::Scope scope(profile, "Renderer");
     if (!renderer->init(metrics.width, metrics.height, detailOptions))
     {
         fatalError(_("Failed to initialize renderer"), false);
         return false;
     }
+    }
 
     if (util::is_set(renderer->getRenderFlags(), RenderFlags::ShowAutoMag))
     {
@@ -2612,6 +3149,22 @@ bool CelestiaCore::initRenderer([[maybe_unused]] bool useMesaPackInvert)
         setFaintestAutoMag();
     }
 
+    engine::QualityLimits qualityLimits;
+    qualityLimits.targetFrameTime = config->quality.targetFrameTime;
+    qualityLimits.tolerance = config->quality.tolerance;
+    qualityLimits.magnitudeOffset = { 0.0, -config->quality.magnitudeReduction };
+    qualityLimits.galaxyPointBudget = { static_cast<double>(config->renderDetails.GalaxyPointBudget),
+                                        static_cast<double>(config->quality.minGalaxyPoints) };
+    qualityLimits.maxLabels = { static_cast<double>(config->renderDetails.MaxLabels),
+                                static_cast<double>(config->quality.minLabels) };
+    qualityLimits.orbitTolerance = { 1.0, config->quality.orbitToleranceScale };
+    qualityLimits.sphereDetail = { 1.0, config->quality.minSphereDetail };
+    qualityLimits.shadowMapSize = { static_cast<double>(config->renderDetails.ShadowMapSize),
+                                    static_cast<double>(config->quality.minShadowMapSize) };
+    renderer->setQualityLimits(qualityLimits);
+    renderer->setDynamicResolution(config->quality.dynamicResolutionTime, config->quality.minRenderScale);
+
+    std::optional<StartupProfile::Scope> fontScope(std::in_place, profile, "Fonts");
     auto mainFont = config->fonts.mainFont.empty()
                 ? LoadFontHelper(renderer, "DejaVuSans.ttf,12")
                 : LoadFontHelper(renderer, config->fonts.mainFont);
@@ -2652,9 +3205,73 @@ bool CelestiaCore::initRenderer([[maybe_unused]] bool useMesaPackInvert)
 
     renderer->setFont(Renderer::FontLarge, hud->titleFont());
     renderer->setRTL(metrics.layoutDirection == LayoutDirection::RightToLeft);
+
+    fontScope.reset();
+    writeStartupProfile();
+    if (FileAccessLog::isEnabled())
+        FileAccessLog::write(config->paths.fileAccessLogFile);
+    if (!keepStartupProfile)
+        startupProfile = nullptr;
+
+    if (!config->paths.frameRecordingFile.empty())
+        startFrameRecording(config->paths.frameRecordingFile);
+
     return true;
 }
 
+bool CelestiaCore::startFrameRecording(const fs::path& path)
+{
+    frameRecorder = FrameRecorder::create(path);
+    return frameRecorder != nullptr;
+}
+
+void CelestiaCore::stopFrameRecording()
+{
+    frameRecorder = nullptr;
+}
+
+void CelestiaCore::setTracing(bool enable)
+{
+    if (enable == Profiler::isEnabled())
+        return;
+
+    if (enable)
+    {
+        Profiler::clear();
+        Profiler::setEnabled(true);
+        flash(_("Tracing started"));
+        return;
+    }
+
+    Profiler::setEnabled(false);
+    fs::path path = getTracePath();
+    if (Profiler::writeTrace(path))
+        flash(fmt::format(fmt::runtime(_("Trace written to {}")), path.u8string()));
+}
+
+bool CelestiaCore::isTracing() const
+{
+    return Profiler::isEnabled();
+}
+
+fs::path CelestiaCore::getTracePath() const
+{
+    if (config != nullptr && !config->paths.profileTraceFile.empty())
+        return config->paths.profileTraceFile;
+    return fs::path("trace.json");
+}
+
+void CelestiaCore::writeStartupProfile() const
+{
+    if (startupProfile == nullptr)
+        return;
+
+    if (!config->paths.startupProfileFile.empty())
+        startupProfile->writeReport(config->paths.startupProfileFile);
+    if (!config->paths.startupTraceFile.empty())
+        startupProfile->writeTrace(config->paths.startupTraceFile);
+}
+
 /// Set the faintest visible star magnitude; adjust the renderer's
 /// brightness parameters appropriately.
 void CelestiaCore::setFaintest(float magnitude)
@@ -2902,6 +3519,29 @@ void CelestiaCore::recordEnd()
     }
 }
 
+void CelestiaCore::setFixedTimeStep(double dt)
+{
+    fixedTimeStep = std::max(dt, 0.0);
+}
+
+double CelestiaCore::getFixedTimeStep() const
+{
+    return fixedTimeStep;
+}
+
+void CelestiaCore::setSimulationUpdateRate(double rate)
+{
+    if (rate > 0.0)
+        m_simulationStepper = std::make_unique<SimulationStepper>(rate);
+    else
+        m_simulationStepper = nullptr;
+}
+
+double CelestiaCore::getSimulationUpdateRate() const
+{
+    return m_simulationStepper == nullptr ? 0.0 : 1.0 / m_simulationStepper->getStep();
+}
+
 bool CelestiaCore::isCaptureActive()
 {
     return movieCapture != nullptr;
@@ -2941,6 +3581,7 @@ void CelestiaCore::removeWatcher(CelestiaWatcher* watcher)
 
 void CelestiaCore::notifyWatchers(int property)
 {
+    viewChanged = true;
     for (const auto watcher : watchers)
     {
         watcher->notifyChange(this, property);
@@ -3198,6 +3839,95 @@ bool CelestiaCore::saveScreenShot(const fs::path& filename, ContentType type) co
     return image.save(filename, type);
 }
 
+bool CelestiaCore::saveTiledScreenShot(const fs::path& filename, int columns, int rows)
+{
+    if (DetermineFileType(filename) != ContentType::PNG)
+    {
+        GetLogger()->error(_("Tiled screenshots can only be saved as PNG: {}!\n"), filename);
+        return false;
+    }
+
+    auto projectionMode = renderer->getProjectionMode();
+    if (columns < 1 || rows < 1 || !projectionMode->setTile(columns, rows, 0, 0))
+    {
+        GetLogger()->error(_("Unable to split the view into {}x{} tiles!\n"), columns, rows);
+        return false;
+    }
+    projectionMode->setTile(1, 1, 0, 0);
+
+    const View* view = viewManager->activeView();
+    auto tileWidth = static_cast<int>(view->width * static_cast<float>(metrics.width));
+    auto tileHeight = static_cast<int>(view->height * static_cast<float>(metrics.height));
+    if (tileWidth <= 0 || tileHeight <= 0 ||
+        tileWidth > std::numeric_limits<std::int32_t>::max() / columns ||
+        tileHeight > std::numeric_limits<std::int32_t>::max() / rows)
+    {
+        return false;
+    }
+
+    FramebufferObject* fbo = renderer->getFramebufferPool().acquireTransient(
+        static_cast<GLuint>(tileWidth),
+        static_cast<GLuint>(tileHeight),
+        FramebufferObject::ColorAttachment | FramebufferObject::DepthAttachment);
+    if (fbo == nullptr)
+    {
+        GetLogger()->error(_("Unable to create a framebuffer for the tiles!\n"));
+        return false;
+    }
+
+    PixelFormat format = renderer->getPreferredCaptureFormat();
+    celestia::engine::PNGWriter writer;
+    if (!writer.open(filename, tileWidth * columns, tileHeight * rows, format))
+        return false;
+
+    // Only a row of tiles is kept in memory, the PNG rows go top first
+    const std::size_t bytesPerPixel = format == PixelFormat::RGBA ? 4 : 3;
+    const std::size_t tilePitch = (bytesPerPixel * static_cast<std::size_t>(tileWidth) + 3) & ~std::size_t(3);
+    const std::size_t tileRowBytes = bytesPerPixel * static_cast<std::size_t>(tileWidth);
+    const std::size_t bandPitch = tileRowBytes * static_cast<std::size_t>(columns);
+    std::vector<std::uint8_t> tile(tilePitch * static_cast<std::size_t>(tileHeight));
+    std::vector<std::uint8_t> band(bandPitch * static_cast<std::size_t>(tileHeight));
+
+    GLint oldFboId = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &oldFboId);
+    bool success = fbo->bind();
+    for (int row = rows - 1; success && row >= 0; --row)
+    {
+        for (int column = 0; success && column < columns; ++column)
+        {
+            projectionMode->setTile(columns, rows, column, row);
+            renderer->setRenderRegion(0, 0, tileWidth, tileHeight, false);
+            if (view->isRootView())
+                sim->render(*renderer);
+            else
+                sim->render(*renderer, *view->observer);
+
+            success = renderer->captureFrame(0, 0, tileWidth, tileHeight, format, tile.data());
+            for (int y = 0; success && y < tileHeight; ++y)
+            {
+                std::memcpy(band.data() + bandPitch * static_cast<std::size_t>(y) + tileRowBytes * static_cast<std::size_t>(column),
+                            tile.data() + tilePitch * static_cast<std::size_t>(y),
+                            tileRowBytes);
+            }
+        }
+
+        success = success && writer.writeRows(band.data(), static_cast<std::int32_t>(bandPitch), tileHeight);
+    }
+
+    fbo->unbind(oldFboId);
+    projectionMode->setTile(1, 1, 0, 0);
+    renderer->setRenderRegion(0, 0, metrics.width, metrics.height, false);
+    viewChanged = true;
+
+    if (!success || !writer.close())
+    {
+        GetLogger()->error(_("Unable to save the tiled screenshot {}!\n"), filename);
+        return false;
+    }
+
+    return true;
+}
+
 #ifdef USE_MINIAUDIO
 std::shared_ptr<celestia::AudioSession> CelestiaCore::getAudioSession(int channel) const
 {
@@ -3211,12 +3941,31 @@ bool CelestiaCore::isPlayingAudio(int channel) const
     return audioSession && audioSession->isPlaying();
 }
 
-bool CelestiaCore::playAudio(int channel, const fs::path &path, double startTime, float volume, float pan, bool loop, bool nopause)
+bool CelestiaCore::preloadAudio(int channel, const fs::path &path, float volume, float pan, bool loop, bool nopause)
 {
+    auto audioSession = getAudioSession(channel);
+    if (audioSession && audioSession->path() == celestia::AudioSession::resolvePath(path))
+    {
+        audioSession->setVolume(volume);
+        audioSession->setPan(pan);
+        audioSession->setLoop(loop);
+        audioSession->setNoPause(nopause);
+        return audioSession->preload();
+    }
+
     stopAudio(channel);
-    auto audioSession = make_shared<MiniAudioSession>(path, volume, pan, loop, nopause);
+    audioSession = make_shared<MiniAudioSession>(path, volume, pan, loop, nopause);
     audioSessions[channel] = audioSession;
-    return audioSession->play(startTime);
+    return audioSession->preload();
+}
+
+bool CelestiaCore::playAudio(int channel, const fs::path &path, double startTime, float volume, float pan, bool loop, bool nopause)
+{
+    // Reuse the session of a preloaded cue, or of the sound already playing,
+    // which play restarts from startTime
+    if (!preloadAudio(channel, path, volume, pan, loop, nopause))
+        return false;
+    return getAudioSession(channel)->play(startTime);
 }
 
 bool CelestiaCore::resumeAudio(int channel)
@@ -21,6 +21,7 @@
 #include <celutil/filetype.h>
 #include <celutil/timer.h>
 #include <celutil/watcher.h>
+#include <celengine/hitchdetector.h>
 #include <celengine/solarsys.h>
 #include <celengine/overlay.h>
 #include <celengine/texture.h>
@@ -54,6 +55,10 @@ class ProgressNotifier;
 
 namespace celestia
 {
+class CatalogWatcher;
+class FrameRecorder;
+class SimulationStepper;
+class StartupProfile;
 class TextPrintPosition;
 class ViewManager;
 #ifdef USE_MINIAUDIO
@@ -236,6 +241,11 @@ public:
 
     Simulation* getSimulation() const;
     Renderer* getRenderer() const;
+    // Fill the report with the memory held by the catalogs, resources and
+    // caches
+    void getMemoryReport(celestia::engine::MemoryReport&) const;
+    // Frames whose CPU time exceeded the HitchThreshold of the config
+    celestia::engine::HitchDetector& getHitchDetector() { return hitchDetector; }
     void showText(std::string_view s,
                   int horig = 0, int vorig = 0,
                   int hoff = 0, int voff = 0,
@@ -252,7 +262,25 @@ public:
     void addFavoriteFolder(const std::string&, FavoritesList::iterator* iter=nullptr);
     FavoritesList* getFavorites();
 
+    // What draw() has to redraw in render on demand mode
+    enum class Redraw
+    {
+        None,
+        Overlay,
+        Scene,
+    };
+
     bool viewUpdateRequired() const;
+    Redraw getRequiredRedraw() const;
+    // In render on demand mode, viewUpdateRequired returns false when
+    // nothing visible has changed since the last draw, and when only the
+    // overlay has changed, draw copies the scene kept in the framebuffers of
+    // the views instead of rendering it again.
+    void setRenderOnDemand(bool);
+    bool getRenderOnDemand() const;
+    // Redraw the scene on the next draw, for changes which aren't tracked,
+    // such as the markers
+    void setViewChanged();
 
     const DestinationList* getDestinations();
 
@@ -270,8 +298,24 @@ public:
     bool isCaptureActive();
     bool isRecording();
 
+    // For offline rendering, each tick advances the animation and scripts
+    // by a fixed step in seconds, whatever the time elapsed since the
+    // previous one; a step of 0 restores the real time clock.
+    void setFixedTimeStep(double);
+    double getFixedTimeStep() const;
+
+    // Step the simulation and the scripts the given number of times per
+    // second, and draw the cameras interpolated between the steps; a rate
+    // of 0 steps them once per tick.
+    void setSimulationUpdateRate(double);
+    double getSimulationUpdateRate() const;
+
     void runScript(const fs::path& filename, bool i18n = true);
+    // Run celx code received from elsewhere than a file, such as a socket;
+    // name identifies it in the error messages
+    void runCelxScript(std::istream& in, const fs::path& name);
     void cancelScript();
+    bool isScriptRunning() const;
 
     int getHudDetail();
     void setHudDetail(int);
@@ -294,6 +338,9 @@ public:
     void singleView(const celestia::View* av = nullptr);
     void deleteView(celestia::View* v = nullptr);
     void setActiveView(const celestia::View* v = nullptr);
+    // Show observer, one of the simulation observers, in the active view and
+    // make it the active observer
+    void setActiveObserver(Observer*);
     bool getFramesVisible() const;
     void setFramesVisible(bool);
     bool getActiveFrameVisible() const;
@@ -323,6 +370,22 @@ public:
 
     const CelestiaConfig* getConfig() const;
 
+    // Keep the startup profile after initRenderer even if the configuration
+    // doesn't ask for a report; set before initSimulation
+    void setKeepStartupProfile(bool keep) { keepStartupProfile = keep; }
+    const celestia::StartupProfile* getStartupProfile() const { return startupProfile.get(); }
+
+    // Record the state each frame is drawn from, see FrameRecorder
+    bool startFrameRecording(const fs::path&);
+    void stopFrameRecording();
+    bool isRecordingFrames() const { return frameRecorder != nullptr; }
+
+    // Record a trace of the profiling zones, the counters of each frame and
+    // the loads and evictions, written when it is stopped and at exit to
+    // the ProfileTrace file of the config
+    void setTracing(bool);
+    bool isTracing() const;
+
     void notifyWatchers(int);
 
     void setLogFile(const fs::path&);
@@ -378,11 +441,18 @@ public:
     void getCaptureInfo(std::array<int, 4>& viewport, celestia::engine::PixelFormat& format) const;
     bool captureImage(std::uint8_t* buffer, const std::array<int, 4>& viewport, celestia::engine::PixelFormat format) const;
     bool saveScreenShot(const fs::path&, ContentType = ContentType::Unknown) const;
+    // Render the active view as a PNG image of columns x rows tiles of the
+    // size of the view, and write the tiles to the file as they are read
+    // back, so the image can be larger than the framebuffer and the memory
+    bool saveTiledScreenShot(const fs::path&, int columns, int rows);
 
     void loadAsterismsFile(const fs::path &path);
 
 #ifdef USE_MINIAUDIO
     bool isPlayingAudio(int channel) const;
+    // Open the file of a cue ahead of time; playAudio on the same channel and
+    // path then starts it without waiting for the file
+    bool preloadAudio(int channel, const fs::path& path, float volume, float pan, bool loop, bool nopause);
     bool playAudio(int channel, const fs::path& path, double startTime, float volume, float pan, bool loop, bool nopause);
     bool resumeAudio(int channel);
     void pauseAudio(int channel);
@@ -412,13 +482,34 @@ private:
     void charEnteredAutoComplete(const char*);
     void updateSelectionFromInput();
     void renderOverlay();
+    void drawCubeMap(celestia::View*, CubeMapViewportEffect*);
+    void drawCachedScene(celestia::View*);
+    const Observer* getViewObserver(const celestia::View*) const;
+    bool observersChanged() const;
+    void saveDrawnState();
+    Eigen::Vector2f getPickPoint(float x, float y, const celestia::View *view) const;
     Eigen::Vector3f getPickRay(float x, float y, const celestia::View *view);
+    celestia::engine::PickHits getPickHits(float x, float y, const celestia::View *view) const;
     void updateFOV(float fov, const std::optional<Eigen::Vector2f> &focus, const celestia::View *view);
 #ifdef CELX
     bool initLuaHook(ProgressNotifier*);
 #endif // CELX
+    void writeStartupProfile() const;
+    fs::path getTracePath() const;
+    void updateSimulation(double dt);
+    std::vector<Observer*> getViewObservers() const;
 
     std::unique_ptr<CelestiaConfig> config;
+    // Only kept from initSimulation to initRenderer, if a report is wanted,
+    // unless keepStartupProfile is set
+    std::unique_ptr<celestia::StartupProfile> startupProfile;
+    bool keepStartupProfile{ false };
+    std::unique_ptr<celestia::CatalogWatcher> catalogWatcher;
+    std::unique_ptr<celestia::FrameRecorder> frameRecorder;
+    // System time of the last memory report written to the log
+    double lastMemoryReport{ 0.0 };
+    celestia::engine::HitchDetector hitchDetector{ 0.0 };
+    std::unique_ptr<celestia::SimulationStepper> m_simulationStepper;
 
     Universe* universe{ nullptr };
 
@@ -444,6 +535,8 @@ private:
     Timer* timer{ nullptr };
 
     std::unique_ptr<celestia::scripts::IScript>             m_script;
+    // File name of the script, for the hitch detector
+    std::string                                             m_scriptName;
     std::unique_ptr<celestia::scripts::IScriptHook>         m_scriptHook;
     std::unique_ptr<celestia::scripts::LegacyScriptPlugin>  m_legacyPlugin;
 #ifdef CELX
@@ -483,6 +576,7 @@ private:
 
     MovieCapture* movieCapture{ nullptr };
     bool recording{ false };
+    double fixedTimeStep{ 0.0 };
 
 #ifdef USE_MINIAUDIO
     std::map<int, std::shared_ptr<celestia::AudioSession>> audioSessions;
@@ -515,6 +609,23 @@ private:
     std::unique_ptr<ViewportEffect> viewportEffect { nullptr };
     bool isViewportEffectUsed { false };
 
+    // State of the last draw of the scene, for render on demand
+    struct DrawnView
+    {
+        const Observer* observer;
+        UniversalCoord position;
+        Eigen::Quaterniond orientation;
+        float fov;
+        double time;
+    };
+
+    bool renderOnDemand{ false };
+    bool viewChanged{ true };
+    bool overlayChanged{ true };
+    bool overlayAnimating{ false };
+    std::vector<DrawnView> drawnViews;
+    Selection drawnSelection;
+
     ScriptSystemAccessPolicy scriptSystemAccessPolicy { ScriptSystemAccessPolicy::Ask };
 
     std::unique_ptr<Console> console;
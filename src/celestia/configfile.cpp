@@ -134,6 +134,7 @@ void
 applyPaths(CelestiaConfig::Paths& paths, const AssociativeArray& hash)
 {
     applyPath(paths.starDatabaseFile, hash, "StarDatabase"sv);
+    applyPath(paths.pagedStarCatalogFile, hash, "PagedStarCatalog"sv);
     applyPath(paths.starNamesFile, hash, "StarNameDatabase"sv);
     applyPathArray(paths.solarSystemFiles, hash, "SolarSystemCatalogs"sv);
     applyPathArray(paths.starCatalogFiles, hash, "StarCatalogs"sv);
@@ -150,6 +151,11 @@ applyPaths(CelestiaConfig::Paths& paths, const AssociativeArray& hash)
     applyPath(paths.SAOCrossIndexFile, hash, "SAOCrossIndex"sv);
     applyPath(paths.warpMeshFile, hash, "WarpMeshFile"sv);
     applyPath(paths.leapSecondsFile, hash, "LeapSecondsFile"sv);
+    applyPath(paths.startupProfileFile, hash, "StartupProfile"sv);
+    applyPath(paths.startupTraceFile, hash, "StartupTrace"sv);
+    applyPath(paths.fileAccessLogFile, hash, "FileAccessLog"sv);
+    applyPath(paths.profileTraceFile, hash, "ProfileTrace"sv);
+    applyPath(paths.frameRecordingFile, hash, "FrameRecording"sv);
 #ifdef CELX
     applyPath(paths.scriptScreenshotDirectory, hash, "ScriptScreenshotDirectory"sv);
     applyPath(paths.luaHook, hash, "LuaHook"sv);
@@ -192,10 +198,48 @@ applyRenderDetails(CelestiaConfig::RenderDetails& renderDetails, const Associati
     applyNumber(renderDetails.SolarSystemMaxDistance, hash, "SolarSystemMaxDistance"sv);
     renderDetails.SolarSystemMaxDistance = std::clamp(renderDetails.SolarSystemMaxDistance, 1.0f, 10.0f);
     applyNumber(renderDetails.ShadowMapSize, hash, "ShadowMapSize"sv);
+    applyNumber(renderDetails.ShadowMapCache, hash, "ShadowMapCache"sv);
+    applyBoolean(renderDetails.GPUStarCulling, hash, "GPUStarCulling"sv);
+    applyBoolean(renderDetails.ReverseDepth, hash, "ReverseDepth"sv);
+    applyBoolean(renderDetails.LabelDeclutter, hash, "LabelDeclutter"sv);
+    applyNumber(renderDetails.MaxLabels, hash, "MaxLabels"sv);
+    applyNumber(renderDetails.GalaxyPointBudget, hash, "GalaxyPointBudget"sv);
+    applyBoolean(renderDetails.RenderOnDemand, hash, "RenderOnDemand"sv);
+    applyBoolean(renderDetails.LowLatency, hash, "LowLatency"sv);
+    applyBoolean(renderDetails.VSync, hash, "VSync"sv);
+    applyBoolean(renderDetails.AsyncShaderCompilation, hash, "AsyncShaderCompilation"sv);
+    applyBoolean(renderDetails.PrewarmShaders, hash, "PrewarmShaders"sv);
+    applyBoolean(renderDetails.AsyncTextureLoading, hash, "AsyncTextureLoading"sv);
+    applyBoolean(renderDetails.AsyncGeometryLoading, hash, "AsyncGeometryLoading"sv);
+    applyBoolean(renderDetails.CompactModelVertices, hash, "CompactModelVertices"sv);
+    applyBoolean(renderDetails.TextureTranscoding, hash, "TextureTranscoding"sv);
+    applyBoolean(renderDetails.VirtualTextureStreaming, hash, "VirtualTextureStreaming"sv);
+    applyNumber(renderDetails.VirtualTextureMemory, hash, "VirtualTextureMemory"sv);
+    applyBoolean(renderDetails.VirtualTextureAtlas, hash, "VirtualTextureAtlas"sv);
+    applyNumber(renderDetails.TextureMemoryBudget, hash, "TextureMemoryBudget"sv);
+    applyNumber(renderDetails.SphereMeshMemory, hash, "SphereMeshMemory"sv);
+    applyBoolean(renderDetails.ScatteringTables, hash, "ScatteringTables"sv);
     applyStringArray(renderDetails.ignoreGLExtensions, hash, "IgnoreGLExtensions"sv);
 }
 
 
+void
+applyQuality(CelestiaConfig::Quality& quality, const AssociativeArray& hash)
+{
+    applyNumber(quality.targetFrameTime, hash, "QualityTargetFrameTime"sv);
+    applyNumber(quality.tolerance, hash, "QualityTolerance"sv);
+    applyNumber(quality.magnitudeReduction, hash, "QualityMagnitudeReduction"sv);
+    applyNumber(quality.minGalaxyPoints, hash, "QualityMinGalaxyPoints"sv);
+    applyNumber(quality.minLabels, hash, "QualityMinLabels"sv);
+    applyNumber(quality.minShadowMapSize, hash, "QualityMinShadowMapSize"sv);
+    applyNumber(quality.orbitToleranceScale, hash, "QualityOrbitToleranceScale"sv);
+    applyNumber(quality.minSphereDetail, hash, "QualityMinSphereDetail"sv);
+    applyNumber(quality.dynamicResolutionTime, hash, "DynamicResolutionGPUTime"sv);
+    applyNumber(quality.minRenderScale, hash, "DynamicResolutionMinScale"sv);
+    applyNumber(quality.upscaleSharpness, hash, "UpscaleSharpness"sv);
+}
+
+
 void
 applyStarTextures(StarDetails::StarTextureSet& starTextures,
                   const AssociativeArray& hash,
@@ -273,18 +317,32 @@ bool ReadCelestiaConfig(const fs::path& filename, CelestiaConfig& config)
     applyFonts(config.fonts, *configParams);
     applyMouse(config.mouse, *configParams);
     applyRenderDetails(config.renderDetails, *configParams);
+    applyQuality(config.quality, *configParams);
     applyStarTextures(config.starTextures, *configParams, "StarTextures"sv);
 
     applyString(config.projectionMode, *configParams, "ProjectionMode"sv);
     applyString(config.viewportEffect, *configParams, "ViewportEffect"sv);
     applyString(config.x264EncoderOptions, *configParams, "X264EncoderOptions"sv);
     applyString(config.ffvhEncoderOptions, *configParams, "FFVHEncoderOptions"sv);
+    applyString(config.hardwareEncoder, *configParams, "HardwareEncoder"sv);
+    applyString(config.hardwareEncoderDevice, *configParams, "HardwareEncoderDevice"sv);
+    applyString(config.hardwareEncoderOptions, *configParams, "HardwareEncoderOptions"sv);
     applyString(config.measurementSystem, *configParams, "MeasurementSystem"sv);
     applyString(config.temperatureScale, *configParams, "TemperatureScale"sv);
     applyString(config.layoutDirection, *configParams, "LayoutDirection"sv);
     applyString(config.scriptSystemAccessPolicy, *configParams, "ScriptSystemAccessPolicy"sv);
+    applyBoolean(config.scriptProfiler, *configParams, "ScriptProfiler"sv);
+    applyBoolean(config.lazySolarSystems, *configParams, "LazySolarSystems"sv);
 
     applyNumber(config.consoleLogRows, *configParams, "LogSize"sv);
+    applyNumber(config.pagedStarCatalogMemory, *configParams, "PagedStarCatalogMemory"sv);
+    applyNumber(config.orbitCacheTolerance, *configParams, "OrbitCacheTolerance"sv);
+    applyNumber(config.rotationCacheTolerance, *configParams, "RotationCacheTolerance"sv);
+    applyNumber(config.scriptTimeBudget, *configParams, "ScriptTimeBudget"sv);
+    applyNumber(config.catalogReloadInterval, *configParams, "CatalogReloadInterval"sv);
+    applyNumber(config.memoryReportInterval, *configParams, "MemoryReportInterval"sv);
+    applyNumber(config.hitchThreshold, *configParams, "HitchThreshold"sv);
+    applyNumber(config.simulationUpdateRate, *configParams, "SimulationUpdateRate"sv);
 
 #ifdef CELX
     // Move the value into the config object to retain ownership of the hash
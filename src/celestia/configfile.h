@@ -24,6 +24,7 @@ struct CelestiaConfig
     struct Paths
     {
         fs::path starDatabaseFile{ };
+        fs::path pagedStarCatalogFile{ };
         fs::path starNamesFile{ };
         std::vector<fs::path> solarSystemFiles{ };
         std::vector<fs::path> starCatalogFiles{ };
@@ -40,6 +41,15 @@ struct CelestiaConfig
         fs::path SAOCrossIndexFile{ };
         fs::path warpMeshFile{ };
         fs::path leapSecondsFile{ };
+        // Startup timings, as a JSON report and as a Chrome trace
+        fs::path startupProfileFile{ };
+        fs::path startupTraceFile{ };
+        // Files read by the loaders, written after startup and at exit
+        fs::path fileAccessLogFile{ };
+        // Trace of the profiling zones, written at exit
+        fs::path profileTraceFile{ };
+        // Recording of the state of each frame, see FrameRecorder
+        fs::path frameRecordingFile{ };
 #ifdef CELX
         fs::path scriptScreenshotDirectory{ };
         fs::path luaHook{ };
@@ -75,9 +85,50 @@ struct CelestiaConfig
         unsigned int aaSamples{ 1 };
         float SolarSystemMaxDistance{ 1.0f };
         unsigned int ShadowMapSize{ 0 };
+        unsigned int ShadowMapCache{ 4 };
+        bool GPUStarCulling{ false };
+        bool ReverseDepth{ false };
+        bool LabelDeclutter{ false };
+        unsigned int MaxLabels{ 0 };
+        unsigned int GalaxyPointBudget{ 0 };
+        bool RenderOnDemand{ false };
+        bool LowLatency{ false };
+        bool VSync{ true };
+        bool AsyncShaderCompilation{ false };
+        bool PrewarmShaders{ false };
+        bool AsyncTextureLoading{ false };
+        bool AsyncGeometryLoading{ false };
+        bool CompactModelVertices{ false };
+        bool TextureTranscoding{ false };
+        bool VirtualTextureStreaming{ false };
+        unsigned int VirtualTextureMemory{ 256 };
+        bool VirtualTextureAtlas{ false };
+        unsigned int TextureMemoryBudget{ 0 };
+        unsigned int SphereMeshMemory{ 0 };
+        bool ScatteringTables{ true };
         std::vector<std::string> ignoreGLExtensions{ };
     };
 
+    // Ranges of the detail lowered to hold a frame time; the best values
+    // are those of the render details
+    struct Quality
+    {
+        // Milliseconds; 0 disables the governor
+        double targetFrameTime{ 0.0 };
+        double tolerance{ 0.15 };
+        float magnitudeReduction{ 2.0f };
+        unsigned int minGalaxyPoints{ 250000 };
+        unsigned int minLabels{ 100 };
+        unsigned int minShadowMapSize{ 512 };
+        double orbitToleranceScale{ 8.0 };
+        float minSphereDetail{ 0.25f };
+        // Milliseconds of GPU time above which the scene is drawn at a
+        // lower resolution; 0 disables it
+        double dynamicResolutionTime{ 0.0 };
+        float minRenderScale{ 0.5f };
+        float upscaleSharpness{ 0.5f };
+    };
+
     CelestiaConfig() = default;
     ~CelestiaConfig() = default;
     CelestiaConfig(const CelestiaConfig&) = delete;
@@ -89,12 +140,50 @@ struct CelestiaConfig
     Fonts fonts{ };
     Mouse mouse{ };
     RenderDetails renderDetails{ };
+    Quality quality{ };
     StarDetails::StarTextureSet starTextures{ };
 
     std::string scriptSystemAccessPolicy{ };
 
+    // Profile the time spent in the functions of celx scripts
+    bool scriptProfiler{ false };
+
+    // Time a celx script or callback may run for before a warning is
+    // logged, in milliseconds; 0 disables the warnings
+    double scriptTimeBudget{ 0.0 };
+
     unsigned int consoleLogRows{ 200 };
 
+    // Only create the objects of a solar system when it is first looked up
+    bool lazySolarSystems{ false };
+
+    // Seconds between checks of the catalog files for changes; 0 disables
+    // reloading them
+    double catalogReloadInterval{ 0.0 };
+
+    // Seconds between reports of the memory usage to the log; 0 disables
+    // them
+    double memoryReportInterval{ 0.0 };
+
+    // Milliseconds of CPU time above which a frame is logged as a hitch,
+    // with the loads and scripts which made it slow; 0 disables the checks
+    double hitchThreshold{ 0.0 };
+
+    // Simulation steps per second, drawn interpolated; 0 steps once per
+    // frame
+    double simulationUpdateRate{ 0.0 };
+
+    // Memory budget for the paged star catalog, in megabytes
+    unsigned int pagedStarCatalogMemory{ 1024 };
+
+    // Tolerance of the Chebyshev approximations of custom and SPICE
+    // orbits, in kilometers; 0 disables them
+    double orbitCacheTolerance{ 0.0 };
+
+    // Tolerance of the interpolated orientations of custom rotation
+    // models, in arcseconds; 0 disables them
+    double rotationCacheTolerance{ 0.0 };
+
     std::string projectionMode{ };
     std::string viewportEffect{ };
     std::string measurementSystem{ };
@@ -103,6 +192,12 @@ struct CelestiaConfig
     std::string x264EncoderOptions{ };
     std::string ffvhEncoderOptions{ };
 
+    // Hardware video encoder (nvenc, vaapi, qsv or videotoolbox), the
+    // device it runs on and its options; empty for the software encoders
+    std::string hardwareEncoder{ };
+    std::string hardwareEncoderDevice{ };
+    std::string hardwareEncoderOptions{ };
+
     std::string layoutDirection{ };
 
 #ifdef CELX
@@ -12,14 +12,22 @@
 
 #include "eclipsefinder.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <cstddef>
 
 #include <Eigen/Core>
 #include <Eigen/Geometry>
 
 #include <celengine/body.h>
+#include <celengine/frame.h>
 #include <celengine/star.h>
+#include <celengine/timeline.h>
+#include <celengine/timelinephase.h>
+#include <celephem/orbit.h>
 #include <celmath/distance.h>
+#include <celutil/threadpool.h>
 
 namespace math = celestia::math;
 namespace util = celestia::util;
@@ -27,7 +35,6 @@ namespace util = celestia::util;
 namespace
 {
 
-constexpr double dT = 1.0 / (24.0 * 60.0);
 constexpr auto EclipseObjectMask = BodyClassification::Planet      |
                                    BodyClassification::Moon        |
                                    BodyClassification::MinorMoon   |
@@ -37,102 +44,262 @@ constexpr auto EclipseObjectMask = BodyClassification::Planet      |
 // TODO: share this constant and function with render.cpp
 constexpr float MinRelativeOccluderRadius = 0.005f;
 
+// Limits of the search step, in days; the first step of a search, before
+// the angular motion of a pair is known, is one hour
+constexpr double MinSearchStep = 1.0 / (24.0 * 60.0);
+constexpr double InitialSearchStep = 1.0 / 24.0;
+constexpr double MaxSearchStep = 10.0;
+
+// Fraction of the time the shadow would take to reach the receiver at the
+// current angular motion that is taken as the next step
+constexpr double SearchStepSafety = 0.5;
+
+// Precision of eclipse duration calculation
+constexpr double DurationPrecision = 1.0 / (24.0 * 360.0); // ten seconds
+
+// Eclipses longer than this are cut short instead of followed further
+constexpr double MaxEclipseDuration = 30.0;
+
+// Length of the spans of the date range which are searched by one task
+constexpr double ChunkLength = 10.0;
+
+struct EclipsePair
+{
+    const Body* receiver;
+    const Body* caster;
+};
+
+// Ignore situations where the shadow casting body is much smaller than
+// the receiver, as these shadows aren't likely to be relevant.  Also,
+// ignore eclipses where the caster is not an ellipsoid, since we can't
+// generate correct shadows in this case.
 bool
-testEclipse(const Body& receiver, const Body& caster, double now)
+canCastShadow(const Body& receiver, const Body& caster)
+{
+    return caster.getRadius() >= receiver.getRadius() * MinRelativeOccluderRadius &&
+           caster.isEllipsoid();
+}
+
+// Distance from the axis of the shadow of the caster at which the
+// receiver is eclipsed
+float
+eclipseRadius(const Body& receiver, const Body& caster,
+              const Eigen::Vector3d& posReceiver, const Eigen::Vector3d& posCaster)
 {
-    // Ignore situations where the shadow casting body is much smaller than
-    // the receiver, as these shadows aren't likely to be relevant.  Also,
-    // ignore eclipses where the caster is not an ellipsoid, since we can't
-    // generate correct shadows in this case.
-    if (caster.getRadius() >= receiver.getRadius() * MinRelativeOccluderRadius &&
-        caster.isEllipsoid())
+    const Star* sun = receiver.getSystem()->getStar();
+    assert(sun != nullptr);
+    double distToSun = posReceiver.norm();
+    float appSunRadius = (float) (sun->getRadius() / distToSun);
+
+    Eigen::Vector3d dir = posCaster - posReceiver;
+    double distToCaster = dir.norm() - receiver.getRadius();
+    float appOccluderRadius = (float) (caster.getRadius() / distToCaster);
+
+    // The shadow radius is the radius of the occluder plus some additional
+    // amount that depends upon the apparent radius of the sun.  For
+    // a sun that's distant/small and effectively a point, the shadow
+    // radius will be the same as the radius of the occluder.
+    float shadowRadius = (1 + appSunRadius / appOccluderRadius) *
+        caster.getRadius();
+
+    return receiver.getRadius() + shadowRadius;
+}
+
+bool
+testEclipse(const Body& receiver, const Body& caster,
+            const Eigen::Vector3d& posReceiver, const Eigen::Vector3d& posCaster)
+{
+    // All of the eclipse related code assumes that both the caster
+    // and receiver are spherical.  Irregular receivers will work more
+    // or less correctly, but casters that are sufficiently non-spherical
+    // will produce obviously incorrect shadows.  Another assumption we
+    // make is that the distance between the caster and receiver is much
+    // less than the distance between the sun and the receiver.  This
+    // approximation works everywhere in the solar system, and likely
+    // works for any orbitally stable pair of objects orbiting a star.
+
+    // Test whether a shadow is cast on the receiver.  We want to know
+    // if the receiver lies within the shadow volume of the caster.  Since
+    // we're assuming that everything is a sphere and the sun is far
+    // away relative to the caster, the shadow volume is a
+    // cylinder capped at one end.  Testing for the intersection of a
+    // singly capped cylinder is as simple as checking the distance
+    // from the center of the receiver to the axis of the shadow cylinder.
+    // If the distance is less than the sum of the caster's and receiver's
+    // radii, then we have an eclipse.
+    float R = eclipseRadius(receiver, caster, posReceiver, posCaster);
+    double dist = math::distance(posReceiver, Eigen::ParametrizedLine<double, 3>(posCaster, posCaster));
+    if (dist < R)
     {
-        // All of the eclipse related code assumes that both the caster
-        // and receiver are spherical.  Irregular receivers will work more
-        // or less correctly, but casters that are sufficiently non-spherical
-        // will produce obviously incorrect shadows.  Another assumption we
-        // make is that the distance between the caster and receiver is much
-        // less than the distance between the sun and the receiver.  This
-        // approximation works everywhere in the solar system, and likely
-        // works for any orbitally stable pair of objects orbiting a star.
-        Eigen::Vector3d posReceiver = receiver.getAstrocentricPosition(now);
-        Eigen::Vector3d posCaster = caster.getAstrocentricPosition(now);
-
-        const Star* sun = receiver.getSystem()->getStar();
-        assert(sun != nullptr);
-        double distToSun = posReceiver.norm();
-        float appSunRadius = (float) (sun->getRadius() / distToSun);
-
-        Eigen::Vector3d dir = posCaster - posReceiver;
-        double distToCaster = dir.norm() - receiver.getRadius();
-        float appOccluderRadius = (float) (caster.getRadius() / distToCaster);
-
-        // The shadow radius is the radius of the occluder plus some additional
-        // amount that depends upon the apparent radius of the sun.  For
-        // a sun that's distant/small and effectively a point, the shadow
-        // radius will be the same as the radius of the occluder.
-        float shadowRadius = (1 + appSunRadius / appOccluderRadius) *
-            caster.getRadius();
-
-        // Test whether a shadow is cast on the receiver.  We want to know
-        // if the receiver lies within the shadow volume of the caster.  Since
-        // we're assuming that everything is a sphere and the sun is far
-        // away relative to the caster, the shadow volume is a
-        // cylinder capped at one end.  Testing for the intersection of a
-        // singly capped cylinder is as simple as checking the distance
-        // from the center of the receiver to the axis of the shadow cylinder.
-        // If the distance is less than the sum of the caster's and receiver's
-        // radii, then we have an eclipse.
-        float R = receiver.getRadius() + shadowRadius;
-        double dist = math::distance(posReceiver, Eigen::ParametrizedLine<double, 3>(posCaster, posCaster));
-        if (dist < R)
-        {
-            // Ignore "eclipses" where the caster and receiver have
-            // intersecting bounding spheres.
-            if (distToCaster > caster.getRadius())
-                return true;
-        }
+        // Ignore "eclipses" where the caster and receiver have
+        // intersecting bounding spheres.
+        double distToCaster = (posCaster - posReceiver).norm() - receiver.getRadius();
+        if (distToCaster > caster.getRadius())
+            return true;
     }
 
     return false;
 }
 
+bool
+testEclipse(const EclipsePair& pair, double now)
+{
+    return testEclipse(*pair.receiver, *pair.caster,
+                       pair.receiver->getAstrocentricPosition(now),
+                       pair.caster->getAstrocentricPosition(now));
+}
+
+// Find the edge of the eclipse in progress at the time inside, after it
+// when direction is positive and before it otherwise. The eclipse is
+// followed in growing steps, then the edge is bisected.
 double
-findEclipseSpan(const Body& receiver, const Body& caster,
-                double now, double dt)
+findEclipseEdge(const EclipsePair& pair, double inside, double direction)
 {
-    double t = now;
-    while (testEclipse(receiver, caster, t))
-        t += dt;
+    double start = inside;
+    double step = MinSearchStep;
+    double outside = inside + direction * step;
+    while (testEclipse(pair, outside))
+    {
+        if (std::abs(outside - start) > MaxEclipseDuration)
+            return outside;
+
+        inside = outside;
+        step *= 2.0;
+        outside = inside + direction * step;
+    }
 
-    return t;
+    while (std::abs(outside - inside) > DurationPrecision)
+    {
+        double middle = (inside + outside) * 0.5;
+        if (testEclipse(pair, middle))
+            inside = middle;
+        else
+            outside = middle;
+    }
+
+    return (inside + outside) * 0.5;
 }
 
+// Tracks the direction from the caster to the receiver and the axis of the
+// shadow, and chooses steps which can't jump over the receiver entering the
+// shadow as long as their angular motion stays about the same.
+class SearchStepper
+{
+ public:
+    double
+    nextStep(const Body& receiver, const Body& caster,
+             const Eigen::Vector3d& posReceiver, const Eigen::Vector3d& posCaster,
+             double now)
+    {
+        Eigen::Vector3d toReceiver = posReceiver - posCaster;
+        double distance = toReceiver.norm();
+        toReceiver /= distance;
+        Eigen::Vector3d axis = posCaster.normalized();
+
+        double step = InitialSearchStep;
+        if (hasLast && now > lastTime)
+        {
+            double rate = (angleBetween(toReceiver, lastToReceiver) + angleBetween(axis, lastAxis)) / (now - lastTime);
+            double radius = eclipseRadius(receiver, caster, posReceiver, posCaster);
+            double margin = angleBetween(toReceiver, axis) - std::asin(std::min(radius / distance, 1.0));
+            step = rate > 0.0 ? SearchStepSafety * std::max(margin, 0.0) / rate : MaxSearchStep;
+            step = std::clamp(step, MinSearchStep, MaxSearchStep);
+        }
+
+        hasLast = true;
+        lastTime = now;
+        lastToReceiver = toReceiver;
+        lastAxis = axis;
+        return step;
+    }
+
+    void reset() { hasLast = false; }
+
+ private:
+    static double
+    angleBetween(const Eigen::Vector3d& a, const Eigen::Vector3d& b)
+    {
+        return std::acos(std::clamp(a.dot(b), -1.0, 1.0));
+    }
+
+    bool hasLast{ false };
+    double lastTime{ 0.0 };
+    Eigen::Vector3d lastToReceiver;
+    Eigen::Vector3d lastAxis;
+};
+
+// Add the eclipses of one pair which start in [begin, end), and those in
+// progress at begin if includeOngoing is set
 void
-addEclipse(const Body& receiver, const Body& occulter,
-           double now,
-           double /*startStep*/, double /*minStep*/,
-           std::vector<Eclipse>& eclipses,
-           std::vector<double>& previousEclipseEndTimes, int i)
+searchPair(const EclipsePair& pair, double begin, double end, bool includeOngoing,
+           std::vector<Eclipse>& eclipses)
 {
-    if (testEclipse(receiver, occulter, now))
+    SearchStepper stepper;
+    double lastTime = begin;
+    bool hasLast = false;
+
+    for (double t = begin;;)
     {
-        Eclipse eclipse;
-#if 1
-        eclipse.startTime = findEclipseSpan(receiver, occulter, now, -dT);
-        eclipse.endTime = findEclipseSpan(receiver, occulter, now, dT);
-#else
-        eclipse.startTime = findEclipseStart(receiver, occulter, now, searchStep, minStep);
-        eclipse.endTime = findEclipseEnd(receiver, occulter, now, searchStep, minStep);
-#endif
-        eclipse.receiver = const_cast<Body*>(&receiver);
-        eclipse.occulter = const_cast<Body*>(&occulter);
-        eclipses.emplace_back(eclipse);
-
-        previousEclipseEndTimes[i] = eclipse.endTime;
+        Eigen::Vector3d posReceiver = pair.receiver->getAstrocentricPosition(t);
+        Eigen::Vector3d posCaster = pair.caster->getAstrocentricPosition(t);
+        if (testEclipse(*pair.receiver, *pair.caster, posReceiver, posCaster))
+        {
+            Eclipse eclipse;
+            eclipse.receiver = const_cast<Body*>(pair.receiver);
+            eclipse.occulter = const_cast<Body*>(pair.caster);
+            eclipse.endTime = findEclipseEdge(pair, t, 1.0);
+
+            if (hasLast)
+            {
+                // The eclipse started since the last step
+                double inside = t;
+                double outside = lastTime;
+                while (inside - outside > DurationPrecision)
+                {
+                    double middle = (inside + outside) * 0.5;
+                    if (testEclipse(pair, middle))
+                        inside = middle;
+                    else
+                        outside = middle;
+                }
+                eclipse.startTime = (inside + outside) * 0.5;
+            }
+            else
+            {
+                eclipse.startTime = findEclipseEdge(pair, t, -1.0);
+            }
+
+            if (eclipse.startTime >= begin || includeOngoing)
+                eclipses.push_back(eclipse);
+
+            // Resume the search once the receiver is out of the shadow
+            t = eclipse.endTime + DurationPrecision;
+            hasLast = false;
+            stepper.reset();
+            if (t >= end)
+                return;
+            continue;
+        }
+
+        if (t >= end)
+            return;
+
+        double step = stepper.nextStep(*pair.receiver, *pair.caster, posReceiver, posCaster, t);
+        lastTime = t;
+        hasLast = true;
+        t = std::min(t + step, end);
     }
 }
 
+// The position of the body may be computed on a worker thread if none of
+// the orbits and frames of it and of the bodies its frames are centered on
+// have caches
+bool
+isThreadSafeBody(const Body& body)
+{
+    return body.getTimeline()->isThreadSafe();
+}
+
 } // end unnamed namespace
 
 EclipseFinder::EclipseFinder(const Body* _body,
@@ -142,6 +309,23 @@ EclipseFinder::EclipseFinder(const Body* _body,
 {
 }
 
+bool EclipseFinder::isThreadSafe() const
+{
+    if (!isThreadSafeBody(*body))
+        return false;
+
+    if (const PlanetarySystem* satellites = body->getSatellites(); satellites != nullptr)
+    {
+        for (int i = 0; i < satellites->getSystemSize(); i++)
+        {
+            if (!isThreadSafeBody(*satellites->getBody(i)))
+                return false;
+        }
+    }
+
+    return true;
+}
+
 void EclipseFinder::findEclipses(double startDate,
                                  double endDate,
                                  int eclipseTypeMask,
@@ -153,53 +337,80 @@ void EclipseFinder::findEclipses(double startDate,
     if (satellites == nullptr)
         return;
 
-    // For each body, we'll need to store the time when the last eclipse ended
-    std::vector<double> previousEclipseEndTimes;
-
     // Make a list of satellites that we'll actually test for eclipses; ignore
     // spacecraft and very small objects.
-    std::vector<Body*> testBodies;
+    std::vector<EclipsePair> pairs;
+    bool threadSafe = isThreadSafeBody(*body);
     for (int i = 0; i < satellites->getSystemSize(); i++)
     {
-        Body* obj = satellites->getBody(i);
-        if (util::is_set(obj->getClassification(), EclipseObjectMask) &&
-            obj->getRadius() >= body->getRadius() * MinRelativeOccluderRadius)
+        const Body* obj = satellites->getBody(i);
+        if (!util::is_set(obj->getClassification(), EclipseObjectMask) ||
+            obj->getRadius() < body->getRadius() * MinRelativeOccluderRadius)
         {
-            testBodies.push_back(obj);
-            previousEclipseEndTimes.push_back(startDate - 1.0);
+            continue;
         }
+
+        if ((eclipseTypeMask & Eclipse::Solar) && canCastShadow(*body, *obj))
+            pairs.push_back({ body, obj });
+        if ((eclipseTypeMask & Eclipse::Lunar) && canCastShadow(*obj, *body))
+            pairs.push_back({ obj, body });
+        threadSafe = threadSafe && isThreadSafeBody(*obj);
     }
 
-    if (testBodies.empty())
+    if (pairs.empty() || !(endDate >= startDate))
         return;
 
-    // TODO: Use a fixed step of one hour for now; we should use a binary
-    // search instead.
-    double searchStep = 1.0 / 24.0; // one hour
+    // Chunks of the date range are searched a round at a time, so that
+    // the watcher is only called when no search is running
+    util::ThreadPool* threadPool = threadSafe ? util::GetThreadPool() : nullptr;
+    std::size_t chunksPerRound = threadPool != nullptr ? (threadPool->threadCount() + 1) * 2 : 1;
+    auto nChunks = static_cast<std::size_t>(std::ceil((endDate - startDate) / ChunkLength));
+    nChunks = std::max(nChunks, std::size_t(1));
 
-    // Precision of eclipse duration calculation
-    double durationPrecision = 1.0 / (24.0 * 360.0); // ten seconds
-
-    for (double t = startDate; t <= endDate; t += searchStep)
+    std::vector<std::vector<Eclipse>> found(chunksPerRound);
+    for (std::size_t first = 0; first < nChunks; first += chunksPerRound)
     {
-        if (watcher != nullptr)
+        std::size_t count = std::min(chunksPerRound, nChunks - first);
+        auto searchChunk = [&](std::size_t i)
         {
-            if (watcher->eclipseFinderProgressUpdate(t) == EclipseFinderWatcher::AbortOperation)
-                return;
-        }
+            std::size_t chunk = first + i;
+            double begin = startDate + ChunkLength * static_cast<double>(chunk);
+            double end = chunk + 1 == nChunks ? endDate : begin + ChunkLength;
+            found[i].clear();
+            for (const EclipsePair& pair : pairs)
+                searchPair(pair, begin, end, chunk == 0, found[i]);
+            std::sort(found[i].begin(), found[i].end(),
+                      [](const Eclipse& a, const Eclipse& b) { return a.startTime < b.startTime; });
+        };
 
-        for (unsigned int i = 0; i < testBodies.size(); i++)
+        if (threadPool != nullptr)
+        {
+            threadPool->parallelFor(count, searchChunk);
+        }
+        else
         {
-            // Only test for an eclipse if we're not in the middle of
-            // of previous one.
-            if (t <= previousEclipseEndTimes[i])
-                continue;
+            for (std::size_t i = 0; i < count; ++i)
+                searchChunk(i);
+        }
 
-            if (eclipseTypeMask & Eclipse::Solar)
-                addEclipse(*body, *testBodies[i], t, searchStep, durationPrecision, eclipses, previousEclipseEndTimes, i);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            for (const Eclipse& eclipse : found[i])
+            {
+                if (watcher != nullptr &&
+                    watcher->eclipseFinderEclipseFound(eclipse) == EclipseFinderWatcher::AbortOperation)
+                {
+                    return;
+                }
+                eclipses.push_back(eclipse);
+            }
+        }
 
-            if (eclipseTypeMask & Eclipse::Lunar)
-                addEclipse(*testBodies[i], *body, t, searchStep, durationPrecision, eclipses, previousEclipseEndTimes, i);
+        double searched = std::min(startDate + ChunkLength * static_cast<double>(first + count), endDate);
+        if (watcher != nullptr &&
+            watcher->eclipseFinderProgressUpdate(searched) == EclipseFinderWatcher::AbortOperation)
+        {
+            return;
         }
     }
 }
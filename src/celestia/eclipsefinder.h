@@ -43,6 +43,14 @@ class EclipseFinderWatcher
     };
 
     virtual Status eclipseFinderProgressUpdate(double t) = 0;
+
+    // Called on the thread which called findEclipses for each eclipse as
+    // it is found, in order of start time, before it is added to the list
+    virtual Status eclipseFinderEclipseFound(const Eclipse& /*eclipse*/)
+    {
+        return ContinueOperation;
+    }
+
     virtual ~EclipseFinderWatcher() = default;
 };
 
@@ -52,10 +60,21 @@ class EclipseFinder
  public:
     EclipseFinder(const Body*, EclipseFinderWatcher* = nullptr);
 
+    // The date range is searched in chunks, in parallel when the
+    // positions of all the bodies may be computed on worker threads. The
+    // search step adapts to the angular motion of each pair of bodies
+    // relative to the shadow, and the edges of eclipses are found by
+    // bisection.
     void findEclipses(double startDate,
                       double endDate,
                       int eclipseTypeMask,
                       std::vector<Eclipse>& eclipses);
+
+    // Whether the positions of the body and of its satellites may be
+    // computed away from the main thread, so that the search may be run on
+    // a worker thread
+    bool isThreadSafe() const;
+
  private:
     const Body* body;
     EclipseFinderWatcher* watcher;
@@ -5,6 +5,8 @@
 extern "C"
 {
 #include <libavcodec/avcodec.h>
+#include <libavutil/hwcontext.h>
+#include <libavutil/imgutils.h>
 #include <libavutil/timestamp.h>
 #include <libavutil/pixdesc.h>
 #include <libavutil/opt.h>
@@ -12,19 +14,87 @@ extern "C"
 #include <libswscale/swscale.h>
 }
 
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <thread>
 #include <vector>
 #include <fmt/format.h>
 
+#include <celengine/framereadback.h>
 #include <celengine/render.h>
 #include <celimage/pixelformat.h>
+#include <celutil/profiler.h>
 
 using namespace std;
 using namespace celestia;
 
+// the hardware encoders need the hwcontext API of ffmpeg 4.0
+#define HAVE_HW_ENCODERS (LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(58, 10, 100))
+
+#if HAVE_HW_ENCODERS
+namespace
+{
+
+struct HardwareEncoder
+{
+    std::string_view name;
+    // hwcontext device type
+    const char *deviceType;
+    // suffix of the encoder names, e.g. h264_nvenc
+    std::string_view suffix;
+};
+
+constexpr std::array<HardwareEncoder, 4> HardwareEncoders
+{
+    HardwareEncoder{ "nvenc"sv,        "cuda",         "nvenc"sv        },
+    HardwareEncoder{ "vaapi"sv,        "vaapi",        "vaapi"sv        },
+    HardwareEncoder{ "qsv"sv,          "qsv",          "qsv"sv          },
+    HardwareEncoder{ "videotoolbox"sv, "videotoolbox", "videotoolbox"sv },
+};
+
+const HardwareEncoder* findHardwareEncoder(std::string_view name)
+{
+    for (const auto& encoder : HardwareEncoders)
+    {
+        if (encoder.name == name)
+            return &encoder;
+    }
+    return nullptr;
+}
+
+// the encoder of a codec on a hardware device, if both are supported by
+// the libraries
+const AVCodec* findHardwareCodec(AVCodecID id, const HardwareEncoder& encoder)
+{
+    if (av_hwdevice_find_type_by_name(encoder.deviceType) == AV_HWDEVICE_TYPE_NONE)
+        return nullptr;
+    std::string codecName = fmt::format("{}_{}", avcodec_get_name(id), encoder.suffix);
+    return avcodec_find_encoder_by_name(codecName.c_str());
+}
+
+} // end unnamed namespace
+#endif
+
 // a wrapper around a single output AVStream
+//
+// Frames are read on the render thread, through a FrameReadback ring when
+// pixel buffer objects are supported, and handed over to an encoder thread
+// which converts them to the codec pixel format, encodes them and writes the
+// packets. At most MaxBufferedFrames frames are held in memory; capturing
+// waits for the encoder when they are all in use.
 class FFMPEGCapturePrivate
 {
+    using PixelBuffer = std::unique_ptr<unsigned char[]>;
+
+    static constexpr std::size_t MaxBufferedFrames = 4;
+
     FFMPEGCapturePrivate() = default;
     ~FFMPEGCapturePrivate();
 
@@ -32,38 +102,77 @@ class FFMPEGCapturePrivate
     bool addStream(int w, int h, float fps);
     bool openVideo();
     bool start();
-    bool writeVideoFrame(bool = false);
+    bool captureFrame();
+    bool retrieveFrame(bool wait);
     void finish();
     void setVideoCodec(int);
 
     bool isSupportedPixelFormat(enum AVPixelFormat) const;
+    bool setupHardwareEncoder();
+
+    PixelBuffer acquireBuffer();
+    void releaseBuffer(PixelBuffer&&);
+    void submitFrame(PixelBuffer&&);
+    void stopEncoder();
+    void encodeFrames();
+    bool encodeFrame(const unsigned char* pixels);
+    bool sendFrame(AVFrame*);
 
     int writePacket();
 
     AVStream        *st       { nullptr };
     AVFrame         *frame    { nullptr };
-    AVFrame         *tmpfr    { nullptr };
     AVCodecContext  *enc      { nullptr };
     AVFormatContext *oc       { nullptr };
     const AVCodec   *vc       { nullptr };
     AVPacket        *pkt      { nullptr };
     SwsContext      *swsc     { nullptr };
 
+    // hardware device and, for encoders which only take frames stored on
+    // the device, the pool of these frames and the frame to upload to
+    AVBufferRef     *hwDevice    { nullptr };
+    AVBufferRef     *hwFrames    { nullptr };
+    AVFrame         *hwFrame     { nullptr };
+    AVHWDeviceType  hwDeviceType { AV_HWDEVICE_TYPE_NONE };
+
     const Renderer  *renderer { nullptr };
 
-    // pts of the next frame that will be generated
+    // pts of the next frame that will be encoded
     int64_t         nextPts   { 0       };
+    // number of frames captured so far
+    int             frameCount{ 0       };
     // requested bitrate
     int64_t         bit_rate  { 400000  };
 
     AVCodecID       vc_id     { AV_CODEC_ID_FFVHUFF };
     AVPixelFormat   format    { AV_PIX_FMT_NONE     };
+    // pixel format of the frames converted from the captured ones
+    AVPixelFormat   swFormat  { AV_PIX_FMT_NONE     };
+    engine::PixelFormat captureFormat{ engine::PixelFormat::RGB };
     float           fps       { 0       };
     bool            capturing { false   };
     bool            hasAlpha  { false   };
 
     fs::path        filename;
+    std::string     container { "matroska" };
     std::string     vc_options;
+    std::string     hwEncoder;
+    std::string     hwDeviceName;
+
+    // size of the captured frames, with rows padded to four bytes
+    std::size_t     rowStride { 0       };
+    std::size_t     frameSize { 0       };
+    std::unique_ptr<FrameReadback> readback;
+    bool            useReadback{ false  };
+
+    std::thread                 encoder;
+    std::mutex                  mutex;
+    std::condition_variable     queueChanged;
+    std::deque<PixelBuffer>     queue;
+    std::vector<PixelBuffer>    freeBuffers;
+    std::size_t                 allocatedBuffers{ 0 };
+    bool                        encoderStopped{ false };
+    std::atomic<bool>           failed{ false };
 
  public:
 #if (LIBAVCODEC_VERSION_INT < AV_VERSION_INT(58, 10, 100)) // ffmpeg < 4.0
@@ -88,10 +197,13 @@ bool FFMPEGCapturePrivate::init(const fs::path& filename)
     }
 #endif
 
-    // always use matroska (*.mkv) as a container
+    // network protocols need to be initialized before opening a URL
+    if (filename.string().find("://") != std::string::npos)
+        avformat_network_init();
+
     // don't change filename.string().c_str() -> filename.c_str()!
     // on windows c_str() return wchar_t*
-    avformat_alloc_output_context2(&oc, nullptr, "matroska", filename.string().c_str());
+    avformat_alloc_output_context2(&oc, nullptr, container.c_str(), filename.string().c_str());
 
     return oc != nullptr;
 }
@@ -209,7 +321,18 @@ bool FFMPEGCapturePrivate::addStream(int width, int height, float fps)
     this->fps = fps;
 
     // find the encoder
-    vc = avcodec_find_encoder(vc_id);
+#if HAVE_HW_ENCODERS
+    if (!hwEncoder.empty())
+    {
+        const HardwareEncoder* encoder = findHardwareEncoder(hwEncoder);
+        if (encoder != nullptr && (vc = findHardwareCodec(vc_id, *encoder)) != nullptr)
+            hwDeviceType = av_hwdevice_find_type_by_name(encoder->deviceType);
+        else
+            fmt::print("Hardware encoder {} isn't available, using the software encoder\n", hwEncoder);
+    }
+#endif
+    if (vc == nullptr)
+        vc = avcodec_find_encoder(vc_id);
     if (vc == nullptr)
     {
         cout << "Video codec isn't found\n";
@@ -262,7 +385,12 @@ bool FFMPEGCapturePrivate::addStream(int width, int height, float fps)
     enc->gop_size  = 12; // emit one intra frame every twelve frames at most
 
     // find a best pixel format to convert to from `format`
-    if (isSupportedPixelFormat(AV_PIX_FMT_YUV420P))
+    if (hwDeviceType != AV_HWDEVICE_TYPE_NONE)
+    {
+        if (!setupHardwareEncoder())
+            return false;
+    }
+    else if (isSupportedPixelFormat(AV_PIX_FMT_YUV420P))
     {
         enc->pix_fmt = AV_PIX_FMT_YUV420P;
     }
@@ -272,6 +400,8 @@ bool FFMPEGCapturePrivate::addStream(int width, int height, float fps)
         if (enc->pix_fmt == AV_PIX_FMT_NONE)
             avcodec_default_get_format(enc, &(enc->pix_fmt));
     }
+    if (swFormat == AV_PIX_FMT_NONE)
+        swFormat = enc->pix_fmt;
 
     if (enc->codec_id == AV_CODEC_ID_MPEG1VIDEO)
     {
@@ -291,6 +421,87 @@ bool FFMPEGCapturePrivate::addStream(int width, int height, float fps)
     return true;
 }
 
+// open the hardware device and choose the pixel formats of a hardware
+// encoder: captured RGB frames if the encoder converts them on the GPU,
+// otherwise frames converted to NV12, which are uploaded to the device
+// first for encoders that only take frames stored on it
+bool FFMPEGCapturePrivate::setupHardwareEncoder()
+{
+#if HAVE_HW_ENCODERS
+    if (av_hwdevice_ctx_create(&hwDevice, hwDeviceType,
+                               hwDeviceName.empty() ? nullptr : hwDeviceName.c_str(),
+                               nullptr, 0) < 0)
+    {
+        fmt::print("Failed to open the {} device\n", hwEncoder);
+        return false;
+    }
+
+    if (isSupportedPixelFormat(AV_PIX_FMT_RGB0))
+    {
+        // the alpha channel is ignored
+        format = AV_PIX_FMT_RGB0;
+        captureFormat = engine::PixelFormat::RGBA;
+        hasAlpha = true;
+        enc->pix_fmt = AV_PIX_FMT_RGB0;
+    }
+    else if (isSupportedPixelFormat(AV_PIX_FMT_NV12))
+    {
+        enc->pix_fmt = AV_PIX_FMT_NV12;
+    }
+    else if (isSupportedPixelFormat(AV_PIX_FMT_YUV420P))
+    {
+        enc->pix_fmt = AV_PIX_FMT_YUV420P;
+    }
+    else
+    {
+        // find the format of the frames stored on the device
+        for (int i = 0;; i++)
+        {
+            const AVCodecHWConfig *config = avcodec_get_hw_config(vc, i);
+            if (config == nullptr)
+            {
+                cout << "Unsupported hardware frame format\n";
+                return false;
+            }
+
+            if (config->device_type == hwDeviceType &&
+                (config->methods & AV_CODEC_HW_CONFIG_METHOD_HW_FRAMES_CTX) != 0)
+            {
+                enc->pix_fmt = config->pix_fmt;
+                break;
+            }
+        }
+
+        if ((hwFrames = av_hwframe_ctx_alloc(hwDevice)) == nullptr)
+        {
+            cout << "Failed to allocate the hardware frames\n";
+            return false;
+        }
+
+        auto *framesContext = reinterpret_cast<AVHWFramesContext*>(hwFrames->data);
+        framesContext->format    = enc->pix_fmt;
+        framesContext->sw_format = AV_PIX_FMT_NV12;
+        framesContext->width     = enc->width;
+        framesContext->height    = enc->height;
+        framesContext->initial_pool_size = 20;
+        if (av_hwframe_ctx_init(hwFrames) < 0)
+        {
+            cout << "Failed to initialize the hardware frames\n";
+            return false;
+        }
+
+        enc->hw_frames_ctx = av_buffer_ref(hwFrames);
+        swFormat = AV_PIX_FMT_NV12;
+        return true;
+    }
+
+    enc->hw_device_ctx = av_buffer_ref(hwDevice);
+    return true;
+#else
+    return false;
+#endif
+}
+
 bool FFMPEGCapturePrivate::start()
 {
     // open the output file, if needed
@@ -352,7 +563,7 @@ bool FFMPEGCapturePrivate::openVideo()
         return false;
     }
 
-    frame->format = enc->pix_fmt;
+    frame->format = swFormat;
     frame->width  = enc->width;
     frame->height = enc->height;
 
@@ -363,100 +574,229 @@ bool FFMPEGCapturePrivate::openVideo()
         return false;
     }
 
-    if (enc->pix_fmt != format)
+    if (hwFrames != nullptr && (hwFrame = av_frame_alloc()) == nullptr)
+    {
+        cout << "Failed to allocate hardware frame\n";
+        return false;
+    }
+
+    if (swFormat != format)
     {
         // as we only grab a RGB24 picture, we must convert it
         // to the codec pixel format if needed
         swsc = sws_getContext(enc->width, enc->height, format,
-                              enc->width, enc->height, enc->pix_fmt,
+                              enc->width, enc->height, swFormat,
                               SWS_BITEXACT, nullptr, nullptr, nullptr);
         if (swsc == nullptr)
         {
             cout << "Failed to allocate SWS context\n";
             return false;
         }
+    }
 
-        // allocate and init a temporary frame
-        if((tmpfr = av_frame_alloc()) == nullptr)
-        {
-            cout << "Failed to allocate temp frame\n";
-            return false;
-        }
+    const int bytesPerPixel = hasAlpha ? 4 : 3;
+    rowStride = (static_cast<std::size_t>(bytesPerPixel * enc->width) + 3) & ~std::size_t(3);
+    frameSize = rowStride * static_cast<std::size_t>(enc->height);
+
+    // copy the stream parameters to the muxer
+    if (avcodec_parameters_from_context(st->codecpar, enc) < 0)
+    {
+        cout << "Failed to copy the stream parameters to the muxer\n";
+        return false;
+    }
+
+    return true;
+}
 
-        tmpfr->format = format;
-        tmpfr->width  = enc->width;
-        tmpfr->height = enc->height;
+// capture the frame at the center of the viewport; with the readback ring
+// the previous frames are handed over to the encoder once their transfers
+// have finished, so frame N is read back while frame N+1 renders
+bool FFMPEGCapturePrivate::captureFrame()
+{
+    if (failed)
+        return false;
+
+    int x, y, w, h;
+    renderer->getViewport(&x, &y, &w, &h);
+    x += (w - enc->width) / 2;
+    y += (h - enc->height) / 2;
 
-        // allocate the buffers for the frame data
-        if (av_frame_get_buffer(tmpfr, 32) < 0)
+    // created here as the GL context is current while rendering
+    if (readback == nullptr && useReadback)
+    {
+        readback = std::make_unique<FrameReadback>(*renderer, enc->width, enc->height,
+                                                   captureFormat);
+    }
+
+    if (readback == nullptr)
+    {
+        PixelBuffer pixels = acquireBuffer();
+        if (!renderer->captureFrame(x, y, enc->width, enc->height,
+                                    captureFormat,
+                                    pixels.get()))
         {
-            cout << "Failed to allocate temp frame buffer\n";
+            releaseBuffer(std::move(pixels));
             return false;
         }
+
+        submitFrame(std::move(pixels));
+        ++frameCount;
+        return true;
     }
 
-    // copy the stream parameters to the muxer
-    if (avcodec_parameters_from_context(st->codecpar, enc) < 0)
+    if (readback->isFull() && !retrieveFrame(true))
+        return false;
+    if (!readback->read(x, y))
+        return false;
+    ++frameCount;
+
+    while (readback->getPending() > 1 && retrieveFrame(false)) {}
+    return true;
+}
+
+// hand over the oldest frame of the readback ring to the encoder
+bool FFMPEGCapturePrivate::retrieveFrame(bool wait)
+{
+    PixelBuffer pixels = acquireBuffer();
+    if (!readback->retrieve(pixels.get(), wait))
     {
-        cout << "Failed to copy the stream parameters to the muxer\n";
+        releaseBuffer(std::move(pixels));
         return false;
     }
 
+    submitFrame(std::move(pixels));
     return true;
 }
 
-static void captureImage(AVFrame *pict, int width, int height, const Renderer *r)
+FFMPEGCapturePrivate::PixelBuffer FFMPEGCapturePrivate::acquireBuffer()
 {
-    int x, y, w, h;
-    r->getViewport(&x, &y, &w, &h);
+    std::unique_lock lock(mutex);
+    if (freeBuffers.empty() && allocatedBuffers < MaxBufferedFrames)
+    {
+        ++allocatedBuffers;
+        return PixelBuffer(new unsigned char[frameSize]);
+    }
 
-    x += (w - width) / 2;
-    y += (h - height) / 2;
-    r->captureFrame(x, y, width, height,
-                    r->getPreferredCaptureFormat(),
-                    pict->data[0]);
+    queueChanged.wait(lock, [this] { return !freeBuffers.empty(); });
+    PixelBuffer pixels = std::move(freeBuffers.back());
+    freeBuffers.pop_back();
+    return pixels;
 }
 
-// encode one video frame and send it to the muxer
-// return 1 when encoding is finished, 0 otherwise
-bool FFMPEGCapturePrivate::writeVideoFrame(bool finalize)
+void FFMPEGCapturePrivate::releaseBuffer(PixelBuffer&& pixels)
 {
-    AVFrame *frame = finalize ? nullptr : this->frame;
-    const int bytesPerPixel = hasAlpha ? 4 : 3;
+    {
+        std::scoped_lock lock(mutex);
+        freeBuffers.push_back(std::move(pixels));
+    }
+    queueChanged.notify_all();
+}
 
-    // check if we want to generate more frames
-    if (!finalize)
+void FFMPEGCapturePrivate::submitFrame(PixelBuffer&& pixels)
+{
     {
-        // when we pass a frame to the encoder, it may keep a reference to it
-        // internally; make sure we do not overwrite it here
-        if (av_frame_make_writable(frame) < 0)
-        {
-            cout << "Failed to make the frame writable\n";
-            return false;
-        }
+        std::scoped_lock lock(mutex);
+        queue.push_back(std::move(pixels));
+    }
+    queueChanged.notify_all();
+}
 
-        if (enc->pix_fmt != format)
-        {
-            captureImage(tmpfr, enc->width, enc->height, renderer);
-            // we need to compute the correct line width of our source data
-            const int linesize = bytesPerPixel * enc->width;
-            sws_scale(swsc, tmpfr->data, &linesize, 0, enc->height,
-                      frame->data, frame->linesize);
-        }
-        else
+// let the encoder thread finish the queued frames and wait for it
+void FFMPEGCapturePrivate::stopEncoder()
+{
+    if (!encoder.joinable())
+        return;
+
+    {
+        std::scoped_lock lock(mutex);
+        encoderStopped = true;
+    }
+    queueChanged.notify_all();
+    encoder.join();
+}
+
+void FFMPEGCapturePrivate::encodeFrames()
+{
+    util::Profiler::setThreadName("Encoder");
+    for (;;)
+    {
+        PixelBuffer pixels;
         {
-            captureImage(frame, enc->width, enc->height, renderer);
+            std::unique_lock lock(mutex);
+            queueChanged.wait(lock, [this] { return encoderStopped || !queue.empty(); });
+            if (queue.empty())
+                return;
+            pixels = std::move(queue.front());
+            queue.pop_front();
         }
 
-        frame->pts = nextPts++;
+        // after a failure, frames are only drained so that capturing doesn't
+        // wait forever for free buffers
+        if (!failed && !encodeFrame(pixels.get()))
+            failed = true;
+
+        releaseBuffer(std::move(pixels));
+    }
+}
+
+// convert one captured frame to the codec pixel format and encode it
+bool FFMPEGCapturePrivate::encodeFrame(const unsigned char* pixels)
+{
+    CELESTIA_PROFILE_ZONE("Encode frame");
+
+    // when we pass a frame to the encoder, it may keep a reference to it
+    // internally; make sure we do not overwrite it here
+    if (av_frame_make_writable(frame) < 0)
+    {
+        cout << "Failed to make the frame writable\n";
+        return false;
+    }
+
+    const int linesize = static_cast<int>(rowStride);
+    if (swsc != nullptr)
+    {
+        sws_scale(swsc, &pixels, &linesize, 0, enc->height,
+                  frame->data, frame->linesize);
+    }
+    else
+    {
+        const int bytesPerPixel = hasAlpha ? 4 : 3;
+        av_image_copy_plane(frame->data[0], frame->linesize[0], pixels, linesize,
+                            bytesPerPixel * enc->width, enc->height);
+    }
+
+    frame->pts = nextPts++;
+    if (hwFrame == nullptr)
+        return sendFrame(frame);
+
+#if HAVE_HW_ENCODERS
+    if (av_hwframe_get_buffer(hwFrames, hwFrame, 0) < 0 ||
+        av_hwframe_transfer_data(hwFrame, frame, 0) < 0)
+    {
+        cout << "Failed to upload the frame\n";
+        av_frame_unref(hwFrame);
+        return false;
     }
 
+    hwFrame->pts = frame->pts;
+    bool ok = sendFrame(hwFrame);
+    av_frame_unref(hwFrame);
+    return ok;
+#else
+    return false;
+#endif
+}
+
+// encode one video frame, or flush the encoder if fr is nullptr, and send
+// the packets to the muxer
+bool FFMPEGCapturePrivate::sendFrame(AVFrame *fr)
+{
 #if (LIBAVCODEC_VERSION_INT < AV_VERSION_INT(58, 133, 100))
     av_init_packet(pkt);
 #endif
 
     // encode the image
-    if (avcodec_send_frame(enc, frame) < 0)
+    if (avcodec_send_frame(enc, fr) < 0)
     {
         cout << "Failed to send the frame\n";
         return false;
@@ -487,7 +827,16 @@ bool FFMPEGCapturePrivate::writeVideoFrame(bool finalize)
 
 void FFMPEGCapturePrivate::finish()
 {
-    writeVideoFrame(true);
+    // the frames still in flight; reading them needs the GL context
+    if (readback != nullptr)
+    {
+        while (readback->getPending() > 0)
+            retrieveFrame(true);
+        readback.reset();
+    }
+
+    stopEncoder();
+    sendFrame(nullptr);
 
     // Write the trailer, if any. The trailer must be written before you
     // close the CodecContexts open when you wrote the header; otherwise
@@ -501,10 +850,13 @@ void FFMPEGCapturePrivate::finish()
 
 FFMPEGCapturePrivate::~FFMPEGCapturePrivate()
 {
+    stopEncoder();
+    sws_freeContext(swsc);
     avcodec_free_context(&enc);
     av_frame_free(&frame);
-    if (tmpfr != nullptr)
-        av_frame_free(&tmpfr);
+    av_frame_free(&hwFrame);
+    av_buffer_unref(&hwFrames);
+    av_buffer_unref(&hwDevice);
     avformat_free_context(oc);
     av_packet_free(&pkt);
 }
@@ -514,7 +866,8 @@ FFMPEGCapture::FFMPEGCapture(const Renderer *r) :
     d(new FFMPEGCapturePrivate)
 {
     d->renderer = r;
-    d->hasAlpha = r->getPreferredCaptureFormat() == engine::PixelFormat::RGBA;
+    d->captureFormat = r->getPreferredCaptureFormat();
+    d->hasAlpha = d->captureFormat == engine::PixelFormat::RGBA;
     d->format   = d->hasAlpha ? AV_PIX_FMT_RGBA : AV_PIX_FMT_RGB24;
 }
 
@@ -525,7 +878,7 @@ FFMPEGCapture::~FFMPEGCapture()
 
 int FFMPEGCapture::getFrameCount() const
 {
-    return d->nextPts;
+    return d->frameCount;
 }
 
 int FFMPEGCapture::getWidth() const
@@ -553,6 +906,8 @@ bool FFMPEGCapture::start(const fs::path& filename, int width, int height, float
         return false;
     }
 
+    d->useReadback = FrameReadback::isSupported();
+    d->encoder = std::thread(&FFMPEGCapturePrivate::encodeFrames, d);
     d->capturing = true; // XXX
 
     return true;
@@ -572,7 +927,7 @@ bool FFMPEGCapture::end()
 
 bool FFMPEGCapture::captureFrame()
 {
-    return d->capturing && d->writeVideoFrame();
+    return d->capturing && d->captureFrame();
 }
 
 void FFMPEGCapture::setVideoCodec(AVCodecID vc_id)
@@ -589,3 +944,27 @@ void FFMPEGCapture::setEncoderOptions(const std::string &s)
 {
     d->vc_options = s;
 }
+
+void FFMPEGCapture::setContainerFormat(const std::string &s)
+{
+    d->container = s;
+}
+
+void FFMPEGCapture::setHardwareEncoder(const std::string &encoder, const std::string &device)
+{
+    d->hwEncoder = encoder;
+    d->hwDeviceName = device;
+}
+
+std::vector<std::string> FFMPEGCapture::getHardwareEncoders([[maybe_unused]] AVCodecID vc_id)
+{
+    std::vector<std::string> encoders;
+#if HAVE_HW_ENCODERS
+    for (const auto& encoder : HardwareEncoders)
+    {
+        if (findHardwareCodec(vc_id, encoder) != nullptr)
+            encoders.emplace_back(encoder.name);
+    }
+#endif
+    return encoders;
+}
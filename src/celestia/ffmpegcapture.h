@@ -2,6 +2,7 @@
 
 #include <cstdint>
 #include <string>
+#include <vector>
 
 extern "C"
 {
@@ -35,6 +36,17 @@ public:
     void setVideoCodec(AVCodecID);
     void setBitRate(std::int64_t);
     void setEncoderOptions(const std::string&);
+    // The FFmpeg muxer of the output, matroska by default. Streaming to a
+    // udp:// or rtp:// URL needs a streamable one, such as mpegts or
+    // rtp_mpegts.
+    void setContainerFormat(const std::string&);
+    // Encode with a hardware encoder, one of getHardwareEncoders(), on the
+    // given device or the default one if it's empty. An empty encoder
+    // selects the software encoder.
+    void setHardwareEncoder(const std::string& encoder, const std::string& device = {});
+
+    // The hardware encoders of a codec supported by the FFmpeg libraries
+    static std::vector<std::string> getHardwareEncoders(AVCodecID);
 
 protected:
     void recordingStatusUpdated(bool) override { /* no action necessary */ };
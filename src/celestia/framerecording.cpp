@@ -0,0 +1,102 @@
+// framerecording.cpp
+//
+// Copyright (C) 2026, the Celestia Development Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include "framerecording.h"
+
+#include <istream>
+#include <ostream>
+#include <sstream>
+
+#include <fmt/format.h>
+
+#include <celutil/logger.h>
+
+using namespace std::string_view_literals;
+
+using celestia::util::GetLogger;
+
+namespace celestia
+{
+
+namespace
+{
+
+constexpr std::string_view FrameRecordingHeader = "# Celestia frame recording 1"sv;
+
+} // end unnamed namespace
+
+bool
+WriteFrameRecordingHeader(std::ostream& out)
+{
+    out << FrameRecordingHeader << '\n';
+    return out.good();
+}
+
+void
+WriteRecordedFrame(std::ostream& out, const RecordedFrame& frame)
+{
+    // URLs are encoded, so they hold no spaces or line breaks
+    out << fmt::format("{:.6f} {} {} {}\n", frame.elapsed, frame.width, frame.height, frame.url);
+}
+
+bool
+ReadFrameRecording(std::istream& in, std::vector<RecordedFrame>& frames)
+{
+    std::string line;
+    if (!std::getline(in, line) || line != FrameRecordingHeader)
+        return false;
+
+    while (std::getline(in, line))
+    {
+        if (line.empty())
+            continue;
+
+        std::istringstream fields(line);
+        RecordedFrame& frame = frames.emplace_back();
+        if (!(fields >> frame.elapsed >> frame.width >> frame.height >> frame.url) ||
+            frame.width <= 0 || frame.height <= 0)
+        {
+            frames.pop_back();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool
+ReadFrameRecording(const fs::path& path, std::vector<RecordedFrame>& frames)
+{
+    std::ifstream in(path, std::ios::in);
+    return in.good() && ReadFrameRecording(in, frames);
+}
+
+std::unique_ptr<FrameRecorder>
+FrameRecorder::create(const fs::path& path)
+{
+    std::unique_ptr<FrameRecorder> recorder(new FrameRecorder());
+    recorder->m_out.open(path, std::ios::out | std::ios::trunc);
+    if (!recorder->m_out.good() || !WriteFrameRecordingHeader(recorder->m_out))
+    {
+        GetLogger()->error("Error creating frame recording {}\n", path);
+        return nullptr;
+    }
+
+    return recorder;
+}
+
+void
+FrameRecorder::record(double time, int width, int height, std::string_view url)
+{
+    double elapsed = m_lastTime.has_value() ? time - *m_lastTime : 0.0;
+    m_lastTime = time;
+    WriteRecordedFrame(m_out, { elapsed, width, height, std::string(url) });
+}
+
+} // end namespace celestia
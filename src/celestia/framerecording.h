@@ -0,0 +1,62 @@
+// framerecording.h
+//
+// Copyright (C) 2026, the Celestia Development Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <fstream>
+#include <iosfwd>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <celcompat/filesystem.h>
+
+namespace celestia
+{
+
+// The state a frame was drawn from: the cel URL of the active view holds
+// the simulation time, the observer frame, position and orientation, the
+// selection and the render and label flags.
+struct RecordedFrame
+{
+    // Seconds of system time since the previous recorded frame
+    double elapsed{ 0.0 };
+    int width{ 0 };
+    int height{ 0 };
+    std::string url;
+};
+
+// A frame recording is a text file which starts with a header line and
+// holds one line per frame: the elapsed time, the window size and the URL,
+// separated by spaces.
+bool WriteFrameRecordingHeader(std::ostream&);
+void WriteRecordedFrame(std::ostream&, const RecordedFrame&);
+bool ReadFrameRecording(std::istream&, std::vector<RecordedFrame>&);
+bool ReadFrameRecording(const fs::path&, std::vector<RecordedFrame>&);
+
+// Writes the frames of a session to a recording, so that a slow session
+// can be replayed with celestia-bench.
+class FrameRecorder
+{
+public:
+    static std::unique_ptr<FrameRecorder> create(const fs::path&);
+
+    // Record a frame drawn at the given system time, in seconds
+    void record(double time, int width, int height, std::string_view url);
+
+private:
+    FrameRecorder() = default;
+
+    std::ofstream m_out;
+    std::optional<double> m_lastTime;
+};
+
+} // end namespace celestia
@@ -0,0 +1,97 @@
+// framescheduler.cpp
+//
+// Copyright (C) 2025, the Celestia Development Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include "framescheduler.h"
+
+#include <algorithm>
+
+#include <celengine/framestats.h>
+
+namespace celestia
+{
+
+namespace
+{
+
+// Time kept free before the refresh for the swap and variations of the
+// frame duration
+constexpr auto SafetyMargin = std::chrono::milliseconds(2);
+
+template<typename T>
+void
+mergeOldest(std::optional<T>& oldest, const std::optional<T>& time)
+{
+    if (time.has_value() && (!oldest.has_value() || *time < *oldest))
+        oldest = time;
+}
+
+} // end unnamed namespace
+
+void
+FrameScheduler::setRefreshRate(double rate)
+{
+    m_refreshInterval = rate > 0.0
+        ? std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(1.0 / rate))
+        : clock::duration::zero();
+}
+
+void
+FrameScheduler::inputReceived(clock::time_point time)
+{
+    mergeOldest(m_pendingInput, std::optional(time));
+}
+
+FrameScheduler::clock::duration
+FrameScheduler::getStartDelay(clock::time_point now) const
+{
+    if (!m_lowLatency || m_refreshInterval == clock::duration::zero())
+        return clock::duration::zero();
+
+    auto start = m_lastPresent + m_refreshInterval - m_frameDuration - SafetyMargin;
+    return std::max(start - now, clock::duration::zero());
+}
+
+void
+FrameScheduler::beginFrame(clock::time_point time)
+{
+    m_frameStart = time;
+    latchInput();
+}
+
+void
+FrameScheduler::latchInput()
+{
+    mergeOldest(m_frameInput, m_pendingInput);
+    m_pendingInput.reset();
+}
+
+void
+FrameScheduler::endFrame(clock::time_point time)
+{
+    // The duration adapts over about ten frames, so that a single slow frame
+    // doesn't delay the following ones much
+    auto duration = time - m_frameStart;
+    if (m_frameDuration == clock::duration::zero())
+        m_frameDuration = duration;
+    else
+        m_frameDuration += (duration - m_frameDuration) / 10;
+}
+
+void
+FrameScheduler::framePresented(clock::time_point time)
+{
+    m_lastPresent = time;
+    if (!m_frameInput.has_value())
+        return;
+
+    engine::GetFrameStats()->addInputLatency(time - *m_frameInput);
+    m_frameInput.reset();
+}
+
+} // end namespace celestia
@@ -0,0 +1,64 @@
+// framescheduler.h
+//
+// Copyright (C) 2025, the Celestia Development Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <chrono>
+#include <optional>
+
+namespace celestia
+{
+
+// Schedules the frames of an interactive front end to keep the delay
+// between input and the frame showing it short. The front end reports the
+// input events as they arrive and the steps of each frame:
+//
+//   wait for getStartDelay() after the last present
+//   process the input events, then beginFrame() and tick
+//   process the input events which arrived during the tick again, so the
+//     camera follows them in this frame, then latchInput() and draw
+//   endFrame(), swap the buffers, and in low latency mode wait for the GPU
+//   framePresented()
+//
+// framePresented() adds the time from the oldest input event shown to the
+// frame stats. The start delay is only used in low latency mode, where it
+// makes the frame start as late as its measured duration allows before the
+// next refresh of the display, instead of right after the previous one.
+class FrameScheduler
+{
+public:
+    using clock = std::chrono::steady_clock;
+
+    void setLowLatency(bool lowLatency) { m_lowLatency = lowLatency; }
+    bool isLowLatency() const { return m_lowLatency; }
+
+    // The refresh rate of the display in Hz, zero when unknown
+    void setRefreshRate(double);
+
+    void inputReceived(clock::time_point = clock::now());
+
+    clock::duration getStartDelay(clock::time_point = clock::now()) const;
+
+    void beginFrame(clock::time_point = clock::now());
+    void latchInput();
+    void endFrame(clock::time_point = clock::now());
+    void framePresented(clock::time_point = clock::now());
+
+private:
+    std::optional<clock::time_point> m_pendingInput;
+    std::optional<clock::time_point> m_frameInput;
+    clock::time_point m_frameStart;
+    clock::time_point m_lastPresent;
+    clock::duration m_refreshInterval{ clock::duration::zero() };
+    // Smoothed time from beginFrame to endFrame
+    clock::duration m_frameDuration{ clock::duration::zero() };
+    bool m_lowLatency{ false };
+};
+
+} // end namespace celestia
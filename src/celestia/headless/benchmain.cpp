@@ -0,0 +1,602 @@
+// benchmain.cpp
+//
+// Copyright (C) 2025-present, the Celestia Development Team
+//
+// Measure the frame timings of scripts and views rendered with the headless
+// front end, and write them as a JSON report.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+#include <fmt/format.h>
+
+#include <celengine/framestats.h>
+#include <celengine/glsupport.h>
+#include <celengine/texmanager.h>
+#include <celestia/celestiacore.h>
+#include <celestia/framerecording.h>
+#include <celestia/startupprofile.h>
+#include <celutil/gettext.h>
+#include "headlessapp.h"
+
+namespace engine = celestia::engine;
+namespace headless = celestia::headless;
+
+using namespace std::string_view_literals;
+
+namespace
+{
+
+struct CommandLine
+{
+    headless::HeadlessOptions options;
+    fs::path dataDir;
+    // Scripts, or cel:// URLs
+    std::vector<std::string> runs;
+    unsigned int warmupFrames{ 30 };
+    // Frames measured at a URL, and the limit for scripts
+    unsigned int frames{ 600 };
+    fs::path output;
+};
+
+// The samples of one quantity, one per frame
+using Samples = std::vector<double>;
+
+struct RunResult
+{
+    std::string name;
+    std::string source;
+    Samples frameTimes;
+    // Times of the frames of a recording in the session it was made in
+    Samples recordedTimes;
+    std::array<Samples, engine::FrameStageCount> stageTimes;
+    Samples gpuTimes;
+    std::array<Samples, engine::GPUStageCount> gpuStageTimes;
+    double drawCalls{ 0.0 };
+    double starsProcessed{ 0.0 };
+    double dsosProcessed{ 0.0 };
+    double renderListSize{ 0.0 };
+    double textureUploads{ 0.0 };
+    bool scriptFinished{ true };
+    std::optional<long> peakRSS;
+    std::size_t textureMemory{ 0 };
+};
+
+void
+usage()
+{
+    std::cerr << "Usage: celestia-bench [options] <script, cel:// URL or frame recording>...\n"
+                 "  --dir <directory>       data directory\n"
+                 "  --conf <file>           configuration file\n"
+                 "  --extrasdir <directory> additional extras directory\n"
+                 "  --size <width>x<height> frame size, 1920x1080 by default\n"
+                 "  --fps <rate>            frames per simulated second, 30 by default\n"
+                 "  --device <index>        EGL device to render on\n"
+                 "  --warmup <count>        frames rendered at a URL before measuring, 30 by\n"
+                 "                          default\n"
+                 "  --frames <count>        frames measured at a URL, and at most for a\n"
+                 "                          script, 600 by default\n"
+                 "  --output <file>         JSON report, written to stdout by default\n"
+                 "Scripts are CEL or CELX scripts, measured from their start until they\n"
+                 "finish. Frame recordings (.celrec) written with FrameRecording are\n"
+                 "replayed frame by frame at their window size. Frame times include\n"
+                 "waiting for the GPU to finish the frame.\n";
+}
+
+bool
+parseCount(const char* arg, unsigned int& value)
+{
+    char* end;
+    unsigned long result = std::strtoul(arg, &end, 10);
+    if (end == arg || *end != '\0' || result > std::numeric_limits<unsigned int>::max())
+        return false;
+
+    value = static_cast<unsigned int>(result);
+    return true;
+}
+
+bool
+parseCommandLine(int argc, char* argv[], CommandLine& commandLine)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        std::string_view arg = argv[i];
+        if (arg.size() < 2 || arg.substr(0, 2) != "--"sv)
+        {
+            commandLine.runs.emplace_back(arg);
+            continue;
+        }
+
+        if (i + 1 == argc)
+        {
+            std::cerr << "Missing value for " << arg << '\n';
+            return false;
+        }
+
+        const char* value = argv[++i];
+        if (arg == "--dir"sv)
+        {
+            commandLine.dataDir = fs::u8path(value);
+        }
+        else if (arg == "--conf"sv)
+        {
+            commandLine.options.configFile = fs::u8path(value);
+        }
+        else if (arg == "--extrasdir"sv)
+        {
+            commandLine.options.extrasDirs.push_back(fs::u8path(value));
+        }
+        else if (arg == "--size"sv)
+        {
+            if (std::sscanf(value, "%dx%d", &commandLine.options.width, &commandLine.options.height) != 2 || // NOSONAR
+                commandLine.options.width <= 0 || commandLine.options.height <= 0)
+            {
+                std::cerr << "Invalid frame size: " << value << '\n';
+                return false;
+            }
+        }
+        else if (arg == "--fps"sv)
+        {
+            double fps = std::atof(value);
+            if (fps <= 0.0)
+            {
+                std::cerr << "Invalid frame rate: " << value << '\n';
+                return false;
+            }
+            commandLine.options.timeStep = 1.0 / fps;
+        }
+        else if (arg == "--device"sv)
+        {
+            commandLine.options.device = std::atoi(value);
+        }
+        else if (arg == "--warmup"sv)
+        {
+            if (!parseCount(value, commandLine.warmupFrames))
+                return false;
+        }
+        else if (arg == "--frames"sv)
+        {
+            if (!parseCount(value, commandLine.frames) || commandLine.frames == 0)
+                return false;
+        }
+        else if (arg == "--output"sv)
+        {
+            commandLine.output = fs::u8path(value);
+        }
+        else
+        {
+            std::cerr << "Unknown command line switch: " << arg << '\n';
+            return false;
+        }
+    }
+
+    return !commandLine.runs.empty();
+}
+
+// Peak resident set size of the process in kilobytes
+std::optional<long>
+getPeakRSS()
+{
+#ifdef _WIN32
+    return std::nullopt;
+#else
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return std::nullopt;
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+#endif
+}
+
+double
+toMilliseconds(std::chrono::steady_clock::duration duration)
+{
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+// Render one frame and add its timings and counters
+void
+measureFrame(headless::HeadlessApp& app, RunResult& result, bool atCurrentTime = false)
+{
+    auto start = std::chrono::steady_clock::now();
+    if (atCurrentTime)
+        app.renderFrameAtCurrentTime();
+    else
+        app.renderFrame();
+    glFinish();
+    result.frameTimes.push_back(toMilliseconds(std::chrono::steady_clock::now() - start));
+
+    const engine::FrameCounters& counters = engine::GetFrameStats()->current();
+    for (std::size_t i = 0; i < engine::FrameStageCount; ++i)
+        result.stageTimes[i].push_back(counters.stageTimes[i]);
+    if (counters.gpuTime.has_value())
+        result.gpuTimes.push_back(*counters.gpuTime);
+    if (counters.gpuStageTimes.has_value())
+    {
+        for (std::size_t i = 0; i < engine::GPUStageCount; ++i)
+            result.gpuStageTimes[i].push_back((*counters.gpuStageTimes)[i]);
+    }
+
+    result.drawCalls += counters.drawCalls;
+    result.starsProcessed += counters.starsProcessed;
+    result.dsosProcessed += counters.dsosProcessed;
+    result.renderListSize += counters.renderListSize;
+    result.textureUploads += counters.textureUploads;
+}
+
+RunResult
+runURL(headless::HeadlessApp& app, const std::string& url, const CommandLine& commandLine)
+{
+    RunResult result;
+    result.source = url;
+
+    CelestiaCore* appCore = app.getCore();
+    if (!appCore->goToUrl(url))
+    {
+        std::cerr << "Invalid URL: " << url << '\n';
+        result.scriptFinished = false;
+        return result;
+    }
+
+    for (unsigned int i = 0; i < commandLine.warmupFrames; ++i)
+        app.renderFrame();
+    glFinish();
+
+    for (unsigned int i = 0; i < commandLine.frames; ++i)
+        measureFrame(app, result);
+
+    return result;
+}
+
+// Scripts are measured from their first frame, the views they show are
+// part of the benchmark
+RunResult
+runScript(headless::HeadlessApp& app, const fs::path& script, const CommandLine& commandLine)
+{
+    RunResult result;
+    result.source = script.u8string();
+
+    CelestiaCore* appCore = app.getCore();
+    appCore->runScript(script);
+    glFinish();
+    for (unsigned int i = 0; i < commandLine.frames && appCore->isScriptRunning(); ++i)
+        measureFrame(app, result);
+
+    result.scriptFinished = !appCore->isScriptRunning();
+    if (!result.scriptFinished)
+        appCore->cancelScript();
+
+    return result;
+}
+
+// Frames of a recording are drawn from their state, the simulation time
+// doesn't advance between them. The recording is played once to load the
+// resources it needs before it is measured.
+RunResult
+runRecording(headless::HeadlessApp& app, const fs::path& recording, const CommandLine& commandLine)
+{
+    RunResult result;
+    result.source = recording.u8string();
+
+    std::vector<celestia::RecordedFrame> frames;
+    if (!celestia::ReadFrameRecording(recording, frames) || frames.empty())
+    {
+        std::cerr << "Invalid frame recording: " << result.source << '\n';
+        result.scriptFinished = false;
+        return result;
+    }
+
+    CelestiaCore* appCore = app.getCore();
+    int width = app.getWidth();
+    int height = app.getHeight();
+    auto playFrame = [&](const celestia::RecordedFrame& frame)
+    {
+        return app.resize(frame.width, frame.height) && appCore->goToUrl(frame.url);
+    };
+
+    for (std::size_t i = 0; i < frames.size() && i < commandLine.warmupFrames; ++i)
+    {
+        if (playFrame(frames[i]))
+            app.renderFrameAtCurrentTime();
+    }
+    glFinish();
+
+    for (const celestia::RecordedFrame& frame : frames)
+    {
+        if (!playFrame(frame))
+        {
+            result.scriptFinished = false;
+            break;
+        }
+
+        measureFrame(app, result, true);
+        result.recordedTimes.push_back(frame.elapsed * 1000.0);
+    }
+
+    app.resize(width, height);
+    return result;
+}
+
+void
+appendString(std::string& out, std::string_view str)
+{
+    out.push_back('"');
+    for (char c : str)
+    {
+        switch (c)
+        {
+        case '"':
+            out.append("\\\""sv);
+            break;
+        case '\\':
+            out.append("\\\\"sv);
+            break;
+        case '\n':
+            out.append("\\n"sv);
+            break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20)
+                fmt::format_to(std::back_inserter(out), "\\u{:04x}", static_cast<unsigned int>(c));
+            else
+                out.push_back(c);
+            break;
+        }
+    }
+    out.push_back('"');
+}
+
+// Mean and nearest rank percentiles
+void
+appendDistribution(std::string& out, Samples samples)
+{
+    if (samples.empty())
+    {
+        out.append("null"sv);
+        return;
+    }
+
+    std::sort(samples.begin(), samples.end());
+    double sum = 0.0;
+    for (double sample : samples)
+        sum += sample;
+
+    auto percentile = [&samples](double p)
+    {
+        auto rank = static_cast<std::size_t>(p * static_cast<double>(samples.size() - 1) + 0.5);
+        return samples[rank];
+    };
+
+    fmt::format_to(std::back_inserter(out),
+                   "{{\"mean\": {:.3f}, \"p50\": {:.3f}, \"p90\": {:.3f}, \"p95\": {:.3f}, "
+                   "\"p99\": {:.3f}, \"max\": {:.3f}}}",
+                   sum / static_cast<double>(samples.size()),
+                   percentile(0.5), percentile(0.9), percentile(0.95), percentile(0.99),
+                   samples.back());
+}
+
+void
+appendLoad(std::string& out, double loadTime, const celestia::StartupProfile* profile)
+{
+    fmt::format_to(std::back_inserter(out), "  \"load\": {{\"totalMs\": {:.3f}, \"phases\": [", loadTime);
+    if (profile != nullptr)
+    {
+        bool first = true;
+        for (const auto& record : profile->records())
+        {
+            // The catalogs are nested in the phases
+            if (record.depth != 0)
+                continue;
+
+            out.append(first ? "\n    {\"name\": "sv : ",\n    {\"name\": "sv);
+            appendString(out, record.name);
+            fmt::format_to(std::back_inserter(out),
+                           ", \"wallMs\": {:.3f}, \"cpuMs\": {:.3f}}}",
+                           toMilliseconds(record.wallTime), toMilliseconds(record.cpuTime));
+            first = false;
+        }
+    }
+    out.append("]},\n"sv);
+}
+
+void
+appendRun(std::string& out, const RunResult& result)
+{
+    auto frames = static_cast<double>(std::max(result.frameTimes.size(), std::size_t(1)));
+
+    out.append("    {\"name\": "sv);
+    appendString(out, result.name);
+    out.append(", \"source\": "sv);
+    appendString(out, result.source);
+    fmt::format_to(std::back_inserter(out), ", \"frames\": {}, \"completed\": {},\n",
+                   result.frameTimes.size(), result.scriptFinished);
+
+    out.append("     \"frameMs\": "sv);
+    appendDistribution(out, result.frameTimes);
+    if (!result.recordedTimes.empty())
+    {
+        out.append(",\n     \"recordedFrameMs\": "sv);
+        appendDistribution(out, result.recordedTimes);
+    }
+    out.append(",\n     \"gpuMs\": "sv);
+    appendDistribution(out, result.gpuTimes);
+    out.append(",\n     \"stageMs\": {"sv);
+    for (std::size_t i = 0; i < engine::FrameStageCount; ++i)
+    {
+        out.append(i == 0 ? "\n      "sv : ",\n      "sv);
+        appendString(out, engine::GetFrameStageName(static_cast<engine::FrameStage>(i)));
+        out.append(": "sv);
+        appendDistribution(out, result.stageTimes[i]);
+    }
+    out.append("},\n     \"gpuStageMs\": {"sv);
+    for (std::size_t i = 0; i < engine::GPUStageCount; ++i)
+    {
+        out.append(i == 0 ? "\n      "sv : ",\n      "sv);
+        appendString(out, engine::GetGPUStageName(static_cast<engine::GPUStage>(i)));
+        out.append(": "sv);
+        appendDistribution(out, result.gpuStageTimes[i]);
+    }
+
+    fmt::format_to(std::back_inserter(out),
+                   "}},\n     \"perFrame\": {{\"drawCalls\": {:.1f}, \"starsProcessed\": {:.1f}, "
+                   "\"dsosProcessed\": {:.1f}, \"renderListSize\": {:.1f}, \"textureUploads\": {:.2f}}},\n",
+                   result.drawCalls / frames, result.starsProcessed / frames,
+                   result.dsosProcessed / frames, result.renderListSize / frames,
+                   result.textureUploads / frames);
+
+    out.append("     \"peakRssKiB\": "sv);
+    out.append(result.peakRSS.has_value() ? std::to_string(*result.peakRSS) : std::string("null"));
+    fmt::format_to(std::back_inserter(out), ", \"textureMemoryBytes\": {}}}", result.textureMemory);
+}
+
+bool
+isURL(std::string_view run)
+{
+    return run.substr(0, 6) == "cel://"sv;
+}
+
+bool
+isRecording(std::string_view run)
+{
+    return run.size() > 7 && run.substr(run.size() - 7) == ".celrec"sv;
+}
+
+} // end unnamed namespace
+
+int
+main(int argc, char* argv[])
+{
+    CelestiaCore::initLocale();
+
+#ifdef ENABLE_NLS
+    bindtextdomain("celestia", LOCALEDIR);
+    bind_textdomain_codeset("celestia", "UTF-8");
+    bindtextdomain("celestia-data", LOCALEDIR);
+    bind_textdomain_codeset("celestia-data", "UTF-8");
+    textdomain("celestia");
+#endif
+
+    CommandLine commandLine;
+    if (!parseCommandLine(argc, argv, commandLine))
+    {
+        usage();
+        return EXIT_FAILURE;
+    }
+
+    // Scripts are named relative to the current directory
+    std::error_code ec;
+    const fs::path currentDir = fs::current_path(ec);
+    for (std::string& run : commandLine.runs)
+    {
+        if (fs::path runPath = fs::u8path(run); !isURL(run) && !runPath.is_absolute())
+            run = (currentDir / runPath).u8string();
+    }
+
+    if (commandLine.dataDir.empty())
+    {
+        if (const char* dataDirEnv = std::getenv("CELESTIA_DATA_DIR"); dataDirEnv == nullptr)
+            commandLine.dataDir = CONFIG_DATA_DIR;
+        else
+            commandLine.dataDir = dataDirEnv;
+    }
+
+    fs::path output = commandLine.output.empty() || commandLine.output.is_absolute()
+        ? commandLine.output
+        : currentDir / commandLine.output;
+    fs::current_path(commandLine.dataDir, ec);
+    if (ec)
+    {
+        std::cerr << "Cannot change to the data directory " << commandLine.dataDir << '\n';
+        return EXIT_FAILURE;
+    }
+
+    commandLine.options.keepStartupProfile = true;
+    auto loadStart = std::chrono::steady_clock::now();
+    auto app = headless::HeadlessApp::create(commandLine.options);
+    if (app == nullptr)
+        return EXIT_FAILURE;
+    double loadTime = toMilliseconds(std::chrono::steady_clock::now() - loadStart);
+
+    auto glString = [](GLenum name)
+    {
+        const auto* str = reinterpret_cast<const char*>(glGetString(name));
+        return std::string_view(str == nullptr ? "" : str);
+    };
+
+    std::string report("{\n  \"renderer\": {\"vendor\": ");
+    appendString(report, glString(GL_VENDOR));
+    report.append(", \"renderer\": "sv);
+    appendString(report, glString(GL_RENDERER));
+    report.append(", \"version\": "sv);
+    appendString(report, glString(GL_VERSION));
+    fmt::format_to(std::back_inserter(report),
+                   ", \"width\": {}, \"height\": {}, \"timeStep\": {}}},\n",
+                   app->getWidth(), app->getHeight(), app->getTimeStep());
+    appendLoad(report, loadTime, app->getCore()->getStartupProfile());
+    report.append("  \"runs\": ["sv);
+
+    bool ok = true;
+    for (std::size_t i = 0; i < commandLine.runs.size(); ++i)
+    {
+        const std::string& run = commandLine.runs[i];
+        RunResult result;
+        if (isURL(run))
+            result = runURL(*app, run, commandLine);
+        else if (isRecording(run))
+            result = runRecording(*app, fs::u8path(run), commandLine);
+        else
+            result = runScript(*app, fs::u8path(run), commandLine);
+        result.name = isURL(run) ? fmt::format("url{}", i + 1) : fs::u8path(run).stem().u8string();
+        result.peakRSS = getPeakRSS();
+        result.textureMemory = GetTextureManager()->getMemoryUsage();
+        ok = ok && !result.frameTimes.empty();
+
+        report.append(i == 0 ? "\n"sv : ",\n"sv);
+        appendRun(report, result);
+
+        std::cerr << result.name << ": " << result.frameTimes.size() << " frames\n";
+    }
+    report.append("\n  ]\n}\n"sv);
+
+    if (output.empty())
+    {
+        std::cout << report;
+    }
+    else
+    {
+        std::ofstream out(output, std::ios::out | std::ios::trunc);
+        out << report;
+        if (!out.flush().good())
+        {
+            std::cerr << "Error writing " << output << '\n';
+            return EXIT_FAILURE;
+        }
+    }
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
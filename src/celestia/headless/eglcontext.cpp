@@ -0,0 +1,150 @@
+// eglcontext.cpp
+//
+// Copyright (C) 2025-present, the Celestia Development Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include "eglcontext.h"
+
+#include <array>
+
+#include <celutil/logger.h>
+
+using celestia::util::GetLogger;
+
+namespace celestia::headless
+{
+
+namespace
+{
+
+constexpr EGLint MaxDevices = 16;
+
+EGLDisplay
+getDisplay(int device)
+{
+    if (device < 0)
+        return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+    if (!epoxy_has_egl_extension(EGL_NO_DISPLAY, "EGL_EXT_device_enumeration") ||
+        !epoxy_has_egl_extension(EGL_NO_DISPLAY, "EGL_EXT_platform_device"))
+    {
+        GetLogger()->warn("EGL devices can't be enumerated, using the default display\n");
+        return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+
+    std::array<EGLDeviceEXT, MaxDevices> devices;
+    EGLint count = 0;
+    if (!eglQueryDevicesEXT(MaxDevices, devices.data(), &count) || device >= count)
+    {
+        GetLogger()->error("EGL device {} not found\n", device);
+        return EGL_NO_DISPLAY;
+    }
+
+    return eglGetPlatformDisplayEXT(EGL_PLATFORM_DEVICE_EXT, devices[device], nullptr);
+}
+
+} // end unnamed namespace
+
+EGLOffscreenContext::~EGLOffscreenContext()
+{
+    if (m_display == EGL_NO_DISPLAY)
+        return;
+
+    eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (m_surface != EGL_NO_SURFACE)
+        eglDestroySurface(m_display, m_surface);
+    if (m_context != EGL_NO_CONTEXT)
+        eglDestroyContext(m_display, m_context);
+    eglTerminate(m_display);
+}
+
+std::unique_ptr<EGLOffscreenContext>
+EGLOffscreenContext::create(int width, int height, int device)
+{
+    auto context = std::make_unique<EGLOffscreenContext>(Private{});
+
+    context->m_display = getDisplay(device);
+    if (context->m_display == EGL_NO_DISPLAY)
+        return nullptr;
+
+    EGLint major;
+    EGLint minor;
+    if (!eglInitialize(context->m_display, &major, &minor))
+    {
+        GetLogger()->error("Failed to initialize EGL\n");
+        context->m_display = EGL_NO_DISPLAY;
+        return nullptr;
+    }
+
+    const bool surfaceless = epoxy_has_egl_extension(context->m_display, "EGL_KHR_surfaceless_context");
+
+    const std::array<EGLint, 15> configAttributes
+    {
+        EGL_SURFACE_TYPE, surfaceless ? 0 : EGL_PBUFFER_BIT,
+#ifdef GL_ES
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT,
+#else
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+#endif
+        EGL_RED_SIZE, 8,
+        EGL_GREEN_SIZE, 8,
+        EGL_BLUE_SIZE, 8,
+        EGL_DEPTH_SIZE, 24,
+        EGL_NONE,
+    };
+
+    EGLConfig config;
+    EGLint count = 0;
+    if (!eglChooseConfig(context->m_display, configAttributes.data(), &config, 1, &count) || count == 0)
+    {
+        GetLogger()->error("No suitable EGL configuration\n");
+        return nullptr;
+    }
+
+#ifdef GL_ES
+    eglBindAPI(EGL_OPENGL_ES_API);
+    const std::array<EGLint, 3> contextAttributes{ EGL_CONTEXT_CLIENT_VERSION, 2, EGL_NONE };
+#else
+    // Like the other front ends, a compatibility context is used
+    eglBindAPI(EGL_OPENGL_API);
+    const std::array<EGLint, 1> contextAttributes{ EGL_NONE };
+#endif
+
+    context->m_context = eglCreateContext(context->m_display, config, EGL_NO_CONTEXT, contextAttributes.data());
+    if (context->m_context == EGL_NO_CONTEXT)
+    {
+        GetLogger()->error("Failed to create an EGL context\n");
+        return nullptr;
+    }
+
+    if (!surfaceless)
+    {
+        const std::array<EGLint, 5> surfaceAttributes{ EGL_WIDTH, width, EGL_HEIGHT, height, EGL_NONE };
+        context->m_surface = eglCreatePbufferSurface(context->m_display, config, surfaceAttributes.data());
+        if (context->m_surface == EGL_NO_SURFACE)
+        {
+            GetLogger()->error("Failed to create an EGL pbuffer surface\n");
+            return nullptr;
+        }
+    }
+
+    if (!context->makeCurrent())
+    {
+        GetLogger()->error("Failed to make the EGL context current\n");
+        return nullptr;
+    }
+
+    return context;
+}
+
+bool
+EGLOffscreenContext::makeCurrent() const
+{
+    return eglMakeCurrent(m_display, m_surface, m_surface, m_context) == EGL_TRUE;
+}
+
+} // end namespace celestia::headless
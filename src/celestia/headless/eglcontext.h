@@ -0,0 +1,49 @@
+// eglcontext.h
+//
+// Copyright (C) 2025-present, the Celestia Development Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <memory>
+
+#include <epoxy/egl.h>
+
+namespace celestia::headless
+{
+
+// An EGL context without any window. It is made current without a surface
+// when EGL_KHR_surfaceless_context is supported, otherwise with a pbuffer
+// surface of the requested size. Rendering is meant to go to a framebuffer
+// object in either case.
+class EGLOffscreenContext //NOSONAR
+{
+    struct Private { explicit Private() = default; };
+
+public:
+    explicit EGLOffscreenContext(Private) {}
+    ~EGLOffscreenContext();
+
+    EGLOffscreenContext(const EGLOffscreenContext&) = delete;
+    EGLOffscreenContext& operator=(const EGLOffscreenContext&) = delete;
+    EGLOffscreenContext(EGLOffscreenContext&&) = delete;
+    EGLOffscreenContext& operator=(EGLOffscreenContext&&) = delete;
+
+    // Create a context on the device with the given index, as enumerated by
+    // EGL_EXT_device_enumeration, or on the default display if device is
+    // negative or devices can't be enumerated
+    static std::unique_ptr<EGLOffscreenContext> create(int width, int height, int device = -1);
+
+    bool makeCurrent() const;
+
+private:
+    EGLDisplay m_display{ EGL_NO_DISPLAY };
+    EGLContext m_context{ EGL_NO_CONTEXT };
+    EGLSurface m_surface{ EGL_NO_SURFACE };
+};
+
+} // end namespace celestia::headless
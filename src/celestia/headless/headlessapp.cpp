@@ -0,0 +1,202 @@
+// headlessapp.cpp
+//
+// Copyright (C) 2025-present, the Celestia Development Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include "headlessapp.h"
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include <celengine/framebuffer.h>
+#include <celengine/glsupport.h>
+#include <celengine/meshmanager.h>
+#include <celengine/render.h>
+#include <celengine/texmanager.h>
+#include <celestia/celestiacore.h>
+#include <celestia/configfile.h>
+#include <celutil/logger.h>
+#include "eglcontext.h"
+
+using celestia::util::GetLogger;
+
+namespace celestia::headless
+{
+
+namespace
+{
+
+class LogAlerter : public CelestiaCore::Alerter
+{
+public:
+    void fatalError(const std::string& msg) override
+    {
+        GetLogger()->error("{}\n", msg);
+    }
+};
+
+LogAlerter alerter;
+
+} // end unnamed namespace
+
+HeadlessApp::HeadlessApp(Private)
+{
+}
+
+// The core and the framebuffer hold GL objects, so they go before the context
+HeadlessApp::~HeadlessApp()
+{
+    m_appCore.reset();
+    m_framebuffer.reset();
+}
+
+std::unique_ptr<HeadlessApp>
+HeadlessApp::create(const HeadlessOptions& options)
+{
+    auto app = std::make_unique<HeadlessApp>(Private{});
+    app->m_width = options.width;
+    app->m_height = options.height;
+    app->m_timeStep = options.timeStep;
+
+    app->m_context = EGLOffscreenContext::create(options.width, options.height, options.device);
+    if (app->m_context == nullptr)
+        return nullptr;
+
+    app->m_appCore = std::make_unique<CelestiaCore>();
+    CelestiaCore* appCore = app->m_appCore.get();
+    appCore->setAlerter(&alerter);
+    appCore->setKeepStartupProfile(options.keepStartupProfile);
+    if (!appCore->initSimulation(options.configFile, options.extrasDirs))
+        return nullptr;
+
+    const CelestiaConfig* config = appCore->getConfig();
+#ifdef GL_ES
+    if (!gl::init(config->renderDetails.ignoreGLExtensions) || !gl::checkVersion(gl::GLES_2))
+    {
+        GetLogger()->error("Celestia was unable to initialize OpenGLES 2.0.\n");
+        return nullptr;
+    }
+#else
+    if (!gl::init(config->renderDetails.ignoreGLExtensions) || !gl::checkVersion(gl::GL_2_1))
+    {
+        GetLogger()->error("Celestia was unable to initialize OpenGL 2.1.\n");
+        return nullptr;
+    }
+#endif
+
+    // The framebuffer object stays bound, so all the views are drawn into it
+    // and the captures read from it
+    app->m_framebuffer = std::make_unique<FramebufferObject>(static_cast<GLuint>(options.width),
+                                                             static_cast<GLuint>(options.height),
+                                                             FramebufferObject::ColorAttachment |
+                                                             FramebufferObject::DepthAttachment);
+    if (!app->m_framebuffer->isValid() || !app->m_framebuffer->bind())
+    {
+        GetLogger()->error("Failed to create the framebuffer object\n");
+        return nullptr;
+    }
+
+    if (!appCore->initRenderer())
+        return nullptr;
+
+    // Frames must not show placeholders for textures and models which are
+    // still loading
+    GetTextureManager()->setAsyncLoading(false);
+    engine::GetGeometryManager()->setAsyncLoading(false);
+
+    Renderer* renderer = appCore->getRenderer();
+    renderer->setShadowMapSize(config->renderDetails.ShadowMapSize);
+    renderer->setShadowMapCacheSize(config->renderDetails.ShadowMapCache);
+    renderer->setSolarSystemMaxDistance(config->renderDetails.SolarSystemMaxDistance);
+    renderer->setGPUStarCulling(config->renderDetails.GPUStarCulling);
+    renderer->setReverseDepth(config->renderDetails.ReverseDepth);
+    renderer->setLabelDeclutter(config->renderDetails.LabelDeclutter);
+    renderer->setMaxLabels(config->renderDetails.MaxLabels);
+    renderer->setGalaxyPointBudget(config->renderDetails.GalaxyPointBudget);
+
+    // The detail of a frame must not depend on the time taken by the
+    // earlier ones
+    renderer->setQualityLimits({});
+    renderer->setDynamicResolution(0.0, 1.0f);
+
+    appCore->setFixedTimeStep(options.timeStep);
+    appCore->start();
+    appCore->resize(options.width, options.height);
+
+    return app;
+}
+
+void
+HeadlessApp::renderFrame()
+{
+    m_appCore->tick(m_timeStep);
+    m_appCore->draw();
+}
+
+void
+HeadlessApp::renderFrameAtCurrentTime()
+{
+    // Without a fixed time step, the core ticks by the time given
+    m_appCore->setFixedTimeStep(0.0);
+    m_appCore->tick(0.0);
+    m_appCore->setFixedTimeStep(m_timeStep);
+    m_appCore->draw();
+}
+
+bool
+HeadlessApp::resize(int width, int height)
+{
+    if (width == m_width && height == m_height)
+        return true;
+
+    auto framebuffer = std::make_unique<FramebufferObject>(static_cast<GLuint>(width),
+                                                           static_cast<GLuint>(height),
+                                                           FramebufferObject::ColorAttachment |
+                                                           FramebufferObject::DepthAttachment);
+    if (!framebuffer->isValid() || !framebuffer->bind())
+    {
+        GetLogger()->error("Failed to create a framebuffer object of {}x{}\n", width, height);
+        m_framebuffer->bind();
+        return false;
+    }
+
+    m_framebuffer = std::move(framebuffer);
+    m_width = width;
+    m_height = height;
+    m_appCore->resize(width, height);
+    return true;
+}
+
+engine::PixelFormat
+HeadlessApp::getPixelFormat() const
+{
+    return m_appCore->getRenderer()->getPreferredCaptureFormat();
+}
+
+bool
+HeadlessApp::readPixels(std::vector<std::uint8_t>& pixels) const
+{
+    std::array<int, 4> viewport;
+    engine::PixelFormat format;
+    m_appCore->getCaptureInfo(viewport, format);
+
+    const std::size_t bytesPerPixel = format == engine::PixelFormat::RGBA ? 4 : 3;
+    const std::size_t pitch = (bytesPerPixel * static_cast<std::size_t>(viewport[2]) + 3) & ~std::size_t(3);
+    pixels.resize(pitch * static_cast<std::size_t>(viewport[3]));
+    return m_appCore->captureImage(pixels.data(), viewport, format);
+}
+
+bool
+HeadlessApp::saveFrame(const fs::path& filename, ContentType type) const
+{
+    return m_appCore->saveScreenShot(filename, type);
+}
+
+} // end namespace celestia::headless
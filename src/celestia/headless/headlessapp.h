@@ -0,0 +1,97 @@
+// headlessapp.h
+//
+// Copyright (C) 2025-present, the Celestia Development Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <celcompat/filesystem.h>
+#include <celimage/pixelformat.h>
+#include <celutil/filetype.h>
+
+class CelestiaCore;
+class FramebufferObject;
+
+namespace celestia::headless
+{
+
+class EGLOffscreenContext;
+
+struct HeadlessOptions
+{
+    fs::path configFile;
+    std::vector<fs::path> extrasDirs;
+    int width{ 1920 };
+    int height{ 1080 };
+    // Simulated seconds per frame
+    double timeStep{ 1.0 / 30.0 };
+    // EGL device, negative for the default display
+    int device{ -1 };
+    // Keep the startup profile, see CelestiaCore::getStartupProfile
+    bool keepStartupProfile{ false };
+};
+
+// HeadlessApp runs a CelestiaCore without a window: it renders into a
+// framebuffer object of an offscreen EGL context, and the simulation and
+// scripts advance by a fixed time step per frame instead of following the
+// system clock.
+//
+// The engine keeps some state per process, such as the supported GL
+// extensions, so only one HeadlessApp should exist in a process; several
+// instances can share a GPU by running in separate processes.
+class HeadlessApp //NOSONAR
+{
+    struct Private { explicit Private() = default; };
+
+public:
+    explicit HeadlessApp(Private);
+    ~HeadlessApp();
+
+    HeadlessApp(const HeadlessApp&) = delete;
+    HeadlessApp& operator=(const HeadlessApp&) = delete;
+    HeadlessApp(HeadlessApp&&) = delete;
+    HeadlessApp& operator=(HeadlessApp&&) = delete;
+
+    // The current directory must be the data directory
+    static std::unique_ptr<HeadlessApp> create(const HeadlessOptions&);
+
+    CelestiaCore* getCore() const { return m_appCore.get(); }
+    int getWidth() const { return m_width; }
+    int getHeight() const { return m_height; }
+    double getTimeStep() const { return m_timeStep; }
+
+    // Advance by one time step and render the frame
+    void renderFrame();
+    // Render a frame without advancing the simulation time, such as after
+    // a URL has set it
+    void renderFrameAtCurrentTime();
+
+    // Change the size of the frames; returns false if the framebuffer
+    // can't be created
+    bool resize(int width, int height);
+
+    // The pixels of the last frame, top row first with rows padded to four
+    // bytes; the channels are given by getPixelFormat()
+    bool readPixels(std::vector<std::uint8_t>&) const;
+    engine::PixelFormat getPixelFormat() const;
+    // Encode the last frame in a format supported by Image::save
+    bool saveFrame(const fs::path&, ContentType = ContentType::Unknown) const;
+
+private:
+    std::unique_ptr<EGLOffscreenContext> m_context;
+    std::unique_ptr<FramebufferObject> m_framebuffer;
+    std::unique_ptr<CelestiaCore> m_appCore;
+    int m_width{ 0 };
+    int m_height{ 0 };
+    double m_timeStep{ 0.0 };
+};
+
+} // end namespace celestia::headless
@@ -0,0 +1,272 @@
+// headlessmain.cpp
+//
+// Copyright (C) 2025-present, the Celestia Development Team
+//
+// Render Celestia views to image files or raw frames without a window.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include <celestia/celestiacore.h>
+#include <celutil/gettext.h>
+#include "headlessapp.h"
+#ifdef ENABLE_STREAMING
+#include "streamserver.h"
+#endif
+
+using namespace std::string_view_literals;
+
+namespace
+{
+
+struct CommandLine
+{
+    celestia::headless::HeadlessOptions options;
+    fs::path dataDir;
+    std::string url;
+    fs::path script;
+    int frames{ 1 };
+    // Frames made of tiles of the frame size, for posters
+    int tileColumns{ 1 };
+    int tileRows{ 1 };
+    // {} is replaced by the frame number, - writes raw frames to stdout
+    std::string output{ "frame-{:05}.png" };
+    // Stream to clients connecting to this port instead of writing frames
+    int servePort{ 0 };
+};
+
+#ifdef ENABLE_STREAMING
+celestia::headless::StreamServer* streamServer = nullptr;
+
+void
+stopServer(int)
+{
+    if (streamServer != nullptr)
+        streamServer->stop();
+}
+#endif
+
+void
+usage()
+{
+    std::cerr << "Usage: celestia-headless [options]\n"
+                 "  --dir <directory>       data directory\n"
+                 "  --conf <file>           configuration file\n"
+                 "  --extrasdir <directory> additional extras directory\n"
+                 "  --size <width>x<height> frame size, 1920x1080 by default\n"
+                 "  --fps <rate>            frames per simulated second, 30 by default\n"
+                 "  --frames <count>        number of frames to render, 1 by default\n"
+                 "  --url <url>             cel:// URL to go to\n"
+                 "  --script <file>         script to run\n"
+                 "  --device <index>        EGL device to render on\n"
+                 "  --tiles <columns>x<rows> save each frame as a PNG image of tiles of the\n"
+                 "                          frame size\n"
+                 "  --output <pattern>      output files, frame-{:05}.png by default;\n"
+                 "                          - writes the raw pixels to stdout\n"
+#ifdef ENABLE_STREAMING
+                 "  --serve <port>          stream the views of the clients connecting to\n"
+                 "                          the port instead of writing frames\n"
+#endif
+                 ;
+}
+
+bool
+parseCommandLine(int argc, char* argv[], CommandLine& commandLine)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        std::string_view arg = argv[i];
+        if (i + 1 == argc)
+        {
+            std::cerr << "Missing value for " << arg << '\n';
+            return false;
+        }
+
+        const char* value = argv[++i];
+        if (arg == "--dir"sv)
+            commandLine.dataDir = value;
+        else if (arg == "--conf"sv)
+            commandLine.options.configFile = value;
+        else if (arg == "--extrasdir"sv)
+            commandLine.options.extrasDirs.emplace_back(value);
+        else if (arg == "--size"sv)
+        {
+            if (std::sscanf(value, "%dx%d", &commandLine.options.width, &commandLine.options.height) != 2 || // NOSONAR
+                commandLine.options.width <= 0 || commandLine.options.height <= 0)
+            {
+                std::cerr << "Invalid frame size: " << value << '\n';
+                return false;
+            }
+        }
+        else if (arg == "--fps"sv)
+        {
+            double fps = std::atof(value);
+            if (fps <= 0.0)
+            {
+                std::cerr << "Invalid frame rate: " << value << '\n';
+                return false;
+            }
+            commandLine.options.timeStep = 1.0 / fps;
+        }
+        else if (arg == "--frames"sv)
+            commandLine.frames = std::atoi(value);
+        else if (arg == "--url"sv)
+            commandLine.url = value;
+        else if (arg == "--script"sv)
+            commandLine.script = value;
+        else if (arg == "--device"sv)
+            commandLine.options.device = std::atoi(value);
+        else if (arg == "--tiles"sv)
+        {
+            if (std::sscanf(value, "%dx%d", &commandLine.tileColumns, &commandLine.tileRows) != 2 || // NOSONAR
+                commandLine.tileColumns <= 0 || commandLine.tileRows <= 0)
+            {
+                std::cerr << "Invalid tile grid: " << value << '\n';
+                return false;
+            }
+        }
+        else if (arg == "--output"sv)
+            commandLine.output = value;
+#ifdef ENABLE_STREAMING
+        else if (arg == "--serve"sv)
+        {
+            commandLine.servePort = std::atoi(value);
+            if (commandLine.servePort <= 0 || commandLine.servePort > 65535)
+            {
+                std::cerr << "Invalid port: " << value << '\n';
+                return false;
+            }
+        }
+#endif
+        else
+        {
+            std::cerr << "Unknown command line switch: " << arg << '\n';
+            return false;
+        }
+    }
+
+    return true;
+}
+
+} // end unnamed namespace
+
+int
+main(int argc, char* argv[])
+{
+    CelestiaCore::initLocale();
+
+#ifdef ENABLE_NLS
+    bindtextdomain("celestia", LOCALEDIR);
+    bind_textdomain_codeset("celestia", "UTF-8");
+    bindtextdomain("celestia-data", LOCALEDIR);
+    bind_textdomain_codeset("celestia-data", "UTF-8");
+    textdomain("celestia");
+#endif
+
+    CommandLine commandLine;
+    if (!parseCommandLine(argc, argv, commandLine))
+    {
+        usage();
+        return EXIT_FAILURE;
+    }
+
+    if (commandLine.dataDir.empty())
+    {
+        if (const char* dataDirEnv = std::getenv("CELESTIA_DATA_DIR"); dataDirEnv == nullptr)
+            commandLine.dataDir = CONFIG_DATA_DIR;
+        else
+            commandLine.dataDir = dataDirEnv;
+    }
+
+    std::error_code ec;
+    fs::current_path(commandLine.dataDir, ec);
+    if (ec)
+    {
+        std::cerr << "Cannot change to the data directory " << commandLine.dataDir << '\n';
+        return EXIT_FAILURE;
+    }
+
+    auto app = celestia::headless::HeadlessApp::create(commandLine.options);
+    if (app == nullptr)
+        return EXIT_FAILURE;
+
+    CelestiaCore* appCore = app->getCore();
+    if (!commandLine.url.empty() && !appCore->goToUrl(commandLine.url))
+    {
+        std::cerr << "Invalid URL: " << commandLine.url << '\n';
+        return EXIT_FAILURE;
+    }
+    if (!commandLine.script.empty())
+        appCore->runScript(commandLine.script);
+
+#ifdef ENABLE_STREAMING
+    if (commandLine.servePort != 0)
+    {
+        celestia::headless::StreamServerOptions serverOptions;
+        serverOptions.port = static_cast<std::uint16_t>(commandLine.servePort);
+        serverOptions.frameRate = static_cast<float>(1.0 / commandLine.options.timeStep);
+
+        celestia::headless::StreamServer server(*app, serverOptions);
+        if (!server.listen())
+            return EXIT_FAILURE;
+
+        streamServer = &server;
+        std::signal(SIGINT, stopServer);
+        std::signal(SIGTERM, stopServer);
+        server.run();
+        streamServer = nullptr;
+        return EXIT_SUCCESS;
+    }
+#endif
+
+    const bool raw = commandLine.output == "-"sv;
+    const bool tiled = commandLine.tileColumns > 1 || commandLine.tileRows > 1;
+    if (raw && tiled)
+    {
+        std::cerr << "Tiled frames can't be written to stdout\n";
+        return EXIT_FAILURE;
+    }
+
+    std::vector<std::uint8_t> pixels;
+    for (int frame = 0; frame < commandLine.frames; frame++)
+    {
+        app->renderFrame();
+        if (raw)
+        {
+            if (!app->readPixels(pixels) ||
+                std::fwrite(pixels.data(), 1, pixels.size(), stdout) != pixels.size())
+            {
+                return EXIT_FAILURE;
+            }
+        }
+        else if (tiled)
+        {
+            if (!appCore->saveTiledScreenShot(fmt::format(fmt::runtime(commandLine.output), frame),
+                                              commandLine.tileColumns, commandLine.tileRows))
+            {
+                return EXIT_FAILURE;
+            }
+        }
+        else if (!app->saveFrame(fmt::format(fmt::runtime(commandLine.output), frame)))
+        {
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::fflush(stdout);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,455 @@
+// streamserver.cpp
+//
+// Copyright (C) 2025-present, the Celestia Development Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include "streamserver.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <sstream>
+#include <thread>
+
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <celengine/observer.h>
+#include <celengine/render.h>
+#include <celengine/simulation.h>
+#include <celestia/celestiacore.h>
+#include <celestia/configfile.h>
+#include <celestia/ffmpegcapture.h>
+#include <celutil/logger.h>
+#include "headlessapp.h"
+
+using namespace std::string_view_literals;
+using celestia::util::GetLogger;
+
+namespace celestia::headless
+{
+
+namespace
+{
+
+// Longest command accepted from a client, larger ones close the session
+constexpr std::size_t MaxCommandLength = 65536;
+
+bool
+setNonBlocking(int fd)
+{
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags != -1 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) != -1;
+}
+
+std::string_view
+nextWord(std::string_view& line)
+{
+    auto start = line.find_first_not_of(' ');
+    if (start == std::string_view::npos)
+    {
+        line = {};
+        return {};
+    }
+
+    line.remove_prefix(start);
+    auto end = std::min(line.find(' '), line.size());
+    std::string_view word = line.substr(0, end);
+    line.remove_prefix(end);
+    return word;
+}
+
+} // end unnamed namespace
+
+struct StreamServer::Session
+{
+    int socket{ -1 };
+    Observer* observer{ nullptr };
+    std::string input;
+    std::unique_ptr<FFMPEGCapture> capture;
+    bool closed{ false };
+
+    void reply(std::string_view msg) const
+    {
+        std::string line(msg);
+        line.push_back('\n');
+        // A client which doesn't read its replies loses them rather than
+        // stalling the other clients
+        (void) ::send(socket, line.data(), line.size(), MSG_NOSIGNAL | MSG_DONTWAIT);
+    }
+};
+
+StreamServer::StreamServer(HeadlessApp& app, const StreamServerOptions& options) :
+    m_app(app),
+    m_options(options)
+{
+}
+
+StreamServer::~StreamServer()
+{
+    for (auto& session : m_sessions)
+        closeSession(*session);
+    if (m_socket != -1)
+        ::close(m_socket);
+}
+
+bool
+StreamServer::listen()
+{
+    m_socket = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (m_socket == -1)
+    {
+        GetLogger()->error("Failed to create the server socket: {}\n", std::strerror(errno));
+        return false;
+    }
+
+    int reuse = 1;
+    setsockopt(m_socket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(m_options.port);
+    if (::bind(m_socket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == -1 || //NOSONAR
+        ::listen(m_socket, SOMAXCONN) == -1 ||
+        !setNonBlocking(m_socket))
+    {
+        GetLogger()->error("Failed to listen on port {}: {}\n", m_options.port, std::strerror(errno));
+        return false;
+    }
+
+    m_defaultObserver = m_app.getCore()->getSimulation()->getActiveObserver();
+    GetLogger()->info("Listening on port {}\n", m_options.port);
+    return true;
+}
+
+void
+StreamServer::run()
+{
+    using clock = std::chrono::steady_clock;
+    const auto frameInterval = std::chrono::duration_cast<clock::duration>(
+        std::chrono::duration<double>(1.0 / m_options.frameRate));
+
+    auto nextFrame = clock::now();
+    while (!m_stopped)
+    {
+        acceptSessions();
+        readSessions();
+
+        m_sessions.erase(std::remove_if(m_sessions.begin(), m_sessions.end(),
+                                        [this](const auto& session)
+                                        {
+                                            if (!session->closed)
+                                                return false;
+                                            closeSession(*session);
+                                            return true;
+                                        }),
+                         m_sessions.end());
+
+        renderFrame();
+
+        // Don't try to catch up after a slow frame, the clients would get a
+        // burst of frames
+        nextFrame += frameInterval;
+        if (auto now = clock::now(); nextFrame < now)
+            nextFrame = now;
+        else
+            std::this_thread::sleep_until(nextFrame);
+    }
+}
+
+void
+StreamServer::acceptSessions()
+{
+    for (;;)
+    {
+        int fd = ::accept(m_socket, nullptr, nullptr);
+        if (fd == -1)
+            return;
+        if (!setNonBlocking(fd))
+        {
+            ::close(fd);
+            continue;
+        }
+
+        auto session = std::make_unique<Session>();
+        session->socket = fd;
+        session->observer = m_app.getCore()->getSimulation()->duplicateActiveObserver();
+        m_sessions.push_back(std::move(session));
+    }
+}
+
+void
+StreamServer::readSessions()
+{
+    std::vector<pollfd> fds;
+    fds.reserve(m_sessions.size());
+    for (const auto& session : m_sessions)
+        fds.push_back({ session->socket, POLLIN, 0 });
+
+    if (fds.empty() || ::poll(fds.data(), fds.size(), 0) <= 0)
+        return;
+
+    char buffer[4096]; //NOSONAR
+    for (std::size_t i = 0; i < fds.size(); i++)
+    {
+        if (fds[i].revents == 0)
+            continue;
+
+        Session& session = *m_sessions[i];
+        ssize_t count = ::recv(session.socket, buffer, sizeof(buffer), 0);
+        if (count <= 0)
+        {
+            if (count == 0 || (errno != EAGAIN && errno != EWOULDBLOCK))
+                session.closed = true;
+            continue;
+        }
+
+        session.input.append(buffer, static_cast<std::size_t>(count));
+        std::string::size_type start = 0;
+        for (auto end = session.input.find('\n'); end != std::string::npos; end = session.input.find('\n', start))
+        {
+            std::string_view line(session.input.data() + start, end - start);
+            if (!line.empty() && line.back() == '\r')
+                line.remove_suffix(1);
+            handleCommand(session, line);
+            start = end + 1;
+        }
+        session.input.erase(0, start);
+
+        if (session.input.size() > MaxCommandLength)
+            session.closed = true;
+    }
+}
+
+void
+StreamServer::closeSession(Session& session)
+{
+    CelestiaCore* appCore = m_app.getCore();
+    if (m_scriptSession == &session)
+    {
+        appCore->cancelScript();
+        m_scriptSession = nullptr;
+    }
+
+    if (session.capture != nullptr)
+        session.capture->end();
+
+    appCore->setActiveObserver(m_defaultObserver);
+    appCore->getSimulation()->removeObserver(session.observer);
+    delete session.observer;
+    session.observer = nullptr;
+
+    ::close(session.socket);
+    session.socket = -1;
+}
+
+void
+StreamServer::handleCommand(Session& session, std::string_view line)
+{
+    CelestiaCore* appCore = m_app.getCore();
+    std::string_view command = nextWord(line);
+    if (command.empty())
+        return;
+
+    // Input is applied to the observer of the client
+    appCore->setActiveObserver(session.observer);
+
+    float x = 0.0f;
+    float y = 0.0f;
+    int value = 0;
+    std::istringstream args{ std::string(line) };
+
+    if (command == "stream"sv)
+    {
+        std::string url;
+        if (!(args >> url))
+            session.reply("error missing URL"sv);
+        else if (startStream(session, url))
+            session.reply("ok"sv);
+        else
+            session.reply("error failed to start the stream"sv);
+        return;
+    }
+
+    if (command == "stop"sv)
+    {
+        if (session.capture != nullptr)
+        {
+            session.capture->end();
+            session.capture.reset();
+        }
+    }
+    else if (command == "down"sv || command == "up"sv)
+    {
+        if (!(args >> x >> y >> value))
+        {
+            session.reply("error expected x y button"sv);
+            return;
+        }
+        if (command == "down"sv)
+            appCore->mouseButtonDown(x, y, value);
+        else
+            appCore->mouseButtonUp(x, y, value);
+    }
+    else if (command == "move"sv)
+    {
+        if (!(args >> x >> y >> value))
+        {
+            session.reply("error expected dx dy modifiers"sv);
+            return;
+        }
+        appCore->mouseMove(x, y, value);
+    }
+    else if (command == "hover"sv)
+    {
+        if (!(args >> x >> y))
+        {
+            session.reply("error expected x y"sv);
+            return;
+        }
+        appCore->mouseMove(x, y);
+    }
+    else if (command == "wheel"sv)
+    {
+        if (!(args >> x >> value))
+        {
+            session.reply("error expected motion modifiers"sv);
+            return;
+        }
+        appCore->mouseWheel(x, value);
+    }
+    else if (command == "keydown"sv || command == "keyup"sv)
+    {
+        int key = 0;
+        if (!(args >> key >> value))
+        {
+            session.reply("error expected key modifiers"sv);
+            return;
+        }
+        if (command == "keydown"sv)
+            appCore->keyDown(key, value);
+        else
+            appCore->keyUp(key, value);
+    }
+    else if (command == "char"sv)
+    {
+        if (!line.empty())
+            line.remove_prefix(1);
+        appCore->charEntered(std::string(line).c_str());
+    }
+    else if (command == "url"sv)
+    {
+        if (!appCore->goToUrl(nextWord(line)))
+        {
+            session.reply("error invalid URL"sv);
+            return;
+        }
+    }
+    else if (command == "script"sv || command == "celx"sv)
+    {
+        if (!line.empty())
+            line.remove_prefix(1);
+        if (command == "script"sv)
+        {
+            appCore->runScript(fs::path(std::string(line)));
+        }
+        else
+        {
+            std::istringstream code{ std::string(line) };
+            appCore->runCelxScript(code, "command.celx");
+        }
+        m_scriptSession = &session;
+    }
+    else if (command == "quit"sv)
+    {
+        session.closed = true;
+    }
+    else
+    {
+        session.reply("error unknown command"sv);
+        return;
+    }
+
+    session.reply("ok"sv);
+}
+
+bool
+StreamServer::startStream(Session& session, const std::string& url)
+{
+    if (session.capture != nullptr)
+        session.capture->end();
+
+    CelestiaCore* appCore = m_app.getCore();
+    auto capture = std::make_unique<FFMPEGCapture>(appCore->getRenderer());
+    capture->setVideoCodec(AV_CODEC_ID_H264);
+    capture->setBitRate(m_options.bitRate);
+    capture->setContainerFormat(url.compare(0, 6, "rtp://") == 0 ? "rtp_mpegts" : "mpegts");
+
+    const CelestiaConfig* config = appCore->getConfig();
+    if (!config->hardwareEncoder.empty())
+    {
+        capture->setHardwareEncoder(config->hardwareEncoder, config->hardwareEncoderDevice);
+        capture->setEncoderOptions(config->hardwareEncoderOptions);
+    }
+    else
+    {
+        capture->setEncoderOptions(config->x264EncoderOptions);
+    }
+
+    if (!capture->start(url, m_app.getWidth(), m_app.getHeight(), m_options.frameRate))
+    {
+        session.capture.reset();
+        return false;
+    }
+
+    session.capture = std::move(capture);
+    return true;
+}
+
+void
+StreamServer::renderFrame()
+{
+    CelestiaCore* appCore = m_app.getCore();
+    Simulation* sim = appCore->getSimulation();
+
+    // A running script moves the observer of the client which started it
+    appCore->setActiveObserver(m_scriptSession == nullptr ? m_defaultObserver : m_scriptSession->observer);
+    appCore->tick(m_app.getTimeStep());
+
+    std::vector<const Observer*> observers;
+    for (const auto& session : m_sessions)
+    {
+        if (session->capture != nullptr)
+            observers.push_back(session->observer);
+    }
+    if (observers.empty())
+        return;
+
+    Renderer* renderer = appCore->getRenderer();
+    renderer->beginMultiViewFrame(*sim->getUniverse(), observers);
+    for (const auto& session : m_sessions)
+    {
+        if (session->capture == nullptr)
+            continue;
+
+        appCore->setActiveObserver(session->observer);
+        appCore->draw();
+        if (!session->capture->captureFrame())
+        {
+            session->reply("error the stream failed"sv);
+            session->capture.reset();
+        }
+    }
+    renderer->endMultiViewFrame();
+}
+
+} // end namespace celestia::headless
@@ -0,0 +1,96 @@
+// streamserver.h
+//
+// Copyright (C) 2025-present, the Celestia Development Team
+//
+// Stream the views of remote clients as video and apply their input.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class FFMPEGCapture;
+class Observer;
+
+namespace celestia::headless
+{
+
+class HeadlessApp;
+
+struct StreamServerOptions
+{
+    std::uint16_t port{ 5550 };
+    // Encoded frames per wall clock second
+    float frameRate{ 30.0f };
+    std::int64_t bitRate{ 8000000 };
+};
+
+// StreamServer lets thin clients such as browsers or VR headsets view
+// Celestia without rendering it. Each client connects to a TCP control
+// port and sends commands, one per line:
+//
+//   stream <url>                  start sending frames to a udp:// or
+//                                 rtp:// URL as H.264 in MPEG-TS
+//   stop                          stop sending frames
+//   down|up <x> <y> <button>      mouse buttons, in frame pixels
+//   move <dx> <dy> <modifiers>    mouse drag
+//   hover <x> <y>                 mouse move without buttons
+//   wheel <motion> <modifiers>
+//   keydown|keyup <key> <modifiers>
+//   char <text>
+//   url <cel url>                 go to a cel:// URL
+//   script <file>                 run a script file on the server
+//   celx <code>                   run a line of Lua
+//   quit
+//
+// and the server replies "ok" or "error <message>" to each. Every client
+// has its own observer, and the views of all the clients are rendered in
+// one multi-view frame of the renderer, so they share the ephemeris and
+// the star search. The simulation time and the selection are shared.
+class StreamServer
+{
+public:
+    StreamServer(HeadlessApp&, const StreamServerOptions&);
+    ~StreamServer();
+
+    StreamServer(const StreamServer&) = delete;
+    StreamServer& operator=(const StreamServer&) = delete;
+    StreamServer(StreamServer&&) = delete;
+    StreamServer& operator=(StreamServer&&) = delete;
+
+    bool listen();
+    // Serve until stop() is called, from a signal handler or another thread
+    void run();
+    void stop() { m_stopped = true; }
+
+private:
+    struct Session;
+
+    void acceptSessions();
+    void readSessions();
+    void closeSession(Session&);
+    void handleCommand(Session&, std::string_view);
+    bool startStream(Session&, const std::string&);
+    void renderFrame();
+
+    HeadlessApp& m_app;
+    StreamServerOptions m_options;
+    int m_socket{ -1 };
+    std::atomic<bool> m_stopped{ false };
+    // The observer of the simulation before the first client connected
+    Observer* m_defaultObserver{ nullptr };
+    std::vector<std::unique_ptr<Session>> m_sessions;
+    // Scripts move the observer of the client which started them
+    Session* m_scriptSession{ nullptr };
+};
+
+} // end namespace celestia::headless
@@ -159,6 +159,14 @@ Helper::getRenderInfo(const Renderer *r)
     if (info.count("MaxAnisotropy") > 0)
         s += fmt::sprintf(_("Max anisotropy filtering: %s\n"), info["MaxAnisotropy"]);
 
+    if (info.count("TextureMemoryUsage") > 0 && info.count("TextureMemoryBudget") > 0)
+        s += fmt::sprintf(_("Texture memory: %s MB of %s MB\n"), info["TextureMemoryUsage"], info["TextureMemoryBudget"]);
+    else if (info.count("TextureMemoryUsage") > 0)
+        s += fmt::sprintf(_("Texture memory: %s MB\n"), info["TextureMemoryUsage"]);
+
+    if (info.count("TextureLoads") > 0 && info.count("TextureMaxUploadTime") > 0)
+        s += fmt::sprintf(_("Textures loaded: %s, longest upload %s ms\n"), info["TextureLoads"], info["TextureMaxUploadTime"]);
+
     s += "\n";
 
     if (info.count("Extensions") > 0)
@@ -13,9 +13,13 @@
 #include "hud.h"
 
 #include <algorithm>
+#include <array>
 #include <cassert>
 #include <cmath>
+#include <iterator>
 #include <string>
+#include <string_view>
+#include <tuple>
 #include <vector>
 
 #include <Eigen/Geometry>
@@ -27,6 +31,7 @@
 
 #include <celcompat/numbers.h>
 #include <celengine/body.h>
+#include <celengine/framestats.h>
 #include <celengine/location.h>
 #include <celengine/observer.h>
 #include <celengine/overlay.h>
@@ -93,60 +98,103 @@ KelvinToStr(const util::NumberFormatter& formatter, float value, int digits, Tem
     }
 }
 
-std::string
-DistanceLyToStr(const util::NumberFormatter& formatter, double distance, int digits, MeasurementSystem measurement)
+std::tuple<double, const char*>
+selectDistanceUnits(double distance, MeasurementSystem measurement)
 {
-    const char* units;
     if (std::abs(distance) >= astro::parsecsToLightYears(1e+6))
+        return { astro::lightYearsToParsecs(distance) / 1e+6, _("Mpc") };
+    if (std::abs(distance) >= 0.5 * astro::parsecsToLightYears(1e+3))
+        return { astro::lightYearsToParsecs(distance) / 1e+3, _("kpc") };
+    if (std::abs(distance) >= astro::AUtoLightYears(1000.0f))
+        return { distance, _("ly") };
+    if (std::abs(distance) >= astro::kilometersToLightYears(10000000.0))
+        return { astro::lightYearsToAU(distance), _("au") };
+
+    if (measurement == MeasurementSystem::Imperial)
     {
-        units = _("Mpc");
-        distance = astro::lightYearsToParsecs(distance) / 1e+6;
-    }
-    else if (std::abs(distance) >= 0.5 * astro::parsecsToLightYears(1e+3))
-    {
-        units = _("kpc");
-        distance = astro::lightYearsToParsecs(distance) / 1e+3;
-    }
-    else if (std::abs(distance) >= astro::AUtoLightYears(1000.0f))
-    {
-        units = _("ly");
+        if (std::abs(distance) > astro::kilometersToLightYears(OneMiInKm))
+            return { astro::lightYearsToKilometers(distance) / OneMiInKm, _("mi") };
+        return { astro::lightYearsToKilometers(distance) / OneFtInKm, _("ft") };
     }
-    else if (std::abs(distance) >= astro::kilometersToLightYears(10000000.0))
+
+    if (std::abs(distance) > astro::kilometersToLightYears(1.0f))
+        return { astro::lightYearsToKilometers(distance), _("km") };
+    return { astro::lightYearsToKilometers(distance) * 1000.0f, _("m") };
+}
+
+} // end unnamed namespace
+
+// Distance strings of the last frames. The lookup key is the value printed
+// to the displayed number of significant figures, which is much cheaper
+// than the grouped and localized formatting, so a distance which doesn't
+// change at the displayed precision is only formatted once. A returned
+// reference stays valid for the next CacheSize - 1 lookups.
+class DistanceStrCache
+{
+public:
+    explicit DistanceStrCache(const util::NumberFormatter& formatter) : m_formatter(formatter) {}
+
+    const std::string& get(double value, int digits, const char* units);
+
+private:
+    static constexpr std::size_t CacheSize = 8;
+    static constexpr std::size_t KeySize = 32;
+
+    struct Entry
     {
-        units = _("au");
-        distance = astro::lightYearsToAU(distance);
-    }
-    else if (measurement == MeasurementSystem::Imperial)
+        std::array<char, KeySize> key{};
+        std::size_t keyLength{ 0 };
+        const char* units{ nullptr };
+        std::string text;
+    };
+
+    const util::NumberFormatter& m_formatter;
+    std::array<Entry, CacheSize> m_entries;
+    std::size_t m_nextEntry{ 0 };
+};
+
+const std::string&
+DistanceStrCache::get(double value, int digits, const char* units)
+{
+    std::array<char, KeySize> key;
+    auto result = fmt::format_to_n(key.data(), key.size(), "{:.{}e}", value, std::max(digits - 1, 0));
+    std::string_view keyView(key.data(), std::min(result.size, key.size()));
+    if (result.size <= key.size())
     {
-        if (std::abs(distance) > astro::kilometersToLightYears(OneMiInKm))
-        {
-            units = _("mi");
-            distance = astro::lightYearsToKilometers(distance) / OneMiInKm;
-        }
-        else
+        for (const Entry& entry : m_entries)
         {
-            units = _("ft");
-            distance = astro::lightYearsToKilometers(distance) / OneFtInKm;
+            if (entry.units == units && std::string_view(entry.key.data(), entry.keyLength) == keyView)
+                return entry.text;
         }
     }
-    else if (std::abs(distance) > astro::kilometersToLightYears(1.0f))
-    {
-        units = _("km");
-        distance = astro::lightYearsToKilometers(distance);
-    }
-    else
-    {
-        units = _("m");
-        distance = astro::lightYearsToKilometers(distance) * 1000.0f;
-    }
 
-    return fmt::format("{} {}", formatter.format(distance, digits, SigDigitNum), units);
+    Entry& entry = m_entries[m_nextEntry];
+    m_nextEntry = (m_nextEntry + 1) % CacheSize;
+
+    // Keys which don't fit are never matched
+    entry.units = result.size <= key.size() ? units : nullptr;
+    std::copy(keyView.begin(), keyView.end(), entry.key.begin());
+    entry.keyLength = keyView.size();
+
+    entry.text.clear();
+    fmt::format_to(std::back_inserter(entry.text), "{} {}", m_formatter.format(value, digits, SigDigitNum), units);
+    return entry.text;
 }
 
-std::string
-DistanceKmToStr(const util::NumberFormatter& formatter, double distance, int digits, MeasurementSystem measurement)
+namespace
+{
+
+const std::string&
+DistanceLyToStr(DistanceStrCache& distances, double distance, int digits, MeasurementSystem measurement)
 {
-    return DistanceLyToStr(formatter, astro::kilometersToLightYears(distance), digits, measurement);
+    auto [value, units] = selectDistanceUnits(distance, measurement);
+    return distances.get(value, digits, units);
+}
+
+const std::string&
+DistanceKmToStr(DistanceStrCache& distances, double distance, int digits, MeasurementSystem measurement)
+{
+    return DistanceLyToStr(distances, astro::kilometersToLightYears(distance), digits, measurement);
 }
 
 void
@@ -351,7 +399,7 @@ displayRADec(Overlay& overlay, const Eigen::Vector3d& v, const std::locale& loc)
 // The latitude and longitude parameters are angles in radians, altitude
 // is in kilometers.
 void
-displayPlanetocentricCoords(const util::NumberFormatter& formatter,
+displayPlanetocentricCoords(DistanceStrCache& distances,
                             Overlay& overlay,
                             const Body& body,
                             double longitude,
@@ -406,11 +454,12 @@ displayPlanetocentricCoords(const util::NumberFormatter& formatter,
 
     overlay.print(loc, fmt::runtime(_("{:.6f}{} {:.6f}{} {}")),
                   lat, nsHemi, lon, ewHemi,
-                  DistanceKmToStr(formatter, altitude, 5, measurement));
+                  DistanceKmToStr(distances, altitude, 5, measurement));
 }
 
 void
 displayStarInfo(const util::NumberFormatter& formatter,
+                DistanceStrCache& distances,
                 Overlay& overlay,
                 int detail,
                 const Star& star,
@@ -420,7 +469,7 @@ displayStarInfo(const util::NumberFormatter& formatter,
                 const std::locale& loc)
 {
     overlay.printf(_("Distance: %s\n"),
-                   DistanceLyToStr(formatter, distance, 5, hudSettings.measurementSystem));
+                   DistanceLyToStr(distances, distance, 5, hudSettings.measurementSystem));
 
     if (!star.getVisibility())
     {
@@ -462,12 +511,12 @@ displayStarInfo(const util::NumberFormatter& formatter,
             {
                 overlay.print(fmt::runtime(_("Radius: {} Rsun ({})\n")),
                               formatter.format(star.getRadius() / 696000.0f, 2, SigDigitNum),
-                              DistanceKmToStr(formatter, star.getRadius(), 3, hudSettings.measurementSystem));
+                              DistanceKmToStr(distances, star.getRadius(), 3, hudSettings.measurementSystem));
             }
             else
             {
                 overlay.print(fmt::runtime(_("Radius: {}\n")),
-                              DistanceKmToStr(formatter, star.getRadius(), 3, hudSettings.measurementSystem));
+                              DistanceKmToStr(distances, star.getRadius(), 3, hudSettings.measurementSystem));
             }
 
             if (star.getRotationModel()->isPeriodic())
@@ -486,7 +535,7 @@ displayStarInfo(const util::NumberFormatter& formatter,
     }
 }
 
-void displayDSOinfo(const util::NumberFormatter& formatter,
+void displayDSOinfo(DistanceStrCache& distances,
                     Overlay& overlay,
                     const DeepSkyObject& dso,
                     double distance,
@@ -499,15 +548,15 @@ void displayDSOinfo(const util::NumberFormatter& formatter,
     if (distance >= 0.0)
     {
         overlay.printf(_("Distance: %s\n"),
-                     DistanceLyToStr(formatter, distance, 5, measurement));
+                     DistanceLyToStr(distances, distance, 5, measurement));
     }
     else
     {
         overlay.printf(_("Distance from center: %s\n"),
-                     DistanceLyToStr(formatter, distance + dso.getRadius(), 5, measurement));
+                     DistanceLyToStr(distances, distance + dso.getRadius(), 5, measurement));
      }
     overlay.printf(_("Radius: %s\n"),
-                 DistanceLyToStr(formatter, dso.getRadius(), 5, measurement));
+                 DistanceLyToStr(distances, dso.getRadius(), 5, measurement));
 
     displayApparentDiameter(overlay, dso.getRadius(), distance, loc);
     if (dso.getAbsoluteMagnitude() > DSO_DEFAULT_ABS_MAGNITUDE)
@@ -521,6 +570,7 @@ void displayDSOinfo(const util::NumberFormatter& formatter,
 
 void
 displayPlanetInfo(const util::NumberFormatter& formatter,
+                  DistanceStrCache& distances,
                   Overlay& overlay,
                   int detail,
                   const Body& body,
@@ -532,7 +582,7 @@ displayPlanetInfo(const util::NumberFormatter& formatter,
     double distanceKm = viewVec.norm();
     double distance = distanceKm - body.getRadius();
     overlay.printf(_("Distance: %s\n"),
-                   DistanceKmToStr(formatter, distance, 5, hudSettings.measurementSystem));
+                   DistanceKmToStr(distances, distance, 5, hudSettings.measurementSystem));
 
     if (body.getClassification() == BodyClassification::Invisible)
     {
@@ -546,28 +596,28 @@ displayPlanetInfo(const util::NumberFormatter& formatter,
             if (semiAxes.x() == semiAxes.y())
             {
                 overlay.print(fmt::runtime(_("Radius: {}\n")),
-                              DistanceKmToStr(formatter, body.getRadius(), 5, hudSettings.measurementSystem));
+                              DistanceKmToStr(distances, body.getRadius(), 5, hudSettings.measurementSystem));
             }
             else
             {
                 overlay.print(fmt::runtime(_("Equatorial radius: {}\n")),
-                              DistanceKmToStr(formatter, semiAxes.x(), 5, hudSettings.measurementSystem));
+                              DistanceKmToStr(distances, semiAxes.x(), 5, hudSettings.measurementSystem));
                 overlay.print(fmt::runtime(_("Polar radius: {}\n")),
-                              DistanceKmToStr(formatter, semiAxes.y(), 5, hudSettings.measurementSystem));
+                              DistanceKmToStr(distances, semiAxes.y(), 5, hudSettings.measurementSystem));
             }
         }
         else
         {
             overlay.print(fmt::runtime(_("Radii: {} × {} × {}\n")),
-                          DistanceKmToStr(formatter, semiAxes.x(), 5, hudSettings.measurementSystem),
-                          DistanceKmToStr(formatter, semiAxes.z(), 5, hudSettings.measurementSystem),
-                          DistanceKmToStr(formatter, semiAxes.y(), 5, hudSettings.measurementSystem));
+                          DistanceKmToStr(distances, semiAxes.x(), 5, hudSettings.measurementSystem),
+                          DistanceKmToStr(distances, semiAxes.z(), 5, hudSettings.measurementSystem),
+                          DistanceKmToStr(distances, semiAxes.y(), 5, hudSettings.measurementSystem));
         }
     }
     else
     {
         overlay.print(fmt::runtime(_("Radius: {}\n")),
-                      DistanceKmToStr(formatter, body.getRadius(), 5, hudSettings.measurementSystem));
+                      DistanceKmToStr(distances, body.getRadius(), 5, hudSettings.measurementSystem));
     }
 
     displayApparentDiameter(overlay, body.getRadius(), distanceKm, loc);
@@ -646,14 +696,14 @@ displayPlanetInfo(const util::NumberFormatter& formatter,
 }
 
 void
-displayLocationInfo(const util::NumberFormatter& formatter,
+displayLocationInfo(DistanceStrCache& distances,
                     Overlay& overlay,
                     const Location& location,
                     double distanceKm,
                     MeasurementSystem measurement,
                     const std::locale& loc)
 {
-    overlay.printf(_("Distance: %s\n"), DistanceKmToStr(formatter, distanceKm, 5, measurement));
+    overlay.printf(_("Distance: %s\n"), DistanceKmToStr(distances, distanceKm, 5, measurement));
 
     const Body* body = location.getParentBody();
     if (body == nullptr)
@@ -661,7 +711,7 @@ displayLocationInfo(const util::NumberFormatter& formatter,
 
     Eigen::Vector3f locPos = location.getPosition();
     Eigen::Vector3d lonLatAlt = body->cartesianToPlanetocentric(locPos.cast<double>());
-    displayPlanetocentricCoords(formatter, overlay, *body,
+    displayPlanetocentricCoords(distances, overlay, *body,
                                 lonLatAlt.x(), lonLatAlt.y(), lonLatAlt.z(), measurement, loc);
 }
 
@@ -687,7 +737,7 @@ std::string
 getBodySelectionNames(const Body& body)
 {
     std::string selectionNames = body.getLocalizedName(); // Primary name, might be localized
-    const std::vector<std::string>& names = body.getNames();
+    const auto& names = body.getNames();
 
     // Start from the second one because primary name is already in the string
     auto secondName = names.begin() + 1;
@@ -697,7 +747,7 @@ getBodySelectionNames(const Body& body)
         selectionNames += " / ";
 
         // Use localized version of parent name in alternative names.
-        std::string alias = *iter;
+        std::string alias = iter->str();
 
         const PlanetarySystem* parentSystem = body.getSystem();
         if (parentSystem == nullptr)
@@ -743,11 +793,12 @@ Hud::Hud(const std::locale& loc) :
     loc(loc),
 #ifdef USE_ICU
     m_dateFormatter(std::make_unique<celestia::engine::DateFormatter>()),
-    m_numberFormatter(std::make_unique<util::NumberFormatter>())
+    m_numberFormatter(std::make_unique<util::NumberFormatter>()),
 #else
     m_dateFormatter(std::make_unique<celestia::engine::DateFormatter>(loc)),
-    m_numberFormatter(std::make_unique<util::NumberFormatter>(loc))
+    m_numberFormatter(std::make_unique<util::NumberFormatter>(loc)),
 #endif
+    m_distanceStrs(std::make_unique<DistanceStrCache>(*m_numberFormatter))
 {
 }
 
@@ -776,6 +827,7 @@ Hud::dateFormat(astro::Date::Format format)
 {
     m_dateFormat = format;
     m_dateStrWidth = 0;
+    m_measuredDateStr.clear();
 }
 
 TextInput&
@@ -836,6 +888,7 @@ Hud::font(const std::shared_ptr<TextureFont>& f)
 {
     m_hudFonts.setFont(f);
     m_dateStrWidth = 0;
+    m_measuredDateStr.clear();
 }
 
 const std::shared_ptr<TextureFont>&
@@ -922,7 +975,13 @@ Hud::renderOverlay(const WindowMetrics& metrics,
         m_overlay->beginText();
         m_overlay->print("\n");
         if (m_hudSettings.showFPSCounter)
-            m_overlay->print(loc, fmt::runtime(_("FPS: {:.1f}\n")), timeInfo.fps);
+        {
+            // The latency is only known when the front end measures it
+            if (auto latency = engine::GetFrameStats()->getAverageInputLatency(); latency.has_value())
+                m_overlay->print(loc, fmt::runtime(_("FPS: {:.1f}, latency: {:.1f} ms\n")), timeInfo.fps, *latency);
+            else
+                m_overlay->print(loc, fmt::runtime(_("FPS: {:.1f}\n")), timeInfo.fps);
+        }
         else
             m_overlay->print("\n");
 
@@ -935,6 +994,9 @@ Hud::renderOverlay(const WindowMetrics& metrics,
     if (m_hudDetail > 0 && util::is_set(m_hudSettings.overlayElements, HudElements::ShowFrame))
         renderFrameInfo(metrics, sim);
 
+    if (m_hudDetail > 0 && m_hudSettings.showFPSCounter)
+        renderFrameTimes(metrics);
+
     if (Selection sel = sim->getSelection();
         !sel.empty() && m_hudDetail > 0 && util::is_set(m_hudSettings.overlayElements, HudElements::ShowSelection))
     {
@@ -943,7 +1005,10 @@ Hud::renderOverlay(const WindowMetrics& metrics,
     }
 
     if (util::is_set(m_textEnterMode, TextEnterMode::AutoComplete))
+    {
+        m_textInput.update();
         m_textInput.render(m_overlay.get(), m_hudFonts, metrics);
+    }
 
     if (m_hudSettings.showMessage)
         renderTextMessages(metrics, timeInfo.currentTime);
@@ -981,10 +1046,16 @@ Hud::renderTimeInfo(const WindowMetrics& metrics, const Simulation* sim, const T
     }
 
     double tdb = sim->getTime() + lt;
-    auto dateStr = m_dateFormatter->formatDate(tdb, timeInfo.timeZoneBias != 0, m_dateFormat);
-    auto fullDateStr = timeInfo.lightTravelFlag ? dateStr + _("  LT") : dateStr;
+    const auto& dateStr = m_dateFormatter->formatDate(tdb, timeInfo.timeZoneBias != 0, m_dateFormat);
 
-    m_dateStrWidth = std::max(m_dateStrWidth, engine::TextLayout::getTextWidth(fullDateStr, m_hudFonts.font().get()) + 2 * m_hudFonts.emWidth());
+    // The width only grows, so it only needs measuring for new strings
+    if (dateStr != m_measuredDateStr || timeInfo.lightTravelFlag != m_measuredLightTravel)
+    {
+        m_measuredDateStr = dateStr;
+        m_measuredLightTravel = timeInfo.lightTravelFlag;
+        auto fullDateStr = timeInfo.lightTravelFlag ? dateStr + _("  LT") : dateStr;
+        m_dateStrWidth = std::max(m_dateStrWidth, engine::TextLayout::getTextWidth(fullDateStr, m_hudFonts.font().get()) + 2 * m_hudFonts.emWidth());
+    }
 
     // Time and date
     m_overlay->savePos();
@@ -1100,6 +1171,40 @@ Hud::renderFrameInfo(const WindowMetrics& metrics, const Simulation* sim)
     m_overlay->restorePos();
 }
 
+// CPU and GPU times of the last frame below the time and date, to tell
+// whether the frame rate is limited by the CPU or the GPU
+void
+Hud::renderFrameTimes(const WindowMetrics& metrics)
+{
+    const engine::FrameCounters& counters = engine::GetFrameStats()->getLastFrame();
+    if (!counters.gpuTime.has_value())
+        return;
+
+    double cpuTime = 0.0;
+    for (double stageTime : counters.stageTimes)
+        cpuTime += stageTime;
+
+    m_overlay->savePos();
+    m_overlay->moveBy(metrics.getSafeAreaEnd(m_hudFonts.emWidth() * 15),
+                      metrics.getSafeAreaTop(m_hudFonts.fontHeight() * 4));
+    m_overlay->beginText();
+    m_overlay->setColor(0.7f, 0.7f, 1.0f, 1.0f);
+    m_overlay->print(loc, fmt::runtime(_("CPU: {:.1f} ms\n")), cpuTime);
+    m_overlay->print(loc, fmt::runtime(_("GPU: {:.1f} ms\n")), *counters.gpuTime);
+    if (counters.gpuStageTimes.has_value())
+    {
+        m_overlay->setColor(0.6f, 0.6f, 1.0f, 1.0f);
+        for (std::size_t i = 0; i < engine::GPUStageCount; ++i)
+        {
+            m_overlay->print(loc, "  {}: {:.2f} ms\n",
+                             engine::GetGPUStageName(static_cast<engine::GPUStage>(i)),
+                             (*counters.gpuStageTimes)[i]);
+        }
+    }
+    m_overlay->endText();
+    m_overlay->restorePos();
+}
+
 void
 Hud::renderSelectionInfo(const WindowMetrics& metrics,
                          const Simulation* sim,
@@ -1127,6 +1232,7 @@ Hud::renderSelectionInfo(const WindowMetrics& metrics,
             m_overlay->setFont(m_hudFonts.font());
             m_overlay->print("\n");
             displayStarInfo(*m_numberFormatter,
+                            *m_distanceStrs,
                             *m_overlay,
                              m_hudDetail,
                             *(sel.star()),
@@ -1149,7 +1255,7 @@ Hud::renderSelectionInfo(const WindowMetrics& metrics,
             m_overlay->print(m_selectionNames);
             m_overlay->setFont(m_hudFonts.font());
             m_overlay->print("\n");
-            displayDSOinfo(*m_numberFormatter,
+            displayDSOinfo(*m_distanceStrs,
                            *m_overlay,
                            *sel.deepsky(),
                             astro::kilometersToLightYears(v.norm()) - sel.deepsky()->getRadius(),
@@ -1172,6 +1278,7 @@ Hud::renderSelectionInfo(const WindowMetrics& metrics,
             m_overlay->setFont(m_hudFonts.font());
             m_overlay->print("\n");
             displayPlanetInfo(*m_numberFormatter,
+                              *m_distanceStrs,
                               *m_overlay,
                                m_hudDetail,
                               *(sel.body()),
@@ -1183,11 +1290,17 @@ Hud::renderSelectionInfo(const WindowMetrics& metrics,
         break;
 
     case SelectionType::Location:
+        if (sel != m_lastSelection)
+        {
+            m_lastSelection = sel;
+            m_selectionNames = sel.location()->getName(true);
+        }
+
         m_overlay->setFont(m_hudFonts.titleFont());
-        m_overlay->print(sel.location()->getName(true).c_str());
+        m_overlay->print(m_selectionNames);
         m_overlay->setFont(m_hudFonts.font());
         m_overlay->print("\n");
-        displayLocationInfo(*m_numberFormatter,
+        displayLocationInfo(*m_distanceStrs,
                             *m_overlay,
                             *(sel.location()),
                              v.norm(),
@@ -1314,6 +1427,13 @@ Hud::showText(const TextPrintPosition& position,
     m_messageDuration = duration;
 }
 
+bool
+Hud::isAnimating(double currentTime) const
+{
+    return currentTime < m_messageStart + m_messageDuration || m_hudSettings.showFPSCounter ||
+           (m_image != nullptr && m_image->isLoading());
+}
+
 void
 Hud::setImage(std::unique_ptr<OverlayImage>&& _image, double currentTime)
 {
@@ -41,6 +41,7 @@ class Simulation;
 namespace celestia
 {
 
+class DistanceStrCache;
 struct TimeInfo;
 class ViewManager;
 
@@ -156,12 +157,17 @@ public:
     void showText(const TextPrintPosition&, std::string_view, double duration, double currentTime);
     void setImage(std::unique_ptr<OverlayImage>&&, double);
 
+    // Whether the overlay changes over time by itself, with a text message
+    // shown, the frame rate counter or an image still loading
+    bool isAnimating(double currentTime) const;
+
     HudSettings& hudSettings() noexcept { return m_hudSettings; }
     const HudSettings& hudSettings() const noexcept { return m_hudSettings; }
 
 private:
     void renderTimeInfo(const WindowMetrics&, const Simulation*, const TimeInfo&);
     void renderFrameInfo(const WindowMetrics&, const Simulation*);
+    void renderFrameTimes(const WindowMetrics&);
     void renderSelectionInfo(const WindowMetrics&, const Simulation*, Selection, const Eigen::Vector3d&);
     void renderTextMessages(const WindowMetrics&, double);
     void renderMovieCapture(const WindowMetrics&, const MovieCapture&);
@@ -177,8 +183,11 @@ private:
 
     std::unique_ptr<engine::DateFormatter> m_dateFormatter;
     std::unique_ptr<const util::NumberFormatter> m_numberFormatter;
+    std::unique_ptr<DistanceStrCache> m_distanceStrs;
     celestia::astro::Date::Format m_dateFormat{ celestia::astro::Date::Locale };
     int m_dateStrWidth{ 0 };
+    std::string m_measuredDateStr;
+    bool m_measuredLightTravel{ false };
 
     int m_hudDetail{ 2 };
 
@@ -16,17 +16,26 @@
 #include <celestia/catalogloader.h>
 #include <celestia/configfile.h>
 #include <celestia/progressnotifier.h>
+#include <celestia/startupprofile.h>
+#include <celutil/fsutils.h>
 #include <celutil/gettext.h>
 #include <celutil/logger.h>
+#include <celutil/profiler.h>
 
 namespace celestia
 {
 using DeepSkyLoader = CatalogLoader<DSODatabaseBuilder>;
 
 std::unique_ptr<DSODatabase>
-loadDSO(const CelestiaConfig &config, ProgressNotifier *progressNotifier)
+loadDSO(const CelestiaConfig &config, ProgressNotifier *progressNotifier, StartupProfile *profile)
 {
+    CELESTIA_PROFILE_ZONE("loadDSO");
+
     auto dsoDB = std::make_unique<DSODatabaseBuilder>();
+#ifndef PORTABLE_BUILD
+    dsoDB->setOctreeCachePath(util::WriteableDataPath() / "cache" / "deepsky.octree");
+    dsoDB->setCatalogCacheDirectory(util::WriteableDataPath() / "cache" / "deepsky");
+#endif
 
     // TRANSLATORS: this is a part of phrases "Loading {} catalog", "Skipping {} catalog"
     const char *typeDesc = C_("catalog", "deep sky");
@@ -35,7 +44,8 @@ loadDSO(const CelestiaConfig &config, ProgressNotifier *progressNotifier)
                          typeDesc,
                          ContentType::CelestiaDeepSkyCatalog,
                          progressNotifier,
-                         config.paths.skipExtras);
+                         config.paths.skipExtras,
+                         profile);
 
     // Load first the vector of dsoCatalogFiles in the data directory (deepsky.dsc,
     // globulars.dsc, ...):
@@ -44,8 +54,12 @@ loadDSO(const CelestiaConfig &config, ProgressNotifier *progressNotifier)
         loader.process(file, empty);
 
     // Next, read all the deep sky files in the extras directories
-    loader.loadExtras(config.paths.extrasDirs);
+    {
+        StartupProfile::Scope scope(profile, "Deep sky add-ons");
+        loader.loadExtras(config.paths.extrasDirs);
+    }
 
+    StartupProfile::Scope scope(profile, "Deep sky database build");
     return dsoDB->finish();
 }
 
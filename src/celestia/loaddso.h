@@ -18,7 +18,10 @@ struct CelestiaConfig;
 namespace celestia
 {
 
+class StartupProfile;
+
 std::unique_ptr<DSODatabase> loadDSO(const CelestiaConfig &config,
-                                     ProgressNotifier     *progressNotifier);
+                                     ProgressNotifier     *progressNotifier,
+                                     StartupProfile       *profile = nullptr);
 
 } // namespace celestia
@@ -9,40 +9,83 @@
 
 #include "loadsso.h"
 
-#include <fstream>
+#include <cstddef>
 #include <memory>
+#include <string_view>
 
+#include <celengine/solarsys.h>
+#include <celengine/ssccache.h>
 #include <celengine/universe.h>
 #include <celestia/configfile.h>
 #include <celestia/progressnotifier.h>
 #include <celestia/catalogloader.h>
+#include <celestia/startupprofile.h>
+#include <celutil/fsutils.h>
 #include <celutil/gettext.h>
+#include <celutil/profiler.h>
 
 namespace celestia
 {
 
-using SolarSystemLoader = CatalogLoader<Universe>;
+namespace
+{
 
-template<> bool
-CatalogLoader<Universe>::load(std::istream &in, const fs::path &dir)
+// Parses the catalogs into the universe, through the compiled copies of the
+// catalogs kept in the cache
+class SolarSystemObjects
 {
-    return LoadSolarSystemObjects(in, *m_objDB, dir);
-}
+public:
+    SolarSystemObjects(Universe *universe, engine::SolarSystemCatalogCache *cache) :
+        m_universe(universe),
+        m_cache(cache)
+    {
+    }
+
+    bool load(std::string_view contents, const fs::path &dir)
+    {
+        return LoadSolarSystemObjects(contents, *m_universe, dir, m_cache, &m_objectCount);
+    }
+
+    // Objects left pending when loading lazily aren't counted
+    std::size_t size() const { return m_objectCount; }
+
+private:
+    Universe                        *m_universe;
+    engine::SolarSystemCatalogCache *m_cache;
+    std::size_t                      m_objectCount{ 0 };
+};
+
+using SolarSystemLoader = CatalogLoader<SolarSystemObjects>;
+
+} // end unnamed namespace
 
 void
-loadSSO(const CelestiaConfig &config, ProgressNotifier *progressNotifier, Universe *universe)
+loadSSO(const CelestiaConfig &config,
+        ProgressNotifier     *progressNotifier,
+        Universe             *universe,
+        StartupProfile       *profile)
 {
+    CELESTIA_PROFILE_ZONE("loadSSO");
+
     auto solarSystem = std::make_unique<SolarSystemCatalog>();
     universe->setSolarSystemCatalog(std::move(solarSystem));
+    // The definitions of lazily loaded solar systems are read back from the
+    // cache, so it is needed in this mode
+    universe->setPendingSolarSystems(config.lazySolarSystems
+                                     ? std::make_unique<PendingSolarSystems>(*universe)
+                                     : nullptr);
 
     // TRANSLATORS: this is a part of phrases "Loading {} catalog", "Skipping {} catalog"
     const char *typeDesc = C_("catalog", "solar system");
 
-    SolarSystemLoader loader(universe,
+    engine::SolarSystemCatalogCache cache(util::WriteableDataPath() / "cache" / "ssc");
+    SolarSystemObjects objects(universe, &cache);
+    SolarSystemLoader loader(&objects,
                              typeDesc,
                              ContentType::CelestiaCatalog,
                              progressNotifier,
-                             config.paths.skipExtras);
+                             config.paths.skipExtras,
+                             profile);
 
     // First read the solar system files listed individually in the config file.
     fs::path empty;
@@ -50,7 +93,14 @@ loadSSO(const CelestiaConfig &config, ProgressNotifier *progressNotifier, Univer
         loader.process(file, empty);
 
     // Next, read all the solar system files in the extras directories
-    loader.loadExtras(config.paths.extrasDirs);
+    {
+        StartupProfile::Scope scope(profile, "Solar system add-ons");
+        loader.loadExtras(config.paths.extrasDirs);
+    }
+    universe->catalogsChanged();
+
+    // Drop the compiled copies of catalogs which were changed or removed
+    cache.removeUnused();
 }
 
 } // namespace celestia
@@ -18,6 +18,11 @@ struct CelestiaConfig;
 namespace celestia
 {
 
-void loadSSO(const CelestiaConfig &config, ProgressNotifier *progressNotifier, Universe *universe);
+class StartupProfile;
+
+void loadSSO(const CelestiaConfig &config,
+             ProgressNotifier     *progressNotifier,
+             Universe             *universe,
+             StartupProfile       *profile = nullptr);
 
 } // namespace celestia
@@ -9,16 +9,22 @@
 
 #include "loadstars.h"
 
-#include <fstream>
+#include <system_error>
 
 #include <celcompat/filesystem.h>
+#include <celengine/pagedstarcatalog.h>
 #include <celengine/stardb.h>
 #include <celengine/stardbbuilder.h>
 #include <celestia/catalogloader.h>
 #include <celestia/configfile.h>
 #include <celestia/progressnotifier.h>
+#include <celestia/startupprofile.h>
+#include <celutil/fileaccesslog.h>
+#include <celutil/fsutils.h>
 #include <celutil/gettext.h>
 #include <celutil/logger.h>
+#include <celutil/profiler.h>
+#include <celutil/threadpool.h>
 
 namespace celestia
 {
@@ -29,25 +35,36 @@ namespace
 {
 
 void
-loadCrossIndex(StarNameDatabase& starNamesDB, StarCatalog catalog, const fs::path &filename)
+loadCrossIndex(StarNameDatabase& starNamesDB, StarCatalog catalog, const fs::path &filename, StartupProfile *profile)
 {
     if (filename.empty())
         return;
 
-    if (std::ifstream xrefFile(filename, std::ios::binary); xrefFile.good())
+    StartupProfile::Scope scope(profile, filename.string(), "catalog");
+    util::FileAccessScope access("catalog", filename);
+    std::error_code ec;
+    if (!fs::is_regular_file(filename, ec))
     {
-        if (!starNamesDB.loadCrossIndex(catalog, xrefFile))
-            util::GetLogger()->error(_("Error reading cross index {}\n"), filename);
-        else
-            util::GetLogger()->info(_("Loaded cross index {}\n"), filename);
+        access.setFailed();
+        return;
     }
+
+    // Sorted cross indexes are mapped rather than read
+    if (auto size = fs::file_size(filename, ec); !ec)
+        scope.addBytesRead(size);
+    if (!starNamesDB.loadCrossIndex(catalog, filename))
+        util::GetLogger()->error(_("Error reading cross index {}\n"), filename);
+    else
+        util::GetLogger()->info(_("Loaded cross index {}\n"), filename);
 }
 
 } // namespace
 
 std::unique_ptr<StarDatabase>
-loadStars(const CelestiaConfig &config, ProgressNotifier *progressNotifier)
+loadStars(const CelestiaConfig &config, ProgressNotifier *progressNotifier, StartupProfile *profile)
 {
+    CELESTIA_PROFILE_ZONE("loadStars");
+
     // First load the binary star database file. The majority of stars
     // will be defined here.
     StarDatabaseBuilder starDBBuilder;
@@ -56,26 +73,39 @@ loadStars(const CelestiaConfig &config, ProgressNotifier *progressNotifier)
         if (progressNotifier)
             progressNotifier->update(path.string());
 
-        if (std::ifstream starFile(path, std::ios::binary); starFile.good())
+        StartupProfile::Scope scope(profile, path.string(), "catalog");
+        util::FileAccessScope access("catalog", path);
+        std::error_code ec;
+        if (!fs::is_regular_file(path, ec))
         {
-            if (!starDBBuilder.loadBinary(starFile))
-            {
-                util::GetLogger()->error(_("Error reading stars file\n"));
-                return nullptr;
-            }
+            access.setFailed();
+            util::GetLogger()->error(_("Error opening {}\n"), path);
+            return nullptr;
         }
-        else
+
+        if (!starDBBuilder.loadBinary(path))
         {
-            util::GetLogger()->error(_("Error opening {}\n"), path);
+            access.setFailed();
+            util::GetLogger()->error(_("Error reading stars file\n"));
             return nullptr;
         }
+
+        if (auto size = fs::file_size(path, ec); !ec)
+            scope.addBytesRead(size);
+        scope.addObjects(starDBBuilder.size());
     }
 
     // Load star names
     std::unique_ptr<StarNameDatabase> starNameDB = nullptr;
-    if (std::ifstream starNamesFile(config.paths.starNamesFile); starNamesFile.good())
+    if (std::error_code ec; fs::is_regular_file(config.paths.starNamesFile, ec))
     {
-        starNameDB = StarNameDatabase::readNames(starNamesFile);
+        StartupProfile::Scope scope(profile, config.paths.starNamesFile.string(), "catalog");
+        util::FileAccessScope access("catalog", config.paths.starNamesFile);
+        if (auto size = fs::file_size(config.paths.starNamesFile, ec); !ec)
+            scope.addBytesRead(size);
+        // The names file is either text or a binary index made by
+        // makestarnames
+        starNameDB = StarNameDatabase::loadNames(config.paths.starNamesFile);
         if (starNameDB == nullptr)
             util::GetLogger()->error(_("Error reading star names file {}\n"),
                                      config.paths.starNamesFile);
@@ -88,11 +118,24 @@ loadStars(const CelestiaConfig &config, ProgressNotifier *progressNotifier)
     if (starNameDB == nullptr)
         starNameDB = std::make_unique<StarNameDatabase>();
 
-    loadCrossIndex(*starNameDB, StarCatalog::HenryDraper, config.paths.HDCrossIndexFile);
-    loadCrossIndex(*starNameDB, StarCatalog::SAO, config.paths.SAOCrossIndexFile);
+    loadCrossIndex(*starNameDB, StarCatalog::HenryDraper, config.paths.HDCrossIndexFile, profile);
+    loadCrossIndex(*starNameDB, StarCatalog::SAO, config.paths.SAOCrossIndexFile, profile);
 
     starDBBuilder.setNameDatabase(std::move(starNameDB));
 
+    if (auto &path = config.paths.pagedStarCatalogFile; !path.empty())
+    {
+        auto pagedCatalog = engine::PagedStarCatalog::open(path,
+                                                           static_cast<std::size_t>(config.pagedStarCatalogMemory) << 20U,
+                                                           util::GetThreadPool());
+        if (pagedCatalog != nullptr)
+            starDBBuilder.setPagedCatalog(std::move(pagedCatalog));
+    }
+
+#ifndef PORTABLE_BUILD
+    starDBBuilder.setOctreeCachePath(util::WriteableDataPath() / "cache" / "stars.octree");
+#endif
+
     // TRANSLATORS: this is a part of phrases "Loading {} catalog", "Skipping {} catalog"
     const char *typeDesc = C_("catalog", "star");
 
@@ -100,7 +143,8 @@ loadStars(const CelestiaConfig &config, ProgressNotifier *progressNotifier)
                       typeDesc,
                       ContentType::CelestiaStarCatalog,
                       progressNotifier,
-                      config.paths.skipExtras);
+                      config.paths.skipExtras,
+                      profile);
 
     // Next, read any ASCII star catalog files specified in the StarCatalogs list.
     fs::path empty;
@@ -108,8 +152,12 @@ loadStars(const CelestiaConfig &config, ProgressNotifier *progressNotifier)
         loader.process(file, empty);
 
     // Now, read supplemental star files from the extras directories
-    loader.loadExtras(config.paths.extrasDirs);
+    {
+        StartupProfile::Scope scope(profile, "Star add-ons");
+        loader.loadExtras(config.paths.extrasDirs);
+    }
 
+    StartupProfile::Scope scope(profile, "Star database build");
     return starDBBuilder.finish();
 }
 
@@ -18,7 +18,10 @@ struct CelestiaConfig;
 namespace celestia
 {
 
+class StartupProfile;
+
 std::unique_ptr<StarDatabase> loadStars(const CelestiaConfig &config,
-                                        ProgressNotifier     *progressNotifier);
+                                        ProgressNotifier     *progressNotifier,
+                                        StartupProfile       *profile = nullptr);
 
 } // namespace celestia
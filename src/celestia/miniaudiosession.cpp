@@ -1,4 +1,5 @@
 #include "miniaudiosession.h"
+#include <memory>
 #include <celutil/logger.h>
 
 #define MINIAUDIO_IMPLEMENTATION
@@ -9,6 +10,80 @@ using namespace celestia::util;
 namespace celestia
 {
 
+// The device and the engine are shared by all the sessions, as opening the
+// device takes long enough to stall the frame which starts a sound. They
+// are released with the last session.
+class MiniAudioEngine
+{
+ public:
+    ~MiniAudioEngine();
+
+    MiniAudioEngine(const MiniAudioEngine&) = delete;
+    MiniAudioEngine(MiniAudioEngine&&)      = delete;
+    MiniAudioEngine &operator=(const MiniAudioEngine&) = delete;
+    MiniAudioEngine &operator=(MiniAudioEngine&&) = delete;
+
+    static std::shared_ptr<MiniAudioEngine> get();
+
+    ma_engine *engine() { return &m_engine; }
+
+ private:
+    MiniAudioEngine() = default;
+
+    bool init();
+
+    ma_context m_context;
+    ma_engine m_engine;
+    bool m_initialized  { false };
+};
+
+MiniAudioEngine::~MiniAudioEngine()
+{
+    if (m_initialized)
+    {
+        ma_engine_uninit(&m_engine);
+        ma_context_uninit(&m_context);
+    }
+}
+
+std::shared_ptr<MiniAudioEngine> MiniAudioEngine::get()
+{
+    static std::weak_ptr<MiniAudioEngine> shared;
+    if (auto engine = shared.lock(); engine != nullptr)
+        return engine;
+
+    std::shared_ptr<MiniAudioEngine> engine(new MiniAudioEngine);
+    if (!engine->init())
+        return nullptr;
+
+    shared = engine;
+    return engine;
+}
+
+bool MiniAudioEngine::init()
+{
+    auto config = ma_context_config_init();
+    // on iOS, explicitly set the correct category for correct routing
+    config.coreaudio.sessionCategory = ma_ios_session_category_playback;
+    ma_result result = ma_context_init(nullptr, 0, &config, &m_context);
+    if (result != MA_SUCCESS)
+    {
+        GetLogger()->error("Failed to init miniaudio context");
+        return false;
+    }
+    auto engineConfig = ma_engine_config_init();
+    engineConfig.pContext = &m_context;
+    result = ma_engine_init(&engineConfig, &m_engine);
+    if (result != MA_SUCCESS)
+    {
+        ma_context_uninit(&m_context);
+        GetLogger()->error("Failed to start miniaudio engine");
+        return false;
+    }
+    m_initialized = true;
+    return true;
+}
+
 class MiniAudioSessionPrivate
 {
  public:
@@ -28,8 +103,7 @@ class MiniAudioSessionPrivate
     MiniAudioSessionPrivate &operator=(const MiniAudioSessionPrivate&) = delete;
     MiniAudioSessionPrivate &operator=(MiniAudioSessionPrivate&&) = delete;
 
-    ma_context context;
-    ma_engine engine;
+    std::shared_ptr<MiniAudioEngine> engine;
     ma_sound sound;
     State state         { State::NotInitialized };
 };
@@ -44,8 +118,6 @@ MiniAudioSessionPrivate::~MiniAudioSessionPrivate()
     case State::SoundInitialzied:
         ma_sound_uninit(&sound);
     case State::EngineStarted:
-        ma_engine_uninit(&engine);
-        ma_context_uninit(&context);
     case State::NotInitialized:
         break;
     }
@@ -59,70 +131,53 @@ MiniAudioSession::MiniAudioSession(const fs::path &path, float volume, float pan
 
 MiniAudioSession::~MiniAudioSession() = default;
 
-bool MiniAudioSession::play(double startTime)
+bool MiniAudioSession::preload()
 {
-    ma_result result;
-    switch (p->state)
-    {
-    case MiniAudioSessionPrivate::State::NotInitialized:
-        // start the engine
-        if (!startEngine())
-            return false;
-        p->state = MiniAudioSessionPrivate::State::EngineStarted;
+    if (p->state >= MiniAudioSessionPrivate::State::SoundInitialzied)
+        return true;
 
-    case MiniAudioSessionPrivate::State::EngineStarted:
-        // load sound file from disk
-        result = ma_sound_init_from_file(&p->engine, path().string().c_str(), MA_SOUND_FLAG_ASYNC, nullptr, nullptr, &p->sound);
-        if (result != MA_SUCCESS)
-        {
-            GetLogger()->error("Failed to load sound file {}", path());
-            return false;
-        }
-        ma_sound_set_volume(&p->sound, volume());
-        ma_sound_set_pan(&p->sound, pan());
-        ma_sound_set_looping(&p->sound, loop() ? MA_TRUE : MA_FALSE);
-        p->state = MiniAudioSessionPrivate::State::SoundInitialzied;
+    if (!startEngine())
+        return false;
 
-    case MiniAudioSessionPrivate::State::SoundInitialzied:
-        // start playing, seek if needed
-        if (startTime >= 0 && !seek(startTime))
-            return false;
+    // The file is opened and decoded page by page by the job thread of the
+    // engine, so that neither blocks the caller and long narrations aren't
+    // decoded to memory as a whole
+    ma_result result = ma_sound_init_from_file(p->engine->engine(), path().string().c_str(),
+                                               MA_SOUND_FLAG_STREAM | MA_SOUND_FLAG_ASYNC,
+                                               nullptr, nullptr, &p->sound);
+    if (result != MA_SUCCESS)
+    {
+        GetLogger()->error("Failed to load sound file {}", path());
+        return false;
+    }
+    ma_sound_set_volume(&p->sound, volume());
+    ma_sound_set_pan(&p->sound, pan());
+    ma_sound_set_looping(&p->sound, loop() ? MA_TRUE : MA_FALSE);
+    p->state = MiniAudioSessionPrivate::State::SoundInitialzied;
+    return true;
+}
 
-        result = ma_sound_start(&p->sound);
-        if (result != MA_SUCCESS)
-        {
-            GetLogger()->error("Failed to start playing sound file {}", path());
-            return false;
-        }
+bool MiniAudioSession::play(double startTime)
+{
+    if (!preload())
+        return false;
 
-        p->state = MiniAudioSessionPrivate::State::Playing;
-        return true;
+    // seek if needed, whether or not the sound is already playing
+    if (startTime >= 0 && !seek(startTime))
+        return false;
 
-    case MiniAudioSessionPrivate::State::Playing:
-        if (!isPlaying())
-        {
-            // not playing, start playing and seek if needed
-            if (startTime >= 0 && !seek(startTime))
-                return false;
-
-            result = ma_sound_start(&p->sound);
-            if (result != MA_SUCCESS)
-            {
-                GetLogger()->error("Failed to start playing sound file {}", path());
-                return false;
-            }
-            p->state = MiniAudioSessionPrivate::State::Playing;
-            return true;
-        }
-        // already playing, seek if needed
-        if (startTime >= 0 && !seek(startTime))
-            return false;
+    if (isPlaying())
         return true;
 
-    default:
-        GetLogger()->error("Unknown miniaudio session state {}", static_cast<int>(p->state));
+    ma_result result = ma_sound_start(&p->sound);
+    if (result != MA_SUCCESS)
+    {
+        GetLogger()->error("Failed to start playing sound file {}", path());
         return false;
     }
+
+    p->state = MiniAudioSessionPrivate::State::Playing;
+    return true;
 }
 
 bool MiniAudioSession::isPlaying() const
@@ -152,7 +207,7 @@ bool MiniAudioSession::seek(double seconds)
 {
     if (p->state >= MiniAudioSessionPrivate::State::SoundInitialzied)
     {
-        ma_result result = ma_sound_seek_to_pcm_frame(&p->sound, static_cast<ma_uint64>(seconds * ma_engine_get_sample_rate(&p->engine)));
+        ma_result result = ma_sound_seek_to_pcm_frame(&p->sound, static_cast<ma_uint64>(seconds * ma_engine_get_sample_rate(p->engine->engine())));
         if (result != MA_SUCCESS)
         {
             GetLogger()->error("Failed to seek to {}", seconds);
@@ -185,24 +240,10 @@ bool MiniAudioSession::startEngine()
     if (p->state >= MiniAudioSessionPrivate::State::EngineStarted)
         return true;
 
-    auto config = ma_context_config_init();
-    // on iOS, explicitly set the correct category for correct routing
-    config.coreaudio.sessionCategory = ma_ios_session_category_playback;
-    ma_result result = ma_context_init(nullptr, 0, &config, &p->context);
-    if (result != MA_SUCCESS)
-    {
-        GetLogger()->error("Failed to init miniaudio context");
+    p->engine = MiniAudioEngine::get();
+    if (p->engine == nullptr)
         return false;
-    }
-    auto engineConfig = ma_engine_config_init();
-    engineConfig.pContext = &p->context;
-    result = ma_engine_init(&engineConfig, &p->engine);
-    if (result != MA_SUCCESS)
-    {
-        ma_context_uninit(&p->context);
-        GetLogger()->error("Failed to start miniaudio engine");
-        return false;
-    }
+
     p->state = MiniAudioSessionPrivate::State::EngineStarted;
     return true;
 }
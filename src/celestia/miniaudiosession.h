@@ -20,6 +20,7 @@ class MiniAudioSession: public AudioSession
     MiniAudioSession &operator=(const MiniAudioSession&) = delete;
     MiniAudioSession &operator=(MiniAudioSession&&) = delete;
 
+    bool preload() override;
     bool play(double startTime) override;
     bool isPlaying() const override;
     void stop() override;
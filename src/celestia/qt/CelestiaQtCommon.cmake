@@ -29,6 +29,7 @@ function(GetQtSources UseWayland)
   set(REL_QT_HEADERS
     qtappwin.h
     qtbookmark.h
+    qtbrowserquery.h
     qtcelestialbrowser.h
     qtcelestiaactions.h
     qtcolorswatchwidget.h
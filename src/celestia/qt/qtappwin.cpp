@@ -328,9 +328,22 @@ CelestiaAppWindow::init(const CelestiaCommandLineOptions& options)
     {
         glformat.setSamples(m_appCore->getConfig()->renderDetails.aaSamples);
     }
+
+    // Offline rendering neither waits for the display nor paces frames
+    batchMode = options.batchTimeStep > 0.0;
+    if (batchMode)
+    {
+        m_appCore->setFixedTimeStep(options.batchTimeStep);
+        glformat.setSwapInterval(0);
+    }
+    else if (!m_appCore->getConfig()->renderDetails.VSync)
+    {
+        glformat.setSwapInterval(0);
+    }
     QSurfaceFormat::setDefaultFormat(glformat);
 
     glWidget = new CelestiaGlWidget(nullptr, "Celestia", m_appCore);
+    glWidget->setLowLatency(!batchMode && m_appCore->getConfig()->renderDetails.LowLatency);
 
     m_appCore->setCursorHandler(glWidget);
     m_appCore->setContextMenuHandler(this);
@@ -652,8 +665,25 @@ CelestiaAppWindow::saveBookmarks()
 void
 CelestiaAppWindow::celestia_tick()
 {
+    if (!batchMode && glWidget->ticksBeforeDraw())
+    {
+        glWidget->update();
+        return;
+    }
+
     m_appCore->tick();
-    glWidget->update();
+    if (!batchMode)
+    {
+        // Only repaint when something has changed in render on demand mode
+        if (m_appCore->viewUpdateRequired())
+            glWidget->update();
+        return;
+    }
+
+    // Every step of time is rendered before the next one
+    glWidget->repaint();
+    if (!m_appCore->isScriptRunning())
+        close();
 }
 
 void
@@ -740,15 +770,34 @@ CelestiaAppWindow::slotCaptureVideo()
         codecCombo->addItem(_("Lossless"), AV_CODEC_ID_FFVHUFF);
         codecCombo->addItem(_("Lossy (H.264)"), AV_CODEC_ID_H264);
 
+        // Hardware encoders are only used for the lossy codec
+        const CelestiaConfig* config = m_appCore->getConfig();
+        QComboBox* encoderCombo = new QComboBox(&videoInfoDialog);
+        layout->addWidget(new QLabel(_("Encoder:"), &videoInfoDialog), 3, 0);
+        layout->addWidget(encoderCombo, 3, 1);
+        encoderCombo->addItem(_("Software"), QString());
+        for (const std::string& encoder : FFMPEGCapture::getHardwareEncoders(AV_CODEC_ID_H264))
+        {
+            encoderCombo->addItem(QString::fromStdString(encoder), QString::fromStdString(encoder));
+            if (encoder == config->hardwareEncoder)
+                encoderCombo->setCurrentIndex(encoderCombo->count() - 1);
+        }
+        encoderCombo->setEnabled(false);
+        connect(codecCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), encoderCombo,
+                [codecCombo, encoderCombo](int index)
+                {
+                    encoderCombo->setEnabled(codecCombo->itemData(index).toInt() == AV_CODEC_ID_H264);
+                });
+
         QLineEdit* bitrateEdit = new QLineEdit("400000", &videoInfoDialog);
         bitrateEdit->setInputMask("D000000000");
-        layout->addWidget(new QLabel(_("Bitrate:"), &videoInfoDialog), 3, 0);
-        layout->addWidget(bitrateEdit, 3, 1);
+        layout->addWidget(new QLabel(_("Bitrate:"), &videoInfoDialog), 4, 0);
+        layout->addWidget(bitrateEdit, 4, 1);
 
         QDialogButtonBox* buttons = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, Qt::Horizontal, &videoInfoDialog);
         connect(buttons, SIGNAL(accepted()), &videoInfoDialog, SLOT(accept()));
         connect(buttons, SIGNAL(rejected()), &videoInfoDialog, SLOT(reject()));
-        layout->addWidget(buttons, 4, 0, 1, 2);
+        layout->addWidget(buttons, 5, 0, 1, 2);
 
         videoInfoDialog.setLayout(layout);
 
@@ -758,14 +807,24 @@ CelestiaAppWindow::slotCaptureVideo()
             float frameRate = frameRateCombo->itemData(frameRateCombo->currentIndex()).toFloat();
             AVCodecID vc = static_cast<AVCodecID>(codecCombo->itemData(codecCombo->currentIndex()).toInt());
             int br = bitrateEdit->text().toLongLong();
+            std::string encoder = vc == AV_CODEC_ID_H264 ? encoderCombo->currentData().toString().toStdString() : std::string();
 
             auto *movieCapture = new FFMPEGCapture(m_appCore->getRenderer());
             movieCapture->setVideoCodec(vc);
             movieCapture->setBitRate(br);
-            if (vc == AV_CODEC_ID_H264)
-                movieCapture->setEncoderOptions(m_appCore->getConfig()->x264EncoderOptions);
+            if (!encoder.empty())
+            {
+                movieCapture->setHardwareEncoder(encoder, config->hardwareEncoderDevice);
+                movieCapture->setEncoderOptions(config->hardwareEncoderOptions);
+            }
+            else if (vc == AV_CODEC_ID_H264)
+            {
+                movieCapture->setEncoderOptions(config->x264EncoderOptions);
+            }
             else
-                movieCapture->setEncoderOptions(m_appCore->getConfig()->ffvhEncoderOptions);
+            {
+                movieCapture->setEncoderOptions(config->ffvhEncoderOptions);
+            }
 
             bool ok = movieCapture->start(saveAsName.toStdString(),
                                           videoSize.width(), videoSize.height(),
@@ -1302,6 +1361,35 @@ CelestiaAppWindow::slotShowGLInfo()
         out << "<br>\n";
     }
 
+    // Counters of the last frame drawn and the memory held by the renderer
+    std::map<std::string, double> stats;
+    m_appCore->getRenderer()->getFrameStats(stats);
+
+    out << "<br>\n";
+    out << QString(_("<b>Draw calls:</b> %1 (%2 vertices)"))
+               .arg(stats["DrawCalls"]).arg(stats["VerticesSubmitted"], 0, 'f', 0);
+    out << "<br>\n";
+    out << QString(_("<b>Stars processed:</b> %1")).arg(stats["StarsProcessed"]);
+    out << "<br>\n";
+    out << QString(_("<b>DSOs processed:</b> %1 (%2 culled)")).arg(stats["DSOsProcessed"]).arg(stats["DSOsCulled"]);
+    out << "<br>\n";
+    out << QString(_("<b>Render list size:</b> %1 (%2 depth partitions)"))
+               .arg(stats["RenderListSize"]).arg(stats["DepthPartitions"]);
+    out << "<br>\n";
+    out << QString(_("<b>Orbit cache:</b> %1 hits, %2 misses, %3 KiB"))
+               .arg(stats["OrbitCacheHits"]).arg(stats["OrbitCacheMisses"])
+               .arg(stats["OrbitCacheMemory"] / 1024.0, 0, 'f', 0);
+    out << "<br>\n";
+    out << QString(_("<b>Shader compiles:</b> %1")).arg(stats["ShaderCompiles"]);
+    out << "<br>\n";
+    out << QString(_("<b>Texture uploads:</b> %1 (%2 KiB)"))
+               .arg(stats["TextureUploads"]).arg(stats["TextureUploadBytes"] / 1024.0, 0, 'f', 0);
+    out << "<br>\n";
+    out << QString(_("<b>Texture memory:</b> %1 MiB")).arg(stats["TextureMemory"] / 1048576.0, 0, 'f', 1);
+    out << "<br>\n";
+    out << QString(_("<b>Geometry memory:</b> %1 MiB")).arg(stats["GeometryMemory"] / 1048576.0, 0, 'f', 1);
+    out << "<br>\n";
+
 
     out << "<br>\n";
 
@@ -1680,7 +1768,7 @@ CelestiaAppWindow::setCheckedFPS()
 void
 CelestiaAppWindow::setFPS(int fps)
 {
-    timer->setInterval(fps_to_ms(fps));
+    timer->setInterval(batchMode ? 0 : fps_to_ms(fps));
     fpsActions->updateFPS(fps);
 }
 
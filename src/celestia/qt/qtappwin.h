@@ -176,6 +176,7 @@ private:
     QString m_dataHome;
 
     QTimer *timer;
+    bool batchMode{ false };
 };
 
 } // end namespace celestia::qt
@@ -0,0 +1,114 @@
+// qtbrowserquery.h
+//
+// Copyright (C) 2025-present, the Celestia Development Team
+//
+// Background queries for the object browser models.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <Qt>
+#include <QMetaObject>
+#include <QObject>
+
+#include <celutil/threadpool.h>
+
+namespace celestia::qt
+{
+
+// Runs the queries of a browser model on the thread pool and hands their
+// results to the thread of the model. Starting a query supersedes the
+// previous one, whose results are dropped. The query runs while the GUI
+// thread renders, so it must only read the catalogs and the values
+// captured when it was started.
+class BrowserQuery
+{
+public:
+    BrowserQuery() = default;
+    ~BrowserQuery();
+
+    BrowserQuery(const BrowserQuery&) = delete;
+    BrowserQuery& operator=(const BrowserQuery&) = delete;
+    BrowserQuery(BrowserQuery&&) = delete;
+    BrowserQuery& operator=(BrowserQuery&&) = delete;
+
+    // Run query() on a worker, then deliver(result) in the thread of
+    // receiver, unless another query was started in the meantime
+    template<typename Q, typename D>
+    void start(QObject* receiver, Q&& query, D&& deliver);
+
+    bool isRunning() const { return m_running; }
+
+private:
+    void cancel();
+
+    std::shared_ptr<std::atomic<bool>> m_cancelled;
+    std::vector<std::future<void>> m_pending;
+    bool m_running{ false };
+};
+
+inline
+BrowserQuery::~BrowserQuery()
+{
+    // The workers post to the receiver, which must outlive them
+    cancel();
+    for (auto& pending : m_pending)
+        pending.wait();
+}
+
+inline void
+BrowserQuery::cancel()
+{
+    if (m_cancelled != nullptr)
+        m_cancelled->store(true);
+    m_running = false;
+
+    m_pending.erase(std::remove_if(m_pending.begin(), m_pending.end(),
+                                   [](const auto& pending)
+                                   {
+                                       return pending.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+                                   }),
+                    m_pending.end());
+}
+
+template<typename Q, typename D>
+void
+BrowserQuery::start(QObject* receiver, Q&& query, D&& deliver)
+{
+    cancel();
+    auto cancelled = std::make_shared<std::atomic<bool>>(false);
+    m_cancelled = cancelled;
+    m_running = true;
+
+    m_pending.push_back(util::GetThreadPool()->async(
+        [this, receiver, cancelled, query = std::forward<Q>(query), deliver = std::forward<D>(deliver)]() mutable
+        {
+            auto result = query();
+            if (cancelled->load())
+                return;
+
+            QMetaObject::invokeMethod(receiver,
+                                      [this, cancelled, result = std::move(result), deliver = std::move(deliver)]() mutable
+                                      {
+                                          if (cancelled->load())
+                                              return;
+                                          m_running = false;
+                                          deliver(std::move(result));
+                                      },
+                                      Qt::QueuedConnection);
+        }));
+}
+
+} // end namespace celestia::qt
@@ -13,9 +13,12 @@
 #include "qtcelestialbrowser.h"
 
 #include <algorithm>
+#include <cstddef>
 #include <cstring>
+#include <functional>
 #include <set>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <Eigen/Core>
@@ -62,6 +65,7 @@
 #include <celutil/flag.h>
 #include <celutil/gettext.h>
 #include <celutil/greek.h>
+#include "qtbrowserquery.h"
 #include "qtcolorswatchwidget.h"
 #include "qtinfopanel.h"
 
@@ -81,6 +85,18 @@ struct StarFilter
 #endif
 };
 
+// Number of rows added to the view at a time
+constexpr std::size_t FetchRowCount = 100;
+
+// A row of the table, with the values computed when it was populated
+struct StarRecord
+{
+    const Star* star;
+    float distance;
+    float appMag;
+    QString name;
+};
+
 } // end unnamed namespace
 
 class CelestialBrowser::StarTableModel : public QAbstractTableModel, public ModelHelper
@@ -104,28 +120,39 @@ public:
     int rowCount(const QModelIndex& index) const override;
     int columnCount(const QModelIndex& index) const override;
     void sort(int column, Qt::SortOrder order) override;
+    bool canFetchMore(const QModelIndex& parent) const override;
+    void fetchMore(const QModelIndex& parent) override;
 
     // Methods from ModelHelper
     Selection itemForInfoPanel(const QModelIndex&) override;
 
+    // The stars are searched on a worker thread, then populated is called
+    // and the rows are added as the view fetches them
     void populate(const UniversalCoord& _observerPos,
                   double _now,
                   const StarFilter& filter,
-                  engine::StarBrowser::Comparison comparison);
+                  engine::StarBrowser::Comparison comparison,
+                  const std::function<void()>& populated);
 
     Selection itemAtRow(unsigned int row) const;
+    int resultCount() const { return static_cast<int>(records.size()); }
 
 private:
-    bool compareByName(const engine::StarBrowserRecord&, const engine::StarBrowserRecord&) const;
-    bool compareByDistance(const engine::StarBrowserRecord&, const engine::StarBrowserRecord&) const;
-    bool compareByAppMag(const engine::StarBrowserRecord&, const engine::StarBrowserRecord&) const;
-    bool compareByAbsMag(const engine::StarBrowserRecord&, const engine::StarBrowserRecord&) const;
-    bool compareBySpectralType(const engine::StarBrowserRecord&, const engine::StarBrowserRecord&) const;
+    bool compareByName(const StarRecord&, const StarRecord&) const;
+    bool compareByDistance(const StarRecord&, const StarRecord&) const;
+    bool compareByAppMag(const StarRecord&, const StarRecord&) const;
+    bool compareByAbsMag(const StarRecord&, const StarRecord&) const;
+    bool compareBySpectralType(const StarRecord&, const StarRecord&) const;
+
+    void setRecords(std::vector<StarRecord>&&);
 
     QCollator coll;
     engine::StarBrowser starBrowser;
     const Universe* universe;
-    std::vector<engine::StarBrowserRecord> records;
+    std::vector<StarRecord> records;
+    std::size_t fetchedRows{ 0 };
+    // Destroyed first, so that no query delivers to a destroyed model
+    BrowserQuery query;
 };
 
 CelestialBrowser::StarTableModel::StarTableModel(const Universe* _universe) :
@@ -155,13 +182,13 @@ QVariant
 CelestialBrowser::StarTableModel::data(const QModelIndex& index, int role) const
 {
     int row = index.row();
-    if (row < 0 || row >= (int) records.size())
+    if (row < 0 || row >= (int) fetchedRows)
     {
         // Out of range
         return QVariant();
     }
 
-    const engine::StarBrowserRecord& record = records[row];
+    const StarRecord& record = records[row];
 
     switch (role)
     {
@@ -169,10 +196,7 @@ CelestialBrowser::StarTableModel::data(const QModelIndex& index, int role) const
         switch (index.column())
         {
         case NameColumn:
-            {
-                std::string starNameString = ReplaceGreekLetterAbbr(universe->getStarCatalog()->getStarName(*record.star, true));
-                return QString::fromStdString(starNameString);
-            }
+            return record.name;
         case DistanceColumn:
             return record.distance < 0.001f
                 ? QString("%L1").arg(record.distance, 0, 'g')
@@ -243,7 +267,7 @@ CelestialBrowser::StarTableModel::headerData(int section, Qt::Orientation /* ori
 int
 CelestialBrowser::StarTableModel::rowCount(const QModelIndex& /*unused*/) const
 {
-    return (int) records.size();
+    return (int) fetchedRows;
 }
 
 // Override QAbstractDataModel::columnCount()
@@ -261,37 +285,36 @@ CelestialBrowser::StarTableModel::itemForInfoPanel(const QModelIndex& _index)
 }
 
 bool
-CelestialBrowser::StarTableModel::compareByName(const engine::StarBrowserRecord& lhs,
-                                                const engine::StarBrowserRecord& rhs) const
+CelestialBrowser::StarTableModel::compareByName(const StarRecord& lhs,
+                                                const StarRecord& rhs) const
 {
-    return coll.compare(QString::fromUtf8(universe->getStarCatalog()->getStarName(*lhs.star, true).c_str()),
-                        QString::fromUtf8(universe->getStarCatalog()->getStarName(*rhs.star, true).c_str())) < 0;
+    return coll.compare(lhs.name, rhs.name) < 0;
 }
 
 bool
-CelestialBrowser::StarTableModel::compareByDistance(const engine::StarBrowserRecord& lhs,
-                                                    const engine::StarBrowserRecord& rhs) const
+CelestialBrowser::StarTableModel::compareByDistance(const StarRecord& lhs,
+                                                    const StarRecord& rhs) const
 {
     return lhs.distance < rhs.distance;
 }
 
 bool
-CelestialBrowser::StarTableModel::compareByAppMag(const engine::StarBrowserRecord& lhs,
-                                                  const engine::StarBrowserRecord& rhs) const
+CelestialBrowser::StarTableModel::compareByAppMag(const StarRecord& lhs,
+                                                  const StarRecord& rhs) const
 {
     return lhs.appMag < rhs.appMag;
 }
 
 bool
-CelestialBrowser::StarTableModel::compareByAbsMag(const engine::StarBrowserRecord& lhs,
-                                                  const engine::StarBrowserRecord& rhs) const
+CelestialBrowser::StarTableModel::compareByAbsMag(const StarRecord& lhs,
+                                                  const StarRecord& rhs) const
 {
     return lhs.star->getAbsoluteMagnitude() < rhs.star->getAbsoluteMagnitude();
 }
 
 bool
-CelestialBrowser::StarTableModel::compareBySpectralType(const engine::StarBrowserRecord& lhs,
-                                                        const engine::StarBrowserRecord& rhs) const
+CelestialBrowser::StarTableModel::compareBySpectralType(const StarRecord& lhs,
+                                                        const StarRecord& rhs) const
 {
     return std::strcmp(lhs.star->getSpectralType(), rhs.star->getSpectralType()) < 0;
 }
@@ -303,7 +326,7 @@ CelestialBrowser::StarTableModel::sort(int column, Qt::SortOrder order)
     if (records.empty())
         return;
 
-    bool (StarTableModel::*compareFn)(const engine::StarBrowserRecord&, const engine::StarBrowserRecord&) const = nullptr;
+    bool (StarTableModel::*compareFn)(const StarRecord&, const StarRecord&) const = nullptr;
     switch (column)
     {
     case NameColumn:
@@ -336,7 +359,28 @@ CelestialBrowser::StarTableModel::sort(int column, Qt::SortOrder order)
                   [this, compareFn](const auto& a, const auto& b) { return (this->*compareFn)(b, a); });
     }
 
-    dataChanged(index(0, 0), index(static_cast<int>(records.size() - 1), 4));
+    if (fetchedRows > 0)
+        dataChanged(index(0, 0), index(static_cast<int>(fetchedRows - 1), 4));
+}
+
+// Override QAbstractItemModel::canFetchMore()
+bool
+CelestialBrowser::StarTableModel::canFetchMore(const QModelIndex& parent) const
+{
+    return !parent.isValid() && fetchedRows < records.size();
+}
+
+// Override QAbstractItemModel::fetchMore()
+void
+CelestialBrowser::StarTableModel::fetchMore(const QModelIndex& parent)
+{
+    if (parent.isValid() || fetchedRows >= records.size())
+        return;
+
+    std::size_t count = std::min(FetchRowCount, records.size() - fetchedRows);
+    beginInsertRows(QModelIndex(), static_cast<int>(fetchedRows), static_cast<int>(fetchedRows + count - 1));
+    fetchedRows += count;
+    endInsertRows();
 }
 
 void
@@ -361,25 +405,49 @@ CelestialBrowser::StarTableModel::populate(const UniversalCoord& _observerPos,
     starBrowser.setComparison(comparison);
     starBrowser.setPosition(_observerPos);
     starBrowser.setTime(_now);
+    // The worker must not evaluate orbits which the renderer is using
+    starBrowser.snapshotPositions();
 
     // Clear out the results of the previous populate() call
-    if (!records.empty())
-    {
-        beginResetModel();
-        records.clear();
-        endResetModel();
-    }
+    setRecords({});
 
-    starBrowser.populate(records);
+    query.start(this,
+                [browser = starBrowser, stardb = universe->getStarCatalog()]
+                {
+                    std::vector<engine::StarBrowserRecord> found;
+                    browser.populate(found);
 
-    beginInsertRows(QModelIndex(), 0, static_cast<int>(records.size()));
-    endInsertRows();
+                    std::vector<StarRecord> result;
+                    result.reserve(found.size());
+                    for (const auto& record : found)
+                    {
+                        std::string name = ReplaceGreekLetterAbbr(stardb->getStarName(*record.star, true));
+                        result.push_back({ record.star, record.distance, record.appMag, QString::fromStdString(name) });
+                    }
+
+                    return result;
+                },
+                [this, populated](std::vector<StarRecord>&& result)
+                {
+                    setRecords(std::move(result));
+                    if (populated)
+                        populated();
+                });
+}
+
+void
+CelestialBrowser::StarTableModel::setRecords(std::vector<StarRecord>&& newRecords)
+{
+    beginResetModel();
+    records = std::move(newRecords);
+    fetchedRows = 0;
+    endResetModel();
 }
 
 Selection
 CelestialBrowser::StarTableModel::itemAtRow(unsigned int row) const
 {
-    if (row >= records.size())
+    if (row >= fetchedRows)
         return Selection();
     else
         return Selection(const_cast<Star*>(records[row].star)); //NOSONAR
@@ -572,13 +640,15 @@ CelestialBrowser::slotRefreshTable()
         filter.filter |= engine::StarBrowser::Filter::SpectralType;
     }
 
-    starModel->populate(observerPos, now, filter, comparison);
-
-    treeView->resizeColumnToContents(StarTableModel::DistanceColumn);
-    treeView->resizeColumnToContents(StarTableModel::AppMagColumn);
-    treeView->resizeColumnToContents(StarTableModel::AbsMagColumn);
+    searchResultLabel->clear();
+    starModel->populate(observerPos, now, filter, comparison, [this]
+    {
+        treeView->resizeColumnToContents(StarTableModel::DistanceColumn);
+        treeView->resizeColumnToContents(StarTableModel::AppMagColumn);
+        treeView->resizeColumnToContents(StarTableModel::AbsMagColumn);
 
-    searchResultLabel->setText(QString(_("%1 objects found")).arg(starModel->rowCount(QModelIndex())));
+        searchResultLabel->setText(QString(_("%1 objects found")).arg(starModel->resultCount()));
+    });
 }
 
 void
@@ -642,6 +712,8 @@ CelestialBrowser::slotMarkSelected()
             }
         }
     }
+
+    appCore->setViewChanged();
 }
 
 void
@@ -656,12 +728,15 @@ CelestialBrowser::slotUnmarkSelected()
         if (!sel.empty())
             universe->unmarkObject(sel, 1);
     } // for
+
+    appCore->setViewChanged();
 }
 
 void
 CelestialBrowser::slotClearMarkers()
 {
     appCore->getSimulation()->getUniverse()->unmarkAll();
+    appCore->setViewChanged();
 }
 
 void
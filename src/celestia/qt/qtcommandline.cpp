@@ -22,6 +22,7 @@ CelestiaCommandLineOptions ParseCommandLine(const QCoreApplication& app)
         { { "s", "nosplash" }, _("Skip the splash screen.") },
         { { "u", "url" }, _("Set the start cel:// URL or startup script path."), _("url") },
         { { "l", "log" }, _("Set the path to the log file."), _("logpath") },
+        { "batch", _("Render offline: advance time by a fixed step in seconds each frame, render as fast as possible and quit when the start script ends."), _("timestep") },
     });
 
     parser.process(app);
@@ -56,6 +57,14 @@ CelestiaCommandLineOptions ParseCommandLine(const QCoreApplication& app)
     options.skipSplashScreen = parser.isSet("nosplash");
     options.startFullscreen = parser.isSet("fullscreen");
 
+    if (parser.isSet("batch"))
+    {
+        bool ok = false;
+        options.batchTimeStep = parser.value("batch").toDouble(&ok);
+        if (!ok || options.batchTimeStep <= 0.0)
+            parser.showHelp(1);
+    }
+
     return options;
 }
 
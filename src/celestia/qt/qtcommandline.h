@@ -28,6 +28,7 @@ struct CelestiaCommandLineOptions
     QString configFileName{ };
     bool skipSplashScreen{ false };
     bool startFullscreen{ false };
+    double batchTimeStep{ 0.0 };
 };
 
 CelestiaCommandLineOptions ParseCommandLine(const QCoreApplication&);
@@ -13,7 +13,9 @@
 #include "qtdeepskybrowser.h"
 
 #include <algorithm>
+#include <cstddef>
 #include <cstring>
+#include <functional>
 #include <string>
 #include <utility>
 #include <vector>
@@ -59,6 +61,7 @@
 #include <celutil/color.h>
 #include <celutil/gettext.h>
 #include <celutil/greek.h>
+#include "qtbrowserquery.h"
 #include "qtcolorswatchwidget.h"
 #include "qtinfopanel.h"
 
@@ -70,6 +73,18 @@ namespace
 
 constexpr int MAX_LISTED_DSOS = 20000;
 
+// Number of rows added to the view at a time
+constexpr std::size_t FetchRowCount = 100;
+
+// A row of the table, with the values computed when it was populated
+struct DSORecord
+{
+    DeepSkyObject* dso;
+    double distance;
+    double appMag;
+    QString name;
+};
+
 class DSOFilterPredicate
 {
 public:
@@ -231,6 +246,8 @@ public:
     int rowCount(const QModelIndex& index) const override;
     int columnCount(const QModelIndex& index) const override;
     void sort(int column, Qt::SortOrder order) override;
+    bool canFetchMore(const QModelIndex& parent) const override;
+    void fetchMore(const QModelIndex& parent) override;
 
     // Methods from ModelHelper
     Selection itemForInfoPanel(const QModelIndex&) override;
@@ -250,24 +267,33 @@ public:
         TypeColumn        = 3,
     };
 
+    // The catalog is searched on a worker thread, then populated is called
+    // and the rows are added as the view fetches them
     void populate(const UniversalCoord& _observerPos,
                   const DSOFilterPredicate& filterPred,
                   DSOPredicate::Criterion criterion,
-                  unsigned int nDSOs);
+                  unsigned int nDSOs,
+                  const std::function<void()>& populated);
 
     DeepSkyObject* itemAtRow(unsigned int row) const;
+    int resultCount() const { return static_cast<int>(dsos.size()); }
 
 private:
+    void setRecords(std::vector<DSORecord>&&);
+
     const Universe* universe;
-    Eigen::Vector3d observerPos;
-    std::vector<DeepSkyObject*> dsos;
+    QCollator coll;
+    std::vector<DSORecord> dsos;
+    std::size_t fetchedRows{ 0 };
     bool showType{ false };
+    // Destroyed first, so that no query delivers to a destroyed model
+    BrowserQuery query;
 };
 
 DeepSkyBrowser::DSOTableModel::DSOTableModel(const Universe* _universe) :
-    universe(_universe),
-    observerPos(Eigen::Vector3d::Zero())
+    universe(_universe)
 {
+    coll.setNumericMode(true);
 }
 
 Selection
@@ -289,13 +315,13 @@ QVariant
 DeepSkyBrowser::DSOTableModel::data(const QModelIndex& index, int role) const
 {
     int row = index.row();
-    if (row < 0 || row >= (int) dsos.size())
+    if (row < 0 || row >= (int) fetchedRows)
     {
         // Out of range
         return QVariant();
     }
 
-    const DeepSkyObject* dso = dsos[row];
+    const DSORecord& record = dsos[row];
 
     if (role != Qt::DisplayRole)
         return QVariant();
@@ -303,19 +329,13 @@ DeepSkyBrowser::DSOTableModel::data(const QModelIndex& index, int role) const
     switch (index.column())
     {
     case NameColumn:
-        {
-            std::string dsoNameString = ReplaceGreekLetterAbbr(universe->getDSOCatalog()->getDSOName(dso, true));
-            return QString::fromStdString(dsoNameString);
-        }
+        return record.name;
     case DistanceColumn:
-        return QString("%L1").arg((observerPos - dso->getPosition()).norm(), 0, 'g', 6);
+        return QString("%L1").arg(record.distance, 0, 'g', 6);
     case AppMagColumn:
-        {
-            double distance = (observerPos - dso->getPosition()).norm();
-            return QString("%L1").arg(astro::absToAppMag((double) dso->getAbsoluteMagnitude(), distance), 0, 'f', 2);
-        }
+        return QString("%L1").arg(record.appMag, 0, 'f', 2);
     case TypeColumn:
-        return QString(dso->getType());
+        return QString(record.dso->getType());
     default:
         return QVariant();
     }
@@ -347,7 +367,7 @@ DeepSkyBrowser::DSOTableModel::headerData(int section, Qt::Orientation /* orient
 int
 DeepSkyBrowser::DSOTableModel::rowCount(const QModelIndex& /*unused*/) const
 {
-    return (int) dsos.size();
+    return (int) fetchedRows;
 }
 
 // Override QAbstractDataModel::columnCount()
@@ -368,66 +388,111 @@ DeepSkyBrowser::DSOTableModel::itemForInfoPanel(const QModelIndex& _index)
 void
 DeepSkyBrowser::DSOTableModel::sort(int column, Qt::SortOrder order)
 {
-    DSOPredicate::Criterion criterion = DSOPredicate::Alphabetical;
+    // Sort by the values computed when the table was populated
+    std::function<bool(const DSORecord&, const DSORecord&)> pred;
 
     switch (column)
     {
-    case NameColumn:
-        criterion = DSOPredicate::Alphabetical;
-        break;
     case DistanceColumn:
-        criterion = DSOPredicate::Distance;
+        pred = [](const DSORecord& a, const DSORecord& b) { return a.distance < b.distance; };
         break;
     case AppMagColumn:
-        criterion = DSOPredicate::Brightness;
+        pred = [](const DSORecord& a, const DSORecord& b) { return a.appMag < b.appMag; };
         break;
     case TypeColumn:
-        criterion = DSOPredicate::ObjectType;
+        pred = [](const DSORecord& a, const DSORecord& b) { return std::strcmp(a.dso->getType(), b.dso->getType()) < 0; };
+        break;
+    default:
+        pred = [this](const DSORecord& a, const DSORecord& b) { return coll.compare(a.name, b.name) < 0; };
         break;
     }
 
-    DSOPredicate pred(criterion, observerPos, universe);
-
     std::sort(dsos.begin(), dsos.end(), pred);
 
     if (order == Qt::DescendingOrder)
         std::reverse(dsos.begin(), dsos.end());
 
-    dataChanged(index(0, 0), index(dsos.size() - 1, 4));
+    if (fetchedRows > 0)
+        dataChanged(index(0, 0), index(static_cast<int>(fetchedRows - 1), 4));
+}
+
+// Override QAbstractItemModel::canFetchMore()
+bool
+DeepSkyBrowser::DSOTableModel::canFetchMore(const QModelIndex& parent) const
+{
+    return !parent.isValid() && fetchedRows < dsos.size();
+}
+
+// Override QAbstractItemModel::fetchMore()
+void
+DeepSkyBrowser::DSOTableModel::fetchMore(const QModelIndex& parent)
+{
+    if (parent.isValid() || fetchedRows >= dsos.size())
+        return;
+
+    std::size_t count = std::min(FetchRowCount, dsos.size() - fetchedRows);
+    beginInsertRows(QModelIndex(), static_cast<int>(fetchedRows), static_cast<int>(fetchedRows + count - 1));
+    fetchedRows += count;
+    endInsertRows();
 }
 
 void
 DeepSkyBrowser::DSOTableModel::populate(const UniversalCoord& _observerPos,
                                         const DSOFilterPredicate& filterPred,
                                         DSOPredicate::Criterion criterion,
-                                        unsigned int nDSOs)
+                                        unsigned int nDSOs,
+                                        const std::function<void()>& populated)
 {
     showType = filterPred.objectType == DeepSkyObjectType::Galaxy;
-    const DSODatabase& dsodb = *universe->getDSOCatalog();
 
-    observerPos = _observerPos.offsetFromKm(UniversalCoord::Zero()) * astro::kilometersToLightYears(1.0);
+    Eigen::Vector3d observerPos = _observerPos.offsetFromKm(UniversalCoord::Zero()) * astro::kilometersToLightYears(1.0);
 
-    DSOPredicate pred(criterion, observerPos, universe);
+    // Clear out the results of the previous populate() call
+    setRecords({});
 
-    // Apply the filter
-    if (!dsos.empty())
-    {
-        beginResetModel();
-        dsos.clear();
-        endResetModel();
-    }
+    query.start(this,
+                [universe = universe, filterPred, criterion, observerPos, nDSOs]
+                {
+                    const DSODatabase& dsodb = *universe->getDSOCatalog();
+                    DSOPredicate pred(criterion, observerPos, universe);
 
-    dsos.reserve(nDSOs);
-    populateDsoVector(dsos, dsodb, filterPred, pred, nDSOs);
+                    std::vector<DeepSkyObject*> found;
+                    found.reserve(nDSOs);
+                    populateDsoVector(found, dsodb, filterPred, pred, nDSOs);
 
-    beginInsertRows(QModelIndex(), 0, static_cast<int>(dsos.size()));
-    endInsertRows();
+                    std::vector<DSORecord> result;
+                    result.reserve(found.size());
+                    for (DeepSkyObject* dso : found)
+                    {
+                        double distance = (observerPos - dso->getPosition()).norm();
+                        double appMag = astro::absToAppMag((double) dso->getAbsoluteMagnitude(), distance);
+                        std::string name = ReplaceGreekLetterAbbr(dsodb.getDSOName(dso, true));
+                        result.push_back({ dso, distance, appMag, QString::fromStdString(name) });
+                    }
+
+                    return result;
+                },
+                [this, populated](std::vector<DSORecord>&& result)
+                {
+                    setRecords(std::move(result));
+                    if (populated)
+                        populated();
+                });
+}
+
+void
+DeepSkyBrowser::DSOTableModel::setRecords(std::vector<DSORecord>&& newRecords)
+{
+    beginResetModel();
+    dsos = std::move(newRecords);
+    fetchedRows = 0;
+    endResetModel();
 }
 
 DeepSkyObject*
 DeepSkyBrowser::DSOTableModel::itemAtRow(unsigned int row) const
 {
-    return row >= dsos.size() ? nullptr : dsos[row];
+    return row >= fetchedRows ? nullptr : dsos[row].dso;
 }
 
 DeepSkyBrowser::DeepSkyBrowser(CelestiaCore* _appCore, QWidget* parent, InfoPanel* _infoPanel) :
@@ -622,11 +687,14 @@ DeepSkyBrowser::slotRefreshTable()
         }
     }
 
-    dsoModel->populate(observerPos, filterPred, criterion, MAX_LISTED_DSOS);
-    treeView->resizeColumnToContents(DSOTableModel::DistanceColumn);
-    treeView->resizeColumnToContents(DSOTableModel::AppMagColumn);
+    searchResultLabel->clear();
+    dsoModel->populate(observerPos, filterPred, criterion, MAX_LISTED_DSOS, [this]
+    {
+        treeView->resizeColumnToContents(DSOTableModel::DistanceColumn);
+        treeView->resizeColumnToContents(DSOTableModel::AppMagColumn);
 
-    searchResultLabel->setText(QString(_("%1 objects found")).arg(dsoModel->rowCount(QModelIndex())));
+        searchResultLabel->setText(QString(_("%1 objects found")).arg(dsoModel->resultCount()));
+    });
 }
 
 void
@@ -692,6 +760,8 @@ DeepSkyBrowser::slotMarkSelected()
             }
         } // isRowSelected
     } // for
+
+    appCore->setViewChanged();
 }
 
 void
@@ -706,12 +776,15 @@ DeepSkyBrowser::slotUnmarkSelected()
         if (!sel.empty())
             universe->unmarkObject(sel, 1);
     } // for
+
+    appCore->setViewChanged();
 }
 
 void
 DeepSkyBrowser::slotClearMarkers()
 {
     appCore->getSimulation()->getUniverse()->unmarkAll();
+    appCore->setViewChanged();
 }
 
 void
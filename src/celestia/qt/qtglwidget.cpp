@@ -87,6 +87,9 @@ CelestiaGlWidget::CelestiaGlWidget(QWidget* parent, const char* /* name */, Cele
 
     // We use glClear directly, so we don't need it called by Qt.
     setUpdateBehavior(QOpenGLWidget::PartialUpdate);
+
+    // Called once the frame has been composited into the window
+    connect(this, &QOpenGLWidget::frameSwapped, this, [this]() { frameScheduler.framePresented(); });
 }
 
 CelestiaGlWidget::~CelestiaGlWidget() = default;
@@ -99,7 +102,28 @@ CelestiaGlWidget::~CelestiaGlWidget() = default;
 void
 CelestiaGlWidget::paintGL()
 {
+    // In low latency mode the simulation is stepped here rather than by the
+    // timer, so that the input events queued before the paint event are
+    // applied just before the frame is drawn. Render on demand needs the
+    // tick to find out whether to paint at all.
+    frameScheduler.beginFrame();
+    if (ticksBeforeDraw())
+        appCore->tick();
+
     appCore->draw();
+    frameScheduler.endFrame();
+}
+
+void
+CelestiaGlWidget::setLowLatency(bool lowLatency)
+{
+    frameScheduler.setLowLatency(lowLatency);
+}
+
+bool
+CelestiaGlWidget::ticksBeforeDraw() const
+{
+    return frameScheduler.isLowLatency() && !appCore->getRenderOnDemand();
 }
 
 /*!
@@ -162,7 +186,13 @@ CelestiaGlWidget::initializeGL()
     appCore->getSimulation()->setFaintestVisible((float) settings.value("Preferences/VisualMagnitude", DEFAULT_VISUAL_MAGNITUDE).toDouble());
 
     appRenderer->setSolarSystemMaxDistance(appCore->getConfig()->renderDetails.SolarSystemMaxDistance);
+    appRenderer->setGPUStarCulling(appCore->getConfig()->renderDetails.GPUStarCulling);
+    appRenderer->setReverseDepth(appCore->getConfig()->renderDetails.ReverseDepth);
+    appRenderer->setLabelDeclutter(appCore->getConfig()->renderDetails.LabelDeclutter);
+    appRenderer->setMaxLabels(appCore->getConfig()->renderDetails.MaxLabels);
+    appRenderer->setGalaxyPointBudget(appCore->getConfig()->renderDetails.GalaxyPointBudget);
     appRenderer->setShadowMapSize(appCore->getConfig()->renderDetails.ShadowMapSize);
+    appRenderer->setShadowMapCacheSize(appCore->getConfig()->renderDetails.ShadowMapCache);
 }
 
 void
@@ -177,6 +207,7 @@ CelestiaGlWidget::resizeGL(int w, int h)
 void
 CelestiaGlWidget::mouseMoveEvent(QMouseEvent* m)
 {
+    frameScheduler.inputReceived();
     qreal scale = devicePixelRatioF();
     auto [x, y] = mousePosition(*m, scale);
 
@@ -222,6 +253,7 @@ CelestiaGlWidget::mouseMoveEvent(QMouseEvent* m)
 void
 CelestiaGlWidget::mousePressEvent(QMouseEvent* m)
 {
+    frameScheduler.inputReceived();
     qreal scale = devicePixelRatioF();
     auto [x, y] = mousePosition(*m, scale);
 
@@ -245,6 +277,7 @@ CelestiaGlWidget::mousePressEvent(QMouseEvent* m)
 void
 CelestiaGlWidget::mouseReleaseEvent(QMouseEvent* m)
 {
+    frameScheduler.inputReceived();
     qreal scale = devicePixelRatioF();
     auto [x, y] = mousePosition(*m, scale);
 
@@ -282,6 +315,7 @@ CelestiaGlWidget::mouseReleaseEvent(QMouseEvent* m)
 void
 CelestiaGlWidget::wheelEvent(QWheelEvent* w)
 {
+    frameScheduler.inputReceived();
     QPoint numDegrees = w->angleDelta();
     if (numDegrees.isNull() || numDegrees.y() == 0)
         return;
@@ -426,6 +460,7 @@ CelestiaGlWidget::handleSpecialKey(QKeyEvent* e, bool down)
 void
 CelestiaGlWidget::keyPressEvent(QKeyEvent* e)
 {
+    frameScheduler.inputReceived();
     int modifiers = 0;
     if (e->modifiers() & Qt::ShiftModifier)
     {
@@ -479,6 +514,7 @@ CelestiaGlWidget::keyPressEvent(QKeyEvent* e)
 void
 CelestiaGlWidget::keyReleaseEvent(QKeyEvent* e)
 {
+    frameScheduler.inputReceived();
     int modifiers = 0;
     if (!(e->modifiers() & Qt::ShiftModifier))
         modifiers |= CelestiaCore::ShiftKey;
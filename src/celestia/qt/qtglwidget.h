@@ -20,6 +20,7 @@
 #include <QOpenGLWidget>
 
 #include <celestia/celestiacore.h>
+#include <celestia/framescheduler.h>
 
 class QKeyEvent;
 class QMouseEvent;
@@ -48,6 +49,10 @@ public:
     void setCursorShape(CelestiaCore::CursorShape) override;
     CelestiaCore::CursorShape getCursorShape() const override;
 
+    void setLowLatency(bool);
+    // Whether the simulation is stepped when painting instead of by the timer
+    bool ticksBeforeDraw() const;
+
 protected:
     void initializeGL() override;
     void paintGL() override;
@@ -71,6 +76,7 @@ private:
     bool cursorVisible;
     std::unique_ptr<DragHandler> dragHandler;
     CelestiaCore::CursorShape currentCursor;
+    FrameScheduler frameScheduler;
 };
 
 } // end namespace celestia::qt
@@ -149,7 +149,7 @@ SetTimeDialog::SetTimeDialog(double currentTimeTDB,
     julianDateSpin->setMaximum(5373850.5); // 10000 Dec 31 23:59:59
     julianDateSpin->setAccelerated(true);
 
-    double jdUTC = astro::TAItoJDUTC(astro::TTtoTAI(astro::TDBtoTT(currentTimeTDB)));
+    double jdUTC = astro::TDBtoJDUTC(currentTimeTDB);
     julianDateSpin->setValue(jdUTC);
 
     julianDateSpin->setToolTip(_("Set Julian Date"));
@@ -172,7 +172,7 @@ SetTimeDialog::SetTimeDialog(double currentTimeTDB,
 void
 SetTimeDialog::slotSetSimulationTime()
 {
-    double tdb = astro::TTtoTDB(astro::TAItoTT(astro::JDUTCtoTAI(julianDateSpin->value())));
+    double tdb = astro::JDUTCtoTDB(julianDateSpin->value());
 
     appCore->getSimulation()->setTime(tdb);
 }
@@ -180,7 +180,7 @@ SetTimeDialog::slotSetSimulationTime()
 void
 SetTimeDialog::slotSetDateTime()
 {
-    double tdb = astro::TTtoTDB(astro::TAItoTT(astro::JDUTCtoTAI(julianDateSpin->value())));
+    double tdb = astro::JDUTCtoTDB(julianDateSpin->value());
     int tzb = appCore->getTimeZoneBias();
 
     tdb += tzb / 86400.0;
@@ -216,7 +216,7 @@ SetTimeDialog::slotDateTimeChanged()
     int tzb = appCore->getTimeZoneBias();
 
     tdb -= tzb / 86400.0;
-    double jdUTC = astro::TAItoJDUTC(astro::TTtoTAI(astro::TDBtoTT(tdb)));
+    double jdUTC = astro::TDBtoJDUTC(tdb);
     setValueNoSignal(julianDateSpin, jdUTC);
 
     if (jdUTC <= minLocalTime || jdUTC >= maxLocalTime)
@@ -239,7 +239,7 @@ SetTimeDialog::slotTimeZoneChanged()
 
     if (timeZoneBox->currentIndex() != 0)
     {
-        double tdb = astro::TTtoTDB(astro::TAItoTT(astro::JDUTCtoTAI(julianDateSpin->value())));
+        double tdb = astro::JDUTCtoTDB(julianDateSpin->value());
 
         astro::Date utc = astro::TDBtoUTC(tdb);
         astro::Date local = astro::TDBtoLocal(tdb);
@@ -10,7 +10,9 @@
 #include "appwindow.h"
 
 #include <cctype>
+#include <chrono>
 #include <string>
+#include <thread>
 #include <utility>
 
 #include <celengine/glsupport.h>
@@ -19,6 +21,7 @@
 #include <SDL_keyboard.h>
 #include <SDL_keycode.h>
 #include <SDL_messagebox.h>
+#include <SDL_timer.h>
 
 #ifdef __EMSCRIPTEN__
 #include <emscripten.h>
@@ -205,7 +208,21 @@ AppWindow::run(const Settings& settings)
     const auto* config = m_appCore->getConfig();
 
     renderer->setShadowMapSize(config->renderDetails.ShadowMapSize);
+    renderer->setShadowMapCacheSize(config->renderDetails.ShadowMapCache);
     renderer->setSolarSystemMaxDistance(config->renderDetails.SolarSystemMaxDistance);
+    renderer->setGPUStarCulling(config->renderDetails.GPUStarCulling);
+    renderer->setReverseDepth(config->renderDetails.ReverseDepth);
+    renderer->setLabelDeclutter(config->renderDetails.LabelDeclutter);
+    renderer->setMaxLabels(config->renderDetails.MaxLabels);
+    renderer->setGalaxyPointBudget(config->renderDetails.GalaxyPointBudget);
+
+    if (!config->renderDetails.VSync)
+        SDL_GL_SetSwapInterval(0);
+#ifndef __EMSCRIPTEN__
+    // The browser paces the frames itself
+    m_frameScheduler.setLowLatency(config->renderDetails.LowLatency);
+#endif
+    updateRefreshRate();
 
     settings.apply(m_appCore.get());
 
@@ -239,6 +256,40 @@ AppWindow::run(const Settings& settings)
 
 bool
 AppWindow::update()
+{
+    if (auto delay = m_frameScheduler.getStartDelay(); delay > FrameScheduler::clock::duration::zero())
+        std::this_thread::sleep_for(delay);
+
+    if (!processEvents())
+        return false;
+
+    m_frameScheduler.beginFrame();
+    m_appCore->tick();
+
+    // Apply the input received during the tick, so that the camera is
+    // rendered where it has been moved to rather than a frame later
+    if (m_frameScheduler.isLowLatency())
+    {
+        if (!processEvents())
+            return false;
+        m_frameScheduler.latchInput();
+    }
+
+    m_appCore->draw();
+    m_gui->render();
+    m_frameScheduler.endFrame();
+    SDL_GL_SwapWindow(m_window.get());
+
+    // Don't let the driver queue frames, which would show them later
+    if (m_frameScheduler.isLowLatency())
+        glFinish();
+    m_frameScheduler.framePresented();
+
+    return !m_gui->isQuitRequested();
+}
+
+bool
+AppWindow::processEvents()
 {
     for (;;)
     {
@@ -246,6 +297,25 @@ AppWindow::update()
         if (SDL_PollEvent(&event) == 0)
             break;
 
+        switch (event.type)
+        {
+        case SDL_TEXTINPUT:
+        case SDL_KEYDOWN:
+        case SDL_KEYUP:
+        case SDL_MOUSEBUTTONDOWN:
+        case SDL_MOUSEBUTTONUP:
+        case SDL_MOUSEWHEEL:
+        case SDL_MOUSEMOTION:
+        {
+            // The timestamps are in milliseconds since SDL was initialized
+            auto age = std::chrono::milliseconds(SDL_GetTicks() - event.common.timestamp);
+            m_frameScheduler.inputReceived(FrameScheduler::clock::now() - age);
+            break;
+        }
+        default:
+            break;
+        }
+
         m_gui->processEvent(event);
         switch (event.type)
         {
@@ -280,12 +350,16 @@ AppWindow::update()
         }
     }
 
-    m_appCore->tick();
-    m_appCore->draw();
-    m_gui->render();
-    SDL_GL_SwapWindow(m_window.get());
+    return true;
+}
 
-    return !m_gui->isQuitRequested();
+void
+AppWindow::updateRefreshRate()
+{
+    if (SDL_DisplayMode mode; SDL_GetWindowDisplayMode(m_window.get(), &mode) == 0)
+        m_frameScheduler.setRefreshRate(mode.refresh_rate);
+    else
+        m_frameScheduler.setRefreshRate(0.0);
 }
 
 void
@@ -491,6 +565,11 @@ AppWindow::handleWindowEvent(const SDL_WindowEvent& event)
         SDL_GL_GetDrawableSize(m_window.get(), &m_width, &m_height);
         m_appCore->resize(m_width, m_height);
     }
+    else if (event.event == SDL_WINDOWEVENT_MOVED)
+    {
+        // The window may have moved to another display
+        updateRefreshRate();
+    }
 }
 
 void
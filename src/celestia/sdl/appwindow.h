@@ -16,6 +16,7 @@
 #include <SDL_stdinc.h>
 #include <SDL_video.h>
 
+#include <celestia/framescheduler.h>
 #include <celutil/uniquedel.h>
 #include "environment.h"
 #include "glcontext.h"
@@ -49,6 +50,9 @@ public:
 private:
     class Alerter;
 
+    bool processEvents();
+    void updateRefreshRate();
+
     void handleTextInputEvent(const SDL_TextInputEvent&);
     void handleKeyDownEvent(const SDL_KeyboardEvent&);
     void handleKeyUpEvent(const SDL_KeyboardEvent&);
@@ -68,6 +72,8 @@ private:
     std::unique_ptr<Alerter> m_alerter;
     std::unique_ptr<Gui> m_gui;
 
+    FrameScheduler m_frameScheduler;
+
     int m_width{ 0 };
     int m_height{ 0 };
 
@@ -0,0 +1,98 @@
+// simulationstepper.cpp
+//
+// Copyright (C) 2025, the Celestia Development Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include "simulationstepper.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace celestia
+{
+
+SimulationStepper::SimulationStepper(double rate) :
+    m_step(1.0 / rate)
+{
+}
+
+int
+SimulationStepper::advance(double dt)
+{
+    m_elapsed += std::max(dt, 0.0);
+    auto steps = static_cast<int>(std::floor(m_elapsed / m_step));
+    if (steps > MaxStepsPerTick)
+    {
+        steps = MaxStepsPerTick;
+        m_elapsed = 0.0;
+    }
+    else
+    {
+        m_elapsed -= static_cast<double>(steps) * m_step;
+    }
+
+    return steps;
+}
+
+void
+SimulationStepper::capture(util::array_view<Observer*> observers)
+{
+    // Forget the observers which are gone
+    m_snapshots.erase(std::remove_if(m_snapshots.begin(), m_snapshots.end(),
+                                     [&observers](const Snapshot& snapshot)
+                                     {
+                                         return std::find(observers.begin(), observers.end(), snapshot.observer) == observers.end();
+                                     }),
+                      m_snapshots.end());
+
+    for (Observer* observer : observers)
+    {
+        auto it = std::find_if(m_snapshots.begin(), m_snapshots.end(),
+                               [observer](const Snapshot& snapshot) { return snapshot.observer == observer; });
+        if (it == m_snapshots.end())
+        {
+            m_snapshots.push_back({ observer, *observer, *observer });
+        }
+        else
+        {
+            it->previous = it->current;
+            it->current = *observer;
+        }
+    }
+}
+
+void
+SimulationStepper::apply(util::array_view<Observer*> observers)
+{
+    m_saved.clear();
+    double t = std::min(getFraction(), 1.0);
+    for (Observer* observer : observers)
+    {
+        auto it = std::find_if(m_snapshots.begin(), m_snapshots.end(),
+                               [observer](const Snapshot& snapshot) { return snapshot.observer == observer; });
+        // The motion across a change of reference frame isn't interpolated
+        if (it == m_snapshots.end() ||
+            it->previous.getFrame() != it->current.getFrame() ||
+            observer->getFrame() != it->current.getFrame())
+        {
+            continue;
+        }
+
+        m_saved.emplace_back(observer, *observer);
+        observer->interpolate(it->previous, it->current, t);
+    }
+}
+
+void
+SimulationStepper::restore()
+{
+    for (auto& [observer, saved] : m_saved)
+        *observer = saved;
+    m_saved.clear();
+}
+
+} // end namespace celestia
@@ -0,0 +1,71 @@
+// simulationstepper.h
+//
+// Copyright (C) 2025, the Celestia Development Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include <celengine/observer.h>
+#include <celutil/array_view.h>
+
+namespace celestia
+{
+
+// Steps the simulation and the scripts at a fixed rate instead of once per
+// frame, and draws the observers between their states at the last two
+// steps so that the camera moves smoothly at any frame rate. A tick runs
+// the steps due for the time elapsed since the previous one:
+//
+//   for each of advance(dt) steps: update by getStep(), then capture()
+//   apply() before drawing the views, restore() after them
+//
+// The changes made to the observers between steps, such as by dragging
+// the view, are drawn at once, as the observers are only moved back by the
+// part of the last step which hasn't elapsed yet.
+class SimulationStepper
+{
+public:
+    // Steps run by a tick at most, the time beyond them is dropped so that
+    // slow steps can't make the simulation fall further behind
+    static constexpr int MaxStepsPerTick = 4;
+
+    explicit SimulationStepper(double rate);
+
+    double getStep() const { return m_step; }
+
+    // Add the time elapsed since the previous tick and return the number of
+    // steps to run
+    int advance(double dt);
+
+    // The fraction of the next step which has elapsed
+    double getFraction() const { return m_elapsed / m_step; }
+
+    // Record the state of the observers after a step
+    void capture(util::array_view<Observer*> observers);
+
+    // Move the observers to their state at the time drawn, and back
+    void apply(util::array_view<Observer*> observers);
+    void restore();
+
+private:
+    struct Snapshot
+    {
+        Observer* observer;
+        Observer previous;
+        Observer current;
+    };
+
+    double m_step;
+    double m_elapsed{ 0.0 };
+    std::vector<Snapshot> m_snapshots;
+    std::vector<std::pair<Observer*, Observer>> m_saved;
+};
+
+} // end namespace celestia
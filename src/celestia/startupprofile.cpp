@@ -0,0 +1,192 @@
+// startupprofile.cpp
+//
+// Copyright (C) 2024, the Celestia Development Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include "startupprofile.h"
+
+#include <fstream>
+#include <iterator>
+
+#include <fmt/format.h>
+
+#include <celutil/logger.h>
+
+using namespace std::string_view_literals;
+
+namespace celestia
+{
+
+namespace
+{
+
+using Buffer = fmt::memory_buffer;
+
+void
+appendString(Buffer& buffer, std::string_view str)
+{
+    buffer.push_back('"');
+    for (char c : str)
+    {
+        switch (c)
+        {
+        case '"':  buffer.append("\\\""sv); break;
+        case '\\': buffer.append("\\\\"sv); break;
+        case '\n': buffer.append("\\n"sv); break;
+        case '\r': buffer.append("\\r"sv); break;
+        case '\t': buffer.append("\\t"sv); break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20)
+                fmt::format_to(std::back_inserter(buffer), "\\u{:04x}", static_cast<unsigned int>(c));
+            else
+                buffer.push_back(c);
+            break;
+        }
+    }
+    buffer.push_back('"');
+}
+
+double
+toMilliseconds(std::chrono::microseconds t)
+{
+    return static_cast<double>(t.count()) / 1000.0;
+}
+
+bool
+writeBuffer(const fs::path& path, const Buffer& buffer)
+{
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    out.close();
+    if (out.fail())
+    {
+        util::GetLogger()->error("Error writing startup profile {}\n", path);
+        return false;
+    }
+
+    return true;
+}
+
+} // end unnamed namespace
+
+StartupProfile::Scope::Scope(StartupProfile* profile, std::string_view name, std::string_view category) :
+    m_profile(profile)
+{
+    if (m_profile == nullptr)
+        return;
+
+    m_start = std::chrono::steady_clock::now();
+    m_cpuStart = std::clock();
+
+    m_index = m_profile->m_records.size();
+    auto& record = m_profile->m_records.emplace_back();
+    record.name = name;
+    record.category = category;
+    record.depth = m_profile->m_depth++;
+    record.start = std::chrono::duration_cast<std::chrono::microseconds>(m_start - m_profile->m_start);
+}
+
+StartupProfile::Scope::~Scope()
+{
+    if (m_profile == nullptr)
+        return;
+
+    auto& record = m_profile->m_records[m_index];
+    record.wallTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - m_start);
+    if (std::clock_t cpuEnd = std::clock(); cpuEnd != static_cast<std::clock_t>(-1) && m_cpuStart != static_cast<std::clock_t>(-1))
+    {
+        auto cpuTime = static_cast<double>(cpuEnd - m_cpuStart) * 1.0e6 / static_cast<double>(CLOCKS_PER_SEC);
+        record.cpuTime = std::chrono::microseconds(static_cast<std::chrono::microseconds::rep>(cpuTime));
+    }
+
+    --m_profile->m_depth;
+}
+
+void
+StartupProfile::Scope::addBytesRead(std::uint64_t bytes)
+{
+    if (m_profile != nullptr)
+        m_profile->m_records[m_index].bytesRead += bytes;
+}
+
+void
+StartupProfile::Scope::addObjects(std::uint64_t count)
+{
+    if (m_profile != nullptr)
+        m_profile->m_records[m_index].objectCount += count;
+}
+
+StartupProfile::StartupProfile() :
+    m_start(std::chrono::steady_clock::now())
+{
+}
+
+bool
+StartupProfile::writeReport(const fs::path& path) const
+{
+    Buffer buffer;
+    auto out = std::back_inserter(buffer);
+
+    std::chrono::microseconds total{ 0 };
+    for (const auto& record : m_records)
+    {
+        if (record.depth == 0)
+            total += record.wallTime;
+    }
+
+    fmt::format_to(out, "{{\n  \"wallTime\": {:.3f},\n  \"records\": [", toMilliseconds(total));
+    for (std::size_t i = 0; i < m_records.size(); ++i)
+    {
+        const Record& record = m_records[i];
+        buffer.append(i == 0 ? "\n    {\"name\": "sv : ",\n    {\"name\": "sv);
+        appendString(buffer, record.name);
+        buffer.append(", \"category\": "sv);
+        appendString(buffer, record.category);
+        fmt::format_to(out,
+                       ", \"depth\": {}, \"start\": {:.3f}, \"wallTime\": {:.3f}, \"cpuTime\": {:.3f}, "
+                       "\"bytesRead\": {}, \"objects\": {}}}",
+                       record.depth,
+                       toMilliseconds(record.start),
+                       toMilliseconds(record.wallTime),
+                       toMilliseconds(record.cpuTime),
+                       record.bytesRead,
+                       record.objectCount);
+    }
+    buffer.append("\n  ]\n}\n"sv);
+
+    return writeBuffer(path, buffer);
+}
+
+bool
+StartupProfile::writeTrace(const fs::path& path) const
+{
+    Buffer buffer;
+    auto out = std::back_inserter(buffer);
+
+    buffer.append("{\"displayTimeUnit\": \"ms\", \"traceEvents\": ["sv);
+    for (std::size_t i = 0; i < m_records.size(); ++i)
+    {
+        const Record& record = m_records[i];
+        buffer.append(i == 0 ? "\n  {\"name\": "sv : ",\n  {\"name\": "sv);
+        appendString(buffer, record.name);
+        buffer.append(", \"cat\": "sv);
+        appendString(buffer, record.category);
+        fmt::format_to(out,
+                       ", \"ph\": \"X\", \"pid\": 1, \"tid\": 1, \"ts\": {}, \"dur\": {}, "
+                       "\"args\": {{\"cpuTime\": {:.3f}, \"bytesRead\": {}, \"objects\": {}}}}}",
+                       record.start.count(),
+                       record.wallTime.count(),
+                       toMilliseconds(record.cpuTime),
+                       record.bytesRead,
+                       record.objectCount);
+    }
+    buffer.append("\n]}\n"sv);
+
+    return writeBuffer(path, buffer);
+}
+
+} // end namespace celestia
@@ -0,0 +1,85 @@
+// startupprofile.h
+//
+// Copyright (C) 2024, the Celestia Development Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <celcompat/filesystem.h>
+
+namespace celestia
+{
+
+// Records the time taken by the phases of the startup, and by each catalog
+// file read in them, along with the number of bytes read and objects
+// created. The records can be written as a JSON report, or as a trace in
+// the Chrome trace event format, which can be opened in chrome://tracing
+// or Perfetto.
+class StartupProfile
+{
+public:
+    struct Record
+    {
+        std::string name;
+        std::string category;
+        // Nesting level of the scope which recorded it
+        int depth{ 0 };
+        // Relative to the creation of the profile
+        std::chrono::microseconds start{ 0 };
+        std::chrono::microseconds wallTime{ 0 };
+        // CPU time of the whole process, including the threads reading
+        // catalogs ahead
+        std::chrono::microseconds cpuTime{ 0 };
+        std::uint64_t bytesRead{ 0 };
+        std::uint64_t objectCount{ 0 };
+    };
+
+    // Records the time until it is destroyed. Scopes may be nested, and must
+    // all be on the thread which created the profile. A scope without a
+    // profile does nothing, so that callers needn't check whether profiling
+    // is enabled.
+    class Scope
+    {
+    public:
+        Scope(StartupProfile*, std::string_view name, std::string_view category = "phase");
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+        void addBytesRead(std::uint64_t);
+        void addObjects(std::uint64_t);
+
+    private:
+        StartupProfile* m_profile;
+        std::size_t m_index{ 0 };
+        std::chrono::steady_clock::time_point m_start;
+        std::clock_t m_cpuStart{ 0 };
+    };
+
+    StartupProfile();
+
+    const std::vector<Record>& records() const { return m_records; }
+
+    bool writeReport(const fs::path&) const;
+    bool writeTrace(const fs::path&) const;
+
+private:
+    std::vector<Record> m_records;
+    std::chrono::steady_clock::time_point m_start;
+    int m_depth{ 0 };
+};
+
+} // end namespace celestia
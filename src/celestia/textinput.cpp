@@ -12,6 +12,7 @@
 
 #include "textinput.h"
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
 #include <cwctype>
@@ -94,26 +95,21 @@ TextInput::doBackspace(const Simulation* sim, bool withLocations)
     if (m_text.empty())
         return;
 
-#ifdef AUTO_COMPLETION
-    do
+    for (;;)
     {
-#endif
-        for (;;)
-        {
-            auto ch = static_cast<std::byte>(m_text.back());
-            m_text.pop_back();
-            // If the string is empty, or the removed character was
-            // not a UTF-8 continuation byte 0b10xx_xxxx then we're
-            // done.
-            if (m_text.empty() || (ch & std::byte(0xc0)) != std::byte(0x80))
-                break;
-        }
+        auto ch = static_cast<std::byte>(m_text.back());
+        m_text.pop_back();
+        // If the string is empty, or the removed character was
+        // not a UTF-8 continuation byte 0b10xx_xxxx then we're
+        // done.
+        if (m_text.empty() || (ch & std::byte(0xc0)) != std::byte(0x80))
+            break;
+    }
 
-        m_completion.clear();
-        if (!m_text.empty())
-                sim->getObjectCompletion(m_completion, m_text, withLocations);
+    startCompletion(sim, withLocations);
 #ifdef AUTO_COMPLETION
-    } while (!typedText.empty() && typedTextCompletion.size() == 1);
+    // Characters are removed while a single object matches, see update()
+    m_autoCompletion = AutoCompletion::Backspace;
 #endif
 }
 
@@ -153,18 +149,50 @@ void
 TextInput::appendText(const Simulation* sim, std::string_view sv, bool withLocations)
 {
     m_text.append(sv);
-    m_completion.clear();
-    sim->getObjectCompletion(m_completion, m_text, withLocations);
+    startCompletion(sim, withLocations);
     m_completionIdx = -1;
 #ifdef AUTO_COMPLETION
-    if (m_completion.size() == 1)
+    // The name is completed when a single object matches, see update()
+    m_autoCompletion = AutoCompletion::Append;
+#endif
+}
+
+void
+TextInput::startCompletion(const Simulation* sim, bool withLocations)
+{
+    m_completion.clear();
+#ifdef AUTO_COMPLETION
+    m_simulation = sim;
+    m_withLocations = withLocations;
+#endif
+    if (m_text.empty())
+        m_completionQuery.cancel();
+    else
+        m_completionQuery.start(sim->getUniverse(), m_text, sim->getCompletionContexts(), withLocations);
+}
+
+#ifdef AUTO_COMPLETION
+// Apply the pending edit once the completions are all found
+void
+TextInput::autoComplete()
+{
+    AutoCompletion autoCompletion = m_autoCompletion;
+    m_autoCompletion = AutoCompletion::None;
+    if (m_completion.size() != 1)
+        return;
+
+    if (autoCompletion == AutoCompletion::Append)
     {
         auto pos = m_text.rfind('/');
         m_text.resize(pos == std::string::npos ? 0 : (pos + 1));
-        m_text.append(m_completion.front());
+        m_text.append(m_completion.front().getName());
+    }
+    else if (!m_text.empty())
+    {
+        doBackspace(m_simulation, m_withLocations);
     }
-#endif
 }
+#endif
 
 void
 TextInput::reset()
@@ -172,6 +200,35 @@ TextInput::reset()
     m_text.clear();
     m_completion.clear();
     m_completionIdx = -1;
+    m_completionQuery.cancel();
+#ifdef AUTO_COMPLETION
+    m_autoCompletion = AutoCompletion::None;
+#endif
+}
+
+void
+TextInput::update()
+{
+    std::vector<engine::Completion> completion;
+    if (m_completionQuery.poll(completion))
+    {
+        // Keep the completion chosen with tab when more are found
+        if (m_completionIdx >= 0)
+        {
+            std::string name = m_completion[m_completionIdx].getName();
+            auto it = std::find_if(completion.begin(), completion.end(),
+                                   [&name](const engine::Completion& c) { return c.getName() == name; });
+            m_completionIdx = it == completion.end() ? -1 : static_cast<int>(it - completion.begin());
+        }
+
+        m_completion = std::move(completion);
+    }
+
+#ifdef AUTO_COMPLETION
+    // Only the complete results tell whether a single object matches
+    if (m_autoCompletion != AutoCompletion::None && !m_completionQuery.isRunning())
+        autoComplete();
+#endif
 }
 
 void
@@ -18,6 +18,7 @@
 #include <vector>
 
 #include <celengine/completion.h>
+#include <celengine/completionquery.h>
 #include <celutil/array_view.h>
 
 class Color;
@@ -48,18 +49,41 @@ public:
     void appendText(const Simulation*, std::string_view, bool withLocations);
     void reset();
 
+    // Pick up the completions found in the background since the last call
+    void update();
+
     void render(Overlay*, const HudFonts&, const WindowMetrics&) const;
 
 private:
     void doBackspace(const Simulation*, bool);
     void doTab();
     void doBackTab();
+    void startCompletion(const Simulation*, bool withLocations);
+#ifdef AUTO_COMPLETION
+    void autoComplete();
+#endif
 
     void renderCompletion(Overlay*, const WindowMetrics&, int) const;
 
     std::string m_text;
     std::vector<engine::Completion> m_completion;
     int m_completionIdx{ -1 };
+    engine::CompletionQuery m_completionQuery;
+
+#ifdef AUTO_COMPLETION
+    // The edit whose completion is pending, and which is completed once the
+    // query has found a single match
+    enum class AutoCompletion
+    {
+        None,
+        Append,
+        Backspace,
+    };
+
+    AutoCompletion m_autoCompletion{ AutoCompletion::None };
+    const Simulation* m_simulation{ nullptr };
+    bool m_withLocations{ false };
+#endif
 };
 
 }
@@ -10,6 +10,7 @@
 #include "view.h"
 
 #include <celengine/framebuffer.h>
+#include <celengine/framebufferpool.h>
 #include <celengine/glsupport.h>
 #include <celengine/overlay.h>
 #include <celengine/rectangle.h>
@@ -261,21 +262,19 @@ View::drawBorder(Overlay* overlay, int gWidth, int gHeight, const Color &color,
 
 
 void
-View::updateFBO(int gWidth, int gHeight)
+View::updateFBO(int gWidth, int gHeight, FramebufferPool& pool)
 {
     auto newWidth = static_cast<GLuint>(width * gWidth);
     auto newHeight = static_cast<GLuint>(height * gHeight);
     if (fbo && fbo.get()->width() == newWidth && fbo.get()->height() == newHeight)
         return;
 
-    // recreate FBO when FBO not exisits or on size change
-    fbo = std::make_unique<FramebufferObject>(newWidth, newHeight,
-                                              FramebufferObject::ColorAttachment | FramebufferObject::DepthAttachment);
-    if (!fbo->isValid())
-    {
+    // Get another FBO when there is none or on size change; the previous
+    // one goes back to the pool
+    fbo = pool.acquire(newWidth, newHeight,
+                       FramebufferObject::ColorAttachment | FramebufferObject::DepthAttachment);
+    if (fbo == nullptr)
         GetLogger()->error("Error creating view FBO.\n");
-        fbo = nullptr;
-    }
 }
 
 
@@ -14,6 +14,7 @@
 
 class Color;
 class FramebufferObject;
+class FramebufferPool;
 class Observer;
 class Overlay;
 
@@ -49,7 +50,7 @@ public:
     void reset();
     static View* remove(View*);
     void drawBorder(Overlay*, int gWidth, int gHeight, const Color &color, float linewidth = 1.0f) const;
-    void updateFBO(int gWidth, int gHeight);
+    void updateFBO(int gWidth, int gHeight, FramebufferPool& pool);
     FramebufferObject *getFBO() const;
 
     Type           type;
@@ -64,7 +65,7 @@ public:
     float          height;
 
 private:
-    std::unique_ptr<FramebufferObject> fbo;
+    std::shared_ptr<FramebufferObject> fbo;
 };
 
 }
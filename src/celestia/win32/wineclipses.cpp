@@ -367,7 +367,11 @@ EclipseFinderProc(HWND hDlg, UINT message, WPARAM wParam, LPARAM lParam)
                                eclipseFinderDlg->toTime.wMonth,
                                eclipseFinderDlg->toTime.wDay);
 
-                const SolarSystemCatalog* systems = eclipseFinderDlg->appCore->getSimulation()->getUniverse()->getSolarSystemCatalog();
+                const Universe* universe = eclipseFinderDlg->appCore->getSimulation()->getUniverse();
+                if (PendingSolarSystems* pending = universe->getPendingSolarSystems(); pending != nullptr)
+                    pending->realize(0);
+
+                const SolarSystemCatalog* systems = universe->getSolarSystemCatalog();
                 if (auto solarSystem = systems->find(0); solarSystem != systems->end())
                 {
                     const PlanetarySystem* system = solarSystem->second->getPlanets();
@@ -712,7 +712,13 @@ WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance,
         hDefaultCursor = LoadCursor(hRes, MAKEINTRESOURCE(IDC_CROSSHAIR_OPAQUE));
 
     appCore->getRenderer()->setSolarSystemMaxDistance(appCore->getConfig()->renderDetails.SolarSystemMaxDistance);
+    appCore->getRenderer()->setGPUStarCulling(appCore->getConfig()->renderDetails.GPUStarCulling);
+    appCore->getRenderer()->setReverseDepth(appCore->getConfig()->renderDetails.ReverseDepth);
+    appCore->getRenderer()->setLabelDeclutter(appCore->getConfig()->renderDetails.LabelDeclutter);
+    appCore->getRenderer()->setMaxLabels(appCore->getConfig()->renderDetails.MaxLabels);
+    appCore->getRenderer()->setGalaxyPointBudget(appCore->getConfig()->renderDetails.GalaxyPointBudget);
     appCore->getRenderer()->setShadowMapSize(appCore->getConfig()->renderDetails.ShadowMapSize);
+    appCore->getRenderer()->setShadowMapCacheSize(appCore->getConfig()->renderDetails.ShadowMapCache);
 
     auto cursorHandler = std::make_unique<WinCursorHandler>(hDefaultCursor);
     appCore->setCursorHandler(cursorHandler.get());
@@ -86,10 +86,20 @@ BeginMovieCapture(CelestiaCore* appCore,
     auto* movieCapture = new FFMPEGCapture(appCore->getRenderer());
     movieCapture->setVideoCodec(codec);
     movieCapture->setBitRate(bitrate);
-    if (codec == AV_CODEC_ID_H264)
-        movieCapture->setEncoderOptions(appCore->getConfig()->x264EncoderOptions);
+    const CelestiaConfig* config = appCore->getConfig();
+    if (codec == AV_CODEC_ID_H264 && !config->hardwareEncoder.empty())
+    {
+        movieCapture->setHardwareEncoder(config->hardwareEncoder, config->hardwareEncoderDevice);
+        movieCapture->setEncoderOptions(config->hardwareEncoderOptions);
+    }
+    else if (codec == AV_CODEC_ID_H264)
+    {
+        movieCapture->setEncoderOptions(config->x264EncoderOptions);
+    }
     else
-        movieCapture->setEncoderOptions(appCore->getConfig()->ffvhEncoderOptions);
+    {
+        movieCapture->setEncoderOptions(config->ffvhEncoderOptions);
+    }
 
     bool success = movieCapture->start(filename, width, height, framerate);
     if (success)
@@ -181,7 +181,7 @@ SetTimeDialog::updateControls()
     jdItem = GetDlgItem(hDlg, IDC_JDPICKER);
     if (jdItem != NULL)
     {
-        auto jdUtc = astro::TAItoJDUTC(astro::TTtoTAI(astro::TDBtoTT(tdb)));
+        auto jdUtc = astro::TDBtoJDUTC(tdb);
 
         std::array<TCHAR, 16> jd;
         jd.fill(TEXT('\0'));
@@ -241,7 +241,7 @@ SetTimeDialog::command(WPARAM wParam, LPARAM lParam)
                 if (auto ec = from_tchars(jdStr.data(), jdStr.data() + jdStr.size(), jd).ec;
                     ec == std::errc{})
                 {
-                    tdb = astro::TTtoTDB(astro::TAItoTT(astro::JDUTCtoTAI(jd)));
+                    tdb = astro::JDUTCtoTDB(jd);
                 }
 
                 updateControls();
@@ -0,0 +1,178 @@
+// bufferpool.cpp
+//
+// Copyright (C) 2024, Celestia Development Team
+//
+// Pool of aligned pixel buffers for images.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include "bufferpool.h"
+
+#include <cstring>
+#include <memory>
+#include <new>
+
+namespace celestia::engine
+{
+
+namespace
+{
+
+constexpr std::size_t MinSizeClass = 4096;
+
+// The size class of a buffer is kept in a header in front of it, which is
+// as large as the alignment so that the pixels stay aligned
+constexpr std::size_t HeaderSize = ImageBufferPool::Alignment;
+static_assert(HeaderSize >= sizeof(std::size_t));
+
+std::uint8_t*
+AllocateBlock(std::size_t sizeClass)
+{
+    auto block = static_cast<std::uint8_t*>(::operator new(sizeClass + HeaderSize,
+                                                           std::align_val_t{ ImageBufferPool::Alignment }));
+    std::memcpy(block, &sizeClass, sizeof(sizeClass));
+    return block + HeaderSize;
+}
+
+void
+FreeBlock(std::uint8_t* buffer)
+{
+    ::operator delete(buffer - HeaderSize, std::align_val_t{ ImageBufferPool::Alignment });
+}
+
+std::size_t
+GetBlockSizeClass(const std::uint8_t* buffer)
+{
+    std::size_t sizeClass;
+    std::memcpy(&sizeClass, buffer - HeaderSize, sizeof(sizeClass));
+    return sizeClass;
+}
+
+} // end unnamed namespace
+
+std::uint8_t*
+ImageBufferPool::allocate(std::size_t size)
+{
+    std::size_t sizeClass = GetSizeClass(size);
+    {
+        std::scoped_lock lock(m_mutex);
+        if (auto it = m_buffers.find(sizeClass); it != m_buffers.end() && !it->second.empty())
+        {
+            std::uint8_t* buffer = it->second.back();
+            it->second.pop_back();
+            m_pooledSize -= sizeClass;
+            return buffer;
+        }
+    }
+
+    return AllocateBlock(sizeClass);
+}
+
+void
+ImageBufferPool::release(std::uint8_t* buffer)
+{
+    if (buffer == nullptr)
+        return;
+
+    std::size_t sizeClass = GetBlockSizeClass(buffer);
+    {
+        std::scoped_lock lock(m_mutex);
+        if (m_pooledSize + sizeClass <= m_capacity)
+        {
+            m_buffers[sizeClass].push_back(buffer);
+            m_pooledSize += sizeClass;
+            return;
+        }
+    }
+
+    FreeBlock(buffer);
+}
+
+void
+ImageBufferPool::setCapacity(std::size_t capacity)
+{
+    std::scoped_lock lock(m_mutex);
+    m_capacity = capacity;
+
+    // Free the largest buffers first, as they are the least likely to be
+    // reused
+    for (auto it = m_buffers.rbegin(); it != m_buffers.rend() && m_pooledSize > m_capacity; ++it)
+    {
+        while (!it->second.empty() && m_pooledSize > m_capacity)
+        {
+            FreeBlock(it->second.back());
+            it->second.pop_back();
+            m_pooledSize -= it->first;
+        }
+    }
+}
+
+std::size_t
+ImageBufferPool::getCapacity() const
+{
+    std::scoped_lock lock(m_mutex);
+    return m_capacity;
+}
+
+std::size_t
+ImageBufferPool::getPooledSize() const
+{
+    std::scoped_lock lock(m_mutex);
+    return m_pooledSize;
+}
+
+void
+ImageBufferPool::clear()
+{
+    std::scoped_lock lock(m_mutex);
+    for (auto& [sizeClass, buffers] : m_buffers)
+    {
+        for (std::uint8_t* buffer : buffers)
+            FreeBlock(buffer);
+    }
+
+    m_buffers.clear();
+    m_pooledSize = 0;
+}
+
+std::size_t
+ImageBufferPool::GetSizeClass(std::size_t size)
+{
+    if (size <= MinSizeClass)
+        return MinSizeClass;
+
+    // Four classes between consecutive powers of two, so that at most a
+    // quarter of a buffer is unused
+    std::size_t power = MinSizeClass;
+    while (power < size / 2)
+        power *= 2;
+    std::size_t step = power / 4;
+    return (size + step - 1) / step * step;
+}
+
+ImageBufferPool*
+GetImageBufferPool()
+{
+    // Never destroyed, as images may outlive static destructors
+    static ImageBufferPool* const pool = std::make_unique<ImageBufferPool>().release(); //NOSONAR
+    return pool;
+}
+
+void
+detail::ReleaseImageBuffer(std::uint8_t* buffer)
+{
+    GetImageBufferPool()->release(buffer);
+}
+
+ImageBuffer
+AllocateImageBuffer(std::size_t size)
+{
+    ImageBuffer buffer(GetImageBufferPool()->allocate(size));
+    std::memset(buffer.get(), 0, size);
+    return buffer;
+}
+
+} // namespace celestia::engine
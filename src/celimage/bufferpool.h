@@ -0,0 +1,70 @@
+// bufferpool.h
+//
+// Copyright (C) 2024, Celestia Development Team
+//
+// Pool of aligned pixel buffers for images.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include <celutil/uniquedel.h>
+
+namespace celestia::engine
+{
+
+/**
+ * Keeps the pixel buffers of destroyed images for reuse, so that streaming
+ * textures and capturing frames don't allocate and release large blocks of
+ * memory all the time. Buffers are rounded up to size classes with four
+ * steps per power of two, aligned to 64 bytes, and cleared when they are
+ * handed out. Released buffers are freed instead of kept once the pool
+ * holds more than its capacity. The pool may be used from any thread.
+ */
+class ImageBufferPool
+{
+public:
+    static constexpr std::size_t Alignment = 64;
+    static constexpr std::size_t DefaultCapacity = 256U * 1024U * 1024U;
+
+    std::uint8_t* allocate(std::size_t size);
+    void release(std::uint8_t* buffer);
+
+    void setCapacity(std::size_t capacity);
+    std::size_t getCapacity() const;
+    // Total size of the buffers kept for reuse
+    std::size_t getPooledSize() const;
+    // Frees all the buffers kept for reuse
+    void clear();
+
+    static std::size_t GetSizeClass(std::size_t size);
+
+private:
+    mutable std::mutex m_mutex;
+    std::map<std::size_t, std::vector<std::uint8_t*>> m_buffers;
+    std::size_t m_pooledSize{ 0 };
+    std::size_t m_capacity{ DefaultCapacity };
+};
+
+ImageBufferPool* GetImageBufferPool();
+
+namespace detail
+{
+void ReleaseImageBuffer(std::uint8_t*);
+}
+
+using ImageBuffer = util::UniquePtrDel<std::uint8_t[], detail::ReleaseImageBuffer>;
+
+// Returns a cleared buffer of the size from the pool
+ImageBuffer AllocateImageBuffer(std::size_t size);
+
+} // namespace celestia::engine
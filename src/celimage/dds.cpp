@@ -9,11 +9,11 @@
 // of the License, or (at your option) any later version.
 
 #include <cassert>
-#include <cstring>
 #include <fstream>
 #include <algorithm>
 #include <memory>
 #include <celengine/glsupport.h>
+#include <celutil/binarywrite.h>
 #include <celutil/logger.h>
 #include <celutil/bytes.h>
 #include "dds_decompress.h"
@@ -74,8 +74,6 @@ struct DDSurfaceDesc
     std::uint32_t textureStage;
 };
 
-constexpr std::size_t DDS_MAX_BLOCK_SIZE = 16;
-
 constexpr std::uint32_t FourCC(const char *s)
 {
     return static_cast<std::uint32_t>(s[3]) << 24 |
@@ -166,109 +164,110 @@ GetFormat(const DDSurfaceDesc& ddsd)
     }
 }
 
-// decompress a DXTc texture to a RGBA texture, taken from https://github.com/ptitSeb/gl4es
-std::unique_ptr<std::uint32_t[]>
-DecompressDXTc(std::uint32_t width, std::uint32_t height, PixelFormat format, bool transparent0, std::istream& in)
+// Size of a mip level in the file, which matches the layout of Image
+std::streamoff
+GetMipLevelSize(const DDSurfaceDesc& ddsd, PixelFormat format, std::int32_t mip)
 {
-    // TODO: check with the size of the input data stream if the stream is in fact decompressed
-    // alloc memory
-    int blocksize = 0;
-    switch (format)
-    {
-    case PixelFormat::DXT1:
-        blocksize = 8;
-        break;
-    case PixelFormat::DXT3:
-    case PixelFormat::DXT5:
-        blocksize = 16;
-        break;
-    default:
-        assert(0);
-        return nullptr;
-    }
-    auto pixels = std::make_unique<std::uint32_t[]>(((width + 3) & ~3) * ((height + 3) & ~3));
-    std::array<std::uint8_t, DDS_MAX_BLOCK_SIZE> block; // enough to hold DXT1/3/5 blocks
-    for (std::uint32_t y = 0; y < height; y += 4)
+    auto width = std::max(static_cast<std::int32_t>(ddsd.width) >> mip, INT32_C(1));
+    auto height = std::max(static_cast<std::int32_t>(ddsd.height) >> mip, INT32_C(1));
+    if (IsCompressedFormat(format))
     {
-        for (std::uint32_t x = 0; x < width; x += 4)
-        {
-            if (!in.good())
-                return nullptr;
-
-            in.read(reinterpret_cast<char*>(block.data()), blocksize); /* Flawfinder: ignore */
-            switch (format)
-            {
-            case PixelFormat::DXT1:
-                DecompressBlockDXT1(x, y, width, block.data(), transparent0, pixels.get());
-                break;
-            case PixelFormat::DXT3:
-                DecompressBlockDXT3(x, y, width, block.data(), transparent0, pixels.get());
-                break;
-            case PixelFormat::DXT5:
-                DecompressBlockDXT5(x, y, width, block.data(), transparent0, pixels.get());
-                break;
-            default:
-                assert(0);
-                return nullptr;
-            }
-        }
+        std::streamoff blockSize = format == PixelFormat::DXT1 ? 8 : 16;
+        return static_cast<std::streamoff>((width + 3) / 4) * ((height + 3) / 4) * blockSize;
     }
-    return pixels;
+
+    auto bytesPerPixel = static_cast<std::int32_t>(ddsd.format.bpp / 8);
+    return static_cast<std::streamoff>(height) * ((width * bytesPerPixel + 3) & ~3);
+}
+
+// Skips the top mip levels up to the reduction, as long as one level is left,
+// and returns the number of levels skipped
+std::int32_t
+SkipMipLevels(DDSurfaceDesc& ddsd, PixelFormat format, std::istream& in, std::int32_t reduction)
+{
+    auto width = static_cast<std::int32_t>(ddsd.width);
+    auto height = static_cast<std::int32_t>(ddsd.height);
+
+    std::int32_t chainLength = 1;
+    while ((width >> chainLength) > 0 || (height >> chainLength) > 0)
+        ++chainLength;
+    std::int32_t mipLevels = std::clamp(static_cast<std::int32_t>(ddsd.mipMapLevels), INT32_C(1), chainLength);
+
+    std::int32_t skipped = std::clamp(reduction, INT32_C(0), mipLevels - 1);
+    if (skipped == 0)
+        return 0;
+
+    std::streamoff offset = 0;
+    for (std::int32_t mip = 0; mip < skipped; ++mip)
+        offset += GetMipLevelSize(ddsd, format, mip);
+    if (!in.seekg(offset, std::ios::cur).good())
+        return 0;
+
+    ddsd.width = static_cast<std::uint32_t>(std::max(width >> skipped, INT32_C(1)));
+    ddsd.height = static_cast<std::uint32_t>(std::max(height >> skipped, INT32_C(1)));
+    ddsd.mipMapLevels = static_cast<std::uint32_t>(mipLevels - skipped);
+    return skipped;
 }
 
 std::unique_ptr<Image>
 CreateDecompressedImage(const DDSurfaceDesc& ddsd, PixelFormat format, std::istream& in, const fs::path& filename)
 {
-    // DXTc texture not supported, decompress DXTc to RGB/RGBA
-    std::unique_ptr<std::uint32_t[]>pixels = nullptr;
-    bool transparent0 = format == PixelFormat::DXT1;
-    if ((ddsd.width & 3) != 0 || (ddsd.height & 3) != 0)
-    {
-        std::uint32_t nw = std::max(ddsd.width, 4u);
-        std::uint32_t nh = std::max(ddsd.height, 4u);
-        auto tmp = DecompressDXTc(nw, nh, format, transparent0, in);
-        if (tmp != nullptr)
-        {
-            pixels = std::make_unique<std::uint32_t[]>(ddsd.width * ddsd.height);
-            // crop
-            for (std::uint32_t y = 0; y < ddsd.height; y++)
-            {
-                std::memcpy(pixels.get() + y * ddsd.width, tmp.get() + y * nw, ddsd.width * 4);
-            }
-        }
-    }
-    else
+    auto width = static_cast<std::int32_t>(ddsd.width);
+    auto height = static_cast<std::int32_t>(ddsd.height);
+
+    std::int32_t chainLength = 1;
+    while ((width >> chainLength) > 0 || (height >> chainLength) > 0)
+        ++chainLength;
+    std::int32_t mipLevels = std::clamp(static_cast<std::int32_t>(ddsd.mipMapLevels), INT32_C(1), chainLength);
+
+    // Read all levels at once; files which are cut short keep the levels
+    // which are complete
+    Image compressed(format, width, height, mipLevels);
+    in.read(reinterpret_cast<char*>(compressed.getPixels()), compressed.getSize()); /* Flawfinder: ignore */
+    auto bytesRead = static_cast<std::int32_t>(in.gcount());
+
+    std::int32_t completeLevels = 0;
+    for (std::int32_t offset = 0; completeLevels < mipLevels; ++completeLevels)
     {
-        pixels = DecompressDXTc(ddsd.width, ddsd.height, format, transparent0, in);
+        offset += compressed.getMipLevelSize(completeLevels);
+        if (offset > bytesRead)
+            break;
     }
 
-    if (pixels == nullptr)
+    if (completeLevels == 0)
     {
         util::GetLogger()->error("Failed to decompress DDS texture file {}.\n", filename);
         return nullptr;
     }
 
-    if (transparent0)
+    // DXTc texture not supported, decompress DXTc to RGB/RGBA. The alpha
+    // channel is removed for DXT1 since DXT1 textures are deemed not to
+    // contain alpha values in Celestia
+    // https://github.com/CelestiaProject/Celestia/pull/1086
+    auto img = std::make_unique<Image>(format == PixelFormat::DXT1 ? PixelFormat::RGB : PixelFormat::RGBA,
+                                       width, height, completeLevels);
+    auto components = static_cast<std::uint32_t>(img->getComponents());
+    for (std::int32_t mip = 0; mip < completeLevels; ++mip)
     {
-        // Remove the alpha channel for DXT1 since DXT1 textures
-        // are deemed not to contain alpha values in Celestia
-        // https://github.com/CelestiaProject/Celestia/pull/1086
-        char *ptr = reinterpret_cast<char*>(pixels.get());
-        std::uint32_t numberOfPixels = ddsd.width * ddsd.height;
-        for (std::uint32_t index = 0; index < numberOfPixels; ++index)
-        {
-            std::memcpy(&ptr[3 * index], &ptr[4 * index], sizeof(char) * 3);
-        }
+        auto mipWidth = static_cast<std::uint32_t>(std::max(width >> mip, INT32_C(1)));
+        auto mipHeight = static_cast<std::uint32_t>(std::max(height >> mip, INT32_C(1)));
+        // Rows of each level are padded to a multiple of 4 bytes
+        std::uint32_t pitch = (mipWidth * components + 3U) & ~3U;
+        DecompressImageDXT(format,
+                           mipWidth,
+                           mipHeight,
+                           compressed.getMipLevel(mip),
+                           components,
+                           pitch,
+                           img->getMipLevel(mip));
     }
 
-    auto img = std::make_unique<Image>(transparent0 ? PixelFormat::RGB : PixelFormat::RGBA, ddsd.width, ddsd.height);
-    std::memcpy(img->getPixels(), pixels.get(), (transparent0 ? 3 : 4) * ddsd.width * ddsd.height);
     return img;
 }
 
 } // anonymous namespace
 
-Image* LoadDDSImage(const fs::path& filename)
+Image* LoadDDSImage(const fs::path& filename, std::int32_t reduction)
 {
     std::ifstream in(filename, std::ios::in | std::ios::binary);
     if (!in.good())
@@ -320,24 +319,141 @@ Image* LoadDDSImage(const fs::path& filename)
         return nullptr;
     }
 
+    // Reduce images with mipmaps by not reading the top levels
+    if (reduction > 0)
+        reduction -= SkipMipLevels(ddsd, format, in, reduction);
+
+    std::unique_ptr<Image> img;
     // Check if the platform supports compressed DTXc textures
     if (IsCompressedFormat(format) && !gl::EXT_texture_compression_s3tc)
-        return CreateDecompressedImage(ddsd, format, in, filename).release();
-
-    // TODO: Verify that the reported texture size matches the amount of
-    // data expected.
-    auto img = std::make_unique<Image>(format,
-                                       static_cast<std::int32_t>(ddsd.width),
-                                       static_cast<std::int32_t>(ddsd.height),
-                                       std::max(static_cast<std::int32_t>(ddsd.mipMapLevels), INT32_C(1)));
-    in.read(reinterpret_cast<char*>(img->getPixels()), img->getSize()); /* Flawfinder: ignore */
-    if (!in.eof() && !in.good())
     {
-        util::GetLogger()->error("Failed reading data from DDS texture file {}.\n", filename);
-        return nullptr;
+        img = CreateDecompressedImage(ddsd, format, in, filename);
+        if (img == nullptr)
+            return nullptr;
+    }
+    else
+    {
+        // TODO: Verify that the reported texture size matches the amount of
+        // data expected.
+        img = std::make_unique<Image>(format,
+                                      static_cast<std::int32_t>(ddsd.width),
+                                      static_cast<std::int32_t>(ddsd.height),
+                                      std::max(static_cast<std::int32_t>(ddsd.mipMapLevels), INT32_C(1)));
+        in.read(reinterpret_cast<char*>(img->getPixels()), img->getSize()); /* Flawfinder: ignore */
+        if (!in.eof() && !in.good())
+        {
+            util::GetLogger()->error("Failed reading data from DDS texture file {}.\n", filename);
+            return nullptr;
+        }
+    }
+
+    // Without enough mipmaps, uncompressed images are reduced with a box
+    // filter; compressed ones are kept as they are
+    if (reduction > 0)
+    {
+        if (auto reduced = img->downsample(reduction); reduced != nullptr)
+            return reduced.release();
     }
 
     return img.release();
 }
 
+bool SaveDDSImage(const fs::path& filename, const Image& image)
+{
+    // Flags of the surface description, pixel format and capabilities
+    constexpr std::uint32_t DDSD_CAPS = 0x1;
+    constexpr std::uint32_t DDSD_HEIGHT = 0x2;
+    constexpr std::uint32_t DDSD_WIDTH = 0x4;
+    constexpr std::uint32_t DDSD_PITCH = 0x8;
+    constexpr std::uint32_t DDSD_PIXELFORMAT = 0x1000;
+    constexpr std::uint32_t DDSD_MIPMAPCOUNT = 0x20000;
+    constexpr std::uint32_t DDSD_LINEARSIZE = 0x80000;
+    constexpr std::uint32_t DDPF_ALPHAPIXELS = 0x1;
+    constexpr std::uint32_t DDPF_FOURCC = 0x4;
+    constexpr std::uint32_t DDPF_RGB = 0x40;
+    constexpr std::uint32_t DDSCAPS_COMPLEX = 0x8;
+    constexpr std::uint32_t DDSCAPS_TEXTURE = 0x1000;
+    constexpr std::uint32_t DDSCAPS_MIPMAP = 0x400000;
+
+    PixelFormat format = image.getFormat();
+    std::uint32_t fourCC = 0;
+    std::uint32_t bpp = 0;
+    switch (format)
+    {
+    case PixelFormat::DXT1:
+        fourCC = FourCC("DXT1");
+        break;
+    case PixelFormat::DXT3:
+        fourCC = FourCC("DXT3");
+        break;
+    case PixelFormat::DXT5:
+        fourCC = FourCC("DXT5");
+        break;
+    case PixelFormat::RGB:
+    case PixelFormat::RGB8:
+        bpp = 24;
+        break;
+    case PixelFormat::RGBA:
+    case PixelFormat::RGBA8:
+        bpp = 32;
+        break;
+    default:
+        util::GetLogger()->error("Unsupported format for DDS texture file {}.\n", filename);
+        return false;
+    }
+
+    std::ofstream out(filename, std::ios::out | std::ios::binary);
+    if (!out.good())
+    {
+        util::GetLogger()->error("Error opening DDS texture file {}.\n", filename);
+        return false;
+    }
+
+    auto mipLevels = static_cast<std::uint32_t>(image.getMipLevelCount());
+    std::uint32_t flags = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT;
+    flags |= fourCC != 0 ? DDSD_LINEARSIZE : DDSD_PITCH;
+    std::uint32_t caps = DDSCAPS_TEXTURE;
+    if (mipLevels > 1)
+    {
+        flags |= DDSD_MIPMAPCOUNT;
+        caps |= DDSCAPS_COMPLEX | DDSCAPS_MIPMAP;
+    }
+
+    out.write("DDS ", 4);
+    util::writeLE<std::uint32_t>(out, sizeof(DDSurfaceDesc));
+    util::writeLE<std::uint32_t>(out, flags);
+    util::writeLE<std::uint32_t>(out, static_cast<std::uint32_t>(image.getHeight()));
+    util::writeLE<std::uint32_t>(out, static_cast<std::uint32_t>(image.getWidth()));
+    util::writeLE<std::uint32_t>(out, static_cast<std::uint32_t>(fourCC != 0 ? image.getMipLevelSize(0)
+                                                                             : image.getPitch()));
+    util::writeLE<std::uint32_t>(out, 0); // depth
+    util::writeLE<std::uint32_t>(out, mipLevels);
+    for (std::size_t i = offsetof(DDSurfaceDesc, alphaBitDepth); i < offsetof(DDSurfaceDesc, format); i += 4)
+        util::writeLE<std::uint32_t>(out, 0);
+
+    util::writeLE<std::uint32_t>(out, sizeof(DDPixelFormat));
+    util::writeLE<std::uint32_t>(out, fourCC != 0 ? DDPF_FOURCC : DDPF_RGB | (bpp == 32 ? DDPF_ALPHAPIXELS : 0));
+    util::writeLE<std::uint32_t>(out, fourCC);
+    util::writeLE<std::uint32_t>(out, bpp);
+    // Red, green, blue and alpha masks of the byte order of Image
+    util::writeLE<std::uint32_t>(out, bpp != 0 ? 0x000000ff : 0);
+    util::writeLE<std::uint32_t>(out, bpp != 0 ? 0x0000ff00 : 0);
+    util::writeLE<std::uint32_t>(out, bpp != 0 ? 0x00ff0000 : 0);
+    util::writeLE<std::uint32_t>(out, bpp == 32 ? 0xff000000 : 0);
+
+    util::writeLE<std::uint32_t>(out, caps);
+    for (std::size_t i = offsetof(DDSurfaceDesc, caps) + 4; i < sizeof(DDSurfaceDesc); i += 4)
+        util::writeLE<std::uint32_t>(out, 0);
+
+    // The mip levels of Image are laid out as in the file
+    out.write(reinterpret_cast<const char*>(image.getPixels()), image.getSize());
+    if (!out.good())
+    {
+        util::GetLogger()->error("Error writing DDS texture file {}.\n", filename);
+        return false;
+    }
+
+    return true;
+}
+
 } // namespace celestia::engine
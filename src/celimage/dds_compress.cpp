@@ -0,0 +1,252 @@
+// dds_compress.cpp
+//
+// Copyright (C) 2024, Celestia Development Team
+//
+// DXT1/DXT5 block compression.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include "dds_compress.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <utility>
+
+namespace celestia::engine
+{
+namespace
+{
+
+constexpr int BlockPixels = 16;
+
+using Color = std::array<int, 3>;
+
+std::uint16_t
+Pack565(const Color& c)
+{
+    return static_cast<std::uint16_t>(((c[0] * 31 + 127) / 255) << 11 |
+                                      ((c[1] * 63 + 127) / 255) << 5 |
+                                      ((c[2] * 31 + 127) / 255));
+}
+
+Color
+Unpack565(std::uint16_t c)
+{
+    int r = c >> 11;
+    int g = (c >> 5) & 0x3f;
+    int b = c & 0x1f;
+    return { (r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2) };
+}
+
+int
+Distance(const Color& c, const std::uint8_t* pixel)
+{
+    int dr = c[0] - pixel[0];
+    int dg = c[1] - pixel[1];
+    int db = c[2] - pixel[2];
+    return dr * dr + dg * dg + db * db;
+}
+
+// Compute the endpoints of the line through the colors of the block along
+// their principal axis, which is found by power iteration on the covariance
+// matrix. The endpoints are moved inwards by 1/16 of the range, as the
+// extreme colors are better matched by the interpolated palette entries.
+std::pair<Color, Color>
+FindEndpoints(const std::uint8_t* pixels)
+{
+    std::array<float, 3> mean{ 0.0f, 0.0f, 0.0f };
+    for (int i = 0; i < BlockPixels; ++i)
+    {
+        for (int c = 0; c < 3; ++c)
+            mean[c] += static_cast<float>(pixels[i * 4 + c]);
+    }
+    for (float& m : mean)
+        m /= static_cast<float>(BlockPixels);
+
+    // Covariance matrix
+    std::array<std::array<float, 3>, 3> cov{};
+    for (int i = 0; i < BlockPixels; ++i)
+    {
+        std::array<float, 3> d;
+        for (int c = 0; c < 3; ++c)
+            d[c] = static_cast<float>(pixels[i * 4 + c]) - mean[c];
+        for (int r = 0; r < 3; ++r)
+        {
+            for (int c = 0; c < 3; ++c)
+                cov[r][c] += d[r] * d[c];
+        }
+    }
+
+    // Start from the column of the channel with the largest variance, which
+    // can't be orthogonal to the principal axis
+    int largest = 0;
+    for (int c = 1; c < 3; ++c)
+    {
+        if (cov[c][c] > cov[largest][largest])
+            largest = c;
+    }
+
+    std::array<float, 3> axis{ cov[0][largest], cov[1][largest], cov[2][largest] };
+    for (int iteration = 0; iteration < 8; ++iteration)
+    {
+        std::array<float, 3> next;
+        for (int r = 0; r < 3; ++r)
+            next[r] = cov[r][0] * axis[0] + cov[r][1] * axis[1] + cov[r][2] * axis[2];
+
+        float norm = std::sqrt(next[0] * next[0] + next[1] * next[1] + next[2] * next[2]);
+        if (norm == 0.0f)
+            break;
+        for (int c = 0; c < 3; ++c)
+            axis[c] = next[c] / norm;
+    }
+
+    float norm = std::sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+    if (norm == 0.0f)
+    {
+        // All pixels have the same color
+        Color c;
+        for (int i = 0; i < 3; ++i)
+            c[i] = static_cast<int>(std::lround(mean[i]));
+        return { c, c };
+    }
+    for (float& a : axis)
+        a /= norm;
+
+    float tMin = 0.0f;
+    float tMax = 0.0f;
+    for (int i = 0; i < BlockPixels; ++i)
+    {
+        float t = 0.0f;
+        for (int c = 0; c < 3; ++c)
+            t += (static_cast<float>(pixels[i * 4 + c]) - mean[c]) * axis[c];
+        tMin = std::min(tMin, t);
+        tMax = std::max(tMax, t);
+    }
+
+    float inset = (tMax - tMin) / 16.0f;
+    tMin += inset;
+    tMax -= inset;
+
+    Color c0;
+    Color c1;
+    for (int c = 0; c < 3; ++c)
+    {
+        c0[c] = std::clamp(static_cast<int>(std::lround(mean[c] + axis[c] * tMax)), 0, 255);
+        c1[c] = std::clamp(static_cast<int>(std::lround(mean[c] + axis[c] * tMin)), 0, 255);
+    }
+
+    return { c0, c1 };
+}
+
+void
+CompressColorBlock(const std::uint8_t* pixels, std::uint8_t* blockStorage)
+{
+    auto [max, min] = FindEndpoints(pixels);
+    std::uint16_t color0 = Pack565(max);
+    std::uint16_t color1 = Pack565(min);
+
+    // color0 > color1 selects the four color mode
+    if (color0 < color1)
+        std::swap(color0, color1);
+
+    std::uint32_t code = 0;
+    if (color0 != color1)
+    {
+        Color c0 = Unpack565(color0);
+        Color c1 = Unpack565(color1);
+        std::array<Color, 4> palette
+        {
+            c0,
+            c1,
+            Color{ (2 * c0[0] + c1[0]) / 3, (2 * c0[1] + c1[1]) / 3, (2 * c0[2] + c1[2]) / 3 },
+            Color{ (c0[0] + 2 * c1[0]) / 3, (c0[1] + 2 * c1[1]) / 3, (c0[2] + 2 * c1[2]) / 3 },
+        };
+
+        for (int i = 0; i < BlockPixels; ++i)
+        {
+            const std::uint8_t* pixel = pixels + i * 4;
+            std::uint32_t best = 0;
+            int bestDistance = Distance(palette[0], pixel);
+            for (std::uint32_t j = 1; j < 4; ++j)
+            {
+                if (int distance = Distance(palette[j], pixel); distance < bestDistance)
+                {
+                    best = j;
+                    bestDistance = distance;
+                }
+            }
+            code |= best << (2 * i);
+        }
+    }
+
+    blockStorage[0] = static_cast<std::uint8_t>(color0);
+    blockStorage[1] = static_cast<std::uint8_t>(color0 >> 8);
+    blockStorage[2] = static_cast<std::uint8_t>(color1);
+    blockStorage[3] = static_cast<std::uint8_t>(color1 >> 8);
+    for (int i = 0; i < 4; ++i)
+        blockStorage[4 + i] = static_cast<std::uint8_t>(code >> (8 * i));
+}
+
+void
+CompressAlphaBlock(const std::uint8_t* pixels, std::uint8_t* blockStorage)
+{
+    int alpha0 = 0;
+    int alpha1 = 255;
+    for (int i = 0; i < BlockPixels; ++i)
+    {
+        alpha0 = std::max(alpha0, static_cast<int>(pixels[i * 4 + 3]));
+        alpha1 = std::min(alpha1, static_cast<int>(pixels[i * 4 + 3]));
+    }
+
+    // alpha0 > alpha1 selects the eight value mode
+    std::uint64_t code = 0;
+    if (alpha0 != alpha1)
+    {
+        std::array<int, 8> palette{ alpha0, alpha1 };
+        for (int j = 2; j < 8; ++j)
+            palette[j] = ((8 - j) * alpha0 + (j - 1) * alpha1) / 7;
+
+        for (int i = 0; i < BlockPixels; ++i)
+        {
+            int alpha = pixels[i * 4 + 3];
+            std::uint64_t best = 0;
+            int bestDistance = std::abs(palette[0] - alpha);
+            for (std::uint64_t j = 1; j < 8; ++j)
+            {
+                if (int distance = std::abs(palette[j] - alpha); distance < bestDistance)
+                {
+                    best = j;
+                    bestDistance = distance;
+                }
+            }
+            code |= best << (3 * i);
+        }
+    }
+
+    blockStorage[0] = static_cast<std::uint8_t>(alpha0);
+    blockStorage[1] = static_cast<std::uint8_t>(alpha1);
+    for (int i = 0; i < 6; ++i)
+        blockStorage[2 + i] = static_cast<std::uint8_t>(code >> (8 * i));
+}
+
+} // namespace
+
+void
+CompressBlockDXT1(const std::uint8_t* pixels, std::uint8_t* blockStorage)
+{
+    CompressColorBlock(pixels, blockStorage);
+}
+
+void
+CompressBlockDXT5(const std::uint8_t* pixels, std::uint8_t* blockStorage)
+{
+    CompressAlphaBlock(pixels, blockStorage);
+    CompressColorBlock(pixels, blockStorage + 8);
+}
+
+} // namespace celestia::engine
@@ -0,0 +1,36 @@
+// dds_compress.h
+//
+// Copyright (C) 2024, Celestia Development Team
+//
+// DXT1/DXT5 block compression.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <cstdint>
+
+namespace celestia::engine
+{
+
+/**
+ * @brief Compresses one block of a DXT1 texture.
+ * The alpha channel of the pixels is ignored.
+ *
+ * @param pixels - the 4x4 pixels of the block in row order, 4 bytes (RGBA) per pixel.
+ * @param blockStorage - pointer to the 8 bytes receiving the compressed block.
+ */
+void CompressBlockDXT1(const std::uint8_t *pixels, std::uint8_t *blockStorage);
+
+/**
+ * @brief Compresses one block of a DXT5 texture.
+ *
+ * @param pixels - the 4x4 pixels of the block in row order, 4 bytes (RGBA) per pixel.
+ * @param blockStorage - pointer to the 16 bytes receiving the compressed block.
+ */
+void CompressBlockDXT5(const std::uint8_t *pixels, std::uint8_t *blockStorage);
+
+} // namespace celestia::engine
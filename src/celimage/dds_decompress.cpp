@@ -1,5 +1,16 @@
+#include <algorithm>
 #include <array>
+#include <cstring>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CELESTIA_DXT_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define CELESTIA_DXT_NEON
+#include <arm_neon.h>
+#endif
+
+#include <celutil/threadpool.h>
 #include "dds_decompress.h"
 
 /*
@@ -336,4 +347,237 @@ void DecompressBlockDXT3(std::uint32_t x,
                                 alphaValues.data());
 }
 
+namespace
+{
+
+// Number of block rows decompressed by one task of DecompressImageDXT
+constexpr std::uint32_t BlockRowsPerTask = 16;
+
+std::uint32_t
+Expand565(std::uint16_t color)
+{
+    std::uint32_t temp = (color >> 11) * 255 + 16;
+    auto r = static_cast<std::uint8_t>((temp / 32 + temp) / 32);
+    temp = ((color & 0x07E0) >> 5) * 255 + 32;
+    auto g = static_cast<std::uint8_t>((temp / 64 + temp) / 64);
+    temp = (color & 0x001F) * 255 + 16;
+    auto b = static_cast<std::uint8_t>((temp / 32 + temp) / 32);
+    return PackRGBA(r, g, b, 0);
+}
+
+std::uint32_t
+Mix(std::uint32_t c0, std::uint32_t c1, std::uint32_t w0, std::uint32_t w1, std::uint32_t d)
+{
+    std::uint32_t result = 0;
+    for (int shift = 0; shift < 24; shift += 8)
+    {
+        std::uint32_t v = (w0 * ((c0 >> shift) & 0xff) + w1 * ((c1 >> shift) & 0xff)) / d;
+        result |= v << shift;
+    }
+    return result;
+}
+
+// Write palette[index] for each of the 16 pixels of a block, where the 2-bit
+// indices are packed in code. The palette entries have zero alpha.
+void
+SelectColors(const std::array<std::uint32_t, 4>& palette, std::uint32_t code, std::uint32_t* pixels)
+{
+#if defined(CELESTIA_DXT_SSE2)
+    // Each lane tests the bits of its pixel within a row of the code, which
+    // avoids variable shifts
+    const __m128i laneMask = _mm_setr_epi32(0x03, 0x0c, 0x30, 0xc0);
+    __m128i entries[4]; //NOSONAR
+    __m128i values[4]; //NOSONAR
+    for (int k = 0; k < 4; ++k)
+    {
+        entries[k] = _mm_set1_epi32(static_cast<int>(palette[k]));
+        values[k] = _mm_setr_epi32(k, k << 2, k << 4, k << 6);
+    }
+
+    for (int j = 0; j < 4; ++j)
+    {
+        __m128i bits = _mm_and_si128(_mm_set1_epi32(static_cast<int>((code >> (8 * j)) & 0xff)), laneMask);
+        __m128i result = _mm_setzero_si128();
+        for (int k = 0; k < 4; ++k)
+            result = _mm_or_si128(result, _mm_and_si128(_mm_cmpeq_epi32(bits, values[k]), entries[k]));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pixels + 4 * j), result); //NOSONAR
+    }
+#elif defined(CELESTIA_DXT_NEON)
+    static constexpr std::array<std::uint32_t, 4> laneMaskValues{ 0x03, 0x0c, 0x30, 0xc0 };
+    const uint32x4_t laneMask = vld1q_u32(laneMaskValues.data());
+    uint32x4_t entries[4]; //NOSONAR
+    uint32x4_t values[4]; //NOSONAR
+    for (std::uint32_t k = 0; k < 4; ++k)
+    {
+        entries[k] = vdupq_n_u32(palette[k]);
+        const std::array<std::uint32_t, 4> value{ k, k << 2, k << 4, k << 6 };
+        values[k] = vld1q_u32(value.data());
+    }
+
+    for (int j = 0; j < 4; ++j)
+    {
+        uint32x4_t bits = vandq_u32(vdupq_n_u32((code >> (8 * j)) & 0xff), laneMask);
+        uint32x4_t result = vdupq_n_u32(0);
+        for (int k = 0; k < 4; ++k)
+            result = vorrq_u32(result, vandq_u32(vceqq_u32(bits, values[k]), entries[k]));
+        vst1q_u32(pixels + 4 * j, result);
+    }
+#else
+    for (int i = 0; i < 16; ++i)
+        pixels[i] = palette[(code >> (2 * i)) & 0x03];
+#endif
+}
+
+// The three color mode is only used by DXT1; the color blocks of DXT3 and
+// DXT5 are always decoded with four colors.
+void
+DecodeColorBlock(const std::uint8_t* block, bool allowThreeColors, std::uint32_t* pixels)
+{
+    auto color0 = static_cast<std::uint16_t>(block[0] | (block[1] << 8));
+    auto color1 = static_cast<std::uint16_t>(block[2] | (block[3] << 8));
+    std::uint32_t code = static_cast<std::uint32_t>(block[4]) |
+                         static_cast<std::uint32_t>(block[5]) << 8 |
+                         static_cast<std::uint32_t>(block[6]) << 16 |
+                         static_cast<std::uint32_t>(block[7]) << 24;
+
+    std::array<std::uint32_t, 4> palette;
+    palette[0] = Expand565(color0);
+    palette[1] = Expand565(color1);
+    if (color0 > color1 || !allowThreeColors)
+    {
+        palette[2] = Mix(palette[0], palette[1], 2, 1, 3);
+        palette[3] = Mix(palette[0], palette[1], 1, 2, 3);
+    }
+    else
+    {
+        palette[2] = Mix(palette[0], palette[1], 1, 1, 2);
+        palette[3] = 0;
+    }
+
+    SelectColors(palette, code, pixels);
+}
+
+void
+DecodeAlphaBlockDXT3(const std::uint8_t* block, std::uint32_t* pixels)
+{
+    for (int i = 0; i < 16; ++i)
+    {
+        std::uint32_t alpha = ((block[i / 2] >> (4 * (i & 1))) & 0x0f) * 17;
+        pixels[i] |= alpha << 24;
+    }
+}
+
+void
+DecodeAlphaBlockDXT5(const std::uint8_t* block, std::uint32_t* pixels)
+{
+    std::uint32_t alpha0 = block[0];
+    std::uint32_t alpha1 = block[1];
+
+    std::array<std::uint32_t, 8> palette{ alpha0, alpha1 };
+    if (alpha0 > alpha1)
+    {
+        for (std::uint32_t c = 2; c < 8; ++c)
+            palette[c] = ((8 - c) * alpha0 + (c - 1) * alpha1) / 7;
+    }
+    else
+    {
+        for (std::uint32_t c = 2; c < 6; ++c)
+            palette[c] = ((6 - c) * alpha0 + (c - 1) * alpha1) / 5;
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+
+    std::uint64_t code = 0;
+    for (int i = 0; i < 6; ++i)
+        code |= static_cast<std::uint64_t>(block[2 + i]) << (8 * i);
+
+    for (int i = 0; i < 16; ++i)
+        pixels[i] |= palette[(code >> (3 * i)) & 0x07] << 24;
+}
+
+void
+DecompressBlockRow(PixelFormat format,
+                   std::uint32_t width,
+                   std::uint32_t rows,
+                   const std::uint8_t* blocks,
+                   std::uint32_t components,
+                   std::uint32_t pitch,
+                   std::uint8_t* image)
+{
+    std::array<std::uint32_t, 16> pixels;
+    for (std::uint32_t x = 0; x < width; x += 4)
+    {
+        switch (format)
+        {
+        case PixelFormat::DXT1:
+            DecodeColorBlock(blocks, true, pixels.data());
+            blocks += 8;
+            break;
+        case PixelFormat::DXT3:
+            DecodeColorBlock(blocks + 8, false, pixels.data());
+            DecodeAlphaBlockDXT3(blocks, pixels.data());
+            blocks += 16;
+            break;
+        default:
+            DecodeColorBlock(blocks + 8, false, pixels.data());
+            DecodeAlphaBlockDXT5(blocks, pixels.data());
+            blocks += 16;
+            break;
+        }
+
+        // Clip the blocks at the right and bottom edges
+        std::uint32_t columns = std::min(width - x, 4U);
+        for (std::uint32_t j = 0; j < rows; ++j)
+        {
+            std::uint8_t* dst = image + j * pitch + x * components;
+            for (std::uint32_t i = 0; i < columns; ++i, dst += components)
+            {
+                std::uint32_t pixel = pixels[j * 4 + i];
+                dst[0] = static_cast<std::uint8_t>(pixel);
+                dst[1] = static_cast<std::uint8_t>(pixel >> 8);
+                dst[2] = static_cast<std::uint8_t>(pixel >> 16);
+                if (components == 4)
+                    dst[3] = static_cast<std::uint8_t>(pixel >> 24);
+            }
+        }
+    }
+}
+
+} // namespace
+
+void DecompressImageDXT(PixelFormat format,
+                        std::uint32_t width,
+                        std::uint32_t height,
+                        const std::uint8_t* blocks,
+                        std::uint32_t components,
+                        std::uint32_t pitch,
+                        std::uint8_t* image)
+{
+    std::uint32_t blockSize = format == PixelFormat::DXT1 ? 8 : 16;
+    std::uint32_t rowSize = ((width + 3) / 4) * blockSize;
+    std::uint32_t blockRows = (height + 3) / 4;
+    std::uint32_t taskCount = (blockRows + BlockRowsPerTask - 1) / BlockRowsPerTask;
+
+    auto decompressRows = [&](std::size_t task)
+    {
+        auto first = static_cast<std::uint32_t>(task) * BlockRowsPerTask;
+        std::uint32_t last = std::min(first + BlockRowsPerTask, blockRows);
+        for (std::uint32_t row = first; row < last; ++row)
+        {
+            DecompressBlockRow(format,
+                               width,
+                               std::min(height - row * 4, 4U),
+                               blocks + row * rowSize,
+                               components,
+                               pitch,
+                               image + row * 4 * pitch);
+        }
+    };
+
+    if (taskCount == 1)
+        decompressRows(0);
+    else
+        util::GetThreadPool()->parallelFor(taskCount, decompressRows);
+}
+
 } // namespace celestia::engine
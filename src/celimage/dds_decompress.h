@@ -3,6 +3,8 @@
 #include <cstddef>
 #include <cstdint>
 
+#include "pixelformat.h"
+
 namespace celestia::engine
 {
 
@@ -48,4 +50,23 @@ void DecompressBlockDXT5(std::uint32_t x, std::uint32_t y, std::uint32_t width,
                          const std::uint8_t *blockStorage, bool transparent0,
                          std::uint32_t *image);
 
+/**
+ * @brief Decompresses one mip level of a DXT1, DXT3 or DXT5 texture.
+ * Rows of blocks are decompressed in parallel. The pixels are written as RGB
+ * or RGBA depending on 'components'; DXT1 transparency is not kept.
+ *
+ * @param format - the compressed format of the blocks.
+ * @param width - width of the mip level in pixels.
+ * @param height - height of the mip level in pixels.
+ * @param blocks - pointer to the compressed blocks of the mip level.
+ * @param components - number of bytes per pixel of 'image', 3 or 4.
+ * @param pitch - number of bytes per row of 'image'.
+ * @param image - pointer to the image where the pixels should be stored.
+*/
+void DecompressImageDXT(PixelFormat format,
+                        std::uint32_t width, std::uint32_t height,
+                        const std::uint8_t *blocks,
+                        std::uint32_t components, std::uint32_t pitch,
+                        std::uint8_t *image);
+
 } // namespace celestia::engine
@@ -0,0 +1,86 @@
+// downsample.cpp
+//
+// Copyright (C) 2024, Celestia Development Team
+//
+// Box filter reduction of images while they are decoded.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include "downsample.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+
+#include "image.h"
+
+namespace celestia::engine
+{
+
+RowDownsampler::RowDownsampler(std::int32_t width,
+                               std::int32_t height,
+                               std::int32_t reduction,
+                               Image& image) :
+    m_width(width),
+    m_height(height),
+    m_reduction(reduction),
+    m_components(image.getComponents()),
+    m_image(image),
+    m_sums(static_cast<std::size_t>(ReducedSize(width, reduction) * image.getComponents()), 0U)
+{
+    assert(!image.isCompressed());
+    assert(image.getWidth() == ReducedSize(width, reduction));
+    assert(image.getHeight() == ReducedSize(height, reduction));
+}
+
+void
+RowDownsampler::addRow(const std::uint8_t* row)
+{
+    if (m_row >= m_height)
+        return;
+
+    for (std::int32_t x = 0; x < m_width; ++x)
+    {
+        std::uint32_t* sum = m_sums.data() + (x >> m_reduction) * m_components;
+        const std::uint8_t* pixel = row + x * m_components;
+        for (std::int32_t c = 0; c < m_components; ++c)
+            sum[c] += pixel[c];
+    }
+
+    ++m_row;
+    ++m_rowsAdded;
+    if (m_rowsAdded == (INT32_C(1) << m_reduction) || m_row == m_height)
+        emitRow();
+}
+
+void
+RowDownsampler::emitRow()
+{
+    std::uint8_t* out = m_image.getPixelRow((m_row - 1) >> m_reduction);
+    std::int32_t blockWidth = INT32_C(1) << m_reduction;
+    std::int32_t reducedWidth = m_image.getWidth();
+    for (std::int32_t x = 0; x < reducedWidth; ++x)
+    {
+        auto count = static_cast<std::uint32_t>(std::min(blockWidth, m_width - x * blockWidth) * m_rowsAdded);
+        std::uint32_t* sum = m_sums.data() + x * m_components;
+        for (std::int32_t c = 0; c < m_components; ++c)
+        {
+            out[x * m_components + c] = static_cast<std::uint8_t>((sum[c] + count / 2) / count);
+            sum[c] = 0;
+        }
+    }
+
+    m_rowsAdded = 0;
+}
+
+std::int32_t
+RowDownsampler::ReducedSize(std::int32_t size, std::int32_t reduction)
+{
+    // Round up, so that the pixels of the last partial block are kept
+    return std::max((size + (INT32_C(1) << reduction) - 1) >> reduction, INT32_C(1));
+}
+
+} // namespace celestia::engine
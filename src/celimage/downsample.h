@@ -0,0 +1,59 @@
+// downsample.h
+//
+// Copyright (C) 2024, Celestia Development Team
+//
+// Box filter reduction of images while they are decoded.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace celestia::engine
+{
+
+class Image;
+
+/**
+ * Averages blocks of 2^reduction by 2^reduction pixels of an uncompressed
+ * image, one source row at a time, so that the image doesn't need to be
+ * decoded at full size first. Blocks at the right and bottom edges are
+ * averaged over the pixels they contain.
+ */
+class RowDownsampler
+{
+public:
+    /**
+     * @param width - width of the source image.
+     * @param height - height of the source image.
+     * @param reduction - number of times the width and height are halved.
+     * @param image - the image receiving the result, with a size of
+     * ReducedSize(width, reduction) by ReducedSize(height, reduction) and
+     * the same format as the source.
+     */
+    RowDownsampler(std::int32_t width, std::int32_t height, std::int32_t reduction, Image& image);
+
+    // Adds the next row of the source image
+    void addRow(const std::uint8_t* row);
+
+    static std::int32_t ReducedSize(std::int32_t size, std::int32_t reduction);
+
+private:
+    void emitRow();
+
+    std::int32_t m_width;
+    std::int32_t m_height;
+    std::int32_t m_reduction;
+    std::int32_t m_components;
+    std::int32_t m_row{ 0 };
+    std::int32_t m_rowsAdded{ 0 };
+    Image& m_image;
+    std::vector<std::uint32_t> m_sums;
+};
+
+} // namespace celestia::engine
@@ -10,13 +10,19 @@
 #include "image.h"
 
 #include <algorithm>
+#include <array>
 #include <cassert>
 #include <cmath>
+#include <cstring>
 #include <tuple>
+#include <utility>
+#include <vector>
 
 #include <celutil/filetype.h>
 #include <celutil/gettext.h>
 #include <celutil/logger.h>
+#include "dds_compress.h"
+#include "downsample.h"
 #include "imageformats.h"
 
 namespace celestia::engine
@@ -155,7 +161,7 @@ Image::Image(PixelFormat fmt, std::int32_t w, std::int32_t h, std::int32_t mip)
     assert(height > 0 && height <= MAX_DIMENSION);
 
     pitch = pad(w * components);
-    pixels = std::make_unique<std::uint8_t[]>(size);
+    pixels = AllocateImageBuffer(static_cast<std::size_t>(size));
 }
 
 bool
@@ -357,6 +363,137 @@ Image::computeNormalMap(float scale, bool wrap) const
     return normalMap;
 }
 
+std::unique_ptr<Image>
+Image::compressDXT() const
+{
+    PixelFormat compressedFormat;
+    bool bgr = false;
+    switch (format)
+    {
+    case PixelFormat::BGR:
+        bgr = true;
+        [[fallthrough]];
+    case PixelFormat::RGB:
+        compressedFormat = PixelFormat::DXT1;
+        break;
+    case PixelFormat::BGRA:
+        bgr = true;
+        [[fallthrough]];
+    case PixelFormat::RGBA:
+        compressedFormat = PixelFormat::DXT5;
+        break;
+    case PixelFormat::sRGB:
+        compressedFormat = PixelFormat::DXT1_sRGBA;
+        break;
+    case PixelFormat::sRGBA:
+        compressedFormat = PixelFormat::DXT5_sRGBA;
+        break;
+    default:
+        return nullptr;
+    }
+
+    std::int32_t mipCount = 1;
+    while ((width >> mipCount) > 0 || (height >> mipCount) > 0)
+        ++mipCount;
+
+    auto compressed = std::make_unique<Image>(compressedFormat, width, height, mipCount);
+    bool dxt1 = compressedFormat == PixelFormat::DXT1 || compressedFormat == PixelFormat::DXT1_sRGBA;
+    std::int32_t blockSize = dxt1 ? 8 : 16;
+
+    // Expand the base level to RGBA, and then compress each mip level
+    // before reducing it to the next one with a box filter
+    std::int32_t w = width;
+    std::int32_t h = height;
+    std::vector<std::uint8_t> level(static_cast<std::size_t>(w) * static_cast<std::size_t>(h) * 4);
+    for (std::int32_t y = 0; y < h; ++y)
+    {
+        const std::uint8_t* src = pixels.get() + y * pitch;
+        std::uint8_t* dst = level.data() + static_cast<std::size_t>(y) * w * 4;
+        for (std::int32_t x = 0; x < w; ++x, src += components, dst += 4)
+        {
+            dst[0] = src[bgr ? 2 : 0];
+            dst[1] = src[1];
+            dst[2] = src[bgr ? 0 : 2];
+            dst[3] = components == 4 ? src[3] : 255;
+        }
+    }
+
+    for (std::int32_t mip = 0; mip < mipCount; ++mip)
+    {
+        std::uint8_t* block = compressed->getMipLevel(mip);
+        std::array<std::uint8_t, 64> blockPixels;
+        for (std::int32_t by = 0; by < h; by += 4)
+        {
+            for (std::int32_t bx = 0; bx < w; bx += 4, block += blockSize)
+            {
+                // Blocks at the edges of levels smaller than a multiple of 4
+                // repeat the last row and column
+                for (std::int32_t i = 0; i < 16; ++i)
+                {
+                    std::int32_t x = std::min(bx + (i & 3), w - 1);
+                    std::int32_t y = std::min(by + (i >> 2), h - 1);
+                    std::memcpy(blockPixels.data() + i * 4,
+                                level.data() + (static_cast<std::size_t>(y) * w + x) * 4,
+                                4);
+                }
+
+                if (dxt1)
+                    CompressBlockDXT1(blockPixels.data(), block);
+                else
+                    CompressBlockDXT5(blockPixels.data(), block);
+            }
+        }
+
+        if (mip + 1 == mipCount)
+            break;
+
+        std::int32_t nw = std::max(w >> 1, INT32_C(1));
+        std::int32_t nh = std::max(h >> 1, INT32_C(1));
+        std::vector<std::uint8_t> next(static_cast<std::size_t>(nw) * static_cast<std::size_t>(nh) * 4);
+        for (std::int32_t y = 0; y < nh; ++y)
+        {
+            std::int32_t y0 = std::min(y * 2, h - 1);
+            std::int32_t y1 = std::min(y * 2 + 1, h - 1);
+            for (std::int32_t x = 0; x < nw; ++x)
+            {
+                std::int32_t x0 = std::min(x * 2, w - 1);
+                std::int32_t x1 = std::min(x * 2 + 1, w - 1);
+                for (std::int32_t c = 0; c < 4; ++c)
+                {
+                    auto texel = [&](std::int32_t tx, std::int32_t ty)
+                    {
+                        return static_cast<std::int32_t>(level[(static_cast<std::size_t>(ty) * w + tx) * 4 + c]);
+                    };
+                    next[(static_cast<std::size_t>(y) * nw + x) * 4 + c] =
+                        static_cast<std::uint8_t>((texel(x0, y0) + texel(x1, y0) + texel(x0, y1) + texel(x1, y1) + 2) / 4);
+                }
+            }
+        }
+
+        level = std::move(next);
+        w = nw;
+        h = nh;
+    }
+
+    return compressed;
+}
+
+std::unique_ptr<Image>
+Image::downsample(std::int32_t reduction) const
+{
+    if (isCompressed() || reduction <= 0)
+        return nullptr;
+
+    auto reduced = std::make_unique<Image>(format,
+                                           RowDownsampler::ReducedSize(width, reduction),
+                                           RowDownsampler::ReducedSize(height, reduction));
+    RowDownsampler downsampler(width, height, reduction, *reduced);
+    for (std::int32_t y = 0; y < height; ++y)
+        downsampler.addRow(pixels.get() + y * pitch);
+
+    return reduced;
+}
+
 void Image::forceLinear()
 {
     format = getLinearFormat(format);
@@ -380,7 +517,7 @@ bool Image::save(const fs::path &path, ContentType type) const
     }
 }
 
-std::unique_ptr<Image> Image::load(const fs::path& filename)
+std::unique_ptr<Image> Image::load(const fs::path& filename, std::int32_t reduction)
 {
     ContentType type = DetermineFileType(filename);
 
@@ -390,13 +527,15 @@ std::unique_ptr<Image> Image::load(const fs::path& filename)
     switch (type)
     {
     case ContentType::JPEG:
-        img = LoadJPEGImage(filename);
+        img = LoadJPEGImage(filename, reduction);
+        reduction = 0;
         break;
     case ContentType::BMP:
         img = LoadBMPImage(filename);
         break;
     case ContentType::PNG:
-        img = LoadPNGImage(filename);
+        img = LoadPNGImage(filename, reduction);
+        reduction = 0;
         break;
 #ifdef USE_LIBAVIF
     case ContentType::AVIF:
@@ -405,14 +544,22 @@ std::unique_ptr<Image> Image::load(const fs::path& filename)
 #endif
     case ContentType::DDS:
     case ContentType::DXT5NormalMap:
-        img = LoadDDSImage(filename);
+        img = LoadDDSImage(filename, reduction);
+        reduction = 0;
         break;
     default:
         util::GetLogger()->error(_("{}: unrecognized or unsupported image file type.\n"), filename);
         break;
     }
 
-    return std::unique_ptr<Image>(img);
+    std::unique_ptr<Image> result(img);
+    if (result != nullptr && reduction > 0)
+    {
+        if (auto reduced = result->downsample(reduction); reduced != nullptr)
+            return reduced;
+    }
+
+    return result;
 }
 
 } // namespace celestia::engine
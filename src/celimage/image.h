@@ -15,6 +15,7 @@
 
 #include <celcompat/filesystem.h>
 #include <celutil/filetype.h>
+#include "bufferpool.h"
 #include "pixelformat.h"
 
 namespace celestia::engine
@@ -60,12 +61,25 @@ public:
 
     std::unique_ptr<Image> computeNormalMap(float scale, bool wrap) const;
 
+    // Returns the image compressed to DXT1, or DXT5 if it has an alpha
+    // channel, with a complete set of mipmaps. Returns nullptr for formats
+    // other than 8-bit RGB and RGBA.
+    std::unique_ptr<Image> compressDXT() const;
+
+    // Returns the base level with its width and height halved reduction
+    // times by averaging blocks of pixels, or nullptr for compressed images.
+    std::unique_ptr<Image> downsample(std::int32_t reduction) const;
+
     void forceLinear();
 
     static bool canSave(ContentType type);
     bool save(const fs::path &path, ContentType type) const;
 
-    static std::unique_ptr<Image> load(const fs::path& filename);
+    // With a reduction, the image is loaded with its width and height halved
+    // that many times. JPEG images are scaled while they are decoded, DDS
+    // images skip the top mip levels they have, and other images are reduced
+    // with a box filter.
+    static std::unique_ptr<Image> load(const fs::path& filename, std::int32_t reduction = 0);
 
 private:
     std::int32_t width;
@@ -75,7 +89,8 @@ private:
     std::int32_t components;
     PixelFormat format;
     std::int32_t size;
-    std::unique_ptr<std::uint8_t[]> pixels;
+    // From the ImageBufferPool
+    ImageBuffer pixels;
 };
 
 } // namespace celestia::engine
@@ -10,21 +10,50 @@
 
 #pragma once
 
+#include <cstdint>
+#include <memory>
+
 #include <celcompat/filesystem.h>
 #include <celimage/image.h>
 
 namespace celestia::engine
 {
 
-Image* LoadJPEGImage(const fs::path& filename);
+Image* LoadJPEGImage(const fs::path& filename, std::int32_t reduction = 0);
 Image* LoadBMPImage(const fs::path& filename);
-Image* LoadPNGImage(const fs::path& filename);
-Image* LoadDDSImage(const fs::path& filename);
+Image* LoadPNGImage(const fs::path& filename, std::int32_t reduction = 0);
+Image* LoadDDSImage(const fs::path& filename, std::int32_t reduction = 0);
 #ifdef USE_LIBAVIF
 Image* LoadAVIFImage(const fs::path& filename);
 #endif
 
 bool SaveJPEGImage(const fs::path& filename, const Image& image);
 bool SavePNGImage(const fs::path& filename, const Image& image);
+// Saves DXT compressed, RGB and RGBA images with their mip levels
+bool SaveDDSImage(const fs::path& filename, const Image& image);
+
+// Writes a PNG file a few rows at a time, top row first, so that images
+// which don't fit in memory can be saved as they are produced. The alpha
+// channel of RGBA rows is dropped.
+class PNGWriter
+{
+public:
+    PNGWriter();
+    ~PNGWriter();
+
+    PNGWriter(const PNGWriter&) = delete;
+    PNGWriter& operator=(const PNGWriter&) = delete;
+    PNGWriter(PNGWriter&&) = delete;
+    PNGWriter& operator=(PNGWriter&&) = delete;
+
+    bool open(const fs::path& filename, std::int32_t width, std::int32_t height, PixelFormat format);
+    bool writeRows(const std::uint8_t* pixels, std::int32_t rowStride, std::int32_t count);
+    // Returns false unless all the rows were written
+    bool close();
+
+private:
+    struct State;
+    std::unique_ptr<State> m_state;
+};
 
 } // namespace celestia::engine
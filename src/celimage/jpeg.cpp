@@ -8,9 +8,11 @@
 // as published by the Free Software Foundation; either version 2
 // of the License, or (at your option) any later version.
 
+#include <algorithm>
 #include <cstdio>  // fopen, fclose
 #include <cstring> // memcpy
 #include <memory>
+#include <optional>
 #include <setjmp.h>
 extern "C"
 {
@@ -18,6 +20,7 @@ extern "C"
 }
 #include <celutil/gettext.h>
 #include <celutil/logger.h>
+#include "downsample.h"
 #include "image.h"
 
 namespace celestia::engine
@@ -120,7 +123,7 @@ bool SaveJPEGImage(const fs::path& filename,
 
 } // anonymous namespace
 
-Image* LoadJPEGImage(const fs::path& filename)
+Image* LoadJPEGImage(const fs::path& filename, std::int32_t reduction)
 {
     Image* img = nullptr;
 
@@ -135,6 +138,8 @@ Image* LoadJPEGImage(const fs::path& filename)
     // More stuff
     JSAMPARRAY buffer; // Output row buffer
     int row_stride;    // physical row width in output buffer
+    // Declared before setjmp, so that the error handler can destroy it
+    std::optional<RowDownsampler> downsampler;
 
     // In this example we want to open the input file before doing anything else,
     // so that the setjmp() error recovery below can assume the file is open.
@@ -163,6 +168,7 @@ Image* LoadJPEGImage(const fs::path& filename)
         // We need to clean up the JPEG object, close the input file, and return.
         jpeg_destroy_decompress(&cinfo);
         fclose(in);
+        downsampler.reset();
         delete img;
 
         util::GetLogger()->error(_("Error reading JPEG image: {}\n"), filename);
@@ -193,8 +199,15 @@ Image* LoadJPEGImage(const fs::path& filename)
 
     // Step 4: set parameters for decompression
 
-    // In this example, we don't need to change any of the defaults set by
-    // jpeg_read_header(), so we do nothing here.
+    // libjpeg scales the image while decoding it by skipping DCT
+    // coefficients, up to 1/8; any further reduction is a box filter.
+    reduction = std::max(reduction, INT32_C(0));
+    std::int32_t scaledReduction = std::min(reduction, INT32_C(3));
+    if (scaledReduction > 0)
+    {
+        cinfo.scale_num = 1;
+        cinfo.scale_denom = 1U << scaledReduction;
+    }
 
     // Step 5: Start decompressor
 
@@ -223,7 +236,15 @@ Image* LoadJPEGImage(const fs::path& filename)
     if (cinfo.output_components == 1)
         format = PixelFormat::Luminance;
 
-    img = new Image(format, cinfo.image_width, cinfo.image_height);
+    auto outputWidth = static_cast<std::int32_t>(cinfo.output_width);
+    auto outputHeight = static_cast<std::int32_t>(cinfo.output_height);
+    std::int32_t remainingReduction = reduction - scaledReduction;
+    img = new Image(format,
+                    RowDownsampler::ReducedSize(outputWidth, remainingReduction),
+                    RowDownsampler::ReducedSize(outputHeight, remainingReduction));
+
+    if (remainingReduction > 0)
+        downsampler.emplace(outputWidth, outputHeight, remainingReduction, *img);
 
     // cont = cinfo.output_height - 1;
     int cont = 0;
@@ -236,7 +257,10 @@ Image* LoadJPEGImage(const fs::path& filename)
 
         // Assume put_scanline_someplace wants a pointer and sample count.
         // put_scanline_someplace(buffer[0], row_stride);
-        std::memcpy(img->getPixelRow(cont), buffer[0], row_stride);
+        if (downsampler.has_value())
+            downsampler->addRow(buffer[0]);
+        else
+            std::memcpy(img->getPixelRow(cont), buffer[0], row_stride);
         cont++;
     }
 
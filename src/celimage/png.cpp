@@ -12,6 +12,7 @@
 #include <cstdint>
 #include <cstdio>
 #include <cstddef>
+#include <memory>
 
 #include <png.h>
 #include <zlib.h>
@@ -19,7 +20,9 @@
 #include <celcompat/filesystem.h>
 #include <celutil/gettext.h>
 #include <celutil/logger.h>
+#include "downsample.h"
 #include "image.h"
+#include "imageformats.h"
 #include "pixelformat.h"
 
 namespace celestia::engine
@@ -97,7 +100,7 @@ GetPixelFormat(png_structp pngPtr, png_const_infop infoPtr, int bitDepth, int co
 }
 
 Image*
-LoadPNGImage(std::FILE* in, const fs::path& filename)
+LoadPNGImage(std::FILE* in, const fs::path& filename, std::int32_t reduction)
 {
     constexpr std::size_t headerSize = 8;
     png_byte header[headerSize]; //NOSONAR
@@ -111,6 +114,9 @@ LoadPNGImage(std::FILE* in, const fs::path& filename)
     int passes;
     std::int32_t pitch;
     Image* img = nullptr;
+    // Used to reduce non-interlaced images while they are read
+    Image* rowBuffer = nullptr;
+    RowDownsampler* downsampler = nullptr;
 
     if (std::fread(header, 1, headerSize, in) != headerSize ||
         png_sig_cmp(header, 0, headerSize) != 0)
@@ -139,6 +145,8 @@ LoadPNGImage(std::FILE* in, const fs::path& filename)
 
     if (setjmp(png_jmpbuf(pngPtr)))
     {
+        delete downsampler; //NOSONAR
+        delete rowBuffer; //NOSONAR
         delete img; //NOSONAR
         png_destroy_read_struct(&pngPtr, &infoPtr, nullptr);
         return nullptr;
@@ -157,10 +165,31 @@ LoadPNGImage(std::FILE* in, const fs::path& filename)
         png_error(pngPtr, _("Image height out of range"));
 
     format = GetPixelFormat(pngPtr, infoPtr, bitDepth, colorType);
+    passes = png_set_interlace_handling(pngPtr);
+
+    if (reduction > 0 && passes == 1)
+    {
+        auto w = static_cast<std::int32_t>(width);
+        auto h = static_cast<std::int32_t>(height);
+        img = new Image(format, RowDownsampler::ReducedSize(w, reduction), RowDownsampler::ReducedSize(h, reduction)); //NOSONAR
+        rowBuffer = new Image(format, w, 1); //NOSONAR
+        downsampler = new RowDownsampler(w, h, reduction, *img); //NOSONAR
+        for (png_uint_32 row = 0; row < height; ++row)
+        {
+            png_read_row(pngPtr, rowBuffer->getPixels(), nullptr);
+            downsampler->addRow(rowBuffer->getPixels());
+        }
+
+        delete downsampler; //NOSONAR
+        delete rowBuffer; //NOSONAR
+        png_read_end(pngPtr, nullptr);
+        png_destroy_read_struct(&pngPtr, &infoPtr, nullptr);
+        return img;
+    }
+
     img = new Image(format, static_cast<std::int32_t>(width), static_cast<std::int32_t>(height)); //NOSONAR
     pitch = img->getPitch();
 
-    passes = png_set_interlace_handling(pngPtr);
     for (int pass = 0; pass < passes; ++pass)
     {
         png_bytep rowPtr = img->getPixels();
@@ -173,49 +202,110 @@ LoadPNGImage(std::FILE* in, const fs::path& filename)
 
     png_read_end(pngPtr, nullptr);
     png_destroy_read_struct(&pngPtr, &infoPtr, nullptr);
+
+    // Interlaced images are only complete after the last pass, so they are
+    // reduced once they are read
+    if (reduction > 0)
+    {
+        std::unique_ptr<Image> full(img);
+        return full->downsample(reduction).release();
+    }
+
     return img;
 }
 
+} // end unnamed namespace
+
+Image* LoadPNGImage(const fs::path& filename, std::int32_t reduction)
+{
+#ifdef _WIN32
+    std::FILE* fp = _wfopen(filename.c_str(), L"rb");
+#else
+    std::FILE* fp = std::fopen(filename.c_str(), "rb");
+#endif
+    if (fp == nullptr)
+    {
+        util::GetLogger()->error(_("Error opening image file {}.\n"), filename);
+        return nullptr;
+    }
+
+    Image* img = LoadPNGImage(fp, filename, reduction);
+
+    std::fclose(fp);
+    return img;
+}
+
+struct PNGWriter::State
+{
+    fs::path filename;
+    std::FILE* out{ nullptr };
+    png_structp pngPtr{ nullptr };
+    png_infop infoPtr{ nullptr };
+    std::int32_t rowsLeft{ 0 };
+};
+
+PNGWriter::PNGWriter() = default;
+
+PNGWriter::~PNGWriter()
+{
+    if (m_state == nullptr)
+        return;
+
+    png_destroy_write_struct(&m_state->pngPtr, &m_state->infoPtr);
+    std::fclose(m_state->out);
+}
+
 bool
-SavePNGImage(std::FILE* out,
-             const fs::path& filename,
-             std::int32_t width,
-             std::int32_t height,
-             std::int32_t rowStride,
-             const std::uint8_t* pixels,
-             bool removeAlpha)
+PNGWriter::open(const fs::path& filename, std::int32_t width, std::int32_t height, PixelFormat format)
 {
-    png_structp pngPtr = nullptr;
-    png_infop infoPtr = nullptr;
+    if (format != PixelFormat::RGB && format != PixelFormat::RGBA)
+    {
+        util::GetLogger()->error(_("Can only save RGB or RGBA images\n"));
+        return false;
+    }
 
-    pngPtr = png_create_write_struct(PNG_LIBPNG_VER_STRING,
-                                     const_cast<fs::path*>(&filename), //NOSONAR
-                                     &PNGError,
-                                     &PNGWarn);
-    if (pngPtr == nullptr)
+    auto state = std::make_unique<State>();
+    state->filename = filename;
+    state->rowsLeft = height;
+
+#ifdef _WIN32
+    state->out = _wfopen(filename.c_str(), L"wb");
+#else
+    state->out = std::fopen(filename.c_str(), "wb");
+#endif
+    if (state->out == nullptr)
     {
-        util::GetLogger()->error(_("Error allocating PNG write struct.\n"));
+        util::GetLogger()->error(_("Can't open screen capture file '{}'\n"), filename);
         return false;
     }
 
-    infoPtr = png_create_info_struct(pngPtr);
-    if (infoPtr == nullptr)
+    // From here the destructor releases the file and the PNG structures
+    m_state = std::move(state);
+
+    m_state->pngPtr = png_create_write_struct(PNG_LIBPNG_VER_STRING,
+                                              &m_state->filename,
+                                              &PNGError,
+                                              &PNGWarn);
+    if (m_state->pngPtr == nullptr)
     {
-        util::GetLogger()->error(_("Error allocating PNG info struct.\n"));
-        png_destroy_write_struct(&pngPtr, nullptr);
+        util::GetLogger()->error(_("Error allocating PNG write struct.\n"));
         return false;
     }
 
-    if (setjmp(png_jmpbuf(pngPtr)))
+    m_state->infoPtr = png_create_info_struct(m_state->pngPtr);
+    if (m_state->infoPtr == nullptr)
     {
-        png_destroy_write_struct(&pngPtr, &infoPtr);
+        util::GetLogger()->error(_("Error allocating PNG info struct.\n"));
         return false;
     }
 
-    png_init_io(pngPtr, out);
+    if (setjmp(png_jmpbuf(m_state->pngPtr)))
+        return false;
+
+    png_init_io(m_state->pngPtr, m_state->out);
 
-    png_set_compression_level(pngPtr, Z_BEST_COMPRESSION);
-    png_set_IHDR(pngPtr, infoPtr,
+    png_set_compression_level(m_state->pngPtr, Z_BEST_COMPRESSION);
+    png_set_IHDR(m_state->pngPtr, m_state->infoPtr,
                  static_cast<png_uint_32>(width),
                  static_cast<png_uint_32>(height),
                  8,
@@ -224,74 +314,57 @@ SavePNGImage(std::FILE* out,
                  PNG_COMPRESSION_TYPE_DEFAULT,
                  PNG_FILTER_TYPE_DEFAULT);
 
-    png_write_info(pngPtr, infoPtr);
-
-    if (removeAlpha)
-        png_set_filler(pngPtr, 0, PNG_FILLER_AFTER);
-
-    // We do not use interlacing so we can just write the rows out in order
-    for (std::int32_t row = 0; row < height; ++row)
-    {
-        png_write_row(pngPtr, pixels);
-        pixels += rowStride;
-    }
+    png_write_info(m_state->pngPtr, m_state->infoPtr);
 
-    png_write_end(pngPtr, infoPtr);
+    if (format == PixelFormat::RGBA)
+        png_set_filler(m_state->pngPtr, 0, PNG_FILLER_AFTER);
 
-    png_destroy_write_struct(&pngPtr, &infoPtr);
     return true;
 }
 
-} // end unnamed namespace
-
-Image* LoadPNGImage(const fs::path& filename)
+bool
+PNGWriter::writeRows(const std::uint8_t* pixels, std::int32_t rowStride, std::int32_t count)
 {
-#ifdef _WIN32
-    std::FILE* fp = _wfopen(filename.c_str(), L"rb");
-#else
-    std::FILE* fp = std::fopen(filename.c_str(), "rb");
-#endif
-    if (fp == nullptr)
+    if (m_state == nullptr || m_state->infoPtr == nullptr || count > m_state->rowsLeft)
+        return false;
+
+    if (setjmp(png_jmpbuf(m_state->pngPtr)))
+        return false;
+
+    // We do not use interlacing so we can just write the rows out in order
+    for (std::int32_t row = 0; row < count; ++row)
     {
-        util::GetLogger()->error(_("Error opening image file {}.\n"), filename);
-        return nullptr;
+        png_write_row(m_state->pngPtr, pixels);
+        pixels += rowStride;
     }
 
-    Image* img = LoadPNGImage(fp, filename);
-
-    std::fclose(fp);
-    return img;
+    m_state->rowsLeft -= count;
+    return true;
 }
 
-bool SavePNGImage(const fs::path& filename, const Image& image)
+bool
+PNGWriter::close()
 {
-    if (auto format = image.getFormat();
-        format != PixelFormat::RGB && format != PixelFormat::RGBA)
-    {
-        util::GetLogger()->error(_("Can only save RGB or RGBA images\n"));
+    if (m_state == nullptr || m_state->infoPtr == nullptr || m_state->rowsLeft != 0)
         return false;
-    }
 
-#ifdef _WIN32
-    std::FILE* out = _wfopen(filename.c_str(), L"wb");
-#else
-    std::FILE* out = std::fopen(filename.c_str(), "wb");
-#endif
-    if (out == nullptr)
-    {
-        util::GetLogger()->error(_("Can't open screen capture file '{}'\n"), filename);
+    if (setjmp(png_jmpbuf(m_state->pngPtr)))
         return false;
-    }
 
-    auto result = SavePNGImage(out, filename,
-                               image.getWidth(),
-                               image.getHeight(),
-                               image.getPitch(),
-                               image.getPixels(),
-                               image.hasAlpha());
+    png_write_end(m_state->pngPtr, m_state->infoPtr);
 
-    std::fclose(out);
+    png_destroy_write_struct(&m_state->pngPtr, &m_state->infoPtr);
+    bool result = std::fclose(m_state->out) == 0;
+    m_state.reset();
     return result;
 }
 
+bool SavePNGImage(const fs::path& filename, const Image& image)
+{
+    PNGWriter writer;
+    return writer.open(filename, image.getWidth(), image.getHeight(), image.getFormat()) &&
+           writer.writeRows(image.getPixels(), image.getPitch(), image.getHeight()) &&
+           writer.close();
+}
+
 } // end namespace celestia::engine
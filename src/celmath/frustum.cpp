@@ -124,6 +124,53 @@ doTestSphere(util::array_view<Frustum::PlaneType> planes,
     return isIntersecting ? FrustumAspect::Intersect : FrustumAspect::Inside;
 }
 
+// Number of spheres tested together by testSpheres, which Eigen evaluates
+// with SIMD instructions where available
+constexpr std::size_t SphereBatchSize = 8;
+
+template<typename PREC>
+void
+doTestSpheres(util::array_view<Frustum::PlaneType> planes,
+              const SphereArrays<PREC>& spheres,
+              std::vector<std::uint32_t>& visible)
+{
+    using ArrayType = Eigen::Array<PREC, SphereBatchSize, 1>;
+    using MaskArrayType = Eigen::Array<bool, SphereBatchSize, 1>;
+
+    const std::size_t count = spheres.radius.size();
+    std::size_t first = 0;
+    for (; first + SphereBatchSize <= count; first += SphereBatchSize)
+    {
+        Eigen::Map<const ArrayType> x(spheres.centerX.data() + first);
+        Eigen::Map<const ArrayType> y(spheres.centerY.data() + first);
+        Eigen::Map<const ArrayType> z(spheres.centerZ.data() + first);
+        Eigen::Map<const ArrayType> radius(spheres.radius.data() + first);
+
+        MaskArrayType inside = MaskArrayType::Constant(true);
+        for (const auto& plane : planes)
+        {
+            // As in doTestSphere, the double precision test must not convert
+            // the centers to single precision
+            Eigen::Matrix<PREC, 3, 1> normal = plane.normal().template cast<PREC>();
+            auto offset = static_cast<PREC>(plane.offset());
+            inside = inside && (x * normal.x() + y * normal.y() + z * normal.z() + offset >= -radius);
+        }
+
+        for (std::size_t i = 0; i < SphereBatchSize; ++i)
+        {
+            if (inside[i])
+                visible.push_back(static_cast<std::uint32_t>(first + i));
+        }
+    }
+
+    for (; first < count; ++first)
+    {
+        Eigen::Matrix<PREC, 3, 1> center(spheres.centerX[first], spheres.centerY[first], spheres.centerZ[first]);
+        if (doTestSphere(planes, center, spheres.radius[first]) != FrustumAspect::Outside)
+            visible.push_back(static_cast<std::uint32_t>(first));
+    }
+}
+
 } // end unnamed namespace
 
 Frustum::Frustum(float fov, float aspectRatio, float n, float f)
@@ -170,6 +217,18 @@ Frustum::testSphere(const Eigen::Vector3d& center, double radius) const
     return doTestSphere(planes, center, radius);
 }
 
+void
+Frustum::testSpheres(const SphereArrays<float>& spheres, std::vector<std::uint32_t>& visible) const
+{
+    doTestSpheres(planes, spheres, visible);
+}
+
+void
+Frustum::testSpheres(const SphereArrays<double>& spheres, std::vector<std::uint32_t>& visible) const
+{
+    doTestSpheres(planes, spheres, visible);
+}
+
 InfiniteFrustum::InfiniteFrustum(float fov, float aspectRatio, float n)
 {
     init(planes.data(), fov, aspectRatio, n);
@@ -207,4 +266,16 @@ InfiniteFrustum::testSphere(const Eigen::Vector3d& center, double radius) const
     return doTestSphere(planes, center, radius);
 }
 
+void
+InfiniteFrustum::testSpheres(const SphereArrays<float>& spheres, std::vector<std::uint32_t>& visible) const
+{
+    doTestSpheres(planes, spheres, visible);
+}
+
+void
+InfiniteFrustum::testSpheres(const SphereArrays<double>& spheres, std::vector<std::uint32_t>& visible) const
+{
+    doTestSpheres(planes, spheres, visible);
+}
+
 }
@@ -11,10 +11,14 @@
 
 #include <array>
 #include <cstddef>
+#include <cstdint>
+#include <vector>
 
 #include <Eigen/Core>
 #include <Eigen/Geometry>
 
+#include <celutil/array_view.h>
+
 namespace celestia::math
 {
 
@@ -35,6 +39,17 @@ enum class FrustumAspect
     Intersect = 2,
 };
 
+// Spheres in structure of arrays layout, for testing many of them at once
+// against a frustum. All the arrays have the same size.
+template<typename PREC>
+struct SphereArrays
+{
+    util::array_view<PREC> centerX;
+    util::array_view<PREC> centerY;
+    util::array_view<PREC> centerZ;
+    util::array_view<PREC> radius;
+};
+
 class Frustum
 {
 public:
@@ -55,6 +70,11 @@ public:
     FrustumAspect testSphere(const Eigen::Vector3f& center, float radius) const;
     FrustumAspect testSphere(const Eigen::Vector3d& center, double radius) const;
 
+    // Append to visible the indices of the spheres which are not outside
+    // the frustum, testing them in batches
+    void testSpheres(const SphereArrays<float>& spheres, std::vector<std::uint32_t>& visible) const;
+    void testSpheres(const SphereArrays<double>& spheres, std::vector<std::uint32_t>& visible) const;
+
 private:
     static constexpr unsigned int nPlanes = 6;
     std::array<PlaneType, nPlanes> planes;
@@ -79,6 +99,11 @@ public:
     FrustumAspect testSphere(const Eigen::Vector3f& center, float radius) const;
     FrustumAspect testSphere(const Eigen::Vector3d& center, double radius) const;
 
+    // Append to visible the indices of the spheres which are not outside
+    // the frustum, testing them in batches
+    void testSpheres(const SphereArrays<float>& spheres, std::vector<std::uint32_t>& visible) const;
+    void testSpheres(const SphereArrays<double>& spheres, std::vector<std::uint32_t>& visible) const;
+
 private:
     static constexpr unsigned int nPlanes = 5;
     std::array<PlaneType, nPlanes> planes;
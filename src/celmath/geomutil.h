@@ -217,6 +217,33 @@ Perspective(T fovy, T aspect, T nearZ, T farZ)
     return m;
 }
 
+/*! Return a perspective projection matrix with the far plane at infinity,
+ *  which maps the near plane to a depth of 1 and infinity to 0. Meant for a
+ *  floating point depth buffer and a [0, 1] clip space depth range, where it
+ *  keeps the relative depth precision constant over any distance.
+ */
+template<class T> Eigen::Matrix<T, 4, 4>
+InfiniteReversePerspective(T fovy, T aspect, T nearZ)
+{
+    using std::cos, std::sin;
+
+    if (aspect == static_cast<T>(0))
+        return Eigen::Matrix<T, 4, 4>::Identity();
+
+    T angle = degToRad(fovy / static_cast<T>(2));
+    T sine = sin(angle);
+    if (sine == static_cast<T>(0))
+        return Eigen::Matrix<T, 4, 4>::Identity();
+    T ctg = cos(angle) / sine;
+
+    Eigen::Matrix<T, 4, 4> m = Eigen::Matrix<T, 4, 4>::Zero();
+    m(0, 0) = ctg / aspect;
+    m(1, 1) = ctg;
+    m(2, 3) = nearZ;
+    m(3, 2) = static_cast<T>(-1);
+    return m;
+}
+
 /*! Return an orthographic projection matrix
  */
 template<class T> Eigen::Matrix<T, 4, 4>
@@ -21,6 +21,35 @@ std::mt19937 createRNG()
     return std::mt19937{ rngSeed };
 }
 
+constexpr std::uint64_t splitMix64(std::uint64_t& state)
+{
+    state += UINT64_C(0x9e3779b97f4a7c15);
+    std::uint64_t z = state;
+    z = (z ^ (z >> 30)) * UINT64_C(0xbf58476d1ce4e5b9);
+    z = (z ^ (z >> 27)) * UINT64_C(0x94d049bb133111eb);
+    return z ^ (z >> 31);
+}
+
+// Expand a (seed, stream) pair into a xoshiro128 state, which must not be
+// all zeros
+std::array<std::uint32_t, 4> seedXoshiro128(std::uint64_t seed, std::uint64_t stream)
+{
+    std::uint64_t state = seed ^ splitMix64(stream);
+    std::uint64_t a = splitMix64(state);
+    std::uint64_t b = splitMix64(state);
+    if (a == 0 && b == 0)
+        a = 1;
+
+    return { static_cast<std::uint32_t>(a), static_cast<std::uint32_t>(a >> 32),
+             static_cast<std::uint32_t>(b), static_cast<std::uint32_t>(b >> 32) };
+}
+
+// Map the high 24 bits to [0, 1)
+inline float toUnitFloat(std::uint32_t x)
+{
+    return static_cast<float>(x >> 8) * 0x1.0p-24f;
+}
+
 // utility functions for Perlin noise
 struct PerlinData
 {
@@ -224,4 +253,83 @@ std::mt19937& getRNG()
     static std::mt19937 rng = createRNG();
     return rng;
 }
+
+Xoshiro128::Xoshiro128(std::uint64_t seed, std::uint64_t stream) noexcept :
+    m_state(seedXoshiro128(seed, stream))
+{
+}
+
+RandomLanes::RandomLanes(std::uint64_t seed, std::uint64_t firstStream) noexcept
+{
+    for (std::size_t i = 0; i < LaneCount; ++i)
+    {
+        auto state = seedXoshiro128(seed, firstStream + i);
+        m_s0[i] = state[0];
+        m_s1[i] = state[1];
+        m_s2[i] = state[2];
+        m_s3[i] = state[3];
+    }
+}
+
+void
+fillUniform(RandomLanes& lanes, float* out, std::size_t count, float low, float high)
+{
+    const float scale = high - low;
+    RandomLanes::Block bits;
+    for (std::size_t start = 0; start < count; start += RandomLanes::LaneCount)
+    {
+        lanes.next(bits);
+        std::size_t n = std::min(RandomLanes::LaneCount, count - start);
+        for (std::size_t i = 0; i < n; ++i)
+            out[start + i] = low + scale * toUnitFloat(bits[i]);
+    }
+}
+
+void
+fillNormal(RandomLanes& lanes, float* out, std::size_t count, float mean, float stddev)
+{
+    // Box-Muller transform, each pair of blocks gives two blocks of samples
+    constexpr std::size_t blockSize = RandomLanes::LaneCount;
+    RandomLanes::Block bits0;
+    RandomLanes::Block bits1;
+    std::array<float, blockSize * 2> samples;
+    for (std::size_t start = 0; start < count; start += blockSize * 2)
+    {
+        lanes.next(bits0);
+        lanes.next(bits1);
+        for (std::size_t i = 0; i < blockSize; ++i)
+        {
+            // 1 - u is in (0, 1], keeping the logarithm finite
+            float r = stddev * std::sqrt(-2.0f * std::log(1.0f - toUnitFloat(bits0[i])));
+            float phi = 2.0f * celestia::numbers::pi_v<float> * toUnitFloat(bits1[i]);
+            samples[i] = mean + r * std::cos(phi);
+            samples[i + blockSize] = mean + r * std::sin(phi);
+        }
+
+        std::size_t n = std::min(samples.size(), count - start);
+        std::copy_n(samples.begin(), n, out + start);
+    }
+}
+
+void
+fillOnSphere(RandomLanes& lanes, Eigen::Vector3f* out, std::size_t count)
+{
+    RandomLanes::Block bits0;
+    RandomLanes::Block bits1;
+    for (std::size_t start = 0; start < count; start += RandomLanes::LaneCount)
+    {
+        lanes.next(bits0);
+        lanes.next(bits1);
+        std::size_t n = std::min(RandomLanes::LaneCount, count - start);
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            float cosTheta = 2.0f * toUnitFloat(bits0[i]) - 1.0f;
+            float phi = celestia::numbers::pi_v<float> * (2.0f * toUnitFloat(bits1[i]) - 1.0f);
+            float xyScale = std::sqrt(std::max(0.0f, 1.0f - square(cosTheta)));
+            out[start + i] = Eigen::Vector3f(xyScale * std::cos(phi),
+                                             xyScale * std::sin(phi),
+                                             cosTheta);
+        }
+    }
+}
 } // end namespace celestia::math
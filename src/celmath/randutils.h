@@ -1,6 +1,9 @@
 #pragma once
 
+#include <array>
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
 #include <random>
 
 #include <Eigen/Core>
@@ -60,4 +63,98 @@ Eigen::Matrix<T, 3, 1> randomOnSphere(RNG&& rng)
 }
 
 std::mt19937& getRNG();
+
+// xoshiro128** generator. The state is only 16 bytes and a step is a few
+// integer operations, so it is cheap to keep one per thread or per work
+// item. Generators with the same seed and different streams produce
+// independent sequences: parallel jobs should use a stream per work item,
+// not per thread, so that the results don't depend on the scheduling.
+class Xoshiro128
+{
+public:
+    using result_type = std::uint32_t;
+
+    explicit Xoshiro128(std::uint64_t seed = 0, std::uint64_t stream = 0) noexcept;
+
+    static constexpr result_type min() noexcept { return 0; }
+    static constexpr result_type max() noexcept { return UINT32_C(0xffffffff); }
+
+    result_type operator()() noexcept
+    {
+        result_type result = rotl(m_state[1] * 5, 7) * 9;
+        result_type t = m_state[1] << 9;
+        m_state[2] ^= m_state[0];
+        m_state[3] ^= m_state[1];
+        m_state[1] ^= m_state[2];
+        m_state[0] ^= m_state[3];
+        m_state[2] ^= t;
+        m_state[3] = rotl(m_state[3], 11);
+        return result;
+    }
+
+    void discard(unsigned long long n) noexcept
+    {
+        for (; n > 0; --n)
+            (*this)();
+    }
+
+private:
+    static constexpr result_type rotl(result_type x, int k) noexcept
+    {
+        return (x << k) | (x >> (32 - k));
+    }
+
+    std::array<std::uint32_t, 4> m_state;
+};
+
+// A group of Xoshiro128 generators stepped together. The state is stored by
+// component so that the update compiles to vector instructions. Lane i
+// produces the same sequence as Xoshiro128(seed, firstStream + i).
+class RandomLanes
+{
+public:
+    static constexpr std::size_t LaneCount = 8;
+    using Block = std::array<std::uint32_t, LaneCount>;
+
+    explicit RandomLanes(std::uint64_t seed = 0, std::uint64_t firstStream = 0) noexcept;
+
+    void next(Block& out) noexcept
+    {
+        for (std::size_t i = 0; i < LaneCount; ++i)
+        {
+            out[i] = rotl(m_s1[i] * 5, 7) * 9;
+            std::uint32_t t = m_s1[i] << 9;
+            m_s2[i] ^= m_s0[i];
+            m_s3[i] ^= m_s1[i];
+            m_s1[i] ^= m_s2[i];
+            m_s0[i] ^= m_s3[i];
+            m_s2[i] ^= t;
+            m_s3[i] = rotl(m_s3[i], 11);
+        }
+    }
+
+private:
+    static constexpr std::uint32_t rotl(std::uint32_t x, int k) noexcept
+    {
+        return (x << k) | (x >> (32 - k));
+    }
+
+    Block m_s0;
+    Block m_s1;
+    Block m_s2;
+    Block m_s3;
+};
+
+// Fill arrays with random samples from the lanes. Each call draws whole
+// blocks, so the output depends only on the seed and on the sequence of
+// calls and counts.
+
+// Uniform in [low, high)
+void fillUniform(RandomLanes& lanes, float* out, std::size_t count,
+                 float low = 0.0f, float high = 1.0f);
+// Normal distribution with the given mean and standard deviation
+void fillNormal(RandomLanes& lanes, float* out, std::size_t count,
+                float mean = 0.0f, float stddev = 1.0f);
+// Uniform on the unit sphere
+void fillOnSphere(RandomLanes& lanes, Eigen::Vector3f* out, std::size_t count);
 }
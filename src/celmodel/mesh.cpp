@@ -12,7 +12,9 @@
 #include <array>
 #include <cstring>
 #include <iterator>
+#include <limits>
 #include <tuple>
+#include <unordered_map>
 #include <utility>
 #include <celutil/logger.h>
 
@@ -29,6 +31,14 @@ namespace cmod
 namespace
 {
 
+// Meshes with fewer triangles aren't simplified
+constexpr unsigned int MinLODTriangles = 4096;
+
+// Grid resolutions of the vertex clustering, in cells along the longest
+// side of the bounding box
+constexpr int MaxLODResolution = 256;
+constexpr int MinLODResolution = 8;
+
 bool
 isOpaqueMaterial(const Material &material)
 {
@@ -36,6 +46,94 @@ isOpaqueMaterial(const Material &material)
              material.blend != BlendMode::AdditiveBlend;
 }
 
+struct VertexCluster
+{
+    Eigen::Vector3f sum{ Eigen::Vector3f::Zero() };
+    unsigned int count{ 0 };
+    Index32 representative{ 0 };
+    float distance{ std::numeric_limits<float>::max() };
+};
+
+// Maps each vertex to the vertex nearest to the mean of the vertices in the
+// same cell of the grid, and returns the largest distance a vertex is moved
+float
+clusterVertices(const std::vector<Eigen::Vector3f>& positions,
+                const Eigen::AlignedBox<float, 3>& bbox,
+                int resolution,
+                std::vector<Index32>& vertexMap)
+{
+    float cellSize = bbox.sizes().maxCoeff() / static_cast<float>(resolution);
+
+    std::unordered_map<std::uint32_t, std::uint32_t> clusterIndices;
+    std::vector<VertexCluster> clusters;
+    std::vector<std::uint32_t> vertexClusters;
+    vertexClusters.reserve(positions.size());
+    for (const Eigen::Vector3f& position : positions)
+    {
+        Eigen::Vector3i cell = ((position - bbox.min()) / cellSize).cast<int>()
+                                                                   .cwiseMax(0)
+                                                                   .cwiseMin(resolution - 1);
+        auto key = static_cast<std::uint32_t>(cell.x() | (cell.y() << 10) | (cell.z() << 20));
+        auto [it, inserted] = clusterIndices.try_emplace(key, static_cast<std::uint32_t>(clusters.size()));
+        if (inserted)
+            clusters.emplace_back();
+
+        clusters[it->second].sum += position;
+        ++clusters[it->second].count;
+        vertexClusters.push_back(it->second);
+    }
+
+    for (std::size_t i = 0; i < positions.size(); ++i)
+    {
+        VertexCluster& cluster = clusters[vertexClusters[i]];
+        float distance = (positions[i] - cluster.sum / static_cast<float>(cluster.count)).squaredNorm();
+        if (distance < cluster.distance)
+        {
+            cluster.distance = distance;
+            cluster.representative = static_cast<Index32>(i);
+        }
+    }
+
+    float error = 0.0f;
+    vertexMap.resize(positions.size());
+    for (std::size_t i = 0; i < positions.size(); ++i)
+    {
+        Index32 representative = clusters[vertexClusters[i]].representative;
+        vertexMap[i] = representative;
+        error = std::max(error, (positions[i] - positions[representative]).norm());
+    }
+
+    return error;
+}
+
+// Replaces the vertices of the triangles by their clusters and drops the
+// triangles which become degenerate or duplicated
+std::vector<Index32>
+collapseTriangles(const std::vector<Index32>& indices, const std::vector<Index32>& vertexMap)
+{
+    std::vector<std::array<Index32, 3>> triangles;
+    for (std::size_t i = 0; i + 2 < indices.size(); i += 3)
+    {
+        std::array<Index32, 3> triangle{ vertexMap[indices[i]], vertexMap[indices[i + 1]], vertexMap[indices[i + 2]] };
+        if (triangle[0] == triangle[1] || triangle[1] == triangle[2] || triangle[2] == triangle[0])
+            continue;
+
+        // Start with the smallest index, keeping the winding, so that
+        // duplicates compare equal
+        std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+        triangles.push_back(triangle);
+    }
+
+    std::sort(triangles.begin(), triangles.end());
+    triangles.erase(std::unique(triangles.begin(), triangles.end()), triangles.end());
+
+    std::vector<Index32> newIndices;
+    newIndices.reserve(triangles.size() * 3);
+    for (const auto& triangle : triangles)
+        newIndices.insert(newIndices.end(), triangle.begin(), triangle.end());
+    return newIndices;
+}
+
 } // end unnamed namespace
 
 
@@ -126,6 +224,7 @@ PrimitiveGroup::clone() const
     newGroup.indices = indices;
     newGroup.indicesCount = indicesCount;
     newGroup.indicesOffset = indicesOffset;
+    newGroup.lodIndices = lodIndices;
     return newGroup;
 }
 
@@ -164,6 +263,7 @@ Mesh::clone() const
     newMesh.groups.reserve(groups.size());
     std::transform(groups.cbegin(), groups.cend(), std::back_inserter(newMesh.groups),
                    [](const PrimitiveGroup& group) { return group.clone(); });
+    newMesh.lodErrors = lodErrors;
     newMesh.name = name;
     return newMesh;
 }
@@ -172,6 +272,7 @@ Mesh::clone() const
 void
 Mesh::setVertices(unsigned int _nVertices, std::vector<VWord>&& vertexData)
 {
+    bvh.reset();
     nVertices = _nVertices;
     vertices = std::move(vertexData);
 }
@@ -184,6 +285,7 @@ Mesh::setVertexDescription(VertexDescription&& desc)
         return false;
 
     vertexDesc = std::move(desc);
+    bvh.reset();
     return true;
 }
 
@@ -217,6 +319,7 @@ Mesh::getGroup(unsigned int index)
 unsigned int
 Mesh::addGroup(PrimitiveGroup&& group)
 {
+    bvh.reset();
     groups.push_back(std::move(group));
     return groups.size();
 }
@@ -246,7 +349,9 @@ Mesh::getGroupCount() const
 void
 Mesh::clearGroups()
 {
+    bvh.reset();
     groups.clear();
+    lodErrors.clear();
 }
 
 
@@ -267,12 +372,19 @@ Mesh::setName(std::string&& _name)
 void
 Mesh::remapIndices(const std::vector<Index32>& indexMap)
 {
+    bvh.reset();
     for (auto& group : groups)
     {
         for (auto& index : group.indices)
         {
             index = indexMap[index];
         }
+
+        for (auto& lod : group.lodIndices)
+        {
+            for (auto& index : lod)
+                index = indexMap[index];
+        }
     }
 }
 
@@ -288,6 +400,7 @@ Mesh::remapMaterials(const std::vector<unsigned int>& materialMap)
 void
 Mesh::aggregateByMaterial()
 {
+    bvh.reset();
     std::sort(groups.begin(), groups.end(),
               [](const PrimitiveGroup& g0, const PrimitiveGroup& g1)
               {
@@ -303,6 +416,8 @@ Mesh::mergePrimitiveGroups()
     if (groups.size() < 2)
         return;
 
+    clearLODs();
+
     std::vector<PrimitiveGroup> newGroups;
     for (size_t i = 0; i < groups.size(); i++)
     {
@@ -355,6 +470,7 @@ Mesh::mergePrimitiveGroups()
 void
 Mesh::optimize()
 {
+    bvh.reset();
 #ifdef HAVE_MESHOPTIMIZER
     if (groups.size() != 1)
         return;
@@ -370,6 +486,106 @@ Mesh::optimize()
 #endif
 }
 
+void
+Mesh::generateLODs()
+{
+    clearLODs();
+
+    const VertexAttribute& position = vertexDesc.getAttribute(VertexAttributeSemantic::Position);
+    if (position.format != VertexAttributeFormat::Float3)
+        return;
+
+    unsigned int triangleCount = 0;
+    for (const auto& group : groups)
+    {
+        if (group.prim == PrimitiveGroupType::TriList)
+            triangleCount += group.getPrimitiveCount();
+    }
+
+    if (triangleCount < MinLODTriangles)
+        return;
+
+    unsigned int stride = vertexDesc.strideBytes / sizeof(VWord);
+    std::vector<Eigen::Vector3f> positions;
+    positions.reserve(nVertices);
+    Eigen::AlignedBox<float, 3> bbox;
+    const VWord* vdata = vertices.data() + position.offsetWords;
+    for (unsigned int i = 0; i < nVertices; i++, vdata += stride)
+    {
+        float fv[3];
+        std::memcpy(fv, vdata, sizeof(float) * 3);
+        positions.emplace_back(fv[0], fv[1], fv[2]);
+        bbox.extend(positions.back());
+    }
+
+    if (!(bbox.sizes().maxCoeff() > 0.0f))
+        return;
+
+    std::vector<Index32> vertexMap;
+    std::vector<std::vector<Index32>> levelIndices(groups.size());
+    for (int resolution = MaxLODResolution; resolution >= MinLODResolution; resolution /= 2)
+    {
+        float error = clusterVertices(positions, bbox, resolution, vertexMap);
+
+        unsigned int levelTriangleCount = 0;
+        for (std::size_t i = 0; i < groups.size(); ++i)
+        {
+            if (groups[i].prim != PrimitiveGroupType::TriList)
+                continue;
+
+            levelIndices[i] = collapseTriangles(groups[i].indices, vertexMap);
+            levelTriangleCount += static_cast<unsigned int>(levelIndices[i].size() / 3);
+        }
+
+        // Levels which save little aren't worth their index buffers
+        if (levelTriangleCount * 2 > triangleCount)
+            continue;
+
+        for (std::size_t i = 0; i < groups.size(); ++i)
+        {
+            if (groups[i].prim == PrimitiveGroupType::TriList)
+                groups[i].lodIndices.push_back(std::move(levelIndices[i]));
+        }
+
+        // Keep the errors ordered for selectLOD()
+        lodErrors.push_back(lodErrors.empty() ? error : std::max(error, lodErrors.back()));
+        triangleCount = levelTriangleCount;
+        if (triangleCount < MinLODTriangles / 4)
+            break;
+    }
+
+    if (!lodErrors.empty())
+    {
+        GetLogger()->verbose("Generated {} levels of detail down to {} triangles.\n",
+                             lodErrors.size(), triangleCount);
+    }
+}
+
+float
+Mesh::getLODError(unsigned int level) const
+{
+    if (level == 0 || level > lodErrors.size())
+        return 0.0f;
+
+    return lodErrors[level - 1];
+}
+
+unsigned int
+Mesh::selectLOD(float maxError) const
+{
+    // Errors grow with the level
+    auto it = std::upper_bound(lodErrors.cbegin(), lodErrors.cend(), maxError);
+    return static_cast<unsigned int>(it - lodErrors.cbegin());
+}
+
+void
+Mesh::clearLODs()
+{
+    lodErrors.clear();
+    for (auto& group : groups)
+        group.lodIndices.clear();
+}
+
 void
 Mesh::rebuildIndexMetadata()
 {
@@ -383,6 +599,66 @@ Mesh::rebuildIndexMetadata()
     nTotalIndices = offset;
 }
 
+void
+Mesh::buildBVH() const
+{
+    unsigned int stride = vertexDesc.strideBytes / sizeof(VWord);
+    unsigned int posOffset = vertexDesc.getAttribute(VertexAttributeSemantic::Position).offsetWords;
+    const VWord* vdata = vertices.data();
+
+    std::vector<Eigen::Vector3f> positions;
+    positions.reserve(nVertices);
+    for (unsigned int i = 0; i < nVertices; i++)
+    {
+        float fv[3];
+        std::memcpy(fv, vdata + i * stride + posOffset, sizeof(float) * 3);
+        positions.emplace_back(fv[0], fv[1], fv[2]);
+    }
+
+    std::vector<MeshBVH::Triangle> triangles;
+    for (std::size_t groupIndex = 0; groupIndex < groups.size(); ++groupIndex)
+    {
+        const auto& group = groups[groupIndex];
+        PrimitiveGroupType primType = group.prim;
+        auto nIndices = static_cast<Index32>(group.indices.size());
+
+        // Only triangle groups can be picked
+        if ((primType != PrimitiveGroupType::TriList &&
+             primType != PrimitiveGroupType::TriStrip &&
+             primType != PrimitiveGroupType::TriFan) ||
+            nIndices < 3 ||
+            (primType == PrimitiveGroupType::TriList && nIndices % 3 != 0))
+        {
+            continue;
+        }
+
+        // Triangles of strips are numbered [0,1,2], [1,2,3], ... and those
+        // of fans [0,1,2], [0,2,3], ...
+        const auto& indices = group.indices;
+        std::uint32_t primitiveIndex = 0;
+        if (primType == PrimitiveGroupType::TriList)
+        {
+            for (Index32 index = 0; index < nIndices; index += 3)
+            {
+                triangles.push_back({ { indices[index], indices[index + 1], indices[index + 2] },
+                                      static_cast<std::uint32_t>(groupIndex), primitiveIndex++ });
+            }
+        }
+        else
+        {
+            for (Index32 index = 2; index < nIndices; ++index)
+            {
+                Index32 i0 = primType == PrimitiveGroupType::TriStrip ? indices[index - 2] : indices[0];
+                triangles.push_back({ { i0, indices[index - 1], indices[index] },
+                                      static_cast<std::uint32_t>(groupIndex), primitiveIndex++ });
+            }
+        }
+    }
+
+    bvh = std::make_unique<MeshBVH>(std::move(positions), std::move(triangles));
+}
+
+
 bool
 Mesh::pick(const Eigen::Vector3d& rayOrigin, const Eigen::Vector3d& rayDirection, PickResult* result) const
 {
@@ -397,130 +673,21 @@ Mesh::pick(const Eigen::Vector3d& rayOrigin, const Eigen::Vector3d& rayDirection
         return false;
     }
 
-    unsigned int stride = vertexDesc.strideBytes / sizeof(VWord);
-    unsigned int posOffset = vertexDesc.getAttribute(VertexAttributeSemantic::Position).offsetWords;
-    const VWord* vdata = vertices.data();
+    if (bvh == nullptr)
+        buildBVH();
 
-    // Iterate over all primitive groups in the mesh
-    for (const auto& group : groups)
+    const MeshBVH::Triangle* triangle = bvh->pick(rayOrigin, rayDirection, closest);
+    if (triangle == nullptr)
+        return false;
+
+    if (result)
     {
-        PrimitiveGroupType primType = group.prim;
-        Index32 nIndices = group.indices.size();
-
-        // Only attempt to compute the intersection of the ray with triangle
-        // groups.
-        if ((primType == PrimitiveGroupType::TriList
-             || primType == PrimitiveGroupType::TriStrip
-             || primType == PrimitiveGroupType::TriFan) &&
-            (nIndices >= 3) &&
-            !(primType == PrimitiveGroupType::TriList && nIndices % 3 != 0))
-        {
-            unsigned int primitiveIndex = 0;
-            Index32 index = 0;
-            Index32 i0 = group.indices[0];
-            Index32 i1 = group.indices[1];
-            Index32 i2 = group.indices[2];
-
-            // 2nd triangle has indices [0,2,3], then [0,3,4], [0,4,5], so for 2nd we
-            // should update index by 3 (+2 here and +1 inside the loop) but for others by 1
-            if (primType == PrimitiveGroupType::TriFan)
-                index = 2;
-
-            // Iterate over the triangles in the primitive group
-            do
-            {
-                // Get the triangle vertices v0, v1, and v2
-                float fv[3];
-                std::memcpy(fv, vdata + i0 * stride + posOffset, sizeof(float) * 3);
-                Eigen::Vector3d v0 = Eigen::Map<Eigen::Vector3f>(fv).cast<double>();
-                std::memcpy(fv, vdata + i1 * stride + posOffset, sizeof(float) * 3);
-                Eigen::Vector3d v1 = Eigen::Map<Eigen::Vector3f>(fv).cast<double>();
-                std::memcpy(fv, vdata + i2 * stride + posOffset, sizeof(float) * 3);
-                Eigen::Vector3d v2 = Eigen::Map<Eigen::Vector3f>(fv).cast<double>();
-
-                // Compute the edge vectors e0 and e1, and the normal n
-                Eigen::Vector3d e0 = v1 - v0;
-                Eigen::Vector3d e1 = v2 - v0;
-                Eigen::Vector3d n = e0.cross(e1);
-
-                // c is the cosine of the angle between the ray and triangle normal
-                double c = n.dot(rayDirection);
-
-                // If the ray is parallel to the triangle, it either misses the
-                // triangle completely, or is contained in the triangle's plane.
-                // If it's contained in the plane, we'll still call it a miss.
-                if (c != 0.0)
-                {
-                    double t = (n.dot(v0 - rayOrigin)) / c;
-                    if (t < closest && t > 0.0)
-                    {
-                        double m00 = e0.dot(e0);
-                        double m01 = e0.dot(e1);
-                        double m10 = e1.dot(e0);
-                        double m11 = e1.dot(e1);
-                        double det = m00 * m11 - m01 * m10;
-                        if (det != 0.0)
-                        {
-                            Eigen::Vector3d p = rayOrigin + rayDirection * t;
-                            Eigen::Vector3d q = p - v0;
-                            double q0 = e0.dot(q);
-                            double q1 = e1.dot(q);
-                            double d = 1.0 / det;
-                            double s0 = (m11 * q0 - m01 * q1) * d;
-                            double s1 = (m00 * q1 - m10 * q0) * d;
-                            if (s0 >= 0.0 && s1 >= 0.0 && s0 + s1 <= 1.0)
-                            {
-                                closest = t;
-                                if (result)
-                                {
-                                    result->group = &group;
-                                    result->primitiveIndex = primitiveIndex;
-                                    result->distance = closest;
-                                }
-                            }
-                        }
-                    }
-                }
-
-                // Get the indices for the next triangle
-                if (primType == PrimitiveGroupType::TriList)
-                {
-                    index += 3;
-                    if (index < nIndices)
-                    {
-                        i0 = group.indices[index + 0];
-                        i1 = group.indices[index + 1];
-                        i2 = group.indices[index + 2];
-                    }
-                }
-                else if (primType == PrimitiveGroupType::TriStrip)
-                {
-                    index += 1;
-                    if (index < nIndices)
-                    {
-                        i0 = i1;
-                        i1 = i2;
-                        i2 = group.indices[index];
-                        // TODO: alternate orientation of triangles in a strip
-                    }
-                }
-                else // primType == TriFan
-                {
-                    index += 1;
-                    if (index < nIndices)
-                    {
-                        i1 = i2;
-                        i2 = group.indices[index];
-                    }
-                }
-
-                primitiveIndex++;
-
-            } while (index < nIndices);
-        }
+        result->group = &groups[triangle->group];
+        result->primitiveIndex = triangle->primitive;
+        result->distance = closest;
     }
 
-    return closest != maxDistance;
+    return true;
 }
 
 
@@ -587,6 +754,7 @@ Mesh::getBoundingBox() const
 void
 Mesh::transform(const Eigen::Vector3f& translation, float scale)
 {
+    bvh.reset();
     if (vertexDesc.getAttribute(VertexAttributeSemantic::Position).format != VertexAttributeFormat::Float3)
         return;
 
@@ -616,6 +784,9 @@ Mesh::transform(const Eigen::Vector3f& translation, float scale)
             std::memcpy(vdata, &f, sizeof(float));
         }
     }
+
+    for (float& error : lodErrors)
+        error *= scale;
 }
 
 
@@ -633,6 +804,7 @@ Mesh::getPrimitiveCount() const
 void
 Mesh::merge(const Mesh &other)
 {
+    bvh.reset();
     auto &ti = groups.front().indices;
     const auto &oi = other.groups.front().indices;
 
@@ -644,6 +816,7 @@ Mesh::merge(const Mesh &other)
     vertices.insert(vertices.end(), other.vertices.begin(), other.vertices.end());
 
     nVertices += other.nVertices;
+    clearLODs();
 }
 
 bool
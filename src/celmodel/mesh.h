@@ -13,6 +13,7 @@
 #include <array>
 #include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -20,6 +21,7 @@
 #include <Eigen/Geometry>
 
 #include "material.h"
+#include "meshbvh.h"
 
 
 namespace cmod
@@ -170,6 +172,9 @@ struct PrimitiveGroup
     int indicesCount{ 0 };
     int indicesOffset{ 0 };
     std::vector<Index32> indices{ };
+    // Simplified triangle lists from the finest to the coarsest level of
+    // detail, empty for groups which aren't simplified
+    std::vector<std::vector<Index32>> lodIndices{ };
 };
 
 
@@ -221,6 +226,9 @@ class Mesh
     const std::string& getName() const;
     void setName(std::string&&);
 
+    // The first pick builds a bounding volume hierarchy over the triangles,
+    // which is dropped when the vertices or groups are changed through the
+    // methods of the mesh
     bool pick(const Eigen::Vector3d& origin, const Eigen::Vector3d& direction, PickResult* result) const;
     bool pick(const Eigen::Vector3d& origin, const Eigen::Vector3d& direction, double& distance) const;
 
@@ -238,10 +246,25 @@ class Mesh
     bool canMerge(const Mesh&, const std::vector<Material> &materials) const;
     void optimize();
 
+    /*! Generate levels of detail of the triangle lists which share the
+     *  vertices of the mesh, each with at most half the triangles of the
+     *  previous one. Meshes with few triangles get none. Merging meshes or
+     *  primitive groups drops the levels, so this should be done last.
+     */
+    void generateLODs();
+    //! Number of levels of detail, including the full one
+    unsigned int getLODCount() const { return static_cast<unsigned int>(lodErrors.size()) + 1; }
+    //! The largest distance a vertex is moved by at the level, in model units
+    float getLODError(unsigned int level) const;
+    //! The coarsest level of detail whose error is at most maxError
+    unsigned int selectLOD(float maxError) const;
+
     void rebuildIndexMetadata();
 
  private:
     void mergePrimitiveGroups();
+    void clearLODs();
+    void buildBVH() const;
 
     VertexDescription vertexDesc{ };
 
@@ -251,8 +274,11 @@ class Mesh
     unsigned int nTotalIndices{ 0 };
 
     std::vector<PrimitiveGroup> groups;
+    std::vector<float> lodErrors;
 
     std::string name;
+
+    mutable std::unique_ptr<MeshBVH> bvh;
 };
 
 Mesh GenerateTangents(const Mesh& mesh);
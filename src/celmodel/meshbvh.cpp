@@ -0,0 +1,342 @@
+// meshbvh.cpp
+//
+// Copyright (C) 2024, Celestia Development Team
+//
+// Bounding volume hierarchy over the triangles of a mesh, for picking.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include "meshbvh.h"
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+#include <Eigen/Geometry>
+
+namespace cmod
+{
+
+namespace
+{
+
+constexpr int BinCount = 16;
+constexpr std::uint32_t MaxLeafSize = 4;
+
+using Box = Eigen::AlignedBox<float, 3>;
+
+float
+surfaceArea(const Box& box)
+{
+    if (box.isEmpty())
+        return 0.0f;
+
+    Eigen::Vector3f sizes = box.sizes();
+    return 2.0f * (sizes.x() * sizes.y() + sizes.y() * sizes.z() + sizes.z() * sizes.x());
+}
+
+Box
+triangleBounds(const std::vector<Eigen::Vector3f>& positions, const MeshBVH::Triangle& triangle)
+{
+    Box box(positions[triangle.vertices[0]]);
+    box.extend(positions[triangle.vertices[1]]);
+    box.extend(positions[triangle.vertices[2]]);
+    return box;
+}
+
+// Distance along the ray to the box if it's hit nearer than maxDistance
+bool
+intersectBox(const Eigen::Vector3f& boxMin,
+             const Eigen::Vector3f& boxMax,
+             const Eigen::Vector3d& origin,
+             const Eigen::Vector3d& invDirection,
+             double maxDistance,
+             double& distance)
+{
+    Eigen::Vector3d t0 = (boxMin.cast<double>() - origin).cwiseProduct(invDirection);
+    Eigen::Vector3d t1 = (boxMax.cast<double>() - origin).cwiseProduct(invDirection);
+    double tmin = std::max(t0.cwiseMin(t1).maxCoeff(), 0.0);
+    double tmax = t0.cwiseMax(t1).minCoeff();
+    if (tmax < tmin || tmin >= maxDistance)
+        return false;
+
+    distance = tmin;
+    return true;
+}
+
+// Same test as the former brute force picking, so that the results don't
+// change: triangles in the plane of the ray are missed
+bool
+intersectTriangle(const Eigen::Vector3d& v0,
+                  const Eigen::Vector3d& v1,
+                  const Eigen::Vector3d& v2,
+                  const Eigen::Vector3d& origin,
+                  const Eigen::Vector3d& direction,
+                  double& closest)
+{
+    // Compute the edge vectors e0 and e1, and the normal n
+    Eigen::Vector3d e0 = v1 - v0;
+    Eigen::Vector3d e1 = v2 - v0;
+    Eigen::Vector3d n = e0.cross(e1);
+
+    // c is the cosine of the angle between the ray and triangle normal
+    double c = n.dot(direction);
+    if (c == 0.0)
+        return false;
+
+    double t = (n.dot(v0 - origin)) / c;
+    if (t >= closest || t <= 0.0)
+        return false;
+
+    double m00 = e0.dot(e0);
+    double m01 = e0.dot(e1);
+    double m10 = e1.dot(e0);
+    double m11 = e1.dot(e1);
+    double det = m00 * m11 - m01 * m10;
+    if (det == 0.0)
+        return false;
+
+    Eigen::Vector3d p = origin + direction * t;
+    Eigen::Vector3d q = p - v0;
+    double q0 = e0.dot(q);
+    double q1 = e1.dot(q);
+    double d = 1.0 / det;
+    double s0 = (m11 * q0 - m01 * q1) * d;
+    double s1 = (m00 * q1 - m10 * q0) * d;
+    if (s0 < 0.0 || s1 < 0.0 || s0 + s1 > 1.0)
+        return false;
+
+    closest = t;
+    return true;
+}
+
+} // end unnamed namespace
+
+MeshBVH::MeshBVH(std::vector<Eigen::Vector3f>&& positions, std::vector<Triangle>&& triangles) :
+    m_positions(std::move(positions)),
+    m_triangles(std::move(triangles))
+{
+    if (m_triangles.empty())
+        return;
+
+    std::vector<Eigen::Vector3f> centroids;
+    centroids.reserve(m_triangles.size());
+    for (const Triangle& triangle : m_triangles)
+        centroids.push_back(triangleBounds(m_positions, triangle).center());
+
+    m_nodes.reserve(m_triangles.size() / MaxLeafSize * 2 + 1);
+
+    // The first child of each node directly follows it, so the second
+    // child is created once the subtree of the first is complete
+    struct Task
+    {
+        std::uint32_t parent;
+        std::uint32_t first;
+        std::uint32_t count;
+    };
+
+    constexpr auto NoParent = std::numeric_limits<std::uint32_t>::max();
+    std::vector<Task> tasks{ { NoParent, 0, static_cast<std::uint32_t>(m_triangles.size()) } };
+    while (!tasks.empty())
+    {
+        Task task = tasks.back();
+        tasks.pop_back();
+
+        auto node = static_cast<std::uint32_t>(m_nodes.size());
+        m_nodes.emplace_back();
+        if (task.parent != NoParent)
+            m_nodes[task.parent].index = node;
+
+        build(node, task.first, task.count, centroids);
+        if (const Node& built = m_nodes[node]; built.count == 0)
+        {
+            std::uint32_t leftCount = built.index;
+            tasks.push_back({ node, task.first + leftCount, task.count - leftCount });
+            tasks.push_back({ NoParent, task.first, leftCount });
+        }
+    }
+}
+
+// Sets the bounds of the node and either makes it a leaf or partitions its
+// triangles, leaving the size of the first part in index
+void
+MeshBVH::build(std::uint32_t node, std::uint32_t first, std::uint32_t count,
+               std::vector<Eigen::Vector3f>& centroids)
+{
+    Box bounds;
+    Box centroidBounds;
+    for (std::uint32_t i = first; i < first + count; ++i)
+    {
+        bounds.extend(triangleBounds(m_positions, m_triangles[i]));
+        centroidBounds.extend(centroids[i]);
+    }
+
+    Node& n = m_nodes[node];
+    n.min = bounds.min();
+    n.max = bounds.max();
+    n.index = first;
+    n.count = count;
+
+    if (count <= 1)
+        return;
+
+    struct Bin
+    {
+        Box bounds;
+        std::uint32_t count{ 0 };
+    };
+
+    Eigen::Vector3f extent = centroidBounds.sizes();
+    float bestCost = std::numeric_limits<float>::max();
+    int bestAxis = -1;
+    int bestSplit = 0;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        if (!(extent[axis] > 0.0f))
+            continue;
+
+        std::array<Bin, BinCount> bins;
+        float scale = static_cast<float>(BinCount) / extent[axis];
+        for (std::uint32_t i = first; i < first + count; ++i)
+        {
+            int bin = std::min(BinCount - 1, static_cast<int>((centroids[i][axis] - centroidBounds.min()[axis]) * scale));
+            bins[bin].bounds.extend(triangleBounds(m_positions, m_triangles[i]));
+            ++bins[bin].count;
+        }
+
+        // Cost of the splits after each bin, summed from the right
+        std::array<float, BinCount - 1> rightCosts;
+        Box rightBounds;
+        std::uint32_t rightCount = 0;
+        for (int i = BinCount - 1; i > 0; --i)
+        {
+            rightBounds.extend(bins[i].bounds);
+            rightCount += bins[i].count;
+            rightCosts[i - 1] = static_cast<float>(rightCount) * surfaceArea(rightBounds);
+        }
+
+        Box leftBounds;
+        std::uint32_t leftCount = 0;
+        for (int i = 0; i < BinCount - 1; ++i)
+        {
+            leftBounds.extend(bins[i].bounds);
+            leftCount += bins[i].count;
+            if (leftCount == 0 || leftCount == count)
+                continue;
+
+            float cost = static_cast<float>(leftCount) * surfaceArea(leftBounds) + rightCosts[i];
+            if (cost < bestCost)
+            {
+                bestCost = cost;
+                bestAxis = axis;
+                bestSplit = i;
+            }
+        }
+    }
+
+    // All centroids in one place, or splitting small leaves doesn't pay
+    if (bestAxis < 0 || (count <= MaxLeafSize && bestCost >= static_cast<float>(count) * surfaceArea(bounds)))
+        return;
+
+    float scale = static_cast<float>(BinCount) / extent[bestAxis];
+    float minCentroid = centroidBounds.min()[bestAxis];
+    auto isLeft = [&](std::uint32_t i)
+    {
+        return std::min(BinCount - 1, static_cast<int>((centroids[i][bestAxis] - minCentroid) * scale)) <= bestSplit;
+    };
+
+    std::uint32_t left = first;
+    std::uint32_t right = first + count;
+    while (left < right)
+    {
+        if (isLeft(left))
+        {
+            ++left;
+        }
+        else
+        {
+            --right;
+            std::swap(m_triangles[left], m_triangles[right]);
+            std::swap(centroids[left], centroids[right]);
+        }
+    }
+
+    n.index = left - first;
+    n.count = 0;
+}
+
+const MeshBVH::Triangle*
+MeshBVH::pick(const Eigen::Vector3d& origin,
+              const Eigen::Vector3d& direction,
+              double& distance) const
+{
+    if (m_nodes.empty())
+        return nullptr;
+
+    Eigen::Vector3d invDirection = direction.cwiseInverse();
+    const Triangle* hit = nullptr;
+
+    double entry;
+    if (!intersectBox(m_nodes.front().min, m_nodes.front().max, origin, invDirection, distance, entry))
+        return nullptr;
+
+    // Nodes to visit with the distance at which the ray enters them
+    std::vector<std::pair<std::uint32_t, double>> stack{ { 0, entry } };
+    while (!stack.empty())
+    {
+        auto [index, nodeEntry] = stack.back();
+        stack.pop_back();
+
+        // A nearer triangle may have been found since the node was pushed
+        if (nodeEntry >= distance)
+            continue;
+
+        const Node& node = m_nodes[index];
+        if (node.count > 0)
+        {
+            for (std::uint32_t i = node.index; i < node.index + node.count; ++i)
+            {
+                const Triangle& triangle = m_triangles[i];
+                if (intersectTriangle(m_positions[triangle.vertices[0]].cast<double>(),
+                                      m_positions[triangle.vertices[1]].cast<double>(),
+                                      m_positions[triangle.vertices[2]].cast<double>(),
+                                      origin, direction, distance))
+                {
+                    hit = &triangle;
+                }
+            }
+            continue;
+        }
+
+        std::pair<std::uint32_t, double> near{ index + 1, 0.0 };
+        std::pair<std::uint32_t, double> far{ node.index, 0.0 };
+        bool hitNear = intersectBox(m_nodes[near.first].min, m_nodes[near.first].max,
+                                    origin, invDirection, distance, near.second);
+        bool hitFar = intersectBox(m_nodes[far.first].min, m_nodes[far.first].max,
+                                   origin, invDirection, distance, far.second);
+        if (hitNear && hitFar)
+        {
+            // Visit the nearer child first, so that the farther one can
+            // often be skipped
+            if (far.second < near.second)
+                std::swap(near, far);
+            stack.push_back(far);
+            stack.push_back(near);
+        }
+        else if (hitNear)
+        {
+            stack.push_back(near);
+        }
+        else if (hitFar)
+        {
+            stack.push_back(far);
+        }
+    }
+
+    return hit;
+}
+
+} // end namespace cmod
@@ -0,0 +1,72 @@
+// meshbvh.h
+//
+// Copyright (C) 2024, Celestia Development Team
+//
+// Bounding volume hierarchy over the triangles of a mesh, for picking.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include <Eigen/Core>
+
+namespace cmod
+{
+
+/*!
+ * Binary tree of bounding boxes over triangles, built by binning the
+ * triangle centroids and splitting at the lowest surface area cost. The
+ * nodes are stored depth first in one array, with the first child of an
+ * inner node right after it, and the triangles are reordered so that each
+ * leaf refers to a contiguous range of them.
+ */
+class MeshBVH
+{
+public:
+    struct Triangle
+    {
+        std::array<std::uint32_t, 3> vertices;
+        // Primitive group and the index of the triangle in the group
+        std::uint32_t group;
+        std::uint32_t primitive;
+    };
+
+    MeshBVH(std::vector<Eigen::Vector3f>&& positions, std::vector<Triangle>&& triangles);
+
+    /*! Find the closest triangle hit by the ray nearer than distance. If
+     *  there is one, set distance to it and return the triangle; otherwise
+     *  return nullptr.
+     */
+    const Triangle* pick(const Eigen::Vector3d& origin,
+                         const Eigen::Vector3d& direction,
+                         double& distance) const;
+
+    std::size_t getNodeCount() const { return m_nodes.size(); }
+
+private:
+    struct Node
+    {
+        Eigen::Vector3f min;
+        Eigen::Vector3f max;
+        // Inner nodes: index of the second child, with count 0.
+        // Leaves: first triangle and number of triangles.
+        std::uint32_t index;
+        std::uint32_t count;
+    };
+
+    void build(std::uint32_t node, std::uint32_t first, std::uint32_t count,
+               std::vector<Eigen::Vector3f>& centroids);
+
+    std::vector<Eigen::Vector3f> m_positions;
+    std::vector<Triangle> m_triangles;
+    std::vector<Node> m_nodes;
+};
+
+} // end namespace cmod
@@ -368,4 +368,12 @@ Model::sortMeshes(const MeshComparator& comparator)
     meshes = std::move(newMeshes);
 }
 
+
+void
+Model::generateLODs()
+{
+    for (auto& mesh : meshes)
+        mesh.generateLODs();
+}
+
 } // end namespace cmod
@@ -130,6 +130,9 @@ class Model
     /*! Sort the model's meshes in place. */
     void sortMeshes(const MeshComparator&);
 
+    /*! Generate the levels of detail of all meshes, see Mesh::generateLODs() */
+    void generateLODs();
+
     /*! Optimize the model by eliminating all duplicated materials */
     void uniquifyMaterials();
 
@@ -12,9 +12,12 @@
 #include <array>
 #include <cassert>
 #include <cstring>
+#include <fstream>
 #include <istream>
+#include <limits>
 #include <optional>
 #include <ostream>
+#include <streambuf>
 #include <string>
 #include <string_view>
 #include <utility>
@@ -22,9 +25,12 @@
 #include <fmt/format.h>
 #include <fmt/ostream.h>
 
+#include <celcompat/bit.h>
+
 #include <celutil/binaryread.h>
 #include <celutil/binarywrite.h>
 #include <celutil/logger.h>
+#include <celutil/mappedfile.h>
 #include <celutil/tokenizer.h>
 #include "mesh.h"
 #include "model.h"
@@ -1678,18 +1684,33 @@ BinaryModelLoader::loadMesh(Mesh& mesh)
         }
 
         std::vector<Index32> indices;
-        indices.reserve(indexCount);
-
-        for (unsigned int i = 0; i < indexCount; i++)
+        if constexpr (celestia::compat::endian::native == celestia::compat::endian::little)
         {
-            std::uint32_t index;
-            if (!util::readLE<std::uint32_t>(*in, index) || index >= vertexCount)
+            // The indices are stored as they are in memory, so read them at
+            // once and check them afterwards
+            indices.resize(indexCount);
+            if (!in->read(reinterpret_cast<char*>(indices.data()), indexCount * sizeof(Index32)).good() || //NOSONAR
+                std::any_of(indices.cbegin(), indices.cend(),
+                            [vertexCount](Index32 index) { return index >= vertexCount; }))
             {
                 reportError("Index out of range");
                 return false;
             }
+        }
+        else
+        {
+            indices.reserve(indexCount);
+            for (unsigned int i = 0; i < indexCount; i++)
+            {
+                std::uint32_t index;
+                if (!util::readLE<std::uint32_t>(*in, index) || index >= vertexCount)
+                {
+                    reportError("Index out of range");
+                    return false;
+                }
 
-            indices.push_back(index);
+                indices.push_back(index);
+            }
         }
 
         mesh.addGroup(type, materialIndex, std::move(indices));
@@ -1716,9 +1737,30 @@ BinaryModelLoader::loadVertices(const VertexDescription& vertexDesc,
     }
 
     unsigned int stride = vertexDesc.strideBytes / sizeof(VWord);
+    if (vertexCount > std::numeric_limits<unsigned int>::max() / stride)
+    {
+        reportError("Too many vertices");
+        return {};
+    }
+
     unsigned int vertexDataSize = stride * vertexCount;
     std::vector<VWord> vertexData(vertexDataSize);
 
+    // The attributes of a vertex are stored one after another at the offsets
+    // of the vertex description: floats in little-endian order and UByte4 as
+    // they are in memory, so on little-endian machines the block can be read
+    // at once
+    if constexpr (celestia::compat::endian::native == celestia::compat::endian::little)
+    {
+        if (!in->read(reinterpret_cast<char*>(vertexData.data()), vertexDataSize * sizeof(VWord)).good()) //NOSONAR
+        {
+            reportError("Failed to load vertex attribute");
+            return {};
+        }
+
+        return vertexData;
+    }
+
     unsigned int offset = 0;
     for (unsigned int i = 0; i < vertexCount; i++, offset += stride)
     {
@@ -2040,6 +2082,20 @@ BinaryModelWriter::writeMaterial(const Material& material)
 }
 
 
+// Input buffer over a memory-mapped file, so that the bulk reads of vertex
+// and index data copy straight from the mapping
+class MappedFileBuf : public std::streambuf
+{
+public:
+    explicit MappedFileBuf(const util::MappedFile& file)
+    {
+        // The get area is only read from
+        auto* begin = const_cast<char*>(file.data()); //NOSONAR
+        setg(begin, begin, begin + file.size());
+    }
+};
+
+
 std::unique_ptr<ModelLoader>
 openModel(std::istream& in, HandleGetter&& getHandle)
 {
@@ -2087,6 +2143,26 @@ LoadModel(std::istream& in, HandleGetter handleGetter)
 }
 
 
+std::unique_ptr<Model>
+LoadModel(const fs::path& filename, HandleGetter handleGetter)
+{
+    if (auto file = util::MappedFile::open(filename); file != nullptr)
+    {
+        MappedFileBuf buf(*file);
+        std::istream in(&buf);
+        return LoadModel(in, std::move(handleGetter));
+    }
+
+    // Empty files can't be mapped, and may be on file systems which don't
+    // support mappings
+    std::ifstream in(filename, std::ios::binary);
+    if (!in.good())
+        return nullptr;
+
+    return LoadModel(in, std::move(handleGetter));
+}
+
+
 bool
 SaveModelAscii(const Model* model, std::ostream& out, SourceGetter sourceGetter)
 {
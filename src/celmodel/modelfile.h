@@ -25,6 +25,8 @@ using HandleGetter = std::function<ResourceHandle(const fs::path&)>;
 using SourceGetter = std::function<fs::path(ResourceHandle)>;
 
 std::unique_ptr<Model> LoadModel(std::istream& in, HandleGetter getHandle);
+// Reads the file through a memory mapping when possible
+std::unique_ptr<Model> LoadModel(const fs::path& filename, HandleGetter getHandle);
 
 bool SaveModelAscii(const Model* model, std::ostream& out, SourceGetter getSource);
 bool SaveModelBinary(const Model* model, std::ostream& out, SourceGetter getSource);
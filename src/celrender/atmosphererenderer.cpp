@@ -11,6 +11,7 @@
 #include "atmosphererenderer.h"
 
 #include <algorithm>
+#include <chrono>
 #include <cmath>
 #include <cstring>
 
@@ -26,6 +27,7 @@
 #include <celmath/vecgl.h>
 #include <celutil/color.h>
 #include <celutil/indexlist.h>
+#include <celutil/threadpool.h>
 #include <celrender/gl/buffer.h>
 #include <celrender/gl/vertexobject.h>
 
@@ -44,6 +46,32 @@ constexpr int MinSkySlices = 30;
 
 constexpr int MaxVertices = MaxSkySlices * (MaxSkyRings + 1);
 constexpr int MaxIndices = IndexListCapacity(MaxSkySlices,  MaxSkyRings + 1);
+
+// Number of atmospheres whose scattering tables are kept; the tables of the
+// atmosphere drawn the longest time ago are released above it
+constexpr std::size_t MaxScatteringTables = 16;
+
+bool useScatteringTables = true;
+
+GLuint
+createTableTexture(const std::vector<std::uint8_t> &texels, int width, int height)
+{
+    GLuint texture = 0;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+#ifdef GL_ES
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, texels.data());
+#else
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, texels.data());
+#endif
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return texture;
+}
+
 } // end unnamed namespace
 
 AtmosphereRenderer::AtmosphereRenderer(Renderer &renderer) :
@@ -89,12 +117,101 @@ void AtmosphereRenderer::initGL()
 
 void AtmosphereRenderer::deinitGL()
 {
+    for (auto &[atmosphere, tables] : m_scatteringTables)
+        releaseScatteringTables(tables);
+    m_scatteringTables.clear();
+
     m_initialized = false;
     m_vo = nullptr;
     m_bo = nullptr;
     m_io = nullptr;
 }
 
+void
+AtmosphereRenderer::setScatteringTables(bool enable)
+{
+    useScatteringTables = enable;
+}
+
+const AtmosphereRenderer::ScatteringTables*
+AtmosphereRenderer::getScatteringTables(const Atmosphere &atmosphere, float radius)
+{
+    if (!useScatteringTables)
+        return nullptr;
+
+    AtmosphereTableParameters params = AtmosphereTableParameters::create(atmosphere, radius);
+    auto [it, inserted] = m_scatteringTables.try_emplace(&atmosphere);
+    ScatteringTables &tables = it->second;
+    tables.lastUsed = ++m_drawCount;
+
+    if (inserted || tables.params != params)
+    {
+        releaseScatteringTables(tables);
+        tables.params = params;
+
+        util::ThreadPool *threadPool = util::GetThreadPool();
+        if (threadPool->threadCount() > 0)
+        {
+            tables.pending = threadPool->async([params, threadPool]
+            {
+                return AtmosphereTables::compute(params, threadPool);
+            });
+        }
+        else
+        {
+            std::promise<AtmosphereTables> computed;
+            computed.set_value(AtmosphereTables::compute(params, nullptr));
+            tables.pending = computed.get_future();
+        }
+
+        if (m_scatteringTables.size() > MaxScatteringTables)
+        {
+            auto oldest = std::min_element(m_scatteringTables.begin(), m_scatteringTables.end(),
+                                           [](const auto &a, const auto &b)
+                                           {
+                                               return a.second.lastUsed < b.second.lastUsed;
+                                           });
+            releaseScatteringTables(oldest->second);
+            m_scatteringTables.erase(oldest);
+        }
+
+        return nullptr;
+    }
+
+    if (tables.pending.valid())
+    {
+        if (tables.pending.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+            return nullptr;
+
+        AtmosphereTables computed = tables.pending.get();
+        tables.transmittanceTexture = createTableTexture(computed.transmittanceTexels(),
+                                                         AtmosphereTables::ViewAngleSamples,
+                                                         AtmosphereTables::HeightSamples);
+        tables.inscatterTexture = createTableTexture(computed.inscatterTexels(),
+                                                     AtmosphereTables::ViewAngleSamples,
+                                                     AtmosphereTables::HeightSamples * AtmosphereTables::SunAngleSamples);
+        tables.inscatterScale = computed.inscatterScale();
+    }
+
+    return &tables;
+}
+
+void
+AtmosphereRenderer::releaseScatteringTables(ScatteringTables &tables) const
+{
+    // A pending computation only holds a copy of the parameters, so its
+    // result can be dropped without waiting for it
+    tables.pending = {};
+
+    if (tables.transmittanceTexture != 0)
+        glDeleteTextures(1, &tables.transmittanceTexture);
+    if (tables.inscatterTexture != 0)
+        glDeleteTextures(1, &tables.inscatterTexture);
+
+    tables.transmittanceTexture = 0;
+    tables.inscatterTexture = 0;
+}
+
 void
 AtmosphereRenderer::computeLegacy(
     const Atmosphere         &atmosphere,
@@ -364,10 +481,14 @@ AtmosphereRenderer::render(
     if (ls.nLights == 0)
         return;
 
+    const ScatteringTables *tables = getScatteringTables(atmosphere, radius);
+
     ShaderProperties shadprop;
     shadprop.nLights = static_cast<ushort>(ls.nLights);
 
     shadprop.texUsage |= TexUsage::Scattering;
+    if (tables != nullptr)
+        shadprop.texUsage |= TexUsage::ScatteringTables;
     shadprop.lightModel = LightingModel::AtmosphereModel;
 
     // Get a shader for the current rendering configuration
@@ -386,6 +507,20 @@ AtmosphereRenderer::render(
     prog->eyePosition = ls.eyePos_obj / atmScale;
     prog->setAtmosphereParameters(atmosphere, radius, atmosphereRadius);
 
+    if (tables != nullptr)
+    {
+        prog->inscatterScale = tables->inscatterScale;
+        prog->scatteringTableSize = Eigen::Vector3f(static_cast<float>(AtmosphereTables::HeightSamples),
+                                                    static_cast<float>(AtmosphereTables::ViewAngleSamples),
+                                                    static_cast<float>(AtmosphereTables::SunAngleSamples));
+
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, tables->transmittanceTexture);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, tables->inscatterTexture);
+        glActiveTexture(GL_TEXTURE0);
+    }
+
 #if 0
     // Currently eclipse shadows are ignored when rendering atmospheres
     if (shadprop.shadowCounts != 0)
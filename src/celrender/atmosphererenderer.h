@@ -12,12 +12,17 @@
 
 #include <array>
 #include <cstdint>
+#include <future>
 #include <memory>
+#include <unordered_map>
 #include <vector>
 
 #include <Eigen/Core>
 #include <Eigen/Geometry>
 
+#include <celengine/glsupport.h>
+#include <celrender/atmospheretables.h>
+
 class Atmosphere;
 class Renderer;
 struct RenderInfo;
@@ -71,7 +76,27 @@ public:
     void initGL();
     void deinitGL();
 
+    // Evaluate the scattering of the atmospheres with the scattering
+    // parameters from tables computed in the background, instead of the
+    // analytic approximation of the shaders
+    static void setScatteringTables(bool enable);
+
 private:
+    // Tables of an atmosphere, drawn with the analytic approximation until
+    // they are computed
+    struct ScatteringTables
+    {
+        AtmosphereTableParameters params;
+        std::future<AtmosphereTables> pending;
+        GLuint transmittanceTexture{ 0 };
+        GLuint inscatterTexture{ 0 };
+        float inscatterScale{ 0.0f };
+        std::uint64_t lastUsed{ 0 };
+    };
+
+    const ScatteringTables* getScatteringTables(const Atmosphere &atmosphere, float radius);
+    void releaseScatteringTables(ScatteringTables &tables) const;
+
     void computeLegacy(
         const Atmosphere         &atmosphere,
         const LightingState      &ls,
@@ -104,6 +129,8 @@ private:
     std::unique_ptr<gl::Buffer>       m_bo;
     std::unique_ptr<gl::Buffer>       m_io;
     std::unique_ptr<gl::VertexObject> m_vo;
+    std::unordered_map<const Atmosphere*, ScatteringTables> m_scatteringTables;
+    std::uint64_t                     m_drawCount{ 0 };
     bool                              m_initialized{ false };
 };
 
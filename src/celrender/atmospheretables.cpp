@@ -0,0 +1,256 @@
+// atmospheretables.cpp
+//
+// Copyright (C) 2025, Celestia Development Team
+//
+// Precomputed transmittance and inscattering tables of atmospheres.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include "atmospheretables.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+#include <celengine/atmosphere.h>
+#include <celutil/threadpool.h>
+
+namespace celestia::render
+{
+
+namespace
+{
+
+constexpr unsigned int IntegrationSteps = 32;
+
+// Avoid numerical precision problems by keeping the sample points just
+// above the planet surface, as the scattertable tool does.
+constexpr double BaseHeight = 1.0e-6;
+
+// Based on the approximation from E. Bruneton and F. Neyret of the optical
+// depth of a path of length l, from the radius r at the cosine mu of the
+// angle to the zenith, in an atmosphere of scale height H above the ground
+// radius R.
+double
+opticalDepth(double r, double mu, double l, double H, double R)
+{
+    double a = std::sqrt(r * 0.5 / H);
+    double bx = a * mu;
+    double by = a * (mu + l / r);
+    double sbx = bx < 0.0 ? -1.0 : 1.0;
+    double sby = by < 0.0 ? -1.0 : 1.0;
+    double x = sby > sbx ? std::exp(bx * bx) : 0.0;
+    double yx = sbx / (2.3193 * std::abs(bx) + std::sqrt(1.52 * bx * bx + 4.0));
+    double yy = sby / (2.3193 * std::abs(by) + std::sqrt(1.52 * by * by + 4.0)) *
+                std::exp(-l / H * (l / (2.0 * r) + mu));
+
+    return std::sqrt(6.2831 * H * r) * std::exp((R - r) / H) * (x + yx - yy);
+}
+
+// Length of the ray from the radius r at the cosine mu of the angle to the
+// zenith, up to the ground or to the top of the atmosphere
+double
+pathLength(double r, double mu, double groundRadius, bool& hitsGround)
+{
+    double sinTheta2 = 1.0 - mu * mu;
+    double d = groundRadius * groundRadius - r * r * sinTheta2;
+    hitsGround = mu < 0.0 && d > 0.0;
+    if (hitsGround)
+        return std::max(0.0, -r * mu - std::sqrt(d));
+
+    return -r * mu + std::sqrt(std::max(0.0, 1.0 - r * r * sinTheta2));
+}
+
+Eigen::Array3d
+pathTransmittance(double r, double mu, double l, const AtmosphereTableParameters& params)
+{
+    Eigen::Array3d extinction = (params.rayleighCoeff.array()
+                                 + params.mieCoeff
+                                 + params.absorptionCoeff.array()).cast<double>();
+    double depth = opticalDepth(r, mu, l, params.scaleHeight, params.groundRadius);
+    return (-depth * extinction).exp();
+}
+
+std::uint8_t
+toUnorm8(double x)
+{
+    return static_cast<std::uint8_t>(std::clamp(x, 0.0, 1.0) * 255.0 + 0.5);
+}
+
+float
+sampleCoordinate(unsigned int index, unsigned int count)
+{
+    return static_cast<float>(index) / static_cast<float>(count - 1);
+}
+
+} // end unnamed namespace
+
+AtmosphereTableParameters
+AtmosphereTableParameters::create(const Atmosphere& atmosphere, float radius)
+{
+    // Same sky sphere as the atmosphere renderer
+    float skyRadius = radius + -atmosphere.mieScaleHeight * std::log(AtmosphereExtinctionThreshold);
+
+    AtmosphereTableParameters params;
+    params.groundRadius = radius / skyRadius;
+    params.scaleHeight = atmosphere.mieScaleHeight / skyRadius;
+    params.rayleighCoeff = atmosphere.rayleighCoeff * skyRadius;
+    params.mieCoeff = atmosphere.mieCoeff * skyRadius;
+    params.absorptionCoeff = atmosphere.absorptionCoeff * skyRadius;
+    return params;
+}
+
+bool
+AtmosphereTableParameters::operator==(const AtmosphereTableParameters& other) const
+{
+    return groundRadius == other.groundRadius &&
+           scaleHeight == other.scaleHeight &&
+           rayleighCoeff == other.rayleighCoeff &&
+           mieCoeff == other.mieCoeff &&
+           absorptionCoeff == other.absorptionCoeff;
+}
+
+float
+AtmosphereTables::toRadius(float u, float groundRadius)
+{
+    // Concentrate the samples near the ground, where the density changes
+    // the most
+    return groundRadius + u * u * (1.0f - groundRadius);
+}
+
+float
+AtmosphereTables::toMu(float u, float r, float groundRadius)
+{
+    // Split the view angles at the horizon, so that the rays hitting the
+    // ground and those reaching the sky never share a texel, and concentrate
+    // the samples around it.
+    float rho = groundRadius / r;
+    float muHorizon = -std::sqrt(std::max(0.0f, 1.0f - rho * rho));
+    if (u >= 0.5f)
+    {
+        float s = 2.0f * u - 1.0f;
+        return muHorizon + (1.0f - muHorizon) * s * s;
+    }
+
+    float s = 1.0f - 2.0f * u;
+    return muHorizon - (1.0f + muHorizon) * s * s;
+}
+
+float
+AtmosphereTables::toMuS(float u, float groundRadius)
+{
+    // No point of the atmosphere is lit with the sun below the horizon of
+    // its top
+    float muSMin = -std::sqrt(std::max(0.0f, 1.0f - groundRadius * groundRadius));
+    return muSMin + u * (1.0f - muSMin);
+}
+
+AtmosphereTables
+AtmosphereTables::compute(const AtmosphereTableParameters& params, util::ThreadPool* threadPool)
+{
+    const double rg = params.groundRadius;
+    std::vector<Eigen::Array3d> inscatter(HeightSamples * SunAngleSamples * ViewAngleSamples);
+
+    AtmosphereTables tables;
+    tables.m_transmittance.resize(HeightSamples * ViewAngleSamples * 4);
+
+    auto computeHeight = [&](std::size_t i)
+    {
+        double r = std::max(static_cast<double>(toRadius(sampleCoordinate(i, HeightSamples), params.groundRadius)),
+                            rg + BaseHeight);
+
+        for (unsigned int j = 0; j < ViewAngleSamples; ++j)
+        {
+            double mu = std::clamp(static_cast<double>(toMu(sampleCoordinate(j, ViewAngleSamples),
+                                                            static_cast<float>(r),
+                                                            params.groundRadius)),
+                                   -1.0, 1.0);
+            Eigen::Vector2d eye(0.0, r);
+            Eigen::Vector2d view(std::sqrt(std::max(0.0, 1.0 - mu * mu)), mu);
+
+            bool hitsGround;
+            double l = pathLength(r, mu, rg, hitsGround);
+
+            Eigen::Array3d viewTransmittance = pathTransmittance(r, mu, l, params);
+            std::uint8_t* texel = &tables.m_transmittance[(i * ViewAngleSamples + j) * 4];
+            for (int c = 0; c < 3; ++c)
+                texel[c] = toUnorm8(viewTransmittance[c]);
+            texel[3] = 255;
+
+            double stepLength = l / static_cast<double>(IntegrationSteps);
+            for (unsigned int k = 0; k < SunAngleSamples; ++k)
+            {
+                double muS = toMuS(sampleCoordinate(k, SunAngleSamples), params.groundRadius);
+                Eigen::Vector2d sun(std::sqrt(std::max(0.0, 1.0 - muS * muS)), muS);
+
+                Eigen::Array3d sum = Eigen::Array3d::Zero();
+                for (unsigned int m = 0; m < IntegrationSteps; ++m)
+                {
+                    double t = (static_cast<double>(m) + 0.5) * stepLength;
+                    Eigen::Vector2d x = eye + view * t;
+                    double rx = std::max(x.norm(), rg + BaseHeight);
+                    double c = x.dot(sun) / rx;
+
+                    // No inscattered light where the planet hides the sun
+                    bool sunHidden;
+                    double sunPathLength = pathLength(rx, c, rg, sunHidden);
+                    if (sunHidden)
+                        continue;
+
+                    sum += std::exp((rg - rx) / params.scaleHeight) * stepLength
+                         * pathTransmittance(r, mu, t, params)
+                         * pathTransmittance(rx, c, sunPathLength, params);
+                }
+
+                inscatter[(i * SunAngleSamples + k) * ViewAngleSamples + j] = sum;
+            }
+        }
+    };
+
+    if (threadPool != nullptr && threadPool->threadCount() > 0)
+    {
+        threadPool->parallelFor(HeightSamples, computeHeight);
+    }
+    else
+    {
+        for (std::size_t i = 0; i < HeightSamples; ++i)
+            computeHeight(i);
+    }
+
+    double maxInscatter = 0.0;
+    for (const auto& value : inscatter)
+        maxInscatter = std::max(maxInscatter, value.maxCoeff());
+    if (!(maxInscatter > 0.0))
+        maxInscatter = 1.0;
+
+    tables.m_inscatterScale = static_cast<float>(maxInscatter);
+    tables.m_inscatter.resize(inscatter.size() * 4);
+    for (std::size_t n = 0; n < inscatter.size(); ++n)
+    {
+        for (int c = 0; c < 3; ++c)
+            tables.m_inscatter[n * 4 + c] = toUnorm8(std::sqrt(inscatter[n][c] / maxInscatter));
+        tables.m_inscatter[n * 4 + 3] = 255;
+    }
+
+    return tables;
+}
+
+Eigen::Vector3f
+AtmosphereTables::transmittance(unsigned int height, unsigned int viewAngle) const
+{
+    const std::uint8_t* texel = &m_transmittance[(height * ViewAngleSamples + viewAngle) * 4];
+    return Eigen::Vector3f(texel[0], texel[1], texel[2]) / 255.0f;
+}
+
+Eigen::Vector3f
+AtmosphereTables::inscatter(unsigned int height, unsigned int viewAngle, unsigned int sunAngle) const
+{
+    const std::uint8_t* texel = &m_inscatter[((height * SunAngleSamples + sunAngle) * ViewAngleSamples + viewAngle) * 4];
+    Eigen::Vector3f value = Eigen::Vector3f(texel[0], texel[1], texel[2]) / 255.0f;
+    return value.cwiseProduct(value) * m_inscatterScale;
+}
+
+} // end namespace celestia::render
@@ -0,0 +1,96 @@
+// atmospheretables.h
+//
+// Copyright (C) 2025, Celestia Development Team
+//
+// Precomputed transmittance and inscattering tables of atmospheres.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <Eigen/Core>
+
+class Atmosphere;
+
+namespace celestia::util
+{
+class ThreadPool;
+}
+
+namespace celestia::render
+{
+
+// Scattering parameters of an atmosphere, with all distances in units of the
+// radius of the sky sphere as in the atmosphere shaders. Rayleigh and Mie
+// scattering share the Mie scale height, as they do in the shaders.
+struct AtmosphereTableParameters
+{
+    float groundRadius{ 0.0f };
+    float scaleHeight{ 0.0f };
+    Eigen::Vector3f rayleighCoeff{ Eigen::Vector3f::Zero() };
+    float mieCoeff{ 0.0f };
+    Eigen::Vector3f absorptionCoeff{ Eigen::Vector3f::Zero() };
+
+    static AtmosphereTableParameters create(const Atmosphere& atmosphere, float radius);
+
+    bool operator==(const AtmosphereTableParameters& other) const;
+    bool operator!=(const AtmosphereTableParameters& other) const { return !(*this == other); }
+};
+
+// Single scattering tables of an atmosphere, computed the way the
+// scattertable tool does, with the sun in the plane of the zenith and view
+// direction. The transmittance along the view ray is a function of the
+// height and view angle, held in a ViewAngleSamples x HeightSamples table.
+// The inscattered light is a function of the height, view angle and sun
+// angle; its table stacks one ViewAngleSamples x SunAngleSamples slice per
+// height, and the shader interpolates between the slices.
+//
+// The inscatter table holds the density integrated along the view ray,
+// weighted by the transmittance of the paths from the sun and to the eye,
+// without the scattering coefficients: as both kinds of scattering share
+// the scale height, the shader gets the Rayleigh and Mie terms by
+// multiplying it with their coefficients and phase functions.
+//
+// Both tables are RGBA8 so that they can be used on every GL version. The
+// inscatter table is normalized by inscatterScale() and holds the square
+// root of the values to keep precision near the terminator.
+class AtmosphereTables
+{
+public:
+    static constexpr unsigned int HeightSamples = 32;
+    static constexpr unsigned int ViewAngleSamples = 128;
+    static constexpr unsigned int SunAngleSamples = 32;
+
+    // Compute the tables, distributing the heights across the thread pool
+    // when there is one
+    static AtmosphereTables compute(const AtmosphereTableParameters& params,
+                                    util::ThreadPool* threadPool);
+
+    const std::vector<std::uint8_t>& transmittanceTexels() const { return m_transmittance; }
+    const std::vector<std::uint8_t>& inscatterTexels() const { return m_inscatter; }
+    float inscatterScale() const { return m_inscatterScale; }
+
+    // Decoded values of the table entries
+    Eigen::Vector3f transmittance(unsigned int height, unsigned int viewAngle) const;
+    Eigen::Vector3f inscatter(unsigned int height, unsigned int viewAngle, unsigned int sunAngle) const;
+
+    // Parameterization of the tables, mapping [0, 1] to the radius of the
+    // sample point, the cosine of the view angle at a radius and the cosine
+    // of the sun angle. The atmosphere shader uses the inverse mappings.
+    static float toRadius(float u, float groundRadius);
+    static float toMu(float u, float r, float groundRadius);
+    static float toMuS(float u, float groundRadius);
+
+private:
+    std::vector<std::uint8_t> m_transmittance;
+    std::vector<std::uint8_t> m_inscatter;
+    float m_inscatterScale{ 0.0f };
+};
+
+} // end namespace celestia::render
@@ -12,6 +12,8 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstddef>
+#include <vector>
 
 #include <Eigen/Geometry>
 
@@ -30,7 +32,6 @@
 
 
 using celestia::util::BuildIndexList;
-using celestia::util::IndexListCapacity;
 using ushort = unsigned short;
 
 namespace celestia::render
@@ -40,17 +41,60 @@ namespace
 {
 constexpr int MaxCometTailPoints = 120;
 constexpr int MaxCometTailSlices = 48;
-constexpr int MaxVertices = MaxCometTailPoints*MaxCometTailSlices;
-constexpr int MaxIndices = IndexListCapacity(MaxCometTailSlices, MaxCometTailPoints);
 
 // Distance from the Sun at which comet tails will start to fade out
 constexpr float CometTailAttenDistSol = astro::AUtoKilometers(5.0f);
+// The tail is a paraboloid whose shape only depends on the mesh resolution:
+// its points are spaced quadratically along the axis, so the slope of the
+// surface at a point doesn't depend on the tail length.
+template<typename V>
+void
+buildTailMesh(int nTailPoints, int nTailSlices, V& vertices)
+{
+    for (int i = 0; i < nTailPoints; i++)
+    {
+        float t = static_cast<float>(i) / static_cast<float>(nTailPoints);
+        float brightness = 1.0f - static_cast<float>(i) / static_cast<float>(nTailPoints - 1);
+
+        // Axial and radial components of the normal
+        float w0 = 1.0f;
+        float w1 = 0.0f;
+        if (i > 0)
+        {
+            // Radius growth over one section, the radius at the end of the
+            // tail being a tenth of its length
+            float dr = 0.1f * static_cast<float>(nTailPoints) / static_cast<float>(2 * i - 1);
+            w0 = std::atan(dr);
+            float d = std::sqrt(1.0f + w0 * w0);
+            w1 = 1.0f / d;
+            w0 = w0 / d;
+        }
+
+        for (int j = 0; j < nTailSlices; j++)
+        {
+            float theta = 2.0f * numbers::pi_v<float> * static_cast<float>(j) / static_cast<float>(nTailSlices);
+            float s, c;
+            math::sincos(theta, s, c);
+
+            auto& vtx = vertices.emplace_back();
+            vtx.point = Eigen::Vector3f(t, s, c);
+            vtx.normal = Eigen::Vector3f(s * w1, c * w1, w0).normalized();
+            vtx.brightness = brightness;
+        }
+    }
+}
+
+void
+tailResolution(int level, int nLevels, int& nTailPoints, int& nTailSlices)
+{
+    nTailPoints = MaxCometTailPoints * (level + 1) / nLevels;
+    nTailSlices = MaxCometTailSlices * (level + 1) / nLevels;
+}
+
 } // end unnamed namespace
 
 CometRenderer::CometRenderer(Renderer &renderer) :
-    m_renderer(renderer),
-    m_vertices(std::make_unique<CometTailVertex[]>(MaxVertices)),
-    m_indices(std::make_unique<ushort[]>(MaxIndices))
+    m_renderer(renderer)
 {
 }
 
@@ -98,6 +142,29 @@ CometRenderer::initGL()
             offsetof(CometTailVertex, brightness))
         .setIndexBuffer(*m_io, 0, gl::VertexObject::IndexType::UnsignedShort);
 
+    // All the levels of detail share the vertex and index buffers
+    std::vector<CometTailVertex> vertices;
+    std::vector<ushort> indices;
+    std::vector<ushort> lodIndices;
+    for (int level = 0; level < nLODs; level++)
+    {
+        int nTailPoints, nTailSlices;
+        tailResolution(level, nLODs, nTailPoints, nTailSlices);
+
+        auto baseVertex = static_cast<ushort>(vertices.size());
+        buildTailMesh(nTailPoints, nTailSlices, vertices);
+
+        lodIndices.clear();
+        BuildIndexList(static_cast<ushort>(nTailPoints - 1), static_cast<ushort>(nTailSlices), lodIndices);
+        m_lodFirsts[level] = static_cast<int>(indices.size());
+        m_lodCounts[level] = static_cast<int>(lodIndices.size());
+        for (ushort index : lodIndices)
+            indices.push_back(static_cast<ushort>(baseVertex + index));
+    }
+
+    m_bo->setData(vertices, gl::Buffer::BufferUsage::StaticDraw);
+    m_io->setData(indices, gl::Buffer::BufferUsage::StaticDraw);
+
     m_initialized = true;
     return true;
 }
@@ -124,18 +191,10 @@ CometRenderer::render(const Body &body,
 
     double now = observer.getTime();
 
-    Eigen::Vector3f cometPoints[MaxCometTailPoints];
-#if 0
-    Eigen::Vector3d pos0 = body.getOrbit(now)->positionAtTime(now);
-    Eigen::Vector3d pos1 = body.getOrbit(now)->positionAtTime(now - 0.01);
-    Eigen::Vector3d vd = pos1 - pos0;
-#endif
-
     // Adjust the amount of triangles used for the comet tail based on
     // the screen size of the comet.
     float lod = std::clamp(discSizeInPixels / 1000.0f, 0.2f, 1.0f);
-    auto nTailPoints = static_cast<int>(MaxCometTailPoints * lod);
-    auto nTailSlices = static_cast<int>(MaxCometTailSlices * lod);
+    int level = std::clamp(static_cast<int>(std::ceil(lod * nLODs)) - 1, 0, nLODs - 1);
 
     float irradiance_max = 0.0f;
     // Find the sun with the largest irrradiance of light onto the comet
@@ -163,83 +222,16 @@ CometRenderer::render(const Body &body,
     // direction to sun with dominant light irradiance:
     Eigen::Vector3f sunDir = (pos.cast<double>() - sunPos).cast<float>().normalized();
 
-    float dustTailRadius = dustTailLength * 0.1f;
-
-    Eigen::Vector3f origin = -sunDir * (body.getRadius() * 100);
-
-    for (int i = 0; i < nTailPoints; i++)
-    {
-        float alpha = static_cast<float>(i) / static_cast<float>(nTailPoints);
-        alpha = alpha * alpha;
-        cometPoints[i] = origin + sunDir * (dustTailLength * alpha);
-    }
-
     // We need three axes to define the coordinate system for rendering the
     // comet. The first axis is the sun-to-comet direction, and the other
-    // two are chose orthogonal to each other and the primary axis.
-    Eigen::Vector3f v = (cometPoints[1] - cometPoints[0]).normalized();
-    Eigen::Quaternionf q = body.getEclipticToEquatorial(now).cast<float>();
+    // two are chosen orthogonal to each other and the primary axis.
+    Eigen::Vector3f v = sunDir;
     Eigen::Vector3f u = v.unitOrthogonal();
     Eigen::Vector3f w = u.cross(v);
-
-    for (int i = 0; i < nTailPoints; i++)
-    {
-        float brightness = 1.0f - static_cast<float>(i) / static_cast<float>(nTailPoints - 1);
-        Eigen::Vector3f v0, v1;
-        float w0, w1;
-        // Special case for the first vertex in the comet tail
-        if (i == 0)
-        {
-            v0 = cometPoints[1] - cometPoints[0];
-            v0.normalize();
-            v1 = v0;
-            w0 = 1.0f;
-            w1 = 0.0f;
-        }
-        else
-        {
-            v0 = cometPoints[i] - cometPoints[i - 1];
-            float sectionLength = v0.norm();
-            v0.normalize();
-
-            if (i == nTailPoints - 1)
-            {
-                v1 = v0;
-            }
-            else
-            {
-                v1 = (cometPoints[i + 1] - cometPoints[i]).normalized();
-                q.setFromTwoVectors(v0, v1);
-                Eigen::Matrix3f rot = q.toRotationMatrix();
-                u = rot * u;
-                v = rot * v;
-                w = rot * w;
-            }
-            float dr = dustTailRadius / static_cast<float>(nTailPoints) / sectionLength;
-            w0 = std::atan(dr);
-            float d = std::sqrt(1.0f + w0 * w0);
-            w1 = 1.0f / d;
-            w0 = w0 / d;
-        }
-
-        float radius = static_cast<float>(i) / static_cast<float>(nTailPoints) * dustTailRadius;
-        for (int j = 0; j < nTailSlices; j++)
-        {
-            float theta = 2.0f * numbers::pi_v<float> * static_cast<float>(j) / static_cast<float>(nTailSlices);
-            float s, c;
-            math::sincos(theta, s, c);
-            CometTailVertex& vtx = m_vertices[i * nTailSlices + j];
-            vtx.normal = u * (s * w1) + w * (c * w1) + v * w0;
-            vtx.normal.normalize();
-            s *= radius;
-            c *= radius;
-
-            vtx.point = cometPoints[i] + u * s + w * c;
-            vtx.brightness = brightness;
-        }
-    }
-
-    BuildIndexList(static_cast<ushort>(nTailPoints-1), static_cast<ushort>(nTailSlices), m_indices.get());
+    Eigen::Matrix4f tailFrame = Eigen::Matrix4f::Identity();
+    tailFrame.block<3, 1>(0, 0) = u;
+    tailFrame.block<3, 1>(0, 1) = w;
+    tailFrame.block<3, 1>(0, 2) = v;
 
     // If fadeDistFromSun = x/x0 >= 1.0, comet tail starts fading,
     // i.e. fadeFactor quickly transits from 1 to 0.
@@ -252,22 +244,14 @@ CometRenderer::render(const Body &body,
     m_renderer.setPipelineState(ps);
 
     m_prog->use();
-    m_prog->setMVPMatrices(*m.projection, (*m.modelview) * math::translate(pos));
+    m_prog->setMVPMatrices(*m.projection, (*m.modelview) * math::translate(pos) * tailFrame);
     m_prog->vec3Param("color") = GetBodyFeaturesManager()->getCometTailColor(&body).toVector3();
-    m_prog->vec3Param("viewDir") = pos.normalized();
+    m_prog->vec3Param("viewDir") = tailFrame.topLeftCorner<3, 3>().transpose() * pos.normalized();
     m_prog->floatParam("fadeFactor") = fadeFactor;
-
-    m_bo->invalidateData().setData(
-        util::array_view(m_vertices.get(), MaxVertices),
-        gl::Buffer::BufferUsage::StreamDraw);
-
-    m_io->invalidateData().setData(
-        util::array_view(m_indices.get(), MaxIndices),
-        gl::Buffer::BufferUsage::StreamDraw);
+    m_prog->vec3Param("tailSize") = Eigen::Vector3f(dustTailLength * 0.1f, dustTailLength, body.getRadius() * 100.0f);
 
     glDisable(GL_CULL_FACE);
-    int count = IndexListCapacity(nTailSlices, nTailPoints);
-    m_vo->draw(count);
+    m_vo->draw(m_lodCounts[level], m_lodFirsts[level]);
     glEnable(GL_CULL_FACE);
 }
 
@@ -10,6 +10,7 @@
 
 #pragma once
 
+#include <array>
 #include <memory>
 
 #include <Eigen/Core>
@@ -51,6 +52,10 @@ public:
 
 private:
 
+    static constexpr int nLODs = 5;
+
+    // Meshes of the tail shape, shared by all the comets; the vertex shader
+    // scales and orients them
     struct CometTailVertex
     {
         Eigen::Vector3f point;
@@ -62,8 +67,8 @@ private:
     CelestiaGLProgram                 *m_prog{ nullptr };
     int                                m_brightnessLoc{ -1 };
     bool                               m_initialized{ false };
-    std::unique_ptr<CometTailVertex[]> m_vertices;
-    std::unique_ptr<unsigned short[]>  m_indices;
+    std::array<int, nLODs>             m_lodFirsts{};
+    std::array<int, nLODs>             m_lodCounts{};
     std::unique_ptr<gl::Buffer>        m_bo;
     std::unique_ptr<gl::Buffer>        m_io;
     std::unique_ptr<gl::VertexObject>  m_vo;
@@ -8,11 +8,16 @@
 // as published by the Free Software Foundation; either version 2
 // of the License, or (at your option) any later version.
 
+#include <algorithm>
 #include <cassert>
+#include <cstddef>
 #include <cstdint>
 #include <cmath>
+#include <limits>
+#include <tuple>
 
 #include <celengine/galaxy.h>
+#include <celengine/framestats.h>
 #include <celengine/galaxyform.h>
 #include <celengine/glsupport.h>
 #include <celengine/render.h>
@@ -22,6 +27,7 @@
 #include <celrender/gl/buffer.h>
 #include <celrender/gl/vertexobject.h>
 #include "galaxyrenderer.h"
+#include "impostoratlas.h"
 
 using celestia::engine::GalacticFormManager;
 
@@ -32,6 +38,47 @@ namespace
 constexpr int kGalaxyTextureSize = 128;
 constexpr float kSpriteScaleFactor = 1.0f / 1.55f;
 
+// Galaxies smaller on screen than the fade start, in pixels, are drawn as
+// impostors, and larger than the fade end as point clouds, with a cross-fade
+// in between. The impostor images keep about as many sprites as the point
+// cloud at the fade end.
+constexpr float kImpostorFadeStart = 24.0f;
+constexpr float kImpostorFadeEnd = 32.0f;
+
+// Distance of the form when it is drawn into the impostor images, far enough
+// for the sprites to have their full brightness
+constexpr float kImpostorDistance = 1000.0f;
+
+// The central sprites fade out at this fraction of their size
+constexpr float kSpriteRadius = 0.9f;
+
+// Blob vertex when the geometry shader builds the sprites
+struct GalaxyPointVtx
+{
+    Eigen::Matrix<GLshort, 3, 1>  position;
+    GLushort size;       // we scale blob by size=kSpriteScaleFactor**n
+    GLubyte  colorIndex; // color index [0; 255]
+    GLubyte  brightness; // blob brightness [0.0; 1.0] packed as normalized byte
+};
+
+void
+addPointVertexBuffers(gl::VertexObject &vo, const gl::Buffer &bo, const CelestiaGLProgram *prog)
+{
+    vo.addVertexBuffer(
+        bo, CelestiaGLProgram::VertexCoordAttributeIndex,
+        3, gl::VertexObject::DataType::Short,
+        true, sizeof(GalaxyPointVtx), offsetof(GalaxyPointVtx, position));
+    vo.addVertexBuffer(
+        bo, prog->attribIndex("in_Size"), 1, gl::VertexObject::DataType::UnsignedShort,
+        true, sizeof(GalaxyPointVtx), offsetof(GalaxyPointVtx, size));
+    vo.addVertexBuffer(
+        bo, prog->attribIndex("in_ColorIndex"), 1, gl::VertexObject::DataType::UnsignedByte,
+        true, sizeof(GalaxyPointVtx), offsetof(GalaxyPointVtx, colorIndex));
+    vo.addVertexBuffer(
+        bo, prog->attribIndex("in_Brightness"), 1, gl::VertexObject::DataType::UnsignedByte,
+        true, sizeof(GalaxyPointVtx), offsetof(GalaxyPointVtx, brightness));
+}
+
 void
 galaxyTextureEval(float u, float v, float /*w*/, std::uint8_t *pixel)
 {
@@ -112,6 +159,36 @@ struct GalaxyRenderer::Object
     const Galaxy   *galaxy;
 };
 
+struct GalaxyRenderer::DrawInfo
+{
+    const Object   *obj;
+    Eigen::Matrix4f m;
+    Eigen::Matrix4f pr;
+    float           brightness;
+    float           size;
+    float           minimumFeatureSize;
+    int             nPoints;
+    float           weight; // area on screen times brightness, for the budget
+};
+
+struct GalaxyRenderer::Instance
+{
+    Eigen::Matrix4f m;
+    Eigen::Vector3f params; // size, brightness, minimum feature size
+    // Not read by the shader
+    int             formId;
+    int             nPoints;
+};
+
+struct GalaxyRenderer::InstanceData
+{
+    gl::Buffer                    bo{ gl::Buffer::TargetHint::Array };
+    // Point buffer of each form with the instance buffer
+    std::vector<gl::VertexObject> vos;
+    std::vector<Instance>         instances;
+    bool                          supported{ false };
+};
+
 GalaxyRenderer::GalaxyRenderer(Renderer &renderer) :
     m_renderer(renderer)
 {
@@ -139,6 +216,11 @@ GalaxyRenderer::add(const Galaxy *galaxy, const Eigen::Vector3f &offset, float b
 void
 GalaxyRenderer::render()
 {
+    if (m_objects.empty())
+        return;
+
+    renderImpostors();
+
     if (m_objects.empty())
         return;
 
@@ -150,6 +232,142 @@ GalaxyRenderer::render()
     m_objects.clear();
 }
 
+CelestiaGLProgram*
+GalaxyRenderer::getFormProgram()
+{
+    if (gl::hasGeomShader())
+    {
+        ShaderManager::GeomShaderParams params = {GL_POINTS, GL_TRIANGLE_STRIP, 4};
+        CelestiaGLProgram *prog = m_renderer.getShaderManager().getShaderGL3("galaxy150", &params);
+        if (prog != nullptr)
+            initializeGL3(prog);
+        return prog;
+    }
+
+    CelestiaGLProgram *prog = m_renderer.getShaderManager().getShader("galaxy");
+    if (prog != nullptr)
+        initializeGL2(prog);
+    return prog;
+}
+
+float
+GalaxyRenderer::getImpostorExtent(int form, const engine::GalacticForm &galacticForm)
+{
+    if (form >= static_cast<int>(m_impostorExtents.size()))
+        m_impostorExtents.resize(static_cast<std::size_t>(form) + 1, 0.0f);
+
+    float &extent = m_impostorExtents[form];
+    if (extent > 0.0f)
+        return extent;
+
+    // The sprites are sized as in initializeGL3, relative to the galaxy size
+    const auto &points = galacticForm.blobs;
+    float sizeFactor = 1.0f;
+    for (unsigned int i = 0, pow2 = 1; i < points.size(); ++i)
+    {
+        if ((i & pow2) != 0)
+        {
+            pow2 <<= 1;
+            sizeFactor *= kSpriteScaleFactor;
+        }
+        Eigen::Vector3f p = points[i].position.cwiseProduct(galacticForm.scale);
+        extent = std::max(extent, p.norm() + kSpriteRadius * sizeFactor);
+    }
+
+    return extent;
+}
+
+void
+GalaxyRenderer::renderImpostors()
+{
+    if (m_impostors == nullptr)
+    {
+        m_impostors = std::make_unique<ImpostorAtlas>(m_renderer,
+            [this](int form, const Eigen::Matrix4f &projection, const Eigen::Matrix4f &modelView, const Eigen::Matrix3f &viewMat)
+            {
+                renderImpostorTile(form, projection, modelView, viewMat);
+            });
+    }
+
+    if (!m_impostors->isSupported())
+        return;
+
+    const auto *gm = GalacticFormManager::get();
+    for (auto &obj : m_objects)
+    {
+        // Galaxies with their own depth range are near, and drawn in full
+        if (obj.nearZ != 0.0f && obj.farZ != 0.0f)
+            continue;
+
+        int formId = obj.galaxy->getFormId();
+        const auto *galacticForm = gm->getForm(formId);
+        float distanceToDSO = std::max(0.0f, obj.offset.norm() - obj.galaxy->getRadius());
+        if (galacticForm == nullptr || distanceToDSO <= 0.0f)
+            continue;
+
+        // Galaxies under a pixel are skipped by the point cloud path too
+        float size = 2.0f * obj.galaxy->getRadius();
+        float sizeInPixels = size / (m_pixelSize * distanceToDSO);
+        if (sizeInPixels < 1.0f || sizeInPixels >= kImpostorFadeEnd)
+            continue;
+
+        float weight = std::min(1.0f, (kImpostorFadeEnd - sizeInPixels) / (kImpostorFadeEnd - kImpostorFadeStart));
+        float brightness = obj.galaxy->getBrightnessCorrection(obj.offset) * obj.brightness;
+        Eigen::Matrix3f rotation = obj.galaxy->getOrientation().conjugate().toRotationMatrix();
+        if (m_impostors->add(formId, obj.offset, rotation, size, getImpostorExtent(formId, *galacticForm), brightness * weight))
+            obj.brightness *= 1.0f - weight;
+    }
+
+    m_objects.erase(std::remove_if(m_objects.begin(), m_objects.end(),
+                                   [](const Object &obj) { return obj.brightness <= 0.0f; }),
+                    m_objects.end());
+
+    m_impostors->render(m_renderer.getProjectionMatrix(), m_renderer.getModelViewMatrix());
+}
+
+void
+GalaxyRenderer::renderImpostorTile(int form, const Eigen::Matrix4f &projection, const Eigen::Matrix4f &modelView, const Eigen::Matrix3f &viewMat)
+{
+    CelestiaGLProgram *prog = getFormProgram();
+    const auto *galacticForm = GalacticFormManager::get()->getForm(form);
+    if (prog == nullptr || galacticForm == nullptr || form >= static_cast<int>(m_renderData.size()))
+        return;
+
+    // Same count as getRenderInfo at the fade end
+    auto nPoints = static_cast<int>(galacticForm->blobs.size());
+    auto power = static_cast<unsigned>(std::log(kImpostorFadeEnd) / std::log(1.0f / kSpriteScaleFactor));
+    if (power < std::numeric_limits<decltype(nPoints)>::digits)
+        nPoints = std::min(nPoints, 1 << power);
+
+    BindTextures();
+
+    // Move the form away along the view direction so that the sprites are
+    // drawn as for a distant galaxy, and back for the projection
+    Eigen::Vector3f viewDirection = viewMat.col(2);
+
+    prog->use();
+    prog->samplerParam("galaxyTex") = 0;
+    prog->samplerParam("colorTex") = 1;
+    prog->mat3Param("viewMat") = viewMat;
+    prog->setMVPMatrices(projection, math::translate(modelView, Eigen::Vector3f(viewDirection * kImpostorDistance)));
+    prog->floatParam("size") = 1.0f;
+    prog->floatParam("brightness") = 1.0f;
+    prog->mat4Param("m") = (Eigen::Translation3f(-viewDirection * kImpostorDistance) *
+                            Eigen::Scaling(galacticForm->scale)).matrix();
+
+    if (gl::hasGeomShader())
+    {
+        prog->floatParam("minimumFeatureSize") = 1.0f / kImpostorFadeEnd;
+        m_renderData[form].vo.draw(nPoints);
+    }
+    else
+    {
+        m_renderData[form].vo.draw(nPoints * 6);
+    }
+
+    glActiveTexture(GL_TEXTURE0);
+}
+
 bool
 GalaxyRenderer::getRenderInfo(const GalaxyRenderer::Object &obj, float &brightness, float &size, float minimumFeatureSize, Eigen::Matrix4f &m, Eigen::Matrix4f &pr, int &nPoints) const
 {
@@ -193,6 +411,83 @@ GalaxyRenderer::getRenderInfo(const GalaxyRenderer::Object &obj, float &brightne
     return true;
 }
 
+void
+GalaxyRenderer::prepareDraws()
+{
+    m_draws.clear();
+    for (const auto &obj : m_objects)
+    {
+        DrawInfo &draw = m_draws.emplace_back();
+        draw.obj = &obj;
+        draw.minimumFeatureSize = 0.0f;
+        if (!getRenderInfo(obj, draw.brightness, draw.size, draw.minimumFeatureSize, draw.m, draw.pr, draw.nPoints))
+            m_draws.pop_back();
+    }
+
+    if (m_pointBudget > 0)
+        allocatePoints();
+
+    std::uint32_t totalPoints = 0;
+    for (const auto &draw : m_draws)
+        totalPoints += static_cast<std::uint32_t>(draw.nPoints);
+    engine::GetFrameStats()->current().galaxyPoints += totalPoints;
+}
+
+void
+GalaxyRenderer::allocatePoints()
+{
+    std::uint64_t requested = 0;
+    for (const auto &draw : m_draws)
+        requested += static_cast<std::uint64_t>(draw.nPoints);
+    if (requested <= m_pointBudget)
+        return;
+
+    // Galaxies we are inside of cover the screen
+    constexpr float kMaxSizeInPixels = 1.0e4f;
+
+    double totalWeight = 0.0;
+    for (auto &draw : m_draws)
+    {
+        float distanceToDSO = std::max(0.0f, draw.obj->offset.norm() - draw.obj->galaxy->getRadius());
+        float sizeInPixels = distanceToDSO > 0.0f
+            ? std::min(kMaxSizeInPixels, draw.size / (m_pixelSize * distanceToDSO))
+            : kMaxSizeInPixels;
+        draw.weight = sizeInPixels * sizeInPixels * std::max(draw.brightness, 1.0e-3f);
+        totalWeight += draw.weight;
+    }
+
+    // Share out the budget in proportion to the weights, passing the points
+    // a galaxy doesn't need on to the others: taking the galaxies by their
+    // requested count over weight, the share of each one is only smaller
+    // than its count once all the following ones are capped too
+    m_drawOrder.resize(m_draws.size());
+    for (std::size_t i = 0; i < m_drawOrder.size(); ++i)
+        m_drawOrder[i] = i;
+    std::sort(m_drawOrder.begin(), m_drawOrder.end(),
+              [this](std::size_t a, std::size_t b)
+              {
+                  return static_cast<float>(m_draws[a].nPoints) * m_draws[b].weight <
+                         static_cast<float>(m_draws[b].nPoints) * m_draws[a].weight;
+              });
+
+    auto remaining = static_cast<double>(m_pointBudget);
+    for (std::size_t i : m_drawOrder)
+    {
+        DrawInfo &draw = m_draws[i];
+        double share = totalWeight > 0.0 ? remaining * draw.weight / totalWeight : 0.0;
+        totalWeight -= draw.weight;
+        if (share < static_cast<double>(draw.nPoints))
+        {
+            // Keep the counts powers of two like the ones chosen by
+            // distance, so that the instanced batches still form
+            draw.nPoints = share >= 1.0
+                ? 1 << static_cast<int>(std::floor(std::log2(share)))
+                : 0;
+        }
+        remaining = std::max(0.0, remaining - static_cast<double>(draw.nPoints));
+    }
+}
+
 void
 GalaxyRenderer::renderGL2()
 {
@@ -215,25 +510,19 @@ GalaxyRenderer::renderGL2()
     ps.smoothLines = true;
     m_renderer.setPipelineState(ps);
 
-    for (const auto &obj : m_objects)
+    prepareDraws();
+    for (const auto &draw : m_draws)
     {
-        float brightness = 0.0f;
-        float size = 0.0f;
-        float minimumFeatureSize = 0.0f;
-        Eigen::Matrix4f m;
-        Eigen::Matrix4f pr;
-        int nPoints = 0;
-
-        if (!getRenderInfo(obj, brightness, size, minimumFeatureSize, m, pr, nPoints))
+        if (draw.nPoints == 0)
             continue;
 
-        prog->setMVPMatrices(pr, m_renderer.getModelViewMatrix());
+        prog->setMVPMatrices(draw.pr, m_renderer.getModelViewMatrix());
 
-        prog->floatParam("size")               = size;
-        prog->floatParam("brightness")         = brightness;
-        prog->mat4Param("m")                   = m;
+        prog->floatParam("size")               = draw.size;
+        prog->floatParam("brightness")         = draw.brightness;
+        prog->mat4Param("m")                   = draw.m;
 
-        m_renderData[obj.galaxy->getFormId()].vo.draw(nPoints * 6);
+        m_renderData[draw.obj->galaxy->getFormId()].vo.draw(draw.nPoints * 6);
     }
 
     glActiveTexture(GL_TEXTURE0);
@@ -272,6 +561,7 @@ GalaxyRenderer::initializeGL2(const CelestiaGLProgram *prog)
     auto brightnessLoc = prog->attribIndex("in_Brightness");
 
     const auto *gm = GalacticFormManager::get();
+    gm->buildForms();
     std::vector<GalaxyVtx> glVertices;
     std::vector<GLuint> indices;
 
@@ -314,7 +604,8 @@ GalaxyRenderer::initializeGL2(const CelestiaGLProgram *prog)
                 indices.push_back(baseIndex + 3);
             }
 
-            gl::Buffer bo(gl::Buffer::TargetHint::Array, glVertices);
+            gl::Buffer bo(gl::Buffer::TargetHint::Array);
+            bo.setStorage(glVertices);
 
             gl::VertexObject vo(gl::VertexObject::Primitive::Triangles);
 
@@ -334,7 +625,8 @@ GalaxyRenderer::initializeGL2(const CelestiaGLProgram *prog)
             vo.addVertexBuffer(
                 bo, CelestiaGLProgram::TextureCoord0AttributeIndex, 2, gl::VertexObject::DataType::UnsignedByte,
                 true, sizeof(GalaxyVtx), offsetof(GalaxyVtx, texCoord));
-            gl::Buffer io(gl::Buffer::TargetHint::ElementArray, indices);
+            gl::Buffer io(gl::Buffer::TargetHint::ElementArray);
+            io.setStorage(indices);
             vo.setIndexBuffer(std::move(io), 0, gl::VertexObject::IndexType::UnsignedInt);
             m_renderData.emplace_back(std::move(bo), std::move(vo));
         }
@@ -357,6 +649,16 @@ GalaxyRenderer::renderGL3()
 
     initializeGL3(prog);
 
+    CelestiaGLProgram *instancedProg = nullptr;
+    if (gl::hasInstancing())
+    {
+        instancedProg = m_renderer.getShaderManager().getShaderGL3("galaxyinstanced150", &params);
+        if (instancedProg != nullptr)
+            initializeInstanced(instancedProg);
+        if (m_instanceData == nullptr || !m_instanceData->supported)
+            instancedProg = nullptr;
+    }
+
     BindTextures();
 
     prog->use();
@@ -370,53 +672,131 @@ GalaxyRenderer::renderGL3()
     ps.smoothLines = true;
     m_renderer.setPipelineState(ps);
 
-    for (const auto &obj : m_objects)
+    prepareDraws();
+    for (const auto &draw : m_draws)
     {
-        float brightness = 0.0f;
-        float size = 0.0f;
-        float minimumFeatureSize = 0.0f;
-        Eigen::Matrix4f m;
-        Eigen::Matrix4f pr;
-        int nPoints = 0;
-
-        if (!getRenderInfo(obj, brightness, size, minimumFeatureSize, m, pr, nPoints))
+        if (draw.nPoints == 0)
+            continue;
+
+        // Galaxies with their own depth range are few, they keep a draw each
+        const Object &obj = *draw.obj;
+        if (instancedProg != nullptr && (obj.nearZ == 0.0f || obj.farZ == 0.0f))
+        {
+            m_instanceData->instances.push_back({ draw.m,
+                                                  Eigen::Vector3f(draw.size, draw.brightness, draw.minimumFeatureSize),
+                                                  obj.galaxy->getFormId(),
+                                                  draw.nPoints });
             continue;
+        }
 
-        prog->setMVPMatrices(pr, m_renderer.getModelViewMatrix());
+        prog->setMVPMatrices(draw.pr, m_renderer.getModelViewMatrix());
 
-        prog->floatParam("size")               = size;
-        prog->floatParam("brightness")         = brightness;
-        prog->floatParam("minimumFeatureSize") = minimumFeatureSize;
-        prog->mat4Param("m")                   = m;
+        prog->floatParam("size")               = draw.size;
+        prog->floatParam("brightness")         = draw.brightness;
+        prog->floatParam("minimumFeatureSize") = draw.minimumFeatureSize;
+        prog->mat4Param("m")                   = draw.m;
 
-        m_renderData[obj.galaxy->getFormId()].vo.draw(nPoints);
+        m_renderData[obj.galaxy->getFormId()].vo.draw(draw.nPoints);
     }
 
+    if (instancedProg != nullptr)
+        renderInstanced(instancedProg);
+
     glActiveTexture(GL_TEXTURE0);
 }
 
 void
-GalaxyRenderer::initializeGL3(const CelestiaGLProgram *prog)
+GalaxyRenderer::renderInstanced(CelestiaGLProgram *prog)
 {
-    struct GalaxyVtx
+    auto &instances = m_instanceData->instances;
+    if (instances.empty())
+        return;
+
+    std::sort(instances.begin(), instances.end(),
+              [](const Instance &a, const Instance &b)
+              {
+                  return std::tie(a.formId, a.nPoints) < std::tie(b.formId, b.nPoints);
+              });
+
+    prog->use();
+    prog->samplerParam("galaxyTex") = 0;
+    prog->samplerParam("colorTex") = 1;
+    prog->mat3Param("viewMat") = m_viewMat;
+    prog->setMVPMatrices(m_renderer.getProjectionMatrix(), m_renderer.getModelViewMatrix());
+
+    for (auto first = instances.begin(); first != instances.end();)
     {
-        Eigen::Matrix<GLshort, 3, 1>  position;
-        GLushort size;       // we scale blob by size=kSpriteScaleFactor**n
-        GLubyte  colorIndex; // color index [0; 255]
-        GLubyte  brightness; // blob brightness [0.0; 1.0] packed as normalized byte
-    };
+        auto last = std::find_if(first, instances.end(),
+                                 [first](const Instance &instance)
+                                 {
+                                     return instance.formId != first->formId || instance.nPoints != first->nPoints;
+                                 });
+        auto count = static_cast<int>(last - first);
+
+        // Each batch replaces the contents of the buffer, which the driver
+        // orphans while the previous draw is pending
+        m_instanceData->bo.setData(util::array_view<const void>(&*first, sizeof(Instance) * count),
+                                   gl::Buffer::BufferUsage::StreamDraw);
+        m_instanceData->vos[first->formId].drawInstanced(first->nPoints, count);
+
+        first = last;
+    }
 
+    instances.clear();
+}
+
+void
+GalaxyRenderer::initializeInstanced(const CelestiaGLProgram *prog)
+{
+    if (m_instanceData != nullptr)
+        return;
+
+    m_instanceData = std::make_unique<InstanceData>();
+
+    auto modelLoc = prog->attribIndex("in_ModelMatrix");
+    auto paramsLoc = prog->attribIndex("in_GalaxyParams");
+    if (modelLoc < 0 || paramsLoc < 0)
+        return;
+
+    m_instanceData->supported = true;
+
+    const auto &bo = m_instanceData->bo;
+    m_instanceData->vos.reserve(m_renderData.size());
+    for (const auto &renderData : m_renderData)
+    {
+        if (renderData.bo.id() == 0)
+        {
+            m_instanceData->vos.emplace_back(util::NoCreateT{});
+            continue;
+        }
+
+        auto &vo = m_instanceData->vos.emplace_back(gl::VertexObject::Primitive::Points);
+        addPointVertexBuffers(vo, renderData.bo, prog);
+
+        // A matrix attribute takes one location per column
+        for (int column = 0; column < 4; ++column)
+        {
+            vo.addInstanceBuffer(
+                bo, modelLoc + column, 4, gl::VertexObject::DataType::Float,
+                false, sizeof(Instance), offsetof(Instance, m) + sizeof(float) * 4 * column);
+        }
+        vo.addInstanceBuffer(
+            bo, paramsLoc, 3, gl::VertexObject::DataType::Float,
+            false, sizeof(Instance), offsetof(Instance, params));
+    }
+}
+
+void
+GalaxyRenderer::initializeGL3(const CelestiaGLProgram *prog)
+{
     if (m_initialized)
         return;
 
     m_initialized = true;
 
-    auto sizeLoc = prog->attribIndex("in_Size");
-    auto colorLoc = prog->attribIndex("in_ColorIndex");
-    auto brightnessLoc = prog->attribIndex("in_Brightness");
-
     const auto *gm = GalacticFormManager::get();
-    std::vector<GalaxyVtx> glVertices;
+    gm->buildForms();
+    std::vector<GalaxyPointVtx> glVertices;
 
     for (int count = gm->getCount(), id = 0; id < count; id++)
     {
@@ -433,7 +813,7 @@ GalaxyRenderer::initializeGL3(const CelestiaGLProgram *prog)
                     pow2 <<= 1;
                     sizeFactor *= kSpriteScaleFactor;
                 }
-                GalaxyVtx v;
+                GalaxyPointVtx v;
                 Eigen::Vector3f p = points[i].position * std::numeric_limits<GLshort>::max();
                 v.position   = p.cast<GLshort>();
                 v.size       = static_cast<GLushort>(sizeFactor);
@@ -443,23 +823,11 @@ GalaxyRenderer::initializeGL3(const CelestiaGLProgram *prog)
                 glVertices.push_back(v);
             }
 
-            gl::Buffer bo(gl::Buffer::TargetHint::Array, glVertices);
+            gl::Buffer bo(gl::Buffer::TargetHint::Array);
+            bo.setStorage(glVertices);
 
             gl::VertexObject vo(gl::VertexObject::Primitive::Points);
-
-            vo.addVertexBuffer(
-                bo, CelestiaGLProgram::VertexCoordAttributeIndex,
-                3, gl::VertexObject::DataType::Short,
-                true, sizeof(GalaxyVtx), offsetof(GalaxyVtx, position));
-            vo.addVertexBuffer(
-                bo, sizeLoc, 1, gl::VertexObject::DataType::UnsignedShort,
-                true, sizeof(GalaxyVtx), offsetof(GalaxyVtx, size));
-            vo.addVertexBuffer(
-                bo, colorLoc, 1, gl::VertexObject::DataType::UnsignedByte,
-                true, sizeof(GalaxyVtx), offsetof(GalaxyVtx, colorIndex));
-            vo.addVertexBuffer(
-                bo, brightnessLoc, 1, gl::VertexObject::DataType::UnsignedByte,
-                true, sizeof(GalaxyVtx), offsetof(GalaxyVtx, brightness));
+            addPointVertexBuffers(vo, bo, prog);
 
             m_renderData.emplace_back(std::move(bo), std::move(vo));
         }
@@ -10,6 +10,8 @@
 
 #pragma once
 
+#include <cstdint>
+#include <memory>
 #include <vector>
 
 #include <Eigen/Core>
@@ -24,6 +26,8 @@ class Renderer;
 namespace celestia::render
 {
 
+class ImpostorAtlas;
+
 class GalaxyRenderer
 {
 public:
@@ -36,13 +40,27 @@ public:
 
     void render();
 
+    // Maximum number of points drawn for all the galaxies of a frame, shared
+    // out by their area on screen and brightness; 0 means no limit
+    void setPointBudget(std::uint32_t budget) { m_pointBudget = budget; }
+    std::uint32_t getPointBudget() const { return m_pointBudget; }
+
 private:
     struct Object;
+    struct DrawInfo;
 
     using BlobVector = engine::GalacticForm::BlobVector;
 
     bool getRenderInfo(const GalaxyRenderer::Object &obj, float &brightness, float &size, float minimumFeatureSize, Eigen::Matrix4f &m, Eigen::Matrix4f &pr, int &nPoints) const;
 
+    // Compute the render info of the point cloud galaxies into m_draws, with
+    // their point counts cut down to the budget
+    void prepareDraws();
+    void allocatePoints();
+    std::vector<DrawInfo>    m_draws;
+    std::vector<std::size_t> m_drawOrder;
+    std::uint32_t            m_pointBudget{ 0 };
+
     struct RenderData;
     std::vector<RenderData>  m_renderData;
 
@@ -52,6 +70,26 @@ private:
     void renderGL3();
     void initializeGL3(const CelestiaGLProgram *prog);
 
+    // Galaxies sharing a form and a point count are drawn with a single
+    // instanced draw, the per-galaxy values coming from a streamed
+    // instance buffer
+    struct Instance;
+    struct InstanceData;
+    std::unique_ptr<InstanceData> m_instanceData;
+
+    void renderInstanced(CelestiaGLProgram *prog);
+    void initializeInstanced(const CelestiaGLProgram *prog);
+
+    // Galaxies a few pixels across are drawn as an image of their form,
+    // cross-faded with the point cloud as they grow on screen
+    std::unique_ptr<ImpostorAtlas> m_impostors;
+    std::vector<float>             m_impostorExtents;
+
+    void renderImpostors();
+    void renderImpostorTile(int form, const Eigen::Matrix4f &projection, const Eigen::Matrix4f &modelView, const Eigen::Matrix3f &viewMat);
+    float getImpostorExtent(int form, const engine::GalacticForm &galacticForm);
+    CelestiaGLProgram* getFormProgram();
+
     // global state
     std::vector<Object>     m_objects;
     Renderer               &m_renderer;
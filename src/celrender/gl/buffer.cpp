@@ -9,6 +9,8 @@
 // as published by the Free Software Foundation; either version 2
 // of the License, or (at your option) any later version.
 
+#include <cassert>
+
 #include "binder.h"
 #include "buffer.h"
 
@@ -22,13 +24,20 @@ Buffer::Buffer(util::NoCreateT)
 Buffer::Buffer(Buffer::TargetHint targetHint) :
     m_targetHint(targetHint)
 {
+#ifndef GL_ES
+    // Created buffers can be edited without binding them first
+    if (hasDirectStateAccess())
+    {
+        glCreateBuffers(1, &m_id);
+        return;
+    }
+#endif
     glGenBuffers(1, &m_id);
 }
 
 Buffer::Buffer(Buffer::TargetHint targetHint, util::array_view<const void> data, Buffer::BufferUsage usage) :
     Buffer(targetHint)
 {
-    Binder::get().bind(*this);
     setData(data, usage);
 }
 
@@ -36,7 +45,8 @@ Buffer::Buffer(Buffer &&other) noexcept :
     m_bufferSize(other.m_bufferSize),
     m_id(other.m_id),
     m_targetHint(other.m_targetHint),
-    m_usage(other.m_usage)
+    m_usage(other.m_usage),
+    m_immutable(other.m_immutable)
 {
     other.clear();
 }
@@ -49,6 +59,7 @@ Buffer& Buffer::operator=(Buffer &&other) noexcept
     m_id         = other.m_id;
     m_targetHint = other.m_targetHint;
     m_usage      = other.m_usage;
+    m_immutable  = other.m_immutable;
 
     other.clear();
 
@@ -78,6 +89,7 @@ Buffer::clear()
     m_id         = 0;
     m_targetHint = TargetHint::Array;
     m_usage      = BufferUsage::StaticDraw;
+    m_immutable  = false;
 }
 
 Buffer&
@@ -102,8 +114,17 @@ Buffer::unbind(Buffer::TargetHint target)
 Buffer&
 Buffer::setData(util::array_view<const void> data, Buffer::BufferUsage usage)
 {
+    assert(!m_immutable);
+
     m_bufferSize = data.size();
     m_usage = usage;
+#ifndef GL_ES
+    if (hasDirectStateAccess())
+    {
+        glNamedBufferData(m_id, m_bufferSize, data.data(), GLenum(m_usage));
+        return *this;
+    }
+#endif
     Binder::get().bind(*this);
     glBufferData(GLenum(m_targetHint), m_bufferSize, data.data(), GLenum(m_usage));
     return *this;
@@ -112,10 +133,40 @@ Buffer::setData(util::array_view<const void> data, Buffer::BufferUsage usage)
 Buffer&
 Buffer::setSubData(GLintptr offset, util::array_view<const void> data)
 {
+#ifndef GL_ES
+    if (hasDirectStateAccess())
+    {
+        glNamedBufferSubData(m_id, offset, data.size(), data.data());
+        return *this;
+    }
+#endif
     glBufferSubData(GLenum(m_targetHint), offset, data.size(), data.data());
     return *this;
 }
 
+Buffer&
+Buffer::setStorage(util::array_view<const void> data)
+{
+#ifndef GL_ES
+    if (ARB_buffer_storage)
+    {
+        m_bufferSize = data.size();
+        m_immutable = true;
+        if (hasDirectStateAccess())
+        {
+            glNamedBufferStorage(m_id, m_bufferSize, data.data(), 0);
+        }
+        else
+        {
+            Binder::get().bind(*this);
+            glBufferStorage(GLenum(m_targetHint), m_bufferSize, data.data(), 0);
+        }
+        return *this;
+    }
+#endif
+    return setData(data, BufferUsage::StaticDraw);
+}
+
 
 Buffer&
 Buffer::invalidateData()
@@ -123,6 +174,26 @@ Buffer::invalidateData()
     return setData(util::array_view<const void>(nullptr, m_bufferSize), m_usage);
 }
 
+#ifndef GL_ES
+void*
+Buffer::setPersistentStorage(GLsizeiptr size)
+{
+    constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+    m_bufferSize = size;
+    m_immutable = true;
+    if (hasDirectStateAccess())
+    {
+        glNamedBufferStorage(m_id, m_bufferSize, nullptr, flags);
+        return glMapNamedBufferRange(m_id, 0, m_bufferSize, flags);
+    }
+
+    Binder::get().bind(*this);
+    glBufferStorage(GLenum(m_targetHint), m_bufferSize, nullptr, flags);
+    return glMapBufferRange(GLenum(m_targetHint), 0, m_bufferSize, flags);
+}
+#endif
+
 Buffer&
 Buffer::setTargetHint(Buffer::TargetHint targetHint)
 {
@@ -133,7 +204,9 @@ Buffer::setTargetHint(Buffer::TargetHint targetHint)
 Buffer
 Buffer::wrap(GLuint id, Buffer::TargetHint targetHint)
 {
-    Buffer bo(targetHint);
+    // Not created, as the name would be lost
+    Buffer bo(util::NoCreateT{});
+    bo.m_targetHint = targetHint;
     bo.m_id = id;
     bo.m_wrapped = true;
     return bo;
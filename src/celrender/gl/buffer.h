@@ -132,9 +132,36 @@ public:
      */
     Buffer& setSubData(GLintptr offset, util::array_view<const void> data);
 
+    /**
+     * @brief Allocate immutable storage holding the data.
+     *
+     * For data which is set once: the storage can't be resized or
+     * orphaned afterwards, so @ref setData() and @ref invalidateData()
+     * must not be used. Falls back to @ref setData() with a static usage
+     * without GL_ARB_buffer_storage.
+     *
+     * @param data Data.
+     * @return Reference to self.
+     */
+    Buffer& setStorage(util::array_view<const void> data);
+
     //! Invalidate buffer data.
     Buffer& invalidateData();
 
+#ifndef GL_ES
+    /**
+     * @brief Allocate immutable storage and map it persistently for writing.
+     *
+     * Requires GL_ARB_buffer_storage. The mapping is coherent and stays
+     * valid until the buffer is destroyed; the caller must use fences to
+     * avoid overwriting data which is still used by the GPU.
+     *
+     * @param size Size in bytes.
+     * @return Pointer to the mapped storage or nullptr on failure.
+     */
+    void* setPersistentStorage(GLsizeiptr size);
+#endif
+
     //! Set buffer target. @see @ref TargetHint
     Buffer& setTargetHint(TargetHint hint);
 
@@ -168,6 +195,9 @@ private:
     //! Wrapped objects are managed externally
     bool m_wrapped{ false };
 
+    //! Storage allocated by @ref setStorage() or @ref setPersistentStorage()
+    bool m_immutable{ false };
+
     friend class VertexObject;
 };
 
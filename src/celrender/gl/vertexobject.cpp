@@ -9,6 +9,9 @@
 // as published by the Free Software Foundation; either version 2
 // of the License, or (at your option) any later version.
 
+#include <cstdint>
+
+#include <celengine/framestats.h>
 #include "binder.h"
 #include "buffer.h"
 #include "vertexobject.h"
@@ -28,6 +31,28 @@ isVAOSupported()
 #endif
 }
 
+#ifndef GL_ES
+// Size of an attribute, which DSA needs as the stride of packed arrays
+GLsizei
+attributeSize(GLenum type, int elemSize)
+{
+    switch (type)
+    {
+    case GL_BYTE:
+    case GL_UNSIGNED_BYTE:
+        return elemSize;
+    case GL_SHORT:
+    case GL_UNSIGNED_SHORT:
+    case GL_HALF_FLOAT:
+        return elemSize * 2;
+    case GL_INT_2_10_10_10_REV:
+        return 4;
+    default:
+        return elemSize * 4;
+    }
+}
+#endif
+
 } // anonymous namespace
 
 namespace celestia::gl
@@ -41,14 +66,16 @@ struct VertexObject::BufferDesc
                std::int16_t  location,
                std::uint8_t  elemSize,
                std::uint8_t  stride,
-               bool          normalized) :
+               bool          normalized,
+               std::uint8_t  divisor) :
         offset(offset),
         bufferId(bufferId),
         type(type),
         location(location),
         elemSize(elemSize),
         stride(stride),
-        normalized(normalized)
+        normalized(normalized),
+        divisor(divisor)
     {
     }
 
@@ -59,6 +86,7 @@ struct VertexObject::BufferDesc
     std::uint8_t  elemSize;   // 1, 2, 3, 4
     std::uint8_t  stride;     // WebGL allows only 255 bytes max
     bool          normalized;
+    std::uint8_t  divisor;    // 0 per vertex, 1 per instance
 };
 
 VertexObject::VertexObject(util::NoCreateT)
@@ -68,6 +96,13 @@ VertexObject::VertexObject(util::NoCreateT)
 VertexObject::VertexObject(VertexObject::Primitive primitive) :
     m_primitive(primitive)
 {
+#ifndef GL_ES
+    if (hasDirectStateAccess())
+    {
+        glCreateVertexArrays(1, &m_id);
+        return;
+    }
+#endif
     if (isVAOSupported())
         glGenVertexArrays(1, &m_id);
 }
@@ -151,7 +186,26 @@ VertexObject::addVertexBuffer(const Buffer &buffer, int location, int elemSize,
                               static_cast<std::uint16_t>(location),
                               static_cast<std::uint8_t>(elemSize),
                               static_cast<std::uint8_t>(stride),
-                              normalized);
+                              normalized,
+                              0);
+
+    return *this;
+}
+
+VertexObject&
+VertexObject::addInstanceBuffer(const Buffer &buffer, int location, int elemSize, VertexObject::DataType type, bool normalized, int stride, std::ptrdiff_t offset)
+{
+    if (buffer.targetHint() != Buffer::TargetHint::Array)
+        return *this;
+
+    m_bufferDesc.emplace_back(offset,
+                              buffer.id(),
+                              static_cast<std::uint16_t>(type),
+                              static_cast<std::uint16_t>(location),
+                              static_cast<std::uint8_t>(elemSize),
+                              static_cast<std::uint8_t>(stride),
+                              normalized,
+                              1);
 
     return *this;
 }
@@ -185,12 +239,94 @@ VertexObject::draw(VertexObject::Primitive primitive, int count, int first)
     {
         glDrawArrays(GLenum(primitive), first, count);
     }
+    engine::GetFrameStats()->addDrawCall(static_cast<std::uint64_t>(count));
 
     unbind();
 
     return *this;
 }
 
+VertexObject&
+VertexObject::drawInstanced(int count, int instanceCount, int first, [[maybe_unused]] int baseInstance)
+{
+    if (count == 0 || instanceCount == 0)
+        return *this;
+
+    bind();
+
+    if (isIndexed())
+    {
+        auto offset = static_cast<std::ptrdiff_t>(first * (m_indexType == IndexType::UnsignedShort ? sizeof(GLushort) : sizeof(GLuint)));
+#ifndef GL_ES
+        if (baseInstance != 0)
+        {
+            glDrawElementsInstancedBaseInstance(GLenum(m_primitive), count, GLenum(m_indexType), PTR(offset), instanceCount, baseInstance);
+        }
+        else
+#endif
+        {
+            glDrawElementsInstanced(GLenum(m_primitive), count, GLenum(m_indexType), PTR(offset), instanceCount);
+        }
+    }
+    else
+    {
+#ifndef GL_ES
+        if (baseInstance != 0)
+        {
+            glDrawArraysInstancedBaseInstance(GLenum(m_primitive), first, count, instanceCount, baseInstance);
+        }
+        else
+#endif
+        {
+            glDrawArraysInstanced(GLenum(m_primitive), first, count, instanceCount);
+        }
+    }
+    engine::GetFrameStats()->addDrawCall(static_cast<std::uint64_t>(count) * static_cast<std::uint64_t>(instanceCount));
+
+    unbind();
+
+    return *this;
+}
+
+VertexObject&
+VertexObject::multiDraw(VertexObject::Primitive primitive, util::array_view<int> counts, util::array_view<int> firsts)
+{
+    if (counts.empty())
+        return *this;
+
+#ifdef GL_ES
+    for (std::size_t i = 0; i < counts.size(); ++i)
+        draw(primitive, counts[i], firsts[i]);
+#else
+    if (counts.size() == 1)
+        return draw(primitive, counts[0], firsts[0]);
+
+    bind();
+
+    auto drawCount = static_cast<GLsizei>(counts.size());
+    if (isIndexed())
+    {
+        std::size_t indexSize = m_indexType == IndexType::UnsignedShort ? sizeof(GLushort) : sizeof(GLuint);
+        m_offsets.clear();
+        for (int first : firsts)
+            m_offsets.push_back(PTR(static_cast<std::ptrdiff_t>(first * indexSize)));
+        glMultiDrawElements(GLenum(primitive), counts.data(), GLenum(m_indexType), m_offsets.data(), drawCount);
+    }
+    else
+    {
+        glMultiDrawArrays(GLenum(primitive), firsts.data(), counts.data(), drawCount);
+    }
+    std::uint64_t vertexCount = 0;
+    for (int count : counts)
+        vertexCount += static_cast<std::uint64_t>(count);
+    engine::GetFrameStats()->addDrawCall(vertexCount);
+
+    unbind();
+#endif
+
+    return *this;
+}
+
 VertexObject&
 VertexObject::setIndexBuffer(const Buffer &buffer, std::ptrdiff_t /*offset*/, VertexObject::IndexType type)
 {
@@ -226,19 +362,47 @@ VertexObject::enableAttribArrays() const
 
         glEnableVertexAttribArray(p.location);
         glVertexAttribPointer(p.location, p.elemSize, p.type, p.normalized ? GL_TRUE : GL_FALSE, p.stride, PTR(p.offset));
+        if (p.divisor != 0)
+            glVertexAttribDivisor(p.location, p.divisor);
     }
 
     if (isIndexed())
         binder.bind(m_indexBuffer);
 }
 
+#ifndef GL_ES
+void
+VertexObject::setAttribArrays() const
+{
+    // Each attribute has its own binding point, numbered after its location
+    for (const auto &p : m_bufferDesc)
+    {
+        GLsizei stride = p.stride != 0 ? p.stride : attributeSize(p.type, p.elemSize);
+        glEnableVertexArrayAttrib(m_id, p.location);
+        glVertexArrayVertexBuffer(m_id, p.location, p.bufferId, p.offset, stride);
+        glVertexArrayAttribFormat(m_id, p.location, p.elemSize, p.type, p.normalized ? GL_TRUE : GL_FALSE, 0);
+        glVertexArrayAttribBinding(m_id, p.location, p.location);
+        if (p.divisor != 0)
+            glVertexArrayBindingDivisor(m_id, p.location, p.divisor);
+    }
+
+    if (isIndexed())
+        glVertexArrayElementBuffer(m_id, m_indexBuffer.id());
+}
+#endif
+
 void
 VertexObject::disableAttribArrays() const
 {
     auto &binder = Binder::get();
 
     for (const auto &p : m_bufferDesc)
+    {
         glDisableVertexAttribArray(p.location);
+        // Without VAOs the divisor isn't reset with the array
+        if (p.divisor != 0)
+            glVertexAttribDivisor(p.location, 0);
+    }
 
     binder.unbind(Buffer::TargetHint::Array);
 
@@ -249,6 +413,16 @@ VertexObject::disableAttribArrays() const
 void
 VertexObject::bind()
 {
+#ifndef GL_ES
+    // The arrays are set up without binding the buffers
+    if (!m_initialized && hasDirectStateAccess())
+    {
+        m_initialized = true;
+        setAttribArrays();
+        m_bufferDesc.clear();
+    }
+#endif
+
     if (isVAOSupported())
         Binder::get().bind(*this);
     else
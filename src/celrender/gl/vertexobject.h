@@ -14,6 +14,7 @@
 #include <cstdint>
 #include <vector>
 #include <celengine/glsupport.h>
+#include <celutil/array_view.h>
 #include <celutil/nocreate.h>
 
 #include "buffer.h"
@@ -45,6 +46,7 @@ public:
         UnsignedInt     = GL_UNSIGNED_INT,
         Half            = GL_HALF_FLOAT,
         Float           = GL_FLOAT,
+        Int2101010Rev   = GL_INT_2_10_10_10_REV,
     };
 
     /**
@@ -152,6 +154,21 @@ public:
      */
     VertexObject& draw(Primitive primitive, int count, int first = 0);
 
+    /**
+     * @brief Render several ranges of VertexObject.
+     *
+     * Render the ranges using a primitive provided, with a single call on
+     * OpenGL and one call per range on OpenGL ES.
+     *
+     * @param primitive Primitive.
+     * @param counts Number of vertices to draw for each range.
+     * @param firsts First vertex to draw for each range.
+     * @return Reference to self.
+     *
+     * @see @ref draw(Primitive, int, int)
+     */
+    VertexObject& multiDraw(Primitive primitive, util::array_view<int> counts, util::array_view<int> firsts);
+
     /**
      * @brief Set the primitive.
      *
@@ -218,6 +235,35 @@ public:
      */
     VertexObject& addVertexBuffer(const Buffer &buffer, int location, int elemSize, DataType type, bool normalized = false, int stride = 0, std::ptrdiff_t offset = 0);
 
+    /**
+     * @brief Define an array of per-instance vertex attribute data.
+     *
+     * Like addVertexBuffer(), except that the attribute advances once per
+     * instance drawn by drawInstanced() rather than once per vertex.
+     * Requires gl::hasInstancing().
+     *
+     * @see @ref addVertexBuffer() @ref drawInstanced()
+     */
+    VertexObject& addInstanceBuffer(const Buffer &buffer, int location, int elemSize, DataType type, bool normalized = false, int stride = 0, std::ptrdiff_t offset = 0);
+
+    /**
+     * @brief Render several instances of VertexObject.
+     *
+     * Render the vertices instanceCount times using the default primitive,
+     * the per-instance attributes taking their values from consecutive
+     * elements of their buffers. Requires gl::hasInstancing().
+     *
+     * @param count Number of vertices to draw for each instance.
+     * @param instanceCount Number of instances.
+     * @param first First vertex to draw.
+     * @param baseInstance First element of the per-instance attributes,
+     * other than 0 only with gl::ARB_base_instance.
+     * @return Reference to self.
+     *
+     * @see @ref addInstanceBuffer()
+     */
+    VertexObject& drawInstanced(int count, int instanceCount, int first = 0, int baseInstance = 0);
+
     /**
      * @brief Add index buffer. The buffer is not owned by VertexObject.
      *
@@ -247,6 +293,10 @@ private:
     void destroy() noexcept;
     //! Enable attribute attays and bind index and vertex buffers
     void enableAttribArrays() const;
+#ifndef GL_ES
+    //! Set up attribute arrays and index buffer with direct state access
+    void setAttribArrays() const;
+#endif
     //! Disable attribute attays and unbind index and vertex buffers
     void disableAttribArrays() const;
     //! Bind the current VertexObject if supported or call enableAttribArrays()
@@ -259,6 +309,9 @@ private:
     //! VAO arrays description
     std::vector<BufferDesc> m_bufferDesc;
 
+    //! Byte offsets of the ranges passed to multiDraw()
+    std::vector<const void*> m_offsets;
+
     //! Index buffer
     Buffer m_indexBuffer{ util::NoCreateT{} };
 
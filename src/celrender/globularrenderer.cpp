@@ -10,14 +10,21 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cassert>
 #include <cstdint>
 #include <cmath>
 #include <memory>
+#include <mutex>
+#include <random>
+#include <vector>
 
 #include <Eigen/Core>
 #include <Eigen/Geometry>
 
+#include <fmt/format.h>
+
+#include <celengine/formcache.h>
 #include <celengine/globular.h>
 #include <celengine/glsupport.h>
 #include <celengine/render.h>
@@ -29,7 +36,9 @@
 #include <celrender/gl/buffer.h>
 #include <celrender/gl/vertexobject.h>
 #include <celutil/color.h>
+#include <celutil/threadpool.h>
 #include "globularrenderer.h"
+#include "impostoratlas.h"
 
 namespace gl = celestia::gl;
 namespace util = celestia::util;
@@ -46,6 +55,10 @@ constexpr int starTexHeight = 128;
 
 constexpr unsigned int kGlobularPoints = 8192u;
 
+// Bump when the generation of the forms changes, so that the forms cached
+// by an earlier version aren't used
+constexpr std::string_view kFormParameters = "globular 1";
+
 constexpr float kLumiShape = 3.0f;
 
 // P1 determines the zoom level, where individual cluster stars start to appear.
@@ -54,6 +67,26 @@ constexpr float P1 = 65.0f, P2 = 0.75f;
 
 constexpr float kSpriteScaleFactor = 1.0f/1.25f;
 
+// Clusters smaller on screen than the fade start, in pixels, are drawn as
+// impostors, and larger than the fade end in full, with a cross-fade in
+// between. Both are below P1, so that the impostor images are drawn with a
+// pixel weight of 1, as the full clusters are.
+constexpr float kImpostorFadeStart = 24.0f;
+constexpr float kImpostorFadeEnd = 32.0f;
+
+// The star sprites are sized in light years, so the images are drawn for a
+// cluster of a typical tidal diameter
+constexpr float kImpostorTidalSize = 100.0f;
+
+// The images are drawn at the brightness where the opacities of the tidal
+// and the stars reach their full range, and scaled by the brightness of
+// each cluster
+constexpr float kImpostorBrightness = 0.5f;
+
+// Distance of the observer when the form is drawn into the images, beyond
+// the star sprite morphing distance
+constexpr float kImpostorDistance = 1000.0f;
+
 float RRatio, XI; // TODO: get rid of these global variables
 
 /// Globular Form
@@ -70,6 +103,9 @@ struct GlobularForm
     using BlobVector = std::vector<Blob>;
 
     std::vector<Blob> gblobs{ };
+    // Forms are built on first use, see GlobularFormManager::getForm
+    std::once_flag built;
+    std::atomic<bool> isBuilt{ false };
     mutable gl::Buffer bo{ util::NoCreateT{} };
     mutable gl::VertexObject vo{ util::NoCreateT{} };
     mutable bool GLDataInitialized{ false };
@@ -81,11 +117,12 @@ class GlobularFormManager
 public:
     GlobularFormManager()
     {
-        initializeForms();
         centerTex.fill(nullptr);
     }
 
     const GlobularForm* getForm(int) const;
+    // Build the forms not built yet in parallel
+    void buildForms(const std::vector<int>&) const;
     Texture* getCenterTex(int);
     Texture* getGlobularTex();
     Texture* getColorTex();
@@ -93,9 +130,7 @@ public:
     static GlobularFormManager* get();
 
 private:
-    void initializeForms();
-
-    std::array<GlobularForm, Globular::GlobularBuckets> globularForms{ };
+    mutable std::array<GlobularForm, Globular::GlobularBuckets> globularForms{ };
     std::array<Texture*, Globular::GlobularBuckets> centerTex{ };
     std::unique_ptr<Texture> globularTex{ nullptr };
     std::unique_ptr<Texture> colorTex{ nullptr };
@@ -260,7 +295,8 @@ initGlobularData(gl::Buffer &bo, gl::VertexObject &vo, const GlobularForm::BlobV
         globularVtx.push_back(vtx);
     }
 
-    bo = gl::Buffer(gl::Buffer::TargetHint::Array, globularVtx);
+    bo = gl::Buffer(gl::Buffer::TargetHint::Array);
+    bo.setStorage(globularVtx);
     vo = gl::VertexObject(gl::VertexObject::Primitive::Points);
     vo.addVertexBuffer(
         bo,
@@ -280,8 +316,8 @@ initGlobularData(gl::Buffer &bo, gl::VertexObject &vo, const GlobularForm::BlobV
         offsetof(GlobularVtx, texCoord));
 }
 
-void
-buildGlobularForm(GlobularForm& globularForm, float c)
+GlobularForm::BlobVector
+generateGlobularForm(float c)
 {
     GlobularForm::BlobVector globularPoints;
 
@@ -300,8 +336,7 @@ buildGlobularForm(GlobularForm& globularForm, float c)
      *  coreRadius r_c, tidalRadius r_t, King concentration c = log10(r_t/r_c).
      */
 
-    auto& rng = math::getRNG();
-    rng.seed(1312);
+    std::mt19937 rng(1312);
     while (i < kGlobularPoints)
     {
         /*!
@@ -374,7 +409,18 @@ buildGlobularForm(GlobularForm& globularForm, float c)
         }
     }
 
-    globularForm.gblobs = std::move(globularPoints);
+    return globularPoints;
+}
+
+void
+buildGlobularForm(GlobularForm& globularForm, float c)
+{
+    auto key = engine::FormCache::computeKey(fmt::format("{}\n{}\n{}", kFormParameters, c, kGlobularPoints));
+    if (engine::FormCache::load(key, globularForm.gblobs))
+        return;
+
+    globularForm.gblobs = generateGlobularForm(c);
+    engine::FormCache::save(key, globularForm.gblobs);
 }
 
 void
@@ -392,9 +438,32 @@ globularTextureEval(float u, float v, float /*w*/, std::uint8_t *pixel)
 const GlobularForm*
 GlobularFormManager::getForm(int form) const
 {
-    return form < static_cast<int>(globularForms.size())
-        ? &globularForms[form]
-        : nullptr;
+    if (form >= static_cast<int>(globularForms.size()))
+        return nullptr;
+
+    // Define globularForms corresponding to 8 different bins of King concentration c
+    GlobularForm& globularForm = globularForms[form];
+    std::call_once(globularForm.built, [&globularForm, form]
+    {
+        float cbin = Globular::MinC + (0.5f + static_cast<float>(form)) * Globular::BinWidth;
+        buildGlobularForm(globularForm, cbin);
+        globularForm.isBuilt = true;
+    });
+    return &globularForm;
+}
+
+void
+GlobularFormManager::buildForms(const std::vector<int>& forms) const
+{
+    std::vector<int> unbuilt;
+    for (int form : forms)
+    {
+        if (form < static_cast<int>(globularForms.size()) && !globularForms[form].isBuilt)
+            unbuilt.push_back(form);
+    }
+
+    if (unbuilt.size() > 1)
+        util::GetThreadPool()->parallelFor(unbuilt.size(), [this, &unbuilt](std::size_t i) { getForm(unbuilt[i]); });
 }
 
 Texture*
@@ -438,17 +507,6 @@ GlobularFormManager::getColorTex()
     return colorTex.get();
 }
 
-void
-GlobularFormManager::initializeForms()
-{
-    // Define globularForms corresponding to 8 different bins of King concentration c
-    for (unsigned int ic  = 0; ic < Globular::GlobularBuckets; ++ic)
-    {
-        float cbin = Globular::MinC + (0.5f + static_cast<float>(ic)) * Globular::BinWidth;
-        buildGlobularForm(globularForms[ic], cbin);
-    }
-}
-
 GlobularFormManager*
 GlobularFormManager::get()
 {
@@ -553,6 +611,23 @@ GlobularRenderer::render()
 
     GlobularFormManager* globularFormManager = GlobularFormManager::get();
 
+    // Build the forms of the clusters in view together rather than one by
+    // one as they are drawn
+    std::vector<int> forms;
+    for (const auto &obj : m_objects)
+    {
+        if (int form = obj.globular->getFormId(); std::find(forms.begin(), forms.end(), form) == forms.end())
+            forms.push_back(form);
+    }
+    globularFormManager->buildForms(forms);
+
+#ifndef GL_ES
+    glEnable(GL_POINT_SPRITE);
+    glEnable(GL_VERTEX_PROGRAM_POINT_SIZE);
+#endif
+
+    renderImpostors();
+
     glActiveTexture(GL_TEXTURE0);
     globularFormManager->getColorTex()->bind();
 
@@ -562,11 +637,6 @@ GlobularRenderer::render()
     ps.smoothLines = true;
     m_renderer.setPipelineState(ps);
 
-#ifndef GL_ES
-    glEnable(GL_POINT_SPRITE);
-    glEnable(GL_VERTEX_PROGRAM_POINT_SIZE);
-#endif
-
     for (const auto &obj : m_objects)
         renderForm(tidalProg, globProg, obj);
 
@@ -578,6 +648,118 @@ GlobularRenderer::render()
     glActiveTexture(GL_TEXTURE0);
 }
 
+void
+GlobularRenderer::renderImpostors()
+{
+    if (m_impostors == nullptr)
+    {
+        m_impostors = std::make_unique<ImpostorAtlas>(m_renderer,
+            [this](int form, const Eigen::Matrix4f &projection, const Eigen::Matrix4f &modelView, const Eigen::Matrix3f &viewMat)
+            {
+                renderImpostorTile(form, projection, modelView, viewMat);
+            });
+    }
+
+    if (!m_impostors->isSupported())
+        return;
+
+    for (auto &obj : m_objects)
+    {
+        // Clusters with their own depth range are near, and drawn in full
+        if (obj.nearZ != 0.0f && obj.farZ != 0.0f)
+            continue;
+
+        // Same size on screen as in renderForm; clusters under a pixel are
+        // skipped there too
+        float radius = obj.globular->getRadius();
+        float distanceToDSO = std::max(0.0f, obj.offset.norm() - radius);
+        if (distanceToDSO <= 0.0f)
+            continue;
+
+        float diskSizeInPixels = radius / (0.5f * m_pixelSize * distanceToDSO);
+        if (diskSizeInPixels < 1.0f || diskSizeInPixels >= kImpostorFadeEnd)
+            continue;
+
+        float weight = std::min(1.0f, (kImpostorFadeEnd - diskSizeInPixels) / (kImpostorFadeEnd - kImpostorFadeStart));
+        float opacity = std::min(1.0f, obj.brightness / kImpostorBrightness) * weight;
+        float tidalSize = 2.0f * obj.globular->getBoundingSphereRadius();
+        Eigen::Matrix3f rotation = obj.globular->getOrientation().conjugate().toRotationMatrix();
+
+        // The tidal quad spans one tidal size in each direction from the
+        // center, and the stars lie within it
+        if (m_impostors->add(obj.globular->getFormId(), obj.offset, rotation, tidalSize, 1.0f, opacity))
+            obj.brightness *= 1.0f - weight;
+    }
+
+    m_objects.erase(std::remove_if(m_objects.begin(), m_objects.end(),
+                                   [](const Object &obj) { return obj.brightness <= 0.0f; }),
+                    m_objects.end());
+
+    m_impostors->render(m_renderer.getProjectionMatrix(), m_renderer.getModelViewMatrix());
+}
+
+void
+GlobularRenderer::renderImpostorTile(int form, const Eigen::Matrix4f &projection, const Eigen::Matrix4f &modelView, const Eigen::Matrix3f &viewMat) const
+{
+    auto *tidalProg = m_renderer.getShaderManager().getShader("tidal");
+    auto *globProg  = m_renderer.getShaderManager().getShader("globular");
+    auto *globularFormManager = GlobularFormManager::get();
+    const auto *globularForm = globularFormManager->getForm(form);
+    if (tidalProg == nullptr || globProg == nullptr || globularForm == nullptr)
+        return;
+
+    gl::VertexObject &vo = globularForm->vo;
+    if (!globularForm->GLDataInitialized)
+    {
+        initGlobularData(globularForm->bo, vo, globularForm->gblobs);
+        globularForm->GLDataInitialized = true;
+    }
+
+    // The cluster concentration is that of the form, as in renderForm
+    float cbin = Globular::MinC + (static_cast<float>(form) + 0.5f) * Globular::BinWidth;
+    RRatio = std::pow(10.0f, cbin);
+    XI = 1.0f / std::sqrt(1.0f + RRatio * RRatio);
+
+    glActiveTexture(GL_TEXTURE0);
+    globularFormManager->getColorTex()->bind();
+    glActiveTexture(GL_TEXTURE1);
+    globularFormManager->getCenterTex(form)->bind();
+    glActiveTexture(GL_TEXTURE2);
+    globularFormManager->getGlobularTex()->bind();
+
+    // The form is drawn in its own units, so that the tidal quad spans the
+    // tile; the images match the clusters at the fade end
+    tidalProg->use();
+    tidalProg->setMVPMatrices(projection, modelView);
+    tidalProg->mat3Param("viewMat")      = viewMat;
+    tidalProg->floatParam("brightness")  = kImpostorBrightness;
+    tidalProg->floatParam("pixelWeight") = 1.0f;
+    tidalProg->floatParam("tidalSize")   = 1.0f;
+    tidalProg->samplerParam("colorTex")  = 0;
+    tidalProg->samplerParam("tidalTex")  = 1;
+
+    vo.draw(gl::VertexObject::Primitive::TriangleFan, 4);
+
+    // Two light years in tile pixels, as CalculateSpriteSize for a cluster
+    // of the nominal size at the fade end
+    float scale = 2.0f * kImpostorFadeEnd / kImpostorTidalSize;
+    float minimumFeatureSize = 0.5f * kImpostorTidalSize / kImpostorFadeEnd;
+
+    globProg->use();
+    globProg->setMVPMatrices(projection, modelView);
+    globProg->mat3Param("m")            = Eigen::Matrix3f::Identity();
+    globProg->vec3Param("offset")       = Eigen::Vector3f(viewMat.col(2) * kImpostorDistance);
+    globProg->floatParam("brightness")  = kImpostorBrightness;
+    globProg->floatParam("pixelWeight") = 1.0f;
+    globProg->floatParam("scale")       = scale * static_cast<float>(m_renderer.getScreenDpi()) / 96.0f;
+    globProg->samplerParam("colorTex")  = 0;
+    globProg->samplerParam("starTex")   = 2;
+
+    vo.draw(gl::VertexObject::Primitive::Points, CalculateSpriteCount(globularForm, 1.0f, kImpostorBrightness, minimumFeatureSize), 4);
+
+    glActiveTexture(GL_TEXTURE0);
+}
+
 void
 GlobularRenderer::renderForm(CelestiaGLProgram *tidalProg, CelestiaGLProgram *globProg, const Object &obj) const
 {
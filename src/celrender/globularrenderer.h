@@ -10,6 +10,7 @@
 
 #pragma once
 
+#include <memory>
 #include <vector>
 
 #include <Eigen/Core>
@@ -23,6 +24,8 @@ class Texture;
 namespace celestia::render
 {
 
+class ImpostorAtlas;
+
 class GlobularRenderer
 {
 public:
@@ -39,11 +42,16 @@ private:
     struct Object;
 
     void renderForm(CelestiaGLProgram *tidalProg, CelestiaGLProgram *globProg, const Object &obj) const;
+    void renderImpostors();
+    void renderImpostorTile(int form, const Eigen::Matrix4f &projection, const Eigen::Matrix4f &modelView, const Eigen::Matrix3f &viewMat) const;
 
     // global state
     std::vector<Object> m_objects;
     Renderer           &m_renderer;
 
+    // Clusters a few pixels across are drawn as an image of their form
+    std::unique_ptr<ImpostorAtlas> m_impostors;
+
     // per-frame state
     Eigen::Quaternionf m_viewerOrientation{ Eigen::Quaternionf::Identity() };
     Eigen::Matrix3f    m_viewMat{ Eigen::Matrix3f::Identity() };
@@ -0,0 +1,119 @@
+// gpuprofiler.cpp
+//
+// Copyright (C) 2025, Celestia Development Team
+//
+// Profiling zones of the GPU.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include "gpuprofiler.h"
+
+#include "gputimer.h"
+
+namespace celestia::render
+{
+
+GPUProfiler::~GPUProfiler()
+{
+#ifndef GL_ES
+    if (!m_allQueries.empty())
+        glDeleteQueries(static_cast<GLsizei>(m_allQueries.size()), m_allQueries.data());
+#endif
+}
+
+bool
+GPUProfiler::isSupported()
+{
+    return GPUTimer::isSupported();
+}
+
+void
+GPUProfiler::beginFrame()
+{
+#ifndef GL_ES
+    while (!m_zones.empty())
+    {
+        const Zone& zone = m_zones.front();
+        if (!zone.ended)
+            break;
+
+        // The end query is the last one issued, so the begin query is also
+        // available once it is
+        GLint available = GL_FALSE;
+        glGetQueryObjectiv(zone.endQuery, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available == GL_FALSE)
+            break;
+
+        GLuint64 begin = 0;
+        GLuint64 end = 0;
+        glGetQueryObjectui64v(zone.beginQuery, GL_QUERY_RESULT, &begin);
+        glGetQueryObjectui64v(zone.endQuery, GL_QUERY_RESULT, &end);
+        util::Profiler::recordGPU(zone.name,
+                                  static_cast<std::uint64_t>(static_cast<std::int64_t>(begin) + zone.offset),
+                                  static_cast<std::uint64_t>(static_cast<std::int64_t>(end) + zone.offset));
+
+        m_freeQueries.push_back(zone.beginQuery);
+        m_freeQueries.push_back(zone.endQuery);
+        m_zones.pop_front();
+        ++m_firstZone;
+    }
+
+    GLint64 gpuNow = 0;
+    glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+    m_offset = static_cast<std::int64_t>(util::Profiler::now()) - static_cast<std::int64_t>(gpuNow);
+#endif
+}
+
+std::size_t
+GPUProfiler::begin(const char* name)
+{
+#ifdef GL_ES
+    return InvalidZone;
+#else
+    if (m_zones.size() >= MaxPendingZones || !util::Profiler::isEnabled())
+        return InvalidZone;
+
+    Zone& zone = m_zones.emplace_back();
+    zone.name = name;
+    zone.beginQuery = acquireQuery();
+    zone.endQuery = acquireQuery();
+    zone.offset = m_offset;
+    zone.ended = false;
+    glQueryCounter(zone.beginQuery, GL_TIMESTAMP);
+
+    return m_firstZone + m_zones.size() - 1;
+#endif
+}
+
+void
+GPUProfiler::end(std::size_t zone)
+{
+#ifndef GL_ES
+    Zone& entry = m_zones[zone - m_firstZone];
+    glQueryCounter(entry.endQuery, GL_TIMESTAMP);
+    entry.ended = true;
+#endif
+}
+
+GLuint
+GPUProfiler::acquireQuery()
+{
+    GLuint query = 0;
+#ifndef GL_ES
+    if (!m_freeQueries.empty())
+    {
+        query = m_freeQueries.back();
+        m_freeQueries.pop_back();
+        return query;
+    }
+
+    glGenQueries(1, &query);
+    m_allQueries.push_back(query);
+#endif
+    return query;
+}
+
+} // end namespace celestia::render
@@ -0,0 +1,107 @@
+// gpuprofiler.h
+//
+// Copyright (C) 2025, Celestia Development Team
+//
+// Profiling zones of the GPU.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <vector>
+
+#include <celengine/glsupport.h>
+#include <celutil/profiler.h>
+
+namespace celestia::render
+{
+
+// Records the time spent by the GPU on the commands of each zone to the
+// GPU track of util::Profiler. Unlike GPUTimer, the zones use timestamp
+// queries, so they may be nested. Their results are read in later frames,
+// once they are available, so that the pipeline isn't stalled.
+class GPUProfiler
+{
+public:
+    static constexpr std::size_t InvalidZone = std::numeric_limits<std::size_t>::max();
+
+    GPUProfiler() = default;
+    ~GPUProfiler();
+
+    GPUProfiler(const GPUProfiler&) = delete;
+    GPUProfiler& operator=(const GPUProfiler&) = delete;
+    GPUProfiler(GPUProfiler&&) = delete;
+    GPUProfiler& operator=(GPUProfiler&&) = delete;
+
+    static bool isSupported();
+
+    // Record the zones whose results became available, and synchronize the
+    // GPU clock with that of the profiler
+    void beginFrame();
+
+    // Start a zone, returning InvalidZone if too many are still pending
+    std::size_t begin(const char* name);
+    void end(std::size_t zone);
+
+private:
+    static constexpr std::size_t MaxPendingZones = 256;
+
+    struct Zone
+    {
+        const char* name;
+        GLuint beginQuery;
+        GLuint endQuery;
+        // Difference from the GPU clock to the profiler clock
+        std::int64_t offset;
+        bool ended;
+    };
+
+    GLuint acquireQuery();
+
+    std::deque<Zone> m_zones;
+    std::vector<GLuint> m_freeQueries;
+    std::vector<GLuint> m_allQueries;
+    // Number of the first pending zone
+    std::size_t m_firstZone{ 0 };
+    std::int64_t m_offset{ 0 };
+};
+
+// Records the GPU commands from its creation to its destruction as a zone
+class GPUProfileZone
+{
+public:
+    GPUProfileZone(GPUProfiler* profiler, const char* name) :
+        m_profiler(profiler),
+        m_zone(profiler == nullptr ? GPUProfiler::InvalidZone : profiler->begin(name))
+    {
+    }
+
+    ~GPUProfileZone()
+    {
+        if (m_zone != GPUProfiler::InvalidZone)
+            m_profiler->end(m_zone);
+    }
+
+    GPUProfileZone(const GPUProfileZone&) = delete;
+    GPUProfileZone& operator=(const GPUProfileZone&) = delete;
+
+private:
+    GPUProfiler* m_profiler;
+    std::size_t m_zone;
+};
+
+} // end namespace celestia::render
+
+#ifdef CELESTIA_PROFILING
+#define CELESTIA_PROFILE_GPU_ZONE(profiler, name) \
+    ::celestia::render::GPUProfileZone CELESTIA_PROFILE_CONCAT(celestiaGPUProfileZone, __LINE__)(profiler, name)
+#else
+#define CELESTIA_PROFILE_GPU_ZONE(profiler, name) static_cast<void>(0)
+#endif
@@ -0,0 +1,117 @@
+// gpustagetimer.cpp
+//
+// Copyright (C) 2026, Celestia Development Team
+//
+// Measures the time spent by the GPU on the stages of a frame.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include "gpustagetimer.h"
+
+#include <chrono>
+#include <cstdint>
+
+#include "gputimer.h"
+
+namespace celestia::render
+{
+
+GPUStageTimer::~GPUStageTimer()
+{
+#ifndef GL_ES
+    if (!m_allQueries.empty())
+        glDeleteQueries(static_cast<GLsizei>(m_allQueries.size()), m_allQueries.data());
+#endif
+}
+
+bool
+GPUStageTimer::isSupported()
+{
+    return GPUTimer::isSupported();
+}
+
+void
+GPUStageTimer::collect()
+{
+#ifndef GL_ES
+    engine::FrameStats* frameStats = engine::GetFrameStats();
+    while (!m_intervals.empty())
+    {
+        const Interval& interval = m_intervals.front();
+        if (!interval.ended)
+            break;
+
+        // The end query is the last one issued, so the begin query is also
+        // available once it is
+        GLint available = GL_FALSE;
+        glGetQueryObjectiv(interval.endQuery, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available == GL_FALSE)
+            break;
+
+        GLuint64 begin = 0;
+        GLuint64 end = 0;
+        glGetQueryObjectui64v(interval.beginQuery, GL_QUERY_RESULT, &begin);
+        glGetQueryObjectui64v(interval.endQuery, GL_QUERY_RESULT, &end);
+        if (end > begin)
+            frameStats->addGPUStageTime(interval.stage, std::chrono::nanoseconds(static_cast<std::int64_t>(end - begin)));
+
+        m_freeQueries.push_back(interval.beginQuery);
+        m_freeQueries.push_back(interval.endQuery);
+        m_intervals.pop_front();
+        ++m_firstInterval;
+    }
+#endif
+}
+
+std::size_t
+GPUStageTimer::begin(engine::GPUStage stage)
+{
+#ifdef GL_ES
+    return InvalidInterval;
+#else
+    if (m_intervals.size() >= MaxPendingIntervals)
+        return InvalidInterval;
+
+    Interval& interval = m_intervals.emplace_back();
+    interval.stage = stage;
+    interval.beginQuery = acquireQuery();
+    interval.endQuery = acquireQuery();
+    interval.ended = false;
+    glQueryCounter(interval.beginQuery, GL_TIMESTAMP);
+
+    return m_firstInterval + m_intervals.size() - 1;
+#endif
+}
+
+void
+GPUStageTimer::end(std::size_t interval)
+{
+#ifndef GL_ES
+    Interval& entry = m_intervals[interval - m_firstInterval];
+    glQueryCounter(entry.endQuery, GL_TIMESTAMP);
+    entry.ended = true;
+#endif
+}
+
+GLuint
+GPUStageTimer::acquireQuery()
+{
+    GLuint query = 0;
+#ifndef GL_ES
+    if (!m_freeQueries.empty())
+    {
+        query = m_freeQueries.back();
+        m_freeQueries.pop_back();
+        return query;
+    }
+
+    glGenQueries(1, &query);
+    m_allQueries.push_back(query);
+#endif
+    return query;
+}
+
+} // end namespace celestia::render
@@ -0,0 +1,97 @@
+// gpustagetimer.h
+//
+// Copyright (C) 2026, Celestia Development Team
+//
+// Measures the time spent by the GPU on the stages of a frame.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <limits>
+#include <vector>
+
+#include <celengine/framestats.h>
+#include <celengine/glsupport.h>
+
+namespace celestia::render
+{
+
+// Adds the time spent by the GPU on each interval to its stage in the
+// frame statistics. The intervals use timestamp queries, so they may be
+// timed while GPUTimer is, and a stage may be timed several times in a
+// frame. Like GPUTimer, the results are read one or two frames later, once
+// they are available, so that the pipeline isn't stalled.
+class GPUStageTimer
+{
+public:
+    static constexpr std::size_t InvalidInterval = std::numeric_limits<std::size_t>::max();
+
+    GPUStageTimer() = default;
+    ~GPUStageTimer();
+
+    GPUStageTimer(const GPUStageTimer&) = delete;
+    GPUStageTimer& operator=(const GPUStageTimer&) = delete;
+    GPUStageTimer(GPUStageTimer&&) = delete;
+    GPUStageTimer& operator=(GPUStageTimer&&) = delete;
+
+    static bool isSupported();
+
+    // Add the intervals whose results became available to the current frame
+    void collect();
+
+    // Start an interval, returning InvalidInterval if too many are still
+    // pending
+    std::size_t begin(engine::GPUStage);
+    void end(std::size_t interval);
+
+private:
+    static constexpr std::size_t MaxPendingIntervals = 256;
+
+    struct Interval
+    {
+        engine::GPUStage stage;
+        GLuint beginQuery;
+        GLuint endQuery;
+        bool ended;
+    };
+
+    GLuint acquireQuery();
+
+    std::deque<Interval> m_intervals;
+    std::vector<GLuint> m_freeQueries;
+    std::vector<GLuint> m_allQueries;
+    // Number of the first pending interval
+    std::size_t m_firstInterval{ 0 };
+};
+
+// Times the GPU commands from its creation to its destruction as a stage
+class GPUStageScope
+{
+public:
+    GPUStageScope(GPUStageTimer* timer, engine::GPUStage stage) :
+        m_timer(timer),
+        m_interval(timer == nullptr ? GPUStageTimer::InvalidInterval : timer->begin(stage))
+    {
+    }
+
+    ~GPUStageScope()
+    {
+        if (m_interval != GPUStageTimer::InvalidInterval)
+            m_timer->end(m_interval);
+    }
+
+    GPUStageScope(const GPUStageScope&) = delete;
+    GPUStageScope& operator=(const GPUStageScope&) = delete;
+
+private:
+    GPUStageTimer* m_timer;
+    std::size_t m_interval;
+};
+
+} // end namespace celestia::render
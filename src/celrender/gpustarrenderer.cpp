@@ -0,0 +1,414 @@
+// gpustarrenderer.cpp
+//
+// Copyright (C) 2024, Celestia Development Team
+//
+// Draw the distant stars of the star catalog from a vertex buffer which holds
+// the whole catalog.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <utility>
+
+#include <celastro/astro.h>
+#include <celengine/dsodb.h>
+#include <celengine/opencluster.h>
+#include <celengine/render.h>
+#include <celengine/renderflags.h>
+#include <celengine/shadermanager.h>
+#include <celengine/star.h>
+#include <celengine/stardb.h>
+#include <celengine/texture.h>
+#include <celimage/image.h>
+#include <celutil/color.h>
+#include "gpustarrenderer.h"
+#include "starpsf.h"
+
+namespace celestia::render
+{
+
+namespace
+{
+
+// Nodes closer than this are always processed on the CPU, so that nearby
+// stars get the exact position and the render list treatment
+constexpr float MinRangeDistance = 10.0f;
+
+// Absolute magnitude given to the stars left out of the buffer, which the
+// vertex shader never draws
+constexpr float ExcludedStarMag = 1000.0f;
+
+// Unit of the star PSF atlas bound during render, and of the color table
+constexpr int PSFTextureUnit = 0;
+constexpr int ColorTextureUnit = 1;
+
+} // end unnamed namespace
+
+// Passes the stars to the handler, except the members of the clusters drawn
+// from their block
+class GPUStarRenderer::MemberFilter : public engine::StarHandler
+{
+public:
+    MemberFilter(const GPUStarRenderer& renderer, engine::StarHandler& handler) :
+        m_renderer(renderer),
+        m_handler(handler),
+        m_firstStar(renderer.m_starDB->getStar(0))
+    {
+    }
+
+    void process(const Star& star, float distance, float appMag) override
+    {
+        auto index = static_cast<engine::OctreeObjectIndex>(&star - m_firstStar);
+        if (!m_renderer.isActiveMember(index))
+            m_handler.process(star, distance, appMag);
+    }
+
+private:
+    const GPUStarRenderer& m_renderer;
+    engine::StarHandler& m_handler;
+    const Star* m_firstStar;
+};
+
+GPUStarRenderer::GPUStarRenderer(const Renderer& renderer) :
+    m_renderer(renderer)
+{
+}
+
+GPUStarRenderer::~GPUStarRenderer() = default;
+
+bool
+GPUStarRenderer::prepare(const StarDatabase& starDB, const DSODatabase* dsoDB, const ColorTemperatureTable& colors)
+{
+    if (m_renderer.getShaderManager().getShader("gpustar") == nullptr)
+        return false;
+
+    std::uint32_t dsoCount = dsoDB == nullptr ? 0 : dsoDB->size();
+    if (m_starDB != &starDB || m_starCount != starDB.size() ||
+        m_dsoDB != dsoDB || m_dsoCount != dsoCount)
+    {
+        upload(starDB, dsoDB);
+    }
+
+    if (m_colorTexture == nullptr || m_colorType != colors.type())
+        uploadColors(colors);
+
+    return m_starCount > 0;
+}
+
+void
+GPUStarRenderer::upload(const StarDatabase& starDB, const DSODatabase* dsoDB)
+{
+    m_starDB = &starDB;
+    m_starCount = starDB.size();
+    m_dsoDB = dsoDB;
+    m_dsoCount = dsoDB == nullptr ? 0 : dsoDB->size();
+    m_orbitingStars.clear();
+    m_clusters.clear();
+    m_memberStars.clear();
+    m_memberClusters.clear();
+
+    std::vector<StarVertex> vertices;
+    vertices.reserve(m_starCount);
+    for (std::uint32_t i = 0; i < m_starCount; ++i)
+    {
+        const Star* star = starDB.getStar(i);
+        StarVertex& vertex = vertices.emplace_back();
+        vertex.position = star->getPosition();
+        vertex.extinction = star->getExtinction();
+        vertex.temperature = static_cast<std::uint16_t>(std::clamp(star->getTemperature(),
+                                                                   0.0f,
+                                                                   static_cast<float>(std::numeric_limits<std::uint16_t>::max())));
+
+        if (star->getOrbit() != nullptr)
+        {
+            m_orbitingStars.push_back(i);
+            vertex.absMag = ExcludedStarMag;
+        }
+        else
+        {
+            vertex.absMag = star->getAbsoluteMagnitude();
+        }
+    }
+
+    if (m_starCount == 0)
+    {
+        m_activeClusters.clear();
+        return;
+    }
+
+    if (dsoDB != nullptr)
+    {
+        std::vector<std::pair<engine::OctreeObjectIndex, std::uint32_t>> members;
+        std::vector<bool> assigned(m_starCount, false);
+        for (std::uint32_t i = 0; i < m_dsoCount; ++i)
+        {
+            const DeepSkyObject* dso = dsoDB->getDSO(i);
+            if (dso->getObjType() != DeepSkyObjectType::OpenCluster)
+                continue;
+
+            Cluster cluster;
+            cluster.center = dso->getPosition().cast<float>();
+            cluster.radius = dso->getRadius();
+            cluster.brightestMag = std::numeric_limits<float>::infinity();
+            cluster.block.first = static_cast<engine::OctreeObjectIndex>(vertices.size());
+
+            auto clusterIndex = static_cast<std::uint32_t>(m_clusters.size());
+            for (engine::OctreeObjectIndex index : static_cast<const OpenCluster*>(dso)->getMembers())
+            {
+                // Members shared by overlapping clusters are kept in the
+                // first one, and stars with an orbit stay on the CPU
+                if (index >= m_starCount || assigned[index] || vertices[index].absMag == ExcludedStarMag)
+                    continue;
+
+                assigned[index] = true;
+                StarVertex vertex = vertices[index];
+                cluster.brightestMag = std::min(cluster.brightestMag, vertex.absMag);
+                vertices.push_back(vertex);
+                vertices[index].absMag = ExcludedStarMag;
+                members.emplace_back(index, clusterIndex);
+            }
+
+            cluster.block.last = static_cast<engine::OctreeObjectIndex>(vertices.size());
+            if (cluster.block.last > cluster.block.first)
+                m_clusters.push_back(cluster);
+        }
+
+        std::sort(members.begin(), members.end());
+        m_memberStars.reserve(members.size());
+        m_memberClusters.reserve(members.size());
+        for (const auto& [index, clusterIndex] : members)
+        {
+            m_memberStars.push_back(index);
+            m_memberClusters.push_back(clusterIndex);
+        }
+    }
+
+    m_activeClusters.assign(m_clusters.size(), false);
+
+    m_bo = gl::Buffer(gl::Buffer::TargetHint::Array);
+    m_bo.setStorage(vertices);
+    m_vo = gl::VertexObject(gl::VertexObject::Primitive::Points);
+    m_vo.addVertexBuffer(m_bo,
+                         CelestiaGLProgram::VertexCoordAttributeIndex,
+                         3,
+                         gl::VertexObject::DataType::Float,
+                         false,
+                         sizeof(StarVertex),
+                         offsetof(StarVertex, position));
+    m_vo.addVertexBuffer(m_bo,
+                         CelestiaGLProgram::IntensityAttributeIndex,
+                         1,
+                         gl::VertexObject::DataType::Float,
+                         false,
+                         sizeof(StarVertex),
+                         offsetof(StarVertex, absMag));
+    m_vo.addVertexBuffer(m_bo,
+                         CelestiaGLProgram::ScaleFactorAttributeIndex,
+                         1,
+                         gl::VertexObject::DataType::Float,
+                         false,
+                         sizeof(StarVertex),
+                         offsetof(StarVertex, extinction));
+    m_vo.addVertexBuffer(m_bo,
+                         CelestiaGLProgram::TextureCoord0AttributeIndex,
+                         1,
+                         gl::VertexObject::DataType::UnsignedShort,
+                         false,
+                         sizeof(StarVertex),
+                         offsetof(StarVertex, temperature));
+}
+
+// The color table as a one pixel high texture, sampled at the texel centers
+void
+GPUStarRenderer::uploadColors(const ColorTemperatureTable& colors)
+{
+    const std::vector<Color>& entries = colors.getColors();
+    auto count = static_cast<std::int32_t>(entries.size());
+
+    engine::Image img(engine::PixelFormat::RGBA, count, 1);
+    std::uint8_t* pixels = img.getPixels();
+    for (std::int32_t i = 0; i < count; ++i)
+        entries[i].get(pixels + i * 4);
+
+    m_colorTexture = std::make_unique<ImageTexture>(img, Texture::EdgeClamp, Texture::NoMipMaps);
+    m_colorTempScale = colors.getTemperatureScale();
+    m_colorCount = static_cast<float>(count);
+    m_colorType = colors.type();
+}
+
+void
+GPUStarRenderer::findVisibleStars(engine::StarHandler& handler,
+                                  const Eigen::Vector3f& obsPosition,
+                                  const Eigen::Quaternionf& obsOrientation,
+                                  float fovY,
+                                  float aspectRatio,
+                                  float limitingMag,
+                                  float labelMag)
+{
+    m_ranges.clear();
+
+    // Keep the ranges a small fraction of their distance away, so that the
+    // star positions relative to the observer are accurate enough in single
+    // precision
+    float minRangeDistance = std::max(MinRangeDistance, obsPosition.norm() * 0.01f);
+    updateClusters(obsPosition, obsOrientation, fovY, aspectRatio, limitingMag, labelMag, minRangeDistance);
+
+    if (m_anyActiveCluster)
+    {
+        MemberFilter filter(*this, handler);
+        m_starDB->findVisibleStarRanges(filter,
+                                        m_ranges,
+                                        obsPosition,
+                                        obsOrientation,
+                                        fovY,
+                                        aspectRatio,
+                                        limitingMag,
+                                        minRangeDistance,
+                                        labelMag);
+    }
+    else
+    {
+        m_starDB->findVisibleStarRanges(handler,
+                                        m_ranges,
+                                        obsPosition,
+                                        obsOrientation,
+                                        fovY,
+                                        aspectRatio,
+                                        limitingMag,
+                                        minRangeDistance,
+                                        labelMag);
+    }
+
+    auto processStar = [&](engine::OctreeObjectIndex index)
+    {
+        const Star* star = m_starDB->getStar(index);
+        float distance = (star->getPosition() - obsPosition).norm();
+        float appMag = star->getApparentMagnitude(distance);
+        if (appMag <= limitingMag)
+            handler.process(*star, distance, appMag);
+    };
+
+    // The stars left out of the ranges of the buffer: the ones with an orbit,
+    // and the members of the clusters which aren't drawn from their block
+    for (const auto& range : m_ranges)
+    {
+        auto it = std::lower_bound(m_orbitingStars.begin(), m_orbitingStars.end(), range.first);
+        for (; it != m_orbitingStars.end() && *it < range.last; ++it)
+            processStar(*it);
+
+        auto first = std::lower_bound(m_memberStars.begin(), m_memberStars.end(), range.first);
+        for (auto member = first; member != m_memberStars.end() && *member < range.last; ++member)
+        {
+            if (!m_activeClusters[m_memberClusters[member - m_memberStars.begin()]])
+                processStar(*member);
+        }
+    }
+
+    m_ranges.insert(m_ranges.end(), m_clusterRanges.begin(), m_clusterRanges.end());
+}
+
+void
+GPUStarRenderer::updateClusters(const Eigen::Vector3f& obsPosition,
+                                const Eigen::Quaternionf& obsOrientation,
+                                float fovY,
+                                float aspectRatio,
+                                float limitingMag,
+                                float labelMag,
+                                float minRangeDistance)
+{
+    m_clusterRanges.clear();
+    m_anyActiveCluster = false;
+    if (m_clusters.empty())
+        return;
+
+    Eigen::Vector3f viewDirection = obsOrientation.conjugate() * -Eigen::Vector3f::UnitZ();
+    float halfDiagonal = std::atan(std::tan(fovY * 0.5f) * std::sqrt(1.0f + aspectRatio * aspectRatio));
+
+    for (std::size_t i = 0; i < m_clusters.size(); ++i)
+    {
+        const Cluster& cluster = m_clusters[i];
+        Eigen::Vector3f offset = cluster.center - obsPosition;
+        float distance = offset.norm();
+
+        // Like the nodes drawn as ranges, a cluster is drawn from its block
+        // when it is far away and has no star bright enough to be labeled
+        float nearDistance = distance - cluster.radius;
+        float brightestAppMag = nearDistance > 0.0f
+            ? astro::absToAppMag(cluster.brightestMag, nearDistance)
+            : -std::numeric_limits<float>::infinity();
+        bool active = nearDistance >= minRangeDistance && brightestAppMag > labelMag;
+        m_activeClusters[i] = active;
+        if (!active)
+            continue;
+
+        m_anyActiveCluster = true;
+        if (brightestAppMag > limitingMag)
+            continue;
+
+        float angle = std::acos(std::clamp(offset.dot(viewDirection) / distance, -1.0f, 1.0f));
+        if (angle <= halfDiagonal + std::asin(cluster.radius / distance))
+            m_clusterRanges.push_back(cluster.block);
+    }
+}
+
+bool
+GPUStarRenderer::isActiveMember(engine::OctreeObjectIndex index) const
+{
+    auto it = std::lower_bound(m_memberStars.begin(), m_memberStars.end(), index);
+    return it != m_memberStars.end() && *it == index &&
+           m_activeClusters[m_memberClusters[it - m_memberStars.begin()]];
+}
+
+void
+GPUStarRenderer::render(const Parameters& params)
+{
+    if (m_ranges.empty())
+        return;
+
+    CelestiaGLProgram* prog = m_renderer.getShaderManager().getShader("gpustar");
+    if (prog == nullptr)
+        return;
+
+    prog->use();
+    prog->setMVPMatrices(m_renderer.getCurrentProjectionMatrix(), m_renderer.getCurrentModelViewMatrix());
+    prog->vec3Param("obsPosition") = params.obsPosition;
+    prog->floatParam("limitingMag") = params.limitingMag;
+    prog->floatParam("faintestMag") = params.faintestMag;
+    prog->floatParam("brightnessScale") = params.brightnessScale;
+    prog->floatParam("brightnessBias") = params.brightnessBias;
+    prog->floatParam("satPoint") = params.satPoint;
+    prog->floatParam("discSize") = params.discSize;
+    prog->floatParam("pointScale") = params.pointScale;
+    prog->floatParam("distanceLimit") = params.distanceLimit;
+    prog->intParam("starStyle") = static_cast<int>(params.starStyle);
+    prog->floatParam("colorTempScale") = m_colorTempScale;
+    prog->floatParam("colorCount") = m_colorCount;
+    prog->samplerParam("starTex") = PSFTextureUnit;
+    prog->samplerParam("colorTex") = ColorTextureUnit;
+
+    glActiveTexture(GL_TEXTURE0 + ColorTextureUnit);
+    m_colorTexture->bind();
+    glActiveTexture(GL_TEXTURE0 + PSFTextureUnit);
+    params.psfTexture->bind();
+
+    // Glare first, so that the star discs are drawn over it
+    prog->intParam("glare") = 1;
+    prog->intParam("textured") = 1;
+    prog->floatParam("psfCell") = starPSFCell(StarPSF::Glare);
+    for (const auto& range : m_ranges)
+        m_vo.draw(static_cast<int>(range.last - range.first), static_cast<int>(range.first));
+
+    prog->intParam("glare") = 0;
+    prog->intParam("textured") = params.starStyle == StarStyle::PointStars ? 0 : 1;
+    prog->floatParam("psfCell") = starPSFCell(StarPSF::Disc);
+    for (const auto& range : m_ranges)
+        m_vo.draw(static_cast<int>(range.last - range.first), static_cast<int>(range.first));
+}
+
+} // end namespace celestia::render
@@ -0,0 +1,158 @@
+// gpustarrenderer.h
+//
+// Copyright (C) 2024, Celestia Development Team
+//
+// Draw the distant stars of the star catalog from a vertex buffer which holds
+// the whole catalog.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+
+#include <celengine/starcolors.h>
+#include <celengine/staroctree.h>
+#include <celrender/gl/buffer.h>
+#include <celrender/gl/vertexobject.h>
+
+class DSODatabase;
+class Renderer;
+class StarDatabase;
+class Texture;
+enum class StarStyle : int;
+
+namespace celestia::render
+{
+
+// The stars are uploaded once, in octree order, so that the stars of an
+// octree node are a contiguous range of the buffer. During traversal the
+// nodes which are far away and too faint to contain labeled stars are
+// collected as ranges instead of being processed star by star, and the
+// vertex shader computes the apparent magnitude and point size of each star
+// in them and discards the ones fainter than the limiting magnitude.
+//
+// Stars with an orbit are left out of the buffer, as their position changes
+// with time, and passed to the handler like the stars of the other nodes.
+//
+// The members of each open cluster are also copied to a contiguous block at
+// the end of the buffer. While a cluster is far and faint enough that its
+// nodes would be drawn as ranges, its block is drawn when it is in view and
+// its members are neither drawn from the ranges nor passed to the handler.
+class GPUStarRenderer
+{
+public:
+    struct Parameters
+    {
+        Eigen::Vector3f obsPosition;
+        float limitingMag;
+        float faintestMag;
+        float brightnessScale;
+        float brightnessBias;
+        float satPoint;
+        float discSize;
+        float pointScale;
+        float distanceLimit;
+        StarStyle starStyle;
+        // The star PSF atlas
+        Texture* psfTexture;
+    };
+
+    explicit GPUStarRenderer(const Renderer&);
+    ~GPUStarRenderer();
+
+    GPUStarRenderer(const GPUStarRenderer&) = delete;
+    GPUStarRenderer& operator=(const GPUStarRenderer&) = delete;
+    GPUStarRenderer(GPUStarRenderer&&) = delete;
+    GPUStarRenderer& operator=(GPUStarRenderer&&) = delete;
+
+    // Upload the stars if the databases changed, and the color table if it
+    // changed. Returns false if the GPU path can't be used.
+    bool prepare(const StarDatabase&, const DSODatabase*, const ColorTemperatureTable&);
+
+    // Find the visible stars, passing the near and bright ones to the handler
+    // and keeping the ranges of the others for render.
+    void findVisibleStars(engine::StarHandler&,
+                          const Eigen::Vector3f& obsPosition,
+                          const Eigen::Quaternionf& obsOrientation,
+                          float fovY,
+                          float aspectRatio,
+                          float limitingMag,
+                          float labelMag);
+
+    // Draw the star ranges found by the last call to findVisibleStars. The
+    // point star vertex buffers must be enabled.
+    void render(const Parameters&);
+
+private:
+    // The color is looked up by the shaders from the temperature, so that
+    // the stars needn't be uploaded again when the color table changes
+    struct StarVertex
+    {
+        Eigen::Vector3f position;
+        float absMag;
+        float extinction;
+        // Kelvin, clamped to the range of the type
+        std::uint16_t temperature;
+    };
+
+    struct Cluster
+    {
+        Eigen::Vector3f center;
+        float radius;
+        float brightestMag;
+        engine::StarOctreeObjectRange block;
+    };
+
+    class MemberFilter;
+
+    void upload(const StarDatabase&, const DSODatabase*);
+    void uploadColors(const ColorTemperatureTable&);
+    void updateClusters(const Eigen::Vector3f& obsPosition,
+                        const Eigen::Quaternionf& obsOrientation,
+                        float fovY,
+                        float aspectRatio,
+                        float limitingMag,
+                        float labelMag,
+                        float minRangeDistance);
+    bool isActiveMember(engine::OctreeObjectIndex) const;
+
+    const Renderer& m_renderer;
+
+    const StarDatabase* m_starDB{ nullptr };
+    std::uint32_t m_starCount{ 0 };
+    const DSODatabase* m_dsoDB{ nullptr };
+    std::uint32_t m_dsoCount{ 0 };
+    ColorTableType m_colorType{ ColorTableType::Blackbody_D65 };
+    std::unique_ptr<Texture> m_colorTexture;
+    float m_colorTempScale{ 0.0f };
+    float m_colorCount{ 0.0f };
+
+    gl::Buffer m_bo{ util::NoCreateT{} };
+    gl::VertexObject m_vo{ util::NoCreateT{} };
+
+    // Sorted indices of the stars with an orbit
+    std::vector<engine::OctreeObjectIndex> m_orbitingStars;
+    std::vector<engine::StarOctreeObjectRange> m_ranges;
+
+    std::vector<Cluster> m_clusters;
+    // Sorted indices of the cluster members, and the index of their cluster
+    std::vector<engine::OctreeObjectIndex> m_memberStars;
+    std::vector<std::uint32_t> m_memberClusters;
+    // Whether the members of each cluster are drawn from its block, for the
+    // last call to findVisibleStars
+    std::vector<bool> m_activeClusters;
+    bool m_anyActiveCluster{ false };
+    // Blocks of the active clusters in view
+    std::vector<engine::StarOctreeObjectRange> m_clusterRanges;
+};
+
+} // end namespace celestia::render
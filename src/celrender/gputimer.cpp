@@ -0,0 +1,91 @@
+// gputimer.cpp
+//
+// Copyright (C) 2024, Celestia Development Team
+//
+// Measures the time spent by the GPU with timer queries.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include "gputimer.h"
+
+namespace celestia::render
+{
+
+GPUTimer::~GPUTimer()
+{
+#ifndef GL_ES
+    if (m_queries[0] != 0)
+        glDeleteQueries(static_cast<GLsizei>(QueryCount), m_queries.data());
+#endif
+}
+
+bool
+GPUTimer::isSupported()
+{
+#ifdef GL_ES
+    return false;
+#else
+    return gl::ARB_timer_query || gl::checkVersion(gl::GL_3_3);
+#endif
+}
+
+void
+GPUTimer::begin()
+{
+#ifndef GL_ES
+    if (m_active || !isSupported())
+        return;
+
+    if (m_queries[0] == 0)
+        glGenQueries(static_cast<GLsizei>(QueryCount), m_queries.data());
+
+    if (m_pending[m_next])
+        return;
+
+    glBeginQuery(GL_TIME_ELAPSED, m_queries[m_next]);
+    m_active = true;
+#endif
+}
+
+void
+GPUTimer::end()
+{
+#ifndef GL_ES
+    if (!m_active)
+        return;
+
+    glEndQuery(GL_TIME_ELAPSED);
+    m_pending[m_next] = true;
+    m_next = (m_next + 1) % QueryCount;
+    m_active = false;
+#endif
+}
+
+std::optional<std::chrono::nanoseconds>
+GPUTimer::collect()
+{
+    std::optional<std::chrono::nanoseconds> total;
+#ifndef GL_ES
+    for (std::size_t i = 0; i < QueryCount; ++i)
+    {
+        if (!m_pending[i])
+            continue;
+
+        GLint available = GL_FALSE;
+        glGetQueryObjectiv(m_queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available == GL_FALSE)
+            continue;
+
+        GLuint64 elapsed = 0;
+        glGetQueryObjectui64v(m_queries[i], GL_QUERY_RESULT, &elapsed);
+        total = total.value_or(std::chrono::nanoseconds::zero()) + std::chrono::nanoseconds(elapsed);
+        m_pending[i] = false;
+    }
+#endif
+    return total;
+}
+
+} // end namespace celestia::render
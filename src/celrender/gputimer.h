@@ -0,0 +1,58 @@
+// gputimer.h
+//
+// Copyright (C) 2024, Celestia Development Team
+//
+// Measures the time spent by the GPU with timer queries.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <optional>
+
+#include <celengine/glsupport.h>
+
+namespace celestia::render
+{
+
+// A few queries are used in turn, so that the result of a query is only
+// read once it is available and the pipeline isn't stalled. Intervals may
+// not be nested.
+class GPUTimer
+{
+public:
+    GPUTimer() = default;
+    ~GPUTimer();
+
+    GPUTimer(const GPUTimer&) = delete;
+    GPUTimer& operator=(const GPUTimer&) = delete;
+    GPUTimer(GPUTimer&&) = delete;
+    GPUTimer& operator=(GPUTimer&&) = delete;
+
+    static bool isSupported();
+
+    // Start timing the commands which follow. Nothing is measured if all
+    // the queries are still pending.
+    void begin();
+    void end();
+
+    // Total time of the intervals whose results became available since the
+    // previous call, or nothing if none did
+    std::optional<std::chrono::nanoseconds> collect();
+
+private:
+    static constexpr std::size_t QueryCount = 4;
+
+    std::array<GLuint, QueryCount> m_queries{ };
+    std::array<bool, QueryCount> m_pending{ };
+    std::size_t m_next{ 0 };
+    bool m_active{ false };
+};
+
+} // end namespace celestia::render
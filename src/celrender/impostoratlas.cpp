@@ -0,0 +1,344 @@
+// impostoratlas.cpp
+//
+// Copyright (C) 2025, Celestia Development Team
+//
+// Sprite images standing in for deep sky objects which are small on screen.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include "impostoratlas.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include <celcompat/numbers.h>
+#include <celengine/render.h>
+#include <celengine/shadermanager.h>
+#include <celmath/geomutil.h>
+#include <celutil/array_view.h>
+#include <celutil/logger.h>
+
+using celestia::util::GetLogger;
+
+namespace celestia::render
+{
+
+namespace
+{
+
+constexpr int AtlasWidth = ImpostorAtlas::DirectionColumns * ImpostorAtlas::TileSize;
+constexpr int AtlasHeight = ImpostorAtlas::DirectionRows * ImpostorAtlas::TileSize;
+
+// Rendering the images is spread over frames, as many objects of a form
+// first seen at once would stall a frame
+constexpr std::size_t MaxTilesPerFrame = 4;
+
+} // end unnamed namespace
+
+ImpostorAtlas::ImpostorAtlas(Renderer& renderer, RenderFunction&& renderFunction) :
+    m_renderer(renderer),
+    m_renderFunction(std::move(renderFunction))
+{
+}
+
+ImpostorAtlas::~ImpostorAtlas()
+{
+    for (const auto& form : m_forms)
+    {
+        if (form.texture != 0)
+            glDeleteTextures(1, &form.texture);
+    }
+
+    if (m_fbo != 0)
+        glDeleteFramebuffers(1, &m_fbo);
+}
+
+bool
+ImpostorAtlas::isSupported() const
+{
+    return !m_invalid && !m_renderer.getShaderManager().isFisheyeEnabled();
+}
+
+const std::array<Eigen::Matrix3f, ImpostorAtlas::DirectionCount>&
+ImpostorAtlas::getFrames()
+{
+    // Spread the directions evenly over the sphere along a Fibonacci spiral
+    static const std::array<Eigen::Matrix3f, DirectionCount> frames = []
+    {
+        const float goldenAngle = numbers::pi_v<float> * (3.0f - std::sqrt(5.0f));
+
+        std::array<Eigen::Matrix3f, DirectionCount> result;
+        for (int i = 0; i < DirectionCount; ++i)
+        {
+            float y = 1.0f - (2.0f * static_cast<float>(i) + 1.0f) / static_cast<float>(DirectionCount);
+            float r = std::sqrt(1.0f - y * y);
+            float phi = goldenAngle * static_cast<float>(i);
+            Eigen::Vector3f direction(r * std::cos(phi), y, r * std::sin(phi));
+
+            Eigen::Vector3f up = std::abs(direction.y()) < 0.9f ? Eigen::Vector3f::UnitY() : Eigen::Vector3f::UnitZ();
+            Eigen::Vector3f right = up.cross(direction).normalized();
+            up = direction.cross(right);
+
+            result[i].row(0) = right;
+            result[i].row(1) = up;
+            result[i].row(2) = direction;
+        }
+        return result;
+    }();
+
+    return frames;
+}
+
+int
+ImpostorAtlas::findDirection(const Eigen::Vector3f& direction)
+{
+    const auto& frames = getFrames();
+    int closest = 0;
+    float closestDot = -2.0f;
+    for (int i = 0; i < DirectionCount; ++i)
+    {
+        if (float dot = frames[i].row(2).dot(direction); dot > closestDot)
+        {
+            closest = i;
+            closestDot = dot;
+        }
+    }
+
+    return closest;
+}
+
+ImpostorAtlas::Form&
+ImpostorAtlas::getForm(int form)
+{
+    if (form >= static_cast<int>(m_forms.size()))
+        m_forms.resize(static_cast<std::size_t>(form) + 1);
+    return m_forms[form];
+}
+
+bool
+ImpostorAtlas::add(int form,
+                   const Eigen::Vector3f& offset,
+                   const Eigen::Matrix3f& rotation,
+                   float scale,
+                   float extent,
+                   float opacity)
+{
+    if (!isSupported() || form < 0)
+        return false;
+
+    float distance = offset.norm();
+    if (distance == 0.0f)
+        return false;
+
+    int direction = findDirection(rotation.transpose() * (-offset / distance));
+
+    Form& f = getForm(form);
+    f.extent = extent;
+    if (!f.rendered[direction])
+    {
+        if (!f.requested[direction])
+        {
+            f.requested[direction] = true;
+            m_requests.emplace_back(form, direction);
+        }
+        return false;
+    }
+
+    const Eigen::Matrix3f& frame = getFrames()[direction];
+    Eigen::Vector3f right = rotation * frame.row(0).transpose() * (scale * extent);
+    Eigen::Vector3f up = rotation * frame.row(1).transpose() * (scale * extent);
+
+    auto column = static_cast<float>(direction % DirectionColumns);
+    auto row = static_cast<float>(direction / DirectionColumns);
+    auto vertex = [&](float s, float t)
+    {
+        return QuadVertex
+        {
+            offset + s * right + t * up,
+            Eigen::Vector2f((column + 0.5f * (s + 1.0f)) / static_cast<float>(DirectionColumns),
+                            (row + 0.5f * (t + 1.0f)) / static_cast<float>(DirectionRows)),
+            opacity,
+        };
+    };
+
+    // Counterclockwise seen from the direction of the image
+    f.vertices.push_back(vertex(-1.0f, -1.0f));
+    f.vertices.push_back(vertex( 1.0f, -1.0f));
+    f.vertices.push_back(vertex( 1.0f,  1.0f));
+    f.vertices.push_back(vertex(-1.0f, -1.0f));
+    f.vertices.push_back(vertex( 1.0f,  1.0f));
+    f.vertices.push_back(vertex(-1.0f,  1.0f));
+    return true;
+}
+
+void
+ImpostorAtlas::renderTiles()
+{
+    if (m_requests.empty() || m_invalid)
+        return;
+
+    if (m_fbo == 0)
+        glGenFramebuffers(1, &m_fbo);
+
+    GLint oldFbo;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &oldFbo);
+    std::array<int, 4> viewport;
+    m_renderer.getViewport(viewport);
+
+    // The tiles are drawn with the conventional depth range
+    bool reverseDepth = m_renderer.usesReverseDepth();
+    if (reverseDepth)
+        m_renderer.setReverseDepthState(false);
+
+    Renderer::PipelineState ps;
+    ps.blending = true;
+    ps.blendFunc = {GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA};
+    m_renderer.setPipelineState(ps);
+
+    // Keep the coverage in the alpha channel too, as the image is blended
+    // over the scene later
+    glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+
+    const std::size_t count = std::min(m_requests.size(), MaxTilesPerFrame);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        const auto [form, direction] = m_requests[i];
+        Form& f = m_forms[form];
+
+        if (f.texture == 0)
+        {
+            // Start from a transparent texture, as only one tile is drawn
+            // at a time
+            std::vector<std::uint8_t> pixels(static_cast<std::size_t>(AtlasWidth) * AtlasHeight * 4, 0);
+            glGenTextures(1, &f.texture);
+            glBindTexture(GL_TEXTURE_2D, f.texture);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+#ifdef GL_ES
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, AtlasWidth, AtlasHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+#else
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, AtlasWidth, AtlasHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+#endif
+            glBindTexture(GL_TEXTURE_2D, 0);
+        }
+
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, f.texture, 0);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        {
+            // Don't retry every frame
+            GetLogger()->warn("Unable to create the impostor framebuffer\n");
+            m_invalid = true;
+            break;
+        }
+
+        glViewport((direction % DirectionColumns) * TileSize,
+                   (direction / DirectionColumns) * TileSize,
+                   TileSize, TileSize);
+
+        Eigen::Matrix4f projection = math::Ortho(-f.extent, f.extent, -f.extent, f.extent,
+                                                 -2.0f * f.extent, 2.0f * f.extent);
+        Eigen::Matrix4f modelView = Eigen::Matrix4f::Identity();
+        const Eigen::Matrix3f& frame = getFrames()[direction];
+        modelView.topLeftCorner<3, 3>() = frame;
+
+        m_renderFunction(form, projection, modelView, frame.transpose());
+        f.rendered[direction] = true;
+    }
+
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, oldFbo);
+    m_requests.erase(m_requests.begin(), m_requests.begin() + static_cast<std::ptrdiff_t>(count));
+
+    // Back to the blending the renderer has cached
+    glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ZERO, GL_ONE);
+    m_renderer.setViewport(viewport);
+    if (reverseDepth)
+        m_renderer.setReverseDepthState(true);
+}
+
+void
+ImpostorAtlas::render(const Eigen::Matrix4f& projection, const Eigen::Matrix4f& modelView)
+{
+    renderTiles();
+
+    std::vector<QuadVertex> vertices;
+    for (const auto& form : m_forms)
+        vertices.insert(vertices.end(), form.vertices.begin(), form.vertices.end());
+    if (vertices.empty())
+        return;
+
+    auto* prog = m_renderer.getShaderManager().getShader("impostor");
+    if (prog == nullptr)
+    {
+        for (auto& form : m_forms)
+            form.vertices.clear();
+        return;
+    }
+
+    if (m_vo.id() == 0 && m_bo.id() == 0)
+    {
+        m_bo = gl::Buffer(gl::Buffer::TargetHint::Array);
+        m_vo = gl::VertexObject(gl::VertexObject::Primitive::Triangles);
+        m_vo.addVertexBuffer(m_bo,
+                             CelestiaGLProgram::VertexCoordAttributeIndex,
+                             3,
+                             gl::VertexObject::DataType::Float,
+                             false,
+                             sizeof(QuadVertex),
+                             offsetof(QuadVertex, position));
+        m_vo.addVertexBuffer(m_bo,
+                             CelestiaGLProgram::TextureCoord0AttributeIndex,
+                             2,
+                             gl::VertexObject::DataType::Float,
+                             false,
+                             sizeof(QuadVertex),
+                             offsetof(QuadVertex, texCoord));
+        m_vo.addVertexBuffer(m_bo,
+                             CelestiaGLProgram::IntensityAttributeIndex,
+                             1,
+                             gl::VertexObject::DataType::Float,
+                             false,
+                             sizeof(QuadVertex),
+                             offsetof(QuadVertex, opacity));
+    }
+
+    m_bo.setData(util::array_view<const void>(vertices.data(), sizeof(QuadVertex) * vertices.size()),
+                 gl::Buffer::BufferUsage::StreamDraw);
+
+    // The images have premultiplied alpha
+    Renderer::PipelineState ps;
+    ps.blending = true;
+    ps.blendFunc = {GL_ONE, GL_ONE_MINUS_SRC_ALPHA};
+    m_renderer.setPipelineState(ps);
+
+    prog->use();
+    prog->setMVPMatrices(projection, modelView);
+    prog->samplerParam("tex") = 0;
+    glActiveTexture(GL_TEXTURE0);
+
+    int first = 0;
+    for (auto& form : m_forms)
+    {
+        if (form.vertices.empty())
+            continue;
+
+        auto count = static_cast<int>(form.vertices.size());
+        glBindTexture(GL_TEXTURE_2D, form.texture);
+        m_vo.draw(count, first);
+        first += count;
+        form.vertices.clear();
+    }
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+} // end namespace celestia::render
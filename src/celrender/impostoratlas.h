@@ -0,0 +1,125 @@
+// impostoratlas.h
+//
+// Copyright (C) 2025, Celestia Development Team
+//
+// Sprite images standing in for deep sky objects which are small on screen.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <array>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include <Eigen/Core>
+
+#include <celengine/glsupport.h>
+#include <celrender/gl/buffer.h>
+#include <celrender/gl/vertexobject.h>
+
+class Renderer;
+
+namespace celestia::render
+{
+
+// The ImpostorAtlas holds images of the forms of an object type, each one
+// rendered once for each of a set of directions of view, the first time it
+// is needed. Objects too small on screen to be worth drawing in full are
+// drawn instead as a quad with the image of the closest direction, in one
+// draw per form.
+//
+// The images are stored with premultiplied alpha, and are scaled by the
+// opacity of each quad, so that they stand in for forms drawn with blending
+// of small alpha values, whose result is close to linear in the alpha.
+class ImpostorAtlas
+{
+public:
+    // The images of a form are tiles of one texture of DirectionColumns by
+    // DirectionRows tiles of TileSize pixels
+    static constexpr int DirectionColumns = 8;
+    static constexpr int DirectionRows = 4;
+    static constexpr int DirectionCount = DirectionColumns * DirectionRows;
+    static constexpr int TileSize = 64;
+
+    // Draw the form into the tile bound as the viewport. The matrices map
+    // the form, in its own units, to the tile; viewMat has the right, up
+    // and view direction of the tile in the frame of the form as columns,
+    // to orient sprites. Blending is set up for the tile, so the function
+    // should leave the pipeline state alone.
+    using RenderFunction = std::function<void(int form,
+                                              const Eigen::Matrix4f& projection,
+                                              const Eigen::Matrix4f& modelView,
+                                              const Eigen::Matrix3f& viewMat)>;
+
+    ImpostorAtlas(Renderer&, RenderFunction&&);
+    ~ImpostorAtlas();
+
+    ImpostorAtlas(const ImpostorAtlas&) = delete;
+    ImpostorAtlas& operator=(const ImpostorAtlas&) = delete;
+    ImpostorAtlas(ImpostorAtlas&&) = delete;
+    ImpostorAtlas& operator=(ImpostorAtlas&&) = delete;
+
+    // Rendering the images needs framebuffer objects, and forms drawn
+    // with the fisheye projection can't be mapped to a tile
+    bool isSupported() const;
+
+    // Queue a quad centered on the object at the offset from the observer.
+    // The rotation maps the frame of the form to the world frame, and the
+    // scale the units of the form to world units. The extent, in units of
+    // the form, is half the width of the image, which must cover the form
+    // drawn with its sprites; it is expected to be the same for every
+    // object of the form. Returns false if the image isn't ready yet, in
+    // which case it is rendered by the next call to render and the object
+    // should be drawn in full for this frame.
+    bool add(int form,
+             const Eigen::Vector3f& offset,
+             const Eigen::Matrix3f& rotation,
+             float scale,
+             float extent,
+             float opacity);
+
+    // Render the images requested since the last call, then draw the
+    // queued quads
+    void render(const Eigen::Matrix4f& projection, const Eigen::Matrix4f& modelView);
+
+private:
+    struct QuadVertex
+    {
+        Eigen::Vector3f position;
+        Eigen::Vector2f texCoord;
+        float           opacity;
+    };
+
+    struct Form
+    {
+        GLuint texture{ 0 };
+        float extent{ 1.0f };
+        std::array<bool, DirectionCount> rendered{ };
+        std::array<bool, DirectionCount> requested{ };
+        std::vector<QuadVertex> vertices;
+    };
+
+    static int findDirection(const Eigen::Vector3f&);
+    static const std::array<Eigen::Matrix3f, DirectionCount>& getFrames();
+
+    Form& getForm(int);
+    void renderTiles();
+
+    Renderer& m_renderer;
+    RenderFunction m_renderFunction;
+    std::vector<Form> m_forms;
+    std::vector<std::pair<int, int>> m_requests;
+
+    GLuint m_fbo{ 0 };
+    bool m_invalid{ false };
+
+    gl::Buffer m_bo{ util::NoCreateT{} };
+    gl::VertexObject m_vo{ util::NoCreateT{} };
+};
+
+} // end namespace celestia::render
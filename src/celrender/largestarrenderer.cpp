@@ -22,6 +22,7 @@ LargeStarRenderer::render(
     const Eigen::Vector3f &position,
     const Color           &color,
     float                  size,
+    StarPSF                psf,
     const Matrices        &mvp)
 {
     auto *prog = m_renderer.getShaderManager().getShader("largestar");
@@ -37,6 +38,7 @@ LargeStarRenderer::render(
     // Draw billboard for large points
     prog->use();
     prog->samplerParam("starTex") = 0;
+    prog->floatParam("psfCell") = starPSFCell(psf);
     prog->setMVPMatrices(*mvp.projection, *mvp.modelview);
     prog->vec4Param("color") = color.toVector4();
     prog->vec3Param("center") = position;
@@ -3,6 +3,8 @@
 #include <memory>
 #include <Eigen/Core>
 
+#include "starpsf.h"
+
 class Color;
 class Renderer;
 struct Matrices;
@@ -25,7 +27,8 @@ public:
     explicit LargeStarRenderer(Renderer &renderer);
     ~LargeStarRenderer();
 
-    void render(const Eigen::Vector3f &position, const Color &color, float size, const Matrices &mvp);
+    // The star PSF atlas must be bound
+    void render(const Eigen::Vector3f &position, const Color &color, float size, StarPSF psf, const Matrices &mvp);
 
 private:
     void initialize();
@@ -11,6 +11,7 @@
 
 #include "linerenderer.h"
 
+#include <algorithm>
 #include <array>
 #include <cstddef>
 
@@ -23,6 +24,23 @@
 namespace celestia::render
 {
 
+namespace
+{
+
+// The corners of the two triangles drawn for each instanced segment: the
+// end of the segment, 0 or 1, and the side of the line
+constexpr std::array<float, 12> SegmentCorners
+{
+    0.0f, -0.5f,
+    0.0f,  0.5f,
+    1.0f, -0.5f,
+    1.0f, -0.5f,
+    1.0f,  0.5f,
+    0.0f, -0.5f,
+};
+
+} // end unnamed namespace
+
 LineRenderer::~LineRenderer() = default;
 
 /**
@@ -90,6 +108,8 @@ LineRenderer::setup_shader()
         props.lightModel = LightingModel::UnlitModel;
         if (m_useTriangles)
             props.texUsage |= TexUsage::LineAsTriangles;
+        if (m_useInstances)
+            props.texUsage |= TexUsage::LineInstances;
         if ((m_hints & DISABLE_FISHEYE_TRANFORMATION) != 0)
             props.fishEyeOverride = FisheyeOverrideMode::Disabled;
         m_prog = m_renderer.getShaderManager().getShader(props);
@@ -110,14 +130,29 @@ LineRenderer::setup_shader()
     }
 }
 
-//! Allocate GPU memory for vertices and define its layout.
+//! Allocate GPU memory for vertices, or update it unless it is static.
+void
+LineRenderer::upload_vertices()
+{
+    if (m_lnBO == nullptr)
+    {
+        m_lnBO = std::make_unique<gl::Buffer>();
+        if (m_storageType == StorageType::Static)
+            m_lnBO->setStorage(m_vertices);
+        else
+            m_lnBO->setData(m_vertices, static_cast<gl::Buffer::BufferUsage>(m_storageType));
+    }
+    else if (m_storageType != StorageType::Static)
+    {
+        m_lnBO->invalidateData().setData(m_vertices);
+    }
+}
+
+//! Define the layout of vertices.
 void
 LineRenderer::create_vbo_lines()
 {
     m_lnVO = std::make_unique<gl::VertexObject>();
-    m_lnBO = std::make_unique<gl::Buffer>();
-
-    m_lnBO->setData(m_vertices, static_cast<gl::Buffer::BufferUsage>(m_storageType));
 
     m_lnVO->addVertexBuffer(
         *m_lnBO,
@@ -145,16 +180,54 @@ LineRenderer::create_vbo_lines()
 void
 LineRenderer::setup_vbo_lines()
 {
-    if (m_lnVO != nullptr)
-    {
-        if (m_storageType != StorageType::Static)
-        {
-            m_lnBO->invalidateData().setData(m_vertices);
-        }
-    }
-    else
-    {
+    upload_vertices();
+    if (m_lnVO == nullptr)
         create_vbo_lines();
+}
+
+//! Define the layout of segments drawn as instances, which use the vertices as they are.
+void
+LineRenderer::create_vbo_instances()
+{
+    m_inVO = std::make_unique<gl::VertexObject>(gl::VertexObject::Primitive::Triangles);
+    m_cornerBO = std::make_unique<gl::Buffer>();
+    m_cornerBO->setStorage(SegmentCorners);
+
+    m_inVO->addVertexBuffer(
+        *m_cornerBO,
+        CelestiaGLProgram::LineCornerAttributeIndex,
+        2,
+        gl::VertexObject::DataType::Float);
+
+    // Segments of a strip share their end points
+    auto stride = static_cast<int>(m_primType == PrimType::Lines ? 2 * sizeof(Vertex) : sizeof(Vertex));
+    m_inVO->addInstanceBuffer(
+        *m_lnBO,
+        CelestiaGLProgram::VertexCoordAttributeIndex,
+        pos_count(),
+        gl::VertexObject::DataType::Float,
+        false,
+        stride,
+        offsetof(Vertex, pos));
+    m_inVO->addInstanceBuffer(
+        *m_lnBO,
+        CelestiaGLProgram::NextVCoordAttributeIndex,
+        pos_count(),
+        gl::VertexObject::DataType::Float,
+        false,
+        stride,
+        sizeof(Vertex) + offsetof(Vertex, pos));
+
+    if (color_count() != 0)
+    {
+        m_inVO->addInstanceBuffer(
+            *m_lnBO,
+            CelestiaGLProgram::ColorAttributeIndex,
+            color_count(),
+            color_type() == VF_UBYTE ? gl::VertexObject::DataType::UnsignedByte : gl::VertexObject::DataType::Float,
+            color_type() == VF_UBYTE,
+            stride,
+            offsetof(Vertex, color));
     }
 }
 
@@ -178,7 +251,10 @@ LineRenderer::create_vbo_triangles()
             offsetof(LineSegment, point1) + offsetof(Vertex, color)
         };
 
-        m_trBO->setData(m_segments, static_cast<gl::Buffer::BufferUsage>(m_storageType));
+        if (m_storageType == StorageType::Static)
+            m_trBO->setStorage(m_segments);
+        else
+            m_trBO->setData(m_segments, static_cast<gl::Buffer::BufferUsage>(m_storageType));
         m_segments.clear();
     }
     else
@@ -192,7 +268,10 @@ LineRenderer::create_vbo_triangles()
             offsetof(LineVertex, point) + offsetof(Vertex, color)
         };
 
-        m_trBO->setData(m_verticesTr, static_cast<gl::Buffer::BufferUsage>(m_storageType));
+        if (m_storageType == StorageType::Static)
+            m_trBO->setStorage(m_verticesTr);
+        else
+            m_trBO->setData(m_verticesTr, static_cast<gl::Buffer::BufferUsage>(m_storageType));
         m_verticesTr.clear();
     }
     m_trVO->addVertexBuffer(
@@ -262,10 +341,20 @@ LineRenderer::setup_vbo_triangles()
 void
 LineRenderer::setup_vbo()
 {
-    if (!m_useTriangles)
+    if (m_useInstances)
+    {
+        upload_vertices();
+        if (m_inVO == nullptr)
+            create_vbo_instances();
+    }
+    else if (!m_useTriangles)
+    {
         setup_vbo_lines();
+    }
     else
+    {
         setup_vbo_triangles();
+    }
 }
 
 //! Add new triagles for a line segment (when primitive is Lines).
@@ -388,6 +477,17 @@ LineRenderer::should_triangulate() const
     return rasterized_width() > celestia::gl::maxLineWidth;
 }
 
+bool
+LineRenderer::should_use_instances() const
+{
+#ifdef GL_ES
+    return false;
+#else
+    // A loop would need its first vertex again after the last one
+    return m_primType != PrimType::LineLoop && celestia::gl::ARB_base_instance && celestia::gl::hasInstancing();
+#endif
+}
+
 float
 LineRenderer::width_multiplyer() const
 {
@@ -415,7 +515,8 @@ LineRenderer::startUpdate()
     if (m_storageType != StorageType::Static)
     {
         m_useTriangles = should_triangulate();
-        m_verticesTriangulated = m_useTriangles && m_primType != PrimType::Lines && (m_hints & PREFER_SIMPLE_TRIANGLES) == 0;
+        m_useInstances = m_useTriangles && should_use_instances();
+        m_verticesTriangulated = m_useTriangles && !m_useInstances && m_primType != PrimType::Lines && (m_hints & PREFER_SIMPLE_TRIANGLES) == 0;
     }
 }
 
@@ -441,6 +542,17 @@ LineRenderer::orphan() const
         m_trBO->invalidateData();
 }
 
+void
+LineRenderer::invalidate()
+{
+    m_lnVO = nullptr;
+    m_lnBO = nullptr;
+    m_trVO = nullptr;
+    m_trBO = nullptr;
+    m_inVO = nullptr;
+    m_cornerBO = nullptr;
+}
+
 void
 LineRenderer::finish()
 {
@@ -455,9 +567,14 @@ LineRenderer::finish()
 void
 LineRenderer::prerender()
 {
-    m_useTriangles = m_useTriangles || should_triangulate();
+    // Static lines decide once they are first drawn
+    if (!m_useTriangles && should_triangulate())
+    {
+        m_useTriangles = true;
+        m_useInstances = should_use_instances();
+    }
 
-    if (m_useTriangles)
+    if (m_useTriangles && !m_useInstances)
         triangulate_and_segment();
 
     setup_vbo();
@@ -474,7 +591,14 @@ LineRenderer::render(const Matrices &mvp, int count, int offset)
 
     m_prog->setMVPMatrices(*mvp.projection, *mvp.modelview);
 
-    if (m_useTriangles)
+    if (m_useInstances)
+    {
+        if (m_primType == PrimType::Lines)
+            m_inVO->drawInstanced(6, count / 2, 0, offset / 2);
+        else
+            m_inVO->drawInstanced(6, std::max(count - 1, 0), 0, offset);
+    }
+    else if (m_useTriangles)
     {
         if ((m_hints & PREFER_SIMPLE_TRIANGLES) != 0 && m_primType != PrimType::Lines)
         {
@@ -571,7 +695,7 @@ LineRenderer::addVertex(float x, float y, float z)
 void
 LineRenderer::addSegment(const Eigen::Vector3f &pos1, const Eigen::Vector3f &pos2)
 {
-    if (!m_useTriangles)
+    if (!m_useTriangles || m_useInstances)
     {
         m_vertices.emplace_back(pos1);
         m_vertices.emplace_back(pos2);
@@ -585,12 +709,18 @@ LineRenderer::addSegment(const Eigen::Vector3f &pos1, const Eigen::Vector3f &pos
 void
 LineRenderer::dropLast()
 {
-    if ((m_hints & PREFER_SIMPLE_TRIANGLES) == 0 && m_primType != PrimType::Lines)
+    if (m_primType == PrimType::Lines)
+        return;
+
+    if (m_verticesTriangulated)
     {
-        m_vertices.pop_back();
         m_verticesTr.pop_back();
         m_verticesTr.pop_back();
     }
+    else
+    {
+        m_vertices.pop_back();
+    }
 }
 
 void
@@ -43,6 +43,11 @@ namespace celestia::render
  * For lines which are not updated (static storage) conversation into triangles is performed before
  * the actual rendering is done. For lines with dynamic or stream storage conversation into
  * triangles is performed immediatelly when a new vertex or segment is added.
+ * Lines with static storage are uploaded once into immutable buffers and drawn with the matrices
+ * of each frame; they can be rebuilt with clear() and invalidate().
+ * Where instanced draws with a base instance are supported, line segments and strips aren't
+ * converted on the CPU: each segment is drawn as an instance of a quad expanded from the end
+ * points by the vertex shader, so the vertices are uploaded as they are.
  *
  * Worflow:
  *   1. create lr
@@ -154,6 +159,9 @@ public:
     //! Clear GPU side memory buffers
     void orphan() const;
 
+    //! Release GPU side memory buffers, so that static lines are uploaded again by the next prerender()
+    void invalidate();
+
     //! Finish renderring
     void finish();
 
@@ -256,6 +264,8 @@ private:
     void setup_vbo();
     void create_vbo_lines();
     void setup_vbo_lines();
+    void upload_vertices();
+    void create_vbo_instances();
     void create_vbo_triangles();
     void setup_vbo_triangles();
     void triangulate_and_segment();
@@ -269,6 +279,7 @@ private:
     int color_count() const;
     int color_type() const;
     bool should_triangulate() const;
+    bool should_use_instances() const;
     float width_multiplyer() const;
     float rasterized_width() const;
 
@@ -280,6 +291,8 @@ private:
     std::unique_ptr<gl::VertexObject>   m_trVO;
     std::unique_ptr<gl::Buffer>         m_lnBO;
     std::unique_ptr<gl::Buffer>         m_trBO;
+    std::unique_ptr<gl::VertexObject>   m_inVO;
+    std::unique_ptr<gl::Buffer>         m_cornerBO;
     const Renderer                     &m_renderer;
     float                               m_width;
     PrimType                            m_primType;
@@ -287,6 +300,7 @@ private:
     VertexFormat                        m_format;
     int                                 m_hints{ 0 };
     bool                                m_useTriangles{ false };
+    bool                                m_useInstances{ false };
     bool                                m_verticesTriangulated{ false };
     bool                                m_segmented{ false };
     bool                                m_loopDone{ false };
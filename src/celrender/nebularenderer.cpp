@@ -22,18 +22,29 @@
 namespace celestia::render
 {
 
+namespace
+{
+
+// Nebulae smaller than this radius in pixels aren't worth loading a mesh
+// for when loading in the background; the ones already loaded are drawn.
+constexpr float MinLoadPixels = 2.0f;
+
+} // end unnamed namespace
+
 struct NebulaRenderer::Object
 {
     Object(const Eigen::Vector3f &offset, float nearZ, float farZ, const Nebula *nebula) :
         offset(offset),
+        distance(offset.norm()),
         nearZ(nearZ),
         farZ(farZ),
         nebula(nebula)
     {
     }
 
-    Eigen::Vector3f offset; // distance to the nebula
-    float           nearZ;  // if nearZ != & farZ != then use custom projection matrix
+    Eigen::Vector3f offset;   // distance to the nebula
+    float           distance; // sort key
+    float           nearZ;    // if nearZ != & farZ != then use custom projection matrix
     float           farZ;
     const Nebula   *nebula;
 };
@@ -63,22 +74,51 @@ NebulaRenderer::add(const Nebula *nebula, const Eigen::Vector3f &offset, float /
 void
 NebulaRenderer::render()
 {
+    if (m_objects.empty())
+        return;
+
     // draw more distant objects first
     std::sort(m_objects.begin(), m_objects.end(),
-        [](const auto &o1, const auto &o2){ return o1.offset.squaredNorm() > o2.offset.squaredNorm(); });
+        [](const auto &o1, const auto &o2){ return o1.distance > o2.distance; });
+
+    // The state and matrices shared by all the nebulae are set up once, the
+    // render contexts only change the blending for their materials
+    Renderer::PipelineState ps;
+    ps.smoothLines = true;
+    m_renderer.setPipelineState(ps);
+
+    const Eigen::Matrix4f &projection = m_renderer.getProjectionMatrix();
+    const Eigen::Matrix4f &modelView = m_renderer.getModelViewMatrix();
 
     for (const auto &obj : m_objects)
-        renderNebula(obj);
+        renderNebula(obj, projection, modelView);
 
     m_objects.clear();
 }
 
 void
-NebulaRenderer::renderNebula(const Object &obj) const
+NebulaRenderer::renderNebula(const Object &obj,
+                             const Eigen::Matrix4f &projection,
+                             const Eigen::Matrix4f &modelView) const
 {
+    auto geometry = obj.nebula->getGeometry();
+    if (geometry == InvalidResource)
+        return;
+
+    float radius = obj.nebula->getRadius();
+
+    // Size in pixels of the unit of the mesh, which is normalized to the
+    // radius of the nebula
+    float pixelScale = obj.distance > 0.0f ? radius / (obj.distance * m_pixelSize) : 0.0f;
+
+    // With background loading, find returns nullptr until the mesh is ready
+    // and the nebula is skipped in the meantime
+    auto geometryManager = engine::GetGeometryManager();
     Geometry *g = nullptr;
-    if (auto geometry = obj.nebula->getGeometry(); geometry != InvalidResource)
-        g = engine::GetGeometryManager()->find(geometry);
+    if (geometryManager->getAsyncLoading() && pixelScale > 0.0f && pixelScale < MinLoadPixels)
+        g = geometryManager->findLoaded(geometry);
+    else
+        g = geometryManager->find(geometry);
     if (g == nullptr)
         return;
 
@@ -86,20 +126,15 @@ NebulaRenderer::renderNebula(const Object &obj) const
     if (obj.nearZ != 0.0f && obj.farZ != 0.0f)
         m_renderer.buildProjectionMatrix(pr, obj.nearZ, obj.farZ, m_zoom);
     else
-        pr = m_renderer.getProjectionMatrix();
-
-    Renderer::PipelineState ps;
-    ps.smoothLines = true;
-    m_renderer.setPipelineState(ps);
-
-    float radius = obj.nebula->getRadius();
+        pr = projection;
 
     Eigen::Matrix4f mv = math::rotate(
-        math::scale(math::translate(m_renderer.getModelViewMatrix(), obj.offset), radius),
+        math::scale(math::translate(modelView, obj.offset), radius),
         obj.nebula->getOrientation());
 
     GLSLUnlit_RenderContext rc(&m_renderer, radius, &mv, &pr);
     rc.setPointScale(2.0f * radius / m_pixelSize);
+    rc.setPixelScale(pixelScale);
     g->render(rc);
 }
 
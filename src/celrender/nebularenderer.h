@@ -10,6 +10,8 @@
 
 #pragma once
 
+#include <vector>
+
 #include <Eigen/Core>
 #include <Eigen/Geometry>
 
@@ -35,7 +37,9 @@ public:
 private:
     struct Object;
 
-    void renderNebula(const Object &obj) const;
+    void renderNebula(const Object &obj,
+                      const Eigen::Matrix4f &projection,
+                      const Eigen::Matrix4f &modelView) const;
 
     // global state
     std::vector<Object> m_objects;
@@ -9,10 +9,15 @@ class CometRenderer;
 class EclipticLineRenderer;
 class GalaxyRenderer;
 class GlobularRenderer;
+class GPUProfiler;
+class GPUStageTimer;
+class GPUStarRenderer;
+class GPUTimer;
 class LargeStarRenderer;
 class LineRenderer;
 class NebulaRenderer;
 class OpenClusterRenderer;
+class ReverseDepthTarget;
 class RingRenderer;
 class SkyGridRenderer;
 }
@@ -0,0 +1,221 @@
+// reversedepthtarget.cpp
+//
+// Copyright (C) 2024, Celestia Development Team
+//
+// Offscreen render target with a floating point depth buffer, used to draw
+// the scene with a reversed depth range.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include "reversedepthtarget.h"
+
+#include <array>
+
+#include <celengine/render.h>
+#include <celengine/shadermanager.h>
+#include <celutil/logger.h>
+
+using celestia::util::GetLogger;
+
+namespace celestia::render
+{
+
+ReverseDepthTarget::ReverseDepthTarget(Renderer& renderer) :
+    m_renderer(renderer)
+{
+}
+
+ReverseDepthTarget::~ReverseDepthTarget()
+{
+    destroy();
+}
+
+bool
+ReverseDepthTarget::isSupported()
+{
+#ifdef GL_ES
+    return false;
+#else
+    return gl::ARB_clip_control;
+#endif
+}
+
+bool
+ReverseDepthTarget::begin(int width, int height)
+{
+    if (m_invalid || width <= 0 || height <= 0)
+        return false;
+
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &m_targetFbo);
+
+    GLint samples = 0;
+    glGetIntegerv(GL_SAMPLES, &samples);
+
+    if (width != m_width || height != m_height || samples != m_samples)
+    {
+        destroy();
+        if (!create(width, height, samples))
+        {
+            // Don't retry every frame
+            GetLogger()->warn("Unable to create the reverse depth render target\n");
+            destroy();
+            m_invalid = true;
+            glBindFramebuffer(GL_FRAMEBUFFER, m_targetFbo);
+            return false;
+        }
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+    return true;
+}
+
+void
+ReverseDepthTarget::end()
+{
+    if (m_fbo != m_resolveFbo)
+    {
+        // The scissor box is in the coordinates of the target framebuffer
+        // and would clip the blit
+        GLboolean scissor = glIsEnabled(GL_SCISSOR_TEST);
+        if (scissor)
+            glDisable(GL_SCISSOR_TEST);
+
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, m_fbo);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_resolveFbo);
+        glBlitFramebuffer(0, 0, m_width, m_height,
+                          0, 0, m_width, m_height,
+                          GL_COLOR_BUFFER_BIT, GL_NEAREST);
+
+        if (scissor)
+            glEnable(GL_SCISSOR_TEST);
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, m_targetFbo);
+
+    auto* prog = m_renderer.getShaderManager().getShader("passthrough");
+    if (prog == nullptr)
+        return;
+
+    if (m_vo.id() == 0 && m_bo.id() == 0)
+    {
+        static constexpr std::array quadVertices
+        {
+            // positions   // texCoords
+            -1.0f, -1.0f,  0.0f, 0.0f,
+             1.0f, -1.0f,  1.0f, 0.0f,
+            -1.0f,  1.0f,  0.0f, 1.0f,
+             1.0f,  1.0f,  1.0f, 1.0f,
+        };
+
+        m_bo = gl::Buffer(gl::Buffer::TargetHint::Array, quadVertices, gl::Buffer::BufferUsage::StaticDraw);
+        m_vo = gl::VertexObject(gl::VertexObject::Primitive::TriangleStrip);
+        m_vo.setCount(4);
+        m_vo.addVertexBuffer(m_bo,
+                             CelestiaGLProgram::VertexCoordAttributeIndex,
+                             2,
+                             gl::VertexObject::DataType::Float,
+                             false,
+                             4 * sizeof(float),
+                             0);
+        m_vo.addVertexBuffer(m_bo,
+                             CelestiaGLProgram::TextureCoord0AttributeIndex,
+                             2,
+                             gl::VertexObject::DataType::Float,
+                             false,
+                             4 * sizeof(float),
+                             2 * sizeof(float));
+    }
+
+    Renderer::PipelineState ps;
+    m_renderer.setPipelineState(ps);
+
+    prog->use();
+    prog->samplerParam("tex") = 0;
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, m_texture);
+    m_vo.draw();
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+bool
+ReverseDepthTarget::create([[maybe_unused]] int width, [[maybe_unused]] int height, [[maybe_unused]] int samples)
+{
+#ifdef GL_ES
+    return false;
+#else
+    m_width = width;
+    m_height = height;
+    m_samples = samples;
+
+    glGenTextures(1, &m_texture);
+    glBindTexture(GL_TEXTURE_2D, m_texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glGenFramebuffers(1, &m_resolveFbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_resolveFbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_texture, 0);
+
+    if (samples > 1)
+    {
+        glGenRenderbuffers(1, &m_colorRenderbuffer);
+        glBindRenderbuffer(GL_RENDERBUFFER, m_colorRenderbuffer);
+        glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_RGBA8, width, height);
+
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            return false;
+
+        glGenFramebuffers(1, &m_fbo);
+        glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_colorRenderbuffer);
+    }
+    else
+    {
+        m_fbo = m_resolveFbo;
+    }
+
+    glGenRenderbuffers(1, &m_depthRenderbuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_depthRenderbuffer);
+    if (samples > 1)
+        glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_DEPTH_COMPONENT32F, width, height);
+    else
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT32F, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_depthRenderbuffer);
+
+    return glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+#endif
+}
+
+void
+ReverseDepthTarget::destroy()
+{
+    if (m_fbo != 0 && m_fbo != m_resolveFbo)
+        glDeleteFramebuffers(1, &m_fbo);
+    if (m_resolveFbo != 0)
+        glDeleteFramebuffers(1, &m_resolveFbo);
+    if (m_colorRenderbuffer != 0)
+        glDeleteRenderbuffers(1, &m_colorRenderbuffer);
+    if (m_depthRenderbuffer != 0)
+        glDeleteRenderbuffers(1, &m_depthRenderbuffer);
+    if (m_texture != 0)
+        glDeleteTextures(1, &m_texture);
+
+    m_fbo = 0;
+    m_resolveFbo = 0;
+    m_colorRenderbuffer = 0;
+    m_depthRenderbuffer = 0;
+    m_texture = 0;
+    m_width = 0;
+    m_height = 0;
+    m_samples = 0;
+}
+
+} // end namespace celestia::render
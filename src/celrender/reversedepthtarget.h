@@ -0,0 +1,78 @@
+// reversedepthtarget.h
+//
+// Copyright (C) 2024, Celestia Development Team
+//
+// Offscreen render target with a floating point depth buffer, used to draw
+// the scene with a reversed depth range.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <celengine/glsupport.h>
+#include <celrender/gl/buffer.h>
+#include <celrender/gl/vertexobject.h>
+
+class Renderer;
+
+namespace celestia::render
+{
+
+// The default framebuffer usually has a fixed point depth buffer, with which
+// a reversed depth range brings no gain in precision. The scene is drawn into
+// this target instead, which matches the sample count of the framebuffer it
+// replaces, and then copied into that framebuffer with a full screen quad.
+class ReverseDepthTarget
+{
+public:
+    explicit ReverseDepthTarget(Renderer&);
+    ~ReverseDepthTarget();
+
+    ReverseDepthTarget(const ReverseDepthTarget&) = delete;
+    ReverseDepthTarget& operator=(const ReverseDepthTarget&) = delete;
+    ReverseDepthTarget(ReverseDepthTarget&&) = delete;
+    ReverseDepthTarget& operator=(ReverseDepthTarget&&) = delete;
+
+    // Check for clip control, which is needed to map the depth to [0, 1]
+    static bool isSupported();
+
+    // Bind the target, resizing it when needed. Returns false if the target
+    // can't be created, in which case the bound framebuffer is unchanged.
+    bool begin(int width, int height);
+
+    // Draw the image into the framebuffer which was bound by begin, using
+    // the current viewport
+    void end();
+
+private:
+    bool create(int width, int height, int samples);
+    void destroy();
+
+    Renderer& m_renderer;
+
+    int m_width{ 0 };
+    int m_height{ 0 };
+    int m_samples{ 0 };
+
+    // Framebuffer the scene is drawn into; multisampled if the target
+    // framebuffer is
+    GLuint m_fbo{ 0 };
+    GLuint m_colorRenderbuffer{ 0 };
+    GLuint m_depthRenderbuffer{ 0 };
+
+    // Single sampled framebuffer holding the image as a texture; same as
+    // m_fbo when there is no multisampling
+    GLuint m_resolveFbo{ 0 };
+    GLuint m_texture{ 0 };
+
+    GLint m_targetFbo{ 0 };
+    bool m_invalid{ false };
+
+    gl::Buffer m_bo{ util::NoCreateT{} };
+    gl::VertexObject m_vo{ util::NoCreateT{} };
+};
+
+} // end namespace celestia::render
@@ -12,6 +12,7 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstddef>
 #include <vector>
 
 #include <Eigen/Core>
@@ -64,75 +65,16 @@ createShaderProperties(const LightingState& ls,
     return shadprop;
 }
 
-void
-setUpShadowParameters(CelestiaGLProgram* prog,
-                      const LightingState& ls,
-                      float planetOblateness)
-{
-    for (unsigned int li = 0; li < ls.nLights; li++)
-    {
-        const DirectionalLight& light = ls.lights[li];
-
-        // Compute the projection vectors based on the sun direction.
-        // I'm being a little careless here--if the sun direction lies
-        // along the y-axis, this will fail.  It's unlikely that a
-        // planet would ever orbit underneath its sun (an orbital
-        // inclination of 90 degrees), but this should be made
-        // more robust anyway.
-        Eigen::Vector3f axis = Eigen::Vector3f::UnitY().cross(light.direction_obj);
-        float cosAngle = Eigen::Vector3f::UnitY().dot(light.direction_obj);
-        axis.normalize();
-
-        float tScale = 1.0f;
-        if (planetOblateness != 0.0f)
-        {
-            // For oblate planets, the size of the shadow volume will vary
-            // based on the light direction.
-
-            // A vertical slice of the planet is an ellipse
-            float a = 1.0f;                          // semimajor axis
-            float b = a * (1.0f - planetOblateness); // semiminor axis
-            float ecc2 = 1.0f - (b * b) / (a * a);   // square of eccentricity
-
-            // Calculate the radius of the ellipse at the incident angle of the
-            // light on the ring plane + 90 degrees.
-            float r = a * std::sqrt((1.0f - ecc2) /
-                                    (1.0f - ecc2 * math::square(cosAngle)));
-
-            tScale *= a / r;
-        }
-
-        // The s axis is perpendicular to the shadow axis in the plane of the
-        // of the rings, and the t axis completes the orthonormal basis.
-        Eigen::Vector3f sAxis = axis * 0.5f;
-        Eigen::Vector3f tAxis = (axis.cross(light.direction_obj)) * 0.5f * tScale;
-        Eigen::Vector4f texGenS;
-        texGenS.head(3) = sAxis;
-        texGenS[3] = 0.5f;
-        Eigen::Vector4f texGenT;
-        texGenT.head(3) = tAxis;
-        texGenT[3] = 0.5f;
-
-        // r0 and r1 determine the size of the planet's shadow and penumbra
-        // on the rings.
-        // A more accurate ring shadow calculation would set r1 / r0
-        // to the ratio of the apparent sizes of the planet and sun as seen
-        // from the rings. Even more realism could be attained by letting
-        // this ratio vary across the rings, though it may not make enough
-        // of a visual difference to be worth the extra effort.
-        float r0 = 0.24f;
-        float r1 = 0.25f;
-        float bias = 1.0f / (1.0f - r1 / r0);
-
-        prog->shadows[li][0].texGenS = texGenS;
-        prog->shadows[li][0].texGenT = texGenT;
-        prog->shadows[li][0].maxDepth = 1.0f;
-        prog->shadows[li][0].falloff = bias / r0;
-    }
-}
-
 } // end unnamed namespace
 
+struct RingRenderer::ShadowState
+{
+    const CelestiaGLProgram* program;
+    unsigned int nLights;
+    float planetOblateness;
+    std::array<Eigen::Vector3f, MaxShaderLights> lightDirections;
+};
+
 RingRenderer::RingRenderer(Renderer& _renderer) : renderer(_renderer)
 {
     // Initialize section scales
@@ -144,6 +86,8 @@ RingRenderer::RingRenderer(Renderer& _renderer) : renderer(_renderer)
     }
 }
 
+RingRenderer::~RingRenderer() = default;
+
 // Render a planetary ring system
 void
 RingRenderer::renderRings(RingSystem& rings,
@@ -183,14 +127,11 @@ RingRenderer::renderRings(RingSystem& rings,
         ringsTex->bind();
 
     // Determine level of detail
-    std::uint32_t nSections = BaseSectionCount;
     unsigned int level = 0;
     for (level = 0U; level < nLODs - 1U; ++level)
     {
         if (float s = segmentSizeInPixels * sectionScales[level]; s < SegmentSizeThreshold)
             break;
-
-        nSections <<= 1;
     }
 
     Renderer::PipelineState ps;
@@ -200,41 +141,137 @@ RingRenderer::renderRings(RingSystem& rings,
     ps.depthMask = inside;
     renderer.setPipelineState(ps);
 
-    renderLOD(level, nSections);
+    renderLOD(level);
+}
+
+void
+RingRenderer::setUpShadowParameters(CelestiaGLProgram* prog,
+                                    const LightingState& ls,
+                                    float planetOblateness)
+{
+    // Ring shaders are only used here, so their shadow uniforms keep the
+    // values of the last ring system drawn with them. Rings seen under the
+    // same lighting, as in consecutive frames, don't need them set again.
+    unsigned int nLights = std::min(ls.nLights, MaxShaderLights);
+    auto state = std::find_if(shadowStates.begin(), shadowStates.end(),
+                              [prog](const ShadowState& s) { return s.program == prog; });
+    if (state == shadowStates.end())
+    {
+        state = shadowStates.insert(shadowStates.end(), ShadowState{ prog, 0, 0.0f, {} });
+    }
+    else if (state->nLights == nLights &&
+             state->planetOblateness == planetOblateness &&
+             std::equal(state->lightDirections.begin(), state->lightDirections.begin() + nLights, ls.lights,
+                        [](const Eigen::Vector3f& d, const DirectionalLight& l) { return d == l.direction_obj; }))
+    {
+        return;
+    }
+
+    state->nLights = nLights;
+    state->planetOblateness = planetOblateness;
+    for (unsigned int li = 0; li < nLights; li++)
+    {
+        const DirectionalLight& light = ls.lights[li];
+        state->lightDirections[li] = light.direction_obj;
+
+        // Compute the projection vectors based on the sun direction.
+        // I'm being a little careless here--if the sun direction lies
+        // along the y-axis, this will fail.  It's unlikely that a
+        // planet would ever orbit underneath its sun (an orbital
+        // inclination of 90 degrees), but this should be made
+        // more robust anyway.
+        Eigen::Vector3f axis = Eigen::Vector3f::UnitY().cross(light.direction_obj);
+        float cosAngle = Eigen::Vector3f::UnitY().dot(light.direction_obj);
+        axis.normalize();
+
+        float tScale = 1.0f;
+        if (planetOblateness != 0.0f)
+        {
+            // For oblate planets, the size of the shadow volume will vary
+            // based on the light direction.
+
+            // A vertical slice of the planet is an ellipse
+            float a = 1.0f;                          // semimajor axis
+            float b = a * (1.0f - planetOblateness); // semiminor axis
+            float ecc2 = 1.0f - (b * b) / (a * a);   // square of eccentricity
+
+            // Calculate the radius of the ellipse at the incident angle of the
+            // light on the ring plane + 90 degrees.
+            float r = a * std::sqrt((1.0f - ecc2) /
+                                    (1.0f - ecc2 * math::square(cosAngle)));
+
+            tScale *= a / r;
+        }
+
+        // The s axis is perpendicular to the shadow axis in the plane of the
+        // of the rings, and the t axis completes the orthonormal basis.
+        Eigen::Vector3f sAxis = axis * 0.5f;
+        Eigen::Vector3f tAxis = (axis.cross(light.direction_obj)) * 0.5f * tScale;
+        Eigen::Vector4f texGenS;
+        texGenS.head(3) = sAxis;
+        texGenS[3] = 0.5f;
+        Eigen::Vector4f texGenT;
+        texGenT.head(3) = tAxis;
+        texGenT[3] = 0.5f;
+
+        // r0 and r1 determine the size of the planet's shadow and penumbra
+        // on the rings.
+        // A more accurate ring shadow calculation would set r1 / r0
+        // to the ratio of the apparent sizes of the planet and sun as seen
+        // from the rings. Even more realism could be attained by letting
+        // this ratio vary across the rings, though it may not make enough
+        // of a visual difference to be worth the extra effort.
+        float r0 = 0.24f;
+        float r1 = 0.25f;
+        float bias = 1.0f / (1.0f - r1 / r0);
+
+        prog->shadows[li][0].texGenS = texGenS;
+        prog->shadows[li][0].texGenT = texGenT;
+        prog->shadows[li][0].maxDepth = 1.0f;
+        prog->shadows[li][0].falloff = bias / r0;
+    }
 }
 
 void
-RingRenderer::initializeLOD(unsigned int level, std::uint32_t nSections)
+RingRenderer::initializeLODs()
 {
+    std::uint32_t nSections = BaseSectionCount;
     std::vector<RingVertex> ringCoord;
-    ringCoord.reserve(2 * nSections);
+    ringCoord.reserve(2 * ((nSections << nLODs) + nLODs));
 
     constexpr float angle = 2.0f * celestia::numbers::pi_v<float>;
-    for (std::uint32_t i = 0; i <= nSections; i++)
+    for (unsigned int level = 0; level < nLODs; ++level)
     {
-        float theta = angle * static_cast<float>(i) / static_cast<float>(nSections);
-        float s, c;
-        math::sincos(theta, s, c);
-
-        RingVertex vertex;
-        // inner point
-        vertex.pos[0] = c;
-        vertex.pos[1] = 0.0f;
-        vertex.pos[2] = s;
-        vertex.tex[0] = 0;
-        vertex.tex[1] = 0;
-        ringCoord.push_back(vertex);
-
-        // outer point
-        vertex.tex[0] = 1;
-
-        ringCoord.push_back(vertex);
+        lodFirsts[level] = static_cast<int>(ringCoord.size());
+        lodCounts[level] = static_cast<int>((nSections + 1) * 2);
+
+        for (std::uint32_t i = 0; i <= nSections; i++)
+        {
+            float theta = angle * static_cast<float>(i) / static_cast<float>(nSections);
+            float s, c;
+            math::sincos(theta, s, c);
+
+            RingVertex vertex;
+            // inner point
+            vertex.pos[0] = c;
+            vertex.pos[1] = 0.0f;
+            vertex.pos[2] = s;
+            vertex.tex[0] = 0;
+            vertex.tex[1] = 0;
+            ringCoord.push_back(vertex);
+
+            // outer point
+            vertex.tex[0] = 1;
+
+            ringCoord.push_back(vertex);
+        }
+
+        nSections <<= 1;
     }
 
-    const auto& bo = buffers[level].emplace(gl::Buffer::TargetHint::Array, ringCoord);
-    auto& vo = vertexObjects[level].emplace(gl::VertexObject::Primitive::TriangleStrip);
-    vo.setCount(static_cast<int>((nSections + 1) * 2))
-      .addVertexBuffer(bo,
+    const auto& bo = buffer.emplace(gl::Buffer::TargetHint::Array, ringCoord);
+    auto& vo = vertexObject.emplace(gl::VertexObject::Primitive::TriangleStrip);
+    vo.addVertexBuffer(bo,
                        CelestiaGLProgram::TextureCoord0AttributeIndex,
                        2,
                        gl::VertexObject::DataType::UnsignedShort,
@@ -252,12 +289,12 @@ RingRenderer::initializeLOD(unsigned int level, std::uint32_t nSections)
 }
 
 void
-RingRenderer::renderLOD(unsigned int level, std::uint32_t nSections)
+RingRenderer::renderLOD(unsigned int level)
 {
-    if (!vertexObjects[level].has_value())
-        initializeLOD(level, nSections);
+    if (!vertexObject.has_value())
+        initializeLODs();
     glDisable(GL_CULL_FACE);
-    vertexObjects[level]->draw();
+    vertexObject->draw(lodCounts[level], lodFirsts[level]);
     glEnable(GL_CULL_FACE);
 }
 
@@ -13,10 +13,12 @@
 #include <array>
 #include <cstdint>
 #include <optional>
+#include <vector>
 
 #include "gl/buffer.h"
 #include "gl/vertexobject.h"
 
+class CelestiaGLProgram;
 class LightingState;
 struct Matrices;
 class Renderer;
@@ -30,7 +32,7 @@ class RingRenderer
 {
 public:
     explicit RingRenderer(Renderer&);
-    ~RingRenderer() = default;
+    ~RingRenderer();
 
     void renderRings(RingSystem& rings,
                      const RenderInfo& ri,
@@ -43,14 +45,22 @@ public:
                      bool inside);
 
 private:
-    void initializeLOD(unsigned int, std::uint32_t);
-    void renderLOD(unsigned int, std::uint32_t);
-
     static constexpr unsigned int nLODs = 4;
 
+    // Ring shadow configuration last uploaded to a ring shader
+    struct ShadowState;
+
+    void initializeLODs();
+    void renderLOD(unsigned int);
+    void setUpShadowParameters(CelestiaGLProgram*, const LightingState&, float);
+
     std::array<float, nLODs - 1> sectionScales;
-    std::array<std::optional<gl::Buffer>, nLODs> buffers;
-    std::array<std::optional<gl::VertexObject>, nLODs> vertexObjects;
+    // All the levels of detail share one immutable buffer
+    std::array<int, nLODs> lodFirsts;
+    std::array<int, nLODs> lodCounts;
+    std::optional<gl::Buffer> buffer;
+    std::optional<gl::VertexObject> vertexObject;
+    std::vector<ShadowState> shadowStates;
     Renderer& renderer;
 };
 
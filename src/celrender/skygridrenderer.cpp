@@ -16,7 +16,9 @@
 #include <algorithm>
 #include <array>
 #include <cmath>
+#include <cstddef>
 #include <iterator>
+#include <optional>
 #include <string>
 #include <string_view>
 #include <utility>
@@ -50,6 +52,10 @@ constexpr int ARC_SUBDIVISIONS = 100;
 // Size of the cross indicating the north and south poles
 constexpr double POLAR_CROSS_SIZE = 0.01;
 
+// Number of grids whose arcs are kept: the equatorial, galactic, ecliptic
+// and horizontal grids
+constexpr std::size_t MAX_CACHED_GRIDS = 4;
+
 // Grid line spacing tables
 constexpr int MSEC = 1;
 constexpr int SEC = 1000;
@@ -446,31 +452,78 @@ SkyGridRenderer::RenderInfo::RenderInfo(double vfov, double viewAspectRatio,
     orientationf = q.cast<float>();
 }
 
+// The grid lines in view, in milliarcseconds for latitudes and in
+// longitude units for longitudes. The vertices of the arcs depend only on
+// these, as the orientation of the grid is applied when drawing them.
+struct SkyGridRenderer::GridLayout
+{
+    GridLayout(const RenderInfo&, const engine::SkyGrid&);
+
+    bool operator==(const GridLayout& other) const
+    {
+        return decIncrement == other.decIncrement &&
+               raIncrement == other.raIncrement &&
+               totalLongitudeUnits == other.totalLongitudeUnits &&
+               startDec == other.startDec &&
+               endDec == other.endDec &&
+               startRa == other.startRa &&
+               endRa == other.endRa;
+    }
+
+    int decIncrement{ 0 };
+    int raIncrement{ 0 };
+    int totalLongitudeUnits{ 0 };
+    int startDec{ 0 };
+    int endDec{ -1 };
+    int startRa{ 0 };
+    int endRa{ -1 };
+};
+
+SkyGridRenderer::GridLayout::GridLayout(const RenderInfo& renderInfo, const engine::SkyGrid& grid) :
+    decIncrement(parallelSpacing(renderInfo.idealParallelSpacing)),
+    raIncrement(meridianSpacing(renderInfo.idealMeridianSpacing, grid.longitudeUnits)),
+    totalLongitudeUnits(grid.longitudeUnits == engine::SkyGrid::LongitudeDegrees ? (DEG_MIN_SEC_TOTAL * 2) : HOUR_MIN_SEC_TOTAL)
+{
+    startDec = static_cast<int>(std::ceil (DEG_MIN_SEC_TOTAL * (renderInfo.minDec * numbers::inv_pi) / static_cast<double>(decIncrement))) * decIncrement;
+    endDec   = static_cast<int>(std::floor(DEG_MIN_SEC_TOTAL * (renderInfo.maxDec * numbers::inv_pi) / static_cast<double>(decIncrement))) * decIncrement;
+    startRa  = static_cast<int>(std::ceil (totalLongitudeUnits * (renderInfo.minTheta * 0.5 * numbers::inv_pi) / static_cast<double>(raIncrement))) * raIncrement;
+    endRa    = static_cast<int>(std::floor(totalLongitudeUnits * (renderInfo.maxTheta * 0.5 * numbers::inv_pi) / static_cast<double>(raIncrement))) * raIncrement;
+}
+
+struct SkyGridRenderer::GridGeometry
+{
+    std::optional<GridLayout> layout;
+    std::unique_ptr<LineRenderer> lines;
+    int arcCount{ 0 };
+    std::uint64_t lastUsed{ 0 };
+};
+
 SkyGridRenderer::SkyGridRenderer(Renderer& renderer) :
-    m_gridRenderer(std::make_unique<LineRenderer>(renderer, 1.0f, LineRenderer::PrimType::LineStrip, LineRenderer::StorageType::Stream)),
+    m_grids(MAX_CACHED_GRIDS),
     m_crossRenderer(std::make_unique<LineRenderer>(renderer, 1.0f, LineRenderer::PrimType::Lines, LineRenderer::StorageType::Stream)),
     m_renderer(renderer)
 {
+    for (GridGeometry& geometry : m_grids)
+        geometry.lines = std::make_unique<LineRenderer>(renderer, 1.0f, LineRenderer::PrimType::LineStrip, LineRenderer::StorageType::Static);
 }
 
 SkyGridRenderer::~SkyGridRenderer() = default;
 
 void
-SkyGridRenderer::render(const engine::SkyGrid& grid, float zoom) const
+SkyGridRenderer::render(const engine::SkyGrid& grid, float zoom)
 {
     auto vfov = static_cast<double>(m_renderer.getProjectionMode()->getFOV(zoom));
     double viewAspectRatio = static_cast<double>(m_renderer.getWindowWidth()) / static_cast<double>(m_renderer.getWindowHeight());
     Eigen::Quaterniond cameraOrientation = m_renderer.getCameraOrientation();
 
     RenderInfo renderInfo(vfov, viewAspectRatio, cameraOrientation, grid);
+    GridLayout layout(renderInfo, grid);
 
-    int decIncrement = parallelSpacing(renderInfo.idealParallelSpacing);
     Eigen::Matrix3f cameraMatrix = cameraOrientation.cast<float>().toRotationMatrix();
+    addParallelLabels(renderInfo, layout, cameraMatrix, grid.labelColor);
+    addMeridianLabels(renderInfo, layout, cameraMatrix, grid);
 
-    m_gridRenderer->startUpdate();
-
-    int count = drawParallels(renderInfo, cameraMatrix, grid.labelColor, decIncrement) +
-                drawMeridians(renderInfo, cameraMatrix, grid, decIncrement);
+    GridGeometry& geometry = getGeometry(layout);
 
     // Radius of sphere is arbitrary, with the constraint that it shouldn't
     // intersect the near or far plane of the view frustum.
@@ -487,9 +540,9 @@ SkyGridRenderer::render(const engine::SkyGrid& grid, float zoom) const
     ps.smoothLines = true;
     m_renderer.setPipelineState(ps);
 
-    for (int offset = 0, i = 0; i < count; ++i)
+    for (int offset = 0, i = 0; i < geometry.arcCount; ++i)
     {
-        m_gridRenderer->render(matrices, grid.lineColor, ARC_SUBDIVISIONS + 1, offset);
+        geometry.lines->render(matrices, grid.lineColor, ARC_SUBDIVISIONS + 1, offset);
         offset += ARC_SUBDIVISIONS + 1;
     }
 
@@ -505,28 +558,47 @@ SkyGridRenderer::render(const engine::SkyGrid& grid, float zoom) const
     m_crossRenderer->addVertex( 0.0f,                      -1.0f,  renderInfo.polarCrossSize);
     m_crossRenderer->render(matrices, grid.lineColor, 8);
 
-    m_gridRenderer->clear();
     m_crossRenderer->clear();
-    m_gridRenderer->finish();
+    geometry.lines->finish();
     m_crossRenderer->finish();
 }
 
-int
-SkyGridRenderer::drawParallels(const RenderInfo& renderInfo,
-                               const Eigen::Matrix3f& cameraMatrix,
-                               const Color& labelColor,
-                               int decIncrement) const
+// Return the arcs of the grid lines in view, building them again in the
+// least recently used slot only when the lines in view changed.
+SkyGridRenderer::GridGeometry&
+SkyGridRenderer::getGeometry(const GridLayout& layout)
 {
-    double arcStep = (renderInfo.maxTheta - renderInfo.minTheta) / static_cast<double>(ARC_SUBDIVISIONS);
-    double theta0 = renderInfo.minTheta;
+    ++m_renderCount;
 
-    auto startDec = static_cast<int>(std::ceil (DEG_MIN_SEC_TOTAL * (renderInfo.minDec * numbers::inv_pi) / static_cast<double>(decIncrement))) * decIncrement;
-    auto endDec   = static_cast<int>(std::floor(DEG_MIN_SEC_TOTAL * (renderInfo.maxDec * numbers::inv_pi) / static_cast<double>(decIncrement))) * decIncrement;
+    auto it = std::find_if(m_grids.begin(), m_grids.end(),
+                           [&layout](const GridGeometry& g) { return g.layout == layout; });
+    if (it != m_grids.end())
+    {
+        it->lastUsed = m_renderCount;
+        return *it;
+    }
 
-    int count = 0;
-    for (int dec = startDec; dec <= endDec; dec += decIncrement)
+    GridGeometry& geometry = *std::min_element(m_grids.begin(), m_grids.end(),
+                                               [](const GridGeometry& a, const GridGeometry& b) { return a.lastUsed < b.lastUsed; });
+    geometry.layout = layout;
+    geometry.lastUsed = m_renderCount;
+    geometry.arcCount = 0;
+
+    LineRenderer& lines = *geometry.lines;
+    lines.clear();
+    lines.invalidate();
+
+    // The arcs extend to the next grid line beyond the view, so that they
+    // still cover it when it turns without crossing a grid line.
+    double thetaStep = 2.0 * numbers::pi / static_cast<double>(layout.totalLongitudeUnits);
+    int startTheta = layout.startRa - layout.raIncrement;
+    int endTheta = std::min(layout.endRa + layout.raIncrement, startTheta + layout.totalLongitudeUnits);
+    double arcStep = thetaStep * static_cast<double>(endTheta - startTheta) / static_cast<double>(ARC_SUBDIVISIONS);
+    double theta0 = thetaStep * static_cast<double>(startTheta);
+
+    for (int dec = layout.startDec; dec <= layout.endDec; dec += layout.decIncrement)
     {
-        ++count;
+        ++geometry.arcCount;
         double phi = numbers::pi * static_cast<double>(dec) / static_cast<double>(DEG_MIN_SEC_TOTAL);
         double cosPhi;
         double sinPhi;
@@ -541,8 +613,55 @@ SkyGridRenderer::drawParallels(const RenderInfo& renderInfo,
             auto x = static_cast<float>(cosPhi * cosTheta);
             auto y = static_cast<float>(cosPhi * sinTheta);
             auto z = static_cast<float>(sinPhi);
-            m_gridRenderer->addVertex(x, z, -y);  // convert to Celestia coords
+            lines.addVertex(x, z, -y);  // convert to Celestia coords
         }
+    }
+
+    // Render meridians only to the last latitude circle; this looks better
+    // than spokes radiating from the pole.
+    int maxMeridianDec = DEG_MIN_SEC_TOTAL / 2 - layout.decIncrement;
+    int startPhi = std::max(layout.startDec - layout.decIncrement, -maxMeridianDec);
+    int endPhi = std::min(layout.endDec + layout.decIncrement, maxMeridianDec);
+    double phiStep = numbers::pi / static_cast<double>(DEG_MIN_SEC_TOTAL);
+    arcStep = phiStep * static_cast<double>(endPhi - startPhi) / static_cast<double>(ARC_SUBDIVISIONS);
+    double phi0 = phiStep * static_cast<double>(startPhi);
+
+    for (int ra = layout.startRa; ra <= layout.endRa; ra += layout.raIncrement)
+    {
+        ++geometry.arcCount;
+        double theta = thetaStep * static_cast<double>(ra);
+        double cosTheta;
+        double sinTheta;
+        math::sincos(theta, sinTheta, cosTheta);
+
+        for (int j = 0; j <= ARC_SUBDIVISIONS; ++j)
+        {
+            double phi = phi0 + j * arcStep;
+            double cosPhi;
+            double sinPhi;
+            math::sincos(phi, sinPhi, cosPhi);
+            auto x = static_cast<float>(cosPhi * cosTheta);
+            auto y = static_cast<float>(cosPhi * sinTheta);
+            auto z = static_cast<float>(sinPhi);
+            lines.addVertex(x, z, -y);  // convert to Celestia coords
+        }
+    }
+
+    return geometry;
+}
+
+void
+SkyGridRenderer::addParallelLabels(const RenderInfo& renderInfo,
+                                   const GridLayout& layout,
+                                   const Eigen::Matrix3f& cameraMatrix,
+                                   const Color& labelColor) const
+{
+    for (int dec = layout.startDec; dec <= layout.endDec; dec += layout.decIncrement)
+    {
+        double phi = numbers::pi * static_cast<double>(dec) / static_cast<double>(DEG_MIN_SEC_TOTAL);
+        double cosPhi;
+        double sinPhi;
+        math::sincos(phi, sinPhi, cosPhi);
 
         // Place labels at the intersections of the view frustum planes
         // and the parallels.
@@ -557,7 +676,7 @@ SkyGridRenderer::drawParallels(const RenderInfo& renderInfo,
             if (!math::planeCircleIntersection(renderInfo.frustumNormal[k], center, axis0, axis1, &isect0, &isect1))
                 continue;
 
-            std::string labelText = latitudeLabel(dec, decIncrement);
+            std::string labelText = latitudeLabel(dec, layout.decIncrement);
 
             Eigen::Vector3f p0(toCelestiaCoords(isect0).cast<float>());
             Eigen::Vector3f p1(toCelestiaCoords(isect1).cast<float>());
@@ -574,52 +693,25 @@ SkyGridRenderer::drawParallels(const RenderInfo& renderInfo,
                 m_renderer.addBackgroundAnnotation(nullptr, labelText, labelColor, p1, hAlign, vAlign);
         }
     }
-
-    return count;
 }
 
-int
-SkyGridRenderer::drawMeridians(const RenderInfo& renderInfo,
-                               const Eigen::Matrix3f& cameraMatrix,
-                               const engine::SkyGrid& grid,
-                               int decIncrement) const
+void
+SkyGridRenderer::addMeridianLabels(const RenderInfo& renderInfo,
+                                   const GridLayout& layout,
+                                   const Eigen::Matrix3f& cameraMatrix,
+                                   const engine::SkyGrid& grid) const
 {
-    int totalLongitudeUnits = grid.longitudeUnits == engine::SkyGrid::LongitudeDegrees ? (DEG_MIN_SEC_TOTAL * 2) : HOUR_MIN_SEC_TOTAL;
-    int raIncrement  = meridianSpacing(renderInfo.idealMeridianSpacing, grid.longitudeUnits);
-    auto startRa  = static_cast<int>(std::ceil (totalLongitudeUnits * (renderInfo.minTheta * 0.5 * numbers::inv_pi) / static_cast<double>(raIncrement))) * raIncrement;
-    auto endRa    = static_cast<int>(std::floor(totalLongitudeUnits * (renderInfo.maxTheta * 0.5 * numbers::inv_pi) / static_cast<double>(raIncrement))) * raIncrement;
-
-    // Render meridians only to the last latitude circle; this looks better
-    // than spokes radiating from the pole.
-    double maxMeridianAngle = numbers::pi * 0.5 * (1.0 - 2.0 * static_cast<double>(decIncrement) / static_cast<double>(DEG_MIN_SEC_TOTAL));
-    double minDec = std::max(renderInfo.minDec, -maxMeridianAngle);
-    double maxDec = std::min(renderInfo.maxDec,  maxMeridianAngle);
-    double arcStep = (maxDec - minDec) / static_cast<double>(ARC_SUBDIVISIONS);
-    double phi0 = minDec;
-
+    // Meridians end at the last latitude circle
+    double maxMeridianAngle = numbers::pi * 0.5 * (1.0 - 2.0 * static_cast<double>(layout.decIncrement) / static_cast<double>(DEG_MIN_SEC_TOTAL));
     double cosMaxMeridianAngle = std::cos(maxMeridianAngle);
 
-    int count = 0;
-    for (int ra = startRa; ra <= endRa; ra += raIncrement)
+    for (int ra = layout.startRa; ra <= layout.endRa; ra += layout.raIncrement)
     {
-        ++count;
-        double theta = 2.0 * numbers::pi * (double) ra / (double) totalLongitudeUnits;
+        double theta = 2.0 * numbers::pi * (double) ra / (double) layout.totalLongitudeUnits;
         double cosTheta;
         double sinTheta;
         math::sincos(theta, sinTheta, cosTheta);
 
-        for (int j = 0; j <= ARC_SUBDIVISIONS; ++j)
-        {
-            double phi = phi0 + j * arcStep;
-            double cosPhi;
-            double sinPhi;
-            math::sincos(phi, sinPhi, cosPhi);
-            auto x = static_cast<float>(cosPhi * cosTheta);
-            auto y = static_cast<float>(cosPhi * sinTheta);
-            auto z = static_cast<float>(sinPhi);
-            m_gridRenderer->addVertex(x, z, -y);  // convert to Celestia coords
-        }
-
         // Place labels at the intersections of the view frustum planes
         // and the meridians.
         Eigen::Vector3d center(Eigen::Vector3d::Zero());
@@ -633,7 +725,7 @@ SkyGridRenderer::drawMeridians(const RenderInfo& renderInfo,
             if (!math::planeCircleIntersection(renderInfo.frustumNormal[k], center, axis0, axis1, &isect0, &isect1))
                 continue;
 
-            std::string labelText = longitudeLabel(ra, raIncrement, grid.longitudeUnits, grid.longitudeDirection);
+            std::string labelText = longitudeLabel(ra, layout.raIncrement, grid.longitudeUnits, grid.longitudeDirection);
 
             Eigen::Vector3f p0(toCelestiaCoords(isect0).cast<float>());
             Eigen::Vector3f p1(toCelestiaCoords(isect1).cast<float>());
@@ -650,8 +742,6 @@ SkyGridRenderer::drawMeridians(const RenderInfo& renderInfo,
                 m_renderer.addBackgroundAnnotation(nullptr, labelText, grid.labelColor, p1, hAlign, vAlign);
         }
     }
-
-    return count;
 }
 
 } // end namespace celestia::render
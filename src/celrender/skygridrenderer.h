@@ -11,7 +11,9 @@
 
 #pragma once
 
+#include <cstdint>
 #include <memory>
+#include <vector>
 
 #include <Eigen/Core>
 
@@ -37,15 +39,21 @@ public:
     explicit SkyGridRenderer(Renderer&);
     ~SkyGridRenderer();
 
-    void render(const engine::SkyGrid& grid, float zoom) const;
+    void render(const engine::SkyGrid& grid, float zoom);
 
 private:
     struct RenderInfo;
+    struct GridLayout;
+    struct GridGeometry;
 
-    int drawParallels(const RenderInfo&, const Eigen::Matrix3f&, const Color&, int) const;
-    int drawMeridians(const RenderInfo&, const Eigen::Matrix3f&, const engine::SkyGrid&, int) const;
+    GridGeometry& getGeometry(const GridLayout&);
+    void addParallelLabels(const RenderInfo&, const GridLayout&, const Eigen::Matrix3f&, const Color&) const;
+    void addMeridianLabels(const RenderInfo&, const GridLayout&, const Eigen::Matrix3f&, const engine::SkyGrid&) const;
 
-    std::unique_ptr<celestia::render::LineRenderer> m_gridRenderer;
+    // The arcs of the last grids drawn, which are kept until the grid
+    // lines in view change
+    std::vector<GridGeometry> m_grids;
+    std::uint64_t m_renderCount{ 0 };
     std::unique_ptr<celestia::render::LineRenderer> m_crossRenderer;
     Renderer& m_renderer;
 };
@@ -0,0 +1,118 @@
+// starpsf.cpp
+//
+// Copyright (C) 2026, Celestia Development Team
+//
+// The point spread functions of the star sprites, as cells of one texture.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include "starpsf.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include <celcompat/numbers.h>
+#include <celengine/texture.h>
+#include <celimage/image.h>
+
+using celestia::engine::Image;
+using celestia::engine::PixelFormat;
+
+namespace celestia::render
+{
+
+namespace
+{
+
+// Mip levels of the cells, down to a single pixel
+constexpr int StarPSFLog2CellSize = 9;
+static_assert(StarPSFCellSize == 1 << StarPSFLog2CellSize);
+
+std::uint8_t
+toPixel(float f)
+{
+    return static_cast<std::uint8_t>(255.99f * std::min(f, 1.0f));
+}
+
+// A gaussian with a full width at half maximum of 0.3 cell, normalized so
+// that the disc has the same brightness at each mip level
+void
+buildDiscCell(std::uint8_t* pixels, int pitch, int size)
+{
+    auto fsize = static_cast<float>(size);
+    float sigma = fsize * 0.3f / 2.3548f;
+    float isig2 = 1.0f / (2.0f * sigma * sigma);
+    // Store 1/sqrt(2*pi) in constexpr sfactor
+    constexpr auto sfactor = static_cast<float>(0.5 * celestia::numbers::sqrt2 * celestia::numbers::inv_sqrtpi);
+    float s = sfactor / sigma * fsize;
+
+    for (int i = 0; i < size; i++)
+    {
+        float y = static_cast<float>(i - size / 2);
+        for (int j = 0; j < size; j++)
+        {
+            float x = static_cast<float>(j - size / 2);
+            float r2 = x * x + y * y;
+            pixels[i * pitch + j] = toPixel(s * std::exp(-r2 * isig2));
+        }
+    }
+}
+
+// An exponential falloff, which drops to 0.66 every 1/25 of the cell
+void
+buildGlareCell(std::uint8_t* pixels, int pitch, int size)
+{
+    auto fsize = static_cast<float>(size);
+    float scale = 25.0f / fsize;
+
+    for (int i = 0; i < size; i++)
+    {
+        float y = static_cast<float>(i - size / 2);
+        for (int j = 0; j < size; j++)
+        {
+            float x = static_cast<float>(j - size / 2);
+            float r = std::sqrt(x * x + y * y);
+            pixels[i * pitch + j] = toPixel(std::pow(0.66f, r * scale));
+        }
+    }
+}
+
+} // end unnamed namespace
+
+std::unique_ptr<Image>
+BuildStarPSFImage()
+{
+    constexpr int mipLevels = StarPSFLog2CellSize + 2;
+    auto img = std::make_unique<Image>(PixelFormat::Luminance,
+                                       StarPSFCellSize * StarPSFCellCount,
+                                       StarPSFCellSize,
+                                       mipLevels);
+
+    for (int mipLevel = 0; mipLevel < mipLevels; mipLevel++)
+    {
+        int width = std::max((StarPSFCellSize * StarPSFCellCount) >> mipLevel, 1);
+        int size = std::max(StarPSFCellSize >> mipLevel, 1);
+        std::uint8_t* pixels = img->getMipLevel(mipLevel);
+        int pitch = img->getMipLevelSize(mipLevel) / size;
+
+        // The last level is narrower than the cells, and keeps the disc
+        buildDiscCell(pixels, pitch, size);
+        if (width >= size * StarPSFCellCount)
+            buildGlareCell(pixels + size * static_cast<int>(StarPSF::Glare), pitch, size);
+    }
+
+    return img;
+}
+
+std::unique_ptr<Texture>
+CreateStarPSFTexture()
+{
+    std::unique_ptr<Image> img = BuildStarPSFImage();
+    return std::make_unique<ImageTexture>(*img, Texture::EdgeClamp, Texture::DefaultMipMaps);
+}
+
+} // end namespace celestia::render
@@ -0,0 +1,53 @@
+// starpsf.h
+//
+// Copyright (C) 2026, Celestia Development Team
+//
+// The point spread functions of the star sprites, as cells of one texture.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <memory>
+
+class Texture;
+
+namespace celestia::engine
+{
+class Image;
+}
+
+namespace celestia::render
+{
+
+// The cells of the atlas, side by side from left to right. The disc is used
+// by the fuzzy and scaled disc star styles, the glare by all of them.
+enum class StarPSF : int
+{
+    Disc  = 0,
+    Glare = 1,
+};
+
+// The sprite shaders map the point coordinates to the cell with the psfCell
+// uniform:
+//     u = (gl_PointCoord.x + psfCell) / StarPSFCellCount
+constexpr int StarPSFCellCount = 2;
+constexpr int StarPSFCellSize  = 512;
+
+inline float
+starPSFCell(StarPSF psf)
+{
+    return static_cast<float>(psf);
+}
+
+// Both cells of every mip level are computed, so that the GL needn't
+// generate the mipmaps, and filtering at the cell borders stays within
+// values close to zero
+std::unique_ptr<engine::Image> BuildStarPSFImage();
+
+std::unique_ptr<Texture> CreateStarPSFTexture();
+
+} // end namespace celestia::render
@@ -13,6 +13,7 @@
 #include <cstddef>
 #include <memory>
 #include <sstream>
+#include <utility>
 
 #include <celengine/asterism.h>
 #include <celengine/body.h>
@@ -52,6 +53,28 @@ double InstantaneousCommand::getDuration() const
     return 0.0;
 }
 
+ObjectPath::ObjectPath(std::string _path) : path(std::move(_path))
+{
+}
+
+Selection ObjectPath::resolve(const Simulation& sim) const
+{
+    Selection sel = sim.getSelection();
+    const SolarSystem* solarSystem = sim.getNearestSolarSystem();
+    const Star* star = solarSystem == nullptr ? nullptr : solarSystem->getStar();
+    std::uint32_t catalogGeneration = sim.getUniverse()->getCatalogGeneration();
+
+    if (generation != catalogGeneration || context != sel || contextStar != star)
+    {
+        resolved = sim.findObjectFromPath(path);
+        context = sel;
+        contextStar = star;
+        generation = catalogGeneration;
+    }
+
+    return resolved;
+}
+
 void InstantaneousCommand::process(ExecutionEnvironment& env, double /*t*/, double /*dt*/)
 {
     processInstantaneous(env);
@@ -88,7 +111,7 @@ CommandSelect::CommandSelect(std::string _target) : target(std::move(_target))
 
 void CommandSelect::processInstantaneous(ExecutionEnvironment& env)
 {
-    Selection sel = env.getSimulation()->findObjectFromPath(target);
+    Selection sel = target.resolve(*env.getSimulation());
     env.getSimulation()->setSelection(sel);
 }
 
@@ -245,10 +268,10 @@ CommandSetFrame::CommandSetFrame(ObserverFrame::CoordinateSystem _coordSys,
 
 void CommandSetFrame::processInstantaneous(ExecutionEnvironment& env)
 {
-    Selection ref = env.getSimulation()->findObjectFromPath(refObjectName);
+    Selection ref = refObjectName.resolve(*env.getSimulation());
     Selection target;
     if (coordSys == ObserverFrame::CoordinateSystem::PhaseLock)
-        target = env.getSimulation()->findObjectFromPath(targetObjectName);
+        target = targetObjectName.resolve(*env.getSimulation());
     env.getSimulation()->setFrame(coordSys, ref, target);
 }
 
@@ -608,7 +631,7 @@ CommandMark::CommandMark(std::string _target,
 
 void CommandMark::processInstantaneous(ExecutionEnvironment& env)
 {
-    Selection sel = env.getSimulation()->findObjectFromPath(target);
+    Selection sel = target.resolve(*env.getSimulation());
     if (sel.empty())
         return;
 
@@ -631,7 +654,7 @@ CommandUnmark::CommandUnmark(std::string _target) :
 
 void CommandUnmark::processInstantaneous(ExecutionEnvironment& env)
 {
-    Selection sel = env.getSimulation()->findObjectFromPath(target);
+    Selection sel = target.resolve(*env.getSimulation());
     if (sel.empty())
         return;
 
@@ -661,7 +684,7 @@ CommandPreloadTextures::CommandPreloadTextures(std::string _name) :
 
 void CommandPreloadTextures::processInstantaneous(ExecutionEnvironment& env)
 {
-    Selection target = env.getSimulation()->findObjectFromPath(name);
+    Selection target = name.resolve(*env.getSimulation());
     if (target.body() == nullptr)
         return;
 
@@ -797,7 +820,7 @@ CommandSetRadius::CommandSetRadius(std::string _object, double _radius) :
 
 void CommandSetRadius::processInstantaneous(ExecutionEnvironment& env)
 {
-    Selection sel = env.getSimulation()->findObjectFromPath(object);
+    Selection sel = object.resolve(*env.getSimulation());
     if (sel.body() == nullptr)
         return;
 
@@ -1091,7 +1114,7 @@ void CommandSetRingsTexture::processInstantaneous(ExecutionEnvironment& env)
     if (textureName.empty())
         return;
 
-    auto body = env.getSimulation()->findObjectFromPath(object).body();
+    auto body = object.resolve(*env.getSimulation()).body();
     if (body == nullptr)
         return;
 
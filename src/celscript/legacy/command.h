@@ -28,9 +28,12 @@
 #include <celengine/observer.h>
 #include <celengine/multitexture.h>
 #include <celengine/renderflags.h>
+#include <celengine/selection.h>
 #include <celutil/color.h>
 
 enum class BodyClassification : std::uint32_t;
+class Simulation;
+class Star;
 
 namespace celestia::scripts
 {
@@ -50,6 +53,26 @@ class Command
 using CommandSequence = std::vector<std::unique_ptr<Command>>;
 
 
+// Name of an object used by a command. How a path resolves depends on the
+// selection and on the nearest solar system, so the object found is kept
+// for as long as those and the catalogs of the universe don't change; a
+// script which is run again and again doesn't look its objects up again.
+class ObjectPath
+{
+ public:
+    ObjectPath(std::string _path);
+
+    Selection resolve(const Simulation&) const;
+
+ private:
+    std::string path;
+    mutable Selection resolved;
+    mutable Selection context;
+    mutable const Star* contextStar{ nullptr };
+    mutable std::uint32_t generation{ 0 };
+};
+
+
 class InstantaneousCommand : public Command
 {
  public:
@@ -97,7 +120,7 @@ class CommandSelect : public InstantaneousCommand
     void processInstantaneous(ExecutionEnvironment&) override;
 
  private:
-    std::string target;
+    ObjectPath target;
 };
 
 
@@ -229,8 +252,8 @@ class CommandSetFrame : public InstantaneousCommand
 
  private:
     ObserverFrame::CoordinateSystem coordSys;
-    std::string refObjectName;
-    std::string targetObjectName;
+    ObjectPath refObjectName;
+    ObjectPath targetObjectName;
 };
 
 
@@ -563,7 +586,7 @@ class CommandPreloadTextures : public InstantaneousCommand
     void processInstantaneous(ExecutionEnvironment&) override;
 
  private:
-    std::string name;
+    ObjectPath name;
 };
 
 
@@ -576,7 +599,7 @@ class CommandMark : public InstantaneousCommand
     void processInstantaneous(ExecutionEnvironment&) override;
 
  private:
-    std::string target;
+    ObjectPath target;
     celestia::MarkerRepresentation rep;
     bool occludable;
 };
@@ -591,7 +614,7 @@ class CommandUnmark : public InstantaneousCommand
     void processInstantaneous(ExecutionEnvironment&) override;
 
  private:
-    std::string target;
+    ObjectPath target;
 };
 
 
@@ -686,7 +709,7 @@ class CommandSetRadius : public InstantaneousCommand
     void processInstantaneous(ExecutionEnvironment&) override;
 
  private:
-    std::string object;
+    ObjectPath object;
     double radius;
 };
 
@@ -809,7 +832,7 @@ class CommandSetRingsTexture : public InstantaneousCommand
     void processInstantaneous(ExecutionEnvironment&) override;
 
  private:
-    std::string object;
+    ObjectPath object;
     fs::path textureName;
     fs::path path;
 };
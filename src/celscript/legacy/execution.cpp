@@ -15,6 +15,12 @@ namespace celestia::scripts
 {
 
 Execution::Execution(CommandSequence&& cmd, ExecutionEnvironment& _env) :
+    Execution(std::make_shared<CommandSequence>(std::move(cmd)), _env)
+{
+}
+
+
+Execution::Execution(std::shared_ptr<CommandSequence> cmd, ExecutionEnvironment& _env) :
     commandSequence(std::move(cmd)),
     env(_env)
 {
@@ -32,9 +38,9 @@ bool Execution::tick(double dt)
         return false;
     }
 
-    while (dt > 0.0 && currentCommand < commandSequence.size())
+    while (dt > 0.0 && currentCommand < commandSequence->size())
     {
-        Command* cmd = commandSequence[currentCommand].get();
+        Command* cmd = (*commandSequence)[currentCommand].get();
 
         double timeLeft = cmd->getDuration() - commandTime;
         if (dt >= timeLeft)
@@ -52,7 +58,7 @@ bool Execution::tick(double dt)
         }
     }
 
-    return currentCommand == commandSequence.size();
+    return currentCommand == commandSequence->size();
 }
 
 }
@@ -9,8 +9,12 @@
 
 #include "legacyscript.h"
 
+#include <cstddef>
 #include <fstream>
 #include <istream>
+#include <iterator>
+#include <sstream>
+#include <utility>
 
 #include <celestia/celestiacore.h>
 #include <celutil/gettext.h>
@@ -60,6 +64,25 @@ public:
     }
 };
 
+// Parsed scripts kept by a plugin; they are few, so the cache is simply
+// emptied when it is full
+constexpr std::size_t MaxParsedScripts = 16;
+
+std::shared_ptr<CommandSequence>
+parseScript(std::istream& scriptfile, const ScriptMaps& scriptMaps, std::string& errorMsg)
+{
+    CommandParser parser(scriptfile, scriptMaps);
+    CommandSequence script = parser.parse();
+    if (script.empty())
+    {
+        auto errors = parser.getErrors();
+        if (!errors.empty())
+            errorMsg = errors[0];
+        return nullptr;
+    }
+    return std::make_shared<CommandSequence>(std::move(script));
+}
+
 } // end unnamed namespace
 
 LegacyScript::LegacyScript(CelestiaCore *core) :
@@ -70,19 +93,18 @@ LegacyScript::LegacyScript(CelestiaCore *core) :
 
 bool LegacyScript::load(std::istream &scriptfile, const fs::path &/*path*/, std::string &errorMsg)
 {
-    CommandParser parser(scriptfile, m_appCore->scriptMaps());
-    CommandSequence script = parser.parse();
-    if (script.empty())
-    {
-        auto errors = parser.getErrors();
-        if (!errors.empty())
-            errorMsg = errors[0];
+    auto script = parseScript(scriptfile, m_appCore->scriptMaps(), errorMsg);
+    if (script == nullptr)
         return false;
-    }
-    m_runningScript = std::make_unique<Execution>(std::move(script), *m_execEnv);
+    start(std::move(script));
     return true;
 }
 
+void LegacyScript::start(std::shared_ptr<CommandSequence> script)
+{
+    m_runningScript = std::make_unique<Execution>(std::move(script), *m_execEnv);
+}
+
 bool LegacyScript::tick(double dt)
 {
     return m_runningScript->tick(dt);
@@ -102,15 +124,30 @@ std::unique_ptr<IScript> LegacyScriptPlugin::loadScript(const fs::path &path)
         return nullptr;
     }
 
+    std::string contents(std::istreambuf_iterator<char>(scriptfile), {});
     auto script = std::make_unique<LegacyScript>(appCore());
+    if (auto it = m_parsedScripts.find(contents); it != m_parsedScripts.end())
+    {
+        script->start(it->second);
+        return script;
+    }
+
+    std::istringstream in(contents);
     std::string errorMsg;
-    if (!script->load(scriptfile, path, errorMsg))
+    auto commands = parseScript(in, appCore()->scriptMaps(), errorMsg);
+    if (commands == nullptr)
     {
         if (errorMsg.empty())
             errorMsg = _("Unknown error loading script");
         appCore()->fatalError(errorMsg);
         return nullptr;
     }
+
+    if (m_parsedScripts.size() >= MaxParsedScripts)
+        m_parsedScripts.clear();
+    m_parsedScripts.try_emplace(std::move(contents), commands);
+
+    script->start(std::move(commands));
     return script;
 }
 
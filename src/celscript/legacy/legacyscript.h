@@ -12,6 +12,8 @@
 #include <iosfwd>
 #include <memory>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include <celcompat/filesystem.h>
 #include <celscript/common/script.h>
@@ -22,9 +24,12 @@ class CelestiaCore;
 namespace celestia::scripts
 {
 
+class Command;
 class Execution;
 class ExecutionEnvironment;
 
+using CommandSequence = std::vector<std::unique_ptr<Command>>;
+
 class LegacyScript : public IScript
 {
  public:
@@ -36,6 +41,8 @@ class LegacyScript : public IScript
     bool tick(double) override;
 
  private:
+    void start(std::shared_ptr<CommandSequence>);
+
     CelestiaCore *m_appCore;
     std::unique_ptr<Execution> m_runningScript;
     std::unique_ptr<ExecutionEnvironment> m_execEnv;
@@ -56,6 +63,11 @@ class LegacyScriptPlugin : public IScriptPlugin
 
     bool isOurFile(const fs::path&) const override;
     std::unique_ptr<IScript> loadScript(const fs::path&) override;
+
+ private:
+    // Parsed scripts by their contents, so that a script which is run
+    // again isn't parsed again unless the file has changed
+    std::unordered_map<std::string, std::shared_ptr<CommandSequence>> m_parsedScripts;
 };
 
 } // end namespace celestia::scripts
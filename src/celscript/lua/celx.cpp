@@ -47,6 +47,9 @@
 #include "celx_celestia.h"
 #include "celx_gl.h"
 #include "celx_category.h"
+#include "celx_job.h"
+#include "celx_worker.h"
+#include "luaprofiler.h"
 
 using namespace Eigen;
 using namespace std;
@@ -72,12 +75,17 @@ static constexpr std::array CelxClassNames
     "class_texture"sv,
     "class_phase"sv,
     "class_category"sv,
+    "class_job"sv,
+    "class_worker"sv,
 };
 
 // Maximum timeslice a script may run without
 // returning control to celestia
 static const double MaxTimeslice = 5.0;
 
+// Functions listed when a profile is written to the log
+static constexpr std::size_t ProfileReportEntries = 30;
+
 // names of callback-functions in Lua:
 const char* KbdCallback = "celestia_keyboard_callback";
 const char* CleanupCallback = "celestia_cleanup_callback";
@@ -223,6 +231,9 @@ LuaState::LuaState() :
 
 LuaState::~LuaState()
 {
+    if (profiler != nullptr)
+        profiler->report(ProfileReportEntries);
+
     delete timer;
     if (state != nullptr)
         lua_close(state);
@@ -244,9 +255,18 @@ double LuaState::getTime() const
 }
 
 
+// Time used by wait() and celestia:getscripttime(), which is the real time
+// unless the core renders offline at a fixed time step: then scripts wait
+// for simulated frames, so that a batch render doesn't depend on speed.
+double LuaState::getScriptTime() const
+{
+    return fixedClock ? scriptClock : getTime() + clockOffset;
+}
+
+
 // Check if the running script has exceeded its allowed timeslice
 // and terminate it if it has:
-static void checkTimeslice(lua_State* l, lua_Debug* /*ar*/)
+static void checkTimeslice(lua_State* l, lua_Debug* ar)
 {
     lua_pushstring(l, "celestia-luastate");
     lua_gettable(l, LUA_REGISTRYINDEX);
@@ -263,16 +283,48 @@ static void checkTimeslice(lua_State* l, lua_Debug* /*ar*/)
         return;
     }
 
-    if (luastate->timesliceExpired())
+    // Call and return events are only requested by the profiler
+    if (ar->event == LUA_HOOKCOUNT && luastate->timesliceExpired())
     {
         const char* errormsg = "Timeout: script hasn't returned control to celestia (forgot to call wait()?)";
         GetLogger()->error("{}\n", errormsg);
         lua_pushstring(l, errormsg);
         lua_error(l);
     }
+
+    luastate->profileHook(l, ar);
 }
 
 
+namespace
+{
+
+// Times a run of the script or of one of its callbacks
+class ScriptSlice
+{
+public:
+    ScriptSlice(LuaState& _state, const char* _what) :
+        state(_state),
+        what(_what),
+        start(_state.getTime())
+    {
+        state.beginSlice(start);
+    }
+
+    ~ScriptSlice() { state.endSlice(what, start); }
+
+    ScriptSlice(const ScriptSlice&) = delete;
+    ScriptSlice& operator=(const ScriptSlice&) = delete;
+
+private:
+    LuaState& state;
+    const char* what;
+    double start;
+};
+
+} // end unnamed namespace
+
+
 // allow the script to perform cleanup
 void LuaState::cleanup()
 {
@@ -304,6 +356,7 @@ void LuaState::cleanup()
         return;
 
     timeout = getTime() + 1.0;
+    ScriptSlice slice(*this, "cleanup callback");
     if (lua_pcall(costate, 0, 0, 0) != 0)
     {
         GetLogger()->error("Error while executing cleanup-callback: {}\n",
@@ -326,7 +379,7 @@ bool LuaState::createThread()
     if (costate == nullptr)
         return false;
 
-    lua_sethook(costate, checkTimeslice, LUA_MASKCOUNT, 1000);
+    setHook();
     lua_pushvalue(state, -2);
     lua_xmove(state, costate, 1);  // move function from L to NL/
     alive = true;
@@ -343,6 +396,75 @@ string LuaState::getErrorMessage()
 }
 
 
+void LuaState::setHook()
+{
+    if (profiler == nullptr)
+        lua_sethook(costate, checkTimeslice, LUA_MASKCOUNT, 1000);
+    else
+        lua_sethook(costate,
+                    checkTimeslice,
+                    LUA_MASKCOUNT | LUA_MASKCALL | LUA_MASKRET,
+                    celestia::scripts::LuaProfiler::SampleInterval);
+}
+
+
+void LuaState::setProfilerEnabled(bool enable)
+{
+    if (enable == (profiler != nullptr))
+        return;
+
+    if (enable)
+        profiler = std::make_unique<celestia::scripts::LuaProfiler>();
+    else
+        profiler.reset();
+
+    if (costate != nullptr)
+        setHook();
+}
+
+
+celestia::scripts::LuaProfiler* LuaState::getProfiler() const
+{
+    return profiler.get();
+}
+
+
+void LuaState::setTimeBudget(double seconds)
+{
+    timeBudget = seconds;
+}
+
+
+void LuaState::profileHook(lua_State* l, lua_Debug* ar)
+{
+    if (profiler != nullptr)
+        profiler->hook(l, ar, getTime());
+}
+
+
+void LuaState::beginSlice(double time)
+{
+    if (profiler != nullptr)
+        profiler->beginSlice(time);
+}
+
+
+void LuaState::endSlice(const char* what, double start)
+{
+    if (!(timeBudget > 0.0))
+        return;
+
+    // Warn at most once a second so that a slow tick doesn't flood the log
+    double now = getTime();
+    if (now - start > timeBudget && now - lastBudgetWarning > 1.0)
+    {
+        GetLogger()->warn("Lua {} took {:.1f} ms, over the budget of {:.1f} ms\n",
+                          what, (now - start) * 1000.0, timeBudget * 1000.0);
+        lastBudgetWarning = now;
+    }
+}
+
+
 bool LuaState::timesliceExpired()
 {
     if (timeout < getTime())
@@ -476,6 +598,7 @@ bool LuaState::charEntered(const char* c_p)
     lua_getglobal(costate, KbdCallback);
     lua_pushstring(costate, c_p);
     timeout = getTime() + 1.0;
+    ScriptSlice slice(*this, "keyboard callback");
     if (lua_pcall(costate, 1, 1, 0) != 0)
     {
         GetLogger()->error("Error while executing keyboard-callback: {}\n",
@@ -523,6 +646,7 @@ bool LuaState::handleKeyEvent(const char* key)
         lua_settable(costate, -3);
 
         timeout = getTime() + 1.0;
+        ScriptSlice slice(*this, "key handler");
         if (lua_pcall(costate, 1, 1, 0) != 0)
         {
             GetLogger()->error("Error while executing keyboard callback: {}\n",
@@ -577,6 +701,7 @@ bool LuaState::handleMouseButtonEvent(float x, float y, int button, bool down)
         lua_settable(costate, -3);
 
         timeout = getTime() + 1.0;
+        ScriptSlice slice(*this, "mouse handler");
         if (lua_pcall(costate, 1, 1, 0) != 0)
         {
             GetLogger()->error("Error while executing keyboard callback: {}\n",
@@ -628,6 +753,7 @@ bool LuaState::handleTickEvent(double dt)
         lua_settable(costate, -3);
 
         timeout = getTime() + 1.0;
+        ScriptSlice slice(*this, "tick handler");
         if (lua_pcall(costate, 1, 1, 0) != 0)
         {
             GetLogger()->error("Error while executing tick callback: {}\n",
@@ -696,6 +822,7 @@ int LuaState::resume()
         return 0;
 
     timeout = getTime() + MaxTimeslice;
+    ScriptSlice slice(*this, "script");
     int nArgs = resumeLuaThread(state, co, 0);
     if (nArgs < 0)
     {
@@ -757,9 +884,22 @@ bool LuaState::tick(double dt)
     if (!isAlive())
         return false;
 
+    // Switching clocks doesn't make the script time jump
+    CelestiaCore* appCore = getAppCore(costate, NoErrors);
+    bool fixedStep = appCore != nullptr && appCore->getFixedTimeStep() > 0.0;
+    if (fixedStep != fixedClock)
+    {
+        if (fixedStep)
+            scriptClock = getScriptTime();
+        else
+            clockOffset = scriptClock - getTime();
+        fixedClock = fixedStep;
+    }
+    if (fixedClock)
+        scriptClock += dt;
+
     if (ioMode == IOMode::Asking)
     {
-        CelestiaCore* appCore = getAppCore(costate, NoErrors);
         if (appCore == nullptr)
         {
             GetLogger()->error("ERROR: appCore not found\n");
@@ -803,9 +943,16 @@ bool LuaState::tick(double dt)
         return false;
     }
 
-    if (dt == 0 || scriptAwakenTime > getTime())
+    if (dt == 0 || scriptAwakenTime > getScriptTime())
         return false;
 
+    if (waitingJob != nullptr)
+    {
+        if (!waitingJob->isReady())
+            return false;
+        waitingJob = nullptr;
+    }
+
     int nArgs = resume();
     if (!isAlive()) // The script is complete
         return true;
@@ -814,13 +961,13 @@ bool LuaState::tick(double dt)
     lua_State* state = getState();
 
     // The values on the stack indicate what event will wake up the
-    // script.  For now, we just support wait()
-    double delay;
+    // script: a delay passed to wait(), or a job to wait for
+    double delay = 0.0;
     if (nArgs == 1 && lua_isnumber(state, -1))
         delay = lua_tonumber(state, -1);
-    else
-        delay = 0.0;
-    scriptAwakenTime = getTime() + delay;
+    else if (CelxJobPtr* job = nArgs == 1 ? to_job(state, -1) : nullptr; job != nullptr)
+        waitingJob = *job;
+    scriptAwakenTime = getScriptTime() + delay;
 
     // Clean up the stack
     lua_pop(state, nArgs);
@@ -1102,6 +1249,12 @@ bool LuaState::init(CelestiaCore* appCore)
     lua_newtable(state);
     lua_settable(state, LUA_REGISTRYINDEX);
 
+    if (const CelestiaConfig* config = appCore->getConfig(); config != nullptr)
+    {
+        setProfilerEnabled(config->scriptProfiler);
+        setTimeBudget(config->scriptTimeBudget / 1000.0);
+    }
+
 #if 0
     lua_getglobal(state, "dofile"); // function "dofile" on stack
     lua_pushstring(state, "luainit.celx"); // parameter
@@ -1145,12 +1298,49 @@ static void loadLuaLibs(lua_State* state)
     CreateImageMetaTable(state);
     CreateTextureMetaTable(state);
     CreateCategoryMetaTable(state);
+    CreateJobMetaTable(state);
+    CreateWorkerMetaTable(state);
     ExtendCelestiaMetaTable(state);
     ExtendObjectMetaTable(state);
 
     LoadLuaGraphicsLibrary(state);
 }
 
+// Workers get neither system, package nor debug access, and only the part
+// of celx which may be used away from the main thread
+void LoadWorkerLuaLibs(lua_State* state, CelestiaCore* appCore)
+{
+    openLuaLibrary(state, "", luaopen_base);
+    openLuaLibrary(state, LUA_MATHLIBNAME, luaopen_math);
+    openLuaLibrary(state, LUA_TABLIBNAME, luaopen_table);
+    openLuaLibrary(state, LUA_STRLIBNAME, luaopen_string);
+#if LUA_VERSION_NUM >= 502
+    openLuaLibrary(state, LUA_COLIBNAME, luaopen_coroutine);
+#endif
+
+    // Don't let workers run code from files
+    lua_pushnil(state);
+    lua_setglobal(state, "dofile");
+    lua_pushnil(state);
+    lua_setglobal(state, "loadfile");
+
+    lua_pushnumber(state, celestia::astro::KM_PER_LY<lua_Number>/1e6);
+    lua_setglobal(state, "KM_PER_MICROLY");
+
+    CreateWorkerObjectMetaTable(state);
+    CreateWorkerCelestiaMetaTable(state);
+    CreatePositionMetaTable(state);
+    CreateVectorMetaTable(state);
+    CreateRotationMetaTable(state);
+    ExtendWorkerCelestiaMetaTable(state);
+
+    celestia_new(state, appCore);
+    lua_setglobal(state, "celestia");
+    lua_pushstring(state, "celestia-appcore");
+    lua_pushlightuserdata(state, static_cast<void*>(appCore));
+    lua_settable(state, LUA_REGISTRYINDEX);
+}
+
 
 void LuaState::allowSystemAccess()
 {
@@ -1205,6 +1395,7 @@ bool LuaState::callLuaHook(void* obj, const char* method)
         lua_remove(costate, -3);        // remove the Lua object from the stack
 
         timeout = getTime() + 1.0;
+        ScriptSlice slice(*this, method);
         if (lua_pcall(costate, 1, 1, 0) != 0)
         {
             GetLogger()->error("Error while executing Lua Hook: {}\n",
@@ -1249,6 +1440,7 @@ bool LuaState::callLuaHook(void* obj, const char* method, const char* keyName)
         lua_pushstring(costate, keyName);    // push the char onto the stack
 
         timeout = getTime() + 1.0;
+        ScriptSlice slice(*this, method);
         if (lua_pcall(costate, 2, 1, 0) != 0)
         {
             GetLogger()->error("Error while executing Lua Hook: {}\n",
@@ -1294,6 +1486,7 @@ bool LuaState::callLuaHook(void* obj, const char* method, float x, float y)
         lua_pushnumber(costate, y);          // push y onto the stack
 
         timeout = getTime() + 1.0;
+        ScriptSlice slice(*this, method);
         if (lua_pcall(costate, 3, 1, 0) != 0)
         {
             GetLogger()->error("Error while executing Lua Hook: {}\n",
@@ -1340,6 +1533,7 @@ bool LuaState::callLuaHook(void* obj, const char* method, float x, float y, int
         lua_pushnumber(costate, b);          // push b onto the stack
 
         timeout = getTime() + 1.0;
+        ScriptSlice slice(*this, method);
         if (lua_pcall(costate, 4, 1, 0) != 0)
         {
             GetLogger()->error("Error while executing Lua Hook: {}\n",
@@ -1383,6 +1577,7 @@ bool LuaState::callLuaHook(void* obj, const char* method, double dt)
         lua_pushnumber(costate, dt);
 
         timeout = getTime() + 1.0;
+        ScriptSlice slice(*this, method);
         if (lua_pcall(costate, 2, 1, 0) != 0)
         {
             GetLogger()->error("Error while executing Lua Hook: {}\n",
@@ -12,6 +12,7 @@
 #pragma once
 
 #include <iosfwd>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -30,10 +31,16 @@ int lua_isinteger(lua_State *L, int index);
 #endif
 
 class CelestiaCore;
+class CelxJob;
 
 namespace celestia
 {
 class View;
+
+namespace scripts
+{
+class LuaProfiler;
+}
 }
 
 class LuaState
@@ -60,6 +67,7 @@ public:
 
     bool charEntered(const char*);
     double getTime() const;
+    double getScriptTime() const;
     int screenshotCount;
     double timeout;
 
@@ -79,6 +87,14 @@ public:
     bool callLuaHook(void* obj, const char* method, float x, float y, int b);
     bool callLuaHook(void* obj, const char* method, double dt);
 
+    // Profiling and time budget of the script and its callbacks
+    void setProfilerEnabled(bool);
+    celestia::scripts::LuaProfiler* getProfiler() const;
+    void setTimeBudget(double seconds);
+    void profileHook(lua_State*, lua_Debug*);
+    void beginSlice(double time);
+    void endSlice(const char* what, double start);
+
     enum class IOMode
     {
         NotDetermined  = 1,
@@ -93,8 +109,20 @@ private:
     bool alive{ false };
     Timer* timer;
     double scriptAwakenTime{ 0.0 };
+    // Script time follows the ticks instead of the real time clock while
+    // the core steps time at a fixed rate
+    bool fixedClock{ false };
+    double scriptClock{ 0.0 };
+    double clockOffset{ 0.0 };
+    // Job passed to wait() by the script
+    std::shared_ptr<CelxJob> waitingJob;
     IOMode ioMode{ IOMode::NotDetermined };
     bool eventHandlerEnabled{ false };
+    std::unique_ptr<celestia::scripts::LuaProfiler> profiler;
+    double timeBudget{ 0.0 };
+    double lastBudgetWarning{ -1.0e10 };
+
+    void setHook();
 };
 
 celestia::View* getViewByObserver(const CelestiaCore*, const Observer*);
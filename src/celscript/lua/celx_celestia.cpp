@@ -10,26 +10,40 @@
 // of the License, or (at your option) any later version.
 
 #include <algorithm>
+#include <array>
 #include <cstdint>
 #include <iostream>
+#include <limits>
+#include <map>
+#include <optional>
+#include <string>
 #include <string_view>
+#include <utility>
+#include <vector>
 
 #include <fmt/format.h>
 
 #include <celcompat/filesystem.h>
 #include <celengine/category.h>
+#include <celengine/framestats.h>
+#include <celengine/hitchdetector.h>
+#include <celengine/memoryreport.h>
 #include <celengine/texture.h>
 #include <celestia/audiosession.h>
 #include <celestia/configfile.h>
+#include <celestia/eclipsefinder.h>
 #include <celestia/hud.h>
 #include <celestia/url.h>
 #include <celestia/celestiacore.h>
 #include <celestia/view.h>
+#include <celmath/mathlib.h>
 #include <celscript/common/scriptmaps.h>
 #include <celttf/truetypefont.h>
 #include <celutil/gettext.h>
 #include <celutil/logger.h>
 #include <celutil/stringutils.h>
+#include <celutil/strnatcmp.h>
+#include <celutil/threadpool.h>
 #include "celx.h"
 #include "celx_internal.h"
 #include "celx_celestia.h"
@@ -41,6 +55,9 @@
 #include "celx_rotation.h"
 #include "celx_vector.h"
 #include "celx_category.h"
+#include "celx_job.h"
+#include "celx_worker.h"
+#include "luaprofiler.h"
 
 using namespace std;
 using namespace std::string_view_literals;
@@ -1851,6 +1868,371 @@ static int celestia_getstar(lua_State* l)
     return 1;
 }
 
+// Columns returned by celestia:getstardata
+enum StarDataColumn : std::size_t
+{
+    StarDataIndex,
+    StarDataX,
+    StarDataY,
+    StarDataZ,
+    StarDataAbsMag,
+    StarDataAppMag,
+    StarDataDistance,
+    StarDataSpectralType,
+    StarDataName,
+    StarDataColumnCount,
+};
+
+constexpr std::array<const char*, StarDataColumnCount> StarDataColumnNames
+{
+    "index", "x", "y", "z", "absmag", "appmag", "distance", "spectraltype", "name",
+};
+
+static lua_Number getFilterNumber(lua_State* l, int filter, const char* key, lua_Number defaultValue)
+{
+    lua_getfield(l, filter, key);
+    lua_Number value = defaultValue;
+    if (lua_isnumber(l, -1))
+        value = lua_tonumber(l, -1);
+    else if (!lua_isnil(l, -1))
+        Celx_DoError(l, "Values in the filter of celestia:getstardata must be numbers");
+    lua_pop(l, 1);
+    return value;
+}
+
+// Returns a table of arrays, one per requested field, with the stars from
+// first to first + count - 1 in the order of celestia:stars() that pass the
+// filter. Positions are in light years and distances are from the active
+// observer. This avoids creating an object for every star when scanning
+// the whole catalog.
+static int celestia_getstardata(lua_State* l)
+{
+    Celx_CheckArgs(l, 4, 5, "Three or four arguments expected to function celestia:getstardata");
+
+    CelestiaCore* appCore = this_celestia(l);
+    double first = Celx_SafeGetNumber(l, 2, AllErrors, "First arg to celestia:getstardata must be a number");
+    double count = Celx_SafeGetNumber(l, 3, AllErrors, "Second arg to celestia:getstardata must be a number");
+    if (!lua_istable(l, 4))
+    {
+        Celx_DoError(l, "Third arg to celestia:getstardata must be a table of field names");
+        return 0;
+    }
+
+    std::array<bool, StarDataColumnCount> requested{};
+    for (int i = 1;; ++i)
+    {
+        lua_rawgeti(l, 4, i);
+        if (lua_isnil(l, -1))
+        {
+            lua_pop(l, 1);
+            break;
+        }
+
+        if (!lua_isstring(l, -1))
+        {
+            Celx_DoError(l, "Field names for celestia:getstardata must be strings");
+            return 0;
+        }
+
+        std::string_view field = lua_tostring(l, -1);
+        if (field == "position"sv)
+        {
+            requested[StarDataX] = requested[StarDataY] = requested[StarDataZ] = true;
+        }
+        else
+        {
+            auto it = std::find(StarDataColumnNames.begin(), StarDataColumnNames.end(), field);
+            if (it == StarDataColumnNames.end())
+            {
+                Celx_DoError(l, "Unknown field name for celestia:getstardata");
+                return 0;
+            }
+            requested[static_cast<std::size_t>(it - StarDataColumnNames.begin())] = true;
+        }
+        lua_pop(l, 1);
+    }
+
+    constexpr auto noLimit = std::numeric_limits<lua_Number>::infinity();
+    lua_Number maxAbsMag = noLimit;
+    lua_Number maxAppMag = noLimit;
+    lua_Number maxDistance = noLimit;
+    if (lua_gettop(l) == 5 && !lua_isnil(l, 5))
+    {
+        if (!lua_istable(l, 5))
+        {
+            Celx_DoError(l, "Fourth arg to celestia:getstardata must be a table");
+            return 0;
+        }
+        maxAbsMag = getFilterNumber(l, 5, "maxabsmag", noLimit);
+        maxAppMag = getFilterNumber(l, 5, "maxappmag", noLimit);
+        maxDistance = getFilterNumber(l, 5, "maxdistance", noLimit);
+    }
+
+    Universe* u = appCore->getSimulation()->getUniverse();
+    const StarDatabase* stars = u->getStarCatalog();
+    auto begin = static_cast<std::uint32_t>(std::clamp(first, 0.0, static_cast<double>(stars->size())));
+    auto end = static_cast<std::uint32_t>(std::clamp(first + count, static_cast<double>(begin), static_cast<double>(stars->size())));
+
+    Vector3d observerPosition = Vector3d::Zero();
+    if (const Observer* o = appCore->getSimulation()->getActiveObserver(); o != nullptr)
+        observerPosition = o->getPosition().toLy();
+
+    bool needDistance = requested[StarDataAppMag] || requested[StarDataDistance]
+                     || maxAppMag != noLimit || maxDistance != noLimit;
+
+    // One array per requested column, kept on the stack while filling them
+    lua_newtable(l);
+    int result = lua_gettop(l);
+    std::array<int, StarDataColumnCount> columns{};
+    for (std::size_t i = 0; i < StarDataColumnCount; ++i)
+    {
+        if (!requested[i])
+            continue;
+        lua_newtable(l);
+        lua_pushvalue(l, -1);
+        lua_setfield(l, result, StarDataColumnNames[i]);
+        columns[i] = lua_gettop(l);
+    }
+
+    int n = 0;
+    for (std::uint32_t i = begin; i < end; ++i)
+    {
+        const Star* star = stars->getStar(i);
+        if (star == nullptr)
+            continue;
+
+        float absMag = star->getAbsoluteMagnitude();
+        if (absMag > maxAbsMag)
+            continue;
+
+        double distance = 0.0;
+        float appMag = absMag;
+        if (needDistance)
+        {
+            distance = (star->getPosition().cast<double>() - observerPosition).norm();
+            appMag = star->getApparentMagnitude(static_cast<float>(distance));
+            if (distance > maxDistance || appMag > maxAppMag)
+                continue;
+        }
+
+        ++n;
+        auto setColumn = [&](StarDataColumn column, lua_Number value)
+        {
+            if (columns[column] == 0)
+                return;
+            lua_pushnumber(l, value);
+            lua_rawseti(l, columns[column], n);
+        };
+
+        setColumn(StarDataIndex, star->getIndex());
+        setColumn(StarDataX, star->getPosition().x());
+        setColumn(StarDataY, star->getPosition().y());
+        setColumn(StarDataZ, star->getPosition().z());
+        setColumn(StarDataAbsMag, absMag);
+        setColumn(StarDataAppMag, appMag);
+        setColumn(StarDataDistance, distance);
+        if (columns[StarDataSpectralType] != 0)
+        {
+            lua_pushstring(l, star->getSpectralType());
+            lua_rawseti(l, columns[StarDataSpectralType], n);
+        }
+        if (columns[StarDataName] != 0)
+        {
+            std::string name = stars->getStarName(*star);
+            lua_pushlstring(l, name.data(), name.size());
+            lua_rawseti(l, columns[StarDataName], n);
+        }
+    }
+
+    lua_settop(l, result);
+    setTable(l, "count", n);
+
+    return 1;
+}
+
+// Parameters of celestia:findstars and celestia:finddsos
+struct SpatialQuery
+{
+    UniversalCoord position;
+    double radius{ 0.0 };
+    std::optional<Vector3d> direction;
+    double angle{ 0.0 };
+    std::optional<Quaterniond> rotation;
+    double fov{ 45.0 };
+    double aspect{ 1.0 };
+    double limitingMag{ 6.0 };
+    std::size_t first{ 1 };
+    std::size_t count{ std::numeric_limits<std::size_t>::max() };
+};
+
+static double getQueryNumber(lua_State* l, const char* key, double defaultValue)
+{
+    lua_getfield(l, 2, key);
+    double value = defaultValue;
+    if (lua_isnumber(l, -1))
+        value = lua_tonumber(l, -1);
+    else if (!lua_isnil(l, -1))
+        Celx_DoError(l, "Numeric field in the query table has the wrong type");
+    lua_pop(l, 1);
+    return value;
+}
+
+static bool getSpatialQuery(lua_State* l, const char* function, SpatialQuery& query)
+{
+    Celx_CheckArgs(l, 2, 2, "One table argument expected");
+    if (!lua_istable(l, 2))
+    {
+        Celx_DoError(l, fmt::format("Argument to {} must be a table", function).c_str());
+        return false;
+    }
+
+    CelestiaCore* appCore = this_celestia(l);
+    lua_getfield(l, 2, "position");
+    if (lua_isnil(l, -1))
+    {
+        // Workers have no access to the observer
+        if (CelxWorker::fromState(l) != nullptr)
+            Celx_DoError(l, fmt::format("Queries of {} in a worker need a position", function).c_str());
+        if (const Observer* o = appCore->getSimulation()->getActiveObserver(); o != nullptr)
+            query.position = o->getPosition();
+    }
+    else if (const UniversalCoord* position = to_position(l, -1); position != nullptr)
+        query.position = *position;
+    else
+        Celx_DoError(l, "Field position of the query must be a position");
+    lua_pop(l, 1);
+
+    lua_getfield(l, 2, "direction");
+    if (!lua_isnil(l, -1))
+    {
+        if (const Vector3d* direction = to_vector(l, -1); direction != nullptr && !direction->isZero())
+            query.direction = *direction;
+        else
+            Celx_DoError(l, "Field direction of the query must be a non-zero vector");
+    }
+    lua_pop(l, 1);
+
+    lua_getfield(l, 2, "rotation");
+    if (!lua_isnil(l, -1))
+    {
+        if (const Quaterniond* rotation = to_rotation(l, -1); rotation != nullptr)
+            query.rotation = *rotation;
+        else
+            Celx_DoError(l, "Field rotation of the query must be a rotation");
+    }
+    lua_pop(l, 1);
+
+    query.radius = getQueryNumber(l, "radius", 0.0);
+    query.angle = getQueryNumber(l, "angle", 0.0);
+    query.fov = getQueryNumber(l, "fov", query.fov);
+    query.aspect = getQueryNumber(l, "aspect", query.aspect);
+    query.limitingMag = getQueryNumber(l, "limitingmag", query.limitingMag);
+    query.first = static_cast<std::size_t>(std::max(getQueryNumber(l, "first", 1.0), 1.0));
+    if (double count = getQueryNumber(l, "count", -1.0); count >= 0.0)
+        query.count = static_cast<std::size_t>(count);
+
+    if (!query.rotation.has_value() && !(query.radius > 0.0))
+    {
+        Celx_DoError(l, fmt::format("Query of {} needs a radius or a rotation", function).c_str());
+        return false;
+    }
+
+    return true;
+}
+
+// Pushes a table of the objects nearest first, from query.first for at
+// most query.count objects, so that large results can be read in batches
+template<typename T>
+static void pushQueryResults(lua_State* l, const SpatialQuery& query, std::vector<const T*>& objects)
+{
+    Vector3d origin = query.position.toLy();
+    std::vector<std::pair<double, const T*>> sorted;
+    sorted.reserve(objects.size());
+    for (const T* obj : objects)
+        sorted.emplace_back((obj->getPosition().template cast<double>() - origin).squaredNorm(), obj);
+    std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    lua_newtable(l);
+    std::size_t begin = std::min(query.first - 1, sorted.size());
+    std::size_t end = begin + std::min(query.count, sorted.size() - begin);
+    for (std::size_t i = begin; i < end; ++i)
+    {
+        object_new(l, Selection(const_cast<T*>(sorted[i].second))); //NOSONAR
+        lua_rawseti(l, -2, static_cast<int>(i - begin + 1));
+    }
+}
+
+// Stars within a radius in light years of a position, optionally within a
+// cone of half angle angle degrees about direction, or else in the view of
+// an observer with the given rotation, fov, aspect and limitingmag
+static int celestia_findstars(lua_State* l)
+{
+    SpatialQuery query;
+    if (!getSpatialQuery(l, "celestia:findstars", query))
+        return 0;
+
+    const Universe* u = this_celestia(l)->getSimulation()->getUniverse();
+    std::vector<const Star*> stars;
+    if (query.rotation.has_value())
+    {
+        u->getStarsInView(query.position,
+                          query.rotation->cast<float>(),
+                          static_cast<float>(math::degToRad(query.fov)),
+                          static_cast<float>(query.aspect),
+                          static_cast<float>(query.limitingMag),
+                          stars);
+    }
+    else if (query.direction.has_value())
+    {
+        u->getStarsInCone(query.position,
+                          query.direction->cast<float>(),
+                          static_cast<float>(math::degToRad(query.angle)),
+                          static_cast<float>(query.radius),
+                          stars);
+    }
+    else
+    {
+        u->getNearStars(query.position, static_cast<float>(query.radius), stars);
+    }
+
+    pushQueryResults(l, query, stars);
+    return 1;
+}
+
+static int celestia_finddsos(lua_State* l)
+{
+    SpatialQuery query;
+    if (!getSpatialQuery(l, "celestia:finddsos", query))
+        return 0;
+
+    const Universe* u = this_celestia(l)->getSimulation()->getUniverse();
+    std::vector<const DeepSkyObject*> dsos;
+    if (query.rotation.has_value())
+    {
+        u->getDSOsInView(query.position,
+                         query.rotation->cast<float>(),
+                         static_cast<float>(math::degToRad(query.fov)),
+                         static_cast<float>(query.aspect),
+                         static_cast<float>(query.limitingMag),
+                         dsos);
+    }
+    else if (query.direction.has_value())
+    {
+        u->getDSOsInCone(query.position,
+                         query.direction->cast<float>(),
+                         static_cast<float>(math::degToRad(query.angle)),
+                         static_cast<float>(query.radius),
+                         dsos);
+    }
+    else
+    {
+        u->getNearDSOs(query.position, static_cast<float>(query.radius), dsos);
+    }
+
+    pushQueryResults(l, query, dsos);
+    return 1;
+}
+
 static int celestia_getdso(lua_State* l)
 {
     Celx_CheckArgs(l, 2, 2, "One argument expected to function celestia:getdso");
@@ -1949,10 +2331,435 @@ static int celestia_getscripttime(lua_State* l)
     this_celestia(l);
 
     LuaState* luastate_ptr = getLuaStateObject(l);
-    lua_pushnumber(l, luastate_ptr->getTime());
+    lua_pushnumber(l, luastate_ptr->getScriptTime());
+    return 1;
+}
+
+// Functions of the profile written to the log or returned by "report"
+constexpr std::size_t ProfilerReportEntries = 30;
+
+static int celestia_profiler(lua_State* l)
+{
+    Celx_CheckArgs(l, 2, 2, "One argument expected for celestia:profiler");
+    // for error checking only:
+    this_celestia(l);
+
+    std::string_view command = Celx_SafeGetString(l, 2, AllErrors, "Argument to celestia:profiler must be a string");
+    LuaState* luastate = getLuaStateObject(l);
+
+    if (command == "start"sv)
+    {
+        luastate->setProfilerEnabled(true);
+        return 0;
+    }
+
+    celestia::scripts::LuaProfiler* profiler = luastate->getProfiler();
+    if (command == "stop"sv)
+    {
+        if (profiler != nullptr)
+            profiler->report(ProfilerReportEntries);
+        luastate->setProfilerEnabled(false);
+        return 0;
+    }
+    if (command == "reset"sv)
+    {
+        if (profiler != nullptr)
+            profiler->reset();
+        return 0;
+    }
+    if (command != "report"sv)
+    {
+        Celx_DoError(l, "Argument to celestia:profiler must be \"start\", \"stop\", \"reset\" or \"report\"");
+        return 0;
+    }
+
+    lua_newtable(l);
+    if (profiler == nullptr)
+        return 1;
+
+    profiler->report(ProfilerReportEntries);
+    auto entries = profiler->getEntries();
+    for (std::size_t i = 0; i < entries.size(); ++i)
+    {
+        const auto& entry = entries[i];
+        lua_newtable(l);
+        lua_pushstring(l, entry.name.c_str());
+        lua_setfield(l, -2, "name");
+        lua_pushnumber(l, entry.time * 1000.0);
+        lua_setfield(l, -2, "time");
+        lua_pushnumber(l, static_cast<lua_Number>(entry.calls));
+        lua_setfield(l, -2, "calls");
+        lua_pushnumber(l, static_cast<lua_Number>(entry.samples));
+        lua_setfield(l, -2, "samples");
+        lua_pushboolean(l, entry.isCFunction);
+        lua_setfield(l, -2, "cfunction");
+        lua_rawseti(l, -2, static_cast<int>(i + 1));
+    }
+
+    return 1;
+}
+
+namespace
+{
+
+// Stops an eclipse search when its job is cancelled or no longer referenced
+class EclipseJobWatcher : public EclipseFinderWatcher
+{
+ public:
+    explicit EclipseJobWatcher(std::weak_ptr<CelxJob> _job) : job(std::move(_job)) {}
+
+    Status eclipseFinderProgressUpdate(double /*t*/) override
+    {
+        auto ptr = job.lock();
+        return ptr == nullptr || ptr->isCancelled() ? AbortOperation : ContinueOperation;
+    }
+
+ private:
+    std::weak_ptr<CelxJob> job;
+};
+
+int pushEclipses(lua_State* l, const std::vector<Eclipse>& eclipses)
+{
+    lua_createtable(l, static_cast<int>(eclipses.size()), 0);
+    for (std::size_t i = 0; i < eclipses.size(); ++i)
+    {
+        const Eclipse& eclipse = eclipses[i];
+        lua_createtable(l, 0, 4);
+        object_new(l, Selection(eclipse.occulter));
+        lua_setfield(l, -2, "occulter");
+        object_new(l, Selection(eclipse.receiver));
+        lua_setfield(l, -2, "receiver");
+        lua_pushnumber(l, eclipse.startTime);
+        lua_setfield(l, -2, "starttime");
+        lua_pushnumber(l, eclipse.endTime);
+        lua_setfield(l, -2, "endtime");
+        lua_rawseti(l, -2, static_cast<int>(i + 1));
+    }
     return 1;
 }
 
+int pushCompletions(lua_State* l, const std::vector<celestia::engine::Completion>& completions)
+{
+    lua_createtable(l, static_cast<int>(completions.size()), 0);
+    for (std::size_t i = 0; i < completions.size(); ++i)
+    {
+        lua_createtable(l, 0, 2);
+        lua_pushstring(l, completions[i].getName().c_str());
+        lua_setfield(l, -2, "name");
+        object_new(l, completions[i].getSelection());
+        lua_setfield(l, -2, "object");
+        lua_rawseti(l, -2, static_cast<int>(i + 1));
+    }
+    return 1;
+}
+
+} // end unnamed namespace
+
+// Starts a search for the eclipses of a body and its satellites. The
+// search runs on the thread pool unless some of the orbits are scripted.
+static int celestia_findeclipses(lua_State* l)
+{
+    Celx_CheckArgs(l, 4, 5, "Three or four arguments expected for celestia:findeclipses");
+    // for error checking only:
+    this_celestia(l);
+
+    Selection* sel = to_object(l, 2);
+    if (sel == nullptr || sel->body() == nullptr)
+    {
+        Celx_DoError(l, "First argument to celestia:findeclipses must be a body");
+        return 0;
+    }
+
+    double startTime = Celx_SafeGetNumber(l, 3, AllErrors, "Second argument to celestia:findeclipses must be a number");
+    double endTime = Celx_SafeGetNumber(l, 4, AllErrors, "Third argument to celestia:findeclipses must be a number");
+
+    int eclipseTypeMask = Eclipse::Solar | Eclipse::Lunar;
+    if (lua_gettop(l) >= 5)
+    {
+        std::string_view type = Celx_SafeGetString(l, 5, AllErrors, "Fourth argument to celestia:findeclipses must be a string");
+        if (type == "solar"sv)
+            eclipseTypeMask = Eclipse::Solar;
+        else if (type == "lunar"sv)
+            eclipseTypeMask = Eclipse::Lunar;
+        else if (type != "all"sv)
+            Celx_DoError(l, "Fourth argument to celestia:findeclipses must be \"solar\", \"lunar\" or \"all\"");
+    }
+
+    auto job = std::make_shared<CelxFutureJob<std::vector<Eclipse>>>(pushEclipses);
+    const Body* body = sel->body();
+    auto search = [weakJob = std::weak_ptr<CelxJob>(job), body, startTime, endTime, eclipseTypeMask]
+    {
+        EclipseJobWatcher watcher(weakJob);
+        std::vector<Eclipse> eclipses;
+        EclipseFinder(body, &watcher).findEclipses(startTime, endTime, eclipseTypeMask, eclipses);
+        return eclipses;
+    };
+
+    if (EclipseFinder(body).isThreadSafe())
+        job->setFuture(celestia::util::GetThreadPool()->async(std::move(search)));
+    else
+        job->setResult(search());
+
+    return job_new(l, job);
+}
+
+// Starts completing an object name in the context of the current selection,
+// as the goto object dialog does.
+static int celestia_findcompletions(lua_State* l)
+{
+    Celx_CheckArgs(l, 2, 3, "One or two arguments expected for celestia:findcompletions");
+    CelestiaCore* appCore = this_celestia(l);
+
+    std::string prefix = Celx_SafeGetString(l, 2, AllErrors, "First argument to celestia:findcompletions must be a string");
+    bool withLocations = lua_gettop(l) >= 3 && lua_toboolean(l, 3) != 0;
+
+    const Simulation* sim = appCore->getSimulation();
+    const Universe* universe = sim->getUniverse();
+    auto job = std::make_shared<CelxFutureJob<std::vector<celestia::engine::Completion>>>(pushCompletions);
+    job->setFuture(celestia::util::GetThreadPool()->async(
+        [universe, contexts = sim->getCompletionContexts(), prefix = std::move(prefix), withLocations]
+        {
+            std::vector<celestia::engine::Completion> completions;
+            universe->getCompletionPath(completions, prefix, { contexts.data(), contexts.size() }, withLocations);
+            std::sort(completions.begin(), completions.end(),
+                      [](const celestia::engine::Completion& c0, const celestia::engine::Completion& c1)
+                      { return strnatcmp(c0.getName(), c1.getName()) < 0; });
+            return completions;
+        }));
+
+    return job_new(l, job);
+}
+
+// Starts a Lua chunk in a worker state running on a thread of its own
+static int celestia_newworker(lua_State* l)
+{
+    Celx_CheckArgs(l, 2, 3, "One or two arguments expected for celestia:newworker");
+    CelestiaCore* appCore = this_celestia(l);
+
+    const char* source = Celx_SafeGetString(l, 2, AllErrors, "First argument to celestia:newworker must be a string");
+    const char* name = Celx_SafeGetString(l, 3, WrongType, "Second argument to celestia:newworker must be a string");
+    if (source == nullptr)
+        return 0;
+
+    auto worker = std::make_shared<CelxWorker>(appCore, name == nullptr ? "worker" : name);
+    std::string error;
+    if (!worker->start(source, error))
+    {
+        Celx_DoError(l, error.c_str());
+        return 0;
+    }
+
+    return worker_new(l, worker);
+}
+
+// Workers only find objects by their full path, as they have no access to
+// the selection
+static int celestia_find_worker(lua_State* l)
+{
+    Celx_CheckArgs(l, 2, 2, "One argument expected for function celestia:find()");
+    if (!lua_isstring(l, 2))
+    {
+        Celx_DoError(l, "Argument to find must be a string");
+        return 0;
+    }
+
+    CelestiaCore* appCore = this_celestia(l);
+    const Universe* universe = appCore->getSimulation()->getUniverse();
+    Selection sel = universe->findPath(lua_tostring(l, 2), {});
+    object_new(l, sel);
+
+    return 1;
+}
+
+static int celestia_setfixedtimestep(lua_State* l)
+{
+    Celx_CheckArgs(l, 2, 2, "One argument expected for celestia:setfixedtimestep");
+    CelestiaCore* appCore = this_celestia(l);
+
+    double dt = Celx_SafeGetNumber(l, 2, AllErrors, "Argument to celestia:setfixedtimestep must be a number");
+    appCore->setFixedTimeStep(dt);
+    return 0;
+}
+
+static int celestia_getfixedtimestep(lua_State* l)
+{
+    Celx_CheckArgs(l, 1, 1, "No arguments expected for celestia:getfixedtimestep");
+    CelestiaCore* appCore = this_celestia(l);
+
+    lua_pushnumber(l, appCore->getFixedTimeStep());
+    return 1;
+}
+
+// Counters of the last complete frame, from the tick running the scripts to
+// the views drawn after it. The times are in milliseconds; gpu and
+// gpustages are nil without timer queries.
+static int celestia_getframestats(lua_State* l)
+{
+    Celx_CheckArgs(l, 1, 1, "No arguments expected for celestia:getframestats");
+    this_celestia(l);
+
+    const celestia::engine::FrameCounters& counters = celestia::engine::GetFrameStats()->getLastFrame();
+
+    lua_createtable(l, 0, 14);
+    lua_pushnumber(l, static_cast<lua_Number>(counters.frame));
+    lua_setfield(l, -2, "frame");
+    lua_pushnumber(l, counters.starsProcessed);
+    lua_setfield(l, -2, "stars");
+    lua_pushnumber(l, counters.dsosProcessed);
+    lua_setfield(l, -2, "dsos");
+    lua_pushnumber(l, counters.galaxyPoints);
+    lua_setfield(l, -2, "galaxypoints");
+    lua_pushnumber(l, counters.renderListSize);
+    lua_setfield(l, -2, "renderlist");
+    lua_pushnumber(l, counters.drawCalls);
+    lua_setfield(l, -2, "drawcalls");
+    lua_pushnumber(l, counters.textureUploads);
+    lua_setfield(l, -2, "textureuploads");
+    lua_pushnumber(l, counters.lightingComputed);
+    lua_setfield(l, -2, "lightingcomputed");
+    lua_pushnumber(l, counters.lightingReused);
+    lua_setfield(l, -2, "lightingreused");
+
+    double cpuTime = 0.0;
+    lua_createtable(l, 0, static_cast<int>(celestia::engine::FrameStageCount));
+    for (std::size_t i = 0; i < celestia::engine::FrameStageCount; ++i)
+    {
+        auto name = celestia::engine::GetFrameStageName(static_cast<celestia::engine::FrameStage>(i));
+        lua_pushnumber(l, counters.stageTimes[i]);
+        lua_setfield(l, -2, std::string(name).c_str());
+        cpuTime += counters.stageTimes[i];
+    }
+    lua_setfield(l, -2, "stages");
+
+    lua_pushnumber(l, cpuTime);
+    lua_setfield(l, -2, "cpu");
+    if (counters.gpuTime.has_value())
+    {
+        lua_pushnumber(l, *counters.gpuTime);
+        lua_setfield(l, -2, "gpu");
+    }
+    if (counters.gpuStageTimes.has_value())
+    {
+        lua_createtable(l, 0, static_cast<int>(celestia::engine::GPUStageCount));
+        for (std::size_t i = 0; i < celestia::engine::GPUStageCount; ++i)
+        {
+            auto name = celestia::engine::GetGPUStageName(static_cast<celestia::engine::GPUStage>(i));
+            lua_pushnumber(l, (*counters.gpuStageTimes)[i]);
+            lua_setfield(l, -2, std::string(name).c_str());
+        }
+        lua_setfield(l, -2, "gpustages");
+    }
+    if (counters.inputLatency.has_value())
+    {
+        lua_pushnumber(l, *counters.inputLatency);
+        lua_setfield(l, -2, "inputlatency");
+    }
+
+    return 1;
+}
+
+// Counters of the last frame and memory held by the renderer, keyed by the
+// names of Renderer::getFrameStats
+static int celestia_getrenderstats(lua_State* l)
+{
+    Celx_CheckArgs(l, 1, 1, "No arguments expected for celestia:getrenderstats");
+    CelestiaCore* appCore = this_celestia(l);
+
+    std::map<std::string, double> stats;
+    appCore->getRenderer()->getFrameStats(stats);
+
+    lua_createtable(l, 0, static_cast<int>(stats.size()));
+    for (const auto& [name, value] : stats)
+    {
+        lua_pushnumber(l, value);
+        lua_setfield(l, -2, name.c_str());
+    }
+
+    return 1;
+}
+
+// The memory report, as a table of the bytes of each entry and of their
+// total
+static int celestia_getmemoryreport(lua_State* l)
+{
+    Celx_CheckArgs(l, 1, 1, "No arguments expected for celestia:getmemoryreport");
+    CelestiaCore* appCore = this_celestia(l);
+
+    celestia::engine::MemoryReport report;
+    appCore->getMemoryReport(report);
+
+    const auto& entries = report.getEntries();
+    lua_createtable(l, 0, static_cast<int>(entries.size()) + 1);
+    for (const auto& entry : entries)
+    {
+        lua_pushnumber(l, static_cast<lua_Number>(entry.bytes));
+        lua_setfield(l, -2, entry.name.c_str());
+    }
+    lua_pushnumber(l, static_cast<lua_Number>(report.getTotalBytes()));
+    lua_setfield(l, -2, "total");
+
+    return 1;
+}
+
+// Returns the number of hitches of the session and the causes which took
+// the most time in them, ten unless a count is given
+static int celestia_gethitches(lua_State* l)
+{
+    Celx_CheckArgs(l, 1, 2, "At most one argument expected for celestia:gethitches");
+    CelestiaCore* appCore = this_celestia(l);
+
+    auto count = static_cast<std::size_t>(std::max(0.0, Celx_SafeGetNumber(l, 2, WrongType, "gethitches: argument must be a number", 10.0)));
+    const celestia::engine::HitchDetector& detector = appCore->getHitchDetector();
+    std::vector<celestia::engine::HitchCause> causes = detector.getTopCauses(count);
+
+    lua_createtable(l, 0, 2);
+    lua_pushnumber(l, static_cast<lua_Number>(detector.getHitchCount()));
+    lua_setfield(l, -2, "count");
+
+    lua_createtable(l, static_cast<int>(causes.size()), 0);
+    for (std::size_t i = 0; i < causes.size(); ++i)
+    {
+        const auto& cause = causes[i];
+        lua_createtable(l, 0, 5);
+        lua_pushstring(l, cause.category.c_str());
+        lua_setfield(l, -2, "category");
+        lua_pushstring(l, cause.name.c_str());
+        lua_setfield(l, -2, "name");
+        lua_pushnumber(l, static_cast<lua_Number>(cause.count));
+        lua_setfield(l, -2, "count");
+        lua_pushnumber(l, static_cast<lua_Number>(cause.totalTime));
+        lua_setfield(l, -2, "total");
+        lua_pushnumber(l, static_cast<lua_Number>(cause.maxTime));
+        lua_setfield(l, -2, "max");
+        lua_rawseti(l, -2, static_cast<int>(i) + 1);
+    }
+    lua_setfield(l, -2, "causes");
+
+    return 1;
+}
+
+static int celestia_istracing(lua_State* l)
+{
+    Celx_CheckArgs(l, 1, 1, "No argument expected for celestia:istracing");
+    CelestiaCore* appCore = this_celestia(l);
+
+    lua_pushboolean(l, appCore->isTracing());
+
+    return 1;
+}
+
+// Starts recording a trace, or stops it and writes it
+static int celestia_settracing(lua_State* l)
+{
+    Celx_CheckArgs(l, 2, 2, "One argument expected for celestia:settracing");
+    CelestiaCore* appCore = this_celestia(l);
+
+    bool enable = Celx_SafeGetBoolean(l, 2, AllErrors, "Argument to celestia:settracing must be a boolean", false);
+    appCore->setTracing(enable);
+
+    return 0;
+}
+
 static int celestia_newframe(lua_State* l)
 {
     Celx_CheckArgs(l, 2, 4, "One to three arguments expected for function celestia:newframe");
@@ -2278,6 +3085,18 @@ static int celestia_overlay(lua_State* l)
     return 0;
 }
 
+static int celestia_preloadoverlay(lua_State* l)
+{
+    Celx_CheckArgs(l, 2, 2, "One argument expected to function celestia:preloadoverlay");
+
+    CelestiaCore* appCore = this_celestia(l);
+    const char* filename = Celx_SafeGetString(l, 2, AllErrors, "Argument to celestia:preloadoverlay must be a string (filename)");
+    if (filename != nullptr)
+        OverlayImage::preload(filename, appCore->getRenderer());
+
+    return 0;
+}
+
 static int celestia_verbosity(lua_State* l)
 {
     Celx_CheckArgs(l, 2, 2, "One argument expected to function celestia:verbosity");
@@ -2382,6 +3201,32 @@ static int celestia_playaudio(lua_State* l)
     return 1;
 }
 
+static int celestia_preloadaudio(lua_State* l)
+{
+#ifdef USE_MINIAUDIO
+    Celx_CheckArgs(l, 3, 7, "Function celestia:preloadaudio requires two to six arguments");
+    int channel = celestia_getchannel(l, "First argument for celestia:preloadaudio must be a number");
+
+    const char* path = Celx_SafeGetString(l, 3, AllErrors, "Second argument to celestia:preloadaudio must be a string");
+    if (path == nullptr)
+    {
+        lua_pushboolean(l, false);
+        return 1;
+    }
+
+    float volume = clamp(static_cast<float>(Celx_SafeGetNumber(l, 4, WrongType, "Third argument to celestia:preloadaudio must be a number", static_cast<lua_Number>(defaultAudioVolume))), minAudioVolume, maxAudioVolume);
+    float pan = clamp(static_cast<float>(Celx_SafeGetNumber(l, 5, WrongType, "Fourth argument to celestia:preloadaudio must be a number", static_cast<lua_Number>(defaultAudioPan))), minAudioPan, maxAudioPan);
+    bool loop = Celx_SafeGetBoolean(l, 6, WrongType, "Fifth argument to celestia:preloadaudio must be a boolean", false);
+    bool nopause = Celx_SafeGetBoolean(l, 7, WrongType, "Sixth argument to celestia:preloadaudio must be a boolean", false);
+    CelestiaCore* appCore = this_celestia(l);
+    lua_pushboolean(l, appCore->preloadAudio(channel, path, volume, pan, loop, nopause));
+#else
+    Celx_DoError(l, "Audio playback is not supported");
+    lua_pushboolean(l, false);
+#endif
+    return 1;
+}
+
 static int celestia_resumeaudio(lua_State* l)
 {
 #ifdef USE_MINIAUDIO
@@ -2624,12 +3469,27 @@ void CreateCelestiaMetaTable(lua_State* l)
     Celx_RegisterMethod(l, "getstarcount", celestia_getstarcount);
     Celx_RegisterMethod(l, "getdsocount", celestia_getdsocount);
     Celx_RegisterMethod(l, "getstar", celestia_getstar);
+    Celx_RegisterMethod(l, "getstardata", celestia_getstardata);
+    Celx_RegisterMethod(l, "findstars", celestia_findstars);
+    Celx_RegisterMethod(l, "finddsos", celestia_finddsos);
     Celx_RegisterMethod(l, "getdso", celestia_getdso);
     Celx_RegisterMethod(l, "newframe", celestia_newframe);
     Celx_RegisterMethod(l, "newvector", celestia_newvector);
     Celx_RegisterMethod(l, "newposition", celestia_newposition);
     Celx_RegisterMethod(l, "newrotation", celestia_newrotation);
     Celx_RegisterMethod(l, "getscripttime", celestia_getscripttime);
+    Celx_RegisterMethod(l, "profiler", celestia_profiler);
+    Celx_RegisterMethod(l, "findeclipses", celestia_findeclipses);
+    Celx_RegisterMethod(l, "findcompletions", celestia_findcompletions);
+    Celx_RegisterMethod(l, "newworker", celestia_newworker);
+    Celx_RegisterMethod(l, "setfixedtimestep", celestia_setfixedtimestep);
+    Celx_RegisterMethod(l, "getfixedtimestep", celestia_getfixedtimestep);
+    Celx_RegisterMethod(l, "getframestats", celestia_getframestats);
+    Celx_RegisterMethod(l, "getrenderstats", celestia_getrenderstats);
+    Celx_RegisterMethod(l, "getmemoryreport", celestia_getmemoryreport);
+    Celx_RegisterMethod(l, "gethitches", celestia_gethitches);
+    Celx_RegisterMethod(l, "istracing", celestia_istracing);
+    Celx_RegisterMethod(l, "settracing", celestia_settracing);
     Celx_RegisterMethod(l, "requestkeyboard", celestia_requestkeyboard);
     Celx_RegisterMethod(l, "takescreenshot", celestia_takescreenshot);
     Celx_RegisterMethod(l, "createcelscript", celestia_createcelscript);
@@ -2645,6 +3505,7 @@ void CreateCelestiaMetaTable(lua_State* l)
     Celx_RegisterMethod(l, "seturl", celestia_seturl);
     Celx_RegisterMethod(l, "geturl", celestia_geturl);
     Celx_RegisterMethod(l, "overlay", celestia_overlay);
+    Celx_RegisterMethod(l, "preloadoverlay", celestia_preloadoverlay);
     Celx_RegisterMethod(l, "verbosity", celestia_verbosity);
 
     // Compatibility audio playback
@@ -2653,6 +3514,7 @@ void CreateCelestiaMetaTable(lua_State* l)
     // Audio playback
     Celx_RegisterMethod(l, "isplayingaudio", celestia_isplayingaudio);
     Celx_RegisterMethod(l, "playaudio", celestia_playaudio);
+    Celx_RegisterMethod(l, "preloadaudio", celestia_preloadaudio);
     Celx_RegisterMethod(l, "resumeaudio", celestia_resumeaudio);
     Celx_RegisterMethod(l, "pauseaudio", celestia_pauseaudio);
     Celx_RegisterMethod(l, "stopaudio", celestia_stopaudio);
@@ -2938,6 +3800,31 @@ static int celestia_setasterisms(lua_State *l)
     return 0;
 }
 
+// Subset of the methods which neither use the simulation nor the renderer,
+// for the states of workers
+void CreateWorkerCelestiaMetaTable(lua_State* l)
+{
+    Celx_CreateClassMetatable(l, Celx_Celestia);
+
+    Celx_RegisterMethod(l, "__tostring", celestia_tostring);
+    Celx_RegisterMethod(l, "find", celestia_find_worker);
+    Celx_RegisterMethod(l, "tojulianday", celestia_tojulianday);
+    Celx_RegisterMethod(l, "fromjulianday", celestia_fromjulianday);
+    Celx_RegisterMethod(l, "utctotdb", celestia_utctotdb);
+    Celx_RegisterMethod(l, "tdbtoutc", celestia_tdbtoutc);
+    Celx_RegisterMethod(l, "getstarcount", celestia_getstarcount);
+    Celx_RegisterMethod(l, "getdsocount", celestia_getdsocount);
+    Celx_RegisterMethod(l, "getstar", celestia_getstar);
+    Celx_RegisterMethod(l, "getdso", celestia_getdso);
+    Celx_RegisterMethod(l, "findstars", celestia_findstars);
+    Celx_RegisterMethod(l, "finddsos", celestia_finddsos);
+    Celx_RegisterMethod(l, "newvector", celestia_newvector);
+    Celx_RegisterMethod(l, "newposition", celestia_newposition);
+    Celx_RegisterMethod(l, "newrotation", celestia_newrotation);
+
+    lua_pop(l, 1);
+}
+
 void ExtendCelestiaMetaTable(lua_State* l)
 {
     CelxLua celx(l);
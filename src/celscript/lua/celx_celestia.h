@@ -18,3 +18,4 @@ CelestiaCore* to_celestia(lua_State*, int);
 CelestiaCore* this_celestia(lua_State*);
 void CreateCelestiaMetaTable(lua_State*);
 void ExtendCelestiaMetaTable(lua_State*);
+void CreateWorkerCelestiaMetaTable(lua_State*);
@@ -47,7 +47,9 @@ enum
     Celx_Image    = 10,
     Celx_Texture  = 11,
     Celx_Phase    = 12,
-    Celx_Category = 13
+    Celx_Category = 13,
+    Celx_Job      = 14,
+    Celx_Worker   = 15
 };
 
 template<typename T> int celxClassId(T)
@@ -0,0 +1,140 @@
+// celx_job.cpp
+//
+// Copyright (C) 2024, the Celestia Development Team
+//
+// Lua script extensions for Celestia: background jobs
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include "celx_job.h"
+
+#include <new>
+
+#include "celx.h"
+
+int job_new(lua_State* l, const CelxJobPtr& job)
+{
+    CelxLua celx(l);
+
+    // Use placement new to put the new job reference in the userdata block.
+    void* block = lua_newuserdata(l, sizeof(CelxJobPtr));
+    new (block) CelxJobPtr(job);
+
+    celx.setClass(Celx_Job);
+
+    return 1;
+}
+
+
+CelxJobPtr* to_job(lua_State* l, int index)
+{
+    CelxLua celx(l);
+
+    return celx.safeGetClass<CelxJobPtr>(index, NoErrors);
+}
+
+
+static CelxJob* this_job(lua_State* l)
+{
+    CelxLua celx(l);
+
+    auto job = to_job(l, 1);
+    if (job == nullptr || *job == nullptr)
+    {
+        celx.doError("Bad job object!");
+        return nullptr;
+    }
+
+    return job->get();
+}
+
+
+/*! bool job:ready()
+ *
+ * Return true if the job is complete, so that job:result() returns its
+ * result. A script may also wait(job) until the job is ready.
+ */
+static int job_ready(lua_State* l)
+{
+    CelxLua celx(l);
+    celx.checkArgs(1, 1, "No arguments expected for job:ready()");
+
+    CelxJob* job = this_job(l);
+    return celx.push(job->isReady());
+}
+
+
+/*! job:result()
+ *
+ * Return the result of a ready job, or nil if the job isn't complete yet.
+ */
+static int job_result(lua_State* l)
+{
+    CelxLua celx(l);
+    celx.checkArgs(1, 1, "No arguments expected for job:result()");
+
+    CelxJob* job = this_job(l);
+    if (!job->isReady())
+        return celx.push();
+
+    return job->pushResult(l);
+}
+
+
+/*! job:cancel()
+ *
+ * Ask the job to stop early; its result holds what was found until then.
+ */
+static int job_cancel(lua_State* l)
+{
+    CelxLua celx(l);
+    celx.checkArgs(1, 1, "No arguments expected for job:cancel()");
+
+    this_job(l)->cancel();
+    return 0;
+}
+
+
+static int job_tostring(lua_State* l)
+{
+    lua_pushstring(l, "[Job]");
+
+    return 1;
+}
+
+
+/*! __gc metamethod
+ * A job which is no longer referenced by the script is cancelled; the task
+ * running it keeps its own reference until it returns.
+ */
+static int job_gc(lua_State* l)
+{
+    CelxJobPtr* job = to_job(l, 1);
+    if (job == nullptr)
+        return 0;
+
+    if (*job != nullptr)
+        (*job)->cancel();
+    job->~CelxJobPtr();
+
+    return 0;
+}
+
+
+void CreateJobMetaTable(lua_State* l)
+{
+    CelxLua celx(l);
+
+    celx.createClassMetatable(Celx_Job);
+
+    celx.registerMethod("__tostring", job_tostring);
+    celx.registerMethod("__gc", job_gc);
+    celx.registerMethod("ready", job_ready);
+    celx.registerMethod("result", job_result);
+    celx.registerMethod("cancel", job_cancel);
+
+    celx.pop(1);
+}
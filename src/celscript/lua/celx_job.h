@@ -0,0 +1,89 @@
+// celx_job.h
+//
+// Copyright (C) 2024, the Celestia Development Team
+//
+// Lua script extensions for Celestia: background jobs
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <optional>
+#include <utility>
+
+#include "celx_internal.h"
+
+struct lua_State;
+
+/*! An operation started by a script which runs on the thread pool, so that
+ *  the frames keep being rendered while it is busy. A script may poll the
+ *  job or pass it to wait(), which resumes the script once the job is
+ *  ready. The result is converted to Lua values on the main thread.
+ */
+class CelxJob
+{
+ public:
+    virtual ~CelxJob() = default;
+
+    virtual bool isReady() = 0;
+    // Pushes the result of a ready job and returns the number of values
+    virtual int pushResult(lua_State*) = 0;
+
+    void cancel() { cancelled = true; }
+    bool isCancelled() const { return cancelled; }
+
+ private:
+    std::atomic<bool> cancelled{ false };
+};
+
+using CelxJobPtr = std::shared_ptr<CelxJob>;
+
+// A job whose result of type T is computed by a task returning it
+template<typename T>
+class CelxFutureJob : public CelxJob
+{
+ public:
+    using Converter = int (*)(lua_State*, const T&);
+
+    explicit CelxFutureJob(Converter _converter) : converter(_converter) {}
+
+    void setFuture(std::future<T>&& _future) { future = std::move(_future); }
+    void setResult(T&& _result) { result = std::move(_result); }
+
+    bool isReady() override
+    {
+        if (!result.has_value() &&
+            future.valid() &&
+            future.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+        {
+            result = future.get();
+        }
+        return result.has_value();
+    }
+
+    int pushResult(lua_State* l) override
+    {
+        return isReady() ? converter(l, *result) : 0;
+    }
+
+ private:
+    Converter converter;
+    std::future<T> future;
+    std::optional<T> result;
+};
+
+inline int celxClassId(const CelxJobPtr&)
+{
+    return Celx_Job;
+}
+
+extern void CreateJobMetaTable(lua_State* l);
+extern int job_new(lua_State* l, const CelxJobPtr& job);
+extern CelxJobPtr* to_job(lua_State* l, int index);
@@ -844,6 +844,30 @@ static int object_getposition(lua_State* l)
     return 1;
 }
 
+// Workers need an explicit time, and only get the positions which may be
+// computed away from the main thread
+static int object_getposition_worker(lua_State* l)
+{
+    CelxLua celx(l);
+    celx.checkArgs(2, 2, "Time expected as argument to object:getposition");
+
+    Selection* sel = this_object(l);
+    double t = celx.safeGetNumber(2, AllErrors, "Time expected as argument to object:getposition");
+
+    bool threadSafe = sel->location() == nullptr;
+    if (const Body* body = sel->body(); body != nullptr)
+        threadSafe = body->getTimeline()->isThreadSafe();
+    for (const Star* star = sel->star(); star != nullptr && threadSafe; star = star->getOrbitBarycenter())
+        threadSafe = star->getOrbit() == nullptr || star->getOrbit()->isThreadSafe();
+
+    if (!threadSafe)
+        celx.doError("The position of this object can't be computed in a worker");
+
+    celx.newPosition(sel->getPosition(t));
+
+    return 1;
+}
+
 static int object_getchildren(lua_State* l)
 {
     CelxLua celx(l);
@@ -1435,6 +1459,31 @@ void CreateObjectMetaTable(lua_State* l)
 }
 
 
+// Subset of the methods which neither use the simulation nor modify the
+// objects, for the states of workers
+void CreateWorkerObjectMetaTable(lua_State* l)
+{
+    CelxLua celx(l);
+
+    celx.createClassMetatable(Celx_Object);
+
+    celx.registerMethod("__tostring", object_tostring);
+    celx.registerMethod("radius", object_radius);
+    celx.registerMethod("type", object_type);
+    celx.registerMethod("spectraltype", object_spectraltype);
+    celx.registerMethod("catalognumber", object_catalognumber);
+    celx.registerMethod("absmag", object_absmag);
+    celx.registerMethod("name", object_name);
+    celx.registerMethod("localname", object_localname);
+    celx.registerMethod("getposition", object_getposition_worker);
+    celx.registerMethod("getchildren", object_getchildren);
+    celx.registerMethod("getmass", object_getmass);
+    celx.registerMethod("getdensity", object_getdensity);
+
+    lua_pop(l, 1); // pop metatable off the stack
+}
+
+
 // ==================== object extensions ====================
 
 static const char* gettablekey(lua_State *l, const char *error)
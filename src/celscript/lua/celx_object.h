@@ -21,5 +21,6 @@ int inline celxClassId(const Selection)
 
 extern void CreateObjectMetaTable(lua_State* l);
 extern void ExtendObjectMetaTable(lua_State* l);
+extern void CreateWorkerObjectMetaTable(lua_State* l);
 extern Selection* to_object(lua_State* l, int index);
 extern int object_new(lua_State* l, const Selection& sel);
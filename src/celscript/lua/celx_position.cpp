@@ -156,7 +156,7 @@ static int position_vectorto(lua_State* l)
 {
     CelxLua celx(l);
 
-    celx.checkArgs(2, 2, "One argument expected to position:vectorto");
+    celx.checkArgs(2, 3, "One or two arguments expected to position:vectorto");
 
     UniversalCoord* uc = this_position(l);
     UniversalCoord* uc2 = to_position(l, 2);
@@ -167,6 +167,19 @@ static int position_vectorto(lua_State* l)
         return 0;
     }
 
+    // Write into a vector passed in instead of creating one
+    if (lua_gettop(l) == 3)
+    {
+        auto dest = celx.toVector(3);
+        if (dest == nullptr)
+        {
+            celx.doError("Second argument to position:vectorto must be a vector");
+            return 0;
+        }
+        *dest = uc2->offsetFromUly(*uc);
+        return 1;
+    }
+
     celx.newVector(uc2->offsetFromUly(*uc));
 
     return 1;
@@ -319,6 +332,64 @@ static int position_addvector(lua_State* l)
 }
 
 
+// In-place variants which modify the position and return it, for scripts
+// which update positions every frame
+
+static int position_setcomponents(lua_State* l)
+{
+    CelxLua celx(l);
+
+    celx.checkArgs(2, 4, "One position or three numbers expected for position:set");
+    UniversalCoord* uc = this_position(l);
+    if (celx.isType(2, Celx_Position))
+    {
+        *uc = *celx.toPosition(2);
+    }
+    else
+    {
+        uc->x = R128(celx.safeGetNumber(2, AllErrors, "Arguments to position:set must be numbers"));
+        uc->y = R128(celx.safeGetNumber(3, AllErrors, "Arguments to position:set must be numbers"));
+        uc->z = R128(celx.safeGetNumber(4, AllErrors, "Arguments to position:set must be numbers"));
+    }
+
+    lua_settop(l, 1);
+    return 1;
+}
+
+
+static int position_addvector_inplace(lua_State* l)
+{
+    CelxLua celx(l);
+
+    celx.checkArgs(2, 2, "One argument expected to position:addvector_inplace()");
+    UniversalCoord* uc = this_position(l);
+    auto v3d = celx.toVector(2);
+    if (v3d == nullptr)
+    {
+        celx.doError("Vector expected as argument to position:addvector_inplace");
+        return 0;
+    }
+
+    *uc = uc->offsetUly(*v3d);
+    lua_settop(l, 1);
+    return 1;
+}
+
+
+// Returns the components in micro light years as three numbers
+static int position_components(lua_State* l)
+{
+    CelxLua celx(l);
+
+    celx.checkArgs(1, 1, "No arguments expected for position:components()");
+    UniversalCoord* uc = this_position(l);
+    lua_pushnumber(l, static_cast<lua_Number>(static_cast<double>(uc->x)));
+    lua_pushnumber(l, static_cast<lua_Number>(static_cast<double>(uc->y)));
+    lua_pushnumber(l, static_cast<lua_Number>(static_cast<double>(uc->z)));
+    return 3;
+}
+
+
 void CreatePositionMetaTable(lua_State* l)
 {
     CelxLua celx(l);
@@ -330,6 +401,9 @@ void CreatePositionMetaTable(lua_State* l)
     celx.registerMethod("vectorto", position_vectorto);
     celx.registerMethod("orientationto", position_orientationto);
     celx.registerMethod("addvector", position_addvector);
+    celx.registerMethod("addvector_inplace", position_addvector_inplace);
+    celx.registerMethod("set", position_setcomponents);
+    celx.registerMethod("components", position_components);
     celx.registerMethod("__add", position_add);
     celx.registerMethod("__sub", position_sub);
     celx.registerMethod("__index", position_get);
@@ -138,7 +138,7 @@ static int rotation_transform(lua_State* l)
 {
     CelxLua celx(l);
 
-    celx.checkArgs(2, 2, "One argument expected for rotation:transform()");
+    celx.checkArgs(2, 3, "One or two arguments expected for rotation:transform()");
     auto q = this_rotation(l);
     auto v = to_vector(l, 2);
     if (v == nullptr)
@@ -147,11 +147,84 @@ static int rotation_transform(lua_State* l)
         return 0;
     }
     // XXX or transpose() instead of .adjoint()?
-    vector_new(l, q->toRotationMatrix().adjoint() * (*v));
+    Vector3d result = q->toRotationMatrix().adjoint() * (*v);
+    if (lua_gettop(l) == 3)
+    {
+        // Write into a vector passed in instead of creating one
+        auto dest = to_vector(l, 3);
+        if (dest == nullptr)
+        {
+            celx.doError("Second argument to rotation:transform() must be a vector");
+            return 0;
+        }
+        *dest = result;
+        return 1;
+    }
+
+    vector_new(l, result);
     return 1;
 }
 
 
+// In-place variants which modify the rotation and return it
+
+static int rotation_setcomponents(lua_State* l)
+{
+    CelxLua celx(l);
+
+    celx.checkArgs(2, 5, "One rotation or four numbers expected for rotation:set()");
+    auto q = this_rotation(l);
+    if (celx.isType(2, Celx_Rotation))
+    {
+        *q = *to_rotation(l, 2);
+    }
+    else
+    {
+        q->w() = celx.safeGetNumber(2, AllErrors, "Arguments to rotation:set() must be numbers");
+        q->x() = celx.safeGetNumber(3, AllErrors, "Arguments to rotation:set() must be numbers");
+        q->y() = celx.safeGetNumber(4, AllErrors, "Arguments to rotation:set() must be numbers");
+        q->z() = celx.safeGetNumber(5, AllErrors, "Arguments to rotation:set() must be numbers");
+    }
+
+    lua_settop(l, 1);
+    return 1;
+}
+
+
+static int rotation_mult_inplace(lua_State* l)
+{
+    CelxLua celx(l);
+
+    celx.checkArgs(2, 2, "One argument expected for rotation:mult_inplace()");
+    auto q = this_rotation(l);
+    auto r = to_rotation(l, 2);
+    if (r == nullptr)
+    {
+        celx.doError("Argument to rotation:mult_inplace() must be a rotation");
+        return 0;
+    }
+
+    *q = *q * *r;
+    lua_settop(l, 1);
+    return 1;
+}
+
+
+// Returns the components w, x, y and z as four numbers
+static int rotation_components(lua_State* l)
+{
+    CelxLua celx(l);
+
+    celx.checkArgs(1, 1, "No arguments expected for rotation:components()");
+    auto q = this_rotation(l);
+    lua_pushnumber(l, static_cast<lua_Number>(q->w()));
+    lua_pushnumber(l, static_cast<lua_Number>(q->x()));
+    lua_pushnumber(l, static_cast<lua_Number>(q->y()));
+    lua_pushnumber(l, static_cast<lua_Number>(q->z()));
+    return 4;
+}
+
+
 static int rotation_setaxisangle(lua_State* l)
 {
     CelxLua celx(l);
@@ -268,6 +341,9 @@ void CreateRotationMetaTable(lua_State* l)
     celx.registerMethod("transform", rotation_transform);
     celx.registerMethod("setaxisangle", rotation_setaxisangle);
     celx.registerMethod("slerp", rotation_slerp);
+    celx.registerMethod("set", rotation_setcomponents);
+    celx.registerMethod("mult_inplace", rotation_mult_inplace);
+    celx.registerMethod("components", rotation_components);
     celx.registerMethod("__tostring", rotation_tostring);
     celx.registerMethod("__add", rotation_add);
     celx.registerMethod("__mul", rotation_mult);
@@ -275,6 +275,101 @@ static int vector_cross(lua_State* l)
 
 }
 
+// The in-place operations below modify the vector and return it, so that
+// scripts which run every frame can reuse their vectors instead of
+// creating garbage for each intermediate result.
+
+static int vector_setcomponents(lua_State* l)
+{
+    CelxLua celx(l);
+
+    celx.checkArgs(2, 4, "One vector or three numbers expected for vector:set");
+    auto v = this_vector(l);
+    if (celx.isType(2, Celx_Vec3))
+    {
+        *v = *celx.toVector(2);
+    }
+    else
+    {
+        v->x() = celx.safeGetNumber(2, AllErrors, "Arguments to vector:set must be numbers");
+        v->y() = celx.safeGetNumber(3, AllErrors, "Arguments to vector:set must be numbers");
+        v->z() = celx.safeGetNumber(4, AllErrors, "Arguments to vector:set must be numbers");
+    }
+
+    lua_settop(l, 1);
+    return 1;
+}
+
+static int vector_add_inplace(lua_State* l)
+{
+    CelxLua celx(l);
+
+    celx.checkArgs(2, 2, "One vector expected for vector:add_inplace");
+    auto v = this_vector(l);
+    auto w = celx.toVector(2);
+    if (w == nullptr)
+    {
+        celx.doError("Argument to vector:add_inplace must be a vector");
+        return 0;
+    }
+
+    *v += *w;
+    lua_settop(l, 1);
+    return 1;
+}
+
+static int vector_sub_inplace(lua_State* l)
+{
+    CelxLua celx(l);
+
+    celx.checkArgs(2, 2, "One vector expected for vector:sub_inplace");
+    auto v = this_vector(l);
+    auto w = celx.toVector(2);
+    if (w == nullptr)
+    {
+        celx.doError("Argument to vector:sub_inplace must be a vector");
+        return 0;
+    }
+
+    *v -= *w;
+    lua_settop(l, 1);
+    return 1;
+}
+
+static int vector_scale_inplace(lua_State* l)
+{
+    CelxLua celx(l);
+
+    celx.checkArgs(2, 2, "One number expected for vector:scale_inplace");
+    auto v = this_vector(l);
+    *v *= celx.safeGetNumber(2, AllErrors, "Argument to vector:scale_inplace must be a number");
+    lua_settop(l, 1);
+    return 1;
+}
+
+static int vector_normalize_inplace(lua_State* l)
+{
+    CelxLua celx(l);
+
+    celx.checkArgs(1, 1, "No arguments expected for vector:normalize_inplace");
+    auto v = this_vector(l);
+    v->normalize();
+    return 1;
+}
+
+// Returns the components as three numbers, without a vector object
+static int vector_components(lua_State* l)
+{
+    CelxLua celx(l);
+
+    celx.checkArgs(1, 1, "No arguments expected for vector:components");
+    auto v = this_vector(l);
+    lua_pushnumber(l, static_cast<lua_Number>(v->x()));
+    lua_pushnumber(l, static_cast<lua_Number>(v->y()));
+    lua_pushnumber(l, static_cast<lua_Number>(v->z()));
+    return 3;
+}
+
 static int vector_tostring(lua_State* l)
 {
     lua_pushstring(l, "[Vector]");
@@ -299,6 +394,12 @@ void CreateVectorMetaTable(lua_State* l)
     celx.registerMethod("getz", vector_getz);
     celx.registerMethod("normalize", vector_normalize);
     celx.registerMethod("length", vector_length);
+    celx.registerMethod("set", vector_setcomponents);
+    celx.registerMethod("add_inplace", vector_add_inplace);
+    celx.registerMethod("sub_inplace", vector_sub_inplace);
+    celx.registerMethod("scale_inplace", vector_scale_inplace);
+    celx.registerMethod("normalize_inplace", vector_normalize_inplace);
+    celx.registerMethod("components", vector_components);
 
     lua_pop(l, 1); // remove metatable from stack
 }
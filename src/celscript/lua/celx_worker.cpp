@@ -0,0 +1,574 @@
+// celx_worker.cpp
+//
+// Copyright (C) 2024, the Celestia Development Team
+//
+// Lua script extensions for Celestia: worker states
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include "celx_worker.h"
+
+#include <chrono>
+#include <new>
+#include <utility>
+
+#include <fmt/format.h>
+
+#include "celx.h"
+#include "celx_object.h"
+#include "celx_position.h"
+#include "celx_rotation.h"
+#include "celx_vector.h"
+
+namespace
+{
+
+constexpr const char WorkerRegistryKey[] = "celx-worker";
+
+// Number of instructions between the checks for stop requests
+constexpr int StopCheckInstructions = 1000;
+
+std::atomic<int> activeWorkers{ 0 };
+
+int absoluteIndex(lua_State* l, int index)
+{
+    return index < 0 && index > LUA_REGISTRYINDEX
+        ? lua_gettop(l) + index + 1
+        : index;
+}
+
+void checkStop(lua_State* l, lua_Debug* /*ar*/)
+{
+    CelxWorker* worker = CelxWorker::fromState(l);
+    if (worker != nullptr && worker->isStopRequested())
+        luaL_error(l, "Worker stopped");
+}
+
+} // end unnamed namespace
+
+// ==================== Messages ====================
+
+std::optional<CelxMessage> CelxMessage::fromLua(lua_State* l, int index, std::string& error)
+{
+    CelxMessage message;
+    if (!message.copy(l, absoluteIndex(l, index), 0, error))
+        return std::nullopt;
+
+    return message;
+}
+
+
+bool CelxMessage::copy(lua_State* l, int index, int depth, std::string& error)
+{
+    switch (lua_type(l, index))
+    {
+    case LUA_TNIL:
+        type = Type::Nil;
+        return true;
+
+    case LUA_TBOOLEAN:
+        type = Type::Boolean;
+        boolean = lua_toboolean(l, index) != 0;
+        return true;
+
+    case LUA_TNUMBER:
+        type = Type::Number;
+        number = lua_tonumber(l, index);
+        return true;
+
+    case LUA_TSTRING:
+    {
+        type = Type::String;
+        std::size_t length = 0;
+        const char* s = lua_tolstring(l, index, &length);
+        string.assign(s, length);
+        return true;
+    }
+
+    case LUA_TUSERDATA:
+        if (const auto* v = to_vector(l, index); v != nullptr)
+        {
+            type = Type::Vector;
+            components = { v->x(), v->y(), v->z(), 0.0 };
+            return true;
+        }
+        if (const auto* q = to_rotation(l, index); q != nullptr)
+        {
+            type = Type::Rotation;
+            components = { q->w(), q->x(), q->y(), q->z() };
+            return true;
+        }
+        if (const auto* uc = to_position(l, index); uc != nullptr)
+        {
+            type = Type::Position;
+            position = *uc;
+            return true;
+        }
+        if (const auto* sel = to_object(l, index); sel != nullptr)
+        {
+            type = Type::Object;
+            object = *sel;
+            return true;
+        }
+        break;
+
+    case LUA_TTABLE:
+        if (depth >= MaxDepth)
+        {
+            error = "Tables in messages may not be nested that deep";
+            return false;
+        }
+
+        type = Type::Table;
+        lua_pushnil(l);
+        while (lua_next(l, index) != 0)
+        {
+            CelxMessage& key = keys.emplace_back();
+            CelxMessage& value = values.emplace_back();
+            if (!key.copy(l, lua_gettop(l) - 1, depth + 1, error) ||
+                !value.copy(l, lua_gettop(l), depth + 1, error))
+            {
+                lua_pop(l, 2);
+                return false;
+            }
+            lua_pop(l, 1);
+        }
+        return true;
+
+    default:
+        break;
+    }
+
+    error = fmt::format("Values of type {} can't be sent to another state", luaL_typename(l, index));
+    return false;
+}
+
+
+void CelxMessage::push(lua_State* l) const
+{
+    switch (type)
+    {
+    case Type::Nil:
+        lua_pushnil(l);
+        break;
+    case Type::Boolean:
+        lua_pushboolean(l, boolean);
+        break;
+    case Type::Number:
+        lua_pushnumber(l, number);
+        break;
+    case Type::String:
+        lua_pushlstring(l, string.data(), string.size());
+        break;
+    case Type::Vector:
+        vector_new(l, Eigen::Vector3d(components[0], components[1], components[2]));
+        break;
+    case Type::Rotation:
+        rotation_new(l, Eigen::Quaterniond(components[0], components[1], components[2], components[3]));
+        break;
+    case Type::Position:
+        position_new(l, position);
+        break;
+    case Type::Object:
+        object_new(l, object);
+        break;
+    case Type::Table:
+        lua_checkstack(l, 3);
+        lua_createtable(l, 0, static_cast<int>(keys.size()));
+        for (std::size_t i = 0; i < keys.size(); ++i)
+        {
+            keys[i].push(l);
+            values[i].push(l);
+            lua_rawset(l, -3);
+        }
+        break;
+    }
+}
+
+// ==================== Worker ====================
+
+CelxWorker::CelxWorker(CelestiaCore* _appCore, std::string_view _name) :
+    appCore(_appCore),
+    name(_name)
+{
+}
+
+
+CelxWorker::~CelxWorker()
+{
+    stop();
+    if (thread.joinable())
+        thread.join();
+
+    if (state != nullptr)
+        lua_close(state);
+}
+
+
+bool CelxWorker::start(std::string_view source, std::string& errorMessage)
+{
+    if (activeWorkers.fetch_add(1) >= MaxWorkers)
+    {
+        activeWorkers.fetch_sub(1);
+        errorMessage = fmt::format("No more than {} workers may run at once", MaxWorkers);
+        return false;
+    }
+
+    state = luaL_newstate();
+    LoadWorkerLuaLibs(state, appCore);
+
+    lua_pushstring(state, WorkerRegistryKey);
+    lua_pushlightuserdata(state, static_cast<void*>(this));
+    lua_settable(state, LUA_REGISTRYINDEX);
+
+    if (luaL_loadbuffer(state, source.data(), source.size(), name.c_str()) != 0)
+    {
+        const char* message = lua_tostring(state, -1);
+        errorMessage = message != nullptr ? message : "Worker failed to load";
+        lua_close(state);
+        state = nullptr;
+        activeWorkers.fetch_sub(1);
+        return false;
+    }
+
+    lua_sethook(state, checkStop, LUA_MASKCOUNT, StopCheckInstructions);
+
+    running = true;
+    thread = std::thread(&CelxWorker::run, this);
+    return true;
+}
+
+
+void CelxWorker::run()
+{
+    if (lua_pcall(state, 0, 0, 0) != 0 && !stopRequested)
+    {
+        const char* message = lua_tostring(state, -1);
+        std::scoped_lock lock(mutex);
+        error = message != nullptr ? message : "Unknown error in worker";
+    }
+
+    lua_close(state);
+    state = nullptr;
+
+    activeWorkers.fetch_sub(1);
+    running = false;
+}
+
+
+void CelxWorker::stop()
+{
+    {
+        std::scoped_lock lock(mutex);
+        stopRequested = true;
+        inbox.clear();
+    }
+    inboxChanged.notify_all();
+}
+
+
+std::string CelxWorker::getError() const
+{
+    std::scoped_lock lock(mutex);
+    return error;
+}
+
+
+bool CelxWorker::post(CelxMessage&& message)
+{
+    {
+        std::scoped_lock lock(mutex);
+        if (!running || stopRequested || inbox.size() >= MaxQueuedMessages)
+            return false;
+
+        inbox.push_back(std::move(message));
+    }
+    inboxChanged.notify_one();
+    return true;
+}
+
+
+std::optional<CelxMessage> CelxWorker::poll()
+{
+    std::scoped_lock lock(mutex);
+    if (outbox.empty())
+        return std::nullopt;
+
+    CelxMessage message = std::move(outbox.front());
+    outbox.pop_front();
+    return message;
+}
+
+
+std::optional<CelxMessage> CelxWorker::receive(double timeout)
+{
+    std::unique_lock lock(mutex);
+    auto ready = [this] { return !inbox.empty() || stopRequested; };
+    if (timeout < 0.0)
+        inboxChanged.wait(lock, ready);
+    else if (!inboxChanged.wait_for(lock, std::chrono::duration<double>(timeout), ready))
+        return std::nullopt;
+
+    if (inbox.empty())
+        return std::nullopt;
+
+    CelxMessage message = std::move(inbox.front());
+    inbox.pop_front();
+    return message;
+}
+
+
+bool CelxWorker::reply(CelxMessage&& message)
+{
+    std::scoped_lock lock(mutex);
+    if (outbox.size() >= MaxQueuedMessages)
+        return false;
+
+    outbox.push_back(std::move(message));
+    return true;
+}
+
+
+CelxWorker* CelxWorker::fromState(lua_State* l)
+{
+    lua_pushstring(l, WorkerRegistryKey);
+    lua_gettable(l, LUA_REGISTRYINDEX);
+    auto* worker = static_cast<CelxWorker*>(lua_touserdata(l, -1));
+    lua_pop(l, 1);
+    return worker;
+}
+
+// ==================== Worker object ====================
+
+int worker_new(lua_State* l, const CelxWorkerPtr& worker)
+{
+    CelxLua celx(l);
+
+    // Use placement new to put the new worker reference in the userdata block.
+    void* block = lua_newuserdata(l, sizeof(CelxWorkerPtr));
+    new (block) CelxWorkerPtr(worker);
+
+    celx.setClass(Celx_Worker);
+
+    return 1;
+}
+
+
+CelxWorkerPtr* to_worker(lua_State* l, int index)
+{
+    CelxLua celx(l);
+
+    return celx.safeGetClass<CelxWorkerPtr>(index, NoErrors);
+}
+
+
+static CelxWorker* this_worker(lua_State* l)
+{
+    CelxLua celx(l);
+
+    auto worker = to_worker(l, 1);
+    if (worker == nullptr || *worker == nullptr)
+    {
+        celx.doError("Bad worker object!");
+        return nullptr;
+    }
+
+    return worker->get();
+}
+
+
+/*! bool worker:send(value)
+ *
+ * Queue a message for the worker, which gets it with celestia:receive().
+ * Return false if the queue is full or the worker no longer runs.
+ */
+static int worker_send(lua_State* l)
+{
+    CelxLua celx(l);
+    celx.checkArgs(2, 2, "One argument expected for worker:send()");
+
+    CelxWorker* worker = this_worker(l);
+    if (lua_isnil(l, 2))
+        celx.doError("Can't send nil to a worker");
+
+    std::string error;
+    auto message = CelxMessage::fromLua(l, 2, error);
+    if (!message.has_value())
+        celx.doError(error.c_str());
+
+    return celx.push(worker->post(std::move(*message)));
+}
+
+
+/*! worker:receive()
+ *
+ * Return the next message sent by the worker, or nil if there is none.
+ */
+static int worker_receive(lua_State* l)
+{
+    CelxLua celx(l);
+    celx.checkArgs(1, 1, "No arguments expected for worker:receive()");
+
+    auto message = this_worker(l)->poll();
+    if (!message.has_value())
+        return celx.push();
+
+    message->push(l);
+    return 1;
+}
+
+
+static int worker_running(lua_State* l)
+{
+    CelxLua celx(l);
+    celx.checkArgs(1, 1, "No arguments expected for worker:running()");
+
+    return celx.push(this_worker(l)->isRunning());
+}
+
+
+/*! worker:error()
+ *
+ * Return the error which ended the worker, or nil.
+ */
+static int worker_error(lua_State* l)
+{
+    CelxLua celx(l);
+    celx.checkArgs(1, 1, "No arguments expected for worker:error()");
+
+    std::string error = this_worker(l)->getError();
+    if (error.empty())
+        return celx.push();
+
+    return celx.push(error.c_str());
+}
+
+
+static int worker_stop(lua_State* l)
+{
+    CelxLua celx(l);
+    celx.checkArgs(1, 1, "No arguments expected for worker:stop()");
+
+    this_worker(l)->stop();
+    return 0;
+}
+
+
+static int worker_tostring(lua_State* l)
+{
+    CelxLua celx(l);
+
+    auto worker = to_worker(l, 1);
+    if (worker == nullptr || *worker == nullptr)
+        return celx.push("[Worker]");
+
+    std::string s = fmt::format("[Worker:{}]", (*worker)->getName());
+    return celx.push(s.c_str());
+}
+
+
+/*! __gc metamethod
+ * A worker which is no longer referenced by the script is stopped, and its
+ * thread joined.
+ */
+static int worker_gc(lua_State* l)
+{
+    CelxWorkerPtr* worker = to_worker(l, 1);
+    if (worker == nullptr)
+        return 0;
+
+    worker->~CelxWorkerPtr();
+
+    return 0;
+}
+
+
+void CreateWorkerMetaTable(lua_State* l)
+{
+    CelxLua celx(l);
+
+    celx.createClassMetatable(Celx_Worker);
+
+    celx.registerMethod("__tostring", worker_tostring);
+    celx.registerMethod("__gc", worker_gc);
+    celx.registerMethod("send", worker_send);
+    celx.registerMethod("receive", worker_receive);
+    celx.registerMethod("running", worker_running);
+    celx.registerMethod("error", worker_error);
+    celx.registerMethod("stop", worker_stop);
+
+    celx.pop(1);
+}
+
+// ==================== Worker side ====================
+
+static CelxWorker* current_worker(lua_State* l)
+{
+    CelxWorker* worker = CelxWorker::fromState(l);
+    if (worker == nullptr)
+        Celx_DoError(l, "Not running in a worker");
+
+    return worker;
+}
+
+
+/*! bool celestia:send(value)
+ *
+ * Send a message from a worker to the script which started it. Return false
+ * if the queue is full.
+ */
+static int celestia_send(lua_State* l)
+{
+    CelxLua celx(l);
+    celx.checkArgs(2, 2, "One argument expected for celestia:send()");
+
+    CelxWorker* worker = current_worker(l);
+    if (lua_isnil(l, 2))
+        celx.doError("Can't send nil from a worker");
+
+    std::string error;
+    auto message = CelxMessage::fromLua(l, 2, error);
+    if (!message.has_value())
+        celx.doError(error.c_str());
+
+    return celx.push(worker->reply(std::move(*message)));
+}
+
+
+/*! celestia:receive([number: timeout])
+ *
+ * Wait for a message from the script which started the worker, up to
+ * timeout seconds if given. Return nil if none arrived.
+ */
+static int celestia_receive(lua_State* l)
+{
+    CelxLua celx(l);
+    celx.checkArgs(1, 2, "One optional argument expected for celestia:receive()");
+
+    CelxWorker* worker = current_worker(l);
+    double timeout = celx.safeGetNumber(2, WrongType, "Timeout for celestia:receive() must be a number", -1.0);
+
+    auto message = worker->receive(timeout);
+    if (worker->isStopRequested())
+        celx.doError("Worker stopped");
+    if (!message.has_value())
+        return celx.push();
+
+    message->push(l);
+    return 1;
+}
+
+
+void ExtendWorkerCelestiaMetaTable(lua_State* l)
+{
+    CelxLua celx(l);
+
+    celx.pushClassName(Celx_Celestia);
+    lua_rawget(l, LUA_REGISTRYINDEX);
+    celx.registerMethod("send", celestia_send);
+    celx.registerMethod("receive", celestia_receive);
+    celx.pop(1);
+}
@@ -0,0 +1,154 @@
+// celx_worker.h
+//
+// Copyright (C) 2024, the Celestia Development Team
+//
+// Lua script extensions for Celestia: worker states
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <celengine/selection.h>
+#include <celengine/univcoord.h>
+#include "celx_internal.h"
+
+class CelestiaCore;
+struct lua_State;
+
+/*! A Lua value copied out of a state, so that it can be pushed into
+ *  another one. Messages may hold booleans, numbers, strings, vectors,
+ *  rotations, positions, objects and tables of these.
+ */
+class CelxMessage
+{
+ public:
+    static constexpr int MaxDepth = 16;
+
+    // Returns nothing and sets the error if the value can't be copied
+    static std::optional<CelxMessage> fromLua(lua_State*, int index, std::string& error);
+    void push(lua_State*) const;
+
+ private:
+    enum class Type : std::uint8_t
+    {
+        Nil,
+        Boolean,
+        Number,
+        String,
+        Vector,
+        Rotation,
+        Position,
+        Object,
+        Table,
+    };
+
+    bool copy(lua_State*, int index, int depth, std::string& error);
+
+    Type type{ Type::Nil };
+    bool boolean{ false };
+    double number{ 0.0 };
+    std::string string;
+    // x, y, z of vectors and w, x, y, z of rotations
+    std::array<double, 4> components{ };
+    UniversalCoord position;
+    Selection object;
+    // Keys and values of the fields of a table
+    std::vector<CelxMessage> keys;
+    std::vector<CelxMessage> values;
+};
+
+/*! A script running in its own Lua state on a thread of its own. The state
+ *  only has the sandboxed subset of celx which doesn't touch the simulation
+ *  or the renderer: catalog queries, the positions of objects with thread
+ *  safe orbits and the vector math. The worker and the script which
+ *  started it exchange messages through a queue in each direction.
+ */
+class CelxWorker
+{
+ public:
+    static constexpr std::size_t MaxQueuedMessages = 1024;
+    static constexpr int MaxWorkers = 16;
+
+    CelxWorker(CelestiaCore*, std::string_view name);
+    ~CelxWorker();
+
+    CelxWorker(const CelxWorker&) = delete;
+    CelxWorker& operator=(const CelxWorker&) = delete;
+
+    // Load the chunk into a new state and start running it. Returns false
+    // with an error message if the chunk doesn't compile or too many
+    // workers are running.
+    bool start(std::string_view source, std::string& errorMessage);
+    // Ask the worker to stop; it raises an error at the next instructions
+    // or when it waits for a message.
+    void stop();
+
+    bool isRunning() const { return running; }
+    bool isStopRequested() const { return stopRequested; }
+    std::string getError() const;
+    const std::string& getName() const { return name; }
+
+    // Queue a message for the worker; fails if the queue is full or the
+    // worker no longer runs
+    bool post(CelxMessage&&);
+    // The next message sent by the worker, if any
+    std::optional<CelxMessage> poll();
+
+    // Called from the worker: wait for a message up to timeout seconds, or
+    // until one arrives if timeout is negative
+    std::optional<CelxMessage> receive(double timeout);
+    bool reply(CelxMessage&&);
+
+    // The worker running in a state, or nullptr for other states
+    static CelxWorker* fromState(lua_State*);
+
+ private:
+    void run();
+
+    CelestiaCore* appCore;
+    std::string name;
+    lua_State* state{ nullptr };
+    std::thread thread;
+
+    mutable std::mutex mutex;
+    std::condition_variable inboxChanged;
+    std::deque<CelxMessage> inbox;
+    std::deque<CelxMessage> outbox;
+    std::string error;
+
+    std::atomic<bool> running{ false };
+    std::atomic<bool> stopRequested{ false };
+};
+
+using CelxWorkerPtr = std::shared_ptr<CelxWorker>;
+
+inline int celxClassId(const CelxWorkerPtr&)
+{
+    return Celx_Worker;
+}
+
+extern void CreateWorkerMetaTable(lua_State* l);
+extern void ExtendWorkerCelestiaMetaTable(lua_State* l);
+extern int worker_new(lua_State* l, const CelxWorkerPtr& worker);
+extern CelxWorkerPtr* to_worker(lua_State* l, int index);
+
+// Open the libraries of a worker state; defined along with the ones of the
+// main state
+extern void LoadWorkerLuaLibs(lua_State* l, CelestiaCore* appCore);
@@ -0,0 +1,180 @@
+// luaprofiler.cpp
+//
+// Copyright (C) 2024, the Celestia Development Team
+//
+// Profiler for celx scripts.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include "luaprofiler.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <fmt/format.h>
+
+#include <celutil/logger.h>
+
+using celestia::util::GetLogger;
+
+namespace celestia::scripts
+{
+
+void
+LuaProfiler::beginSlice(double time)
+{
+    // Frames left by a previous slice are only known again when they return
+    callStack.clear();
+    lastEvent = time;
+}
+
+
+void
+LuaProfiler::hook(lua_State* l, lua_Debug* ar, double time)
+{
+    if (!callStack.empty())
+        callStack.back()->time += time - lastEvent;
+
+    switch (ar->event)
+    {
+    case LUA_HOOKCALL:
+        if (Entry* entry = getEntry(l, ar); entry != nullptr)
+        {
+            ++entry->calls;
+            callStack.push_back(entry);
+        }
+        break;
+
+#ifdef LUA_HOOKTAILCALL
+    case LUA_HOOKTAILCALL:
+        // The called function replaces the caller on the stack
+        if (Entry* entry = getEntry(l, ar); entry != nullptr)
+        {
+            ++entry->calls;
+            if (!callStack.empty())
+                callStack.pop_back();
+            callStack.push_back(entry);
+        }
+        break;
+#endif
+
+    case LUA_HOOKRET:
+#ifdef LUA_HOOKTAILRET
+    case LUA_HOOKTAILRET:
+#endif
+        if (Entry* entry = getEntry(l, ar); entry != nullptr)
+            popTo(entry);
+        break;
+
+    case LUA_HOOKCOUNT:
+        if (Entry* entry = getEntry(l, ar); entry != nullptr)
+        {
+            ++entry->samples;
+            // A slice which resumed a script starts in a running function
+            if (callStack.empty())
+                callStack.push_back(entry);
+        }
+        break;
+
+    default:
+        break;
+    }
+
+    lastEvent = time;
+}
+
+
+void
+LuaProfiler::reset()
+{
+    entries.clear();
+    functions.clear();
+    callStack.clear();
+}
+
+
+std::vector<LuaProfiler::Entry>
+LuaProfiler::getEntries() const
+{
+    std::vector<Entry> result;
+    result.reserve(entries.size());
+    for (const auto& [key, entry] : entries)
+        result.push_back(entry);
+
+    std::sort(result.begin(), result.end(),
+              [](const Entry& a, const Entry& b) { return a.time > b.time; });
+    return result;
+}
+
+
+void
+LuaProfiler::report(std::size_t maxEntries) const
+{
+    auto sorted = getEntries();
+    if (sorted.size() > maxEntries)
+        sorted.resize(maxEntries);
+
+    GetLogger()->info("Lua profile: {:>10} {:>10} {:>10}  function\n", "ms", "calls", "samples");
+    for (const Entry& entry : sorted)
+    {
+        GetLogger()->info("Lua profile: {:>10.3f} {:>10} {:>10}  {}\n",
+                          entry.time * 1000.0, entry.calls, entry.samples, entry.name);
+    }
+}
+
+
+LuaProfiler::Entry*
+LuaProfiler::getEntry(lua_State* l, lua_Debug* ar)
+{
+    if (lua_getinfo(l, "Snf", ar) == 0)
+        return nullptr;
+
+    // C functions are known by their address, Lua functions by where they
+    // are defined so that the closures of a function share an entry
+    bool isCFunction = std::strcmp(ar->what, "C") == 0;
+    FunctionKey functionKey{ nullptr, ar->linedefined };
+    if (isCFunction)
+        functionKey.address = reinterpret_cast<const void*>(lua_tocfunction(l, -1));
+    else
+        functionKey.address = ar->source;
+    lua_pop(l, 1);
+
+    if (auto it = functions.find(functionKey); it != functions.end())
+        return it->second;
+
+    std::string key = isCFunction
+        ? fmt::format("{}", functionKey.address)
+        : fmt::format("{}:{}", ar->source == nullptr ? "?" : ar->source, ar->linedefined);
+
+    auto [it, inserted] = entries.try_emplace(std::move(key));
+    Entry& entry = it->second;
+    if (inserted)
+    {
+        entry.isCFunction = isCFunction;
+        const char* name = ar->name == nullptr ? "?" : ar->name;
+        if (isCFunction)
+            entry.name = fmt::format("{} [C]", name);
+        else if (std::strcmp(ar->what, "main") == 0)
+            entry.name = fmt::format("main chunk ({})", ar->short_src);
+        else
+            entry.name = fmt::format("{} ({}:{})", name, ar->short_src, ar->linedefined);
+    }
+
+    functions.try_emplace(functionKey, &entry);
+    return &entry;
+}
+
+
+void
+LuaProfiler::popTo(const Entry* entry)
+{
+    // Frames above the returning one were left by errors
+    auto it = std::find(callStack.rbegin(), callStack.rend(), entry);
+    if (it != callStack.rend())
+        callStack.erase(std::next(it).base(), callStack.end());
+}
+
+} // end namespace celestia::scripts
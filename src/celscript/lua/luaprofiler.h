@@ -0,0 +1,91 @@
+// luaprofiler.h
+//
+// Copyright (C) 2024, the Celestia Development Team
+//
+// Profiler for celx scripts.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <lua.hpp>
+
+namespace celestia::scripts
+{
+
+/*! Aggregates the time spent in the Lua and C functions of a script. It is
+ *  driven by the debug hook of the script thread: the time between two
+ *  events is credited to the function on top of a shadow call stack, which
+ *  is kept by the call and return events, and count events sample the
+ *  running function so that the share of the instructions executed by each
+ *  Lua function is known as well.
+ */
+class LuaProfiler
+{
+ public:
+    struct Entry
+    {
+        std::string name;
+        bool isCFunction{ false };
+        double time{ 0.0 };          // seconds, excluding the functions called
+        std::uint64_t calls{ 0 };
+        std::uint64_t samples{ 0 };  // count events
+    };
+
+    // Instructions between count events while profiling
+    static constexpr int SampleInterval = 1000;
+
+    // Starts a slice of execution at the given time in seconds, when a
+    // script is resumed or a callback is called
+    void beginSlice(double time);
+
+    // Handles an event of the debug hook at the given time
+    void hook(lua_State* l, lua_Debug* ar, double time);
+
+    void reset();
+
+    // Returns the entries sorted by decreasing time
+    std::vector<Entry> getEntries() const;
+
+    // Writes the most expensive entries to the log
+    void report(std::size_t maxEntries) const;
+
+ private:
+    struct FunctionKey
+    {
+        const void* address;
+        int line;
+
+        bool operator==(const FunctionKey& other) const { return address == other.address && line == other.line; }
+    };
+
+    struct FunctionKeyHash
+    {
+        std::size_t operator()(const FunctionKey& key) const
+        {
+            return std::hash<const void*>()(key.address) ^ (static_cast<std::size_t>(key.line) * 0x9e3779b9U);
+        }
+    };
+
+    Entry* getEntry(lua_State* l, lua_Debug* ar);
+    void popTo(const Entry* entry);
+
+    std::unordered_map<std::string, Entry> entries;
+    // Entries of the functions seen, by the address of a C function or the
+    // source and line of a Lua function
+    std::unordered_map<FunctionKey, Entry*, FunctionKeyHash> functions;
+    std::vector<Entry*> callStack;
+    double lastEvent{ 0.0 };
+};
+
+} // end namespace celestia::scripts
@@ -42,7 +42,7 @@ LuaScript::~LuaScript()
     m_celxScript->cleanup();
 }
 
-bool LuaScript::load(ifstream &scriptfile, const fs::path &path, string &errorMsg)
+bool LuaScript::load(istream &scriptfile, const fs::path &path, string &errorMsg)
 {
     if (m_celxScript->loadScript(scriptfile, path) != 0)
     {
@@ -92,9 +92,14 @@ unique_ptr<IScript> LuaScriptPlugin::loadScript(const fs::path &path)
         return nullptr;
     }
 
+    return loadScript(scriptfile, path);
+}
+
+unique_ptr<IScript> LuaScriptPlugin::loadScript(istream &in, const fs::path &path)
+{
     auto script = unique_ptr<LuaScript>(new LuaScript(appCore()));
     string errMsg;
-    if (!script->load(scriptfile, path, errMsg))
+    if (!script->load(in, path, errMsg))
     {
         if (errMsg.empty())
             errMsg = _("Unknown error loading script");
@@ -26,7 +26,7 @@ class LuaScript : public IScript
     LuaScript(CelestiaCore*);
     ~LuaScript() override;
 
-    bool load(std::ifstream&, const fs::path&, std::string&);
+    bool load(std::istream&, const fs::path&, std::string&);
 
     bool handleMouseButtonEvent(float x, float y, int button, bool down) override;
     bool charEntered(const char*) override;
@@ -54,6 +54,8 @@ class LuaScriptPlugin : public IScriptPlugin
 
     bool isOurFile(const fs::path&) const override;
     std::unique_ptr<IScript> loadScript(const fs::path&) override;
+    // Load a script which isn't in a file, named by path in the messages
+    std::unique_ptr<IScript> loadScript(std::istream&, const fs::path&);
 };
 
 class LuaHook : public IScriptHook
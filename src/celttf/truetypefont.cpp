@@ -11,7 +11,10 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <memory>
 #include <system_error>
 #include <unordered_map>
@@ -24,6 +27,8 @@
 #include <celimage/image.h>
 #include <celrender/gl/buffer.h>
 #include <celrender/gl/vertexobject.h>
+#include <celutil/color.h>
+#include <celutil/fileaccesslog.h>
 #include <celutil/logger.h>
 #include <celutil/utf8.h>
 #include <ft2build.h>
@@ -57,8 +62,8 @@ struct Glyph
     int bl; // bitmap_left;
     int bt; // bitmap_top;
 
-    float tx; // x offset of glyph in texture coordinates
-    float ty; // y offset of glyph in texture coordinates
+    int tx; // x offset of glyph in the atlas, in pixels
+    int ty; // y offset of glyph in the atlas, in pixels
 };
 
 struct UnicodeBlock
@@ -67,9 +72,21 @@ struct UnicodeBlock
     FT_ULong last;
 };
 
-constexpr Glyph g_badGlyph = { 0, 0, 0, 0, 0, 0, 0, 0.0f, 0.0f };
+constexpr Glyph g_badGlyph = { 0, 0, 0, 0, 0, 0, 0, 0, 0 };
 constexpr auto INVALID_POS = static_cast<std::size_t>(-1);
 
+// The atlas has a fixed width, and its height doubles when the glyphs loaded
+// on demand don't fit in it anymore
+constexpr int AtlasWidth = 1024;
+constexpr int MinAtlasHeight = 64;
+
+// Versions of the glyph atlases, unique across the fonts so that a glyph
+// run is never taken for one laid out with another font
+std::atomic<std::uint32_t> g_atlasVersion{ 0 };
+
+// Texture memory of the glyph atlases of all the fonts
+std::atomic<std::size_t> g_atlasMemory{ 0 };
+
 } // end unnamed namespace
 
 struct TextureFontPrivate
@@ -85,6 +102,16 @@ struct TextureFontPrivate
 
     static_assert(std::is_standard_layout_v<FontVertex>);
 
+    // Vertex of batched text, transformed by the modelview matrix
+    struct BatchVertex
+    {
+        float x, y, z;
+        float u, v;
+        std::uint8_t color[4];
+    };
+
+    static_assert(std::is_standard_layout_v<BatchVertex>);
+
     TextureFontPrivate(const Renderer *renderer);
     ~TextureFontPrivate();
     TextureFontPrivate() = delete;
@@ -94,18 +121,26 @@ struct TextureFontPrivate
     TextureFontPrivate &operator=(TextureFontPrivate &&) = default;
 
     std::pair<float, float> render(std::u16string_view line, float x, float y);
+    template<typename F>
+    std::pair<float, float> layoutLine(std::u16string_view line, float x, float y, F &&addGlyph);
 
     bool                       buildAtlas();
     void                       computeTextureSize();
+    bool                       placeGlyph(Glyph & /*c*/, const FT_Bitmap & /*bitmap*/);
+    bool                       growAtlas();
+    void                       createAtlasTexture();
     bool                       loadGlyphInfo(FT_ULong /*ch*/, Glyph & /*c*/) const;
     void                       initCommonGlyphs();
     int                        getCommonGlyphsCount();
     const Glyph &              getGlyph(std::int32_t /*ch*/, char16_t /*fallback*/);
     const Glyph &              getGlyph(FT_ULong /* ch */);
     [[nodiscard]] std::size_t  toPos(FT_ULong /*ch*/) const;
-    void                       optimize();
     CelestiaGLProgram         *getProgram();
     void                       flush();
+    void                       addQuad(float x1, float y1, float x2, float y2,
+                                       float tx1, float ty1, float tx2, float ty2);
+    void                       initBatch();
+    void                       flushBatch();
 
     const Renderer    *m_renderer;
     CelestiaGLProgram *m_prog{ nullptr };
@@ -120,13 +155,24 @@ struct TextureFontPrivate
     int m_texHeight{ 0 };
 
     std::unique_ptr<ImageTexture> m_tex; // texture object
+    std::unique_ptr<Image> m_atlas; // copy of the texture
+
+    // Free space of the atlas: the glyphs are placed left to right on
+    // shelves as high as their highest glyph
+    int m_shelfX{ 0 };
+    int m_shelfY{ 0 };
+    int m_shelfHeight{ 0 };
 
     std::vector<Glyph> m_glyphs; // character information
 
+    // Position in m_glyphs of the glyphs out of the common blocks, or
+    // INVALID_POS for those the font doesn't have
+    std::unordered_map<FT_ULong, std::size_t> m_extraGlyphs;
+
     std::array<UnicodeBlock, 2> m_unicodeBlocks;
 
     int m_commonGlyphsCount{ 0 };
-    int m_inserted{ 0 };
+    std::uint32_t m_atlasVersion{ 0 };
 
     Eigen::Matrix4f m_projection;
     Eigen::Matrix4f m_modelView;
@@ -139,8 +185,20 @@ struct TextureFontPrivate
 
     bool m_shaderInUse{ false };
 
+    bool                      m_batching{ false };
+    std::vector<BatchVertex>  m_batchVertices;
+    std::array<std::uint8_t, 4> m_batchColor{ 255, 255, 255, 255 };
+    Eigen::Matrix4f           m_batchProjection;
+    gl::VertexObject          m_batchVao{ celestia::util::NoCreateT{} };
+    gl::Buffer                m_batchVbo{ celestia::util::NoCreateT{} };
+    gl::Buffer                m_batchVio{ celestia::util::NoCreateT{} };
+
     static constexpr std::size_t MaxVertices = 256; // This gives BO size 4kB, MUST be multiply of 4
     static constexpr std::size_t MaxIndices = MaxVertices / 4 * 6;
+
+    // Largest batch addressable with 16-bit indices
+    static constexpr std::size_t MaxBatchVertices = 65536;
+    static constexpr std::size_t MaxBatchIndices = MaxBatchVertices / 4 * 6;
 };
 
 
@@ -172,6 +230,8 @@ TextureFontPrivate::~TextureFontPrivate()
 {
     if (m_face != nullptr)
         FT_Done_Face(m_face);
+    if (m_tex != nullptr)
+        g_atlasMemory -= m_tex->getMemoryUsage();
 }
 
 bool
@@ -214,35 +274,103 @@ TextureFontPrivate::initCommonGlyphs()
     }
 }
 
+// Size of an atlas holding the common glyphs, with as much room left for the
+// glyphs loaded on demand
 void
 TextureFontPrivate::computeTextureSize()
 {
-    int roww = 0;
+    int width = std::min(AtlasWidth, gl::maxTextureSize);
+    int x = 0;
+    int y = 0;
     int rowh = 0;
-    int w    = 0;
-    int h    = 0;
 
-    // Find minimum size for a texture holding all visible ASCII characters
     for (const auto &c : m_glyphs)
     {
         if (c.ch == 0) continue; // skip bad glyphs
 
-        if (roww + static_cast<int>(c.bw) + 1 >= celestia::gl::maxTextureSize)
+        if (x + static_cast<int>(c.bw) > width)
         {
-            w = std::max(w, roww);
-            h += rowh;
-            roww = 0;
+            y += rowh;
+            x = 0;
             rowh = 0;
         }
-        roww += c.bw + 1;
-        rowh = std::max(rowh, static_cast<int>(c.bh));
+        x += c.bw + 1;
+        rowh = std::max(rowh, static_cast<int>(c.bh) + 1);
+    }
+
+    y += rowh;
+
+    int height = MinAtlasHeight;
+    while (height < y * 2 && height * 2 <= gl::maxTextureSize)
+        height *= 2;
+
+    m_texWidth  = width;
+    m_texHeight = height;
+}
+
+// Copy the bitmap of a glyph to the free space of the atlas image, and
+// remember its offset. Returns false if the glyph doesn't fit.
+bool
+TextureFontPrivate::placeGlyph(Glyph &c, const FT_Bitmap &bitmap)
+{
+    auto bw = static_cast<int>(bitmap.width);
+    auto bh = static_cast<int>(bitmap.rows);
+    if (m_shelfX + bw > m_texWidth)
+    {
+        m_shelfY += m_shelfHeight;
+        m_shelfX = 0;
+        m_shelfHeight = 0;
+    }
+
+    if (bw > m_texWidth || m_shelfY + bh > m_texHeight)
+        return false;
+
+    for (int y = 0; y < bh; y++)
+    {
+        std::uint8_t *dst = m_atlas->getPixelRow(m_shelfY + y) + m_shelfX * m_atlas->getComponents();
+        const std::uint8_t *src = bitmap.buffer + y * bitmap.pitch;
+        std::memcpy(dst, src, bitmap.width);
     }
 
-    w = std::max(w, roww);
-    h += rowh;
+    c.tx = m_shelfX;
+    c.ty = m_shelfY;
 
-    m_texWidth  = w;
-    m_texHeight = h;
+    // Leave a texel between glyphs, so that they don't bleed into each other
+    m_shelfX += bw + 1;
+    m_shelfHeight = std::max(m_shelfHeight, bh + 1);
+    return true;
+}
+
+// Double the height of the atlas, keeping the glyphs where they are. Their
+// texture coordinates change, so the text laid out before must be laid out
+// again.
+bool
+TextureFontPrivate::growAtlas()
+{
+    if (m_texHeight * 2 > gl::maxTextureSize)
+        return false;
+
+    auto atlas = std::make_unique<Image>(PixelFormat::Luminance, m_texWidth, m_texHeight * 2);
+    auto size = static_cast<std::size_t>(m_atlas->getPitch()) * static_cast<std::size_t>(m_texHeight);
+    std::memcpy(atlas->getPixels(), m_atlas->getPixels(), size);
+    std::memset(atlas->getPixelRow(m_texHeight), 0, size);
+
+    m_atlas = std::move(atlas);
+    m_texHeight *= 2;
+    createAtlasTexture();
+    return true;
+}
+
+void
+TextureFontPrivate::createAtlasTexture()
+{
+    // The texture coordinates of all glyphs change
+    m_atlasVersion = ++g_atlasVersion;
+
+    if (m_tex != nullptr)
+        g_atlasMemory -= m_tex->getMemoryUsage();
+    m_tex = std::make_unique<ImageTexture>(*m_atlas, Texture::EdgeClamp, Texture::NoMipMaps);
+    g_atlasMemory += m_tex->getMemoryUsage();
 }
 
 bool
@@ -252,52 +380,27 @@ TextureFontPrivate::buildAtlas()
     computeTextureSize();
 
     // Create an image that will be used to hold all glyphs
-    auto img = std::make_unique<Image>(PixelFormat::Luminance, m_texWidth, m_texHeight);
+    m_atlas = std::make_unique<Image>(PixelFormat::Luminance, m_texWidth, m_texHeight);
+    std::memset(m_atlas->getPixels(), 0, static_cast<std::size_t>(m_atlas->getSize()));
+    m_shelfX = 0;
+    m_shelfY = 0;
+    m_shelfHeight = 0;
 
     // Paste all glyph bitmaps into the texture, remembering the offset
-    int ox = 0;
-    int oy = 0;
-    int rowh = 0;
-
     FT_GlyphSlot g = m_face->glyph;
     for (auto &c : m_glyphs)
     {
         if (c.ch == 0)
             continue; // skip bad glyphs
 
-        if (FT_Load_Char(m_face, c.ch, FT_LOAD_RENDER) != 0)
+        if (FT_Load_Char(m_face, c.ch, FT_LOAD_RENDER) != 0 || !placeGlyph(c, g->bitmap))
         {
             GetLogger()->warn("Loading character {:x} failed!\n", static_cast<unsigned>(c.ch));
             c.ch = 0;
-            continue;
         }
-
-        // compute subimage position
-        if (ox + int(g->bitmap.width) > int(m_texWidth))
-        {
-            oy += rowh;
-            rowh = 0;
-            ox   = 0;
-        }
-
-        // copy glyph image to the destination image
-        auto bitmapRows = static_cast<int>(g->bitmap.rows);
-        for (int y = 0; y < bitmapRows; y++)
-        {
-            std::uint8_t *dst = img->getPixelRow(oy + y) + ox * img->getComponents();
-            const std::uint8_t *src = g->bitmap.buffer + y * g->bitmap.width;
-            memcpy(dst, src, g->bitmap.width);
-        }
-
-        c.tx = static_cast<float>(ox) / static_cast<float>(m_texWidth);
-        c.ty = static_cast<float>(oy) / static_cast<float>(m_texHeight);
-
-        rowh = std::max(rowh, static_cast<int>(g->bitmap.rows));
-        ox += g->bitmap.width + 1;
     }
 
-    m_tex = std::make_unique<ImageTexture>(*img, Texture::EdgeClamp, Texture::NoMipMaps);
-
+    createAtlasTexture();
     return true;
 }
 
@@ -353,32 +456,50 @@ TextureFontPrivate::getGlyph(FT_ULong ch)
     if (auto pos = toPos(ch); pos != INVALID_POS)
         return m_glyphs[pos];
 
-    auto it = std::find_if(m_glyphs.cbegin() + getCommonGlyphsCount(),
-                           m_glyphs.cend(),
-                           [ch](const Glyph &g) { return g.ch == ch; });
-
-    if (it != m_glyphs.end())
-        return *it;
+    if (auto it = m_extraGlyphs.find(ch); it != m_extraGlyphs.end())
+        return it->second == INVALID_POS ? g_badGlyph : m_glyphs[it->second];
 
+    // Other glyphs are rendered once, when first needed, and added to the
+    // free space of the atlas
     Glyph c;
     if (!loadGlyphInfo(ch, c))
+    {
+        m_extraGlyphs.try_emplace(ch, INVALID_POS);
         return g_badGlyph;
+    }
 
-    flush(); // render text to avoid garbled output due to changed texture
+    // loadGlyphInfo left the bitmap of the glyph in the glyph slot
+    if (c.bw > 0 && c.bh > 0)
+    {
+        const FT_Bitmap &bitmap = m_face->glyph->bitmap;
+        if (!placeGlyph(c, bitmap))
+        {
+            // render text to avoid garbled output due to changed texture
+            if (m_batching)
+                flushBatch();
+            else
+                flush();
 
+            do
+            {
+                if (!growAtlas())
+                {
+                    GetLogger()->warn("No room for character {:x} in the font atlas\n", static_cast<unsigned>(ch));
+                    m_extraGlyphs.try_emplace(ch, INVALID_POS);
+                    return g_badGlyph;
+                }
+            } while (!placeGlyph(c, bitmap));
+        }
+
+        m_tex->updateRows(*m_atlas, c.ty, static_cast<int>(c.bh));
+    }
+
+    m_extraGlyphs.try_emplace(ch, m_glyphs.size());
     m_glyphs.push_back(c);
-    if (++m_inserted == 10) optimize();
-    buildAtlas();
 
     return m_glyphs.back();
 }
 
-void
-TextureFontPrivate::optimize()
-{
-    m_inserted = 0;
-}
-
 /*
  * Render text using the currently loaded font and currently set font size.
  * Rendering starts at coordinates (x, y), z is always 0.
@@ -393,6 +514,22 @@ TextureFontPrivate::render(std::u16string_view line, float x, float y)
     // Use the texture containing the atlas
     m_tex->bind();
 
+    return layoutLine(line, x, y,
+                      [this](float x1, float y1, float x2, float y2,
+                             float tx1, float ty1, float tx2, float ty2)
+                      {
+                          addQuad(x1, y1, x2, y2, tx1, ty1, tx2, ty2);
+                      });
+}
+
+/*
+ * Pass the quad of each glyph of the line, starting at (x, y), to addGlyph
+ * and return the position after the line.
+ */
+template<typename F>
+std::pair<float, float>
+TextureFontPrivate::layoutLine(std::u16string_view line, float x, float y, F &&addGlyph)
+{
     std::u16string_view::size_type i = 0;
     while (i < line.size())
     {
@@ -434,20 +571,130 @@ TextureFontPrivate::render(std::u16string_view line, float x, float y)
         // Skip glyphs that have no pixels
         if (g.bw == 0 || g.bh == 0) continue;
 
-        const float tx1 = g.tx;
-        const float ty1 = g.ty;
-        const float tx2 = tx1 + w / m_texWidth;
-        const float ty2 = ty1 + h / m_texHeight;
+        const float tx1 = static_cast<float>(g.tx) / static_cast<float>(m_texWidth);
+        const float ty1 = static_cast<float>(g.ty) / static_cast<float>(m_texHeight);
+        const float tx2 = tx1 + w / static_cast<float>(m_texWidth);
+        const float ty2 = ty1 + h / static_cast<float>(m_texHeight);
+
+        addGlyph(x1, y1, x2, y2, tx1, ty1, tx2, ty2);
+    }
 
+    return {x, y};
+}
+
+void
+TextureFontPrivate::addQuad(float x1, float y1, float x2, float y2,
+                            float tx1, float ty1, float tx2, float ty2)
+{
+    if (!m_batching)
+    {
         m_fontVertices.emplace_back(x1, y1, tx1, ty2);
         m_fontVertices.emplace_back(x2, y1, tx2, ty2);
         m_fontVertices.emplace_back(x1, y2, tx1, ty1);
         m_fontVertices.emplace_back(x2, y2, tx2, ty1);
 
         if (m_fontVertices.size() == MaxVertices) flush();
+        return;
     }
 
-    return {x, y};
+    auto addVertex = [this](float x, float y, float u, float v)
+    {
+        Eigen::Vector4f p = m_modelView * Eigen::Vector4f(x, y, 0.0f, 1.0f);
+        BatchVertex &vertex = m_batchVertices.emplace_back();
+        vertex.x = p.x();
+        vertex.y = p.y();
+        vertex.z = p.z();
+        vertex.u = u;
+        vertex.v = v;
+        std::copy(m_batchColor.begin(), m_batchColor.end(), vertex.color);
+    };
+
+    addVertex(x1, y1, tx1, ty2);
+    addVertex(x2, y1, tx2, ty2);
+    addVertex(x1, y2, tx1, ty1);
+    addVertex(x2, y2, tx2, ty1);
+
+    if (m_batchVertices.size() == MaxBatchVertices) flushBatch();
+}
+
+void
+TextureFontPrivate::initBatch()
+{
+    if (m_batchVbo.id() != 0)
+        return;
+
+    // The index buffer is the same for every batch
+    std::vector<std::uint16_t> indexes;
+    indexes.reserve(MaxBatchIndices);
+    for (std::size_t index = 0; index < MaxBatchVertices; index += 4)
+    {
+        auto i = static_cast<std::uint16_t>(index);
+        indexes.push_back(i + 0);
+        indexes.push_back(i + 1);
+        indexes.push_back(i + 2);
+        indexes.push_back(i + 1);
+        indexes.push_back(i + 3);
+        indexes.push_back(i + 2);
+    }
+
+    m_batchVbo = gl::Buffer(gl::Buffer::TargetHint::Array);
+    m_batchVio = gl::Buffer(gl::Buffer::TargetHint::ElementArray, indexes);
+    m_batchVao = gl::VertexObject(gl::VertexObject::Primitive::Triangles);
+    m_batchVao.addVertexBuffer(
+        m_batchVbo,
+        CelestiaGLProgram::VertexCoordAttributeIndex,
+        3,
+        gl::VertexObject::DataType::Float,
+        false,
+        sizeof(BatchVertex),
+        offsetof(BatchVertex, x));
+    m_batchVao.addVertexBuffer(
+        m_batchVbo,
+        CelestiaGLProgram::TextureCoord0AttributeIndex,
+        2,
+        gl::VertexObject::DataType::Float,
+        false,
+        sizeof(BatchVertex),
+        offsetof(BatchVertex, u));
+    m_batchVao.addVertexBuffer(
+        m_batchVbo,
+        CelestiaGLProgram::ColorAttributeIndex,
+        4,
+        gl::VertexObject::DataType::UnsignedByte,
+        true,
+        sizeof(BatchVertex),
+        offsetof(BatchVertex, color));
+    m_batchVao.setIndexBuffer(m_batchVio, 0, gl::VertexObject::IndexType::UnsignedShort);
+}
+
+void
+TextureFontPrivate::flushBatch()
+{
+    if (m_batchVertices.empty())
+        return;
+
+    auto *prog = m_renderer->getShaderManager().getShader("textbatch");
+    if (prog == nullptr || m_tex == nullptr)
+    {
+        m_batchVertices.clear();
+        return;
+    }
+
+    initBatch();
+
+    glActiveTexture(GL_TEXTURE0);
+    m_tex->bind();
+    prog->use();
+    prog->samplerParam("atlasTex") = 0;
+    prog->setMVPMatrices(m_batchProjection);
+    m_shaderInUse = false;
+
+    m_batchVbo.invalidateData().setData(m_batchVertices, gl::Buffer::BufferUsage::StreamDraw);
+    m_batchVao.draw(static_cast<int>(m_batchVertices.size() / 4 * 6));
+    m_batchVbo.unbind();
+    m_batchVio.unbind();
+
+    m_batchVertices.clear();
 }
 
 CelestiaGLProgram *
@@ -493,6 +740,12 @@ TextureFont::TextureFont(const Renderer *renderer) :
 // Needs to have the definition of TextureFontPrivate visible when we define this
 TextureFont::~TextureFont() = default;
 
+std::size_t
+TextureFont::getTotalAtlasMemory()
+{
+    return g_atlasMemory;
+}
+
 /**
  * Render a string with the specified offset
  *
@@ -510,6 +763,64 @@ TextureFont::render(std::u16string_view line, float xoffset, float yoffset) cons
     return impl->render(line, xoffset, yoffset);
 }
 
+/**
+ * Render a line laid out by layout() with the specified offset
+ *
+ * @param run -- glyphs to render, which must be laid out with the current atlas
+ * @param xoffset -- horizontal offset
+ * @param yoffset -- vertical offset
+ * @return the start position for the next glyph
+ */
+std::pair<float, float>
+TextureFont::render(const GlyphRun &run, float xoffset, float yoffset) const
+{
+    if (impl->m_tex == nullptr)
+        return {0.0f, 0.0f};
+
+    impl->m_tex->bind();
+    for (const auto &q : run.quads)
+        impl->addQuad(q[0] + xoffset, q[1] + yoffset, q[2] + xoffset, q[3] + yoffset, q[4], q[5], q[6], q[7]);
+
+    return {xoffset + run.advanceX, yoffset + run.advanceY};
+}
+
+/**
+ * Lay out the glyphs of a line from the origin, to render it later
+ *
+ * Glyphs which aren't in the atlas yet are added to it, and when it has to
+ * grow the line is laid out again with the new texture coordinates.
+ *
+ * @param line -- line to lay out
+ * @param run -- the glyphs of the line
+ */
+void
+TextureFont::layout(std::u16string_view line, GlyphRun &run) const
+{
+    run.width = getWidth(line);
+    do
+    {
+        run.atlasVersion = impl->m_atlasVersion;
+        run.quads.clear();
+        auto [x, y] = impl->layoutLine(line, 0.0f, 0.0f,
+                                       [&run](float x1, float y1, float x2, float y2,
+                                              float tx1, float ty1, float tx2, float ty2)
+                                       {
+                                           run.quads.push_back({ x1, y1, x2, y2, tx1, ty1, tx2, ty2 });
+                                       });
+        run.advanceX = x;
+        run.advanceY = y;
+    } while (run.atlasVersion != impl->m_atlasVersion);
+}
+
+/**
+ * Return whether the glyph run was laid out with the current atlas of this font
+ */
+bool
+TextureFont::isLaidOut(const GlyphRun &run) const
+{
+    return run.atlasVersion != 0 && run.atlasVersion == impl->m_atlasVersion;
+}
+
 /**
  * Calculate string width in pixels
  *
@@ -593,7 +904,7 @@ void
 TextureFont::bind()
 {
     auto *prog = impl->getProgram();
-    if (prog == nullptr || impl->m_tex == nullptr)
+    if (prog == nullptr || impl->m_tex == nullptr || impl->m_batching)
         return;
 
     glActiveTexture(GL_TEXTURE0);
@@ -610,6 +921,18 @@ TextureFont::bind()
 void
 TextureFont::setMVPMatrices(const Eigen::Matrix4f &p, const Eigen::Matrix4f &m)
 {
+    if (impl->m_batching)
+    {
+        // Glyphs are queued already transformed by the modelview matrix, so
+        // only a change of projection requires drawing them
+        if (!impl->m_batchVertices.empty() && impl->m_batchProjection != p)
+            impl->flushBatch();
+        impl->m_batchProjection = p;
+        impl->m_projection = p;
+        impl->m_modelView  = m;
+        return;
+    }
+
     impl->m_projection = p;
     impl->m_modelView  = m;
     auto *prog         = impl->getProgram();
@@ -631,12 +954,53 @@ TextureFont::unbind()
 }
 
 /**
- * Perform all delayed text rendering operations.
+ * Perform all delayed text rendering operations. Batched text is only drawn
+ * by endBatch().
  */
 void
 TextureFont::flush()
 {
-    impl->flush();
+    if (!impl->m_batching)
+        impl->flush();
+}
+
+/**
+ * Start queueing text instead of drawing it.
+ *
+ * Until endBatch() is called, the glyphs of rendered text are transformed by
+ * the current modelview matrix on the CPU, and queued with the batch color
+ * rather than the current vertex color. All queued glyphs are then drawn with
+ * one call for each 16384 glyphs or change of projection. This allows many
+ * labels to be drawn with separate modelview matrices cheaply.
+ */
+void
+TextureFont::beginBatch()
+{
+    flush();
+    impl->m_batching = true;
+    impl->m_batchProjection = impl->m_projection;
+}
+
+/**
+ * Set the color of text queued afterwards in the current batch.
+ */
+void
+TextureFont::setBatchColor(const Color &color)
+{
+    color.get(impl->m_batchColor.data());
+}
+
+/**
+ * Draw the queued text and return to immediate rendering.
+ */
+void
+TextureFont::endBatch()
+{
+    if (!impl->m_batching)
+        return;
+
+    impl->flushBatch();
+    impl->m_batching = false;
 }
 
 namespace
@@ -742,18 +1106,23 @@ LoadTextureFont(const Renderer *r, const fs::path &filename, int index, int size
         int  psize    = TextureFont::kDefaultSize;
         int  pindex   = 0;
         auto nameonly = ParseFontName(filename, pindex, psize);
+        celestia::util::FileAccessScope access("font", nameonly);
         auto face     = LoadFontFace(ftlib, nameonly,
                                      index > 0 ? index : pindex,
                                      size > 0 ? size : psize,
                                      screenDpi);
         if (face == nullptr)
+        {
+            access.setFailed();
             return nullptr;
+        }
 
         ret = std::make_shared<TextureFont>(r);
         ret->impl->m_face = face;
 
         if (!ret->impl->buildAtlas())
         {
+            access.setFailed();
             FT_Done_Face(face);
             return nullptr;
         }
@@ -9,14 +9,19 @@
 
 #pragma once
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <string_view>
+#include <vector>
 
 #include <Eigen/Core>
 
 #include <celcompat/filesystem.h>
 
 
+class Color;
 class Renderer;
 class TextureFont;
 
@@ -32,6 +37,20 @@ class TextureFont
 public:
     constexpr static int kDefaultSize = 12;
 
+    /*! The glyph quads of a line laid out from the origin, so that text
+     *  which doesn't change is drawn again without looking up its glyphs.
+     *  Each quad holds the corners and the texture coordinates of a glyph.
+     */
+    struct GlyphRun
+    {
+        std::vector<std::array<float, 8>> quads;
+        float advanceX{ 0.0f };
+        float advanceY{ 0.0f };
+        int width{ 0 };
+        // Version of the glyph atlas the texture coordinates refer to
+        std::uint32_t atlasVersion{ 0 };
+    };
+
     TextureFont(const Renderer *);
     TextureFont() = delete;
     ~TextureFont();
@@ -44,6 +63,10 @@ public:
                         const Eigen::Matrix4f &m = Eigen::Matrix4f::Identity());
 
     std::pair<float, float> render(std::u16string_view line, float xoffset = 0.0f, float yoffset = 0.0f) const;
+    std::pair<float, float> render(const GlyphRun &run, float xoffset = 0.0f, float yoffset = 0.0f) const;
+
+    void layout(std::u16string_view line, GlyphRun &run) const;
+    bool isLaidOut(const GlyphRun &run) const;
 
     int getWidth(std::u16string_view) const;
     int getMaxWidth() const;
@@ -58,6 +81,13 @@ public:
     void unbind();
     void flush();
 
+    void beginBatch();
+    void setBatchColor(const Color &);
+    void endBatch();
+
+    // Texture memory of the glyph atlases of all the fonts
+    static std::size_t getTotalAtlasMemory();
+
 private:
     std::unique_ptr<TextureFontPrivate> impl;
 
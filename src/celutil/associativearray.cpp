@@ -10,29 +10,115 @@
 
 #include "associativearray.h"
 
+#include <algorithm>
+#include <array>
+
 #include <celmath/mathlib.h>
 #include "color.h"
 #include "fsutils.h"
 
+using namespace std::string_view_literals;
+
 namespace celestia::util
 {
 
+namespace
+{
+
+// Property names used by the solar system, star and deep sky catalogs, in
+// sorted order. Keys found here aren't copied into each array.
+constexpr std::array knownKeys
+{
+    "AbsMag"sv, "Absorption"sv, "AddonPath"sv, "Albedo"sv, "AltSurface"sv, "Angle"sv,
+    "AppMag"sv, "ArgOfPericenter"sv, "AscendingNode"sv, "Atmosphere"sv, "Axis"sv,
+    "BaseFrame"sv, "BaseSplit"sv, "Beginning"sv, "BlendTexture"sv, "BodyFixed"sv,
+    "BodyFrame"sv, "BoloCorrection"sv, "BondAlbedo"sv, "BoundingRadius"sv,
+    "BumpHeight"sv, "BumpMap"sv, "Category"sv, "Center"sv, "Class"sv, "Clickable"sv,
+    "CloudHeight"sv, "CloudMap"sv, "CloudNormalMap"sv, "CloudShadowDepth"sv,
+    "CloudSpeed"sv, "Color"sv, "CompressTexture"sv, "ConstantVector"sv, "CoreRadius"sv,
+    "CustomOrbit"sv, "CustomRotation"sv, "CustomTemplate"sv, "Dec"sv, "Density"sv,
+    "Description"sv, "Detail"sv, "Distance"sv, "DistanceUnits"sv, "DoublePrecision"sv,
+    "Eccentricity"sv, "EclipticJ2000"sv, "EllipticalOrbit"sv, "Emissive"sv, "Ending"sv,
+    "Epoch"sv, "EquatorAscendingNode"sv, "EquatorJ2000"sv, "Extinction"sv,
+    "FeatureHeight"sv, "FixedAttitude"sv, "FixedPosition"sv, "FixedRotation"sv,
+    "Frame"sv, "Function"sv, "GeomAlbedo"sv, "Heading"sv, "Height"sv,
+    "ImageDirectory"sv, "Importance"sv, "Inclination"sv, "InfoURL"sv, "Inner"sv,
+    "Interpolation"sv, "Kernel"sv, "KingConcentration"sv, "LabelColor"sv, "LongLat"sv,
+    "LongOfPericenter"sv, "Lower"sv, "LunarLambert"sv, "Mass"sv, "MeanAnomaly"sv,
+    "MeanEquator"sv, "MeanLongitude"sv, "MeridianAngle"sv, "Mesh"sv, "MeshCenter"sv,
+    "MeshScale"sv, "Mie"sv, "MieAsymmetry"sv, "MieScaleHeight"sv, "Module"sv, "Name"sv,
+    "NightTexture"sv, "NoiseOffset"sv, "NormalMap"sv, "NormalizeMesh"sv, "Object"sv,
+    "Oblateness"sv, "Obliquity"sv, "Observer"sv, "Octaves"sv, "OrbitBarycenter"sv,
+    "OrbitColor"sv, "OrbitFrame"sv, "Orientation"sv, "Origin"sv, "Outer"sv,
+    "OverlayTexture"sv, "PericenterDistance"sv, "Period"sv, "Planetocentric"sv,
+    "Planetographic"sv, "Position"sv, "PrecessingRotation"sv, "PrecessionPeriod"sv,
+    "PrecessionRate"sv, "Primary"sv, "RA"sv, "Radius"sv, "Rayleigh"sv,
+    "RayleighScaleHeight"sv, "Rectangular"sv, "Reflectivity"sv, "RelativePosition"sv,
+    "RelativeVelocity"sv, "Rings"sv, "Roll"sv, "RotationEpoch"sv, "RotationOffset"sv,
+    "RotationPeriod"sv, "SampledOrbit"sv, "SampledOrientation"sv, "SampledTrajectory"sv,
+    "ScriptedOrbit"sv, "ScriptedRotation"sv, "Secondary"sv, "SemiAxes"sv,
+    "SemiMajorAxis"sv, "Size"sv, "Sky"sv, "Slices"sv, "Source"sv, "SpectralType"sv,
+    "SpecularColor"sv, "SpecularPower"sv, "SpecularTexture"sv, "SpiceOrbit"sv,
+    "SpiceRotation"sv, "Sunset"sv, "TailColor"sv, "Target"sv, "TempDiscrepancy"sv,
+    "Temperature"sv, "Texture"sv, "TilePrefix"sv, "TileSize"sv, "TileType"sv, "Tilt"sv,
+    "Timeline"sv, "Topocentric"sv, "TwoVector"sv, "Type"sv, "UniformRotation"sv,
+    "Upper"sv, "Vector"sv, "Visible"sv,
+};
+
+template<std::size_t N>
+constexpr bool
+isSorted(const std::array<std::string_view, N>& keys)
+{
+    for (std::size_t i = 1; i < N; ++i)
+    {
+        if (!(keys[i - 1] < keys[i]))
+            return false;
+    }
+
+    return true;
+}
+
+static_assert(isSorted(knownKeys));
+
+struct KeyLess
+{
+    template<typename T>
+    bool operator()(const T& entry, std::string_view key) const { return entry.key < key; }
+};
+
+} // end unnamed namespace
+
 const Value*
 AssociativeArray::getValue(std::string_view key) const
 {
-    auto iter = assoc.find(key);
-    if (iter == assoc.end())
+    auto iter = std::lower_bound(entries.begin(), entries.end(), key, KeyLess{});
+    if (iter == entries.end() || iter->key != key)
         return nullptr;
 
-    return &values[iter->second];
+    return &values[iter->index];
 }
 
 void
-AssociativeArray::addValue(std::string&& key, Value&& val)
+AssociativeArray::addValue(std::string_view key, Value&& val)
 {
-    std::size_t index = values.size();
-    if (assoc.try_emplace(std::move(key), index).second)
-        values.emplace_back(std::move(val));
+    auto iter = std::lower_bound(entries.begin(), entries.end(), key, KeyLess{});
+    if (iter != entries.end() && iter->key == key)
+        return;
+
+    entries.insert(iter, Entry{ internKey(key), values.size() });
+    values.emplace_back(std::move(val));
+}
+
+std::string_view
+AssociativeArray::internKey(std::string_view key)
+{
+    if (auto iter = std::lower_bound(knownKeys.begin(), knownKeys.end(), key);
+        iter != knownKeys.end() && *iter == key)
+    {
+        return *iter;
+    }
+
+    return ownedKeys.emplace_front(key);
 }
 
 std::optional<double>
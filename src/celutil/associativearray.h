@@ -11,8 +11,7 @@
 #pragma once
 
 #include <cstddef>
-#include <functional>
-#include <map>
+#include <forward_list>
 #include <memory>
 #include <optional>
 #include <string>
@@ -36,8 +35,6 @@ class Value;
 class AssociativeArray
 {
 public:
-    using AssocType = std::map<std::string, std::size_t, std::less<>>;
-
     AssociativeArray() = default;
     ~AssociativeArray();
     AssociativeArray(AssociativeArray&&) = delete;
@@ -46,7 +43,8 @@ public:
     AssociativeArray& operator=(AssociativeArray&) = delete;
 
     const Value* getValue(std::string_view) const;
-    void addValue(std::string&&, Value&&);
+    // If the key is already present, the previous value is kept
+    void addValue(std::string_view, Value&&);
 
     template<typename T, std::enable_if_t<std::is_arithmetic_v<T>, int> = 0>
     std::optional<T> getNumber(std::string_view key) const
@@ -144,10 +142,21 @@ public:
     void for_all(T& action) const;
 
 private:
+    struct Entry
+    {
+        std::string_view key;
+        std::size_t index;
+    };
+
+    // Keywords of the catalog files are interned from a static dictionary,
+    // only other keys need storage of their own.
+    std::string_view internKey(std::string_view);
+
     // At this point, Value is an incomplete type. C++17 allows us to store
-    // this in a vector but not a map, so use the map to store vector indices
+    // this in a vector, so the entries sorted by key store vector indices.
     std::vector<Value> values;
-    AssocType assoc;
+    std::vector<Entry> entries;
+    std::forward_list<std::string> ownedKeys;
 
     std::optional<double> getNumberImpl(std::string_view) const;
     std::optional<Eigen::Vector3d> getVector3Impl(std::string_view) const;
@@ -345,9 +354,9 @@ template<typename T>
 void
 AssociativeArray::for_all(T& action) const
 {
-    for (const auto& [key, value] : assoc)
+    for (const auto& entry : entries)
     {
-        action(key, values[value]);
+        action(entry.key, values[entry.index]);
     }
 }
 
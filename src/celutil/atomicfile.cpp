@@ -0,0 +1,85 @@
+// atomicfile.cpp
+//
+// Copyright (C) 2026, Celestia Development Team
+//
+// Files replaced in one step once they are completely written.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include "atomicfile.h"
+
+#include <atomic>
+#include <cstdint>
+#include <system_error>
+
+#include <fmt/format.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace celestia::util
+{
+
+namespace
+{
+
+std::uint64_t
+processId()
+{
+#ifdef _WIN32
+    return GetCurrentProcessId();
+#else
+    return static_cast<std::uint64_t>(getpid());
+#endif
+}
+
+std::atomic<std::uint32_t> tempFileCounter{ 0 };
+
+} // end unnamed namespace
+
+AtomicFile::AtomicFile(const fs::path& path) :
+    m_path(path),
+    m_tempPath(path)
+{
+    m_tempPath += fmt::format(".{:x}.{:x}.tmp", processId(), tempFileCounter.fetch_add(1, std::memory_order_relaxed));
+    m_out.open(m_tempPath, std::ios::out | std::ios::binary | std::ios::trunc);
+}
+
+AtomicFile::~AtomicFile()
+{
+    if (m_out.is_open())
+    {
+        m_out.close();
+        std::error_code ec;
+        fs::remove(m_tempPath, ec);
+    }
+}
+
+bool
+AtomicFile::commit()
+{
+    if (!m_out.is_open())
+        return false;
+
+    bool ok = m_out.flush().good();
+    m_out.close();
+
+    std::error_code ec;
+    if (ok)
+        fs::rename(m_tempPath, m_path, ec);
+    if (!ok || ec)
+    {
+        fs::remove(m_tempPath, ec);
+        return false;
+    }
+
+    return true;
+}
+
+} // end namespace celestia::util
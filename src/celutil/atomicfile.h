@@ -0,0 +1,55 @@
+// atomicfile.h
+//
+// Copyright (C) 2026, Celestia Development Team
+//
+// Files replaced in one step once they are completely written.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <fstream>
+
+#include <celcompat/filesystem.h>
+
+namespace celestia::util
+{
+
+/*! Writes a file through a temporary file in the same directory, which is
+ *  renamed over it on commit. Readers never see a partial file, and a
+ *  process mapping the previous file keeps its contents. The temporary name
+ *  is unique to the process and the writer, so concurrent writers of the
+ *  same file, in this process or in others, don't clobber each other: the
+ *  last one to commit wins. The temporary file is removed if the writer is
+ *  destroyed without committing.
+ */
+class AtomicFile
+{
+public:
+    explicit AtomicFile(const fs::path& path);
+    ~AtomicFile();
+
+    AtomicFile(const AtomicFile&) = delete;
+    AtomicFile& operator=(const AtomicFile&) = delete;
+    AtomicFile(AtomicFile&&) = delete;
+    AtomicFile& operator=(AtomicFile&&) = delete;
+
+    bool isOpen() const { return m_out.is_open(); }
+    // The binary stream writing the temporary file
+    std::ofstream& stream() { return m_out; }
+
+    // Close the temporary file and rename it over the destination. Returns
+    // false if a write or the rename failed, leaving the destination as it
+    // was.
+    bool commit();
+
+private:
+    fs::path m_path;
+    fs::path m_tempPath;
+    std::ofstream m_out;
+};
+
+} // end namespace celestia::util
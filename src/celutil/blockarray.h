@@ -16,6 +16,7 @@
 #include <iterator>
 #include <limits>
 #include <memory>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -28,6 +29,10 @@
  *  - The address of a BlockArray element is guaranteed not to
  *    change over the lifetime of the BlockArray (or until the
  *    BlockArray is cleared.)
+ *
+ *  Each block is contiguous, so loops over all the elements are faster
+ *  with for_each_block(), which avoids the block lookup of each access
+ *  through the iterators and can be vectorized.
  */
 template<typename T, std::size_t BLOCKSIZE = 1024>
 class BlockArray
@@ -197,9 +202,75 @@ public:
         return m_blocks.back()->emplace_back(std::forward<Args>(args)...);
     }
 
+    // Append the elements of the range, filling the blocks one at a time
+    template<typename InputIt>
+    void append(InputIt first, InputIt last)
+    {
+        using category = typename std::iterator_traits<InputIt>::iterator_category;
+        if constexpr (std::is_base_of_v<std::forward_iterator_tag, category>)
+        {
+            auto remaining = static_cast<std::size_t>(std::distance(first, last));
+            while (remaining > 0)
+            {
+                if (m_blocks.empty() || m_blocks.back()->size() == BLOCKSIZE)
+                    m_blocks.push_back(std::make_unique<block_type>());
+
+                block_type& block = *m_blocks.back();
+                std::size_t count = std::min(remaining, BLOCKSIZE - block.size());
+                InputIt next = std::next(first, static_cast<difference_type>(count));
+                block.insert(block.end(), first, next);
+                first = next;
+                remaining -= count;
+            }
+        }
+        else
+        {
+            for (; first != last; ++first)
+                push_back(*first);
+        }
+    }
+
+    size_type block_count() const noexcept { return m_blocks.size(); }
+
+    // Invoke func(data, count) for each block, in order
+    template<typename F>
+    void for_each_block(F&& func)
+    {
+        for (const auto& block : m_blocks)
+            func(block->data(), block->size());
+    }
+
+    template<typename F>
+    void for_each_block(F&& func) const
+    {
+        for (const auto& block : m_blocks)
+            func(static_cast<const T*>(block->data()), block->size());
+    }
+
+    // Invoke func(data, count, offset) for each block in parallel, where
+    // offset is the position of the first element of the block. The
+    // executor is a util::ThreadPool.
+    template<typename EXECUTOR, typename F>
+    void for_each_block(EXECUTOR& executor, F&& func)
+    {
+        executor.parallelFor(m_blocks.size(), [this, &func](std::size_t i)
+        {
+            func(m_blocks[i]->data(), m_blocks[i]->size(), i * BLOCKSIZE);
+        });
+    }
+
+    template<typename EXECUTOR, typename F>
+    void for_each_block(EXECUTOR& executor, F&& func) const
+    {
+        executor.parallelFor(m_blocks.size(), [this, &func](std::size_t i)
+        {
+            func(static_cast<const T*>(m_blocks[i]->data()), m_blocks[i]->size(), i * BLOCKSIZE);
+        });
+    }
+
     void pop_back()
     {
-        block_type* lastBlock = m_blocks.back();
+        block_type* lastBlock = m_blocks.back().get();
         lastBlock->pop_back();
         if (lastBlock->empty())
             m_blocks.pop_back();
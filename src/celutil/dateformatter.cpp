@@ -11,52 +11,103 @@
 
 #include "dateformatter.h"
 
+#include <cmath>
+#include <cstdint>
+
 namespace astro = celestia::astro;
 
 namespace celestia::engine
 {
 
-std::string DateFormatter::formatDate(double tdb, bool local, astro::Date::Format format)
+namespace
 {
+
 #ifdef USE_ICU
-    auto formatter = getFormatter(local, format);
-    if (formatter == nullptr)
-        return {};
+// Enough for the usual formats, longer dates go to a heap buffer
+constexpr std::int32_t FormatBufferSize = 128;
+#else
+bool
+isSameDate(const astro::Date& a, const astro::Date& b, bool compareFraction)
+{
+    return a.year == b.year && a.month == b.month && a.day == b.day &&
+           a.hour == b.hour && a.minute == b.minute && a.utc_offset == b.utc_offset &&
+           (compareFraction ? a.seconds == b.seconds
+                            : std::floor(a.seconds) == std::floor(b.seconds));
+}
+#endif
 
-    UErrorCode error = U_ZERO_ERROR;
+} // end unnamed namespace
+
+const std::string&
+DateFormatter::formatDate(double tdb, bool local, astro::Date::Format format)
+{
+#ifdef USE_ICU
     static auto epoch = astro::Date(1970, 1, 1);
     auto date = (astro::TDBtoUTC(tdb) - epoch) * 86400.0 * 1000.0;
-    auto requiredSize = udat_format(formatter, date, nullptr, 0, nullptr, &error);
-    if (U_FAILURE(error) && error != U_BUFFER_OVERFLOW_ERROR)
-        return {};
+    // Only ISO 8601 dates show the milliseconds
+    auto time = format == astro::Date::ISO8601 ? date : std::floor(date / 1000.0);
+    if (isCached(local, format) && time == lastTime)
+        return lastResult;
 
-    error = U_ZERO_ERROR;
+    hasLastResult = false;
+    lastResult.clear();
 
-    std::u16string formattedDate;
-    formattedDate.resize(requiredSize);
-    udat_format(formatter, date, formattedDate.data(), requiredSize, nullptr, &error);
+    auto formatter = getFormatter(local, format);
+    if (formatter == nullptr)
+        return lastResult;
+
+    UErrorCode error = U_ZERO_ERROR;
+    std::array<UChar, FormatBufferSize> buffer;
+    std::u16string longBuffer;
+    const UChar* formattedDate = buffer.data();
+    auto size = udat_format(formatter, date, buffer.data(), FormatBufferSize, nullptr, &error);
+    if (error == U_BUFFER_OVERFLOW_ERROR)
+    {
+        error = U_ZERO_ERROR;
+        longBuffer.resize(size);
+        udat_format(formatter, date, longBuffer.data(), size, nullptr, &error);
+        formattedDate = longBuffer.data();
+    }
 
     if (U_FAILURE(error))
-        return {};
+        return lastResult;
 
-    u_strToUTF8(nullptr, 0, &requiredSize, formattedDate.data(), formattedDate.size(), &error);
+    std::int32_t requiredSize = 0;
+    u_strToUTF8(nullptr, 0, &requiredSize, formattedDate, size, &error);
     if (U_FAILURE(error) && error != U_BUFFER_OVERFLOW_ERROR)
-        return {};
+        return lastResult;
 
     error = U_ZERO_ERROR;
-    std::string utf8FormattedDate;
-    utf8FormattedDate.resize(requiredSize);
+    lastResult.resize(requiredSize);
 
-    u_strToUTF8(utf8FormattedDate.data(), requiredSize, nullptr, formattedDate.data(), formattedDate.size(), &error);
+    u_strToUTF8(lastResult.data(), requiredSize, nullptr, formattedDate, size, &error);
 
     if (U_FAILURE(error))
-        return {};
+    {
+        lastResult.clear();
+        return lastResult;
+    }
 
-    return utf8FormattedDate;
+    lastTime = time;
 #else
     astro::Date d = local ? astro::TDBtoLocal(tdb) : astro::TDBtoUTC(tdb);
-    return d.toString(loc, format);
+    if (isCached(local, format) && isSameDate(d, lastDate, format == astro::Date::ISO8601))
+        return lastResult;
+
+    lastResult = d.toString(loc, format);
+    lastDate = d;
 #endif
+
+    hasLastResult = true;
+    lastLocal = local;
+    lastFormat = format;
+    return lastResult;
+}
+
+bool
+DateFormatter::isCached(bool local, astro::Date::Format format) const
+{
+    return hasLastResult && local == lastLocal && format == lastFormat;
 }
 
 #ifdef USE_ICU
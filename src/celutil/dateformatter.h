@@ -18,6 +18,7 @@
 #else
 #include <locale>
 #endif
+#include <string>
 
 #include <celastro/date.h>
 
@@ -38,10 +39,24 @@ public:
     DateFormatter &operator=(const DateFormatter &) = delete;
     DateFormatter &operator=(DateFormatter &&) noexcept = default;
 
-    std::string formatDate(double tdb, bool local, astro::Date::Format format);
+    // The returned string is valid until the next call. When the date is
+    // the same as in the previous call at the displayed precision, the
+    // previous string is returned without formatting again.
+    const std::string& formatDate(double tdb, bool local, astro::Date::Format format);
 
 private:
+    bool isCached(bool local, astro::Date::Format format) const;
+
+    std::string lastResult;
+    bool hasLastResult{ false };
+    bool lastLocal{ false };
+    astro::Date::Format lastFormat{ astro::Date::Locale };
+
 #ifdef USE_ICU
+    // Milliseconds since the Unix epoch, truncated to seconds when they are
+    // not displayed
+    double lastTime{ 0.0 };
+
     using UniqueDateFormat = util::UniquePtrDel<UDateFormat, udat_close>;
 
     static constexpr auto FormatCount = static_cast<std::size_t>(astro::Date::FormatCount);
@@ -52,6 +67,7 @@ private:
     UDateFormat *getFormatter(bool local, astro::Date::Format format);
 #else
     std::locale loc;
+    astro::Date lastDate;
 #endif
 };
 
@@ -0,0 +1,282 @@
+// fileaccesslog.cpp
+//
+// Copyright (C) 2026, Celestia Development Team
+//
+// Files and directories read by the loaders, with their size and latency.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include "fileaccesslog.h"
+
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+#include <fmt/format.h>
+
+#include "logger.h"
+
+namespace celestia::util
+{
+
+namespace
+{
+
+std::mutex logMutex;
+std::vector<FileAccessRecord> files;
+std::vector<DirectoryScanRecord> directoryScans;
+std::chrono::steady_clock::time_point logStart = std::chrono::steady_clock::now();
+
+template<typename D>
+std::chrono::microseconds
+toMicroseconds(D duration)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(duration);
+}
+
+double
+toMilliseconds(std::chrono::microseconds t)
+{
+    return static_cast<double>(t.count()) / 1000.0;
+}
+
+// Paths are quoted, as they may hold commas
+void
+appendCSVString(fmt::memory_buffer& buffer, std::string_view str)
+{
+    buffer.push_back('"');
+    for (char c : str)
+    {
+        if (c == '"')
+            buffer.push_back('"');
+        buffer.push_back(c);
+    }
+    buffer.push_back('"');
+}
+
+struct CategorySummary
+{
+    std::uint32_t files{ 0 };
+    std::uint32_t failed{ 0 };
+    std::uint64_t bytes{ 0 };
+    std::chrono::microseconds time{ 0 };
+    const FileAccessRecord* slowest{ nullptr };
+};
+
+void
+logSummary(const std::vector<FileAccessRecord>& fileRecords,
+           const std::vector<DirectoryScanRecord>& scanRecords)
+{
+    std::map<std::string_view, CategorySummary> categories;
+    for (const FileAccessRecord& record : fileRecords)
+    {
+        CategorySummary& summary = categories[record.category];
+        ++summary.files;
+        if (record.failed)
+            ++summary.failed;
+        summary.bytes += record.bytes;
+        summary.time += record.totalTime;
+        if (summary.slowest == nullptr || record.totalTime > summary.slowest->totalTime)
+            summary.slowest = &record;
+    }
+
+    for (const auto& [category, summary] : categories)
+    {
+        GetLogger()->info("{}: {} files ({} failed), {:.1f} MiB in {:.1f} ms, slowest {} in {:.1f} ms\n",
+                          category, summary.files, summary.failed,
+                          static_cast<double>(summary.bytes) / (1024.0 * 1024.0),
+                          toMilliseconds(summary.time),
+                          summary.slowest->path, toMilliseconds(summary.slowest->totalTime));
+    }
+
+    if (scanRecords.empty())
+        return;
+
+    std::uint32_t entries = 0;
+    std::chrono::microseconds time{ 0 };
+    for (const DirectoryScanRecord& record : scanRecords)
+    {
+        entries += record.entries;
+        time += record.time;
+    }
+
+    GetLogger()->info("directories: {} trees, {} entries in {:.1f} ms\n",
+                      scanRecords.size(), entries, toMilliseconds(time));
+}
+
+} // end unnamed namespace
+
+std::atomic<bool> FileAccessLog::enabled{ false };
+
+void
+FileAccessLog::setEnabled(bool enable)
+{
+    if (enable && !isEnabled())
+    {
+        std::scoped_lock lock(logMutex);
+        logStart = std::chrono::steady_clock::now();
+    }
+
+    enabled.store(enable, std::memory_order_relaxed);
+}
+
+std::chrono::microseconds
+FileAccessLog::now()
+{
+    return toMicroseconds(std::chrono::steady_clock::now() - logStart);
+}
+
+void
+FileAccessLog::add(FileAccessRecord&& record)
+{
+    std::scoped_lock lock(logMutex);
+    files.push_back(std::move(record));
+}
+
+void
+FileAccessLog::addDirectoryScan(DirectoryScanRecord&& record)
+{
+    std::scoped_lock lock(logMutex);
+    directoryScans.push_back(std::move(record));
+}
+
+std::vector<FileAccessRecord>
+FileAccessLog::getFiles()
+{
+    std::scoped_lock lock(logMutex);
+    return files;
+}
+
+std::vector<DirectoryScanRecord>
+FileAccessLog::getDirectoryScans()
+{
+    std::scoped_lock lock(logMutex);
+    return directoryScans;
+}
+
+void
+FileAccessLog::clear()
+{
+    std::scoped_lock lock(logMutex);
+    files.clear();
+    directoryScans.clear();
+}
+
+bool
+FileAccessLog::write(const fs::path& path)
+{
+    std::vector<FileAccessRecord> fileRecords = getFiles();
+    std::vector<DirectoryScanRecord> scanRecords = getDirectoryScans();
+
+    fmt::memory_buffer buffer;
+    buffer.append(std::string_view("category,path,start_ms,open_ms,total_ms,bytes,reads,entries,failed\n"));
+    for (const FileAccessRecord& record : fileRecords)
+    {
+        fmt::format_to(std::back_inserter(buffer), "{},", record.category);
+        appendCSVString(buffer, record.path);
+        fmt::format_to(std::back_inserter(buffer), ",{:.3f},{:.3f},{:.3f},{},{},,{}\n",
+                       toMilliseconds(record.start), toMilliseconds(record.openTime),
+                       toMilliseconds(record.totalTime), record.bytes, record.reads,
+                       record.failed ? 1 : 0);
+    }
+
+    for (const DirectoryScanRecord& record : scanRecords)
+    {
+        buffer.append(std::string_view("directory,"));
+        appendCSVString(buffer, record.path);
+        fmt::format_to(std::back_inserter(buffer), ",{:.3f},,{:.3f},,,{},0\n",
+                       toMilliseconds(record.start), toMilliseconds(record.time), record.entries);
+    }
+
+    logSummary(fileRecords, scanRecords);
+
+    std::ofstream out(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    if (!out.good())
+    {
+        GetLogger()->error("Error writing file access log {}\n", path);
+        return false;
+    }
+
+    return true;
+}
+
+FileAccessScope::FileAccessScope(const char* category, const fs::path& path) :
+    m_category(FileAccessLog::isEnabled() ? category : nullptr),
+    m_path(path)
+{
+    if (m_category != nullptr)
+        m_start = std::chrono::steady_clock::now();
+}
+
+FileAccessScope::~FileAccessScope()
+{
+    if (m_category == nullptr)
+        return;
+
+    auto end = std::chrono::steady_clock::now();
+
+    FileAccessRecord record;
+    record.path = m_path.u8string();
+    record.category = m_category;
+    record.start = toMicroseconds(m_start - logStart);
+    record.openTime = toMicroseconds(m_openTime);
+    record.totalTime = toMicroseconds(end - m_start);
+    record.bytes = m_bytes;
+    record.reads = m_reads;
+    record.failed = m_failed;
+
+    // The loaders reading through a library don't count the bytes
+    if (record.bytes == 0 && !record.failed)
+    {
+        std::error_code ec;
+        if (auto size = fs::file_size(m_path, ec); !ec)
+            record.bytes = size;
+    }
+
+    FileAccessLog::add(std::move(record));
+}
+
+void
+FileAccessScope::opened()
+{
+    if (m_category != nullptr)
+        m_openTime = std::chrono::steady_clock::now() - m_start;
+}
+
+void
+FileAccessScope::addRead(std::uint64_t bytes)
+{
+    m_bytes += bytes;
+    ++m_reads;
+}
+
+DirectoryScanScope::DirectoryScanScope(const fs::path& path) :
+    m_path(path),
+    m_enabled(FileAccessLog::isEnabled())
+{
+    if (m_enabled)
+        m_start = std::chrono::steady_clock::now();
+}
+
+DirectoryScanScope::~DirectoryScanScope()
+{
+    if (!m_enabled)
+        return;
+
+    DirectoryScanRecord record;
+    record.path = m_path.u8string();
+    record.start = toMicroseconds(m_start - logStart);
+    record.time = toMicroseconds(std::chrono::steady_clock::now() - m_start);
+    record.entries = m_entries;
+    FileAccessLog::addDirectoryScan(std::move(record));
+}
+
+} // end namespace celestia::util
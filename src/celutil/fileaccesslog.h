@@ -0,0 +1,127 @@
+// fileaccesslog.h
+//
+// Copyright (C) 2026, Celestia Development Team
+//
+// Files and directories read by the loaders, with their size and latency.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <celcompat/filesystem.h>
+
+namespace celestia::util
+{
+
+struct FileAccessRecord
+{
+    std::string path;
+    // The kind of loader, such as "catalog" or "texture"
+    const char* category{ nullptr };
+    // Relative to the enabling of the log
+    std::chrono::microseconds start{ 0 };
+    // Until the file was opened, when the loader opens it itself
+    std::chrono::microseconds openTime{ 0 };
+    // Until the file was read and decoded
+    std::chrono::microseconds totalTime{ 0 };
+    std::uint64_t bytes{ 0 };
+    // Read calls counted by the loader, 0 when it reads through a library
+    // or a mapping
+    std::uint32_t reads{ 0 };
+    bool failed{ false };
+};
+
+struct DirectoryScanRecord
+{
+    std::string path;
+    std::chrono::microseconds start{ 0 };
+    std::chrono::microseconds time{ 0 };
+    // Files and directories visited
+    std::uint32_t entries{ 0 };
+};
+
+// Keeps a record of each file read by the loaders of the catalogs, the
+// textures and virtual texture tiles, the models, the trajectories and the
+// fonts, and of the directory trees scanned for add-ons, to find the files
+// worth prebaking, caching locally or reading asynchronously on slow file
+// systems. The records of all the threads are kept, and only while the log
+// is enabled.
+class FileAccessLog
+{
+public:
+    static void setEnabled(bool enabled);
+    static bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+
+    // Time since the log was enabled
+    static std::chrono::microseconds now();
+
+    static void add(FileAccessRecord&&);
+    static void addDirectoryScan(DirectoryScanRecord&&);
+
+    static std::vector<FileAccessRecord> getFiles();
+    static std::vector<DirectoryScanRecord> getDirectoryScans();
+    static void clear();
+
+    // Write the records as CSV, one line per file or directory tree, and a
+    // summary by category to the log
+    static bool write(const fs::path&);
+
+private:
+    static std::atomic<bool> enabled;
+};
+
+// Records a file from its creation to its destruction, if the log is
+// enabled. The category must outlive the log, as string literals do.
+class FileAccessScope
+{
+public:
+    FileAccessScope(const char* category, const fs::path& path);
+    ~FileAccessScope();
+
+    FileAccessScope(const FileAccessScope&) = delete;
+    FileAccessScope& operator=(const FileAccessScope&) = delete;
+
+    // Mark the file as opened
+    void opened();
+    void addRead(std::uint64_t bytes);
+    void setFailed() { m_failed = true; }
+
+private:
+    const char* m_category;
+    const fs::path& m_path;
+    std::chrono::steady_clock::time_point m_start;
+    std::chrono::steady_clock::duration m_openTime{ 0 };
+    std::uint64_t m_bytes{ 0 };
+    std::uint32_t m_reads{ 0 };
+    bool m_failed{ false };
+};
+
+// Records the scan of a directory tree, if the log is enabled
+class DirectoryScanScope
+{
+public:
+    explicit DirectoryScanScope(const fs::path& path);
+    ~DirectoryScanScope();
+
+    DirectoryScanScope(const DirectoryScanScope&) = delete;
+    DirectoryScanScope& operator=(const DirectoryScanScope&) = delete;
+
+    void addEntry() { ++m_entries; }
+
+private:
+    const fs::path& m_path;
+    bool m_enabled;
+    std::chrono::steady_clock::time_point m_start;
+    std::uint32_t m_entries{ 0 };
+};
+
+} // end namespace celestia::util
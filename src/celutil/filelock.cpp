@@ -0,0 +1,90 @@
+// filelock.cpp
+//
+// Copyright (C) 2025, Celestia Development Team
+//
+// Advisory locks serializing processes on a file.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include "filelock.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+#endif
+
+namespace celestia::util
+{
+
+#ifdef _WIN32
+
+std::unique_ptr<FileLock>
+FileLock::acquire(const fs::path& path)
+{
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE,
+                              FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+                              OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return nullptr;
+
+    OVERLAPPED overlapped{};
+    if (!LockFileEx(file, LOCKFILE_EXCLUSIVE_LOCK, 0, MAXDWORD, MAXDWORD, &overlapped))
+    {
+        CloseHandle(file);
+        return nullptr;
+    }
+
+    std::unique_ptr<FileLock> result(new FileLock());
+    result->m_file = file;
+    return result;
+}
+
+FileLock::~FileLock()
+{
+    OVERLAPPED overlapped{};
+    UnlockFileEx(m_file, 0, MAXDWORD, MAXDWORD, &overlapped);
+    CloseHandle(m_file);
+}
+
+#else
+
+std::unique_ptr<FileLock>
+FileLock::acquire(const fs::path& path)
+{
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644); //NOSONAR
+    if (fd < 0)
+        return nullptr;
+
+    int status;
+    do
+    {
+        status = flock(fd, LOCK_EX);
+    } while (status != 0 && errno == EINTR);
+
+    if (status != 0)
+    {
+        close(fd);
+        return nullptr;
+    }
+
+    std::unique_ptr<FileLock> result(new FileLock());
+    result->m_fd = fd;
+    return result;
+}
+
+// Closing the descriptor releases the lock
+FileLock::~FileLock()
+{
+    close(m_fd);
+}
+
+#endif
+
+} // end namespace celestia::util
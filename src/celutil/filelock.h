@@ -0,0 +1,49 @@
+// filelock.h
+//
+// Copyright (C) 2025, Celestia Development Team
+//
+// Advisory locks serializing processes on a file.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <memory>
+
+#include <celcompat/filesystem.h>
+
+namespace celestia::util
+{
+
+/*! An exclusive advisory lock on a file, created if it doesn't exist. The
+ *  lock is held until the object is destroyed, or the process exits. Other
+ *  processes acquiring a lock on the same file wait for it to be released.
+ */
+class FileLock
+{
+public:
+    // Blocks until the lock is acquired, returns nullptr if the file can't
+    // be opened or locked
+    static std::unique_ptr<FileLock> acquire(const fs::path&);
+
+    ~FileLock();
+
+    FileLock(const FileLock&) = delete;
+    FileLock& operator=(const FileLock&) = delete;
+    FileLock(FileLock&&) = delete;
+    FileLock& operator=(FileLock&&) = delete;
+
+private:
+    FileLock() = default;
+
+#ifdef _WIN32
+    void* m_file{ nullptr };
+#else
+    int m_fd{ -1 };
+#endif
+};
+
+} // end namespace celestia::util
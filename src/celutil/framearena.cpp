@@ -0,0 +1,110 @@
+// framearena.cpp
+//
+// Copyright (C) 2025, Celestia Development Team
+//
+// Bump allocator for data which only lives until the end of a frame.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include "framearena.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+
+namespace celestia::util
+{
+
+namespace
+{
+
+std::size_t
+paddingFor(const std::byte* address, std::size_t alignment)
+{
+    auto misalignment = reinterpret_cast<std::uintptr_t>(address) & static_cast<std::uintptr_t>(alignment - 1); //NOSONAR
+    return misalignment == 0 ? 0 : alignment - static_cast<std::size_t>(misalignment);
+}
+
+} // end unnamed namespace
+
+FrameArena::FrameArena(std::size_t blockSize) :
+    m_blockSize(std::max(blockSize, std::size_t{ 1 }))
+{
+}
+
+void*
+FrameArena::allocate(std::size_t size, std::size_t alignment)
+{
+    assert(alignment > 0 && (alignment & (alignment - 1)) == 0);
+
+    if (m_current < m_blocks.size())
+    {
+        Block& block = m_blocks[m_current];
+        std::size_t padding = paddingFor(block.data.get() + m_offset, alignment);
+        if (padding + size <= block.size - m_offset)
+        {
+            std::byte* result = block.data.get() + m_offset + padding;
+            m_offset += padding + size;
+            m_used += padding + size;
+            return result;
+        }
+    }
+
+    nextBlock(size, alignment);
+    Block& block = m_blocks[m_current];
+    std::size_t padding = paddingFor(block.data.get(), alignment);
+    m_offset = padding + size;
+    m_used += padding + size;
+    return block.data.get() + padding;
+}
+
+std::string_view
+FrameArena::copy(std::string_view str)
+{
+    if (str.empty())
+        return {};
+
+    auto data = static_cast<char*>(allocate(str.size(), 1));
+    std::memcpy(data, str.data(), str.size());
+    return { data, str.size() };
+}
+
+void
+FrameArena::reset()
+{
+    if (m_current > 0)
+    {
+        // Merge the blocks into one which fits all the allocations of the
+        // frame
+        std::size_t size = capacity();
+        m_blocks.clear();
+        m_blocks.push_back({ std::make_unique<std::byte[]>(size), size });
+    }
+
+    m_current = 0;
+    m_offset = 0;
+    m_used = 0;
+}
+
+std::size_t
+FrameArena::capacity() const
+{
+    std::size_t total = 0;
+    for (const Block& block : m_blocks)
+        total += block.size;
+    return total;
+}
+
+void
+FrameArena::nextBlock(std::size_t size, std::size_t alignment)
+{
+    std::size_t blockSize = std::max(m_blockSize, size + alignment - 1);
+    m_blocks.push_back({ std::make_unique<std::byte[]>(blockSize), blockSize });
+    m_current = m_blocks.size() - 1;
+}
+
+} // end namespace celestia::util
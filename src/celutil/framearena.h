@@ -0,0 +1,67 @@
+// framearena.h
+//
+// Copyright (C) 2025, Celestia Development Team
+//
+// Bump allocator for data which only lives until the end of a frame.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace celestia::util
+{
+
+// Allocations are only freed all at once by reset(), which invalidates all
+// of them. When the allocations of a frame did not fit in one block, reset()
+// replaces the blocks with a single one large enough for all of them, so
+// that after the first frames the memory is contiguous and nothing is
+// allocated from the heap.
+class FrameArena
+{
+public:
+    static constexpr std::size_t DefaultBlockSize = 16384;
+
+    explicit FrameArena(std::size_t blockSize = DefaultBlockSize);
+    ~FrameArena() = default;
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+    FrameArena(FrameArena&&) noexcept = default;
+    FrameArena& operator=(FrameArena&&) noexcept = default;
+
+    // The alignment must be a power of two
+    void* allocate(std::size_t size, std::size_t alignment = alignof(std::max_align_t));
+    // Copy of the string in the arena
+    std::string_view copy(std::string_view str);
+
+    void reset();
+
+    // Bytes allocated since the last reset, including the alignment padding
+    std::size_t used() const { return m_used; }
+    std::size_t capacity() const;
+
+private:
+    struct Block
+    {
+        std::unique_ptr<std::byte[]> data;
+        std::size_t size;
+    };
+
+    void nextBlock(std::size_t size, std::size_t alignment);
+
+    std::vector<Block> m_blocks;
+    std::size_t m_blockSize;
+    std::size_t m_current{ 0 };
+    std::size_t m_offset{ 0 };
+    std::size_t m_used{ 0 };
+};
+
+} // end namespace celestia::util
@@ -188,6 +188,24 @@ bool IsValidDirectory(const fs::path& dir)
     return true;
 }
 
+fs::path RelativeToDirectory(const fs::path& path, const fs::path& dir)
+{
+    // The iterators append the names to the directory as it was given
+    const auto& str = path.native();
+    const auto& prefix = dir.native();
+    if (str.compare(0, prefix.size(), prefix) != 0)
+        return path;
+
+    auto isSeparator = [](fs::path::value_type c) { return c == '/' || c == fs::path::preferred_separator; };
+    auto pos = prefix.size();
+    if (pos > 0 && pos < str.size() && !isSeparator(prefix[pos - 1]) && !isSeparator(str[pos]))
+        return path;
+
+    while (pos < str.size() && isSeparator(str[pos]))
+        ++pos;
+    return fs::path(str.substr(pos));
+}
+
 #ifndef PORTABLE_BUILD
 fs::path HomeDir()
 {
@@ -39,6 +39,9 @@ fs::path PathExp(fs::path&& filename);
 fs::path ResolveWildcard(const fs::path& wildcard,
                          array_view<std::string_view> extensions);
 bool IsValidDirectory(const fs::path &dir);
+// Path of a file found by iterating over a directory, relative to that
+// directory; lexically_relative isn't in std::experimental::filesystem
+fs::path RelativeToDirectory(const fs::path& path, const fs::path& dir);
 #ifndef PORTABLE_BUILD
 fs::path HomeDir();
 fs::path WriteableDataPath();
@@ -0,0 +1,63 @@
+// hash.h
+//
+// Copyright (C) 2026, Celestia Development Team
+//
+// Hash of byte sequences, for the keys and checksums of the caches.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <type_traits>
+
+namespace celestia::util
+{
+
+// 64 bit FNV-1a. The value only depends on the sequence of bytes added, not
+// on how it is split between the calls. Values are added in the native byte
+// order, as the caches are only read back on the machine which wrote them.
+class FNV1aHash
+{
+public:
+    static constexpr std::uint64_t Offset = UINT64_C(0xcbf29ce484222325);
+    static constexpr std::uint64_t Prime = UINT64_C(0x100000001b3);
+
+    FNV1aHash& addBytes(const void* data, std::size_t size)
+    {
+        const auto* bytes = static_cast<const unsigned char*>(data);
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            m_value ^= bytes[i];
+            m_value *= Prime;
+        }
+        return *this;
+    }
+
+    FNV1aHash& addBytes(std::string_view bytes)
+    {
+        return addBytes(bytes.data(), bytes.size());
+    }
+
+    template<typename T>
+    FNV1aHash& addValue(T value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        unsigned char bytes[sizeof(T)]; //NOSONAR
+        std::memcpy(bytes, &value, sizeof(T));
+        return addBytes(bytes, sizeof(T));
+    }
+
+    std::uint64_t value() const { return m_value; }
+
+private:
+    std::uint64_t m_value{ Offset };
+};
+
+} // end namespace celestia::util
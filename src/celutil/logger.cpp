@@ -9,9 +9,15 @@
 // as published by the Free Software Foundation; either version 2
 // of the License, or (at your option) any later version.
 
+#include <atomic>
+#include <condition_variable>
 #include <cstdlib>
 #include <iostream>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
 
 #ifdef _MSC_VER
 #    include <windows.h>
@@ -57,6 +63,194 @@ DestroyLogger()
     globalLogger = nullptr;
 }
 
+AsyncLogScope::AsyncLogScope(Logger *logger) :
+    m_logger(logger)
+{
+    if (m_logger != nullptr)
+        m_wasAsync = m_logger->setAsync(true);
+}
+
+AsyncLogScope::~AsyncLogScope()
+{
+    end();
+}
+
+void
+AsyncLogScope::end()
+{
+    if (m_logger == nullptr)
+        return;
+
+    m_logger->setAsync(m_wasAsync);
+    m_logger = nullptr;
+}
+
+// Writes the messages queued by any thread from a background thread. The
+// queue is the intrusive multiple producer, single consumer queue of
+// D. Vyukov: producers only exchange the head pointer, and the writer
+// follows the links from the tail, which is always a node already written.
+class Logger::AsyncWriter
+{
+public:
+    AsyncWriter(Stream &log, Stream &err);
+    ~AsyncWriter();
+
+    void push(Level level, std::string &&text);
+
+private:
+    struct Record
+    {
+        std::atomic<Record*> next{ nullptr };
+        Level level{ Level::Info };
+        std::string text;
+    };
+
+    void run();
+    // Write the queued records, returns false if there were none
+    bool drain();
+    void write(Level level, const std::string &text);
+    void writeRepeats();
+
+    Stream &m_log;
+    Stream &m_err;
+
+    std::atomic<Record*> m_head;
+    Record *m_tail;
+    std::atomic<bool> m_pending{ false };
+    std::atomic<bool> m_stopping{ false };
+    std::mutex m_mutex;
+    std::condition_variable m_wakeup;
+
+    // Only used by the writer thread
+    Level m_lastLevel{ Level::Info };
+    std::string m_lastText;
+    unsigned int m_repeats{ 0 };
+
+    std::thread m_thread;
+};
+
+Logger::AsyncWriter::AsyncWriter(Stream &log, Stream &err) :
+    m_log(log),
+    m_err(err),
+    m_head(new Record),
+    m_tail(m_head.load(std::memory_order_relaxed)),
+    m_thread(&AsyncWriter::run, this)
+{
+}
+
+Logger::AsyncWriter::~AsyncWriter()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping.store(true, std::memory_order_relaxed);
+    }
+    m_wakeup.notify_one();
+    m_thread.join();
+
+    delete m_tail;
+}
+
+void
+Logger::AsyncWriter::push(Level level, std::string &&text)
+{
+    auto *record = new Record;
+    record->level = level;
+    record->text = std::move(text);
+
+    Record *previous = m_head.exchange(record, std::memory_order_acq_rel);
+    previous->next.store(record, std::memory_order_release);
+
+    // Only the producer which finds the writer idle takes the lock to wake
+    // it up
+    if (!m_pending.exchange(true, std::memory_order_acq_rel))
+    {
+        { std::lock_guard<std::mutex> lock(m_mutex); }
+        m_wakeup.notify_one();
+    }
+}
+
+void
+Logger::AsyncWriter::run()
+{
+    for (;;)
+    {
+        // Both sides exchange the flag, so either this reads the flag set by
+        // a producer and then sees its record, or the producer finds the
+        // flag cleared and wakes the writer up
+        m_pending.exchange(false, std::memory_order_acq_rel);
+        if (drain())
+            continue;
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (m_stopping.load(std::memory_order_relaxed))
+            break;
+        m_wakeup.wait(lock, [this]
+        {
+            return m_pending.load(std::memory_order_acquire) || m_stopping.load(std::memory_order_relaxed);
+        });
+    }
+
+    // A producer may be between the exchange of the head and the link
+    // to its record, wait for it
+    while (m_tail != m_head.load(std::memory_order_acquire))
+    {
+        if (!drain())
+            std::this_thread::yield();
+    }
+
+    writeRepeats();
+    m_log.flush();
+    m_err.flush();
+}
+
+bool
+Logger::AsyncWriter::drain()
+{
+    bool written = false;
+    for (Record *next = m_tail->next.load(std::memory_order_acquire);
+         next != nullptr;
+         next = m_tail->next.load(std::memory_order_acquire))
+    {
+        delete m_tail;
+        m_tail = next;
+        write(next->level, next->text);
+        written = true;
+    }
+
+    return written;
+}
+
+void
+Logger::AsyncWriter::write(Level level, const std::string &text)
+{
+    if (level == m_lastLevel && text == m_lastText)
+    {
+        ++m_repeats;
+        return;
+    }
+
+    writeRepeats();
+    auto &stream = (level <= Level::Warning || level == Level::Debug) ? m_err : m_log;
+    stream << text;
+
+    m_lastLevel = level;
+    m_lastText = text;
+}
+
+void
+Logger::AsyncWriter::writeRepeats()
+{
+    if (m_repeats == 0)
+        return;
+
+    auto &stream = (m_lastLevel <= Level::Warning || m_lastLevel == Level::Debug) ? m_err : m_log;
+    if (m_repeats == 1)
+        stream << "Last message repeated 1 time\n";
+    else
+        fmt::print(stream, "Last message repeated {} times\n", m_repeats);
+    m_repeats = 0;
+}
+
 Logger::Logger() :
     Logger(Level::Info, std::clog, std::cerr)
 {
@@ -69,12 +263,25 @@ Logger::Logger(Level level, Stream &log, Stream &err) :
 {
 }
 
+Logger::~Logger() = default;
+
 void
 Logger::setLevel(Level level)
 {
     m_level = level;
 }
 
+bool
+Logger::setAsync(bool async)
+{
+    bool wasAsync = m_async != nullptr;
+    if (async && !wasAsync)
+        m_async = std::make_unique<AsyncWriter>(m_log, m_err);
+    else if (!async)
+        m_async = nullptr;
+    return wasAsync;
+}
+
 void
 Logger::vlog(Level level, std::string_view format, fmt::format_args args) const
 {
@@ -86,6 +293,14 @@ Logger::vlog(Level level, std::string_view format, fmt::format_args args) const
     }
 #endif
 
+    // The level has already been checked, so only the messages written are
+    // formatted
+    if (m_async != nullptr)
+    {
+        m_async->push(level, fmt::vformat(fmt::string_view(format), args));
+        return;
+    }
+
     auto &stream = (level <= Level::Warning || level == Level::Debug) ? m_err : m_log;
     fmt::vprint(stream, fmt::string_view(format), args);
 }
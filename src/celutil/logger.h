@@ -12,6 +12,7 @@
 #pragma once
 
 #include <iosfwd>
+#include <memory>
 #include <string_view>
 
 #include <fmt/format.h>
@@ -70,6 +71,8 @@ public:
      */
     Logger(Level level, Stream &log, Stream &err);
 
+    ~Logger();
+
     /**
      * Set verbocity level
      *
@@ -77,6 +80,18 @@ public:
      */
     void setLevel(Level level);
 
+    /**
+     * Switch between writing the messages on the calling thread and queuing
+     * them for a background thread. In asynchronous mode, a message repeated
+     * several times in a row is written once, followed by the count of the
+     * repetitions. Switching back waits for the queued messages to be
+     * written. This must not be called while other threads are logging.
+     *
+     * @param async whether to write the messages from a background thread
+     * @return whether the logger was asynchronous before the call
+     */
+    bool setAsync(bool async);
+
     template<typename... Args>
     void debug(std::string_view format, const Args &...args) const;
 
@@ -96,11 +111,14 @@ public:
     void log(Level, std::string_view format, const Args &...args) const;
 
 private:
+    class AsyncWriter;
+
     void vlog(Level level, std::string_view format, fmt::format_args args) const;
 
     Stream &m_log;
     Stream &m_err;
     Level   m_level;
+    std::unique_ptr<AsyncWriter> m_async;
 };
 
 template<typename... Args> inline void
@@ -163,4 +181,24 @@ Logger *CreateLogger(Level level, Logger::Stream &log, Logger::Stream &err);
 /** Destroy the default global Logger instance */
 void DestroyLogger();
 
+/**
+ * Keeps a logger asynchronous until the end of the scope or the call to
+ * end(), then restores its previous mode
+ */
+class AsyncLogScope
+{
+public:
+    explicit AsyncLogScope(Logger *logger);
+    ~AsyncLogScope();
+
+    AsyncLogScope(const AsyncLogScope &) = delete;
+    AsyncLogScope &operator=(const AsyncLogScope &) = delete;
+
+    void end();
+
+private:
+    Logger *m_logger;
+    bool    m_wasAsync{ false };
+};
+
 } // end namespace celestia::util
@@ -0,0 +1,109 @@
+// mappedfile.cpp
+//
+// Copyright (C) 2024, Celestia Development Team
+//
+// Read-only memory-mapped files.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include "mappedfile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace celestia::util
+{
+
+#ifdef _WIN32
+
+std::unique_ptr<MappedFile>
+MappedFile::open(const fs::path& path)
+{
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return nullptr;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return nullptr;
+    }
+
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr)
+    {
+        CloseHandle(file);
+        return nullptr;
+    }
+
+    const void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (data == nullptr)
+    {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return nullptr;
+    }
+
+    std::unique_ptr<MappedFile> result(new MappedFile());
+    result->m_data = static_cast<const char*>(data);
+    result->m_size = static_cast<std::size_t>(fileSize.QuadPart);
+    result->m_file = file;
+    result->m_mapping = mapping;
+    return result;
+}
+
+MappedFile::~MappedFile()
+{
+    UnmapViewOfFile(m_data);
+    CloseHandle(m_mapping);
+    CloseHandle(m_file);
+}
+
+#else
+
+std::unique_ptr<MappedFile>
+MappedFile::open(const fs::path& path)
+{
+    int fd = ::open(path.c_str(), O_RDONLY); //NOSONAR
+    if (fd < 0)
+        return nullptr;
+
+    struct stat fileInfo;
+    if (fstat(fd, &fileInfo) != 0 || fileInfo.st_size <= 0)
+    {
+        close(fd);
+        return nullptr;
+    }
+
+    auto size = static_cast<std::size_t>(fileInfo.st_size);
+    void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping stays valid after the descriptor is closed
+    close(fd);
+    if (data == MAP_FAILED)
+        return nullptr;
+
+    std::unique_ptr<MappedFile> result(new MappedFile());
+    result->m_data = static_cast<const char*>(data);
+    result->m_size = size;
+    return result;
+}
+
+MappedFile::~MappedFile()
+{
+    munmap(const_cast<char*>(m_data), m_size); //NOSONAR
+}
+
+#endif
+
+} // end namespace celestia::util
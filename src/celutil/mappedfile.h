@@ -0,0 +1,52 @@
+// mappedfile.h
+//
+// Copyright (C) 2024, Celestia Development Team
+//
+// Read-only memory-mapped files.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+#include <celcompat/filesystem.h>
+
+namespace celestia::util
+{
+
+/*! A whole file mapped read-only into the address space. The contents are
+ *  paged in by the operating system on access, and the mapping is released
+ *  when the object is destroyed.
+ */
+class MappedFile
+{
+public:
+    static std::unique_ptr<MappedFile> open(const fs::path&);
+
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&&) = delete;
+    MappedFile& operator=(MappedFile&&) = delete;
+
+    const char* data() const noexcept { return m_data; }
+    std::size_t size() const noexcept { return m_size; }
+
+private:
+    MappedFile() = default;
+
+    const char* m_data{ nullptr };
+    std::size_t m_size{ 0 };
+#ifdef _WIN32
+    void* m_file{ nullptr };
+    void* m_mapping{ nullptr };
+#endif
+};
+
+} // end namespace celestia::util
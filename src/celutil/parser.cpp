@@ -125,9 +125,10 @@ Parser::readHash()
     tok = tokenizer->nextToken();
     while (tok != Tokenizer::TokenEndGroup)
     {
-        std::string name;
+        std::string_view name;
         if (auto tokenValue = tokenizer->getNameValue(); tokenValue.has_value())
         {
+            // The name remains valid until the next token is read
             name = *tokenValue;
         }
         else
@@ -0,0 +1,310 @@
+// profiler.cpp
+//
+// Copyright (C) 2025, Celestia Development Team
+//
+// Scoped profiling zones.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include "profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include "logger.h"
+
+using namespace std::string_view_literals;
+
+namespace celestia::util
+{
+
+namespace
+{
+
+struct Zone
+{
+    const char* name;
+    std::uint64_t begin;
+    std::uint64_t end;
+};
+
+// The zones of one thread. The mutex is only contended while the trace is
+// written.
+struct ZoneBuffer
+{
+    explicit ZoneBuffer(std::uint32_t _id) : id(_id) {}
+
+    void add(const char* name, std::uint64_t begin, std::uint64_t end)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (zones.size() < Profiler::BufferSize)
+        {
+            zones.push_back({ name, begin, end });
+        }
+        else
+        {
+            zones[next] = { name, begin, end };
+            next = (next + 1) % Profiler::BufferSize;
+        }
+    }
+
+    std::mutex mutex;
+    std::vector<Zone> zones;
+    // Oldest zone once the buffer is full
+    std::size_t next{ 0 };
+    std::uint32_t id;
+    const char* name{ nullptr };
+};
+
+// A counter value, or an instant event when it has a category
+struct Event
+{
+    std::string name;
+    std::string category;
+    std::uint64_t time;
+    double value;
+    std::uint32_t threadId;
+};
+
+struct EventBuffer
+{
+    void add(Event&& event)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (events.size() < Profiler::BufferSize)
+        {
+            events.push_back(std::move(event));
+        }
+        else
+        {
+            events[next] = std::move(event);
+            next = (next + 1) % Profiler::BufferSize;
+        }
+    }
+
+    std::mutex mutex;
+    std::vector<Event> events;
+    std::size_t next{ 0 };
+};
+
+// Thread id of the GPU zones in the trace
+constexpr std::uint32_t GPUThreadId = 0;
+
+const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+std::mutex buffersMutex;
+// Kept after their threads end, so that their zones are still written
+std::vector<std::shared_ptr<ZoneBuffer>> buffers;
+
+ZoneBuffer&
+gpuBuffer()
+{
+    static const std::shared_ptr<ZoneBuffer> buffer = []
+    {
+        auto result = std::make_shared<ZoneBuffer>(GPUThreadId);
+        std::lock_guard<std::mutex> lock(buffersMutex);
+        buffers.push_back(result);
+        return result;
+    }();
+    return *buffer;
+}
+
+EventBuffer&
+eventBuffer()
+{
+    static EventBuffer buffer;
+    return buffer;
+}
+
+ZoneBuffer&
+threadBuffer()
+{
+    thread_local const std::shared_ptr<ZoneBuffer> buffer = []
+    {
+        std::lock_guard<std::mutex> lock(buffersMutex);
+        auto result = std::make_shared<ZoneBuffer>(static_cast<std::uint32_t>(buffers.size() + 1));
+        buffers.push_back(result);
+        return result;
+    }();
+    return *buffer;
+}
+
+void
+appendString(fmt::memory_buffer& buffer, std::string_view str)
+{
+    buffer.push_back('"');
+    for (char c : str)
+    {
+        if (c == '"' || c == '\\')
+            buffer.push_back('\\');
+        if (static_cast<unsigned char>(c) >= 0x20)
+            buffer.push_back(c);
+    }
+    buffer.push_back('"');
+}
+
+} // end unnamed namespace
+
+std::atomic<bool> Profiler::enabled{ false };
+
+void
+Profiler::setEnabled(bool _enabled)
+{
+    enabled.store(_enabled, std::memory_order_relaxed);
+}
+
+std::uint64_t
+Profiler::now()
+{
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - startTime).count());
+}
+
+void
+Profiler::record(const char* name, std::uint64_t begin, std::uint64_t end)
+{
+    threadBuffer().add(name, begin, end);
+}
+
+void
+Profiler::recordGPU(const char* name, std::uint64_t begin, std::uint64_t end)
+{
+    gpuBuffer().add(name, begin, end);
+}
+
+void
+Profiler::recordCounter(std::string_view name, double value)
+{
+    if (isEnabled())
+        eventBuffer().add({ std::string(name), {}, now(), value, 0 });
+}
+
+void
+Profiler::recordInstant(std::string_view category, std::string_view name)
+{
+    if (isEnabled())
+        eventBuffer().add({ std::string(name), std::string(category), now(), 0.0, threadBuffer().id });
+}
+
+void
+Profiler::setThreadName(const char* name)
+{
+    ZoneBuffer& buffer = threadBuffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    buffer.name = name;
+}
+
+bool
+Profiler::writeTrace(const fs::path& path)
+{
+    fmt::memory_buffer buffer;
+    auto out = std::back_inserter(buffer);
+
+    std::vector<std::shared_ptr<ZoneBuffer>> allBuffers;
+    {
+        std::lock_guard<std::mutex> lock(buffersMutex);
+        allBuffers = buffers;
+    }
+
+    bool first = true;
+    buffer.append("{\"displayTimeUnit\": \"ms\", \"traceEvents\": ["sv);
+    for (const auto& zoneBuffer : allBuffers)
+    {
+        std::lock_guard<std::mutex> lock(zoneBuffer->mutex);
+        if (zoneBuffer->zones.empty() && zoneBuffer->name == nullptr)
+            continue;
+
+        buffer.append(first ? "\n  "sv : ",\n  "sv);
+        first = false;
+        fmt::format_to(out,
+                       "{{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": {}, \"args\": {{\"name\": ",
+                       zoneBuffer->id);
+        if (zoneBuffer->id == GPUThreadId)
+            appendString(buffer, "GPU"sv);
+        else if (zoneBuffer->name != nullptr)
+            appendString(buffer, zoneBuffer->name);
+        else
+            appendString(buffer, fmt::format("Thread {}", zoneBuffer->id));
+        buffer.append("}}"sv);
+
+        for (std::size_t i = 0; i < zoneBuffer->zones.size(); ++i)
+        {
+            const Zone& zone = zoneBuffer->zones[(zoneBuffer->next + i) % zoneBuffer->zones.size()];
+            buffer.append(",\n  {\"name\": "sv);
+            appendString(buffer, zone.name);
+            fmt::format_to(out,
+                           ", \"ph\": \"X\", \"pid\": 1, \"tid\": {}, \"ts\": {:.3f}, \"dur\": {:.3f}}}",
+                           zoneBuffer->id,
+                           static_cast<double>(zone.begin) * 1.0e-3,
+                           static_cast<double>(std::max(zone.end, zone.begin) - zone.begin) * 1.0e-3);
+        }
+    }
+
+    {
+        EventBuffer& events = eventBuffer();
+        std::lock_guard<std::mutex> lock(events.mutex);
+        for (std::size_t i = 0; i < events.events.size(); ++i)
+        {
+            const Event& event = events.events[(events.next + i) % events.events.size()];
+            buffer.append(first ? "\n  {\"name\": "sv : ",\n  {\"name\": "sv);
+            first = false;
+            appendString(buffer, event.name);
+            if (event.category.empty())
+            {
+                fmt::format_to(out, ", \"ph\": \"C\", \"pid\": 1, \"ts\": {:.3f}, \"args\": {{\"value\": {}}}}}",
+                               static_cast<double>(event.time) * 1.0e-3, event.value);
+            }
+            else
+            {
+                buffer.append(", \"cat\": "sv);
+                appendString(buffer, event.category);
+                fmt::format_to(out, ", \"ph\": \"i\", \"s\": \"t\", \"pid\": 1, \"tid\": {}, \"ts\": {:.3f}}}",
+                               event.threadId, static_cast<double>(event.time) * 1.0e-3);
+            }
+        }
+    }
+    buffer.append("\n]}\n"sv);
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    file.close();
+    if (file.fail())
+    {
+        GetLogger()->error("Error writing profile trace {}\n", path);
+        return false;
+    }
+
+    return true;
+}
+
+void
+Profiler::clear()
+{
+    std::lock_guard<std::mutex> lock(buffersMutex);
+    for (const auto& zoneBuffer : buffers)
+    {
+        std::lock_guard<std::mutex> bufferLock(zoneBuffer->mutex);
+        zoneBuffer->zones.clear();
+        zoneBuffer->next = 0;
+    }
+
+    EventBuffer& events = eventBuffer();
+    std::lock_guard<std::mutex> eventLock(events.mutex);
+    events.events.clear();
+    events.next = 0;
+}
+
+} // end namespace celestia::util
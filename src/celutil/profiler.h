@@ -0,0 +1,108 @@
+// profiler.h
+//
+// Copyright (C) 2025, Celestia Development Team
+//
+// Scoped profiling zones.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include <celcompat/filesystem.h>
+
+#ifdef CELESTIA_PROFILING_TRACY
+#include <tracy/Tracy.hpp>
+#endif
+
+namespace celestia::util
+{
+
+// Records the begin and end times of the profiling zones of every thread,
+// in one ring buffer per thread which keeps the latest zones, and writes
+// them as a trace in the Chrome trace event format, which can be opened in
+// chrome://tracing or Perfetto. Counters and instant events, such as the
+// memory usage and the loads of the resources, are kept in one more ring
+// buffer shared by the threads. Zones are only recorded while the profiler
+// is enabled.
+class Profiler
+{
+public:
+    // Zones kept per thread, and counters and events kept in total
+    static constexpr std::size_t BufferSize = 65536;
+
+    static void setEnabled(bool enabled);
+    static bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+
+    // Nanoseconds since the start of the program
+    static std::uint64_t now();
+
+    // Record a zone of the calling thread. The name must outlive the
+    // profiler, as string literals do.
+    static void record(const char* name, std::uint64_t begin, std::uint64_t end);
+    // Record a zone of the GPU, with the times converted to those of now()
+    static void recordGPU(const char* name, std::uint64_t begin, std::uint64_t end);
+    // Record the value of a counter, or an instant event of the calling
+    // thread, if the profiler is enabled. The names are copied.
+    static void recordCounter(std::string_view name, double value);
+    static void recordInstant(std::string_view category, std::string_view name);
+
+    // Name the calling thread in the trace. The name must outlive the
+    // profiler, as string literals do.
+    static void setThreadName(const char* name);
+
+    static bool writeTrace(const fs::path&);
+    static void clear();
+
+private:
+    static std::atomic<bool> enabled;
+};
+
+// Records the time from its creation to its destruction as a zone
+class ProfileZone
+{
+public:
+    explicit ProfileZone(const char* name) :
+        m_name(Profiler::isEnabled() ? name : nullptr),
+        m_begin(m_name == nullptr ? 0 : Profiler::now())
+    {
+    }
+
+    ~ProfileZone()
+    {
+        if (m_name != nullptr)
+            Profiler::record(m_name, m_begin, Profiler::now());
+    }
+
+    ProfileZone(const ProfileZone&) = delete;
+    ProfileZone& operator=(const ProfileZone&) = delete;
+
+private:
+    const char* m_name;
+    std::uint64_t m_begin;
+};
+
+} // end namespace celestia::util
+
+// Zones are only compiled in builds with ENABLE_PROFILING, and are also
+// sent to Tracy in builds with USE_TRACY. The name must be a string literal.
+#define CELESTIA_PROFILE_CONCAT_IMPL(a, b) a##b
+#define CELESTIA_PROFILE_CONCAT(a, b) CELESTIA_PROFILE_CONCAT_IMPL(a, b)
+
+#if defined(CELESTIA_PROFILING_TRACY)
+#define CELESTIA_PROFILE_ZONE(name) \
+    ZoneScopedN(name); \
+    ::celestia::util::ProfileZone CELESTIA_PROFILE_CONCAT(celestiaProfileZone, __LINE__)(name)
+#elif defined(CELESTIA_PROFILING)
+#define CELESTIA_PROFILE_ZONE(name) \
+    ::celestia::util::ProfileZone CELESTIA_PROFILE_CONCAT(celestiaProfileZone, __LINE__)(name)
+#else
+#define CELESTIA_PROFILE_ZONE(name) static_cast<void>(0)
+#endif
@@ -9,22 +9,92 @@
 
 #pragma once
 
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
 #include <map>
 #include <memory>
+#include <set>
+#include <string>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
 #include <celcompat/filesystem.h>
+#include <celutil/profiler.h>
 #include <celutil/reshandle.h>
+#include <celutil/threadpool.h>
 
 
 enum class ResourceState {
     NotLoaded     = 0,
     Loaded        = 1,
     LoadingFailed = 2,
+    Pending       = 3,
 };
 
 
+namespace celestia::util::detail
+{
+
+struct NoDecodedType {};
+
+template<class T, class = void>
+struct DecodedType
+{
+    using type = NoDecodedType;
+};
+
+template<class T>
+struct DecodedType<T, std::void_t<typename T::DecodedType>>
+{
+    using type = typename T::DecodedType;
+};
+
+template<class R, class = void>
+struct HasMemoryUsage : std::false_type {};
+
+template<class R>
+struct HasMemoryUsage<R, std::void_t<decltype(std::declval<const R&>().getMemoryUsage())>> : std::true_type {};
+
+template<class R, class = void>
+struct HasIncrementalUpload : std::false_type {};
+
+template<class R>
+struct HasIncrementalUpload<R, std::void_t<decltype(std::declval<R&>().upload(std::declval<std::chrono::steady_clock::time_point>()))>> : std::true_type {};
+
+} // end namespace celestia::util::detail
+
+
+namespace celestia::util
+{
+
+// Timings of loading one resource, with frames counted by
+// ResourceManager::update
+struct ResourceLoadRecord
+{
+    std::uint64_t requestFrame{ 0 };
+    // Frame in which the resource was created, or failed to load
+    std::uint64_t readyFrame{ 0 };
+    // Frame of the first find after the resource was created
+    std::uint64_t firstUseFrame{ 0 };
+    // Time spent decoding in the background
+    std::chrono::steady_clock::duration decodeTime{ 0 };
+    // Time spent creating the resource on the thread calling find and
+    // update, which includes decoding for synchronous loads
+    std::chrono::steady_clock::duration createTime{ 0 };
+    // Memory usage of resources which support eviction
+    std::size_t memory{ 0 };
+    bool failed{ false };
+};
+
+} // end namespace celestia::util
+
+
+
 template<class T> class ResourceManager
 {
  public:
@@ -37,6 +107,25 @@ template<class T> class ResourceManager
     ResourceManager& operator=(ResourceManager&&) = delete;
 
     using ResourceType = typename T::ResourceType;
+    using KeyType = typename T::ResourceKey;
+    using DecodedType = typename celestia::util::detail::DecodedType<T>::type;
+
+    // Resources whose info defines a DecodedType can be loaded in the
+    // background. info.decode(key) runs on the thread pool and must not
+    // touch the GL state; info.create(key, decoded) makes the resource
+    // from its result in update().
+    static constexpr bool SupportsAsyncLoading = !std::is_same_v<DecodedType, celestia::util::detail::NoDecodedType>;
+
+    // Resources with a getMemoryUsage() method can be evicted: once their
+    // total exceeds the budget, update() releases the ones which haven't
+    // been found for the longest time, back to NotLoaded so that the next
+    // find loads them again. Each update call counts as one frame.
+    static constexpr bool SupportsEviction = celestia::util::detail::HasMemoryUsage<ResourceType>::value;
+
+    // Resources with an upload(deadline) method may take several updates to
+    // be created: they stay Pending until upload returns true, and each
+    // update calls it with the end of its time budget.
+    static constexpr bool SupportsIncrementalUpload = celestia::util::detail::HasIncrementalUpload<ResourceType>::value;
 
     ResourceHandle getHandle(const T& info)
     {
@@ -52,6 +141,8 @@ template<class T> class ResourceManager
         }
     }
 
+    // In asynchronous mode find returns nullptr while the resource is
+    // Pending
     ResourceType* find(ResourceHandle h)
     {
         if (h < 0 || h >= static_cast<ResourceHandle>(handles.size()))
@@ -59,24 +150,130 @@ template<class T> class ResourceManager
             return nullptr;
         }
 
+        resources[h].lastUsed = frame;
         if (resources[h].state == ResourceState::NotLoaded)
         {
-            loadResource(resources[h]);
+            if constexpr (SupportsAsyncLoading)
+            {
+                if (asyncLoading)
+                    startLoad(h);
+                else
+                    loadResource(resources[h]);
+            }
+            else
+            {
+                loadResource(resources[h]);
+            }
+        }
+
+        return getLoaded(resources[h]);
+    }
+
+    // Call fn(info, key) for each resource with the key it resolves to,
+    // without loading it
+    template<typename F>
+    void forEachResource(F&& fn) const
+    {
+        for (const InfoType& resource : resources)
+            fn(resource.info, resource.info.resolve(baseDir));
+    }
+
+    // Like find, without starting to load the resource
+    ResourceType* findLoaded(ResourceHandle h) const
+    {
+        if (h < 0 || h >= static_cast<ResourceHandle>(handles.size()))
+            return nullptr;
+
+        resources[h].lastUsed = frame;
+        return getLoaded(resources[h]);
+    }
+
+    ResourceState getState(ResourceHandle h) const
+    {
+        if (h < 0 || h >= static_cast<ResourceHandle>(handles.size()))
+            return ResourceState::LoadingFailed;
+
+        return resources[h].state;
+    }
+
+    void setAsyncLoading(bool enabled) { asyncLoading = enabled && SupportsAsyncLoading; }
+    bool getAsyncLoading() const { return asyncLoading; }
+
+    // Whether resources are being loaded in the background, which update()
+    // will create
+    bool hasPendingLoads() const { return !pendingLoads.empty(); }
+
+    // A budget of zero means no limit
+    void setMemoryBudget(std::size_t budget) { memoryBudget = budget; }
+    std::size_t getMemoryBudget() const { return memoryBudget; }
+
+    // Total memory usage of the loaded resources as of the last update
+    std::size_t getMemoryUsage() const { return memoryUsage; }
+
+    // Number of update calls so far
+    std::uint64_t getFrame() const { return frame; }
+
+    // The observer is called once per load, on the first find of the
+    // resource after it was created, or as soon as loading fails
+    using LoadObserver = std::function<void(const KeyType&, const celestia::util::ResourceLoadRecord&)>;
+    void setLoadObserver(LoadObserver observer) { loadObserver = std::move(observer); }
+
+    // Create the resources which have been decoded in the background, until
+    // the time budget is spent. At least one resource is created or
+    // uploaded to if any is ready, so that loading always progresses.
+    void update(std::chrono::steady_clock::duration budget)
+    {
+        ++frame;
+
+        if constexpr (SupportsAsyncLoading)
+        {
+            auto deadline = std::chrono::steady_clock::now() + budget;
+            for (auto iter = pendingLoads.begin(); iter != pendingLoads.end();)
+            {
+                if (iter->resource == nullptr &&
+                    iter->decoded.wait_for(std::chrono::seconds::zero()) != std::future_status::ready)
+                {
+                    ++iter;
+                    continue;
+                }
+
+                if (finishLoad(*iter, deadline))
+                    iter = pendingLoads.erase(iter);
+                else
+                    ++iter;
+
+                if (std::chrono::steady_clock::now() >= deadline)
+                    break;
+            }
         }
 
-        return resources[h].state == ResourceState::Loaded
-            ? resources[h].resource.get()
-            : nullptr;
+        if constexpr (SupportsEviction)
+        {
+            updateMemoryUsage();
+            if (memoryBudget != 0 && memoryUsage > memoryBudget)
+                evict();
+        }
     }
 
  private:
-    using KeyType = typename T::ResourceKey;
+    struct LoadReport
+    {
+        KeyType key;
+        celestia::util::ResourceLoadRecord record;
+    };
 
     struct InfoType
     {
         T info;
         ResourceState state{ ResourceState::NotLoaded };
         std::shared_ptr<ResourceType> resource{ nullptr };
+        // Frame of the last find, for eviction
+        mutable std::uint64_t lastUsed{ 0 };
+        // Set on the handle which created the resource, so that resources
+        // shared by several handles are counted once
+        bool owner{ false };
+        // Reported to the load observer on the first find
+        mutable std::unique_ptr<LoadReport> loadReport{ nullptr };
 
         explicit InfoType(T _info) : info(std::move(_info)) {}
         InfoType(const InfoType&) = delete;
@@ -92,6 +289,16 @@ template<class T> class ResourceManager
         }
     };
 
+    struct PendingLoad
+    {
+        ResourceHandle handle;
+        KeyType key;
+        std::future<std::pair<std::unique_ptr<DecodedType>, std::chrono::steady_clock::duration>> decoded;
+        // Created from the decoded result, while it is being uploaded
+        std::shared_ptr<ResourceType> resource{ nullptr };
+        celestia::util::ResourceLoadRecord record{ };
+    };
+
     using ResourceTable = std::vector<InfoType>;
     using ResourceHandleMap = std::map<T, ResourceHandle>;
     using NameMap = std::map<KeyType, std::weak_ptr<ResourceType>>;
@@ -100,9 +307,52 @@ template<class T> class ResourceManager
     ResourceTable resources{ };
     ResourceHandleMap handles{ };
     NameMap loadedResources{ };
+    std::vector<PendingLoad> pendingLoads{ };
+    bool asyncLoading{ false };
+    std::uint64_t frame{ 0 };
+    std::size_t memoryBudget{ 0 };
+    std::size_t memoryUsage{ 0 };
+    LoadObserver loadObserver{ };
+
+    ResourceType* getLoaded(const InfoType& info) const
+    {
+        if (info.state != ResourceState::Loaded)
+            return nullptr;
+
+        if (info.loadReport != nullptr)
+        {
+            info.loadReport->record.firstUseFrame = frame;
+            if (loadObserver)
+                loadObserver(info.loadReport->key, info.loadReport->record);
+            info.loadReport = nullptr;
+        }
+
+        return info.resource.get();
+    }
+
+    // Successful loads are reported on the first find, failures right away
+    void setLoadRecord(const InfoType& info, const KeyType& key, celestia::util::ResourceLoadRecord record)
+    {
+        record.readyFrame = frame;
+        if constexpr (SupportsEviction)
+        {
+            if (info.resource != nullptr)
+                record.memory = info.resource->getMemoryUsage();
+        }
+
+        if (record.failed)
+        {
+            if (loadObserver)
+                loadObserver(key, record);
+            return;
+        }
+
+        info.loadReport = std::make_unique<LoadReport>(LoadReport{ key, record });
+    }
 
     void loadResource(InfoType& info)
     {
+        auto start = std::chrono::steady_clock::now();
         KeyType resolvedKey = info.resolve(baseDir);
         std::shared_ptr<ResourceType> resource = nullptr;
         if (auto iter = loadedResources.find(resolvedKey); iter != loadedResources.end())
@@ -113,15 +363,164 @@ template<class T> class ResourceManager
             info.resource = std::move(resource);
             info.state = ResourceState::Loaded;
         }
-        else if (info.load(resolvedKey))
+        else
         {
-            info.state = ResourceState::Loaded;
-            if (auto [iter, inserted] = loadedResources.try_emplace(std::move(resolvedKey), info.resource); !inserted)
-                iter->second = info.resource;
+            celestia::util::ResourceLoadRecord record;
+            record.requestFrame = frame;
+            record.failed = !info.load(resolvedKey);
+            record.createTime = std::chrono::steady_clock::now() - start;
+            setLoadRecord(info, resolvedKey, record);
+
+            if (record.failed)
+            {
+                info.state = ResourceState::LoadingFailed;
+            }
+            else
+            {
+                info.state = ResourceState::Loaded;
+                info.owner = true;
+                if (auto [iter, inserted] = loadedResources.try_emplace(std::move(resolvedKey), info.resource); !inserted)
+                    iter->second = info.resource;
+            }
         }
-        else
+    }
+
+    void startLoad(ResourceHandle h)
+    {
+        InfoType& info = resources[h];
+        KeyType resolvedKey = info.resolve(baseDir);
+        if (auto iter = loadedResources.find(resolvedKey); iter != loadedResources.end())
+        {
+            if (auto resource = iter->second.lock(); resource != nullptr)
+            {
+                info.resource = std::move(resource);
+                info.state = ResourceState::Loaded;
+                return;
+            }
+        }
+
+        info.state = ResourceState::Pending;
+        auto decoded = celestia::util::GetThreadPool()->async([info = info.info, resolvedKey]
+        {
+            auto start = std::chrono::steady_clock::now();
+            auto result = info.decode(resolvedKey);
+            return std::make_pair(std::move(result), std::chrono::steady_clock::now() - start);
+        });
+        pendingLoads.push_back(PendingLoad{ h, std::move(resolvedKey), std::move(decoded) });
+        pendingLoads.back().record.requestFrame = frame;
+    }
+
+    // Returns false while the resource is still being uploaded
+    bool finishLoad(PendingLoad& pending, std::chrono::steady_clock::time_point deadline)
+    {
+        InfoType& info = resources[pending.handle];
+
+        if (pending.resource == nullptr)
+        {
+            // Another handle may have loaded the same resource meanwhile
+            if (auto iter = loadedResources.find(pending.key); iter != loadedResources.end())
+            {
+                if (auto resource = iter->second.lock(); resource != nullptr)
+                {
+                    info.resource = std::move(resource);
+                    info.state = ResourceState::Loaded;
+                    return true;
+                }
+            }
+
+            auto [decoded, decodeTime] = pending.decoded.get();
+            pending.record.decodeTime = decodeTime;
+
+            auto start = std::chrono::steady_clock::now();
+            pending.resource = info.info.create(pending.key, std::move(decoded));
+            pending.record.createTime += std::chrono::steady_clock::now() - start;
+            if (pending.resource == nullptr)
+            {
+                info.state = ResourceState::LoadingFailed;
+                pending.record.failed = true;
+                setLoadRecord(info, pending.key, pending.record);
+                return true;
+            }
+        }
+
+        if constexpr (SupportsIncrementalUpload)
+        {
+            auto start = std::chrono::steady_clock::now();
+            bool uploaded = pending.resource->upload(deadline);
+            pending.record.createTime += std::chrono::steady_clock::now() - start;
+            if (!uploaded)
+                return false;
+        }
+
+        info.resource = std::move(pending.resource);
+        info.state = ResourceState::Loaded;
+        info.owner = true;
+        setLoadRecord(info, pending.key, pending.record);
+        if (auto [iter, inserted] = loadedResources.try_emplace(pending.key, info.resource); !inserted)
+            iter->second = info.resource;
+        return true;
+    }
+
+    void updateMemoryUsage()
+    {
+        memoryUsage = 0;
+        for (const InfoType& info : resources)
+        {
+            if (info.state == ResourceState::Loaded && info.owner)
+                memoryUsage += info.resource->getMemoryUsage();
+        }
+    }
+
+    void evict()
+    {
+        // A shared resource is only released when all of its handles are,
+        // so handles are grouped by resource
+        std::map<const ResourceType*, std::uint64_t> lastUses;
+        for (const InfoType& info : resources)
+        {
+            if (info.state != ResourceState::Loaded)
+                continue;
+            auto& lastUsed = lastUses[info.resource.get()];
+            lastUsed = std::max(lastUsed, info.lastUsed);
+        }
+
+        // Resources used in this frame or the previous one are kept even
+        // when they don't fit in the budget
+        std::vector<std::pair<std::uint64_t, const ResourceType*>> candidates;
+        for (const auto& [resource, lastUsed] : lastUses)
+        {
+            if (lastUsed + 1 < frame)
+                candidates.emplace_back(lastUsed, resource);
+        }
+        std::sort(candidates.begin(), candidates.end());
+
+        std::set<const ResourceType*> evicted;
+        for (const auto& [lastUsed, resource] : candidates)
+        {
+            if (memoryUsage <= memoryBudget)
+                break;
+            memoryUsage -= std::min(memoryUsage, resource->getMemoryUsage());
+            evicted.insert(resource);
+        }
+
+        if (evicted.empty())
+            return;
+
+        if (celestia::util::Profiler::isEnabled())
+        {
+            celestia::util::Profiler::recordInstant("eviction",
+                                                    baseDir.u8string() + ": " + std::to_string(evicted.size()));
+        }
+
+        for (InfoType& info : resources)
         {
-            info.state = ResourceState::LoadingFailed;
+            if (info.state == ResourceState::Loaded && evicted.count(info.resource.get()) != 0)
+            {
+                info.resource = nullptr;
+                info.state = ResourceState::NotLoaded;
+                info.owner = false;
+                info.loadReport = nullptr;
+            }
         }
     }
 };
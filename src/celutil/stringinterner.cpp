@@ -0,0 +1,86 @@
+// stringinterner.cpp
+//
+// Copyright (C) 2025, Celestia Development Team
+//
+// Shared storage of the names of objects.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include "stringinterner.h"
+
+#include <array>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+
+namespace celestia::util
+{
+
+namespace
+{
+
+// The catalogs are loaded by several threads, so the strings are split
+// across shards with a lock each
+constexpr std::size_t ShardCount = 16;
+
+struct Shard
+{
+    std::mutex mutex;
+    // References to the elements of a deque stay valid when it grows
+    std::deque<std::string> strings;
+    std::unordered_map<std::string_view, const std::string*> index;
+};
+
+std::array<Shard, ShardCount>&
+shards()
+{
+    // Never destroyed, as the names of objects with static storage may be
+    // used until the end of the program
+    static auto* const result = new std::array<Shard, ShardCount>(); //NOSONAR
+    return *result;
+}
+
+const std::string*
+intern(std::string_view str)
+{
+    Shard& shard = shards()[std::hash<std::string_view>()(str) % ShardCount];
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if (auto it = shard.index.find(str); it != shard.index.end())
+        return it->second;
+
+    const std::string& stored = shard.strings.emplace_back(str);
+    shard.index.try_emplace(stored, &stored);
+    return &stored;
+}
+
+} // end unnamed namespace
+
+InternedString::InternedString()
+{
+    static const std::string* const emptyString = intern({});
+    m_str = emptyString;
+}
+
+InternedString::InternedString(std::string_view str) :
+    m_str(intern(str))
+{
+}
+
+std::size_t
+InternedString::count()
+{
+    std::size_t total = 0;
+    for (Shard& shard : shards())
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        total += shard.strings.size();
+    }
+    return total;
+}
+
+} // end namespace celestia::util
@@ -0,0 +1,47 @@
+// stringinterner.h
+//
+// Copyright (C) 2025, Celestia Development Team
+//
+// Shared storage of the names of objects.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace celestia::util
+{
+
+// Handle of a string stored once for the lifetime of the program. Equal
+// strings share the same storage, so that objects with the same name or
+// with names which appear in several catalogs hold a pointer instead of a
+// copy. Interning is thread-safe.
+class InternedString
+{
+public:
+    InternedString();
+    explicit InternedString(std::string_view str);
+
+    const std::string& str() const { return *m_str; }
+    operator const std::string&() const { return *m_str; } //NOSONAR
+    // The interned strings are null-terminated
+    const char* c_str() const { return m_str->c_str(); }
+    bool empty() const { return m_str->empty(); }
+
+    friend bool operator==(InternedString lhs, InternedString rhs) { return lhs.m_str == rhs.m_str; }
+    friend bool operator!=(InternedString lhs, InternedString rhs) { return lhs.m_str != rhs.m_str; }
+
+    // Number of distinct strings interned
+    static std::size_t count();
+
+private:
+    const std::string* m_str;
+};
+
+} // end namespace celestia::util
@@ -0,0 +1,162 @@
+// threadpool.cpp
+//
+// Copyright (C) 2024, Celestia Development Team
+//
+// Fixed-size pool of worker threads.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include "threadpool.h"
+
+#include <algorithm>
+#include <atomic>
+
+#include "profiler.h"
+
+namespace celestia::util
+{
+
+namespace
+{
+
+struct ParallelForState
+{
+    explicit ParallelForState(std::size_t _count, const std::function<void(std::size_t)>& _func) :
+        count(_count), func(_func)
+    {}
+
+    // Run items until none are left, returns the number of items run
+    std::size_t run()
+    {
+        std::size_t processed = 0;
+        for (;;)
+        {
+            std::size_t i = next.fetch_add(1, std::memory_order_relaxed);
+            if (i >= count)
+                break;
+            func(i);
+            ++processed;
+        }
+
+        if (processed > 0)
+        {
+            std::scoped_lock lock(mutex);
+            completed += processed;
+            if (completed == count)
+                condition.notify_all();
+        }
+
+        return processed;
+    }
+
+    std::size_t count;
+    // Only dereferenced while the owning parallelFor call is waiting
+    const std::function<void(std::size_t)>& func;
+    std::atomic<std::size_t> next{ 0 };
+    std::size_t completed{ 0 };
+    std::mutex mutex;
+    std::condition_variable condition;
+};
+
+} // end unnamed namespace
+
+ThreadPool::ThreadPool(unsigned int threadCount)
+{
+    if (threadCount == 0)
+    {
+        unsigned int hardwareThreads = std::thread::hardware_concurrency();
+        threadCount = hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+    }
+
+    m_threads.reserve(threadCount);
+    for (unsigned int i = 0; i < threadCount; ++i)
+        m_threads.emplace_back(&ThreadPool::workerMain, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::scoped_lock lock(m_mutex);
+        m_stopping = true;
+    }
+
+    m_condition.notify_all();
+    for (std::thread& thread : m_threads)
+        thread.join();
+}
+
+void
+ThreadPool::parallelFor(std::size_t count, const std::function<void(std::size_t)>& func)
+{
+    if (count == 0)
+        return;
+
+    if (count == 1 || m_threads.empty())
+    {
+        for (std::size_t i = 0; i < count; ++i)
+            func(i);
+        return;
+    }
+
+    auto state = std::make_shared<ParallelForState>(count, func);
+    std::size_t helpers = std::min(count - 1, m_threads.size());
+    for (std::size_t i = 0; i < helpers; ++i)
+        submit([state] { state->run(); });
+
+    state->run();
+
+    // Helpers which only start after all items are taken never touch func
+    std::unique_lock lock(state->mutex);
+    state->condition.wait(lock, [&state] { return state->completed == state->count; });
+}
+
+void
+ThreadPool::submit(std::function<void()>&& task)
+{
+    if (m_threads.empty())
+    {
+        task();
+        return;
+    }
+
+    {
+        std::scoped_lock lock(m_mutex);
+        m_tasks.push_back(std::move(task));
+    }
+
+    m_condition.notify_one();
+}
+
+void
+ThreadPool::workerMain()
+{
+    Profiler::setThreadName("Worker");
+    for (;;)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock lock(m_mutex);
+            m_condition.wait(lock, [this] { return m_stopping || !m_tasks.empty(); });
+            if (m_tasks.empty())
+                return;
+
+            task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+        }
+
+        CELESTIA_PROFILE_ZONE("Task");
+        task();
+    }
+}
+
+ThreadPool*
+GetThreadPool()
+{
+    static ThreadPool globalPool;
+    return &globalPool;
+}
+
+} // end namespace celestia::util
@@ -0,0 +1,79 @@
+// threadpool.h
+//
+// Copyright (C) 2024, Celestia Development Team
+//
+// Fixed-size pool of worker threads.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace celestia::util
+{
+
+class ThreadPool
+{
+public:
+    // A thread count of zero uses one worker per hardware thread, minus one
+    // for the calling thread (which participates in parallelFor)
+    explicit ThreadPool(unsigned int threadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    ThreadPool(ThreadPool&&) = delete;
+    ThreadPool& operator=(ThreadPool&&) = delete;
+
+    unsigned int threadCount() const noexcept { return static_cast<unsigned int>(m_threads.size()); }
+
+    // Invoke func(i) for each i in [0, count), returning once all calls are
+    // complete. The calling thread takes part in the work, so it is safe to
+    // call parallelFor from inside a task.
+    void parallelFor(std::size_t count, const std::function<void(std::size_t)>& func);
+
+    // Queue a task to be run asynchronously by one of the workers.
+    void submit(std::function<void()>&& task);
+
+    template<typename F>
+    std::future<std::invoke_result_t<F>> async(F&& func);
+
+private:
+    void workerMain();
+
+    std::vector<std::thread> m_threads;
+    std::deque<std::function<void()>> m_tasks;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_stopping{ false };
+};
+
+template<typename F>
+std::future<std::invoke_result_t<F>>
+ThreadPool::async(F&& func)
+{
+    using ResultType = std::invoke_result_t<F>;
+    auto task = std::make_shared<std::packaged_task<ResultType()>>(std::forward<F>(func));
+    std::future<ResultType> result = task->get_future();
+    submit([task] { (*task)(); });
+    return result;
+}
+
+// Get the process-wide pool, created on first use.
+ThreadPool* GetThreadPool();
+
+} // end namespace celestia::util
@@ -154,6 +154,7 @@ public:
     using TokenValue = std::variant<std::monostate, std::int32_t, double, std::string_view, std::string>;
 
     TokenizerImpl(std::istream*, std::size_t);
+    explicit TokenizerImpl(std::string_view);
 
     TokenizerImpl(const TokenizerImpl&) = delete;
     TokenizerImpl& operator=(const TokenizerImpl&) = delete;
@@ -168,6 +169,8 @@ public:
 private:
     std::istream* in;
     std::vector<char> buffer;
+    // Either the start of buffer or of the contents being tokenized
+    const char* data;
     std::size_t position{ 0 };
     std::size_t length{ 0 };
     TokenValue tokenValue{ std::in_place_type<std::monostate> };
@@ -199,7 +202,17 @@ private:
 
 TokenizerImpl::TokenizerImpl(std::istream* _in, std::size_t _bufferSize)
     : in(_in),
-      buffer(_bufferSize)
+      buffer(_bufferSize),
+      data(buffer.data())
+{}
+
+// The whole of the contents is available at once, so the tokens are read
+// straight out of it and are never moved around.
+TokenizerImpl::TokenizerImpl(std::string_view _contents)
+    : in(nullptr),
+      data(_contents.data()),
+      length(_contents.size()),
+      isEnded(true)
 {}
 
 Tokenizer::TokenType
@@ -233,9 +246,9 @@ TokenizerImpl::skipWhitespace()
     for (;;)
     {
         // skip whitespace
-        auto bufferEnd = buffer.cbegin() + length;
-        auto it = std::find_if_not(buffer.cbegin() + position, bufferEnd, isWhitespace);
-        position = it - buffer.cbegin();
+        auto bufferEnd = data + length;
+        auto it = std::find_if_not(data + position, bufferEnd, isWhitespace);
+        position = it - data;
         if (it == bufferEnd)
         {
             if (isEnded)
@@ -259,8 +272,8 @@ TokenizerImpl::skipWhitespace()
         // skip comments
         for (;;)
         {
-            it = std::find(buffer.cbegin() + position, bufferEnd, '\n');
-            position = it - buffer.cbegin();
+            it = std::find(data + position, bufferEnd, '\n');
+            position = it - data;
             if (it != bufferEnd)
             {
                 ++lineNumber;
@@ -272,7 +285,7 @@ TokenizerImpl::skipWhitespace()
                 return Tokenizer::TokenEnd;
             if (!fillBuffer())
                 return Tokenizer::TokenError;
-            bufferEnd = buffer.cbegin() + length;
+            bufferEnd = data + length;
         }
     }
 }
@@ -331,11 +344,11 @@ TokenizerImpl::readToken(char ch)
 bool
 TokenizerImpl::skipUTF8Bom()
 {
-    if (!fillBuffer())
+    if (!isEnded && !fillBuffer())
         return false;
 
     isAtStart = false;
-    if (length >= UTF8_BOM.size() && std::string_view(buffer.data(), UTF8_BOM.size()) == UTF8_BOM)
+    if (length >= UTF8_BOM.size() && std::string_view(data, UTF8_BOM.size()) == UTF8_BOM)
         position += UTF8_BOM.size();
 
     return true;
@@ -347,9 +360,9 @@ TokenizerImpl::readName()
     std::size_t endPosition = position + 1;
     do
     {
-        auto bufferEnd = buffer.cbegin() + length;
-        auto it = std::find_if_not(buffer.cbegin() + endPosition, bufferEnd, isName);
-        endPosition = it - buffer.cbegin();
+        auto bufferEnd = data + length;
+        auto it = std::find_if_not(data + endPosition, bufferEnd, isName);
+        endPosition = it - data;
         if (it != bufferEnd || isEnded) { break; }
 
         if (!fillBuffer(&endPosition))
@@ -359,7 +372,7 @@ TokenizerImpl::readName()
         }
     } while (endPosition < length);
 
-    tokenValue.emplace<std::string_view>(buffer.data() + position, endPosition - position);
+    tokenValue.emplace<std::string_view>(data + position, endPosition - position);
     position = endPosition;
 
     return true;
@@ -374,9 +387,9 @@ TokenizerImpl::readNumber()
 
     while (state.part != NumberPart::End)
     {
-        auto bufferEnd = buffer.cbegin() + length;
-        auto it = std::find_if_not(buffer.cbegin() + state.endPosition, bufferEnd, isAsciiDigit);
-        state.endPosition = it - buffer.cbegin();
+        auto bufferEnd = data + length;
+        auto it = std::find_if_not(data + state.endPosition, bufferEnd, isAsciiDigit);
+        state.endPosition = it - data;
         if (it == bufferEnd)
         {
             if (isEnded)
@@ -420,7 +433,7 @@ TokenizerImpl::createNumberState()
 {
     NumberState state;
     state.endPosition = position + 1;
-    if (buffer[position] == '.')
+    if (data[position] == '.')
     {
         // decimal point must be followed by a digit
         if (auto check = peekAt(state.endPosition); !isAsciiDigit(check.value_or('\0')))
@@ -432,7 +445,7 @@ TokenizerImpl::createNumberState()
         state.isInteger = false;
         state.part = NumberPart::Fraction;
     }
-    else if (isSign(buffer[position]))
+    else if (isSign(data[position]))
     {
         // sign must be followed by either a decimal point or a digit
         if (auto check = peekAt(state.endPosition); check == '.')
@@ -511,11 +524,11 @@ TokenizerImpl::setNumber(const NumberState& numberState)
 {
     using celestia::compat::from_chars;
 
-    const char* startPtr = buffer.data() + position;
+    const char* startPtr = data + position;
     if (*startPtr == '+')
         ++startPtr;
 
-    const char* endPtr = buffer.data() + numberState.endPosition;
+    const char* endPtr = data + numberState.endPosition;
     position = numberState.endPosition;
 
     // detect negative zero in order to roundtrip CMOD correctly
@@ -561,7 +574,7 @@ TokenizerImpl::readString()
             return false;
         }
 
-        std::string_view run(buffer.data() + position + state.runStart,
+        std::string_view run(data + position + state.runStart,
                              state.runEnd - state.runStart);
 
         if (!state.checkUTF8(ch, run) && ch != '"')
@@ -572,7 +585,7 @@ TokenizerImpl::readString()
             return false;
     }
 
-    const char* startPtr = buffer.data() + position;
+    const char* startPtr = data + position;
     position += state.runEnd + 1;
 
     if (state.runStart == 1)
@@ -653,8 +666,8 @@ TokenizerImpl::parseEscape(StringState& state, char ch)
                 return false;
             }
 
-            const char* uStart = buffer.data() + position + state.runEnd + 2;
-            const char* uEnd = buffer.data() + position + state.runEnd + 6;
+            const char* uStart = data + position + state.runEnd + 2;
+            const char* uEnd = data + position + state.runEnd + 6;
 
             std::uint32_t uch;
             if (auto [ptr, ec] = celestia::compat::from_chars(uStart, uEnd, uch, 16);
@@ -666,7 +679,7 @@ TokenizerImpl::parseEscape(StringState& state, char ch)
             }
             else
             {
-                position = ptr - buffer.data();
+                position = ptr - data;
                 return false;
             }
         }
@@ -684,8 +697,9 @@ TokenizerImpl::parseEscape(StringState& state, char ch)
 bool
 TokenizerImpl::fillBuffer(std::size_t* alterOffset)
 {
-    // If we've hit EOF or we've got an overlong token then exit
-    if (position == 0 && length > 0)
+    // If there is no stream, we've hit EOF or we've got an overlong token
+    // then exit
+    if (in == nullptr || (position == 0 && length > 0))
         return false;
 
     assert(position <= length);
@@ -714,16 +728,20 @@ std::optional<char>
 TokenizerImpl::peekAt(std::size_t& offset)
 {
     if (offset < length)
-        return buffer[offset];
+        return data[offset];
     if (isEnded || !fillBuffer(&offset) || offset >= length)
         return std::nullopt;
-    return buffer[offset];
+    return data[offset];
 }
 
 Tokenizer::Tokenizer(std::istream* _in, std::size_t buffer_size)
     : impl(std::make_unique<TokenizerImpl>(_in, buffer_size))
 {}
 
+Tokenizer::Tokenizer(std::string_view contents)
+    : impl(std::make_unique<TokenizerImpl>(contents))
+{}
+
 Tokenizer::~Tokenizer() = default;
 
 void
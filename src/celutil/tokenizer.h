@@ -47,6 +47,10 @@ public:
     static constexpr std::size_t DEFAULT_BUFFER_SIZE = 4096;
 
     Tokenizer(std::istream*, std::size_t = DEFAULT_BUFFER_SIZE);
+    // Tokenize contents which are all in memory, e.g. a mapped file. The
+    // name and string values refer to the contents, which must outlive the
+    // tokenizer.
+    explicit Tokenizer(std::string_view);
     ~Tokenizer();
 
     TokenType nextToken();
@@ -464,6 +464,36 @@ bool UTF8StartsWith(std::string_view str, std::string_view prefix, bool ignoreCa
     }
 }
 
+//! Return the string normalized and converted to lower case the same way as
+//! UTF8StartsWith does when ignoring case, so that the folded strings can be
+//! compared byte by byte. Invalid sequences are copied unchanged.
+std::string UTF8FoldCase(std::string_view str)
+{
+    std::string folded;
+    folded.reserve(str.size());
+
+    auto length = static_cast<std::int32_t>(str.size());
+    std::int32_t pos = 0;
+    while (pos < length)
+    {
+        std::int32_t start = pos;
+        std::int32_t ch;
+        if (!UTF8Decode(str, pos, ch))
+        {
+            folded.push_back(str[start]);
+            pos = start + 1;
+            continue;
+        }
+
+        ch = UTF8Normalize(ch);
+        if (ch >= 0 && ch <= WCHAR_MAX)
+            ch = static_cast<std::int32_t>(std::towlower(static_cast<std::wint_t>(ch)));
+        UTF8Encode(static_cast<std::uint32_t>(ch), folded);
+    }
+
+    return folded;
+}
+
 std::int32_t
 UTF8Validator::check(unsigned char c)
 {
@@ -14,7 +14,10 @@
 #include <cstdlib>
 #include <cmath>
 #include <algorithm>
+#include <atomic>
 #include <map>
+#include <thread>
+#include <vector>
 
 #include <Eigen/Core>
 #include <Eigen/Geometry>
@@ -57,6 +60,28 @@ enum LUTUsageType
 static LUTUsageType LUTUsage = NoLUT;
 static bool UseFisheyeCameras = false;
 static double CameraExposure = 0.0;
+static unsigned int ThreadCount = std::max(1u, std::thread::hardware_concurrency());
+
+
+// Run body for each index in [0, count), spreading the indices across
+// ThreadCount threads
+template<typename F>
+static void parallelFor(unsigned int count, F body)
+{
+    atomic<unsigned int> next{ 0 };
+    auto work = [&]()
+    {
+        for (unsigned int i = next++; i < count; i = next++)
+            body(i);
+    };
+
+    vector<thread> threads;
+    for (unsigned int t = 1; t < min(ThreadCount, count); ++t)
+        threads.emplace_back(work);
+    work();
+    for (thread& t : threads)
+        t.join();
+}
 
 
 typedef map<string, double> ParameterSet;
@@ -383,6 +408,8 @@ void usage()
     cerr << "           set the number of integration steps for depth\n";
     cerr << "   --scattersteps <value> (or -s)\n";
     cerr << "           set the number of integration steps for scattering\n";
+    cerr << "   --threads <value> (or -t)\n";
+    cerr << "           set the number of threads building lookup tables\n";
 }
 
 
@@ -1034,7 +1061,7 @@ buildExtinctionLUT(const Scene& scene)
     //Sphered planet = Sphered(scene.planet.radius);
     math::Sphered shell(scene.planet.radius + scene.atmosphereShellHeight);
 
-    for (unsigned int i = 0; i < ExtinctionLUTHeightSteps; i++)
+    parallelFor(ExtinctionLUTHeightSteps, [&](unsigned int i)
     {
         double h = (double) i / (double) (ExtinctionLUTHeightSteps - 1) *
             scene.atmosphereShellHeight * 0.9999;
@@ -1061,7 +1088,7 @@ buildExtinctionLUT(const Scene& scene)
 
             lut->setValue(i, j, ext.cwiseMax(1.0e-18));
         }
-    }
+    });
 
     return lut;
 }
@@ -1094,7 +1121,7 @@ buildOpticalDepthLUT(const Scene& scene)
     //Sphered planet = Sphered(scene.planet.radius);
     math::Sphered shell(scene.planet.radius + scene.atmosphereShellHeight);
 
-    for (unsigned int i = 0; i < ExtinctionLUTHeightSteps; i++)
+    parallelFor(ExtinctionLUTHeightSteps, [&](unsigned int i)
     {
         double h = (double) i / (double) (ExtinctionLUTHeightSteps - 1) *
             scene.atmosphereShellHeight;
@@ -1120,7 +1147,7 @@ buildOpticalDepthLUT(const Scene& scene)
 
             lut->setValue(i, j, Vector3d(depth.rayleigh, depth.mie, depth.absorption));
         }
-    }
+    });
 
     return lut;
 }
@@ -1311,7 +1338,7 @@ buildScatteringLUT(const Scene& scene)
 
     math::Sphered shell(scene.planet.radius + scene.atmosphereShellHeight);
 
-    for (unsigned int i = 0; i < ScatteringLUTHeightSteps; i++)
+    parallelFor(ScatteringLUTHeightSteps, [&](unsigned int i)
     {
         double h = (double) i / (double) (ScatteringLUTHeightSteps - 1) *
             scene.atmosphereShellHeight * 0.9999;
@@ -1352,7 +1379,7 @@ buildScatteringLUT(const Scene& scene)
                 lut->setValue(i, j, k, inscatter);
             }
         }
-    }
+    });
 
     return lut;
 }
@@ -1836,6 +1863,15 @@ bool parseCommandLine(int argc, char* argv[])
             {
                 UseFisheyeCameras = true;
             }
+            else if (!strcmp(argv[i], "-t") || !strcmp(argv[i], "--threads"))
+            {
+                if (i == argc - 1)
+                    return false;
+
+                if (sscanf(argv[i + 1], " %u", &ThreadCount) != 1 || ThreadCount == 0)
+                    return false;
+                i++;
+            }
             else if (!strcmp(argv[i], "-e") || !strcmp(argv[i], "--exposure"))
             {
                 if (i == argc - 1)
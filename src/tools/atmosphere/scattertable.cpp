@@ -41,7 +41,11 @@
 #include <cmath>
 #include <algorithm>
 #include <map>
+#include <atomic>
 #include <cassert>
+#include <sstream>
+#include <thread>
+#include <vector>
 #include <Eigen/Core>
 #include <celmath/mathlib.h>
 
@@ -55,6 +59,7 @@ constexpr const unsigned int SunAngleSamples = 32;
 
 // Values settable via the command line
 static unsigned int ScatteringIntegrationSteps = 25;
+static unsigned int ThreadCount = std::max(1u, std::thread::hardware_concurrency());
 
 typedef map<string, double> ParameterSet;
 
@@ -121,6 +126,55 @@ float opticalDepth(float r, float mu, float l, float H, float R)
 }
 
 
+// Optical depths of a batch of paths at once, vectorized by Eigen
+ArrayXf opticalDepth(const ArrayXf& r, const ArrayXf& mu, const ArrayXf& l, float H, float R)
+{
+    ArrayXf a = (r * (0.5f / H)).sqrt();
+    ArrayXf bx = a * mu;
+    ArrayXf by = a * (mu + l / r);
+    ArrayXf sbx = bx.sign();
+    ArrayXf sby = by.sign();
+    ArrayXf x = (sby > sbx).select((bx * bx).exp(), 0.0f);
+    ArrayXf yx = sbx / (2.3193f * bx.abs() + (1.52f * bx * bx + 4.0f).sqrt());
+    ArrayXf yy = sby / (2.3193f * by.abs() + (1.52f * by * by + 4.0f).sqrt()) *
+        (-l / H * (l / (2.0f * r) + mu)).exp();
+
+    return (6.2831f * H * r).sqrt() * ((R - r) / H).exp() * (x + yx - yy);
+}
+
+
+// Transmittance of a batch of paths, one column per path
+Array3Xf transmittance(const ArrayXf& r, const ArrayXf& mu, const ArrayXf& l, const Atmosphere& atm)
+{
+    ArrayXf depthR = opticalDepth(r, mu, l, atm.rayleighScaleHeight, atm.planetRadius);
+    ArrayXf depthM = opticalDepth(r, mu, l, atm.mieScaleHeight, atm.planetRadius);
+    Matrix3Xf depth = atm.rayleighCoeff * depthR.matrix().transpose()
+                    + (Vector3f::Constant(atm.mieCoeff) + atm.absorptionCoeff) * depthM.matrix().transpose();
+    return (-depth.array()).exp();
+}
+
+
+// Run body for each index in [0, count), spreading the indices across
+// ThreadCount threads
+template<typename F>
+static void parallelFor(unsigned int count, F body)
+{
+    atomic<unsigned int> next{ 0 };
+    auto work = [&]()
+    {
+        for (unsigned int i = next++; i < count; i = next++)
+            body(i);
+    };
+
+    vector<thread> threads;
+    for (unsigned int t = 1; t < min(ThreadCount, count); ++t)
+        threads.emplace_back(work);
+    work();
+    for (thread& t : threads)
+        t.join();
+}
+
+
 Vector3f transmittance(float r, float mu, float l, const Atmosphere& atm)
 {
     float depthR = opticalDepth(r, mu, l, atm.rayleighScaleHeight, atm.planetRadius);
@@ -173,7 +227,7 @@ Atmosphere::computeTransmittanceTable() const
     // position just *above* the planet surface.
     float baseHeight = Rg * 1.0e-6f;
 
-    for (unsigned int i = 0; i < HeightSamples; ++i)
+    parallelFor(HeightSamples, [&](unsigned int i)
     {
         float v = float(i) / float(HeightSamples);
         float h = v * v * (Rt - Rg) + baseHeight;
@@ -215,7 +269,7 @@ Atmosphere::computeTransmittanceTable() const
                 cout << "Non-physical transmittance " << transmittanceTable[index].x() << endl;
             }
         }
-    }
+    });
 
     return transmittanceTable;
 }
@@ -240,16 +294,29 @@ Atmosphere::computeInscatterTable() const
     unsigned int sampleCount = HeightSamples * ViewAngleSamples * SunAngleSamples;
     Vector4f* inscatter = new Vector4f[sampleCount];
 
-    for (unsigned int i = 0; i < HeightSamples; ++i)
+    // Each height is computed on its own thread; the messages about it are
+    // printed in order once all are done
+    vector<string> messages(HeightSamples);
+
+    const unsigned int steps = ScatteringIntegrationSteps;
+
+    parallelFor(HeightSamples, [&](unsigned int i)
     {
+        ostringstream out;
+
         float w = float(i) / float(HeightSamples);
         float h = w * w * (Rt - Rg) + baseHeight;
         float r = Rg + h;
         float r2 = r * r;
 
-        cout << "layer " << i << ", height=" << h << "km\n";
+        out << "layer " << i << ", height=" << h << "km\n";
 
-        Vector2f eye(0.0f, r);
+        // Sample points along the view ray, which are the same for every
+        // sun angle
+        ArrayXf stepIndex = ArrayXf::LinSpaced(steps, 0.0f, float(steps - 1));
+        ArrayXf xs(steps);
+        ArrayXf ys(steps);
+        ArrayXf rx(steps);
 
         for (unsigned int j = 0; j < ViewAngleSamples; ++j)
         {
@@ -258,7 +325,6 @@ Atmosphere::computeInscatterTable() const
             float cosTheta = mu;
             float sinTheta2 = 1.0f - cosTheta * cosTheta;
             float sinTheta = sqrt(sinTheta2);
-            Vector2f view(sinTheta, cosTheta);
 
             float pathLength;
             float d = Rg2 - r2 * sinTheta2;
@@ -273,80 +339,77 @@ Atmosphere::computeInscatterTable() const
                 pathLength = -r * cosTheta + sqrt(Rt2 - r2 * sinTheta2);
             }
 
+            float stepLength = pathLength / float(steps);
+            ArrayXf distanceToViewer = stepIndex * stepLength;
+            xs = sinTheta * distanceToViewer;
+            ys = r + cosTheta * distanceToViewer;
+            ArrayXf rx2 = xs * xs + ys * ys;
+            rx = rx2.sqrt();
+
+            // Transmittance along the path to the viewer
+            Array3Xf viewPathTransmittance = transmittance(ArrayXf::Constant(steps, r),
+                                                           ArrayXf::Constant(steps, mu),
+                                                           distanceToViewer,
+                                                           *this);
+
+            // Densities at the sample points, times the step length
+            ArrayXf hx = rx - Rg;
+            ArrayXf rayleighDensity = (-hx / rayleighScaleHeight).exp() * stepLength;
+            ArrayXf mieDensity = (-hx / mieScaleHeight).exp() * stepLength;
+
             for (unsigned int k = 0; k < SunAngleSamples; ++k)
             {
                 float w = float(k) / float(SunAngleSamples - 1);
                 float muS = toMuS(w);
                 float cosPhi = muS;
                 float sinPhi = sqrt(max(0.0f, 1.0f - cosPhi * cosPhi));
-                Vector2f sun(sinPhi, cosPhi);
 
-                float stepLength = pathLength / float(ScatteringIntegrationSteps);
-                Vector2f step = view * stepLength;
+                // Compute the cosine and sine of the angle between the
+                // sun direction and zenith at the sample points.
+                ArrayXf c = (xs * sinPhi + ys * cosPhi) / rx;
+                ArrayXf s2 = 1.0f - c * c;
 
-                Vector3f rayleigh = Vector3f::Zero();
-                float mie = 0.0f;
+                // Points where the ray to the sun intersects the planet
+                // get no inscattered light.
+                ArrayXf dGround = Rg2 - rx2 * s2;
+                Array<bool, Dynamic, 1> lit = (dGround < 0.0f) || (-rx * c - dGround.max(0.0f).sqrt() < 0.0f);
 
-                for (unsigned int m = 0; m < ScatteringIntegrationSteps; ++m)
-                {
-                    Vector2f x = eye + step * m;
-                    float distanceToViewer = stepLength * m;
-                    float rx2 = x.squaredNorm();
-                    float rx = sqrt(rx2);
-
-                    // Compute the transmittance along the path to the viewer
-                    Vector3f viewPathTransmittance = transmittance(r, mu, distanceToViewer, *this);
-
-                    // Compute the cosine and sine of the angle between the
-                    // sun direction and zenith at the current sample.
-                    float c = x.dot(sun) / rx;
-                    float s2 = 1.0f - c * c;
-
-                    // Compute the transmittance along the path to the sun
-                    // and the total transmittance t.
-                    Vector3f t;
-                    if (Rg2 - rx2 * s2 < 0.0f || -rx * c - sqrt(Rg2 - rx2 * s2) < 0.0f)
-                    {
-                        // Compute the distance through the atmosphere
-                        // in the direction of the sun
-                        float sunPathLength = -rx * c + sqrt(Rt2 - rx2 * s2);
-                        Vector3f sunPathTransmittance = transmittance(rx, c, sunPathLength, *this);
-
-                        t = viewPathTransmittance.cwiseProduct(sunPathTransmittance);
-                    }
-                    else
-                    {
-                        // Ray to sun intersects the planet; no inscattered
-                        // light at this point.
-                        t = Vector3f::Zero();
-                    }
-
-                    // Accumulate Rayleigh and Mie scattering
-                    float hx = rx - Rg;
-                    rayleigh += (exp(-hx / rayleighScaleHeight) * stepLength) * t;
-                    mie += exp(-hx / mieScaleHeight) * stepLength * t.x();
-                }
+                // Compute the distance through the atmosphere in the
+                // direction of the sun, and the total transmittance t.
+                ArrayXf sunPathLength = -rx * c + (Rt2 - rx2 * s2).sqrt();
+                Array3Xf t = viewPathTransmittance * transmittance(rx, c, sunPathLength, *this);
+                for (int channel = 0; channel < 3; ++channel)
+                    t.row(channel) = lit.transpose().select(t.row(channel), 0.0f);
+
+                // Accumulate Rayleigh and Mie scattering
+                Vector3f rayleigh = (t.matrix() * rayleighDensity.matrix());
+                float mie = (t.row(0).matrix() * mieDensity.matrix()).value();
 
                 unsigned int index = (i * ViewAngleSamples + j) * SunAngleSamples + k;
                 inscatter[index] << rayleigh.cwiseProduct(rayleighCoeff),
                                     mie * mieCoeff;
                 if (i == HeightSamples - 1 && k == 0)
                 {
-                    cout << acos(muS) * 180.0/M_PI << ", "
-                         << acos(mu) * 180.0/M_PI << ", "
-                         << inscatter[index].transpose() << endl;
+                    out << acos(muS) * 180.0/M_PI << ", "
+                        << acos(mu) * 180.0/M_PI << ", "
+                        << inscatter[index].transpose() << endl;
                 }
 
 #if 0
                 // Emit warnings about NaNs in scatter table
                 if (isnan(rayleigh.x()))
                 {
-                    cout << "NaN in inscatter table at (" << k << ", " << j << ", " << i << ")\n";
+                    out << "NaN in inscatter table at (" << k << ", " << j << ", " << i << ")\n";
                 }
 #endif
             }
         }
-    }
+
+        messages[i] = out.str();
+    });
+
+    for (const string& message : messages)
+        cout << message;
 
     return inscatter;
 }
@@ -360,6 +423,9 @@ void usage()
     cerr << "           (default is out.atm)\n";
     cerr << "   --scattersteps <value> (or -s)\n";
     cerr << "           set the number of integration steps for scattering\n";
+    cerr << "   --threads <value> (or -t)\n";
+    cerr << "           set the number of threads computing the tables\n";
+    cerr << "           (default is the number of processors)\n";
 }
 
 
@@ -482,6 +548,15 @@ bool parseCommandLine(int argc, char* argv[])
                     return false;
                 i++;
             }
+            else if (!strcmp(argv[i], "-t") || !strcmp(argv[i], "--threads"))
+            {
+                if (i == argc - 1)
+                    return false;
+
+                if (sscanf(argv[i + 1], " %u", &ThreadCount) != 1 || ThreadCount == 0)
+                    return false;
+                i++;
+            }
             else if (!strcmp(argv[i], "-o") || !strcmp(argv[i], "--output"))
             {
                 if (i == argc - 1)
@@ -895,6 +970,7 @@ int main(int argc, char* argv[])
     cout << "Mie coeff: " << atmosphere.mieCoeff << "m^-1\n";
     cout << "Absorption coeff: " << atmosphere.absorptionCoeff.transpose() << "m^-1\n";
     cout << "Using " << ScatteringIntegrationSteps << " integration steps.\n";
+    cout << "Using " << ThreadCount << " threads.\n";
 
     cout << "Generating transmittance table (" << ViewAngleSamples << "x"
          << HeightSamples << ")...\n";
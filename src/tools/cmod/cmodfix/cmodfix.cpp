@@ -9,6 +9,9 @@
 //
 // Perform various adjustments to a cmod file
 
+#include <atomic>
+#include <chrono>
+#include <cstddef>
 #include <cstdint>
 #include <cstdio>
 #include <cstring>
@@ -17,18 +20,21 @@
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include <celmath/mathlib.h>
 #include <celmodel/mesh.h>
 #include <celmodel/model.h>
 #include <celmodel/modelfile.h>
 #include <celutil/logger.h>
+#include <celutil/threadpool.h>
 
 #include "cmodops.h"
 #include "pathmanager.h"
 
 using celestia::util::CreateLogger;
 namespace math = celestia::math;
+namespace util = celestia::util;
 
 std::string inputFilename;
 std::string outputFilename;
@@ -39,6 +45,7 @@ bool genTangents = false;
 bool weldVertices = false;
 bool mergeMeshes = false;
 bool stripify = false;
+bool showProgress = false;
 unsigned int vertexCacheSize = 16;
 float smoothAngle = 60.0f;
 
@@ -54,6 +61,7 @@ void usage()
     std::cerr << "   --smooth (or -s) <angle> : smoothing angle for normal generation\n";
     std::cerr << "   --weld (or -w)        : join identical vertices before normal generation\n";
     std::cerr << "   --merge (or -m)       : merge submeshes to improve rendering performance\n";
+    std::cerr << "   --progress (or -p)    : report the time taken by each step\n";
 #ifdef TRISTRIP
     std::cerr << "   --optimize (or -o)    : optimize by converting triangle lists to strips\n";
 #endif
@@ -97,6 +105,10 @@ bool parseCommandLine(int argc, char* argv[])
             {
                 mergeMeshes = true;
             }
+            else if (!std::strcmp(argv[i], "-p") || !std::strcmp(argv[i], "--progress"))
+            {
+                showProgress = true;
+            }
             else if (!std::strcmp(argv[i], "-o") || !std::strcmp(argv[i], "--optimize"))
             {
                 stripify = true;
@@ -147,6 +159,40 @@ bool parseCommandLine(int argc, char* argv[])
 }
 
 
+// Reports the size of the model and the time since the last step on
+// stderr when --progress is given
+class StepTimer
+{
+public:
+    void report(const char* step, const cmod::Model* model)
+    {
+        auto now = std::chrono::steady_clock::now();
+        if (showProgress)
+        {
+            std::size_t vertexCount = 0;
+            std::size_t primitiveCount = 0;
+            unsigned int meshCount = model == nullptr ? 0 : model->getMeshCount();
+            for (unsigned int i = 0; i < meshCount; i++)
+            {
+                vertexCount += model->getMesh(i)->getVertexCount();
+                primitiveCount += model->getMesh(i)->getPrimitiveCount();
+            }
+
+            std::chrono::duration<double, std::milli> elapsed = now - last;
+            std::cerr << step << ": " << elapsed.count() << " ms, "
+                      << meshCount << " meshes, "
+                      << vertexCount << " vertices, "
+                      << primitiveCount << " primitives\n";
+        }
+
+        last = now;
+    }
+
+private:
+    std::chrono::steady_clock::time_point last{ std::chrono::steady_clock::now() };
+};
+
+
 int main(int argc, char* argv[])
 {
     if (!parseCommandLine(argc, argv))
@@ -158,6 +204,7 @@ int main(int argc, char* argv[])
 
     CreateLogger();
 
+    StepTimer timer;
     std::unique_ptr<cmod::Model> model = nullptr;
     if (!inputFilename.empty())
     {
@@ -177,6 +224,8 @@ int main(int argc, char* argv[])
     if (model == nullptr)
         return 1;
 
+    timer.report("Load", model.get());
+
     if (genNormals || genTangents)
     {
         auto newModel = std::make_unique<cmod::Model>();
@@ -188,10 +237,13 @@ int main(int argc, char* argv[])
             newModel->addMaterial(model->getMaterial(i)->clone());
         }
 
-        // Generate normals and/or tangents for each model in the mesh
-        for (i = 0; model->getMesh(i) != nullptr; i++)
+        // Generate normals and/or tangents for the meshes in parallel
+        std::vector<cmod::Mesh> meshes(model->getMeshCount());
+        std::atomic<bool> normalsFailed{ false };
+        std::atomic<bool> tangentsFailed{ false };
+        util::GetThreadPool()->parallelFor(meshes.size(), [&](std::size_t meshIndex)
         {
-            cmod::Mesh mesh = model->getMesh(i)->clone();
+            cmod::Mesh mesh = model->getMesh(static_cast<std::uint32_t>(meshIndex))->clone();
 
             if (genNormals)
             {
@@ -200,8 +252,8 @@ int main(int argc, char* argv[])
                                                                 weldVertices);
                 if (newMesh.getVertexCount() == 0)
                 {
-                    std::cerr << "Error generating normals!\n";
-                    return 1;
+                    normalsFailed = true;
+                    return;
                 }
 
                 mesh = std::move(newMesh);
@@ -212,31 +264,51 @@ int main(int argc, char* argv[])
                 cmod::Mesh newMesh = cmodtools::GenerateTangents(mesh, weldVertices);
                 if (newMesh.getVertexCount() == 0)
                 {
-                    std::cerr << "Error generating tangents!\n";
-                    return 1;
+                    tangentsFailed = true;
+                    return;
                 }
                 // TODO: clean up old mesh
                 mesh = std::move(newMesh);
             }
 
-            newModel->addMesh(std::move(mesh));
+            meshes[meshIndex] = std::move(mesh);
+        });
+
+        if (normalsFailed)
+        {
+            std::cerr << "Error generating normals!\n";
+            return 1;
+        }
+
+        if (tangentsFailed)
+        {
+            std::cerr << "Error generating tangents!\n";
+            return 1;
         }
 
+        for (cmod::Mesh& mesh : meshes)
+            newModel->addMesh(std::move(mesh));
+
         model = std::move(newModel);
+        if (genNormals && genTangents)
+            timer.report("Generate normals and tangents", model.get());
+        else
+            timer.report(genNormals ? "Generate normals" : "Generate tangents", model.get());
     }
 
     if (mergeMeshes)
     {
         model = cmodtools::MergeModelMeshes(*model);
+        timer.report("Merge meshes", model.get());
     }
 
     if (uniquify)
     {
-        for (std::uint32_t i = 0; model->getMesh(i) != nullptr; i++)
+        util::GetThreadPool()->parallelFor(model->getMeshCount(), [&](std::size_t meshIndex)
         {
-            cmod::Mesh* mesh = model->getMesh(i);
-            cmodtools::UniquifyVertices(*mesh);
-        }
+            cmodtools::UniquifyVertices(*model->getMesh(static_cast<std::uint32_t>(meshIndex)));
+        });
+        timer.report("Uniquify vertices", model.get());
     }
 
 #ifdef TRISTRIP
@@ -280,5 +352,7 @@ int main(int argc, char* argv[])
             SaveModelAscii(model.get(), out, cmodtools::GetPathManager()->getSource);
     }
 
+    timer.report("Save", model.get());
+
     return 0;
 }
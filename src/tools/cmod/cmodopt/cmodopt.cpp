@@ -0,0 +1,296 @@
+// cmodopt.cpp
+//
+// Copyright (C) 2026, Celestia Development Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// Optimize all cmod files of a directory tree and write them as binary cmod
+
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <celcompat/filesystem.h>
+#include <celmodel/mesh.h>
+#include <celmodel/model.h>
+#include <celmodel/modelfile.h>
+#include <celutil/fsutils.h>
+#include <celutil/logger.h>
+#include <celutil/reshandle.h>
+#include <celutil/threadpool.h>
+
+#include "cmodops.h"
+
+namespace util = celestia::util;
+
+namespace
+{
+
+fs::path inputDirectory;
+fs::path outputDirectory;
+bool uniquify = false;
+bool mergeMeshes = false;
+bool verbose = false;
+
+void
+Usage()
+{
+    std::cerr << "Usage: cmodopt [options] <input directory> <output directory>\n";
+    std::cerr << "   --uniquify (or -u)    : eliminate duplicate vertices\n";
+    std::cerr << "   --merge (or -m)       : merge submeshes with the same vertex layout\n";
+    std::cerr << "   --verbose (or -v)     : report the size of each model\n";
+    std::cerr << "  The output directory may be the input directory.\n";
+}
+
+bool
+parseCommandLine(int argc, char* argv[])
+{
+    int fileCount = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        if (argv[i][0] == '-')
+        {
+            if (!std::strcmp(argv[i], "-u") || !std::strcmp(argv[i], "--uniquify"))
+            {
+                uniquify = true;
+            }
+            else if (!std::strcmp(argv[i], "-m") || !std::strcmp(argv[i], "--merge"))
+            {
+                mergeMeshes = true;
+            }
+            else if (!std::strcmp(argv[i], "-v") || !std::strcmp(argv[i], "--verbose"))
+            {
+                verbose = true;
+            }
+            else
+            {
+                std::cerr << "Unknown command line switch: " << argv[i] << '\n';
+                return false;
+            }
+        }
+        else if (fileCount == 0)
+        {
+            inputDirectory = fs::u8path(argv[i]);
+            fileCount++;
+        }
+        else if (fileCount == 1)
+        {
+            outputDirectory = fs::u8path(argv[i]);
+            fileCount++;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    return fileCount == 2;
+}
+
+// The texture paths of a model. The one of cmodtools is shared, so each
+// model being processed has its own.
+class ModelPaths
+{
+public:
+    ResourceHandle getHandle(const fs::path& path)
+    {
+        auto [it, inserted] = handles.try_emplace(path, static_cast<ResourceHandle>(paths.size()));
+        if (inserted)
+            paths.push_back(path);
+        return it->second;
+    }
+
+    fs::path getSource(ResourceHandle handle) const
+    {
+        return handle >= 0 && static_cast<std::size_t>(handle) < paths.size() ? paths[handle] : fs::path();
+    }
+
+private:
+    std::vector<fs::path> paths;
+    std::map<fs::path, ResourceHandle> handles;
+};
+
+struct ModelStats
+{
+    std::uint32_t meshCount{ 0 };
+    std::uint32_t vertexCount{ 0 };
+    std::uint32_t primitiveCount{ 0 };
+};
+
+ModelStats
+getStats(const cmod::Model& model)
+{
+    return { model.getMeshCount(), model.getVertexCount(), model.getPrimitiveCount() };
+}
+
+struct ModelResult
+{
+    ModelStats before;
+    ModelStats after;
+    std::uintmax_t sizeBefore{ 0 };
+    std::uintmax_t sizeAfter{ 0 };
+    std::string error;
+};
+
+// Apply the passes the engine applies when loading a model, so that they
+// are cheap at load time, and those too slow to apply there
+void
+optimizeModel(std::unique_ptr<cmod::Model>& model)
+{
+    if (mergeMeshes)
+        model = cmodtools::MergeModelMeshes(*model);
+
+    if (uniquify)
+    {
+        for (std::uint32_t i = 0; i < model->getMeshCount(); i++)
+            cmodtools::UniquifyVertices(*model->getMesh(i));
+    }
+
+    // Merges compatible submeshes and reorders the triangles and vertices
+    // of each for the vertex cache, overdraw and vertex fetch when built
+    // with meshoptimizer
+    model->uniquifyMaterials();
+    model->sortMeshes(cmod::Model::OpacityComparator());
+}
+
+void
+processModel(const fs::path& relativePath, ModelResult& result)
+{
+    fs::path inputPath = inputDirectory / relativePath;
+    fs::path outputPath = outputDirectory / relativePath;
+
+    std::error_code ec;
+    result.sizeBefore = fs::file_size(inputPath, ec);
+
+    ModelPaths paths;
+    std::unique_ptr<cmod::Model> model = cmod::LoadModel(inputPath, [&](const fs::path& path)
+    {
+        return paths.getHandle(path);
+    });
+    if (model == nullptr)
+    {
+        result.error = "Error loading model";
+        return;
+    }
+
+    result.before = getStats(*model);
+    optimizeModel(model);
+    result.after = getStats(*model);
+
+    // The model is written in full before the file is opened, as the
+    // output may replace the input
+    std::ostringstream data(std::ios::out | std::ios::binary);
+    if (!cmod::SaveModelBinary(model.get(), data, [&](ResourceHandle handle) { return paths.getSource(handle); }))
+    {
+        result.error = "Error writing model";
+        return;
+    }
+
+    fs::create_directories(outputPath.parent_path(), ec);
+    std::ofstream out(outputPath, std::ios::out | std::ios::binary | std::ios::trunc);
+    std::string bytes = data.str();
+    out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    if (!out.good())
+    {
+        result.error = "Error writing " + outputPath.u8string();
+        return;
+    }
+
+    result.sizeAfter = bytes.size();
+}
+
+std::vector<fs::path>
+findModels()
+{
+    std::vector<fs::path> models;
+    std::error_code ec;
+    for (auto iter = fs::recursive_directory_iterator(inputDirectory, ec); iter != end(iter); iter.increment(ec))
+    {
+        if (ec)
+            break;
+        if (!fs::is_regular_file(iter->path(), ec))
+            continue;
+
+        std::string extension = iter->path().extension().u8string();
+        std::transform(extension.begin(), extension.end(), extension.begin(),
+                       [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        if (extension == ".cmod")
+            models.push_back(util::RelativeToDirectory(iter->path(), inputDirectory));
+    }
+
+    std::sort(models.begin(), models.end());
+    return models;
+}
+
+} // end unnamed namespace
+
+int
+main(int argc, char* argv[])
+{
+    if (!parseCommandLine(argc, argv))
+    {
+        Usage();
+        return 1;
+    }
+
+    util::CreateLogger();
+
+    std::vector<fs::path> models = findModels();
+    if (models.empty())
+    {
+        std::cerr << "No cmod files found in " << inputDirectory << '\n';
+        return 1;
+    }
+
+    // Models are processed in parallel; the passes of cmodops split large
+    // meshes across the threads as well
+    std::vector<ModelResult> results(models.size());
+    util::GetThreadPool()->parallelFor(models.size(), [&](std::size_t i)
+    {
+        processModel(models[i], results[i]);
+    });
+
+    std::size_t failed = 0;
+    std::uintmax_t sizeBefore = 0;
+    std::uintmax_t sizeAfter = 0;
+    for (std::size_t i = 0; i < models.size(); i++)
+    {
+        const ModelResult& result = results[i];
+        if (!result.error.empty())
+        {
+            std::cerr << models[i].u8string() << ": " << result.error << '\n';
+            ++failed;
+            continue;
+        }
+
+        sizeBefore += result.sizeBefore;
+        sizeAfter += result.sizeAfter;
+        if (verbose)
+        {
+            std::cerr << models[i].u8string() << ": "
+                      << result.before.meshCount << " -> " << result.after.meshCount << " meshes, "
+                      << result.before.vertexCount << " -> " << result.after.vertexCount << " vertices, "
+                      << result.after.primitiveCount << " primitives, "
+                      << result.sizeBefore << " -> " << result.sizeAfter << " bytes\n";
+        }
+    }
+
+    std::cerr << "Optimized " << (models.size() - failed) << " of " << models.size() << " models, "
+              << sizeBefore << " -> " << sizeAfter << " bytes\n";
+
+    return failed == 0 ? 0 : 1;
+}
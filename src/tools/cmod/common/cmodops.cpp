@@ -11,8 +11,10 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cassert>
 #include <cmath>
+#include <cstddef>
 #include <cstring>
 #include <iostream>
 #include <iterator>
@@ -21,6 +23,7 @@
 #include <vector>
 
 #include <celmodel/model.h>
+#include <celutil/threadpool.h>
 
 #include "cmodops.h"
 
@@ -30,6 +33,79 @@ namespace cmodtools
 
 namespace
 {
+
+namespace util = celestia::util;
+
+// Smaller jobs aren't worth handing to other threads
+constexpr std::size_t MinItemsPerTask = 16384;
+
+std::size_t
+getTaskCount(std::size_t count)
+{
+    return std::min(static_cast<std::size_t>(util::GetThreadPool()->threadCount()) + 1,
+                    count / MinItemsPerTask);
+}
+
+// Call func(begin, end) for consecutive ranges covering [0, count), on the
+// threads of the pool when there are enough items
+template<typename F> void
+forEachRange(std::size_t count, const F& func)
+{
+    std::size_t taskCount = getTaskCount(count);
+    if (taskCount <= 1)
+    {
+        func(std::size_t(0), count);
+        return;
+    }
+
+    util::GetThreadPool()->parallelFor(taskCount, [&](std::size_t task)
+    {
+        func(count * task / taskCount, count * (task + 1) / taskCount);
+    });
+}
+
+// Sort ranges of the items in parallel, then merge neighbouring ranges in
+// parallel until one is left
+template<typename T, typename Compare> void
+parallelSort(std::vector<T>& items, const Compare& compare)
+{
+    std::size_t taskCount = getTaskCount(items.size());
+    if (taskCount <= 1)
+    {
+        std::sort(items.begin(), items.end(), compare);
+        return;
+    }
+
+    std::vector<std::size_t> bounds(taskCount + 1);
+    for (std::size_t i = 0; i <= taskCount; i++)
+        bounds[i] = items.size() * i / taskCount;
+
+    util::ThreadPool* pool = util::GetThreadPool();
+    pool->parallelFor(taskCount, [&](std::size_t task)
+    {
+        std::sort(items.begin() + bounds[task], items.begin() + bounds[task + 1], compare);
+    });
+
+    while (bounds.size() > 2)
+    {
+        pool->parallelFor((bounds.size() - 1) / 2, [&](std::size_t pair)
+        {
+            std::inplace_merge(items.begin() + bounds[pair * 2],
+                               items.begin() + bounds[pair * 2 + 1],
+                               items.begin() + bounds[pair * 2 + 2],
+                               compare);
+        });
+
+        std::vector<std::size_t> merged;
+        for (std::size_t i = 0; i < bounds.size(); i += 2)
+            merged.push_back(bounds[i]);
+        if (merged.back() != items.size())
+            merged.push_back(items.size());
+        bounds = std::move(merged);
+    }
+}
+
+
 struct Vertex
 {
     Vertex() :
@@ -365,7 +441,7 @@ joinVertices(std::vector<Face>& faces,
     }
 
     // Sort the vertices so that identical ones will be ordered consecutively
-    std::sort(vertices.begin(), vertices.end(), orderingPredicate);
+    parallelSort(vertices, orderingPredicate);
 
     // Build the vertex merge map
     std::vector<std::uint32_t> mergeMap(nVertices);
@@ -524,18 +600,21 @@ GenerateNormals(const cmod::Mesh& mesh, float smoothAngle, bool weld, float weld
     const cmod::VWord* vertexData = mesh.getVertexData();
 
     // Compute normals for the faces
-    for (f = 0; f < nFaces; f++)
+    forEachRange(nFaces, [&](std::size_t begin, std::size_t end)
     {
-        Face& face = faces[f];
-        Eigen::Vector3f p0 = getVertex(vertexData, posOffset, stride, face.i[0]);
-        Eigen::Vector3f p1 = getVertex(vertexData, posOffset, stride, face.i[1]);
-        Eigen::Vector3f p2 = getVertex(vertexData, posOffset, stride, face.i[2]);
-        face.normal = (p1 - p0).cross(p2 - p1);
-        if (face.normal.squaredNorm() > 0.0f)
+        for (std::size_t faceIndex = begin; faceIndex < end; faceIndex++)
         {
-            face.normal.normalize();
+            Face& face = faces[faceIndex];
+            Eigen::Vector3f p0 = getVertex(vertexData, posOffset, stride, face.i[0]);
+            Eigen::Vector3f p1 = getVertex(vertexData, posOffset, stride, face.i[1]);
+            Eigen::Vector3f p2 = getVertex(vertexData, posOffset, stride, face.i[2]);
+            face.normal = (p1 - p0).cross(p2 - p1);
+            if (face.normal.squaredNorm() > 0.0f)
+            {
+                face.normal.normalize();
+            }
         }
-    }
+    });
 
     // For each vertex, create a list of faces that contain it
     std::vector<std::uint32_t> faceCounts(nVertices, 0);
@@ -590,18 +669,21 @@ GenerateNormals(const cmod::Mesh& mesh, float smoothAngle, bool weld, float weld
 
     // Compute the vertex normals by averaging
     std::vector<Eigen::Vector3f> vertexNormals(nFaces * 3);
-    for (f = 0; f < nFaces; f++)
+    forEachRange(nFaces, [&](std::size_t begin, std::size_t end)
     {
-        Face& face = faces[f];
-        for (std::uint32_t j = 0; j < 3; j++)
+        for (auto faceIndex = static_cast<std::uint32_t>(begin); faceIndex < end; faceIndex++)
         {
-            vertexNormals[f * 3 + j] =
-                averageFaceVectors(faces, f,
-                                   &vertexFaces[face.vi[j]][1],
-                                   vertexFaces[face.vi[j]][0],
-                                   cosSmoothAngle);
+            Face& face = faces[faceIndex];
+            for (std::uint32_t j = 0; j < 3; j++)
+            {
+                vertexNormals[faceIndex * 3 + j] =
+                    averageFaceVectors(faces, faceIndex,
+                                       &vertexFaces[face.vi[j]][1],
+                                       vertexFaces[face.vi[j]][0],
+                                       cosSmoothAngle);
+            }
         }
-    }
+    });
 
     // Finally, create a new mesh with normals included
 
@@ -641,21 +723,24 @@ GenerateNormals(const cmod::Mesh& mesh, float smoothAngle, bool weld, float weld
     // new vertex data buffer.
     unsigned int newStride = newDesc.strideBytes / sizeof(cmod::VWord);
     std::vector<cmod::VWord> newVertexData(newStride * nFaces * 3);
-    for (f = 0; f < nFaces; f++)
+    forEachRange(nFaces, [&](std::size_t begin, std::size_t end)
     {
-        Face& face = faces[f];
-
-        for (std::uint32_t j = 0; j < 3; j++)
+        for (std::size_t faceIndex = begin; faceIndex < end; faceIndex++)
         {
-            cmod::VWord* newVertex = newVertexData.data() + (f * 3 + j) * newStride;
-            copyVertex(newVertex, newDesc,
-                       vertexData, desc,
-                       face.i[j],
-                       fromOffsets);
-            std::memcpy(newVertex + normalOffset, &vertexNormals[f * 3 + j],
-                        cmod::VertexAttribute::getFormatSizeWords(cmod::VertexAttributeFormat::Float3) * sizeof(cmod::VWord));
+            const Face& face = faces[faceIndex];
+
+            for (std::uint32_t j = 0; j < 3; j++)
+            {
+                cmod::VWord* newVertex = newVertexData.data() + (faceIndex * 3 + j) * newStride;
+                copyVertex(newVertex, newDesc,
+                           vertexData, desc,
+                           face.i[j],
+                           fromOffsets);
+                std::memcpy(newVertex + normalOffset, &vertexNormals[faceIndex * 3 + j],
+                            cmod::VertexAttribute::getFormatSizeWords(cmod::VertexAttributeFormat::Float3) * sizeof(cmod::VWord));
+            }
         }
-    }
+    });
 
     // Create the Celestia mesh
     cmod::Mesh newMesh;
@@ -783,25 +868,28 @@ GenerateTangents(const cmod::Mesh& mesh, bool weld)
     const cmod::VWord* vertexData = mesh.getVertexData();
 
     // Compute tangents for faces
-    for (f = 0; f < nFaces; f++)
+    forEachRange(nFaces, [&](std::size_t begin, std::size_t end)
     {
-        Face& face = faces[f];
-        Eigen::Vector3f p0 = getVertex(vertexData, posOffset, stride, face.i[0]);
-        Eigen::Vector3f p1 = getVertex(vertexData, posOffset, stride, face.i[1]);
-        Eigen::Vector3f p2 = getVertex(vertexData, posOffset, stride, face.i[2]);
-        Eigen::Vector2f tc0 = getTexCoord(vertexData, texCoordOffset, stride, face.i[0]);
-        Eigen::Vector2f tc1 = getTexCoord(vertexData, texCoordOffset, stride, face.i[1]);
-        Eigen::Vector2f tc2 = getTexCoord(vertexData, texCoordOffset, stride, face.i[2]);
-        float s1 = tc1.x() - tc0.x();
-        float s2 = tc2.x() - tc0.x();
-        float t1 = tc1.y() - tc0.y();
-        float t2 = tc2.y() - tc0.y();
-        float a = s1 * t2 - s2 * t1;
-        if (a != 0.0f)
-            face.normal = (t2 * (p1 - p0) - t1 * (p2 - p0)) * (1.0f / a);
-        else
-            face.normal = Eigen::Vector3f::Zero();
-    }
+        for (std::size_t faceIndex = begin; faceIndex < end; faceIndex++)
+        {
+            Face& face = faces[faceIndex];
+            Eigen::Vector3f p0 = getVertex(vertexData, posOffset, stride, face.i[0]);
+            Eigen::Vector3f p1 = getVertex(vertexData, posOffset, stride, face.i[1]);
+            Eigen::Vector3f p2 = getVertex(vertexData, posOffset, stride, face.i[2]);
+            Eigen::Vector2f tc0 = getTexCoord(vertexData, texCoordOffset, stride, face.i[0]);
+            Eigen::Vector2f tc1 = getTexCoord(vertexData, texCoordOffset, stride, face.i[1]);
+            Eigen::Vector2f tc2 = getTexCoord(vertexData, texCoordOffset, stride, face.i[2]);
+            float s1 = tc1.x() - tc0.x();
+            float s2 = tc2.x() - tc0.x();
+            float t1 = tc1.y() - tc0.y();
+            float t2 = tc2.y() - tc0.y();
+            float a = s1 * t2 - s2 * t1;
+            if (a != 0.0f)
+                face.normal = (t2 * (p1 - p0) - t1 * (p2 - p0)) * (1.0f / a);
+            else
+                face.normal = Eigen::Vector3f::Zero();
+        }
+    });
 
     // For each vertex, create a list of faces that contain it
     std::uint32_t* faceCounts = new std::uint32_t[nVertices];
@@ -863,18 +951,21 @@ GenerateTangents(const cmod::Mesh& mesh, bool weld)
 
     // Compute the vertex tangents by averaging
     std::vector<Eigen::Vector3f> vertexTangents(nFaces * 3);
-    for (f = 0; f < nFaces; f++)
+    forEachRange(nFaces, [&](std::size_t begin, std::size_t end)
     {
-        Face& face = faces[f];
-        for (std::uint32_t j = 0; j < 3; j++)
+        for (auto faceIndex = static_cast<std::uint32_t>(begin); faceIndex < end; faceIndex++)
         {
-            vertexTangents[f * 3 + j] =
-                averageFaceVectors(faces, f,
-                                   &vertexFaces[face.vi[j]][1],
-                                   vertexFaces[face.vi[j]][0],
-                                   0.0f);
+            Face& face = faces[faceIndex];
+            for (std::uint32_t j = 0; j < 3; j++)
+            {
+                vertexTangents[faceIndex * 3 + j] =
+                    averageFaceVectors(faces, faceIndex,
+                                       &vertexFaces[face.vi[j]][1],
+                                       vertexFaces[face.vi[j]][0],
+                                       0.0f);
+            }
         }
-    }
+    });
 
     // Create the new vertex description
     cmod::VertexDescription newDesc = desc.clone();
@@ -912,20 +1003,23 @@ GenerateTangents(const cmod::Mesh& mesh, bool weld)
     // new vertex data buffer.
     unsigned int newStride = newDesc.strideBytes / sizeof(cmod::VWord);
     std::vector<cmod::VWord> newVertexData(newStride * nFaces * 3);
-    for (f = 0; f < nFaces; f++)
+    forEachRange(nFaces, [&](std::size_t begin, std::size_t end)
     {
-        Face& face = faces[f];
-
-        for (std::uint32_t j = 0; j < 3; j++)
+        for (std::size_t faceIndex = begin; faceIndex < end; faceIndex++)
         {
-            cmod::VWord* newVertex = newVertexData.data() + (f * 3 + j) * newStride;
-            copyVertex(newVertex, newDesc,
-                       vertexData, desc,
-                       face.i[j],
-                       fromOffsets);
-            std::memcpy(newVertex + tangentOffset, &vertexTangents[f * 3 + j], 3 * sizeof(float));
+            const Face& face = faces[faceIndex];
+
+            for (std::uint32_t j = 0; j < 3; j++)
+            {
+                cmod::VWord* newVertex = newVertexData.data() + (faceIndex * 3 + j) * newStride;
+                copyVertex(newVertex, newDesc,
+                           vertexData, desc,
+                           face.i[j],
+                           fromOffsets);
+                std::memcpy(newVertex + tangentOffset, &vertexTangents[faceIndex * 3 + j], 3 * sizeof(float));
+            }
         }
-    }
+    });
 
     // Create the Celestia mesh
     cmod::Mesh newMesh;
@@ -998,7 +1092,7 @@ UniquifyVertices(cmod::Mesh& mesh)
     }
 
     // Sort the vertices so that identical ones will be ordered consecutively
-    std::sort(vertices.begin(), vertices.end(), FullComparator(stride));
+    parallelSort(vertices, FullComparator(stride));
 
     // Count the number of unique vertices
     std::uint32_t uniqueVertexCount = 0;
@@ -1145,20 +1239,19 @@ GenerateModelNormals(const cmod::Model& model, float smoothAngle, bool weldVerti
         newModel->addMaterial(model.getMaterial(i)->clone());
     }
 
-    bool ok = true;
-    for (unsigned int i = 0; model.getMesh(i) != nullptr; i++)
+    // The meshes are processed in parallel, and added in their order
+    std::vector<cmod::Mesh> newMeshes(model.getMeshCount());
+    std::atomic<bool> ok{ true };
+    util::GetThreadPool()->parallelFor(newMeshes.size(), [&](std::size_t i)
     {
-        const cmod::Mesh* mesh = model.getMesh(i);
-        cmod::Mesh newMesh = GenerateNormals(*mesh, smoothAngle, weldVertices, weldTolerance);
-        if (newMesh.getVertexCount() == 0)
-        {
+        newMeshes[i] = GenerateNormals(*model.getMesh(static_cast<unsigned int>(i)),
+                                       smoothAngle, weldVertices, weldTolerance);
+        if (newMeshes[i].getVertexCount() == 0)
             ok = false;
-        }
-        else
-        {
-            newModel->addMesh(std::move(newMesh));
-        }
-    }
+    });
+
+    for (cmod::Mesh& newMesh : newMeshes)
+        newModel->addMesh(std::move(newMesh));
 
     if (!ok)
     {
@@ -9,13 +9,17 @@
 //
 // Functions for converting a 3DS scene into a Celestia model (cmod)
 
+#include <algorithm>
 #include <cmath>
+#include <cstring>
 #include <cstdint>
+#include <string>
 #include <utility>
 #include <vector>
 
 #include <Eigen/Core>
 
+#include <cel3ds/3dsread.h>
 #include <celmodel/material.h>
 #include <celmodel/mesh.h>
 
@@ -58,13 +62,23 @@ convert3dsMaterial(const M3DMaterial* material3ds, cmod::HandleGetter& handleGet
     return newMaterial;
 }
 
-} // end unnamed namespace
 
+// Returns the index of the last material with the name, or ~0 if there is
+// none
+unsigned int
+findMaterialIndex(const std::vector<std::string>& materialNames, const std::string& name)
+{
+    if (name.empty())
+        return ~0u;
 
-void
-Convert3DSMesh(cmod::Model& model,
-               const M3DTriangleMesh& mesh3ds,
-               const M3DScene& scene,
+    auto it = std::find(materialNames.rbegin(), materialNames.rend(), name);
+    return it == materialNames.rend() ? ~0u : static_cast<unsigned int>(materialNames.rend() - it - 1);
+}
+
+
+cmod::Mesh
+convert3dsMesh(const M3DTriangleMesh& mesh3ds,
+               const std::vector<std::string>& materialNames,
                std::string&& meshName)
 {
     int nVertices = mesh3ds.getVertexCount();
@@ -157,60 +171,101 @@ Convert3DSMesh(cmod::Model& model,
                 indices.push_back(v2);
             }
 
-            // Get the material index
-            unsigned int materialIndex = ~0u;
-            std::string material3dsName = matGroup->materialName;
-            if (!material3dsName.empty())
-            {
-                for (unsigned int i = 0; i < scene.getMaterialCount(); i++)
-                {
-                    const M3DMaterial* material3ds = scene.getMaterial(i);
-                    if (material3dsName == material3ds->getName())
-                    {
-                        materialIndex = i;
-                    }
-                }
-            }
-
+            unsigned int materialIndex = findMaterialIndex(materialNames, matGroup->materialName);
             mesh.addGroup(cmod::PrimitiveGroupType::TriList, materialIndex, std::move(indices));
         }
     }
 
-    model.addMesh(std::move(mesh));
+    return mesh;
 }
 
 
-std::unique_ptr<cmod::Model>
-Convert3DSModel(const M3DScene& scene, cmod::HandleGetter handleGetter)
+// Converts the materials and meshes of a 3DS file while it is read, so that
+// only one 3DS mesh is kept in memory at a time
+class ModelConverter : public M3DSceneHandler
 {
-    auto model = std::make_unique<cmod::Model>();
+public:
+    explicit ModelConverter(cmod::HandleGetter& handleGetter) : handleGetter(handleGetter) {}
 
-    // Convert materials
-    for (unsigned int i = 0; i < scene.getMaterialCount(); i++)
+    void addMaterial(M3DMaterial&& material) override
     {
-        const M3DMaterial* material = scene.getMaterial(i);
-        model->addMaterial(convert3dsMaterial(material, handleGetter));
+        model->addMaterial(convert3dsMaterial(&material, handleGetter));
+        materialNames.push_back(material.getName());
     }
 
-    // Convert meshes
-    for (unsigned int i = 0; i < scene.getModelCount(); i++)
+    void beginModel(std::string&& name) override
     {
-        const M3DModel* model3ds = scene.getModel(i);
-        if (model3ds != nullptr)
-        {
-            for (unsigned int j = 0; j < model3ds->getTriMeshCount(); j++)
-            {
-                const M3DTriangleMesh* mesh = model3ds->getTriMesh(j);
+        modelName = std::move(name);
+    }
 
-                if (mesh != nullptr && mesh->getFaceCount() > 0)
-                {
-                    Convert3DSMesh(*model, *mesh, scene, model3ds->getName());
-                }
-            }
+    void addTriMesh(M3DTriangleMesh&& mesh) override
+    {
+        if (mesh.getFaceCount() == 0)
+            return;
+
+        // Meshes referring to materials which follow them are converted
+        // once the whole file is read, and so are those after them to keep
+        // the order of the meshes
+        if (pendingMeshes.empty() && hasMaterials(mesh))
+            model->addMesh(convert3dsMesh(mesh, materialNames, std::string(modelName)));
+        else
+            pendingMeshes.emplace_back(std::move(mesh), modelName);
+    }
+
+    std::unique_ptr<cmod::Model> finish()
+    {
+        for (auto& [mesh, name] : pendingMeshes)
+            model->addMesh(convert3dsMesh(mesh, materialNames, std::move(name)));
+        pendingMeshes.clear();
+        return std::move(model);
+    }
+
+private:
+    bool hasMaterials(const M3DTriangleMesh& mesh) const
+    {
+        for (std::uint32_t i = 0; i < mesh.getMeshMaterialGroupCount(); ++i)
+        {
+            const std::string& name = mesh.getMeshMaterialGroup(i)->materialName;
+            if (!name.empty() && std::find(materialNames.begin(), materialNames.end(), name) == materialNames.end())
+                return false;
         }
+
+        return true;
     }
 
-    return model;
+    cmod::HandleGetter& handleGetter;
+    std::unique_ptr<cmod::Model> model{ std::make_unique<cmod::Model>() };
+    std::vector<std::string> materialNames;
+    std::string modelName;
+    std::vector<std::pair<M3DTriangleMesh, std::string>> pendingMeshes;
+};
+
+} // end unnamed namespace
+
+
+void
+Convert3DSMesh(cmod::Model& model,
+               const M3DTriangleMesh& mesh3ds,
+               const M3DScene& scene,
+               std::string&& meshName)
+{
+    std::vector<std::string> materialNames;
+    materialNames.reserve(scene.getMaterialCount());
+    for (unsigned int i = 0; i < scene.getMaterialCount(); i++)
+        materialNames.push_back(scene.getMaterial(i)->getName());
+
+    model.addMesh(convert3dsMesh(mesh3ds, materialNames, std::move(meshName)));
+}
+
+
+std::unique_ptr<cmod::Model>
+Load3DSModel(const fs::path& filename, cmod::HandleGetter handleGetter)
+{
+    ModelConverter converter(handleGetter);
+    if (!Read3DSFile(filename, converter))
+        return nullptr;
+
+    return converter.finish();
 }
 
 } // end namespace cmodtools
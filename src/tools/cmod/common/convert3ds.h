@@ -15,6 +15,7 @@
 #include <string>
 
 #include <cel3ds/3dsmodel.h>
+#include <celcompat/filesystem.h>
 #include <celmodel/model.h>
 #include <celmodel/modelfile.h>
 
@@ -23,11 +24,13 @@ namespace cmodtools
 {
 
 extern void Convert3DSMesh(cmod::Model& model,
-                           M3DTriangleMesh& mesh3ds,
+                           const M3DTriangleMesh& mesh3ds,
                            const M3DScene& scene,
                            std::string&& meshName);
 
-extern std::unique_ptr<cmod::Model> Convert3DSModel(const M3DScene& scene,
-                                                    cmod::HandleGetter handleGetter);
+// Reads the 3DS file and converts it while it is read, returns nullptr if
+// the file can't be read
+extern std::unique_ptr<cmod::Model> Load3DSModel(const fs::path& filename,
+                                                 cmod::HandleGetter handleGetter);
 
 }
@@ -10,6 +10,7 @@
 // Functions for converting a Wavefront .obj file into a
 // Celestia model (cmod)
 
+#include <cstddef>
 #include <cstdio>
 #include <cstring>
 #include <sstream>
@@ -314,17 +315,18 @@ WavefrontLoader::reportError(const std::string& message)
 void
 WavefrontLoader::addVertexData(const Eigen::Vector2f& v)
 {
-    m_vertexData.push_back(v.x());
-    m_vertexData.push_back(v.y());
+    std::size_t offset = m_vertexData.size();
+    m_vertexData.resize(offset + 2);
+    std::memcpy(m_vertexData.data() + offset, v.data(), sizeof(float) * 2);
 }
 
 
 void
 WavefrontLoader::addVertexData(const Eigen::Vector3f& v)
 {
-    m_vertexData.push_back(v.x());
-    m_vertexData.push_back(v.y());
-    m_vertexData.push_back(v.z());
+    std::size_t offset = m_vertexData.size();
+    m_vertexData.resize(offset + 3);
+    std::memcpy(m_vertexData.data() + offset, v.data(), sizeof(float) * 3);
 }
 
 
@@ -357,13 +359,11 @@ WavefrontLoader::createMesh(ObjVertex::VertexType vertexType, unsigned int verte
         offset += 2;
     }
 
-    std::vector<cmod::VWord> vertexDataCopy(m_vertexData.size());
-    std::memcpy(vertexDataCopy.data(), m_vertexData.data(), m_vertexData.size() * sizeof(cmod::VWord));
-
-    // Create the Celestia mesh
+    // Create the Celestia mesh, taking over the vertex data
+    static_assert(sizeof(float) == sizeof(cmod::VWord), "Float does not match vertex data word size");
     cmod::Mesh mesh;
     mesh.setVertexDescription(cmod::VertexDescription(std::move(attributes)));
-    mesh.setVertices(vertexCount, std::move(vertexDataCopy));
+    mesh.setVertices(vertexCount, std::move(m_vertexData));
 
     // Add primitive groups
     for (unsigned int i = 0; i < m_materialGroups.size(); ++i)
@@ -379,13 +379,25 @@ WavefrontLoader::createMesh(ObjVertex::VertexType vertexType, unsigned int verte
             indexCount = m_indexData.size() - firstIndex;
         }
 
-        if (indexCount > 0)
+        if (indexCount == 0)
+            continue;
+
+        std::vector<cmod::Index32> indices;
+        if (i < m_materialGroups.size() - 1)
         {
             auto copyStart = m_indexData.begin() + firstIndex;
-            mesh.addGroup(cmod::PrimitiveGroupType::TriList,
-                          m_materialGroups[i].materialIndex,
-                          std::vector<cmod::Index32>(copyStart, copyStart + indexCount));
+            indices.assign(copyStart, copyStart + indexCount);
         }
+        else
+        {
+            // The last group takes over the remaining indices
+            m_indexData.erase(m_indexData.begin(), m_indexData.begin() + firstIndex);
+            indices = std::move(m_indexData);
+        }
+
+        mesh.addGroup(cmod::PrimitiveGroupType::TriList,
+                      m_materialGroups[i].materialIndex,
+                      std::move(indices));
     }
 
     m_vertexData.clear();
@@ -19,6 +19,7 @@
 
 #include <Eigen/Core>
 
+#include <celmodel/mesh.h>
 #include <celmodel/model.h>
 
 
@@ -97,7 +98,7 @@ private:
     std::vector<Eigen::Vector3f> m_normals;
     std::vector<Eigen::Vector2f> m_texCoords;
 
-    std::vector<float> m_vertexData;
+    std::vector<cmod::VWord> m_vertexData;
     std::vector<cmod::Index32> m_indexData;
     std::vector<MaterialGroup> m_materialGroups;
 
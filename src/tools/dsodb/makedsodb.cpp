@@ -0,0 +1,105 @@
+// makedsodb.cpp
+//
+// Copyright (C) 2025, the Celestia Development Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// Convert a deep sky catalog to the binary catalog which Celestia loads
+// without parsing. File references in the catalog, such as meshes and
+// custom galaxy templates, are resolved against the directory of the
+// binary catalog when it is loaded.
+
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include <celengine/dsodbbuilder.h>
+
+
+static std::string inputFilename;
+static std::string outputFilename;
+
+
+void Usage()
+{
+    std::cerr << "Usage: makedsodb [input file] [output file]\n";
+}
+
+
+bool parseCommandLine(int argc, char* argv[])
+{
+    int fileCount = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        if (argv[i][0] == '-')
+        {
+            std::cerr << "Unknown command line switch: " << argv[i] << '\n';
+            return false;
+        }
+
+        if (fileCount == 0)
+            inputFilename = std::string(argv[i]);
+        else if (fileCount == 1)
+            outputFilename = std::string(argv[i]);
+        else
+            return false;
+        fileCount++;
+    }
+
+    return true;
+}
+
+
+int main(int argc, char* argv[])
+{
+    if (!parseCommandLine(argc, argv))
+    {
+        Usage();
+        return 1;
+    }
+
+    std::istream* inputFile = &std::cin;
+    std::ifstream fin;
+    if (!inputFilename.empty())
+    {
+        fin.open(inputFilename, std::ios::in);
+        if (!fin.good())
+        {
+            std::cerr << "Error opening input file " << inputFilename << '\n';
+            return 1;
+        }
+        inputFile = &fin;
+    }
+
+    DSODatabaseBuilder builder;
+    builder.setKeepDefinitions(true);
+    if (!builder.load(*inputFile))
+    {
+        std::cerr << "Error reading deep sky catalog\n";
+        return 1;
+    }
+
+    std::ostream* outputFile = &std::cout;
+    std::ofstream fout;
+    if (!outputFilename.empty())
+    {
+        fout.open(outputFilename, std::ios::out | std::ios::binary);
+        if (!fout.good())
+        {
+            std::cerr << "Error opening output file " << outputFilename << '\n';
+            return 1;
+        }
+        outputFile = &fout;
+    }
+
+    if (!builder.writeBinary(*outputFile))
+    {
+        std::cerr << "Error writing deep sky catalog\n";
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,465 @@
+// prebake.cpp
+//
+// Copyright (C) 2025-present, the Celestia Development Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// Load the catalogs of an installation as Celestia does at startup, so that
+// the on-disk caches are written, then load them again to check that the
+// caches are used, and write a manifest of the cache files.
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include <celcompat/filesystem.h>
+#include <celengine/dsodb.h>
+#include <celengine/formcache.h>
+#include <celengine/galaxyform.h>
+#include <celengine/star.h>
+#include <celengine/stardb.h>
+#include <celengine/texmanager.h>
+#include <celengine/texturecache.h>
+#include <celengine/universe.h>
+#include <celestia/configfile.h>
+#include <celestia/loaddso.h>
+#include <celestia/loadsso.h>
+#include <celestia/loadstars.h>
+#include <celimage/image.h>
+#include <celutil/atomicfile.h>
+#include <celutil/filetype.h>
+#include <celutil/fsutils.h>
+#include <celutil/hash.h>
+#include <celutil/logger.h>
+#include <celutil/mappedfile.h>
+#include <celutil/threadpool.h>
+#ifdef USE_SPICE
+#include <celephem/spiceinterface.h>
+#endif
+
+using celestia::engine::Image;
+namespace engine = celestia::engine;
+namespace util = celestia::util;
+
+namespace
+{
+
+struct Options
+{
+    fs::path dataDirectory;
+    fs::path configFile{ "celestia.cfg" };
+    std::vector<fs::path> extrasDirs;
+    fs::path manifestFile;
+};
+
+void
+Usage()
+{
+    std::cerr << "Usage: celestia-prebake [options]\n";
+    std::cerr << "  Options:\n";
+    std::cerr << "    --dir <directory> (or -d) : Celestia data directory\n";
+    std::cerr << "    --conf <file> (or -f) : configuration file (default celestia.cfg)\n";
+    std::cerr << "    --extrasdir <directory> (or -e) : additional extras directory\n";
+    std::cerr << "    --manifest <file> (or -m) : manifest file (default prebake.manifest\n";
+    std::cerr << "        in the cache directory)\n";
+    std::cerr << "  The caches are written to the cache directory of the writeable data\n";
+    std::cerr << "  directory, which XDG_DATA_HOME selects. Transcoded textures are keyed by\n";
+    std::cerr << "  the absolute path and modification time of their sources, so the\n";
+    std::cerr << "  installation must be deployed to the same path with the times kept.\n";
+    std::cerr << "  Shader binaries depend on the driver and are written at the first launch.\n";
+}
+
+bool
+parseCommandLine(int argc, char* argv[], Options& options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        std::string_view arg(argv[i]);
+        if (i + 1 == argc)
+            return false;
+
+        fs::path value = fs::u8path(argv[++i]);
+        if (arg == "--dir" || arg == "-d")
+        {
+            options.dataDirectory = std::move(value);
+        }
+        else if (arg == "--conf" || arg == "-f")
+        {
+            options.configFile = std::move(value);
+        }
+        else if (arg == "--extrasdir" || arg == "-e")
+        {
+            options.extrasDirs.push_back(std::move(value));
+        }
+        else if (arg == "--manifest" || arg == "-m")
+        {
+            options.manifestFile = std::move(value);
+        }
+        else
+        {
+            std::cerr << "Unknown command line switch: " << arg << '\n';
+            return false;
+        }
+    }
+
+    return true;
+}
+
+struct CatalogCounts
+{
+    std::uint32_t stars{ 0 };
+    std::uint32_t dsos{ 0 };
+    std::size_t solarSystems{ 0 };
+
+    bool operator==(const CatalogCounts& other) const
+    {
+        return stars == other.stars && dsos == other.dsos && solarSystems == other.solarSystems;
+    }
+};
+
+// Load the catalogs as CelestiaCore::initSimulation does, which writes the
+// octree, solar system and deep sky caches where they are missing or stale
+std::unique_ptr<Universe>
+loadCatalogs(const CelestiaConfig& config, CatalogCounts& counts)
+{
+    auto universe = std::make_unique<Universe>();
+
+    auto starCatalog = celestia::loadStars(config, nullptr);
+    if (starCatalog == nullptr)
+    {
+        std::cerr << "Cannot read star database\n";
+        return nullptr;
+    }
+    counts.stars = starCatalog->size();
+    universe->setStarCatalog(std::move(starCatalog));
+
+    auto dsoCatalog = celestia::loadDSO(config, nullptr);
+    if (dsoCatalog == nullptr)
+    {
+        std::cerr << "Cannot read DSO database\n";
+        return nullptr;
+    }
+    counts.dsos = dsoCatalog->size();
+    universe->setDSOCatalog(std::move(dsoCatalog));
+
+    celestia::loadSSO(config, nullptr, universe.get());
+    counts.solarSystems = universe->getSolarSystemCatalog()->size();
+
+    // Builds the galaxy forms which aren't in the form cache yet
+    engine::GalacticFormManager::get()->buildForms();
+
+    return universe;
+}
+
+bool
+isTranscodable(const fs::path& path)
+{
+    // As LoadTextureImage
+    switch (DetermineFileType(path))
+    {
+    case ContentType::JPEG:
+    case ContentType::BMP:
+    case ContentType::PNG:
+#ifdef USE_LIBAVIF
+    case ContentType::AVIF:
+#endif
+        return true;
+    default:
+        return false;
+    }
+}
+
+// The textures of the loaded objects which Celestia transcodes, at every
+// resolution
+std::vector<TextureKey>
+findTextures()
+{
+    std::set<TextureKey> keys;
+    GetTextureManager()->forEachResource([&](const TextureInfo& info, const TextureKey& key)
+    {
+        std::error_code ec;
+        if (!info.isHeightMap() && isTranscodable(key.path) && fs::is_regular_file(key.path, ec))
+            keys.insert(key);
+    });
+
+    return std::vector<TextureKey>(keys.begin(), keys.end());
+}
+
+// Transcode the textures missing from the cache, as LoadTranscodedImage
+// does, and flag the textures in the cache. Images which aren't RGB or RGBA
+// aren't transcoded at run time either.
+std::size_t
+transcodeTextures(const engine::TextureCache& cache,
+                  const std::vector<TextureKey>& textures,
+                  std::vector<char>& cached)
+{
+    cached.assign(textures.size(), 0);
+    std::atomic<std::size_t> transcoded{ 0 };
+    util::GetThreadPool()->parallelFor(textures.size(), [&](std::size_t i)
+    {
+        const TextureKey& key = textures[i];
+        if (cache.load(key.path, key.reduction) != nullptr)
+        {
+            cached[i] = 1;
+            return;
+        }
+
+        auto image = Image::load(key.path, key.reduction);
+        if (image == nullptr)
+        {
+            util::GetLogger()->error("Error loading texture {}\n", key.path);
+            return;
+        }
+
+        auto compressed = image->compressDXT();
+        if (compressed == nullptr)
+            return;
+
+        if (cache.save(key.path, *compressed, key.reduction))
+        {
+            cached[i] = 1;
+            ++transcoded;
+        }
+        else
+        {
+            util::GetLogger()->error("Error saving the transcoded image of {}\n", key.path);
+        }
+    });
+
+    return transcoded;
+}
+
+struct ManifestEntry
+{
+    std::uintmax_t size;
+    std::uint64_t hash;
+
+    bool operator==(const ManifestEntry& other) const { return size == other.size && hash == other.hash; }
+    bool operator!=(const ManifestEntry& other) const { return !(*this == other); }
+};
+
+using Manifest = std::map<std::string, ManifestEntry>;
+
+std::uint64_t
+hashFile(const fs::path& path)
+{
+    util::FNV1aHash hash;
+    if (auto file = util::MappedFile::open(path); file != nullptr)
+        hash.addBytes(file->data(), file->size());
+    return hash.value();
+}
+
+Manifest
+scanCache(const fs::path& cacheDirectory, const fs::path& manifestFile)
+{
+    std::vector<std::pair<std::string, fs::path>> files;
+    std::error_code ec;
+    for (fs::recursive_directory_iterator it(cacheDirectory, ec), end; !ec && it != end; it.increment(ec))
+    {
+        if (fs::is_regular_file(it->path(), ec) && it->path() != manifestFile)
+            files.emplace_back(util::RelativeToDirectory(it->path(), cacheDirectory).generic_u8string(), it->path());
+    }
+
+    std::vector<ManifestEntry> entries(files.size());
+    util::GetThreadPool()->parallelFor(files.size(), [&](std::size_t i)
+    {
+        std::error_code sizeError;
+        entries[i].size = fs::file_size(files[i].second, sizeError);
+        entries[i].hash = hashFile(files[i].second);
+    });
+
+    Manifest manifest;
+    for (std::size_t i = 0; i < files.size(); ++i)
+        manifest.try_emplace(std::move(files[i].first), entries[i]);
+    return manifest;
+}
+
+bool
+writeManifest(const fs::path& path,
+              const Manifest& manifest,
+              const CatalogCounts& counts,
+              std::size_t textureCount)
+{
+    util::AtomicFile file(path);
+    std::ofstream& out = file.stream();
+    out << "# Celestia prebaked caches\n";
+    out << "# stars " << counts.stars << '\n';
+    out << "# dsos " << counts.dsos << '\n';
+    out << "# solar systems " << counts.solarSystems << '\n';
+    out << "# textures " << textureCount << '\n';
+    for (const auto& [name, entry] : manifest)
+        out << fmt::format("{:016x} {} {}\n", entry.hash, entry.size, name);
+
+    return file.commit();
+}
+
+} // end unnamed namespace
+
+int
+main(int argc, char* argv[])
+{
+    Options options;
+    if (!parseCommandLine(argc, argv, options))
+    {
+        Usage();
+        return 1;
+    }
+
+    util::CreateLogger();
+
+#ifdef PORTABLE_BUILD
+    std::cerr << "Portable builds don't use caches\n";
+    return 1;
+#else
+    if (!options.dataDirectory.empty())
+    {
+        std::error_code ec;
+        fs::current_path(options.dataDirectory, ec);
+        if (ec)
+        {
+            std::cerr << "Cannot change to the data directory " << options.dataDirectory << '\n';
+            return 1;
+        }
+    }
+
+    CelestiaConfig config;
+    if (!ReadCelestiaConfig(options.configFile, config))
+    {
+        std::cerr << "Error reading configuration file " << options.configFile << '\n';
+        return 1;
+    }
+
+    for (const fs::path& dir : options.extrasDirs)
+    {
+        if (std::find(config.paths.extrasDirs.begin(), config.paths.extrasDirs.end(), dir) ==
+            config.paths.extrasDirs.end())
+        {
+            config.paths.extrasDirs.push_back(dir);
+        }
+    }
+
+#ifdef USE_SPICE
+    if (!celestia::ephem::InitializeSpice())
+    {
+        std::cerr << "Initialization of SPICE library failed\n";
+        return 1;
+    }
+#endif
+
+    const fs::path cacheDirectory = util::WriteableDataPath() / "cache";
+    fs::path manifestFile = options.manifestFile.empty()
+        ? cacheDirectory / "prebake.manifest"
+        : fs::absolute(options.manifestFile);
+
+    engine::SetFormCacheDirectory(cacheDirectory / "forms");
+    StarDetails::SetStarTextures(config.starTextures);
+
+    std::cout << "Loading catalogs, writing caches to " << cacheDirectory.u8string() << '\n';
+    CatalogCounts counts;
+    auto universe = loadCatalogs(config, counts);
+    if (universe == nullptr)
+        return 1;
+
+    std::cout << counts.stars << " stars, " << counts.dsos << " deep sky objects, "
+              << counts.solarSystems << " solar systems\n";
+
+    std::vector<TextureKey> textures;
+    std::vector<char> cachedTextures;
+    std::unique_ptr<engine::TextureCache> textureCache;
+    if (config.renderDetails.TextureTranscoding)
+    {
+        textureCache = std::make_unique<engine::TextureCache>(cacheDirectory / "textures");
+        textures = findTextures();
+        std::size_t transcoded = transcodeTextures(*textureCache, textures, cachedTextures);
+        std::cout << "Transcoded " << transcoded << " of " << textures.size() << " textures\n";
+    }
+    else
+    {
+        std::cout << "Texture transcoding is disabled in the configuration\n";
+    }
+
+    Manifest manifest = scanCache(cacheDirectory, manifestFile);
+
+    // Valid caches are read rather than written again, so loading again
+    // must leave the cache files as they are and find the same objects
+    std::cout << "Validating\n";
+    universe = nullptr;
+    CatalogCounts validationCounts;
+    universe = loadCatalogs(config, validationCounts);
+    if (universe == nullptr)
+        return 1;
+
+    bool valid = true;
+    if (!(validationCounts == counts))
+    {
+        std::cerr << "The catalogs loaded from the caches differ\n";
+        valid = false;
+    }
+
+    std::atomic<std::size_t> missingTextures{ 0 };
+    if (textureCache != nullptr)
+    {
+        util::GetThreadPool()->parallelFor(textures.size(), [&](std::size_t i)
+        {
+            if (cachedTextures[i] != 0 &&
+                textureCache->load(textures[i].path, textures[i].reduction) == nullptr)
+            {
+                util::GetLogger()->error("No transcoded image for {}\n", textures[i].path);
+                ++missingTextures;
+            }
+        });
+    }
+
+    if (missingTextures > 0)
+        valid = false;
+
+    Manifest validationManifest = scanCache(cacheDirectory, manifestFile);
+    for (const auto& [name, entry] : validationManifest)
+    {
+        if (auto it = manifest.find(name); it == manifest.end() || it->second != entry)
+        {
+            std::cerr << "Cache file " << name << " was rewritten by a second load\n";
+            valid = false;
+        }
+    }
+
+    for (const auto& [name, entry] : manifest)
+    {
+        if (validationManifest.find(name) == validationManifest.end())
+        {
+            std::cerr << "Cache file " << name << " was removed by a second load\n";
+            valid = false;
+        }
+    }
+
+    if (!valid)
+    {
+        std::cerr << "The caches are not valid, no manifest written\n";
+        return 1;
+    }
+
+    if (!writeManifest(manifestFile, validationManifest, counts, textures.size()))
+    {
+        std::cerr << "Error writing manifest " << manifestFile << '\n';
+        return 1;
+    }
+
+    std::cout << "Wrote " << validationManifest.size() << " cache files to " << manifestFile.u8string() << '\n';
+    return 0;
+#endif
+}
@@ -17,7 +17,16 @@
 #include <sstream>
 #include <iomanip>
 #include <cmath>
+#include <cstdio>
 #include <ctime>
+#include <algorithm>
+#include <thread>
+
+#ifndef _WIN32
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
 
 #ifndef min
 #define min(a, b) ((a) < (b) ? (a) : (b))
@@ -46,7 +55,8 @@ public:
         frameName("eclipJ2000"),
         minStepSize(MIN_STEP_SIZE),
         maxStepSize(MAX_STEP_SIZE),
-        tolerance(TOLERANCE)
+        tolerance(TOLERANCE),
+        workerCount(defaultWorkerCount())
     {
     }
 
@@ -60,6 +70,14 @@ public:
     double minStepSize;
     double maxStepSize;
     double tolerance;
+    int workerCount;
+
+private:
+    static int defaultWorkerCount()
+    {
+        unsigned int count = std::thread::hardware_concurrency();
+        return count == 0 ? 1 : static_cast<int>(count);
+    }
 };
 
 
@@ -338,116 +356,223 @@ void writeCommentHeader(const Configuration& config,
 }
 
 
-bool convertSpkToXyzv(const Configuration& config,
-                      ostream& out)
+// Load the kernels listed in the configuration, or unload them
+void loadKernels(const Configuration& config, bool load = true)
 {
-    // Load the required SPICE kernels
     for (vector<string>::const_iterator iter = config.kernelList.begin();
          iter != config.kernelList.end(); iter++)
     {
         string pathname = config.kernelDirectory + "/" + *iter;
-        furnsh_c(pathname.c_str());
+        if (load)
+            furnsh_c(pathname.c_str());
+        else
+            unload_c(pathname.c_str());
     }
+}
 
-    double startET = 0.0;
-    double endET = 0.0;
-
-    str2et_c(config.startDate.c_str(), &startET);
-    str2et_c(config.endDate.c_str(),   &endET);
-
-    SpiceInt observerID = 0;
-    SpiceInt targetID = 0;
-    if (!bodyNameToId(config.observerName, &observerID))
-    {
-        cerr << "Observer object " << config.observerName << " not found. Aborting.\n";
-        return false;
-    }
 
-    if (!bodyNameToId(config.targetName, &targetID))
-    {
-        cerr << "Target object " << config.targetName << " not found. Aborting.\n";
-        return false;
-    }
-
-    double startStepSize = config.minStepSize; // samplingParams.startStep;
-    double maxStepSize   = config.maxStepSize; // samplingParams.maxStep;
-    double minStepSize   = config.minStepSize; // samplingParams.minStep;
-    double tolerance     = config.tolerance;   // samplingParams.tolerance;
-    double t = startET;
+// Write states from startET to endET at adaptively chosen steps: each step
+// is the longest for which cubic Hermite interpolation between its ends, as
+// done by Celestia, is within the tolerance at its midpoint. The state at
+// startET is written only if includeStart is set.
+void sampleRange(const Configuration& config,
+                 SpiceInt targetID,
+                 SpiceInt observerID,
+                 double startET,
+                 double endET,
+                 bool includeStart,
+                 ostream& out)
+{
+    double maxStepSize   = config.maxStepSize;
+    double minStepSize   = config.minStepSize;
+    double tolerance     = config.tolerance;
     const double stepFactor = 1.25;
 
     StateVector lastState = getStateVector(targetID, startET, config.frameName, observerID);
-    double et = startET;
+    double t = startET;
 
-    printRecord(out, et, lastState);
+    if (includeStart)
+        printRecord(out, t, lastState);
 
-    while (t < endET)
+    // Interpolation error at the midpoint of a step of dt, with the state
+    // at its end in s1
+    auto stepError = [&](double dt, StateVector& s1)
     {
-        // Make sure that we don't go past the end of the sample interval
-        maxStepSize = min(maxStepSize, endET - t);
-        double dt = min(maxStepSize, startStepSize * 2.0);
-
-        StateVector s1 = getStateVector(targetID, t + dt, config.frameName, observerID);
-
-        double tmid = t + dt / 2.0;
-        Vec3d pTest = getStateVector(targetID, tmid, config.frameName, observerID).position;
+        s1 = getStateVector(targetID, t + dt, config.frameName, observerID);
+        Vec3d pTest = getStateVector(targetID, t + dt / 2.0, config.frameName, observerID).position;
         Vec3d pInterp = cubicInterpolate(lastState.position,
                                          lastState.velocity * dt,
                                          s1.position,
                                          s1.velocity * dt,
                                          0.5);
+        return (pInterp - pTest).length();
+    };
+
+    // Steps usually change slowly, so the search starts from the last one
+    double startStepSize = minStepSize;
+
+    while (t < endET)
+    {
+        // Make sure that we don't go past the end of the sample interval
+        double maxStep = min(maxStepSize, endET - t);
+        double dt = min(maxStep, startStepSize * 2.0);
 
-        double positionError = (pInterp - pTest).length();
+        StateVector s1 = lastState;
+        double positionError = stepError(dt, s1);
 
-        // Error is greater than tolerance; decrease the step until the
-        // error is within the tolerance.
         if (positionError > tolerance)
         {
+            // Error is greater than tolerance; decrease the step until the
+            // error is within the tolerance.
             while (positionError > tolerance && dt > minStepSize)
             {
-                dt /= stepFactor;
-
-                s1 = getStateVector(targetID, t + dt, config.frameName, observerID);
-
-                tmid = t + dt / 2.0;
-                Vec3d pTest = getStateVector(targetID, tmid, config.frameName, observerID).position;
-                pInterp = cubicInterpolate(lastState.position,
-                                           lastState.velocity * dt,
-                                           s1.position,
-                                           s1.velocity * dt,
-                                           0.5);
-
-                positionError = (pInterp - pTest).length();
+                dt = std::max(dt / stepFactor, min(minStepSize, maxStep));
+                positionError = stepError(dt, s1);
             }
         }
         else
         {
             // Error is less than the tolerance; increase the step size until
-            // the tolerance is just exceeded.
-            while (positionError < tolerance && dt < maxStepSize)
+            // the tolerance would be exceeded, keeping the last step within it.
+            while (dt < maxStep)
             {
-                dt *= stepFactor;
-                dt = min(maxStepSize, dt);
-
-                s1 = getStateVector(targetID, t + dt, config.frameName, observerID);
+                double nextDt = min(maxStep, dt * stepFactor);
+                StateVector next = s1;
+                if (stepError(nextDt, next) > tolerance)
+                    break;
 
-                tmid = t + dt / 2.0;
-                Vec3d pTest = getStateVector(targetID, tmid, config.frameName, observerID).position;
-                pInterp = cubicInterpolate(lastState.position,
-                                           lastState.velocity * dt,
-                                           s1.position,
-                                           s1.velocity * dt,
-                                           0.5);
-
-                positionError = (pInterp - pTest).length();
+                dt = nextDt;
+                s1 = next;
             }
         }
 
         t = t + dt;
         lastState = s1;
+        startStepSize = dt;
 
         printRecord(out, t, lastState);
     }
+}
+
+
+#ifndef _WIN32
+// Sample the time span in worker processes, each covering a part of it, as
+// CSPICE can't be used from several threads. The records of each worker go
+// to a temporary file, which is copied to out once all have finished.
+bool sampleInWorkers(const Configuration& config,
+                     SpiceInt targetID,
+                     SpiceInt observerID,
+                     double startET,
+                     double endET,
+                     ostream& out)
+{
+    int workerCount = config.workerCount;
+    vector<FILE*> files;
+    vector<pid_t> workers;
+
+    out.flush();
+    cerr.flush();
+
+    bool ok = true;
+    for (int i = 0; i < workerCount && ok; i++)
+    {
+        FILE* file = tmpfile();
+        if (file == nullptr)
+        {
+            ok = false;
+            break;
+        }
+        files.push_back(file);
+
+        pid_t pid = fork();
+        if (pid < 0)
+        {
+            ok = false;
+            break;
+        }
+
+        if (pid == 0)
+        {
+            double span = endET - startET;
+            double begin = startET + span * i / workerCount;
+            double end = i + 1 == workerCount ? endET : startET + span * (i + 1) / workerCount;
+
+            // Binary kernels are read through open files, whose offsets
+            // would be shared with the other workers
+            loadKernels(config, false);
+            loadKernels(config);
+
+            ostringstream records;
+            sampleRange(config, targetID, observerID, begin, end, i == 0, records);
+
+            string s = records.str();
+            bool written = fwrite(s.data(), 1, s.size(), file) == s.size() && fflush(file) == 0;
+            _exit(written ? 0 : 1);
+        }
+
+        workers.push_back(pid);
+    }
+
+    for (pid_t pid : workers)
+    {
+        int status = 0;
+        if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+            ok = false;
+    }
+
+    for (FILE* file : files)
+    {
+        if (ok)
+        {
+            rewind(file);
+            char buf[65536];
+            size_t n;
+            while ((n = fread(buf, 1, sizeof(buf), file)) > 0)
+                out.write(buf, n);
+        }
+        fclose(file);
+    }
+
+    if (!ok)
+        cerr << "Error sampling in worker processes. Aborting.\n";
+
+    return ok;
+}
+#endif
+
+
+bool convertSpkToXyzv(const Configuration& config,
+                      ostream& out)
+{
+    // Load the required SPICE kernels
+    loadKernels(config);
+
+    double startET = 0.0;
+    double endET = 0.0;
+
+    str2et_c(config.startDate.c_str(), &startET);
+    str2et_c(config.endDate.c_str(),   &endET);
+
+    SpiceInt observerID = 0;
+    SpiceInt targetID = 0;
+    if (!bodyNameToId(config.observerName, &observerID))
+    {
+        cerr << "Observer object " << config.observerName << " not found. Aborting.\n";
+        return false;
+    }
+
+    if (!bodyNameToId(config.targetName, &targetID))
+    {
+        cerr << "Target object " << config.targetName << " not found. Aborting.\n";
+        return false;
+    }
+
+#ifndef _WIN32
+    if (config.workerCount > 1)
+        return sampleInWorkers(config, targetID, observerID, startET, endET, out);
+#endif
+
+    sampleRange(config, targetID, observerID, startET, endET, true, out);
 
     return true;
 }
@@ -504,6 +629,10 @@ bool readConfig(istream& in, Configuration& config)
             {
                 in >> config.tolerance;
             }
+            else if (key == "Workers")
+            {
+                in >> config.workerCount;
+            }
             else if (key == "KernelDirectory")
             {
                 if (in >> qs)
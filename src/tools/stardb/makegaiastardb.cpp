@@ -0,0 +1,664 @@
+// makegaiastardb.cpp
+//
+// Copyright (C) 2025-present, the Celestia Development Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// Convert Gaia source tables in CSV or ECSV format to a Celestia star
+// database and/or a paged star catalog
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <Eigen/Core>
+
+#include <celastro/astro.h>
+#include <celcompat/charconv.h>
+#include <celcompat/filesystem.h>
+#include <celengine/pagedstarcatalog.h>
+#include <celengine/stardb.h>
+#include <celengine/starname.h>
+#include <celengine/stellarclass.h>
+#include <celutil/binarywrite.h>
+#include <celutil/logger.h>
+#include <celutil/threadpool.h>
+#include "stardbtext.h"
+
+namespace astro = celestia::astro;
+namespace compat = celestia::compat;
+namespace engine = celestia::engine;
+namespace util = celestia::util;
+
+using stardbtools::nextLine;
+using stardbtools::writeStarsHeader;
+
+namespace
+{
+
+// The input is parsed in windows of this size, each split into a chunk per
+// thread, so that memory use doesn't depend on the size of the input
+constexpr std::size_t WindowSize = 64 * 1024 * 1024;
+
+// Catalog numbers from here up to the Tycho numbers are unused by the
+// Hipparcos and Tycho catalogs
+constexpr AstroCatalog::IndexNumber FirstFreeNumber = StarDatabase::MAX_HIPPARCOS_NUMBER + 1;
+constexpr AstroCatalog::IndexNumber LastFreeNumber = StarNameDatabase::TYC3_MULTIPLIER - 1;
+
+struct Options
+{
+    std::vector<std::string> inputs;
+    std::string stardbFilename;
+    std::string pagedFilename;
+    std::string sourceIdFilename;
+    double minParallaxOverError{ 5.0 };
+    AstroCatalog::IndexNumber firstNumber{ FirstFreeNumber };
+};
+
+void
+Usage()
+{
+    std::cerr << "Usage: makegaiastardb [options] <input file>...\n";
+    std::cerr << "  Options:\n";
+    std::cerr << "    --stardb <file> (or -s) : write a star database (stars.dat format)\n";
+    std::cerr << "    --paged <file> (or -p) : write a paged star catalog; the selected stars\n";
+    std::cerr << "        are kept in memory to sort them into the octree (24 bytes per star)\n";
+    std::cerr << "    --source-ids <file> (or -i) : write the Gaia source_id of each catalog\n";
+    std::cerr << "        number as CSV\n";
+    std::cerr << "    --min-parallax-over-error <value> (or -e) : drop stars with less\n";
+    std::cerr << "        significant parallaxes (default 5)\n";
+    std::cerr << "    --first-number <n> (or -n) : catalog number of the first star\n";
+    std::cerr << "        (default " << FirstFreeNumber << ")\n";
+    std::cerr << "  Inputs are Gaia source tables in CSV or ECSV format with the columns\n";
+    std::cerr << "  source_id, ra, dec, parallax, phot_g_mean_mag and parallax_over_error\n";
+    std::cerr << "  or parallax_error, and optionally bp_rp. Use - to read standard input,\n";
+    std::cerr << "  for example from zcat.\n";
+}
+
+bool
+parseCommandLine(int argc, char* argv[], Options& options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        std::string_view arg(argv[i]);
+        if (arg.size() > 1 && arg[0] == '-')
+        {
+            if (i + 1 == argc)
+                return false;
+
+            const char* value = argv[++i];
+            if (arg == "--stardb" || arg == "-s")
+            {
+                options.stardbFilename = value;
+            }
+            else if (arg == "--paged" || arg == "-p")
+            {
+                options.pagedFilename = value;
+            }
+            else if (arg == "--source-ids" || arg == "-i")
+            {
+                options.sourceIdFilename = value;
+            }
+            else if (arg == "--min-parallax-over-error" || arg == "-e")
+            {
+                char* end = nullptr;
+                options.minParallaxOverError = std::strtod(value, &end);
+                if (end == value || *end != '\0')
+                    return false;
+            }
+            else if (arg == "--first-number" || arg == "-n")
+            {
+                char* end = nullptr;
+                unsigned long number = std::strtoul(value, &end, 10);
+                if (end == value || *end != '\0' || number > LastFreeNumber)
+                    return false;
+                options.firstNumber = static_cast<AstroCatalog::IndexNumber>(number);
+            }
+            else
+            {
+                std::cerr << "Unknown command line switch: " << arg << '\n';
+                return false;
+            }
+        }
+        else
+        {
+            options.inputs.emplace_back(arg);
+        }
+    }
+
+    return !options.inputs.empty() && (!options.stardbFilename.empty() || !options.pagedFilename.empty());
+}
+
+// Indices of the columns used, -1 if absent
+struct Columns
+{
+    int sourceId{ -1 };
+    int ra{ -1 };
+    int dec{ -1 };
+    int parallax{ -1 };
+    int parallaxError{ -1 };
+    int parallaxOverError{ -1 };
+    int gMag{ -1 };
+    int bpRp{ -1 };
+    int count{ 0 };
+};
+
+// Split a CSV line into fields, removing the quotes around quoted fields
+void
+splitFields(std::string_view line, std::vector<std::string_view>& fields)
+{
+    fields.clear();
+    std::size_t pos = 0;
+    for (;;)
+    {
+        if (pos < line.size() && line[pos] == '"')
+        {
+            std::size_t close = line.find('"', pos + 1);
+            if (close == std::string_view::npos)
+                close = line.size();
+            fields.push_back(line.substr(pos + 1, close - pos - 1));
+            pos = line.find(',', close);
+        }
+        else
+        {
+            std::size_t comma = line.find(',', pos);
+            fields.push_back(line.substr(pos, comma == std::string_view::npos ? comma : comma - pos));
+            pos = comma;
+        }
+
+        if (pos == std::string_view::npos)
+            return;
+        ++pos;
+    }
+}
+
+bool
+parseHeader(std::string_view line, Columns& columns)
+{
+    if (!line.empty() && line.back() == '\r')
+        line.remove_suffix(1);
+
+    std::vector<std::string_view> names;
+    splitFields(line, names);
+
+    columns = Columns();
+    columns.count = static_cast<int>(names.size());
+    for (int i = 0; i < columns.count; ++i)
+    {
+        std::string_view name = names[i];
+        if (name == "source_id")
+            columns.sourceId = i;
+        else if (name == "ra")
+            columns.ra = i;
+        else if (name == "dec")
+            columns.dec = i;
+        else if (name == "parallax")
+            columns.parallax = i;
+        else if (name == "parallax_error")
+            columns.parallaxError = i;
+        else if (name == "parallax_over_error")
+            columns.parallaxOverError = i;
+        else if (name == "phot_g_mean_mag")
+            columns.gMag = i;
+        else if (name == "bp_rp")
+            columns.bpRp = i;
+    }
+
+    return columns.sourceId >= 0 && columns.ra >= 0 && columns.dec >= 0 &&
+           columns.parallax >= 0 && columns.gMag >= 0 &&
+           (columns.parallaxOverError >= 0 || columns.parallaxError >= 0);
+}
+
+// Missing values are empty, or null in some exports
+template<typename T>
+std::optional<T>
+parseField(std::string_view field)
+{
+    T value;
+    const char* end = field.data() + field.size();
+    auto result = compat::from_chars(field.data(), end, value);
+    if (result.ec != std::errc{} || result.ptr != end)
+        return std::nullopt;
+    if constexpr (std::is_floating_point_v<T>)
+    {
+        if (!std::isfinite(value))
+            return std::nullopt;
+    }
+    return value;
+}
+
+// Main sequence colours and absolute G magnitudes by spectral type, after
+// Pecaut & Mamajek (2013), used to estimate the spectral types of the stars
+struct MainSequenceType
+{
+    float bpRp;
+    float absMag;
+    StellarClass::SpectralClass spectralClass;
+    unsigned int subclass;
+};
+
+constexpr std::array<MainSequenceType, 14> MainSequence
+{
+    MainSequenceType{ -0.45f, -4.5f, StellarClass::Spectral_O, 5 },
+    MainSequenceType{ -0.32f, -3.3f, StellarClass::Spectral_B, 0 },
+    MainSequenceType{ -0.12f, -1.0f, StellarClass::Spectral_B, 5 },
+    MainSequenceType{  0.00f,  1.0f, StellarClass::Spectral_A, 0 },
+    MainSequenceType{  0.19f,  1.9f, StellarClass::Spectral_A, 5 },
+    MainSequenceType{  0.38f,  2.6f, StellarClass::Spectral_F, 0 },
+    MainSequenceType{  0.56f,  3.4f, StellarClass::Spectral_F, 5 },
+    MainSequenceType{  0.72f,  4.2f, StellarClass::Spectral_G, 0 },
+    MainSequenceType{  0.84f,  4.9f, StellarClass::Spectral_G, 5 },
+    MainSequenceType{  0.98f,  5.7f, StellarClass::Spectral_K, 0 },
+    MainSequenceType{  1.43f,  7.1f, StellarClass::Spectral_K, 5 },
+    MainSequenceType{  1.84f,  8.2f, StellarClass::Spectral_M, 0 },
+    MainSequenceType{  3.30f, 11.6f, StellarClass::Spectral_M, 5 },
+    MainSequenceType{  4.50f, 15.0f, StellarClass::Spectral_M, 8 },
+};
+
+// Estimate a spectral type from the colour, and a luminosity class from the
+// offset from the main sequence. Extinction is not corrected for, so distant
+// stars in the plane of the galaxy appear later and fainter than they are.
+StellarClass
+estimateClass(std::optional<float> bpRp, float absMag)
+{
+    if (!bpRp.has_value())
+    {
+        return StellarClass(StellarClass::NormalStar, StellarClass::Spectral_Unknown,
+                            StellarClass::Subclass_Unknown, StellarClass::Lum_Unknown);
+    }
+
+    float colour = std::clamp(*bpRp, MainSequence.front().bpRp, MainSequence.back().bpRp);
+    auto upper = std::upper_bound(MainSequence.begin() + 1, MainSequence.end() - 1, colour,
+                                  [](float c, const MainSequenceType& type) { return c < type.bpRp; });
+    auto lower = upper - 1;
+    float t = (colour - lower->bpRp) / (upper->bpRp - lower->bpRp);
+
+    // Spectral classes O to M are consecutive, so the types interpolate as
+    // class * 10 + subclass
+    float lowerType = static_cast<float>(lower->spectralClass * 10 + lower->subclass);
+    float upperType = static_cast<float>(upper->spectralClass * 10 + upper->subclass);
+    auto type = static_cast<unsigned int>(std::lround(lowerType + (upperType - lowerType) * t));
+    float mainSequenceMag = lower->absMag + (upper->absMag - lower->absMag) * t;
+
+    if (absMag > mainSequenceMag + 4.0f && *bpRp < 1.0f)
+    {
+        return StellarClass(StellarClass::WhiteDwarf, StellarClass::Spectral_DA,
+                            StellarClass::Subclass_Unknown, StellarClass::Lum_Unknown);
+    }
+
+    StellarClass::LuminosityClass lum = StellarClass::Lum_V;
+    if (absMag < mainSequenceMag - 6.0f)
+        lum = StellarClass::Lum_Ib;
+    else if (absMag < mainSequenceMag - 2.5f)
+        lum = StellarClass::Lum_III;
+
+    return StellarClass(StellarClass::NormalStar,
+                        static_cast<StellarClass::SpectralClass>(type / 10),
+                        type % 10,
+                        lum);
+}
+
+struct GaiaStar
+{
+    std::uint64_t sourceId;
+    Eigen::Vector3f position;
+    float absMag;
+    std::uint16_t spectralType;
+};
+
+struct ParsedChunk
+{
+    std::vector<GaiaStar> stars;
+    std::uint64_t rowCount{ 0 };
+    std::string error;
+};
+
+// Convert the rows of a chunk of whole lines, keeping the stars with a
+// significant parallax
+void
+parseChunk(const char* ptr, const char* end, const Columns& columns, double minParallaxOverError, ParsedChunk& chunk)
+{
+    std::vector<std::string_view> fields;
+    fields.reserve(static_cast<std::size_t>(columns.count));
+    while (ptr != end)
+    {
+        const char* lineEnd = std::find(ptr, end, '\n');
+        std::string_view line(ptr, static_cast<std::size_t>(lineEnd - ptr));
+        ptr = lineEnd == end ? end : lineEnd + 1;
+
+        if (!line.empty() && line.back() == '\r')
+            line.remove_suffix(1);
+        if (line.empty())
+            continue;
+
+        splitFields(line, fields);
+        if (fields.size() != static_cast<std::size_t>(columns.count))
+        {
+            chunk.error = "Wrong number of fields in line: " + std::string(line.substr(0, 80));
+            return;
+        }
+
+        ++chunk.rowCount;
+
+        auto sourceId = parseField<std::uint64_t>(fields[columns.sourceId]);
+        auto ra = parseField<double>(fields[columns.ra]);
+        auto dec = parseField<double>(fields[columns.dec]);
+        auto parallax = parseField<double>(fields[columns.parallax]);
+        auto gMag = parseField<float>(fields[columns.gMag]);
+        if (!sourceId.has_value() || !ra.has_value() || !dec.has_value() ||
+            !parallax.has_value() || *parallax <= 0.0 || !gMag.has_value())
+        {
+            continue;
+        }
+
+        std::optional<double> parallaxOverError;
+        if (columns.parallaxOverError >= 0)
+        {
+            parallaxOverError = parseField<double>(fields[columns.parallaxOverError]);
+        }
+        else if (auto parallaxError = parseField<double>(fields[columns.parallaxError]);
+                 parallaxError.has_value() && *parallaxError > 0.0)
+        {
+            parallaxOverError = *parallax / *parallaxError;
+        }
+
+        if (!parallaxOverError.has_value() || *parallaxOverError < minParallaxOverError)
+            continue;
+
+        // Parallaxes are in milliarcseconds
+        double distance = astro::parsecsToLightYears(1000.0 / *parallax);
+        auto absMag = static_cast<float>(*gMag + 5.0 * std::log10(*parallax) - 10.0);
+        std::optional<float> bpRp;
+        if (columns.bpRp >= 0)
+            bpRp = parseField<float>(fields[columns.bpRp]);
+
+        GaiaStar& star = chunk.stars.emplace_back();
+        star.sourceId = *sourceId;
+        star.position = astro::equatorialToCelestialCart(*ra / 15.0, *dec, distance).cast<float>();
+        star.absMag = absMag;
+        star.spectralType = estimateClass(bpRp, absMag).packV1();
+    }
+}
+
+class Ingester
+{
+public:
+    Ingester(const Options& options) : m_options(options), m_nextNumber(options.firstNumber) {}
+
+    bool open();
+    bool process(std::istream& in, const std::string& name);
+    bool finish();
+
+private:
+    bool store(const std::vector<ParsedChunk>&);
+
+    const Options& m_options;
+    std::ofstream m_stardb;
+    std::ofstream m_sourceIds;
+    std::vector<engine::PagedStarRecord> m_pagedRecords;
+    AstroCatalog::IndexNumber m_nextNumber;
+    std::uint64_t m_rowCount{ 0 };
+    std::uint32_t m_starCount{ 0 };
+};
+
+bool
+Ingester::open()
+{
+    if (!m_options.stardbFilename.empty())
+    {
+        m_stardb.open(fs::u8path(m_options.stardbFilename), std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!m_stardb.good())
+        {
+            std::cerr << "Error opening star database file " << m_options.stardbFilename << '\n';
+            return false;
+        }
+
+        // The count is written again at the end
+        writeStarsHeader(m_stardb, 0);
+    }
+
+    if (!m_options.sourceIdFilename.empty())
+    {
+        m_sourceIds.open(fs::u8path(m_options.sourceIdFilename), std::ios::out | std::ios::trunc);
+        if (!m_sourceIds.good())
+        {
+            std::cerr << "Error opening source id file " << m_options.sourceIdFilename << '\n';
+            return false;
+        }
+
+        m_sourceIds << "catalog_number,source_id\n";
+    }
+
+    return true;
+}
+
+// Parse the rows in windows, each split across the threads, and store the
+// stars in input order
+bool
+Ingester::process(std::istream& in, const std::string& name)
+{
+    Columns columns;
+    std::string line;
+    bool hasHeader = false;
+    while (std::getline(in, line))
+    {
+        // ECSV metadata
+        if (line.empty() || line[0] == '#')
+            continue;
+        hasHeader = parseHeader(line, columns);
+        break;
+    }
+
+    if (!hasHeader)
+    {
+        std::cerr << "Missing or incomplete column header in " << name << '\n';
+        return false;
+    }
+
+    util::ThreadPool* threadPool = util::GetThreadPool();
+    const std::size_t taskCount = static_cast<std::size_t>(threadPool->threadCount()) + 1;
+    std::vector<ParsedChunk> chunks(taskCount);
+    std::vector<const char*> bounds(taskCount + 1);
+
+    std::vector<char> buffer(WindowSize);
+    std::size_t carried = 0;
+    for (;;)
+    {
+        in.read(buffer.data() + carried, static_cast<std::streamsize>(buffer.size() - carried)); /* Flawfinder: ignore */
+        std::size_t size = carried + static_cast<std::size_t>(in.gcount());
+        if (size == 0)
+            break;
+
+        // Parse up to the last whole line, unless the input has ended
+        const char* begin = buffer.data();
+        const char* end = begin + size;
+        const char* windowEnd = end;
+        if (in.good())
+        {
+            const char* lastNewline = end;
+            while (lastNewline != begin && lastNewline[-1] != '\n')
+                --lastNewline;
+            if (lastNewline == begin)
+            {
+                // A line longer than the window, grow it
+                carried = size;
+                buffer.resize(buffer.size() * 2);
+                continue;
+            }
+            windowEnd = lastNewline;
+        }
+
+        bounds[0] = begin;
+        for (std::size_t i = 1; i < taskCount; ++i)
+        {
+            auto offset = static_cast<std::size_t>(windowEnd - begin) * i / taskCount;
+            bounds[i] = std::max(bounds[i - 1], nextLine(begin + offset, windowEnd));
+        }
+        bounds[taskCount] = windowEnd;
+
+        double minParallaxOverError = m_options.minParallaxOverError;
+        threadPool->parallelFor(taskCount, [&](std::size_t i)
+        {
+            chunks[i] = ParsedChunk();
+            parseChunk(bounds[i], bounds[i + 1], columns, minParallaxOverError, chunks[i]);
+        });
+
+        for (const ParsedChunk& chunk : chunks)
+        {
+            if (!chunk.error.empty())
+            {
+                std::cerr << name << ": " << chunk.error << '\n';
+                return false;
+            }
+        }
+
+        if (!store(chunks))
+            return false;
+
+        carried = static_cast<std::size_t>(end - windowEnd);
+        std::memmove(buffer.data(), windowEnd, carried);
+        if (!in.good())
+            break;
+    }
+
+    if (in.bad())
+    {
+        std::cerr << "Error reading " << name << '\n';
+        return false;
+    }
+
+    std::cout << name << ": " << m_rowCount << " rows, " << m_starCount << " stars selected so far\n";
+    return true;
+}
+
+bool
+Ingester::store(const std::vector<ParsedChunk>& chunks)
+{
+    for (const ParsedChunk& chunk : chunks)
+    {
+        m_rowCount += chunk.rowCount;
+        if (chunk.stars.size() > static_cast<std::size_t>(LastFreeNumber - m_nextNumber) + 1)
+        {
+            std::cerr << "Too many stars for the catalog numbers below " << LastFreeNumber + 1 << '\n';
+            return false;
+        }
+
+        for (const GaiaStar& star : chunk.stars)
+        {
+            AstroCatalog::IndexNumber catalogNumber = m_nextNumber++;
+            if (m_stardb.is_open())
+            {
+                util::writeLE(m_stardb, catalogNumber);
+                util::writeLE(m_stardb, star.position.x());
+                util::writeLE(m_stardb, star.position.y());
+                util::writeLE(m_stardb, star.position.z());
+                util::writeLE(m_stardb, static_cast<std::int16_t>(std::clamp(star.absMag * 256.0f, -32768.0f, 32767.0f)));
+                util::writeLE(m_stardb, star.spectralType);
+            }
+
+            if (m_sourceIds.is_open())
+                m_sourceIds << catalogNumber << ',' << star.sourceId << '\n';
+
+            if (!m_options.pagedFilename.empty())
+                m_pagedRecords.push_back({ catalogNumber, star.position, star.absMag, star.spectralType });
+        }
+
+        m_starCount += static_cast<std::uint32_t>(chunk.stars.size());
+    }
+
+    if ((m_stardb.is_open() && !m_stardb.good()) || (m_sourceIds.is_open() && !m_sourceIds.good()))
+    {
+        std::cerr << "Error writing output files\n";
+        return false;
+    }
+
+    return true;
+}
+
+bool
+Ingester::finish()
+{
+    std::cout << "Selected " << m_starCount << " of " << m_rowCount << " rows\n";
+
+    if (m_stardb.is_open())
+    {
+        m_stardb.seekp(0);
+        writeStarsHeader(m_stardb, m_starCount);
+        if (!m_stardb.flush().good())
+        {
+            std::cerr << "Error writing star database file " << m_options.stardbFilename << '\n';
+            return false;
+        }
+    }
+
+    if (m_sourceIds.is_open() && !m_sourceIds.flush().good())
+    {
+        std::cerr << "Error writing source id file " << m_options.sourceIdFilename << '\n';
+        return false;
+    }
+
+    if (!m_options.pagedFilename.empty() &&
+        !engine::PagedStarCatalog::write(fs::u8path(m_options.pagedFilename), std::move(m_pagedRecords)))
+    {
+        std::cerr << "Error writing paged star catalog " << m_options.pagedFilename << '\n';
+        return false;
+    }
+
+    return true;
+}
+
+} // end unnamed namespace
+
+int
+main(int argc, char* argv[])
+{
+    Options options;
+    if (!parseCommandLine(argc, argv, options))
+    {
+        Usage();
+        return 1;
+    }
+
+    util::CreateLogger();
+
+    Ingester ingester(options);
+    if (!ingester.open())
+        return 1;
+
+    for (const std::string& input : options.inputs)
+    {
+        if (input == "-")
+        {
+            if (!ingester.process(std::cin, "standard input"))
+                return 1;
+            continue;
+        }
+
+        std::ifstream in(fs::u8path(input), std::ios::in | std::ios::binary);
+        if (!in.good())
+        {
+            std::cerr << "Error opening input file " << input << '\n';
+            return 1;
+        }
+
+        if (!ingester.process(in, input))
+            return 1;
+    }
+
+    return ingester.finish() ? 0 : 1;
+}
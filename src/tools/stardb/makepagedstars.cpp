@@ -0,0 +1,115 @@
+// makepagedstars.cpp
+//
+// Copyright (C) 2024, Celestia Development Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// Convert a binary star database (stars.dat format) to a paged star catalog
+
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <celcompat/filesystem.h>
+#include <celengine/pagedstarcatalog.h>
+#include <celutil/binaryread.h>
+
+namespace engine = celestia::engine;
+namespace util = celestia::util;
+
+using namespace std::string_view_literals;
+
+namespace
+{
+
+constexpr std::string_view StarsDatMagic = "CELSTARS"sv;
+constexpr std::uint16_t StarsDatVersion = 0x0100;
+
+void
+Usage()
+{
+    std::cerr << "Usage: makepagedstars <star database file> <output file>\n";
+}
+
+bool
+readStars(std::istream& in, std::vector<engine::PagedStarRecord>& records)
+{
+    std::array<char, 8> magic;
+    if (!in.read(magic.data(), magic.size()).good() || /* Flawfinder: ignore */
+        std::string_view(magic.data(), magic.size()) != StarsDatMagic)
+    {
+        std::cerr << "Missing header in star database\n";
+        return false;
+    }
+
+    std::uint16_t version;
+    std::uint32_t starCount;
+    if (!util::readLE(in, version) || version != StarsDatVersion || !util::readLE(in, starCount))
+    {
+        std::cerr << "Unsupported star database version\n";
+        return false;
+    }
+
+    records.reserve(starCount);
+    for (std::uint32_t i = 0; i < starCount; ++i)
+    {
+        engine::PagedStarRecord& record = records.emplace_back();
+        std::int16_t absMag;
+        if (!util::readLE(in, record.catalogNumber) ||
+            !util::readLE(in, record.position.x()) ||
+            !util::readLE(in, record.position.y()) ||
+            !util::readLE(in, record.position.z()) ||
+            !util::readLE(in, absMag) ||
+            !util::readLE(in, record.spectralType))
+        {
+            std::cerr << "Error reading star " << i << '\n';
+            return false;
+        }
+
+        record.absMag = static_cast<float>(absMag) / 256.0f;
+    }
+
+    return true;
+}
+
+} // end unnamed namespace
+
+int
+main(int argc, char* argv[])
+{
+    if (argc != 3)
+    {
+        Usage();
+        return 1;
+    }
+
+    std::vector<engine::PagedStarRecord> records;
+    {
+        std::ifstream in(fs::u8path(argv[1]), std::ios::binary);
+        if (!in.good())
+        {
+            std::cerr << "Error opening " << argv[1] << '\n';
+            return 1;
+        }
+
+        if (!readStars(in, records))
+            return 1;
+    }
+
+    std::cout << "Read " << records.size() << " stars\n";
+
+    if (!engine::PagedStarCatalog::write(fs::u8path(argv[2]), std::move(records)))
+    {
+        std::cerr << "Error writing " << argv[2] << '\n';
+        return 1;
+    }
+
+    return 0;
+}
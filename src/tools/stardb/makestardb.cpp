@@ -9,234 +9,359 @@
 //
 // Convert a file with ASCII star records to a Celestia star database
 
-#include <iostream>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <fstream>
-#include <iomanip>
-#include <cctype>
-#include <cassert>
-#include <celastro/astro.h>
-#include <celutil/bytes.h>
-#include <celengine/star.h>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
 
-using namespace std;
+#include <celastro/astro.h>
+#include <celcompat/bit.h>
+#include <celcompat/filesystem.h>
+#include <celengine/stardb.h>
+#include <celengine/stardbbuilder.h>
+#include <celengine/stellarclass.h>
+#include <celutil/logger.h>
+#include <celutil/mappedfile.h>
+#include <celutil/threadpool.h>
+#include "stardbtext.h"
 
 namespace astro = celestia::astro;
+namespace compat = celestia::compat;
+namespace util = celestia::util;
+
+using stardbtools::nextLine;
+using stardbtools::nextToken;
+using stardbtools::parseNumber;
+using stardbtools::writeStarsHeader;
 
-static string inputFilename;
-static string outputFilename;
-static bool useSphericalCoords = false;
+namespace
+{
 
+// Size of a stars.dat record: catalog number, position, magnitude and
+// packed spectral type
+constexpr std::size_t RecordSize = 20;
 
-void Usage()
+// The input is parsed in windows of this size, each split into a chunk per
+// thread, so that large catalogs needn't be held in memory
+constexpr std::size_t WindowSize = 64 * 1024 * 1024;
+
+std::string inputFilename;
+std::string outputFilename;
+bool useSphericalCoords = false;
+bool useOctreeOrder = false;
+
+void
+Usage()
 {
-    cerr << "Usage: makestardb [options] <input file> <output star database>\n";
-    cerr << "  Options:\n";
-    cerr << "    --spherical (or -s) : input file has spherical coords (RA/dec/distance\n";
+    std::cerr << "Usage: makestardb [options] <input file> <output star database>\n";
+    std::cerr << "  Options:\n";
+    std::cerr << "    --spherical (or -s) : input file has spherical coords (RA/dec/distance\n";
+    std::cerr << "    --octree-order (or -o) : write the stars in the order of the star octree\n";
+    std::cerr << "                             built at load time, dropping invalid stars\n";
+    std::cerr << "  Each star record must be on a line of its own.\n";
 }
 
-
-bool parseCommandLine(int argc, char* argv[])
+bool
+parseCommandLine(int argc, char* argv[])
 {
-    int i = 1;
     int fileCount = 0;
-
-    while (i < argc)
+    for (int i = 1; i < argc; i++)
     {
         if (argv[i][0] == '-')
         {
-            if (!strcmp(argv[i], "--spherical") || !strcmp(argv[i], "-s"))
+            if (!std::strcmp(argv[i], "--spherical") || !std::strcmp(argv[i], "-s"))
             {
                 useSphericalCoords = true;
             }
+            else if (!std::strcmp(argv[i], "--octree-order") || !std::strcmp(argv[i], "-o"))
+            {
+                useOctreeOrder = true;
+            }
             else
             {
-                cerr << "Unknown command line switch: " << argv[i] << '\n';
+                std::cerr << "Unknown command line switch: " << argv[i] << '\n';
                 return false;
             }
-            i++;
+        }
+        else if (fileCount == 0)
+        {
+            // input filename first
+            inputFilename = std::string(argv[i]);
+            fileCount++;
+        }
+        else if (fileCount == 1)
+        {
+            // output filename second
+            outputFilename = std::string(argv[i]);
+            fileCount++;
         }
         else
         {
-            if (fileCount == 0)
-            {
-                // input filename first
-                inputFilename = string(argv[i]);
-                fileCount++;
-            }
-            else if (fileCount == 1)
-            {
-                // output filename second
-                outputFilename = string(argv[i]);
-                fileCount++;
-            }
-            else
-            {
-                // more than two filenames on the command line is an error
-                return false;
-            }
-            i++;
+            // more than two filenames on the command line is an error
+            return false;
         }
     }
 
-    return true;
+    return fileCount == 2;
 }
 
-
-static void writeUint(ostream& out, uint32_t n)
+template<typename T>
+void
+appendLE(std::string& out, T value)
 {
-    LE_TO_CPU_INT32(n, n);
-    out.write(reinterpret_cast<const char*>(&n), sizeof n);
+    std::array<char, sizeof(T)> bytes;
+    std::memcpy(bytes.data(), &value, sizeof(T));
+    if constexpr (compat::endian::native != compat::endian::little)
+        std::reverse(bytes.begin(), bytes.end());
+    out.append(bytes.data(), bytes.size());
 }
 
-static void writeFloat(ostream& out, float f)
+template<typename T>
+T
+recordField(const char* record, std::size_t offset)
 {
-    LE_TO_CPU_FLOAT(f, f);
-    out.write(reinterpret_cast<const char*>(&f), sizeof f);
+    std::array<char, sizeof(T)> bytes;
+    std::memcpy(bytes.data(), record + offset, sizeof(T));
+    if constexpr (compat::endian::native != compat::endian::little)
+        std::reverse(bytes.begin(), bytes.end());
+
+    T value;
+    std::memcpy(&value, bytes.data(), sizeof(T));
+    return value;
 }
 
-static void writeUshort(ostream& out, uint16_t n)
+struct ParsedChunk
 {
-    LE_TO_CPU_INT16(n, n);
-    out.write(reinterpret_cast<const char*>(&n), sizeof n);
-}
-
-static void writeShort(ostream& out, int16_t n)
+    std::string records;
+    std::uint32_t count{ 0 };
+    std::string error;
+};
+
+// Convert the records of a chunk of whole lines to stars.dat records
+void
+parseChunk(const char* ptr, const char* end, bool sphericalCoords, ParsedChunk& chunk)
 {
-    LE_TO_CPU_INT16(n, n);
-    out.write(reinterpret_cast<const char*>(&n), sizeof n);
-}
+    chunk.records.reserve(static_cast<std::size_t>(end - ptr) / 2);
+    for (;;)
+    {
+        std::string_view token = nextToken(ptr, end);
+        if (token.empty())
+            return;
+
+        std::uint32_t catalogNumber;
+        if (!parseNumber(token, catalogNumber))
+        {
+            chunk.error = "Error parsing catalog number " + std::string(token);
+            return;
+        }
+
+        float values[4];
+        for (float& value : values)
+        {
+            if (!parseNumber(nextToken(ptr, end), value))
+            {
+                chunk.error = "Error parsing star " + std::to_string(catalogNumber);
+                return;
+            }
+        }
+
+        float x = values[0];
+        float y = values[1];
+        float z = values[2];
+        float absMag = values[3];
+        if (sphericalCoords)
+        {
+            float distance = values[2];
+            Eigen::Vector3d pos = astro::equatorialToCelestialCart(static_cast<double>(values[0]) * 24.0 / 360.0,
+                                                                   static_cast<double>(values[1]),
+                                                                   static_cast<double>(distance));
+            x = static_cast<float>(pos.x());
+            y = static_cast<float>(pos.y());
+            z = static_cast<float>(pos.z());
+            absMag = static_cast<float>(values[3] + 5 - 5 * std::log10(distance / 3.26));
+        }
 
+        StellarClass sc = StellarClass::parse(nextToken(ptr, end));
 
-bool WriteStarDatabase(istream& in, ostream& out, bool sphericalCoords)
+        appendLE(chunk.records, catalogNumber);
+        appendLE(chunk.records, x);
+        appendLE(chunk.records, y);
+        appendLE(chunk.records, z);
+        appendLE(chunk.records, static_cast<std::int16_t>(absMag * 256.0f));
+        appendLE(chunk.records, sc.packV1());
+        ++chunk.count;
+    }
+}
+
+// Parse the records in windows, each split across the threads, and write
+// them in input order. If records is not null, they are also kept there.
+bool
+WriteStarDatabase(std::string_view input, std::ostream& out, bool sphericalCoords, std::string* records)
 {
-    unsigned int nStarsInFile = 0;
+    const char* ptr = input.data();
+    const char* end = input.data() + input.size();
 
-    in >> nStarsInFile;
-    if (!in.good())
+    std::uint32_t nStarsInFile = 0;
+    if (!parseNumber(nextToken(ptr, end), nStarsInFile))
     {
-        cerr << "Error reading star count at beginning of input file.\n";
-        return 1;
+        std::cerr << "Error reading star count at beginning of input file.\n";
+        return false;
     }
 
-    // Write the header
-    out.write("CELSTARS", 8);
-
-    // Write the version
-    writeShort(out, 0x0100);
+    // The count is written again once the records have been parsed
+    writeStarsHeader(out, nStarsInFile);
 
-    writeUint(out, nStarsInFile);
+    util::ThreadPool* threadPool = util::GetThreadPool();
+    const std::size_t taskCount = static_cast<std::size_t>(threadPool->threadCount()) + 1;
+    std::vector<ParsedChunk> chunks(taskCount);
+    std::vector<const char*> bounds(taskCount + 1);
 
-    for (unsigned int record = 0; record < nStarsInFile; record++)
+    std::uint32_t nStarsWritten = 0;
+    while (ptr != end && nStarsWritten < nStarsInFile)
     {
-        unsigned int catalogNumber;
-        float x, y, z;
-        float absMag;
-
-        in >> catalogNumber;
-        if (in.eof())
-            return true;
+        const char* windowEnd = static_cast<std::size_t>(end - ptr) > WindowSize
+            ? nextLine(ptr + WindowSize, end)
+            : end;
 
-        if (!in.good())
+        bounds[0] = ptr;
+        for (std::size_t i = 1; i < taskCount; ++i)
         {
-            cerr << "Error parsing catalog number for record #" << record << '\n';
-            return false;
+            auto offset = static_cast<std::size_t>(windowEnd - ptr) * i / taskCount;
+            bounds[i] = std::max(bounds[i - 1], nextLine(ptr + offset, windowEnd));
         }
+        bounds[taskCount] = windowEnd;
 
-        if (sphericalCoords)
+        threadPool->parallelFor(taskCount, [&](std::size_t i)
         {
-            float RA, dec, distance;
-            float appMag;
+            chunks[i] = ParsedChunk();
+            parseChunk(bounds[i], bounds[i + 1], sphericalCoords, chunks[i]);
+        });
 
-            in >> RA >> dec >> distance;
-            if (!in.good())
+        for (const ParsedChunk& chunk : chunks)
+        {
+            // Records beyond the count at the beginning are ignored
+            std::uint32_t count = std::min(chunk.count, nStarsInFile - nStarsWritten);
+            out.write(chunk.records.data(), static_cast<std::streamsize>(count * RecordSize));
+            if (records != nullptr)
+                records->append(chunk.records.data(), count * RecordSize);
+            nStarsWritten += count;
+
+            if (!chunk.error.empty() && nStarsWritten < nStarsInFile)
             {
-                cerr << "Error parsing position of star " << catalogNumber << '\n';
+                std::cerr << chunk.error << '\n';
                 return false;
             }
+        }
 
-            in >> appMag;
-            if (!in.good())
-            {
-                cerr << "Error parsing magnitude of star " << catalogNumber << '\n';
-                return false;
-            }
+        ptr = windowEnd;
+    }
 
-            Eigen::Vector3d pos =
-                astro::equatorialToCelestialCart((double) RA * 24.0 / 360.0,
-                                                 (double) dec,
-                                                 (double) distance);
-            x = (float) pos.x();
-            y = (float) pos.y();
-            z = (float) pos.z();
-            absMag = (float) (appMag + 5 - 5 * log10(distance / 3.26));
-        }
-        else
-        {
-            in >> x >> y >> z;
-            if (!in.good())
-            {
-                cerr << "Error parsing position of star " << catalogNumber << '\n';
-                return false;
-            }
+    if (nStarsWritten < nStarsInFile)
+    {
+        std::cerr << "Only " << nStarsWritten << " of " << nStarsInFile << " stars found in input file\n";
+        out.seekp(0);
+        writeStarsHeader(out, nStarsWritten);
+    }
 
-            in >> absMag;
-            if (!in.good())
-            {
-                cerr << "Error parsing magnitude of star " << catalogNumber << '\n';
-                return false;
-            }
-        }
+    return out.good();
+}
 
-        string scString;
-        in >> scString;
-        StellarClass sc = StellarClass::parse(scString);
-#if 0
-        StarDetails* details = StarDetails::GetStarDetails(sc);
-        if (details == NULL)
-        {
-            cerr << "Error parsing spectral type of star " << catalogNumber << '\n';
-            return false;
-        }
+// Write the database again with the records in the order in which
+// StarDatabaseBuilder places the stars into the octree, so that loading it
+// reads them in the order they are kept in
+bool
+WriteOctreeOrder(const std::string& records, const fs::path& path)
+{
+    StarDatabaseBuilder builder;
+    if (!builder.loadBinary(path))
+    {
+        std::cerr << "Error reading back " << path << '\n';
+        return false;
+    }
+
+    std::unique_ptr<StarDatabase> starDB = builder.finish();
+
+    // Records by catalog number; duplicates are taken in input order
+    std::vector<std::pair<std::uint32_t, std::size_t>> index;
+    index.reserve(records.size() / RecordSize);
+    for (std::size_t offset = 0; offset < records.size(); offset += RecordSize)
+        index.emplace_back(recordField<std::uint32_t>(records.data() + offset, 0), offset);
+    std::stable_sort(index.begin(), index.end(),
+                     [](const auto& a, const auto& b) { return a.first < b.first; });
+    std::vector<bool> used(index.size(), false);
 
-        // For spectral type parser debugging . . .
-        cout << scString << ' ' << details->getSpectralType() << '\n';
-#endif
+    std::string sorted;
+    sorted.reserve(records.size());
+    for (std::uint32_t i = 0; i < starDB->size(); ++i)
+    {
+        std::uint32_t catalogNumber = starDB->getStar(i)->getIndex();
+        auto it = std::lower_bound(index.begin(), index.end(), catalogNumber,
+                                   [](const auto& entry, std::uint32_t n) { return entry.first < n; });
+        while (it != index.end() && it->first == catalogNumber && used[it - index.begin()])
+            ++it;
+        if (it == index.end() || it->first != catalogNumber)
+            continue;
+
+        used[it - index.begin()] = true;
+        sorted.append(records, it->second, RecordSize);
+    }
 
-        writeUint(out, catalogNumber);
-        writeFloat(out, x);
-        writeFloat(out, y);
-        writeFloat(out, z);
-        writeShort(out, (int16_t) (absMag * 256.0f));
-        writeUshort(out, sc.packV1());
+    std::ofstream out(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    writeStarsHeader(out, static_cast<std::uint32_t>(sorted.size() / RecordSize));
+    out.write(sorted.data(), static_cast<std::streamsize>(sorted.size()));
+    if (!out.good())
+    {
+        std::cerr << "Error writing star database file " << path << '\n';
+        return false;
     }
 
     return true;
 }
 
+} // end unnamed namespace
 
-int main(int argc, char* argv[])
+int
+main(int argc, char* argv[])
 {
-    if (!parseCommandLine(argc, argv) || inputFilename.empty())
+    if (!parseCommandLine(argc, argv))
     {
         Usage();
         return 1;
     }
 
-    ifstream inputFile(inputFilename, ios::in);
-    if (!inputFile.good())
+    auto inputFile = util::MappedFile::open(fs::u8path(inputFilename));
+    if (inputFile == nullptr)
     {
-        cerr << "Error opening input file " << inputFilename << '\n';
+        std::cerr << "Error opening input file " << inputFilename << '\n';
         return 1;
     }
 
-    ofstream stardbFile(outputFilename, ios::out | ios::binary);
-    if (!stardbFile.good())
+    std::string records;
     {
-        cerr << "Error opening star database file " << outputFilename << '\n';
-        return 1;
+        std::ofstream stardbFile(fs::u8path(outputFilename), std::ios::out | std::ios::binary);
+        if (!stardbFile.good())
+        {
+            std::cerr << "Error opening star database file " << outputFilename << '\n';
+            return 1;
+        }
+
+        std::string_view input(inputFile->data(), inputFile->size());
+        if (!WriteStarDatabase(input, stardbFile, useSphericalCoords, useOctreeOrder ? &records : nullptr))
+            return 1;
     }
 
-    bool success = WriteStarDatabase(inputFile, stardbFile, useSphericalCoords);
+    if (!useOctreeOrder)
+        return 0;
 
-    return success ? 0 : 1;
+    util::CreateLogger();
+    return WriteOctreeOrder(records, fs::u8path(outputFilename)) ? 0 : 1;
 }
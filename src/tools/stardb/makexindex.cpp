@@ -9,139 +9,410 @@
 //
 // Convert an ASCII cross index to binary
 
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <fstream>
-#include <iomanip>
+#include <functional>
 #include <iostream>
+#include <iterator>
+#include <memory>
 #include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
 
-#include <celutil/bytes.h>
+#include <celcompat/bit.h>
+#include <celcompat/filesystem.h>
+#include <celengine/starname.h>
+#include <celutil/binarywrite.h>
+#include <celutil/mappedfile.h>
+#include <celutil/threadpool.h>
+#include "stardbtext.h"
 
+namespace compat = celestia::compat;
+namespace util = celestia::util;
 
-static std::string inputFilename;
-static std::string outputFilename;
+using stardbtools::nextLine;
+using stardbtools::nextToken;
+using stardbtools::parseNumber;
 
+namespace
+{
+
+using CrossIndexEntries = std::vector<std::pair<std::uint32_t, std::uint32_t>>;
+
+// Size of the stars.dat header and records
+constexpr std::size_t StarsHeaderSize = 14;
+constexpr std::size_t StarsRecordSize = 20;
+
+// Sorting is only split across the threads for at least this many items
+// per thread
+constexpr std::size_t MinItemsPerTask = 16384;
 
-void Usage()
+std::string inputFilename;
+std::string outputFilename;
+std::string starsFilename;
+bool writeVersion1 = false;
+
+void
+Usage()
 {
-    std::cerr << "Usage: makexindex [input file] [output file]\n";
+    std::cerr << "Usage: makexindex [options] [input file] [output file]\n";
+    std::cerr << "  Options:\n";
+    std::cerr << "    --version1 (or -1) : write an unsorted index readable by older versions\n";
+    std::cerr << "    --stars <stars.dat> (or -s) : drop entries of stars missing from the\n";
+    std::cerr << "                                  star database\n";
+    std::cerr << "  Each pair of catalog numbers must be on a line of its own.\n";
 }
 
-
-bool parseCommandLine(int argc, char* argv[])
+bool
+parseCommandLine(int argc, char* argv[])
 {
-    int i = 1;
     int fileCount = 0;
-
-    while (i < argc)
+    for (int i = 1; i < argc; i++)
     {
-        if (argv[i][0] == '-')
+        if (argv[i][0] == '-' && argv[i][1] != '\0')
         {
-            std::cerr << "Unknown command line switch: " << argv[i] << '\n';
-            return false;
-        }
-        else
-        {
-            if (fileCount == 0)
+            if (!std::strcmp(argv[i], "--version1") || !std::strcmp(argv[i], "-1"))
             {
-                // input filename first
-                inputFilename = std::string(argv[i]);
-                fileCount++;
+                writeVersion1 = true;
             }
-            else if (fileCount == 1)
+            else if (!std::strcmp(argv[i], "--stars") || !std::strcmp(argv[i], "-s"))
             {
-                // output filename second
-                outputFilename = std::string(argv[i]);
-                fileCount++;
+                if (++i == argc)
+                    return false;
+                starsFilename = argv[i];
             }
             else
             {
-                // more than two filenames on the command line is an error
+                std::cerr << "Unknown command line switch: " << argv[i] << '\n';
                 return false;
             }
-            i++;
+        }
+        else if (fileCount == 0)
+        {
+            // input filename first
+            inputFilename = std::string(argv[i]);
+            fileCount++;
+        }
+        else if (fileCount == 1)
+        {
+            // output filename second
+            outputFilename = std::string(argv[i]);
+            fileCount++;
+        }
+        else
+        {
+            // more than two filenames on the command line is an error
+            return false;
         }
     }
 
     return true;
 }
 
+std::size_t
+getTaskCount(std::size_t count)
+{
+    return std::min(static_cast<std::size_t>(util::GetThreadPool()->threadCount()) + 1,
+                    count / MinItemsPerTask);
+}
 
-static void writeUint(std::ostream& out, std::uint32_t n)
+// Sort ranges of the items on the threads of the pool, then merge them
+template<typename T, typename Compare> void
+parallelSort(std::vector<T>& items, const Compare& compare)
 {
-    LE_TO_CPU_INT32(n, n);
-    out.write(reinterpret_cast<const char*>(&n), sizeof n);
+    std::size_t taskCount = getTaskCount(items.size());
+    if (taskCount <= 1)
+    {
+        std::sort(items.begin(), items.end(), compare);
+        return;
+    }
+
+    std::vector<std::size_t> bounds(taskCount + 1);
+    for (std::size_t i = 0; i <= taskCount; i++)
+        bounds[i] = items.size() * i / taskCount;
+
+    util::ThreadPool* pool = util::GetThreadPool();
+    pool->parallelFor(taskCount, [&](std::size_t task)
+    {
+        std::sort(items.begin() + bounds[task], items.begin() + bounds[task + 1], compare);
+    });
+
+    while (bounds.size() > 2)
+    {
+        pool->parallelFor((bounds.size() - 1) / 2, [&](std::size_t pair)
+        {
+            std::inplace_merge(items.begin() + bounds[pair * 2],
+                               items.begin() + bounds[pair * 2 + 1],
+                               items.begin() + bounds[pair * 2 + 2],
+                               compare);
+        });
+
+        std::vector<std::size_t> merged;
+        for (std::size_t i = 0; i < bounds.size(); i += 2)
+            merged.push_back(bounds[i]);
+        if (merged.back() != items.size())
+            merged.push_back(items.size());
+        bounds = std::move(merged);
+    }
 }
 
+struct ParsedChunk
+{
+    CrossIndexEntries entries;
+    std::string error;
+};
 
-static void writeShort(std::ostream& out, std::int16_t n)
+// Parse the pairs of catalog numbers in a chunk of whole lines
+void
+parseChunk(const char* ptr, const char* end, ParsedChunk& chunk)
 {
-    LE_TO_CPU_INT16(n, n);
-    out.write(reinterpret_cast<const char*>(&n), sizeof n);
-}
+    for (;;)
+    {
+        std::string_view token = nextToken(ptr, end);
+        if (token.empty())
+            return;
+
+        std::uint32_t catalogNumber;
+        std::uint32_t celCatalogNumber;
+        if (!parseNumber(token, catalogNumber))
+        {
+            chunk.error = "Error parsing catalog number " + std::string(token);
+            return;
+        }
 
+        if (!parseNumber(nextToken(ptr, end), celCatalogNumber))
+        {
+            chunk.error = "Error parsing record of catalog number " + std::to_string(catalogNumber);
+            return;
+        }
+
+        chunk.entries.emplace_back(catalogNumber, celCatalogNumber);
+    }
+}
 
-bool WriteCrossIndex(std::istream& in, std::ostream& out)
+// Parse the input split into a chunk per thread, keeping the input order
+bool
+parseCrossIndex(std::string_view input, CrossIndexEntries& entries)
 {
-    // Write the header
-    out.write("CELINDEX", 8);
+    const char* ptr = input.data();
+    const char* end = input.data() + input.size();
 
-    // Write the version
-    writeShort(out, 0x0100);
+    util::ThreadPool* threadPool = util::GetThreadPool();
+    const std::size_t taskCount = static_cast<std::size_t>(threadPool->threadCount()) + 1;
+    std::vector<ParsedChunk> chunks(taskCount);
+    std::vector<const char*> bounds(taskCount + 1);
 
-    unsigned int record = 0;
-    while (!in.eof())
+    bounds[0] = ptr;
+    for (std::size_t i = 1; i < taskCount; ++i)
     {
-        std::uint32_t catalogNumber;
-        std::uint32_t celCatalogNumber;
+        auto offset = static_cast<std::size_t>(end - ptr) * i / taskCount;
+        bounds[i] = std::max(bounds[i - 1], nextLine(ptr + offset, end));
+    }
+    bounds[taskCount] = end;
 
-        in >> catalogNumber;
-        if (in.eof())
-            return true;
+    threadPool->parallelFor(taskCount, [&](std::size_t i)
+    {
+        chunks[i].entries.reserve(static_cast<std::size_t>(bounds[i + 1] - bounds[i]) / 12);
+        parseChunk(bounds[i], bounds[i + 1], chunks[i]);
+    });
 
-        in >> celCatalogNumber;
-        if (!in.good())
+    for (ParsedChunk& chunk : chunks)
+    {
+        entries.insert(entries.end(), chunk.entries.begin(), chunk.entries.end());
+        if (!chunk.error.empty())
         {
-            std::cerr << "Error parsing record #" << record << '\n';
+            std::cerr << chunk.error << " (record #" << entries.size() << ")\n";
             return false;
         }
+    }
+
+    return true;
+}
+
+// Sort the entries by catalog number, keeping the first of the entries for
+// each catalog number, as that is the one a search of the index finds
+void
+sortUnique(CrossIndexEntries& entries)
+{
+    std::vector<std::pair<std::uint64_t, std::uint32_t>> keyed;
+    keyed.reserve(entries.size());
+    for (std::size_t i = 0; i < entries.size(); ++i)
+        keyed.emplace_back((static_cast<std::uint64_t>(entries[i].first) << 32) | i, entries[i].second);
+
+    parallelSort(keyed, [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+
+    std::size_t duplicates = 0;
+    std::size_t conflicts = 0;
+    entries.clear();
+    for (const auto& [key, celCatalogNumber] : keyed)
+    {
+        auto catalogNumber = static_cast<std::uint32_t>(key >> 32);
+        if (!entries.empty() && entries.back().first == catalogNumber)
+        {
+            if (entries.back().second == celCatalogNumber)
+            {
+                ++duplicates;
+            }
+            else
+            {
+                std::cerr << "Catalog number " << catalogNumber << " maps to both "
+                          << entries.back().second << " and " << celCatalogNumber
+                          << ", keeping the first\n";
+                ++conflicts;
+            }
+            continue;
+        }
 
-        writeUint(out, catalogNumber);
-        writeUint(out, celCatalogNumber);
+        entries.emplace_back(catalogNumber, celCatalogNumber);
+    }
 
-        record++;
+    if (duplicates > 0 || conflicts > 0)
+        std::cerr << "Dropped " << duplicates << " duplicate and " << conflicts << " conflicting entries\n";
+}
+
+// Read the catalog numbers of a stars.dat file in sorted order
+bool
+readStarCatalogNumbers(const fs::path& path, std::vector<std::uint32_t>& catalogNumbers)
+{
+    auto file = util::MappedFile::open(path);
+    if (file == nullptr || file->size() < StarsHeaderSize || std::memcmp(file->data(), "CELSTARS", 8) != 0)
+    {
+        std::cerr << "Error reading star database " << path << '\n';
+        return false;
+    }
+
+    std::uint32_t count;
+    std::memcpy(&count, file->data() + 10, sizeof(count));
+    if constexpr (compat::endian::native != compat::endian::little)
+        count = compat::byteswap(count);
+    if ((file->size() - StarsHeaderSize) / StarsRecordSize < count)
+    {
+        std::cerr << "Star database " << path << " is truncated\n";
+        return false;
+    }
+
+    catalogNumbers.resize(count);
+    const char* records = file->data() + StarsHeaderSize;
+    for (std::uint32_t i = 0; i < count; ++i)
+    {
+        std::memcpy(&catalogNumbers[i], records + i * StarsRecordSize, sizeof(std::uint32_t));
+        if constexpr (compat::endian::native != compat::endian::little)
+            catalogNumbers[i] = compat::byteswap(catalogNumbers[i]);
     }
 
+    parallelSort(catalogNumbers, std::less<std::uint32_t>());
     return true;
 }
 
+// Drop the entries mapping to stars not in the star database
+void
+dropMissingStars(CrossIndexEntries& entries, const std::vector<std::uint32_t>& catalogNumbers)
+{
+    auto it = std::remove_if(entries.begin(), entries.end(), [&](const auto& entry)
+    {
+        return !std::binary_search(catalogNumbers.begin(), catalogNumbers.end(), entry.second);
+    });
 
-int main(int argc, char* argv[])
+    if (it != entries.end())
+    {
+        std::cerr << "Dropped " << (entries.end() - it) << " entries of stars missing from "
+                  << starsFilename << '\n';
+        entries.erase(it, entries.end());
+    }
+}
+
+bool
+WriteCrossIndex(const CrossIndexEntries& entries, std::ostream& out)
 {
-    if (!parseCommandLine(argc, argv)/* || inputFilename.empty()*/)
+    // Write the header
+    out.write("CELINDEX", 8);
+
+    // Write the version
+    util::writeLE<std::uint16_t>(out, 0x0100);
+
+    for (const auto& [catalogNumber, celCatalogNumber] : entries)
+    {
+        util::writeLE(out, catalogNumber);
+        util::writeLE(out, celCatalogNumber);
+    }
+
+    return out.good();
+}
+
+// Sorted indexes are mapped by Celestia and searched in place
+bool
+WriteSortedCrossIndex(CrossIndexEntries&& entries, std::ostream& out)
+{
+    sortUnique(entries);
+
+    // Entries with the same Celestia catalog number stay sorted by catalog
+    // number, as the engine writes them
+    CrossIndexEntries byCelCatalogNumber = entries;
+    parallelSort(byCelCatalogNumber, [](const auto& lhs, const auto& rhs)
+    {
+        return lhs.second < rhs.second || (lhs.second == rhs.second && lhs.first < rhs.first);
+    });
+
+    return StarNameDatabase::writeCrossIndex(out, entries, byCelCatalogNumber);
+}
+
+} // end unnamed namespace
+
+int
+main(int argc, char* argv[])
+{
+    if (!parseCommandLine(argc, argv))
     {
         Usage();
         return 1;
     }
 
-    std::istream* inputFile = &std::cin;
-    std::ifstream fin;
-    if (!inputFilename.empty())
+    std::unique_ptr<util::MappedFile> inputFile;
+    std::string inputText;
+    std::string_view input;
+    if (inputFilename.empty() || inputFilename == "-")
     {
-        fin.open(inputFilename, std::ios::in);
-        if (!fin.good())
+        inputText.assign(std::istreambuf_iterator<char>(std::cin), std::istreambuf_iterator<char>());
+        input = inputText;
+    }
+    else
+    {
+        inputFile = util::MappedFile::open(fs::u8path(inputFilename));
+        if (inputFile == nullptr)
         {
             std::cerr << "Error opening input file " << inputFilename << '\n';
             return 1;
         }
-        inputFile = &fin;
+        input = std::string_view(inputFile->data(), inputFile->size());
+    }
+
+    CrossIndexEntries entries;
+    if (!parseCrossIndex(input, entries))
+        return 1;
+    if (entries.size() > UINT32_MAX)
+    {
+        std::cerr << "Too many entries in input file\n";
+        return 1;
+    }
+
+    if (!starsFilename.empty())
+    {
+        std::vector<std::uint32_t> catalogNumbers;
+        if (!readStarCatalogNumbers(fs::u8path(starsFilename), catalogNumbers))
+            return 1;
+        dropMissingStars(entries, catalogNumbers);
     }
 
     std::ostream* outputFile = &std::cout;
     std::ofstream fout;
     if (!outputFilename.empty())
     {
-        fout.open(outputFilename, std::ios::out | std::ios::binary);
+        fout.open(fs::u8path(outputFilename), std::ios::out | std::ios::binary);
         if (!fout.good())
         {
             std::cerr << "Error opening output file " << outputFilename << '\n';
@@ -150,7 +421,9 @@ int main(int argc, char* argv[])
         outputFile = &fout;
     }
 
-    bool success = WriteCrossIndex(*inputFile, *outputFile);
+    bool success = writeVersion1
+        ? WriteCrossIndex(entries, *outputFile)
+        : WriteSortedCrossIndex(std::move(entries), *outputFile);
 
     return success ? 0 : 1;
 }
@@ -0,0 +1,69 @@
+// stardbtext.h
+//
+// Copyright (C) 2025-present, the Celestia Development Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// Parsing of the text catalogs and writing of the stars.dat header, shared
+// by the star database tools
+
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string_view>
+#include <system_error>
+
+#include <celcompat/charconv.h>
+#include <celutil/binarywrite.h>
+
+namespace stardbtools
+{
+
+// Return the next whitespace separated token, or an empty one at the end
+inline std::string_view
+nextToken(const char*& ptr, const char* end)
+{
+    while (ptr != end && std::isspace(static_cast<unsigned char>(*ptr)))
+        ++ptr;
+    const char* start = ptr;
+    while (ptr != end && !std::isspace(static_cast<unsigned char>(*ptr)))
+        ++ptr;
+    return std::string_view(start, static_cast<std::size_t>(ptr - start));
+}
+
+template<typename T>
+bool
+parseNumber(std::string_view token, T& value)
+{
+    // Accept a leading plus sign, as reading from a stream did
+    if (!token.empty() && token.front() == '+')
+        token.remove_prefix(1);
+    const char* end = token.data() + token.size();
+    auto result = celestia::compat::from_chars(token.data(), end, value);
+    return result.ec == std::errc{} && result.ptr == end;
+}
+
+// Move a chunk boundary to the start of the next line
+inline const char*
+nextLine(const char* ptr, const char* end)
+{
+    ptr = std::find(ptr, end, '\n');
+    return ptr == end ? end : ptr + 1;
+}
+
+inline void
+writeStarsHeader(std::ostream& out, std::uint32_t starCount)
+{
+    out.write("CELSTARS", 8);
+    celestia::util::writeLE<std::uint16_t>(out, 0x0100);
+    celestia::util::writeLE(out, starCount);
+}
+
+} // end namespace stardbtools
@@ -0,0 +1,578 @@
+// makevt.cpp
+//
+// Copyright (C) 2025-present, the Celestia Development Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// Build the tiles of a virtual texture from a source image, or from a grid
+// of source images, and write its .ctx descriptor.
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include <celcompat/filesystem.h>
+#include <celimage/image.h>
+#include <celimage/imageformats.h>
+#include <celutil/logger.h>
+#include <celutil/threadpool.h>
+
+using celestia::engine::Image;
+using celestia::engine::PixelFormat;
+namespace engine = celestia::engine;
+namespace util = celestia::util;
+
+namespace
+{
+
+enum class TileFormat
+{
+    PNG,
+    JPEG,
+    DDS,
+};
+
+struct Options
+{
+    std::string source;
+    fs::path outputDirectory;
+    int columns{ 1 };
+    int rows{ 1 };
+    int tileSize{ 512 };
+    int baseSplit{ 0 };
+    // Number of levels written, or zero to match the source resolution
+    int levels{ 0 };
+    TileFormat format{ TileFormat::DDS };
+    std::string prefix{ "tx_" };
+};
+
+void
+Usage()
+{
+    std::cerr << "Usage: makevt [options] <source image> <output directory>\n";
+    std::cerr << "  Options:\n";
+    std::cerr << "    --grid <columns>x<rows> (or -g) : the source is a grid of images of equal\n";
+    std::cerr << "        size, named by replacing {col} and {row} in the source name\n";
+    std::cerr << "    --tile-size <size> (or -t) : tile size, a power of two >= 64 (default 512)\n";
+    std::cerr << "    --base-split <n> (or -b) : BaseSplit of the texture (default 0)\n";
+    std::cerr << "    --levels <n> (or -l) : number of levels written (default: enough to keep\n";
+    std::cerr << "        the resolution of the source)\n";
+    std::cerr << "    --format <dds|png|jpg> (or -f) : tile format; DDS tiles are DXT\n";
+    std::cerr << "        compressed (default dds)\n";
+    std::cerr << "    --prefix <prefix> (or -p) : tile name prefix (default tx_)\n";
+    std::cerr << "  The descriptor is written next to the output directory, with its name\n";
+    std::cerr << "  and the extension .ctx.\n";
+}
+
+bool
+parseInt(const char* s, int& value)
+{
+    char* end = nullptr;
+    long v = std::strtol(s, &end, 10);
+    if (end == s || *end != '\0' || v < 0 || v > 65536)
+        return false;
+    value = static_cast<int>(v);
+    return true;
+}
+
+bool
+parseCommandLine(int argc, char* argv[], Options& options)
+{
+    int fileCount = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string_view arg(argv[i]);
+        if (arg.size() > 1 && arg[0] == '-')
+        {
+            if (i + 1 == argc)
+                return false;
+
+            const char* value = argv[++i];
+            if (arg == "--grid" || arg == "-g")
+            {
+                if (std::sscanf(value, "%dx%d", &options.columns, &options.rows) != 2 ||
+                    options.columns < 1 || options.rows < 1)
+                {
+                    return false;
+                }
+            }
+            else if (arg == "--tile-size" || arg == "-t")
+            {
+                if (!parseInt(value, options.tileSize) || options.tileSize < 64 ||
+                    (options.tileSize & (options.tileSize - 1)) != 0)
+                {
+                    return false;
+                }
+            }
+            else if (arg == "--base-split" || arg == "-b")
+            {
+                if (!parseInt(value, options.baseSplit) || options.baseSplit > 8)
+                    return false;
+            }
+            else if (arg == "--levels" || arg == "-l")
+            {
+                if (!parseInt(value, options.levels) || options.levels < 1 || options.levels > 14)
+                    return false;
+            }
+            else if (arg == "--format" || arg == "-f")
+            {
+                std::string_view format(value);
+                if (format == "dds")
+                    options.format = TileFormat::DDS;
+                else if (format == "png")
+                    options.format = TileFormat::PNG;
+                else if (format == "jpg" || format == "jpeg")
+                    options.format = TileFormat::JPEG;
+                else
+                    return false;
+            }
+            else if (arg == "--prefix" || arg == "-p")
+            {
+                options.prefix = value;
+            }
+            else
+            {
+                std::cerr << "Unknown command line switch: " << arg << '\n';
+                return false;
+            }
+        }
+        else if (fileCount == 0)
+        {
+            options.source = std::string(arg);
+            fileCount++;
+        }
+        else if (fileCount == 1)
+        {
+            options.outputDirectory = fs::u8path(arg);
+            fileCount++;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    return fileCount == 2;
+}
+
+// The source images, loaded when a tile needs them. Only the most recently
+// used ones are kept, so that memory is bounded however large the grid is;
+// tiles are built in quadtree order, so that the tiles being built at any
+// time share few source images.
+class SourceImages
+{
+public:
+    SourceImages(const Options& options, std::size_t capacity) :
+        m_options(options),
+        m_capacity(capacity)
+    {
+    }
+
+    std::shared_ptr<const Image> get(int column, int row)
+    {
+        std::shared_future<std::shared_ptr<const Image>> image;
+        std::promise<std::shared_ptr<const Image>> loaded;
+        {
+            std::scoped_lock lock(m_mutex);
+            auto key = std::make_pair(column, row);
+            if (auto it = m_images.find(key); it != m_images.end())
+            {
+                m_order.splice(m_order.begin(), m_order, it->second.second);
+                return it->second.first.get();
+            }
+
+            image = loaded.get_future().share();
+            m_order.push_front(key);
+            m_images.try_emplace(key, image, m_order.begin());
+            if (m_images.size() > m_capacity)
+            {
+                // Images in use are kept alive by their users
+                m_images.erase(m_order.back());
+                m_order.pop_back();
+            }
+        }
+
+        fs::path path = fs::u8path(m_options.columns == 1 && m_options.rows == 1
+                                   ? m_options.source
+                                   : fmt::format(fmt::runtime(m_options.source),
+                                                 fmt::arg("col", column),
+                                                 fmt::arg("row", row)));
+        std::shared_ptr<const Image> result = Image::load(path);
+        if (result != nullptr && result->isCompressed())
+        {
+            std::cerr << "Compressed source image " << path << " is not supported\n";
+            result = nullptr;
+        }
+        else if (result == nullptr)
+        {
+            std::cerr << "Error loading source image " << path << '\n';
+        }
+
+        loaded.set_value(result);
+        return result;
+    }
+
+private:
+    using Key = std::pair<int, int>;
+    using Entry = std::pair<std::shared_future<std::shared_ptr<const Image>>, std::list<Key>::iterator>;
+
+    const Options& m_options;
+    std::size_t m_capacity;
+    std::mutex m_mutex;
+    std::map<Key, Entry> m_images;
+    std::list<Key> m_order;
+};
+
+class TileBuilder
+{
+public:
+    TileBuilder(const Options& options, const Image& first, int finestLOD) :
+        m_options(options),
+        m_sourceWidth(first.getWidth()),
+        m_sourceHeight(first.getHeight()),
+        m_format(first.getFormat()),
+        m_components(first.getComponents()),
+        m_finestLOD(finestLOD),
+        m_sources(options, static_cast<std::size_t>(util::GetThreadPool()->threadCount()) * 4 + 4)
+    {
+    }
+
+    // Build the tile and the tiles below it, returning the tile uncompressed
+    std::unique_ptr<Image> build(int lod, int u, int v);
+
+    // Write a tile of a level with a directory
+    void write(const Image& tile, int lod, int u, int v);
+
+    bool failed() const { return m_failed; }
+
+private:
+    std::unique_ptr<Image> sample(int u, int v);
+
+    const Options& m_options;
+    int m_sourceWidth;
+    int m_sourceHeight;
+    PixelFormat m_format;
+    int m_components;
+    int m_finestLOD;
+    SourceImages m_sources;
+    std::atomic<bool> m_failed{ false };
+};
+
+std::unique_ptr<Image>
+TileBuilder::build(int lod, int u, int v)
+{
+    std::unique_ptr<Image> tile;
+    if (lod == m_finestLOD)
+    {
+        tile = sample(u, v);
+    }
+    else
+    {
+        // Average the four tiles of the next level
+        const int size = m_options.tileSize;
+        Image combined(m_format, size * 2, size * 2);
+        for (int child = 0; child < 4; ++child)
+        {
+            int cu = child & 1;
+            int cv = child >> 1;
+            std::unique_ptr<Image> childTile = build(lod + 1, u * 2 + cu, v * 2 + cv);
+            auto rowSize = static_cast<std::size_t>(size * m_components);
+            for (int y = 0; y < size; ++y)
+            {
+                std::memcpy(combined.getPixelRow(cv * size + y) + cu * rowSize,
+                            childTile->getPixels() + static_cast<std::size_t>(y) * childTile->getPitch(),
+                            rowSize);
+            }
+        }
+        tile = combined.downsample(1);
+    }
+
+    if (lod >= m_options.baseSplit)
+        write(*tile, lod, u, v);
+    return tile;
+}
+
+// Sample a tile of the finest level from the source images, bilinearly
+// unless the resolutions match. The texture wraps around horizontally.
+std::unique_ptr<Image>
+TileBuilder::sample(int u, int v)
+{
+    const int size = m_options.tileSize;
+    const int totalWidth = m_sourceWidth * m_options.columns;
+    const int totalHeight = m_sourceHeight * m_options.rows;
+    const double levelWidth = static_cast<double>(size) * static_cast<double>(2 << m_finestLOD);
+    const double levelHeight = static_cast<double>(size) * static_cast<double>(1 << m_finestLOD);
+    const double scaleX = totalWidth / levelWidth;
+    const double scaleY = totalHeight / levelHeight;
+
+    auto tile = std::make_unique<Image>(m_format, size, size);
+
+    // The source images used by the current row
+    std::map<std::pair<int, int>, std::shared_ptr<const Image>> images;
+    auto pixel = [&](int x, int y) -> const std::uint8_t*
+    {
+        x = ((x % totalWidth) + totalWidth) % totalWidth;
+        y = std::clamp(y, 0, totalHeight - 1);
+        auto key = std::make_pair(x / m_sourceWidth, y / m_sourceHeight);
+        auto it = images.find(key);
+        if (it == images.end())
+        {
+            std::shared_ptr<const Image> image = m_sources.get(key.first, key.second);
+            if (image == nullptr || image->getWidth() != m_sourceWidth ||
+                image->getHeight() != m_sourceHeight || image->getFormat() != m_format)
+            {
+                if (image != nullptr)
+                    std::cerr << "Source image " << key.first << ", " << key.second << " differs in size or format\n";
+                m_failed = true;
+                image = nullptr;
+            }
+            it = images.try_emplace(key, std::move(image)).first;
+        }
+
+        static const std::uint8_t black[4] = {};
+        if (it->second == nullptr)
+            return black;
+        return it->second->getPixels() +
+               static_cast<std::size_t>(y % m_sourceHeight) * it->second->getPitch() +
+               static_cast<std::size_t>(x % m_sourceWidth) * m_components;
+    };
+
+    for (int y = 0; y < size; ++y)
+    {
+        double sy = (static_cast<double>(v * size + y) + 0.5) * scaleY - 0.5;
+        int y0 = static_cast<int>(std::floor(sy));
+        auto fy = static_cast<float>(sy - y0);
+
+        std::uint8_t* row = tile->getPixelRow(y);
+        for (int x = 0; x < size; ++x)
+        {
+            double sx = (static_cast<double>(u * size + x) + 0.5) * scaleX - 0.5;
+            int x0 = static_cast<int>(std::floor(sx));
+            auto fx = static_cast<float>(sx - x0);
+
+            const std::uint8_t* p00 = pixel(x0, y0);
+            const std::uint8_t* p10 = pixel(x0 + 1, y0);
+            const std::uint8_t* p01 = pixel(x0, y0 + 1);
+            const std::uint8_t* p11 = pixel(x0 + 1, y0 + 1);
+            for (int c = 0; c < m_components; ++c)
+            {
+                float top = p00[c] + (p10[c] - p00[c]) * fx;
+                float bottom = p01[c] + (p11[c] - p01[c]) * fx;
+                row[x * m_components + c] = static_cast<std::uint8_t>(top + (bottom - top) * fy + 0.5f);
+            }
+        }
+
+        // Keep only the images of the rows still to come
+        if (y + 1 < size && (y + 1) % 64 == 0)
+            images.clear();
+    }
+
+    return tile;
+}
+
+void
+TileBuilder::write(const Image& tile, int lod, int u, int v)
+{
+    static constexpr std::string_view extensions[] = { ".png", ".jpg", ".dds" };
+    fs::path path = m_options.outputDirectory /
+                    fmt::format("level{}", lod - m_options.baseSplit) /
+                    fmt::format("{}{}_{}{}", m_options.prefix, u, v,
+                                extensions[static_cast<int>(m_options.format)]);
+
+    bool ok = false;
+    switch (m_options.format)
+    {
+    case TileFormat::PNG:
+        ok = engine::SavePNGImage(path, tile);
+        break;
+    case TileFormat::JPEG:
+        ok = engine::SaveJPEGImage(path, tile);
+        break;
+    case TileFormat::DDS:
+        if (auto compressed = tile.compressDXT(); compressed != nullptr)
+            ok = engine::SaveDDSImage(path, *compressed);
+        break;
+    }
+
+    if (!ok)
+    {
+        std::cerr << "Error writing tile " << path << '\n';
+        m_failed = true;
+    }
+}
+
+bool
+WriteDescriptor(const Options& options)
+{
+    fs::path directory = options.outputDirectory;
+    if (!directory.has_filename())
+        directory = directory.parent_path();
+
+    fs::path path = directory;
+    path += ".ctx";
+
+    static constexpr std::string_view types[] = { "png", "jpg", "dds" };
+    std::ofstream out(path);
+    out << "VirtualTexture\n";
+    out << "{\n";
+    out << "    ImageDirectory \"" << directory.filename().u8string() << "\"\n";
+    out << "    BaseSplit " << options.baseSplit << '\n';
+    out << "    TileSize " << options.tileSize << '\n';
+    out << "    TileType \"" << types[static_cast<int>(options.format)] << "\"\n";
+    if (options.prefix != "tx_")
+        out << "    TilePrefix \"" << options.prefix << "\"\n";
+    out << "}\n";
+
+    if (!out.good())
+    {
+        std::cerr << "Error writing descriptor " << path << '\n';
+        return false;
+    }
+
+    std::cout << "Wrote " << path.u8string() << '\n';
+    return true;
+}
+
+} // end unnamed namespace
+
+int
+main(int argc, char* argv[])
+{
+    Options options;
+    if (!parseCommandLine(argc, argv, options))
+    {
+        Usage();
+        return 1;
+    }
+
+    util::CreateLogger();
+
+    // The first source image gives the size and format of all of them
+    SourceImages probe(options, 1);
+    std::shared_ptr<const Image> first = probe.get(0, 0);
+    if (first == nullptr)
+        return 1;
+
+    if (options.format == TileFormat::DDS &&
+        first->getFormat() != PixelFormat::RGB && first->getFormat() != PixelFormat::RGBA)
+    {
+        std::cerr << "DDS tiles need RGB or RGBA source images\n";
+        return 1;
+    }
+
+    // The finest level is the first at least as wide as the source, level
+    // n having 2^(n+1) by 2^n tiles
+    int finestLOD = options.baseSplit;
+    if (options.levels > 0)
+    {
+        finestLOD = options.baseSplit + options.levels - 1;
+    }
+    else
+    {
+        auto width = static_cast<std::int64_t>(first->getWidth()) * options.columns;
+        while ((static_cast<std::int64_t>(options.tileSize) << (finestLOD + 1)) < width)
+            ++finestLOD;
+    }
+
+    for (int lod = options.baseSplit; lod <= finestLOD; ++lod)
+    {
+        std::error_code ec;
+        fs::create_directories(options.outputDirectory / fmt::format("level{}", lod - options.baseSplit), ec);
+        if (ec)
+        {
+            std::cerr << "Error creating the directories of " << options.outputDirectory << '\n';
+            return 1;
+        }
+    }
+
+    TileBuilder builder(options, *first, finestLOD);
+    first = nullptr;
+
+    // The subtrees of a level with a few tiles per thread are built in
+    // parallel, then the levels above them from their top tiles
+    util::ThreadPool* threadPool = util::GetThreadPool();
+    const std::size_t minTiles = (static_cast<std::size_t>(threadPool->threadCount()) + 1) * 4;
+    int splitLOD = 0;
+    while (splitLOD < finestLOD && (std::size_t(2) << (2 * splitLOD)) < minTiles)
+        ++splitLOD;
+
+    std::cout << "Building " << (finestLOD - options.baseSplit + 1) << " levels of "
+              << options.tileSize << " pixel tiles, "
+              << (2 << finestLOD) << "x" << (1 << finestLOD) << " tiles at the finest\n";
+
+    int uCount = 2 << splitLOD;
+    int vCount = 1 << splitLOD;
+    std::vector<std::unique_ptr<Image>> tiles(static_cast<std::size_t>(uCount) * vCount);
+    threadPool->parallelFor(tiles.size(), [&](std::size_t i)
+    {
+        // Quadtree order keeps the tiles being built close together
+        int u = 0;
+        int v = 0;
+        for (int bit = 0; bit < splitLOD; ++bit)
+        {
+            u |= static_cast<int>((i >> (2 * bit)) & 1) << bit;
+            v |= static_cast<int>((i >> (2 * bit + 1)) & 1) << bit;
+        }
+        u |= static_cast<int>(i >> (2 * splitLOD)) << splitLOD;
+
+        tiles[static_cast<std::size_t>(v) * uCount + u] = builder.build(splitLOD, u, v);
+    });
+
+    for (int lod = splitLOD - 1; lod >= 0; --lod)
+    {
+        uCount /= 2;
+        vCount /= 2;
+        std::vector<std::unique_ptr<Image>> parents(static_cast<std::size_t>(uCount) * vCount);
+        threadPool->parallelFor(parents.size(), [&](std::size_t i)
+        {
+            int u = static_cast<int>(i % uCount);
+            int v = static_cast<int>(i / uCount);
+            const int size = options.tileSize;
+            const Image& sample = *tiles.front();
+            Image combined(sample.getFormat(), size * 2, size * 2);
+            auto rowSize = static_cast<std::size_t>(size * sample.getComponents());
+            for (int child = 0; child < 4; ++child)
+            {
+                int cu = u * 2 + (child & 1);
+                int cv = v * 2 + (child >> 1);
+                const Image& childTile = *tiles[static_cast<std::size_t>(cv) * uCount * 2 + cu];
+                for (int y = 0; y < size; ++y)
+                {
+                    std::memcpy(combined.getPixelRow((child >> 1) * size + y) + (child & 1) * rowSize,
+                                childTile.getPixels() + static_cast<std::size_t>(y) * childTile.getPitch(),
+                                rowSize);
+                }
+            }
+
+            parents[i] = combined.downsample(1);
+            if (lod >= options.baseSplit)
+                builder.write(*parents[i], lod, u, v);
+        });
+        tiles = std::move(parents);
+    }
+
+    if (builder.failed())
+        return 1;
+
+    return WriteDescriptor(options) ? 0 : 1;
+}
@@ -1,11 +1,15 @@
+#include <algorithm>
 #include <array>
 #include <cstddef>
 #include <cstdio>
 #include <cstring>
 #include <fstream>
+#include <iterator>
 #include <limits>
+#include <memory>
 #include <string>
 #include <string_view>
+#include <vector>
 
 #include <fmt/format.h>
 
@@ -14,6 +18,92 @@
 
 #define _(s) (s)
 
+static bool printRecord(std::FILE* out, double tdb, const double* position, const double* velocity)
+{
+    fmt::print(out, "{} {} {} {} {} {} {}\n",
+               tdb,
+               position[0], position[1], position[2],
+               velocity[0], velocity[1], velocity[2]);
+    return std::ferror(out) == 0;
+}
+
+// Decode the chunks of a chunked file written by xyzv2bin --chunked
+static bool chunkedToText(std::ifstream& in, const std::string& infilename, std::FILE* out)
+{
+    using celestia::ephem::DecodeXYZVChunk;
+    using celestia::ephem::XYZVChunkedHeader;
+    using celestia::ephem::XYZVChunkIndexEntry;
+    using celestia::ephem::XYZVRecord;
+
+    std::vector<char> file{ std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>() };
+    if (file.size() < sizeof(XYZVChunkedHeader))
+    {
+        fmt::print(stderr, _("Error reading header of {}.\n"), infilename);
+        return false;
+    }
+
+    decltype(XYZVChunkedHeader::byteOrder) byteOrder;
+    decltype(XYZVChunkedHeader::digits) digits;
+    decltype(XYZVChunkedHeader::chunkSize) chunkSize;
+    decltype(XYZVChunkedHeader::count) count;
+    decltype(XYZVChunkedHeader::indexOffset) indexOffset;
+    std::memcpy(&byteOrder, file.data() + offsetof(XYZVChunkedHeader, byteOrder), sizeof(byteOrder));
+    std::memcpy(&digits, file.data() + offsetof(XYZVChunkedHeader, digits), sizeof(digits));
+    std::memcpy(&chunkSize, file.data() + offsetof(XYZVChunkedHeader, chunkSize), sizeof(chunkSize));
+    std::memcpy(&count, file.data() + offsetof(XYZVChunkedHeader, count), sizeof(count));
+    std::memcpy(&indexOffset, file.data() + offsetof(XYZVChunkedHeader, indexOffset), sizeof(indexOffset));
+
+    if (byteOrder != static_cast<decltype(byteOrder)>(celestia::compat::endian::native))
+    {
+        fmt::print(stderr, _("Unsupported byte order {}, expected {}.\n"),
+                   byteOrder, static_cast<int>(celestia::compat::endian::native));
+        return false;
+    }
+
+    if (digits != std::numeric_limits<double>::digits)
+    {
+        fmt::print(stderr, _("Unsupported digits number {}, expected {}.\n"),
+                   digits, std::numeric_limits<double>::digits);
+        return false;
+    }
+
+    fmt::print(stderr, "File has {} records in chunks of {}.\n", count, chunkSize);
+    std::uint64_t nChunks = chunkSize == 0 ? 0 : (count + chunkSize - 1) / chunkSize;
+    if (count == 0 || nChunks == 0 || indexOffset > file.size() ||
+        (file.size() - indexOffset) / sizeof(XYZVChunkIndexEntry) < nChunks)
+    {
+        fmt::print(stderr, _("Bad chunk index in {}.\n"), infilename);
+        return false;
+    }
+
+    std::vector<XYZVRecord> records(chunkSize);
+    for (std::uint64_t i = 0; i < nChunks; ++i)
+    {
+        const char* entry = file.data() + indexOffset + i * sizeof(XYZVChunkIndexEntry);
+        std::uint64_t start;
+        std::uint64_t end = indexOffset;
+        std::memcpy(&start, entry + offsetof(XYZVChunkIndexEntry, offset), sizeof(start));
+        if (i + 1 < nChunks)
+            std::memcpy(&end, entry + sizeof(XYZVChunkIndexEntry) + offsetof(XYZVChunkIndexEntry, offset), sizeof(end));
+
+        auto nRecords = static_cast<std::size_t>(std::min<std::uint64_t>(chunkSize, count - i * chunkSize));
+        if (start > end || end > indexOffset ||
+            !DecodeXYZVChunk(file.data() + start, end - start, nRecords, records.data()))
+        {
+            fmt::print(stderr, _("Bad chunk {} in {}.\n"), i, infilename);
+            return false;
+        }
+
+        for (std::size_t j = 0; j < nRecords; ++j)
+        {
+            if (!printRecord(out, records[j][0], records[j].data() + 1, records[j].data() + 4))
+                return false;
+        }
+    }
+
+    return true;
+}
+
 static bool binaryToText(const std::string& infilename, const std::string& outfilename)
 {
     using celestia::ephem::XYZVBinaryData;
@@ -21,13 +111,26 @@ static bool binaryToText(const std::string& infilename, const std::string& outfi
     using celestia::ephem::XYZV_MAGIC;
 
     std::ifstream in(infilename, std::ios::binary);
-    std::ofstream out(outfilename);
-    if (!in.good() || !out.good())
+    std::unique_ptr<std::FILE, decltype(&std::fclose)> out(std::fopen(outfilename.c_str(), "w"), &std::fclose);
+    if (!in.good() || out == nullptr)
     {
         fmt::print(stderr, _("Error opening {} or {}.\n"), infilename, outfilename);
         return false;
     }
 
+    {
+        std::array<char, sizeof(XYZVBinaryHeader::magic)> magic;
+        if (in.read(magic.data(), magic.size()) && /* Flawfinder: ignore */
+            std::string_view(magic.data(), magic.size()) == celestia::ephem::XYZV_CHUNKED_MAGIC)
+        {
+            in.seekg(0);
+            return chunkedToText(in, infilename, out.get());
+        }
+
+        in.clear();
+        in.seekg(0);
+    }
+
     {
         std::array<char, sizeof(XYZVBinaryHeader)> header;
         if (!in.read(header.data(), header.size())) /* Flawfinder: ignore */
@@ -81,10 +184,8 @@ static bool binaryToText(const std::string& infilename, const std::string& outfi
         std::memcpy(position.data(), data.data() + offsetof(XYZVBinaryData, position), sizeof(double) * 3);
         std::memcpy(velocity.data(), data.data() + offsetof(XYZVBinaryData, velocity), sizeof(double) * 3);
 
-        fmt::print("{} {} {} {} {} {} {}\n",
-                   tdb,
-                   position[0], position[1], position[2],
-                   velocity[0], velocity[1], velocity[2]);
+        if (!printRecord(out.get(), tdb, position.data(), velocity.data()))
+            return false;
     }
 
     return true;
@@ -1,5 +1,7 @@
+#include <algorithm>
 #include <array>
 #include <cctype>
+#include <cmath>
 #include <cstddef>
 #include <cstdio>
 #include <cstring>
@@ -7,6 +9,8 @@
 #include <istream>
 #include <limits>
 #include <string>
+#include <string_view>
+#include <vector>
 
 #include <fmt/format.h>
 
@@ -131,15 +135,131 @@ static bool xyzvToBinary(const std::string& inFilename, const std::string& outFi
     return !!out.write(reinterpret_cast<const char*>(&header), sizeof(header));
 }
 
+// Convert text xyzv file to chunked binary file, with the records of each
+// chunk encoded by EncodeXYZVChunk and an index of the chunks at the end.
+static bool xyzvToChunked(const std::string& inFilename, const std::string& outFilename)
+{
+    using celestia::ephem::EncodeXYZVChunk;
+    using celestia::ephem::XYZVChunkedHeader;
+    using celestia::ephem::XYZVChunkIndexEntry;
+    using celestia::ephem::XYZVRecord;
+    using celestia::ephem::XYZV_CHUNK_SIZE;
+    using celestia::ephem::XYZV_CHUNKED_MAGIC;
+
+    std::ifstream in(inFilename);
+    std::ofstream out(outFilename, std::ios::binary);
+    if (!in.good() || !out.good())
+        return false;
+
+    if (!SkipComments(in))
+        return false;
+
+    // write empty header, will update it later
+    std::array<char, sizeof(XYZVChunkedHeader)> header = {};
+    if (!out.write(header.data(), header.size()))
+        return false;
+
+    std::vector<XYZVRecord> records;
+    records.reserve(XYZV_CHUNK_SIZE);
+    std::vector<std::array<char, sizeof(XYZVChunkIndexEntry)>> index;
+    std::string encoded;
+    std::uint64_t offset = sizeof(XYZVChunkedHeader);
+    double boundingRadius = 0.0;
+
+    auto writeChunk = [&]()
+    {
+        std::array<char, sizeof(XYZVChunkIndexEntry)> entry;
+        std::memcpy(entry.data() + offsetof(XYZVChunkIndexEntry, tdb), &records.front()[0], sizeof(double));
+        std::memcpy(entry.data() + offsetof(XYZVChunkIndexEntry, offset), &offset, sizeof(offset));
+        index.push_back(entry);
+
+        encoded.clear();
+        EncodeXYZVChunk(records.data(), records.size(), encoded);
+        offset += encoded.size();
+        records.clear();
+        return !!out.write(encoded.data(), static_cast<std::streamsize>(encoded.size()));
+    };
+
+    decltype(XYZVChunkedHeader::count) counter = 0;
+    while (!in.eof())
+    {
+        XYZVRecord& values = records.emplace_back();
+        for (double& value : values)
+            in >> value;
+
+        if (!in.good())
+        {
+            if (!in.eof())
+                fmt::print(stderr, "Error reading input file, line {}\n", counter+1);
+            records.pop_back();
+            break;
+        }
+
+        boundingRadius = std::max(boundingRadius, std::hypot(values[1], values[2], values[3]));
+        counter++;
+
+        if (records.size() == XYZV_CHUNK_SIZE && !writeChunk())
+        {
+            fmt::print(stderr, "Error writing output file, record N{}\n", counter);
+            return false;
+        }
+    }
+
+    if (!records.empty() && !writeChunk())
+    {
+        fmt::print(stderr, "Error writing output file, record N{}\n", counter);
+        return false;
+    }
+
+    fmt::print(stderr, "Written {} records in {} chunks, {} bytes.\n", counter, index.size(), offset);
+
+    if (counter == 0)
+        return false;
+
+    for (const auto& entry : index)
+    {
+        if (!out.write(entry.data(), entry.size()))
+            return false;
+    }
+
+    // write actual header
+    {
+        std::memcpy(header.data() + offsetof(XYZVChunkedHeader, magic), XYZV_CHUNKED_MAGIC.data(), XYZV_CHUNKED_MAGIC.size());
+
+        auto byteOrder = static_cast<decltype(XYZVChunkedHeader::byteOrder)>(celestia::compat::endian::native);
+        auto digits =    static_cast<decltype(XYZVChunkedHeader::digits)   >(std::numeric_limits<double>::digits);
+        auto chunkSize = XYZV_CHUNK_SIZE;
+
+        std::memcpy(header.data() + offsetof(XYZVChunkedHeader, byteOrder),      &byteOrder,      sizeof(byteOrder));
+        std::memcpy(header.data() + offsetof(XYZVChunkedHeader, digits),         &digits,         sizeof(digits));
+        std::memcpy(header.data() + offsetof(XYZVChunkedHeader, chunkSize),      &chunkSize,      sizeof(chunkSize));
+        std::memcpy(header.data() + offsetof(XYZVChunkedHeader, count),          &counter,        sizeof(counter));
+        std::memcpy(header.data() + offsetof(XYZVChunkedHeader, indexOffset),    &offset,         sizeof(offset));
+        std::memcpy(header.data() + offsetof(XYZVChunkedHeader, boundingRadius), &boundingRadius, sizeof(boundingRadius));
+    }
+
+    out.seekp(0);
+    return !!out.write(header.data(), header.size());
+}
+
 int main(int argc, char* argv[])
 {
+    const char* program = argv[0];
+    bool chunked = argc > 1 && (std::string_view(argv[1]) == "--chunked" || std::string_view(argv[1]) == "-c");
+    if (chunked)
+    {
+        --argc;
+        ++argv;
+    }
+
     if (argc < 3)
     {
-        fmt::print(stderr, "Usage: {} infile.xyzv outfile.bin\n", argv[0]);
+        fmt::print(stderr, "Usage: {} [--chunked] infile.xyzv outfile.bin\n", program);
+        fmt::print(stderr, "  --chunked (or -c) : write compressed chunks with an index by time\n");
         return 1;
     }
 
-    if (!xyzvToBinary(argv[1], argv[2]))
+    if (!(chunked ? xyzvToChunked(argv[1], argv[2]) : xyzvToBinary(argv[1], argv[2])))
     {
         fmt::print(stderr, "Error converting {} to {}.\n", argv[1], argv[2]);
         return 1;
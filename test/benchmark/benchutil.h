@@ -0,0 +1,52 @@
+// benchutil.h
+//
+// Copyright (C) 2025-present, the Celestia Development Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// Command line parsing and timing shared by the benchmarks
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+
+namespace benchutil
+{
+
+inline bool
+parseCount(const char* arg, std::uint32_t& value)
+{
+    char* end;
+    unsigned long result = std::strtoul(arg, &end, 10);
+    if (*end != '\0' || result > std::numeric_limits<std::uint32_t>::max())
+        return false;
+
+    value = static_cast<std::uint32_t>(result);
+    return true;
+}
+
+// Returns the fastest time of a run, in nanoseconds
+inline double
+timeRuns(unsigned int iterations, const std::function<void()>& run)
+{
+    double best = std::numeric_limits<double>::infinity();
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        auto start = std::chrono::steady_clock::now();
+        run();
+        auto end = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double, std::nano>(end - start).count());
+    }
+
+    return best;
+}
+
+} // end namespace benchutil
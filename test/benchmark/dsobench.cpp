@@ -0,0 +1,422 @@
+// dsobench.cpp
+//
+// Copyright (C) 2025, Celestia Development Team
+//
+// Benchmarks of deep sky object rendering in reproducible scenes, rendered
+// with the headless front end.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+
+#include <fmt/format.h>
+
+#include <celcompat/filesystem.h>
+#include <celengine/deepskyobj.h>
+#include <celengine/dsodb.h>
+#include <celengine/framestats.h>
+#include <celengine/galaxy.h>
+#include <celengine/glsupport.h>
+#include <celengine/observer.h>
+#include <celengine/render.h>
+#include <celengine/simulation.h>
+#include <celengine/univcoord.h>
+#include <celestia/celestiacore.h>
+#include <celestia/headless/headlessapp.h>
+#include <celmath/geomutil.h>
+#include <celmath/mathlib.h>
+
+namespace engine = celestia::engine;
+namespace headless = celestia::headless;
+namespace math = celestia::math;
+
+using namespace std::string_view_literals;
+
+namespace
+{
+
+struct Options
+{
+    headless::HeadlessOptions app;
+    fs::path dataDir;
+    std::vector<std::string> scenes;
+    unsigned int warmupFrames{ 30 };
+    unsigned int frames{ 120 };
+    float lightGain{ -1.0f };
+    long pointBudget{ -1 };
+};
+
+// The observer position and the point looked at, in light years
+struct Viewpoint
+{
+    Eigen::Vector3d position;
+    Eigen::Vector3d target;
+};
+
+// A scene is a path of the observer around a deep sky object, followed over
+// the measured frames; t goes from 0 to 1.
+struct Scene
+{
+    std::string_view name;
+    std::string_view object;
+    Viewpoint (*path)(const DeepSkyObject&, double t);
+};
+
+// Direction from the Sun to the object, to look at it from the Sun's side
+Eigen::Vector3d
+viewDirection(const DeepSkyObject& dso)
+{
+    Eigen::Vector3d direction = dso.getPosition();
+    return direction.norm() > 0.0 ? direction.normalized() : Eigen::Vector3d::UnitZ();
+}
+
+// Turn the offset from the object about the ecliptic pole
+Viewpoint
+orbitObject(const DeepSkyObject& dso, double distance, double degrees)
+{
+    Eigen::AngleAxisd rotation(math::degToRad(degrees), Eigen::Vector3d::UnitY());
+    Eigen::Vector3d center = dso.getPosition();
+    return { center - rotation * viewDirection(dso) * distance, center };
+}
+
+// The Virgo cluster from 20 million light years, slowly orbited
+Viewpoint
+galaxyClusterPath(const DeepSkyObject& dso, double t)
+{
+    return orbitObject(dso, 2.0e7, 10.0 * t);
+}
+
+// A full turn about the ecliptic pole from the Sun, sweeping across the disk
+// of the Milky Way
+Viewpoint
+milkyWayInteriorPath(const DeepSkyObject& dso, double t)
+{
+    Eigen::AngleAxisd rotation(math::degToRad(360.0 * t), Eigen::Vector3d::UnitY());
+    return { Eigen::Vector3d::Zero(), rotation * viewDirection(dso) };
+}
+
+// A globular cluster filling the view, orbited by 30 degrees
+Viewpoint
+globularCloseUpPath(const DeepSkyObject& dso, double t)
+{
+    return orbitObject(dso, 3.0 * dso.getRadius(), 30.0 * t);
+}
+
+// A straight line through a nebula, slightly off its center, from two radii
+// in front of it to two radii behind it
+Viewpoint
+nebulaFlyThroughPath(const DeepSkyObject& dso, double t)
+{
+    double radius = dso.getRadius();
+    Eigen::Vector3d direction = viewDirection(dso);
+    Eigen::Vector3d side = direction.unitOrthogonal() * 0.2 * radius;
+    Eigen::Vector3d position = dso.getPosition() + side + direction * radius * (4.0 * t - 2.0);
+    return { position, position + direction * radius };
+}
+
+constexpr std::array<Scene, 4> Scenes
+{
+    Scene{ "galaxy-cluster"sv, "M 87"sv, galaxyClusterPath },
+    Scene{ "milky-way-interior"sv, "Milky Way"sv, milkyWayInteriorPath },
+    Scene{ "globular-closeup"sv, "M 13"sv, globularCloseUpPath },
+    Scene{ "nebula-flythrough"sv, "M 42"sv, nebulaFlyThroughPath },
+};
+
+struct Result
+{
+    std::vector<double> frameTimes;
+    double gpuTime{ 0.0 };
+    unsigned int gpuFrames{ 0 };
+    std::array<double, engine::FrameDSOTypeCount> culled{ };
+    std::array<double, engine::FrameDSOTypeCount> processed{ };
+    double galaxyPoints{ 0.0 };
+};
+
+void
+Usage()
+{
+    fmt::print(stderr,
+               "Usage: dsobench [options]\n"
+               "  --dir <path>            : Celestia data directory (default current)\n"
+               "  --conf <file>           : configuration file\n"
+               "  --size <width>x<height> : frame size (default 1920x1080)\n"
+               "  --device <index>        : EGL device to render on\n"
+               "  --scene <name>          : scene to run, may be repeated (default all)\n"
+               "  --warmup <n>            : frames rendered before measuring (default 30)\n"
+               "  --frames <n>            : frames measured per scene (default 120)\n"
+               "  --light-gain <gain>     : galaxy light gain, from 0 to 1\n"
+               "  --point-budget <n>      : galaxy points drawn per frame, 0 for no limit\n"
+               "Scenes:");
+    for (const Scene& scene : Scenes)
+        fmt::print(stderr, " {}", scene.name);
+    fmt::print(stderr, "\n");
+}
+
+bool
+parseCount(const char* arg, unsigned int& value)
+{
+    char* end;
+    unsigned long result = std::strtoul(arg, &end, 10);
+    if (*end != '\0' || result > std::numeric_limits<unsigned int>::max())
+        return false;
+
+    value = static_cast<unsigned int>(result);
+    return true;
+}
+
+bool
+parseCommandLine(int argc, char* argv[], Options& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string_view arg = argv[i];
+        if (i + 1 == argc)
+            return false;
+
+        const char* value = argv[++i];
+        if (arg == "--dir"sv)
+        {
+            options.dataDir = fs::u8path(value);
+        }
+        else if (arg == "--conf"sv)
+        {
+            options.app.configFile = fs::u8path(value);
+        }
+        else if (arg == "--size"sv)
+        {
+            if (std::sscanf(value, "%dx%d", &options.app.width, &options.app.height) != 2 || // NOSONAR
+                options.app.width <= 0 || options.app.height <= 0)
+            {
+                return false;
+            }
+        }
+        else if (arg == "--device"sv)
+        {
+            options.app.device = std::atoi(value);
+        }
+        else if (arg == "--scene"sv)
+        {
+            if (std::none_of(Scenes.begin(), Scenes.end(), [value](const Scene& s) { return s.name == value; }))
+                return false;
+            options.scenes.emplace_back(value);
+        }
+        else if (arg == "--warmup"sv)
+        {
+            if (!parseCount(value, options.warmupFrames))
+                return false;
+        }
+        else if (arg == "--frames"sv)
+        {
+            if (!parseCount(value, options.frames) || options.frames == 0)
+                return false;
+        }
+        else if (arg == "--light-gain"sv)
+        {
+            char* end;
+            options.lightGain = std::strtof(value, &end);
+            if (*end != '\0' || !(options.lightGain >= 0.0f && options.lightGain <= 1.0f))
+                return false;
+        }
+        else if (arg == "--point-budget"sv)
+        {
+            unsigned int budget;
+            if (!parseCount(value, budget))
+                return false;
+            options.pointBudget = static_cast<long>(budget);
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void
+setViewpoint(Observer& observer, const Viewpoint& viewpoint)
+{
+    Eigen::Vector3d direction = (viewpoint.target - viewpoint.position).normalized();
+    Eigen::Vector3d up = std::abs(direction.y()) > 0.99 ? Eigen::Vector3d::UnitZ() : Eigen::Vector3d::UnitY();
+
+    observer.setPosition(UniversalCoord::CreateLy(viewpoint.position));
+    observer.setOrientation(math::LookAt(viewpoint.position, viewpoint.target, up));
+}
+
+void
+accumulate(Result& result, const engine::FrameCounters& counters)
+{
+    if (counters.gpuTime.has_value())
+    {
+        result.gpuTime += *counters.gpuTime;
+        ++result.gpuFrames;
+    }
+
+    for (std::size_t i = 0; i < engine::FrameDSOTypeCount; ++i)
+    {
+        result.culled[i] += counters.dsosCulledByType[i];
+        result.processed[i] += counters.dsosProcessedByType[i];
+    }
+
+    result.galaxyPoints += counters.galaxyPoints;
+}
+
+// Renders the warm up frames at the start of the path, so that the catalogs
+// and textures are loaded and the caches filled, then the measured frames
+// along the path. The frame time includes waiting for the GPU to finish.
+Result
+runScene(headless::HeadlessApp& app, const DeepSkyObject& dso, const Scene& scene, const Options& options)
+{
+    Simulation* sim = app.getCore()->getSimulation();
+    sim->setSelection(Selection());
+    Observer& observer = sim->getObserver();
+    observer.cancelMotion();
+    observer.setFrame(ObserverFrame::CoordinateSystem::Universal, Selection());
+
+    for (unsigned int i = 0; i < options.warmupFrames; ++i)
+    {
+        setViewpoint(observer, scene.path(dso, 0.0));
+        app.renderFrame();
+    }
+    glFinish();
+
+    Result result;
+    result.frameTimes.reserve(options.frames);
+    for (unsigned int i = 0; i < options.frames; ++i)
+    {
+        double t = options.frames > 1 ? static_cast<double>(i) / static_cast<double>(options.frames - 1) : 0.0;
+        setViewpoint(observer, scene.path(dso, t));
+
+        auto start = std::chrono::steady_clock::now();
+        app.renderFrame();
+        glFinish();
+        auto end = std::chrono::steady_clock::now();
+
+        result.frameTimes.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+        accumulate(result, engine::GetFrameStats()->current());
+    }
+
+    return result;
+}
+
+void
+printHeader()
+{
+    fmt::print("{:<20} {:>9} {:>9} {:>9} {:>15} {:>15} {:>15} {:>15} {:>12}\n",
+               "scene", "mean ms", "p95 ms", "gpu ms",
+               "galaxies", "globulars", "nebulae", "open clusters", "galaxy pts");
+}
+
+void
+printResult(std::string_view name, Result& result)
+{
+    auto frames = static_cast<double>(result.frameTimes.size());
+    double mean = 0.0;
+    for (double frameTime : result.frameTimes)
+        mean += frameTime;
+    mean /= frames;
+
+    auto p95 = result.frameTimes.begin() + static_cast<std::ptrdiff_t>(0.95 * (frames - 1.0));
+    std::nth_element(result.frameTimes.begin(), p95, result.frameTimes.end());
+
+    std::string gpuTime = result.gpuFrames == 0
+        ? std::string("-")
+        : fmt::format("{:.2f}", result.gpuTime / static_cast<double>(result.gpuFrames));
+
+    // Processed/culled objects per frame
+    std::array<std::string, engine::FrameDSOTypeCount> counts;
+    for (std::size_t i = 0; i < engine::FrameDSOTypeCount; ++i)
+        counts[i] = fmt::format("{:.0f}/{:.0f}", result.processed[i] / frames, result.culled[i] / frames);
+
+    fmt::print("{:<20} {:>9.2f} {:>9.2f} {:>9} {:>15} {:>15} {:>15} {:>15} {:>12.0f}\n",
+               name, mean, *p95, gpuTime,
+               counts[static_cast<std::size_t>(DeepSkyObjectType::Galaxy)],
+               counts[static_cast<std::size_t>(DeepSkyObjectType::Globular)],
+               counts[static_cast<std::size_t>(DeepSkyObjectType::Nebula)],
+               counts[static_cast<std::size_t>(DeepSkyObjectType::OpenCluster)],
+               result.galaxyPoints / frames);
+}
+
+} // end unnamed namespace
+
+int
+main(int argc, char* argv[])
+{
+    Options options;
+    if (!parseCommandLine(argc, argv, options))
+    {
+        Usage();
+        return EXIT_FAILURE;
+    }
+
+    if (!options.dataDir.empty())
+    {
+        std::error_code ec;
+        fs::current_path(options.dataDir, ec);
+        if (ec)
+        {
+            fmt::print(stderr, "Error changing to {}\n", options.dataDir.string());
+            return EXIT_FAILURE;
+        }
+    }
+
+    auto app = headless::HeadlessApp::create(options.app);
+    if (app == nullptr)
+        return EXIT_FAILURE;
+
+    CelestiaCore* appCore = app->getCore();
+    Renderer* renderer = appCore->getRenderer();
+    renderer->setRenderFlags(renderer->getRenderFlags() | RenderFlags::ShowDeepSpaceObjects);
+    if (options.pointBudget >= 0)
+        renderer->setGalaxyPointBudget(static_cast<unsigned>(options.pointBudget));
+    if (options.lightGain >= 0.0f)
+        Galaxy::setLightGain(options.lightGain);
+
+    // Stop the time, so that the views only depend on the paths
+    appCore->getSimulation()->setTimeScale(0.0);
+
+    fmt::print("{}x{}, {} warm up and {} measured frames per scene, light gain {:.2f}\n"
+               "Objects are the mean processed/culled per frame\n",
+               app->getWidth(), app->getHeight(), options.warmupFrames, options.frames, Galaxy::getLightGain());
+    printHeader();
+
+    const DSODatabase* dsoDB = appCore->getSimulation()->getUniverse()->getDSOCatalog();
+    for (const Scene& scene : Scenes)
+    {
+        if (!options.scenes.empty() &&
+            std::find(options.scenes.begin(), options.scenes.end(), scene.name) == options.scenes.end())
+        {
+            continue;
+        }
+
+        const DeepSkyObject* dso = dsoDB == nullptr ? nullptr : dsoDB->find(scene.object, false);
+        if (dso == nullptr)
+        {
+            fmt::print("{:<20} {} not found\n", scene.name, scene.object);
+            continue;
+        }
+
+        Result result = runScene(*app, *dso, scene, options);
+        printResult(scene.name, result);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,421 @@
+// ephembench.cpp
+//
+// Copyright (C) 2024, Celestia Development Team
+//
+// Benchmarks of the cost and accuracy of the orbit theories.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include <Eigen/Core>
+
+#include <fmt/format.h>
+
+#include <celastro/astro.h>
+#include <celastro/date.h>
+#include <celcompat/filesystem.h>
+#include <celephem/chebyshevorbit.h>
+#include <celephem/customorbit.h>
+#include <celephem/orbit.h>
+#include <celephem/samporbit.h>
+#include <celmath/mathlib.h>
+#include <celutil/logger.h>
+#include "benchutil.h"
+
+namespace astro = celestia::astro;
+namespace ephem = celestia::ephem;
+namespace math = celestia::math;
+namespace util = celestia::util;
+
+using benchutil::parseCount;
+using benchutil::timeRuns;
+
+using namespace std::string_view_literals;
+
+namespace
+{
+
+struct Options
+{
+    fs::path dataDir;
+    unsigned int iterations{ 5 };
+    std::uint32_t count{ 20000 };
+    std::uint32_t years{ 50 };
+    double orbitCacheTolerance{ 0.0 };
+};
+
+// An orbit theory and the orbit it is compared with, if any
+struct Theory
+{
+    std::string_view name;
+    std::string_view reference;
+};
+
+struct Accuracy
+{
+    double maxError{ 0.0 };
+    double rmsError{ 0.0 };
+    double maxAngle{ 0.0 };
+};
+
+class CountingSampleProc : public ephem::OrbitSampleProc
+{
+public:
+    void sample(double, const Eigen::Vector3d&, const Eigen::Vector3d&) override { ++samples; }
+
+    std::uint64_t samples{ 0 };
+};
+
+void
+Usage()
+{
+    fmt::print(stderr,
+               "Usage: ephembench [options]\n"
+               "  --dir <path>         : Celestia data directory with data/jpleph.dat (default current)\n"
+               "  --count <n>          : times evaluated per orbit (default 20000)\n"
+               "  --years <n>          : span of the times around J2000 in years (default 50)\n"
+               "  --iterations <n>     : timed repetitions of each benchmark (default 5)\n"
+               "  --orbit-cache <km>   : approximate the custom orbits within a tolerance\n");
+}
+
+bool
+parseCommandLine(int argc, char* argv[], Options& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string_view arg = argv[i];
+        if (i + 1 == argc)
+            return false;
+
+        const char* value = argv[++i];
+        if (arg == "--dir"sv)
+        {
+            options.dataDir = fs::u8path(value);
+        }
+        else if (arg == "--count"sv)
+        {
+            if (!parseCount(value, options.count) || options.count == 0)
+                return false;
+        }
+        else if (arg == "--years"sv)
+        {
+            if (!parseCount(value, options.years) || options.years == 0)
+                return false;
+        }
+        else if (arg == "--iterations"sv)
+        {
+            std::uint32_t iterations;
+            if (!parseCount(value, iterations) || iterations == 0)
+                return false;
+            options.iterations = iterations;
+        }
+        else if (arg == "--orbit-cache"sv)
+        {
+            char* end;
+            options.orbitCacheTolerance = std::strtod(value, &end);
+            if (*end != '\0' || !(options.orbitCacheTolerance >= 0.0))
+                return false;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Distinct times scattered over the span by the golden ratio, so that
+// consecutive evaluations never hit the last result cached by an orbit.
+std::vector<double>
+makeTimes(double begin, double end, std::uint32_t count)
+{
+    std::vector<double> times;
+    times.reserve(count);
+    for (std::uint32_t i = 0; i < count; ++i)
+    {
+        double fraction = std::fmod(static_cast<double>(i) * 0.6180339887498949, 1.0);
+        times.push_back(begin + (end - begin) * fraction);
+    }
+
+    return times;
+}
+
+// Nanoseconds per call of positionAtTime
+double
+timePositions(const ephem::Orbit& orbit, const std::vector<double>& times, unsigned int iterations)
+{
+    double sum = 0.0;
+    double ns = timeRuns(iterations, [&]
+    {
+        for (double jd : times)
+            sum += orbit.positionAtTime(jd).x();
+    });
+
+    // Keep the evaluations from being optimized away
+    if (!std::isfinite(sum))
+        fmt::print(stderr, "Non-finite positions\n");
+
+    return ns / static_cast<double>(times.size());
+}
+
+// Nanoseconds per call of sample over one period, or a year for
+// aperiodic orbits, and the number of samples produced
+double
+timeSampling(const ephem::Orbit& orbit, unsigned int iterations, std::uint64_t& samples)
+{
+    double span = orbit.isPeriodic() ? orbit.getPeriod() : 365.25;
+    double begin = astro::J2000;
+    double end = 0.0;
+    orbit.getValidRange(begin, end);
+    if (begin == end)
+        begin = astro::J2000;
+    else
+        span = std::min(span, end - begin);
+
+    return timeRuns(iterations, [&]
+    {
+        CountingSampleProc proc;
+        orbit.sample(begin, begin + span, proc);
+        samples = proc.samples;
+    });
+}
+
+Accuracy
+compareOrbits(const ephem::Orbit& orbit, const ephem::Orbit& reference, const std::vector<double>& times)
+{
+    Accuracy accuracy;
+    double sumSquares = 0.0;
+    for (double jd : times)
+    {
+        Eigen::Vector3d expected = reference.positionAtTime(jd);
+        double error = (orbit.positionAtTime(jd) - expected).norm();
+        accuracy.maxError = std::max(accuracy.maxError, error);
+        sumSquares += error * error;
+
+        double distance = expected.norm();
+        if (distance > 0.0)
+            accuracy.maxAngle = std::max(accuracy.maxAngle, error / distance);
+    }
+
+    accuracy.rmsError = std::sqrt(sumSquares / static_cast<double>(times.size()));
+    accuracy.maxAngle = math::radToDeg(accuracy.maxAngle) * 3600.0;
+    return accuracy;
+}
+
+void
+printHeader()
+{
+    fmt::print("{:<22} {:<16} {:>12} {:>12} {:>8} {:>14} {:>14} {:>12}\n",
+               "orbit", "reference", "ns/position", "us/sample", "samples", "max km", "rms km", "max arcsec");
+}
+
+void
+printResult(std::string_view name,
+            std::string_view reference,
+            double nsPerPosition,
+            double nsPerSample,
+            std::uint64_t samples,
+            const Accuracy* accuracy)
+{
+    fmt::print("{:<22} {:<16} {:>12.1f} {:>12.1f} {:>8}",
+               name, reference.empty() ? "-"sv : reference, nsPerPosition, nsPerSample * 1.0e-3, samples);
+    if (accuracy == nullptr)
+        fmt::print(" {:>14} {:>14} {:>12}\n", "-", "-", "-");
+    else
+        fmt::print(" {:>14.3f} {:>14.3f} {:>12.4f}\n", accuracy->maxError, accuracy->rmsError, accuracy->maxAngle);
+}
+
+void
+benchmarkOrbit(std::string_view name,
+               const ephem::Orbit& orbit,
+               std::string_view referenceName,
+               const ephem::Orbit* reference,
+               const std::vector<double>& times,
+               unsigned int iterations)
+{
+    double nsPerPosition = timePositions(orbit, times, iterations);
+    std::uint64_t samples = 0;
+    double nsPerSample = timeSampling(orbit, iterations, samples);
+
+    if (reference == nullptr)
+    {
+        printResult(name, {}, nsPerPosition, nsPerSample, samples, nullptr);
+        return;
+    }
+
+    Accuracy accuracy = compareOrbits(orbit, *reference, times);
+    printResult(name, referenceName, nsPerPosition, nsPerSample, samples, &accuracy);
+}
+
+void
+benchmarkTheories(const std::vector<double>& times, unsigned int iterations)
+{
+    // The JPL orbits themselves are listed last for their cost alone
+    const std::vector<Theory> theories
+    {
+        { "vsop87-mercury"sv, "jpl-mercury-sun"sv },
+        { "vsop87-venus"sv, "jpl-venus-sun"sv },
+        { "vsop87-earth"sv, "jpl-earth-sun"sv },
+        { "vsop87-mars"sv, "jpl-mars-sun"sv },
+        { "vsop87-jupiter"sv, "jpl-jupiter-sun"sv },
+        { "vsop87-saturn"sv, "jpl-saturn-sun"sv },
+        { "vsop87-uranus"sv, "jpl-uranus-sun"sv },
+        { "vsop87-neptune"sv, "jpl-neptune-sun"sv },
+        { "pluto"sv, "jpl-pluto-sun"sv },
+        { "moon"sv, "jpl-moon-earth"sv },
+        { "io"sv, {} },
+        { "europa"sv, {} },
+        { "ganymede"sv, {} },
+        { "callisto"sv, {} },
+        { "mimas"sv, {} },
+        { "titan"sv, {} },
+        { "iapetus"sv, {} },
+        { "miranda"sv, {} },
+        { "titania"sv, {} },
+        { "triton"sv, {} },
+        { "jpl-earth-sun"sv, {} },
+        { "jpl-moon-earth"sv, {} },
+    };
+
+    fmt::print("\nOrbit theories, {} times\n", times.size());
+    printHeader();
+
+    for (const Theory& theory : theories)
+    {
+        auto orbit = ephem::CreateCachedOrbit(ephem::GetCustomOrbit(theory.name));
+        if (orbit == nullptr)
+        {
+            fmt::print("{:<22} not available\n", theory.name);
+            continue;
+        }
+
+        std::shared_ptr<const ephem::Orbit> reference;
+        if (!theory.reference.empty())
+        {
+            reference = ephem::GetCustomOrbit(theory.reference);
+            if (reference == nullptr)
+                fmt::print(stderr, "{} not available, check that data/jpleph.dat is present\n", theory.reference);
+        }
+
+        benchmarkOrbit(theory.name, *orbit, theory.reference, reference.get(), times, iterations);
+    }
+}
+
+// Writes the orbit sampled daily to an ASCII xyz file, in the coordinates
+// of the file which are converted back when it is loaded
+bool
+writeTrajectory(const fs::path& path, const ephem::Orbit& orbit, double begin, double end)
+{
+    std::ofstream out(path);
+    if (!out.good())
+        return false;
+
+    for (double jd = begin; jd <= end; jd += 1.0)
+    {
+        Eigen::Vector3d p = orbit.positionAtTime(jd);
+        out << fmt::format("{:.9f} {:.6f} {:.6f} {:.6f}\n", jd, p.x(), -p.z(), p.y());
+    }
+
+    return out.good();
+}
+
+void
+benchmarkSampledOrbits(std::uint32_t count, unsigned int iterations)
+{
+    constexpr double SampledYears = 10.0;
+    double begin = astro::J2000 - SampledYears * 365.25 * 0.5;
+    double end = astro::J2000 + SampledYears * 365.25 * 0.5;
+
+    fmt::print("\nSampled and Keplerian orbits, {} times over {} years\n", count, SampledYears);
+    printHeader();
+
+    auto source = ephem::GetCustomOrbit("vsop87-earth"sv);
+    auto times = makeTimes(begin, end - 1.0, count);
+
+    fs::path path = fs::temp_directory_path() / "celestia_ephembench.xyz";
+    if (source != nullptr && writeTrajectory(path, *source, begin, end))
+    {
+        for (auto interpolation : { ephem::TrajectoryInterpolation::Linear, ephem::TrajectoryInterpolation::Cubic })
+        {
+            auto orbit = ephem::LoadSampledTrajectory(path, interpolation, ephem::TrajectoryPrecision::Double);
+            if (orbit == nullptr)
+                continue;
+
+            std::string_view name = interpolation == ephem::TrajectoryInterpolation::Linear
+                ? "sampled daily linear"sv
+                : "sampled daily cubic"sv;
+            benchmarkOrbit(name, *orbit, "vsop87-earth"sv, source.get(), times, iterations);
+        }
+    }
+    else
+    {
+        fmt::print(stderr, "Error writing the sampled trajectory\n");
+    }
+
+    std::error_code ec;
+    fs::remove(path, ec);
+
+    // Elements of the Earth's orbit
+    astro::KeplerElements elements;
+    elements.semimajorAxis = 149598023.0;
+    elements.eccentricity = 0.0167086;
+    elements.inclination = 0.0;
+    elements.longAscendingNode = math::degToRad(-11.26064);
+    elements.argPericenter = math::degToRad(114.20783);
+    elements.meanAnomaly = math::degToRad(358.617);
+    elements.period = 365.256363004;
+    ephem::EllipticalOrbit elliptical(elements, astro::J2000);
+    benchmarkOrbit("elliptical"sv, elliptical, "vsop87-earth"sv, source.get(), times, iterations);
+}
+
+} // end unnamed namespace
+
+int
+main(int argc, char* argv[])
+{
+    Options options;
+    if (!parseCommandLine(argc, argv, options))
+    {
+        Usage();
+        return EXIT_FAILURE;
+    }
+
+    util::CreateLogger(util::Level::Warning);
+
+    // The JPL ephemeris is loaded relative to the data directory
+    if (!options.dataDir.empty())
+    {
+        std::error_code ec;
+        fs::current_path(options.dataDir, ec);
+        if (ec)
+        {
+            fmt::print(stderr, "Error changing to {}\n", options.dataDir.string());
+            return EXIT_FAILURE;
+        }
+    }
+
+    ephem::SetOrbitCacheTolerance(options.orbitCacheTolerance);
+
+    fmt::print("{} iterations, best time reported, errors against the JPL ephemeris where present\n",
+               options.iterations);
+
+    double span = static_cast<double>(options.years) * 365.25;
+    auto times = makeTimes(astro::J2000 - span * 0.5, astro::J2000 + span * 0.5, options.count);
+    benchmarkTheories(times, options.iterations);
+    benchmarkSampledOrbits(options.count, options.iterations);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,494 @@
+// kernelbench.cpp
+//
+// Copyright (C) 2026, Celestia Development Team
+//
+// Benchmarks of the parsing, culling and decoding kernels, with an output
+// which stays comparable between runs and builds.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <Eigen/Core>
+
+#include <fmt/format.h>
+
+#include <celcompat/filesystem.h>
+#include <celimage/dds_decompress.h>
+#include <celimage/pixelformat.h>
+#include <celmath/frustum.h>
+#include <celmath/mathlib.h>
+#include <celmodel/material.h>
+#include <celmodel/mesh.h>
+#include <celmodel/model.h>
+#include <celmodel/modelfile.h>
+#include <celutil/associativearray.h>
+#include <celutil/logger.h>
+#include <celutil/parser.h>
+#include <celutil/tokenizer.h>
+#include "benchutil.h"
+
+namespace engine = celestia::engine;
+namespace math = celestia::math;
+namespace util = celestia::util;
+
+using benchutil::parseCount;
+using benchutil::timeRuns;
+
+using namespace std::string_view_literals;
+
+namespace
+{
+
+struct Options
+{
+    std::uint32_t bodies{ 20000 };
+    std::uint32_t spheres{ 1000000 };
+    std::uint32_t imageSize{ 2048 };
+    std::uint32_t gridSize{ 256 };
+    unsigned int iterations{ 10 };
+    std::string_view filter;
+};
+
+void
+Usage()
+{
+    fmt::print(stderr,
+               "Usage: kernelbench [options]\n"
+               "  --bodies <n>         : bodies of the generated SSC catalog (default 20000)\n"
+               "  --spheres <n>        : spheres tested against the frustum (default 1000000)\n"
+               "  --image-size <n>     : size of the DXT compressed images (default 2048)\n"
+               "  --grid-size <n>      : quads per side of the cmod mesh (default 256)\n"
+               "  --iterations <n>     : timed repetitions of each benchmark (default 10)\n"
+               "  --filter <text>      : only run the benchmarks whose name contains text\n");
+}
+
+bool
+parseCommandLine(int argc, char* argv[], Options& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string_view arg = argv[i];
+        if (i + 1 == argc)
+            return false;
+
+        const char* value = argv[++i];
+        if (arg == "--bodies"sv)
+        {
+            if (!parseCount(value, options.bodies) || options.bodies == 0)
+                return false;
+        }
+        else if (arg == "--spheres"sv)
+        {
+            if (!parseCount(value, options.spheres) || options.spheres == 0)
+                return false;
+        }
+        else if (arg == "--image-size"sv)
+        {
+            if (!parseCount(value, options.imageSize) || options.imageSize == 0)
+                return false;
+        }
+        else if (arg == "--grid-size"sv)
+        {
+            if (!parseCount(value, options.gridSize) || options.gridSize == 0)
+                return false;
+        }
+        else if (arg == "--iterations"sv)
+        {
+            std::uint32_t iterations;
+            if (!parseCount(value, iterations) || iterations == 0)
+                return false;
+            options.iterations = iterations;
+        }
+        else if (arg == "--filter"sv)
+        {
+            options.filter = value;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Runs the benchmarks selected by the filter and prints one line for each,
+// with the name, the items processed per run, the fastest run and the time
+// per item. The names and columns are kept stable so that the output of
+// different builds can be compared line by line.
+class BenchmarkRunner
+{
+public:
+    explicit BenchmarkRunner(const Options& options) : m_options(options)
+    {
+        fmt::print("{:<28} {:>10} {:>10} {:>10}\n", "benchmark", "items", "ms", "ns/item");
+    }
+
+    bool selected(std::string_view name) const
+    {
+        return m_options.filter.empty() || name.find(m_options.filter) != std::string_view::npos;
+    }
+
+    void run(std::string_view name, std::uint64_t items, const std::function<void()>& body)
+    {
+        if (!selected(name))
+            return;
+
+        double ns = timeRuns(m_options.iterations, body);
+        fmt::print("{:<28} {:>10} {:>10.3f} {:>10.2f}\n",
+                   name, items, ns * 1.0e-6, ns / static_cast<double>(items));
+    }
+
+private:
+    const Options& m_options;
+};
+
+// Keeps the results of a benchmark from being optimized away
+void
+checkResult(std::string_view name, bool valid)
+{
+    if (!valid)
+        fmt::print(stderr, "{}: unexpected result\n", name);
+}
+
+// A catalog of asteroids, with the properties and nesting of the catalogs
+// of the minor bodies
+std::string
+makeCatalog(std::uint32_t bodies)
+{
+    std::mt19937 rng(20260101);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+    std::string catalog;
+    catalog.reserve(static_cast<std::size_t>(bodies) * 400);
+    for (std::uint32_t i = 0; i < bodies; ++i)
+    {
+        catalog += fmt::format(
+            "# Minor body {}\n"
+            "\"{} Asteroid {}:A{}\" \"Sol\"\n"
+            "{{\n"
+            "    Class \"asteroid\"\n"
+            "    Texture \"asteroid.jpg\"\n"
+            "    Mesh \"asteroid.cms\"\n"
+            "    Radius {:.3f}\n"
+            "    Albedo {:.3f}\n"
+            "    Color [ {:.2f} {:.2f} {:.2f} ]\n"
+            "    EllipticalOrbit\n"
+            "    {{\n"
+            "        Epoch 2460600.5\n"
+            "        Period {:.6f}\n"
+            "        SemiMajorAxis {:.6f}\n"
+            "        Eccentricity {:.6f}\n"
+            "        Inclination {:.4f}\n"
+            "        AscendingNode {:.4f}\n"
+            "        ArgOfPericenter {:.4f}\n"
+            "        MeanAnomaly {:.4f}\n"
+            "    }}\n"
+            "    RotationPeriod {:.4f}\n"
+            "}}\n\n",
+            i, i + 1000, i, i,
+            1.0 + unit(rng) * 100.0, unit(rng) * 0.5,
+            unit(rng), unit(rng), unit(rng),
+            1.0 + unit(rng) * 10.0, 1.0 + unit(rng) * 4.0, unit(rng) * 0.3,
+            unit(rng) * 30.0, unit(rng) * 360.0, unit(rng) * 360.0, unit(rng) * 360.0,
+            1.0 + unit(rng) * 24.0);
+    }
+
+    return catalog;
+}
+
+// Reads the objects of a catalog the way the solar system loader does
+std::vector<util::Value>
+parseCatalog(std::string_view catalog)
+{
+    std::vector<util::Value> objects;
+    util::Tokenizer tokenizer(catalog);
+    util::Parser parser(&tokenizer);
+    while (tokenizer.nextToken() == util::Tokenizer::TokenString)
+    {
+        if (tokenizer.nextToken() != util::Tokenizer::TokenString)
+            break;
+
+        util::Value value = parser.readValue();
+        if (value.getHash() == nullptr)
+            break;
+        objects.push_back(std::move(value));
+    }
+
+    return objects;
+}
+
+void
+benchmarkCatalogs(BenchmarkRunner& runner, std::uint32_t bodies)
+{
+    if (!runner.selected("ssc.tokenize"sv) &&
+        !runner.selected("ssc.parse"sv) &&
+        !runner.selected("associativearray.lookup"sv))
+    {
+        return;
+    }
+
+    std::string catalog = makeCatalog(bodies);
+
+    std::uint64_t tokenCount = 0;
+    {
+        util::Tokenizer tokenizer(catalog);
+        while (tokenizer.nextToken() != util::Tokenizer::TokenEnd)
+            ++tokenCount;
+    }
+
+    runner.run("ssc.tokenize"sv, tokenCount, [&]
+    {
+        util::Tokenizer tokenizer(catalog);
+        std::uint64_t tokens = 0;
+        while (tokenizer.nextToken() != util::Tokenizer::TokenEnd)
+            ++tokens;
+        checkResult("ssc.tokenize"sv, tokens == tokenCount);
+    });
+
+    runner.run("ssc.parse"sv, bodies, [&]
+    {
+        checkResult("ssc.parse"sv, parseCatalog(catalog).size() == bodies);
+    });
+
+    if (!runner.selected("associativearray.lookup"sv))
+        return;
+
+    // The lookups of a body definition: present and missing properties,
+    // and those of the nested orbit
+    std::vector<util::Value> objects = parseCatalog(catalog);
+    constexpr std::uint64_t LookupsPerBody = 8;
+    runner.run("associativearray.lookup"sv, bodies * LookupsPerBody, [&]
+    {
+        double sum = 0.0;
+        std::uint32_t found = 0;
+        for (const util::Value& object : objects)
+        {
+            const util::AssociativeArray* hash = object.getHash();
+            sum += hash->getNumber<double>("Radius"sv).value_or(0.0);
+            sum += hash->getNumber<double>("Albedo"sv).value_or(0.0);
+            found += hash->getString("Class"sv) != nullptr ? 1 : 0;
+            found += hash->getPath("Texture"sv).has_value() ? 1 : 0;
+            found += hash->getValue("Atmosphere"sv) != nullptr ? 1 : 0;
+            if (const util::Value* orbit = hash->getValue("EllipticalOrbit"sv); orbit != nullptr)
+            {
+                const util::AssociativeArray* orbitHash = orbit->getHash();
+                sum += orbitHash->getNumber<double>("Period"sv).value_or(0.0);
+                sum += orbitHash->getNumber<double>("SemiMajorAxis"sv).value_or(0.0);
+            }
+        }
+        checkResult("associativearray.lookup"sv, std::isfinite(sum) && found == bodies * 2);
+    });
+}
+
+// Spheres around the viewer, a fraction of which are in the frustum
+template<typename T>
+std::vector<Eigen::Matrix<T, 4, 1>>
+makeSpheres(std::uint32_t count)
+{
+    std::mt19937 rng(20260102);
+    std::uniform_real_distribution<T> coordinate(T(-1000), T(1000));
+    std::uniform_real_distribution<T> radius(T(0.1), T(20));
+
+    std::vector<Eigen::Matrix<T, 4, 1>> spheres;
+    spheres.reserve(count);
+    for (std::uint32_t i = 0; i < count; ++i)
+        spheres.emplace_back(coordinate(rng), coordinate(rng), coordinate(rng), radius(rng));
+    return spheres;
+}
+
+template<typename T>
+void
+benchmarkFrustum(BenchmarkRunner& runner, const math::Frustum& frustum,
+                 std::string_view name, std::string_view batchName, std::uint32_t count)
+{
+    if (!runner.selected(name) && !runner.selected(batchName))
+        return;
+
+    auto spheres = makeSpheres<T>(count);
+
+    std::uint32_t visible = 0;
+    runner.run(name, count, [&]
+    {
+        visible = 0;
+        for (const auto& sphere : spheres)
+        {
+            Eigen::Matrix<T, 3, 1> center = sphere.template head<3>();
+            if (frustum.testSphere(center, sphere.w()) != math::FrustumAspect::Outside)
+                ++visible;
+        }
+    });
+
+    std::vector<T> x(count);
+    std::vector<T> y(count);
+    std::vector<T> z(count);
+    std::vector<T> r(count);
+    for (std::uint32_t i = 0; i < count; ++i)
+    {
+        x[i] = spheres[i].x();
+        y[i] = spheres[i].y();
+        z[i] = spheres[i].z();
+        r[i] = spheres[i].w();
+    }
+
+    math::SphereArrays<T> arrays{ x, y, z, r };
+    std::vector<std::uint32_t> indices;
+    indices.reserve(count);
+    runner.run(batchName, count, [&]
+    {
+        indices.clear();
+        frustum.testSpheres(arrays, indices);
+    });
+
+    if (runner.selected(name) && runner.selected(batchName))
+        checkResult(batchName, indices.size() == visible);
+}
+
+void
+benchmarkDXT(BenchmarkRunner& runner, std::string_view name, engine::PixelFormat format,
+             std::uint32_t size)
+{
+    if (!runner.selected(name))
+        return;
+
+    const std::uint32_t blockSize = format == engine::PixelFormat::DXT1 ? 8 : 16;
+    const std::uint32_t blocksWide = (size + 3) / 4;
+
+    std::mt19937 rng(20260103);
+    std::vector<std::uint8_t> blocks(static_cast<std::size_t>(blocksWide) * blocksWide * blockSize);
+    for (auto& b : blocks)
+        b = static_cast<std::uint8_t>(rng());
+
+    constexpr std::uint32_t Components = 4;
+    std::vector<std::uint8_t> image(static_cast<std::size_t>(size) * size * Components);
+    runner.run(name, static_cast<std::uint64_t>(size) * size, [&]
+    {
+        engine::DecompressImageDXT(format, size, size, blocks.data(), Components, size * Components, image.data());
+    });
+}
+
+// A grid of size x size quads with positions, normals and texture
+// coordinates, like those of the models of the bodies
+std::unique_ptr<cmod::Model>
+makeModel(std::uint32_t size)
+{
+    std::vector<cmod::VertexAttribute> attributes;
+    attributes.emplace_back(cmod::VertexAttributeSemantic::Position, cmod::VertexAttributeFormat::Float3, 0);
+    attributes.emplace_back(cmod::VertexAttributeSemantic::Normal, cmod::VertexAttributeFormat::Float3, 3);
+    attributes.emplace_back(cmod::VertexAttributeSemantic::Texture0, cmod::VertexAttributeFormat::Float2, 6);
+    constexpr std::uint32_t VertexWords = 8;
+
+    cmod::Mesh mesh;
+    mesh.setVertexDescription(cmod::VertexDescription(std::move(attributes)));
+
+    std::uint32_t side = size + 1;
+    std::vector<cmod::VWord> vertices(static_cast<std::size_t>(side) * side * VertexWords);
+    for (std::uint32_t y = 0; y < side; ++y)
+    {
+        for (std::uint32_t x = 0; x < side; ++x)
+        {
+            float u = static_cast<float>(x) / static_cast<float>(size);
+            float v = static_cast<float>(y) / static_cast<float>(size);
+            float vertex[VertexWords] = { u, v, 0.0f, 0.0f, 0.0f, 1.0f, u, v };
+            std::memcpy(&vertices[(static_cast<std::size_t>(y) * side + x) * VertexWords], vertex, sizeof(vertex));
+        }
+    }
+    mesh.setVertices(side * side, std::move(vertices));
+
+    std::vector<cmod::Index32> indices;
+    indices.reserve(static_cast<std::size_t>(size) * size * 6);
+    for (std::uint32_t y = 0; y < size; ++y)
+    {
+        for (std::uint32_t x = 0; x < size; ++x)
+        {
+            cmod::Index32 i = y * side + x;
+            indices.insert(indices.end(), { i, i + 1, i + side + 1, i, i + side + 1, i + side });
+        }
+    }
+    mesh.addGroup(cmod::PrimitiveGroupType::TriList, 0, std::move(indices));
+
+    auto model = std::make_unique<cmod::Model>();
+    model->addMaterial(cmod::Material());
+    model->addMesh(std::move(mesh));
+    return model;
+}
+
+void
+benchmarkCmod(BenchmarkRunner& runner, std::uint32_t gridSize)
+{
+    if (!runner.selected("cmod.parse.ascii"sv) && !runner.selected("cmod.parse.binary"sv))
+        return;
+
+    auto model = makeModel(gridSize);
+    std::uint64_t vertexCount = model->getVertexCount();
+    auto getSource = [](ResourceHandle) { return fs::path(); };
+    auto getHandle = [](const fs::path&) { return ResourceHandle(0); };
+
+    std::ostringstream ascii;
+    std::ostringstream binary(std::ios::out | std::ios::binary);
+    if (!cmod::SaveModelAscii(model.get(), ascii, getSource) ||
+        !cmod::SaveModelBinary(model.get(), binary, getSource))
+    {
+        fmt::print(stderr, "Error writing the cmod model\n");
+        return;
+    }
+
+    std::string asciiData = ascii.str();
+    std::string binaryData = binary.str();
+    for (auto [name, data] : { std::pair("cmod.parse.ascii"sv, &asciiData),
+                               std::pair("cmod.parse.binary"sv, &binaryData) })
+    {
+        runner.run(name, vertexCount, [&, name = name, data = data]
+        {
+            std::istringstream in(*data, std::ios::in | std::ios::binary);
+            auto loaded = cmod::LoadModel(in, getHandle);
+            checkResult(name, loaded != nullptr && loaded->getVertexCount() == vertexCount);
+        });
+    }
+}
+
+} // end unnamed namespace
+
+int
+main(int argc, char* argv[])
+{
+    Options options;
+    if (!parseCommandLine(argc, argv, options))
+    {
+        Usage();
+        return EXIT_FAILURE;
+    }
+
+    // The model loader logs each model at the info level
+    util::CreateLogger(util::Level::Warning);
+
+    BenchmarkRunner runner(options);
+    benchmarkCatalogs(runner, options.bodies);
+
+    math::Frustum frustum(math::degToRad(45.0f), 16.0f / 9.0f, 1.0f, 1500.0f);
+    benchmarkFrustum<float>(runner, frustum, "frustum.sphere.float"sv, "frustum.spheres.float"sv, options.spheres);
+    benchmarkFrustum<double>(runner, frustum, "frustum.sphere.double"sv, "frustum.spheres.double"sv, options.spheres);
+
+    benchmarkDXT(runner, "dxt1.decompress"sv, engine::PixelFormat::DXT1, options.imageSize);
+    benchmarkDXT(runner, "dxt5.decompress"sv, engine::PixelFormat::DXT5, options.imageSize);
+
+    benchmarkCmod(runner, options.gridSize);
+
+    return EXIT_SUCCESS;
+}
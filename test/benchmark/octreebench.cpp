@@ -0,0 +1,536 @@
+// octreebench.cpp
+//
+// Copyright (C) 2024, Celestia Development Team
+//
+// Benchmarks of the star and deep sky object octree traversals.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+
+#include <fmt/format.h>
+
+#include <celcompat/filesystem.h>
+#include <celengine/dsodb.h>
+#include <celengine/dsodbbuilder.h>
+#include <celengine/dsooctree.h>
+#include <celengine/stardb.h>
+#include <celengine/stardbbuilder.h>
+#include <celengine/starname.h>
+#include <celengine/staroctree.h>
+#include <celengine/stellarclass.h>
+#include <celutil/binarywrite.h>
+#include <celutil/logger.h>
+#include <celutil/threadpool.h>
+#include "benchutil.h"
+
+namespace engine = celestia::engine;
+namespace util = celestia::util;
+
+using benchutil::parseCount;
+using benchutil::timeRuns;
+
+using namespace std::string_view_literals;
+
+namespace
+{
+
+struct Options
+{
+    std::uint32_t starCount{ 2000000 };
+    std::uint32_t dsoCount{ 100000 };
+    unsigned int iterations{ 10 };
+    fs::path starsFile;
+    fs::path dsoFile;
+};
+
+struct Viewpoint
+{
+    std::string_view name;
+    Eigen::Vector3d position;
+    Eigen::Quaternionf orientation;
+    float limitingMag;
+};
+
+// Wraps a processor to count the nodes tested and the objects processed.
+// This forces the scalar culling path.
+template<typename PROCESSOR>
+class CountingProcessor
+{
+public:
+    explicit CountingProcessor(PROCESSOR& processor) : m_processor(processor) {}
+
+    template<typename POINT, typename PREC>
+    bool checkNode(const POINT& center, PREC size, float factor)
+    {
+        ++nodes;
+        return m_processor.checkNode(center, size, factor);
+    }
+
+    template<typename OBJ>
+    void process(const OBJ& obj)
+    {
+        ++objects;
+        m_processor.process(obj);
+    }
+
+    std::uint64_t nodes{ 0 };
+    std::uint64_t objects{ 0 };
+
+private:
+    PROCESSOR& m_processor;
+};
+
+class CountingStarHandler : public engine::StarHandler
+{
+public:
+    void process(const Star&, float, float) override { ++found; }
+
+    std::uint64_t found{ 0 };
+};
+
+class CountingDSOHandler : public engine::DSOHandler
+{
+public:
+    void process(const std::unique_ptr<DeepSkyObject>&, double, float) override { ++found; } //NOSONAR
+
+    std::uint64_t found{ 0 };
+};
+
+struct Counts
+{
+    std::uint64_t nodes{ 0 };
+    std::uint64_t objects{ 0 };
+    std::uint64_t found{ 0 };
+};
+
+void
+Usage()
+{
+    fmt::print(stderr,
+               "Usage: octreebench [options]\n"
+               "  --stars <file>       : use a stars.dat file instead of synthetic stars\n"
+               "  --dsc <file>         : use a deep sky catalog instead of synthetic objects\n"
+               "  --star-count <n>     : number of synthetic stars (default 2000000)\n"
+               "  --dso-count <n>      : number of synthetic deep sky objects (default 100000)\n"
+               "  --iterations <n>     : timed repetitions of each benchmark (default 10)\n");
+}
+
+bool
+parseCommandLine(int argc, char* argv[], Options& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string_view arg = argv[i];
+        if (i + 1 == argc)
+            return false;
+
+        const char* value = argv[++i];
+        if (arg == "--stars"sv)
+        {
+            options.starsFile = fs::u8path(value);
+        }
+        else if (arg == "--dsc"sv)
+        {
+            options.dsoFile = fs::u8path(value);
+        }
+        else if (arg == "--star-count"sv)
+        {
+            if (!parseCount(value, options.starCount))
+                return false;
+        }
+        else if (arg == "--dso-count"sv)
+        {
+            if (!parseCount(value, options.dsoCount))
+                return false;
+        }
+        else if (arg == "--iterations"sv)
+        {
+            std::uint32_t iterations;
+            if (!parseCount(value, iterations) || iterations == 0)
+                return false;
+            options.iterations = iterations;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Stars scattered in a disk a few thousand light years across, denser
+// towards the center, with a realistic spread of absolute magnitudes.
+std::string
+makeSyntheticStars(std::uint32_t count)
+{
+    std::mt19937 rng(20240101);
+    std::exponential_distribution<float> radius(1.0f / 1500.0f);
+    std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+    std::normal_distribution<float> height(0.0f, 300.0f);
+    std::normal_distribution<float> absMag(6.0f, 3.5f);
+    std::uniform_int_distribution<int> spectralClass(StellarClass::Spectral_O, StellarClass::Spectral_M);
+    std::uniform_int_distribution<unsigned int> subclass(0, 9);
+
+    std::ostringstream out(std::ios::binary);
+    out.write("CELSTARS", 8);
+    util::writeLE(out, std::uint16_t(0x0100));
+    util::writeLE(out, count);
+
+    for (std::uint32_t i = 0; i < count; ++i)
+    {
+        float r = radius(rng);
+        float theta = angle(rng);
+        StellarClass sc(StellarClass::NormalStar,
+                        static_cast<StellarClass::SpectralClass>(spectralClass(rng)),
+                        subclass(rng),
+                        StellarClass::Lum_V);
+
+        util::writeLE(out, i + 1);
+        util::writeLE(out, r * std::cos(theta));
+        util::writeLE(out, height(rng));
+        util::writeLE(out, r * std::sin(theta));
+        util::writeLE(out, static_cast<std::int16_t>(std::clamp(absMag(rng), -10.0f, 20.0f) * 256.0f));
+        util::writeLE(out, sc.packV1());
+    }
+
+    return out.str();
+}
+
+std::string
+makeSyntheticDSOs(std::uint32_t count)
+{
+    std::mt19937 rng(20240102);
+    std::uniform_real_distribution<double> direction(-1.0, 1.0);
+    std::exponential_distribution<double> distance(1.0 / 5.0e7);
+    std::uniform_real_distribution<float> radius(5.0f, 50000.0f);
+    std::normal_distribution<float> absMag(-18.0f, 3.0f);
+
+    std::string dsc;
+    for (std::uint32_t i = 0; i < count; ++i)
+    {
+        Eigen::Vector3d position(direction(rng), direction(rng), direction(rng));
+        position = position.normalized() * distance(rng);
+        fmt::format_to(std::back_inserter(dsc),
+                       "OpenCluster \"Bench {}\"\n{{\n\tPosition [ {} {} {} ]\n\tRadius {}\n\tAbsMag {}\n}}\n",
+                       i,
+                       position.x(),
+                       position.y(),
+                       position.z(),
+                       radius(rng),
+                       absMag(rng));
+    }
+
+    return dsc;
+}
+
+std::unique_ptr<StarDatabase>
+loadStars(const Options& options)
+{
+    StarDatabaseBuilder builder;
+    builder.setNameDatabase(std::make_unique<StarNameDatabase>());
+    if (options.starsFile.empty())
+    {
+        std::istringstream in(makeSyntheticStars(options.starCount), std::ios::binary);
+        if (!builder.loadBinary(in))
+            return nullptr;
+    }
+    else if (!builder.loadBinary(options.starsFile))
+    {
+        return nullptr;
+    }
+
+    return builder.finish();
+}
+
+std::unique_ptr<DSODatabase>
+loadDSOs(const Options& options)
+{
+    DSODatabaseBuilder builder;
+    if (options.dsoFile.empty())
+    {
+        std::istringstream in(makeSyntheticDSOs(options.dsoCount));
+        if (!builder.load(in))
+            return nullptr;
+    }
+    else
+    {
+        std::ifstream in(options.dsoFile);
+        if (!in.good() || !builder.load(in, options.dsoFile.parent_path()))
+            return nullptr;
+    }
+
+    return builder.finish();
+}
+
+template<typename PREC>
+std::array<Eigen::Hyperplane<PREC, 3>, 5>
+computeFrustumPlanes(const Viewpoint& viewpoint, float fovY, float aspectRatio)
+{
+    using VectorType = Eigen::Matrix<PREC, 3, 1>;
+
+    Eigen::Matrix<PREC, 3, 3> rot = viewpoint.orientation.cast<PREC>().toRotationMatrix().transpose();
+    PREC h = std::tan(static_cast<PREC>(fovY) / 2);
+    PREC w = h * static_cast<PREC>(aspectRatio);
+
+    std::array<VectorType, 5> planeNormals
+    {
+        VectorType(0, 1, -h),
+        VectorType(0, -1, -h),
+        VectorType(1, 0, -w),
+        VectorType(-1, 0, -w),
+        VectorType(0, 0, -1),
+    };
+
+    std::array<Eigen::Hyperplane<PREC, 3>, 5> frustumPlanes;
+    for (unsigned int i = 0; i < 5; ++i)
+    {
+        frustumPlanes[i] = Eigen::Hyperplane<PREC, 3>(rot * planeNormals[i].normalized(),
+                                                      viewpoint.position.cast<PREC>());
+    }
+
+    return frustumPlanes;
+}
+
+void
+printHeader()
+{
+    fmt::print("{:<34} {:<14} {:>10} {:>12} {:>10} {:>10} {:>10}\n",
+               "benchmark", "viewpoint", "nodes", "objects", "found", "ms", "ns/object");
+}
+
+void
+printResult(std::string_view benchmark, const Viewpoint& viewpoint, const Counts& counts, double ns)
+{
+    double nsPerObject = counts.objects > 0 ? ns / static_cast<double>(counts.objects) : 0.0;
+    fmt::print("{:<34} {:<14} {:>10} {:>12} {:>10} {:>10.3f} {:>10.2f}\n",
+               benchmark, viewpoint.name, counts.nodes, counts.objects, counts.found, ns * 1.0e-6, nsPerObject);
+}
+
+constexpr float BenchFovY = 0.7854f;
+constexpr float BenchAspectRatio = 16.0f / 9.0f;
+constexpr float CloseStarsRadius = 50.0f;
+
+void
+benchmarkStars(const StarDatabase& starDB, const std::vector<Viewpoint>& viewpoints, unsigned int iterations)
+{
+    const engine::StarOctree& octree = *starDB.getOctree();
+    fmt::print("\nStar octree: {} stars, {} nodes\n", octree.size(), octree.nodeCount());
+    printHeader();
+
+    for (const Viewpoint& viewpoint : viewpoints)
+    {
+        const Eigen::Vector3f position = viewpoint.position.cast<float>();
+        auto planes = computeFrustumPlanes<float>(viewpoint, BenchFovY, BenchAspectRatio);
+
+        // Counts of the octree traversal, shared by the timed variants
+        Counts counts;
+        {
+            CountingStarHandler handler;
+            engine::StarOctreeVisibleObjectsProcessor processor(&handler, position, planes, viewpoint.limitingMag);
+            CountingProcessor counter(processor);
+            octree.processDepthFirst(counter);
+            counts = { counter.nodes, counter.objects, handler.found };
+        }
+
+        double ns = timeRuns(iterations, [&]
+        {
+            CountingStarHandler handler;
+            engine::StarOctreeVisibleObjectsProcessor processor(&handler, position, planes, viewpoint.limitingMag);
+            CountingProcessor counter(processor);
+            octree.processDepthFirst(counter);
+        });
+        printResult("StarOctree processDepthFirst scalar", viewpoint, counts, ns);
+
+        ns = timeRuns(iterations, [&]
+        {
+            CountingStarHandler handler;
+            engine::StarOctreeVisibleObjectsProcessor processor(&handler, position, planes, viewpoint.limitingMag);
+            octree.processDepthFirst(processor);
+        });
+        printResult("StarOctree processDepthFirst", viewpoint, counts, ns);
+
+        Counts breadthCounts;
+        ns = timeRuns(iterations, [&]
+        {
+            CountingStarHandler handler;
+            engine::StarOctreeVisibleObjectsProcessor processor(&handler, position, planes, viewpoint.limitingMag);
+            CountingProcessor counter(processor);
+            octree.processBreadthFirst(counter);
+            breadthCounts = { counter.nodes, counter.objects, handler.found };
+        });
+        printResult("StarOctree processBreadthFirst", viewpoint, breadthCounts, ns);
+
+        auto findVisible = [&](std::string_view name, util::ThreadPool* threadPool, StarVisibilityCache* cache)
+        {
+            Counts findCounts = counts;
+            double findNs = timeRuns(iterations, [&]
+            {
+                CountingStarHandler handler;
+                starDB.findVisibleStars(handler,
+                                        position,
+                                        viewpoint.orientation,
+                                        BenchFovY,
+                                        BenchAspectRatio,
+                                        viewpoint.limitingMag,
+                                        threadPool,
+                                        cache);
+                findCounts.found = handler.found;
+            });
+            printResult(name, viewpoint, findCounts, findNs);
+        };
+
+        findVisible("findVisibleStars", nullptr, nullptr);
+        findVisible("findVisibleStars parallel", util::GetThreadPool(), nullptr);
+
+        StarVisibilityCache cache;
+        findVisible("findVisibleStars cached", util::GetThreadPool(), &cache);
+
+        Counts closeCounts;
+        ns = timeRuns(iterations, [&]
+        {
+            CountingStarHandler handler;
+            engine::StarOctreeCloseObjectsProcessor processor(&handler, position, CloseStarsRadius);
+            CountingProcessor counter(processor);
+            octree.processDepthFirst(counter);
+            closeCounts = { counter.nodes, counter.objects, handler.found };
+        });
+
+        ns = timeRuns(iterations, [&]
+        {
+            CountingStarHandler handler;
+            starDB.findCloseStars(handler, position, CloseStarsRadius);
+        });
+        printResult("findCloseStars", viewpoint, closeCounts, ns);
+    }
+}
+
+void
+benchmarkDSOs(const DSODatabase& dsoDB, const std::vector<Viewpoint>& viewpoints, unsigned int iterations)
+{
+    const engine::DSOOctree& octree = *dsoDB.getOctree();
+    fmt::print("\nDSO octree: {} objects, {} nodes\n", octree.size(), octree.nodeCount());
+    printHeader();
+
+    for (const Viewpoint& viewpoint : viewpoints)
+    {
+        auto planes = computeFrustumPlanes<double>(viewpoint, BenchFovY, BenchAspectRatio);
+
+        Counts counts;
+        double ns = timeRuns(iterations, [&]
+        {
+            CountingDSOHandler handler;
+            engine::DSOOctreeVisibleObjectsProcessor processor(&handler, viewpoint.position, planes, viewpoint.limitingMag);
+            CountingProcessor counter(processor);
+            octree.processDepthFirst(counter);
+            counts = { counter.nodes, counter.objects, handler.found };
+        });
+        printResult("DSOOctree processDepthFirst scalar", viewpoint, counts, ns);
+
+        ns = timeRuns(iterations, [&]
+        {
+            CountingDSOHandler handler;
+            engine::DSOOctreeVisibleObjectsProcessor processor(&handler, viewpoint.position, planes, viewpoint.limitingMag);
+            octree.processDepthFirst(processor);
+        });
+        printResult("DSOOctree processDepthFirst", viewpoint, counts, ns);
+
+        Counts breadthCounts;
+        ns = timeRuns(iterations, [&]
+        {
+            CountingDSOHandler handler;
+            engine::DSOOctreeVisibleObjectsProcessor processor(&handler, viewpoint.position, planes, viewpoint.limitingMag);
+            CountingProcessor counter(processor);
+            octree.processBreadthFirst(counter);
+            breadthCounts = { counter.nodes, counter.objects, handler.found };
+        });
+        printResult("DSOOctree processBreadthFirst", viewpoint, breadthCounts, ns);
+
+        ns = timeRuns(iterations, [&]
+        {
+            CountingDSOHandler handler;
+            dsoDB.findVisibleDSOs(handler,
+                                  viewpoint.position,
+                                  viewpoint.orientation,
+                                  BenchFovY,
+                                  BenchAspectRatio,
+                                  viewpoint.limitingMag);
+            counts.found = handler.found;
+        });
+        printResult("findVisibleDSOs", viewpoint, counts, ns);
+    }
+}
+
+} // end unnamed namespace
+
+int
+main(int argc, char* argv[])
+{
+    Options options;
+    if (!parseCommandLine(argc, argv, options))
+    {
+        Usage();
+        return EXIT_FAILURE;
+    }
+
+    util::CreateLogger(util::Level::Warning);
+
+    auto starDB = loadStars(options);
+    if (starDB == nullptr)
+    {
+        fmt::print(stderr, "Error loading stars\n");
+        return EXIT_FAILURE;
+    }
+
+    auto dsoDB = loadDSOs(options);
+    if (dsoDB == nullptr)
+    {
+        fmt::print(stderr, "Error loading deep sky objects\n");
+        return EXIT_FAILURE;
+    }
+
+    const Eigen::Quaternionf forward = Eigen::Quaternionf::Identity();
+    const Eigen::Quaternionf galacticCenter(Eigen::AngleAxisf(1.2f, Eigen::Vector3f::UnitY()) *
+                                            Eigen::AngleAxisf(-0.3f, Eigen::Vector3f::UnitX()));
+
+    const std::vector<Viewpoint> starViewpoints
+    {
+        { "sun mag 6"sv, Eigen::Vector3d::Zero(), forward, 6.0f },
+        { "sun mag 12"sv, Eigen::Vector3d::Zero(), galacticCenter, 12.0f },
+        { "500 ly mag 8"sv, Eigen::Vector3d(300.0, 100.0, -400.0), galacticCenter, 8.0f },
+        { "5000 ly mag 10"sv, Eigen::Vector3d(-4000.0, 500.0, 3000.0), forward, 10.0f },
+    };
+
+    const std::vector<Viewpoint> dsoViewpoints
+    {
+        { "sun mag 6"sv, Eigen::Vector3d::Zero(), forward, 6.0f },
+        { "sun mag 14"sv, Eigen::Vector3d::Zero(), galacticCenter, 14.0f },
+        { "10 Mly mag 10"sv, Eigen::Vector3d(6.0e6, -2.0e6, 7.0e6), forward, 10.0f },
+    };
+
+    fmt::print("{} worker threads, {} iterations, best time reported\n",
+               util::GetThreadPool()->threadCount(), options.iterations);
+
+    benchmarkStars(*starDB, starViewpoints, options.iterations);
+    benchmarkDSOs(*dsoDB, dsoViewpoints, options.iterations);
+
+    return EXIT_SUCCESS;
+}
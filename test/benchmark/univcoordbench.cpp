@@ -0,0 +1,160 @@
+// univcoordbench.cpp
+//
+// Copyright (C) 2025, Celestia Development Team
+//
+// Benchmarks of the offsets between universal coordinates.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <random>
+#include <string_view>
+#include <vector>
+
+#include <Eigen/Core>
+
+#include <fmt/format.h>
+
+#include <celastro/astro.h>
+#include <celengine/univcoord.h>
+#include "benchutil.h"
+
+namespace astro = celestia::astro;
+
+using benchutil::parseCount;
+using benchutil::timeRuns;
+
+using namespace std::string_view_literals;
+
+namespace
+{
+
+struct Options
+{
+    std::uint32_t count{ 1000000 };
+    unsigned int iterations{ 10 };
+};
+
+void
+Usage()
+{
+    fmt::print(stderr,
+               "Usage: univcoordbench [options]\n"
+               "  --count <n>          : number of coordinates (default 1000000)\n"
+               "  --iterations <n>     : timed repetitions of each benchmark (default 10)\n");
+}
+
+bool
+parseCommandLine(int argc, char* argv[], Options& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string_view arg = argv[i];
+        if (i + 1 == argc)
+            return false;
+
+        const char* value = argv[++i];
+        if (arg == "--count"sv)
+        {
+            if (!parseCount(value, options.count) || options.count == 0)
+                return false;
+        }
+        else if (arg == "--iterations"sv)
+        {
+            std::uint32_t iterations;
+            if (!parseCount(value, iterations) || iterations == 0)
+                return false;
+            options.iterations = iterations;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Coordinates scattered around an origin, at the distances of the bodies of
+// a solar system or of the nearby stars
+std::vector<UniversalCoord>
+makeCoords(const UniversalCoord& origin, double spreadKm, std::uint32_t count)
+{
+    std::mt19937 rng(20250101);
+    std::normal_distribution<double> offset(0.0, spreadKm);
+
+    std::vector<UniversalCoord> coords;
+    coords.reserve(count);
+    for (std::uint32_t i = 0; i < count; ++i)
+        coords.push_back(origin.offsetKm(Eigen::Vector3d(offset(rng), offset(rng), offset(rng))));
+    return coords;
+}
+
+void
+runBenchmarks(std::string_view name, const std::vector<UniversalCoord>& coords,
+              const UniversalCoord& origin, unsigned int iterations)
+{
+    std::vector<Eigen::Vector3d> offsets(coords.size());
+    const double scale = astro::microLightYearsToKilometers(1.0);
+
+    // The offsets computed with the generic R128 subtraction and conversion
+    double generic = timeRuns(iterations, [&]
+    {
+        for (std::size_t i = 0; i < coords.size(); ++i)
+        {
+            const UniversalCoord& uc = coords[i];
+            offsets[i] = Eigen::Vector3d(static_cast<double>(uc.x - origin.x),
+                                         static_cast<double>(uc.y - origin.y),
+                                         static_cast<double>(uc.z - origin.z)) * scale;
+        }
+    });
+    std::vector<Eigen::Vector3d> reference = offsets;
+
+    double single = timeRuns(iterations, [&]
+    {
+        for (std::size_t i = 0; i < coords.size(); ++i)
+            offsets[i] = coords[i].offsetFromKm(origin);
+    });
+    bool singleMatches = offsets == reference;
+
+    double batched = timeRuns(iterations, [&]
+    {
+        UniversalCoord::OffsetsFromKm(coords, origin, offsets.data());
+    });
+    bool batchedMatches = offsets == reference;
+
+    auto count = static_cast<double>(coords.size());
+    fmt::print("{:<20} {:<14} {:>10.3f} {:>10.2f}\n", name, "generic", generic * 1.0e-6, generic / count);
+    fmt::print("{:<20} {:<14} {:>10.3f} {:>10.2f} {}\n", name, "offsetFromKm", single * 1.0e-6, single / count,
+               singleMatches ? "" : "MISMATCH");
+    fmt::print("{:<20} {:<14} {:>10.3f} {:>10.2f} {}\n", name, "OffsetsFromKm", batched * 1.0e-6, batched / count,
+               batchedMatches ? "" : "MISMATCH");
+}
+
+} // end unnamed namespace
+
+int
+main(int argc, char* argv[])
+{
+    Options options;
+    if (!parseCommandLine(argc, argv, options))
+    {
+        Usage();
+        return EXIT_FAILURE;
+    }
+
+    const UniversalCoord origin = UniversalCoord::CreateLy(Eigen::Vector3d(-35.2, 8.7, 112.4));
+
+    fmt::print("{:<20} {:<14} {:>10} {:>10}\n", "coordinates", "benchmark", "ms", "ns/coord");
+    runBenchmarks("solar system"sv, makeCoords(origin, astro::AUtoKilometers(40.0), options.count),
+                  origin, options.iterations);
+    runBenchmarks("nearby stars"sv, makeCoords(origin, astro::lightYearsToKilometers(50.0), options.count),
+                  origin, options.iterations);
+
+    return EXIT_SUCCESS;
+}
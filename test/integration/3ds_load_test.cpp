@@ -1,5 +1,7 @@
 #include <cstdint>
 #include <memory>
+#include <string>
+#include <utility>
 
 #include <doctest.h>
 
@@ -38,4 +40,49 @@ TEST_CASE("Load a 3DS file")
     REQUIRE(vertexCount == 63);
 }
 
+TEST_CASE("Read a 3DS file through a handler")
+{
+    struct CountingHandler : M3DSceneHandler
+    {
+        void addMaterial(M3DMaterial&&) override { ++materialCount; }
+        void beginModel(std::string&& name) override
+        {
+            REQUIRE(!inModel);
+            inModel = true;
+            modelName = std::move(name);
+        }
+        void addTriMesh(M3DTriangleMesh&& mesh) override
+        {
+            REQUIRE(inModel);
+            ++meshCount;
+            faceCount += static_cast<std::uint32_t>(mesh.getFaceCount());
+        }
+        void endModel() override
+        {
+            REQUIRE(inModel);
+            inModel = false;
+            ++modelCount;
+        }
+
+        bool inModel{ false };
+        std::string modelName;
+        std::uint32_t materialCount{ 0 };
+        std::uint32_t modelCount{ 0 };
+        std::uint32_t meshCount{ 0 };
+        std::uint32_t faceCount{ 0 };
+    };
+
+    CountingHandler handler;
+    REQUIRE(Read3DSFile("icosphere.3ds", handler));
+    REQUIRE(!handler.inModel);
+    REQUIRE(handler.materialCount == 1);
+    REQUIRE(handler.modelCount == 1);
+    REQUIRE(handler.meshCount == 1);
+    REQUIRE(handler.faceCount == 80);
+
+    std::unique_ptr<M3DScene> scene = Read3DSFile("icosphere.3ds");
+    REQUIRE(scene != nullptr);
+    REQUIRE(scene->getModel(0)->getName() == handler.modelName);
+}
+
 TEST_SUITE_END();
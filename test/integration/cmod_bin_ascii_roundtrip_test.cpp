@@ -58,4 +58,30 @@ TEST_CASE("CMOD binary to ASCII roundtrip")
                        std::istreambuf_iterator<char>(roundtrippedData), end));
 }
 
+TEST_CASE("CMOD mapped file load")
+{
+    std::vector<fs::path> paths;
+    cmod::HandleGetter handleGetter = [&](const fs::path& path)
+    {
+        paths.push_back(path);
+        return static_cast<ResourceHandle>(paths.size() - 1);
+    };
+    cmod::SourceGetter sourceGetter = [&](ResourceHandle handle) { return paths[handle]; };
+
+    std::unique_ptr<cmod::Model> mappedModel = cmod::LoadModel(fs::path("testmodel.cmod"), handleGetter);
+    REQUIRE(mappedModel != nullptr);
+
+    std::ifstream f("testmodel.cmod", std::ios::in | std::ios::binary);
+    REQUIRE(f.good());
+    std::stringstream sourceData;
+    sourceData << f.rdbuf();
+
+    std::stringstream savedData;
+    REQUIRE(cmod::SaveModelBinary(mappedModel.get(), savedData, sourceGetter));
+
+    std::istreambuf_iterator<char> end;
+    REQUIRE(std::equal(std::istreambuf_iterator<char>(sourceData), end,
+                       std::istreambuf_iterator<char>(savedData), end));
+}
+
 TEST_SUITE_END();
@@ -1,4 +1,6 @@
 #include <memory>
+#include <string>
+#include <string_view>
 #include <utility>
 
 #include <celutil/associativearray.h>
@@ -105,6 +107,29 @@ TEST_CASE("AssociativeArray")
             REQUIRE(c->alpha() == doctest::Approx(0x78 / 255.).epsilon(EPSILON));
         }
     }
+
+    SUBCASE("Keys")
+    {
+        AssociativeArray h;
+        std::string key = "Radius";
+        h.addValue(key, Value(6378.0));
+        h.addValue("UnknownKey", Value(1.0));
+        h.addValue("Radius", Value(1.0));
+        // The key doesn't need to outlive the array
+        key = "Mass";
+        h.addValue("Albedo", Value(0.3));
+
+        REQUIRE(h.getNumber<double>("Radius") == 6378.0);
+        REQUIRE(h.getNumber<double>("UnknownKey") == 1.0);
+        REQUIRE(h.getNumber<double>("Albedo") == 0.3);
+        REQUIRE(h.getValue("Mass") == nullptr);
+        REQUIRE(h.getValue("Unknown") == nullptr);
+
+        std::string keys;
+        auto action = [&keys](std::string_view k, const Value&) { keys.append(k).append(" "); };
+        h.for_all(action);
+        REQUIRE(keys == "Albedo Radius UnknownKey ");
+    }
 }
 
 TEST_SUITE_END();
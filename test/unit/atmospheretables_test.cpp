@@ -0,0 +1,103 @@
+#include <celengine/atmosphere.h>
+#include <celrender/atmospheretables.h>
+#include <celutil/threadpool.h>
+
+#include <doctest.h>
+
+using namespace celestia::render;
+using celestia::util::ThreadPool;
+
+namespace
+{
+
+Atmosphere
+earthLikeAtmosphere()
+{
+    Atmosphere atmosphere;
+    atmosphere.mieScaleHeight = 12.0f;
+    atmosphere.mieCoeff = 0.0027f;
+    atmosphere.miePhaseAsymmetry = -0.3f;
+    atmosphere.rayleighCoeff = Eigen::Vector3f(0.0057f, 0.0135f, 0.0331f);
+    return atmosphere;
+}
+
+constexpr unsigned int TopHeight = AtmosphereTables::HeightSamples - 1;
+constexpr unsigned int Zenith = AtmosphereTables::ViewAngleSamples - 1;
+constexpr unsigned int Horizon = AtmosphereTables::ViewAngleSamples / 2;
+constexpr unsigned int SunAtZenith = AtmosphereTables::SunAngleSamples - 1;
+
+} // end unnamed namespace
+
+TEST_SUITE_BEGIN("AtmosphereTables");
+
+TEST_CASE("Parameters are relative to the sky sphere")
+{
+    auto params = AtmosphereTableParameters::create(earthLikeAtmosphere(), 6378.0f);
+    REQUIRE(params.groundRadius < 1.0f);
+    REQUIRE(params.groundRadius > 0.99f);
+    REQUIRE(params.scaleHeight == doctest::Approx(12.0f / (6378.0f + 12.0f * -std::log(AtmosphereExtinctionThreshold))));
+    REQUIRE(params == AtmosphereTableParameters::create(earthLikeAtmosphere(), 6378.0f));
+    REQUIRE(params != AtmosphereTableParameters::create(earthLikeAtmosphere(), 3000.0f));
+}
+
+TEST_CASE("Parameterization covers the view and sun angles")
+{
+    float rg = 0.99f;
+    REQUIRE(AtmosphereTables::toRadius(0.0f, rg) == doctest::Approx(rg));
+    REQUIRE(AtmosphereTables::toRadius(1.0f, rg) == doctest::Approx(1.0f));
+
+    REQUIRE(AtmosphereTables::toMu(0.0f, 1.0f, rg) == doctest::Approx(-1.0f));
+    REQUIRE(AtmosphereTables::toMu(1.0f, 1.0f, rg) == doctest::Approx(1.0f));
+    REQUIRE(AtmosphereTables::toMu(0.5f, rg, rg) == doctest::Approx(0.0f));
+
+    REQUIRE(AtmosphereTables::toMuS(1.0f, rg) == doctest::Approx(1.0f));
+    REQUIRE(AtmosphereTables::toMuS(0.0f, rg) < 0.0f);
+}
+
+TEST_CASE("Transparent atmosphere")
+{
+    Atmosphere atmosphere;
+    atmosphere.mieScaleHeight = 12.0f;
+    auto tables = AtmosphereTables::compute(AtmosphereTableParameters::create(atmosphere, 6378.0f), nullptr);
+
+    for (unsigned int i = 0; i < AtmosphereTables::HeightSamples; ++i)
+    {
+        for (unsigned int j = 0; j < AtmosphereTables::ViewAngleSamples; ++j)
+            REQUIRE(tables.transmittance(i, j).minCoeff() == doctest::Approx(1.0f));
+    }
+}
+
+TEST_CASE("Earth-like atmosphere")
+{
+    auto tables = AtmosphereTables::compute(AtmosphereTableParameters::create(earthLikeAtmosphere(), 6378.0f), nullptr);
+
+    SUBCASE("Transmittance falls toward the horizon")
+    {
+        REQUIRE(tables.transmittance(TopHeight, Zenith).minCoeff() > 0.99f);
+        REQUIRE(tables.transmittance(0, Zenith).x() < 1.0f);
+        REQUIRE(tables.transmittance(0, Zenith + 1 - Horizon / 2).z() < tables.transmittance(0, Zenith).z());
+        REQUIRE(tables.transmittance(0, Zenith).z() < tables.transmittance(0, Zenith).x());
+    }
+
+    SUBCASE("Sky is darker when the sun sets")
+    {
+        REQUIRE(tables.inscatter(0, Zenith, SunAtZenith).z() > 0.0f);
+        REQUIRE(tables.inscatter(0, Zenith, 0).maxCoeff() < tables.inscatter(0, Zenith, SunAtZenith).z());
+        REQUIRE(tables.inscatterScale() > 0.0f);
+    }
+}
+
+TEST_CASE("Tables computed in parallel")
+{
+    auto params = AtmosphereTableParameters::create(earthLikeAtmosphere(), 6378.0f);
+    auto serial = AtmosphereTables::compute(params, nullptr);
+
+    ThreadPool threadPool(4);
+    auto parallel = AtmosphereTables::compute(params, &threadPool);
+
+    REQUIRE(serial.transmittanceTexels() == parallel.transmittanceTexels());
+    REQUIRE(serial.inscatterTexels() == parallel.inscatterTexels());
+    REQUIRE(serial.inscatterScale() == parallel.inscatterScale());
+}
+
+TEST_SUITE_END();
@@ -0,0 +1,82 @@
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <system_error>
+
+#include <celcompat/filesystem.h>
+#include <celutil/atomicfile.h>
+
+#include <doctest.h>
+
+using celestia::util::AtomicFile;
+
+namespace
+{
+
+std::string
+readFile(const fs::path& path)
+{
+    std::ifstream in(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+bool
+isEmptyDirectory(const fs::path& path)
+{
+    std::error_code ec;
+    return fs::directory_iterator(path, ec) == fs::directory_iterator();
+}
+
+} // end unnamed namespace
+
+TEST_SUITE_BEGIN("AtomicFile");
+
+TEST_CASE("AtomicFile")
+{
+    const fs::path directory = fs::temp_directory_path() / "celestia_atomicfile_test";
+    std::error_code ec;
+    fs::remove_all(directory, ec);
+    fs::create_directories(directory, ec);
+    const fs::path path = directory / "file.bin";
+
+    SUBCASE("Committed files replace the destination")
+    {
+        {
+            AtomicFile file(path);
+            REQUIRE(file.isOpen());
+            file.stream() << "first";
+            REQUIRE(file.commit());
+        }
+        REQUIRE(readFile(path) == "first");
+
+        AtomicFile file(path);
+        file.stream() << "second";
+        REQUIRE(readFile(path) == "first");
+        REQUIRE(file.commit());
+        REQUIRE(readFile(path) == "second");
+    }
+
+    SUBCASE("Concurrent writers have their own temporary files")
+    {
+        AtomicFile first(path);
+        AtomicFile second(path);
+        first.stream() << "first";
+        second.stream() << "second";
+        REQUIRE(second.commit());
+        REQUIRE(first.commit());
+        REQUIRE(readFile(path) == "first");
+    }
+
+    SUBCASE("Files which aren't committed are removed")
+    {
+        {
+            AtomicFile file(path);
+            file.stream() << "partial";
+        }
+        REQUIRE(isEmptyDirectory(directory));
+    }
+
+    fs::remove_all(directory, ec);
+}
+
+TEST_SUITE_END();
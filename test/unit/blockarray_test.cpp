@@ -0,0 +1,113 @@
+#include <atomic>
+#include <cstddef>
+#include <list>
+#include <numeric>
+#include <iterator>
+#include <sstream>
+#include <vector>
+
+#include <celutil/blockarray.h>
+#include <celutil/threadpool.h>
+
+#include <doctest.h>
+
+using celestia::util::ThreadPool;
+
+TEST_SUITE_BEGIN("BlockArray");
+
+TEST_CASE("Append fills the blocks")
+{
+    std::vector<int> values(10);
+    std::iota(values.begin(), values.end(), 0);
+
+    BlockArray<int, 4> array;
+    array.push_back(-1);
+    array.append(values.begin(), values.end());
+    REQUIRE(array.size() == 11);
+    REQUIRE(array.block_count() == 3);
+    REQUIRE(array[0] == -1);
+    for (int i = 0; i < 10; ++i)
+        REQUIRE(array[i + 1] == i);
+
+    const int* first = &array[1];
+    array.append(values.begin(), values.begin());
+    REQUIRE(array.size() == 11);
+    REQUIRE(&array[1] == first);
+
+    SUBCASE("Input iterators")
+    {
+        std::istringstream in("7 8 9");
+        array.append(std::istream_iterator<int>(in), std::istream_iterator<int>());
+        REQUIRE(array.size() == 14);
+        REQUIRE(array.back() == 9);
+    }
+
+    SUBCASE("Non-contiguous ranges")
+    {
+        std::list<int> list{ 20, 21, 22, 23, 24 };
+        array.append(list.begin(), list.end());
+        REQUIRE(array.size() == 16);
+        REQUIRE(array[11] == 20);
+        REQUIRE(array[15] == 24);
+    }
+}
+
+TEST_CASE("Blocks are visited in order")
+{
+    BlockArray<int, 4> array;
+    for (int i = 0; i < 10; ++i)
+        array.push_back(i);
+
+    std::vector<std::size_t> counts;
+    std::vector<int> visited;
+    const auto& constArray = array;
+    constArray.for_each_block([&](const int* data, std::size_t count)
+    {
+        counts.push_back(count);
+        visited.insert(visited.end(), data, data + count);
+    });
+    REQUIRE(counts == std::vector<std::size_t>{ 4, 4, 2 });
+    REQUIRE(visited == std::vector<int>(array.begin(), array.end()));
+
+    array.for_each_block([](int* data, std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+            data[i] *= 2;
+    });
+    REQUIRE(array[9] == 18);
+}
+
+TEST_CASE("Blocks are visited in parallel")
+{
+    BlockArray<std::size_t, 16> array;
+    for (std::size_t i = 0; i < 1000; ++i)
+        array.push_back(0);
+
+    ThreadPool threadPool(3);
+    std::atomic<std::size_t> total{ 0 };
+    array.for_each_block(threadPool, [&total](std::size_t* data, std::size_t count, std::size_t offset)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+            data[i] = offset + i;
+        total += count;
+    });
+
+    REQUIRE(total == 1000);
+    for (std::size_t i = 0; i < array.size(); ++i)
+        REQUIRE(array[i] == i);
+}
+
+TEST_CASE("Pop back releases empty blocks")
+{
+    std::vector<int> values{ 1, 2, 3 };
+    BlockArray<int, 2> array;
+    array.append(values.begin(), values.end());
+    REQUIRE(array.block_count() == 2);
+
+    array.pop_back();
+    REQUIRE(array.size() == 2);
+    REQUIRE(array.block_count() == 1);
+    REQUIRE(array.back() == 2);
+}
+
+TEST_SUITE_END();
@@ -0,0 +1,78 @@
+#include <cstdint>
+
+#include <celimage/bufferpool.h>
+
+#include <doctest.h>
+
+using namespace celestia::engine;
+
+TEST_SUITE_BEGIN("ImageBufferPool");
+
+TEST_CASE("Size classes")
+{
+    REQUIRE(ImageBufferPool::GetSizeClass(1) == 4096);
+    REQUIRE(ImageBufferPool::GetSizeClass(4096) == 4096);
+    REQUIRE(ImageBufferPool::GetSizeClass(4097) == 5120);
+    REQUIRE(ImageBufferPool::GetSizeClass(8192) == 8192);
+    REQUIRE(ImageBufferPool::GetSizeClass(512 * 512 * 3) == 512 * 512 * 3);
+    for (std::size_t size : { 5000U, 70000U, 1000001U })
+    {
+        std::size_t sizeClass = ImageBufferPool::GetSizeClass(size);
+        REQUIRE(sizeClass >= size);
+        REQUIRE(sizeClass - size < sizeClass / 4);
+    }
+}
+
+TEST_CASE("Released buffers are reused")
+{
+    ImageBufferPool pool;
+    std::uint8_t* buffer = pool.allocate(10000);
+    REQUIRE(reinterpret_cast<std::uintptr_t>(buffer) % ImageBufferPool::Alignment == 0);
+
+    pool.release(buffer);
+    REQUIRE(pool.getPooledSize() == ImageBufferPool::GetSizeClass(10000));
+
+    // Same size class
+    std::uint8_t* reused = pool.allocate(10100);
+    REQUIRE(reused == buffer);
+    REQUIRE(pool.getPooledSize() == 0);
+
+    std::uint8_t* other = pool.allocate(20000);
+    REQUIRE(other != buffer);
+
+    pool.release(reused);
+    pool.release(other);
+    pool.clear();
+    REQUIRE(pool.getPooledSize() == 0);
+}
+
+TEST_CASE("Buffers over the capacity are freed")
+{
+    ImageBufferPool pool;
+    pool.setCapacity(16384);
+    std::uint8_t* buffer1 = pool.allocate(12000);
+    std::uint8_t* buffer2 = pool.allocate(12000);
+    pool.release(buffer1);
+    pool.release(buffer2);
+    REQUIRE(pool.getPooledSize() == ImageBufferPool::GetSizeClass(12000));
+
+    pool.setCapacity(0);
+    REQUIRE(pool.getPooledSize() == 0);
+}
+
+TEST_CASE("Allocated image buffers are cleared")
+{
+    {
+        ImageBuffer buffer = AllocateImageBuffer(5000);
+        for (std::size_t i = 0; i < 5000; ++i)
+            buffer[i] = 0xff;
+    }
+
+    ImageBuffer buffer = AllocateImageBuffer(5000);
+    bool cleared = true;
+    for (std::size_t i = 0; i < 5000; ++i)
+        cleared = cleared && buffer[i] == 0;
+    REQUIRE(cleared);
+}
+
+TEST_SUITE_END();
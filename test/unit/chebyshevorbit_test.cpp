@@ -0,0 +1,116 @@
+#include <cmath>
+#include <cstddef>
+#include <memory>
+
+#include <celastro/date.h>
+#include <celcompat/numbers.h>
+#include <celephem/chebyshevorbit.h>
+
+#include <doctest.h>
+
+using namespace celestia;
+using namespace celestia::ephem;
+
+namespace
+{
+
+// Circular orbit with a small fast perturbation
+class TestOrbit : public Orbit
+{
+ public:
+    explicit TestOrbit(double jump = 0.0) : jump(jump) {}
+
+    Eigen::Vector3d
+    positionAtTime(double jd) const override
+    {
+        ++evaluations;
+        double t = jd - astro::J2000;
+        double a = Radius + 10.0 * std::sin(t * 3.1);
+        if (t > JumpTime)
+            a += jump;
+        return Eigen::Vector3d(a * std::cos(t * Rate), a * std::sin(t * Rate), 20.0 * std::sin(t * 0.5));
+    }
+
+    Eigen::Vector3d
+    velocityAtTime(double jd) const override
+    {
+        double t = jd - astro::J2000;
+        double a = Radius + 10.0 * std::sin(t * 3.1);
+        if (t > JumpTime)
+            a += jump;
+        double da = 31.0 * std::cos(t * 3.1);
+        return Eigen::Vector3d(da * std::cos(t * Rate) - a * Rate * std::sin(t * Rate),
+                               da * std::sin(t * Rate) + a * Rate * std::cos(t * Rate),
+                               10.0 * std::cos(t * 0.5));
+    }
+
+    double getPeriod() const override { return 2.0 * celestia::numbers::pi / Rate; }
+    double getBoundingRadius() const override { return Radius * 1.1; }
+
+    mutable std::size_t evaluations{ 0 };
+
+ private:
+    static constexpr double Radius = 400000.0;
+    static constexpr double Rate = 0.23;
+    static constexpr double JumpTime = 3.3;
+
+    double jump;
+};
+
+} // end unnamed namespace
+
+TEST_SUITE_BEGIN("Chebyshev orbit");
+
+TEST_CASE("Approximated positions and velocities are within the tolerance")
+{
+    constexpr double tolerance = 1.0e-3;
+    auto orbit = std::make_shared<TestOrbit>();
+    ChebyshevOrbit cached(orbit, tolerance);
+
+    for (int i = 0; i < 2000; ++i)
+    {
+        double jd = astro::J2000 - 20.0 + 0.0271 * i;
+        Eigen::Vector3d expected = orbit->positionAtTime(jd);
+        REQUIRE((cached.positionAtTime(jd) - expected).norm() <= tolerance);
+        REQUIRE((cached.velocityAtTime(jd) - orbit->velocityAtTime(jd)).norm() <= 1.0e-3);
+    }
+
+    REQUIRE(cached.getSegmentCount() > 0);
+    REQUIRE(cached.getPeriod() == orbit->getPeriod());
+
+    // Only the fits evaluate the orbit once the segments are known
+    orbit->evaluations = 0;
+    for (int i = 0; i < 100; ++i)
+        cached.positionAtTime(astro::J2000 - 10.0 + 0.1 * i);
+    REQUIRE(orbit->evaluations == 0);
+}
+
+TEST_CASE("Discontinuities are evaluated directly")
+{
+    constexpr double tolerance = 1.0e-3;
+    auto orbit = std::make_shared<TestOrbit>(5000.0);
+    ChebyshevOrbit cached(orbit, tolerance);
+
+    for (double t : { 3.2999, 3.3001, 1.0, 5.0 })
+    {
+        double jd = astro::J2000 + t;
+        REQUIRE((cached.positionAtTime(jd) - orbit->positionAtTime(jd)).norm() <= tolerance);
+    }
+}
+
+TEST_CASE("Orbits are only cached with a tolerance")
+{
+    std::shared_ptr<const Orbit> orbit = std::make_shared<TestOrbit>();
+
+    SetOrbitCacheTolerance(0.0);
+    REQUIRE(CreateCachedOrbit(orbit) == orbit);
+
+    SetOrbitCacheTolerance(0.01);
+    auto cached = CreateCachedOrbit(orbit);
+    REQUIRE(cached != orbit);
+    REQUIRE(dynamic_cast<const ChebyshevOrbit*>(cached.get()) != nullptr);
+
+    SetOrbitCacheTolerance(0.0);
+}
+
+TEST_SUITE_END();
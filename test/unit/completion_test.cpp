@@ -0,0 +1,65 @@
+#include <string>
+#include <vector>
+
+#include <celengine/completion.h>
+#include <celengine/star.h>
+
+#include <doctest.h>
+
+using celestia::engine::Completion;
+using celestia::engine::rankCompletions;
+
+namespace
+{
+
+std::vector<std::string>
+names(const std::vector<Completion>& completion)
+{
+    std::vector<std::string> result;
+    for (const auto& c : completion)
+        result.push_back(c.getName());
+    return result;
+}
+
+} // end unnamed namespace
+
+TEST_SUITE_BEGIN("Completion");
+
+TEST_CASE("Exact matches are ranked first, then by brightness")
+{
+    Star bright;
+    bright.setAbsoluteMagnitude(-5.0f);
+    Star medium;
+    medium.setAbsoluteMagnitude(1.0f);
+    Star faint;
+    faint.setAbsoluteMagnitude(10.0f);
+
+    std::vector<Completion> completion;
+    completion.emplace_back("Algol", Selection(&medium));
+    completion.emplace_back("Alnilam", Selection(&bright));
+    completion.emplace_back("Alnair", [&faint] { return Selection(&faint); });
+    completion.emplace_back("Al", Selection(&faint));
+
+    rankCompletions(completion, "al");
+    REQUIRE(names(completion) == std::vector<std::string>{ "Al", "Alnilam", "Algol", "Alnair" });
+}
+
+TEST_CASE("Names of equal brightness are in natural order")
+{
+    Star star1;
+    Star star2;
+    Star star3;
+
+    std::vector<Completion> completion;
+    completion.emplace_back("Star 10", Selection(&star1));
+    completion.emplace_back("Star 9", Selection(&star2));
+    completion.emplace_back("Star 1", Selection(&star3));
+
+    rankCompletions(completion, "Sol/Star");
+    REQUIRE(names(completion) == std::vector<std::string>{ "Star 1", "Star 9", "Star 10" });
+
+    rankCompletions(completion, "Sol/star 9");
+    REQUIRE(names(completion) == std::vector<std::string>{ "Star 9", "Star 1", "Star 10" });
+}
+
+TEST_SUITE_END();
@@ -0,0 +1,83 @@
+#include <cstddef>
+#include <vector>
+
+#include <celastro/date.h>
+#include <celastro/units.h>
+
+#include <doctest.h>
+
+using namespace celestia::astro;
+
+namespace
+{
+
+static_assert(TAItoTT(TTtoTAI(J2000)) == J2000);
+static_assert(*getLengthScale(LengthUnit::Meter) == 1e-3);
+static_assert(*getTimeScale(TimeUnit::Day) == 1.0);
+static_assert(!getAngleScale(AngleUnit::Default).has_value());
+
+// 1 Jan 2017, when the last leap second of the built-in table was inserted
+constexpr double LastLeapSecond = 2457754.5;
+
+} // end unnamed namespace
+
+TEST_SUITE_BEGIN("Date");
+
+TEST_CASE("UTC leap seconds")
+{
+    // TAI - UTC is 36 s before the leap second of 2017 and 37 s after it
+    REQUIRE(JDUTCtoTAI(LastLeapSecond - 1.0) == LastLeapSecond - 1.0 + secsToDays(36.0));
+    REQUIRE(JDUTCtoTAI(LastLeapSecond + 1.0) == LastLeapSecond + 1.0 + secsToDays(37.0));
+    REQUIRE(JDUTCtoTAI(J2000) == J2000 + secsToDays(32.0));
+    REQUIRE(JDUTCtoTAI(2441000.5) == 2441000.5 + secsToDays(10.0));
+
+    REQUIRE(TAItoJDUTC(JDUTCtoTAI(J2000)) == doctest::Approx(J2000));
+    REQUIRE(TAItoJDUTC(JDUTCtoTAI(LastLeapSecond + 1.0)) == doctest::Approx(LastLeapSecond + 1.0));
+}
+
+TEST_CASE("Leap second is the last second of the day")
+{
+    Date date = TAItoUTC(LastLeapSecond + secsToDays(36.5));
+    REQUIRE(date.year == 2016);
+    REQUIRE(date.month == 12);
+    REQUIRE(date.day == 31);
+    REQUIRE(date.hour == 23);
+    REQUIRE(date.minute == 59);
+    REQUIRE(date.seconds == doctest::Approx(60.5));
+
+    Date after = TAItoUTC(LastLeapSecond + secsToDays(37.5));
+    REQUIRE(after.year == 2017);
+    REQUIRE(after.seconds == doctest::Approx(0.5));
+    REQUIRE(UTCtoTAI(after) == doctest::Approx(LastLeapSecond + secsToDays(37.5)));
+}
+
+TEST_CASE("Batched conversions")
+{
+    std::vector<double> tdb;
+    for (double t = 2440000.5; t < 2470000.5; t += 37.25)
+        tdb.push_back(t);
+    // Unordered times too
+    tdb.push_back(2450000.5);
+    tdb.push_back(2430000.5);
+
+    std::vector<double> utc(tdb.size());
+    TDBtoJDUTC(tdb, utc.data());
+    for (std::size_t i = 0; i < tdb.size(); ++i)
+        REQUIRE(utc[i] == TDBtoJDUTC(tdb[i]));
+
+    std::vector<double> back(utc.size());
+    JDUTCtoTDB(utc, back.data());
+    for (std::size_t i = 0; i < utc.size(); ++i)
+        REQUIRE(back[i] == JDUTCtoTDB(utc[i]));
+
+    std::vector<double> tt = tdb;
+    TDBtoTT(tt, tt.data());
+    for (std::size_t i = 0; i < tdb.size(); ++i)
+        REQUIRE(tt[i] == TDBtoTT(tdb[i]));
+
+    TTtoTDB(tt, tt.data());
+    for (std::size_t i = 0; i < tdb.size(); ++i)
+        REQUIRE(tt[i] == TTtoTDB(TDBtoTT(tdb[i])));
+}
+
+TEST_SUITE_END();
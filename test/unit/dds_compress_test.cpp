@@ -0,0 +1,94 @@
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+
+#include <celimage/dds_compress.h>
+#include <celimage/dds_decompress.h>
+
+#include <doctest.h>
+
+using namespace celestia::engine;
+
+namespace
+{
+
+using Block = std::array<std::uint8_t, 64>;
+
+Block
+MakeGradient(int r0, int g0, int b0, int r1, int g1, int b1)
+{
+    Block pixels;
+    for (int i = 0; i < 16; ++i)
+    {
+        pixels[i * 4 + 0] = static_cast<std::uint8_t>(r0 + (r1 - r0) * i / 15);
+        pixels[i * 4 + 1] = static_cast<std::uint8_t>(g0 + (g1 - g0) * i / 15);
+        pixels[i * 4 + 2] = static_cast<std::uint8_t>(b0 + (b1 - b0) * i / 15);
+        pixels[i * 4 + 3] = static_cast<std::uint8_t>(i * 17);
+    }
+    return pixels;
+}
+
+int
+MaxError(const Block& pixels, const std::array<std::uint32_t, 16>& decoded, int channels)
+{
+    int maxError = 0;
+    for (int i = 0; i < 16; ++i)
+    {
+        for (int c = 0; c < channels; ++c)
+        {
+            int value = static_cast<int>((decoded[i] >> (c * 8)) & 0xff);
+            maxError = std::max(maxError, std::abs(value - pixels[i * 4 + c]));
+        }
+    }
+    return maxError;
+}
+
+} // end unnamed namespace
+
+TEST_SUITE_BEGIN("DDS compression");
+
+TEST_CASE("DXT1 round trip of a solid color")
+{
+    Block pixels = MakeGradient(200, 100, 50, 200, 100, 50);
+    std::array<std::uint8_t, 8> block;
+    CompressBlockDXT1(pixels.data(), block.data());
+
+    std::array<std::uint32_t, 16> decoded;
+    DecompressBlockDXT1(0, 0, 4, block.data(), false, decoded.data());
+    REQUIRE(MaxError(pixels, decoded, 3) <= 4);
+}
+
+TEST_CASE("DXT1 round trip of gradients")
+{
+    // A 16 step gradient spread over four palette entries is off by up to
+    // a sixth of its range. The second one runs against the (1, 1, 1)
+    // diagonal.
+    for (const Block& pixels : { MakeGradient(0, 0, 0, 255, 255, 255),
+                                 MakeGradient(255, 0, 40, 0, 255, 40) })
+    {
+        std::array<std::uint8_t, 8> block;
+        CompressBlockDXT1(pixels.data(), block.data());
+
+        // Four color mode
+        std::uint16_t color0 = block[0] | (block[1] << 8);
+        std::uint16_t color1 = block[2] | (block[3] << 8);
+        REQUIRE(color0 > color1);
+
+        std::array<std::uint32_t, 16> decoded;
+        DecompressBlockDXT1(0, 0, 4, block.data(), false, decoded.data());
+        REQUIRE(MaxError(pixels, decoded, 3) <= 40);
+    }
+}
+
+TEST_CASE("DXT5 round trip keeps alpha")
+{
+    Block pixels = MakeGradient(10, 20, 30, 90, 80, 70);
+    std::array<std::uint8_t, 16> block;
+    CompressBlockDXT5(pixels.data(), block.data());
+
+    std::array<std::uint32_t, 16> decoded;
+    DecompressBlockDXT5(0, 0, 4, block.data(), false, decoded.data());
+    REQUIRE(MaxError(pixels, decoded, 4) <= 20);
+}
+
+TEST_SUITE_END();
@@ -0,0 +1,96 @@
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include <celimage/dds_decompress.h>
+#include <celimage/pixelformat.h>
+
+#include <doctest.h>
+
+using namespace celestia::engine;
+
+namespace
+{
+
+// Compare DecompressImageDXT with the single block decoders on random
+// blocks, for a size which isn't a multiple of the block size and spans
+// several decompression tasks
+void
+CheckImage(PixelFormat format, std::uint32_t components)
+{
+    constexpr std::uint32_t width = 37;
+    constexpr std::uint32_t height = 150;
+    constexpr std::uint32_t blocksWide = (width + 3) / 4;
+    constexpr std::uint32_t blocksHigh = (height + 3) / 4;
+    const std::uint32_t blockSize = format == PixelFormat::DXT1 ? 8 : 16;
+
+    std::mt19937 rng(42);
+    std::vector<std::uint8_t> blocks(blocksWide * blocksHigh * blockSize);
+    for (auto& b : blocks)
+        b = static_cast<std::uint8_t>(rng());
+
+    if (format == PixelFormat::DXT3)
+    {
+        // The single block decoder uses the three color mode for DXT3
+        for (std::size_t i = 0; i < blocks.size(); i += blockSize)
+        {
+            blocks[i + 9] = 0xff;
+            blocks[i + 11] = 0x00;
+        }
+    }
+
+    const std::uint32_t pitch = (width * components + 3) & ~3U;
+    std::vector<std::uint8_t> image(pitch * height);
+    DecompressImageDXT(format, width, height, blocks.data(), components, pitch, image.data());
+
+    std::vector<std::uint32_t> expected(blocksWide * 4 * blocksHigh * 4);
+    for (std::uint32_t by = 0; by < blocksHigh; ++by)
+    {
+        for (std::uint32_t bx = 0; bx < blocksWide; ++bx)
+        {
+            const std::uint8_t* block = blocks.data() + (by * blocksWide + bx) * blockSize;
+            switch (format)
+            {
+            case PixelFormat::DXT1:
+                DecompressBlockDXT1(bx * 4, by * 4, blocksWide * 4, block, false, expected.data());
+                break;
+            case PixelFormat::DXT3:
+                DecompressBlockDXT3(bx * 4, by * 4, blocksWide * 4, block, false, expected.data());
+                break;
+            default:
+                DecompressBlockDXT5(bx * 4, by * 4, blocksWide * 4, block, false, expected.data());
+                break;
+            }
+        }
+    }
+
+    int mismatches = 0;
+    for (std::uint32_t y = 0; y < height; ++y)
+    {
+        for (std::uint32_t x = 0; x < width; ++x)
+        {
+            std::uint32_t pixel = expected[y * blocksWide * 4 + x];
+            const std::uint8_t* actual = image.data() + y * pitch + x * components;
+            for (std::uint32_t c = 0; c < components; ++c)
+            {
+                if (actual[c] != static_cast<std::uint8_t>(pixel >> (8 * c)))
+                    ++mismatches;
+            }
+        }
+    }
+
+    REQUIRE(mismatches == 0);
+}
+
+} // end unnamed namespace
+
+TEST_SUITE_BEGIN("DDS decompression");
+
+TEST_CASE("DecompressImageDXT matches the block decoders")
+{
+    SUBCASE("DXT1") { CheckImage(PixelFormat::DXT1, 3); }
+    SUBCASE("DXT3") { CheckImage(PixelFormat::DXT3, 4); }
+    SUBCASE("DXT5") { CheckImage(PixelFormat::DXT5, 4); }
+}
+
+TEST_SUITE_END();
@@ -0,0 +1,85 @@
+#include <cstdint>
+
+#include <celimage/downsample.h>
+#include <celimage/image.h>
+
+#include <doctest.h>
+
+using namespace celestia::engine;
+
+TEST_SUITE_BEGIN("Image downsampling");
+
+TEST_CASE("Reduced sizes round up")
+{
+    REQUIRE(RowDownsampler::ReducedSize(16, 2) == 4);
+    REQUIRE(RowDownsampler::ReducedSize(17, 2) == 5);
+    REQUIRE(RowDownsampler::ReducedSize(3, 4) == 1);
+    REQUIRE(RowDownsampler::ReducedSize(5, 0) == 5);
+}
+
+TEST_CASE("Blocks of pixels are averaged")
+{
+    // 5x3 luminance image reduced once, so that the last row and column
+    // of blocks are partial
+    constexpr std::int32_t width = 5;
+    constexpr std::int32_t height = 3;
+    const std::uint8_t values[height][width] =
+    {
+        { 0, 10, 20, 30, 40 },
+        { 2, 12, 22, 32, 42 },
+        { 100, 110, 120, 130, 140 },
+    };
+
+    Image img(PixelFormat::Luminance, width, height);
+    for (std::int32_t y = 0; y < height; ++y)
+    {
+        for (std::int32_t x = 0; x < width; ++x)
+            img.getPixelRow(y)[x] = values[y][x];
+    }
+
+    auto reduced = img.downsample(1);
+    REQUIRE(reduced != nullptr);
+    REQUIRE(reduced->getFormat() == PixelFormat::Luminance);
+    REQUIRE(reduced->getWidth() == 3);
+    REQUIRE(reduced->getHeight() == 2);
+    REQUIRE(reduced->getMipLevelCount() == 1);
+
+    REQUIRE(reduced->getPixelRow(0)[0] == 6);
+    REQUIRE(reduced->getPixelRow(0)[1] == 26);
+    REQUIRE(reduced->getPixelRow(0)[2] == 41);
+    REQUIRE(reduced->getPixelRow(1)[0] == 105);
+    REQUIRE(reduced->getPixelRow(1)[1] == 125);
+    REQUIRE(reduced->getPixelRow(1)[2] == 140);
+}
+
+TEST_CASE("Channels are averaged separately")
+{
+    Image img(PixelFormat::RGB, 4, 4);
+    for (std::int32_t y = 0; y < 4; ++y)
+    {
+        std::uint8_t* row = img.getPixelRow(y);
+        for (std::int32_t x = 0; x < 4; ++x)
+        {
+            row[x * 3 + 0] = 255;
+            row[x * 3 + 1] = static_cast<std::uint8_t>(x * 20);
+            row[x * 3 + 2] = static_cast<std::uint8_t>(y * 20);
+        }
+    }
+
+    auto reduced = img.downsample(2);
+    REQUIRE(reduced != nullptr);
+    REQUIRE(reduced->getWidth() == 1);
+    REQUIRE(reduced->getHeight() == 1);
+    const std::uint8_t* pixel = reduced->getPixels();
+    REQUIRE(pixel[0] == 255);
+    REQUIRE(pixel[1] == 30);
+    REQUIRE(pixel[2] == 30);
+}
+
+TEST_CASE("Compressed images aren't downsampled")
+{
+    Image img(PixelFormat::DXT1, 8, 8);
+    REQUIRE(img.downsample(1) == nullptr);
+}
+
+TEST_SUITE_END();
@@ -0,0 +1,91 @@
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <celcompat/filesystem.h>
+#include <celengine/dsobinary.h>
+
+#include <doctest.h>
+
+using celestia::engine::DSOBinaryRecord;
+
+TEST_SUITE_BEGIN("DSOBinary");
+
+TEST_CASE("DSOBinary round trip")
+{
+    std::vector<DSOBinaryRecord> records(2);
+
+    records[0].type = DeepSkyObjectType::Galaxy;
+    records[0].names = "M 31:NGC 224:Andromeda Galaxy";
+    records[0].position = Eigen::Vector3d(1.0e6, -2.5e5, 3.0);
+    records[0].orientation = Eigen::Quaternionf(Eigen::AngleAxisf(0.5f, Eigen::Vector3f::UnitY()));
+    records[0].radius = 1.1e5f;
+    records[0].absMag = -21.5f;
+    records[0].infoURL = "https://example.org/m31";
+    records[0].categories = { "Local Group", "Spirals" };
+    records[0].detail = 0.8f;
+    records[0].typeName = "Sb";
+
+    records[1].type = DeepSkyObjectType::Globular;
+    records[1].names = "M 13";
+    records[1].clickable = false;
+    records[1].coreRadius = 0.62f;
+    records[1].kingConcentration = 1.51f;
+
+    std::ostringstream out;
+    REQUIRE(celestia::engine::WriteDSOBinaryCatalog(out, records));
+    const std::string contents = out.str();
+    REQUIRE(celestia::engine::IsDSOBinaryCatalog(contents));
+
+    std::vector<DSOBinaryRecord> loaded;
+    REQUIRE(celestia::engine::ReadDSOBinaryCatalog(contents, loaded));
+    REQUIRE(loaded.size() == records.size());
+
+    CHECK(loaded[0].type == DeepSkyObjectType::Galaxy);
+    CHECK(loaded[0].names == records[0].names);
+    CHECK(loaded[0].position == records[0].position);
+    CHECK(loaded[0].orientation.coeffs() == records[0].orientation.coeffs());
+    CHECK(loaded[0].radius == records[0].radius);
+    CHECK(loaded[0].absMag == records[0].absMag);
+    CHECK(loaded[0].visible);
+    CHECK(loaded[0].clickable);
+    CHECK(loaded[0].infoURL == records[0].infoURL);
+    CHECK(loaded[0].categories == records[0].categories);
+    CHECK(loaded[0].detail == records[0].detail);
+    CHECK(loaded[0].typeName == "Sb");
+    CHECK(loaded[0].form.empty());
+
+    CHECK(loaded[1].type == DeepSkyObjectType::Globular);
+    CHECK(loaded[1].names == "M 13");
+    CHECK(!loaded[1].clickable);
+    CHECK(loaded[1].categories.empty());
+    CHECK(loaded[1].coreRadius == records[1].coreRadius);
+    CHECK(loaded[1].kingConcentration == records[1].kingConcentration);
+}
+
+TEST_CASE("DSOBinary rejects malformed catalogs")
+{
+    std::vector<DSOBinaryRecord> records(1);
+    records[0].names = "NGC 1300";
+
+    std::ostringstream out;
+    REQUIRE(celestia::engine::WriteDSOBinaryCatalog(out, records));
+    const std::string contents = out.str();
+
+    std::vector<DSOBinaryRecord> loaded;
+    CHECK(!celestia::engine::ReadDSOBinaryCatalog(contents.substr(0, contents.size() - 1), loaded));
+    CHECK(!celestia::engine::ReadDSOBinaryCatalog(contents + "x", loaded));
+    CHECK(!celestia::engine::IsDSOBinaryCatalog("Galaxy \"NGC 1300\" { }"));
+    CHECK(loaded.empty());
+}
+
+TEST_CASE("DSOBinary catalog keys")
+{
+    using celestia::engine::ComputeDSOCatalogKey;
+    const std::string catalog = "Galaxy \"NGC 1300\" { Type \"SBb\" }";
+    CHECK(ComputeDSOCatalogKey(catalog, "extras/a") == ComputeDSOCatalogKey(catalog, "extras/a"));
+    CHECK(ComputeDSOCatalogKey(catalog, "extras/a") != ComputeDSOCatalogKey(catalog, "extras/b"));
+    CHECK(ComputeDSOCatalogKey(catalog, "extras/a") != ComputeDSOCatalogKey(catalog + " ", "extras/a"));
+}
+
+TEST_SUITE_END();
@@ -0,0 +1,85 @@
+#include <celutil/fileaccesslog.h>
+
+#include <fstream>
+#include <string>
+
+#include <doctest.h>
+
+using namespace celestia::util;
+
+TEST_SUITE_BEGIN("FileAccessLog");
+
+TEST_CASE("Files are only recorded while the log is enabled")
+{
+    FileAccessLog::clear();
+    FileAccessLog::setEnabled(false);
+
+    fs::path path("missing.dat");
+    {
+        FileAccessScope access("catalog", path);
+    }
+    REQUIRE(FileAccessLog::getFiles().empty());
+
+    FileAccessLog::setEnabled(true);
+    {
+        FileAccessScope access("catalog", path);
+        access.opened();
+        access.addRead(100);
+        access.addRead(50);
+    }
+    {
+        FileAccessScope access("texture", path);
+        access.setFailed();
+    }
+    {
+        DirectoryScanScope scan(fs::path("extras"));
+        scan.addEntry();
+        scan.addEntry();
+    }
+    FileAccessLog::setEnabled(false);
+
+    auto files = FileAccessLog::getFiles();
+    REQUIRE(files.size() == 2);
+    REQUIRE(std::string(files[0].category) == "catalog");
+    REQUIRE(files[0].path == "missing.dat");
+    REQUIRE(files[0].bytes == 150);
+    REQUIRE(files[0].reads == 2);
+    REQUIRE(!files[0].failed);
+    REQUIRE(files[0].openTime <= files[0].totalTime);
+    REQUIRE(files[1].failed);
+    REQUIRE(files[1].bytes == 0);
+
+    auto scans = FileAccessLog::getDirectoryScans();
+    REQUIRE(scans.size() == 1);
+    REQUIRE(scans[0].entries == 2);
+
+    FileAccessLog::clear();
+    REQUIRE(FileAccessLog::getFiles().empty());
+    REQUIRE(FileAccessLog::getDirectoryScans().empty());
+}
+
+TEST_CASE("The size of files read through a library is taken from the file")
+{
+    fs::path path("fileaccesslog_test.dat");
+    {
+        std::ofstream out(path, std::ios::binary);
+        out << "0123456789";
+    }
+
+    FileAccessLog::clear();
+    FileAccessLog::setEnabled(true);
+    {
+        FileAccessScope access("model", path);
+    }
+    FileAccessLog::setEnabled(false);
+
+    auto files = FileAccessLog::getFiles();
+    REQUIRE(files.size() == 1);
+    REQUIRE(files[0].bytes == 10);
+    REQUIRE(files[0].reads == 0);
+
+    FileAccessLog::clear();
+    fs::remove(path);
+}
+
+TEST_SUITE_END();
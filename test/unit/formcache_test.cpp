@@ -0,0 +1,107 @@
+#include <cstdint>
+#include <fstream>
+#include <system_error>
+#include <vector>
+
+#include <celcompat/filesystem.h>
+#include <celengine/formcache.h>
+
+#include <doctest.h>
+
+using celestia::engine::FormCache;
+using celestia::engine::SetFormCacheDirectory;
+
+namespace
+{
+
+struct Record
+{
+    float x;
+    float y;
+    std::uint8_t value;
+};
+
+struct OtherRecord
+{
+    double x;
+};
+
+} // end unnamed namespace
+
+TEST_SUITE_BEGIN("FormCache");
+
+TEST_CASE("FormCache")
+{
+    const fs::path directory = fs::temp_directory_path() / "celestia_formcache_test";
+    std::error_code ec;
+    fs::remove_all(directory, ec);
+
+    const std::uint64_t key = FormCache::computeKey("galaxy 1\nirregular\n3500");
+    REQUIRE(key != FormCache::computeKey("galaxy 1\nirregular\n3501"));
+
+    const std::vector<Record> records{ { 0.5f, -0.25f, 64 }, { 1.0f, 2.0f, 255 } };
+    std::vector<Record> loaded;
+
+    SUBCASE("Disabled cache")
+    {
+        SetFormCacheDirectory(fs::path());
+        REQUIRE_FALSE(FormCache::save(key, records));
+        REQUIRE_FALSE(FormCache::load(key, loaded));
+    }
+
+    SUBCASE("Round trip")
+    {
+        SetFormCacheDirectory(directory);
+        REQUIRE_FALSE(FormCache::load(key, loaded));
+        REQUIRE(FormCache::save(key, records));
+        REQUIRE(FormCache::load(key, loaded));
+        REQUIRE(loaded.size() == records.size());
+        for (std::size_t i = 0; i < records.size(); ++i)
+        {
+            REQUIRE(loaded[i].x == records[i].x);
+            REQUIRE(loaded[i].y == records[i].y);
+            REQUIRE(loaded[i].value == records[i].value);
+        }
+
+        std::vector<OtherRecord> other;
+        REQUIRE_FALSE(FormCache::load(key, other));
+        REQUIRE_FALSE(FormCache::load(key + 1, loaded));
+    }
+
+    SUBCASE("Damaged file")
+    {
+        SetFormCacheDirectory(directory);
+        REQUIRE(FormCache::save(key, records));
+
+        for (const auto& entry : fs::directory_iterator(directory))
+        {
+            std::fstream file(entry.path(), std::ios::binary | std::ios::in | std::ios::out);
+            file.seekp(-1, std::ios::end);
+            file.put('\x7f');
+        }
+
+        REQUIRE_FALSE(FormCache::load(key, loaded));
+        REQUIRE(loaded.empty());
+    }
+
+    SetFormCacheDirectory(fs::path());
+    fs::remove_all(directory, ec);
+}
+
+TEST_CASE("FormCache source key")
+{
+    const fs::path source = fs::temp_directory_path() / "celestia_formcache_source.png";
+    std::error_code ec;
+    fs::remove(source, ec);
+
+    REQUIRE_FALSE(FormCache::computeKey("galaxy 1", source).has_value());
+
+    std::ofstream(source, std::ios::binary) << "template";
+    auto key = FormCache::computeKey("galaxy 1", source);
+    REQUIRE(key.has_value());
+    REQUIRE(key != FormCache::computeKey("galaxy 2", source));
+
+    fs::remove(source, ec);
+}
+
+TEST_SUITE_END();
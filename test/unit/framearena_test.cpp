@@ -0,0 +1,59 @@
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include <celutil/framearena.h>
+
+#include <doctest.h>
+
+using celestia::util::FrameArena;
+
+TEST_SUITE_BEGIN("FrameArena");
+
+TEST_CASE("Allocations are aligned")
+{
+    FrameArena arena(64);
+    arena.allocate(1, 1);
+    void* p = arena.allocate(8, 8);
+    REQUIRE(reinterpret_cast<std::uintptr_t>(p) % 8 == 0);
+    p = arena.allocate(4, 16);
+    REQUIRE(reinterpret_cast<std::uintptr_t>(p) % 16 == 0);
+}
+
+TEST_CASE("Strings are copied")
+{
+    FrameArena arena;
+    std::string label = "Alpha Centauri";
+    std::string_view copy = arena.copy(label);
+    label = "Sol";
+    REQUIRE(copy == "Alpha Centauri");
+    REQUIRE(copy.data() != label.data());
+    REQUIRE(arena.copy(std::string_view{}).empty());
+}
+
+TEST_CASE("Blocks are merged on reset")
+{
+    FrameArena arena(32);
+    std::string_view first = arena.copy("first label of the frame");
+    for (int i = 0; i < 10; ++i)
+        arena.allocate(24, 1);
+    REQUIRE(first == "first label of the frame");
+    REQUIRE(arena.used() == 264);
+    REQUIRE(arena.capacity() >= 264);
+
+    std::size_t capacity = arena.capacity();
+    arena.reset();
+    REQUIRE(arena.used() == 0);
+    REQUIRE(arena.capacity() == capacity);
+
+    // The next frame fits in the merged block
+    auto begin = static_cast<char*>(arena.allocate(24, 1));
+    for (int i = 0; i < 10; ++i)
+    {
+        auto p = static_cast<char*>(arena.allocate(24, 1));
+        REQUIRE(p == begin + 24 * (i + 1));
+    }
+    REQUIRE(arena.capacity() == capacity);
+}
+
+TEST_SUITE_END();
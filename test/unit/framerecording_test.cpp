@@ -0,0 +1,48 @@
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <celestia/framerecording.h>
+
+#include <doctest.h>
+
+using celestia::RecordedFrame;
+
+TEST_SUITE_BEGIN("FrameRecording");
+
+TEST_CASE("Frames are read back")
+{
+    std::stringstream recording;
+    REQUIRE(celestia::WriteFrameRecordingHeader(recording));
+    celestia::WriteRecordedFrame(recording, { 0.0, 1920, 1080, "cel://Follow/Sol:Earth/2024-01-01T00:00:00.00000" });
+    celestia::WriteRecordedFrame(recording, { 0.016, 1280, 720, "cel://SyncOrbit/Sol:Mars/2024-01-01T00:00:01.00000" });
+
+    std::vector<RecordedFrame> frames;
+    REQUIRE(celestia::ReadFrameRecording(recording, frames));
+    REQUIRE(frames.size() == 2);
+    REQUIRE(frames[0].elapsed == 0.0);
+    REQUIRE(frames[0].width == 1920);
+    REQUIRE(frames[0].height == 1080);
+    REQUIRE(frames[0].url == "cel://Follow/Sol:Earth/2024-01-01T00:00:00.00000");
+    REQUIRE(frames[1].elapsed == doctest::Approx(0.016));
+    REQUIRE(frames[1].width == 1280);
+    REQUIRE(frames[1].height == 720);
+    REQUIRE(frames[1].url == "cel://SyncOrbit/Sol:Mars/2024-01-01T00:00:01.00000");
+}
+
+TEST_CASE("Invalid recordings are rejected")
+{
+    std::vector<RecordedFrame> frames;
+
+    std::istringstream noHeader("0.0 1920 1080 cel://Follow/Sol:Earth\n");
+    REQUIRE(!celestia::ReadFrameRecording(noHeader, frames));
+
+    std::istringstream badSize("# Celestia frame recording 1\n0.0 0 1080 cel://Follow/Sol:Earth\n");
+    REQUIRE(!celestia::ReadFrameRecording(badSize, frames));
+
+    std::istringstream noURL("# Celestia frame recording 1\n0.0 1920 1080\n");
+    REQUIRE(!celestia::ReadFrameRecording(noURL, frames));
+    REQUIRE(frames.empty());
+}
+
+TEST_SUITE_END();
@@ -0,0 +1,65 @@
+#include <chrono>
+
+#include <celengine/framestats.h>
+#include <celestia/framescheduler.h>
+
+#include <doctest.h>
+
+using namespace std::chrono_literals;
+using celestia::FrameScheduler;
+
+TEST_SUITE_BEGIN("FrameScheduler");
+
+TEST_CASE("Frames start as late as their duration allows")
+{
+    FrameScheduler scheduler;
+    scheduler.setRefreshRate(50.0);
+
+    FrameScheduler::clock::time_point start{ 1s };
+    scheduler.beginFrame(start);
+    scheduler.endFrame(start + 5ms);
+    scheduler.framePresented(start + 20ms);
+
+    // No delay unless in low latency mode
+    REQUIRE(scheduler.getStartDelay(start + 20ms) == FrameScheduler::clock::duration::zero());
+
+    // 20 ms between refreshes, 5 ms to render and 2 ms of margin
+    scheduler.setLowLatency(true);
+    REQUIRE(scheduler.getStartDelay(start + 20ms) == 13ms);
+    REQUIRE(scheduler.getStartDelay(start + 40ms) == FrameScheduler::clock::duration::zero());
+
+    scheduler.setRefreshRate(0.0);
+    REQUIRE(scheduler.getStartDelay(start + 20ms) == FrameScheduler::clock::duration::zero());
+}
+
+TEST_CASE("Latency is measured from the oldest input shown")
+{
+    auto* stats = celestia::engine::GetFrameStats();
+    FrameScheduler scheduler;
+
+    FrameScheduler::clock::time_point start{ 1s };
+    scheduler.inputReceived(start + 1ms);
+    scheduler.inputReceived(start + 3ms);
+    scheduler.beginFrame(start + 4ms);
+    // Received during the tick, shown in the next frame unless latched
+    scheduler.inputReceived(start + 5ms);
+    scheduler.endFrame(start + 8ms);
+
+    stats->beginFrame();
+    scheduler.framePresented(start + 16ms);
+    REQUIRE(stats->current().inputLatency.has_value());
+    REQUIRE(*stats->current().inputLatency == doctest::Approx(15.0));
+
+    stats->beginFrame();
+    scheduler.beginFrame(start + 20ms);
+    scheduler.framePresented(start + 32ms);
+    REQUIRE(*stats->current().inputLatency == doctest::Approx(27.0));
+
+    // Frames without input don't report a latency
+    stats->beginFrame();
+    scheduler.beginFrame(start + 40ms);
+    scheduler.framePresented(start + 48ms);
+    REQUIRE(!stats->current().inputLatency.has_value());
+}
+
+TEST_SUITE_END();
@@ -0,0 +1,107 @@
+#include <cstdint>
+#include <vector>
+
+#include <Eigen/Core>
+
+#include <celmath/frustum.h>
+
+#include <doctest.h>
+
+using celestia::math::Frustum;
+using celestia::math::FrustumAspect;
+using celestia::math::InfiniteFrustum;
+using celestia::math::SphereArrays;
+
+namespace
+{
+
+// Spheres along a line crossing the frustum, some of them beyond the far
+// plane, with a count which doesn't fill the last batch
+template<typename PREC>
+struct TestSpheres
+{
+    std::vector<PREC> x;
+    std::vector<PREC> y;
+    std::vector<PREC> z;
+    std::vector<PREC> radius;
+
+    TestSpheres()
+    {
+        for (int i = 0; i < 37; ++i)
+        {
+            x.push_back(static_cast<PREC>(i - 18) * PREC(2));
+            y.push_back(static_cast<PREC>(i % 5) - PREC(2));
+            z.push_back(static_cast<PREC>(-i) * PREC(4));
+            radius.push_back(static_cast<PREC>(i % 3) * PREC(0.5));
+        }
+    }
+
+    SphereArrays<PREC> arrays() const
+    {
+        return { x, y, z, radius };
+    }
+
+    Eigen::Matrix<PREC, 3, 1> center(std::size_t i) const
+    {
+        return Eigen::Matrix<PREC, 3, 1>(x[i], y[i], z[i]);
+    }
+};
+
+template<typename FRUSTUM, typename PREC>
+std::vector<std::uint32_t>
+visibleOneByOne(const FRUSTUM& frustum, const TestSpheres<PREC>& spheres)
+{
+    std::vector<std::uint32_t> visible;
+    for (std::size_t i = 0; i < spheres.radius.size(); ++i)
+    {
+        if (frustum.testSphere(spheres.center(i), spheres.radius[i]) != FrustumAspect::Outside)
+            visible.push_back(static_cast<std::uint32_t>(i));
+    }
+    return visible;
+}
+
+} // end unnamed namespace
+
+TEST_SUITE_BEGIN("Frustum");
+
+TEST_CASE("Batched sphere tests match the single tests")
+{
+    Frustum frustum(0.8f, 1.5f, 1.0f, 100.0f);
+    InfiniteFrustum infiniteFrustum(0.8f, 1.5f, 1.0f);
+
+    TestSpheres<float> floatSpheres;
+    TestSpheres<double> doubleSpheres;
+
+    std::vector<std::uint32_t> visible;
+    frustum.testSpheres(floatSpheres.arrays(), visible);
+    REQUIRE(!visible.empty());
+    REQUIRE(visible.size() < floatSpheres.radius.size());
+    REQUIRE(visible == visibleOneByOne(frustum, floatSpheres));
+
+    visible.clear();
+    frustum.testSpheres(doubleSpheres.arrays(), visible);
+    REQUIRE(visible == visibleOneByOne(frustum, doubleSpheres));
+
+    visible.clear();
+    infiniteFrustum.testSpheres(floatSpheres.arrays(), visible);
+    REQUIRE(visible == visibleOneByOne(infiniteFrustum, floatSpheres));
+
+    visible.clear();
+    infiniteFrustum.testSpheres(doubleSpheres.arrays(), visible);
+    REQUIRE(visible == visibleOneByOne(infiniteFrustum, doubleSpheres));
+}
+
+TEST_CASE("Batched sphere tests append to the indices")
+{
+    Frustum frustum(0.8f, 1.0f, 1.0f, 100.0f);
+    std::vector<float> x{ 0.0f };
+    std::vector<float> y{ 0.0f };
+    std::vector<float> z{ -10.0f };
+    std::vector<float> radius{ 1.0f };
+
+    std::vector<std::uint32_t> visible{ 7 };
+    frustum.testSpheres(SphereArrays<float>{ x, y, z, radius }, visible);
+    REQUIRE(visible == std::vector<std::uint32_t>{ 7, 0 });
+}
+
+TEST_SUITE_END();
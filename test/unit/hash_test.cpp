@@ -0,0 +1,30 @@
+#include <cstdint>
+#include <string_view>
+
+#include <celutil/hash.h>
+
+#include <doctest.h>
+
+using celestia::util::FNV1aHash;
+
+TEST_SUITE_BEGIN("FNV1aHash");
+
+TEST_CASE("FNV1aHash matches the reference values")
+{
+    REQUIRE(FNV1aHash().value() == UINT64_C(0xcbf29ce484222325));
+    REQUIRE(FNV1aHash().addBytes(std::string_view("a")).value() == UINT64_C(0xaf63dc4c8601ec8c));
+    REQUIRE(FNV1aHash().addBytes(std::string_view("foobar")).value() == UINT64_C(0x85944171f73967e8));
+}
+
+TEST_CASE("FNV1aHash doesn't depend on how the bytes are split")
+{
+    FNV1aHash split;
+    split.addBytes(std::string_view("foo")).addBytes(std::string_view()).addBytes(std::string_view("bar"));
+    REQUIRE(split.value() == FNV1aHash().addBytes(std::string_view("foobar")).value());
+
+    std::uint32_t value = 0x12345678;
+    REQUIRE(FNV1aHash().addValue(value).value() == FNV1aHash().addBytes(&value, sizeof(value)).value());
+    REQUIRE(FNV1aHash().addValue(value).value() != FNV1aHash().addValue(value + 1).value());
+}
+
+TEST_SUITE_END();
@@ -0,0 +1,95 @@
+#include <celengine/hitchdetector.h>
+
+#include <doctest.h>
+
+using namespace celestia::engine;
+
+namespace
+{
+
+FrameCounters
+makeFrame(std::uint64_t frame, double simulation, double solarSystem)
+{
+    FrameCounters counters;
+    counters.frame = frame;
+    counters.stageTimes[static_cast<std::size_t>(FrameStage::Simulation)] = simulation;
+    counters.stageTimes[static_cast<std::size_t>(FrameStage::SolarSystem)] = solarSystem;
+    return counters;
+}
+
+} // end unnamed namespace
+
+TEST_SUITE_BEGIN("HitchDetector");
+
+TEST_CASE("Frames under the threshold are not hitches")
+{
+    HitchDetector detector(100.0);
+    REQUIRE(detector.check(makeFrame(1, 10.0, 50.0)) == nullptr);
+    REQUIRE(detector.getHitchCount() == 0);
+
+    HitchDetector disabled(0.0);
+    REQUIRE(disabled.check(makeFrame(1, 10.0, 500.0)) == nullptr);
+}
+
+TEST_CASE("Hitches are attributed to their zones")
+{
+    HitchDetector detector(100.0);
+
+    FrameCounters counters = makeFrame(7, 5.0, 200.0);
+    counters.zones.push_back({ FrameZone::OrbitSampling, "Io", 20.0 });
+    counters.zones.push_back({ FrameZone::TextureLoad, "earth.jpg", 150.0 });
+
+    const Hitch* hitch = detector.check(counters);
+    REQUIRE(hitch != nullptr);
+    REQUIRE(hitch->frame == 7);
+    REQUIRE(hitch->time == doctest::Approx(205.0));
+    REQUIRE(hitch->stage == FrameStage::SolarSystem);
+    REQUIRE(hitch->zones.size() == 2);
+    REQUIRE(hitch->zones[0].name == "earth.jpg");
+
+    counters.frame = 8;
+    counters.zones.clear();
+    counters.zones.push_back({ FrameZone::TextureLoad, "earth.jpg", 120.0 });
+    REQUIRE(detector.check(counters) != nullptr);
+    REQUIRE(detector.getHitchCount() == 2);
+
+    auto causes = detector.getTopCauses(10);
+    REQUIRE(causes.size() == 2);
+    REQUIRE(causes[0].category == "texture");
+    REQUIRE(causes[0].name == "earth.jpg");
+    REQUIRE(causes[0].count == 2);
+    REQUIRE(causes[0].totalTime == doctest::Approx(270.0));
+    REQUIRE(causes[0].maxTime == doctest::Approx(150.0));
+    REQUIRE(causes[1].name == "Io");
+
+    REQUIRE(detector.getTopCauses(1).size() == 1);
+}
+
+TEST_CASE("Unexplained time is attributed to the slowest stage")
+{
+    HitchDetector detector(100.0);
+    REQUIRE(detector.check(makeFrame(1, 150.0, 10.0)) != nullptr);
+
+    auto causes = detector.getTopCauses(10);
+    REQUIRE(causes.size() == 1);
+    REQUIRE(causes[0].category == "stage");
+    REQUIRE(causes[0].name == "simulation");
+    REQUIRE(causes[0].totalTime == doctest::Approx(160.0));
+
+    detector.reset();
+    REQUIRE(detector.getHitchCount() == 0);
+    REQUIRE(detector.getTopCauses(10).empty());
+}
+
+TEST_CASE("Only the last hitches are kept")
+{
+    HitchDetector detector(1.0);
+    for (std::uint64_t i = 0; i < HitchDetector::MaxRecentHitches + 5; ++i)
+        detector.check(makeFrame(i, 2.0, 0.0));
+
+    REQUIRE(detector.getHitchCount() == HitchDetector::MaxRecentHitches + 5);
+    REQUIRE(detector.getRecentHitches().size() == HitchDetector::MaxRecentHitches);
+    REQUIRE(detector.getRecentHitches().front().frame == 5);
+}
+
+TEST_SUITE_END();
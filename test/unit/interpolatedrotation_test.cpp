@@ -0,0 +1,111 @@
+#include <cmath>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include <Eigen/Geometry>
+
+#include <celastro/date.h>
+#include <celcompat/numbers.h>
+#include <celephem/interpolatedrotation.h>
+#include <celephem/rotation.h>
+
+#include <doctest.h>
+
+using namespace celestia;
+using namespace celestia::ephem;
+
+namespace
+{
+
+// Spin about a wobbling axis, with a slowly precessing equator
+class TestRotation : public CachingRotationModel
+{
+ public:
+    Eigen::Quaterniond
+    computeSpin(double tjd) const override
+    {
+        ++evaluations;
+        double t = tjd - astro::J2000;
+        Eigen::Vector3d axis(0.01 * std::sin(t * 0.7), 1.0, 0.02 * std::cos(t * 0.3));
+        return Eigen::Quaterniond(Eigen::AngleAxisd(t * Rate, axis.normalized()));
+    }
+
+    Eigen::Quaterniond
+    computeEquatorOrientation(double tjd) const override
+    {
+        double t = tjd - astro::J2000;
+        return Eigen::Quaterniond(Eigen::AngleAxisd(0.4 + 1.0e-3 * t, Eigen::Vector3d::UnitX()));
+    }
+
+    double getPeriod() const override { return 2.0 * celestia::numbers::pi / Rate; }
+    bool isPeriodic() const override { return true; }
+
+    mutable std::size_t evaluations{ 0 };
+
+ private:
+    static constexpr double Rate = 6.0;
+};
+
+} // end unnamed namespace
+
+TEST_SUITE_BEGIN("Interpolated rotation");
+
+TEST_CASE("Interpolated orientations are within the tolerance")
+{
+    constexpr double tolerance = 1.0e-7;
+    auto model = std::make_shared<TestRotation>();
+    InterpolatedRotation cached(model, tolerance);
+
+    std::vector<double> times;
+    for (int i = 0; i < 2000; ++i)
+        times.push_back(astro::J2000 - 0.5 + 0.000471 * i);
+
+    for (double tjd : times)
+    {
+        REQUIRE(cached.spin(tjd).angularDistance(model->spin(tjd)) <= tolerance * 2.0);
+        REQUIRE(cached.orientationAtTime(tjd).angularDistance(model->orientationAtTime(tjd)) <= tolerance * 4.0);
+    }
+    REQUIRE(cached.getSegmentCount() > 0);
+
+    // Batched evaluation agrees, and only uses the samples
+    std::vector<Eigen::Quaterniond> orientations(times.size());
+    model->evaluations = 0;
+    cached.computeOrientations(times.data(), orientations.data(), times.size());
+    REQUIRE(model->evaluations == 0);
+    for (std::size_t i = 0; i < times.size(); ++i)
+        REQUIRE(orientations[i].angularDistance(cached.orientationAtTime(times[i])) <= 1.0e-12);
+}
+
+TEST_CASE("Caching rotation models keep several times")
+{
+    TestRotation model;
+    const double times[] = { astro::J2000, astro::J2000 + 0.001, astro::J2000 + 0.002 };
+    for (double tjd : times)
+        model.spin(tjd);
+
+    model.evaluations = 0;
+    for (int pass = 0; pass < 3; ++pass)
+    {
+        for (double tjd : times)
+            model.spin(tjd);
+    }
+    REQUIRE(model.evaluations == 0);
+}
+
+TEST_CASE("Rotation models are only cached with a tolerance")
+{
+    std::shared_ptr<const RotationModel> model = std::make_shared<TestRotation>();
+
+    SetRotationCacheTolerance(0.0);
+    REQUIRE(CreateCachedRotationModel(model) == model);
+
+    SetRotationCacheTolerance(1.0e-6);
+    auto cached = CreateCachedRotationModel(model);
+    REQUIRE(cached != model);
+    REQUIRE(dynamic_cast<const InterpolatedRotation*>(cached.get()) != nullptr);
+
+    SetRotationCacheTolerance(0.0);
+}
+
+TEST_SUITE_END();
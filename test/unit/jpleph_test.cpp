@@ -0,0 +1,208 @@
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <celcompat/bit.h>
+#include <celcompat/filesystem.h>
+#include <celephem/jpleph.h>
+
+#include <doctest.h>
+
+using namespace celestia;
+using namespace celestia::ephem;
+
+namespace
+{
+
+// Layout of the DE header record
+constexpr std::size_t StartDateOffset = 2652;
+constexpr std::size_t CoeffInfoOffset = 2696;
+constexpr std::size_t DENumOffset = 2840;
+constexpr std::size_t LibrationOffset = 2844;
+
+constexpr double StartDate = 2451536.5;
+constexpr double DaysPerInterval = 32.0;
+constexpr unsigned int NRecords = 20;
+
+// Mercury in 4 granules of 14 coefficients, the Sun in 2 granules of 11
+// and the librations in 5 granules of 10
+constexpr std::uint32_t MercuryCoeffs = 14;
+constexpr std::uint32_t MercuryGranules = 4;
+constexpr std::uint32_t SunCoeffs = 11;
+constexpr std::uint32_t SunGranules = 2;
+constexpr unsigned int RecordSize = 2 + 3 * (MercuryCoeffs * MercuryGranules + SunCoeffs * SunGranules + 10 * 5);
+
+class EphemerisWriter
+{
+ public:
+    explicit EphemerisWriter(bool swap) : swap(swap) {}
+
+    void
+    putUint(std::size_t offset, std::uint32_t value)
+    {
+        if (swap)
+            value = compat::byteswap(value);
+        std::memcpy(data.data() + offset, &value, sizeof(value));
+    }
+
+    void
+    putDouble(std::size_t offset, double value)
+    {
+        std::uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(value));
+        if (swap)
+            bits = compat::byteswap(bits);
+        std::memcpy(data.data() + offset, &bits, sizeof(bits));
+    }
+
+    void
+    putCoeffInfo(std::size_t offset, std::uint32_t first, std::uint32_t nCoeffs, std::uint32_t nGranules)
+    {
+        putUint(offset, first);
+        putUint(offset + 4, nCoeffs);
+        putUint(offset + 8, nGranules);
+    }
+
+    std::vector<char> data;
+
+ private:
+    bool swap;
+};
+
+// The constant term of each coefficient series, the rest are zero
+double
+constantTerm(unsigned int record, unsigned int granule, unsigned int component)
+{
+    return record * 100.0 + granule * 10.0 + component;
+}
+
+void
+writeEphemeris(const fs::path& path, bool swap)
+{
+    EphemerisWriter writer(swap);
+    writer.data.resize(std::size_t(RecordSize) * 8 * (NRecords + 2));
+
+    writer.putDouble(StartDateOffset, StartDate);
+    writer.putDouble(StartDateOffset + 8, StartDate + DaysPerInterval * NRecords);
+    writer.putDouble(StartDateOffset + 16, DaysPerInterval);
+    writer.putUint(DENumOffset, 440);
+
+    // Offsets count from one and include the times of the record
+    std::uint32_t sunFirst = 3 + 3 * MercuryCoeffs * MercuryGranules;
+    std::uint32_t librationFirst = sunFirst + 3 * SunCoeffs * SunGranules;
+    for (unsigned int i = 0; i < JPLEphemeris::JPLEph_NItems; ++i)
+    {
+        if (i == static_cast<unsigned int>(JPLEphemItem::Mercury))
+            writer.putCoeffInfo(CoeffInfoOffset + i * 12, 3, MercuryCoeffs, MercuryGranules);
+        else if (i == static_cast<unsigned int>(JPLEphemItem::Sun))
+            writer.putCoeffInfo(CoeffInfoOffset + i * 12, sunFirst, SunCoeffs, SunGranules);
+        else
+            writer.putCoeffInfo(CoeffInfoOffset + i * 12, librationFirst, 0, 1);
+    }
+    writer.putCoeffInfo(LibrationOffset, librationFirst, 10, 5);
+
+    for (unsigned int record = 0; record < NRecords; ++record)
+    {
+        std::size_t recordOffset = std::size_t(RecordSize) * 8 * (record + 2);
+        double t0 = StartDate + DaysPerInterval * record;
+        writer.putDouble(recordOffset, t0);
+        writer.putDouble(recordOffset + 8, t0 + DaysPerInterval);
+
+        for (unsigned int granule = 0; granule < MercuryGranules; ++granule)
+        {
+            for (unsigned int component = 0; component < 3; ++component)
+            {
+                std::size_t index = 2 + (granule * 3 + component) * MercuryCoeffs;
+                writer.putDouble(recordOffset + index * 8, constantTerm(record, granule, component));
+                // A linear term, which is zero in the middle of the granule
+                writer.putDouble(recordOffset + (index + 1) * 8, 0.5);
+            }
+        }
+    }
+
+    std::ofstream out(path, std::ios::out | std::ios::binary);
+    out.write(writer.data.data(), writer.data.size());
+}
+
+// Middle of a granule of Mercury
+double
+granuleMiddle(unsigned int record, unsigned int granule)
+{
+    double daysPerGranule = DaysPerInterval / MercuryGranules;
+    return StartDate + DaysPerInterval * record + daysPerGranule * (granule + 0.5);
+}
+
+} // end unnamed namespace
+
+TEST_SUITE_BEGIN("JPL ephemeris");
+
+TEST_CASE("Mapped and loaded ephemerides agree")
+{
+    for (bool swap : { false, true })
+    {
+        fs::path path = fs::temp_directory_path() / "celestia_jpleph_test.dat";
+        writeEphemeris(path, swap);
+
+        std::unique_ptr<JPLEphemeris> mapped(JPLEphemeris::load(path));
+        REQUIRE(mapped != nullptr);
+        REQUIRE(mapped->getByteSwap() == swap);
+        REQUIRE(mapped->getDENumber() == 440);
+        REQUIRE(mapped->getRecordSize() == RecordSize);
+        REQUIRE(mapped->getStartDate() == StartDate);
+
+        std::ifstream in(path, std::ios::in | std::ios::binary);
+        std::unique_ptr<JPLEphemeris> loaded(JPLEphemeris::load(in));
+        REQUIRE(loaded != nullptr);
+
+        // Visit more records than are kept decoded, back and forth
+        for (unsigned int pass = 0; pass < 2; ++pass)
+        {
+            for (unsigned int i = 0; i < NRecords; ++i)
+            {
+                unsigned int record = pass == 0 ? i : (i * 7) % NRecords;
+                for (unsigned int granule = 0; granule < MercuryGranules; ++granule)
+                {
+                    double jd = granuleMiddle(record, granule);
+                    Eigen::Vector3d position = mapped->getPlanetPosition(JPLEphemItem::Mercury, jd);
+                    REQUIRE(position == loaded->getPlanetPosition(JPLEphemItem::Mercury, jd));
+                    for (unsigned int component = 0; component < 3; ++component)
+                        REQUIRE(std::abs(position[component] - constantTerm(record, granule, component)) < 1.0e-9);
+                }
+            }
+        }
+
+        // Times past the end are clamped to the last record
+        double endDate = StartDate + DaysPerInterval * NRecords;
+        REQUIRE(mapped->getPlanetPosition(JPLEphemItem::Sun, endDate + 100.0) ==
+                loaded->getPlanetPosition(JPLEphemItem::Sun, endDate));
+
+        mapped.reset();
+        in.close();
+        std::error_code ec;
+        fs::remove(path, ec);
+    }
+}
+
+TEST_CASE("Truncated ephemerides are rejected")
+{
+    fs::path path = fs::temp_directory_path() / "celestia_jpleph_truncated.dat";
+    writeEphemeris(path, false);
+    fs::resize_file(path, fs::file_size(path) - 8);
+
+    REQUIRE(std::unique_ptr<JPLEphemeris>(JPLEphemeris::load(path)) == nullptr);
+    {
+        std::ifstream in(path, std::ios::in | std::ios::binary);
+        REQUIRE(std::unique_ptr<JPLEphemeris>(JPLEphemeris::load(in)) == nullptr);
+    }
+
+    std::error_code ec;
+    fs::remove(path, ec);
+}
+
+TEST_SUITE_END();
@@ -1,5 +1,7 @@
+#include <algorithm>
 #include <array>
 #include <cmath>
+#include <vector>
 
 #include <celastro/astro.h>
 #include <celcompat/numbers.h>
@@ -53,6 +55,56 @@ void TestElements(const astro::KeplerElements& expected,
     REQUIRE(ApproxAngle(expected.meanAnomaly, actual.meanAnomaly));
 }
 
+struct OrbitSample
+{
+    double t;
+    Eigen::Vector3d position;
+    Eigen::Vector3d velocity;
+};
+
+class SampleCollector : public celestia::ephem::OrbitSampleProc
+{
+public:
+    void sample(double t, const Eigen::Vector3d& position, const Eigen::Vector3d& velocity) override
+    {
+        samples.push_back({ t, position, velocity });
+    }
+
+    std::vector<OrbitSample> samples;
+};
+
+std::vector<OrbitSample>
+SampleOrbit(double eccentricity)
+{
+    astro::KeplerElements elements;
+    elements.period = 365.25;
+    elements.semimajorAxis = 1.5e8;
+    elements.eccentricity = eccentricity;
+    elements.inclination = math::degToRad(10.0);
+    elements.longAscendingNode = math::degToRad(40.0);
+    elements.argPericenter = math::degToRad(120.0);
+    elements.meanAnomaly = 0.0;
+    celestia::ephem::EllipticalOrbit orbit(elements, 0.0);
+
+    SampleCollector collector;
+    orbit.sample(0.0, elements.period, collector);
+
+    // Check the error of the interpolated path in the middle of each interval
+    for (std::size_t i = 1; i < collector.samples.size(); ++i)
+    {
+        const OrbitSample& s0 = collector.samples[i - 1];
+        const OrbitSample& s1 = collector.samples[i];
+        double dt = s1.t - s0.t;
+        Eigen::Vector3d interpolated = (s0.position + s1.position) * 0.5
+                                     + (s0.velocity - s1.velocity) * (dt * 0.125);
+        Eigen::Vector3d expected = orbit.positionAtTime(s0.t + dt * 0.5);
+        double tolerance = std::max(1.0, celestia::ephem::OrbitSampleProc::DefaultAngularTolerance * expected.norm());
+        REQUIRE((interpolated - expected).norm() <= tolerance * 1.001);
+    }
+
+    return collector.samples;
+}
+
 }
 
 TEST_SUITE_BEGIN("Keplerian orbits");
@@ -136,4 +188,28 @@ TEST_CASE("Hyperbolic orbits")
     }
 }
 
+TEST_CASE("Adaptive orbit sampling")
+{
+    SUBCASE("Circular orbit")
+    {
+        auto samples = SampleOrbit(0.0);
+        REQUIRE(samples.front().t == 0.0);
+        REQUIRE(samples.back().t == doctest::Approx(365.25));
+        REQUIRE(samples.size() < 100);
+    }
+
+    SUBCASE("Eccentric orbit")
+    {
+        auto samples = SampleOrbit(0.95);
+        REQUIRE(samples.back().t == doctest::Approx(365.25));
+
+        // Samples are concentrated near pericenter, at the start and end
+        double pericenterStep = samples[1].t - samples[0].t;
+        auto middle = std::lower_bound(samples.begin(), samples.end(), 365.25 * 0.5,
+                                       [](const OrbitSample& sample, double t) { return sample.t < t; });
+        double apocenterStep = middle->t - (middle - 1)->t;
+        REQUIRE(pericenterStep * 100.0 < apocenterStep);
+    }
+}
+
 TEST_SUITE_END();
@@ -0,0 +1,60 @@
+#include <celengine/labelplacer.h>
+
+#include <doctest.h>
+
+using celestia::engine::LabelPlacer;
+
+TEST_SUITE_BEGIN("LabelPlacer");
+
+TEST_CASE("Overlapping labels are rejected")
+{
+    LabelPlacer placer;
+    placer.reset(640, 480);
+
+    REQUIRE(placer.place({ 100.0f, 100.0f, 160.0f, 112.0f }));
+    REQUIRE(!placer.place({ 150.0f, 105.0f, 210.0f, 117.0f }));
+    REQUIRE(placer.place({ 160.0f, 100.0f, 220.0f, 112.0f }));
+    REQUIRE(placer.place({ 100.0f, 112.0f, 160.0f, 124.0f }));
+    REQUIRE(placer.size() == 3);
+}
+
+TEST_CASE("Labels spanning several cells")
+{
+    LabelPlacer placer(16.0f);
+    placer.reset(640, 480);
+
+    REQUIRE(placer.place({ 10.0f, 10.0f, 300.0f, 20.0f }));
+    REQUIRE(placer.overlaps({ 200.0f, 15.0f, 210.0f, 25.0f }));
+    REQUIRE(!placer.overlaps({ 200.0f, 20.0f, 210.0f, 30.0f }));
+}
+
+TEST_CASE("Labels outside the screen")
+{
+    LabelPlacer placer;
+    placer.reset(640, 480);
+
+    REQUIRE(placer.place({ -100.0f, -20.0f, -40.0f, -8.0f }));
+    REQUIRE(!placer.place({ -50.0f, -10.0f, 10.0f, 2.0f }));
+    REQUIRE(placer.place({ 630.0f, 470.0f, 700.0f, 490.0f }));
+    REQUIRE(placer.overlaps({ 690.0f, 480.0f, 720.0f, 500.0f }));
+}
+
+TEST_CASE("Forced labels and reset")
+{
+    LabelPlacer placer;
+    placer.reset(640, 480);
+
+    placer.insert({ 0.0f, 0.0f, 50.0f, 10.0f });
+    placer.insert({ 10.0f, 0.0f, 60.0f, 10.0f });
+    REQUIRE(placer.size() == 2);
+    REQUIRE(!placer.place({ 40.0f, 5.0f, 90.0f, 15.0f }));
+
+    placer.reset(640, 480);
+    REQUIRE(placer.size() == 0);
+    REQUIRE(placer.place({ 40.0f, 5.0f, 90.0f, 15.0f }));
+
+    placer.reset(320, 240);
+    REQUIRE(placer.place({ 40.0f, 5.0f, 90.0f, 15.0f }));
+}
+
+TEST_SUITE_END();
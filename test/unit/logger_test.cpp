@@ -2,11 +2,15 @@
 
 #include <sstream>
 #include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
 #include <celutil/logger.h>
 
 using celestia::util::Logger;
 using celestia::util::Level;
 using celestia::util::CreateLogger;
+using celestia::util::AsyncLogScope;
 
 #define CLEAR(s) s.str(""); s.clear()
 
@@ -159,4 +163,76 @@ TEST_CASE("logger")
     }
 }
 
+TEST_CASE("async logger")
+{
+    SUBCASE("Writes the messages when switched back")
+    {
+        std::ostringstream err, log;
+        Logger logger(Level::Info, log, err);
+
+        REQUIRE(!logger.setAsync(true));
+        logger.error("number={}\n", 123);
+        logger.info("hello world\n");
+        logger.verbose("hi there\n");
+        REQUIRE(logger.setAsync(false));
+
+        REQUIRE(err.str() == "number=123\n");
+        REQUIRE(log.str() == "hello world\n");
+    }
+
+    SUBCASE("Counts the repeated messages")
+    {
+        std::ostringstream err, log;
+        Logger logger(Level::Info, log, err);
+
+        {
+            AsyncLogScope scope(&logger);
+            for (int i = 0; i < 4; ++i)
+                logger.warn("duplicate {}\n", "name");
+            logger.warn("other\n");
+            logger.warn("other\n");
+        }
+
+        REQUIRE(err.str() == "duplicate name\n"
+                             "Last message repeated 3 times\n"
+                             "other\n"
+                             "Last message repeated 1 time\n");
+    }
+
+    SUBCASE("Writes the messages of all the threads")
+    {
+        std::ostringstream err, log;
+        Logger logger(Level::Info, log, err);
+
+        constexpr int threadCount = 4;
+        constexpr int messageCount = 1000;
+        logger.setAsync(true);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < threadCount; ++t)
+        {
+            threads.emplace_back([&logger, t]
+            {
+                for (int i = 0; i < messageCount; ++i)
+                    logger.info("{} {}\n", t, i);
+            });
+        }
+        for (auto &thread : threads)
+            thread.join();
+        logger.setAsync(false);
+
+        std::istringstream lines(log.str());
+        std::vector<int> next(threadCount, 0);
+        int t;
+        int i;
+        while (lines >> t >> i)
+        {
+            // The messages of each thread are written in order
+            REQUIRE(i == next[t]);
+            ++next[t];
+        }
+        for (int count : next)
+            REQUIRE(count == messageCount);
+    }
+}
+
 TEST_SUITE_END();
@@ -0,0 +1,165 @@
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include <Eigen/Geometry>
+
+#include <celmodel/mesh.h>
+#include <celmodel/meshbvh.h>
+
+#include <doctest.h>
+
+using namespace cmod;
+
+namespace
+{
+
+// Distance to the closest triangle hit by the ray found by testing all of
+// them, or a negative value
+double
+bruteForcePick(const std::vector<Eigen::Vector3f>& positions,
+               const std::vector<MeshBVH::Triangle>& triangles,
+               const Eigen::ParametrizedLine<double, 3>& ray)
+{
+    double closest = -1.0;
+    for (const auto& triangle : triangles)
+    {
+        Eigen::Vector3d v0 = positions[triangle.vertices[0]].cast<double>();
+        Eigen::Vector3d v1 = positions[triangle.vertices[1]].cast<double>();
+        Eigen::Vector3d v2 = positions[triangle.vertices[2]].cast<double>();
+        Eigen::Vector3d n = (v1 - v0).cross(v2 - v0);
+        double c = n.dot(ray.direction());
+        if (c == 0.0)
+            continue;
+
+        double t = n.dot(v0 - ray.origin()) / c;
+        if (t <= 0.0 || (closest >= 0.0 && t >= closest))
+            continue;
+
+        // Inside if the point is on the same side of all edges
+        Eigen::Vector3d p = ray.pointAt(t);
+        if (n.dot((v1 - v0).cross(p - v0)) >= 0.0 &&
+            n.dot((v2 - v1).cross(p - v1)) >= 0.0 &&
+            n.dot((v0 - v2).cross(p - v2)) >= 0.0)
+        {
+            closest = t;
+        }
+    }
+
+    return closest;
+}
+
+} // end unnamed namespace
+
+TEST_SUITE_BEGIN("Mesh BVH");
+
+TEST_CASE("Picks match testing all triangles")
+{
+    std::mt19937 rng(12345);
+    std::uniform_real_distribution<float> coordinate(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> offset(-0.05f, 0.05f);
+
+    std::vector<Eigen::Vector3f> positions;
+    std::vector<MeshBVH::Triangle> triangles;
+    for (std::uint32_t i = 0; i < 2000; ++i)
+    {
+        Eigen::Vector3f center(coordinate(rng), coordinate(rng), coordinate(rng));
+        for (int j = 0; j < 3; ++j)
+            positions.push_back(center + Eigen::Vector3f(offset(rng), offset(rng), offset(rng)));
+        triangles.push_back({ { i * 3, i * 3 + 1, i * 3 + 2 }, 0, i });
+    }
+
+    auto bvhPositions = positions;
+    auto bvhTriangles = triangles;
+    MeshBVH bvh(std::move(bvhPositions), std::move(bvhTriangles));
+    REQUIRE(bvh.getNodeCount() > 1);
+
+    int hits = 0;
+    for (int i = 0; i < 500; ++i)
+    {
+        Eigen::Vector3d origin = Eigen::Vector3d(coordinate(rng), coordinate(rng), coordinate(rng)) * 3.0;
+        Eigen::Vector3d target(coordinate(rng), coordinate(rng), coordinate(rng));
+        Eigen::ParametrizedLine<double, 3> ray(origin, (target - origin).normalized());
+
+        double expected = bruteForcePick(positions, triangles, ray);
+        double distance = 1.0e30;
+        const MeshBVH::Triangle* triangle = bvh.pick(ray.origin(), ray.direction(), distance);
+        REQUIRE((triangle != nullptr) == (expected >= 0.0));
+        if (triangle != nullptr)
+        {
+            REQUIRE(distance == doctest::Approx(expected));
+            ++hits;
+        }
+    }
+
+    // Make sure the rays test something
+    REQUIRE(hits > 10);
+}
+
+TEST_CASE("Picks nearer than the distance only")
+{
+    std::vector<Eigen::Vector3f> positions
+    {
+        { -1.0f, -1.0f, 0.0f }, { 1.0f, -1.0f, 0.0f }, { 0.0f, 1.0f, 0.0f },
+        { -1.0f, -1.0f, 1.0f }, { 1.0f, -1.0f, 1.0f }, { 0.0f, 1.0f, 1.0f },
+    };
+    std::vector<MeshBVH::Triangle> triangles
+    {
+        { { 0, 1, 2 }, 0, 0 },
+        { { 3, 4, 5 }, 1, 0 },
+    };
+    MeshBVH bvh(std::move(positions), std::move(triangles));
+
+    Eigen::Vector3d origin(0.0, 0.0, 5.0);
+    Eigen::Vector3d direction(0.0, 0.0, -1.0);
+    double distance = 1.0e30;
+    const MeshBVH::Triangle* triangle = bvh.pick(origin, direction, distance);
+    REQUIRE(triangle != nullptr);
+    REQUIRE(triangle->group == 1);
+    REQUIRE(distance == doctest::Approx(4.0));
+
+    distance = 3.0;
+    REQUIRE(bvh.pick(origin, direction, distance) == nullptr);
+    REQUIRE(distance == 3.0);
+
+    distance = 1.0e30;
+    REQUIRE(bvh.pick(origin, -direction, distance) == nullptr);
+}
+
+TEST_CASE("Strip triangles are numbered in the group")
+{
+    std::vector<VertexAttribute> attributes;
+    attributes.emplace_back(VertexAttributeSemantic::Position, VertexAttributeFormat::Float3, 0);
+    Mesh mesh;
+    mesh.setVertexDescription(VertexDescription(std::move(attributes)));
+
+    // Strip of four triangles along x in the z = 0 plane
+    std::vector<VWord> vertices;
+    for (int i = 0; i < 6; ++i)
+    {
+        float position[3] = { static_cast<float>(i / 2), static_cast<float>(i % 2), 0.0f };
+        for (float f : position)
+        {
+            VWord word;
+            std::memcpy(&word, &f, sizeof(word));
+            vertices.push_back(word);
+        }
+    }
+    mesh.setVertices(6, std::move(vertices));
+    mesh.addGroup(PrimitiveGroupType::TriStrip, 0, { 0, 1, 2, 3, 4, 5 });
+
+    Mesh::PickResult result;
+    REQUIRE(mesh.pick(Eigen::Vector3d(1.25, 0.5, 2.0), -Eigen::Vector3d::UnitZ(), &result));
+    REQUIRE(result.group == mesh.getGroup(0));
+    REQUIRE(result.primitiveIndex == 2);
+    REQUIRE(result.distance == doctest::Approx(2.0));
+
+    // Moving the mesh rebuilds the hierarchy
+    mesh.transform(Eigen::Vector3f(0.0f, 0.0f, 1.0f), 1.0f);
+    REQUIRE(mesh.pick(Eigen::Vector3d(1.25, 0.5, 2.0), -Eigen::Vector3d::UnitZ(), &result));
+    REQUIRE(result.distance == doctest::Approx(1.0));
+}
+
+TEST_SUITE_END();
@@ -0,0 +1,100 @@
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include <celmodel/mesh.h>
+
+#include <doctest.h>
+
+using namespace cmod;
+
+namespace
+{
+
+// Flat grid of size x size quads in the unit square
+Mesh
+makeGrid(unsigned int size)
+{
+    std::vector<VertexAttribute> attributes;
+    attributes.emplace_back(VertexAttributeSemantic::Position, VertexAttributeFormat::Float3, 0);
+    Mesh mesh;
+    mesh.setVertexDescription(VertexDescription(std::move(attributes)));
+
+    unsigned int side = size + 1;
+    std::vector<VWord> vertices(side * side * 3);
+    for (unsigned int y = 0; y < side; ++y)
+    {
+        for (unsigned int x = 0; x < side; ++x)
+        {
+            float position[3] = { static_cast<float>(x) / size, static_cast<float>(y) / size, 0.0f };
+            std::memcpy(&vertices[(y * side + x) * 3], position, sizeof(position));
+        }
+    }
+    mesh.setVertices(side * side, std::move(vertices));
+
+    std::vector<Index32> indices;
+    for (unsigned int y = 0; y < size; ++y)
+    {
+        for (unsigned int x = 0; x < size; ++x)
+        {
+            Index32 i = y * side + x;
+            indices.insert(indices.end(), { i, i + 1, i + side + 1, i, i + side + 1, i + side });
+        }
+    }
+    mesh.addGroup(PrimitiveGroupType::TriList, 0, std::move(indices));
+    return mesh;
+}
+
+} // end unnamed namespace
+
+TEST_SUITE_BEGIN("Mesh levels of detail");
+
+TEST_CASE("Levels of detail halve the triangles")
+{
+    Mesh mesh = makeGrid(128);
+    mesh.generateLODs();
+    REQUIRE(mesh.getLODCount() > 2);
+
+    const PrimitiveGroup* group = mesh.getGroup(0);
+    REQUIRE(group->lodIndices.size() == mesh.getLODCount() - 1);
+
+    std::size_t indexCount = group->indices.size();
+    float error = 0.0f;
+    for (unsigned int level = 1; level < mesh.getLODCount(); ++level)
+    {
+        const auto& lodIndices = group->lodIndices[level - 1];
+        REQUIRE(lodIndices.size() % 3 == 0);
+        REQUIRE(lodIndices.size() * 2 <= indexCount);
+        REQUIRE(std::all_of(lodIndices.begin(), lodIndices.end(),
+                            [&mesh](Index32 index) { return index < mesh.getVertexCount(); }));
+
+        REQUIRE(mesh.getLODError(level) >= error);
+        error = mesh.getLODError(level);
+        indexCount = lodIndices.size();
+    }
+
+    REQUIRE(mesh.selectLOD(0.0f) == 0);
+    REQUIRE(mesh.selectLOD(error) == mesh.getLODCount() - 1);
+}
+
+TEST_CASE("Errors are scaled with the mesh")
+{
+    Mesh mesh = makeGrid(128);
+    mesh.generateLODs();
+    REQUIRE(mesh.getLODCount() > 1);
+
+    float error = mesh.getLODError(1);
+    mesh.transform(Eigen::Vector3f::Zero(), 2.0f);
+    REQUIRE(mesh.getLODError(1) == doctest::Approx(error * 2.0f));
+}
+
+TEST_CASE("Small meshes aren't simplified")
+{
+    Mesh mesh = makeGrid(8);
+    mesh.generateLODs();
+    REQUIRE(mesh.getLODCount() == 1);
+    REQUIRE(mesh.selectLOD(1.0f) == 0);
+}
+
+TEST_SUITE_END();
@@ -0,0 +1,138 @@
+#include <cstddef>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <celengine/name.h>
+
+#include <doctest.h>
+
+namespace
+{
+
+std::vector<std::pair<std::string, AstroCatalog::IndexNumber>>
+complete(const NameDatabase& db, std::string_view prefix)
+{
+    std::vector<std::pair<std::string, AstroCatalog::IndexNumber>> completion;
+    db.getCompletion(completion, prefix);
+    return completion;
+}
+
+void
+addNames(NameDatabase& db)
+{
+    db.add(1, "Sirius");
+    db.add(1, "Alpha Canis Majoris");
+    db.add(2, "Sirius B");
+    db.add(3, "Siriusly Long Name");
+    db.add(4, "Vega");
+}
+
+void
+checkNames(const NameDatabase& db)
+{
+    REQUIRE(db.getCatalogNumberByName("Sirius", false) == 1);
+    REQUIRE(db.getCatalogNumberByName("SIRIUS", false) == 1);
+    REQUIRE(db.getCatalogNumberByName("sirius b", false) == 2);
+    REQUIRE(db.getCatalogNumberByName("ALF Canis Majoris", false) == 1);
+    REQUIRE(db.getCatalogNumberByName("Siriu", false) == AstroCatalog::InvalidIndex);
+
+    auto completion = complete(db, "siri");
+    REQUIRE(completion.size() == 3);
+    REQUIRE(completion[0].first == "Sirius");
+    REQUIRE(completion[0].second == 1);
+    REQUIRE(completion[1].first == "Sirius B");
+    REQUIRE(completion[2].first == "Siriusly Long Name");
+
+    completion = complete(db, "alpha");
+    REQUIRE(completion.size() == 1);
+    REQUIRE(completion[0].second == 1);
+
+    REQUIRE(complete(db, "Altair").empty());
+}
+
+} // end unnamed namespace
+
+TEST_SUITE_BEGIN("NameDatabase");
+
+TEST_CASE("NameDatabase")
+{
+    NameDatabase db;
+    addNames(db);
+
+    SUBCASE("Names are found before freezing")
+    {
+        checkNames(db);
+    }
+
+    SUBCASE("Names are found after freezing")
+    {
+        db.freeze();
+        checkNames(db);
+    }
+
+    SUBCASE("Names added after freezing take precedence")
+    {
+        db.freeze();
+        db.add(5, "VEGA");
+        db.add(6, "Deneb");
+        REQUIRE(db.getCatalogNumberByName("Vega", false) == 5);
+        REQUIRE(db.getCatalogNumberByName("Deneb", false) == 6);
+        REQUIRE(complete(db, "Den").size() == 1);
+
+        db.freeze();
+        REQUIRE(db.getCatalogNumberByName("Vega", false) == 5);
+        REQUIRE(db.getCatalogNumberByName("deneb", false) == 6);
+        auto completion = complete(db, "ve");
+        REQUIRE(completion.size() == 1);
+        REQUIRE(completion[0].second == 5);
+        checkNames(db);
+    }
+
+    SUBCASE("Names are read back from a binary index")
+    {
+        db.add(4, "HR 7001");
+        db.freeze();
+
+        std::ostringstream out;
+        REQUIRE(db.writeIndex(out));
+        std::string data = out.str();
+        REQUIRE(NameDatabase::isIndex(data.data(), data.size()));
+
+        NameDatabase loaded;
+        REQUIRE(loaded.readIndex(data.data(), data.size()));
+        checkNames(loaded);
+
+        for (AstroCatalog::IndexNumber catalogNumber : { 1u, 2u, 3u, 4u })
+        {
+            auto expected = db.getFirstNameIter(catalogNumber);
+            auto actual = loaded.getFirstNameIter(catalogNumber);
+            for (; expected != db.getFinalNameIter() && expected->first == catalogNumber; ++expected, ++actual)
+            {
+                REQUIRE(actual != loaded.getFinalNameIter());
+                REQUIRE(actual->first == catalogNumber);
+                REQUIRE(actual->second == expected->second);
+            }
+            REQUIRE((actual == loaded.getFinalNameIter() || actual->first != catalogNumber));
+        }
+
+        NameDatabase truncated;
+        REQUIRE(!truncated.readIndex(data.data(), data.size() - 1));
+        REQUIRE(!NameDatabase::isIndex("Sirius", 6));
+    }
+
+    SUBCASE("Memory usage grows with the names")
+    {
+        std::size_t usage = db.getMemoryUsage();
+        REQUIRE(usage > NameDatabase().getMemoryUsage());
+
+        db.add(7, std::string(100, 'x'));
+        REQUIRE(db.getMemoryUsage() > usage + 200);
+        db.freeze();
+        REQUIRE(db.getMemoryUsage() > usage);
+    }
+}
+
+TEST_SUITE_END();
@@ -0,0 +1,102 @@
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include <celengine/nearstartracker.h>
+#include <celengine/stardb.h>
+#include <celengine/stardbbuilder.h>
+#include <celengine/univcoord.h>
+#include <celengine/universe.h>
+
+#include <doctest.h>
+
+using celestia::engine::NearStarTracker;
+
+namespace
+{
+
+std::unique_ptr<StarDatabase>
+makeCatalog()
+{
+    // Stars scattered within 20 ly of the origin
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<double> ra(0.0, 24.0);
+    std::uniform_real_distribution<double> dec(-90.0, 90.0);
+    std::uniform_real_distribution<double> distance(0.5, 20.0);
+
+    std::string stc;
+    for (int i = 1; i <= 500; ++i)
+    {
+        stc += fmt::format("{} {{ RA {} Dec {} Distance {} SpectralType \"G2V\" AbsMag 4.8 }}\n",
+                           i, ra(rng) * 15.0, dec(rng), distance(rng));
+    }
+
+    StarDatabaseBuilder builder;
+    REQUIRE(builder.load(std::string_view(stc)));
+    return builder.finish();
+}
+
+std::vector<const Star*>
+sorted(std::vector<const Star*> stars)
+{
+    std::sort(stars.begin(), stars.end());
+    return stars;
+}
+
+} // end unnamed namespace
+
+TEST_SUITE_BEGIN("NearStarTracker");
+
+TEST_CASE("Tracked stars match a search at every position")
+{
+    Universe universe;
+    universe.setStarCatalog(makeCatalog());
+
+    NearStarTracker tracker;
+    constexpr float radius = 3.0f;
+
+    // Small steps reuse the stars found, the jumps search again
+    Eigen::Vector3d position = Eigen::Vector3d::Zero();
+    for (int i = 0; i < 200; ++i)
+    {
+        position += i % 50 == 49 ? Eigen::Vector3d(5.0, -4.0, 2.0) : Eigen::Vector3d(0.02, 0.01, -0.015);
+
+        UniversalCoord coord = UniversalCoord::CreateLy(position);
+        std::vector<const Star*> expected;
+        universe.getNearStars(coord, radius, expected);
+        std::vector<const Star*> tracked;
+        tracker.find(universe, coord, radius, tracked);
+
+        REQUIRE(sorted(tracked) == sorted(expected));
+    }
+
+    REQUIRE(tracker.getSearchCount() < 40);
+}
+
+TEST_CASE("A larger radius or new catalogs search again")
+{
+    Universe universe;
+    universe.setStarCatalog(makeCatalog());
+
+    NearStarTracker tracker;
+    std::vector<const Star*> stars;
+    tracker.find(universe, UniversalCoord::Zero(), 2.0f, stars);
+    tracker.find(universe, UniversalCoord::Zero(), 2.0f, stars);
+    REQUIRE(tracker.getSearchCount() == 1);
+
+    tracker.find(universe, UniversalCoord::Zero(), 4.0f, stars);
+    REQUIRE(tracker.getSearchCount() == 2);
+
+    universe.catalogsChanged();
+    tracker.find(universe, UniversalCoord::Zero(), 4.0f, stars);
+    REQUIRE(tracker.getSearchCount() == 3);
+
+    tracker.reset();
+    tracker.find(universe, UniversalCoord::Zero(), 4.0f, stars);
+    REQUIRE(tracker.getSearchCount() == 4);
+}
+
+TEST_SUITE_END();
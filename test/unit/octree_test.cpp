@@ -0,0 +1,432 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+
+#include <celengine/octree.h>
+#include <celengine/octreebuilder.h>
+#include <celengine/octreecache.h>
+#include <celutil/threadpool.h>
+
+#include <doctest.h>
+
+namespace engine = celestia::engine;
+
+namespace
+{
+
+struct TestObject
+{
+    Eigen::Vector3f position;
+    float magnitude;
+    std::uint32_t id;
+};
+
+struct TestOctreeTraits
+{
+    using ObjectType = TestObject;
+    using PrecisionType = float;
+
+    static Eigen::Vector3f getPosition(const ObjectType& obj) { return obj.position; }
+    static float getRadius(const ObjectType&) { return 0.0f; }
+    static float getMagnitude(const ObjectType& obj) { return obj.magnitude; }
+    static float applyDecay(float factor) { return factor + 1.50515f; }
+};
+
+using TestOctree = engine::StaticOctree<TestObject, float>;
+using PlaneType = Eigen::Hyperplane<float, 3>;
+
+std::vector<TestObject>
+makeTestObjects(std::uint32_t count)
+{
+    std::mt19937 rng(12345);
+    std::uniform_real_distribution<float> position(-1000.0f, 1000.0f);
+    std::uniform_real_distribution<float> magnitude(-5.0f, 15.0f);
+
+    std::vector<TestObject> objects;
+    objects.reserve(count);
+    for (std::uint32_t i = 0; i < count; ++i)
+        objects.push_back({ Eigen::Vector3f(position(rng), position(rng), position(rng)), magnitude(rng), i });
+
+    return objects;
+}
+
+std::unique_ptr<TestOctree>
+buildTestOctree(std::uint32_t count,
+                std::vector<engine::OctreeObjectIndex>* objectOrder = nullptr,
+                celestia::util::ThreadPool* threadPool = nullptr)
+{
+    if (threadPool != nullptr)
+    {
+        return engine::makeDynamicOctree<TestOctreeTraits>(makeTestObjects(count),
+                                                           Eigen::Vector3f::Zero(),
+                                                           1000.0f,
+                                                           6.0f,
+                                                           8,
+                                                           *threadPool)->build(objectOrder);
+    }
+
+    auto dynamicOctree = engine::makeDynamicOctree<TestOctreeTraits>(makeTestObjects(count),
+                                                                     Eigen::Vector3f::Zero(),
+                                                                     1000.0f,
+                                                                     6.0f,
+                                                                     8);
+    return dynamicOctree->build(objectOrder);
+}
+
+class ScalarProcessor
+{
+public:
+    ScalarProcessor(const Eigen::Vector3f& obsPosition, const std::vector<PlaneType>& planes, float radius) :
+        m_obsPosition(obsPosition), m_planes(planes), m_radius(radius)
+    {}
+
+    bool checkNode(const Eigen::Vector3f& center, float size, float /* factor */)
+    {
+        for (const PlaneType& plane : m_planes)
+        {
+            if (plane.signedDistance(center) < -(size * plane.normal().cwiseAbs().sum()))
+                return false;
+        }
+
+        return (m_obsPosition - center).norm() - size * 1.7320508f <= m_radius;
+    }
+
+    void process(const TestObject& obj) { visited.push_back(obj.id); }
+
+    std::vector<std::uint32_t> visited;
+
+protected:
+    Eigen::Vector3f m_obsPosition;
+    std::vector<PlaneType> m_planes;
+    float m_radius;
+};
+
+class BatchedProcessor : public ScalarProcessor
+{
+public:
+    using ScalarProcessor::ScalarProcessor;
+
+    std::uint32_t checkNodes(const engine::OctreeNodeBatch<float>& batch)
+    {
+        auto distance = batch.distanceFrom(m_obsPosition) - batch.size * 1.7320508f;
+        return engine::OctreeNodeBatch<float>::toBitMask(batch.inFrustum(m_planes) && (distance <= m_radius));
+    }
+
+    void selectNode(unsigned int) { ++selected; }
+
+    std::uint32_t selected{ 0 };
+};
+
+class RangeProcessor : public ScalarProcessor
+{
+public:
+    using ScalarProcessor::ScalarProcessor;
+
+    void processObjects(const Eigen::Vector3f& center,
+                        float size,
+                        const TestObject* objects,
+                        engine::OctreeObjectIndex first,
+                        engine::OctreeObjectIndex last)
+    {
+        REQUIRE(first < last);
+        for (engine::OctreeObjectIndex idx = first; idx < last; ++idx)
+        {
+            REQUIRE((objects[idx].position - center).cwiseAbs().maxCoeff() <= size);
+            process(objects[idx]);
+        }
+    }
+};
+
+class ConeProcessor
+{
+public:
+    ConeProcessor(const Eigen::Vector3f& apex, const Eigen::Vector3f& axis, float angle) :
+        m_apex(apex), m_axis(axis), m_sinAngle(std::sin(angle)), m_cosAngle(std::cos(angle))
+    {}
+
+    bool checkNode(const Eigen::Vector3f&, float, float) { return true; }
+
+    std::uint32_t checkNodes(const engine::OctreeNodeBatch<float>& batch)
+    {
+        return engine::OctreeNodeBatch<float>::toBitMask(batch.inCone(m_apex, m_axis, m_sinAngle, m_cosAngle));
+    }
+
+    void selectNode(unsigned int) { /* no per-node state */ }
+
+    void process(const TestObject& obj) { visited.push_back(obj.id); }
+
+    bool inCone(const TestObject& obj) const
+    {
+        Eigen::Vector3f offset = obj.position - m_apex;
+        return offset.dot(m_axis) >= offset.norm() * m_cosAngle;
+    }
+
+    std::vector<std::uint32_t> visited;
+
+private:
+    Eigen::Vector3f m_apex;
+    Eigen::Vector3f m_axis;
+    float m_sinAngle;
+    float m_cosAngle;
+};
+
+class NodeRecorder
+{
+public:
+    bool checkNode(const Eigen::Vector3f& center, float size, float factor)
+    {
+        nodes.push_back({ center.x(), center.y(), center.z(), size, factor });
+        return true;
+    }
+
+    void process(const TestObject& obj) { visited.push_back(obj.id); }
+
+    std::vector<std::array<float, 5>> nodes;
+    std::vector<std::uint32_t> visited;
+};
+
+} // end unnamed namespace
+
+TEST_SUITE_BEGIN("Octree");
+
+TEST_CASE("Batched octree traversal matches scalar traversal")
+{
+    auto octree = buildTestOctree(20000);
+    REQUIRE(octree->size() == 20000);
+    REQUIRE(octree->nodeCount() > engine::OctreeNodeBatchSize);
+
+    const Eigen::Vector3f obsPosition(100.0f, -50.0f, 25.0f);
+
+    SUBCASE("Distance only")
+    {
+        ScalarProcessor scalar(obsPosition, {}, 300.0f);
+        BatchedProcessor batched(obsPosition, {}, 300.0f);
+
+        octree->processDepthFirst(scalar);
+        octree->processDepthFirst(batched);
+
+        REQUIRE(!scalar.visited.empty());
+        REQUIRE(scalar.visited.size() < octree->size());
+        REQUIRE(batched.selected > 0);
+        REQUIRE(scalar.visited == batched.visited);
+    }
+
+    SUBCASE("Frustum planes")
+    {
+        std::vector<PlaneType> planes
+        {
+            PlaneType(Eigen::Vector3f(1.0f, 0.0f, -1.0f).normalized(), obsPosition),
+            PlaneType(Eigen::Vector3f(-1.0f, 0.0f, -1.0f).normalized(), obsPosition),
+            PlaneType(Eigen::Vector3f(0.0f, 1.0f, -1.0f).normalized(), obsPosition),
+            PlaneType(Eigen::Vector3f(0.0f, -1.0f, -1.0f).normalized(), obsPosition),
+            PlaneType(Eigen::Vector3f(0.0f, 0.0f, -1.0f), obsPosition),
+        };
+
+        ScalarProcessor scalar(obsPosition, planes, 5000.0f);
+        BatchedProcessor batched(obsPosition, planes, 5000.0f);
+
+        octree->processDepthFirst(scalar);
+        octree->processDepthFirst(batched);
+
+        REQUIRE(!scalar.visited.empty());
+        REQUIRE(scalar.visited.size() < octree->size());
+        REQUIRE(scalar.visited == batched.visited);
+    }
+}
+
+TEST_CASE("Cone traversal finds all objects in the cone")
+{
+    auto octree = buildTestOctree(20000);
+    auto objects = makeTestObjects(20000);
+
+    Eigen::Vector3f apex(100.0f, -50.0f, 20.0f);
+    Eigen::Vector3f axis = Eigen::Vector3f(1.0f, 2.0f, -0.5f).normalized();
+    ConeProcessor processor(apex, axis, 0.05f);
+    octree->processDepthFirst(processor);
+
+    std::vector<std::uint32_t> expected;
+    for (const TestObject& obj : objects)
+    {
+        if (processor.inCone(obj))
+            expected.push_back(obj.id);
+    }
+
+    std::sort(processor.visited.begin(), processor.visited.end());
+    REQUIRE(!expected.empty());
+    REQUIRE(std::includes(processor.visited.begin(), processor.visited.end(),
+                          expected.begin(), expected.end()));
+    // Whole subtrees away from the ray are skipped
+    REQUIRE(processor.visited.size() < objects.size());
+}
+
+TEST_CASE("Split octree traversal matches full traversal")
+{
+    auto octree = buildTestOctree(20000);
+    const Eigen::Vector3f obsPosition(-200.0f, 10.0f, 400.0f);
+
+    for (engine::OctreeDepthType splitDepth = 0; splitDepth < 4; ++splitDepth)
+    {
+        BatchedProcessor full(obsPosition, {}, 500.0f);
+        octree->processDepthFirst(full);
+
+        BatchedProcessor splitter(obsPosition, {}, 500.0f);
+        std::vector<engine::OctreeNodeRange> ranges;
+        octree->splitDepthFirst(splitter, splitDepth, ranges);
+        REQUIRE(!ranges.empty());
+
+        std::vector<std::uint32_t> visited;
+        for (const auto& range : ranges)
+        {
+            ScalarProcessor rangeProcessor(obsPosition, {}, 500.0f);
+            octree->processDepthFirst(rangeProcessor, range);
+            visited.insert(visited.end(), rangeProcessor.visited.begin(), rangeProcessor.visited.end());
+        }
+
+        REQUIRE(visited == full.visited);
+    }
+}
+
+TEST_CASE("Subset traversal matches full traversal")
+{
+    auto octree = buildTestOctree(20000);
+    const Eigen::Vector3f obsPosition(-100.0f, 200.0f, 0.0f);
+
+    // Select with a looser test, then process with the strict one from a
+    // nearby position
+    ScalarProcessor selector(obsPosition, {}, 600.0f);
+    engine::OctreeNodeSubset subset;
+    octree->selectDepthFirst(selector, subset);
+    REQUIRE(!subset.nodes.empty());
+    REQUIRE(subset.nodes.size() < octree->nodeCount());
+    REQUIRE(subset.right.size() == subset.nodes.size());
+
+    const Eigen::Vector3f movedPosition = obsPosition + Eigen::Vector3f(50.0f, -20.0f, 10.0f);
+    ScalarProcessor full(movedPosition, {}, 500.0f);
+    ScalarProcessor partial(movedPosition, {}, 500.0f);
+    octree->processDepthFirst(full);
+    octree->processDepthFirst(partial, subset);
+
+    REQUIRE(!full.visited.empty());
+    REQUIRE(full.visited == partial.visited);
+}
+
+TEST_CASE("Range processing matches per-object processing")
+{
+    auto octree = buildTestOctree(20000);
+    const Eigen::Vector3f obsPosition(50.0f, 50.0f, -300.0f);
+
+    ScalarProcessor scalar(obsPosition, {}, 400.0f);
+    RangeProcessor range(obsPosition, {}, 400.0f);
+    octree->processDepthFirst(scalar);
+    octree->processDepthFirst(range);
+
+    REQUIRE(!scalar.visited.empty());
+    REQUIRE(scalar.visited == range.visited);
+}
+
+TEST_CASE("Parallel octree build matches sequential build")
+{
+    celestia::util::ThreadPool threadPool(3);
+
+    for (std::uint32_t count : { 0U, 7U, 1000U, 100000U })
+    {
+        std::vector<engine::OctreeObjectIndex> sequentialOrder;
+        std::vector<engine::OctreeObjectIndex> parallelOrder;
+        auto sequential = buildTestOctree(count, &sequentialOrder);
+        auto parallel = buildTestOctree(count, &parallelOrder, &threadPool);
+
+        REQUIRE(parallel->size() == sequential->size());
+        REQUIRE(parallel->nodeCount() == sequential->nodeCount());
+        REQUIRE(parallelOrder == sequentialOrder);
+
+        NodeRecorder sequentialNodes;
+        NodeRecorder parallelNodes;
+        sequential->processDepthFirst(sequentialNodes);
+        parallel->processDepthFirst(parallelNodes);
+        REQUIRE(parallelNodes.nodes == sequentialNodes.nodes);
+        REQUIRE(parallelNodes.visited == sequentialNodes.visited);
+    }
+}
+
+TEST_CASE("Octree cache round trip")
+{
+    using Cache = engine::OctreeCache<TestOctreeTraits>;
+
+    std::vector<engine::OctreeObjectIndex> objectOrder;
+    auto octree = buildTestOctree(5000, &objectOrder);
+    REQUIRE(objectOrder.size() == octree->size());
+
+    auto objects = makeTestObjects(5000);
+    auto key = Cache::computeKey(objects, Eigen::Vector3f::Zero(), 1000.0f, 6.0f, 8);
+
+    fs::path cachePath = fs::temp_directory_path() / "celestia_octree_test.cache";
+    REQUIRE(Cache(cachePath, key).save(*octree, objectOrder));
+
+    SUBCASE("Mismatched key is rejected")
+    {
+        REQUIRE(Cache(cachePath, key + 1).load(objects) == nullptr);
+    }
+
+    SUBCASE("Matching key restores the octree")
+    {
+        auto cached = Cache(cachePath, key).load(objects);
+        REQUIRE(cached != nullptr);
+        REQUIRE(cached->nodeCount() == octree->nodeCount());
+        REQUIRE(cached->size() == octree->size());
+
+        const Eigen::Vector3f obsPosition(300.0f, 300.0f, -100.0f);
+        BatchedProcessor original(obsPosition, {}, 400.0f);
+        BatchedProcessor restored(obsPosition, {}, 400.0f);
+        octree->processDepthFirst(original);
+        cached->processDepthFirst(restored);
+        REQUIRE(!original.visited.empty());
+        REQUIRE(original.visited == restored.visited);
+
+        NodeRecorder originalNodes;
+        NodeRecorder restoredNodes;
+        octree->processDepthFirst(originalNodes);
+        cached->processDepthFirst(restoredNodes);
+        REQUIRE(originalNodes.nodes == restoredNodes.nodes);
+        REQUIRE(originalNodes.visited == restoredNodes.visited);
+    }
+
+    SUBCASE("Truncated cache is rejected")
+    {
+        fs::resize_file(cachePath, fs::file_size(cachePath) - 1);
+        REQUIRE(Cache(cachePath, key).load(objects) == nullptr);
+    }
+
+    SUBCASE("Mapped octree can be saved again")
+    {
+        auto cached = Cache(cachePath, key).load(objects);
+        REQUIRE(cached != nullptr);
+
+        fs::path copyPath = fs::temp_directory_path() / "celestia_octree_test_copy.cache";
+        REQUIRE(Cache(copyPath, key).save(*cached, objectOrder));
+
+        auto copyObjects = makeTestObjects(5000);
+        auto copy = Cache(copyPath, key).load(copyObjects);
+        REQUIRE(copy != nullptr);
+
+        NodeRecorder originalNodes;
+        NodeRecorder copyNodes;
+        octree->processDepthFirst(originalNodes);
+        copy->processDepthFirst(copyNodes);
+        REQUIRE(originalNodes.nodes == copyNodes.nodes);
+        REQUIRE(originalNodes.visited == copyNodes.visited);
+
+        std::error_code ec;
+        fs::remove(copyPath, ec);
+    }
+
+    std::error_code ec;
+    fs::remove(cachePath, ec);
+}
+
+TEST_SUITE_END();
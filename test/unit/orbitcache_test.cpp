@@ -0,0 +1,106 @@
+#include <atomic>
+#include <future>
+#include <memory>
+
+#include <Eigen/Core>
+
+#include <celengine/orbitcache.h>
+#include <celengine/render.h>
+#include <celephem/orbit.h>
+#include <celutil/threadpool.h>
+
+#include <doctest.h>
+
+namespace ephem = celestia::ephem;
+namespace util = celestia::util;
+
+namespace
+{
+
+// Orbit whose sampling waits until it is released
+class BlockingOrbit : public ephem::Orbit
+{
+public:
+    BlockingOrbit(std::shared_future<void> release, std::atomic<bool>& sampled, std::atomic<bool>& destroyed) :
+        m_release(std::move(release)),
+        m_sampled(sampled),
+        m_destroyed(destroyed)
+    {
+    }
+
+    ~BlockingOrbit() override { m_destroyed = true; }
+
+    Eigen::Vector3d positionAtTime(double jd) const override { return Eigen::Vector3d(jd, 0.0, 0.0); }
+    double getPeriod() const override { return 1.0; }
+    double getBoundingRadius() const override { return 1.0; }
+    bool isThreadSafe() const override { return true; }
+
+    void sample(double startTime, double endTime, ephem::OrbitSampleProc& proc) const override
+    {
+        m_release.wait();
+        proc.sample(startTime, positionAtTime(startTime), Eigen::Vector3d::UnitX());
+        proc.sample(endTime, positionAtTime(endTime), Eigen::Vector3d::UnitX());
+        m_sampled = true;
+    }
+
+private:
+    std::shared_future<void> m_release;
+    std::atomic<bool>& m_sampled;
+    std::atomic<bool>& m_destroyed;
+};
+
+} // end unnamed namespace
+
+TEST_SUITE_BEGIN("OrbitCache");
+
+TEST_CASE("Orbit destroyed while its samples are pending")
+{
+    std::promise<void> release;
+    std::atomic<bool> sampled{ false };
+    std::atomic<bool> destroyed{ false };
+
+    Renderer renderer;
+    {
+        util::ThreadPool pool(1);
+        OrbitCache cache(renderer, OrbitCache::DefaultBudget, &pool);
+
+        auto orbit = std::make_shared<BlockingOrbit>(release.get_future().share(), sampled, destroyed);
+        REQUIRE(cache.get(orbit, 0.0, 1) != nullptr);
+
+        // Replace the orbit and drop its cached path, as a catalog reload
+        // does, while the sampling task is still waiting
+        orbit.reset();
+        cache.clear();
+        REQUIRE_FALSE(destroyed);
+
+        release.set_value();
+        // Destroying the pool completes the sampling task
+    }
+
+    REQUIRE(sampled);
+    REQUIRE(destroyed);
+}
+
+TEST_CASE("Cached path keeps its orbit alive")
+{
+    std::promise<void> release;
+    release.set_value();
+    std::atomic<bool> sampled{ false };
+    std::atomic<bool> destroyed{ false };
+
+    Renderer renderer;
+    OrbitCache cache(renderer, OrbitCache::DefaultBudget, nullptr);
+
+    auto orbit = std::make_shared<BlockingOrbit>(release.get_future().share(), sampled, destroyed);
+    REQUIRE(cache.get(orbit, 0.0, 1) != nullptr);
+    REQUIRE(sampled);
+
+    orbit.reset();
+    REQUIRE_FALSE(destroyed);
+    REQUIRE(cache.size() == 1);
+
+    cache.clear();
+    REQUIRE(destroyed);
+}
+
+TEST_SUITE_END();
@@ -0,0 +1,73 @@
+#include <array>
+
+#include <celengine/pathcache.h>
+#include <celengine/star.h>
+
+#include <doctest.h>
+
+TEST_SUITE_BEGIN("PathCache");
+
+TEST_CASE("Paths are cached by context and localization")
+{
+    std::array<Star, 3> stars;
+    Selection sol(&stars[0]);
+    Selection earth(&stars[1]);
+    Selection moon(&stars[2]);
+
+    PathCache cache(2);
+    REQUIRE(!cache.find("Sol/Earth", { &sol, 1 }, false, 1).has_value());
+    cache.insert("Sol/Earth", { &sol, 1 }, false, earth);
+
+    auto found = cache.find("Sol/Earth", { &sol, 1 }, false, 1);
+    REQUIRE(found.has_value());
+    REQUIRE(*found == earth);
+
+    // Other contexts and localized lookups are separate entries
+    REQUIRE(!cache.find("Sol/Earth", {}, false, 1).has_value());
+    REQUIRE(!cache.find("Sol/Earth", { &sol, 1 }, true, 1).has_value());
+
+    // Paths which weren't found are remembered as well
+    cache.insert("Sol/Nowhere", { &sol, 1 }, false, Selection());
+    found = cache.find("Sol/Nowhere", { &sol, 1 }, false, 1);
+    REQUIRE(found.has_value());
+    REQUIRE(found->empty());
+
+    REQUIRE(cache.getStats().hits == 2);
+    REQUIRE(cache.getStats().misses == 3);
+}
+
+TEST_CASE("The least recently used path is evicted")
+{
+    std::array<Star, 3> stars;
+    Selection a(&stars[0]);
+    Selection b(&stars[1]);
+    Selection c(&stars[2]);
+
+    // Entries belong to the generation of the last lookup
+    PathCache cache(2);
+    REQUIRE(!cache.find("a", {}, false, 1).has_value());
+    cache.insert("a", {}, false, a);
+    cache.insert("b", {}, false, b);
+    REQUIRE(cache.find("a", {}, false, 1).has_value());
+
+    cache.insert("c", {}, false, c);
+    REQUIRE(cache.size() == 2);
+    REQUIRE(cache.find("a", {}, false, 1).has_value());
+    REQUIRE(!cache.find("b", {}, false, 1).has_value());
+    REQUIRE(cache.find("c", {}, false, 1).has_value());
+}
+
+TEST_CASE("A new catalog generation empties the cache")
+{
+    Star star;
+    Selection sel(&star);
+
+    PathCache cache;
+    REQUIRE(!cache.find("x", {}, false, 1).has_value());
+    cache.insert("x", {}, false, sel);
+    REQUIRE(cache.find("x", {}, false, 1).has_value());
+    REQUIRE(!cache.find("x", {}, false, 2).has_value());
+    REQUIRE(cache.size() == 0);
+}
+
+TEST_SUITE_END();
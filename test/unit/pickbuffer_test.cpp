@@ -0,0 +1,77 @@
+#include <celengine/pickbuffer.h>
+#include <celengine/star.h>
+
+#include <doctest.h>
+
+using celestia::engine::PickBuffer;
+using Layer = PickBuffer::Layer;
+
+TEST_SUITE_BEGIN("PickBuffer");
+
+TEST_CASE("The nearest disc under the point is picked")
+{
+    Star near;
+    Star far;
+    PickBuffer buffer;
+    buffer.reset(640, 480);
+
+    buffer.add(Layer::Body, Selection(&far), { 320.0f, 240.0f }, 100.0f, 1000.0f, true);
+    buffer.add(Layer::Body, Selection(&near), { 360.0f, 240.0f }, 30.0f, 10.0f, true);
+
+    REQUIRE(buffer.pick({ 370.0f, 245.0f }, 4.0f).body == Selection(&near));
+    REQUIRE(buffer.pick({ 300.0f, 245.0f }, 4.0f).body == Selection(&far));
+    REQUIRE(buffer.pick({ 600.0f, 20.0f }, 4.0f).body.empty());
+}
+
+TEST_CASE("A small body in front of a disc is picked within the tolerance")
+{
+    Star planet;
+    Star moon;
+    Star behind;
+    PickBuffer buffer;
+    buffer.reset(640, 480);
+
+    buffer.add(Layer::Body, Selection(&planet), { 320.0f, 240.0f }, 100.0f, 1000.0f, true);
+    buffer.add(Layer::Body, Selection(&moon), { 350.0f, 240.0f }, 0.5f, 500.0f, true);
+    buffer.add(Layer::Body, Selection(&behind), { 290.0f, 240.0f }, 0.5f, 5000.0f, true);
+
+    REQUIRE(buffer.pick({ 352.0f, 241.0f }, 4.0f).body == Selection(&moon));
+    REQUIRE(buffer.pick({ 360.0f, 241.0f }, 4.0f).body == Selection(&planet));
+    REQUIRE(buffer.pick({ 291.0f, 240.0f }, 4.0f).body == Selection(&planet));
+}
+
+TEST_CASE("Picks on bounding discs are left unresolved")
+{
+    Star mesh;
+    Star galaxy;
+    Star cluster;
+    PickBuffer buffer;
+    buffer.reset(640, 480);
+
+    buffer.add(Layer::Body, Selection(&mesh), { 100.0f, 100.0f }, 20.0f, 10.0f, false);
+    REQUIRE(buffer.pick({ 105.0f, 100.0f }, 4.0f).body.empty());
+
+    buffer.add(Layer::DeepSky, Selection(&cluster), { 400.0f, 300.0f }, 50.0f, 1.0e9f, true);
+    REQUIRE(buffer.pick({ 420.0f, 300.0f }, 4.0f).deepSky == Selection(&cluster));
+
+    buffer.add(Layer::DeepSky, Selection(&galaxy), { 430.0f, 300.0f }, 20.0f, 1.0e10f, false);
+    REQUIRE(buffer.pick({ 420.0f, 300.0f }, 4.0f).deepSky.empty());
+    REQUIRE(buffer.pick({ 370.0f, 300.0f }, 4.0f).deepSky == Selection(&cluster));
+}
+
+TEST_CASE("Discs extending beyond the window")
+{
+    Star star;
+    PickBuffer buffer(16.0f);
+    buffer.reset(640, 480);
+
+    buffer.add(Layer::Body, Selection(&star), { -1.0e6f, 240.0f }, 1.0e6f + 50.0f, 10.0f, true);
+    REQUIRE(buffer.pick({ 40.0f, 240.0f }, 4.0f).body == Selection(&star));
+    REQUIRE(buffer.pick({ 60.0f, 240.0f }, 4.0f).body.empty());
+
+    buffer.reset(640, 480);
+    REQUIRE(buffer.size() == 0);
+    REQUIRE(buffer.pick({ 40.0f, 240.0f }, 4.0f).body.empty());
+}
+
+TEST_SUITE_END();
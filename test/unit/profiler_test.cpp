@@ -0,0 +1,119 @@
+#include <cstddef>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <system_error>
+#include <thread>
+
+#include <celcompat/filesystem.h>
+#include <celutil/profiler.h>
+
+#include <doctest.h>
+
+using celestia::util::Profiler;
+using celestia::util::ProfileZone;
+
+namespace
+{
+
+std::string
+readFile(const fs::path& path)
+{
+    std::ifstream in(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+std::size_t
+countOf(const std::string& str, const std::string& pattern)
+{
+    std::size_t count = 0;
+    for (auto pos = str.find(pattern); pos != std::string::npos; pos = str.find(pattern, pos + 1))
+        ++count;
+    return count;
+}
+
+} // end unnamed namespace
+
+TEST_SUITE_BEGIN("Profiler");
+
+TEST_CASE("Profiler")
+{
+    const fs::path path = fs::temp_directory_path() / "celestia_profiler_test.json";
+    Profiler::clear();
+
+    SUBCASE("Zones are only recorded when enabled")
+    {
+        Profiler::setEnabled(false);
+        {
+            ProfileZone zone("Disabled");
+        }
+
+        Profiler::setEnabled(true);
+        {
+            ProfileZone outer("Outer \"zone\"");
+            ProfileZone inner("Inner");
+        }
+        auto gpuBegin = Profiler::now();
+        Profiler::recordGPU("Frame", gpuBegin, gpuBegin + 1000);
+
+        std::thread worker([] { ProfileZone zone("Worker"); });
+        worker.join();
+        Profiler::setEnabled(false);
+
+        REQUIRE(Profiler::writeTrace(path));
+        std::string trace = readFile(path);
+        REQUIRE(trace.find("\"traceEvents\": [") != std::string::npos);
+        REQUIRE(trace.find("Disabled") == std::string::npos);
+        REQUIRE(trace.find("\"name\": \"Outer \\\"zone\\\"\", \"ph\": \"X\"") != std::string::npos);
+        REQUIRE(trace.find("\"name\": \"Inner\"") != std::string::npos);
+        REQUIRE(trace.find("\"name\": \"Worker\"") != std::string::npos);
+        REQUIRE(trace.find("\"args\": {\"name\": \"GPU\"}") != std::string::npos);
+        REQUIRE(trace.find("\"name\": \"Frame\", \"ph\": \"X\", \"pid\": 1, \"tid\": 0") != std::string::npos);
+        REQUIRE(trace.find("\"dur\": 1.000}") != std::string::npos);
+    }
+
+    SUBCASE("Counters and instant events are recorded")
+    {
+        Profiler::recordCounter("Disabled", 1.0);
+
+        Profiler::setEnabled(true);
+        Profiler::recordCounter("TextureMemory", 1024.0);
+        Profiler::recordInstant("load", "textures/earth.jpg");
+        std::thread worker([]
+        {
+            Profiler::setThreadName("Loader");
+            Profiler::recordInstant("load", "models/iss.cmod");
+        });
+        worker.join();
+        Profiler::setEnabled(false);
+
+        REQUIRE(Profiler::writeTrace(path));
+        std::string trace = readFile(path);
+        REQUIRE(trace.find("Disabled") == std::string::npos);
+        REQUIRE(trace.find("\"name\": \"TextureMemory\", \"ph\": \"C\"") != std::string::npos);
+        REQUIRE(trace.find("\"args\": {\"value\": 1024}") != std::string::npos);
+        REQUIRE(trace.find("\"name\": \"textures/earth.jpg\", \"cat\": \"load\", \"ph\": \"i\"") != std::string::npos);
+        REQUIRE(trace.find("\"name\": \"models/iss.cmod\"") != std::string::npos);
+        REQUIRE(trace.find("\"args\": {\"name\": \"Loader\"}") != std::string::npos);
+    }
+
+    SUBCASE("Only the latest zones are kept")
+    {
+        for (std::size_t i = 0; i < Profiler::BufferSize; ++i)
+            Profiler::record("Old", 0, 1);
+        Profiler::record("New", 2, 3);
+
+        REQUIRE(Profiler::writeTrace(path));
+        std::string trace = readFile(path);
+        REQUIRE(countOf(trace, "\"name\": \"Old\"") == Profiler::BufferSize - 1);
+        REQUIRE(countOf(trace, "\"name\": \"New\"") == 1);
+        // The zones are written oldest first
+        REQUIRE(trace.rfind("\"name\": \"Old\"") < trace.find("\"name\": \"New\""));
+    }
+
+    Profiler::clear();
+    std::error_code ec;
+    fs::remove(path, ec);
+}
+
+TEST_SUITE_END();
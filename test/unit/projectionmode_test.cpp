@@ -0,0 +1,83 @@
+#include <array>
+#include <cmath>
+
+#include <Eigen/Core>
+
+#include <celengine/perspectiveprojectionmode.h>
+#include <celmath/geomutil.h>
+
+#include <doctest.h>
+
+using celestia::engine::PerspectiveProjectionMode;
+
+namespace
+{
+
+// Project to the pixel coordinates of a viewport
+Eigen::Vector3f
+project(const Eigen::Matrix4f& projection, const Eigen::Vector3f& pos, int width, int height)
+{
+    Eigen::Vector3f result;
+    celestia::math::ProjectPerspective(pos, projection, std::array<int, 4>{ 0, 0, width, height }, result);
+    return result;
+}
+
+} // end unnamed namespace
+
+TEST_SUITE_BEGIN("ProjectionMode");
+
+TEST_CASE("Perspective tiles cover the image")
+{
+    constexpr int width = 640;
+    constexpr int height = 480;
+    PerspectiveProjectionMode projection(width, height, 400, 96);
+    Eigen::Matrix4f image = projection.getProjectionMatrix(1.0f, 1000.0f, 1.0f);
+    float pixelSize = projection.getPixelSize(1.0f);
+
+    const std::array<Eigen::Vector3f, 3> points
+    {
+        Eigen::Vector3f(0.1f, 0.2f, -10.0f),
+        Eigen::Vector3f(-3.0f, 1.5f, -15.0f),
+        Eigen::Vector3f(2.0f, -2.5f, -20.0f),
+    };
+
+    for (const auto& point : points)
+    {
+        // The image is twice the size of the viewport, positions within it
+        // are scaled by two
+        Eigen::Vector3f expected = project(image, point, width, height) * 2.0f;
+        auto column = static_cast<int>(std::floor(expected.x() / width));
+        auto row = static_cast<int>(std::floor(expected.y() / height));
+        REQUIRE(projection.setTile(2, 2, column, row));
+
+        Eigen::Vector3f actual = project(projection.getProjectionMatrix(1.0f, 1000.0f, 1.0f), point, width, height);
+        CHECK(actual.x() + static_cast<float>(column * width) == doctest::Approx(expected.x()).epsilon(1e-4));
+        CHECK(actual.y() + static_cast<float>(row * height) == doctest::Approx(expected.y()).epsilon(1e-4));
+        REQUIRE(projection.setTile(1, 1, 0, 0));
+    }
+
+    REQUIRE(projection.setTile(2, 2, 1, 1));
+    CHECK(projection.getPixelSize(1.0f) == doctest::Approx(pixelSize * 0.5f));
+}
+
+TEST_CASE("Perspective tiles keep the vertical field of view")
+{
+    PerspectiveProjectionMode projection(640, 480, 400, 96);
+    float fov = projection.getFOV(1.0f);
+    double viewCone = projection.getViewConeAngleMax(1.0f);
+
+    REQUIRE(projection.setTile(3, 1, 0, 0));
+    CHECK(projection.getFOV(1.0f) == fov);
+    // Wider image, so a wider cone
+    CHECK(projection.getViewConeAngleMax(1.0f) < viewCone);
+}
+
+TEST_CASE("Perspective tiles outside the grid are rejected")
+{
+    PerspectiveProjectionMode projection(640, 480, 400, 96);
+    CHECK(!projection.setTile(2, 2, 2, 0));
+    CHECK(!projection.setTile(2, 2, 0, -1));
+    CHECK(!projection.setTile(0, 1, 0, 0));
+}
+
+TEST_SUITE_END();
@@ -0,0 +1,113 @@
+#include <celengine/qualitygovernor.h>
+
+#include <doctest.h>
+
+using namespace celestia::engine;
+
+namespace
+{
+
+FrameCounters
+makeFrame(double cpuTime, std::optional<double> gpuTime = std::nullopt)
+{
+    FrameCounters counters;
+    counters.stageTimes[static_cast<std::size_t>(FrameStage::SolarSystem)] = cpuTime;
+    counters.gpuTime = gpuTime;
+    return counters;
+}
+
+// Feed frames of the given time, and return the number of level changes
+int
+run(QualityGovernor& governor, int frames, double cpuTime, std::optional<double> gpuTime = std::nullopt)
+{
+    int changes = 0;
+    for (int i = 0; i < frames; ++i)
+    {
+        if (governor.update(makeFrame(cpuTime, gpuTime)))
+            ++changes;
+    }
+    return changes;
+}
+
+QualityLimits
+makeLimits()
+{
+    QualityLimits limits;
+    limits.targetFrameTime = 16.0;
+    limits.galaxyPointBudget = { 0.0, 100000.0 };
+    limits.maxLabels = { 800.0, 100.0 };
+    limits.shadowMapSize = { 2048.0, 512.0 };
+    return limits;
+}
+
+} // end unnamed namespace
+
+TEST_SUITE_BEGIN("QualityGovernor");
+
+TEST_CASE("The governor is disabled without a target")
+{
+    QualityGovernor governor;
+    REQUIRE(!governor.isEnabled());
+    REQUIRE(run(governor, 100, 100.0) == 0);
+    REQUIRE(governor.getLevel() == 0);
+}
+
+TEST_CASE("Slow frames lower the quality and fast frames raise it")
+{
+    QualityGovernor governor;
+    governor.setLimits(makeLimits());
+
+    // Frames within the tolerance keep the level
+    REQUIRE(run(governor, 200, 17.0) == 0);
+
+    REQUIRE(run(governor, 200, 40.0) > 0);
+    int level = governor.getLevel();
+    REQUIRE(level > 0);
+    REQUIRE(governor.getFrameTime() == doctest::Approx(40.0).epsilon(0.01));
+
+    // The level is raised more slowly than it is lowered
+    REQUIRE(run(governor, 60, 5.0) == 0);
+    REQUIRE(governor.getLevel() == level);
+    run(governor, 2000, 5.0);
+    REQUIRE(governor.getLevel() == 0);
+    REQUIRE(governor.getAdjustments() == static_cast<std::uint32_t>(2 * level));
+}
+
+TEST_CASE("The GPU time counts when it is the larger")
+{
+    QualityGovernor governor;
+    governor.setLimits(makeLimits());
+    run(governor, 100, 5.0, 40.0);
+    REQUIRE(governor.getLevel() > 0);
+}
+
+TEST_CASE("The settings span the limits")
+{
+    QualityGovernor governor;
+    governor.setLimits(makeLimits());
+
+    QualitySettings best = governor.getSettings();
+    REQUIRE(best.magnitudeOffset == 0.0f);
+    REQUIRE(best.galaxyPointBudget == 0);
+    REQUIRE(best.maxLabels == 800);
+    REQUIRE(best.orbitTolerance == 1.0);
+    REQUIRE(best.sphereDetail == 1.0f);
+    REQUIRE(best.shadowMapSize == 2048);
+
+    run(governor, 10000, 100.0);
+    REQUIRE(governor.getLevel() == QualityGovernor::MaxLevel);
+
+    QualitySettings worst = governor.getSettings();
+    REQUIRE(worst.magnitudeOffset == doctest::Approx(-2.0f));
+    REQUIRE(worst.galaxyPointBudget == doctest::Approx(100000).epsilon(0.001));
+    REQUIRE(worst.maxLabels == doctest::Approx(100).epsilon(0.01));
+    REQUIRE(worst.orbitTolerance == doctest::Approx(8.0));
+    REQUIRE(worst.sphereDetail == doctest::Approx(0.25f));
+    REQUIRE(worst.shadowMapSize == 512);
+
+    governor.reset();
+    REQUIRE(governor.getLevel() == 0);
+    REQUIRE(governor.getAdjustments() == 0);
+}
+
+TEST_SUITE_END();
@@ -0,0 +1,129 @@
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <Eigen/Core>
+
+#include <celmath/randutils.h>
+
+#include <doctest.h>
+
+using celestia::math::RandomLanes;
+using celestia::math::Xoshiro128;
+
+TEST_SUITE_BEGIN("randutils");
+
+TEST_CASE("Xoshiro128 is deterministic per seed and stream")
+{
+    Xoshiro128 a(1312, 3);
+    Xoshiro128 b(1312, 3);
+    Xoshiro128 otherStream(1312, 4);
+    Xoshiro128 otherSeed(1313, 3);
+
+    int sameStream = 0;
+    int sameSeed = 0;
+    for (int i = 0; i < 64; ++i)
+    {
+        auto x = a();
+        REQUIRE(x == b());
+        sameStream += x == otherStream() ? 1 : 0;
+        sameSeed += x == otherSeed() ? 1 : 0;
+    }
+
+    REQUIRE(sameStream < 2);
+    REQUIRE(sameSeed < 2);
+}
+
+TEST_CASE("Xoshiro128 discard skips values")
+{
+    Xoshiro128 a(42);
+    Xoshiro128 b(42);
+    for (int i = 0; i < 10; ++i)
+        a();
+    b.discard(10);
+    REQUIRE(a() == b());
+}
+
+TEST_CASE("RandomLanes match scalar generators")
+{
+    RandomLanes lanes(7, 100);
+    std::vector<Xoshiro128> scalars;
+    for (std::size_t i = 0; i < RandomLanes::LaneCount; ++i)
+        scalars.emplace_back(7, 100 + i);
+
+    RandomLanes::Block block;
+    for (int step = 0; step < 16; ++step)
+    {
+        lanes.next(block);
+        for (std::size_t i = 0; i < RandomLanes::LaneCount; ++i)
+            REQUIRE(block[i] == scalars[i]());
+    }
+}
+
+TEST_CASE("fillUniform stays in range")
+{
+    RandomLanes lanes(1);
+    std::vector<float> values(1001);
+    celestia::math::fillUniform(lanes, values.data(), values.size(), -2.0f, 3.0f);
+
+    double sum = 0.0;
+    for (float v : values)
+    {
+        REQUIRE(v >= -2.0f);
+        REQUIRE(v < 3.0f);
+        sum += v;
+    }
+
+    REQUIRE(sum / values.size() == doctest::Approx(0.5).epsilon(0.1));
+}
+
+TEST_CASE("fillNormal has the requested moments")
+{
+    RandomLanes lanes(2);
+    std::vector<float> values(20001);
+    celestia::math::fillNormal(lanes, values.data(), values.size(), 1.0f, 2.0f);
+
+    double sum = 0.0;
+    double sumSq = 0.0;
+    for (float v : values)
+    {
+        REQUIRE(std::isfinite(v));
+        sum += v;
+        sumSq += static_cast<double>(v) * v;
+    }
+
+    double mean = sum / values.size();
+    double variance = sumSq / values.size() - mean * mean;
+    REQUIRE(mean == doctest::Approx(1.0).epsilon(0.05));
+    REQUIRE(variance == doctest::Approx(4.0).epsilon(0.05));
+}
+
+TEST_CASE("fillOnSphere returns unit vectors")
+{
+    RandomLanes lanes(3);
+    std::vector<Eigen::Vector3f> points(999);
+    celestia::math::fillOnSphere(lanes, points.data(), points.size());
+
+    Eigen::Vector3f sum = Eigen::Vector3f::Zero();
+    for (const auto& p : points)
+    {
+        REQUIRE(p.norm() == doctest::Approx(1.0f).epsilon(1.0e-5));
+        sum += p;
+    }
+
+    REQUIRE(sum.norm() / points.size() < 0.1f);
+}
+
+TEST_CASE("Batched output is reproducible")
+{
+    RandomLanes a(11, 5);
+    RandomLanes b(11, 5);
+    std::vector<float> x(37);
+    std::vector<float> y(37);
+    celestia::math::fillNormal(a, x.data(), x.size());
+    celestia::math::fillNormal(b, y.data(), y.size());
+    REQUIRE(x == y);
+}
+
+TEST_SUITE_END();
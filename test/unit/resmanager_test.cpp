@@ -0,0 +1,339 @@
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <celutil/resmanager.h>
+
+#include <doctest.h>
+
+namespace
+{
+
+struct TestResource
+{
+    std::string name;
+};
+
+struct SyncInfo
+{
+    using ResourceType = TestResource;
+    using ResourceKey = std::string;
+
+    std::string name;
+
+    std::string resolve(const fs::path&) const { return name; }
+    std::unique_ptr<TestResource> load(const std::string& key) const
+    {
+        if (key.empty())
+            return nullptr;
+        return std::make_unique<TestResource>(TestResource{ key });
+    }
+};
+
+bool operator<(const SyncInfo& a, const SyncInfo& b) { return a.name < b.name; }
+
+struct AsyncInfo
+{
+    using ResourceType = TestResource;
+    using ResourceKey = std::string;
+    using DecodedType = std::string;
+
+    std::string name;
+    std::string alias;
+
+    std::string resolve(const fs::path&) const { return alias.empty() ? name : alias; }
+    std::unique_ptr<TestResource> load(const std::string& key) const
+    {
+        return create(key, decode(key));
+    }
+    std::unique_ptr<std::string> decode(const std::string& key) const
+    {
+        if (key.empty())
+            return nullptr;
+        return std::make_unique<std::string>(key + " decoded");
+    }
+    std::unique_ptr<TestResource> create(const std::string&, std::unique_ptr<std::string> decoded) const
+    {
+        if (decoded == nullptr)
+            return nullptr;
+        return std::make_unique<TestResource>(TestResource{ *decoded });
+    }
+};
+
+bool operator<(const AsyncInfo& a, const AsyncInfo& b) { return a.name < b.name; }
+
+struct SizedResource
+{
+    std::size_t size;
+    std::size_t getMemoryUsage() const { return size; }
+};
+
+struct SizedInfo
+{
+    using ResourceType = SizedResource;
+    using ResourceKey = std::string;
+
+    std::string name;
+    std::string alias;
+
+    std::string resolve(const fs::path&) const { return alias.empty() ? name : alias; }
+    std::unique_ptr<SizedResource> load(const std::string&) const
+    {
+        return std::make_unique<SizedResource>(SizedResource{ 100 });
+    }
+};
+
+bool operator<(const SizedInfo& a, const SizedInfo& b) { return a.name < b.name; }
+
+// Takes one upload call per part
+struct UploadedResource
+{
+    int parts;
+    int uploaded{ 0 };
+
+    bool upload(std::chrono::steady_clock::time_point)
+    {
+        ++uploaded;
+        return uploaded >= parts;
+    }
+};
+
+struct UploadedInfo
+{
+    using ResourceType = UploadedResource;
+    using ResourceKey = std::string;
+    using DecodedType = int;
+
+    std::string name;
+
+    std::string resolve(const fs::path&) const { return name; }
+    std::unique_ptr<UploadedResource> load(const std::string&) const
+    {
+        return std::make_unique<UploadedResource>(UploadedResource{ 1 });
+    }
+    std::unique_ptr<int> decode(const std::string&) const { return std::make_unique<int>(3); }
+    std::unique_ptr<UploadedResource> create(const std::string&, std::unique_ptr<int> decoded) const
+    {
+        return std::make_unique<UploadedResource>(UploadedResource{ *decoded });
+    }
+};
+
+bool operator<(const UploadedInfo& a, const UploadedInfo& b) { return a.name < b.name; }
+
+template<class T>
+void
+WaitForLoad(ResourceManager<T>& manager, ResourceHandle h)
+{
+    for (int i = 0; i < 1000 && manager.getState(h) == ResourceState::Pending; ++i)
+    {
+        manager.update(std::chrono::milliseconds(10));
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+} // end unnamed namespace
+
+TEST_SUITE_BEGIN("ResourceManager");
+
+TEST_CASE("Resources without a decoded type load synchronously")
+{
+    static_assert(!ResourceManager<SyncInfo>::SupportsAsyncLoading);
+
+    ResourceManager<SyncInfo> manager("");
+    manager.setAsyncLoading(true);
+    REQUIRE(!manager.getAsyncLoading());
+
+    ResourceHandle h = manager.getHandle(SyncInfo{ "a" });
+    REQUIRE(manager.findLoaded(h) == nullptr);
+    TestResource* resource = manager.find(h);
+    REQUIRE(resource != nullptr);
+    REQUIRE(resource->name == "a");
+    REQUIRE(manager.findLoaded(h) == resource);
+}
+
+TEST_CASE("Asynchronous loading is pending until update")
+{
+    static_assert(ResourceManager<AsyncInfo>::SupportsAsyncLoading);
+
+    ResourceManager<AsyncInfo> manager("");
+    manager.setAsyncLoading(true);
+
+    ResourceHandle h = manager.getHandle(AsyncInfo{ "a", {} });
+    REQUIRE(manager.getState(h) == ResourceState::NotLoaded);
+    REQUIRE(manager.find(h) == nullptr);
+    REQUIRE(manager.getState(h) == ResourceState::Pending);
+
+    WaitForLoad(manager, h);
+    REQUIRE(manager.getState(h) == ResourceState::Loaded);
+    TestResource* resource = manager.find(h);
+    REQUIRE(resource != nullptr);
+    REQUIRE(resource->name == "a decoded");
+}
+
+TEST_CASE("Asynchronous loading failures")
+{
+    ResourceManager<AsyncInfo> manager("");
+    manager.setAsyncLoading(true);
+
+    ResourceHandle h = manager.getHandle(AsyncInfo{ "", {} });
+    REQUIRE(manager.find(h) == nullptr);
+    WaitForLoad(manager, h);
+    REQUIRE(manager.getState(h) == ResourceState::LoadingFailed);
+    REQUIRE(manager.find(h) == nullptr);
+    REQUIRE(manager.getState(InvalidResource) == ResourceState::LoadingFailed);
+}
+
+TEST_CASE("Handles resolving to the same key share the resource")
+{
+    ResourceManager<AsyncInfo> manager("");
+    ResourceHandle h1 = manager.getHandle(AsyncInfo{ "a", "shared" });
+    ResourceHandle h2 = manager.getHandle(AsyncInfo{ "b", "shared" });
+
+    TestResource* resource = manager.find(h1);
+    REQUIRE(resource != nullptr);
+
+    manager.setAsyncLoading(true);
+    REQUIRE(manager.find(h2) == resource);
+    REQUIRE(manager.getState(h2) == ResourceState::Loaded);
+}
+
+TEST_CASE("Resources are pending until their upload completes")
+{
+    static_assert(!ResourceManager<AsyncInfo>::SupportsIncrementalUpload);
+    static_assert(ResourceManager<UploadedInfo>::SupportsIncrementalUpload);
+
+    ResourceManager<UploadedInfo> manager("");
+    manager.setAsyncLoading(true);
+    ResourceHandle h = manager.getHandle(UploadedInfo{ "a" });
+    REQUIRE(manager.find(h) == nullptr);
+
+    // A zero budget uploads one part per update
+    int updates = 0;
+    for (; updates < 1000 && manager.getState(h) == ResourceState::Pending; ++updates)
+    {
+        manager.update(std::chrono::milliseconds(0));
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    REQUIRE(updates >= 3);
+
+    UploadedResource* resource = manager.find(h);
+    REQUIRE(resource != nullptr);
+    REQUIRE(resource->uploaded == 3);
+}
+
+TEST_CASE("Loads are reported on first use")
+{
+    ResourceManager<AsyncInfo> manager("");
+    std::vector<std::pair<std::string, celestia::util::ResourceLoadRecord>> reports;
+    manager.setLoadObserver([&reports](const std::string& key, const celestia::util::ResourceLoadRecord& record)
+    {
+        reports.emplace_back(key, record);
+    });
+    manager.setAsyncLoading(true);
+
+    manager.update(std::chrono::milliseconds(1));
+    ResourceHandle h = manager.getHandle(AsyncInfo{ "a", {} });
+    ResourceHandle failed = manager.getHandle(AsyncInfo{ "", {} });
+    REQUIRE(manager.find(h) == nullptr);
+    REQUIRE(manager.find(failed) == nullptr);
+    WaitForLoad(manager, h);
+    WaitForLoad(manager, failed);
+
+    // Only the failure is reported before the resource is used
+    REQUIRE(reports.size() == 1);
+    REQUIRE(reports[0].second.failed);
+
+    manager.update(std::chrono::milliseconds(1));
+    REQUIRE(manager.find(h) != nullptr);
+    REQUIRE(manager.find(h) != nullptr);
+    REQUIRE(reports.size() == 2);
+    const auto& [key, record] = reports[1];
+    REQUIRE(key == "a");
+    REQUIRE(!record.failed);
+    REQUIRE(record.requestFrame == 1);
+    REQUIRE(record.readyFrame > record.requestFrame);
+    REQUIRE(record.firstUseFrame > record.readyFrame);
+}
+
+TEST_CASE("Least recently used resources are evicted over the budget")
+{
+    static_assert(!ResourceManager<SyncInfo>::SupportsEviction);
+    static_assert(ResourceManager<SizedInfo>::SupportsEviction);
+
+    ResourceManager<SizedInfo> manager("");
+    manager.setMemoryBudget(250);
+
+    ResourceHandle h1 = manager.getHandle(SizedInfo{ "a", {} });
+    ResourceHandle h2 = manager.getHandle(SizedInfo{ "b", {} });
+    ResourceHandle h3 = manager.getHandle(SizedInfo{ "c", {} });
+
+    REQUIRE(manager.find(h1) != nullptr);
+    manager.update(std::chrono::milliseconds(1));
+    REQUIRE(manager.find(h2) != nullptr);
+    manager.update(std::chrono::milliseconds(1));
+    REQUIRE(manager.find(h3) != nullptr);
+    manager.update(std::chrono::milliseconds(1));
+
+    // h1 was used two frames ago, h2 and h3 are recent enough to be kept
+    REQUIRE(manager.getState(h1) == ResourceState::NotLoaded);
+    REQUIRE(manager.getState(h2) == ResourceState::Loaded);
+    REQUIRE(manager.getState(h3) == ResourceState::Loaded);
+    REQUIRE(manager.getMemoryUsage() == 200);
+
+    // Evicted resources are loaded again on the next find
+    REQUIRE(manager.find(h1) != nullptr);
+    REQUIRE(manager.getState(h1) == ResourceState::Loaded);
+}
+
+TEST_CASE("Resources are kept without a budget or when recently used")
+{
+    ResourceManager<SizedInfo> manager("");
+    ResourceHandle h1 = manager.getHandle(SizedInfo{ "a", {} });
+    ResourceHandle h2 = manager.getHandle(SizedInfo{ "b", {} });
+    REQUIRE(manager.find(h1) != nullptr);
+    REQUIRE(manager.find(h2) != nullptr);
+    for (int i = 0; i < 3; ++i)
+        manager.update(std::chrono::milliseconds(1));
+    REQUIRE(manager.getMemoryUsage() == 200);
+    REQUIRE(manager.getState(h1) == ResourceState::Loaded);
+
+    manager.setMemoryBudget(50);
+    manager.update(std::chrono::milliseconds(1));
+    REQUIRE(manager.find(h1) != nullptr);
+    REQUIRE(manager.find(h2) != nullptr);
+    manager.update(std::chrono::milliseconds(1));
+    REQUIRE(manager.getState(h1) == ResourceState::Loaded);
+    REQUIRE(manager.getState(h2) == ResourceState::Loaded);
+}
+
+TEST_CASE("Shared resources are counted and evicted once")
+{
+    ResourceManager<SizedInfo> manager("");
+    ResourceHandle h1 = manager.getHandle(SizedInfo{ "a", "shared" });
+    ResourceHandle h2 = manager.getHandle(SizedInfo{ "b", "shared" });
+    REQUIRE(manager.find(h1) != nullptr);
+    REQUIRE(manager.find(h2) == manager.find(h1));
+    manager.update(std::chrono::milliseconds(1));
+    REQUIRE(manager.getMemoryUsage() == 100);
+
+    // Using either handle keeps the resource
+    manager.setMemoryBudget(50);
+    for (int i = 0; i < 3; ++i)
+    {
+        REQUIRE(manager.findLoaded(h2) != nullptr);
+        manager.update(std::chrono::milliseconds(1));
+    }
+    REQUIRE(manager.getState(h1) == ResourceState::Loaded);
+
+    for (int i = 0; i < 3; ++i)
+        manager.update(std::chrono::milliseconds(1));
+    REQUIRE(manager.getState(h1) == ResourceState::NotLoaded);
+    REQUIRE(manager.getState(h2) == ResourceState::NotLoaded);
+    REQUIRE(manager.getMemoryUsage() == 0);
+}
+
+TEST_SUITE_END();
@@ -0,0 +1,70 @@
+#include <celengine/resolutionscaler.h>
+
+#include <doctest.h>
+
+using namespace celestia::engine;
+
+namespace
+{
+
+// Feed frames whose GPU time is proportional to the pixels drawn at the
+// scale, taking fullTime at full resolution
+void
+run(ResolutionScaler& scaler, int frames, double fullTime)
+{
+    for (int i = 0; i < frames; ++i)
+    {
+        FrameCounters counters;
+        double scale = scaler.getScale();
+        counters.gpuTime = fullTime * scale * scale;
+        scaler.update(counters);
+    }
+}
+
+} // end unnamed namespace
+
+TEST_SUITE_BEGIN("ResolutionScaler");
+
+TEST_CASE("The scale is kept without a target or GPU times")
+{
+    ResolutionScaler scaler;
+    run(scaler, 100, 50.0);
+    REQUIRE(scaler.getScale() == 1.0f);
+
+    scaler.setTarget(10.0, 0.5f);
+    for (int i = 0; i < 100; ++i)
+        REQUIRE(!scaler.update(FrameCounters()));
+    REQUIRE(scaler.getScale() == 1.0f);
+}
+
+TEST_CASE("The scale holds the GPU time")
+{
+    ResolutionScaler scaler;
+    scaler.setTarget(10.0, 0.25f);
+
+    run(scaler, 200, 20.0);
+    float scale = scaler.getScale();
+    REQUIRE(scale < 1.0f);
+    REQUIRE(scaler.getGPUTime() <= 10.0 * 1.1);
+
+    // Steady once the target is met
+    run(scaler, 500, 20.0);
+    REQUIRE(scaler.getScale() == doctest::Approx(scale));
+
+    // Back to full resolution when the scene gets cheaper
+    run(scaler, 1000, 5.0);
+    REQUIRE(scaler.getScale() == doctest::Approx(1.0f));
+}
+
+TEST_CASE("The scale doesn't go below the minimum")
+{
+    ResolutionScaler scaler;
+    scaler.setTarget(10.0, 0.5f);
+    run(scaler, 500, 1000.0);
+    REQUIRE(scaler.getScale() == doctest::Approx(0.5f));
+
+    scaler.reset();
+    REQUIRE(scaler.getScale() == 1.0f);
+}
+
+TEST_SUITE_END();
@@ -0,0 +1,277 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <Eigen/Core>
+
+#include <celastro/date.h>
+#include <celcompat/bit.h>
+#include <celcompat/filesystem.h>
+#include <celephem/orbit.h>
+#include <celephem/sampfile.h>
+#include <celephem/samporbit.h>
+#include <celephem/xyzvbinary.h>
+
+#include <doctest.h>
+
+using namespace celestia;
+using namespace celestia::ephem;
+
+namespace
+{
+
+constexpr double StartTime = 2451545.0;
+constexpr double Interval = 1.0 / 1440.0;
+
+// Linear motion, which the cubic interpolation reproduces exactly; in km
+// and km/s, in the coordinates of the file
+const Eigen::Vector3d Origin(1000.0, -2000.0, 500.0);
+const Eigen::Vector3d Velocity(3.0, 1.5, -2.0);
+
+Eigen::Vector3d
+expectedPosition(double jd)
+{
+    Eigen::Vector3d p = Origin + Velocity * astro::daysToSecs(jd - StartTime);
+    return Eigen::Vector3d(p.x(), p.z(), -p.y());
+}
+
+// Times of the samples, at a regular cadence unless jittered
+std::vector<double>
+sampleTimes(std::uint32_t count, bool jittered)
+{
+    std::vector<double> times;
+    for (std::uint32_t i = 0; i < count; ++i)
+    {
+        double jitter = jittered ? Interval * 0.4 * static_cast<double>((i * 7) % 3) : 0.0;
+        times.push_back(StartTime + Interval * static_cast<double>(i) + jitter);
+    }
+    return times;
+}
+
+void
+writeXYZVBinary(const fs::path& path, const std::vector<double>& times)
+{
+    std::vector<char> data(sizeof(XYZVBinaryHeader) + times.size() * sizeof(XYZVBinaryData));
+
+    auto byteOrder = static_cast<decltype(XYZVBinaryHeader::byteOrder)>(compat::endian::native);
+    auto digits = static_cast<decltype(XYZVBinaryHeader::digits)>(std::numeric_limits<double>::digits);
+    auto count = static_cast<decltype(XYZVBinaryHeader::count)>(times.size());
+    std::memcpy(data.data() + offsetof(XYZVBinaryHeader, magic), XYZV_MAGIC.data(), XYZV_MAGIC.size());
+    std::memcpy(data.data() + offsetof(XYZVBinaryHeader, byteOrder), &byteOrder, sizeof(byteOrder));
+    std::memcpy(data.data() + offsetof(XYZVBinaryHeader, digits), &digits, sizeof(digits));
+    std::memcpy(data.data() + offsetof(XYZVBinaryHeader, count), &count, sizeof(count));
+
+    for (std::size_t i = 0; i < times.size(); ++i)
+    {
+        char* record = data.data() + sizeof(XYZVBinaryHeader) + i * sizeof(XYZVBinaryData);
+        Eigen::Vector3d position = Origin + Velocity * astro::daysToSecs(times[i] - StartTime);
+        std::memcpy(record + offsetof(XYZVBinaryData, tdb), &times[i], sizeof(double));
+        std::memcpy(record + offsetof(XYZVBinaryData, position), position.data(), sizeof(double) * 3);
+        std::memcpy(record + offsetof(XYZVBinaryData, velocity), Velocity.data(), sizeof(double) * 3);
+    }
+
+    std::ofstream out(path, std::ios::out | std::ios::binary);
+    out.write(data.data(), data.size());
+}
+
+// Write the records as xyzv2bin --chunked does, in chunks of chunkSize
+void
+writeXYZVChunked(const fs::path& path, const std::vector<double>& times, std::uint32_t chunkSize)
+{
+    std::string chunks;
+    std::vector<char> index;
+    double boundingRadius = 0.0;
+    for (std::size_t first = 0; first < times.size(); first += chunkSize)
+    {
+        std::vector<XYZVRecord> records;
+        for (std::size_t i = first; i < std::min(times.size(), first + chunkSize); ++i)
+        {
+            Eigen::Vector3d position = Origin + Velocity * astro::daysToSecs(times[i] - StartTime);
+            boundingRadius = std::max(boundingRadius, position.norm());
+            records.push_back({ times[i], position.x(), position.y(), position.z(),
+                                Velocity.x(), Velocity.y(), Velocity.z() });
+        }
+
+        std::uint64_t offset = sizeof(XYZVChunkedHeader) + chunks.size();
+        index.resize(index.size() + sizeof(XYZVChunkIndexEntry));
+        char* entry = index.data() + index.size() - sizeof(XYZVChunkIndexEntry);
+        std::memcpy(entry + offsetof(XYZVChunkIndexEntry, tdb), &times[first], sizeof(double));
+        std::memcpy(entry + offsetof(XYZVChunkIndexEntry, offset), &offset, sizeof(offset));
+        EncodeXYZVChunk(records.data(), records.size(), chunks);
+    }
+
+    std::vector<char> header(sizeof(XYZVChunkedHeader));
+    auto byteOrder = static_cast<decltype(XYZVChunkedHeader::byteOrder)>(compat::endian::native);
+    auto digits = static_cast<decltype(XYZVChunkedHeader::digits)>(std::numeric_limits<double>::digits);
+    auto count = static_cast<decltype(XYZVChunkedHeader::count)>(times.size());
+    auto indexOffset = static_cast<decltype(XYZVChunkedHeader::indexOffset)>(sizeof(XYZVChunkedHeader) + chunks.size());
+    std::memcpy(header.data() + offsetof(XYZVChunkedHeader, magic), XYZV_CHUNKED_MAGIC.data(), XYZV_CHUNKED_MAGIC.size());
+    std::memcpy(header.data() + offsetof(XYZVChunkedHeader, byteOrder), &byteOrder, sizeof(byteOrder));
+    std::memcpy(header.data() + offsetof(XYZVChunkedHeader, digits), &digits, sizeof(digits));
+    std::memcpy(header.data() + offsetof(XYZVChunkedHeader, chunkSize), &chunkSize, sizeof(chunkSize));
+    std::memcpy(header.data() + offsetof(XYZVChunkedHeader, count), &count, sizeof(count));
+    std::memcpy(header.data() + offsetof(XYZVChunkedHeader, indexOffset), &indexOffset, sizeof(indexOffset));
+    std::memcpy(header.data() + offsetof(XYZVChunkedHeader, boundingRadius), &boundingRadius, sizeof(boundingRadius));
+
+    std::ofstream out(path, std::ios::out | std::ios::binary);
+    out.write(header.data(), header.size());
+    out.write(chunks.data(), chunks.size());
+    out.write(index.data(), index.size());
+}
+
+void
+checkTrajectory(const fs::path& path, const std::vector<double>& times)
+{
+    for (auto interpolation : { TrajectoryInterpolation::Linear, TrajectoryInterpolation::Cubic })
+    {
+        auto orbit = LoadSampledTrajectory(path, interpolation, TrajectoryPrecision::Double);
+        REQUIRE(orbit != nullptr);
+
+        double begin = 0.0;
+        double end = 0.0;
+        orbit->getValidRange(begin, end);
+        REQUIRE(begin == times.front());
+        REQUIRE(end == times.back());
+
+        // Forwards, backwards and at random
+        std::vector<double> jds;
+        for (std::size_t i = 0; i + 1 < times.size(); i += 3)
+            jds.push_back(times[i] + (times[i + 1] - times[i]) * 0.3);
+        for (std::size_t i = times.size() - 1; i >= 5; i -= 5)
+            jds.push_back(times[i] - (times[i] - times[i - 1]) * 0.6);
+        for (std::size_t i = 0; i < times.size(); i += 2)
+            jds.push_back(times[(i * 37) % times.size()]);
+
+        for (double jd : jds)
+            REQUIRE((orbit->positionAtTime(jd) - expectedPosition(jd)).norm() < 1.0e-6);
+
+        // Times outside the samples are clamped
+        REQUIRE((orbit->positionAtTime(begin - 1.0) - expectedPosition(begin)).norm() < 1.0e-6);
+        REQUIRE((orbit->positionAtTime(end + 1.0) - expectedPosition(end)).norm() < 1.0e-6);
+
+        // Batched evaluation agrees with one time after another
+        auto caching = std::dynamic_pointer_cast<const CachingOrbit>(orbit);
+        REQUIRE(caching != nullptr);
+        std::vector<Eigen::Vector3d> positions(jds.size());
+        caching->computePositions(jds.data(), positions.data(), jds.size());
+        for (std::size_t i = 0; i < jds.size(); ++i)
+            REQUIRE((positions[i] - expectedPosition(jds[i])).norm() < 1.0e-6);
+    }
+}
+
+} // end unnamed namespace
+
+TEST_SUITE_BEGIN("Sampled orbit");
+
+TEST_CASE("Binary xyzv trajectories are interpolated")
+{
+    for (bool jittered : { false, true })
+    {
+        fs::path path = fs::temp_directory_path() / (jittered ? "celestia_irregular.xyzvbin"
+                                                              : "celestia_regular.xyzvbin");
+        auto times = sampleTimes(500, jittered);
+        writeXYZVBinary(path, times);
+
+        checkTrajectory(path, times);
+
+        std::error_code ec;
+        fs::remove(path, ec);
+    }
+}
+
+TEST_CASE("Chunked xyzv records decode losslessly")
+{
+    std::vector<XYZVRecord> records;
+    for (int i = 0; i < 300; ++i)
+    {
+        double t = StartTime + Interval * static_cast<double>(i);
+        double angle = static_cast<double>(i) * 0.01;
+        // Include sign changes, zeros and values of any size
+        records.push_back({ t, 7000.0 * std::cos(angle), 7000.0 * std::sin(angle), i % 50 == 0 ? 0.0 : -1.0e-300 * i,
+                            -7.5 * std::sin(angle), 7.5 * std::cos(angle), i % 7 == 0 ? 1.0e300 : -0.0 });
+    }
+
+    std::string encoded;
+    EncodeXYZVChunk(records.data(), records.size(), encoded);
+    REQUIRE(encoded.size() < records.size() * sizeof(XYZVRecord));
+
+    std::vector<XYZVRecord> decoded(records.size());
+    REQUIRE(DecodeXYZVChunk(encoded.data(), encoded.size(), decoded.size(), decoded.data()));
+    REQUIRE(std::memcmp(decoded.data(), records.data(), records.size() * sizeof(XYZVRecord)) == 0);
+
+    // Truncated data is rejected
+    REQUIRE(!DecodeXYZVChunk(encoded.data(), encoded.size() - 1, decoded.size(), decoded.data()));
+}
+
+TEST_CASE("Chunked xyzv trajectories are interpolated")
+{
+    for (bool jittered : { false, true })
+    {
+        fs::path path = fs::temp_directory_path() / (jittered ? "celestia_irregular_chunked.xyzvbin"
+                                                              : "celestia_regular_chunked.xyzvbin");
+        auto times = sampleTimes(500, jittered);
+        writeXYZVChunked(path, times, 64);
+
+        checkTrajectory(path, times);
+
+        std::error_code ec;
+        fs::remove(path, ec);
+    }
+}
+
+TEST_CASE("Indexed sample searches agree with a binary search")
+{
+    // Irregular gaps, including a long one and repeated times
+    std::vector<double> times;
+    double t = StartTime;
+    for (std::uint32_t i = 0; i < 1000; ++i)
+    {
+        times.push_back(t);
+        if (i == 600)
+            t += 50.0;
+        else if (i % 17 != 0)
+            t += Interval * static_cast<double>(1 + (i * 13) % 7);
+    }
+
+    SampleTimeIndex timeIndex(times);
+    std::uint32_t lastSample = 0;
+    for (std::uint32_t i = 0; i < 5000; ++i)
+    {
+        double jd = times.front() - 1.0 + (times.back() - times.front() + 2.0) * static_cast<double>((i * 7919) % 5000) / 5000.0;
+        if (i % 5 == 0)
+            jd = times[(i * 31) % times.size()];
+
+        auto expected = static_cast<std::uint32_t>(std::lower_bound(times.begin(), times.end(), jd) - times.begin());
+        std::uint32_t n = GetSampleIndex(jd, lastSample, times, timeIndex);
+        REQUIRE((n == expected || (n < times.size() && n > 0 && times[n - 1] <= jd && jd <= times[n])));
+    }
+
+    SampleTimeIndex single(std::vector<double>(1, StartTime));
+    std::vector<double> one(1, StartTime);
+    lastSample = 0;
+    REQUIRE(GetSampleIndex(StartTime - 1.0, lastSample, one, single) == 0);
+    REQUIRE(GetSampleIndex(StartTime + 1.0, lastSample, one, single) == 1);
+}
+
+TEST_CASE("Out-of-order samples are skipped")
+{
+    fs::path path = fs::temp_directory_path() / "celestia_unordered.xyzvbin";
+    auto times = sampleTimes(100, false);
+    auto unordered = times;
+    unordered.insert(unordered.begin() + 50, times[20]);
+    writeXYZVBinary(path, unordered);
+
+    checkTrajectory(path, times);
+
+    std::error_code ec;
+    fs::remove(path, ec);
+}
+
+TEST_SUITE_END();
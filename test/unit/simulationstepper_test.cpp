@@ -0,0 +1,34 @@
+#include <celestia/simulationstepper.h>
+
+#include <doctest.h>
+
+using celestia::SimulationStepper;
+
+TEST_SUITE_BEGIN("SimulationStepper");
+
+TEST_CASE("Steps are run for the elapsed time")
+{
+    SimulationStepper stepper(4.0);
+    REQUIRE(stepper.getStep() == 0.25);
+
+    REQUIRE(stepper.advance(0.125) == 0);
+    REQUIRE(stepper.getFraction() == 0.5);
+
+    REQUIRE(stepper.advance(0.25) == 1);
+    REQUIRE(stepper.getFraction() == 0.5);
+
+    REQUIRE(stepper.advance(0.625) == 3);
+    REQUIRE(stepper.getFraction() == 0.0);
+}
+
+TEST_CASE("Time beyond the maximum steps is dropped")
+{
+    SimulationStepper stepper(10.0);
+    REQUIRE(stepper.advance(10.0) == SimulationStepper::MaxStepsPerTick);
+    REQUIRE(stepper.getFraction() == 0.0);
+
+    REQUIRE(stepper.advance(-1.0) == 0);
+    REQUIRE(stepper.getFraction() == 0.0);
+}
+
+TEST_SUITE_END();
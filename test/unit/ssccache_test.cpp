@@ -0,0 +1,162 @@
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#include <celcompat/filesystem.h>
+#include <celengine/ssccache.h>
+#include <celutil/associativearray.h>
+
+#include <doctest.h>
+
+using celestia::engine::SolarSystemCatalogCache;
+using celestia::engine::SolarSystemDefinition;
+using celestia::util::AssociativeArray;
+using celestia::util::Value;
+using celestia::util::ValueArray;
+using celestia::util::ValueType;
+
+namespace
+{
+
+SolarSystemDefinition
+makeDefinition()
+{
+    auto orbit = std::make_unique<AssociativeArray>();
+    orbit->addValue("Period", Value(365.25));
+    orbit->addValue("Eccentricity", Value(0.0167));
+
+    auto color = std::make_unique<ValueArray>();
+    color->emplace_back(0.5);
+    color->emplace_back(0.25);
+    color->emplace_back(1.0);
+
+    Value radius(6378.14);
+    radius.setUnits({ celestia::astro::LengthUnit::Kilometer });
+
+    auto properties = std::make_unique<AssociativeArray>();
+    properties->addValue("Radius", std::move(radius));
+    properties->addValue("Texture", Value("earth.*"));
+    properties->addValue("Clickable", Value(true));
+    properties->addValue("Color", Value(std::move(color)));
+    properties->addValue("EllipticalOrbit", Value(std::move(orbit)));
+
+    SolarSystemDefinition definition;
+    definition.disposition = DataDisposition::Modify;
+    definition.itemType = "Body";
+    definition.nameList = "Earth:Terra";
+    definition.parentName = "Sol";
+    definition.lineNumber = 42;
+    definition.properties = Value(std::move(properties));
+    return definition;
+}
+
+} // end unnamed namespace
+
+TEST_SUITE_BEGIN("SolarSystemCatalogCache");
+
+TEST_CASE("SolarSystemCatalogCache")
+{
+    const fs::path directory = fs::temp_directory_path() / "celestia_ssccache_test";
+    std::error_code ec;
+    fs::remove_all(directory, ec);
+
+    const std::uint64_t key = SolarSystemCatalogCache::computeKey("\"Earth\" \"Sol\" { }");
+    REQUIRE(key != SolarSystemCatalogCache::computeKey("\"Earth\" \"Sol\" {}"));
+
+    {
+        SolarSystemCatalogCache cache(directory);
+        REQUIRE(cache.open(key) == nullptr);
+
+        auto writer = cache.create(key);
+        REQUIRE(writer != nullptr);
+        writer->write(makeDefinition());
+        writer->write(makeDefinition());
+        REQUIRE(writer->commit());
+    }
+
+    SUBCASE("Definitions are read back")
+    {
+        SolarSystemCatalogCache cache(directory);
+        auto reader = cache.open(key);
+        REQUIRE(reader != nullptr);
+
+        for (int i = 0; i < 2; ++i)
+        {
+            SolarSystemDefinition definition;
+            REQUIRE(reader->read(definition));
+            REQUIRE(definition.disposition == DataDisposition::Modify);
+            REQUIRE(definition.itemType == "Body");
+            REQUIRE(definition.nameList == "Earth:Terra");
+            REQUIRE(definition.parentName == "Sol");
+            REQUIRE(definition.lineNumber == 42);
+
+            const AssociativeArray* properties = definition.properties.getHash();
+            REQUIRE(properties != nullptr);
+            REQUIRE(properties->getNumber<double>("Radius") == 6378.14);
+            REQUIRE(properties->getValue("Radius")->getLengthUnit() == celestia::astro::LengthUnit::Kilometer);
+            REQUIRE(*properties->getString("Texture") == "earth.*");
+            REQUIRE(properties->getBoolean("Clickable") == true);
+            REQUIRE(properties->getVector3<double>("Color") == Eigen::Vector3d(0.5, 0.25, 1.0));
+
+            const Value* orbit = properties->getValue("EllipticalOrbit");
+            REQUIRE(orbit != nullptr);
+            REQUIRE(orbit->getType() == ValueType::HashType);
+            REQUIRE(orbit->getHash()->getNumber<double>("Period") == 365.25);
+            REQUIRE(orbit->getHash()->getNumber<double>("Eccentricity") == 0.0167);
+        }
+
+        SolarSystemDefinition definition;
+        REQUIRE(!reader->read(definition));
+    }
+
+    SUBCASE("Definitions are read back by offset")
+    {
+        SolarSystemCatalogCache cache(directory);
+        auto reader = cache.open(key);
+        REQUIRE(reader != nullptr);
+
+        SolarSystemDefinition definition;
+        REQUIRE(reader->skip(definition));
+        std::size_t offset = reader->tell();
+        REQUIRE(reader->skip(definition));
+        REQUIRE(definition.parentName == "Sol");
+        REQUIRE(definition.properties.isNull());
+        REQUIRE(!reader->skip(definition));
+
+        REQUIRE(reader->readAt(offset, definition));
+        REQUIRE(definition.nameList == "Earth:Terra");
+        REQUIRE(definition.properties.getHash() != nullptr);
+        REQUIRE(definition.properties.getHash()->getNumber<double>("Radius") == 6378.14);
+    }
+
+    SUBCASE("Damaged files are rejected")
+    {
+        fs::path path;
+        for (const auto& entry : fs::directory_iterator(directory))
+            path = entry.path();
+
+        {
+            std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+            file.seekp(-1, std::ios::end);
+            file.put('\x7f');
+        }
+
+        SolarSystemCatalogCache cache(directory);
+        REQUIRE(cache.open(key) == nullptr);
+    }
+
+    SUBCASE("Unused files are removed")
+    {
+        SolarSystemCatalogCache cache(directory);
+        cache.removeUnused();
+        REQUIRE(fs::is_empty(directory));
+    }
+
+    fs::remove_all(directory, ec);
+}
+
+TEST_SUITE_END();
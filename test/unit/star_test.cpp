@@ -0,0 +1,58 @@
+#include <boost/smart_ptr/intrusive_ptr.hpp>
+
+#include <celengine/star.h>
+#include <celengine/stellarclass.h>
+
+#include <doctest.h>
+
+namespace
+{
+
+boost::intrusive_ptr<StarDetails>
+makeCustomDetails(float radius, float temperature)
+{
+    auto details = StarDetails::GetStarDetails(StellarClass::parse("G2V"));
+    StarDetails::setRadius(details, radius);
+    StarDetails::setTemperature(details, temperature);
+    return details;
+}
+
+} // end unnamed namespace
+
+TEST_SUITE_BEGIN("Star");
+
+TEST_CASE("StarDetailsPool")
+{
+    StarDetailsPool pool;
+
+    auto standard = StarDetails::GetStarDetails(StellarClass::parse("G2V"));
+    auto standardCopy = standard;
+    pool.intern(standardCopy);
+    REQUIRE(standardCopy == standard);
+    REQUIRE(pool.size() == 0);
+
+    auto details1 = makeCustomDetails(1.5f, 5800.0f);
+    auto details2 = makeCustomDetails(1.5f, 5800.0f);
+    auto details3 = makeCustomDetails(2.0f, 5800.0f);
+    REQUIRE(!details1->shared());
+    REQUIRE(details1 != details2);
+
+    pool.intern(details1);
+    pool.intern(details2);
+    pool.intern(details3);
+    REQUIRE(pool.size() == 2);
+    REQUIRE(details1 == details2);
+    REQUIRE(details1 != details3);
+    REQUIRE(details1->shared());
+
+    SUBCASE("Modified details are copied")
+    {
+        StarDetails::setRadius(details2, 3.0f);
+        REQUIRE(details1 != details2);
+        REQUIRE(details1->getRadius() == 1.5f);
+        REQUIRE(details2->getRadius() == 3.0f);
+        REQUIRE(details2->getTemperature() == 5800.0f);
+    }
+}
+
+TEST_SUITE_END();
@@ -0,0 +1,105 @@
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <celcompat/filesystem.h>
+#include <celengine/starname.h>
+
+#include <doctest.h>
+
+namespace
+{
+
+std::vector<std::pair<AstroCatalog::IndexNumber, AstroCatalog::IndexNumber>>
+makeEntries()
+{
+    return { { 48915, 32349 }, { 172167, 91262 }, { 1, 424 }, { 8890, 11767 } };
+}
+
+void
+checkCrossIndex(const StarNameDatabase& db)
+{
+    REQUIRE(db.searchCrossIndexForCatalogNumber(StarCatalog::HenryDraper, 48915) == 32349);
+    REQUIRE(db.searchCrossIndexForCatalogNumber(StarCatalog::HenryDraper, 1) == 424);
+    REQUIRE(db.searchCrossIndexForCatalogNumber(StarCatalog::HenryDraper, 172167) == 91262);
+    REQUIRE(db.searchCrossIndexForCatalogNumber(StarCatalog::HenryDraper, 2) == AstroCatalog::InvalidIndex);
+    REQUIRE(db.crossIndex(StarCatalog::HenryDraper, 11767) == 8890);
+    REQUIRE(db.crossIndex(StarCatalog::HenryDraper, 424) == 1);
+    REQUIRE(db.crossIndex(StarCatalog::HenryDraper, 425) == AstroCatalog::InvalidIndex);
+    REQUIRE(db.crossIndex(StarCatalog::SAO, 424) == AstroCatalog::InvalidIndex);
+}
+
+} // end unnamed namespace
+
+TEST_SUITE_BEGIN("StarNameDatabase");
+
+TEST_CASE("Sorted cross index")
+{
+    std::ostringstream out;
+    REQUIRE(StarNameDatabase::writeCrossIndex(out, makeEntries()));
+    std::string data = out.str();
+
+    SUBCASE("Read from a stream")
+    {
+        StarNameDatabase db;
+        std::istringstream in(data);
+        REQUIRE(db.loadCrossIndex(StarCatalog::HenryDraper, in));
+        checkCrossIndex(db);
+    }
+
+    SUBCASE("Mapped from a file")
+    {
+        fs::path path = fs::temp_directory_path() / "celestia_starname_test.dat";
+        {
+            std::ofstream file(path, std::ios::binary);
+            file.write(data.data(), static_cast<std::streamsize>(data.size()));
+        }
+
+        StarNameDatabase db;
+        REQUIRE(db.loadCrossIndex(StarCatalog::HenryDraper, path));
+        checkCrossIndex(db);
+
+        {
+            std::ofstream file(path, std::ios::binary);
+            file.write(data.data(), static_cast<std::streamsize>(data.size() - 4));
+        }
+        REQUIRE(!db.loadCrossIndex(StarCatalog::SAO, path));
+
+        std::error_code ec;
+        fs::remove(path, ec);
+    }
+
+    SUBCASE("Truncated streams are rejected")
+    {
+        StarNameDatabase db;
+        // Streams only read the records sorted by catalog number, so cut
+        // these short
+        std::istringstream in(data.substr(0, data.size() / 2));
+        REQUIRE(!db.loadCrossIndex(StarCatalog::HenryDraper, in));
+    }
+}
+
+TEST_CASE("Presorted cross index")
+{
+    auto byCatalogNumber = makeEntries();
+    std::sort(byCatalogNumber.begin(), byCatalogNumber.end());
+    auto byCelCatalogNumber = byCatalogNumber;
+    std::sort(byCelCatalogNumber.begin(), byCelCatalogNumber.end(),
+              [](const auto& lhs, const auto& rhs) { return lhs.second < rhs.second; });
+
+    std::ostringstream sorted;
+    REQUIRE(StarNameDatabase::writeCrossIndex(sorted, makeEntries()));
+    std::ostringstream presorted;
+    REQUIRE(StarNameDatabase::writeCrossIndex(presorted, byCatalogNumber, byCelCatalogNumber));
+    REQUIRE(presorted.str() == sorted.str());
+
+    byCelCatalogNumber.pop_back();
+    std::ostringstream mismatched;
+    REQUIRE(!StarNameDatabase::writeCrossIndex(mismatched, byCatalogNumber, byCelCatalogNumber));
+}
+
+TEST_SUITE_END();
@@ -0,0 +1,84 @@
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <system_error>
+
+#include <celcompat/filesystem.h>
+#include <celestia/startupprofile.h>
+
+#include <doctest.h>
+
+using celestia::StartupProfile;
+
+namespace
+{
+
+std::string
+readFile(const fs::path& path)
+{
+    std::ifstream in(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+} // end unnamed namespace
+
+TEST_SUITE_BEGIN("StartupProfile");
+
+TEST_CASE("StartupProfile")
+{
+    StartupProfile profile;
+    {
+        StartupProfile::Scope phase(&profile, "Star catalogs");
+        {
+            StartupProfile::Scope catalog(&profile, "extras\\my \"addon\".stc", "catalog");
+            catalog.addBytesRead(100);
+            catalog.addBytesRead(28);
+            catalog.addObjects(3);
+        }
+    }
+    {
+        StartupProfile::Scope phase(&profile, "Asterisms");
+    }
+    {
+        StartupProfile::Scope ignored(nullptr, "Nothing");
+        ignored.addObjects(1);
+    }
+
+    const auto& records = profile.records();
+    REQUIRE(records.size() == 3);
+    REQUIRE(records[0].name == "Star catalogs");
+    REQUIRE(records[0].category == "phase");
+    REQUIRE(records[0].depth == 0);
+    REQUIRE(records[1].category == "catalog");
+    REQUIRE(records[1].depth == 1);
+    REQUIRE(records[1].bytesRead == 128);
+    REQUIRE(records[1].objectCount == 3);
+    REQUIRE(records[1].start >= records[0].start);
+    REQUIRE(records[1].wallTime <= records[0].wallTime);
+    REQUIRE(records[2].depth == 0);
+    REQUIRE(records[2].start >= records[0].start + records[0].wallTime);
+
+    const fs::path path = fs::temp_directory_path() / "celestia_startupprofile_test.json";
+
+    SUBCASE("Report")
+    {
+        REQUIRE(profile.writeReport(path));
+        std::string report = readFile(path);
+        REQUIRE(report.find("\"name\": \"extras\\\\my \\\"addon\\\".stc\"") != std::string::npos);
+        REQUIRE(report.find("\"bytesRead\": 128, \"objects\": 3}") != std::string::npos);
+        REQUIRE(report.find("\"Asterisms\"") != std::string::npos);
+    }
+
+    SUBCASE("Trace")
+    {
+        REQUIRE(profile.writeTrace(path));
+        std::string trace = readFile(path);
+        REQUIRE(trace.find("\"traceEvents\": [") != std::string::npos);
+        REQUIRE(trace.find("\"cat\": \"catalog\", \"ph\": \"X\"") != std::string::npos);
+    }
+
+    std::error_code ec;
+    fs::remove(path, ec);
+}
+
+TEST_SUITE_END();
@@ -0,0 +1,60 @@
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <celutil/stringinterner.h>
+
+#include <doctest.h>
+
+using celestia::util::InternedString;
+
+TEST_SUITE_BEGIN("InternedString");
+
+TEST_CASE("Equal strings share their storage")
+{
+    std::string name = "Olympus Mons";
+    InternedString a(name);
+    name += " Caldera";
+    InternedString b("Olympus Mons");
+    InternedString c(name);
+
+    REQUIRE(a == b);
+    REQUIRE(&a.str() == &b.str());
+    REQUIRE(a != c);
+    REQUIRE(a.str() == "Olympus Mons");
+    REQUIRE(c.str() == "Olympus Mons Caldera");
+    REQUIRE(*(c.c_str() + c.str().size()) == '\0');
+}
+
+TEST_CASE("Empty strings")
+{
+    InternedString a;
+    InternedString b("");
+    REQUIRE(a.empty());
+    REQUIRE(a == b);
+}
+
+TEST_CASE("Strings interned from several threads")
+{
+    constexpr int ThreadCount = 4;
+    constexpr int NameCount = 1000;
+
+    std::vector<std::vector<InternedString>> results(ThreadCount);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < ThreadCount; ++t)
+    {
+        threads.emplace_back([&results, t]
+        {
+            for (int i = 0; i < NameCount; ++i)
+                results[t].emplace_back("Minor planet " + std::to_string(i));
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+
+    for (int t = 1; t < ThreadCount; ++t)
+        REQUIRE(results[t] == results[0]);
+    REQUIRE(InternedString::count() >= NameCount);
+}
+
+TEST_SUITE_END();
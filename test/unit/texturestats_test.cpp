@@ -0,0 +1,71 @@
+#include <chrono>
+
+#include <celengine/texturestats.h>
+
+#include <doctest.h>
+
+using namespace celestia::engine;
+using namespace std::chrono_literals;
+
+TEST_SUITE_BEGIN("TextureLoadStats");
+
+TEST_CASE("Histogram buckets double")
+{
+    REQUIRE(TextureLoadStats::GetHistogramBucket(0ms) == 0);
+    REQUIRE(TextureLoadStats::GetHistogramBucket(999us) == 0);
+    REQUIRE(TextureLoadStats::GetHistogramBucket(1ms) == 1);
+    REQUIRE(TextureLoadStats::GetHistogramBucket(3ms) == 2);
+    REQUIRE(TextureLoadStats::GetHistogramBucket(4ms) == 3);
+    REQUIRE(TextureLoadStats::GetHistogramBucket(1h) == TextureLoadStats::HistogramBuckets - 1);
+}
+
+TEST_CASE("Loads are counted and recorded")
+{
+    TextureLoadStats stats;
+
+    TextureLoadRecord loaded;
+    loaded.path = "a.png";
+    loaded.load.decodeTime = 5ms;
+    loaded.load.createTime = 2ms;
+    loaded.load.memory = 1000;
+    stats.add(std::move(loaded));
+
+    TextureLoadRecord failed;
+    failed.path = "b.png";
+    failed.load.failed = true;
+    stats.add(std::move(failed));
+
+    REQUIRE(stats.getLoadCount() == 2);
+    REQUIRE(stats.getFailureCount() == 1);
+    REQUIRE(stats.getLoadedBytes() == 1000);
+    REQUIRE(stats.getMaxUploadTime() == 2ms);
+    REQUIRE(stats.getDecodeHistogram()[3] == 1);
+    REQUIRE(stats.getUploadHistogram()[2] == 1);
+
+    auto records = stats.getRecords();
+    REQUIRE(records.size() == 2);
+    REQUIRE(records[0].path == "a.png");
+    REQUIRE(records[1].load.failed);
+
+    stats.clear();
+    REQUIRE(stats.getLoadCount() == 0);
+    REQUIRE(stats.getRecords().empty());
+}
+
+TEST_CASE("Only the most recent records are kept")
+{
+    TextureLoadStats stats;
+    for (std::size_t i = 0; i < TextureLoadStats::MaxRecords + 10; ++i)
+    {
+        TextureLoadRecord record;
+        record.load.requestFrame = i;
+        stats.add(std::move(record));
+    }
+
+    auto records = stats.getRecords();
+    REQUIRE(records.size() == TextureLoadStats::MaxRecords);
+    REQUIRE(records.front().load.requestFrame == 10);
+    REQUIRE(stats.getLoadCount() == TextureLoadStats::MaxRecords + 10);
+}
+
+TEST_SUITE_END();
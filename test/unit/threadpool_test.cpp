@@ -0,0 +1,44 @@
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <numeric>
+#include <vector>
+
+#include <celutil/threadpool.h>
+
+#include <doctest.h>
+
+using celestia::util::ThreadPool;
+
+TEST_SUITE_BEGIN("ThreadPool");
+
+TEST_CASE("parallelFor visits every index once")
+{
+    for (unsigned int threads : { 1U, 4U })
+    {
+        ThreadPool pool(threads);
+        std::vector<int> counts(1000, 0);
+        pool.parallelFor(counts.size(), [&counts](std::size_t i) { ++counts[i]; });
+        REQUIRE(std::all_of(counts.begin(), counts.end(), [](int c) { return c == 1; }));
+    }
+}
+
+TEST_CASE("Nested parallelFor completes")
+{
+    ThreadPool pool(2);
+    std::atomic<int> total{ 0 };
+    pool.parallelFor(8, [&](std::size_t)
+    {
+        pool.parallelFor(8, [&](std::size_t) { ++total; });
+    });
+    REQUIRE(total == 64);
+}
+
+TEST_CASE("async returns the task result")
+{
+    ThreadPool pool(2);
+    auto future = pool.async([] { return 42; });
+    REQUIRE(future.get() == 42);
+}
+
+TEST_SUITE_END();
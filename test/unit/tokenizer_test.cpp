@@ -3,6 +3,7 @@
 #include <optional>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <tuple>
 
 #include <celutil/tokenizer.h>
@@ -520,4 +521,47 @@ TEST_CASE("Tokenizer skips comments")
     }
 }
 
+TEST_CASE("Tokenizer reads contents in memory")
+{
+    std::string_view contents = "\357\273\277Body \"Earth\" # comment\n"
+                                "{\n"
+                                "    Radius 6378.14\n"
+                                "    Name \"esc\\\"aped\"\n"
+                                "    Count 12\n"
+                                "}";
+    Tokenizer tok(contents);
+
+    REQUIRE(tok.nextToken() == Tokenizer::TokenName);
+    auto name = tok.getNameValue();
+    REQUIRE(name == "Body");
+    // Names and unescaped strings refer to the contents
+    REQUIRE(name->data() == contents.data() + 3);
+
+    REQUIRE(tok.nextToken() == Tokenizer::TokenString);
+    auto str = tok.getStringValue();
+    REQUIRE(str == "Earth");
+    REQUIRE(str->data() == contents.data() + 9);
+
+    REQUIRE(tok.nextToken() == Tokenizer::TokenBeginGroup);
+    REQUIRE(tok.getLineNumber() == 2);
+
+    REQUIRE(tok.nextToken() == Tokenizer::TokenName);
+    REQUIRE(tok.nextToken() == Tokenizer::TokenNumber);
+    REQUIRE(tok.getNumberValue() == 6378.14);
+
+    REQUIRE(tok.nextToken() == Tokenizer::TokenName);
+    REQUIRE(tok.nextToken() == Tokenizer::TokenString);
+    REQUIRE(tok.getStringValue() == "esc\"aped");
+
+    REQUIRE(tok.nextToken() == Tokenizer::TokenName);
+    REQUIRE(tok.nextToken() == Tokenizer::TokenNumber);
+    REQUIRE(tok.getIntegerValue() == 12);
+
+    REQUIRE(tok.nextToken() == Tokenizer::TokenEndGroup);
+    REQUIRE(tok.nextToken() == Tokenizer::TokenEnd);
+
+    Tokenizer empty(std::string_view{});
+    REQUIRE(empty.nextToken() == Tokenizer::TokenEnd);
+}
+
 TEST_SUITE_END();
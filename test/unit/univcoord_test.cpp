@@ -0,0 +1,80 @@
+#include <array>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include <Eigen/Core>
+
+#include <celengine/univcoord.h>
+
+#include <doctest.h>
+
+namespace
+{
+
+// The offset computed with the generic R128 routines
+Eigen::Vector3d
+referenceOffsetUly(const UniversalCoord& a, const UniversalCoord& b)
+{
+    return Eigen::Vector3d(static_cast<double>(a.x - b.x),
+                           static_cast<double>(a.y - b.y),
+                           static_cast<double>(a.z - b.z));
+}
+
+} // end unnamed namespace
+
+TEST_SUITE_BEGIN("UniversalCoord");
+
+TEST_CASE("Offsets match the R128 arithmetic")
+{
+    std::mt19937_64 rng(20250101);
+    // Keep within the simulated volume so that the differences don't wrap
+    std::uniform_int_distribution<std::int64_t> high(-(INT64_C(1) << 61), INT64_C(1) << 61);
+    std::uniform_int_distribution<std::uint64_t> low;
+    std::uniform_int_distribution<std::int64_t> nearby(-4, 4);
+
+    auto randomR128 = [&]() { return R128(low(rng), static_cast<std::uint64_t>(high(rng))); };
+    auto nearR128 = [&](const R128& r) { return R128(low(rng), r.hi + static_cast<std::uint64_t>(nearby(rng))); };
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        UniversalCoord a(randomR128(), randomR128(), randomR128());
+        UniversalCoord far(randomR128(), randomR128(), randomR128());
+        UniversalCoord near(nearR128(a.x), nearR128(a.y), nearR128(a.z));
+        // Same high words, in both orders of the low words
+        UniversalCoord sameHigh(R128(low(rng), a.x.hi), R128(low(rng), a.y.hi), R128(a.z.lo, a.z.hi));
+
+        for (const UniversalCoord* b : std::array{ &far, &near, &sameHigh })
+        {
+            REQUIRE(a.offsetFromUly(*b) == referenceOffsetUly(a, *b));
+            REQUIRE(b->offsetFromUly(a) == referenceOffsetUly(*b, a));
+        }
+    }
+}
+
+TEST_CASE("Small negative offsets keep their precision")
+{
+    UniversalCoord a = UniversalCoord::CreateKm(Eigen::Vector3d(1.0e9, -2.0e9, 3.0e6));
+    UniversalCoord b = a.offsetKm(Eigen::Vector3d(1.0e-3, -2.0e-3, 0.0));
+
+    Eigen::Vector3d offset = a.offsetFromKm(b);
+    REQUIRE(offset.x() == doctest::Approx(-1.0e-3).epsilon(1.0e-6));
+    REQUIRE(offset.y() == doctest::Approx(2.0e-3).epsilon(1.0e-6));
+    REQUIRE(offset.z() == 0.0);
+}
+
+TEST_CASE("Batched offsets match the single offsets")
+{
+    UniversalCoord origin = UniversalCoord::CreateLy(Eigen::Vector3d(8.6, -0.3, 4.2));
+    std::vector<UniversalCoord> coords;
+    for (int i = 0; i < 10; ++i)
+        coords.push_back(origin.offsetKm(Eigen::Vector3d(1.0e8 * i, -3.0e5 * i, 20.0 - i)));
+    coords.push_back(UniversalCoord::CreateLy(Eigen::Vector3d(-500.0, 20.0, 1000.0)));
+
+    std::vector<Eigen::Vector3d> offsets(coords.size());
+    UniversalCoord::OffsetsFromKm(coords, origin, offsets.data());
+    for (std::size_t i = 0; i < coords.size(); ++i)
+        REQUIRE(offsets[i] == coords[i].offsetFromKm(origin));
+}
+
+TEST_SUITE_END();
@@ -0,0 +1,104 @@
+#include <array>
+#include <cmath>
+#include <cstddef>
+
+#include <celephem/vsopseries.h>
+
+#include <doctest.h>
+
+using namespace celestia::ephem;
+
+namespace
+{
+
+// Terms of the Mercury longitude series L0 and L1
+constexpr std::array<VSOPTerm, 5> testL0{
+    VSOPTerm{ 4.40250710144, 0, 0 },
+    VSOPTerm{ 0.40989414977, 1.48302034195, 26087.9031416 },
+    VSOPTerm{ 0.050462942, 4.47785489551, 52175.8062831 },
+    VSOPTerm{ 0.00855346844, 1.16520322459, 78263.7094247 },
+    VSOPTerm{ 0.00165590362, 4.11969163423, 104351.612566 },
+};
+
+constexpr std::array<VSOPTerm, 2> testL1{
+    VSOPTerm{ 26087.9031406, 0, 0 },
+    VSOPTerm{ 0.0113, 6.21874197797, 26087.9031416 },
+};
+
+double
+referenceValue(double t)
+{
+    double l0 = 0.0;
+    for (const VSOPTerm& term : testL0)
+        l0 += term.A * std::cos(term.B + term.C * t);
+    double l1 = 0.0;
+    for (const VSOPTerm& term : testL1)
+        l1 += term.A * std::cos(term.B + term.C * t);
+    return l0 + l1 * t;
+}
+
+VSOPVariable
+makeVariable()
+{
+    VSOPVariable variable;
+    variable.addSeries(testL0.data(), testL0.size());
+    variable.addSeries(testL1.data(), testL1.size());
+    return variable;
+}
+
+} // end unnamed namespace
+
+TEST_SUITE_BEGIN("VSOP87 series");
+
+TEST_CASE("Variables match the sums of the terms")
+{
+    VSOPVariable variable = makeVariable();
+    for (double t : { -6.0, -1.234, -0.5, 0.0, 0.0001, 0.25, 0.4, 3.7 })
+    {
+        double expected = referenceValue(t);
+        REQUIRE(std::abs(variable.evaluate(t) - expected) <= 1.0e-12 * std::abs(expected) + 1.0e-12);
+    }
+}
+
+TEST_CASE("Variables are evaluated at several times")
+{
+    VSOPVariable variable = makeVariable();
+
+    constexpr std::size_t count = 7;
+    std::array<double, count> times;
+    for (std::size_t i = 0; i < count; ++i)
+        times[i] = -0.3 + 0.07 * static_cast<double>(i);
+
+    std::array<double, count> values;
+    variable.evaluate(times.data(), values.data(), count);
+    for (std::size_t i = 0; i < count; ++i)
+        REQUIRE(std::abs(values[i] - variable.evaluate(times[i])) <= 1.0e-12 * std::abs(values[i]));
+}
+
+TEST_CASE("Large arguments are evaluated")
+{
+    VSOPVariable variable = makeVariable();
+    double t = 2.0e4;
+    double expected = referenceValue(t);
+    REQUIRE(std::abs(variable.evaluate(t) - expected) <= 1.0e-9 * std::abs(expected));
+}
+
+TEST_CASE("Empty series add nothing")
+{
+    VSOPVariable variable;
+    variable.addSeries(nullptr, 0);
+    variable.addSeries(testL1.data(), testL1.size());
+    variable.addSeries(nullptr, 0);
+
+    double t = 0.1;
+    double expected = 0.0;
+    for (const VSOPTerm& term : testL1)
+        expected += term.A * std::cos(term.B + term.C * t);
+    expected *= t;
+    REQUIRE(std::abs(variable.evaluate(t) - expected) <= 1.0e-12 * std::abs(expected));
+
+    VSOPVariable empty;
+    REQUIRE(empty.evaluate(0.1) == 0.0);
+}
+
+TEST_SUITE_END();